@@ -451,7 +451,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
     if (stream->resume(stream)) {
       LOG(ERROR) << __func__ << ": state=" << out->bluetooth_output_.GetState()
                  << " failed to resume";
-      usleep(kBluetoothDefaultOutputBufferMs * 1000);
+      usleep(out->frames_count_ * 1000000LL / out->sample_rate_);
       return totalWritten;
     }
     lock.lock();
@@ -678,9 +678,12 @@ int adev_open_output_stream(struct audio_hw_device* dev,
   out->sample_rate_ = config->sample_rate;
   out->channel_mask_ = config->channel_mask;
   out->format_ = config->format;
+  out->flags_ = flags;
   // frame is number of samples per channel
-  out->frames_count_ =
-      samples_per_ticks(kBluetoothDefaultOutputBufferMs, out->sample_rate_, 1);
+  const unsigned int buffer_ms = (flags & AUDIO_OUTPUT_FLAG_FAST)
+                                     ? kBluetoothFastOutputBufferMs
+                                     : kBluetoothDefaultOutputBufferMs;
+  out->frames_count_ = samples_per_ticks(buffer_ms, out->sample_rate_, 1);
   out->frames_rendered_ = 0;
   out->frames_presented_ = 0;
 
@@ -692,7 +695,7 @@ int adev_open_output_stream(struct audio_hw_device* dev,
   *stream_out = &out->stream_out_;
   LOG(INFO) << __func__ << ": state=" << out->bluetooth_output_.GetState() << ", sample_rate=" << out->sample_rate_
             << ", channels=" << StringPrintf("%#x", out->channel_mask_) << ", format=" << out->format_
-            << ", frames=" << out->frames_count_;
+            << ", flags=" << StringPrintf("%#x", out->flags_) << ", frames=" << out->frames_count_;
   return 0;
 }
 
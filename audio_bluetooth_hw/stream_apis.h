@@ -29,6 +29,9 @@ constexpr audio_format_t kBluetoothDefaultAudioFormatBitsPerSample =
 constexpr unsigned int kBluetoothDefaultInputBufferMs = 20;
 
 constexpr unsigned int kBluetoothDefaultOutputBufferMs = 10;
+// Outputs opened with AUDIO_OUTPUT_FLAG_FAST, so that the fast mixer can write
+// to them, write smaller bursts for a lower latency
+constexpr unsigned int kBluetoothFastOutputBufferMs = 5;
 constexpr audio_channel_mask_t kBluetoothDefaultOutputChannelModeMask =
     AUDIO_CHANNEL_OUT_STEREO;
 
@@ -53,6 +56,7 @@ struct BluetoothStreamOut {
   uint32_t sample_rate_;
   audio_channel_mask_t channel_mask_;
   audio_format_t format_;
+  audio_output_flags_t flags_;
   // frame is the number of samples per channel
   // frames count per tick
   size_t frames_count_;
@@ -18,6 +18,8 @@
 #include "client_interface.h"
 #include "codec_status.h"
 
+#include <algorithm>
+
 #include "btif_a2dp_source.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
@@ -53,6 +55,8 @@ class A2dpTransport : public ::bluetooth::audio::IBluetoothTransportInstance {
   A2dpTransport(SessionType sessionType)
       : IBluetoothTransportInstance(sessionType, {}),
         total_bytes_read_(0),
+        sent_bytes_base_(btif_a2dp_source_get_sent_pcm_bytes()),
+        presented_bytes_(0),
         data_position_({}) {
     a2dp_pending_cmd_ = A2DP_CTRL_CMD_NONE;
     remote_delay_report_ = 0;
@@ -135,12 +139,19 @@ class A2dpTransport : public ::bluetooth::audio::IBluetoothTransportInstance {
                                uint64_t* total_bytes_read,
                                timespec* data_position) override {
     *remote_delay_report_ns = remote_delay_report_ * 100000u;
-    *total_bytes_read = total_bytes_read_;
+    // Only the audio handed over to be sent to the peer is presented: the
+    // audio still queued in the stack is presented later, and the audio
+    // dropped never is. The position never goes back.
+    uint64_t sent_bytes =
+        btif_a2dp_source_get_sent_pcm_bytes() - sent_bytes_base_;
+    presented_bytes_ = std::max(
+        presented_bytes_, std::min(sent_bytes, total_bytes_read_));
+    *total_bytes_read = presented_bytes_;
     *data_position = data_position_;
     VLOG(2) << __func__ << ": delay=" << remote_delay_report_
-            << "/10ms, data=" << total_bytes_read_
-            << " byte(s), timestamp=" << data_position_.tv_sec << "."
-            << data_position_.tv_nsec << "s";
+            << "/10ms, data=" << total_bytes_read_ << " byte(s), presented="
+            << presented_bytes_ << " byte(s), timestamp="
+            << data_position_.tv_sec << "." << data_position_.tv_nsec << "s";
     return true;
   }
 
@@ -164,6 +175,8 @@ class A2dpTransport : public ::bluetooth::audio::IBluetoothTransportInstance {
   void ResetPresentationPosition() override {
     remote_delay_report_ = 0;
     total_bytes_read_ = 0;
+    sent_bytes_base_ = btif_a2dp_source_get_sent_pcm_bytes();
+    presented_bytes_ = 0;
     data_position_ = {};
   }
 
@@ -183,6 +196,10 @@ class A2dpTransport : public ::bluetooth::audio::IBluetoothTransportInstance {
   static tA2DP_CTRL_CMD a2dp_pending_cmd_;
   static uint16_t remote_delay_report_;
   uint64_t total_bytes_read_;
+  // Bytes sent by btif_a2dp_source when the position was reset, and the
+  // position last reported
+  uint64_t sent_bytes_base_;
+  uint64_t presented_bytes_;
   timespec data_position_;
 };
 
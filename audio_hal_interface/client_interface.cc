@@ -24,6 +24,7 @@
 #include <base/logging.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/ServiceManagement.h>
+#include <algorithm>
 #include <future>
 
 #include "osi/include/log.h"
@@ -518,6 +519,31 @@ size_t BluetoothAudioClientInterface::ReadAudioData(uint8_t* p_buf,
   return total_read;
 }
 
+size_t BluetoothAudioClientInterface::ReadAvailableAudioData(
+    uint8_t* p_buf, uint32_t len, uint32_t frame_size) {
+  if (provider_ == nullptr) {
+    LOG(ERROR) << __func__ << ": BluetoothAudioHal nullptr";
+    return 0;
+  }
+  if (p_buf == nullptr || len == 0 || frame_size == 0) return 0;
+
+  std::lock_guard<std::mutex> guard(internal_mutex_);
+
+  if (mDataMQ == nullptr || !mDataMQ->isValid()) return 0;
+
+  size_t avail_to_read = std::min<size_t>(mDataMQ->availableToRead(), len);
+  avail_to_read -= avail_to_read % frame_size;
+  if (avail_to_read != 0 && !mDataMQ->read(p_buf, avail_to_read)) {
+    LOG(WARNING) << __func__ << ": len=" << len
+                 << " avail_to_read=" << avail_to_read << " failed";
+    avail_to_read = 0;
+  }
+  VLOG(2) << __func__ << ": " << len << " -> " << avail_to_read << " read";
+
+  sink_->LogBytesRead(avail_to_read);
+  return avail_to_read;
+}
+
 size_t BluetoothAudioClientInterface::WriteAudioData(uint8_t* p_buf,
                                                      uint32_t len) {
   // Not implemented!
@@ -153,6 +153,12 @@ class BluetoothAudioClientInterface {
   // Read data from audio  HAL through fmq
   size_t ReadAudioData(uint8_t* p_buf, uint32_t len);
 
+  // Read up to |len| bytes already in the fmq, without waiting for the audio
+  // HAL to write more, as a multiple of |frame_size| so that no sample is split
+  // between two reads
+  size_t ReadAvailableAudioData(uint8_t* p_buf, uint32_t len,
+                                uint32_t frame_size);
+
   // Write data to audio HAL through fmq
   size_t WriteAudioData(uint8_t* p_buf, uint32_t len);
 
@@ -47,6 +47,10 @@ void set_remote_delay(uint16_t delay_report_ms);
 // Read from the FMQ of BluetoothAudio HAL
 size_t read(uint8_t* p_buf, uint32_t len);
 
+// Read the whole frames of |frame_size| bytes already in the FMQ of
+// BluetoothAudio HAL, up to |len| bytes, without waiting for more
+size_t read_available(uint8_t* p_buf, uint32_t len, uint32_t frame_size);
+
 }  // namespace hearing_aid
 }  // namespace audio
 }  // namespace bluetooth
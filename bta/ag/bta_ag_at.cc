@@ -23,7 +23,9 @@
  ******************************************************************************/
 
 #include <cstring>
+#include <unordered_map>
 
+#include "at_command_trie.h"
 #include "bt_common.h"
 #include "bta_ag_at.h"
 #include "log/log.h"
@@ -33,17 +35,44 @@
  *  Constants
  ****************************************************************************/
 
+/******************************************************************************
+ *
+ * Function         bta_ag_at_trie
+ *
+ * Description      Get the trie of the commands of an AT command table, built
+ *                  on first use and kept for the lifetime of the process.
+ *
+ *
+ * Returns          the trie mapping command strings to table indexes
+ *
+ *****************************************************************************/
+static const AtCommandTrie* bta_ag_at_trie(const tBTA_AG_AT_CMD* p_at_tbl) {
+  static std::unordered_map<const tBTA_AG_AT_CMD*, AtCommandTrie> tries;
+
+  auto it = tries.find(p_at_tbl);
+  if (it == tries.end()) {
+    /* Command strings are uppercase, matched like utl_strucmp() does */
+    it = tries.emplace(p_at_tbl, AtCommandTrie(true)).first;
+    for (size_t idx = 0; p_at_tbl[idx].p_cmd[0] != 0; idx++) {
+      it->second.Add(p_at_tbl[idx].p_cmd, idx);
+    }
+  }
+  return &it->second;
+}
+
 /******************************************************************************
  *
  * Function         bta_ag_at_init
  *
- * Description      Initialize the AT command parser control block.
+ * Description      Initialize the AT command parser control block, once its
+ *                  AT command table is set.
  *
  *
  * Returns          void
  *
  *****************************************************************************/
 void bta_ag_at_init(tBTA_AG_AT_CB* p_cb) {
+  p_cb->p_at_trie = bta_ag_at_trie(p_cb->p_at_tbl);
   p_cb->p_cmd_buf = nullptr;
   p_cb->cmd_pos = 0;
 }
@@ -78,21 +107,18 @@ void bta_ag_at_reinit(tBTA_AG_AT_CB* p_cb) {
  *
  *****************************************************************************/
 void bta_ag_process_at(tBTA_AG_AT_CB* p_cb, char* p_end) {
-  uint16_t idx;
+  size_t idx;
+  size_t cmd_len;
   uint8_t arg_type;
   char* p_arg;
   int16_t int_arg = 0;
-  /* loop through at command table looking for match */
-  for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0; idx++) {
-    if (!utl_strucmp(p_cb->p_at_tbl[idx].p_cmd, p_cb->p_cmd_buf)) {
-      break;
-    }
-  }
+  /* look up the first table entry the command starts with */
+  idx = p_cb->p_at_trie->Match(p_cb->p_cmd_buf, &cmd_len);
 
   /* if there is a match; verify argument type */
-  if (p_cb->p_at_tbl[idx].p_cmd[0] != 0) {
+  if (idx != AtCommandTrie::kNoMatch) {
     /* start of argument is p + strlen matching command */
-    p_arg = p_cb->p_cmd_buf + strlen(p_cb->p_at_tbl[idx].p_cmd);
+    p_arg = p_cb->p_cmd_buf + cmd_len;
     if (p_arg > p_end) {
       (*p_cb->p_err_cback)((tBTA_AG_SCB*)p_cb->p_user, false, nullptr);
       android_errorWriteLog(0x534e4554, "112860487");
@@ -64,8 +64,10 @@ typedef void(tBTA_AG_AT_ERR_CBACK)(tBTA_AG_SCB* p_user, bool unknown,
                                    const char* p_arg);
 
 /* AT command parsing control block */
+class AtCommandTrie;
 typedef struct {
   const tBTA_AG_AT_CMD* p_at_tbl;    /* AT command table */
+  const AtCommandTrie* p_at_trie;    /* p_at_tbl commands, set by init */
   tBTA_AG_AT_CMD_CBACK* p_cmd_cback; /* command callback */
   tBTA_AG_AT_ERR_CBACK* p_err_cback; /* error callback */
   void* p_user;                      /* user-defined data */
@@ -83,7 +85,8 @@ typedef struct {
  *
  * Function         bta_ag_at_init
  *
- * Description      Initialize the AT command parser control block.
+ * Description      Initialize the AT command parser control block, once its
+ *                  AT command table is set.
  *
  *
  * Returns          void
@@ -35,6 +35,7 @@
 #include "a2dp_sbc.h"
 #include "avdt_api.h"
 #include "avrcp_service.h"
+#include "bt_hdr_ref.h"
 #include "bt_utils.h"
 #include "bta_av_int.h"
 #include "btif/include/btif_av_co.h"
@@ -524,6 +525,10 @@ void bta_av_sink_data_cback(uint8_t handle, BT_HDR* p_pkt, uint32_t time_stamp,
     return;
   }
   p_pkt->event = BTA_AV_SINK_MEDIA_DATA_EVT;
+  /* Pass the RTP timestamp ahead of the payload, where the RTP header was */
+  if (p_pkt->offset >= sizeof(uint32_t)) {
+    *((uint32_t*)(p_pkt + 1)) = time_stamp;
+  }
   p_scb->seps[p_scb->sep_idx].p_app_sink_data_cback(
       p_scb->PeerAddress(), BTA_AV_SINK_MEDIA_DATA_EVT, (tBTA_AV_MEDIA*)p_pkt);
   /* Free the buffer: a copy of the packet has been delivered */
@@ -1967,7 +1972,7 @@ void bta_av_str_stopped(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
     while (!list_is_empty(p_scb->a2dp_list)) {
       p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
       list_remove(p_scb->a2dp_list, p_buf);
-      osi_free(p_buf);
+      bt_hdr_unref(p_buf);
     }
 
     /* drop the audio buffers queued in L2CAP */
@@ -2157,6 +2162,10 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
        * L2CAP (see above).
        */
 
+      /* AVDTP and the fragmentation below modify the buffer, take it from
+       * the other channels if they still hold it */
+      p_buf = bt_hdr_make_writable(p_buf);
+
       /* opt is a bit mask, it could have several options set */
       opt = AVDT_DATA_OPT_NONE;
       if (p_scb->no_rtp_header) {
@@ -2222,7 +2231,7 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
         } else {
           /* too many buffers in a2dp_list, drop it. */
           bta_av_co_audio_drop(p_scb->hndl, p_scb->PeerAddress());
-          osi_free(p_buf);
+          bt_hdr_unref(p_buf);
         }
       }
     }
@@ -32,6 +32,7 @@
 
 #include "avdt_api.h"
 #include "avrcp_service.h"
+#include "bt_hdr_ref.h"
 #include "bta_av_api.h"
 #include "bta_av_int.h"
 #include "l2c_api.h"
@@ -2266,7 +2267,7 @@ void bta_av_dereg_comp(tBTA_AV_DATA* p_data) {
       while (!list_is_empty(p_scb->a2dp_list)) {
         p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
         list_remove(p_scb->a2dp_list, p_buf);
-        osi_free(p_buf);
+        bt_hdr_unref(p_buf);
       }
     }
 
@@ -32,10 +32,12 @@
 #include "osi/include/osi.h"
 #include "osi/include/properties.h"
 
+#include "bt_hdr_ref.h"
 #include "bta_av_co.h"
 #include "bta_av_int.h"
 #include "btif/include/btif_av_co.h"
 #include "btif/include/btif_config.h"
+#include "common/state_table.h"
 #include "l2c_api.h"
 #include "l2cdefs.h"
 #include "utl.h"
@@ -114,7 +116,7 @@ enum {
 typedef void (*tBTA_AV_ACTION)(tBTA_AV_CB* p_cb, tBTA_AV_DATA* p_data);
 
 /* action functions */
-const tBTA_AV_ACTION bta_av_action[] = {
+constexpr tBTA_AV_ACTION bta_av_action[] = {
     bta_av_disable,
     bta_av_rc_opened,
     bta_av_rc_remote_cmd,
@@ -133,7 +135,7 @@ const tBTA_AV_ACTION bta_av_action[] = {
 #define BTA_AV_NUM_COLS 2   /* number of columns in state tables */
 
 /* state table for init state */
-static const uint8_t bta_av_st_init[][BTA_AV_NUM_COLS] = {
+static constexpr uint8_t bta_av_st_init[][BTA_AV_NUM_COLS] = {
     /* Event                     Action 1                   Next state */
     /* API_DISABLE_EVT */ {BTA_AV_DISABLE, BTA_AV_INIT_ST},
     /* API_REMOTE_CMD_EVT */ {BTA_AV_IGNORE, BTA_AV_INIT_ST},
@@ -147,7 +149,7 @@ static const uint8_t bta_av_st_init[][BTA_AV_NUM_COLS] = {
 };
 
 /* state table for open state */
-static const uint8_t bta_av_st_open[][BTA_AV_NUM_COLS] = {
+static constexpr uint8_t bta_av_st_open[][BTA_AV_NUM_COLS] = {
     /* Event                     Action 1                   Next state */
     /* API_DISABLE_EVT */ {BTA_AV_DISABLE, BTA_AV_INIT_ST},
     /* API_REMOTE_CMD_EVT */ {BTA_AV_RC_REMOTE_CMD, BTA_AV_OPEN_ST},
@@ -160,11 +162,12 @@ static const uint8_t bta_av_st_open[][BTA_AV_NUM_COLS] = {
     /* AVRC_NONE_EVT */ {BTA_AV_IGNORE, BTA_AV_INIT_ST},
 };
 
-/* type for state table */
-typedef const uint8_t (*tBTA_AV_ST_TBL)[BTA_AV_NUM_COLS];
-
-/* state table */
-static const tBTA_AV_ST_TBL bta_av_st_tbl[] = {bta_av_st_init, bta_av_st_open};
+/* state table, built at compile time with the action functions resolved */
+static constexpr auto bta_av_st_tbl = bluetooth::common::MakeStateTable<1>(
+    [](uint8_t action) {
+      return action == BTA_AV_IGNORE ? nullptr : bta_av_action[action];
+    },
+    BTA_AV_INIT_ST, bta_av_st_init, bta_av_st_open);
 
 typedef void (*tBTA_AV_NSM_ACT)(tBTA_AV_DATA* p_data);
 static void bta_av_api_enable(tBTA_AV_DATA* p_data);
@@ -1187,7 +1190,6 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
   /* Test whether there is more than one audio channel connected */
   if ((p_buf == NULL) || (bta_av_cb.audio_open_cnt < 2)) return;
 
-  uint16_t copy_size = BT_HDR_SIZE + p_buf->len + p_buf->offset;
   for (int i = 0; i < BTA_AV_NUM_STRS; i++) {
     tBTA_AV_SCB* p_scbi = bta_av_cb.p_scb[i];
 
@@ -1197,17 +1199,16 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
     if (!(bta_av_cb.conn_audio & BTA_AV_HNDL_TO_MSK(i)))
       continue; /* Audio is not connected */
 
-    /* Enqueue the data */
-    BT_HDR* p_new = (BT_HDR*)osi_malloc(copy_size);
-    memcpy(p_new, p_buf, copy_size);
-    list_append(p_scbi->a2dp_list, p_new);
+    /* Enqueue a reference to the data, it is only copied if the channel
+     * sends it while the other ones still hold it */
+    list_append(p_scbi->a2dp_list, bt_hdr_ref(p_buf));
 
     if (list_length(p_scbi->a2dp_list) > p_bta_av_cfg->audio_mqs) {
       // Drop the oldest packet
       bta_av_co_audio_drop(p_scbi->hndl, p_scbi->PeerAddress());
       BT_HDR* p_buf_drop = static_cast<BT_HDR*>(list_front(p_scbi->a2dp_list));
       list_remove(p_scbi->a2dp_list, p_buf_drop);
-      osi_free(p_buf_drop);
+      bt_hdr_unref(p_buf_drop);
     }
   }
 }
@@ -1223,28 +1224,28 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
  *
  ******************************************************************************/
 void bta_av_sm_execute(tBTA_AV_CB* p_cb, uint16_t event, tBTA_AV_DATA* p_data) {
-  tBTA_AV_ST_TBL state_table;
-  uint8_t action;
-
   APPL_TRACE_EVENT("%s: AV event=0x%x(%s) state=%d(%s)", __func__, event,
                    bta_av_evt_code(event), p_cb->state,
                    bta_av_st_code(p_cb->state));
 
-  /* look up the state table for the current state */
-  state_table = bta_av_st_tbl[p_cb->state];
-
+  /* look up the transition of the current state */
   event &= 0x00FF;
+  const auto* transition = bta_av_st_tbl.Find(p_cb->state, event);
+  if (transition == nullptr) {
+    APPL_TRACE_ERROR("%s: invalid state=%d or event offset:%d", __func__,
+                     p_cb->state, event);
+    return;
+  }
 
   /* set next state */
-  p_cb->state = state_table[event][BTA_AV_NEXT_STATE];
+  p_cb->state = transition->next_state;
   APPL_TRACE_EVENT("%s: next state=%d event offset:%d", __func__, p_cb->state,
                    event);
 
   /* execute action functions */
-  action = state_table[event][BTA_AV_ACTION_COL];
-  if (action != BTA_AV_IGNORE) {
-    APPL_TRACE_EVENT("%s: action executed %d", __func__, action);
-    (*bta_av_action[action])(p_cb, p_data);
+  if (transition->actions[0] != nullptr) {
+    APPL_TRACE_EVENT("%s: action executed", __func__);
+    (*transition->actions[0])(p_cb, p_data);
   }
 }
 
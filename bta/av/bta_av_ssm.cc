@@ -26,6 +26,7 @@
 #include "bt_target.h"
 #include "bta_av_co.h"
 #include "bta_av_int.h"
+#include "common/state_table.h"
 
 /*****************************************************************************
  * Constants and types
@@ -105,7 +106,7 @@ enum {
 #define BTA_AV_NUM_COLS 3    /* number of columns in state tables */
 
 /* state table for init state */
-static const uint8_t bta_av_sst_init[][BTA_AV_NUM_COLS] = {
+static constexpr uint8_t bta_av_sst_init[][BTA_AV_NUM_COLS] = {
     /* Event                     Action 1               Action 2 Next state */
     /* API_OPEN_EVT */ {BTA_AV_DO_DISC, BTA_AV_SIGNORE, BTA_AV_OPENING_SST},
     /* API_CLOSE_EVT */ {BTA_AV_CLEANUP, BTA_AV_SIGNORE, BTA_AV_INIT_SST},
@@ -152,7 +153,7 @@ static const uint8_t bta_av_sst_init[][BTA_AV_NUM_COLS] = {
     {BTA_AV_OFFLOAD_RSP, BTA_AV_SIGNORE, BTA_AV_INIT_SST}};
 
 /* state table for incoming state */
-static const uint8_t bta_av_sst_incoming[][BTA_AV_NUM_COLS] = {
+static constexpr uint8_t bta_av_sst_incoming[][BTA_AV_NUM_COLS] = {
     /* Event                     Action 1               Action 2 Next state */
     /* API_OPEN_EVT */ {BTA_AV_OPEN_AT_INC, BTA_AV_SIGNORE,
                         BTA_AV_INCOMING_SST},
@@ -221,7 +222,7 @@ static const uint8_t bta_av_sst_incoming[][BTA_AV_NUM_COLS] = {
     {BTA_AV_OFFLOAD_RSP, BTA_AV_SIGNORE, BTA_AV_INCOMING_SST}};
 
 /* state table for opening state */
-static const uint8_t bta_av_sst_opening[][BTA_AV_NUM_COLS] = {
+static constexpr uint8_t bta_av_sst_opening[][BTA_AV_NUM_COLS] = {
     /* Event                     Action 1               Action 2 Next state */
     /* API_OPEN_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_OPENING_SST},
     /* API_CLOSE_EVT */ {BTA_AV_DO_CLOSE, BTA_AV_SIGNORE, BTA_AV_CLOSING_SST},
@@ -287,7 +288,7 @@ static const uint8_t bta_av_sst_opening[][BTA_AV_NUM_COLS] = {
     {BTA_AV_OFFLOAD_RSP, BTA_AV_SIGNORE, BTA_AV_OPENING_SST}};
 
 /* state table for open state */
-static const uint8_t bta_av_sst_open[][BTA_AV_NUM_COLS] = {
+static constexpr uint8_t bta_av_sst_open[][BTA_AV_NUM_COLS] = {
     /* Event                     Action 1               Action 2 Next state */
     /* API_OPEN_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_OPEN_SST},
     /* API_CLOSE_EVT */ {BTA_AV_DO_CLOSE, BTA_AV_SIGNORE, BTA_AV_CLOSING_SST},
@@ -342,7 +343,7 @@ static const uint8_t bta_av_sst_open[][BTA_AV_NUM_COLS] = {
     {BTA_AV_OFFLOAD_RSP, BTA_AV_SIGNORE, BTA_AV_OPEN_SST}};
 
 /* state table for reconfig state */
-static const uint8_t bta_av_sst_rcfg[][BTA_AV_NUM_COLS] = {
+static constexpr uint8_t bta_av_sst_rcfg[][BTA_AV_NUM_COLS] = {
     /* Event                     Action 1               Action 2 Next state */
     /* API_OPEN_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_RCFG_SST},
     /* API_CLOSE_EVT */
@@ -397,7 +398,7 @@ static const uint8_t bta_av_sst_rcfg[][BTA_AV_NUM_COLS] = {
     {BTA_AV_OFFLOAD_RSP, BTA_AV_SIGNORE, BTA_AV_RCFG_SST}};
 
 /* state table for closing state */
-static const uint8_t bta_av_sst_closing[][BTA_AV_NUM_COLS] = {
+static constexpr uint8_t bta_av_sst_closing[][BTA_AV_NUM_COLS] = {
     /* Event                     Action 1               Action 2 Next state */
     /* API_OPEN_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_CLOSING_SST},
     /* API_CLOSE_EVT */
@@ -459,14 +460,13 @@ static const uint8_t bta_av_sst_closing[][BTA_AV_NUM_COLS] = {
     /* API_OFFLOAD_START_RSP_EVT */
     {BTA_AV_OFFLOAD_RSP, BTA_AV_SIGNORE, BTA_AV_CLOSING_SST}};
 
-/* type for state table */
-typedef const uint8_t (*tBTA_AV_SST_TBL)[BTA_AV_NUM_COLS];
-
-/* state table */
-static const tBTA_AV_SST_TBL bta_av_sst_tbl[] = {
-    bta_av_sst_init, bta_av_sst_incoming, bta_av_sst_opening,
-    bta_av_sst_open, bta_av_sst_rcfg,     bta_av_sst_closing};
-
+/* state table, built at compile time. The actions are kept as numbers, they
+ * are resolved with the action table of the stream control block. */
+static constexpr auto bta_av_sst_tbl =
+    bluetooth::common::MakeStateTable<BTA_AV_SACTIONS>(
+        [](uint8_t action) { return action; }, BTA_AV_INIT_SST,
+        bta_av_sst_init, bta_av_sst_incoming, bta_av_sst_opening,
+        bta_av_sst_open, bta_av_sst_rcfg, bta_av_sst_closing);
 
 /*******************************************************************************
  *
@@ -486,12 +486,18 @@ void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
     return;
   }
 
-  /* look up the state table for the current state */
-  tBTA_AV_SST_TBL state_table = bta_av_sst_tbl[p_scb->state];
+  /* look up the transition of the current state */
+  const auto* transition =
+      bta_av_sst_tbl.Find(p_scb->state, event - BTA_AV_FIRST_SSM_EVT);
+  if (transition == nullptr) {
+    APPL_TRACE_ERROR("%s: peer %s invalid state=%d or event=0x%x p_scb=%p",
+                     __func__, p_scb->PeerAddress().ToString().c_str(),
+                     p_scb->state, event, p_scb);
+    return;
+  }
 
   /* set next state */
-  auto new_state =
-      state_table[event - BTA_AV_FIRST_SSM_EVT][BTA_AV_SNEXT_STATE];
+  auto new_state = transition->next_state;
   if (p_scb->state != new_state) {
     APPL_TRACE_WARNING(
         "%s: peer %s AV event(0x%x)=0x%x(%s) state=%d(%s) -> %d(%s) p_scb=%p",
@@ -505,8 +511,7 @@ void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
         bta_av_evt_code(event), p_scb->state, bta_av_sst_code(p_scb->state),
         p_scb);
   }
-  event -= BTA_AV_FIRST_SSM_EVT;
-  p_scb->state = state_table[event][BTA_AV_SNEXT_STATE];
+  p_scb->state = new_state;
 
   APPL_TRACE_VERBOSE("%s: peer %s AV next state=%d(%s) p_scb=%p(0x%x)",
                      __func__, p_scb->PeerAddress().ToString().c_str(),
@@ -515,7 +520,7 @@ void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
 
   /* execute action functions */
   for (int i = 0; i < BTA_AV_SACTIONS; i++) {
-    uint8_t action = state_table[event][i];
+    uint8_t action = transition->actions[i];
     if (action != BTA_AV_SIGNORE) {
       (*p_scb->p_act_tbl[action])(p_scb, p_data);
     } else
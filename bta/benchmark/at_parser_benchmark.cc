@@ -0,0 +1,226 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the HFP AT command parsers, replaying the car kit session of
+// bta/test/at_session_data.h.
+//
+// BM_AgCommandScan and BM_AgCommandTrie look up the commands received by the
+// AG, the first by comparing them with every entry of the command table like
+// the AG used to, the second with the AtCommandTrie the AG uses now.
+// BM_HfClientEventScan and BM_HfClientEventTrie do the same for the result
+// codes received by the HF client.
+//
+// BM_AgParseSession feeds the whole AG session to bta_ag_at_parse() in reads
+// of range(0) bytes, like RFCOMM frames of that size would.
+//
+// All of them report the number of commands or result codes handled per
+// second. If AT_PARSER_BENCHMARK_SESSION is set to a file name, the commands
+// received by the AG are read from it instead, for instance to replay a
+// session captured from a btsnoop log.
+
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "bta/ag/bta_ag_at.h"
+#include "bta/include/at_command_trie.h"
+#include "bta/include/utl.h"
+#include "bta/test/at_session_data.h"
+#include "stack/include/btm_api.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// The commands received by the AG
+std::string ag_session() {
+  const char* path = getenv("AT_PARSER_BENCHMARK_SESSION");
+  if (path == nullptr) return at_session_ag_rx;
+
+  std::string session;
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    abort();
+  }
+  char buf[1024];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof(buf), file)) > 0) session.append(buf, len);
+  fclose(file);
+  return session;
+}
+
+// The commands of the AG session without their "AT" prefix, as
+// bta_ag_process_at() looks them up
+std::vector<std::string> ag_commands() {
+  std::vector<std::string> commands;
+  std::string session = ag_session();
+  size_t start = 0;
+  for (size_t end; (end = session.find('\r', start)) != std::string::npos;
+       start = end + 1) {
+    std::string line = session.substr(start, end - start);
+    if (line.size() > 2 && strncasecmp(line.c_str(), "AT", 2) == 0) {
+      commands.push_back(line.substr(2));
+    }
+  }
+  return commands;
+}
+
+// The result codes received by the HF client, starting with their "\r\n"
+// prefix as bta_hf_client_parse_start() looks them up
+std::vector<const char*> hf_client_events() {
+  std::vector<const char*> events;
+  for (const char* p = at_session_hf_client_rx; *p != 0; p++) {
+    if (p[0] == '\r' && p[1] == '\n' && p[2] != 0 && p[2] != '\r') {
+      events.push_back(p);
+    }
+  }
+  return events;
+}
+
+size_t ag_table_scan(const char* p_cmd) {
+  size_t idx;
+  for (idx = 0; at_session_ag_hfp_cmd[idx].p_cmd[0] != 0; idx++) {
+    if (!utl_strucmp(at_session_ag_hfp_cmd[idx].p_cmd, p_cmd)) return idx;
+  }
+  return AtCommandTrie::kNoMatch;
+}
+
+size_t hf_client_event_scan(const char* p_event) {
+  for (size_t idx = 0; idx < sizeof(at_session_hf_client_events) /
+                                 sizeof(at_session_hf_client_events[0]);
+       idx++) {
+    const char* p_name = at_session_hf_client_events[idx];
+    if (strncmp(p_event + 2, p_name, strlen(p_name)) == 0) return idx;
+  }
+  return AtCommandTrie::kNoMatch;
+}
+
+void BM_AgCommandScan(State& state) {
+  std::vector<std::string> commands = ag_commands();
+  for (auto _ : state) {
+    for (const std::string& command : commands) {
+      benchmark::DoNotOptimize(ag_table_scan(command.c_str()));
+    }
+  }
+  state.counters["commands"] = benchmark::Counter(
+      state.iterations() * commands.size(), benchmark::Counter::kIsRate);
+}
+
+void BM_AgCommandTrie(State& state) {
+  AtCommandTrie trie(true);
+  for (size_t idx = 0; at_session_ag_hfp_cmd[idx].p_cmd[0] != 0; idx++) {
+    trie.Add(at_session_ag_hfp_cmd[idx].p_cmd, idx);
+  }
+
+  std::vector<std::string> commands = ag_commands();
+  for (const std::string& command : commands) {
+    if (trie.Match(command.c_str()) != ag_table_scan(command.c_str())) {
+      state.SkipWithError("Trie and table scan mismatch");
+      return;
+    }
+  }
+
+  for (auto _ : state) {
+    for (const std::string& command : commands) {
+      benchmark::DoNotOptimize(trie.Match(command.c_str()));
+    }
+  }
+  state.counters["commands"] = benchmark::Counter(
+      state.iterations() * commands.size(), benchmark::Counter::kIsRate);
+}
+
+void BM_HfClientEventScan(State& state) {
+  std::vector<const char*> events = hf_client_events();
+  for (auto _ : state) {
+    for (const char* event : events) {
+      benchmark::DoNotOptimize(hf_client_event_scan(event));
+    }
+  }
+  state.counters["events"] = benchmark::Counter(
+      state.iterations() * events.size(), benchmark::Counter::kIsRate);
+}
+
+void BM_HfClientEventTrie(State& state) {
+  AtCommandTrie trie(false);
+  for (size_t idx = 0; idx < sizeof(at_session_hf_client_events) /
+                                 sizeof(at_session_hf_client_events[0]);
+       idx++) {
+    std::string keyword = "\r\n";
+    keyword += at_session_hf_client_events[idx];
+    trie.Add(keyword.c_str(), idx);
+  }
+
+  std::vector<const char*> events = hf_client_events();
+  for (auto _ : state) {
+    for (const char* event : events) {
+      benchmark::DoNotOptimize(trie.Match(event));
+    }
+  }
+  state.counters["events"] = benchmark::Counter(
+      state.iterations() * events.size(), benchmark::Counter::kIsRate);
+}
+
+size_t parsed_commands;
+
+void count_cmd_cback(tBTA_AG_SCB*, uint16_t, uint8_t, char*, char*, int16_t) {
+  parsed_commands++;
+}
+
+void count_err_cback(tBTA_AG_SCB*, bool, const char*) { parsed_commands++; }
+
+void BM_AgParseSession(State& state) {
+  std::string session = ag_session();
+  size_t read_size = state.range(0);
+
+  tBTA_AG_AT_CB at_cb = {};
+  at_cb.p_at_tbl = at_session_ag_hfp_cmd;
+  at_cb.p_cmd_cback = count_cmd_cback;
+  at_cb.p_err_cback = count_err_cback;
+  at_cb.cmd_max_len = 512;
+  bta_ag_at_init(&at_cb);
+
+  parsed_commands = 0;
+  std::string buf;
+  for (auto _ : state) {
+    for (size_t pos = 0; pos < session.size(); pos += read_size) {
+      // Each read comes in its own buffer, like RFCOMM data does
+      buf.assign(session, pos, read_size);
+      bta_ag_at_parse(&at_cb, &buf[0], buf.size());
+    }
+  }
+  bta_ag_at_reinit(&at_cb);
+
+  state.counters["commands"] =
+      benchmark::Counter(parsed_commands, benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+// Referenced by utl.cc, which provides utl_str2int() to the AG parser
+tBTM_STATUS BTM_SetDeviceClass(DEV_CLASS dev_class) {
+  return BTM_ILLEGAL_VALUE;
+}
+uint8_t* BTM_ReadDeviceClass(void) { return nullptr; }
+
+BENCHMARK(BM_AgCommandScan);
+BENCHMARK(BM_AgCommandTrie);
+BENCHMARK(BM_HfClientEventScan);
+BENCHMARK(BM_HfClientEventTrie);
+BENCHMARK(BM_AgParseSession)->Arg(16)->Arg(127)->Arg(1024);
@@ -42,6 +42,8 @@
 #include "btm_api.h"
 #include "btm_int.h"
 #include "btu.h"
+#include "common/metrics.h"
+#include "common/time_util.h"
 #include "device/include/controller.h"
 #include "device/include/interop.h"
 #include "gap_api.h" /* For GAP_BleReadPeerPrefConnParams */
@@ -65,6 +67,9 @@ static void bta_dm_inq_cmpl_cb(void* p_result);
 static void bta_dm_service_search_remname_cback(const RawAddress& bd_addr,
                                                 DEV_CLASS dc, BD_NAME bd_name);
 static void bta_dm_remname_cback(void* p);
+static void bta_dm_name_prefetch_add(const RawAddress& bd_addr);
+static void bta_dm_name_prefetch_next(void);
+static void bta_dm_name_prefetch_cback(void* p);
 static void bta_dm_find_services(const RawAddress& bd_addr);
 static void bta_dm_discover_next_device(void);
 static void bta_dm_sdp_callback(uint16_t sdp_status);
@@ -151,6 +156,12 @@ static void bta_dm_ctrl_features_rd_cmpl_cback(tBTM_STATUS result);
 #define BTA_DM_SWITCH_DELAY_TIMER_MS 500
 #endif
 
+/* Consecutive failed remote name requests after which no more names are read
+ * while the inquiry is running */
+#ifndef BTA_DM_NAME_PREFETCH_MAX_FAILURES
+#define BTA_DM_NAME_PREFETCH_MAX_FAILURES 2
+#endif
+
 static void bta_dm_reset_sec_dev_pending(const RawAddress& remote_bd_addr);
 static void bta_dm_remove_sec_dev_entry(const RawAddress& remote_bd_addr);
 static void bta_dm_observe_results_cb(tBTM_INQ_RESULTS* p_inq, uint8_t* p_eir,
@@ -990,6 +1001,13 @@ void bta_dm_search_start(tBTA_DM_MSG* p_data) {
   bta_dm_search_cb.p_search_cback = p_data->search.p_cback;
   bta_dm_search_cb.services = p_data->search.services;
 
+  bta_dm_search_cb.name_prefetch_count = 0;
+  bta_dm_search_cb.name_prefetch_failures = 0;
+  bta_dm_search_cb.search_start_ms =
+      bluetooth::common::time_get_os_boottime_ms();
+  bta_dm_search_cb.search_first_device_ms = 0;
+  bta_dm_search_cb.search_num_devices = 0;
+
   osi_free_and_reset((void**)&bta_dm_search_cb.p_srvc_uuid);
 
   if ((bta_dm_search_cb.num_uuid = p_data->search.num_uuid) != 0 &&
@@ -1022,6 +1040,9 @@ void bta_dm_search_start(tBTA_DM_MSG* p_data) {
 void bta_dm_search_cancel(UNUSED_ATTR tBTA_DM_MSG* p_data) {
   tBTA_DM_MSG* p_msg;
 
+  /* a name request in progress still completes, queued ones are dropped */
+  bta_dm_search_cb.name_prefetch_count = 0;
+
   if (BTM_IsInquiryActive()) {
     if (BTM_CancelInquiry() == BTM_SUCCESS) {
       bta_dm_search_cancel_notify(NULL);
@@ -1263,6 +1284,10 @@ void bta_dm_inq_cmpl(tBTA_DM_MSG* p_data) {
   data.inq_cmpl.num_resps = p_data->inq_cmpl.num;
   bta_dm_search_cb.p_search_cback(BTA_DM_INQ_CMPL_EVT, &data);
 
+  /* the names not read yet are read one by one below */
+  bta_dm_search_cb.name_prefetch_count = 0;
+  bta_dm_search_cb.search_num_devices = p_data->inq_cmpl.num;
+
   bta_dm_search_cb.p_btm_inq_info = BTM_InqDbFirst();
   if (bta_dm_search_cb.p_btm_inq_info != NULL) {
     /* start name and service discovery from the first device on inquiry result
@@ -1565,6 +1590,20 @@ void bta_dm_search_cmpl(tBTA_DM_MSG* p_data) {
 
   osi_free_and_reset((void**)&bta_dm_search_cb.p_srvc_uuid);
 
+  if (bta_dm_search_cb.search_start_ms != 0) {
+    uint64_t now_ms = bluetooth::common::time_get_os_boottime_ms();
+    int64_t first_device_ms = -1;
+    if (bta_dm_search_cb.search_first_device_ms != 0) {
+      first_device_ms = bta_dm_search_cb.search_first_device_ms -
+                        bta_dm_search_cb.search_start_ms;
+    }
+    bluetooth::common::BluetoothMetricsLogger::GetInstance()
+        ->LogDeviceDiscovery(first_device_ms,
+                             now_ms - bta_dm_search_cb.search_start_ms,
+                             bta_dm_search_cb.search_num_devices);
+    bta_dm_search_cb.search_start_ms = 0;
+  }
+
   if (p_data->hdr.layer_specific == BTA_DM_API_DI_DISCOVER_EVT)
     bta_dm_di_disc_cmpl(p_data);
   else
@@ -1957,6 +1996,16 @@ static void bta_dm_discover_device(const RawAddress& remote_bd_addr) {
     /* Do not perform RNR for LE devices at inquiry complete*/
     bta_dm_search_cb.name_discover_done = true;
   }
+  /* the name was already read while the inquiry was running */
+  if (!bta_dm_search_cb.name_discover_done && bta_dm_search_cb.p_btm_inq_info &&
+      bta_dm_search_cb.p_btm_inq_info->remote_name_state ==
+          BTM_INQ_RMT_NAME_DONE &&
+      bta_dm_search_cb.p_btm_inq_info->results.remote_bd_addr ==
+          remote_bd_addr) {
+    strlcpy((char*)bta_dm_search_cb.peer_name,
+            (char*)bta_dm_search_cb.p_btm_inq_info->remote_name, BD_NAME_LEN);
+    bta_dm_search_cb.name_discover_done = true;
+  }
   /* if name discovery is not done and application needs remote name */
   if ((!bta_dm_search_cb.name_discover_done) &&
       ((bta_dm_search_cb.p_btm_inq_info == NULL) ||
@@ -2107,6 +2156,141 @@ static void bta_dm_inq_results_cb(tBTM_INQ_RESULTS* p_inq, uint8_t* p_eir,
     if (result.inq_res.remt_name_not_required)
       p_inq_info->appl_knows_rem_name = true;
   }
+
+  if (bta_dm_search_cb.search_first_device_ms == 0) {
+    bta_dm_search_cb.search_first_device_ms =
+        bluetooth::common::time_get_os_boottime_ms();
+  }
+
+  /* read the name now rather than after the inquiry */
+  if (p_inq_info && !p_inq_info->appl_knows_rem_name &&
+      (p_inq->inq_result_type & BTM_INQ_RESULT_BR) &&
+      p_inq->device_type != BT_DEVICE_TYPE_BLE) {
+    bta_dm_name_prefetch_add(p_inq->remote_bd_addr);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_name_prefetch_add
+ *
+ * Description      Queues a remote name request for a BR/EDR device found by
+ *                  the inquiry, to read its name while the inquiry is running
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_name_prefetch_add(const RawAddress& bd_addr) {
+  if (bta_dm_search_cb.name_prefetch_failures >=
+      BTA_DM_NAME_PREFETCH_MAX_FAILURES)
+    return;
+
+  if (bta_dm_search_cb.name_prefetch_active &&
+      bta_dm_search_cb.name_prefetch_bda == bd_addr)
+    return;
+
+  for (uint8_t i = 0; i < bta_dm_search_cb.name_prefetch_count; i++) {
+    if (bta_dm_search_cb.name_prefetch_queue[i] == bd_addr) return;
+  }
+
+  /* the devices not queued get their name after the inquiry */
+  if (bta_dm_search_cb.name_prefetch_count < BTA_DM_NAME_PREFETCH_QUEUE_SIZE) {
+    bta_dm_search_cb
+        .name_prefetch_queue[bta_dm_search_cb.name_prefetch_count++] = bd_addr;
+  }
+
+  bta_dm_name_prefetch_next();
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_name_prefetch_next
+ *
+ * Description      Starts the remote name request of the next queued device,
+ *                  if the inquiry is still running, no other name request is
+ *                  in progress and the controller has a link to spare
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_name_prefetch_next(void) {
+  if (bta_dm_search_cb.name_prefetch_active) return;
+
+  if (!(BTM_IsInquiryActive() & BTM_BR_INQUIRY_MASK)) {
+    bta_dm_search_cb.name_prefetch_count = 0;
+    return;
+  }
+
+  /* keep a link for the connections of the applications, the name is read
+   * after the inquiry otherwise */
+  if (BTM_GetNumAclLinks() + 1 >= MAX_L2CAP_LINKS) return;
+
+  while (bta_dm_search_cb.name_prefetch_count > 0) {
+    RawAddress bd_addr = bta_dm_search_cb.name_prefetch_queue[0];
+    bta_dm_search_cb.name_prefetch_count--;
+    memmove(&bta_dm_search_cb.name_prefetch_queue[0],
+            &bta_dm_search_cb.name_prefetch_queue[1],
+            bta_dm_search_cb.name_prefetch_count * sizeof(RawAddress));
+
+    tBTM_INQ_INFO* p_inq_info = BTM_InqDbRead(bd_addr);
+    if (p_inq_info == NULL || p_inq_info->appl_knows_rem_name ||
+        p_inq_info->remote_name_state != BTM_INQ_RMT_NAME_EMPTY)
+      continue;
+
+    /* BTM reads one name at a time, stop if it is busy with another one */
+    if (BTM_ReadRemoteDeviceName(bd_addr, bta_dm_name_prefetch_cback,
+                                 BT_TRANSPORT_BR_EDR) != BTM_CMD_STARTED) {
+      bta_dm_search_cb.name_prefetch_count = 0;
+      return;
+    }
+
+    VLOG(1) << __func__ << ": reading name of " << bd_addr;
+    bta_dm_search_cb.name_prefetch_active = true;
+    bta_dm_search_cb.name_prefetch_bda = bd_addr;
+    return;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_name_prefetch_cback
+ *
+ * Description      Remote name complete call back from BTM for a name read
+ *                  while the inquiry is running. The name is kept in the
+ *                  inquiry database for the name and service discovery that
+ *                  follows the inquiry.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_name_prefetch_cback(void* p) {
+  tBTM_REMOTE_DEV_NAME* p_remote_name = (tBTM_REMOTE_DEV_NAME*)p;
+
+  bta_dm_search_cb.name_prefetch_active = false;
+
+  tBTM_INQ_INFO* p_inq_info = BTM_InqDbRead(bta_dm_search_cb.name_prefetch_bda);
+  if (p_remote_name->status == BTM_SUCCESS) {
+    bta_dm_search_cb.name_prefetch_failures = 0;
+    if (p_inq_info) {
+      strlcpy((char*)p_inq_info->remote_name,
+              (char*)p_remote_name->remote_bd_name,
+              sizeof(p_inq_info->remote_name));
+      p_inq_info->remote_name_len = strlen((char*)p_inq_info->remote_name);
+      p_inq_info->remote_name_state = BTM_INQ_RMT_NAME_DONE;
+    }
+  } else {
+    /* the pages of name requests compete with the inquiry, stop reading names
+     * during this inquiry if the controller does not cope with both */
+    bta_dm_search_cb.name_prefetch_failures++;
+    if (bta_dm_search_cb.name_prefetch_failures >=
+        BTA_DM_NAME_PREFETCH_MAX_FAILURES) {
+      LOG(WARNING) << __func__ << ": names are read after the inquiry";
+      bta_dm_search_cb.name_prefetch_count = 0;
+    }
+    if (p_inq_info) p_inq_info->remote_name_state = BTM_INQ_RMT_NAME_FAILED;
+  }
+
+  bta_dm_name_prefetch_next();
 }
 
 /*******************************************************************************
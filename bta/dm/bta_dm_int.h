@@ -335,6 +335,12 @@ typedef struct {
 
 } tBTA_DM_CB;
 
+/* Number of inquiry results waiting for a remote name request while the
+ * inquiry is running */
+#ifndef BTA_DM_NAME_PREFETCH_QUEUE_SIZE
+#define BTA_DM_NAME_PREFETCH_QUEUE_SIZE 8
+#endif
+
 /* DM search control block */
 typedef struct {
   tBTA_DM_SEARCH_CBACK* p_search_cback;
@@ -370,6 +376,15 @@ typedef struct {
   uint32_t ble_raw_used;
   alarm_t* gatt_close_timer; /* GATT channel close delay timer */
   RawAddress pending_close_bda; /* pending GATT channel remote device address */
+  /* remote name requests started while the inquiry is running */
+  RawAddress name_prefetch_queue[BTA_DM_NAME_PREFETCH_QUEUE_SIZE];
+  uint8_t name_prefetch_count;    /* number of queued devices */
+  bool name_prefetch_active;      /* a remote name request is in progress */
+  RawAddress name_prefetch_bda;   /* device of that remote name request */
+  uint8_t name_prefetch_failures; /* consecutive failed name requests */
+  uint64_t search_start_ms;       /* start of the search, 0 if none */
+  uint64_t search_first_device_ms; /* first inquiry result, 0 if none */
+  uint16_t search_num_devices;     /* number of inquiry responses */
 
 } tBTA_DM_SEARCH_CB;
 
@@ -27,6 +27,7 @@
 #include <base/logging.h>
 #include <string.h>
 
+#include <algorithm>
 #include <mutex>
 
 #include "bt_common.h"
@@ -34,10 +35,24 @@
 #include "bta_dm_api.h"
 #include "bta_dm_int.h"
 #include "bta_sys.h"
+#include "btif_bqr.h"
 #include "btm_api.h"
 #include "device/include/controller.h"
+#include "osi/include/properties.h"
 #include "stack/include/btu.h"
 
+/* fit the sniff and subrating parameters to the traffic of the links, off
+ * unless enabled: it changes the sniff behaviour peers are tested against */
+#define BTA_DM_PM_ADAPTIVE_PROPERTY "persist.bluetooth.pm.adaptive"
+
+/* duration of a baseband slot */
+#define BTA_DM_PM_SLOT_US 625
+
+/* links with an RSSI below this, or approaching their supervision timeout,
+ * within the last BTA_DM_PM_LINK_QUALITY_AGE_MS, are poor links */
+#define BTA_DM_PM_POOR_RSSI (-80)
+#define BTA_DM_PM_LINK_QUALITY_AGE_MS 30000
+
 static void bta_dm_pm_cback(tBTA_SYS_CONN_STATUS status, uint8_t id,
                             uint8_t app_id, const RawAddress& peer_addr);
 static void bta_dm_pm_set_mode(const RawAddress& peer_addr,
@@ -58,6 +73,10 @@ static void bta_dm_pm_set_sniff_policy(tBTA_DM_PEER_DEVICE* p_dev,
                                        bool bDisable);
 static void bta_dm_pm_stop_timer_by_index(tBTA_PM_TIMER* p_timer,
                                           uint8_t timer_idx);
+static uint32_t bta_dm_pm_traffic_slots(const RawAddress& peer_addr);
+static bool bta_dm_pm_poor_link(const RawAddress& peer_addr);
+static void bta_dm_pm_adapt_sniff(const RawAddress& peer_addr,
+                                  tBTM_PM_PWR_MD* p_pwr_md);
 
 #if (BTM_SSR_INCLUDED == TRUE)
 #if (BTA_HH_INCLUDED == TRUE)
@@ -67,11 +86,15 @@ static void bta_dm_pm_stop_timer_by_index(tBTA_PM_TIMER* p_timer,
 #define BTA_DM_PM_SSR_HH BTA_DM_PM_SSR1
 #endif
 static void bta_dm_pm_ssr(const RawAddress& peer_addr, int ssr);
+static void bta_dm_pm_link_quality_cback(
+    const bluetooth::bqr::BqrLinkQualityEventView& event);
 #endif
 
 tBTA_DM_CONNECTED_SRVCS bta_dm_conn_srvcs;
 static std::recursive_mutex pm_timer_schedule_mutex;
 static std::recursive_mutex pm_timer_state_mutex;
+static bool bta_dm_pm_adaptive = false;
+static int bta_dm_pm_link_quality_observer_id = 0;
 
 /*******************************************************************************
  *
@@ -85,6 +108,8 @@ static std::recursive_mutex pm_timer_state_mutex;
  ******************************************************************************/
 void bta_dm_init_pm(void) {
   memset(&bta_dm_conn_srvcs, 0x00, sizeof(bta_dm_conn_srvcs));
+  bta_dm_pm_adaptive =
+      osi_property_get_bool(BTA_DM_PM_ADAPTIVE_PROPERTY, false);
 
   /* if there are no power manger entries, so not register */
   if (p_bta_dm_pm_cfg[0].app_id != 0) {
@@ -92,6 +117,12 @@ void bta_dm_init_pm(void) {
 
     BTM_PmRegister((BTM_PM_REG_SET | BTM_PM_REG_NOTIF), &bta_dm_cb.pm_id,
                    bta_dm_pm_btm_cback);
+
+    if (bta_dm_pm_adaptive) {
+      bta_dm_pm_link_quality_observer_id =
+          bluetooth::bqr::RegisterLinkQualityObserver(
+              bta_dm_pm_link_quality_cback);
+    }
   }
 
   /* Need to initialize all PM timer service IDs */
@@ -114,6 +145,10 @@ void bta_dm_init_pm(void) {
 void bta_dm_disable_pm(void) {
   BTM_PmRegister(BTM_PM_DEREG, &bta_dm_cb.pm_id, NULL);
 
+  bluetooth::bqr::UnregisterLinkQualityObserver(
+      bta_dm_pm_link_quality_observer_id);
+  bta_dm_pm_link_quality_observer_id = 0;
+
   /*
    * Deregister the PM callback from the system handling to prevent
    * re-enabling the PM timers after this call if the callback is invoked.
@@ -727,6 +762,7 @@ static bool bta_dm_pm_sniff(tBTA_DM_PEER_DEVICE* p_peer_dev, uint8_t index) {
     /* if the current mode is not sniff, issue the sniff command.
      * If sniff, but SSR is not used in this link, still issue the command */
     memcpy(&pwr_md, &p_bta_dm_pm_md[index], sizeof(tBTM_PM_PWR_MD));
+    bta_dm_pm_adapt_sniff(p_peer_dev->peer_bdaddr, &pwr_md);
     if (p_peer_dev->info & BTA_DM_DI_INT_SNIFF) {
       pwr_md.mode |= BTM_PM_MD_FORCE;
     }
@@ -750,6 +786,119 @@ static bool bta_dm_pm_sniff(tBTA_DM_PEER_DEVICE* p_peer_dev, uint8_t index) {
   }
   return true;
 }
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_traffic_slots
+ *
+ * Description      Reads the interval between the ACL packets of a link, when
+ *                  the adaptive power mode policy is enabled.
+ *
+ * Returns          the interval in baseband slots, 0 if not known.
+ *
+ ******************************************************************************/
+static uint32_t bta_dm_pm_traffic_slots(const RawAddress& peer_addr) {
+  uint32_t interval_us = 0;
+
+  if (!bta_dm_pm_adaptive ||
+      BTM_ReadTrafficInterval(peer_addr, &interval_us) != BTM_SUCCESS)
+    return 0;
+  return interval_us / BTA_DM_PM_SLOT_US;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_poor_link
+ *
+ * Description      Tells from the link quality sampled by BTM if a link is
+ *                  poor, when the adaptive power mode policy is enabled.
+ *
+ * Returns          true if the link is poor.
+ *
+ ******************************************************************************/
+static bool bta_dm_pm_poor_link(const RawAddress& peer_addr) {
+  tBTM_LINK_QUALITY quality;
+
+  if (!bta_dm_pm_adaptive ||
+      BTM_ReadLinkQuality(peer_addr, BT_TRANSPORT_BR_EDR, &quality) !=
+          BTM_SUCCESS)
+    return false;
+  return quality.lsto_age_ms < BTA_DM_PM_LINK_QUALITY_AGE_MS ||
+         (quality.rssi_age_ms < BTA_DM_PM_LINK_QUALITY_AGE_MS &&
+          quality.rssi_avg < BTA_DM_PM_POOR_RSSI);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_link_quality_cback
+ *
+ * Description      Brings a sniffed link approaching its supervision timeout
+ *                  back to active mode as soon as the controller reports it,
+ *                  before it drops. The power mode timers then put it back in
+ *                  sniff with the interval of a poor link.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_pm_link_quality_cback(
+    const bluetooth::bqr::BqrLinkQualityEventView& event) {
+  if (event.QualityReportId() !=
+      bluetooth::bqr::QUALITY_REPORT_ID_APPROACH_LSTO)
+    return;
+
+  for (int i = 0; i < bta_dm_cb.device_list.count; i++) {
+    tBTA_DM_PEER_DEVICE* p_dev = &bta_dm_cb.device_list.peer_device[i];
+    if (p_dev->transport != BT_TRANSPORT_BR_EDR ||
+        BTM_GetHCIConnHandle(p_dev->peer_bdaddr, BT_TRANSPORT_BR_EDR) !=
+            event.ConnectionHandle())
+      continue;
+
+    tBTM_PM_MODE mode = BTM_PM_STS_ACTIVE;
+    BTM_ReadPowerMode(p_dev->peer_bdaddr, &mode);
+    if (mode == BTM_PM_MD_SNIFF) {
+      APPL_TRACE_WARNING("%s approaching LSTO, exit sniff handle:0x%04x",
+                         __func__, event.ConnectionHandle());
+      bta_dm_pm_active(p_dev->peer_bdaddr);
+    }
+    return;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_adapt_sniff
+ *
+ * Description      Fits the sniff interval of the spec tables to the traffic
+ *                  of the link: the packets of a link with steady traffic,
+ *                  like an HID device in use, would be delayed by up to the
+ *                  whole sniff interval when it is longer than the interval
+ *                  between them. A poor link misses more sniff anchors, each
+ *                  costing a whole interval, and gets the shortest interval
+ *                  of the table.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_pm_adapt_sniff(const RawAddress& peer_addr,
+                                  tBTM_PM_PWR_MD* p_pwr_md) {
+  if (bta_dm_pm_poor_link(peer_addr)) {
+    APPL_TRACE_DEBUG("%s poor link, sniff max:%d->%d", __func__, p_pwr_md->max,
+                     p_pwr_md->min);
+    p_pwr_md->max = p_pwr_md->min;
+    return;
+  }
+
+  uint32_t traffic_slots = bta_dm_pm_traffic_slots(peer_addr);
+  if (traffic_slots == 0 || traffic_slots >= p_pwr_md->max) return;
+
+  /* sniff intervals are even, and stay within the range of the table */
+  uint16_t max = (uint16_t)std::max<uint32_t>(traffic_slots & ~1u,
+                                               p_pwr_md->min);
+  APPL_TRACE_DEBUG("%s traffic interval:%d slots, sniff max:%d->%d", __func__,
+                   traffic_slots, p_pwr_md->max, max);
+  p_pwr_md->max = max;
+}
+
 /*******************************************************************************
  *
  * Function         bta_dm_pm_ssr
@@ -805,6 +954,15 @@ static void bta_dm_pm_ssr(const RawAddress& peer_addr, int ssr) {
   APPL_TRACE_WARNING("%s ssr:%d, lat:%d", __func__, ssr_index, p_spec->max_lat);
 
   if (p_spec->max_lat) {
+    /* a link with steady traffic doesn't subrate past its packet interval */
+    uint16_t max_lat = p_spec->max_lat;
+    uint32_t traffic_slots = bta_dm_pm_traffic_slots(peer_addr);
+    if (traffic_slots != 0 && traffic_slots < max_lat) {
+      max_lat = (uint16_t)std::max<uint32_t>(traffic_slots, 2);
+      APPL_TRACE_DEBUG("%s traffic interval:%d slots, lat:%d", __func__,
+                       traffic_slots, max_lat);
+    }
+
     /* Avoid SSR reset on device which has SCO connected */
     if (bta_dm_pm_is_sco_active()) {
       int idx = bta_dm_get_sco_index();
@@ -818,7 +976,7 @@ static void bta_dm_pm_ssr(const RawAddress& peer_addr, int ssr) {
     }
 
     /* set the SSR parameters. */
-    BTM_SetSsrParams(peer_addr, p_spec->max_lat, p_spec->min_rmt_to,
+    BTM_SetSsrParams(peer_addr, max_lat, p_spec->min_rmt_to,
                      p_spec->min_loc_to);
   }
 }
@@ -33,6 +33,7 @@
 #include "bta_gattc_int.h"
 #include "bta_sys.h"
 #include "btif/include/btif_debug_conn.h"
+#include "common/time_util.h"
 #include "l2c_api.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
@@ -133,6 +134,8 @@ void bta_gattc_disable() {
     return;
   }
 
+  bta_gattc_pool_set_size(0);
+
   for (i = 0; i < BTA_GATTC_CL_MAX; i++) {
     if (!bta_gattc_cb.cl_rcb[i].in_use) continue;
 
@@ -360,6 +363,9 @@ void bta_gattc_open(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
     return;
   }
 
+  if (p_data->api_conn.transport == BTA_TRANSPORT_LE)
+    bta_gattc_pool_take(p_data->api_conn.remote_bda);
+
   /* a connected remote device */
   if (GATT_GetConnIdIfConnected(
           p_clcb->p_rcb->client_if, p_data->api_conn.remote_bda,
@@ -545,6 +551,11 @@ void bta_gattc_close(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
   if (p_clcb->transport == BTA_TRANSPORT_BR_EDR)
     bta_sys_conn_close(BTA_ID_GATTC, BTA_ALL_APP_ID, p_clcb->bda);
 
+  /* keep the link open for the next poll if the pool has room for it */
+  if (p_data->hdr.event == BTA_GATTC_API_CLOSE_EVT &&
+      p_clcb->transport == BTA_TRANSPORT_LE)
+    bta_gattc_pool_release(p_clcb->bda);
+
   bta_gattc_clcb_dealloc(p_clcb);
 
   if (p_data->hdr.event == BTA_GATTC_API_CLOSE_EVT) {
@@ -629,6 +640,17 @@ void bta_gattc_cfg_mtu(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
   }
 }
 
+/** Start discovering all the services of the server */
+static void bta_gattc_discover_all_services(tBTA_GATTC_CLCB* p_clcb) {
+  p_clcb->status = bta_gattc_discover_pri_service(
+      p_clcb->bta_conn_id, p_clcb->p_srcb, GATT_DISC_SRVC_ALL);
+  if (p_clcb->status != GATT_SUCCESS) {
+    LOG(ERROR) << "discovery on server failed";
+    bta_gattc_reset_discover_st(p_clcb->p_srcb, p_clcb->status);
+  } else
+    p_clcb->disc_active = true;
+}
+
 /** Start a discovery on server */
 void bta_gattc_start_discover(tBTA_GATTC_CLCB* p_clcb,
                               UNUSED_ATTR tBTA_GATTC_DATA* p_data) {
@@ -656,13 +678,18 @@ void bta_gattc_start_discover(tBTA_GATTC_CLCB* p_clcb,
       bta_gattc_set_discover_st(p_clcb->p_srcb);
 
       bta_gattc_init_cache(p_clcb->p_srcb);
-      p_clcb->status = bta_gattc_discover_pri_service(
-          p_clcb->bta_conn_id, p_clcb->p_srcb, GATT_DISC_SRVC_ALL);
-      if (p_clcb->status != GATT_SUCCESS) {
-        LOG(ERROR) << "discovery on server failed";
-        bta_gattc_reset_discover_st(p_clcb->p_srcb, p_clcb->status);
-      } else
+      p_clcb->p_srcb->disc_start_ms =
+          bluetooth::common::time_get_os_boottime_ms();
+      p_clcb->p_srcb->has_db_hash = false;
+
+      /* read the Database Hash first, the discovery is skipped if the server
+       * database was cached with the same hash */
+      if (bta_gattc_read_db_hash(p_clcb) == GATT_SUCCESS) {
+        p_clcb->p_srcb->db_hash_read = true;
         p_clcb->disc_active = true;
+      } else {
+        bta_gattc_discover_all_services(p_clcb);
+      }
     } else {
       LOG(ERROR) << "unknown device, can not start discovery";
     }
@@ -686,6 +713,7 @@ void bta_gattc_disc_cmpl(tBTA_GATTC_CLCB* p_clcb,
   if (p_clcb->transport == BTA_TRANSPORT_LE)
     L2CA_EnableUpdateBleConnParams(p_clcb->p_srcb->server_bda, true);
   p_clcb->p_srcb->state = BTA_GATTC_SERV_IDLE;
+  p_clcb->p_srcb->db_hash_read = false;
   p_clcb->disc_active = false;
 
   if (p_clcb->status != GATT_SUCCESS) {
@@ -971,9 +999,37 @@ void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
   }
 }
 
+/** Database Hash read before discovery completed */
+static void bta_gattc_db_hash_read_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                                        const tBTA_GATTC_OP_CMPL* p_data) {
+  tBTA_GATTC_SERV* p_srcb = p_clcb->p_srcb;
+  p_srcb->db_hash_read = false;
+
+  if (p_data->status == GATT_SUCCESS && p_data->p_cmpl &&
+      p_data->p_cmpl->att_value.len == p_srcb->db_hash.size()) {
+    memcpy(p_srcb->db_hash.data(), p_data->p_cmpl->att_value.value,
+           p_srcb->db_hash.size());
+    p_srcb->has_db_hash = true;
+  }
+
+  if (bta_gattc_cache_load_by_hash(p_srcb)) {
+    LOG(INFO) << __func__ << ": Database Hash unchanged, discovery skipped";
+    bta_gattc_reset_discover_st(p_srcb, GATT_SUCCESS);
+    return;
+  }
+
+  bta_gattc_discover_all_services(p_clcb);
+}
+
 /** operation completed */
-void bta_gattc_ignore_op_cmpl(UNUSED_ATTR tBTA_GATTC_CLCB* p_clcb,
+void bta_gattc_ignore_op_cmpl(tBTA_GATTC_CLCB* p_clcb,
                               tBTA_GATTC_DATA* p_data) {
+  if (p_clcb->p_srcb && p_clcb->p_srcb->db_hash_read &&
+      p_data->op_cmpl.op_code == GATTC_OPTYPE_READ) {
+    bta_gattc_db_hash_read_cmpl(p_clcb, &p_data->op_cmpl);
+    return;
+  }
+
   /* receive op complete when discovery is started, ignore the response,
       and wait for discovery finish and resent */
   VLOG(1) << __func__ << ": op = " << +p_data->hdr.layer_specific;
@@ -1019,6 +1075,7 @@ static void bta_gattc_deregister_cmpl(tBTA_GATTC_RCB* p_clreg) {
   memset(&cb_data, 0, sizeof(tBTA_GATTC));
 
   GATT_Deregister(p_clreg->client_if);
+  bta_gattc_notif_index_remove_client(client_if);
   memset(p_clreg, 0, sizeof(tBTA_GATTC_RCB));
 
   cb_data.reg_oper.client_if = client_if;
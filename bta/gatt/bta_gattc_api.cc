@@ -490,6 +490,45 @@ void BTA_GATTC_WriteCharValue(uint16_t conn_id, uint16_t handle,
   bta_sys_sendmsg(p_buf);
 }
 
+static void write_char_value_no_rsp_impl(uint16_t conn_id, uint16_t handle,
+                                         std::vector<uint8_t> value,
+                                         GATT_WRITE_OP_CB callback,
+                                         void* cb_data) {
+  tGATT_STATUS status =
+      GATTC_WriteNoRsp(conn_id, handle, value.size(), value.data());
+  /* queued behind pending requests, it is sent in order */
+  if (status == GATT_CMD_STARTED) status = GATT_SUCCESS;
+
+  if (callback) callback(conn_id, status, handle, cb_data);
+}
+
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_WriteCharValueNoRsp
+ *
+ * Description      This function is called to write characteristic value
+ *                  without response, with no authentication required. Unlike
+ *                  BTA_GATTC_WriteCharValue, several of them can be in flight
+ *                  on a connection: |callback| is called as soon as the write
+ *                  is handed to L2CAP, with GATT_CONGESTED when the
+ *                  application should wait for BTA_GATTC_CONGEST_EVT before
+ *                  writing more.
+ *
+ * Parameters       conn_id - connection ID.
+ *                  handle - characteristic handle to write.
+ *                  value - the value to be written.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void BTA_GATTC_WriteCharValueNoRsp(uint16_t conn_id, uint16_t handle,
+                                   std::vector<uint8_t> value,
+                                   GATT_WRITE_OP_CB callback, void* cb_data) {
+  do_in_main_thread(FROM_HERE, base::Bind(&write_char_value_no_rsp_impl,
+                                          conn_id, handle, std::move(value),
+                                          callback, cb_data));
+}
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_WriteCharDescr
@@ -664,6 +703,7 @@ tGATT_STATUS BTA_GATTC_RegisterForNotifications(tGATT_IF client_if,
           p_clreg->notif_reg[i].remote_bda = bda;
 
           p_clreg->notif_reg[i].handle = handle;
+          bta_gattc_notif_index_add(client_if, bda, handle);
           status = GATT_SUCCESS;
           break;
         }
@@ -714,6 +754,7 @@ tGATT_STATUS BTA_GATTC_DeregisterForNotifications(tGATT_IF client_if,
         p_clreg->notif_reg[i].remote_bda == bda &&
         p_clreg->notif_reg[i].handle == handle) {
       VLOG(1) << __func__ << " deregistered bd_addr=" << bda;
+      bta_gattc_notif_index_remove(client_if, bda, handle);
       memset(&p_clreg->notif_reg[i], 0, sizeof(tBTA_GATTC_NOTIF_REG));
       return GATT_SUCCESS;
     }
@@ -738,3 +779,22 @@ void BTA_GATTC_Refresh(const RawAddress& remote_bda) {
   do_in_main_thread(FROM_HERE,
                     base::Bind(&bta_gattc_process_api_refresh, remote_bda));
 }
+
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_SetConnectionPool
+ *
+ * Description      Keep up to |max_links| LE links open once the applications
+ *                  close them, so that the peers polled periodically are
+ *                  reopened without a new connection and discovery. The link
+ *                  released the longest ago is closed when the pool is full.
+ *
+ * Parameters       max_links: number of links kept open, 0 to disable.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTA_GATTC_SetConnectionPool(uint8_t max_links) {
+  do_in_main_thread(FROM_HERE,
+                    base::Bind(&bta_gattc_pool_set_size, max_links));
+}
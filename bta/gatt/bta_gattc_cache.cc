@@ -27,18 +27,22 @@
 
 #include "bt_target.h"
 
-#include <errno.h>
-#include <stdio.h>
 #include <string.h>
-#include <unistd.h>
 #include <sstream>
 
+#include <base/bind.h>
+#include <base/bind_helpers.h>
+
 #include "bt_common.h"
 #include "bta_gattc_int.h"
 #include "bta_sys.h"
 #include "btm_api.h"
 #include "btm_ble_api.h"
 #include "btm_int.h"
+#include "cache_store.h"
+#include "common/message_loop_thread.h"
+#include "common/metrics.h"
+#include "common/time_util.h"
 #include "database.h"
 #include "database_builder.h"
 #include "osi/include/log.h"
@@ -49,6 +53,9 @@
 
 using base::StringPrintf;
 using bluetooth::Uuid;
+using bluetooth::common::BluetoothMetricsLogger;
+using bluetooth::common::MessageLoopThread;
+using gatt::CacheStore;
 using gatt::Characteristic;
 using gatt::Database;
 using gatt::DatabaseBuilder;
@@ -58,7 +65,9 @@ using gatt::Service;
 using gatt::StoredAttribute;
 
 static void bta_gattc_cache_write(const RawAddress& server_bda,
-                                  const std::vector<StoredAttribute>& attr);
+                                  std::vector<StoredAttribute> attr,
+                                  const CacheStore::Hash* hash,
+                                  uint32_t discovery_ms);
 static tGATT_STATUS bta_gattc_sdp_service_disc(uint16_t conn_id,
                                                tBTA_GATTC_SERV* p_server_cb);
 const Descriptor* bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV* p_srcb,
@@ -70,14 +79,25 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
 
 #define BTA_GATT_SDP_DB_SIZE 4096
 
-#define GATT_CACHE_PREFIX "/data/misc/bluetooth/gatt_cache_"
-#define GATT_CACHE_VERSION 5
+#define GATT_CACHE_PATH "/data/misc/bluetooth/gatt_cache"
+
+/* Maximal size of the cached attributes of all servers, about a thousand
+ * servers with 100 attributes each */
+#ifndef GATT_CACHE_MAX_SIZE
+#define GATT_CACHE_MAX_SIZE (100 * 1000 * sizeof(StoredAttribute))
+#endif
 
-static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
-                                               const RawAddress& bda) {
-  snprintf(buffer, buffer_len, "%s%02x%02x%02x%02x%02x%02x", GATT_CACHE_PREFIX,
-           bda.address[0], bda.address[1], bda.address[2], bda.address[3],
-           bda.address[4], bda.address[5]);
+/* The cache file is written on its own thread, not to hold the main thread on
+ * storage */
+static MessageLoopThread cache_write_thread("bt_gatt_cache_thread");
+
+static CacheStore& bta_gattc_cache_store() {
+  static CacheStore* store = [] {
+    CacheStore* store = new CacheStore(GATT_CACHE_PATH, GATT_CACHE_MAX_SIZE);
+    store->Open();
+    return store;
+  }();
+  return *store;
 }
 
 /*****************************************************************************
@@ -119,16 +139,6 @@ void bta_gattc_init_cache(tBTA_GATTC_SERV* p_srvc_cb) {
   p_srvc_cb->pending_discovery.Clear();
 }
 
-const Service* bta_gattc_find_matching_service(
-    const std::list<Service>& services, uint16_t handle) {
-  for (const Service& service : services) {
-    if (handle >= service.handle && handle <= service.end_handle)
-      return &service;
-  }
-
-  return nullptr;
-}
-
 /** Start primary service discovery */
 tGATT_STATUS bta_gattc_discover_pri_service(uint16_t conn_id,
                                             tBTA_GATTC_SERV* p_server_cb,
@@ -182,12 +192,19 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
 #if (BTA_GATT_DEBUG == TRUE)
   bta_gattc_display_cache_server(p_srvc_cb->gatt_database);
 #endif
-  /* save cache to NV */
+  uint32_t discovery_ms =
+      bluetooth::common::time_get_os_boottime_ms() - p_srvc_cb->disc_start_ms;
+  BluetoothMetricsLogger::GetInstance()->LogGattDiscovery(false, discovery_ms);
+
+  /* save cache to NV; the database of a server with a Database Hash can be
+   * trusted on reconnection even without a bond */
   p_clcb->p_srcb->state = BTA_GATTC_SERV_SAVE;
 
-  if (btm_sec_is_a_bonded_dev(p_srvc_cb->server_bda)) {
-    bta_gattc_cache_write(p_clcb->p_srcb->server_bda,
-                          p_clcb->p_srcb->gatt_database.Serialize());
+  if (btm_sec_is_a_bonded_dev(p_srvc_cb->server_bda) ||
+      p_srvc_cb->has_db_hash) {
+    bta_gattc_cache_write(
+        p_clcb->p_srcb->server_bda, p_clcb->p_srcb->gatt_database.Serialize(),
+        p_srvc_cb->has_db_hash ? &p_srvc_cb->db_hash : nullptr, discovery_ms);
   }
 
   bta_gattc_reset_discover_st(p_clcb->p_srcb, GATT_SUCCESS);
@@ -437,31 +454,22 @@ const std::list<Service>* bta_gattc_get_services(uint16_t conn_id) {
 
 const Service* bta_gattc_get_service_for_handle_srcb(tBTA_GATTC_SERV* p_srcb,
                                                      uint16_t handle) {
-  const std::list<Service>* services = bta_gattc_get_services_srcb(p_srcb);
-  if (services == NULL) return NULL;
-  return bta_gattc_find_matching_service(*services, handle);
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.GetService(handle);
 }
 
 const Service* bta_gattc_get_service_for_handle(uint16_t conn_id,
                                                 uint16_t handle) {
-  const std::list<Service>* services = bta_gattc_get_services(conn_id);
-  if (services == NULL) return NULL;
+  tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+  if (p_clcb == NULL) return NULL;
 
-  return bta_gattc_find_matching_service(*services, handle);
+  return bta_gattc_get_service_for_handle_srcb(p_clcb->p_srcb, handle);
 }
 
 const Characteristic* bta_gattc_get_characteristic_srcb(tBTA_GATTC_SERV* p_srcb,
                                                         uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) return NULL;
-
-  for (const Characteristic& charac : service->characteristics) {
-    if (handle == charac.value_handle) return &charac;
-  }
-
-  return NULL;
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.GetCharacteristic(handle);
 }
 
 const Characteristic* bta_gattc_get_characteristic(uint16_t conn_id,
@@ -476,20 +484,8 @@ const Characteristic* bta_gattc_get_characteristic(uint16_t conn_id,
 
 const Descriptor* bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV* p_srcb,
                                                 uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) {
-    return NULL;
-  }
-
-  for (const Characteristic& charac : service->characteristics) {
-    for (const Descriptor& desc : charac.descriptors) {
-      if (handle == desc.handle) return &desc;
-    }
-  }
-
-  return NULL;
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.GetDescriptor(handle);
 }
 
 const Descriptor* bta_gattc_get_descriptor(uint16_t conn_id, uint16_t handle) {
@@ -503,18 +499,8 @@ const Descriptor* bta_gattc_get_descriptor(uint16_t conn_id, uint16_t handle) {
 
 const Characteristic* bta_gattc_get_owning_characteristic_srcb(
     tBTA_GATTC_SERV* p_srcb, uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) return NULL;
-
-  for (const Characteristic& charac : service->characteristics) {
-    for (const Descriptor& desc : charac.descriptors) {
-      if (handle == desc.handle) return &charac;
-    }
-  }
-
-  return NULL;
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.GetOwningCharacteristic(handle);
 }
 
 const Characteristic* bta_gattc_get_owning_characteristic(uint16_t conn_id,
@@ -709,50 +695,63 @@ void bta_gattc_get_gatt_db(uint16_t conn_id, uint16_t start_handle,
  *
  ******************************************************************************/
 bool bta_gattc_cache_load(tBTA_GATTC_SERV* p_srcb) {
-  char fname[255] = {0};
-  bta_gattc_generate_cache_file_name(fname, sizeof(fname), p_srcb->server_bda);
+  /* the cache of a server that is not bonded is only valid once its Database
+   * Hash is checked, see bta_gattc_cache_load_by_hash */
+  if (!btm_sec_is_a_bonded_dev(p_srcb->server_bda)) return false;
 
-  FILE* fd = fopen(fname, "rb");
-  if (!fd) {
-    LOG(ERROR) << __func__ << ": can't open GATT cache file " << fname
-               << " for reading, error: " << strerror(errno);
-    return false;
-  }
-
-  uint16_t cache_ver = 0;
-  bool success = false;
-  uint16_t num_attr = 0;
+  return bta_gattc_cache_store().Load(p_srcb->server_bda,
+                                      &p_srcb->gatt_database);
+}
 
-  if (fread(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't read GATT cache version from: " << fname;
-    goto done;
-  }
+/** Start reading the Database Hash of the server, to find out whether its
+ * cached database is still valid before discovering it */
+tGATT_STATUS bta_gattc_read_db_hash(tBTA_GATTC_CLCB* p_clcb) {
+  if (p_clcb->transport != BTA_TRANSPORT_LE) return GATT_REQ_NOT_SUPPORTED;
+
+  tGATT_READ_PARAM read_param;
+  memset(&read_param, 0, sizeof(tGATT_READ_BY_TYPE));
+  read_param.char_type.s_handle = 0x0001;
+  read_param.char_type.e_handle = 0xFFFF;
+  read_param.char_type.uuid = Uuid::From16Bit(GATT_UUID_DATABASE_HASH);
+  read_param.char_type.auth_req = GATT_AUTH_REQ_NONE;
+  return GATTC_Read(p_clcb->bta_conn_id, GATT_READ_BY_TYPE, &read_param);
+}
 
-  if (cache_ver != GATT_CACHE_VERSION) {
-    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
-    goto done;
-  }
+/*******************************************************************************
+ *
+ * Function         bta_gattc_cache_load_by_hash
+ *
+ * Description      Load GATT cache from storage for server, only if it was
+ *                  saved with the Database Hash just read from the server.
+ *
+ * Parameter        p_srcb: pointer to server cache, that will
+ *                          be filled from storage
+ * Returns          true on success, false otherwise
+ *
+ ******************************************************************************/
+bool bta_gattc_cache_load_by_hash(tBTA_GATTC_SERV* p_srcb) {
+  if (!p_srcb->has_db_hash) return false;
 
-  if (fread(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't read number of GATT attributes: " << fname;
-    goto done;
+  CacheStore& store = bta_gattc_cache_store();
+  if (!store.Load(p_srcb->server_bda, &p_srcb->gatt_database,
+                  &p_srcb->db_hash)) {
+    return false;
   }
 
-  {
-    std::vector<StoredAttribute> attr(num_attr);
-
-    if (fread(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-      LOG(ERROR) << __func__ << "s: can't read GATT attributes: " << fname;
-      goto done;
-    }
+  BluetoothMetricsLogger::GetInstance()->LogGattDiscovery(
+      true, store.DiscoveryTime(p_srcb->server_bda));
+  return true;
+}
 
-    p_srcb->gatt_database = gatt::Database::Deserialize(attr, &success);
-  }
+/* Writes the cache file with the current content of the store, on the cache
+ * thread */
+static void bta_gattc_cache_save() {
+  if (!cache_write_thread.IsRunning()) cache_write_thread.StartUp();
 
-done:
-  fclose(fd);
-  return success;
+  CacheStore& store = bta_gattc_cache_store();
+  cache_write_thread.DoInThread(
+      FROM_HERE, base::BindOnce(base::IgnoreResult(&CacheStore::WriteFile),
+                                store.Path(), store.Serialize()));
 }
 
 /*******************************************************************************
@@ -764,43 +763,18 @@ done:
  *
  * Parameter        server_bda: server bd address of this cache belongs to
  *                  attr: attributes to save.
+ *                  hash: Database Hash of the server, or nullptr.
+ *                  discovery_ms: time the discovery of attr took.
  * Returns
  *
  ******************************************************************************/
 static void bta_gattc_cache_write(const RawAddress& server_bda,
-                                  const std::vector<StoredAttribute>& attr) {
-  char fname[255] = {0};
-  bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
-
-  FILE* fd = fopen(fname, "wb");
-  if (!fd) {
-    LOG(ERROR) << __func__
-               << ": can't open GATT cache file for writing: " << fname;
-    return;
-  }
-
-  uint16_t cache_ver = GATT_CACHE_VERSION;
-  if (fwrite(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache version: " << fname;
-    fclose(fd);
-    return;
-  }
-
-  uint16_t num_attr = attr.size();
-  if (fwrite(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't write GATT cache attribute count: " << fname;
-    fclose(fd);
-    return;
-  }
-
-  if (fwrite(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache attributes: " << fname;
-    fclose(fd);
-    return;
-  }
-
-  fclose(fd);
+                                  std::vector<StoredAttribute> attr,
+                                  const CacheStore::Hash* hash,
+                                  uint32_t discovery_ms) {
+  bta_gattc_cache_store().Store(server_bda, std::move(attr), hash,
+                                discovery_ms);
+  bta_gattc_cache_save();
 }
 
 /*******************************************************************************
@@ -817,7 +791,5 @@ static void bta_gattc_cache_write(const RawAddress& server_bda,
  ******************************************************************************/
 void bta_gattc_cache_reset(const RawAddress& server_bda) {
   VLOG(1) << __func__;
-  char fname[255] = {0};
-  bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
-  unlink(fname);
+  if (bta_gattc_cache_store().Remove(server_bda)) bta_gattc_cache_save();
 }
@@ -28,6 +28,7 @@
 
 #include "bta_gatt_api.h"
 #include "bta_sys.h"
+#include "cache_store.h"
 #include "database_builder.h"
 #include "osi/include/fixed_queue.h"
 
@@ -35,6 +36,9 @@
 
 #include <base/logging.h>
 #include <base/strings/stringprintf.h>
+#include <map>
+#include <utility>
+#include <vector>
 
 /*****************************************************************************
  *  Constants and data types
@@ -217,6 +221,11 @@ typedef struct {
   uint16_t attr_index;  /* cahce NV saving/loading attribute index */
 
   uint16_t mtu;
+
+  bool db_hash_read; /* Database Hash read before discovery pending */
+  bool has_db_hash;  /* db_hash is the Database Hash of the server */
+  gatt::CacheStore::Hash db_hash;
+  uint64_t disc_start_ms; /* time the discovery started */
 } tBTA_GATTC_SERV;
 
 #ifndef BTA_GATTC_NOTIF_REG_MAX
@@ -298,6 +307,11 @@ typedef struct {
 
   tBTA_GATTC_CLCB clcb[BTA_GATTC_CLCB_MAX];
   tBTA_GATTC_SERV known_server[BTA_GATTC_KNOWN_SR_MAX];
+
+  /* Clients registered in notif_reg, by server and attribute handle, so that
+   * notifications don't search the registrations of every client */
+  std::map<std::pair<RawAddress, uint16_t>, std::vector<tGATT_IF>>
+      notif_index;
 } tBTA_GATTC_CB;
 
 /*****************************************************************************
@@ -403,6 +417,12 @@ extern bool bta_gattc_enqueue(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data);
 extern bool bta_gattc_check_notif_registry(tBTA_GATTC_RCB* p_clreg,
                                            tBTA_GATTC_SERV* p_srcb,
                                            tBTA_GATTC_NOTIFY* p_notify);
+extern void bta_gattc_notif_index_add(tGATT_IF client_if,
+                                      const RawAddress& bda, uint16_t handle);
+extern void bta_gattc_notif_index_remove(tGATT_IF client_if,
+                                         const RawAddress& bda,
+                                         uint16_t handle);
+extern void bta_gattc_notif_index_remove_client(tGATT_IF client_if);
 extern bool bta_gattc_mark_bg_conn(tGATT_IF client_if,
                                    const RawAddress& remote_bda, bool add);
 extern bool bta_gattc_check_bg_conn(tGATT_IF client_if,
@@ -414,6 +434,12 @@ extern void bta_gattc_clear_notif_registration(tBTA_GATTC_SERV* p_srcb,
                                                uint16_t end_handle);
 extern tBTA_GATTC_SERV* bta_gattc_find_srvr_cache(const RawAddress& bda);
 
+/* connection pool functions */
+extern void bta_gattc_pool_set_size(uint8_t max_links);
+extern void bta_gattc_pool_release(const RawAddress& bda);
+extern void bta_gattc_pool_take(const RawAddress& bda);
+extern bool bta_gattc_pool_contains(const RawAddress& bda);
+
 /* discovery functions */
 extern void bta_gattc_disc_res_cback(uint16_t conn_id,
                                      tGATT_DISC_TYPE disc_type,
@@ -452,6 +478,8 @@ extern tBTA_GATTC_CONN* bta_gattc_conn_find_alloc(const RawAddress& remote_bda);
 extern bool bta_gattc_conn_dealloc(const RawAddress& remote_bda);
 
 extern bool bta_gattc_cache_load(tBTA_GATTC_SERV* p_srcb);
+extern tGATT_STATUS bta_gattc_read_db_hash(tBTA_GATTC_CLCB* p_clcb);
+extern bool bta_gattc_cache_load_by_hash(tBTA_GATTC_SERV* p_srcb);
 extern void bta_gattc_cache_reset(const RawAddress& server_bda);
 
 #endif /* BTA_GATTC_INT_H */
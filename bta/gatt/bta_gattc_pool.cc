@@ -0,0 +1,218 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the GATT client connection pool. When enabled, the LE
+ *  links closed by the applications are kept open, up to a number of links,
+ *  so that a peer polled periodically is reopened without a new connection,
+ *  encryption and service discovery.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_bta_gattc"
+
+#include <base/logging.h>
+
+#include <algorithm>
+#include <list>
+
+#include "bt_target.h"
+#include "bta_gattc_int.h"
+#include "btm_api.h"
+#include "l2c_api.h"
+#include "osi/include/osi.h"
+
+using bluetooth::Uuid;
+
+/* The links of the pool are kept open with a long connection interval, of 400
+ * to 500 ms, as long as no application uses them */
+#define BTA_GATTC_POOL_CONN_INT_MIN 320
+#define BTA_GATTC_POOL_CONN_INT_MAX 400
+#define BTA_GATTC_POOL_CONN_LATENCY 0
+#define BTA_GATTC_POOL_CONN_TIMEOUT 600
+
+#define BTA_GATTC_POOL_MAX_LINKS GATT_MAX_PHY_CHANNEL
+
+static void bta_gattc_pool_conn_cback(tGATT_IF gatt_if, const RawAddress& bda,
+                                      uint16_t conn_id, bool connected,
+                                      tGATT_DISCONN_REASON reason,
+                                      tBT_TRANSPORT transport);
+
+static tGATT_CBACK bta_gattc_pool_cback = {bta_gattc_pool_conn_cback,
+                                           NULL,
+                                           NULL,
+                                           NULL,
+                                           NULL,
+                                           NULL,
+                                           NULL,
+                                           NULL,
+                                           NULL};
+
+/* Links of the pool, the one released the longest ago first: it is the first
+ * one closed when the pool is full, the peers are polled in turn */
+static std::list<RawAddress> pool_links;
+static uint8_t pool_max_links = 0;
+/* GATT registration holding the links of the pool */
+static tGATT_IF pool_gatt_if = 0;
+
+/* Forget the MTU and the database of |bda| kept for the pool, if no
+ * application uses them */
+static void bta_gattc_pool_reset_srcb(const RawAddress& bda) {
+  tBTA_GATTC_SERV* p_srcb = bta_gattc_find_srcb(bda);
+  if (p_srcb == NULL || p_srcb->num_clcb != 0) return;
+
+  p_srcb->mtu = 0;
+  p_srcb->gatt_database.Clear();
+}
+
+/* Stop holding the link to |bda|, the GATT idle timer closes it unless an
+ * application uses it */
+static void bta_gattc_pool_drop(const RawAddress& bda) {
+  uint16_t conn_id;
+  if (GATT_GetConnIdIfConnected(pool_gatt_if, bda, &conn_id,
+                                BT_TRANSPORT_LE))
+    GATT_Disconnect(conn_id);
+
+  bta_gattc_pool_reset_srcb(bda);
+}
+
+/* Close the links released the longest ago while the pool holds too many */
+static void bta_gattc_pool_evict() {
+  while (pool_links.size() > pool_max_links) {
+    RawAddress bda = pool_links.front();
+    pool_links.pop_front();
+    bta_gattc_pool_drop(bda);
+  }
+}
+
+static void bta_gattc_pool_conn_cback(UNUSED_ATTR tGATT_IF gatt_if,
+                                      const RawAddress& bda,
+                                      UNUSED_ATTR uint16_t conn_id,
+                                      bool connected,
+                                      UNUSED_ATTR tGATT_DISCONN_REASON reason,
+                                      tBT_TRANSPORT transport) {
+  if (connected || transport != BT_TRANSPORT_LE) return;
+
+  auto it = std::find(pool_links.begin(), pool_links.end(), bda);
+  if (it == pool_links.end()) return;
+
+  VLOG(1) << __func__ << ": pooled link to " << bda << " lost";
+  pool_links.erase(it);
+  bta_gattc_pool_reset_srcb(bda);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_pool_set_size
+ *
+ * Description      Set the number of LE links the pool keeps open, 0 to
+ *                  disable the pool. The links released the longest ago are
+ *                  closed if the pool holds more.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_gattc_pool_set_size(uint8_t max_links) {
+  pool_max_links = std::min<uint8_t>(max_links, BTA_GATTC_POOL_MAX_LINKS);
+  VLOG(1) << __func__ << ": max_links=" << +pool_max_links;
+
+  if (pool_max_links != 0 && pool_gatt_if == 0) {
+    pool_gatt_if = GATT_Register(Uuid::GetRandom(), &bta_gattc_pool_cback);
+    if (pool_gatt_if == 0) {
+      LOG(ERROR) << __func__ << ": unable to register with GATT";
+      pool_max_links = 0;
+      return;
+    }
+  }
+
+  bta_gattc_pool_evict();
+
+  if (pool_max_links == 0 && pool_gatt_if != 0) {
+    GATT_Deregister(pool_gatt_if);
+    pool_gatt_if = 0;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_pool_release
+ *
+ * Description      An application closes its connection to |bda|: keep the
+ *                  link open in the pool, with a long connection interval if
+ *                  no other application uses it. Called before the clcb of
+ *                  the closing application is freed.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_gattc_pool_release(const RawAddress& bda) {
+  if (pool_max_links == 0 || !BTM_IsAclConnectionUp(bda, BT_TRANSPORT_LE))
+    return;
+
+  pool_links.remove(bda);
+  if (!GATT_Connect(pool_gatt_if, bda, true, BT_TRANSPORT_LE, false)) return;
+  pool_links.push_back(bda);
+
+  VLOG(1) << __func__ << ": " << bda << " kept open, "
+          << pool_links.size() << " pooled links";
+
+  tBTA_GATTC_SERV* p_srcb = bta_gattc_find_srcb(bda);
+  if (p_srcb != NULL && p_srcb->num_clcb <= 1) {
+    L2CA_UpdateBleConnParams(bda, BTA_GATTC_POOL_CONN_INT_MIN,
+                             BTA_GATTC_POOL_CONN_INT_MAX,
+                             BTA_GATTC_POOL_CONN_LATENCY,
+                             BTA_GATTC_POOL_CONN_TIMEOUT);
+  }
+
+  bta_gattc_pool_evict();
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_pool_take
+ *
+ * Description      An application opened a connection to |bda|: take the link
+ *                  out of the pool, and restore the default connection
+ *                  parameters. Called once the application holds the link.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_gattc_pool_take(const RawAddress& bda) {
+  auto it = std::find(pool_links.begin(), pool_links.end(), bda);
+  if (it == pool_links.end()) return;
+
+  pool_links.erase(it);
+
+  uint16_t conn_id;
+  if (GATT_GetConnIdIfConnected(pool_gatt_if, bda, &conn_id,
+                                BT_TRANSPORT_LE))
+    GATT_Disconnect(conn_id);
+
+  L2CA_UpdateBleConnParams(bda, BTM_BLE_CONN_INT_MIN_DEF,
+                           BTM_BLE_CONN_INT_MAX_DEF,
+                           BTM_BLE_CONN_SLAVE_LATENCY_DEF,
+                           BTM_BLE_CONN_TIMEOUT_DEF);
+}
+
+/** Returns true if the link to |bda| is kept open by the pool */
+bool bta_gattc_pool_contains(const RawAddress& bda) {
+  return std::find(pool_links.begin(), pool_links.end(), bda) !=
+         pool_links.end();
+}
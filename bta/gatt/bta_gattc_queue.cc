@@ -126,9 +126,14 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
         (gatt_write_op_data*)osi_malloc(sizeof(gatt_write_op_data));
     data->cb = op.write_cb;
     data->cb_data = op.write_cb_data;
-    BTA_GATTC_WriteCharValue(conn_id, op.handle, op.write_type,
-                             std::move(op.value), GATT_AUTH_REQ_NONE,
-                             gatt_write_op_finished, data);
+    if (op.write_type == GATT_WRITE_NO_RSP) {
+      BTA_GATTC_WriteCharValueNoRsp(conn_id, op.handle, std::move(op.value),
+                                    gatt_write_op_finished, data);
+    } else {
+      BTA_GATTC_WriteCharValue(conn_id, op.handle, op.write_type,
+                               std::move(op.value), GATT_AUTH_REQ_NONE,
+                               gatt_write_op_finished, data);
+    }
 
   } else if (op.type == GATT_WRITE_DESC) {
     gatt_write_op_data* data =
@@ -169,6 +174,16 @@ void BtaGattQueue::WriteCharacteristic(uint16_t conn_id, uint16_t handle,
                                        std::vector<uint8_t> value,
                                        tGATT_WRITE_TYPE write_type,
                                        GATT_WRITE_OP_CB cb, void* cb_data) {
+  /* A write without response needs no response to wait for and can go out
+   * while another operation executes, as long as none is waiting before it */
+  auto map_ptr = gatt_op_queue.find(conn_id);
+  if (write_type == GATT_WRITE_NO_RSP &&
+      (map_ptr == gatt_op_queue.end() || map_ptr->second.empty())) {
+    BTA_GATTC_WriteCharValueNoRsp(conn_id, handle, std::move(value), cb,
+                                  cb_data);
+    return;
+  }
+
   gatt_op_queue[conn_id].push_back({.type = GATT_WRITE_CHAR,
                                     .handle = handle,
                                     .write_cb = cb,
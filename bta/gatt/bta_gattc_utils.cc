@@ -28,6 +28,7 @@
 
 #include <base/logging.h>
 #include <string.h>
+#include <algorithm>
 
 #include "bt_common.h"
 #include "bta_gattc_int.h"
@@ -201,10 +202,15 @@ void bta_gattc_clcb_dealloc(tBTA_GATTC_CLCB* p_clcb) {
   if (p_srcb->num_clcb == 0) {
     p_srcb->connected = false;
     p_srcb->state = BTA_GATTC_SERV_IDLE;
-    p_srcb->mtu = 0;
 
-    // clear reallocating
-    p_srcb->gatt_database.Clear();
+    /* a link kept open by the connection pool keeps its MTU and database for
+     * the next application opening it */
+    if (!bta_gattc_pool_contains(p_srcb->server_bda)) {
+      p_srcb->mtu = 0;
+
+      // clear reallocating
+      p_srcb->gatt_database.Clear();
+    }
   }
 
   osi_free_and_reset((void**)&p_clcb->p_q_cmd);
@@ -337,17 +343,78 @@ bool bta_gattc_enqueue(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
 bool bta_gattc_check_notif_registry(tBTA_GATTC_RCB* p_clreg,
                                     tBTA_GATTC_SERV* p_srcb,
                                     tBTA_GATTC_NOTIFY* p_notify) {
-  uint8_t i;
+  auto it = bta_gattc_cb.notif_index.find(
+      std::make_pair(p_srcb->server_bda, p_notify->handle));
+  if (it == bta_gattc_cb.notif_index.end()) return false;
 
-  for (i = 0; i < BTA_GATTC_NOTIF_REG_MAX; i++) {
-    if (p_clreg->notif_reg[i].in_use &&
-        p_clreg->notif_reg[i].remote_bda == p_srcb->server_bda &&
-        p_clreg->notif_reg[i].handle == p_notify->handle) {
-      VLOG(1) << "Notification registered!";
-      return true;
-    }
+  if (std::find(it->second.begin(), it->second.end(), p_clreg->client_if) ==
+      it->second.end())
+    return false;
+
+  VLOG(1) << "Notification registered!";
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_notif_index_add
+ *
+ * Description      Index the registration of |client_if| for the notifications
+ *                  of |handle| on |bda|, once added to its notif_reg.
+ *
+ * Returns          None.
+ *
+ ******************************************************************************/
+void bta_gattc_notif_index_add(tGATT_IF client_if, const RawAddress& bda,
+                               uint16_t handle) {
+  std::vector<tGATT_IF>& clients =
+      bta_gattc_cb.notif_index[std::make_pair(bda, handle)];
+  if (std::find(clients.begin(), clients.end(), client_if) == clients.end())
+    clients.push_back(client_if);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_notif_index_remove
+ *
+ * Description      Remove the registration of |client_if| for the
+ *                  notifications of |handle| on |bda| from the index.
+ *
+ * Returns          None.
+ *
+ ******************************************************************************/
+void bta_gattc_notif_index_remove(tGATT_IF client_if, const RawAddress& bda,
+                                  uint16_t handle) {
+  auto it = bta_gattc_cb.notif_index.find(std::make_pair(bda, handle));
+  if (it == bta_gattc_cb.notif_index.end()) return;
+
+  std::vector<tGATT_IF>& clients = it->second;
+  clients.erase(std::remove(clients.begin(), clients.end(), client_if),
+                clients.end());
+  if (clients.empty()) bta_gattc_cb.notif_index.erase(it);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_gattc_notif_index_remove_client
+ *
+ * Description      Remove all the registrations of |client_if| from the index,
+ *                  when the client is deregistered.
+ *
+ * Returns          None.
+ *
+ ******************************************************************************/
+void bta_gattc_notif_index_remove_client(tGATT_IF client_if) {
+  for (auto it = bta_gattc_cb.notif_index.begin();
+       it != bta_gattc_cb.notif_index.end();) {
+    std::vector<tGATT_IF>& clients = it->second;
+    clients.erase(std::remove(clients.begin(), clients.end(), client_if),
+                  clients.end());
+    if (clients.empty())
+      it = bta_gattc_cb.notif_index.erase(it);
+    else
+      it++;
   }
-  return false;
 }
 /*******************************************************************************
  *
@@ -382,8 +449,10 @@ void bta_gattc_clear_notif_registration(tBTA_GATTC_SERV* p_srcb,
            * clear boundaries are always around service.
            */
           handle = p_clrcb->notif_reg[i].handle;
-          if (handle >= start_handle && handle <= end_handle)
+          if (handle >= start_handle && handle <= end_handle) {
+            bta_gattc_notif_index_remove(gatt_if, remote_bda, handle);
             memset(&p_clrcb->notif_reg[i], 0, sizeof(tBTA_GATTC_NOTIF_REG));
+          }
         }
       }
     }
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cache_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include <base/logging.h>
+
+namespace gatt {
+
+namespace {
+constexpr uint32_t CACHE_MAGIC = 0x43545447; /* "GTTC" */
+constexpr uint16_t CACHE_VERSION = 2;
+
+constexpr uint32_t ENTRY_FLAG_HASH = 0x01; /* |hash| is valid */
+
+struct FileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t attr_size; /* sizeof(StoredAttribute) of the writer */
+  uint32_t num_entries;
+  uint32_t reserved;
+};
+
+struct FileEntry {
+  uint8_t address[RawAddress::kLength];
+  uint16_t num_attr;
+  uint32_t offset; /* of the attributes, from the start of the file */
+  uint32_t discovery_ms;
+  uint32_t flags;
+  uint32_t reserved;
+  uint64_t last_used;
+  uint8_t hash[16];
+};
+
+static_assert(std::is_trivially_copyable<StoredAttribute>::value,
+              "StoredAttribute is read from the file as is");
+static_assert(sizeof(FileHeader) % alignof(FileEntry) == 0 &&
+                  sizeof(FileEntry) % alignof(StoredAttribute) == 0,
+              "attributes are aligned in the file");
+}  // namespace
+
+CacheStore::CacheStore(std::string path, size_t max_size)
+    : path_(std::move(path)), max_size_(max_size) {}
+
+CacheStore::~CacheStore() {
+  if (map_) munmap(map_, map_size_);
+}
+
+bool CacheStore::Open() {
+  CHECK(map_ == nullptr) << "cache already open";
+
+  int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno != ENOENT) {
+      LOG(ERROR) << __func__ << ": can't open GATT cache file " << path_
+                 << " for reading, error: " << strerror(errno);
+    }
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+    LOG(ERROR) << __func__ << ": invalid GATT cache file " << path_;
+    close(fd);
+    return false;
+  }
+
+  size_t size = st.st_size;
+  void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    LOG(ERROR) << __func__ << ": can't map GATT cache file " << path_
+               << ", error: " << strerror(errno);
+    return false;
+  }
+
+  const uint8_t* base = (const uint8_t*)map;
+  const FileHeader* header = (const FileHeader*)base;
+  uint64_t index_end = sizeof(FileHeader) +
+                       (uint64_t)header->num_entries * sizeof(FileEntry);
+  if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION ||
+      header->attr_size != sizeof(StoredAttribute) || index_end > size) {
+    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << path_;
+    munmap(map, size);
+    return false;
+  }
+
+  const FileEntry* file_entries = (const FileEntry*)(base + sizeof(FileHeader));
+  for (uint32_t i = 0; i < header->num_entries; i++) {
+    const FileEntry& file_entry = file_entries[i];
+    uint64_t attr_size =
+        (uint64_t)file_entry.num_attr * sizeof(StoredAttribute);
+    if (file_entry.offset < index_end ||
+        file_entry.offset % alignof(StoredAttribute) != 0 ||
+        file_entry.offset + attr_size > size) {
+      LOG(ERROR) << __func__ << ": corrupted GATT cache file: " << path_;
+      entries_.clear();
+      size_ = 0;
+      last_used_ = 0;
+      munmap(map, size);
+      return false;
+    }
+
+    RawAddress bda(file_entry.address);
+    Entry& entry = entries_[bda];
+    entry.attr = (const StoredAttribute*)(base + file_entry.offset);
+    entry.num_attr = file_entry.num_attr;
+    entry.last_used = file_entry.last_used;
+    entry.has_hash = file_entry.flags & ENTRY_FLAG_HASH;
+    memcpy(entry.hash.data(), file_entry.hash, entry.hash.size());
+    entry.discovery_ms = file_entry.discovery_ms;
+    size_ += attr_size;
+    last_used_ = std::max(last_used_, file_entry.last_used);
+  }
+
+  map_ = map;
+  map_size_ = size;
+  Evict();
+  return true;
+}
+
+bool CacheStore::Load(const RawAddress& bda, Database* database,
+                      const Hash* hash) {
+  auto it = entries_.find(bda);
+  if (it == entries_.end()) return false;
+  if (hash && (!it->second.has_hash || it->second.hash != *hash)) return false;
+
+  bool success = false;
+  *database = Database::Deserialize(it->second.attr, it->second.num_attr,
+                                    &success);
+  if (!success) {
+    LOG(ERROR) << __func__ << ": can't read GATT attributes of " << bda;
+    Remove(bda);
+    return false;
+  }
+
+  it->second.last_used = ++last_used_;
+  return true;
+}
+
+void CacheStore::Store(const RawAddress& bda, std::vector<StoredAttribute> attr,
+                       const Hash* hash, uint32_t discovery_ms) {
+  Remove(bda);
+  if (attr.size() > UINT16_MAX) {
+    LOG(ERROR) << __func__ << ": too many GATT attributes to cache for " << bda;
+    return;
+  }
+
+  Entry& entry = entries_[bda];
+  entry.stored = std::move(attr);
+  entry.attr = entry.stored.data();
+  entry.num_attr = entry.stored.size();
+  entry.last_used = ++last_used_;
+  entry.has_hash = hash != nullptr;
+  entry.hash = hash ? *hash : Hash{};
+  entry.discovery_ms = discovery_ms;
+  size_ += entry.num_attr * sizeof(StoredAttribute);
+  Evict();
+}
+
+uint32_t CacheStore::DiscoveryTime(const RawAddress& bda) const {
+  auto it = entries_.find(bda);
+  return it == entries_.end() ? 0 : it->second.discovery_ms;
+}
+
+bool CacheStore::Remove(const RawAddress& bda) {
+  auto it = entries_.find(bda);
+  if (it == entries_.end()) return false;
+
+  size_ -= it->second.num_attr * sizeof(StoredAttribute);
+  entries_.erase(it);
+  return true;
+}
+
+void CacheStore::Evict() {
+  while (size_ > max_size_) {
+    auto lru = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); it++) {
+      if (it->second.last_used < lru->second.last_used) lru = it;
+    }
+    VLOG(1) << __func__ << ": evict GATT cache of " << lru->first;
+    Remove(lru->first);
+  }
+}
+
+std::vector<uint8_t> CacheStore::Serialize() const {
+  size_t offset = sizeof(FileHeader) + entries_.size() * sizeof(FileEntry);
+  std::vector<uint8_t> content(offset + size_);
+
+  FileHeader header = {
+      .magic = CACHE_MAGIC,
+      .version = CACHE_VERSION,
+      .attr_size = sizeof(StoredAttribute),
+      .num_entries = (uint32_t)entries_.size(),
+  };
+  memcpy(content.data(), &header, sizeof(header));
+
+  uint8_t* p_entry = content.data() + sizeof(FileHeader);
+  for (const auto& it : entries_) {
+    const Entry& entry = it.second;
+    size_t attr_size = entry.num_attr * sizeof(StoredAttribute);
+
+    FileEntry file_entry = {
+        .num_attr = entry.num_attr,
+        .offset = (uint32_t)offset,
+        .discovery_ms = entry.discovery_ms,
+        .flags = entry.has_hash ? ENTRY_FLAG_HASH : 0,
+        .last_used = entry.last_used,
+    };
+    memcpy(file_entry.address, it.first.address, RawAddress::kLength);
+    memcpy(file_entry.hash, entry.hash.data(), entry.hash.size());
+    memcpy(p_entry, &file_entry, sizeof(file_entry));
+    p_entry += sizeof(file_entry);
+
+    memcpy(content.data() + offset, entry.attr, attr_size);
+    offset += attr_size;
+  }
+
+  return content;
+}
+
+bool CacheStore::WriteFile(const std::string& path,
+                           const std::vector<uint8_t>& content) {
+  std::string tmp_path = path + ".tmp";
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                S_IRUSR | S_IWUSR | S_IRGRP);
+  if (fd < 0) {
+    LOG(ERROR) << __func__ << ": can't open GATT cache file for writing: "
+               << tmp_path << ", error: " << strerror(errno);
+    return false;
+  }
+
+  const uint8_t* p = content.data();
+  size_t remaining = content.size();
+  while (remaining > 0) {
+    ssize_t written = write(fd, p, remaining);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) {
+      LOG(ERROR) << __func__ << ": can't write GATT cache file: " << tmp_path
+                 << ", error: " << strerror(errno);
+      close(fd);
+      unlink(tmp_path.c_str());
+      return false;
+    }
+    p += written;
+    remaining -= written;
+  }
+
+  bool synced = fsync(fd) == 0;
+  if (close(fd) != 0 || !synced ||
+      rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(ERROR) << __func__ << ": can't save GATT cache file: " << path
+               << ", error: " << strerror(errno);
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace gatt
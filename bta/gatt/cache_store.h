@@ -0,0 +1,109 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gatt/database.h"
+#include "types/raw_address.h"
+
+namespace gatt {
+
+/* GATT client cache of the databases of all known servers, kept in a single
+ * file: a header, an index of the servers, then the attributes of each server
+ * as an array of StoredAttribute, with the Database Hash of the server when
+ * it has one. The file is mapped in memory, so that a
+ * database is built straight from it, and is rewritten as a whole when the
+ * cache changes. The least recently used servers are evicted when the
+ * attributes do not fit in the maximal size of the cache.
+ *
+ * The store is not thread safe, only writing the file may be done on another
+ * thread, see Serialize() and WriteFile(). */
+class CacheStore {
+ public:
+  /* Value of the Database Hash characteristic of a server */
+  using Hash = std::array<uint8_t, 16>;
+
+  CacheStore(std::string path, size_t max_size);
+  ~CacheStore();
+
+  CacheStore(const CacheStore&) = delete;
+  CacheStore& operator=(const CacheStore&) = delete;
+
+  /* Maps the cache file and reads its index. Returns false if the file does
+   * not exist or is not a valid cache, in which case the cache starts empty. */
+  bool Open();
+
+  /* Builds the cached database of |bda| into |database|, and marks it as the
+   * most recently used. If |hash| is not null, the database must have been
+   * stored with the same hash. Returns false if |bda| is not cached. */
+  bool Load(const RawAddress& bda, Database* database,
+            const Hash* hash = nullptr);
+
+  /* Caches |attr| for |bda|, evicting the least recently used servers if the
+   * cache gets too large. |hash| is the Database Hash of the server, if it
+   * has one, and |discovery_ms| the time it took to discover the database. */
+  void Store(const RawAddress& bda, std::vector<StoredAttribute> attr,
+             const Hash* hash = nullptr, uint32_t discovery_ms = 0);
+
+  /* Returns the time it took to discover the cached database of |bda|, in
+   * milliseconds, or 0 if unknown. */
+  uint32_t DiscoveryTime(const RawAddress& bda) const;
+
+  /* Removes |bda| from the cache. Returns false if it was not cached. */
+  bool Remove(const RawAddress& bda);
+
+  /* Returns the content of the cache file for the current state of the
+   * cache. */
+  std::vector<uint8_t> Serialize() const;
+
+  /* Replaces the cache file at |path| with |content|. */
+  static bool WriteFile(const std::string& path,
+                        const std::vector<uint8_t>& content);
+
+  const std::string& Path() const { return path_; }
+
+  /* Number of bytes of attributes in the cache. */
+  size_t Size() const { return size_; }
+
+ private:
+  struct Entry {
+    /* attributes in the mapped file, or in |stored| once replaced */
+    const StoredAttribute* attr;
+    uint16_t num_attr;
+    uint64_t last_used;
+    bool has_hash;
+    Hash hash;
+    uint32_t discovery_ms;
+    std::vector<StoredAttribute> stored;
+  };
+
+  void Evict();
+
+  std::string path_;
+  size_t max_size_;
+  void* map_ = nullptr;
+  size_t map_size_ = 0;
+  std::unordered_map<RawAddress, Entry> entries_;
+  size_t size_ = 0;
+  uint64_t last_used_ = 0;
+};
+
+}  // namespace gatt
@@ -21,6 +21,7 @@
 #include "stack/include/gattdefs.h"
 
 #include <base/logging.h>
+#include <algorithm>
 #include <list>
 #include <memory>
 #include <sstream>
@@ -49,6 +50,80 @@ Service* FindService(std::list<Service>& services, uint16_t handle) {
   return nullptr;
 }
 
+void Database::BuildIndex() {
+  service_index.clear();
+  attribute_index.clear();
+  service_index.reserve(services.size());
+  size_t num_attr = 0;
+  for (const Service& service : services) {
+    service_index.push_back(&service);
+    for (const Characteristic& charac : service.characteristics) {
+      num_attr += 1 + charac.descriptors.size();
+    }
+  }
+  attribute_index.reserve(num_attr);
+  for (const Service& service : services) {
+    for (const Characteristic& charac : service.characteristics) {
+      attribute_index.push_back({charac.value_handle, &charac, nullptr});
+      for (const Descriptor& desc : charac.descriptors) {
+        attribute_index.push_back({desc.handle, &charac, &desc});
+      }
+    }
+  }
+
+  // Services and attributes are usually discovered in order already
+  std::stable_sort(service_index.begin(), service_index.end(),
+                   [](const Service* a, const Service* b) {
+                     return a->handle < b->handle;
+                   });
+  std::stable_sort(
+      attribute_index.begin(), attribute_index.end(),
+      [](const AttributeIndexEntry& a, const AttributeIndexEntry& b) {
+        return a.handle < b.handle;
+      });
+}
+
+const Service* Database::GetService(uint16_t handle) const {
+  // Last service starting at or before |handle|
+  auto it = std::upper_bound(service_index.begin(), service_index.end(),
+                             handle, [](uint16_t handle, const Service* s) {
+                               return handle < s->handle;
+                             });
+  if (it == service_index.begin()) return nullptr;
+  const Service* service = *std::prev(it);
+  return HandleInRange(*service, handle) ? service : nullptr;
+}
+
+const Database::AttributeIndexEntry* Database::FindAttribute(
+    uint16_t handle, bool is_descriptor) const {
+  auto it = std::lower_bound(attribute_index.begin(), attribute_index.end(),
+                             handle,
+                             [](const AttributeIndexEntry& a, uint16_t handle) {
+                               return a.handle < handle;
+                             });
+  // Malformed databases may reuse a handle, look through all its entries
+  for (; it != attribute_index.end() && it->handle == handle; it++) {
+    if ((it->descriptor != nullptr) == is_descriptor) return &*it;
+  }
+  return nullptr;
+}
+
+const Characteristic* Database::GetCharacteristic(uint16_t value_handle) const {
+  const AttributeIndexEntry* entry = FindAttribute(value_handle, false);
+  return entry ? entry->characteristic : nullptr;
+}
+
+const Descriptor* Database::GetDescriptor(uint16_t handle) const {
+  const AttributeIndexEntry* entry = FindAttribute(handle, true);
+  return entry ? entry->descriptor : nullptr;
+}
+
+const Characteristic* Database::GetOwningCharacteristic(
+    uint16_t handle) const {
+  const AttributeIndexEntry* entry = FindAttribute(handle, true);
+  return entry ? entry->characteristic : nullptr;
+}
+
 std::string Database::ToString() const {
   std::stringstream tmp;
 
@@ -84,6 +159,15 @@ std::vector<StoredAttribute> Database::Serialize() const {
 
   if (services.empty()) return std::vector<StoredAttribute>();
 
+  size_t num_attr = services.size();
+  for (const Service& service : services) {
+    num_attr += service.included_services.size();
+    for (const Characteristic& charac : service.characteristics) {
+      num_attr += 1 + charac.descriptors.size();
+    }
+  }
+  nv_attr.reserve(num_attr);
+
   for (const Service& service : services) {
     // TODO: add constructor to NV_ATTR, use emplace_back
     nv_attr.push_back({service.handle,
@@ -118,13 +202,14 @@ std::vector<StoredAttribute> Database::Serialize() const {
   return nv_attr;
 }
 
-Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
-                               bool* success) {
+Database Database::Deserialize(const StoredAttribute* nv_attr,
+                               size_t num_attr, bool* success) {
   // clear reallocating
   Database result;
-  auto it = nv_attr.cbegin();
+  const StoredAttribute* it = nv_attr;
+  const StoredAttribute* end = nv_attr + num_attr;
 
-  for (; it != nv_attr.cend(); ++it) {
+  for (; it != end; ++it) {
     const auto& attr = *it;
     if (attr.type != PRIMARY_SERVICE && attr.type != SECONDARY_SERVICE) break;
     result.services.emplace_back(Service{
@@ -136,7 +221,8 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
   }
 
   auto current_service_it = result.services.begin();
-  for (; it != nv_attr.cend(); it++) {
+  auto reserved_service_it = result.services.end();
+  for (; it != end; it++) {
     const auto& attr = *it;
 
     // go to the service this attribute belongs to; attributes are stored in
@@ -154,6 +240,20 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
       return result;
     }
 
+    if (reserved_service_it != current_service_it) {
+      // size the service containers once, instead of growing them
+      size_t num_included = 0, num_characteristics = 0;
+      for (const StoredAttribute* next = it;
+           next != end && HandleInRange(*current_service_it, next->handle);
+           next++) {
+        if (next->type == INCLUDE) num_included++;
+        if (next->type == CHARACTERISTIC) num_characteristics++;
+      }
+      current_service_it->included_services.reserve(num_included);
+      current_service_it->characteristics.reserve(num_characteristics);
+      reserved_service_it = current_service_it;
+    }
+
     if (attr.type == INCLUDE) {
       Service* included_service =
           FindService(result.services, attr.value.included_service.handle);
@@ -176,11 +276,28 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
           .properties = attr.value.characteristic.properties,
       });
 
+      size_t num_descriptors = 0;
+      for (const StoredAttribute* next = it + 1;
+           next != end && HandleInRange(*current_service_it, next->handle) &&
+           next->type != INCLUDE && next->type != CHARACTERISTIC;
+           next++) {
+        num_descriptors++;
+      }
+      current_service_it->characteristics.back().descriptors.reserve(
+          num_descriptors);
+
     } else {
+      if (current_service_it->characteristics.empty()) {
+        LOG(ERROR) << "Descriptor outside of characteristic, handle: "
+                   << loghex(attr.handle);
+        *success = false;
+        return result;
+      }
       current_service_it->characteristics.back().descriptors.emplace_back(
           Descriptor{.handle = attr.handle, .uuid = attr.type});
     }
   }
+  result.BuildIndex();
   *success = true;
   return result;
 }
@@ -97,27 +97,84 @@ class DatabaseBuilder;
 
 class Database {
  public:
+  Database() = default;
+  Database(Database&&) = default;
+  Database& operator=(Database&&) = default;
+
+  /* The handle index points into the services, rebuild it for the copy */
+  Database(const Database& other) : services(other.services) { BuildIndex(); }
+  Database& operator=(const Database& other) {
+    services = other.services;
+    BuildIndex();
+    return *this;
+  }
+
   /* Return true if there are no services in this database. */
   bool IsEmpty() const { return services.empty(); }
 
   /* Clear the GATT database. This method forces relocation to ensure no extra
    * space is used unnecesarly */
-  void Clear() { std::list<Service>().swap(services); }
+  void Clear() {
+    std::list<Service>().swap(services);
+    std::vector<const Service*>().swap(service_index);
+    std::vector<AttributeIndexEntry>().swap(attribute_index);
+  }
 
   /* Return list of services available in this database */
   const std::list<Service>& Services() const { return services; }
 
+  /* Return the service containing |handle|, or nullptr */
+  const Service* GetService(uint16_t handle) const;
+
+  /* Return the characteristic with value handle |value_handle|, or nullptr */
+  const Characteristic* GetCharacteristic(uint16_t value_handle) const;
+
+  /* Return the descriptor with handle |handle|, or nullptr */
+  const Descriptor* GetDescriptor(uint16_t handle) const;
+
+  /* Return the characteristic owning the descriptor with handle |handle|, or
+   * nullptr */
+  const Characteristic* GetOwningCharacteristic(uint16_t handle) const;
+
   std::string ToString() const;
 
   std::vector<gatt::StoredAttribute> Serialize() const;
 
   static Database Deserialize(const std::vector<gatt::StoredAttribute>& nv_attr,
-                              bool* success);
+                              bool* success) {
+    return Deserialize(nv_attr.data(), nv_attr.size(), success);
+  }
+
+  /* Same as above, for |num_attr| attributes stored at |nv_attr|, to build the
+   * database straight from a mapped cache file */
+  static Database Deserialize(const gatt::StoredAttribute* nv_attr,
+                              size_t num_attr, bool* success);
 
   friend class DatabaseBuilder;
 
  private:
+  /* Characteristic value or descriptor in the handle index */
+  struct AttributeIndexEntry {
+    uint16_t handle;
+    const Characteristic* characteristic;
+    /* nullptr for the characteristic value */
+    const Descriptor* descriptor;
+  };
+
+  /* Index the services, characteristic values and descriptors by handle. Must
+   * be called once the services are complete, as adding to them invalidates
+   * the index. */
+  void BuildIndex();
+
+  const AttributeIndexEntry* FindAttribute(uint16_t handle,
+                                           bool is_descriptor) const;
+
   std::list<Service> services;
+
+  /* Flat arrays sorted by handle, for binary searches on each read, write and
+   * notification instead of walking the services */
+  std::vector<const Service*> service_index;
+  std::vector<AttributeIndexEntry> attribute_index;
 };
 
 /* Find a service that should contain handle. Helper method for internal use
@@ -44,7 +44,9 @@ void DatabaseBuilder::AddService(uint16_t handle, uint16_t end_handle,
     // Find first service whose start handle is bigger than new service handle
     auto it = std::lower_bound(
         vec.begin(), vec.end(), handle,
-        [](Service s, uint16_t handle) { return s.end_handle < handle; });
+        [](const Service& s, uint16_t handle) {
+          return s.end_handle < handle;
+        });
 
     // Insert new service just before it
     vec.emplace(it, Service{
@@ -183,7 +185,9 @@ std::pair<uint16_t, uint16_t> DatabaseBuilder::NextDescriptorRangeToExplore() {
 bool DatabaseBuilder::InProgress() const { return !database.services.empty(); }
 
 Database DatabaseBuilder::Build() {
-  Database tmp = database;
+  // Hand the services over rather than copy them and all their attributes
+  database.BuildIndex();
+  Database tmp = std::move(database);
   database.Clear();
   return tmp;
 }
@@ -25,6 +25,7 @@
 #include "embdrv/g722/g722_enc_dec.h"
 #include "gap_api.h"
 #include "gatt_api.h"
+#include "osi/include/allocator.h"
 #include "osi/include/properties.h"
 
 #include <base/bind.h>
@@ -95,9 +96,19 @@ void encryption_callback(const RawAddress*, tGATT_TRANSPORT, void*,
                          tBTM_STATUS);
 void read_rssi_cb(void* p_void);
 
+// Audio packets in flight, for both sides: a few connection intervals worth
+constexpr size_t kAudioPacketPoolSize = 16;
+// Audio packets, sized for the codec and interval in use once audio starts
+slab_pool_t* audio_packet_pool = nullptr;
+
+inline size_t l2cap_buf_size(uint16_t len) {
+  return BT_HDR_SIZE + L2CAP_MIN_OFFSET +
+         len /* LE-only, no need for FCS here */;
+}
+
 inline BT_HDR* malloc_l2cap_buf(uint16_t len) {
-  BT_HDR* msg = (BT_HDR*)osi_malloc(BT_HDR_SIZE + L2CAP_MIN_OFFSET +
-                                    len /* LE-only, no need for FCS here */);
+  BT_HDR* msg =
+      (BT_HDR*)osi_malloc_from_pool(audio_packet_pool, l2cap_buf_size(len));
   msg->offset = L2CAP_MIN_OFFSET;
   msg->len = len;
   return msg;
@@ -222,6 +233,9 @@ inline void encoder_state_release() {
     g722_encode_release(encoder_state_right);
     encoder_state_right = nullptr;
   }
+  // Packets still queued in L2CAP go back to the heap once sent
+  osi_pool_free(audio_packet_pool);
+  audio_packet_pool = nullptr;
 }
 
 class HearingAidImpl : public HearingAid {
@@ -1163,9 +1177,12 @@ class HearingAidImpl : public HearingAid {
       return;
     }
 
-    std::vector<uint16_t> chan_left;
-    std::vector<uint16_t> chan_right;
+    // A single device gets the mono downmix, a binaural pair gets the
+    // interleaved stereo samples, encoded for both sides at once.
+    std::vector<uint16_t> chan_mono;
+    std::vector<uint16_t> chan_stereo;
     if (left == nullptr || right == nullptr) {
+      chan_mono.reserve(num_samples);
       for (int i = 0; i < num_samples; i++) {
         const uint8_t* sample = data.data() + i * 4;
 
@@ -1175,39 +1192,32 @@ class HearingAidImpl : public HearingAid {
         int16_t right = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
 
         uint16_t mono_data = (int16_t)(((uint32_t)left + (uint32_t)right) >> 1);
-        chan_left.push_back(mono_data);
-        chan_right.push_back(mono_data);
+        chan_mono.push_back(mono_data);
       }
     } else {
+      chan_stereo.reserve(num_samples * 2);
       for (int i = 0; i < num_samples; i++) {
         const uint8_t* sample = data.data() + i * 4;
 
         uint16_t left = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-        chan_left.push_back(left);
+        chan_stereo.push_back(left);
 
         sample += 2;
         uint16_t right = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-        chan_right.push_back(right);
+        chan_stereo.push_back(right);
       }
     }
 
     // TODO: monural, binarual check
 
-    // divide encoded data into packets, add header, send.
+    uint16_t packet_size =
+        CalcCompressedAudioPacketSize(codec_in_use, default_data_interval_ms);
+    if (audio_packet_pool == nullptr) {
+      audio_packet_pool =
+          osi_pool_new(l2cap_buf_size(packet_size + 1), kAudioPacketPoolSize);
+    }
 
-    // TODO: make those buffers static and global to prevent constant
-    // reallocations
-    // TODO: this should basically fit the encoded data, tune the size later
-    std::vector<uint8_t> encoded_data_left;
     if (left) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_left.resize(4000);
-      int encoded_size =
-          g722_encode(encoder_state_left, encoded_data_left.data(),
-                      (const int16_t*)chan_left.data(), chan_left.size());
-      encoded_data_left.resize(encoded_size);
-
       uint16_t cid = GAP_ConnGetL2CAPCid(left->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -1222,16 +1232,7 @@ class HearingAidImpl : public HearingAid {
       check_and_do_rssi_read(left);
     }
 
-    std::vector<uint8_t> encoded_data_right;
     if (right) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_right.resize(4000);
-      int encoded_size =
-          g722_encode(encoder_state_right, encoded_data_right.data(),
-                      (const int16_t*)chan_right.data(), chan_right.size());
-      encoded_data_right.resize(encoded_size);
-
       uint16_t cid = GAP_ConnGetL2CAPCid(right->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -1246,20 +1247,24 @@ class HearingAidImpl : public HearingAid {
       check_and_do_rssi_read(right);
     }
 
-    size_t encoded_data_size =
-        std::max(encoded_data_left.size(), encoded_data_right.size());
-
-    uint16_t packet_size =
-        CalcCompressedAudioPacketSize(codec_in_use, default_data_interval_ms);
-
-    for (size_t i = 0; i < encoded_data_size; i += packet_size) {
-      if (left) {
+    // Divide the samples into packets, each encoded straight into its L2CAP
+    // buffer. G.722 at 64 kbit/s packs two samples in each octet.
+    size_t packet_samples = packet_size * 2;
+    for (size_t i = 0; i < (size_t)num_samples; i += packet_samples) {
+      size_t samples = std::min(packet_samples, num_samples - i);
+      if (left && right) {
         left->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_left.data() + i, packet_size, left);
-      }
-      if (right) {
         right->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_right.data() + i, packet_size, right);
+        SendAudioStereo(chan_stereo.data() + i * 2, samples, packet_size, left,
+                        right);
+      } else if (left) {
+        left->audio_stats.packet_send_count++;
+        SendAudio(encoder_state_left, chan_mono.data() + i, samples,
+                  packet_size, left);
+      } else {
+        right->audio_stats.packet_send_count++;
+        SendAudio(encoder_state_right, chan_mono.data() + i, samples,
+                  packet_size, right);
       }
       seq_counter++;
     }
@@ -1267,22 +1272,60 @@ class HearingAidImpl : public HearingAid {
     if (right) right->audio_stats.frame_send_count++;
   }
 
-  void SendAudio(uint8_t* encoded_data, uint16_t packet_size,
+  // Encodes |num_samples| samples of |samples| into a |packet_size| audio
+  // packet and sends it to |hearingAid|. The encoder runs even when playback
+  // is stalled, to keep its state in step with the audio.
+  void SendAudio(g722_encode_state_t* encoder, const uint16_t* samples,
+                 size_t num_samples, uint16_t packet_size,
                  HearingDevice* hearingAid) {
+    BT_HDR* audio_packet = NewAudioPacket(packet_size);
+    uint8_t* p = get_l2cap_sdu_start_ptr(audio_packet) + 1;
+    int encoded_size = g722_encode(encoder, p, (const int16_t*)samples,
+                                   (int)num_samples);
+    SendAudioPacket(audio_packet, encoded_size, packet_size, hearingAid);
+  }
+
+  // Encodes |num_frames| frames of the interleaved |samples| into one audio
+  // packet for each side of a binaural pair, and sends them.
+  void SendAudioStereo(const uint16_t* samples, size_t num_frames,
+                       uint16_t packet_size, HearingDevice* left,
+                       HearingDevice* right) {
+    BT_HDR* left_packet = NewAudioPacket(packet_size);
+    BT_HDR* right_packet = NewAudioPacket(packet_size);
+    int encoded_size = g722_encode_stereo(
+        encoder_state_left, encoder_state_right,
+        get_l2cap_sdu_start_ptr(left_packet) + 1,
+        get_l2cap_sdu_start_ptr(right_packet) + 1, (const int16_t*)samples,
+        (int)num_frames);
+    SendAudioPacket(left_packet, encoded_size, packet_size, left);
+    SendAudioPacket(right_packet, encoded_size, packet_size, right);
+  }
+
+  // Returns an audio packet of |packet_size| octets, after the sequence number
+  BT_HDR* NewAudioPacket(uint16_t packet_size) {
+    BT_HDR* audio_packet = malloc_l2cap_buf(packet_size + 1);
+    *get_l2cap_sdu_start_ptr(audio_packet) = seq_counter;
+    return audio_packet;
+  }
+
+  // Pads the |encoded_size| octets of |audio_packet| to |packet_size| and sends
+  // it to |hearingAid|.
+  void SendAudioPacket(BT_HDR* audio_packet, int encoded_size,
+                       uint16_t packet_size, HearingDevice* hearingAid) {
+    uint8_t* p = get_l2cap_sdu_start_ptr(audio_packet) + 1;
+    if (encoded_size < packet_size) {
+      memset(p + encoded_size, 0, packet_size - encoded_size);
+    }
+
     if (!hearingAid->playback_started || !hearingAid->command_acked) {
       VLOG(2) << __func__
               << ": Playback stalled, device=" << hearingAid->address
               << ", cmd send=" << hearingAid->playback_started
               << ", cmd acked=" << hearingAid->command_acked;
+      osi_free(audio_packet);
       return;
     }
 
-    BT_HDR* audio_packet = malloc_l2cap_buf(packet_size + 1);
-    uint8_t* p = get_l2cap_sdu_start_ptr(audio_packet);
-    *p = seq_counter;
-    p++;
-    memcpy(p, encoded_data, packet_size);
-
     DVLOG(2) << hearingAid->address << " : " << base::HexEncode(p, packet_size);
 
     uint16_t result = GAP_ConnWriteData(hearingAid->gap_handle, audio_packet);
@@ -1305,6 +1348,10 @@ class HearingAidImpl : public HearingAid {
         uint16_t tx_mtu = GAP_ConnGetRemMtuSize(gap_handle);
 
         LOG(INFO) << "GAP_EVT_CONN_OPENED " << address << ", tx_mtu=" << tx_mtu;
+
+        // Keep the audio ahead of the other traffic to the controller
+        L2CA_SetChnlAclPriority(GAP_ConnGetL2CAPCid(gap_handle),
+                                L2CAP_PRIORITY_HIGH);
         OnGapConnection(address);
         break;
       }
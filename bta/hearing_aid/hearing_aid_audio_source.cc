@@ -25,6 +25,7 @@
 
 #include <base/files/file_util.h>
 #include <include/hardware/bt_av.h>
+#include <vector>
 
 #include "common/repeating_timer.h"
 #include "common/time_util.h"
@@ -40,6 +41,8 @@ int num_channels = 2;
 bluetooth::common::RepeatingTimer audio_timer;
 HearingAidAudioReceiver* localAudioReceiver = nullptr;
 std::unique_ptr<tUIPC_STATE> uipc_hearing_aid = nullptr;
+// Audio read on each tick, it keeps its capacity from one tick to the next
+std::vector<uint8_t> audio_data;
 
 struct AudioHalStats {
   size_t media_read_total_underflow_bytes;
@@ -65,14 +68,18 @@ void send_audio_data() {
       (num_channels * sample_rate * data_interval_ms * (bit_rate / 8)) / 1000;
 
   uint16_t event;
-  uint8_t p_buf[bytes_per_tick];
+  audio_data.resize(bytes_per_tick);
 
   uint32_t bytes_read;
   if (bluetooth::audio::hearing_aid::is_hal_2_0_enabled()) {
-    bytes_read = bluetooth::audio::hearing_aid::read(p_buf, bytes_per_tick);
+    // The tick takes the audio in the FMQ, the next tick takes the rest: it
+    // never waits on the main thread. The read is a whole number of sample
+    // pairs, as G.722 encodes the samples two by two.
+    bytes_read = bluetooth::audio::hearing_aid::read_available(
+        audio_data.data(), bytes_per_tick, 2 * num_channels * (bit_rate / 8));
   } else {
     bytes_read = UIPC_Read(*uipc_hearing_aid, UIPC_CH_ID_AV_AUDIO, &event,
-                           p_buf, bytes_per_tick);
+                           audio_data.data(), bytes_per_tick);
   }
 
   VLOG(2) << "bytes_read: " << bytes_read;
@@ -83,10 +90,10 @@ void send_audio_data() {
         bluetooth::common::time_get_os_boottime_us();
   }
 
-  std::vector<uint8_t> data(p_buf, p_buf + bytes_read);
+  audio_data.resize(bytes_read);
 
   if (localAudioReceiver != nullptr) {
-    localAudioReceiver->OnAudioDataReady(data);
+    localAudioReceiver->OnAudioDataReady(audio_data);
   }
 }
 
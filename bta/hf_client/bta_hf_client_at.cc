@@ -22,7 +22,9 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <string>
 
+#include "at_command_trie.h"
 #include "bta_hf_client_api.h"
 #include "bta_hf_client_int.h"
 #include "osi/include/log.h"
@@ -1486,25 +1488,57 @@ static char* bta_hf_client_process_unknown(tBTA_HF_CLIENT_CB* client_cb,
  */
 typedef char* (*tBTA_HF_CLIENT_PARSER_CALLBACK)(tBTA_HF_CLIENT_CB*, char*);
 
-static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb[] = {
-    bta_hf_client_parse_ok,          bta_hf_client_parse_error,
-    bta_hf_client_parse_ring,        bta_hf_client_parse_brsf,
-    bta_hf_client_parse_cind,        bta_hf_client_parse_ciev,
-    bta_hf_client_parse_chld,        bta_hf_client_parse_bcs,
-    bta_hf_client_parse_bsir,        bta_hf_client_parse_cmeerror,
-    bta_hf_client_parse_vgm,         bta_hf_client_parse_vgme,
-    bta_hf_client_parse_vgs,         bta_hf_client_parse_vgse,
-    bta_hf_client_parse_bvra,        bta_hf_client_parse_clip,
-    bta_hf_client_parse_ccwa,        bta_hf_client_parse_cops,
-    bta_hf_client_parse_binp,        bta_hf_client_parse_clcc,
-    bta_hf_client_parse_cnum,        bta_hf_client_parse_btrh,
-    bta_hf_client_parse_busy,        bta_hf_client_parse_delayed,
-    bta_hf_client_parse_no_carrier,  bta_hf_client_parse_no_answer,
-    bta_hf_client_parse_blacklisted, bta_hf_client_process_unknown};
-
-/* calculate supported event list length */
-static const uint16_t bta_hf_client_parser_cb_count =
-    sizeof(bta_hf_client_parser_cb) / sizeof(bta_hf_client_parser_cb[0]);
+/* AT event parser table element */
+typedef struct {
+  const char* p_event; /* event string checked by the parser */
+  tBTA_HF_CLIENT_PARSER_CALLBACK p_parser;
+} tBTA_HF_CLIENT_PARSER;
+
+/* Events without a parser are reported by bta_hf_client_process_unknown() */
+static const tBTA_HF_CLIENT_PARSER bta_hf_client_parser[] = {
+    {"OK", bta_hf_client_parse_ok},
+    {"ERROR", bta_hf_client_parse_error},
+    {"RING", bta_hf_client_parse_ring},
+    {"+BRSF:", bta_hf_client_parse_brsf},
+    {"+CIND:", bta_hf_client_parse_cind},
+    {"+CIEV:", bta_hf_client_parse_ciev},
+    {"+CHLD:", bta_hf_client_parse_chld},
+    {"+BCS:", bta_hf_client_parse_bcs},
+    {"+BSIR:", bta_hf_client_parse_bsir},
+    {"+CME ERROR:", bta_hf_client_parse_cmeerror},
+    {"+VGM:", bta_hf_client_parse_vgm},
+    {"+VGM=", bta_hf_client_parse_vgme},
+    {"+VGS:", bta_hf_client_parse_vgs},
+    {"+VGS=", bta_hf_client_parse_vgse},
+    {"+BVRA:", bta_hf_client_parse_bvra},
+    {"+CLIP:", bta_hf_client_parse_clip},
+    {"+CCWA:", bta_hf_client_parse_ccwa},
+    {"+COPS:", bta_hf_client_parse_cops},
+    {"+BINP:", bta_hf_client_parse_binp},
+    {"+CLCC:", bta_hf_client_parse_clcc},
+    {"+CNUM:", bta_hf_client_parse_cnum},
+    {"+BTRH:", bta_hf_client_parse_btrh},
+    {"BUSY", bta_hf_client_parse_busy},
+    {"DELAYED", bta_hf_client_parse_delayed},
+    {"NO CARRIER", bta_hf_client_parse_no_carrier},
+    {"NO ANSWER", bta_hf_client_parse_no_answer},
+    {"BLACKLISTED", bta_hf_client_parse_blacklisted}};
+
+/* the trie of the <cr><lf> prefixed events of bta_hf_client_parser */
+static const AtCommandTrie& bta_hf_client_parser_trie() {
+  static const AtCommandTrie trie = [] {
+    AtCommandTrie events(false);
+    for (size_t i = 0;
+         i < sizeof(bta_hf_client_parser) / sizeof(bta_hf_client_parser[0]);
+         i++) {
+      std::string event("\r\n");
+      event += bta_hf_client_parser[i].p_event;
+      events.Add(event.c_str(), i);
+    }
+    return events;
+  }();
+  return trie;
+}
 
 #ifdef BTA_HF_CLIENT_AT_DUMP
 static void bta_hf_client_dump_at(tBTA_HF_CLIENT_CB* client_cb) {
@@ -1544,23 +1578,17 @@ static void bta_hf_client_at_parse_start(tBTA_HF_CLIENT_CB* client_cb) {
 #endif
 
   while (*buf != '\0') {
-    int i;
-    char* tmp = NULL;
-
-    for (i = 0; i < bta_hf_client_parser_cb_count; i++) {
-      tmp = bta_hf_client_parser_cb[i](client_cb, buf);
-      if (tmp == NULL) {
-        APPL_TRACE_ERROR("HFPCient: AT event/reply parsing failed, skipping");
-        tmp = bta_hf_client_skip_unknown(client_cb, buf);
-        break;
-      }
+    char* tmp = buf;
 
-      /* matched or unknown skipped, if unknown failed tmp is NULL so
-         this is also handled */
-      if (tmp != buf) {
-        buf = tmp;
-        break;
-      }
+    size_t idx = bta_hf_client_parser_trie().Match(buf);
+    if (idx != AtCommandTrie::kNoMatch) {
+      tmp = bta_hf_client_parser[idx].p_parser(client_cb, buf);
+    }
+    if (tmp == buf) tmp = bta_hf_client_process_unknown(client_cb, buf);
+
+    if (tmp == NULL) {
+      APPL_TRACE_ERROR("HFPCient: AT event/reply parsing failed, skipping");
+      tmp = bta_hf_client_skip_unknown(client_cb, buf);
     }
 
     /* could not skip unknown (received garbage?)... disconnect */
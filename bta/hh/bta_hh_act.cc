@@ -33,6 +33,7 @@
 #include "bta_hh_int.h"
 #include "bta_sys.h"
 #include "btm_api.h"
+#include "common/time_util.h"
 #include "l2c_api.h"
 #include "osi/include/osi.h"
 #include "utl.h"
@@ -47,6 +48,10 @@
 static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
                          uint8_t event, uint32_t data, BT_HDR* pdata);
 static tBTA_HH_STATUS bta_hh_get_trans_status(uint32_t result);
+static void bta_hh_deliver_rpt(tBTA_HH_DEV_CB* p_cb, uint8_t dev_handle,
+                               BT_HDR* pdata, uint64_t rx_time_us);
+static bool bta_hh_low_latency_data(uint8_t dev_handle, BT_HDR* pdata,
+                                    uint64_t rx_time_us);
 
 #if (BTA_HH_DEBUG == TRUE)
 static const char* bta_hh_get_w4_event(uint16_t event);
@@ -536,6 +541,7 @@ void bta_hh_open_cmpl_act(tBTA_HH_DEV_CB* p_cb, tBTA_HH_DATA* p_data) {
   /* initialize device driver */
   bta_hh_co_open(p_cb->hid_handle, p_cb->sub_class, p_cb->attr_mask,
                  p_cb->app_id);
+  bta_hh_update_low_latency(p_cb);
 
 #if (BTA_HH_LE_INCLUDED == TRUE)
   conn.status = p_cb->status;
@@ -621,14 +627,53 @@ void bta_hh_open_act(tBTA_HH_DEV_CB* p_cb, tBTA_HH_DATA* p_data) {
  *
  ******************************************************************************/
 void bta_hh_data_act(tBTA_HH_DEV_CB* p_cb, tBTA_HH_DATA* p_data) {
-  BT_HDR* pdata = p_data->hid_cback.p_data;
+  bta_hh_deliver_rpt(p_cb, (uint8_t)p_data->hid_cback.hdr.layer_specific,
+                     p_data->hid_cback.p_data, p_data->hid_cback.rx_time_us);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_deliver_rpt
+ *
+ * Description      Write an input report to the device driver and free it.
+ *
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_hh_deliver_rpt(tBTA_HH_DEV_CB* p_cb, uint8_t dev_handle,
+                               BT_HDR* pdata, uint64_t rx_time_us) {
   uint8_t* p_rpt = (uint8_t*)(pdata + 1) + pdata->offset;
 
-  bta_hh_co_data((uint8_t)p_data->hid_cback.hdr.layer_specific, p_rpt,
-                 pdata->len, p_cb->mode, p_cb->sub_class,
+  bta_hh_co_data(dev_handle, p_rpt, pdata->len, p_cb->mode, p_cb->sub_class,
                  p_cb->dscp_info.ctry_code, p_cb->addr, p_cb->app_id);
+  bta_hh_record_rpt_latency(p_cb, rx_time_us);
 
-  osi_free_and_reset((void**)&pdata);
+  osi_free(pdata);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_low_latency_data
+ *
+ * Description      Write an interrupt channel report straight to the device
+ *                  driver if its device is connected in low latency mode.
+ *                  HID callbacks run in the same thread as BTA, so this only
+ *                  saves the report a trip through the BTA event queue.
+ *
+ * Returns          true if the report was handled.
+ *
+ ******************************************************************************/
+static bool bta_hh_low_latency_data(uint8_t dev_handle, BT_HDR* pdata,
+                                    uint64_t rx_time_us) {
+  uint8_t index = bta_hh_dev_handle_to_cb_idx(dev_handle);
+  if (index == BTA_HH_IDX_INVALID) return false;
+
+  tBTA_HH_DEV_CB* p_cb = &bta_hh_cb.kdev[index];
+  if (!p_cb->low_latency || p_cb->state != BTA_HH_CONN_ST) return false;
+
+  bta_hh_deliver_rpt(p_cb, dev_handle, pdata, rx_time_us);
+  return true;
 }
 
 /*******************************************************************************
@@ -1125,6 +1170,7 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
                          uint8_t event, uint32_t data, BT_HDR* pdata) {
   uint16_t sm_event = BTA_HH_INVALID_EVT;
   uint8_t xx = 0;
+  uint64_t rx_time_us = bluetooth::common::time_get_os_boottime_us();
 
 #if (BTA_HH_DEBUG == TRUE)
   APPL_TRACE_DEBUG("%s::HID_event [%s]", __func__,
@@ -1139,6 +1185,7 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
       sm_event = BTA_HH_INT_CLOSE_EVT;
       break;
     case HID_HDEV_EVT_INTR_DATA:
+      if (bta_hh_low_latency_data(dev_handle, pdata, rx_time_us)) return;
       sm_event = BTA_HH_INT_DATA_EVT;
       break;
     case HID_HDEV_EVT_HANDSHAKE:
@@ -1172,6 +1219,7 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
     p_buf->data = data;
     p_buf->addr = addr;
     p_buf->p_data = pdata;
+    p_buf->rx_time_us = rx_time_us;
 
     bta_sys_sendmsg(p_buf);
   }
@@ -126,6 +126,7 @@ typedef struct {
   RawAddress addr;
   uint32_t data;
   BT_HDR* p_data;
+  uint64_t rx_time_us; /* time the data was received from L2CAP */
 } tBTA_HH_CBACK_DATA;
 
 typedef struct {
@@ -214,6 +215,21 @@ typedef struct {
 #define BTA_HH_IS_LE_DEV_HDL_VALID(x) (((x) >> 4) <= BTA_HH_LE_MAX_KNOWN)
 #endif
 
+/* number of buckets of the input report latency histogram: bucket i counts
+ * the reports written to the driver less than 2^(i + 6) us after they were
+ * received, the last one all the others */
+#define BTA_HH_LATENCY_BUCKETS 12
+/* upper bound of the first bucket is 64 us, each next one doubles it */
+#define BTA_HH_LATENCY_MIN_US_SHIFT 6
+
+/* input report latency histogram */
+typedef struct {
+  uint32_t count[BTA_HH_LATENCY_BUCKETS];
+  uint32_t total;
+  uint64_t total_us;
+  uint64_t max_us;
+} tBTA_HH_LATENCY_HIST;
+
 /* device control block */
 typedef struct {
   tBTA_HH_DEV_DSCP_INFO dscp_info; /* report descriptor and DI information */
@@ -235,6 +251,8 @@ typedef struct {
   bool opened; /* true if device successfully opened HID connection */
   tBTA_HH_PROTO_MODE mode; /* protocol mode */
   tBTA_HH_STATE state;     /* CB state */
+  bool low_latency; /* input reports skip the BTA event queue */
+  tBTA_HH_LATENCY_HIST rpt_latency; /* input report latency histogram */
 
 #if (BTA_HH_LE_INCLUDED == TRUE)
 #define BTA_HH_LE_DISC_NONE 0x00
@@ -342,6 +360,9 @@ extern void bta_hh_update_di_info(tBTA_HH_DEV_CB* p_cb, uint16_t vendor_id,
 extern void bta_hh_cleanup_disable(tBTA_HH_STATUS status);
 
 extern uint8_t bta_hh_dev_handle_to_cb_idx(uint8_t dev_handle);
+extern void bta_hh_update_low_latency(tBTA_HH_DEV_CB* p_cb);
+extern void bta_hh_record_rpt_latency(tBTA_HH_DEV_CB* p_cb,
+                                      uint64_t rx_time_us);
 
 /* action functions used outside state machine */
 extern void bta_hh_api_enable(tBTA_HH_DATA* p_data);
@@ -35,6 +35,7 @@
 #include "btm_api.h"
 #include "btm_ble_api.h"
 #include "btm_int.h"
+#include "common/time_util.h"
 #include "device/include/interop.h"
 #include "osi/include/log.h"
 #include "srvc_api.h"
@@ -1539,6 +1540,25 @@ void bta_hh_le_srvc_search_cmpl(tBTA_GATTC_SEARCH_CMPL* p_data) {
   bta_hh_le_gatt_disc_cmpl(p_dev_cb, p_dev_cb->status);
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_find_rpt_by_handle
+ *
+ * Description      find the report entry of a characteristic value handle
+ *
+ * Returns          pointer to the report entry, NULL if not found
+ *
+ ******************************************************************************/
+static tBTA_HH_LE_RPT* bta_hh_le_find_rpt_by_handle(tBTA_HH_DEV_CB* p_cb,
+                                                    uint16_t handle) {
+  tBTA_HH_LE_RPT* p_rpt = &p_cb->hid_srvc.report[0];
+
+  for (uint8_t i = 0; i < BTA_HH_LE_RPT_MAX; i++, p_rpt++) {
+    if (p_rpt->in_use && p_rpt->char_inst_id == handle) return p_rpt;
+  }
+  return NULL;
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_le_input_rpt_notify
@@ -1549,10 +1569,14 @@ void bta_hh_le_srvc_search_cmpl(tBTA_GATTC_SEARCH_CMPL* p_data) {
  *
  ******************************************************************************/
 void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
+  uint64_t rx_time_us = bluetooth::common::time_get_os_boottime_us();
   tBTA_HH_DEV_CB* p_dev_cb = bta_hh_le_find_dev_cb_by_conn_id(p_data->conn_id);
   uint8_t app_id;
   uint8_t* p_buf;
+  uint8_t rpt_buf[GATT_MAX_ATTR_LEN + 1];
+  uint16_t len = p_data->len;
   tBTA_HH_LE_RPT* p_rpt;
+  uint16_t rpt_uuid;
 
   if (p_dev_cb == NULL) {
     APPL_TRACE_ERROR(
@@ -1561,54 +1585,65 @@ void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
     return;
   }
 
-  const gatt::Characteristic* p_char =
-      BTA_GATTC_GetCharacteristic(p_dev_cb->conn_id, p_data->handle);
-  if (p_char == NULL) {
-    APPL_TRACE_ERROR(
-        "%s: notification received for Unknown Characteristic, conn_id: "
-        "0x%04x, handle: 0x%04x",
-        __func__, p_dev_cb->conn_id, p_data->handle);
-    return;
-  }
-
-  app_id = p_dev_cb->app_id;
-
-  const gatt::Service* p_svc =
-      BTA_GATTC_GetOwningService(p_dev_cb->conn_id, p_char->value_handle);
+  if (p_dev_cb->low_latency) {
+    /* the value handle identifies the report, skip the GATT database */
+    p_rpt = bta_hh_le_find_rpt_by_handle(p_dev_cb, p_data->handle);
+    if (p_rpt == NULL) {
+      APPL_TRACE_ERROR(
+          "%s: notification received for Unknown Report, handle: 0x%04x",
+          __func__, p_data->handle);
+      return;
+    }
+    rpt_uuid = p_rpt->uuid;
+  } else {
+    const gatt::Characteristic* p_char =
+        BTA_GATTC_GetCharacteristic(p_dev_cb->conn_id, p_data->handle);
+    if (p_char == NULL) {
+      APPL_TRACE_ERROR(
+          "%s: notification received for Unknown Characteristic, conn_id: "
+          "0x%04x, handle: 0x%04x",
+          __func__, p_dev_cb->conn_id, p_data->handle);
+      return;
+    }
 
-  p_rpt = bta_hh_le_find_report_entry(
-      p_dev_cb, p_svc->handle, p_char->uuid.As16Bit(), p_char->value_handle);
-  if (p_rpt == NULL) {
-    APPL_TRACE_ERROR(
-        "%s: notification received for Unknown Report, uuid: %s, handle: "
-        "0x%04x",
-        __func__, p_char->uuid.ToString().c_str(), p_char->value_handle);
-    return;
+    const gatt::Service* p_svc =
+        BTA_GATTC_GetOwningService(p_dev_cb->conn_id, p_char->value_handle);
+
+    p_rpt = bta_hh_le_find_report_entry(
+        p_dev_cb, p_svc->handle, p_char->uuid.As16Bit(), p_char->value_handle);
+    if (p_rpt == NULL) {
+      APPL_TRACE_ERROR(
+          "%s: notification received for Unknown Report, uuid: %s, handle: "
+          "0x%04x",
+          __func__, p_char->uuid.ToString().c_str(), p_char->value_handle);
+      return;
+    }
+    rpt_uuid = p_char->uuid.As16Bit();
   }
 
-  if (p_char->uuid == Uuid::From16Bit(GATT_UUID_HID_BT_MOUSE_INPUT))
+  app_id = p_dev_cb->app_id;
+  if (rpt_uuid == GATT_UUID_HID_BT_MOUSE_INPUT)
     app_id = BTA_HH_APP_ID_MI;
-  else if (p_char->uuid == Uuid::From16Bit(GATT_UUID_HID_BT_KB_INPUT))
+  else if (rpt_uuid == GATT_UUID_HID_BT_KB_INPUT)
     app_id = BTA_HH_APP_ID_KB;
 
   APPL_TRACE_DEBUG("Notification received on report ID: %d", p_rpt->rpt_id);
 
   /* need to append report ID to the head of data */
   if (p_rpt->rpt_id != 0) {
-    p_buf = (uint8_t*)osi_malloc(p_data->len + 1);
+    p_buf = rpt_buf;
 
     p_buf[0] = p_rpt->rpt_id;
-    memcpy(&p_buf[1], p_data->value, p_data->len);
-    ++p_data->len;
+    memcpy(&p_buf[1], p_data->value, len);
+    ++len;
   } else {
     p_buf = p_data->value;
   }
 
-  bta_hh_co_data((uint8_t)p_dev_cb->hid_handle, p_buf, p_data->len,
-                 p_dev_cb->mode, 0, /* no sub class*/
+  bta_hh_co_data((uint8_t)p_dev_cb->hid_handle, p_buf, len, p_dev_cb->mode,
+                 0, /* no sub class*/
                  p_dev_cb->dscp_info.ctry_code, p_dev_cb->addr, app_id);
-
-  if (p_buf != p_data->value) osi_free(p_buf);
+  bta_hh_record_rpt_latency(p_dev_cb, rx_time_us);
 }
 
 /*******************************************************************************
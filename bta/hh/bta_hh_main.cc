@@ -26,11 +26,13 @@
 
 #if (BTA_HH_INCLUDED == TRUE)
 
+#include <stdio.h>
 #include <string.h>
 
 #include "bt_common.h"
 #include "bta_hh_api.h"
 #include "bta_hh_int.h"
+#include "common/state_table.h"
 
 /*****************************************************************************
  * Constants and types
@@ -68,7 +70,7 @@ enum {
 typedef void (*tBTA_HH_ACTION)(tBTA_HH_DEV_CB* p_cb, tBTA_HH_DATA* p_data);
 
 /* action functions */
-const tBTA_HH_ACTION bta_hh_action[] = {
+constexpr tBTA_HH_ACTION bta_hh_action[] = {
     bta_hh_api_disc_act, bta_hh_open_act, bta_hh_close_act, bta_hh_data_act,
     bta_hh_ctrl_dat_act, bta_hh_handsk_act, bta_hh_start_sdp, bta_hh_sdp_cmpl,
     bta_hh_write_dev_act, bta_hh_get_dscp_act, bta_hh_maint_dev_act,
@@ -86,7 +88,7 @@ const tBTA_HH_ACTION bta_hh_action[] = {
 #define BTA_HH_NUM_COLS 2   /* number of columns */
 
 /* state table for idle state */
-const uint8_t bta_hh_st_idle[][BTA_HH_NUM_COLS] = {
+constexpr uint8_t bta_hh_st_idle[][BTA_HH_NUM_COLS] = {
     /* Event                          Action                    Next state */
     /* BTA_HH_API_OPEN_EVT      */ {BTA_HH_START_SDP, BTA_HH_W4_CONN_ST},
     /* BTA_HH_API_CLOSE_EVT     */ {BTA_HH_IGNORE, BTA_HH_IDLE_ST},
@@ -115,7 +117,7 @@ const uint8_t bta_hh_st_idle[][BTA_HH_NUM_COLS] = {
 
 };
 
-const uint8_t bta_hh_st_w4_conn[][BTA_HH_NUM_COLS] = {
+constexpr uint8_t bta_hh_st_w4_conn[][BTA_HH_NUM_COLS] = {
     /* Event                          Action                 Next state */
     /* BTA_HH_API_OPEN_EVT      */ {BTA_HH_IGNORE, BTA_HH_W4_CONN_ST},
     /* BTA_HH_API_CLOSE_EVT     */ {BTA_HH_IGNORE, BTA_HH_IDLE_ST},
@@ -143,7 +145,7 @@ const uint8_t bta_hh_st_w4_conn[][BTA_HH_NUM_COLS] = {
 #endif
 };
 
-const uint8_t bta_hh_st_connected[][BTA_HH_NUM_COLS] = {
+constexpr uint8_t bta_hh_st_connected[][BTA_HH_NUM_COLS] = {
     /* Event                          Action                 Next state */
     /* BTA_HH_API_OPEN_EVT      */ {BTA_HH_IGNORE, BTA_HH_CONN_ST},
     /* BTA_HH_API_CLOSE_EVT     */ {BTA_HH_API_DISC_ACT, BTA_HH_CONN_ST},
@@ -171,7 +173,7 @@ const uint8_t bta_hh_st_connected[][BTA_HH_NUM_COLS] = {
 #endif
 };
 #if (BTA_HH_LE_INCLUDED == TRUE)
-const uint8_t bta_hh_st_w4_sec[][BTA_HH_NUM_COLS] = {
+constexpr uint8_t bta_hh_st_w4_sec[][BTA_HH_NUM_COLS] = {
     /* Event                          Action                 Next state */
     /* BTA_HH_API_OPEN_EVT      */ {BTA_HH_IGNORE, BTA_HH_W4_SEC},
     /* BTA_HH_API_CLOSE_EVT     */ {BTA_HH_API_DISC_ACT, BTA_HH_W4_SEC},
@@ -192,17 +194,17 @@ const uint8_t bta_hh_st_w4_sec[][BTA_HH_NUM_COLS] = {
     /* BTA_HH_GATT_ENC_CMPL_EVT */ {BTA_HH_GATT_ENC_CMPL, BTA_HH_W4_SEC}};
 #endif
 
-/* type for state table */
-typedef const uint8_t (*tBTA_HH_ST_TBL)[BTA_HH_NUM_COLS];
-
-/* state table */
-const tBTA_HH_ST_TBL bta_hh_st_tbl[] = {bta_hh_st_idle, bta_hh_st_w4_conn,
-                                        bta_hh_st_connected
+/* state table, built at compile time with the action functions resolved */
+constexpr auto bta_hh_st_tbl = bluetooth::common::MakeStateTable<1>(
+    [](uint8_t action) {
+      return action == BTA_HH_IGNORE ? nullptr : bta_hh_action[action];
+    },
+    BTA_HH_IDLE_ST, bta_hh_st_idle, bta_hh_st_w4_conn, bta_hh_st_connected
 #if (BTA_HH_LE_INCLUDED == TRUE)
-                                        ,
-                                        bta_hh_st_w4_sec
+    ,
+    bta_hh_st_w4_sec
 #endif
-};
+    );
 
 /*****************************************************************************
  * Global data
@@ -229,8 +231,6 @@ static const char* bta_hh_state_code(tBTA_HH_STATE state_code);
  ******************************************************************************/
 void bta_hh_sm_execute(tBTA_HH_DEV_CB* p_cb, uint16_t event,
                        tBTA_HH_DATA* p_data) {
-  tBTA_HH_ST_TBL state_table;
-  uint8_t action;
   tBTA_HH cback_data;
   tBTA_HH_EVT cback_event = 0;
 #if (BTA_HH_DEBUG == TRUE)
@@ -321,21 +321,18 @@ void bta_hh_sm_execute(tBTA_HH_DEV_CB* p_cb, uint16_t event,
                      bta_hh_evt_code(debug_event));
 #endif
 
-    if ((p_cb->state == BTA_HH_NULL_ST) || (p_cb->state >= BTA_HH_INVALID_ST)) {
+    const auto* transition = bta_hh_st_tbl.Find(p_cb->state, event & 0xff);
+    if (transition == nullptr) {
       APPL_TRACE_ERROR(
           "bta_hh_sm_execute: Invalid state State = 0x%x, Event = %d",
           p_cb->state, event);
       return;
     }
-    state_table = bta_hh_st_tbl[p_cb->state - 1];
-
-    event &= 0xff;
 
-    p_cb->state = state_table[event][BTA_HH_NEXT_STATE];
+    p_cb->state = transition->next_state;
 
-    action = state_table[event][BTA_HH_ACTION];
-    if (action != BTA_HH_IGNORE) {
-      (*bta_hh_action[action])(p_cb, p_data);
+    if (transition->actions[0] != nullptr) {
+      (*transition->actions[0])(p_cb, p_data);
     }
 
 #if (BTA_HH_DEBUG == TRUE)
@@ -420,6 +417,42 @@ bool bta_hh_hdl_event(BT_HDR* p_msg) {
   return (true);
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_debug_dump
+ *
+ * Description      Dump the input report latency of the connected devices.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_hh_debug_dump(int fd) {
+  dprintf(fd, "\nBTA HID Host:\n");
+  for (const tBTA_HH_DEV_CB& dev : bta_hh_cb.kdev) {
+    if (!dev.in_use) continue;
+
+    const tBTA_HH_LATENCY_HIST& hist = dev.rpt_latency;
+    dprintf(fd, "  Device: %s\n", dev.addr.ToString().c_str());
+    dprintf(fd, "    Low latency: %s\n", dev.low_latency ? "true" : "false");
+    dprintf(fd, "    Input reports: %u\n", hist.total);
+    if (hist.total == 0) continue;
+
+    dprintf(fd, "    Latency average: %llu us, max: %llu us\n",
+            (unsigned long long)(hist.total_us / hist.total),
+            (unsigned long long)hist.max_us);
+    dprintf(fd, "    Latency histogram:");
+    for (int i = 0; i < BTA_HH_LATENCY_BUCKETS; i++) {
+      if (i < BTA_HH_LATENCY_BUCKETS - 1)
+        dprintf(fd, " <%dus: %u", 1 << (i + BTA_HH_LATENCY_MIN_US_SHIFT),
+                hist.count[i]);
+      else
+        dprintf(fd, " >=%dus: %u", 1 << (i - 1 + BTA_HH_LATENCY_MIN_US_SHIFT),
+                hist.count[i]);
+    }
+    dprintf(fd, "\n");
+  }
+}
+
 /*****************************************************************************
  *  Debug Functions
  ****************************************************************************/
@@ -22,8 +22,10 @@
 
 #include "bta_hh_int.h"
 #include "btif/include/btif_storage.h"
+#include "common/time_util.h"
 #include "device/include/interop.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 
 /* if SSR max latency is not defined by remote device, set the default value
    as half of the link supervision timeout */
@@ -42,6 +44,17 @@
 
 #define BTA_HH_MAX_RPT_CHARS 8
 
+/* report descriptor items used to spot game controllers */
+#define BTA_HH_DSCP_LONG_ITEM 0xFE
+#define BTA_HH_DSCP_USAGE_PAGE 0x04 /* global item, tag and type */
+#define BTA_HH_DSCP_USAGE 0x08      /* local item, tag and type */
+#define BTA_HH_USAGE_PAGE_GENERIC_DESKTOP 0x01
+#define BTA_HH_USAGE_JOYSTICK 0x04
+#define BTA_HH_USAGE_GAME_PAD 0x05
+
+/* put every HID device in low latency mode, not only game controllers */
+#define BTA_HH_LOW_LATENCY_PROPERTY "persist.bluetooth.hid.low_latency"
+
 static const uint8_t bta_hh_mod_key_mask[BTA_HH_MOD_MAX_KEY] = {
     BTA_HH_KB_CTRL_MASK, BTA_HH_KB_SHIFT_MASK, BTA_HH_KB_ALT_MASK,
     BTA_HH_KB_GUI_MASK};
@@ -457,6 +470,108 @@ void bta_hh_cleanup_disable(tBTA_HH_STATUS status) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_is_game_controller
+ *
+ * Description      Check whether a report descriptor declares a joystick or a
+ *                  game pad usage.
+ *
+ * Returns          bool
+ *
+ ******************************************************************************/
+static bool bta_hh_is_game_controller(const tBTA_HH_DEV_DESCR* p_dscp) {
+  const uint8_t* p = p_dscp->dsc_list;
+  uint16_t len = p_dscp->dl_len;
+  uint32_t usage_page = 0;
+  uint16_t xx = 0;
+
+  if (p == NULL) return false;
+
+  while (xx < len) {
+    uint8_t prefix = p[xx++];
+    if (prefix == BTA_HH_DSCP_LONG_ITEM) {
+      if (len - xx < 2) break;
+      xx += 2 + p[xx];
+      continue;
+    }
+
+    uint8_t size = prefix & 0x03;
+    if (size == 3) size = 4;
+    if (len - xx < size) break;
+
+    uint32_t value = 0;
+    for (uint8_t yy = 0; yy < size; yy++) value |= p[xx++] << (8 * yy);
+
+    if ((prefix & 0xFC) == BTA_HH_DSCP_USAGE_PAGE) {
+      usage_page = value;
+    } else if ((prefix & 0xFC) == BTA_HH_DSCP_USAGE) {
+      /* a 4 bytes usage comes with its own usage page */
+      uint32_t page = (size == 4) ? (value >> 16) : usage_page;
+      uint16_t usage = (uint16_t)value;
+      if (page == BTA_HH_USAGE_PAGE_GENERIC_DESKTOP &&
+          (usage == BTA_HH_USAGE_JOYSTICK || usage == BTA_HH_USAGE_GAME_PAD))
+        return true;
+    }
+  }
+  return false;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_update_low_latency
+ *
+ * Description      Decide whether the input reports of a device being opened
+ *                  are written to the driver as soon as they are received,
+ *                  which is the case for joysticks and game pads, and reset
+ *                  its report latency histogram.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_hh_update_low_latency(tBTA_HH_DEV_CB* p_cb) {
+  const tBTA_HH_DEV_DESCR* p_dscp = &p_cb->dscp_info.descriptor;
+
+#if (BTA_HH_LE_INCLUDED == TRUE)
+  if (p_cb->is_le_device) p_dscp = &p_cb->hid_srvc.descriptor;
+#endif
+
+  p_cb->low_latency = p_cb->app_id == BTA_HH_APP_ID_JOY ||
+                      p_cb->app_id == BTA_HH_APP_ID_GPAD ||
+                      bta_hh_is_game_controller(p_dscp) ||
+                      osi_property_get_bool(BTA_HH_LOW_LATENCY_PROPERTY, false);
+  memset(&p_cb->rpt_latency, 0, sizeof(p_cb->rpt_latency));
+
+  APPL_TRACE_DEBUG("%s: handle = %d, low latency = %d", __func__,
+                   p_cb->hid_handle, p_cb->low_latency);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_record_rpt_latency
+ *
+ * Description      Count an input report written to the driver in the report
+ *                  latency histogram of its device.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_hh_record_rpt_latency(tBTA_HH_DEV_CB* p_cb, uint64_t rx_time_us) {
+  tBTA_HH_LATENCY_HIST* p_hist = &p_cb->rpt_latency;
+  uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+  uint64_t latency_us = (now_us > rx_time_us) ? now_us - rx_time_us : 0;
+  uint8_t bucket = 0;
+
+  while (bucket < BTA_HH_LATENCY_BUCKETS - 1 &&
+         latency_us >= (1ULL << (bucket + BTA_HH_LATENCY_MIN_US_SHIFT)))
+    bucket++;
+
+  p_hist->count[bucket]++;
+  p_hist->total++;
+  p_hist->total_us += latency_us;
+  if (latency_us > p_hist->max_us) p_hist->max_us = latency_us;
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_dev_handle_to_cb_idx
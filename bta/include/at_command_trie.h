@@ -0,0 +1,66 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Prefix trie used to dispatch AT commands and result codes in a single pass
+ *  over the input, instead of comparing it with every entry of a table.
+ *
+ ******************************************************************************/
+#ifndef AT_COMMAND_TRIE_H
+#define AT_COMMAND_TRIE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class AtCommandTrie {
+ public:
+  static constexpr size_t kNoMatch = SIZE_MAX;
+
+  /* With |ignore_case| the input is matched in uppercase, so the keywords
+   * have to be uppercase, like utl_strucmp() expects. */
+  explicit AtCommandTrie(bool ignore_case);
+
+  /* Adds |keyword| with |value|. Empty keywords are ignored. */
+  void Add(const char* keyword, size_t value);
+
+  /* Looks for the keywords that |text| starts with, and returns the smallest
+   * of their values, or kNoMatch if there is none. The length of that keyword
+   * is written to |p_len| if not null. |text| is read up to its terminating
+   * null character at most. */
+  size_t Match(const char* text, size_t* p_len = nullptr) const;
+
+ private:
+  struct Node {
+    char c;
+    /* Node indexes of the first child and of the next sibling, or 0 for none
+     * since the root is nobody's child */
+    uint32_t first_child;
+    uint32_t next_sibling;
+    size_t value;
+  };
+
+  uint32_t FindChild(uint32_t node, char c) const;
+
+  /* nodes_[0] is the root */
+  std::vector<Node> nodes_;
+  bool ignore_case_;
+};
+
+#endif /* AT_COMMAND_TRIE_H */
@@ -618,6 +618,29 @@ void BTA_GATTC_WriteCharValue(uint16_t conn_id, uint16_t handle,
                               tGATT_AUTH_REQ auth_req,
                               GATT_WRITE_OP_CB callback, void* cb_data);
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_WriteCharValueNoRsp
+ *
+ * Description      This function is called to write characteristic value
+ *                  without response, with no authentication required. Unlike
+ *                  BTA_GATTC_WriteCharValue, several of them can be in flight
+ *                  on a connection: |callback| is called as soon as the write
+ *                  is handed to L2CAP, with GATT_CONGESTED when the
+ *                  application should wait for BTA_GATTC_CONGEST_EVT before
+ *                  writing more.
+ *
+ * Parameters       conn_id - connection ID.
+ *                  handle - characteristic handle to write.
+ *                  value - the value to be written.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void BTA_GATTC_WriteCharValueNoRsp(uint16_t conn_id, uint16_t handle,
+                                   std::vector<uint8_t> value,
+                                   GATT_WRITE_OP_CB callback, void* cb_data);
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_WriteCharDescr
@@ -749,6 +772,22 @@ extern void BTA_GATTC_ReadMultiple(uint16_t conn_id,
  ******************************************************************************/
 extern void BTA_GATTC_Refresh(const RawAddress& remote_bda);
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_SetConnectionPool
+ *
+ * Description      Keep up to |max_links| LE links open once the applications
+ *                  close them, with a long connection interval, so that the
+ *                  peers polled periodically are reopened without a new
+ *                  connection and discovery.
+ *
+ * Parameters       max_links: number of links kept open, 0 to disable.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void BTA_GATTC_SetConnectionPool(uint8_t max_links);
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_ConfigureMTU
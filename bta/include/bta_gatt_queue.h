@@ -31,6 +31,9 @@
  *
  * If you decide to use those methods in your app, make sure to not mix it with
  * existing BTA_GATTC_* API.
+ *
+ * Characteristic writes without response are not held back by the operation
+ * being executed, they only wait behind the operations queued before them.
  */
 class BtaGattQueue {
  public:
@@ -514,6 +514,18 @@ extern void BTA_HhRemoveDev(uint8_t dev_handle);
 extern void BTA_HhParseBootRpt(tBTA_HH_BOOT_RPT* p_data, uint8_t* p_report,
                                uint16_t report_len);
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_debug_dump
+ *
+ * Description      Dump debug-related information of the HID host, written
+ *                  in ASCII to |fd|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void bta_hh_debug_dump(int fd);
+
 /* test commands */
 extern void bta_hh_le_hid_read_rpt_clt_cfg(const RawAddress& bd_addr,
                                            uint8_t rpt_id);
@@ -655,6 +655,20 @@ tBTA_JV_STATUS BTA_JvL2capRead(uint32_t handle, uint32_t req_id,
  ******************************************************************************/
 tBTA_JV_STATUS BTA_JvL2capReady(uint32_t handle, uint32_t* p_data_size);
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capReadBuf
+ *
+ * Description      This function takes the next SDU received on an L2CAP
+ *                  connection, without copying it. The caller owns *pp_buf
+ *                  and must osi_free it.
+ *
+ * Returns          BTA_JV_SUCCESS, if an SDU is returned in *pp_buf.
+ *                  BTA_JV_FAILURE, if no data is available or on error.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capReadBuf(uint32_t handle, BT_HDR** pp_buf);
+
 /*******************************************************************************
  *
  * Function         BTA_JvL2capWrite
@@ -467,6 +467,28 @@ tBTA_JV_STATUS BTA_JvL2capReady(uint32_t handle, uint32_t* p_data_size) {
   return (status);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capReadBuf
+ *
+ * Description      This function takes the next SDU received on an L2CAP
+ *                  connection, without copying it. The caller owns *pp_buf
+ *                  and must osi_free it.
+ *
+ * Returns          BTA_JV_SUCCESS, if an SDU is returned in *pp_buf.
+ *                  BTA_JV_FAILURE, if no data is available or on error.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capReadBuf(uint32_t handle, BT_HDR** pp_buf) {
+  if (handle >= BTA_JV_MAX_L2C_CONN || !bta_jv_cb.l2c_cb[handle].p_cback)
+    return BTA_JV_FAILURE;
+
+  if (GAP_ConnBTRead((uint16_t)handle, pp_buf) != BT_PASS)
+    return BTA_JV_FAILURE;
+
+  return BTA_JV_SUCCESS;
+}
+
 /*******************************************************************************
  *
  * Function         BTA_JvL2capWrite
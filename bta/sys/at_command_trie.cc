@@ -0,0 +1,69 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "at_command_trie.h"
+
+AtCommandTrie::AtCommandTrie(bool ignore_case)
+    : nodes_(1, Node{0, 0, 0, kNoMatch}), ignore_case_(ignore_case) {}
+
+uint32_t AtCommandTrie::FindChild(uint32_t node, char c) const {
+  for (uint32_t child = nodes_[node].first_child; child != 0;
+       child = nodes_[child].next_sibling) {
+    if (nodes_[child].c == c) return child;
+  }
+  return 0;
+}
+
+void AtCommandTrie::Add(const char* keyword, size_t value) {
+  if (keyword[0] == 0) return;
+
+  uint32_t node = 0;
+  for (const char* p = keyword; *p != 0; p++) {
+    uint32_t child = FindChild(node, *p);
+    if (child == 0) {
+      child = nodes_.size();
+      nodes_.push_back(Node{*p, 0, nodes_[node].first_child, kNoMatch});
+      nodes_[node].first_child = child;
+    }
+    node = child;
+  }
+
+  /* Like a table scan, the first entry of duplicated keywords wins */
+  if (value < nodes_[node].value) nodes_[node].value = value;
+}
+
+size_t AtCommandTrie::Match(const char* text, size_t* p_len) const {
+  size_t match = kNoMatch;
+  size_t match_len = 0;
+
+  uint32_t node = 0;
+  for (size_t len = 1; text[len - 1] != 0; len++) {
+    char c = text[len - 1];
+    if (ignore_case_ && c >= 'a' && c <= 'z') c -= 0x20;
+    node = FindChild(node, c);
+    if (node == 0) break;
+    /* A shorter keyword may come first in the table, so keep the smallest */
+    if (nodes_[node].value < match) {
+      match = nodes_[node].value;
+      match_len = len;
+    }
+  }
+
+  if (p_len != nullptr) *p_len = match_len;
+  return match;
+}
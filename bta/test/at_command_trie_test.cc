@@ -0,0 +1,162 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "bta/ag/bta_ag_at.h"
+#include "bta/include/at_command_trie.h"
+
+namespace {
+
+TEST(AtCommandTrieTest, match_keyword_prefix) {
+  AtCommandTrie trie(false);
+  trie.Add("+CIND", 0);
+  trie.Add("+CIEV", 1);
+  trie.Add("+CLCC", 2);
+
+  size_t len;
+  EXPECT_EQ(trie.Match("+CIND?", &len), 0u);
+  EXPECT_EQ(len, 5u);
+  EXPECT_EQ(trie.Match("+CIEV: 1,0"), 1u);
+  EXPECT_EQ(trie.Match("+CLCC"), 2u);
+  EXPECT_EQ(trie.Match("+CLC"), AtCommandTrie::kNoMatch);
+  EXPECT_EQ(trie.Match("+cind?"), AtCommandTrie::kNoMatch);
+  EXPECT_EQ(trie.Match(""), AtCommandTrie::kNoMatch);
+}
+
+TEST(AtCommandTrieTest, ignore_case) {
+  AtCommandTrie trie(true);
+  trie.Add("+BRSF", 0);
+  EXPECT_EQ(trie.Match("+brsf=1023"), 0u);
+  EXPECT_EQ(trie.Match("+BrSf=1023"), 0u);
+}
+
+TEST(AtCommandTrieTest, first_entry_wins) {
+  // Like a table scan, the entry coming first wins whatever its length
+  AtCommandTrie trie(false);
+  trie.Add("+VGS", 0);
+  trie.Add("+V", 1);
+  trie.Add("D", 2);
+  trie.Add("DELAYED", 3);
+  trie.Add("+V", 4);
+
+  size_t len;
+  EXPECT_EQ(trie.Match("+VGS=5", &len), 0u);
+  EXPECT_EQ(len, 4u);
+  EXPECT_EQ(trie.Match("+VGM=5", &len), 1u);
+  EXPECT_EQ(len, 2u);
+  EXPECT_EQ(trie.Match("DELAYED", &len), 2u);
+  EXPECT_EQ(len, 1u);
+  EXPECT_EQ(trie.Match("x"), AtCommandTrie::kNoMatch);
+}
+
+enum { CMD_A, CMD_D, CMD_VGS, CMD_CIND, CMD_CLCC };
+
+const tBTA_AG_AT_CMD test_cmd[] = {
+    {"A", CMD_A, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
+    {"D", CMD_D, BTA_AG_AT_NONE | BTA_AG_AT_FREE, BTA_AG_AT_STR, 0, 0},
+    {"+VGS", CMD_VGS, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 15},
+    {"+CIND", CMD_CIND, BTA_AG_AT_READ | BTA_AG_AT_TEST, BTA_AG_AT_STR, 0, 0},
+    {"+CLCC", CMD_CLCC, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
+    {"", 0, 0, 0, 0, 0}};
+
+struct ParsedCommand {
+  uint16_t command_id;
+  uint8_t arg_type;
+  std::string arg;
+  int16_t int_arg;
+};
+
+std::vector<ParsedCommand> parsed;
+std::vector<std::string> errors;
+
+void test_cmd_cback(tBTA_AG_SCB*, uint16_t command_id, uint8_t arg_type,
+                    char* p_arg, char*, int16_t int_arg) {
+  parsed.push_back({command_id, arg_type, p_arg, int_arg});
+}
+
+void test_err_cback(tBTA_AG_SCB*, bool unknown, const char* p_arg) {
+  errors.push_back(unknown && p_arg ? p_arg : "");
+}
+
+class BtaAgAtTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    parsed.clear();
+    errors.clear();
+    at_cb_.p_at_tbl = test_cmd;
+    at_cb_.p_cmd_cback = test_cmd_cback;
+    at_cb_.p_err_cback = test_err_cback;
+    at_cb_.p_user = nullptr;
+    at_cb_.cmd_max_len = 64;
+    bta_ag_at_init(&at_cb_);
+  }
+
+  void TearDown() override { bta_ag_at_reinit(&at_cb_); }
+
+  void Parse(std::string data) {
+    bta_ag_at_parse(&at_cb_, &data[0], data.size());
+  }
+
+  tBTA_AG_AT_CB at_cb_;
+};
+
+TEST_F(BtaAgAtTest, dispatch_commands) {
+  Parse("AT+CIND=?\rAT+cind?\rAT+VGS=7\rATD5551234;\rATA\rAT+CLCC\r");
+
+  ASSERT_EQ(parsed.size(), 6u);
+  EXPECT_EQ(parsed[0].command_id, CMD_CIND);
+  EXPECT_EQ(parsed[0].arg_type, BTA_AG_AT_TEST);
+  EXPECT_EQ(parsed[1].command_id, CMD_CIND);
+  EXPECT_EQ(parsed[1].arg_type, BTA_AG_AT_READ);
+  EXPECT_EQ(parsed[2].command_id, CMD_VGS);
+  EXPECT_EQ(parsed[2].arg, "7");
+  EXPECT_EQ(parsed[2].int_arg, 7);
+  EXPECT_EQ(parsed[3].command_id, CMD_D);
+  EXPECT_EQ(parsed[3].arg_type, BTA_AG_AT_FREE);
+  EXPECT_EQ(parsed[3].arg, "5551234;");
+  EXPECT_EQ(parsed[4].command_id, CMD_A);
+  EXPECT_EQ(parsed[5].command_id, CMD_CLCC);
+  EXPECT_TRUE(errors.empty());
+}
+
+TEST_F(BtaAgAtTest, commands_split_across_reads) {
+  Parse("AT+C");
+  Parse("LCC\r\nAT+VG");
+  Parse("S=3\r");
+
+  ASSERT_EQ(parsed.size(), 2u);
+  EXPECT_EQ(parsed[0].command_id, CMD_CLCC);
+  EXPECT_EQ(parsed[1].command_id, CMD_VGS);
+  EXPECT_EQ(parsed[1].int_arg, 3);
+}
+
+TEST_F(BtaAgAtTest, report_errors) {
+  Parse("AT+BIA=1\rAT+VGS=16\rAT+CLCC?\r");
+
+  EXPECT_TRUE(parsed.empty());
+  ASSERT_EQ(errors.size(), 3u);
+  EXPECT_EQ(errors[0], "+BIA=1");
+  EXPECT_EQ(errors[1], "");
+  EXPECT_EQ(errors[2], "");
+}
+
+}  // namespace
@@ -0,0 +1,152 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  AT traffic recorded between a car kit and a phone, from the service level
+ *  connection set up to the end of an incoming call, with the CLCC and CIND
+ *  polling car kits do while the call is set up. It is shared by the AT
+ *  parser benchmark and fuzzer.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include "bta/ag/bta_ag_at.h"
+
+/* The commands of bta_ag_hfp_cmd, which is private to bta_ag_cmd.cc, in the
+ * same order and with the same argument syntax. Command ids are the table
+ * indexes. */
+static const tBTA_AG_AT_CMD at_session_ag_hfp_cmd[] = {
+    {"A", 0, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
+    {"D", 1, BTA_AG_AT_NONE | BTA_AG_AT_FREE, BTA_AG_AT_STR, 0, 0},
+    {"+VGS", 2, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 15},
+    {"+VGM", 3, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 15},
+    {"+CCWA", 4, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 1},
+    {"+CHLD", 5, BTA_AG_AT_SET | BTA_AG_AT_TEST, BTA_AG_AT_STR, 0, 4},
+    {"+CHUP", 6, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
+    {"+CIND", 7, BTA_AG_AT_READ | BTA_AG_AT_TEST, BTA_AG_AT_STR, 0, 0},
+    {"+CLIP", 8, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 1},
+    {"+CMER", 9, BTA_AG_AT_SET, BTA_AG_AT_STR, 0, 0},
+    {"+VTS", 10, BTA_AG_AT_SET, BTA_AG_AT_STR, 0, 0},
+    {"+BINP", 11, BTA_AG_AT_SET, BTA_AG_AT_INT, 1, 1},
+    {"+BLDN", 12, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
+    {"+BVRA", 13, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 1},
+    {"+BRSF", 14, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 32767},
+    {"+NREC", 15, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 0},
+    {"+CNUM", 16, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
+    {"+BTRH", 17, BTA_AG_AT_READ | BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 2},
+    {"+CLCC", 18, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
+    {"+COPS", 19, BTA_AG_AT_READ | BTA_AG_AT_SET, BTA_AG_AT_STR, 0, 0},
+    {"+CMEE", 20, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 1},
+    {"+BIA", 21, BTA_AG_AT_SET, BTA_AG_AT_STR, 0, 20},
+    {"+CBC", 22, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 100},
+    {"+BCC", 23, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
+    {"+BCS", 24, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 32767},
+    {"+BIND", 25, BTA_AG_AT_SET | BTA_AG_AT_READ | BTA_AG_AT_TEST,
+     BTA_AG_AT_STR, 0, 0},
+    {"+BIEV", 26, BTA_AG_AT_SET, BTA_AG_AT_STR, 0, 0},
+    {"+BAC", 27, BTA_AG_AT_SET, BTA_AG_AT_STR, 0, 0},
+    {"", 0, 0, 0, 0, 0}};
+
+/* The events of bta_hf_client_parser in bta_hf_client_at.cc, in order */
+static const char* const at_session_hf_client_events[] = {
+    "OK",     "ERROR",  "RING",   "+BRSF:", "+CIND:", "+CIEV:",
+    "+CHLD:", "+BCS:",  "+BSIR:", "+CME ERROR:",      "+VGM:",
+    "+VGM=",  "+VGS:",  "+VGS=",  "+BVRA:", "+CLIP:", "+CCWA:",
+    "+COPS:", "+BINP:", "+CLCC:", "+CNUM:", "+BTRH:", "BUSY",
+    "DELAYED",          "NO CARRIER",       "NO ANSWER",
+    "BLACKLISTED"};
+
+#define AT_SESSION_CLCC_POLL "AT+CLCC\r"
+#define AT_SESSION_CIND_POLL "AT+CIND?\r"
+
+/* Commands sent by the car kit */
+static const char at_session_ag_rx[] =
+    "AT+BRSF=959\r"
+    "AT+BAC=1,2\r"
+    "AT+CIND=?\r"
+    "AT+CIND?\r"
+    "AT+CMER=3,0,0,1\r"
+    "AT+CHLD=?\r"
+    "AT+BIND=1,2\r"
+    "AT+BIND=?\r"
+    "AT+BIND?\r"
+    "AT+CMEE=1\r"
+    "AT+CCWA=1\r"
+    "AT+CLIP=1\r"
+    "AT+NREC=0\r"
+    "AT+VGS=9\r"
+    "AT+VGM=9\r"
+    "AT+COPS=3,0\r"
+    "AT+COPS?\r"
+    "AT+CNUM\r"
+    "AT+BIA=0,0,0,1,1,1,0\r"
+    "AT+BTRH?\r" AT_SESSION_CLCC_POLL AT_SESSION_CIND_POLL
+        AT_SESSION_CLCC_POLL AT_SESSION_CIND_POLL AT_SESSION_CLCC_POLL
+            AT_SESSION_CLCC_POLL AT_SESSION_CIND_POLL AT_SESSION_CLCC_POLL
+    "AT+BCS=2\r"
+    "ATA\r" AT_SESSION_CLCC_POLL AT_SESSION_CIND_POLL AT_SESSION_CLCC_POLL
+    "AT+VTS=1\r"
+    "AT+VGS=12\r"
+    "AT+BIEV=2,60\r"
+    "AT+CHLD=1\r"
+    "AT+CHUP\r" AT_SESSION_CLCC_POLL AT_SESSION_CIND_POLL;
+
+#define AT_SESSION_CLCC_ACTIVE \
+  "\r\n+CLCC: 1,1,0,0,0,\"+15551234567\",145\r\n\r\nOK\r\n"
+#define AT_SESSION_CLCC_INCOMING \
+  "\r\n+CLCC: 1,1,4,0,0,\"+15551234567\",145\r\n\r\nOK\r\n"
+#define AT_SESSION_CIND_VALUES "\r\n+CIND: 0,1,1,4,0,3,0\r\n\r\nOK\r\n"
+
+/* Responses and unsolicited result codes sent by the phone */
+static const char at_session_hf_client_rx[] =
+    "\r\n+BRSF: 3943\r\n\r\nOK\r\n"
+    "\r\nOK\r\n"
+    "\r\n+CIND: (\"call\",(0,1)),(\"callsetup\",(0-3)),(\"service\",(0-1)),"
+    "(\"signal\",(0-5)),(\"roam\",(0,1)),(\"battchg\",(0-5)),"
+    "(\"callheld\",(0-2))\r\n\r\nOK\r\n"
+    "\r\n+CIND: 0,0,1,4,0,3,0\r\n\r\nOK\r\n"
+    "\r\nOK\r\n"
+    "\r\n+CHLD: (0,1,2,3)\r\n\r\nOK\r\n"
+    "\r\nOK\r\n"
+    "\r\n+BIND: (1,2)\r\n\r\nOK\r\n"
+    "\r\n+BIND: 1,1\r\n\r\n+BIND: 2,1\r\n\r\nOK\r\n"
+    "\r\nOK\r\n\r\nOK\r\n\r\nOK\r\n\r\nOK\r\n"
+    "\r\n+VGS: 9\r\n\r\n+VGM=9\r\n"
+    "\r\nOK\r\n"
+    "\r\n+COPS: 0,0,\"Carrier\"\r\n\r\nOK\r\n"
+    "\r\n+CNUM: ,\"+15557654321\",145,,4\r\n\r\nOK\r\n"
+    "\r\nOK\r\n\r\nOK\r\n"
+    "\r\n+CIEV: 2,1\r\n"
+    "\r\nRING\r\n"
+    "\r\n+CLIP: \"+15551234567\",145\r\n" AT_SESSION_CLCC_INCOMING
+        AT_SESSION_CIND_VALUES AT_SESSION_CLCC_INCOMING AT_SESSION_CIND_VALUES
+    "\r\nRING\r\n"
+    "\r\n+CLIP: \"+15551234567\",145\r\n" AT_SESSION_CLCC_INCOMING
+        AT_SESSION_CLCC_INCOMING AT_SESSION_CIND_VALUES
+    "\r\n+BCS: 2\r\n"
+    "\r\nOK\r\n"
+    "\r\n+CIEV: 1,1\r\n"
+    "\r\n+CIEV: 2,0\r\n" AT_SESSION_CLCC_ACTIVE AT_SESSION_CIND_VALUES
+        AT_SESSION_CLCC_ACTIVE
+    "\r\nOK\r\n"
+    "\r\n+VGS: 12\r\n"
+    "\r\n+CME ERROR: 4\r\n"
+    "\r\nOK\r\n"
+    "\r\n+CIEV: 1,0\r\n"
+    "\r\nNO CARRIER\r\n" AT_SESSION_CIND_VALUES;
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Fuzzes the AG AT command parser with the HFP command table, the input being
+// split in reads of fuzzed sizes like RFCOMM data, and checks on every command
+// that the AtCommandTrie lookups of the AG and of the HF client find the same
+// entry as a scan of their tables would.
+
+#include <fuzzer/FuzzedDataProvider.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "bta/ag/bta_ag_at.h"
+#include "bta/include/at_command_trie.h"
+#include "bta/include/utl.h"
+#include "bta/test/at_session_data.h"
+#include "stack/include/btm_api.h"
+
+#define MIN_CMD_LEN 16
+#define MAX_READ_SIZE 1024
+#define NUM_HF_CLIENT_EVENTS               \
+  (sizeof(at_session_hf_client_events) / \
+   sizeof(at_session_hf_client_events[0]))
+
+size_t ag_table_scan(const char* p_cmd) {
+  for (size_t idx = 0; at_session_ag_hfp_cmd[idx].p_cmd[0] != 0; idx++) {
+    if (!utl_strucmp(at_session_ag_hfp_cmd[idx].p_cmd, p_cmd)) return idx;
+  }
+  return AtCommandTrie::kNoMatch;
+}
+
+size_t hf_client_event_scan(const char* p_event) {
+  for (size_t idx = 0; idx < NUM_HF_CLIENT_EVENTS; idx++) {
+    const char* p_name = at_session_hf_client_events[idx];
+    if (strncmp(p_event, p_name, strlen(p_name)) == 0) return idx;
+  }
+  return AtCommandTrie::kNoMatch;
+}
+
+const AtCommandTrie& hf_client_trie() {
+  static const AtCommandTrie* trie = [] {
+    AtCommandTrie* trie = new AtCommandTrie(false);
+    for (size_t idx = 0; idx < NUM_HF_CLIENT_EVENTS; idx++) {
+      trie->Add(at_session_hf_client_events[idx], idx);
+    }
+    return trie;
+  }();
+  return *trie;
+}
+
+tBTA_AG_AT_CB at_cb;
+
+void check_lookups(const char* p_cmd) {
+  if (at_cb.p_at_trie->Match(p_cmd) != ag_table_scan(p_cmd)) abort();
+  if (hf_client_trie().Match(p_cmd) != hf_client_event_scan(p_cmd)) abort();
+}
+
+// The command bta_ag_process_at() dispatched is still in the command buffer
+void cmd_cback(tBTA_AG_SCB*, uint16_t, uint8_t, char*, char*, int16_t) {
+  check_lookups(at_cb.p_cmd_buf);
+}
+
+void err_cback(tBTA_AG_SCB*, bool unknown, const char* p_arg) {
+  if (unknown && p_arg != nullptr) check_lookups(p_arg);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size) {
+  FuzzedDataProvider dataProvider(Data, Size);
+
+  at_cb.p_at_tbl = at_session_ag_hfp_cmd;
+  at_cb.p_cmd_cback = cmd_cback;
+  at_cb.p_err_cback = err_cback;
+  at_cb.p_user = nullptr;
+  at_cb.cmd_max_len = dataProvider.ConsumeIntegralInRange<uint16_t>(
+      MIN_CMD_LEN, MAX_READ_SIZE);
+  bta_ag_at_init(&at_cb);
+
+  while (dataProvider.remaining_bytes() > 0) {
+    size_t read_size =
+        dataProvider.ConsumeIntegralInRange<size_t>(1, MAX_READ_SIZE);
+    std::vector<char> read = dataProvider.ConsumeBytes<char>(read_size);
+    if (read.empty()) break;
+    bta_ag_at_parse(&at_cb, read.data(), read.size());
+  }
+
+  bta_ag_at_reinit(&at_cb);
+  return 0;
+}
+
+// Referenced by utl.cc, which provides utl_str2int() to the AG parser
+tBTM_STATUS BTM_SetDeviceClass(DEV_CLASS dev_class) {
+  return BTM_ILLEGAL_VALUE;
+}
+uint8_t* BTM_ReadDeviceClass(void) { return nullptr; }
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include "gatt/cache_store.h"
+#include "gatt/database_builder.h"
+
+using bluetooth::Uuid;
+
+namespace gatt {
+
+namespace {
+const RawAddress kAddress1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kAddress2({0x11, 0x22, 0x33, 0x44, 0x55, 0x67});
+const RawAddress kAddress3({0x11, 0x22, 0x33, 0x44, 0x55, 0x68});
+
+Database BuildDatabase(uint16_t value_handle) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, Uuid::FromString("1800"), true);
+  builder.AddCharacteristic(0x0002, value_handle, Uuid::FromString("2a00"),
+                            0x02);
+  builder.AddDescriptor(value_handle + 1, Uuid::FromString("2902"));
+  return builder.Build();
+}
+
+class GattCacheStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = ::testing::TempDir() + "gatt_cache_store_test";
+    unlink(path_.c_str());
+  }
+
+  void TearDown() override { unlink(path_.c_str()); }
+
+  std::string path_;
+};
+}  // namespace
+
+TEST_F(GattCacheStoreTest, store_write_and_load) {
+  {
+    CacheStore store(path_, 4096);
+    EXPECT_FALSE(store.Open());
+    store.Store(kAddress1, BuildDatabase(0x0003).Serialize());
+    store.Store(kAddress2, BuildDatabase(0x0005).Serialize());
+    ASSERT_TRUE(CacheStore::WriteFile(path_, store.Serialize()));
+  }
+
+  CacheStore store(path_, 4096);
+  ASSERT_TRUE(store.Open());
+  EXPECT_EQ(store.Size(), 6 * sizeof(StoredAttribute));
+
+  Database database;
+  ASSERT_TRUE(store.Load(kAddress1, &database));
+  EXPECT_EQ(database.ToString(), BuildDatabase(0x0003).ToString());
+  ASSERT_TRUE(store.Load(kAddress2, &database));
+  EXPECT_EQ(database.ToString(), BuildDatabase(0x0005).ToString());
+  EXPECT_FALSE(store.Load(kAddress3, &database));
+
+  // replace an entry read from the file
+  store.Store(kAddress1, BuildDatabase(0x0007).Serialize());
+  ASSERT_TRUE(store.Load(kAddress1, &database));
+  EXPECT_EQ(database.ToString(), BuildDatabase(0x0007).ToString());
+  EXPECT_EQ(store.Size(), 6 * sizeof(StoredAttribute));
+
+  EXPECT_TRUE(store.Remove(kAddress2));
+  EXPECT_FALSE(store.Remove(kAddress2));
+  EXPECT_FALSE(store.Load(kAddress2, &database));
+}
+
+TEST_F(GattCacheStoreTest, evict_least_recently_used) {
+  CacheStore store(path_, 6 * sizeof(StoredAttribute));
+  store.Store(kAddress1, BuildDatabase(0x0003).Serialize());
+  store.Store(kAddress2, BuildDatabase(0x0005).Serialize());
+
+  Database database;
+  ASSERT_TRUE(store.Load(kAddress1, &database));
+
+  store.Store(kAddress3, BuildDatabase(0x0007).Serialize());
+  EXPECT_TRUE(store.Load(kAddress1, &database));
+  EXPECT_FALSE(store.Load(kAddress2, &database));
+  EXPECT_TRUE(store.Load(kAddress3, &database));
+
+  // the order of use survives writing the file
+  ASSERT_TRUE(CacheStore::WriteFile(path_, store.Serialize()));
+  CacheStore reopened(path_, 6 * sizeof(StoredAttribute));
+  ASSERT_TRUE(reopened.Open());
+  reopened.Store(kAddress2, BuildDatabase(0x0005).Serialize());
+  EXPECT_FALSE(reopened.Load(kAddress1, &database));
+  EXPECT_TRUE(reopened.Load(kAddress3, &database));
+}
+
+TEST_F(GattCacheStoreTest, load_matching_hash) {
+  CacheStore::Hash hash;
+  hash.fill(0x5a);
+  CacheStore::Hash other_hash = hash;
+  other_hash[15] = 0xa5;
+
+  {
+    CacheStore store(path_, 4096);
+    store.Store(kAddress1, BuildDatabase(0x0003).Serialize(), &hash, 1234);
+    store.Store(kAddress2, BuildDatabase(0x0005).Serialize());
+    ASSERT_TRUE(CacheStore::WriteFile(path_, store.Serialize()));
+  }
+
+  CacheStore store(path_, 4096);
+  ASSERT_TRUE(store.Open());
+  EXPECT_EQ(store.DiscoveryTime(kAddress1), 1234u);
+  EXPECT_EQ(store.DiscoveryTime(kAddress2), 0u);
+
+  Database database;
+  EXPECT_FALSE(store.Load(kAddress1, &database, &other_hash));
+  ASSERT_TRUE(store.Load(kAddress1, &database, &hash));
+  EXPECT_EQ(database.ToString(), BuildDatabase(0x0003).ToString());
+  EXPECT_TRUE(store.Load(kAddress1, &database));
+
+  // a server cached without a hash never matches one
+  EXPECT_FALSE(store.Load(kAddress2, &database, &hash));
+  EXPECT_TRUE(store.Load(kAddress2, &database));
+}
+
+TEST_F(GattCacheStoreTest, reject_truncated_file) {
+  CacheStore store(path_, 4096);
+  store.Store(kAddress1, BuildDatabase(0x0003).Serialize());
+  std::vector<uint8_t> content = store.Serialize();
+  content.resize(content.size() - 1);
+  ASSERT_TRUE(CacheStore::WriteFile(path_, content));
+
+  CacheStore truncated(path_, 4096);
+  EXPECT_FALSE(truncated.Open());
+  EXPECT_EQ(truncated.Size(), 0u);
+}
+
+}  // namespace gatt
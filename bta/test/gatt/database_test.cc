@@ -84,6 +84,51 @@ TEST(GattDatabaseTest, serialize_deserialize_binary_test) {
   EXPECT_EQ(serialized[4].type, SERVICE_1_CHAR_1_DESC_1_UUID);
 }
 
+void ExpectHandleLookups(const Database& db) {
+  const Service* service = db.GetService(0x0005);
+  ASSERT_NE(nullptr, service);
+  EXPECT_EQ(0x0001, service->handle);
+  EXPECT_EQ(0x0010, db.GetService(0x001f)->handle);
+  EXPECT_EQ(nullptr, db.GetService(0x0020));
+
+  const Characteristic* charac = db.GetCharacteristic(0x0004);
+  ASSERT_NE(nullptr, charac);
+  EXPECT_EQ(SERVICE_1_CHAR_1_UUID, charac->uuid);
+  EXPECT_EQ(nullptr, db.GetCharacteristic(0x0003));
+  EXPECT_EQ(nullptr, db.GetCharacteristic(0x0005));
+
+  const Descriptor* desc = db.GetDescriptor(0x0005);
+  ASSERT_NE(nullptr, desc);
+  EXPECT_EQ(SERVICE_1_CHAR_1_DESC_1_UUID, desc->uuid);
+  EXPECT_EQ(nullptr, db.GetDescriptor(0x0004));
+  EXPECT_EQ(charac, db.GetOwningCharacteristic(0x0005));
+  EXPECT_EQ(nullptr, db.GetOwningCharacteristic(0x0004));
+}
+
+/* This test makes sure that the handle lookups work on databases that are
+ * discovered, loaded from the cache or copied */
+TEST(GattDatabaseTest, handle_lookup_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0010, 0x001f, SERVICE_2_UUID, false);
+  builder.AddIncludedService(0x0002, SERVICE_2_UUID, 0x0010, 0x001f);
+  builder.AddCharacteristic(0x0003, 0x0004, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddDescriptor(0x0005, SERVICE_1_CHAR_1_DESC_1_UUID);
+
+  Database db = builder.Build();
+  ExpectHandleLookups(db);
+
+  bool success = false;
+  Database loaded = Database::Deserialize(db.Serialize(), &success);
+  ASSERT_TRUE(success);
+  ExpectHandleLookups(loaded);
+
+  Database copy = loaded;
+  loaded.Clear();
+  EXPECT_EQ(nullptr, loaded.GetCharacteristic(0x0004));
+  ExpectHandleLookups(copy);
+}
+
 /* This test makes sure that Service represented in StoredAttribute have proper
  * binary format. */
 TEST(GattCacheTest, stored_attribute_to_binary_service_test) {
@@ -27,11 +27,13 @@
 
 #include "btcore/include/module.h"
 #include "common/message_loop_thread.h"
+#include "common/startup_trace.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 
 using bluetooth::common::MessageLoopThread;
+using bluetooth::common::startup_trace::ScopedEvent;
 
 typedef enum {
   MODULE_STATE_NONE = 0,
@@ -64,6 +66,7 @@ bool module_init(const module_t* module) {
   CHECK(module != NULL);
   CHECK(get_module_state(module) == MODULE_STATE_NONE);
 
+  ScopedEvent trace_event(std::string("module_init ") + module->name);
   if (!call_lifecycle_function(module->init)) {
     LOG_ERROR("%s Failed to initialize module \"%s\"", __func__, module->name);
     return false;
@@ -84,6 +87,7 @@ bool module_start_up(const module_t* module) {
         module->init == NULL);
 
   LOG_INFO("%s Starting module \"%s\"", __func__, module->name);
+  ScopedEvent trace_event(std::string("module_start_up ") + module->name);
   if (!call_lifecycle_function(module->start_up)) {
     LOG_ERROR("%s Failed to start up module \"%s\"", __func__, module->name);
     return false;
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Throughput of the PAN TAP datapath. A SOCK_SEQPACKET socket pair stands in
+// for the TAP driver: like it, each read or write moves one whole ethernet
+// frame. Each iteration moves a batch of range(0) frames of range(1) bytes
+// of payload, and the bytes processed are the ethernet frames moved.
+//
+// The legacy functions are the datapath before the frames were read and
+// written with scatter / gather I/O, kept here as the baseline.
+
+#include <benchmark/benchmark.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "bt_common.h"
+#include "btif_pan_internal.h"
+#include "osi/include/osi.h"
+#include "pan_api.h"
+
+using ::benchmark::State;
+
+namespace {
+
+constexpr uint16_t kProto = 0x0800;  // ETH_P_IP
+const RawAddress kSrc({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});
+const RawAddress kDst({0x00, 0x66, 0x77, 0x88, 0x99, 0xaa});
+
+// Legacy TAP write: the frame is staged in a stack buffer
+int legacy_tap_send(int tap_fd, const RawAddress& src, const RawAddress& dst,
+                    uint16_t proto, const char* buf, uint16_t len) {
+  tETH_HDR eth_hdr;
+  eth_hdr.h_dest = dst;
+  eth_hdr.h_src = src;
+  eth_hdr.h_proto = htons(proto);
+  char packet[TAP_MAX_PKT_WRITE_LEN + sizeof(tETH_HDR)];
+  memcpy(packet, &eth_hdr, sizeof(tETH_HDR));
+  if (len > TAP_MAX_PKT_WRITE_LEN) return -1;
+  memcpy(packet + sizeof(tETH_HDR), buf, len);
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = write(tap_fd, packet, len + sizeof(tETH_HDR)));
+  return (int)ret;
+}
+
+// Legacy TAP read: the frame is read into a separate buffer, then copied
+// into a new BNEP buffer, with the ethernet header skipped.
+BT_HDR* legacy_tap_read(int tap_fd, unsigned char* congest_packet,
+                        size_t congest_packet_size, tETH_HDR* p_eth_hdr) {
+  ssize_t ret;
+  OSI_NO_INTR(ret = read(tap_fd, congest_packet, congest_packet_size));
+  if (ret <= (ssize_t)sizeof(tETH_HDR)) return NULL;
+
+  BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
+  buffer->offset = PAN_MINIMUM_OFFSET;
+  buffer->len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
+  uint8_t* packet = (uint8_t*)(buffer + 1) + buffer->offset;
+  buffer->len = ret < buffer->len ? ret : buffer->len;
+  memcpy(packet, congest_packet, buffer->len);
+
+  memcpy(p_eth_hdr, packet, sizeof(tETH_HDR));
+  buffer->len -= sizeof(tETH_HDR);
+  buffer->offset += sizeof(tETH_HDR);
+  return buffer;
+}
+
+class TapPair {
+ public:
+  TapPair() {
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds_) == -1) {
+      fds_[0] = fds_[1] = INVALID_FD;
+      return;
+    }
+    // Room for a whole batch
+    int size = 4 * 1024 * 1024;
+    for (int fd : fds_) {
+      setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+      setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    }
+  }
+  ~TapPair() {
+    for (int fd : fds_)
+      if (fd != INVALID_FD) close(fd);
+  }
+
+  bool ok() const { return fds_[0] != INVALID_FD; }
+  // The TAP fd of the stack
+  int tap() const { return fds_[0]; }
+  // The kernel side of the TAP interface
+  int net() const { return fds_[1]; }
+
+ private:
+  int fds_[2];
+};
+
+// Writes |frames| copies of the ethernet |frame| to |fd|, from the kernel
+// side.
+bool WriteFrames(int fd, const std::vector<char>& frame, int frames) {
+  for (int i = 0; i < frames; i++) {
+    if (write(fd, frame.data(), frame.size()) != (ssize_t)frame.size())
+      return false;
+  }
+  return true;
+}
+
+// Discards the frames written by the stack, from the kernel side
+void DrainFrames(int fd, std::vector<char>* scratch) {
+  while (read(fd, scratch->data(), scratch->size()) > 0) {
+  }
+}
+
+std::vector<char> MakeFrame(size_t payload) {
+  std::vector<char> frame(sizeof(tETH_HDR) + payload, 0x5a);
+  tETH_HDR eth_hdr;
+  eth_hdr.h_dest = kDst;
+  eth_hdr.h_src = kSrc;
+  eth_hdr.h_proto = htons(kProto);
+  memcpy(frame.data(), &eth_hdr, sizeof(tETH_HDR));
+  return frame;
+}
+
+}  // namespace
+
+// TAP to BNEP, legacy: read(), then a new buffer and a copy per frame
+static void BM_TapReadLegacy(State& state) {
+  TapPair pair;
+  if (!pair.ok()) {
+    state.SkipWithError("socketpair failed");
+    return;
+  }
+  int frames = state.range(0);
+  std::vector<char> frame = MakeFrame(state.range(1));
+  unsigned char congest_packet[1600];
+  for (auto _ : state) {
+    state.PauseTiming();
+    if (!WriteFrames(pair.net(), frame, frames)) {
+      state.SkipWithError("write failed");
+      return;
+    }
+    state.ResumeTiming();
+    tETH_HDR eth_hdr;
+    for (int i = 0; i < frames; i++) {
+      BT_HDR* buffer = legacy_tap_read(pair.tap(), congest_packet,
+                                       sizeof(congest_packet), &eth_hdr);
+      benchmark::DoNotOptimize(buffer);
+      osi_free(buffer);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * frames * frame.size());
+}
+
+// TAP to BNEP: readv() into the BNEP buffer, reused as the spare buffer when
+// it is not sent
+static void BM_TapReadFrame(State& state) {
+  TapPair pair;
+  if (!pair.ok()) {
+    state.SkipWithError("socketpair failed");
+    return;
+  }
+  int frames = state.range(0);
+  std::vector<char> frame = MakeFrame(state.range(1));
+  BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
+  for (auto _ : state) {
+    state.PauseTiming();
+    if (!WriteFrames(pair.net(), frame, frames)) {
+      state.SkipWithError("write failed");
+      break;
+    }
+    state.ResumeTiming();
+    tETH_HDR eth_hdr;
+    for (int i = 0; i < frames; i++) {
+      buffer->offset = PAN_MINIMUM_OFFSET;
+      buffer->len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
+      benchmark::DoNotOptimize(
+          btpan_tap_read_frame(pair.tap(), &eth_hdr, buffer));
+    }
+  }
+  osi_free(buffer);
+  state.SetBytesProcessed(state.iterations() * frames * frame.size());
+}
+
+// BNEP to TAP, legacy: the frame is staged before write()
+static void BM_TapSendLegacy(State& state) {
+  TapPair pair;
+  if (!pair.ok()) {
+    state.SkipWithError("socketpair failed");
+    return;
+  }
+  int frames = state.range(0);
+  std::vector<char> payload(state.range(1), 0x5a);
+  std::vector<char> scratch(sizeof(tETH_HDR) + payload.size());
+  for (auto _ : state) {
+    for (int i = 0; i < frames; i++) {
+      legacy_tap_send(pair.tap(), kSrc, kDst, kProto, payload.data(),
+                      payload.size());
+    }
+    state.PauseTiming();
+    DrainFrames(pair.net(), &scratch);
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed(state.iterations() * frames * scratch.size());
+}
+
+// BNEP to TAP: writev() of the header and the payload
+static void BM_TapSend(State& state) {
+  TapPair pair;
+  if (!pair.ok()) {
+    state.SkipWithError("socketpair failed");
+    return;
+  }
+  int frames = state.range(0);
+  std::vector<char> payload(state.range(1), 0x5a);
+  std::vector<char> scratch(sizeof(tETH_HDR) + payload.size());
+  for (auto _ : state) {
+    for (int i = 0; i < frames; i++) {
+      btpan_tap_send(pair.tap(), kSrc, kDst, kProto, payload.data(),
+                     payload.size(), false, false);
+    }
+    state.PauseTiming();
+    DrainFrames(pair.net(), &scratch);
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed(state.iterations() * frames * scratch.size());
+}
+
+// Batches of PAN_BUF_MAX frames, the most read per TAP event, of a full
+// 1500 byte MTU and of a TCP ACK
+static void FrameArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->Args({PAN_BUF_MAX, 1500});
+  benchmark->Args({PAN_BUF_MAX, 40});
+}
+
+BENCHMARK(BM_TapReadLegacy)->Apply(FrameArguments);
+BENCHMARK(BM_TapReadFrame)->Apply(FrameArguments);
+BENCHMARK(BM_TapSendLegacy)->Apply(FrameArguments);
+BENCHMARK(BM_TapSend)->Apply(FrameArguments);
@@ -1397,6 +1397,7 @@ void BtaAvCo::DataPacketWasDropped(tBTA_AV_HNDL bta_av_handle,
                                    const RawAddress& peer_address) {
   APPL_TRACE_ERROR("%s: peer %s dropped audio packet on handle 0x%x", __func__,
                    peer_address.ToString().c_str(), bta_av_handle);
+  btif_a2dp_source_link_congestion_req();
 }
 
 void BtaAvCo::ProcessAudioDelay(tBTA_AV_HNDL bta_av_handle,
@@ -0,0 +1,128 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+
+#include "bt_types.h"
+#include "osi/include/fixed_queue.h"
+
+// What a full A2DP media queue drops to make room for a new packet.
+enum class BtifA2dpDropPolicy {
+  // Every queued packet, so that the stream resumes with the newest audio
+  kFlush,
+  // The oldest queued packets, as few as needed
+  kOldest,
+  // The new packet, so that the queued audio plays out uninterrupted
+  kNewest,
+  // The queued packets whose RTP timestamp lags the new packet by more than
+  // the deadline, then the oldest ones if that is not enough
+  kDeadline,
+};
+
+// Parses "flush", "oldest", "newest" or "deadline" into |policy|.
+bool BtifA2dpDropPolicyFromString(const std::string& text,
+                                  BtifA2dpDropPolicy* policy);
+const char* BtifA2dpDropPolicyText(BtifA2dpDropPolicy policy);
+
+// Returns the policy named by system property |property|, or
+// |default_policy| if it is not set or not a policy name.
+BtifA2dpDropPolicy BtifA2dpDropPolicyFromProperty(
+    const char* property, BtifA2dpDropPolicy default_policy);
+
+// What was dropped from a queue, by one enqueue or since the queue was made.
+struct BtifA2dpDropCounts {
+  size_t overflows = 0;     // Enqueues that found the queue full
+  size_t packets = 0;       // Packets dropped, queued or new
+  size_t late_packets = 0;  // Of those, dropped for being past the deadline
+  size_t frames = 0;        // Audio frames in the dropped packets
+  size_t bytes = 0;         // Encoded bytes in the dropped packets
+
+  void Add(const BtifA2dpDropCounts& other);
+};
+
+// A bounded queue of A2DP media packets, which drops packets according to
+// its policy when a new one does not fit.
+//
+// Each queued BT_HDR carries the RTP timestamp of its media in the four
+// bytes following the header, and its number of audio frames in
+// |layer_specific|. The queue owns the queued packets and frees them with
+// osi_free().
+//
+// One thread enqueues, any thread may dequeue. A lock-free queue may be
+// dequeued concurrently with Enqueue(), so Enqueue() never reads a packet it
+// has not dequeued itself: the deadline policy judges the queued packets by
+// the timestamps it recorded when enqueuing them. When the consumer takes the
+// oldest packet between that judgement and the drop, the drop takes the next
+// one instead, which costs at most one packet per Enqueue() more than the
+// policy asks for.
+class BtifA2dpMediaQueue {
+ public:
+  // Lag from the new packet past which a queued packet is late
+  static constexpr uint32_t kDefaultDeadlineMs = 200;
+
+  BtifA2dpMediaQueue(size_t capacity, BtifA2dpDropPolicy policy,
+                     bool lock_free);
+  ~BtifA2dpMediaQueue();
+
+  // Sets the sample rate of the RTP timestamps, which the deadline policy
+  // needs. Until it is set, the deadline policy drops the oldest packets.
+  void SetSampleRate(uint32_t sample_rate);
+  void SetDeadlineMs(uint32_t deadline_ms);
+
+  // Takes |p_buf|, first dropping packets per the policy if the queue is
+  // full. Returns false if |p_buf| itself was dropped. What this call
+  // dropped is stored in |dropped| if it is not null.
+  bool Enqueue(BT_HDR* p_buf, BtifA2dpDropCounts* dropped);
+
+  // Returns the oldest packet, or nullptr if the queue is empty.
+  BT_HDR* Dequeue();
+
+  // Frees every queued packet and returns how many there were. These are not
+  // counted as drops.
+  size_t Flush();
+
+  size_t Length() const;
+  size_t Capacity() const { return capacity_; }
+  bool IsEmpty() const { return Length() == 0; }
+
+  BtifA2dpDropPolicy policy() const { return policy_; }
+  void set_policy(BtifA2dpDropPolicy policy) { policy_ = policy; }
+
+  // Everything dropped since the queue was made
+  const BtifA2dpDropCounts& drops() const { return drops_; }
+
+ private:
+  bool IsLate(uint32_t queued_timestamp, uint32_t timestamp) const;
+  // Forgets the timestamps of the packets that are no longer queued
+  void PruneTimestamps(size_t length);
+  void Drop(BT_HDR* p_buf, bool late, BtifA2dpDropCounts* dropped);
+
+  fixed_queue_t* const queue_;
+  const size_t capacity_;
+  BtifA2dpDropPolicy policy_;
+  uint32_t sample_rate_;
+  uint32_t deadline_ms_;
+  BtifA2dpDropCounts drops_;
+  // The RTP timestamps of the queued packets, oldest first. Only touched by
+  // Enqueue(), so that it needs no lock against the consumer.
+  std::deque<uint32_t> timestamps_;
+};
@@ -117,9 +117,13 @@ bool btif_a2dp_sink_on_start(void);
 void btif_a2dp_sink_set_rx_flush(bool enable);
 
 // Enqueue a buffer to the A2DP Sink queue. If the queue has reached its
-// maximum size |MAX_INPUT_A2DP_FRAME_QUEUE_SZ|, the oldest buffer is
-// removed from the queue.
-// |p_buf| is the buffer to enqueue.
+// maximum size |MAX_INPUT_A2DP_FRAME_QUEUE_SZ|, buffers are dropped per the
+// policy set by persist.bluetooth.a2dp_sink.drop_policy, by default the
+// oldest ones. The queued buffers are decoded ahead on the
+// A2DP Sink worker thread, into a jitter buffer whose depth adapts to the
+// arrival jitter.
+// |p_buf| is the buffer to enqueue, with the RTP timestamp of the packet
+// stored in the first 4 bytes of its data, ahead of the payload.
 // Returns the number of buffers in the Sink queue after the enqueing.
 uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_buf);
 
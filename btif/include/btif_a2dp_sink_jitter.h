@@ -0,0 +1,92 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Depth of the A2DP Sink jitter buffer, adapted to the arrival jitter of the
+// media packets.
+//
+// The transit time of a packet is its arrival time minus the media time of
+// its RTP timestamp. Over two consecutive windows of kWindowUs, the spread
+// between the shortest and the longest transit time is the delay the buffer
+// must absorb; the target depth is that spread plus kMarginUs, within
+// [kMinDepthUs, kMaxDepthUs]. Taking the minimum over a short window keeps
+// the estimate independent of the drift between the clock of the source and
+// the local clock. The RFC 3550 interarrival jitter is estimated as well, for
+// the statistics.
+//
+// The depth of the buffered PCM, sampled at each playback tick, is compared
+// with the target to compensate for the drift between the source and the
+// audio track: by dropping or repeating one PCM frame per tick when the
+// smoothed depth leaves the target band.
+class BtifA2dpSinkJitter {
+ public:
+  static constexpr uint64_t kMinDepthUs = 40000;
+  static constexpr uint64_t kMaxDepthUs = 300000;
+  static constexpr uint64_t kDefaultDepthUs = 100000;
+  static constexpr uint64_t kMarginUs = 20000;
+  static constexpr uint64_t kWindowUs = 4000000;
+
+  BtifA2dpSinkJitter() { Reset(0); }
+
+  // Resets the estimate for RTP timestamps at |sample_rate| Hz.
+  void Reset(uint32_t sample_rate);
+
+  // Updates the estimate with a packet of RTP |timestamp| that arrived at
+  // |arrival_us|. The timestamps that do not advance, or jump by more than
+  // a second, restart the estimate from that packet.
+  void OnPacket(uint32_t timestamp, uint64_t arrival_us);
+
+  // Returns the depth the buffer should have before playing, and keep.
+  uint64_t TargetDepthUs() const;
+
+  // Updates the smoothed depth with the |depth_us| of buffered PCM at a
+  // playback tick. Returns the number of PCM frames to drop (1), repeat (-1)
+  // or not (0) at this tick.
+  int OnPlaybackTick(uint64_t depth_us);
+
+  // Forgets the smoothed depth, when the playback restarts.
+  void RestartPlayback() { smoothed_depth_us_ = -1; }
+
+  uint64_t JitterUs() const { return jitter_x16_ >> 4; }
+  int64_t SmoothedDepthUs() const { return smoothed_depth_us_; }
+  uint64_t packets() const { return packets_; }
+  uint64_t resyncs() const { return resyncs_; }
+
+ private:
+  void Resync(uint32_t timestamp, uint64_t arrival_us);
+
+  uint32_t sample_rate_;
+  uint64_t packets_;
+  uint64_t resyncs_;
+
+  bool synced_;
+  uint32_t last_timestamp_;
+  uint64_t media_samples_;  // Since the first packet after a resync
+  uint64_t sync_arrival_us_;
+  int64_t last_transit_us_;
+  uint64_t jitter_x16_;
+
+  // Transit time windows, the current and the previous one
+  uint64_t window_start_us_;
+  bool has_previous_window_;
+  int64_t min_transit_us_[2];
+  int64_t max_transit_us_[2];
+
+  int64_t smoothed_depth_us_;
+};
@@ -24,6 +24,14 @@
 #include <future>
 
 #include "bta_av_api.h"
+#include "embdrv/pcm_converter/pcm_converter.h"
+
+/**
+ * The typical runlevel of the tx queue size is ~1 buffer
+ * but due to link flow control or thread preemption in lower
+ * layers we might need to temporarily buffer up data.
+ */
+#define MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ (MAX_PCM_FRAME_NUM_PER_TICK * 2)
 
 // Initialize the A2DP Source module.
 // This function should be called by the BTIF state machine prior to using the
@@ -99,6 +107,13 @@ void btif_a2dp_source_encoder_user_config_update_req(
 void btif_a2dp_source_feeding_update_req(
     const btav_a2dp_codec_config_t& codec_audio_config);
 
+// Set the format of the audio read from the audio HAL to |input_format|, when
+// it differs from the format the encoder is fed with. The audio is then
+// converted to the encoder format as it is read. An empty format ({}) feeds
+// the encoder with the audio as read, which is the default.
+void btif_a2dp_source_set_audio_input_format(
+    const bluetooth::audio::PcmFormat& input_format);
+
 // Process 'idle' request from the BTIF state machine during initialization.
 void btif_a2dp_source_on_idle(void);
 
@@ -117,10 +132,20 @@ void btif_a2dp_source_on_suspended(tBTA_AV_SUSPEND* p_av_suspend);
 // If |enable| is true, the discarding is enabled, otherwise is disabled.
 void btif_a2dp_source_set_tx_flush(bool enable);
 
+// Report that encoded audio was dropped before reaching the peer, so the
+// encoder lowers its bit rate on the link.
+void btif_a2dp_source_link_congestion_req(void);
+
 // Get the next A2DP buffer to send.
 // Returns the next A2DP buffer to send if available, otherwise NULL.
 BT_HDR* btif_a2dp_source_audio_readbuf(void);
 
+// Get the number of bytes of audio read from the audio HAL whose encoded
+// packets were handed over to be sent to the peer. The audio still queued and
+// the audio dropped are not counted. The count only grows.
+// This can be called from any thread.
+uint64_t btif_a2dp_source_get_sent_pcm_bytes(void);
+
 // Dump debug-related information for the A2DP Source module.
 // |fd| is the file descriptor to use for writing the ASCII formatted
 // information.
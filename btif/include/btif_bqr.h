@@ -17,6 +17,8 @@
 #ifndef BTIF_BQR_H_
 #define BTIF_BQR_H_
 
+#include <functional>
+
 #include "btm_api_types.h"
 #include "common/leaky_bonded_queue.h"
 #include "osi/include/osi.h"
@@ -256,6 +258,62 @@ typedef struct {
   uint8_t* vendor_specific_parameter;
 } BqrLogDumpEvent;
 
+// View of a Link Quality related BQR event, reading its fields straight from
+// the parameters of the sub-event, which must outlive the view.
+class BqrLinkQualityEventView {
+ public:
+  BqrLinkQualityEventView(const uint8_t* p_param_buf, uint8_t length)
+      : p_param_buf_(p_param_buf), length_(length) {}
+
+  // True if the parameters hold all the fields of the event. The fields must
+  // not be read otherwise.
+  bool IsValid() const { return length_ >= kLinkQualityParamTotalLen; }
+
+  uint8_t QualityReportId() const { return Get8(0); }
+  uint8_t PacketTypes() const { return Get8(1); }
+  uint16_t ConnectionHandle() const { return Get16(2); }
+  uint8_t ConnectionRole() const { return Get8(4); }
+  int8_t TxPowerLevel() const { return static_cast<int8_t>(Get8(5)); }
+  int8_t Rssi() const { return static_cast<int8_t>(Get8(6)); }
+  uint8_t Snr() const { return Get8(7); }
+  uint8_t UnusedAfhChannelCount() const { return Get8(8); }
+  uint8_t AfhSelectUnidealChannelCount() const { return Get8(9); }
+  uint16_t Lsto() const { return Get16(10); }
+  uint32_t ConnectionPiconetClock() const { return Get32(12); }
+  uint32_t RetransmissionCount() const { return Get32(16); }
+  uint32_t NoRxCount() const { return Get32(20); }
+  uint32_t NakCount() const { return Get32(24); }
+  uint32_t LastTxAckTimestamp() const { return Get32(28); }
+  uint32_t FlowOffCount() const { return Get32(32); }
+  uint32_t LastFlowOnTimestamp() const { return Get32(36); }
+  uint32_t BufferOverflowBytes() const { return Get32(40); }
+  uint32_t BufferUnderflowBytes() const { return Get32(44); }
+  const uint8_t* VendorSpecificParameter() const {
+    return p_param_buf_ + kLinkQualityParamTotalLen;
+  }
+  uint8_t VendorSpecificParameterLength() const {
+    return length_ - kLinkQualityParamTotalLen;
+  }
+
+ private:
+  uint8_t Get8(size_t offset) const { return p_param_buf_[offset]; }
+  uint16_t Get16(size_t offset) const {
+    return p_param_buf_[offset] | (p_param_buf_[offset + 1] << 8);
+  }
+  uint32_t Get32(size_t offset) const {
+    return Get16(offset) | (static_cast<uint32_t>(Get16(offset + 2)) << 16);
+  }
+
+  const uint8_t* p_param_buf_;
+  uint8_t length_;
+};
+
+// Observer of the Link Quality related BQR events. It is called on the stack
+// main thread as the events are received, with a view only valid for the
+// duration of the call.
+using LinkQualityObserver =
+    std::function<void(const BqrLinkQualityEventView& event)>;
+
 // BQR sub-event of Vendor Specific Event
 class BqrVseSubEvt {
  public:
@@ -351,6 +409,20 @@ void CategorizeBqrEvent(uint8_t length, uint8_t* p_bqr_event);
 // @param p_link_quality_event A pointer to the Link Quality related BQR event.
 void AddLinkQualityEventToQueue(uint8_t length, uint8_t* p_link_quality_event);
 
+// Subscribe to the Link Quality related BQR events. May be called from any
+// thread.
+//
+// @param observer The observer to call with each event.
+// @return an id to unsubscribe the observer with.
+int RegisterLinkQualityObserver(LinkQualityObserver observer);
+
+// Unsubscribe an observer of the Link Quality related BQR events. If called
+// off the stack main thread, the observer may still receive the event being
+// dispatched when this returns.
+//
+// @param observer_id The id returned by RegisterLinkQualityObserver.
+void UnregisterLinkQualityObserver(int observer_id);
+
 // Dump the LMP/LL message handshaking with the remote device to a log file.
 //
 // @param length Lengths of the LMP/LL message trace event.
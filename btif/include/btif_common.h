@@ -195,6 +195,19 @@ base::Callback<R(Args...)> jni_thread_wrapper(const base::Location& from_here,
       from_here, std::move(cb));
 }
 
+/**
+ * Typed variant of btif_transfer_context: runs |functor| with |args| on the
+ * jni thread. The arguments are moved into the closure, instead of being
+ * copied into a parameter block and deep copied by a tBTIF_COPY_CBACK.
+ */
+template <typename Functor, typename... Args>
+bt_status_t btif_transfer_context(const base::Location& from_here,
+                                  Functor&& functor, Args&&... args) {
+  return do_in_jni_thread(
+      from_here, base::BindOnce(std::forward<Functor>(functor),
+                                std::forward<Args>(args)...));
+}
+
 tBTA_SERVICE_MASK btif_get_enabled_services_mask(void);
 bt_status_t btif_enable_service(tBTA_SERVICE_ID service_id);
 bt_status_t btif_disable_service(tBTA_SERVICE_ID service_id);
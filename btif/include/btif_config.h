@@ -36,6 +36,7 @@ static const std::string BT_CONFIG_KEY_SDP_DI_HW_VERSION =
     "SdpDiHardwareVersion";
 static const std::string BT_CONFIG_KEY_SDP_DI_VENDOR_ID_SRC =
     "SdpDiVendorIdSource";
+static const std::string BT_CONFIG_KEY_SDP_CACHE = "SdpCache";
 
 static const std::string BT_CONFIG_KEY_REMOTE_VER_MFCT = "Manufacturer";
 static const std::string BT_CONFIG_KEY_REMOTE_VER_VER = "LmpVer";
@@ -65,6 +66,11 @@ size_t btif_config_get_bin_length(const std::string& section,
 
 std::vector<RawAddress> btif_config_get_paired_devices();
 
+// Have the keystore decrypt the encrypted keys of the paired devices in the
+// background, most recently used devices first, so that they are cached by
+// the time the bonded devices are loaded and reconnected.
+void btif_config_prefetch_encrypted_keys();
+
 void btif_config_save(void);
 void btif_config_flush(void);
 bool btif_config_clear(void);
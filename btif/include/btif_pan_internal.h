@@ -27,6 +27,8 @@
 #ifndef BTIF_PAN_INTERNAL_H
 #define BTIF_PAN_INTERNAL_H
 
+#include <sys/types.h>
+
 #include "bt_types.h"
 #include "btif_pan.h"
 
@@ -79,8 +81,9 @@ typedef struct {
   int open_count;
   int flow;  // 1: outbound data flow on; 0: outbound data flow off
   btpan_conn_t conns[MAX_PAN_CONNS];
-  int congest_packet_size;
-  unsigned char congest_packet[1600];  // max ethernet packet size
+  BT_HDR* congest_buf;       // frame read from the TAP and not sent yet
+  tETH_HDR congest_eth_hdr;  // ethernet header of congest_buf
+  BT_HDR* spare_buf;         // buffer of a TAP read that got no frame
 } btpan_cb_t;
 
 /*******************************************************************************
@@ -101,6 +104,11 @@ int btpan_tap_close(int tap_fd);
 int btpan_tap_send(int tap_fd, const RawAddress& src, const RawAddress& dst,
                    uint16_t protocol, const char* buff, uint16_t size, bool ext,
                    bool forward);
+// Reads one frame from the TAP driver: the ethernet header into |p_eth_hdr|
+// and the payload into |p_buf|, at its offset and up to its length. Sets the
+// length of |p_buf| to the length of the payload read. Returns the result of
+// the read.
+ssize_t btpan_tap_read_frame(int tap_fd, tETH_HDR* p_eth_hdr, BT_HDR* p_buf);
 
 static inline int is_empty_eth_addr(const RawAddress& addr) {
   return addr == RawAddress::kEmpty;
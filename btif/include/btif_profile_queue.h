@@ -37,7 +37,22 @@ void btif_queue_cleanup(uint16_t uuid);
 void btif_queue_advance();
 
 /**
- * Dispatch the next pending connect request.
+ * Complete the connect request in progress for |bda| and dispatch the next
+ * pending ones. Requests for different devices may be in progress at once.
+ */
+void btif_queue_advance_by_address(const RawAddress& bda);
+
+/**
+ * Complete the connect request in progress for profile |uuid| on |bda| and
+ * dispatch the next pending ones. Once the ACL to |bda| is up, HFP and A2DP
+ * requests for it may be in progress at once, so profiles must use this
+ * rather than btif_queue_advance_by_address().
+ */
+void btif_queue_advance_by_profile(uint16_t uuid, const RawAddress& bda);
+
+/**
+ * Dispatch the next pending connect requests, most recently used devices
+ * first.
  * NOTE: Must be called on the JNI thread.
  *
  * @return BT_STATUS_SUCCESS on success, otherwise the corresponding error
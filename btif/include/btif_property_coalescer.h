@@ -0,0 +1,79 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include <hardware/bluetooth.h>
+
+#include "raw_address.h"
+
+// Collects property updates of remote devices and merges the updates of
+// each device, so that a storm of updates reaches the upper layer as one
+// update per device.
+//
+// Within a device, a property replaces an earlier property of the same type,
+// which is what the upper layer does with it anyway. Devices are delivered
+// in the order they were first added, and the properties of a device in the
+// order their types were first added.
+//
+// Not thread safe; the owner adds and flushes on one thread.
+class BtifPropertyCoalescer {
+ public:
+  using DeliverCallback = std::function<void(
+      const RawAddress& bd_addr, int num_properties, bt_property_t* properties)>;
+
+  // Copies |properties| of |bd_addr|. Returns true if nothing was pending
+  // before, that is when the owner has to schedule a flush.
+  bool Add(const RawAddress& bd_addr, int num_properties,
+           const bt_property_t* properties);
+
+  // Calls |deliver| once for each pending device and forgets them. The
+  // properties passed to |deliver| are valid for the duration of the call.
+  // Returns the number of devices delivered.
+  size_t Flush(const DeliverCallback& deliver);
+
+  // Forgets the pending updates without delivering them.
+  void Clear();
+
+  bool IsEmpty() const { return devices_.empty(); }
+  size_t PendingDevices() const { return devices_.size(); }
+
+  // Updates added, and updates that reached the upper layer, since the
+  // coalescer was made
+  size_t added() const { return added_; }
+  size_t delivered() const { return delivered_; }
+
+ private:
+  struct Property {
+    bt_property_type_t type;
+    std::vector<uint8_t> value;
+  };
+
+  struct Device {
+    RawAddress bd_addr;
+    std::vector<Property> properties;
+  };
+
+  std::vector<Device> devices_;
+  size_t added_ = 0;
+  size_t delivered_ = 0;
+};
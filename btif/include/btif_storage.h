@@ -238,6 +238,12 @@ void btif_storage_set_gatt_cl_supp_feat(const RawAddress& bd_addr,
 /** Get client supported features */
 uint8_t btif_storage_get_gatt_cl_supp_feat(const RawAddress& bd_addr);
 
+/** Stores the time a bonded device was last connected */
+void btif_storage_set_remote_device_last_used(const RawAddress& bd_addr);
+
+/** Get the time a bonded device was last connected, 0 if never recorded */
+int btif_storage_get_remote_device_last_used(const RawAddress& bd_addr);
+
 /** Get the hearing aid device properties. */
 bool btif_storage_get_hearing_aid_prop(
     const RawAddress& address, uint8_t* capabilities, uint64_t* hi_sync_id,
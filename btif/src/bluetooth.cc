@@ -49,6 +49,7 @@
 #include "bt_utils.h"
 #include "bta/include/bta_hearing_aid_api.h"
 #include "bta/include/bta_hf_client_api.h"
+#include "bta/include/bta_hh_api.h"
 #include "btif/avrcp/avrcp_service.h"
 #include "btif_a2dp.h"
 #include "btif_api.h"
@@ -61,20 +62,28 @@
 #include "btif_hf.h"
 #include "btif_keystore.h"
 #include "btif_storage.h"
+#include "btm_ble_api.h"
 #include "btsnoop.h"
 #include "btsnoop_mem.h"
 #include "common/address_obfuscator.h"
 #include "common/metric_id_allocator.h"
 #include "common/metrics.h"
+#include "common/startup_trace.h"
+#include "common/thread_profile.h"
 #include "device/include/interop.h"
+#include "gatt_api.h"
 #include "gd/common/init_flags.h"
+#include "hci_layer.h"
 #include "main/shim/dumpsys.h"
 #include "main/shim/shim.h"
 #include "osi/include/alarm.h"
 #include "osi/include/allocation_tracker.h"
+#include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/wakelock.h"
+#include "stack/include/btu.h"
+#include "stack/include/sco_hci_link_interface.h"
 #include "stack/gatt/connection_manager.h"
 #include "stack_manager.h"
 
@@ -90,6 +99,11 @@ bool niap_mode = false;
 const int CONFIG_COMPARE_ALL_PASS = 0b11;
 int niap_config_compare_result = CONFIG_COMPARE_ALL_PASS;
 
+// Average octets allocated between the samples of the allocation profiler
+static const size_t kAllocationProfileSampleInterval = 64 * 1024;
+// Dump argument that writes only the allocation profile
+static const char kAllocationProfileDumpArg[] = "--allocation-profile";
+
 /*******************************************************************************
  *  Externs
  ******************************************************************************/
@@ -147,6 +161,13 @@ static int init(bt_callbacks_t* callbacks, bool start_restricted,
            __func__, start_restricted, is_niap_mode, config_compare_result);
 
   bluetooth::common::InitFlags::Load(init_flags);
+  osi_allocator_enable_slab(
+      bluetooth::common::InitFlags::OsiSlabAllocatorEnabled());
+  bluetooth::common::SetMetricsPerEventLogging(
+      bluetooth::common::InitFlags::MetricsPerEventEnabled());
+  if (bluetooth::common::InitFlags::OsiAllocationProfilingEnabled()) {
+    allocation_tracker_profile_start(kAllocationProfileSampleInterval);
+  }
 
   if (interface_ready()) return BT_STATUS_DONE;
 
@@ -174,6 +195,7 @@ static int enable() {
 static int disable(void) {
   if (!interface_ready()) return BT_STATUS_NOT_READY;
 
+  bluetooth::common::FlushMetrics();
   stack_manager_get_interface()->shut_down_stack_async();
   return BT_STATUS_SUCCESS;
 }
@@ -323,11 +345,20 @@ static int read_energy_info() {
 }
 
 static void dump(int fd, const char** arguments) {
+  // Only the profile, for pprof to read the output
+  for (const char** arg = arguments; arg != nullptr && *arg != nullptr; arg++) {
+    if (strcmp(*arg, kAllocationProfileDumpArg) == 0) {
+      allocation_tracker_profile_dump(fd);
+      return;
+    }
+  }
+
   btif_debug_conn_dump(fd);
   btif_debug_bond_event_dump(fd);
   btif_debug_a2dp_dump(fd);
   btif_debug_av_dump(fd);
   bta_debug_av_dump(fd);
+  bta_hh_debug_dump(fd);
   stack_debug_avdtp_api_dump(fd);
   bluetooth::avrcp::AvrcpService::DebugDump(fd);
   btif_debug_config_dump(fd);
@@ -337,10 +368,20 @@ static void dump(int fd, const char** arguments) {
   alarm_debug_dump(fd);
   HearingAid::DebugDump(fd);
   connection_manager::dump(fd);
+  gatt_debug_dump(fd);
+  BTM_BleResolvingListDump(fd);
+  BTM_PmDebugDump(fd);
+  BTM_LinkQualityDebugDump(fd);
   bluetooth::bqr::DebugDump(fd);
+  bluetooth::audio::sco::DebugDump(fd);
+  bluetooth::common::startup_trace::DebugDump(fd);
+  bluetooth::common::MetricsDebugDump(fd);
+  btu_debug_dump(fd);
+  bluetooth::common::DumpThreads(fd);
   if (bluetooth::shim::is_gd_shim_enabled()) {
     bluetooth::shim::Dump(fd, arguments);
   } else {
+    hci_debug_dump(fd);
 #if (BTSNOOP_MEM == TRUE)
     btif_debug_btsnoop_dump(fd);
 #endif
@@ -348,6 +389,7 @@ static void dump(int fd, const char** arguments) {
 }
 
 static void dumpMetrics(std::string* output) {
+  bluetooth::common::FlushMetrics();
   bluetooth::common::BluetoothMetricsLogger::GetInstance()->WriteString(output);
 }
 
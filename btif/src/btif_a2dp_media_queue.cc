@@ -0,0 +1,200 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#define LOG_TAG "bt_btif_a2dp_media_queue"
+
+#include "btif_a2dp_media_queue.h"
+
+#include <base/logging.h>
+
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+#include "osi/include/properties.h"
+
+constexpr uint32_t BtifA2dpMediaQueue::kDefaultDeadlineMs;
+
+bool BtifA2dpDropPolicyFromString(const std::string& text,
+                                  BtifA2dpDropPolicy* policy) {
+  if (text == "flush") {
+    *policy = BtifA2dpDropPolicy::kFlush;
+  } else if (text == "oldest") {
+    *policy = BtifA2dpDropPolicy::kOldest;
+  } else if (text == "newest") {
+    *policy = BtifA2dpDropPolicy::kNewest;
+  } else if (text == "deadline") {
+    *policy = BtifA2dpDropPolicy::kDeadline;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* BtifA2dpDropPolicyText(BtifA2dpDropPolicy policy) {
+  switch (policy) {
+    case BtifA2dpDropPolicy::kFlush:
+      return "flush";
+    case BtifA2dpDropPolicy::kOldest:
+      return "oldest";
+    case BtifA2dpDropPolicy::kNewest:
+      return "newest";
+    case BtifA2dpDropPolicy::kDeadline:
+      return "deadline";
+  }
+  return "unknown";
+}
+
+BtifA2dpDropPolicy BtifA2dpDropPolicyFromProperty(
+    const char* property, BtifA2dpDropPolicy default_policy) {
+  char value[PROPERTY_VALUE_MAX] = {};
+  if (osi_property_get(property, value, nullptr) == 0) return default_policy;
+  BtifA2dpDropPolicy policy;
+  if (!BtifA2dpDropPolicyFromString(value, &policy)) {
+    LOG_WARN("%s: ignoring %s=%s", __func__, property, value);
+    return default_policy;
+  }
+  LOG_INFO("%s: %s=%s", __func__, property, value);
+  return policy;
+}
+
+void BtifA2dpDropCounts::Add(const BtifA2dpDropCounts& other) {
+  overflows += other.overflows;
+  packets += other.packets;
+  late_packets += other.late_packets;
+  frames += other.frames;
+  bytes += other.bytes;
+}
+
+BtifA2dpMediaQueue::BtifA2dpMediaQueue(size_t capacity,
+                                       BtifA2dpDropPolicy policy,
+                                       bool lock_free)
+    : queue_(lock_free ? fixed_queue_new_lock_free(capacity)
+                       : fixed_queue_new(capacity)),
+      capacity_(capacity),
+      policy_(policy),
+      sample_rate_(0),
+      deadline_ms_(kDefaultDeadlineMs) {
+  CHECK(queue_ != nullptr);
+}
+
+BtifA2dpMediaQueue::~BtifA2dpMediaQueue() {
+  fixed_queue_free(queue_, osi_free);
+}
+
+void BtifA2dpMediaQueue::SetSampleRate(uint32_t sample_rate) {
+  sample_rate_ = sample_rate;
+}
+
+void BtifA2dpMediaQueue::SetDeadlineMs(uint32_t deadline_ms) {
+  deadline_ms_ = deadline_ms;
+}
+
+static uint32_t TimestampOf(const BT_HDR* p_buf) {
+  return *reinterpret_cast<const uint32_t*>(p_buf + 1);
+}
+
+bool BtifA2dpMediaQueue::IsLate(uint32_t queued_timestamp,
+                                uint32_t timestamp) const {
+  if (sample_rate_ == 0) return false;
+  // Unsigned so that the lag is right across a timestamp wrap
+  uint32_t lag = timestamp - queued_timestamp;
+  return static_cast<uint64_t>(lag) * 1000 >
+         static_cast<uint64_t>(deadline_ms_) * sample_rate_;
+}
+
+void BtifA2dpMediaQueue::Drop(BT_HDR* p_buf, bool late,
+                              BtifA2dpDropCounts* dropped) {
+  dropped->packets++;
+  if (late) dropped->late_packets++;
+  dropped->frames += p_buf->layer_specific;
+  dropped->bytes += p_buf->len;
+  osi_free(p_buf);
+}
+
+void BtifA2dpMediaQueue::PruneTimestamps(size_t length) {
+  // The consumer takes the oldest packets, so the queued ones are the last
+  // |length| enqueued
+  while (timestamps_.size() > length) timestamps_.pop_front();
+}
+
+bool BtifA2dpMediaQueue::Enqueue(BT_HDR* p_buf, BtifA2dpDropCounts* dropped) {
+  BtifA2dpDropCounts counts;
+  bool enqueued = true;
+  uint32_t timestamp = TimestampOf(p_buf);
+
+  if (fixed_queue_length(queue_) >= capacity_) {
+    counts.overflows++;
+    switch (policy_) {
+      case BtifA2dpDropPolicy::kFlush:
+        while (BT_HDR* p_old = Dequeue()) Drop(p_old, false, &counts);
+        break;
+      case BtifA2dpDropPolicy::kOldest:
+        while (fixed_queue_length(queue_) >= capacity_) {
+          BT_HDR* p_old = Dequeue();
+          if (p_old == nullptr) break;
+          Drop(p_old, false, &counts);
+        }
+        break;
+      case BtifA2dpDropPolicy::kNewest:
+        Drop(p_buf, false, &counts);
+        enqueued = false;
+        break;
+      case BtifA2dpDropPolicy::kDeadline: {
+        while (true) {
+          size_t length = fixed_queue_length(queue_);
+          PruneTimestamps(length);
+          if (timestamps_.empty()) break;
+          // The consumer may free the oldest packet at any time, so it is
+          // judged by its recorded timestamp rather than read
+          if (!IsLate(timestamps_.front(), timestamp) && length < capacity_)
+            break;
+          BT_HDR* p_old = Dequeue();
+          if (p_old == nullptr) break;
+          bool late = IsLate(TimestampOf(p_old), timestamp);
+          Drop(p_old, late, &counts);
+          // A timely packet was dropped because the consumer took the late
+          // one first; there is room now
+          if (!late && fixed_queue_length(queue_) < capacity_) break;
+        }
+        break;
+      }
+    }
+  }
+
+  if (enqueued) {
+    PruneTimestamps(fixed_queue_length(queue_));
+    timestamps_.push_back(timestamp);
+    fixed_queue_enqueue(queue_, p_buf);
+  }
+
+  drops_.Add(counts);
+  if (dropped != nullptr) *dropped = counts;
+  return enqueued;
+}
+
+BT_HDR* BtifA2dpMediaQueue::Dequeue() {
+  return static_cast<BT_HDR*>(fixed_queue_try_dequeue(queue_));
+}
+
+size_t BtifA2dpMediaQueue::Flush() {
+  size_t count = 0;
+  while (BT_HDR* p_buf = Dequeue()) {
+    osi_free(p_buf);
+    count++;
+  }
+  return count;
+}
+
+size_t BtifA2dpMediaQueue::Length() const { return fixed_queue_length(queue_); }
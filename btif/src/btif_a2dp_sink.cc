@@ -19,9 +19,12 @@
 
 #define LOG_TAG "bt_btif_a2dp_sink"
 
+#include <inttypes.h>
+#include <algorithm>
 #include <atomic>
 #include <cstdio>
 #include <cstring>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -29,15 +32,19 @@
 
 #include "bt_common.h"
 #include "btif_a2dp.h"
+#include "btif_a2dp_media_queue.h"
 #include "btif_a2dp_sink.h"
+#include "btif_a2dp_sink_jitter.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
 #include "btif_avrcp_audio_track.h"
 #include "btif_util.h"
 #include "common/message_loop_thread.h"
-#include "osi/include/fixed_queue.h"
+#include "common/time_util.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
+#include "osi/include/ringbuffer.h"
 
 using bluetooth::common::MessageLoopThread;
 using LockGuard = std::lock_guard<std::mutex>;
@@ -47,10 +54,15 @@ using LockGuard = std::lock_guard<std::mutex>;
  */
 #define MAX_INPUT_A2DP_FRAME_QUEUE_SZ (MAX_PCM_FRAME_NUM_PER_TICK * 2)
 
+/* What the receiving queue drops when full, see BtifA2dpDropPolicy */
+#define BTIF_A2DP_SINK_DROP_POLICY_PROPERTY \
+  "persist.bluetooth.a2dp_sink.drop_policy"
+
 #define BTIF_SINK_MEDIA_TIME_TICK_MS 20
 
-/* In case of A2DP Sink, we will delay start by 5 AVDTP Packets */
-#define MAX_A2DP_DELAYED_START_FRAME_COUNT 5
+/* The decoded PCM ring holds the deepest jitter buffer, and two ticks */
+#define BTIF_A2DP_SINK_PCM_RING_MS \
+  (BtifA2dpSinkJitter::kMaxDepthUs / 1000 + 2 * BTIF_SINK_MEDIA_TIME_TICK_MS)
 
 enum {
   BTIF_A2DP_SINK_STATE_OFF,
@@ -79,19 +91,30 @@ typedef struct {
   btif_a2dp_sink_focus_state_t focus_state;
 } tBTIF_MEDIA_SINK_FOCUS_UPDATE;
 
+/* BTIF A2DP Sink jitter buffer statistics */
+struct BtifA2dpSinkStats {
+  uint64_t underruns = 0;       /* PCM ring empty while playing */
+  uint64_t overruns = 0;        /* PCM ring full, oldest PCM dropped */
+  uint64_t dropped_frames = 0;  /* drift compensation */
+  uint64_t repeated_frames = 0; /* drift compensation */
+};
+
 /* BTIF A2DP Sink control block */
 class BtifA2dpSinkControlBlock {
  public:
   explicit BtifA2dpSinkControlBlock(const std::string& thread_name)
       : worker_thread(thread_name),
-        rx_audio_queue(nullptr),
         rx_flush(false),
         decode_alarm(nullptr),
         sample_rate(0),
         channel_count(0),
         rx_focus_state(BTIF_A2DP_SINK_FOCUS_NOT_GRANTED),
         audio_track(nullptr),
-        decoder_interface(nullptr) {}
+        decoder_interface(nullptr),
+        pcm_ring(nullptr),
+        pcm_frame_size(0),
+        tick_frames(0),
+        playing(false) {}
 
   void Reset() {
     if (audio_track != nullptr) {
@@ -99,8 +122,7 @@ class BtifA2dpSinkControlBlock {
       BtifAvrcpAudioTrackDelete(audio_track);
     }
     audio_track = nullptr;
-    fixed_queue_free(rx_audio_queue, nullptr);
-    rx_audio_queue = nullptr;
+    rx_audio_queue.reset();
     alarm_free(decode_alarm);
     decode_alarm = nullptr;
     rx_flush = false;
@@ -108,10 +130,17 @@ class BtifA2dpSinkControlBlock {
     sample_rate = 0;
     channel_count = 0;
     decoder_interface = nullptr;
+    ringbuffer_free(pcm_ring);
+    pcm_ring = nullptr;
+    pcm_frame_size = 0;
+    tick_frames = 0;
+    playing = false;
+    jitter.Reset(0);
+    stats = BtifA2dpSinkStats();
   }
 
   MessageLoopThread worker_thread;
-  fixed_queue_t* rx_audio_queue;
+  std::unique_ptr<BtifA2dpMediaQueue> rx_audio_queue;
   bool rx_flush; /* discards any incoming data when true */
   alarm_t* decode_alarm;
   tA2DP_SAMPLE_RATE sample_rate;
@@ -120,6 +149,12 @@ class BtifA2dpSinkControlBlock {
   btif_a2dp_sink_focus_state_t rx_focus_state; /* audio focus state */
   void* audio_track;
   const tA2DP_DECODER_INTERFACE* decoder_interface;
+  ringbuffer_t* pcm_ring; /* decoded PCM, ahead of the playback */
+  size_t pcm_frame_size;  /* bytes per PCM frame, all channels */
+  size_t tick_frames;     /* PCM frames written to the track at each tick */
+  bool playing;           /* false while prebuffering */
+  BtifA2dpSinkJitter jitter;
+  BtifA2dpSinkStats stats;
 };
 
 // Mutex for below data structures.
@@ -141,6 +176,10 @@ static void btif_a2dp_sink_audio_handle_stop_decoding();
 static void btif_decode_alarm_cb(void* context);
 static void btif_a2dp_sink_audio_handle_start_decoding();
 static void btif_a2dp_sink_avk_handle_timer();
+static void btif_a2dp_sink_decode_ahead();
+static void btif_a2dp_sink_decode_queue();
+static void btif_a2dp_sink_pcm_flush();
+static void btif_a2dp_sink_pcm_play_tick();
 static void btif_a2dp_sink_audio_rx_flush_req();
 /* Handle incoming media packets A2DP SINK streaming */
 static void btif_a2dp_sink_handle_inc_media(BT_HDR* p_msg);
@@ -188,7 +227,11 @@ bool btif_a2dp_sink_init() {
     return false;
   }
 
-  btif_a2dp_sink_cb.rx_audio_queue = fixed_queue_new(SIZE_MAX);
+  btif_a2dp_sink_cb.rx_audio_queue = std::make_unique<BtifA2dpMediaQueue>(
+      MAX_INPUT_A2DP_FRAME_QUEUE_SZ,
+      BtifA2dpDropPolicyFromProperty(BTIF_A2DP_SINK_DROP_POLICY_PROPERTY,
+                                     BtifA2dpDropPolicy::kOldest),
+      false);
 
   /* Schedule the rest of the operations */
   if (!btif_a2dp_sink_cb.worker_thread.EnableRealTimeScheduling()) {
@@ -328,8 +371,9 @@ static void btif_a2dp_sink_cleanup_delayed() {
   LOG_INFO("%s", __func__);
   LockGuard lock(g_mutex);
 
-  fixed_queue_free(btif_a2dp_sink_cb.rx_audio_queue, nullptr);
-  btif_a2dp_sink_cb.rx_audio_queue = nullptr;
+  btif_a2dp_sink_cb.rx_audio_queue.reset();
+  ringbuffer_free(btif_a2dp_sink_cb.pcm_ring);
+  btif_a2dp_sink_cb.pcm_ring = nullptr;
   btif_a2dp_sink_state = BTIF_A2DP_SINK_STATE_OFF;
 }
 
@@ -453,6 +497,7 @@ static void btif_a2dp_sink_audio_handle_stop_decoding() {
     LockGuard lock(g_mutex);
     btif_a2dp_sink_cb.rx_flush = true;
     btif_a2dp_sink_audio_rx_flush_req();
+    btif_a2dp_sink_pcm_flush();
     old_alarm = btif_a2dp_sink_cb.decode_alarm;
     btif_a2dp_sink_cb.decode_alarm = nullptr;
   }
@@ -498,6 +543,10 @@ static void btif_a2dp_sink_audio_handle_start_decoding() {
   BtifAvrcpAudioTrackStart(btif_a2dp_sink_cb.audio_track);
 #endif
 
+  // The arrival times before the stream was suspended are stale
+  btif_a2dp_sink_cb.jitter.Reset(btif_a2dp_sink_cb.sample_rate);
+  btif_a2dp_sink_cb.playing = false;
+
   btif_a2dp_sink_cb.decode_alarm = alarm_new_periodic("btif.a2dp_sink_decode");
   if (btif_a2dp_sink_cb.decode_alarm == nullptr) {
     LOG_ERROR("%s: unable to allocate decode alarm", __func__);
@@ -507,11 +556,20 @@ static void btif_a2dp_sink_audio_handle_start_decoding() {
             btif_decode_alarm_cb, nullptr);
 }
 
+// Must be called while locked.
 static void btif_a2dp_sink_on_decode_complete(uint8_t* data, uint32_t len) {
-#ifndef OS_GENERIC
-  BtifAvrcpAudioTrackWriteData(btif_a2dp_sink_cb.audio_track,
-                               reinterpret_cast<void*>(data), len);
-#endif
+  ringbuffer_t* pcm_ring = btif_a2dp_sink_cb.pcm_ring;
+  if (pcm_ring == nullptr) return;
+
+  size_t available = ringbuffer_available(pcm_ring);
+  if (len > available) {
+    // Make room by dropping the oldest PCM, in whole frames
+    size_t frame_size = btif_a2dp_sink_cb.pcm_frame_size;
+    size_t excess = (len - available + frame_size - 1) / frame_size;
+    ringbuffer_delete(pcm_ring, excess * frame_size);
+    btif_a2dp_sink_cb.stats.overruns++;
+  }
+  ringbuffer_insert(pcm_ring, data, len);
 }
 
 // Must be called while locked.
@@ -528,12 +586,10 @@ static void btif_a2dp_sink_handle_inc_media(BT_HDR* p_msg) {
   }
 }
 
-static void btif_a2dp_sink_avk_handle_timer() {
-  LockGuard lock(g_mutex);
-
+// Must be called while locked.
+static void btif_a2dp_sink_decode_queue() {
   BT_HDR* p_msg;
-  if (fixed_queue_is_empty(btif_a2dp_sink_cb.rx_audio_queue)) {
-    APPL_TRACE_DEBUG("%s: empty queue", __func__);
+  if (btif_a2dp_sink_cb.rx_audio_queue->IsEmpty()) {
     return;
   }
 
@@ -545,18 +601,18 @@ static void btif_a2dp_sink_avk_handle_timer() {
   }
   /* Play only in BTIF_A2DP_SINK_FOCUS_GRANTED case */
   if (btif_a2dp_sink_cb.rx_flush) {
-    fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+    btif_a2dp_sink_cb.rx_audio_queue->Flush();
     return;
   }
 
   APPL_TRACE_DEBUG("%s: process frames begin", __func__);
   while (true) {
-    p_msg = (BT_HDR*)fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue);
+    p_msg = btif_a2dp_sink_cb.rx_audio_queue->Dequeue();
     if (p_msg == NULL) {
       break;
     }
     APPL_TRACE_DEBUG("%s: number of packets in queue %zu", __func__,
-                     fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue));
+                     btif_a2dp_sink_cb.rx_audio_queue->Length());
 
     /* Queue packet has less frames */
     btif_a2dp_sink_handle_inc_media(p_msg);
@@ -565,6 +621,96 @@ static void btif_a2dp_sink_avk_handle_timer() {
   APPL_TRACE_DEBUG("%s: process frames end", __func__);
 }
 
+// Decodes the received packets as they arrive, ahead of the playback.
+static void btif_a2dp_sink_decode_ahead() {
+  LockGuard lock(g_mutex);
+  btif_a2dp_sink_decode_queue();
+}
+
+// Must be called while locked.
+static void btif_a2dp_sink_pcm_flush() {
+  if (btif_a2dp_sink_cb.pcm_ring != nullptr) {
+    ringbuffer_delete(btif_a2dp_sink_cb.pcm_ring,
+                      ringbuffer_size(btif_a2dp_sink_cb.pcm_ring));
+  }
+  btif_a2dp_sink_cb.playing = false;
+}
+
+// Must be called while locked.
+static uint64_t btif_a2dp_sink_pcm_depth_us() {
+  if (btif_a2dp_sink_cb.pcm_ring == nullptr ||
+      btif_a2dp_sink_cb.sample_rate == 0)
+    return 0;
+  uint64_t frames = ringbuffer_size(btif_a2dp_sink_cb.pcm_ring) /
+                    btif_a2dp_sink_cb.pcm_frame_size;
+  return frames * 1000000 / btif_a2dp_sink_cb.sample_rate;
+}
+
+// Writes one tick of PCM to the audio track, once the jitter buffer reached
+// its target depth. Must be called while locked.
+static void btif_a2dp_sink_pcm_play_tick() {
+  ringbuffer_t* pcm_ring = btif_a2dp_sink_cb.pcm_ring;
+  if (pcm_ring == nullptr) return;
+
+  uint64_t depth_us = btif_a2dp_sink_pcm_depth_us();
+  if (!btif_a2dp_sink_cb.playing) {
+    if (depth_us < btif_a2dp_sink_cb.jitter.TargetDepthUs()) return;
+    btif_a2dp_sink_cb.playing = true;
+    btif_a2dp_sink_cb.jitter.RestartPlayback();
+  }
+
+  size_t frame_size = btif_a2dp_sink_cb.pcm_frame_size;
+  size_t tick_frames = btif_a2dp_sink_cb.tick_frames;
+  size_t frames = ringbuffer_size(pcm_ring) / frame_size;
+  bool repeat_last_frame = false;
+  if (frames < tick_frames) {
+    // Play what is left, then prebuffer again
+    APPL_TRACE_DEBUG("%s: underrun, %zu frames left", __func__, frames);
+    btif_a2dp_sink_cb.stats.underruns++;
+    btif_a2dp_sink_cb.playing = false;
+    tick_frames = frames;
+  } else {
+    // Compensate the drift between the source and the track by a frame
+    int slip = btif_a2dp_sink_cb.jitter.OnPlaybackTick(depth_us);
+    if (slip > 0 && frames > tick_frames) {
+      ringbuffer_delete(pcm_ring, frame_size);
+      btif_a2dp_sink_cb.stats.dropped_frames++;
+    }
+    if (slip < 0 && tick_frames > 1) {
+      tick_frames--;
+      repeat_last_frame = true;
+      btif_a2dp_sink_cb.stats.repeated_frames++;
+    }
+  }
+  if (tick_frames == 0) return;
+
+#ifndef OS_GENERIC
+  // Write the PCM to the track from the ring. Unless the ring is mirrored, it
+  // holds a whole number of frames: no frame is split between the spans.
+  ringbuffer_span_t spans[2];
+  size_t count =
+      ringbuffer_peek_spans(pcm_ring, tick_frames * frame_size, spans);
+  for (size_t i = 0; i < count; i++) {
+    BtifAvrcpAudioTrackWriteData(btif_a2dp_sink_cb.audio_track, spans[i].data,
+                                 spans[i].length);
+  }
+  if (repeat_last_frame) {
+    const ringbuffer_span_t& last = spans[count - 1];
+    BtifAvrcpAudioTrackWriteData(btif_a2dp_sink_cb.audio_track,
+                                 last.data + last.length - frame_size,
+                                 frame_size);
+  }
+#endif
+  ringbuffer_delete(pcm_ring, tick_frames * frame_size);
+}
+
+static void btif_a2dp_sink_avk_handle_timer() {
+  LockGuard lock(g_mutex);
+
+  btif_a2dp_sink_decode_queue();
+  btif_a2dp_sink_pcm_play_tick();
+}
+
 /* when true media task discards any rx frames */
 void btif_a2dp_sink_set_rx_flush(bool enable) {
   LOG_INFO("%s: enable=%s", __func__, (enable) ? "true" : "false");
@@ -577,7 +723,8 @@ static void btif_a2dp_sink_audio_rx_flush_event() {
   LOG_INFO("%s", __func__);
   LockGuard lock(g_mutex);
   // Flush all received encoded audio buffers
-  fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+  btif_a2dp_sink_cb.rx_audio_queue->Flush();
+  btif_a2dp_sink_pcm_flush();
 }
 
 static void btif_a2dp_sink_decoder_update_event(
@@ -610,9 +757,22 @@ static void btif_a2dp_sink_decoder_update_event(
     return;
   }
   btif_a2dp_sink_cb.sample_rate = sample_rate;
+  btif_a2dp_sink_cb.rx_audio_queue->SetSampleRate(sample_rate);
   btif_a2dp_sink_cb.bits_per_sample = bits_per_sample;
   btif_a2dp_sink_cb.channel_count = channel_count;
 
+  // Decode ahead into a ring deep enough for the jitter buffer
+  size_t frame_size = channel_count * (bits_per_sample / 8);
+  size_t ring_frames = sample_rate * BTIF_A2DP_SINK_PCM_RING_MS / 1000;
+  ringbuffer_free(btif_a2dp_sink_cb.pcm_ring);
+  btif_a2dp_sink_cb.pcm_ring =
+      ringbuffer_init_mirrored(ring_frames * frame_size);
+  btif_a2dp_sink_cb.pcm_frame_size = frame_size;
+  btif_a2dp_sink_cb.tick_frames =
+      sample_rate * BTIF_SINK_MEDIA_TIME_TICK_MS / 1000;
+  btif_a2dp_sink_cb.playing = false;
+  btif_a2dp_sink_cb.jitter.Reset(sample_rate);
+
   btif_a2dp_sink_cb.rx_flush = false;
   APPL_TRACE_DEBUG("%s: reset to Sink role", __func__);
 
@@ -648,35 +808,49 @@ static void btif_a2dp_sink_decoder_update_event(
 uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
   LockGuard lock(g_mutex);
   if (btif_a2dp_sink_cb.rx_flush) /* Flush enabled, do not enqueue */
-    return fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
+    return btif_a2dp_sink_cb.rx_audio_queue->Length();
 
-  if (fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
-      MAX_INPUT_A2DP_FRAME_QUEUE_SZ) {
-    uint8_t ret = fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
-    osi_free(fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue));
-    return ret;
-  }
+  // The RTP timestamp is stored ahead of the payload by
+  // bta_av_sink_data_cback().
+  uint32_t timestamp = *reinterpret_cast<uint32_t*>(p_pkt + 1);
+  btif_a2dp_sink_cb.jitter.OnPacket(
+      timestamp, bluetooth::common::time_get_os_boottime_us());
 
   BTIF_TRACE_VERBOSE("%s +", __func__);
-  /* Allocate and queue this buffer */
-  BT_HDR* p_msg =
-      reinterpret_cast<BT_HDR*>(osi_malloc(sizeof(*p_msg) + p_pkt->len));
+  /* Allocate and queue this buffer, the RTP timestamp still ahead of the
+   * payload for the drop policy of the queue */
+  BT_HDR* p_msg = reinterpret_cast<BT_HDR*>(
+      osi_malloc(sizeof(*p_msg) + sizeof(timestamp) + p_pkt->len));
   memcpy(p_msg, p_pkt, sizeof(*p_msg));
-  p_msg->offset = 0;
-  memcpy(p_msg->data, p_pkt->data + p_pkt->offset, p_pkt->len);
-  fixed_queue_enqueue(btif_a2dp_sink_cb.rx_audio_queue, p_msg);
-  if (fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
-      MAX_A2DP_DELAYED_START_FRAME_COUNT) {
+  p_msg->offset = sizeof(timestamp);
+  *reinterpret_cast<uint32_t*>(p_msg + 1) = timestamp;
+  memcpy(p_msg->data + p_msg->offset, p_pkt->data + p_pkt->offset,
+         p_pkt->len);
+  BtifA2dpDropCounts dropped;
+  if (!btif_a2dp_sink_cb.rx_audio_queue->Enqueue(p_msg, &dropped)) {
+    return btif_a2dp_sink_cb.rx_audio_queue->Length();
+  }
+  if (dropped.packets > 0) {
+    BTIF_TRACE_DEBUG("%s: queue full, dropped %zu packets", __func__,
+                     dropped.packets);
+  }
+  uint8_t ret = btif_a2dp_sink_cb.rx_audio_queue->Length();
+
+  // The playback starts once the decoded PCM reaches the jitter buffer depth
+  if (btif_a2dp_sink_cb.decode_alarm == nullptr) {
     BTIF_TRACE_DEBUG("%s: Initiate decoding", __func__);
     btif_a2dp_sink_audio_handle_start_decoding();
   }
+  btif_a2dp_sink_cb.worker_thread.DoInThread(
+      FROM_HERE, base::BindOnce(btif_a2dp_sink_decode_ahead));
 
-  return fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
+  return ret;
 }
 
 void btif_a2dp_sink_audio_rx_flush_req() {
   LOG_INFO("%s", __func__);
-  if (fixed_queue_is_empty(btif_a2dp_sink_cb.rx_audio_queue)) {
+  if (btif_a2dp_sink_cb.rx_audio_queue == nullptr ||
+      btif_a2dp_sink_cb.rx_audio_queue->IsEmpty()) {
     /* Queue is already empty */
     return;
   }
@@ -687,8 +861,48 @@ void btif_a2dp_sink_audio_rx_flush_req() {
       FROM_HERE, base::BindOnce(btif_a2dp_sink_command_ready, p_buf));
 }
 
-void btif_a2dp_sink_debug_dump(UNUSED_ATTR int fd) {
-  // Nothing to do
+void btif_a2dp_sink_debug_dump(int fd) {
+  LockGuard lock(g_mutex);
+  const BtifA2dpSinkJitter& jitter = btif_a2dp_sink_cb.jitter;
+  const BtifA2dpSinkStats& stats = btif_a2dp_sink_cb.stats;
+  int64_t smoothed_depth_us = std::max<int64_t>(jitter.SmoothedDepthUs(), 0);
+
+  dprintf(fd, "\nA2DP Sink State:\n");
+  dprintf(fd, "  %s\n", btif_a2dp_sink_cb.playing ? "Playing" : "Prebuffering");
+
+  BtifA2dpDropCounts drops;
+  const char* drop_policy = "none";
+  if (btif_a2dp_sink_cb.rx_audio_queue != nullptr) {
+    drops = btif_a2dp_sink_cb.rx_audio_queue->drops();
+    drop_policy =
+        BtifA2dpDropPolicyText(btif_a2dp_sink_cb.rx_audio_queue->policy());
+  }
+
+  dprintf(fd,
+          "  Packets since start (received/dropped/resyncs)          : "
+          "%" PRIu64 " / %zu / %" PRIu64 "\n",
+          jitter.packets(), drops.packets, jitter.resyncs());
+
+  dprintf(fd,
+          "  Queue drops (policy/overflows/late)                     : "
+          "%s / %zu / %zu\n",
+          drop_policy, drops.overflows, drops.late_packets);
+
+  dprintf(fd,
+          "  Jitter buffer in ms (jitter/target/smoothed/current)    : "
+          "%" PRIu64 " / %" PRIu64 " / %" PRId64 " / %" PRIu64 "\n",
+          jitter.JitterUs() / 1000, jitter.TargetDepthUs() / 1000,
+          smoothed_depth_us / 1000, btif_a2dp_sink_pcm_depth_us() / 1000);
+
+  dprintf(fd,
+          "  Counts (underruns/overruns)                             : "
+          "%" PRIu64 " / %" PRIu64 "\n",
+          stats.underruns, stats.overruns);
+
+  dprintf(fd,
+          "  Drift compensation frames (dropped/repeated)            : "
+          "%" PRIu64 " / %" PRIu64 "\n",
+          stats.dropped_frames, stats.repeated_frames);
 }
 
 void btif_a2dp_sink_set_focus_state_req(btif_a2dp_sink_focus_state_t state) {
@@ -710,7 +924,8 @@ static void btif_a2dp_sink_set_focus_state_event(
   APPL_TRACE_DEBUG("%s: setting focus state to %d", __func__, state);
   btif_a2dp_sink_cb.rx_focus_state = state;
   if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_NOT_GRANTED) {
-    fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+    btif_a2dp_sink_cb.rx_audio_queue->Flush();
+    btif_a2dp_sink_pcm_flush();
     btif_a2dp_sink_cb.rx_flush = true;
   } else if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_GRANTED) {
     btif_a2dp_sink_cb.rx_flush = false;
@@ -0,0 +1,133 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "btif_a2dp_sink_jitter.h"
+
+#include <algorithm>
+
+// Smoothing of the depth sampled at each playback tick, as a shift: about
+// 32 ticks, 640 ms at 20 ms ticks
+#define BTIF_A2DP_SINK_DEPTH_SMOOTHING_SHIFT 5
+
+// Half width of the target depth band, at least
+#define BTIF_A2DP_SINK_MIN_DEPTH_BAND_US 10000
+
+constexpr uint64_t BtifA2dpSinkJitter::kMinDepthUs;
+constexpr uint64_t BtifA2dpSinkJitter::kMaxDepthUs;
+constexpr uint64_t BtifA2dpSinkJitter::kDefaultDepthUs;
+constexpr uint64_t BtifA2dpSinkJitter::kMarginUs;
+constexpr uint64_t BtifA2dpSinkJitter::kWindowUs;
+
+void BtifA2dpSinkJitter::Reset(uint32_t sample_rate) {
+  sample_rate_ = sample_rate;
+  packets_ = 0;
+  resyncs_ = 0;
+  synced_ = false;
+  last_timestamp_ = 0;
+  media_samples_ = 0;
+  sync_arrival_us_ = 0;
+  last_transit_us_ = 0;
+  jitter_x16_ = 0;
+  window_start_us_ = 0;
+  has_previous_window_ = false;
+  min_transit_us_[0] = min_transit_us_[1] = 0;
+  max_transit_us_[0] = max_transit_us_[1] = 0;
+  smoothed_depth_us_ = -1;
+}
+
+void BtifA2dpSinkJitter::Resync(uint32_t timestamp, uint64_t arrival_us) {
+  synced_ = true;
+  last_timestamp_ = timestamp;
+  media_samples_ = 0;
+  sync_arrival_us_ = arrival_us;
+  last_transit_us_ = 0;
+  window_start_us_ = arrival_us;
+  has_previous_window_ = false;
+  min_transit_us_[0] = max_transit_us_[0] = 0;
+}
+
+void BtifA2dpSinkJitter::OnPacket(uint32_t timestamp, uint64_t arrival_us) {
+  packets_++;
+  if (sample_rate_ == 0) return;
+  if (!synced_) {
+    Resync(timestamp, arrival_us);
+    return;
+  }
+
+  // The RTP timestamps wrap around
+  int32_t delta = static_cast<int32_t>(timestamp - last_timestamp_);
+  if (delta <= 0 || static_cast<uint32_t>(delta) > sample_rate_) {
+    resyncs_++;
+    Resync(timestamp, arrival_us);
+    return;
+  }
+  last_timestamp_ = timestamp;
+  media_samples_ += delta;
+
+  int64_t media_us = media_samples_ * 1000000 / sample_rate_;
+  int64_t transit_us = static_cast<int64_t>(arrival_us) -
+                       static_cast<int64_t>(sync_arrival_us_) - media_us;
+
+  // RFC 3550 section 6.4.1: J += (|D| - J) / 16
+  int64_t d = transit_us - last_transit_us_;
+  last_transit_us_ = transit_us;
+  uint64_t abs_d = d < 0 ? -d : d;
+  jitter_x16_ = jitter_x16_ - (jitter_x16_ >> 4) + abs_d;
+
+  if (arrival_us - window_start_us_ >= kWindowUs) {
+    min_transit_us_[1] = min_transit_us_[0];
+    max_transit_us_[1] = max_transit_us_[0];
+    has_previous_window_ = true;
+    window_start_us_ = arrival_us;
+    min_transit_us_[0] = max_transit_us_[0] = transit_us;
+  } else {
+    min_transit_us_[0] = std::min(min_transit_us_[0], transit_us);
+    max_transit_us_[0] = std::max(max_transit_us_[0], transit_us);
+  }
+}
+
+uint64_t BtifA2dpSinkJitter::TargetDepthUs() const {
+  if (!synced_) return kDefaultDepthUs;
+
+  int64_t min_transit_us = min_transit_us_[0];
+  int64_t max_transit_us = max_transit_us_[0];
+  if (has_previous_window_) {
+    min_transit_us = std::min(min_transit_us, min_transit_us_[1]);
+    max_transit_us = std::max(max_transit_us, max_transit_us_[1]);
+  }
+  uint64_t depth_us = max_transit_us - min_transit_us + kMarginUs;
+
+  // Until a whole window was seen, the spread may be underestimated
+  if (!has_previous_window_) depth_us = std::max(depth_us, kDefaultDepthUs);
+  return std::min(std::max(depth_us, kMinDepthUs), kMaxDepthUs);
+}
+
+int BtifA2dpSinkJitter::OnPlaybackTick(uint64_t depth_us) {
+  int64_t depth = static_cast<int64_t>(depth_us);
+  if (smoothed_depth_us_ < 0) {
+    smoothed_depth_us_ = depth;
+  } else {
+    smoothed_depth_us_ +=
+        (depth - smoothed_depth_us_) >> BTIF_A2DP_SINK_DEPTH_SMOOTHING_SHIFT;
+  }
+
+  int64_t target_us = TargetDepthUs();
+  int64_t band_us =
+      std::max<int64_t>(BTIF_A2DP_SINK_MIN_DEPTH_BAND_US, target_us / 4);
+  if (smoothed_depth_us_ > target_us + band_us) return 1;
+  if (smoothed_depth_us_ < target_us - band_us) return -1;
+  return 0;
+}
@@ -28,6 +28,10 @@
 #include <limits.h>
 #include <string.h>
 #include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
 
 #include "audio_a2dp_hw/include/audio_a2dp_hw.h"
 #include "audio_hal_interface/a2dp_encoding.h"
@@ -36,33 +40,32 @@
 #include "btif_a2dp.h"
 #include "btif_a2dp_audio_interface.h"
 #include "btif_a2dp_control.h"
+#include "btif_a2dp_media_queue.h"
 #include "btif_a2dp_source.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
+#include "btif_bqr.h"
 #include "btif_util.h"
 #include "common/message_loop_thread.h"
 #include "common/metrics.h"
-#include "common/repeating_timer.h"
 #include "common/time_util.h"
-#include "osi/include/fixed_queue.h"
+#include "common/timerfd_repeating_timer.h"
+#include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
+#include "osi/include/slab_allocator.h"
 #include "osi/include/wakelock.h"
 #include "uipc.h"
 
+using bluetooth::audio::PcmConverter;
+using bluetooth::audio::PcmFormat;
 using bluetooth::common::A2dpSessionMetrics;
 using bluetooth::common::BluetoothMetricsLogger;
-using bluetooth::common::RepeatingTimer;
+using bluetooth::common::TimerFdRepeatingTimer;
 
 extern std::unique_ptr<tUIPC_STATE> a2dp_uipc;
 
-/**
- * The typical runlevel of the tx queue size is ~1 buffer
- * but due to link flow control or thread preemption in lower
- * layers we might need to temporarily buffer up data.
- */
-#define MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ (MAX_PCM_FRAME_NUM_PER_TICK * 2)
-
 class SchedulingStats {
  public:
   SchedulingStats() { Reset(); }
@@ -77,6 +80,9 @@ class SchedulingStats {
     max_premature_scheduling_delta_us = 0;
     exact_scheduling_count = 0;
     total_scheduling_time_us = 0;
+    tick_error_count = 0;
+    total_tick_error_us = 0;
+    max_tick_error_us = 0;
   }
 
   // Counter for total updates
@@ -108,6 +114,15 @@ class SchedulingStats {
 
   // Accumulated and counted scheduling time (in us)
   uint64_t total_scheduling_time_us;
+
+  // Counter for the ticks with a known due time
+  size_t tick_error_count;
+
+  // Accumulated delays of the ticks after their due time (in us)
+  uint64_t total_tick_error_us;
+
+  // Max. delay of a tick after its due time (in us)
+  uint64_t max_tick_error_us;
 };
 
 class BtifMediaStats {
@@ -128,6 +143,7 @@ class BtifMediaStats {
     tx_queue_last_flushed_us = 0;
     tx_queue_total_dropped_messages = 0;
     tx_queue_max_dropped_messages = 0;
+    tx_queue_total_late_messages = 0;
     tx_queue_dropouts = 0;
     tx_queue_last_dropouts_us = 0;
     media_read_total_underflow_bytes = 0;
@@ -156,6 +172,7 @@ class BtifMediaStats {
 
   size_t tx_queue_total_dropped_messages;
   size_t tx_queue_max_dropped_messages;
+  size_t tx_queue_total_late_messages;
   size_t tx_queue_dropouts;
   uint64_t tx_queue_last_dropouts_us;
 
@@ -166,6 +183,45 @@ class BtifMediaStats {
   int codec_index = -1;
 };
 
+// The stream to one peer. The media task, the encoder and the audio feeding
+// are shared by all the sessions, each session has its own TX queue and
+// statistics.
+// Media buffers per session: a full TX queue, plus as many packets waiting in
+// AVDTP, L2CAP and the controller.
+#define A2DP_MEDIA_BUFFER_POOL_SZ (MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ * 2)
+
+// Rise of the retransmission count between two Link Quality reports of the
+// active peer above which the link is reported congested to the encoder.
+#define A2DP_BQR_RETRANSMISSION_RISE_THRESHOLD 16
+
+// What the TX queue drops when full, see BtifA2dpDropPolicy
+#define BTIF_A2DP_SOURCE_DROP_POLICY_PROPERTY \
+  "persist.bluetooth.a2dp_source.drop_policy"
+
+class BtifA2dpSourceSession {
+ public:
+  BtifA2dpSourceSession(const RawAddress& peer_address,
+                        BtifA2dpDropPolicy drop_policy)
+      : peer_address(peer_address),
+        // The queue drops packets rather than grow beyond
+        // MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ, so a bounded lock-free queue avoids
+        // the mutex and semaphores on every audio packet.
+        tx_audio_queue(MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ, drop_policy, true),
+        media_buffer_pool(osi_pool_new(BT_DEFAULT_BUFFER_SIZE,
+                                       A2DP_MEDIA_BUFFER_POOL_SZ)) {}
+
+  ~BtifA2dpSourceSession() {
+    // The buffers still owned by the lower layers go back to the heap
+    osi_pool_free(media_buffer_pool);
+  }
+
+  const RawAddress peer_address;
+  BtifA2dpMediaQueue tx_audio_queue;
+  // Encoded audio packets, recycled once L2CAP is done with them
+  slab_pool_t* const media_buffer_pool;
+  BtifMediaStats stats;
+};
+
 class BtifA2dpSource {
  public:
   enum RunState {
@@ -176,25 +232,65 @@ class BtifA2dpSource {
   };
 
   BtifA2dpSource()
-      : tx_audio_queue(nullptr),
-        tx_flush(false),
+      : tx_flush(false),
         encoder_interface(nullptr),
         encoder_interval_ms(0),
+        audio_input_format{},
+        tx_drop_policy(BtifA2dpDropPolicy::kFlush),
+        pcm_bytes_pending(0),
+        pcm_bytes_sent(0),
         state_(kStateOff) {}
 
   void Reset() {
-    fixed_queue_free(tx_audio_queue, nullptr);
-    tx_audio_queue = nullptr;
     tx_flush = false;
     media_alarm.CancelAndWait();
     wakelock_release();
     encoder_interface = nullptr;
     encoder_interval_ms = 0;
-    stats.Reset();
+    audio_input_format = {};
+    tx_drop_policy = BtifA2dpDropPolicy::kFlush;
+    pcm_converter = PcmConverter();
+    pcm_read_buffer.clear();
+    pcm_bytes_pending = 0;
     accumulated_stats.Reset();
+    ClearSessions();
     state_ = kStateOff;
   }
 
+  // Get the session of |peer_address|, it is created on first use.
+  std::shared_ptr<BtifA2dpSourceSession> Session(
+      const RawAddress& peer_address) {
+    auto& session = sessions_[peer_address];
+    if (session == nullptr) {
+      session =
+          std::make_shared<BtifA2dpSourceSession>(peer_address, tx_drop_policy);
+    }
+    return session;
+  }
+
+  // Get the session the encoded audio is queued to, or nullptr when there is
+  // none. The TX queue of the active session is read from the BTA thread,
+  // which holds on to the returned reference while it reads: a session that
+  // is erased or replaced meanwhile is freed by whoever lets go of it last.
+  std::shared_ptr<BtifA2dpSourceSession> ActiveSession() const {
+    return std::atomic_load(&active_session_);
+  }
+  void SetActiveSession(std::shared_ptr<BtifA2dpSourceSession> session) {
+    std::atomic_store(&active_session_, std::move(session));
+  }
+
+  const std::map<RawAddress, std::shared_ptr<BtifA2dpSourceSession>>&
+  Sessions() const {
+    return sessions_;
+  }
+  void EraseSession(const RawAddress& peer_address) {
+    sessions_.erase(peer_address);
+  }
+  void ClearSessions() {
+    SetActiveSession(nullptr);
+    sessions_.clear();
+  }
+
   BtifA2dpSource::RunState State() const { return state_; }
   std::string StateStr() const {
     switch (state_) {
@@ -211,15 +307,30 @@ class BtifA2dpSource {
 
   void SetState(BtifA2dpSource::RunState state) { state_ = state; }
 
-  fixed_queue_t* tx_audio_queue;
   bool tx_flush; /* Discards any outgoing data when true */
-  RepeatingTimer media_alarm;
+  TimerFdRepeatingTimer media_alarm;
   const tA2DP_ENCODER_INTERFACE* encoder_interface;
   uint64_t encoder_interval_ms; /* Local copy of the encoder interval */
-  BtifMediaStats stats;
+  // Format of the audio read, if set, and its conversion to the encoder
+  // format. The read buffer keeps its capacity from one read to the next.
+  PcmFormat audio_input_format;
+  PcmConverter pcm_converter;
+  std::vector<uint8_t> pcm_read_buffer;
   BtifMediaStats accumulated_stats;
+  // What the TX queues of the sessions drop when full
+  BtifA2dpDropPolicy tx_drop_policy;
+  // Bytes read from the audio HAL since the last packet was enqueued. Each
+  // packet carries the bytes read for it in BT_HDR::event, which the media
+  // path does not use otherwise.
+  uint32_t pcm_bytes_pending;
+  // Bytes read from the audio HAL for the packets handed to the BTA thread
+  // since startup. Never reset, read from the audio HAL threads.
+  std::atomic<uint64_t> pcm_bytes_sent;
 
  private:
+  std::map<RawAddress, std::shared_ptr<BtifA2dpSourceSession>> sessions_;
+  // Only accessed with std::atomic_load() and std::atomic_store()
+  std::shared_ptr<BtifA2dpSourceSession> active_session_;
   BtifA2dpSource::RunState state_;
 };
 
@@ -250,21 +361,34 @@ static void btif_a2dp_source_encoder_user_config_update_event(
     std::promise<void> peer_ready_promise);
 static void btif_a2dp_source_audio_feeding_update_event(
     const btav_a2dp_codec_config_t& codec_audio_config);
+static void btif_a2dp_source_audio_input_format_event(
+    const PcmFormat& input_format);
+static void btif_a2dp_source_setup_pcm_converter(
+    A2dpCodecConfig* a2dp_codec_config);
 static bool btif_a2dp_source_audio_tx_flush_req(void);
+static void btif_a2dp_source_link_congestion_event(void);
 static void btif_a2dp_source_audio_handle_timer(void);
 static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len);
 static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
                                               uint32_t bytes_read);
-static void log_tstamps_us(const char* comment, uint64_t timestamp_us);
+static BT_HDR* btif_a2dp_source_alloc_callback(size_t size);
+static void log_tstamps_us(const char* comment, uint64_t timestamp_us,
+                           size_t queue_length);
 static void update_scheduling_stats(SchedulingStats* stats, uint64_t now_us,
                                     uint64_t expected_delta);
+static void update_tick_error_stats(SchedulingStats* stats, uint64_t now_us,
+                                    uint64_t due_us);
 // Update the A2DP Source related metrics.
 // This function should be called before collecting the metrics.
-static void btif_a2dp_source_update_metrics(void);
+static void btif_a2dp_source_update_metrics(const BtifMediaStats& stats);
 static void btm_read_rssi_cb(void* data);
 static void btm_read_failed_contact_counter_cb(void* data);
 static void btm_read_automatic_flush_timeout_cb(void* data);
 static void btm_read_tx_power_cb(void* data);
+static void btif_a2dp_source_link_quality_event(
+    const bluetooth::bqr::BqrLinkQualityEventView& event);
+
+static int btif_a2dp_source_link_quality_observer_id = 0;
 
 void btif_a2dp_source_accumulate_scheduling_stats(SchedulingStats* src,
                                                   SchedulingStats* dst) {
@@ -284,6 +408,10 @@ void btif_a2dp_source_accumulate_scheduling_stats(SchedulingStats* src,
                src->max_premature_scheduling_delta_us);
   dst->exact_scheduling_count += src->exact_scheduling_count;
   dst->total_scheduling_time_us += src->total_scheduling_time_us;
+  dst->tick_error_count += src->tick_error_count;
+  dst->total_tick_error_us += src->total_tick_error_us;
+  dst->max_tick_error_us =
+      std::max(dst->max_tick_error_us, src->max_tick_error_us);
 }
 
 void btif_a2dp_source_accumulate_stats(BtifMediaStats* src,
@@ -301,6 +429,7 @@ void btif_a2dp_source_accumulate_stats(BtifMediaStats* src,
   dst->tx_queue_total_dropped_messages += src->tx_queue_total_dropped_messages;
   dst->tx_queue_max_dropped_messages = std::max(
       dst->tx_queue_max_dropped_messages, src->tx_queue_max_dropped_messages);
+  dst->tx_queue_total_late_messages += src->tx_queue_total_late_messages;
   dst->tx_queue_dropouts += src->tx_queue_dropouts;
   dst->tx_queue_last_dropouts_us = src->tx_queue_last_dropouts_us;
   dst->media_read_total_underflow_bytes +=
@@ -340,8 +469,12 @@ bool btif_a2dp_source_startup(void) {
   }
 
   btif_a2dp_source_cb.Reset();
+  btif_a2dp_source_cb.tx_drop_policy = BtifA2dpDropPolicyFromProperty(
+      BTIF_A2DP_SOURCE_DROP_POLICY_PROPERTY, BtifA2dpDropPolicy::kFlush);
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateStartingUp);
-  btif_a2dp_source_cb.tx_audio_queue = fixed_queue_new(SIZE_MAX);
+  btif_a2dp_source_link_quality_observer_id =
+      bluetooth::bqr::RegisterLinkQualityObserver(
+          &btif_a2dp_source_link_quality_event);
 
   // Schedule the rest of the operations
   btif_a2dp_source_thread.DoInThread(
@@ -352,8 +485,9 @@ bool btif_a2dp_source_startup(void) {
 
 static void btif_a2dp_source_startup_delayed() {
   LOG_INFO("%s: state=%s", __func__, btif_a2dp_source_cb.StateStr().c_str());
-  if (!btif_a2dp_source_thread.EnableRealTimeScheduling()) {
-    LOG(FATAL) << __func__ << ": unable to enable real time scheduling";
+  if (!btif_a2dp_source_thread.ApplyThreadRole(
+          bluetooth::common::ThreadRole::AUDIO_TX)) {
+    LOG(FATAL) << __func__ << ": unable to apply the audio TX thread profile";
   }
   if (!bluetooth::audio::a2dp::init(&btif_a2dp_source_thread)) {
     if (btif_av_is_a2dp_offload_enabled()) {
@@ -463,6 +597,11 @@ static void btif_a2dp_source_end_session_delayed(
   } else {
     LOG_ERROR("%s: A2DP Source media task is not running", __func__);
   }
+  auto session = btif_a2dp_source_cb.Sessions().find(peer_address);
+  if (session != btif_a2dp_source_cb.Sessions().end() &&
+      session->second != btif_a2dp_source_cb.ActiveSession()) {
+    btif_a2dp_source_cb.EraseSession(peer_address);
+  }
   if (bluetooth::audio::a2dp::is_hal_2_0_enabled()) {
     bluetooth::audio::a2dp::end_session();
     BluetoothMetricsLogger::GetInstance()->LogBluetoothSessionEnd(
@@ -486,6 +625,9 @@ void btif_a2dp_source_shutdown(void) {
 
   /* Make sure no channels are restarted while shutting down */
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateShuttingDown);
+  bluetooth::bqr::UnregisterLinkQualityObserver(
+      btif_a2dp_source_link_quality_observer_id);
+  btif_a2dp_source_link_quality_observer_id = 0;
 
   btif_a2dp_source_thread.DoInThread(
       FROM_HERE, base::Bind(&btif_a2dp_source_shutdown_delayed));
@@ -506,8 +648,7 @@ static void btif_a2dp_source_shutdown_delayed(void) {
   } else {
     btif_a2dp_control_cleanup();
   }
-  fixed_queue_free(btif_a2dp_source_cb.tx_audio_queue, nullptr);
-  btif_a2dp_source_cb.tx_audio_queue = nullptr;
+  btif_a2dp_source_cb.ClearSessions();
 
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateOff);
 }
@@ -571,6 +712,8 @@ static void btif_a2dp_source_setup_codec_delayed(
               peer_address.ToString().c_str());
     return;
   }
+  btif_a2dp_source_cb.SetActiveSession(
+      btif_a2dp_source_cb.Session(peer_address));
   btif_a2dp_source_cb.encoder_interface = bta_av_co_get_encoder_interface();
   if (btif_a2dp_source_cb.encoder_interface == nullptr) {
     LOG_ERROR("%s: Cannot stream audio: no source encoder interface", __func__);
@@ -585,12 +728,17 @@ static void btif_a2dp_source_setup_codec_delayed(
 
   btif_a2dp_source_cb.encoder_interface->encoder_init(
       &peer_params, a2dp_codec_config, btif_a2dp_source_read_callback,
-      btif_a2dp_source_enqueue_callback);
+      btif_a2dp_source_enqueue_callback, btif_a2dp_source_alloc_callback);
 
   // Save a local copy of the encoder_interval_ms
   btif_a2dp_source_cb.encoder_interval_ms =
       btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms();
 
+  btif_a2dp_source_setup_pcm_converter(a2dp_codec_config);
+  // The encoders count the RTP timestamps in samples of the encoded audio
+  btif_a2dp_source_cb.ActiveSession()->tx_audio_queue.SetSampleRate(
+      btif_a2dp_source_cb.pcm_converter.output().sample_rate);
+
   if (bluetooth::audio::a2dp::is_hal_2_0_enabled()) {
     bluetooth::audio::a2dp::setup_codec();
   }
@@ -682,6 +830,65 @@ static void btif_a2dp_source_audio_feeding_update_event(
   }
 }
 
+void btif_a2dp_source_set_audio_input_format(const PcmFormat& input_format) {
+  LOG_INFO("%s: sample_rate=%u bits_per_sample=%u channel_count=%u", __func__,
+           input_format.sample_rate, input_format.bits_per_sample,
+           input_format.channel_count);
+  btif_a2dp_source_thread.DoInThread(
+      FROM_HERE,
+      base::Bind(&btif_a2dp_source_audio_input_format_event, input_format));
+}
+
+static void btif_a2dp_source_audio_input_format_event(
+    const PcmFormat& input_format) {
+  btif_a2dp_source_cb.audio_input_format = input_format;
+
+  // Applied to the current encoder, if any, or when it is set up
+  if (btif_a2dp_source_cb.encoder_interface == nullptr) return;
+  A2dpCodecConfig* a2dp_codec_config = bta_av_get_a2dp_current_codec();
+  if (a2dp_codec_config != nullptr) {
+    btif_a2dp_source_setup_pcm_converter(a2dp_codec_config);
+  }
+}
+
+// Set the audio conversion up for the encoder of |a2dp_codec_config|.
+static void btif_a2dp_source_setup_pcm_converter(
+    A2dpCodecConfig* a2dp_codec_config) {
+  uint8_t codec_info[AVDT_CODEC_SIZE];
+  if (!a2dp_codec_config->copyOutOtaCodecConfig(codec_info)) {
+    LOG_ERROR("%s: cannot get the codec config", __func__);
+    return;
+  }
+
+  PcmFormat encoder_format = {
+      static_cast<uint32_t>(A2DP_GetTrackSampleRate(codec_info)),
+      static_cast<uint8_t>(A2DP_GetTrackBitsPerSample(codec_info)),
+      static_cast<uint8_t>(A2DP_GetTrackChannelCount(codec_info))};
+  PcmFormat input_format = btif_a2dp_source_cb.audio_input_format;
+  if (input_format.sample_rate == 0) input_format = encoder_format;
+
+  PcmConverter& converter = btif_a2dp_source_cb.pcm_converter;
+  if (!converter.Init(input_format, encoder_format)) {
+    LOG_ERROR(
+        "%s: cannot convert from %u Hz %u bits %u channels to %u Hz %u bits "
+        "%u channels, the audio is not converted",
+        __func__, input_format.sample_rate, input_format.bits_per_sample,
+        input_format.channel_count, encoder_format.sample_rate,
+        encoder_format.bits_per_sample, encoder_format.channel_count);
+    converter.Init(encoder_format, encoder_format);
+    return;
+  }
+
+  if (!converter.IsPassThrough()) {
+    LOG_INFO(
+        "%s: converting from %u Hz %u bits %u channels to %u Hz %u bits %u "
+        "channels",
+        __func__, input_format.sample_rate, input_format.bits_per_sample,
+        input_format.channel_count, encoder_format.sample_rate,
+        encoder_format.bits_per_sample, encoder_format.channel_count);
+  }
+}
+
 void btif_a2dp_source_on_idle(void) {
   LOG_INFO("%s: state=%s", __func__, btif_a2dp_source_cb.StateStr().c_str());
   if (btif_a2dp_source_cb.State() == BtifA2dpSource::kStateOff) return;
@@ -775,7 +982,11 @@ static void btif_a2dp_source_audio_tx_start_event(void) {
 
   /* Reset the media feeding state */
   CHECK(btif_a2dp_source_cb.encoder_interface != nullptr);
+  std::shared_ptr<BtifA2dpSourceSession> session =
+      btif_a2dp_source_cb.ActiveSession();
+  CHECK(session != nullptr);
   btif_a2dp_source_cb.encoder_interface->feeding_reset();
+  btif_a2dp_source_cb.pcm_converter.Reset();
 
   APPL_TRACE_EVENT(
       "%s: starting timer %" PRIu64 " ms", __func__,
@@ -791,19 +1002,19 @@ static void btif_a2dp_source_audio_tx_start_event(void) {
       base::TimeDelta::FromMilliseconds(
           btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms()));
 
-  btif_a2dp_source_cb.stats.Reset();
+  session->stats.Reset();
   // Assign session_start_us to 1 when
   // bluetooth::common::time_get_os_boottime_us() is 0 to indicate
   // btif_a2dp_source_start_audio_req() has been called
-  btif_a2dp_source_cb.stats.session_start_us =
+  session->stats.session_start_us =
       bluetooth::common::time_get_os_boottime_us();
-  if (btif_a2dp_source_cb.stats.session_start_us == 0) {
-    btif_a2dp_source_cb.stats.session_start_us = 1;
+  if (session->stats.session_start_us == 0) {
+    session->stats.session_start_us = 1;
   }
-  btif_a2dp_source_cb.stats.session_end_us = 0;
+  session->stats.session_end_us = 0;
   A2dpCodecConfig* codec_config = bta_av_get_a2dp_current_codec();
   if (codec_config != nullptr) {
-    btif_a2dp_source_cb.stats.codec_index = codec_config->codecIndex();
+    session->stats.codec_index = codec_config->codecIndex();
   }
 }
 
@@ -816,11 +1027,15 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
 
   if (btif_av_is_a2dp_offload_running()) return;
 
-  btif_a2dp_source_cb.stats.session_end_us =
-      bluetooth::common::time_get_os_boottime_us();
-  btif_a2dp_source_update_metrics();
-  btif_a2dp_source_accumulate_stats(&btif_a2dp_source_cb.stats,
-                                    &btif_a2dp_source_cb.accumulated_stats);
+  std::shared_ptr<BtifA2dpSourceSession> session =
+      btif_a2dp_source_cb.ActiveSession();
+  if (session != nullptr) {
+    session->stats.session_end_us =
+        bluetooth::common::time_get_os_boottime_us();
+    btif_a2dp_source_update_metrics(session->stats);
+    btif_a2dp_source_accumulate_stats(&session->stats,
+                                      &btif_a2dp_source_cb.accumulated_stats);
+  }
 
   uint8_t p_buf[AUDIO_STREAM_OUTPUT_BUFFER_SZ * 2];
   uint16_t event;
@@ -871,15 +1086,17 @@ static void btif_a2dp_source_audio_handle_timer(void) {
   if (btif_av_is_a2dp_offload_running()) return;
 
   uint64_t timestamp_us = bluetooth::common::time_get_os_boottime_us();
-  log_tstamps_us("A2DP Source tx timer", timestamp_us);
+  std::shared_ptr<BtifA2dpSourceSession> session =
+      btif_a2dp_source_cb.ActiveSession();
+  CHECK(session != nullptr);
+  size_t transmit_queue_length = session->tx_audio_queue.Length();
+  log_tstamps_us("A2DP Source tx timer", timestamp_us, transmit_queue_length);
 
   if (!btif_a2dp_source_cb.media_alarm.IsScheduled()) {
     LOG_ERROR("%s: ERROR Media task Scheduled after Suspend", __func__);
     return;
   }
   CHECK(btif_a2dp_source_cb.encoder_interface != nullptr);
-  size_t transmit_queue_length =
-      fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
 #ifndef OS_GENERIC
   ATRACE_INT("btif TX queue", transmit_queue_length);
 #endif
@@ -890,12 +1107,15 @@ static void btif_a2dp_source_audio_handle_timer(void) {
   }
   btif_a2dp_source_cb.encoder_interface->send_frames(timestamp_us);
   bta_av_ci_src_data_ready(BTA_AV_CHNL_AUDIO);
-  update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_enqueue_stats,
-                          timestamp_us,
+  update_scheduling_stats(&session->stats.tx_queue_enqueue_stats, timestamp_us,
                           btif_a2dp_source_cb.encoder_interval_ms * 1000);
+  update_tick_error_stats(
+      &session->stats.tx_queue_enqueue_stats, timestamp_us,
+      btif_a2dp_source_cb.media_alarm.GetExpectedTimeCurrentTaskUs());
 }
 
-static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
+// Read |len| bytes of audio from the audio HAL
+static uint32_t btif_a2dp_source_read_audio(uint8_t* p_buf, uint32_t len) {
   uint16_t event;
   uint32_t bytes_read = 0;
 
@@ -904,23 +1124,63 @@ static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
   } else if (a2dp_uipc != nullptr) {
     bytes_read = UIPC_Read(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, &event, p_buf, len);
   }
+  btif_a2dp_source_cb.pcm_bytes_pending += bytes_read;
+  return bytes_read;
+}
+
+// Read the audio needed for |len| bytes in the encoder format, and convert
+// it into |p_buf|
+static uint32_t btif_a2dp_source_read_converted(uint8_t* p_buf, uint32_t len) {
+  PcmConverter& converter = btif_a2dp_source_cb.pcm_converter;
+  size_t input_frame_size = converter.input().FrameSize();
+  size_t output_frame_size = converter.output().FrameSize();
+  size_t output_frames = len / output_frame_size;
+
+  std::vector<uint8_t>& buffer = btif_a2dp_source_cb.pcm_read_buffer;
+  buffer.resize(converter.InputFramesNeeded(output_frames) * input_frame_size);
+  uint32_t bytes_read = 0;
+  if (!buffer.empty()) {
+    bytes_read = btif_a2dp_source_read_audio(buffer.data(), buffer.size());
+  }
+
+  size_t frames = converter.Convert(
+      buffer.data(), bytes_read / input_frame_size, p_buf, output_frames);
+  return frames * output_frame_size;
+}
+
+static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
+  uint32_t bytes_read;
+  if (btif_a2dp_source_cb.pcm_converter.IsPassThrough()) {
+    bytes_read = btif_a2dp_source_read_audio(p_buf, len);
+  } else {
+    bytes_read = btif_a2dp_source_read_converted(p_buf, len);
+  }
 
   if (bytes_read < len) {
     LOG_WARN("%s: UNDERFLOW: ONLY READ %d BYTES OUT OF %d", __func__,
              bytes_read, len);
-    btif_a2dp_source_cb.stats.media_read_total_underflow_bytes +=
-        (len - bytes_read);
-    btif_a2dp_source_cb.stats.media_read_total_underflow_count++;
-    btif_a2dp_source_cb.stats.media_read_last_underflow_us =
+    std::shared_ptr<BtifA2dpSourceSession> session =
+        btif_a2dp_source_cb.ActiveSession();
+    CHECK(session != nullptr);
+    session->stats.media_read_total_underflow_bytes += (len - bytes_read);
+    session->stats.media_read_total_underflow_count++;
+    session->stats.media_read_last_underflow_us =
         bluetooth::common::time_get_os_boottime_us();
     bluetooth::common::LogA2dpAudioUnderrunEvent(
-        btif_av_source_active_peer(), btif_a2dp_source_cb.encoder_interval_ms,
+        session->peer_address, btif_a2dp_source_cb.encoder_interval_ms,
         len - bytes_read);
   }
 
   return bytes_read;
 }
 
+static BT_HDR* btif_a2dp_source_alloc_callback(size_t size) {
+  std::shared_ptr<BtifA2dpSourceSession> session =
+      btif_a2dp_source_cb.ActiveSession();
+  CHECK(session != nullptr);
+  return (BT_HDR*)osi_malloc_from_pool(session->media_buffer_pool, size);
+}
+
 static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
                                               uint32_t bytes_read) {
   uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
@@ -932,54 +1192,56 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     return false;
   }
 
+  std::shared_ptr<BtifA2dpSourceSession> session =
+      btif_a2dp_source_cb.ActiveSession();
+  CHECK(session != nullptr);
+  BtifA2dpMediaQueue& tx_audio_queue = session->tx_audio_queue;
+
   /* Check if the transmission queue has been flushed */
   if (btif_a2dp_source_cb.tx_flush) {
     LOG_VERBOSE("%s: tx suspended, discarded frame", __func__);
 
-    btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
-        fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
-    btif_a2dp_source_cb.stats.tx_queue_last_flushed_us = now_us;
-    fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+    session->stats.tx_queue_total_flushed_messages += tx_audio_queue.Flush();
+    session->stats.tx_queue_last_flushed_us = now_us;
 
     osi_free(p_buf);
     return false;
   }
 
-  // Check for TX queue overflow
-  // TODO: Using frames_n here is probably wrong: should be "+ 1" instead.
-  if (fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue) + frames_n >
-      MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ) {
-    LOG_WARN("%s: TX queue buffer size now=%u adding=%u max=%d", __func__,
-             (uint32_t)fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue),
-             (uint32_t)frames_n, MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ);
+  /* Update the statistics */
+  session->stats.tx_queue_total_frames += frames_n;
+  session->stats.tx_queue_max_frames_per_packet =
+      std::max(frames_n, session->stats.tx_queue_max_frames_per_packet);
+  CHECK(btif_a2dp_source_cb.encoder_interface != nullptr);
+
+  // Bytes past what BT_HDR::event holds are left to the next packet
+  uint32_t pcm_bytes =
+      std::min<uint32_t>(btif_a2dp_source_cb.pcm_bytes_pending, UINT16_MAX);
+  btif_a2dp_source_cb.pcm_bytes_pending -= pcm_bytes;
+  p_buf->event = pcm_bytes;
+
+  // Make room per the drop policy of the queue if it is full
+  BtifA2dpDropCounts dropped;
+  bool enqueued = tx_audio_queue.Enqueue(p_buf, &dropped);
+  if (dropped.overflows > 0) {
+    LOG_WARN("%s: TX queue full at %zu, %s dropped %zu packets", __func__,
+             tx_audio_queue.Capacity(),
+             BtifA2dpDropPolicyText(tx_audio_queue.policy()), dropped.packets);
     // Keep track of drop-outs
-    btif_a2dp_source_cb.stats.tx_queue_dropouts++;
-    btif_a2dp_source_cb.stats.tx_queue_last_dropouts_us = now_us;
-
-    // Flush all queued buffers
-    size_t drop_n = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
-    btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages = std::max(
-        drop_n, btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages);
-    int num_dropped_encoded_bytes = 0;
-    int num_dropped_encoded_frames = 0;
-    while (fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue)) {
-      btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages++;
-      void* p_data =
-          fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
-      if (p_data != nullptr) {
-        auto p_dropped_buf = static_cast<BT_HDR*>(p_data);
-        num_dropped_encoded_bytes += p_dropped_buf->len;
-        num_dropped_encoded_frames += p_dropped_buf->layer_specific;
-        osi_free(p_data);
-      }
-    }
+    session->stats.tx_queue_dropouts++;
+    session->stats.tx_queue_last_dropouts_us = now_us;
+    session->stats.tx_queue_total_dropped_messages += dropped.packets;
+    session->stats.tx_queue_total_late_messages += dropped.late_packets;
+    session->stats.tx_queue_max_dropped_messages = std::max(
+        dropped.packets, session->stats.tx_queue_max_dropped_messages);
     bluetooth::common::LogA2dpAudioOverrunEvent(
-        btif_av_source_active_peer(), drop_n,
-        btif_a2dp_source_cb.encoder_interval_ms, num_dropped_encoded_frames,
-        num_dropped_encoded_bytes);
+        session->peer_address, dropped.packets,
+        btif_a2dp_source_cb.encoder_interval_ms, dropped.frames, dropped.bytes);
+
+    btif_a2dp_source_link_congestion_event();
 
-    // Request additional debug info if we had to flush buffers
-    RawAddress peer_bda = btif_av_source_active_peer();
+    // Request additional debug info if we had to drop buffers
+    const RawAddress& peer_bda = session->peer_address;
     tBTM_STATUS status = BTM_ReadRSSI(peer_bda, btm_read_rssi_cb);
     if (status != BTM_CMD_STARTED) {
       LOG_WARN("%s: Cannot read RSSI: status %d", __func__, status);
@@ -1003,15 +1265,7 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     }
   }
 
-  /* Update the statistics */
-  btif_a2dp_source_cb.stats.tx_queue_total_frames += frames_n;
-  btif_a2dp_source_cb.stats.tx_queue_max_frames_per_packet = std::max(
-      frames_n, btif_a2dp_source_cb.stats.tx_queue_max_frames_per_packet);
-  CHECK(btif_a2dp_source_cb.encoder_interface != nullptr);
-
-  fixed_queue_enqueue(btif_a2dp_source_cb.tx_audio_queue, p_buf);
-
-  return true;
+  return enqueued;
 }
 
 static void btif_a2dp_source_audio_tx_flush_event(void) {
@@ -1022,11 +1276,14 @@ static void btif_a2dp_source_audio_tx_flush_event(void) {
   if (btif_a2dp_source_cb.encoder_interface != nullptr)
     btif_a2dp_source_cb.encoder_interface->feeding_flush();
 
-  btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
-      fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
-  btif_a2dp_source_cb.stats.tx_queue_last_flushed_us =
-      bluetooth::common::time_get_os_boottime_us();
-  fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+  std::shared_ptr<BtifA2dpSourceSession> session =
+      btif_a2dp_source_cb.ActiveSession();
+  if (session != nullptr) {
+    session->stats.tx_queue_total_flushed_messages +=
+        session->tx_audio_queue.Flush();
+    session->stats.tx_queue_last_flushed_us =
+        bluetooth::common::time_get_os_boottime_us();
+  }
 
   if (!bluetooth::audio::a2dp::is_hal_2_0_enabled() && a2dp_uipc != nullptr) {
     UIPC_Ioctl(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, nullptr);
@@ -1041,29 +1298,53 @@ static bool btif_a2dp_source_audio_tx_flush_req(void) {
   return true;
 }
 
+void btif_a2dp_source_link_congestion_req(void) {
+  btif_a2dp_source_thread.DoInThread(
+      FROM_HERE, base::Bind(&btif_a2dp_source_link_congestion_event));
+}
+
+static void btif_a2dp_source_link_congestion_event(void) {
+  if (btif_a2dp_source_cb.encoder_interface == nullptr ||
+      btif_a2dp_source_cb.encoder_interface->report_congestion == nullptr) {
+    return;
+  }
+  btif_a2dp_source_cb.encoder_interface->report_congestion();
+}
+
 BT_HDR* btif_a2dp_source_audio_readbuf(void) {
+  std::shared_ptr<BtifA2dpSourceSession> session =
+      btif_a2dp_source_cb.ActiveSession();
+  if (session == nullptr) return nullptr;
+
   uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
-  BT_HDR* p_buf =
-      (BT_HDR*)fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
+  BT_HDR* p_buf = session->tx_audio_queue.Dequeue();
+  if (p_buf != nullptr) {
+    btif_a2dp_source_cb.pcm_bytes_sent += p_buf->event;
+    p_buf->event = 0;
+  }
 
-  btif_a2dp_source_cb.stats.tx_queue_total_readbuf_calls++;
-  btif_a2dp_source_cb.stats.tx_queue_last_readbuf_us = now_us;
+  session->stats.tx_queue_total_readbuf_calls++;
+  session->stats.tx_queue_last_readbuf_us = now_us;
   if (p_buf != nullptr) {
     // Update the statistics
-    update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_dequeue_stats,
-                            now_us,
+    update_scheduling_stats(&session->stats.tx_queue_dequeue_stats, now_us,
                             btif_a2dp_source_cb.encoder_interval_ms * 1000);
   }
 
   return p_buf;
 }
 
-static void log_tstamps_us(const char* comment, uint64_t timestamp_us) {
+uint64_t btif_a2dp_source_get_sent_pcm_bytes(void) {
+  return btif_a2dp_source_cb.pcm_bytes_sent;
+}
+
+static void log_tstamps_us(const char* comment, uint64_t timestamp_us,
+                           size_t queue_length) {
   static uint64_t prev_us = 0;
   APPL_TRACE_DEBUG("%s: [%s] ts %08" PRIu64 ", diff : %08" PRIu64
                    ", queue sz %zu",
                    __func__, comment, timestamp_us, timestamp_us - prev_us,
-                   fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue));
+                   queue_length);
   prev_us = timestamp_us;
 }
 
@@ -1106,9 +1387,23 @@ static void update_scheduling_stats(SchedulingStats* stats, uint64_t now_us,
   }
 }
 
+static void update_tick_error_stats(SchedulingStats* stats, uint64_t now_us,
+                                    uint64_t due_us) {
+  if (due_us == 0 || due_us > now_us) return;
+
+  uint64_t error_us = now_us - due_us;
+  stats->tick_error_count++;
+  stats->total_tick_error_us += error_us;
+  stats->max_tick_error_us = std::max(error_us, stats->max_tick_error_us);
+}
+
 void btif_a2dp_source_debug_dump(int fd) {
-  btif_a2dp_source_accumulate_stats(&btif_a2dp_source_cb.stats,
-                                    &btif_a2dp_source_cb.accumulated_stats);
+  std::shared_ptr<BtifA2dpSourceSession> session =
+      btif_a2dp_source_cb.ActiveSession();
+  if (session != nullptr) {
+    btif_a2dp_source_accumulate_stats(&session->stats,
+                                      &btif_a2dp_source_cb.accumulated_stats);
+  }
   uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
   BtifMediaStats* accumulated_stats = &btif_a2dp_source_cb.accumulated_stats;
   SchedulingStats* enqueue_stats = &accumulated_stats->tx_queue_enqueue_stats;
@@ -1117,6 +1412,16 @@ void btif_a2dp_source_debug_dump(int fd) {
   uint64_t ave_time_us;
 
   dprintf(fd, "\nA2DP State:\n");
+  const PcmConverter& converter = btif_a2dp_source_cb.pcm_converter;
+  if (!converter.IsPassThrough()) {
+    dprintf(fd,
+            "  Audio conversion                                        : "
+            "%u Hz %u bits %u channels to %u Hz %u bits %u channels\n",
+            converter.input().sample_rate, converter.input().bits_per_sample,
+            converter.input().channel_count, converter.output().sample_rate,
+            converter.output().bits_per_sample,
+            converter.output().channel_count);
+  }
   dprintf(fd, "  TxQueue:\n");
 
   dprintf(fd,
@@ -1159,8 +1464,14 @@ void btif_a2dp_source_debug_dump(int fd) {
           accumulated_stats->tx_queue_dropouts);
 
   dprintf(fd,
-          "  Counts (max dropped)                                    : %zu\n",
-          accumulated_stats->tx_queue_max_dropped_messages);
+          "  Counts (max dropped/late)                               : %zu / "
+          "%zu\n",
+          accumulated_stats->tx_queue_max_dropped_messages,
+          accumulated_stats->tx_queue_total_late_messages);
+
+  dprintf(fd,
+          "  Drop policy                                             : %s\n",
+          BtifA2dpDropPolicyText(btif_a2dp_source_cb.tx_drop_policy));
 
   dprintf(
       fd,
@@ -1194,6 +1505,15 @@ void btif_a2dp_source_debug_dump(int fd) {
                     1000
               : 0);
 
+  if (session != nullptr) {
+    slab_allocator_stats_t pool_stats;
+    slab_pool_get_stats(session->media_buffer_pool, &pool_stats);
+    dprintf(fd,
+            "  Media buffers (allocations/pooled/high water)           : %zu / "
+            "%zu / %zu\n",
+            pool_stats.allocations, pool_stats.hits, pool_stats.high_water);
+  }
+
   //
   // TxQueue enqueue stats
   //
@@ -1232,6 +1552,18 @@ void btif_a2dp_source_debug_dump(int fd) {
           1000,
       (unsigned long long)ave_time_us / 1000);
 
+  ave_time_us = 0;
+  if (enqueue_stats->tick_error_count != 0) {
+    ave_time_us =
+        enqueue_stats->total_tick_error_us / enqueue_stats->tick_error_count;
+  }
+  dprintf(fd,
+          "  Media tick error in us (count/max/ave)                  : %zu / "
+          "%llu / %llu\n",
+          enqueue_stats->tick_error_count,
+          (unsigned long long)enqueue_stats->max_tick_error_us,
+          (unsigned long long)ave_time_us);
+
   //
   // TxQueue dequeue stats
   //
@@ -1271,8 +1603,7 @@ void btif_a2dp_source_debug_dump(int fd) {
       (unsigned long long)ave_time_us / 1000);
 }
 
-static void btif_a2dp_source_update_metrics(void) {
-  BtifMediaStats stats = btif_a2dp_source_cb.stats;
+static void btif_a2dp_source_update_metrics(const BtifMediaStats& stats) {
   SchedulingStats enqueue_stats = stats.tx_queue_enqueue_stats;
   A2dpSessionMetrics metrics;
   metrics.codec_index = stats.codec_index;
@@ -1357,6 +1688,47 @@ static void btm_read_failed_contact_counter_cb(void* data) {
 
   LOG_WARN("%s: device: %s, Failed Contact Counter: %u", __func__,
            result->rem_bda.ToString().c_str(), result->failed_contact_counter);
+
+  // The counter only grows while the link keeps flushing packets
+  static RawAddress last_rem_bda = RawAddress::kEmpty;
+  static uint16_t last_failed_contact_counter = 0;
+  if (result->rem_bda == last_rem_bda &&
+      result->failed_contact_counter > last_failed_contact_counter) {
+    btif_a2dp_source_link_congestion_req();
+  }
+  last_rem_bda = result->rem_bda;
+  last_failed_contact_counter = result->failed_contact_counter;
+}
+
+// Called on the stack main thread for each Link Quality report, so that the
+// encoder lowers its bitrate as soon as the controller sees the link degrade
+// rather than once the TX queue overflows.
+static void btif_a2dp_source_link_quality_event(
+    const bluetooth::bqr::BqrLinkQualityEventView& event) {
+  static uint16_t last_handle = HCI_INVALID_HANDLE;
+  static uint32_t last_retransmission_count = 0;
+
+  uint16_t handle = BTM_GetHCIConnHandle(btif_av_source_active_peer(),
+                                         BT_TRANSPORT_BR_EDR);
+  if (handle == HCI_INVALID_HANDLE || event.ConnectionHandle() != handle) {
+    return;
+  }
+
+  uint32_t retransmission_count = event.RetransmissionCount();
+  bool rising =
+      handle == last_handle &&
+      retransmission_count >
+          last_retransmission_count + A2DP_BQR_RETRANSMISSION_RISE_THRESHOLD;
+  last_handle = handle;
+  last_retransmission_count = retransmission_count;
+
+  if (event.QualityReportId() ==
+          bluetooth::bqr::QUALITY_REPORT_ID_A2DP_AUDIO_CHOPPY ||
+      rising) {
+    LOG_WARN("%s: handle: 0x%04x, report: 0x%02x, retransmissions: %u",
+             __func__, handle, event.QualityReportId(), retransmission_count);
+    btif_a2dp_source_link_congestion_req();
+  }
 }
 
 static void btm_read_automatic_flush_timeout_cb(void* data) {
@@ -1461,7 +1461,8 @@ bool BtifAvStateMachine::StateIdle::ProcessEvent(uint32_t event, void* p_data) {
             "peers",
             __PRETTY_FUNCTION__, peer_.PeerAddress().ToString().c_str());
         if (peer_.SelfInitiatedConnection()) {
-          btif_queue_advance();
+          btif_queue_advance_by_profile(peer_.LocalUuidServiceClass(),
+                                        peer_.PeerAddress());
         }
         break;
       }
@@ -1584,7 +1585,8 @@ bool BtifAvStateMachine::StateIdle::ProcessEvent(uint32_t event, void* p_data) {
           BTA_AvOpenRc(peer_.BtaHandle());
         }
       }
-      btif_queue_advance();
+      btif_queue_advance_by_profile(peer_.LocalUuidServiceClass(),
+                                    peer_.PeerAddress());
     } break;
 
     case BTA_AV_REMOTE_CMD_EVT:
@@ -1667,7 +1669,8 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
                                    BTAV_CONNECTION_STATE_DISCONNECTED);
       peer_.StateMachine().TransitionTo(BtifAvStateMachine::kStateIdle);
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_profile(peer_.LocalUuidServiceClass(),
+                                      peer_.PeerAddress());
       }
       break;
     case BTA_AV_REJECT_EVT:
@@ -1679,7 +1682,8 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
                                    BTAV_CONNECTION_STATE_DISCONNECTED);
       peer_.StateMachine().TransitionTo(BtifAvStateMachine::kStateIdle);
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_profile(peer_.LocalUuidServiceClass(),
+                                      peer_.PeerAddress());
       }
       break;
 
@@ -1733,7 +1737,8 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
         BTA_AvOpenRc(peer_.BtaHandle());
       }
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_profile(peer_.LocalUuidServiceClass(),
+                                      peer_.PeerAddress());
       }
     } break;
 
@@ -1755,7 +1760,8 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
           "ignore Connect request",
           __PRETTY_FUNCTION__, peer_.PeerAddress().ToString().c_str(),
           BtifAvEvent::EventName(event).c_str());
-      btif_queue_advance();
+      btif_queue_advance_by_profile(peer_.LocalUuidServiceClass(),
+                                    peer_.PeerAddress());
     } break;
 
     case BTA_AV_PENDING_EVT: {
@@ -1782,7 +1788,8 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
                                    BTAV_CONNECTION_STATE_DISCONNECTED);
       peer_.StateMachine().TransitionTo(BtifAvStateMachine::kStateIdle);
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_profile(peer_.LocalUuidServiceClass(),
+                                      peer_.PeerAddress());
       }
       break;
 
@@ -1792,7 +1799,8 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
                                    BTAV_CONNECTION_STATE_DISCONNECTED);
       peer_.StateMachine().TransitionTo(BtifAvStateMachine::kStateIdle);
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_profile(peer_.LocalUuidServiceClass(),
+                                      peer_.PeerAddress());
       }
       break;
 
@@ -2003,7 +2011,8 @@ bool BtifAvStateMachine::StateOpened::ProcessEvent(uint32_t event,
                          __PRETTY_FUNCTION__,
                          peer_.PeerAddress().ToString().c_str(),
                          BtifAvEvent::EventName(event).c_str());
-      btif_queue_advance();
+      btif_queue_advance_by_profile(peer_.LocalUuidServiceClass(),
+                                    peer_.PeerAddress());
     } break;
 
     case BTIF_AV_OFFLOAD_START_REQ_EVT:
@@ -2773,7 +2782,7 @@ static bt_status_t connect_int(RawAddress* peer_address, uint16_t uuid) {
       peer = btif_av_sink.FindOrCreatePeer(*peer_address, kBtaHandleUnknown);
     }
     if (peer == nullptr) {
-      btif_queue_advance();
+      btif_queue_advance_by_profile(uuid, *peer_address);
       return;
     }
     peer->StateMachine().ProcessEvent(BTIF_AV_CONNECT_REQ_EVT, nullptr);
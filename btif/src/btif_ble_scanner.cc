@@ -41,6 +41,7 @@
 #include "btif_gatt.h"
 #include "btif_gatt_util.h"
 #include "btif_storage.h"
+#include "osi/include/alarm.h"
 #include "osi/include/log.h"
 #include "stack/include/btu.h"
 #include "vendor_api.h"
@@ -94,35 +95,66 @@ void bta_batch_scan_threshold_cb(tBTM_BLE_REF_VALUE ref_value) {
   SCAN_CBACK_IN_JNI(batchscan_threshold_cb, ref_value);
 }
 
-void bta_batch_scan_reports_cb(int client_id, tBTA_STATUS status,
-                               uint8_t report_format, uint8_t num_records,
-                               std::vector<uint8_t> data) {
+/* Records of a batch scan read, gathered for batchscan_reports_cb when the
+ * upper layer does not take them chunk by chunk */
+struct BatchScanReports {
+  int num_records = 0;
+  vector<uint8_t> data;
+};
+
+void bta_batch_scan_reports_cb(int client_id,
+                               std::shared_ptr<BatchScanReports> reports,
+                               tBTA_STATUS status, uint8_t report_format,
+                               uint8_t num_records, std::vector<uint8_t> data,
+                               bool more) {
+  if (bt_gatt_callbacks &&
+      bt_gatt_callbacks->scanner->batchscan_reports_chunk_cb) {
+    SCAN_CBACK_IN_JNI(batchscan_reports_chunk_cb, client_id, status,
+                      report_format, num_records, std::move(data), more);
+    return;
+  }
+
+  reports->num_records += num_records;
+  reports->data.insert(reports->data.end(), data.begin(), data.end());
+  if (more) return;
+
   SCAN_CBACK_IN_JNI(batchscan_reports_cb, client_id, status, report_format,
-                    num_records, std::move(data));
+                    reports->num_records, std::move(reports->data));
 }
 
-void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
-                              int8_t rssi, uint8_t addr_type,
-                              uint16_t ble_evt_type, uint8_t ble_primary_phy,
-                              uint8_t ble_secondary_phy,
-                              uint8_t ble_advertising_sid, int8_t ble_tx_power,
-                              uint16_t ble_periodic_adv_int,
-                              vector<uint8_t> value) {
+struct ScanResult {
+  RawAddress bd_addr;
+  tBT_DEVICE_TYPE device_type;
+  int8_t rssi;
+  uint8_t addr_type;
+  uint16_t ble_evt_type;
+  uint8_t ble_primary_phy;
+  uint8_t ble_secondary_phy;
+  uint8_t ble_advertising_sid;
+  int8_t ble_tx_power;
+  uint16_t ble_periodic_adv_int;
+  vector<uint8_t> value;
+};
+
+/* Updates the properties of the remote device from the result, returns false
+ * if the result is to be dropped */
+bool bta_scan_result_update_properties(const ScanResult& r) {
   uint8_t remote_name_len;
   bt_device_type_t dev_type;
   bt_property_t properties;
+  RawAddress bd_addr = r.bd_addr;
 
   const uint8_t* p_eir_remote_name = AdvertiseDataParser::GetFieldByType(
-      value, BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
+      r.value, BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
 
   if (p_eir_remote_name == NULL) {
     p_eir_remote_name = AdvertiseDataParser::GetFieldByType(
-        value, BT_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
+        r.value, BT_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
   }
 
-  if ((addr_type != BLE_ADDR_RANDOM) || (p_eir_remote_name)) {
+  if ((r.addr_type != BLE_ADDR_RANDOM) || (p_eir_remote_name)) {
     if (!btif_address_cache_find(bd_addr)) {
-      btif_address_cache_add(bd_addr, addr_type);
+      btif_address_cache_add(bd_addr, r.addr_type);
 
       if (p_eir_remote_name) {
         if (remote_name_len > BD_NAME_LEN + 1 ||
@@ -130,7 +162,7 @@ void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
              p_eir_remote_name[BD_NAME_LEN] != '\0')) {
           LOG_INFO("%s dropping invalid packet - device name too long: %d",
                    __func__, remote_name_len);
-          return;
+          return false;
         }
 
         bt_bdname_t bdname;
@@ -139,21 +171,102 @@ void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
           bdname.name[remote_name_len] = '\0';
 
         LOG_VERBOSE("%s BLE device name=%s len=%d dev_type=%d", __func__,
-                    bdname.name, remote_name_len, device_type);
-        btif_dm_update_ble_remote_properties(bd_addr, bdname.name, device_type);
+                    bdname.name, remote_name_len, r.device_type);
+        btif_dm_update_ble_remote_properties(bd_addr, bdname.name,
+                                             r.device_type);
       }
     }
   }
 
-  dev_type = (bt_device_type_t)device_type;
+  dev_type = (bt_device_type_t)r.device_type;
   BTIF_STORAGE_FILL_PROPERTY(&properties, BT_PROPERTY_TYPE_OF_DEVICE,
                              sizeof(dev_type), &dev_type);
   btif_storage_set_remote_device_property(&(bd_addr), &properties);
 
-  btif_storage_set_remote_addr_type(&bd_addr, addr_type);
-  HAL_CBACK(bt_gatt_callbacks, scanner->scan_result_cb, ble_evt_type, addr_type,
-            &bd_addr, ble_primary_phy, ble_secondary_phy, ble_advertising_sid,
-            ble_tx_power, rssi, ble_periodic_adv_int, std::move(value));
+  btif_storage_set_remote_addr_type(&bd_addr, r.addr_type);
+  return true;
+}
+
+/* Appends |r| to the buffer of a scan_results_batch_cb */
+void bta_scan_result_append(const ScanResult& r, vector<uint8_t>* data) {
+  btgatt_batched_scan_result_t header;
+  header.event_type = r.ble_evt_type;
+  header.addr_type = r.addr_type;
+  header.bda = r.bd_addr;
+  header.primary_phy = r.ble_primary_phy;
+  header.secondary_phy = r.ble_secondary_phy;
+  header.advertising_sid = r.ble_advertising_sid;
+  header.tx_power = r.ble_tx_power;
+  header.rssi = r.rssi;
+  header.periodic_adv_int = r.ble_periodic_adv_int;
+  header.adv_data_len = r.value.size();
+
+  const uint8_t* p_header = reinterpret_cast<const uint8_t*>(&header);
+  data->insert(data->end(), p_header, p_header + sizeof(header));
+  data->insert(data->end(), r.value.begin(), r.value.end());
+}
+
+void bta_scan_results_batch_impl(vector<ScanResult> results, bool coalesce) {
+  if (coalesce && bt_gatt_callbacks &&
+      bt_gatt_callbacks->scanner->scan_results_batch_cb) {
+    vector<uint8_t> data;
+    int num_results = 0;
+    for (const ScanResult& r : results) {
+      if (!bta_scan_result_update_properties(r)) continue;
+      bta_scan_result_append(r, &data);
+      num_results++;
+    }
+    if (num_results > 0) {
+      HAL_CBACK(bt_gatt_callbacks, scanner->scan_results_batch_cb, num_results,
+                std::move(data));
+    }
+    return;
+  }
+
+  for (ScanResult& r : results) {
+    if (!bta_scan_result_update_properties(r)) continue;
+    HAL_CBACK(bt_gatt_callbacks, scanner->scan_result_cb, r.ble_evt_type,
+              r.addr_type, &r.bd_addr, r.ble_primary_phy, r.ble_secondary_phy,
+              r.ble_advertising_sid, r.ble_tx_power, r.rssi,
+              r.ble_periodic_adv_int, std::move(r.value));
+  }
+}
+
+// results received on the main thread, not yet passed to the jni thread
+vector<ScanResult> pending_scan_results;
+
+// Coalescing set with SetScanResultBatching, accessed on the main thread. The
+// results are held for up to scan_batch_window_ms, or until
+// scan_batch_max_results of them are pending.
+uint64_t scan_batch_window_ms = 0;
+size_t scan_batch_max_results = 0;
+alarm_t* scan_batch_alarm = nullptr;
+
+/* Passes all the pending results to the jni thread at once, rather than one
+ * task per result */
+void bta_scan_results_flush() {
+  if (pending_scan_results.empty()) return;
+  vector<ScanResult> results;
+  results.swap(pending_scan_results);
+  do_in_jni_thread(base::BindOnce(bta_scan_results_batch_impl,
+                                  std::move(results),
+                                  scan_batch_window_ms != 0));
+}
+
+void bta_scan_results_batch_timeout(void* /* data */) {
+  bta_scan_results_flush();
+}
+
+void bta_set_scan_result_batching(int window_ms, int max_results) {
+  if (scan_batch_alarm == nullptr) {
+    scan_batch_alarm = alarm_new("btif_scan_batch");
+  }
+  // The results held with the previous settings are delivered with them
+  alarm_cancel(scan_batch_alarm);
+  bta_scan_results_flush();
+
+  scan_batch_window_ms = window_ms > 0 ? window_ms : 0;
+  scan_batch_max_results = max_results > 0 ? max_results : 1;
 }
 
 void bta_scan_results_cb(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH* p_data) {
@@ -182,11 +295,27 @@ void bta_scan_results_cb(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH* p_data) {
   }
 
   tBTA_DM_INQ_RES* r = &p_data->inq_res;
-  do_in_jni_thread(Bind(bta_scan_results_cb_impl, r->bd_addr, r->device_type,
-                        r->rssi, r->ble_addr_type, r->ble_evt_type,
-                        r->ble_primary_phy, r->ble_secondary_phy,
-                        r->ble_advertising_sid, r->ble_tx_power,
-                        r->ble_periodic_adv_int, std::move(value)));
+  if (pending_scan_results.empty()) {
+    if (scan_batch_window_ms == 0) {
+      // the flush runs once the main thread is done with the current HCI
+      // events
+      do_in_main_thread(FROM_HERE, base::BindOnce(bta_scan_results_flush));
+    } else {
+      alarm_set_on_mloop(scan_batch_alarm, scan_batch_window_ms,
+                         bta_scan_results_batch_timeout, nullptr);
+    }
+  }
+
+  pending_scan_results.push_back(ScanResult{
+      r->bd_addr, r->device_type, r->rssi, r->ble_addr_type, r->ble_evt_type,
+      r->ble_primary_phy, r->ble_secondary_phy, r->ble_advertising_sid,
+      r->ble_tx_power, r->ble_periodic_adv_int, std::move(value)});
+
+  if (scan_batch_window_ms != 0 &&
+      pending_scan_results.size() >= scan_batch_max_results) {
+    alarm_cancel(scan_batch_alarm);
+    bta_scan_results_flush();
+  }
 }
 
 void bta_track_adv_event_cb(tBTM_BLE_TRACK_ADV_DATA* p_track_adv_data) {
@@ -199,6 +328,15 @@ void bta_track_adv_event_cb(tBTM_BLE_TRACK_ADV_DATA* p_track_adv_data) {
   SCAN_CBACK_IN_JNI(track_adv_event_cb, Owned(btif_scan_track_cb));
 }
 
+/* The data is only valid in the stack context, copy it for the JNI thread */
+void bta_sync_report_cb(BleScannerInterface::SyncReportCb cb,
+                        uint16_t sync_handle, int8_t tx_power, int8_t rssi,
+                        uint8_t status, const uint8_t* data, uint16_t len) {
+  do_in_jni_thread(FROM_HERE,
+                   Bind(cb, sync_handle, tx_power, rssi, status,
+                        std::vector<uint8_t>(data, data + len)));
+}
+
 void bta_cback(tBTA_GATTC_EVT, tBTA_GATTC*) {}
 
 class BleScannerInterfaceImpl : public BleScannerInterface {
@@ -321,14 +459,48 @@ class BleScannerInterfaceImpl : public BleScannerInterface {
   void BatchscanReadReports(int client_if, int scan_mode) override {
     do_in_main_thread(FROM_HERE,
                       base::Bind(&BTM_BleReadScanReports, (uint8_t)scan_mode,
-                                 Bind(bta_batch_scan_reports_cb, client_if)));
+                                 Bind(bta_batch_scan_reports_cb, client_if,
+                                      std::make_shared<BatchScanReports>())));
+  }
+
+  void SetScanResultBatching(int window_ms, int max_results) override {
+    do_in_main_thread(FROM_HERE, Bind(&bta_set_scan_result_batching, window_ms,
+                                      max_results));
   }
 
   void StartSync(uint8_t sid, RawAddress address, uint16_t skip,
                  uint16_t timeout, StartSyncCb start_cb, SyncReportCb report_cb,
-                 SyncLostCb lost_cb) override {}
+                 SyncLostCb lost_cb) override {
+    do_in_main_thread(
+        FROM_HERE,
+        base::Bind(&BTM_BleStartPeriodicSync, sid, address, skip, timeout,
+                   jni_thread_wrapper(FROM_HERE, std::move(start_cb)),
+                   Bind(&bta_sync_report_cb, std::move(report_cb)),
+                   jni_thread_wrapper(FROM_HERE, std::move(lost_cb))));
+  }
+
+  void StopSync(uint16_t handle) override {
+    do_in_main_thread(FROM_HERE, base::Bind(&BTM_BleStopPeriodicSync, handle));
+  }
+
+  void TransferSync(RawAddress address, uint16_t service_data,
+                    uint16_t sync_handle, SyncTransferCb cb) override {
+    do_in_main_thread(
+        FROM_HERE,
+        base::Bind(&BTM_BlePeriodicSyncTransfer, address, service_data,
+                   sync_handle, jni_thread_wrapper(FROM_HERE, std::move(cb))));
+  }
 
-  void StopSync(uint16_t handle) override {}
+  void ReceiveSyncTransfer(RawAddress address, uint16_t skip, uint16_t timeout,
+                           StartSyncCb start_cb, SyncReportCb report_cb,
+                           SyncLostCb lost_cb) override {
+    do_in_main_thread(
+        FROM_HERE,
+        base::Bind(&BTM_BleReceivePeriodicSyncTransfer, address, skip, timeout,
+                   jni_thread_wrapper(FROM_HERE, std::move(start_cb)),
+                   Bind(&bta_sync_report_cb, std::move(report_cb)),
+                   jni_thread_wrapper(FROM_HERE, std::move(lost_cb))));
+  }
 };
 
 BleScannerInterface* btLeScannerInstance = nullptr;
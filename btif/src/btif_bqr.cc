@@ -20,6 +20,9 @@
 #include <statslog.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <map>
+#include <mutex>
+#include <vector>
 
 #include "btif_bqr.h"
 #include "btif_dm.h"
@@ -37,6 +40,43 @@ using std::chrono::system_clock;
 static std::unique_ptr<LeakyBondedQueue<BqrVseSubEvt>> kpBqrEventQueue(
     new LeakyBondedQueue<BqrVseSubEvt>(kBqrEventQueueSize));
 
+// The observers of the Link Quality related BQR events, by id
+static std::mutex link_quality_observers_mutex;
+static std::map<int, LinkQualityObserver> link_quality_observers;
+static int link_quality_observer_next_id = 1;
+
+int RegisterLinkQualityObserver(LinkQualityObserver observer) {
+  std::lock_guard<std::mutex> lock(link_quality_observers_mutex);
+  int observer_id = link_quality_observer_next_id++;
+  link_quality_observers[observer_id] = std::move(observer);
+  return observer_id;
+}
+
+void UnregisterLinkQualityObserver(int observer_id) {
+  std::lock_guard<std::mutex> lock(link_quality_observers_mutex);
+  link_quality_observers.erase(observer_id);
+}
+
+// Called before the event is copied for the queue and statsd, so that the
+// observers can adapt the link as soon as the controller reports it.
+static void NotifyLinkQualityObservers(uint8_t length,
+                                       const uint8_t* p_bqr_event) {
+  BqrLinkQualityEventView event(p_bqr_event, length);
+  std::vector<LinkQualityObserver> observers;
+  {
+    std::lock_guard<std::mutex> lock(link_quality_observers_mutex);
+    if (link_quality_observers.empty()) return;
+    observers.reserve(link_quality_observers.size());
+    for (const auto& entry : link_quality_observers) {
+      observers.push_back(entry.second);
+    }
+  }
+  // Called without the lock held so that an observer can unregister itself
+  for (const auto& observer : observers) {
+    observer(event);
+  }
+}
+
 void BqrVseSubEvt::ParseBqrLinkQualityEvt(uint8_t length,
                                           uint8_t* p_param_buf) {
   if (length < kLinkQualityParamTotalLen) {
@@ -359,6 +399,7 @@ void CategorizeBqrEvent(uint8_t length, uint8_t* p_bqr_event) {
         return;
       }
 
+      NotifyLinkQualityObservers(length, p_bqr_event);
       AddLinkQualityEventToQueue(length, p_bqr_event);
       break;
 
@@ -408,6 +449,20 @@ void AddLinkQualityEventToQueue(uint8_t length, uint8_t* p_link_quality_event) {
     LOG(WARNING) << __func__ << ": failed to log BQR event to statsd, error "
                  << ret;
   }
+
+  // Aggregated per link by BTM for the power mode and link policies
+  const BqrLinkQualityEvent& event = p_bqr_event->bqr_link_quality_event_;
+  tBTM_LQ_SAMPLE sample = {};
+  sample.handle = event.connection_handle;
+  sample.source = BTM_LQ_SRC_BQR;
+  if (event.quality_report_id == QUALITY_REPORT_ID_APPROACH_LSTO) {
+    sample.flags = BTM_LQ_FLAG_APPROACH_LSTO;
+  }
+  sample.rssi = event.rssi;
+  sample.retransmissions = event.retransmission_count;
+  sample.naks = event.nak_count;
+  BTM_LinkQualityAddSample(&sample);
+
   kpBqrEventQueue->Enqueue(p_bqr_event.release());
 }
 
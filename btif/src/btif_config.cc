@@ -21,11 +21,13 @@
 #include "btif_config.h"
 
 #include <unistd.h>
+#include <algorithm>
 #include <cctype>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
 #include <functional>
+#include <future>
 #include <mutex>
 #include <sstream>
 #include <string>
@@ -271,6 +273,14 @@ static future_t* init(void) {
 
   std::string file_source;
 
+  // Parse the backup alongside the config file, so that a corrupt config file
+  // does not make the stack wait for both files to be read one after another
+  std::future<std::unique_ptr<config_t>> backup_config;
+  if (config_checksum_pass(CONFIG_BACKUP_COMPARE_PASS)) {
+    backup_config = std::async(std::launch::async, btif_config_open,
+                               CONFIG_BACKUP_PATH);
+  }
+
   if (config_checksum_pass(CONFIG_FILE_COMPARE_PASS)) {
     config = btif_config_open(CONFIG_FILE_PATH);
     btif_config_source = ORIGINAL;
@@ -278,8 +288,8 @@ static future_t* init(void) {
   if (!config) {
     LOG_WARN("%s unable to load config file: %s; using backup.", __func__,
              CONFIG_FILE_PATH);
-    if (config_checksum_pass(CONFIG_BACKUP_COMPARE_PASS)) {
-      config = btif_config_open(CONFIG_BACKUP_PATH);
+    if (backup_config.valid()) {
+      config = backup_config.get();
       btif_config_source = BACKUP;
       file_source = "Backup";
     }
@@ -495,6 +505,14 @@ static bool btif_in_encrypt_key_name_list(std::string key) {
                    key) != (encrypt_key_name_list + ENCRYPT_KEY_NAME_LIST_SIZE);
 }
 
+// Returns the value of the hex digit |c|, or -1 if |c| is not a hex digit.
+static int hex_digit_value(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
 bool btif_config_get_bin(const std::string& section, const std::string& key,
                          uint8_t* value, size_t* length) {
   if (bluetooth::shim::is_gd_shim_enabled()) {
@@ -533,15 +551,15 @@ bool btif_config_get_bin(const std::string& section, const std::string& key,
     return false;
   }
 
+  const char* ptr = value_str->c_str();
   for (size_t i = 0; i < value_len; ++i)
-    if (!isxdigit(value_str->c_str()[i])) {
+    if (hex_digit_value(ptr[i]) < 0) {
       LOG(WARNING) << ": value is not hex digit";
       return false;
     }
 
-  const char* ptr = value_str->c_str();
-  for (*length = 0; *ptr; ptr += 2, *length += 1) {
-    sscanf(ptr, "%02hhx", &value[*length]);
+  for (*length = 0; *length < value_len / 2; ptr += 2, *length += 1) {
+    value[*length] = (hex_digit_value(ptr[0]) << 4) | hex_digit_value(ptr[1]);
   }
 
   if (btif_is_niap_mode()) {
@@ -589,8 +607,7 @@ bool btif_config_set_bin(const std::string& section, const std::string& key,
     return false;
   }
 
-  char* str = (char*)osi_calloc(length * 2 + 1);
-
+  std::string str(length * 2, '\0');
   for (size_t i = 0; i < length; ++i) {
     str[(i * 2) + 0] = lookup[(value[i] >> 4) & 0x0F];
     str[(i * 2) + 1] = lookup[value[i] & 0x0F];
@@ -603,7 +620,7 @@ bool btif_config_set_bin(const std::string& section, const std::string& key,
         section + "-" + key, str);
     value_str = ENCRYPTED_STR;
   } else {
-    value_str = str;
+    value_str = std::move(str);
   }
 
   {
@@ -611,7 +628,6 @@ bool btif_config_set_bin(const std::string& section, const std::string& key,
     btif_config_cache.SetString(section, key, value_str);
   }
 
-  osi_free(str);
   return true;
 }
 
@@ -637,6 +653,36 @@ std::vector<RawAddress> btif_config_get_paired_devices() {
   return result;
 }
 
+void btif_config_prefetch_encrypted_keys() {
+  if (bluetooth::shim::is_gd_shim_enabled()) return;
+
+  std::vector<std::string> prefixes;
+  {
+    std::unique_lock<std::recursive_mutex> lock(config_lock);
+    std::vector<std::pair<int, std::string>> sections;
+    for (auto& name : btif_config_cache.GetPersistentSectionNames()) {
+      // BTIF_STORAGE_KEY_LAST_USED
+      int last_used = btif_config_cache.GetInt(name, "LastUsed").value_or(0);
+      sections.emplace_back(last_used, std::move(name));
+    }
+    // Most recently used devices first, they are the first to reconnect
+    std::stable_sort(
+        sections.begin(), sections.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (const auto& section : sections) {
+      for (const auto& key : encrypt_key_name_list) {
+        auto value = btif_config_cache.GetString(section.second, key);
+        if (value && *value == ENCRYPTED_STR) {
+          prefixes.push_back(section.second + "-" + key);
+        }
+      }
+    }
+  }
+  if (prefixes.empty()) return;
+
+  get_bluetooth_keystore_interface()->prefetch_keys(std::move(prefixes));
+}
+
 bool btif_config_remove(const std::string& section, const std::string& key) {
   if (bluetooth::shim::is_gd_shim_enabled()) {
     CHECK(bluetooth::shim::is_gd_stack_started_up());
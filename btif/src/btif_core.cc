@@ -58,6 +58,7 @@
 #include "btif_util.h"
 #include "btu.h"
 #include "common/message_loop_thread.h"
+#include "common/startup_trace.h"
 #include "device/include/controller.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/future.h"
@@ -69,6 +70,7 @@
 using base::PlatformThread;
 using bluetooth::Uuid;
 using bluetooth::common::MessageLoopThread;
+namespace startup_trace = bluetooth::common::startup_trace;
 
 /*******************************************************************************
  *  Constants & Macros
@@ -129,6 +131,13 @@ static tBTA_SERVICE_MASK btif_enabled_services = 0;
 static uint8_t btif_dut_mode = 0;
 
 static MessageLoopThread jni_thread("bt_jni_thread");
+
+/* Buffers of the context switches, which parameter blocks mostly fit in a
+ * buffer of the pool. The pool is kept across init / cleanup cycles, as the
+ * BTA callbacks may still be switching context during the cleanup. */
+#define BTIF_CONTEXT_SWITCH_BUFFER_SIZE 1024
+#define BTIF_CONTEXT_SWITCH_POOL_SIZE 32
+static slab_pool_t* context_switch_pool = nullptr;
 static base::AtExitManager* exit_manager;
 static uid_set_t* uid_set;
 
@@ -192,8 +201,12 @@ static void btif_context_switched(void* p_msg) {
 bt_status_t btif_transfer_context(tBTIF_CBACK* p_cback, uint16_t event,
                                   char* p_params, int param_len,
                                   tBTIF_COPY_CBACK* p_copy_cback) {
-  tBTIF_CONTEXT_SWITCH_CBACK* p_msg = (tBTIF_CONTEXT_SWITCH_CBACK*)osi_malloc(
-      sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len);
+  size_t size = sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len;
+  tBTIF_CONTEXT_SWITCH_CBACK* p_msg =
+      (tBTIF_CONTEXT_SWITCH_CBACK*)(context_switch_pool
+                                        ? osi_malloc_from_pool(
+                                              context_switch_pool, size)
+                                        : osi_malloc(size));
 
   BTIF_TRACE_VERBOSE("btif_transfer_context event %d, len %d", event,
                      param_len);
@@ -324,8 +337,13 @@ void btif_sendmsg(void* p_msg) {
 bt_status_t btif_init_bluetooth() {
   LOG_INFO("%s entered", __func__);
   exit_manager = new base::AtExitManager();
+  if (context_switch_pool == nullptr) {
+    context_switch_pool = osi_pool_new(BTIF_CONTEXT_SWITCH_BUFFER_SIZE,
+                                       BTIF_CONTEXT_SWITCH_POOL_SIZE);
+  }
   bte_main_boot_entry();
   jni_thread.StartUp();
+  jni_thread.ApplyThreadRole(bluetooth::common::ThreadRole::DEFAULT);
   jni_thread.DoInThread(FROM_HERE, base::Bind(btif_jni_associate));
   LOG_INFO("%s finished", __func__);
   return BT_STATUS_SUCCESS;
@@ -344,6 +362,7 @@ bt_status_t btif_init_bluetooth() {
 
 void btif_enable_bluetooth_evt(tBTA_STATUS status) {
   LOG_INFO("%s entered: status %d", __func__, status);
+  auto trace_begin = startup_trace::Clock::now();
 
   /* Fetch the local BD ADDR */
   RawAddress local_bd_addr = *controller_get_interface()->get_address();
@@ -389,6 +408,8 @@ void btif_enable_bluetooth_evt(tBTA_STATUS status) {
     btif_dm_load_local_oob();
 #endif
 
+    startup_trace::AddEvent("btif_enable_bluetooth_evt", trace_begin,
+                            startup_trace::Clock::now());
     future_ready(stack_manager_get_hack_future(), FUTURE_SUCCESS);
   } else {
     /* cleanup rfcomm & l2cap api */
@@ -396,6 +417,8 @@ void btif_enable_bluetooth_evt(tBTA_STATUS status) {
 
     btif_pan_cleanup();
 
+    startup_trace::AddEvent("btif_enable_bluetooth_evt", trace_begin,
+                            startup_trace::Clock::now());
     future_ready(stack_manager_get_hack_future(), FUTURE_FAIL);
   }
 
@@ -417,6 +440,7 @@ bt_status_t btif_disable_bluetooth() {
   LOG_INFO("%s entered", __func__);
 
   do_in_main_thread(FROM_HERE, base::Bind(&btm_ble_multi_adv_cleanup));
+  do_in_main_thread(FROM_HERE, base::Bind(&btm_ble_periodic_sync_cleanup));
   // TODO(jpawlowski): this should do whole BTA_VendorCleanup(), but it would
   // kill the stack now.
 
@@ -712,10 +736,7 @@ static void execute_storage_request(uint16_t event, char* p_param) {
         local_le_features.local_privacy_enabled = BTM_BleLocalPrivacyEnabled();
 
         prop.len = sizeof(bt_local_le_features_t);
-        if (cmn_vsc_cb.filter_support == 1)
-          local_le_features.max_adv_filter_supported = cmn_vsc_cb.max_filter;
-        else
-          local_le_features.max_adv_filter_supported = 0;
+        local_le_features.max_adv_filter_supported = BTM_BleMaxAdvFilters();
         local_le_features.max_adv_instance = cmn_vsc_cb.adv_inst_max;
         local_le_features.max_irk_list_size = cmn_vsc_cb.max_irk_list_sz;
         local_le_features.rpa_offload_supported = cmn_vsc_cb.rpa_offloading;
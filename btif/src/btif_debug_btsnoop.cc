@@ -35,7 +35,7 @@
 static const size_t BTSNOOP_MEM_BUFFER_SIZE = (256 * 1024);
 #endif
 
-// Block size for copying buffers (for compression/encoding etc.)
+// Largest block compressed at once
 static const size_t BLOCK_SIZE = 16384;
 
 // Maximum line length in bugreport (should be multiple of 4 for base64 output)
@@ -142,30 +142,36 @@ static bool btsnoop_compress(ringbuffer_t* rb_dst, ringbuffer_t* rb_src) {
   if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) return false;
 
   bool rc = true;
-  uint8_t block_src[BLOCK_SIZE];
-  uint8_t block_dst[BLOCK_SIZE];
 
-  const size_t num_blocks =
-      (ringbuffer_size(rb_src) + BLOCK_SIZE - 1) / BLOCK_SIZE;
-  for (size_t i = 0; i < num_blocks; ++i) {
-    zs.avail_in =
-        ringbuffer_peek(rb_src, i * BLOCK_SIZE, block_src, BLOCK_SIZE);
-    zs.next_in = block_src;
+  // Compress in place, from the spans of the source into those of the
+  // destination
+  ringbuffer_span_t src[2];
+  const size_t num_src =
+      ringbuffer_peek_spans(rb_src, ringbuffer_size(rb_src), src);
+  size_t i = 0;
+  do {
+    zs.next_in = (i < num_src) ? src[i].data : Z_NULL;
+    zs.avail_in = (i < num_src) ? src[i].length : 0;
+    const int flush = (i + 1 >= num_src) ? Z_FINISH : Z_NO_FLUSH;
 
     do {
-      zs.avail_out = BLOCK_SIZE;
-      zs.next_out = block_dst;
+      ringbuffer_span_t dst[2];
+      if (ringbuffer_reserve(rb_dst, BLOCK_SIZE, dst) == 0) {
+        rc = false;
+        break;
+      }
+      zs.avail_out = dst[0].length;
+      zs.next_out = dst[0].data;
 
-      int err = deflate(&zs, (i == num_blocks - 1) ? Z_FINISH : Z_NO_FLUSH);
+      int err = deflate(&zs, flush);
       if (err == Z_STREAM_ERROR) {
         rc = false;
         break;
       }
 
-      const size_t length = BLOCK_SIZE - zs.avail_out;
-      ringbuffer_insert(rb_dst, block_dst, length);
+      ringbuffer_commit(rb_dst, dst[0].length - zs.avail_out);
     } while (zs.avail_out == 0);
-  }
+  } while (rc && ++i < num_src);
 
   deflateEnd(&zs);
   return rc;
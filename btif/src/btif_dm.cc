@@ -56,6 +56,7 @@
 #include "btif_hd.h"
 #include "btif_hf.h"
 #include "btif_hh.h"
+#include "btif_property_coalescer.h"
 #include "btif_sdp.h"
 #include "btif_storage.h"
 #include "btif_util.h"
@@ -67,6 +68,7 @@
 #include "internal_include/stack_config.h"
 #include "main/shim/btif_dm.h"
 #include "main/shim/shim.h"
+#include "osi/include/alarm.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
@@ -105,6 +107,10 @@ const Uuid UUID_HEARING_AID = Uuid::FromString("FDF0");
 #define PROPERTY_PRODUCT_MODEL "ro.product.model"
 #endif
 #define DEFAULT_LOCAL_NAME_MAX 31
+
+/* How long remote device updates are held back to merge them, 0 disables */
+#define PROPERTY_COALESCE_WINDOW_MS "persist.bluetooth.btif_dm.coalesce_ms"
+#define BTIF_DM_DEFAULT_COALESCE_WINDOW_MS 100
 #if (DEFAULT_LOCAL_NAME_MAX > BTM_MAX_LOC_BD_NAME_LEN)
 #error "default btif local name size exceeds stack supported length"
 #endif
@@ -218,6 +224,22 @@ static size_t btif_events_end_index = 0;
  *****************************************************************************/
 static btif_dm_pairing_cb_t pairing_cb;
 static btif_dm_oob_cb_t oob_cb;
+
+/* Found devices and remote device properties reach the upper layer at most
+ * once per coalescing window; what comes within a window is merged per device
+ * and delivered when it closes. Only accessed on the JNI thread. */
+static BtifPropertyCoalescer device_found_coalescer;
+static BtifPropertyCoalescer remote_properties_coalescer;
+static alarm_t* coalesce_alarm = NULL;
+static uint64_t coalesce_window_ms = 0;
+static bool coalesce_window_open = false;
+static void report_device_found(const RawAddress& bd_addr, int num_properties,
+                                bt_property_t* properties);
+static void report_remote_properties(bt_status_t status,
+                                     const RawAddress& bd_addr,
+                                     int num_properties,
+                                     bt_property_t* properties);
+static void flush_coalesced_reports();
 static void btif_dm_generic_evt(uint16_t event, char* p_param);
 static void btif_dm_cb_create_bond(const RawAddress& bd_addr,
                                    tBTA_TRANSPORT transport);
@@ -311,6 +333,10 @@ static void btif_dm_send_bond_state_changed(RawAddress address, bt_bond_state_t
 
 void btif_dm_init(uid_set_t* set) {
   uid_set = set;
+  int32_t window_ms = osi_property_get_int32(
+      PROPERTY_COALESCE_WINDOW_MS, BTIF_DM_DEFAULT_COALESCE_WINDOW_MS);
+  coalesce_window_ms = window_ms > 0 ? window_ms : 0;
+  coalesce_alarm = alarm_new("btif_dm.coalesce");
   if (bluetooth::shim::is_gd_shim_enabled()) {
     bluetooth::shim::BTIF_DM_SetUiCallback([](RawAddress address, bt_bdname_t bd_name, uint32_t cod, bt_ssp_variant_t pairing_variant, uint32_t pass_key) {
       do_in_jni_thread(FROM_HERE, base::BindOnce([](RawAddress address, bt_bdname_t bd_name, uint32_t cod, bt_ssp_variant_t pairing_variant, uint32_t pass_key) {
@@ -347,6 +373,86 @@ void btif_dm_cleanup(void) {
     uid_set_destroy(uid_set);
     uid_set = NULL;
   }
+
+  alarm_free(coalesce_alarm);
+  coalesce_alarm = NULL;
+  coalesce_window_open = false;
+  device_found_coalescer.Clear();
+  remote_properties_coalescer.Clear();
+  LOG_INFO("%s: %zu found devices reported as %zu, %zu property updates as %zu",
+           __func__, device_found_coalescer.added(),
+           device_found_coalescer.delivered(),
+           remote_properties_coalescer.added(),
+           remote_properties_coalescer.delivered());
+}
+
+static void coalesce_window_closed();
+
+static void coalesce_alarm_cb(UNUSED_ATTR void* data) {
+  do_in_jni_thread(FROM_HERE, base::Bind(&coalesce_window_closed));
+}
+
+static void coalesce_window_closed() {
+  if (!coalesce_window_open) return;
+  if (device_found_coalescer.IsEmpty() &&
+      remote_properties_coalescer.IsEmpty()) {
+    coalesce_window_open = false;
+    return;
+  }
+  // What was held back starts a new window, so that a storm is delivered at
+  // most once per window
+  flush_coalesced_reports();
+  alarm_set(coalesce_alarm, coalesce_window_ms, coalesce_alarm_cb, NULL);
+}
+
+/* Returns true if a report has to wait for the window to close */
+static bool coalesce_report() {
+  if (coalesce_alarm == NULL || coalesce_window_ms == 0) return false;
+  if (coalesce_window_open) return true;
+
+  coalesce_window_open = true;
+  alarm_set(coalesce_alarm, coalesce_window_ms, coalesce_alarm_cb, NULL);
+  return false;
+}
+
+static void report_device_found(const RawAddress& bd_addr, int num_properties,
+                                bt_property_t* properties) {
+  if (coalesce_report()) {
+    device_found_coalescer.Add(bd_addr, num_properties, properties);
+    return;
+  }
+  HAL_CBACK(bt_hal_cbacks, device_found_cb, num_properties, properties);
+}
+
+static void report_remote_properties(bt_status_t status,
+                                     const RawAddress& bd_addr,
+                                     int num_properties,
+                                     bt_property_t* properties) {
+  if (status == BT_STATUS_SUCCESS && coalesce_report()) {
+    remote_properties_coalescer.Add(bd_addr, num_properties, properties);
+    return;
+  }
+  // Keeps a failure from being overtaken by held back properties
+  flush_coalesced_reports();
+  RawAddress tmp = bd_addr;
+  HAL_CBACK(bt_hal_cbacks, remote_device_properties_cb, status, &tmp,
+            num_properties, properties);
+}
+
+/* Delivers what the window held back, ahead of an event that must not
+ * overtake it */
+static void flush_coalesced_reports() {
+  device_found_coalescer.Flush(
+      [](const RawAddress&, int num_properties, bt_property_t* properties) {
+        HAL_CBACK(bt_hal_cbacks, device_found_cb, num_properties, properties);
+      });
+  remote_properties_coalescer.Flush([](const RawAddress& bd_addr,
+                                       int num_properties,
+                                       bt_property_t* properties) {
+    RawAddress tmp = bd_addr;
+    HAL_CBACK(bt_hal_cbacks, remote_device_properties_cb, BT_STATUS_SUCCESS,
+              &tmp, num_properties, properties);
+  });
 }
 
 bt_status_t btif_in_execute_service_request(tBTA_SERVICE_ID service_id,
@@ -542,6 +648,7 @@ bool check_sdp_bl(const RawAddress* remote_bdaddr) {
 static void bond_state_changed(bt_status_t status, const RawAddress& bd_addr,
                                bt_bond_state_t state) {
   btif_stats_add_bond_event(bd_addr, BTIF_DM_FUNC_BOND_STATE_CHANGED, state);
+  flush_coalesced_reports();
 
   if ((pairing_cb.state == state) && (state == BT_BOND_STATE_BONDING)) {
     // Cross key pairing so send callback for static address
@@ -681,9 +788,7 @@ static void btif_update_remote_properties(const RawAddress& bdaddr,
           status);
   num_properties++;
 
-  auto tmp = bdaddr;
-  HAL_CBACK(bt_hal_cbacks, remote_device_properties_cb, status, &tmp,
-            num_properties, properties);
+  report_remote_properties(status, bdaddr, num_properties, properties);
 }
 
 /*******************************************************************************
@@ -1176,8 +1281,7 @@ static void btif_dm_auth_cmpl_evt(tBTA_DM_AUTH_CMPL* p_auth_cmpl) {
       prop.len = Uuid::kNumBytes128;
 
       /* Send the event to the BTIF */
-      HAL_CBACK(bt_hal_cbacks, remote_device_properties_cb, BT_STATUS_SUCCESS,
-                &bd_addr, 1, &prop);
+      report_remote_properties(BT_STATUS_SUCCESS, bd_addr, 1, &prop);
     } else {
       bool is_crosskey = false;
       /* If bonded due to cross-key, save the static address too*/
@@ -1312,8 +1416,7 @@ static void btif_dm_search_devices_evt(uint16_t event, char* p_param) {
             btif_storage_set_remote_device_property(&bdaddr, &properties[0]);
         ASSERTC(status == BT_STATUS_SUCCESS,
                 "failed to save remote device property", status);
-        HAL_CBACK(bt_hal_cbacks, remote_device_properties_cb, status, &bdaddr,
-                  1, properties);
+        report_remote_properties(status, bdaddr, 1, properties);
       }
       /* TODO: Services? */
     } break;
@@ -1411,7 +1514,7 @@ static void btif_dm_search_devices_evt(uint16_t event, char* p_param) {
         ASSERTC(status == BT_STATUS_SUCCESS,
                 "failed to save remote addr type (inquiry)", status);
         /* Callback to notify upper layer of device */
-        HAL_CBACK(bt_hal_cbacks, device_found_cb, num_properties, properties);
+        report_device_found(bdaddr, num_properties, properties);
       }
     } break;
 
@@ -1422,6 +1525,7 @@ static void btif_dm_search_devices_evt(uint16_t event, char* p_param) {
                      nullptr, base::Bind(&bte_scan_filt_param_cfg_evt, 0)));
     } break;
     case BTA_DM_DISC_CMPL_EVT: {
+      flush_coalesced_reports();
       HAL_CBACK(bt_hal_cbacks, discovery_state_changed_cb,
                 BT_DISCOVERY_STOPPED);
     } break;
@@ -1442,6 +1546,7 @@ static void btif_dm_search_devices_evt(uint16_t event, char* p_param) {
             FROM_HERE,
             base::Bind(&BTM_BleAdvFilterParamSetup, BTM_BLE_SCAN_COND_DELETE, 0,
                        nullptr, base::Bind(&bte_scan_filt_param_cfg_evt, 0)));
+        flush_coalesced_reports();
         HAL_CBACK(bt_hal_cbacks, discovery_state_changed_cb,
                   BT_DISCOVERY_STOPPED);
       }
@@ -1526,8 +1631,7 @@ static void btif_dm_search_services_evt(uint16_t event, char* p_param) {
           prop.len = Uuid::kNumBytes128;
 
           /* Send the event to the BTIF */
-          HAL_CBACK(bt_hal_cbacks, remote_device_properties_cb,
-                    BT_STATUS_SUCCESS, &bd_addr, 1, &prop);
+          report_remote_properties(BT_STATUS_SUCCESS, bd_addr, 1, &prop);
           break;
         }
       }
@@ -1538,8 +1642,7 @@ static void btif_dm_search_services_evt(uint16_t event, char* p_param) {
         ASSERTC(ret == BT_STATUS_SUCCESS, "storing remote services failed",
                 ret);
         /* Send the event to the BTIF */
-        HAL_CBACK(bt_hal_cbacks, remote_device_properties_cb, BT_STATUS_SUCCESS,
-                  &bd_addr, 1, &prop);
+        report_remote_properties(BT_STATUS_SUCCESS, bd_addr, 1, &prop);
       }
     } break;
 
@@ -1588,8 +1691,8 @@ static void btif_dm_search_services_evt(uint16_t event, char* p_param) {
         }
 
         /* Send the event to the BTIF */
-        HAL_CBACK(bt_hal_cbacks, remote_device_properties_cb, BT_STATUS_SUCCESS,
-                  &bd_addr, num_properties, prop);
+        report_remote_properties(BT_STATUS_SUCCESS, bd_addr, num_properties,
+                                 prop);
       }
     } break;
 
@@ -1631,8 +1734,7 @@ static void btif_dm_remote_service_record_evt(uint16_t event, char* p_param) {
       /* TODO: Need to get the service name using p_raw_data */
       rec.name[0] = 0;
 
-      HAL_CBACK(bt_hal_cbacks, remote_device_properties_cb, BT_STATUS_SUCCESS,
-                &bd_addr, 1, &prop);
+      report_remote_properties(BT_STATUS_SUCCESS, bd_addr, 1, &prop);
     } break;
 
     default: {
@@ -1763,6 +1865,7 @@ static void btif_dm_upstreams_evt(uint16_t event, char* p_param) {
                     BT_DISCOVERY_STARTED);
           btif_dm_inquiry_in_progress = true;
         } else if (p_data->busy_level.level_flags == BTM_BL_INQUIRY_CANCELLED) {
+          flush_coalesced_reports();
           HAL_CBACK(bt_hal_cbacks, discovery_state_changed_cb,
                     BT_DISCOVERY_STOPPED);
           btif_dm_inquiry_in_progress = false;
@@ -1777,6 +1880,7 @@ static void btif_dm_upstreams_evt(uint16_t event, char* p_param) {
       BTIF_TRACE_DEBUG("BTA_DM_LINK_UP_EVT. Sending BT_ACL_STATE_CONNECTED");
 
       btif_update_remote_version_property(&bd_addr);
+      btif_storage_set_remote_device_last_used(bd_addr);
 
       HAL_CBACK(bt_hal_cbacks, acl_state_changed_cb, BT_STATUS_SUCCESS,
                 &bd_addr, BT_ACL_STATE_CONNECTED);
@@ -1928,10 +2032,7 @@ static void btif_dm_upstreams_evt(uint16_t event, char* p_param) {
       local_le_features.local_privacy_enabled = BTM_BleLocalPrivacyEnabled();
 
       prop.len = sizeof(bt_local_le_features_t);
-      if (cmn_vsc_cb.filter_support == 1)
-        local_le_features.max_adv_filter_supported = cmn_vsc_cb.max_filter;
-      else
-        local_le_features.max_adv_filter_supported = 0;
+      local_le_features.max_adv_filter_supported = BTM_BleMaxAdvFilters();
       local_le_features.max_adv_instance = cmn_vsc_cb.adv_inst_max;
       local_le_features.max_irk_list_size = cmn_vsc_cb.max_irk_list_sz;
       local_le_features.rpa_offload_supported = cmn_vsc_cb.rpa_offloading;
@@ -115,25 +115,6 @@ void btif_gattc_upstreams_evt(uint16_t event, char* p_param) {
       break;
     }
 
-    case BTA_GATTC_NOTIF_EVT: {
-      btgatt_notify_params_t data;
-
-      data.bda = p_data->notify.bda;
-      memcpy(data.value, p_data->notify.value, p_data->notify.len);
-
-      data.handle = p_data->notify.handle;
-      data.is_notify = p_data->notify.is_notify;
-      data.len = p_data->notify.len;
-
-      HAL_CBACK(bt_gatt_callbacks, client->notify_cb, p_data->notify.conn_id,
-                data);
-
-      if (!p_data->notify.is_notify)
-        BTA_GATTC_SendIndConfirm(p_data->notify.conn_id, p_data->notify.handle);
-
-      break;
-    }
-
     case BTA_GATTC_OPEN_EVT: {
       DVLOG(1) << "BTA_GATTC_OPEN_EVT " << p_data->open.remote_bda;
       HAL_CBACK(bt_gatt_callbacks, client->open_cb, p_data->open.conn_id,
@@ -200,7 +181,35 @@ void btif_gattc_upstreams_evt(uint16_t event, char* p_param) {
   }
 }
 
+static void btif_gattc_notify_evt(uint16_t conn_id, RawAddress bda,
+                                  uint16_t handle, bool is_notify,
+                                  std::vector<uint8_t> value) {
+  btgatt_notify_params_t data;
+
+  data.bda = bda;
+  memcpy(data.value, value.data(), value.size());
+
+  data.handle = handle;
+  data.is_notify = is_notify;
+  data.len = value.size();
+
+  HAL_CBACK(bt_gatt_callbacks, client->notify_cb, conn_id, data);
+
+  if (!is_notify) BTA_GATTC_SendIndConfirm(conn_id, handle);
+}
+
 void bta_gattc_cback(tBTA_GATTC_EVT event, tBTA_GATTC* p_data) {
+  // Only the value is transferred, rather than the whole tBTA_GATTC holding
+  // a value of the maximum attribute length
+  if (event == BTA_GATTC_NOTIF_EVT) {
+    const tBTA_GATTC_NOTIFY& notify = p_data->notify;
+    btif_transfer_context(
+        FROM_HERE, &btif_gattc_notify_evt, notify.conn_id, notify.bda,
+        notify.handle, notify.is_notify,
+        std::vector<uint8_t>(notify.value, notify.value + notify.len));
+    return;
+  }
+
   bt_status_t status =
       btif_transfer_context(btif_gattc_upstreams_evt, (uint16_t)event,
                             (char*)p_data, sizeof(tBTA_GATTC), NULL);
@@ -358,8 +358,9 @@ static void btif_hf_upstreams_evt(uint16_t event, char* p_param) {
           bt_hf_callbacks->ConnectionStateCallback(
               BTHF_CONNECTION_STATE_DISCONNECTED,
               &(btif_hf_cb[idx].connected_bda));
+          btif_queue_advance_by_profile(UUID_SERVCLASS_AG_HANDSFREE,
+                                        btif_hf_cb[idx].connected_bda);
           reset_control_block(&btif_hf_cb[idx]);
-          btif_queue_advance();
         }
       }
       if (p_data->open.status == BTA_AG_SUCCESS) {
@@ -387,7 +388,8 @@ static void btif_hf_upstreams_evt(uint16_t event, char* p_param) {
         reset_control_block(&btif_hf_cb[idx]);
         bt_hf_callbacks->ConnectionStateCallback(btif_hf_cb[idx].state,
                                                  &connected_bda);
-        btif_queue_advance();
+        btif_queue_advance_by_profile(UUID_SERVCLASS_AG_HANDSFREE,
+                                      connected_bda);
       }
       break;
     // SLC and RFCOMM both disconnected
@@ -405,7 +407,8 @@ static void btif_hf_upstreams_evt(uint16_t event, char* p_param) {
                                                &connected_bda);
       if (failed_to_setup_slc) {
         LOG(ERROR) << __func__ << ": failed to setup SLC for " << connected_bda;
-        btif_queue_advance();
+        btif_queue_advance_by_profile(UUID_SERVCLASS_AG_HANDSFREE,
+                                      connected_bda);
       }
       break;
     }
@@ -417,7 +420,8 @@ static void btif_hf_upstreams_evt(uint16_t event, char* p_param) {
       bt_hf_callbacks->ConnectionStateCallback(btif_hf_cb[idx].state,
                                                &btif_hf_cb[idx].connected_bda);
       if (btif_hf_cb[idx].is_initiator) {
-        btif_queue_advance();
+        btif_queue_advance_by_profile(UUID_SERVCLASS_AG_HANDSFREE,
+                                      btif_hf_cb[idx].connected_bda);
       }
       break;
 
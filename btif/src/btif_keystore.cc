@@ -23,7 +23,11 @@
 #include <base/location.h>
 #include <base/logging.h>
 #include <hardware/bluetooth.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <map>
+#include <mutex>
+#include <vector>
 
 using base::Bind;
 using base::Unretained;
@@ -35,6 +39,108 @@ namespace bluetooth_keystore {
 class BluetoothKeystoreInterfaceImpl;
 std::unique_ptr<BluetoothKeystoreInterface> bluetoothKeystoreInstance;
 
+// Decrypted keys, kept in memory that is locked so that it is never swapped
+// out, left out of core dumps, and zeroed when the keys are cleared.
+//
+// Not thread safe.
+class SecureKeyCache {
+ public:
+  SecureKeyCache() {
+    void* arena = mmap(nullptr, sizeof(Slot) * kNumSlots,
+                       PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                       0);
+    if (arena == MAP_FAILED) {
+      LOG(ERROR) << __func__ << ": unable to map the key cache, keys will be "
+                 << "fetched on each use";
+      return;
+    }
+    if (mlock(arena, sizeof(Slot) * kNumSlots) != 0) {
+      LOG(WARNING) << __func__ << ": unable to lock the key cache in memory";
+    }
+    madvise(arena, sizeof(Slot) * kNumSlots, MADV_DONTDUMP);
+    slots_ = static_cast<Slot*>(arena);
+    Clear();
+  }
+
+  ~SecureKeyCache() {
+    if (slots_ == nullptr) return;
+    Clear();
+    munlock(slots_, sizeof(Slot) * kNumSlots);
+    munmap(slots_, sizeof(Slot) * kNumSlots);
+  }
+
+  bool Get(const std::string& prefix, std::string* value) const {
+    auto iter = index_.find(prefix);
+    if (iter == index_.end()) return false;
+    const Slot& slot = slots_[iter->second];
+    value->assign(slot.data, slot.length);
+    return true;
+  }
+
+  bool Contains(const std::string& prefix) const {
+    return index_.find(prefix) != index_.end();
+  }
+
+  // Values that do not fit a slot, or that come when all the slots are in use,
+  // are not kept.
+  void Put(const std::string& prefix, const std::string& value) {
+    auto iter = index_.find(prefix);
+    if (value.size() > sizeof(Slot::data)) {
+      if (iter != index_.end()) Free(iter);
+      LOG(WARNING) << __func__ << ": key too long to be cached, prefix: "
+                   << prefix;
+      return;
+    }
+    if (iter == index_.end()) {
+      if (free_slots_.empty()) {
+        LOG(WARNING) << __func__ << ": key cache full, prefix: " << prefix;
+        return;
+      }
+      iter = index_.emplace(prefix, free_slots_.back()).first;
+      free_slots_.pop_back();
+    }
+    Slot& slot = slots_[iter->second];
+    Zero(&slot, sizeof(slot));
+    memcpy(slot.data, value.data(), value.size());
+    slot.length = value.size();
+  }
+
+  void Clear() {
+    index_.clear();
+    free_slots_.clear();
+    if (slots_ == nullptr) return;
+    Zero(slots_, sizeof(Slot) * kNumSlots);
+    for (size_t i = kNumSlots; i > 0; i--) free_slots_.push_back(i - 1);
+  }
+
+ private:
+  // A link key or an LE key set in hex takes at most 56 chars.
+  struct Slot {
+    uint8_t length;
+    char data[63];
+  };
+  // 32 KiB, within the default RLIMIT_MEMLOCK, holds the keys of some 70
+  // devices bonded over LE.
+  static constexpr size_t kNumSlots = 512;
+
+  // memset() of memory about to be released may be optimized out.
+  static void Zero(void* data, size_t size) {
+    volatile uint8_t* p = static_cast<volatile uint8_t*>(data);
+    while (size--) *p++ = 0;
+  }
+
+  void Free(std::map<std::string, size_t>::iterator iter) {
+    Zero(&slots_[iter->second], sizeof(Slot));
+    free_slots_.push_back(iter->second);
+    index_.erase(iter);
+  }
+
+  Slot* slots_ = nullptr;
+  // Prefixes name the device and the key, they are not secret.
+  std::map<std::string, size_t> index_;
+  std::vector<size_t> free_slots_;
+};
+
 class BluetoothKeystoreInterfaceImpl
     : public bluetooth::bluetooth_keystore::BluetoothKeystoreInterface,
       public bluetooth::bluetooth_keystore::BluetoothKeystoreCallbacks {
@@ -42,20 +148,24 @@ class BluetoothKeystoreInterfaceImpl
 
   void init(BluetoothKeystoreCallbacks* callbacks) override {
     VLOG(2) << __func__;
+    std::lock_guard<std::mutex> lock(mutex);
     this->callbacks = callbacks;
+    if (!pending_prefetch.empty()) post_prefetch();
   }
 
   void set_encrypt_key_or_remove_key(std::string prefix,
                                      std::string decryptedString) override {
     VLOG(2) << __func__ << " prefix: " << prefix;
 
+    std::lock_guard<std::mutex> lock(mutex);
     if (!callbacks) {
       LOG(WARNING) << __func__ << " callback isn't ready. prefix: " << prefix;
       return;
     }
 
-    // Save the value into a map.
-    key_map[prefix] = decryptedString;
+    // Save the value into the cache.
+    key_cache.Put(prefix, decryptedString);
+    generation++;
 
     do_in_jni_thread(
         base::Bind(&bluetooth::bluetooth_keystore::BluetoothKeystoreCallbacks::
@@ -66,21 +176,29 @@ class BluetoothKeystoreInterfaceImpl
   std::string get_key(std::string prefix) override {
     VLOG(2) << __func__ << " prefix: " << prefix;
 
-    if (!callbacks) {
-      LOG(WARNING) << __func__ << " callback isn't ready. prefix: " << prefix;
-      return "";
+    BluetoothKeystoreCallbacks* keystore_callbacks;
+    uint64_t fetch_generation;
+    std::string decryptedString;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!callbacks) {
+        LOG(WARNING) << __func__ << " callback isn't ready. prefix: " << prefix;
+        return "";
+      }
+      // try to find the key.
+      if (key_cache.Get(prefix, &decryptedString)) return decryptedString;
+      keystore_callbacks = callbacks;
+      fetch_generation = generation;
     }
 
-    std::string decryptedString;
-    // try to find the key.
-    std::map<std::string, std::string>::iterator iter = key_map.find(prefix);
-    if (iter == key_map.end()) {
-      decryptedString = callbacks->get_key(prefix);
-      // Save the value into a map.
-      key_map[prefix] = decryptedString;
-      VLOG(2) << __func__ << ": get key from bluetoothkeystore.";
-    } else {
-      decryptedString = iter->second;
+    // The keystore round trip is made without the lock, so that it does not
+    // hold up reads of cached keys. The key fetched is only cached if no key
+    // was set and the cache was not cleared meanwhile, since it may be stale.
+    decryptedString = keystore_callbacks->get_key(prefix);
+    VLOG(2) << __func__ << ": get key from bluetoothkeystore.";
+    std::lock_guard<std::mutex> lock(mutex);
+    if (generation == fetch_generation && !key_cache.Contains(prefix)) {
+      key_cache.Put(prefix, decryptedString);
     }
     return decryptedString;
   }
@@ -88,14 +206,59 @@ class BluetoothKeystoreInterfaceImpl
   void clear_map() override {
     VLOG(2) << __func__;
 
-    std::map<std::string, std::string> empty_map;
-    key_map.swap(empty_map);
-    key_map.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    key_cache.Clear();
+    pending_prefetch.clear();
+    generation++;
+  }
+
+  void prefetch_keys(std::vector<std::string> prefixes) override {
+    VLOG(2) << __func__ << ": " << prefixes.size() << " keys";
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pending_prefetch.insert(pending_prefetch.end(), prefixes.begin(),
+                            prefixes.end());
+    // Until the callbacks are registered, the keys wait in pending_prefetch.
+    if (callbacks) post_prefetch();
   }
 
  private:
+  // Called with |mutex| held.
+  void post_prefetch() {
+    do_in_jni_thread(base::Bind(&BluetoothKeystoreInterfaceImpl::prefetch,
+                                base::Unretained(this)));
+  }
+
+  // Fetch the pending keys, if any, one after another on the JNI thread, ahead
+  // of the reconnections that need them.
+  void prefetch() {
+    std::vector<std::string> prefixes;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      prefixes.swap(pending_prefetch);
+    }
+    if (prefixes.empty()) return;
+    size_t fetched = 0;
+    for (const auto& prefix : prefixes) {
+      std::string decryptedString;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!callbacks) return;
+        if (key_cache.Get(prefix, &decryptedString)) continue;
+      }
+      get_key(prefix);
+      fetched++;
+    }
+    LOG(INFO) << __func__ << ": fetched " << fetched << " of "
+              << prefixes.size() << " keys";
+  }
+
+  std::mutex mutex;
   BluetoothKeystoreCallbacks* callbacks = nullptr;
-  std::map<std::string, std::string> key_map;
+  SecureKeyCache key_cache;
+  // Bumped when a key is set and when the cache is cleared
+  uint64_t generation = 0;
+  std::vector<std::string> pending_prefetch;
 };
 
 BluetoothKeystoreInterface* getBluetoothKeystoreInterface() {
@@ -42,7 +42,6 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
-#include <sys/poll.h>
 #include <sys/prctl.h>
 #include <sys/select.h>
 #include <sys/socket.h>
@@ -88,8 +87,6 @@
                        __func__, #s, __LINE__)                           \
   } while (0)
 
-#define MIN(x, y) (((x) < (y)) ? (x) : (y))
-
 btpan_cb_t btpan_cb;
 
 static bool jni_initialized;
@@ -409,34 +406,16 @@ int btpan_tap_open() {
   return INVALID_FD;
 }
 
-int btpan_tap_send(int tap_fd, const RawAddress& src, const RawAddress& dst,
-                   uint16_t proto, const char* buf, uint16_t len,
-                   UNUSED_ATTR bool ext, UNUSED_ATTR bool forward) {
-  if (tap_fd != INVALID_FD) {
-    tETH_HDR eth_hdr;
-    eth_hdr.h_dest = dst;
-    eth_hdr.h_src = src;
-    eth_hdr.h_proto = htons(proto);
-    char packet[TAP_MAX_PKT_WRITE_LEN + sizeof(tETH_HDR)];
-    memcpy(packet, &eth_hdr, sizeof(tETH_HDR));
-    if (len > TAP_MAX_PKT_WRITE_LEN) {
-      LOG_ERROR("btpan_tap_send eth packet size:%d is exceeded limit!", len);
-      return -1;
-    }
-    memcpy(packet + sizeof(tETH_HDR), buf, len);
-
-    /* Send data to network interface */
-    ssize_t ret;
-    OSI_NO_INTR(ret = write(tap_fd, packet, len + sizeof(tETH_HDR)));
-    BTIF_TRACE_DEBUG("ret:%d", ret);
-    return (int)ret;
-  }
-  return -1;
+// Frees the buffers kept by btu_exec_tap_fd_read, from the same thread.
+static void btpan_free_tap_bufs() {
+  osi_free_and_reset((void**)&btpan_cb.congest_buf);
+  osi_free_and_reset((void**)&btpan_cb.spare_buf);
 }
 
 int btpan_tap_close(int fd) {
   if (tap_if_down(TAP_IF_NAME) == 0) close(fd);
   if (pan_pth >= 0) btsock_thread_wakeup(pan_pth);
+  do_in_main_thread(FROM_HERE, base::Bind(btpan_free_tap_bufs));
   return 0;
 }
 
@@ -664,83 +643,55 @@ static void bta_pan_callback(tBTA_PAN_EVT event, tBTA_PAN* p_data) {
                         sizeof(tBTA_PAN), NULL);
 }
 
-#define IS_EXCEPTION(e) ((e) & (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL))
 static void btu_exec_tap_fd_read(int fd) {
-  struct pollfd ufd;
-
   if (fd == INVALID_FD || fd != btpan_cb.tap_fd) return;
 
   // Don't occupy BTU context too long, avoid buffer overruns and
   // give other profiles a chance to run by limiting the amount of memory
   // PAN can use.
   for (int i = 0; i < PAN_BUF_MAX && btif_is_enabled() && btpan_cb.flow; i++) {
-    BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
-    buffer->offset = PAN_MINIMUM_OFFSET;
-    buffer->len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
-
-    uint8_t* packet = (uint8_t*)buffer + sizeof(BT_HDR) + buffer->offset;
-
-    // If we don't have an undelivered packet left over, pull one from the TAP
-    // driver.
-    // We save it in the congest_packet right away in case we can't deliver it
-    // in this
-    // attempt.
-    if (!btpan_cb.congest_packet_size) {
-      ssize_t ret;
-      OSI_NO_INTR(ret = read(fd, btpan_cb.congest_packet,
-                             sizeof(btpan_cb.congest_packet)));
-      switch (ret) {
-        case -1:
-          BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__,
-                           strerror(errno));
-          osi_free(buffer);
+    // If we don't have an undelivered frame left over, pull one from the TAP
+    // driver, straight into the buffer sent to BNEP. It is kept in
+    // congest_buf in case we can't deliver it in this attempt.
+    if (btpan_cb.congest_buf == NULL) {
+      BT_HDR* buffer = btpan_cb.spare_buf;
+      btpan_cb.spare_buf = NULL;
+      if (buffer == NULL) buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
+      buffer->offset = PAN_MINIMUM_OFFSET;
+      buffer->len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
+
+      ssize_t ret = btpan_tap_read_frame(fd, &btpan_cb.congest_eth_hdr, buffer);
+      if (ret <= 0) {
+        // Keep the buffer for the next read
+        btpan_cb.spare_buf = buffer;
+        if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (ret == -1) {
+          LOG_ERROR("%s: unable to read from driver: %s", __func__,
+                    strerror(errno));
           // add fd back to monitor thread to try it again later
-          btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-          return;
-        case 0:
-          BTIF_TRACE_WARNING("%s end of file reached.", __func__);
-          osi_free(buffer);
+        } else {
+          LOG_WARN("%s: end of file reached.", __func__);
           // add fd back to monitor thread to process the exception
-          btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-          return;
-        default:
-          btpan_cb.congest_packet_size = ret;
-          break;
+        }
+        btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
+        return;
       }
-    }
 
-    memcpy(packet, btpan_cb.congest_packet,
-           MIN(btpan_cb.congest_packet_size, buffer->len));
-    buffer->len = MIN(btpan_cb.congest_packet_size, buffer->len);
-
-    if (buffer->len > sizeof(tETH_HDR) && should_forward((tETH_HDR*)packet)) {
-      // Extract the ethernet header from the buffer since the PAN_WriteBuf
-      // inside
-      // forward_bnep can't handle two pointers that point inside the same GKI
-      // buffer.
-      tETH_HDR hdr;
-      memcpy(&hdr, packet, sizeof(tETH_HDR));
-
-      // Skip the ethernet header.
-      buffer->len -= sizeof(tETH_HDR);
-      buffer->offset += sizeof(tETH_HDR);
-      if (forward_bnep(&hdr, buffer) != FORWARD_CONGEST)
-        btpan_cb.congest_packet_size = 0;
-    } else {
-      BTIF_TRACE_WARNING("%s dropping packet of length %d", __func__,
-                         buffer->len);
-      btpan_cb.congest_packet_size = 0;
-      osi_free(buffer);
+      if (ret <= (ssize_t)sizeof(tETH_HDR) ||
+          !should_forward(&btpan_cb.congest_eth_hdr)) {
+        LOG_WARN("%s: dropping packet of length %zd", __func__, ret);
+        btpan_cb.spare_buf = buffer;
+        continue;
+      }
+      btpan_cb.congest_buf = buffer;
     }
 
-    // Bail out of the loop if reading from the TAP fd would block.
-    ufd.fd = fd;
-    ufd.events = POLLIN;
-    ufd.revents = 0;
-
-    int ret;
-    OSI_NO_INTR(ret = poll(&ufd, 1, 0));
-    if (ret <= 0 || IS_EXCEPTION(ufd.revents)) break;
+    // BNEP keeps the buffer on success, frees it on failure and gives it back
+    // on congestion.
+    if (forward_bnep(&btpan_cb.congest_eth_hdr, btpan_cb.congest_buf) ==
+        FORWARD_CONGEST)
+      break;
+    btpan_cb.congest_buf = NULL;
   }
 
   if (btpan_cb.flow) {
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_pan_tap.cc
+ *
+ *  Description:   PAN TAP interface datapath. The ethernet frames are moved
+ *                 between the TAP driver and the BNEP buffers with scatter /
+ *                 gather I/O, without staging them in a separate buffer.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btif_pan"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "bt_common.h"
+#include "btif_pan_internal.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+
+int btpan_tap_send(int tap_fd, const RawAddress& src, const RawAddress& dst,
+                   uint16_t proto, const char* buf, uint16_t len,
+                   UNUSED_ATTR bool ext, UNUSED_ATTR bool forward) {
+  if (tap_fd == INVALID_FD) return -1;
+
+  if (len > TAP_MAX_PKT_WRITE_LEN) {
+    LOG_ERROR("%s: eth packet size:%d is exceeded limit!", __func__, len);
+    return -1;
+  }
+
+  tETH_HDR eth_hdr;
+  eth_hdr.h_dest = dst;
+  eth_hdr.h_src = src;
+  eth_hdr.h_proto = htons(proto);
+
+  // The TAP driver takes one frame per write, gathered from the header and
+  // the payload where they are.
+  struct iovec iov[2];
+  iov[0].iov_base = &eth_hdr;
+  iov[0].iov_len = sizeof(tETH_HDR);
+  iov[1].iov_base = const_cast<char*>(buf);
+  iov[1].iov_len = len;
+
+  /* Send data to network interface */
+  ssize_t ret;
+  OSI_NO_INTR(ret = writev(tap_fd, iov, 2));
+  if (ret == -1) LOG_ERROR("%s: write failed: %s", __func__, strerror(errno));
+  return (int)ret;
+}
+
+ssize_t btpan_tap_read_frame(int tap_fd, tETH_HDR* p_eth_hdr, BT_HDR* p_buf) {
+  // The TAP driver returns one frame per read, scattered into the header and
+  // the payload area of |p_buf|. The part of a frame larger than the buffer
+  // is dropped by the driver.
+  struct iovec iov[2];
+  iov[0].iov_base = p_eth_hdr;
+  iov[0].iov_len = sizeof(tETH_HDR);
+  iov[1].iov_base = (uint8_t*)(p_buf + 1) + p_buf->offset;
+  iov[1].iov_len = p_buf->len;
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = readv(tap_fd, iov, 2));
+  p_buf->len = ret > (ssize_t)sizeof(tETH_HDR) ? ret - sizeof(tETH_HDR) : 0;
+  return ret;
+}
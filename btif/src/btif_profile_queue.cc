@@ -33,10 +33,18 @@
 #include <base/logging.h>
 #include <base/strings/stringprintf.h>
 #include <string.h>
+#include <algorithm>
 #include <list>
+#include <map>
+#include <set>
+#include <vector>
 
 #include "bt_common.h"
 #include "btif_common.h"
+#include "btif_storage.h"
+#include "btm_api.h"
+#include "sdpdefs.h"
+#include "common/time_util.h"
 #include "stack_manager.h"
 
 /*******************************************************************************
@@ -48,7 +56,13 @@ class ConnectNode {
  public:
   ConnectNode(const RawAddress& address, uint16_t uuid,
               btif_connect_cb_t connect_cb)
-      : address_(address), uuid_(uuid), busy_(false), connect_cb_(connect_cb) {}
+      : address_(address),
+        uuid_(uuid),
+        busy_(false),
+        connect_cb_(connect_cb),
+        last_used_(btif_storage_get_remote_device_last_used(address)),
+        queued_ms_(bluetooth::common::time_get_os_boottime_ms()),
+        started_ms_(0) {}
 
   std::string ToString() const {
     return base::StringPrintf("address=%s UUID=%04X busy=%s",
@@ -58,6 +72,10 @@ class ConnectNode {
 
   const RawAddress& address() const { return address_; }
   uint16_t uuid() const { return uuid_; }
+  bool busy() const { return busy_; }
+  int last_used() const { return last_used_; }
+  uint64_t queued_ms() const { return queued_ms_; }
+  uint64_t started_ms() const { return started_ms_; }
 
   /**
    * Initiate the connection.
@@ -69,6 +87,7 @@ class ConnectNode {
   bt_status_t connect() {
     if (busy_) return BT_STATUS_SUCCESS;
     busy_ = true;
+    started_ms_ = bluetooth::common::time_get_os_boottime_ms();
     return connect_cb_(&address_, uuid_);
   }
 
@@ -77,6 +96,9 @@ class ConnectNode {
   uint16_t uuid_;
   bool busy_;
   btif_connect_cb_t connect_cb_;
+  int last_used_;
+  uint64_t queued_ms_;
+  uint64_t started_ms_;
 };
 
 /*******************************************************************************
@@ -87,6 +109,22 @@ static std::list<ConnectNode> connect_queue;
 
 static const size_t MAX_REASONABLE_REQUESTS = 20;
 
+// Requests for different devices run side by side, so that one device's
+// profile setup overlaps with the next device's page. Requests for the same
+// device still run one at a time.
+static const size_t MAX_CONCURRENT_DEVICES = 4;
+
+// When the ACL to a device is already up, requests for these profiles run
+// side by side with each other: they use separate SDP records and L2CAP
+// channels, so HFP no longer has to wait for A2DP (or the reverse) to open.
+static const std::set<uint16_t> kParallelUuids = {
+    UUID_SERVCLASS_AG_HANDSFREE, UUID_SERVCLASS_HF_HANDSFREE,
+    UUID_SERVCLASS_AUDIO_SOURCE, UUID_SERVCLASS_AUDIO_SINK};
+
+// Time at which the first pending request of each device was queued, used to
+// report how long the device took to get all its profiles up.
+static std::map<RawAddress, uint64_t> device_queued_ms;
+
 /*******************************************************************************
  *  Queue helper functions
  ******************************************************************************/
@@ -107,18 +145,70 @@ static void queue_int_add(uint16_t uuid, const RawAddress& bda,
 
   LOG_INFO("%s: adding connection request: %s", __func__,
            param.ToString().c_str());
+  device_queued_ms.emplace(bda, param.queued_ms());
   connect_queue.push_back(param);
 
   btif_queue_connect_next();
 }
 
+static bool queue_int_has_device(const RawAddress& bda) {
+  for (const auto& node : connect_queue) {
+    if (node.address() == bda) return true;
+  }
+  return false;
+}
+
+static void queue_int_remove(std::list<ConnectNode>::iterator it) {
+  uint64_t removed_ms = bluetooth::common::time_get_os_boottime_ms();
+  LOG_INFO("%s: removing connection request: %s, waited %llu ms, took %llu ms",
+           __func__, it->ToString().c_str(),
+           (unsigned long long)(it->started_ms() - it->queued_ms()),
+           (unsigned long long)(removed_ms - it->started_ms()));
+  RawAddress bda = it->address();
+  connect_queue.erase(it);
+
+  if (queue_int_has_device(bda)) return;
+  auto first = device_queued_ms.find(bda);
+  if (first == device_queued_ms.end()) return;
+  LOG_INFO("%s: all connection requests for %s done in %llu ms", __func__,
+           bda.ToString().c_str(),
+           (unsigned long long)(removed_ms - first->second));
+  device_queued_ms.erase(first);
+}
+
 static void queue_int_advance() {
-  if (connect_queue.empty()) return;
+  auto it = std::find_if(connect_queue.begin(), connect_queue.end(),
+                         [](const ConnectNode& node) { return node.busy(); });
+  if (it == connect_queue.end()) return;
+
+  queue_int_remove(it);
+
+  btif_queue_connect_next();
+}
+
+static void queue_int_advance_by_address(const RawAddress& bda) {
+  auto it = std::find_if(
+      connect_queue.begin(), connect_queue.end(),
+      [&bda](const ConnectNode& node) {
+        return node.busy() && node.address() == bda;
+      });
+  if (it == connect_queue.end()) return;
+
+  queue_int_remove(it);
+
+  btif_queue_connect_next();
+}
 
-  const ConnectNode& head = connect_queue.front();
-  LOG_INFO("%s: removing connection request: %s", __func__,
-           head.ToString().c_str());
-  connect_queue.pop_front();
+static void queue_int_advance_by_profile(uint16_t uuid,
+                                         const RawAddress& bda) {
+  auto it = std::find_if(
+      connect_queue.begin(), connect_queue.end(),
+      [uuid, &bda](const ConnectNode& node) {
+        return node.busy() && node.uuid() == uuid && node.address() == bda;
+      });
+  if (it == connect_queue.end()) return;
+
+  queue_int_remove(it);
 
   btif_queue_connect_next();
 }
@@ -135,9 +225,33 @@ static void queue_int_cleanup(uint16_t uuid) {
       connect_queue.erase(it_prev);
     }
   }
+
+  // Forget the start of the devices left without requests, so that their
+  // next requests are timed from when they are queued
+  for (auto it = device_queued_ms.begin(); it != device_queued_ms.end();) {
+    if (queue_int_has_device(it->first)) {
+      ++it;
+    } else {
+      it = device_queued_ms.erase(it);
+    }
+  }
+}
+
+static void queue_int_release() {
+  connect_queue.clear();
+  device_queued_ms.clear();
 }
 
-static void queue_int_release() { connect_queue.clear(); }
+// Whether |node| may start while |busy_uuids| are in progress for the same
+// device.
+static bool queue_int_can_run_along(const ConnectNode& node,
+                                    const std::set<uint16_t>& busy_uuids) {
+  if (kParallelUuids.count(node.uuid()) == 0) return false;
+  for (uint16_t uuid : busy_uuids) {
+    if (kParallelUuids.count(uuid) == 0) return false;
+  }
+  return BTM_IsAclConnectionUp(node.address(), BT_TRANSPORT_BR_EDR);
+}
 
 /*******************************************************************************
  *
@@ -172,8 +286,9 @@ void btif_queue_cleanup(uint16_t uuid) {
  *
  * Function         btif_queue_advance
  *
- * Description      Clear the queue's busy status and advance to the next
- *                  scheduled connection.
+ * Description      Remove the oldest request in progress and advance to the
+ *                  next scheduled connections. Prefer
+ *                  btif_queue_advance_by_address() when the device is known.
  *
  * Returns          void
  *
@@ -182,6 +297,35 @@ void btif_queue_advance() {
   do_in_jni_thread(FROM_HERE, base::Bind(&queue_int_advance));
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_queue_advance_by_address
+ *
+ * Description      Remove the request in progress for |bda| and advance to
+ *                  the next scheduled connections.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_queue_advance_by_address(const RawAddress& bda) {
+  do_in_jni_thread(FROM_HERE, base::Bind(&queue_int_advance_by_address, bda));
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_queue_advance_by_profile
+ *
+ * Description      Remove the request in progress for |uuid| on |bda| and
+ *                  advance to the next scheduled connections.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_queue_advance_by_profile(uint16_t uuid, const RawAddress& bda) {
+  do_in_jni_thread(FROM_HERE,
+                   base::Bind(&queue_int_advance_by_profile, uuid, bda));
+}
+
 bt_status_t btif_queue_connect_next(void) {
   // The call must be on the JNI thread, otherwise the access to connect_queue
   // is not thread-safe.
@@ -191,17 +335,50 @@ bt_status_t btif_queue_connect_next(void) {
   if (!stack_manager_get_interface()->get_stack_is_running())
     return BT_STATUS_FAIL;
 
-  ConnectNode& head = connect_queue.front();
+  bool retry;
+  do {
+    retry = false;
+    std::map<RawAddress, std::set<uint16_t>> busy_devices;
+    std::vector<std::list<ConnectNode>::iterator> waiting;
+    for (auto it = connect_queue.begin(); it != connect_queue.end(); it++) {
+      if (it->busy()) {
+        busy_devices[it->address()].insert(it->uuid());
+      } else {
+        waiting.push_back(it);
+      }
+    }
 
-  LOG_INFO("%s: executing connection request: %s", __func__,
-           head.ToString().c_str());
-  bt_status_t b_status = head.connect();
-  if (b_status != BT_STATUS_SUCCESS) {
-    LOG_INFO("%s: connect %s failed, advance to next scheduled connection.",
-             __func__, head.ToString().c_str());
-    btif_queue_advance();
-  }
-  return b_status;
+    // Most recently used devices first, so that the accessories the user is
+    // most likely waiting for come back first. Ties keep their queue order.
+    std::stable_sort(waiting.begin(), waiting.end(),
+                     [](std::list<ConnectNode>::iterator a,
+                        std::list<ConnectNode>::iterator b) {
+                       return a->last_used() > b->last_used();
+                     });
+
+    for (auto it : waiting) {
+      auto busy = busy_devices.find(it->address());
+      if (busy == busy_devices.end()) {
+        if (busy_devices.size() >= MAX_CONCURRENT_DEVICES) continue;
+        busy = busy_devices.emplace(it->address(), std::set<uint16_t>()).first;
+      } else if (!queue_int_can_run_along(*it, busy->second)) {
+        continue;
+      }
+      busy->second.insert(it->uuid());
+
+      LOG_INFO("%s: executing connection request: %s", __func__,
+               it->ToString().c_str());
+      bt_status_t b_status = it->connect();
+      if (b_status != BT_STATUS_SUCCESS) {
+        LOG_INFO("%s: connect %s failed, advance to next scheduled connection.",
+                 __func__, it->ToString().c_str());
+        queue_int_remove(it);
+        retry = true;
+        break;
+      }
+    }
+  } while (retry);
+  return BT_STATUS_SUCCESS;
 }
 
 /*******************************************************************************
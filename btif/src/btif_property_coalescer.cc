@@ -0,0 +1,75 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "btif_property_coalescer.h"
+
+bool BtifPropertyCoalescer::Add(const RawAddress& bd_addr, int num_properties,
+                                const bt_property_t* properties) {
+  bool was_empty = devices_.empty();
+  added_++;
+
+  Device* device = nullptr;
+  for (Device& pending : devices_) {
+    if (pending.bd_addr == bd_addr) {
+      device = &pending;
+      break;
+    }
+  }
+  if (device == nullptr) {
+    devices_.push_back({bd_addr, {}});
+    device = &devices_.back();
+  }
+
+  for (int i = 0; i < num_properties; i++) {
+    const uint8_t* val = static_cast<const uint8_t*>(properties[i].val);
+    std::vector<uint8_t> value(val, val + properties[i].len);
+
+    Property* property = nullptr;
+    for (Property& pending : device->properties) {
+      if (pending.type == properties[i].type) {
+        property = &pending;
+        break;
+      }
+    }
+    if (property == nullptr) {
+      device->properties.push_back({properties[i].type, std::move(value)});
+    } else {
+      property->value = std::move(value);
+    }
+  }
+  return was_empty;
+}
+
+size_t BtifPropertyCoalescer::Flush(const DeliverCallback& deliver) {
+  // Taken first so that |deliver| may add again
+  std::vector<Device> devices;
+  devices.swap(devices_);
+
+  std::vector<bt_property_t> properties;
+  for (Device& device : devices) {
+    properties.clear();
+    for (Property& property : device.properties) {
+      properties.push_back({property.type,
+                            static_cast<int>(property.value.size()),
+                            property.value.data()});
+    }
+    deliver(device.bd_addr, properties.size(), properties.data());
+  }
+  delivered_ += devices.size();
+  return devices.size();
+}
+
+void BtifPropertyCoalescer::Clear() { devices_.clear(); }
@@ -17,6 +17,7 @@
 
 #include "btif_sock_l2cap.h"
 
+#include <base/bind.h>
 #include <base/logging.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -24,8 +25,7 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
-#include <vector>
-
+#include <algorithm>
 #include <mutex>
 
 #include <frameworks/base/core/proto/android/bluetooth/enums.pb.h>
@@ -48,6 +48,7 @@
 #include "btm_int.h"
 #include "btu.h"
 #include "common/metrics.h"
+#include "common/time_util.h"
 #include "hcimsgs.h"
 #include "l2c_api.h"
 #include "l2c_int.h"
@@ -55,10 +56,11 @@
 #include "port_api.h"
 #include "sdp_api.h"
 
+using bluetooth::common::time_get_os_boottime_ms;
+
 struct packet {
   struct packet *next, *prev;
-  uint32_t len;
-  uint8_t* data;
+  BT_HDR* p_buf;
 };
 
 typedef struct l2cap_socket {
@@ -77,6 +79,8 @@ typedef struct l2cap_socket {
   unsigned bytes_buffered;
   struct packet* first_packet;  // fist packet to be delivered to app
   struct packet* last_packet;   // last packet to be delivered to app
+  // Reads from L2CAP are paused until the app drains the packets buffered
+  bool rx_paused;
 
   unsigned fixed_chan : 1;        // fixed channel (or psm?)
   unsigned server : 1;            // is a server? (or connecting?)
@@ -90,6 +94,11 @@ typedef struct l2cap_socket {
   int64_t tx_bytes;
   // Cumulative number of bytes received on this socket
   int64_t rx_bytes;
+  // Most bytes buffered for the app, and number of times reads from L2CAP
+  // were paused, to size L2CAP_MAX_RX_BUFFER
+  unsigned rx_peak_buffered;
+  unsigned rx_pause_count;
+  uint64_t connect_time_ms;
 } l2cap_socket;
 
 static void btsock_l2cap_server_listen(l2cap_socket* sock);
@@ -104,88 +113,42 @@ static int pth = -1;
 static void btsock_l2cap_cbk(tBTA_JV_EVT event, tBTA_JV* p_data,
                              uint32_t l2cap_socket_id);
 
-/* TODO: Consider to remove this buffer, as we have a buffer in l2cap as well,
- * and we risk
- *       a buffer overflow with this implementation if the socket data is not
- * read from
- *       JAVA for a while. In such a case we should use flow control to tell the
- * sender to
- *       back off.
- *       BUT remember we need to avoid blocking the BTA task execution - hence
- * we cannot
- *       directly write to the socket.
- *       we should be able to change to store the data pointer here, and just
- * wait
- *       confirming the l2cap_ind until we have more space in the buffer. */
-
-/* returns false if none - caller must free "data" memory when done with it */
-static char packet_get_head_l(l2cap_socket* sock, uint8_t** data,
-                              uint32_t* len) {
+/* The packets received are queued here until the app reads them from the
+ * socket, without copying them. Once L2CAP_MAX_RX_BUFFER bytes are queued, the
+ * packets of PSM based channels are left in the L2CAP receive queue, and read
+ * again as the app drains this queue: the app gets the packets as they arrive,
+ * at the pace it parses them. The connection is still dropped if more than
+ * L2CAP_MAX_RX_PENDING bytes pile up below. */
+
+/* returns the first packet to be delivered to app, NULL if none */
+static BT_HDR* packet_peek_head_l(l2cap_socket* sock) {
+  return sock->first_packet ? sock->first_packet->p_buf : NULL;
+}
+
+/* removes the first packet, NULL if none - caller must free it */
+static BT_HDR* packet_get_head_l(l2cap_socket* sock) {
   struct packet* p = sock->first_packet;
 
-  if (!p) return false;
+  if (!p) return NULL;
 
-  if (data) *data = sock->first_packet->data;
-  if (len) *len = sock->first_packet->len;
+  BT_HDR* p_buf = p->p_buf;
   sock->first_packet = p->next;
   if (sock->first_packet)
     sock->first_packet->prev = NULL;
   else
     sock->last_packet = NULL;
 
-  if (len) sock->bytes_buffered -= *len;
+  sock->bytes_buffered -= p_buf->len;
 
   osi_free(p);
 
-  return true;
+  return p_buf;
 }
 
-static struct packet* packet_alloc(const uint8_t* data, uint32_t len) {
+/* takes ownership of p_buf */
+static void packet_put_tail_l(l2cap_socket* sock, BT_HDR* p_buf) {
   struct packet* p = (struct packet*)osi_calloc(sizeof(*p));
-  uint8_t* buf = (uint8_t*)osi_malloc(len);
-
-  p->data = buf;
-  p->len = len;
-  memcpy(p->data, data, len);
-  return p;
-}
-
-/* makes a copy of the data, returns true on success */
-static char packet_put_head_l(l2cap_socket* sock, const void* data,
-                              uint32_t len) {
-  struct packet* p = packet_alloc((const uint8_t*)data, len);
-
-  /*
-   * We do not check size limits here since this is used to undo "getting" a
-   * packet that the user read incompletely. That is to say the packet was
-   * already in the queue. We do check thos elimits in packet_put_tail_l() since
-   * that function is used to put new data into the queue.
-   */
-
-  if (!p) return false;
-
-  p->prev = NULL;
-  p->next = sock->first_packet;
-  sock->first_packet = p;
-  if (p->next)
-    p->next->prev = p;
-  else
-    sock->last_packet = p;
-
-  sock->bytes_buffered += len;
-
-  return true;
-}
-
-/* makes a copy of the data, returns true on success */
-static char packet_put_tail_l(l2cap_socket* sock, const void* data,
-                              uint32_t len) {
-  if (sock->bytes_buffered >= L2CAP_MAX_RX_BUFFER) {
-    LOG(ERROR) << __func__ << ": buffer overflow";
-    return false;
-  }
-
-  struct packet* p = packet_alloc((const uint8_t*)data, len);
+  p->p_buf = p_buf;
   p->next = NULL;
   p->prev = sock->last_packet;
   sock->last_packet = p;
@@ -194,9 +157,13 @@ static char packet_put_tail_l(l2cap_socket* sock, const void* data,
   else
     sock->first_packet = p;
 
-  sock->bytes_buffered += len;
+  sock->bytes_buffered += p_buf->len;
+  sock->rx_peak_buffered =
+      std::max(sock->rx_peak_buffered, sock->bytes_buffered);
+}
 
-  return true;
+static bool packet_queue_full_l(l2cap_socket* sock) {
+  return sock->bytes_buffered >= L2CAP_MAX_RX_BUFFER;
 }
 
 static char is_inited(void) {
@@ -214,7 +181,7 @@ static l2cap_socket* btsock_l2cap_find_by_id_l(uint32_t id) {
 }
 
 static void btsock_l2cap_free_l(l2cap_socket* sock) {
-  uint8_t* buf;
+  BT_HDR* p_buf;
   l2cap_socket* t = socks;
 
   while (t && t != sock) t = t->next;
@@ -230,6 +197,14 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
       sock->server ? android::bluetooth::SOCKET_ROLE_LISTEN
                    : android::bluetooth::SOCKET_ROLE_CONNECTION);
 
+  if (sock->rx_bytes) {
+    uint64_t duration_ms = time_get_os_boottime_ms() - sock->connect_time_ms;
+    LOG(INFO) << __func__ << ": id " << sock->id << " received "
+              << sock->rx_bytes << " bytes in " << duration_ms
+              << " ms, peak buffered " << sock->rx_peak_buffered
+              << " bytes, reads paused " << sock->rx_pause_count << " times";
+  }
+
   if (sock->next) sock->next->prev = sock->prev;
 
   if (sock->prev)
@@ -245,7 +220,7 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
     LOG(ERROR) << "SOCK_LIST: free(id = " << sock->id << ") - NO app_fd!";
   }
 
-  while (packet_get_head_l(sock, &buf, NULL)) osi_free(buf);
+  while ((p_buf = packet_get_head_l(sock)) != NULL) osi_free(p_buf);
 
   // lower-level close() should be idempotent... so let's call it and see...
   if (sock->is_le_coc) {
@@ -463,6 +438,7 @@ static void on_srv_l2cap_psm_connect_l(tBTA_JV_L2CAP_OPEN* p_open,
   l2cap_socket* accept_rs =
       btsock_l2cap_alloc_l(sock->name, &p_open->rem_bda, false, 0);
   accept_rs->connected = true;
+  accept_rs->connect_time_ms = time_get_os_boottime_ms();
   accept_rs->security = sock->security;
   accept_rs->fixed_chan = sock->fixed_chan;
   accept_rs->channel = sock->channel;
@@ -518,6 +494,7 @@ static void on_srv_l2cap_le_connect_l(tBTA_JV_L2CAP_LE_OPEN* p_open,
 
   accept_rs->handle = p_open->handle;
   accept_rs->connected = true;
+  accept_rs->connect_time_ms = time_get_os_boottime_ms();
   accept_rs->security = sock->security;
   accept_rs->fixed_chan = sock->fixed_chan;
   accept_rs->channel = sock->channel;
@@ -578,6 +555,7 @@ static void on_cl_l2cap_psm_connect_l(tBTA_JV_L2CAP_OPEN* p_open,
   btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_RD,
                        sock->id);
   sock->connected = true;
+  sock->connect_time_ms = time_get_os_boottime_ms();
 }
 
 static void on_cl_l2cap_le_connect_l(tBTA_JV_L2CAP_LE_OPEN* p_open,
@@ -609,6 +587,7 @@ static void on_cl_l2cap_le_connect_l(tBTA_JV_L2CAP_LE_OPEN* p_open,
   btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_RD,
                        sock->id);
   sock->connected = true;
+  sock->connect_time_ms = time_get_os_boottime_ms();
 }
 
 static void on_l2cap_connect(tBTA_JV* p_data, uint32_t id) {
@@ -699,6 +678,50 @@ static void on_l2cap_write_done(uint16_t len, uint32_t id) {
   uid_set_add_tx(uid_set, app_uid, len);
 }
 
+/* Moves the packets received on a PSM based channel from L2CAP to the queue
+ * of the app, until the queue is full. Returns the number of bytes moved. */
+static uint32_t read_incoming_l(l2cap_socket* sock) {
+  uint32_t bytes_read = 0;
+  BT_HDR* p_buf;
+
+  while (!packet_queue_full_l(sock) &&
+         BTA_JvL2capReadBuf(sock->handle, &p_buf) == BTA_JV_SUCCESS) {
+    bytes_read += p_buf->len;
+    packet_put_tail_l(sock, p_buf);
+  }
+
+  if (packet_queue_full_l(sock) && !sock->rx_paused) {
+    DVLOG(2) << __func__ << ": app not keeping up, pausing reads";
+    sock->rx_paused = true;
+    sock->rx_pause_count++;
+  }
+
+  if (bytes_read) {
+    btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
+                         sock->id);
+  }
+
+  return bytes_read;
+}
+
+/* Drops a PSM based connection whose paused reads left more than
+ * L2CAP_MAX_RX_PENDING bytes in the L2CAP receive queue. L2CAP does not
+ * throttle the peer, so without this a peer could grow the heap without limit
+ * against an app that stopped reading. */
+static void drop_if_rx_overflow_l(l2cap_socket* sock) {
+  uint32_t pending = 0;
+  if (!sock->rx_paused ||
+      BTA_JvL2capReady(sock->handle, &pending) != BTA_JV_SUCCESS ||
+      pending <= L2CAP_MAX_RX_PENDING) {
+    return;
+  }
+
+  LOG(ERROR) << __func__ << ": buffer overflow, " << pending
+             << " bytes pending - closing channel";
+  BTA_JvL2capClose(sock->handle);
+  btsock_l2cap_free_l(sock);
+}
+
 static void on_l2cap_data_ind(tBTA_JV* evt, uint32_t id) {
   l2cap_socket* sock;
 
@@ -710,18 +733,26 @@ static void on_l2cap_data_ind(tBTA_JV* evt, uint32_t id) {
   if (!sock) return;
 
   app_uid = sock->app_uid;
+  bool fixed_chan = sock->fixed_chan;
 
-  if (sock->fixed_chan) { /* we do these differently */
+  if (fixed_chan) { /* we do these differently */
 
     tBTA_JV_LE_DATA_IND* p_le_data_ind = &evt->le_data_ind;
     BT_HDR* p_buf = p_le_data_ind->p_buf;
-    uint8_t* data = (uint8_t*)(p_buf + 1) + p_buf->offset;
 
-    if (packet_put_tail_l(sock, data, p_buf->len)) {
+    /* There is no receive queue below fixed channels to hold the packets
+     * while the app catches up */
+    if (!packet_queue_full_l(sock)) {
+      BT_HDR* p_copy = (BT_HDR*)osi_malloc(BT_HDR_SIZE + p_buf->len);
+      p_copy->offset = 0;
+      p_copy->len = p_buf->len;
+      memcpy(p_copy->data, p_buf->data + p_buf->offset, p_buf->len);
+      packet_put_tail_l(sock, p_copy);
       bytes_read = p_buf->len;
       btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
                            sock->id);
     } else {  // connection must be dropped
+      LOG(ERROR) << __func__ << ": buffer overflow";
       DVLOG(2) << __func__
                << ": unable to push data to socket - closing  fixed channel";
       BTA_JvL2capCloseLE(sock->handle);
@@ -729,28 +760,24 @@ static void on_l2cap_data_ind(tBTA_JV* evt, uint32_t id) {
     }
 
   } else {
-    uint32_t count;
-
-    if (BTA_JvL2capReady(sock->handle, &count) == BTA_JV_SUCCESS) {
-      std::vector<uint8_t> buffer(count);
-      if (BTA_JvL2capRead(sock->handle, sock->id, buffer.data(), count) ==
-          BTA_JV_SUCCESS) {
-        if (packet_put_tail_l(sock, buffer.data(), count)) {
-          bytes_read = count;
-          btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP,
-                               SOCK_THREAD_FD_WR, sock->id);
-        } else {  // connection must be dropped
-          DVLOG(2) << __func__
-                   << ": unable to push data to socket - closing channel";
-          BTA_JvL2capClose(sock->handle);
-          btsock_l2cap_free_l(sock);
-        }
-      }
-    }
+    bytes_read = read_incoming_l(sock);
   }
 
   sock->rx_bytes += bytes_read;
   uid_set_add_rx(uid_set, app_uid, bytes_read);
+
+  if (!fixed_chan) drop_if_rx_overflow_l(sock);
+}
+
+/* Resumes the reads from L2CAP once the app drained its queue */
+static void on_l2cap_rx_resume(uint32_t id) {
+  std::unique_lock<std::mutex> lock(state_lock);
+  l2cap_socket* sock = btsock_l2cap_find_by_id_l(id);
+  if (!sock || !sock->connected) return;
+
+  uint32_t bytes_read = read_incoming_l(sock);
+  sock->rx_bytes += bytes_read;
+  uid_set_add_rx(uid_set, sock->app_uid, bytes_read);
 }
 
 static void btsock_l2cap_cbk(tBTA_JV_EVT event, tBTA_JV* p_data,
@@ -967,24 +994,23 @@ bt_status_t btsock_l2cap_connect(const RawAddress* bd_addr, int channel,
  * (for example: unrecoverable error or no data)
  */
 static bool flush_incoming_que_on_wr_signal_l(l2cap_socket* sock) {
-  uint8_t* buf;
-  uint32_t len;
+  BT_HDR* p_buf;
 
-  while (packet_get_head_l(sock, &buf, &len)) {
+  while ((p_buf = packet_peek_head_l(sock)) != NULL) {
     ssize_t sent;
-    OSI_NO_INTR(sent = send(sock->our_fd, buf, len, MSG_DONTWAIT));
+    OSI_NO_INTR(sent = send(sock->our_fd, p_buf->data + p_buf->offset,
+                            p_buf->len, MSG_DONTWAIT));
     int saved_errno = errno;
 
-    if (sent == (signed)len)
-      osi_free(buf);
+    if (sent == (signed)p_buf->len)
+      osi_free(packet_get_head_l(sock));
     else if (sent >= 0) {
-      packet_put_head_l(sock, buf + sent, len - sent);
-      osi_free(buf);
+      p_buf->offset += sent;
+      p_buf->len -= sent;
+      sock->bytes_buffered -= sent;
       if (!sent) /* special case if other end not keeping up */
         return true;
     } else {
-      packet_put_head_l(sock, buf, len);
-      osi_free(buf);
       return saved_errno == EWOULDBLOCK || saved_errno == EAGAIN;
     }
   }
@@ -1065,6 +1091,12 @@ void btsock_l2cap_signaled(int fd, int flags, uint32_t user_id) {
     if (flush_incoming_que_on_wr_signal_l(sock) && sock->connected)
       btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
                            sock->id);
+    /* Read the packets left in L2CAP once half of the queue is drained */
+    if (sock->rx_paused &&
+        sock->bytes_buffered < L2CAP_MAX_RX_BUFFER / 2 && sock->connected) {
+      sock->rx_paused = false;
+      do_in_main_thread(FROM_HERE, base::Bind(&on_l2cap_rx_resume, sock->id));
+    }
   }
   if (drop_it || (flags & SOCK_THREAD_FD_EXCEPTION)) {
     int size = 0;
@@ -26,6 +26,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <mutex>
@@ -69,6 +70,9 @@ using bluetooth::Uuid;
 // Maximum number of devices we can have an RFCOMM connection with.
 #define MAX_RFC_SESSION 7
 
+// Maximum number of queued incoming buffers handed to the app in one call.
+#define MAX_RFC_SEND_IOV 16
+
 typedef struct {
   int outgoing_congest : 1;
   int pending_sdp_request : 1;
@@ -816,10 +820,56 @@ static sent_status_t send_data_to_app(int fd, BT_HDR* p_buf) {
   return SENT_PARTIAL;
 }
 
+// Sends the buffers at the front of |queue| to the app with a single call and
+// removes the ones that were sent completely. SENT_ALL means that every buffer
+// of the batch was sent, more may remain queued.
+static sent_status_t send_queue_to_app(int fd, list_t* queue) {
+  struct iovec iov[MAX_RFC_SEND_IOV];
+  int iov_count = 0;
+  size_t total = 0;
+  for (const list_node_t* node = list_begin(queue);
+       node != list_end(queue) && iov_count < MAX_RFC_SEND_IOV;
+       node = list_next(node)) {
+    BT_HDR* p_buf = (BT_HDR*)list_node(node);
+    iov[iov_count].iov_base = p_buf->data + p_buf->offset;
+    iov[iov_count].iov_len = p_buf->len;
+    total += p_buf->len;
+    iov_count++;
+  }
+
+  ssize_t sent = 0;
+  if (total) {
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iov_count;
+    OSI_NO_INTR(sent = sendmsg(fd, &msg, MSG_DONTWAIT));
+
+    if (sent == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return SENT_NONE;
+      LOG_ERROR("%s error writing RFCOMM data back to app: %s", __func__,
+                strerror(errno));
+      return SENT_FAILED;
+    }
+
+    if (sent == 0) return SENT_FAILED;
+  }
+
+  for (int i = 0; i < iov_count; i++) {
+    BT_HDR* p_buf = (BT_HDR*)list_front(queue);
+    if ((size_t)sent < p_buf->len) {
+      p_buf->offset += sent;
+      p_buf->len -= sent;
+      return SENT_PARTIAL;
+    }
+    sent -= p_buf->len;
+    list_remove(queue, p_buf);
+  }
+  return SENT_ALL;
+}
+
 static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
   while (!list_is_empty(slot->incoming_queue)) {
-    BT_HDR* p_buf = (BT_HDR*)list_front(slot->incoming_queue);
-    switch (send_data_to_app(slot->fd, p_buf)) {
+    switch (send_queue_to_app(slot->fd, slot->incoming_queue)) {
       case SENT_NONE:
       case SENT_PARTIAL:
         // monitor the fd to get callback when app is ready to receive data
@@ -828,11 +878,10 @@ static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
         return true;
 
       case SENT_ALL:
-        list_remove(slot->incoming_queue, p_buf);
         break;
 
       case SENT_FAILED:
-        list_remove(slot->incoming_queue, p_buf);
+        list_remove(slot->incoming_queue, list_front(slot->incoming_queue));
         return false;
     }
   }
@@ -83,6 +83,7 @@ using bluetooth::Uuid;
 #define BTIF_STORAGE_KEY_LOCAL_IO_CAPS_BLE "LocalIOCapsBLE"
 #define BTIF_STORAGE_KEY_ADAPTER_DISC_TIMEOUT "DiscoveryTimeout"
 #define BTIF_STORAGE_KEY_GATT_CLIENT_SUPPORTED "GattClientSupportedFeatures"
+#define BTIF_STORAGE_KEY_LAST_USED "LastUsed"
 
 /* This is a local property to add a device found */
 #define BT_PROPERTY_REMOTE_DEVICE_TIMESTAMP 0xFF
@@ -177,6 +178,7 @@ static bt_status_t btif_in_fetch_bonded_ble_device(
 static bt_status_t btif_in_fetch_bonded_device(const std::string& bdstr);
 
 static bool btif_has_ble_keys(const std::string& bdstr);
+static bool btif_has_sample_ltk(const RawAddress& bd_addr);
 
 /*******************************************************************************
  *  Static functions
@@ -449,9 +451,18 @@ static bt_status_t btif_in_fetch_bonded_devices(
   bool bt_linkkey_file_found = false;
   int device_type;
 
-  for (const auto& bd_addr : btif_config_get_paired_devices()) {
+  for (auto bd_addr : btif_config_get_paired_devices()) {
     auto name = bd_addr.ToString();
 
+    // Checked in the same pass, before anything is added to the stack
+    if (add && btif_has_sample_ltk(bd_addr)) {
+      android_errorWriteLog(0x534e4554, "128437297");
+      LOG(ERROR) << __func__
+                 << ": removing bond to device using test TLK: " << bd_addr;
+      btif_storage_remove_bonded_device(&bd_addr);
+      continue;
+    }
+
     BTIF_TRACE_DEBUG("Remote device:%s", name.c_str());
     LinkKey link_key;
     size_t size = sizeof(link_key);
@@ -479,7 +490,10 @@ static bt_status_t btif_in_fetch_bonded_devices(
         bt_linkkey_file_found = false;
       }
     }
-    if (!btif_in_fetch_bonded_ble_device(name, add, p_bonded_devices) && !bt_linkkey_file_found) {
+    // Without |add| the LE devices are not listed, don't decode their keys
+    if (add && btif_in_fetch_bonded_ble_device(name, add, p_bonded_devices) !=
+                   BT_STATUS_SUCCESS &&
+        !bt_linkkey_file_found) {
       BTIF_TRACE_DEBUG("Remote device:%s, no link key or ble key found",
                        name.c_str());
     }
@@ -870,29 +884,15 @@ bt_status_t btif_storage_remove_bonded_device(
  * We still allow such devices to bond in order to give the user a chance to
  * update firmware.
  */
-static void remove_devices_with_sample_ltk() {
-  std::vector<RawAddress> bad_ltk;
-  for (const auto& bd_addr : btif_config_get_paired_devices()) {
-    auto name = bd_addr.ToString();
-
-    tBTA_LE_KEY_VALUE key;
-    memset(&key, 0, sizeof(key));
-
-    if (btif_storage_get_ble_bonding_key(
-            bd_addr, BTIF_DM_LE_KEY_PENC, (uint8_t*)&key,
-            sizeof(tBTM_LE_PENC_KEYS)) == BT_STATUS_SUCCESS) {
-      if (is_sample_ltk(key.penc_key.ltk)) {
-        bad_ltk.push_back(bd_addr);
-      }
-    }
-  }
-
-  for (RawAddress address : bad_ltk) {
-    android_errorWriteLog(0x534e4554, "128437297");
-    LOG(ERROR) << __func__ << ": removing bond to device using test TLK: " << address;
+static bool btif_has_sample_ltk(const RawAddress& bd_addr) {
+  tBTA_LE_KEY_VALUE key;
+  memset(&key, 0, sizeof(key));
 
-    btif_storage_remove_bonded_device(&address);
-  }
+  return btif_storage_get_ble_bonding_key(bd_addr, BTIF_DM_LE_KEY_PENC,
+                                          (uint8_t*)&key,
+                                          sizeof(tBTM_LE_PENC_KEYS)) ==
+             BT_STATUS_SUCCESS &&
+         is_sample_ltk(key.penc_key.ltk);
 }
 
 /*******************************************************************************
@@ -922,8 +922,6 @@ bt_status_t btif_storage_load_bonded_devices(void) {
   Uuid remote_uuids[BT_MAX_NUM_UUIDS];
   bt_status_t status;
 
-  remove_devices_with_sample_ltk();
-
   btif_in_fetch_bonded_devices(&bonded_devices, 1);
 
   /* Now send the adapter_properties_cb with all adapter_properties */
@@ -1786,3 +1784,27 @@ uint8_t btif_storage_get_gatt_cl_supp_feat(const RawAddress& bd_addr) {
 
   return value;
 }
+
+/** Stores the time a bonded device was last connected */
+void btif_storage_set_remote_device_last_used(const RawAddress& bd_addr) {
+  do_in_jni_thread(
+      FROM_HERE, Bind(
+                     [](const RawAddress& bd_addr, int now) {
+                       std::string bdstr = bd_addr.ToString();
+                       if (btif_in_fetch_bonded_device(bdstr) !=
+                           BT_STATUS_SUCCESS) {
+                         return;
+                       }
+                       btif_config_set_int(bdstr, BTIF_STORAGE_KEY_LAST_USED,
+                                           now);
+                       btif_config_save();
+                     },
+                     bd_addr, (int)time(NULL)));
+}
+
+/** Get the time a bonded device was last connected */
+int btif_storage_get_remote_device_last_used(const RawAddress& bd_addr) {
+  int value = 0;
+  btif_config_get_int(bd_addr.ToString(), BTIF_STORAGE_KEY_LAST_USED, &value);
+  return value;
+}
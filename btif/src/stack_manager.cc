@@ -27,6 +27,7 @@
 #include "btif_api.h"
 #include "btif_common.h"
 #include "common/message_loop_thread.h"
+#include "common/startup_trace.h"
 #include "device/include/controller.h"
 #include "main/shim/shim.h"
 #include "osi/include/log.h"
@@ -39,6 +40,7 @@
 #include "btif_profile_queue.h"
 
 using bluetooth::common::MessageLoopThread;
+namespace startup_trace = bluetooth::common::startup_trace;
 
 static MessageLoopThread management_thread("bt_stack_manager_thread");
 
@@ -109,6 +111,9 @@ static void event_init_stack(void* context) {
   if (stack_is_initialized) {
     LOG_INFO("%s found the stack already in initialized state", __func__);
   } else {
+    // Kept until the stack is up, so that the first enable shows the init too
+    startup_trace::Start();
+    startup_trace::ScopedEvent trace_event("init_stack");
     module_management_start();
 
     module_init(get_module(OSI_MODULE));
@@ -147,13 +152,28 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
   ensure_stack_is_initialized();
 
   LOG_INFO("%s is bringing up the stack", __func__);
+  startup_trace::Start();
+  auto trace_begin = startup_trace::Clock::now();
   future_t* local_hack_future = future_new();
   hack_future = local_hack_future;
 
+  // Decrypting the keys of the bonded devices overlaps with the controller
+  // bring up, they are all read when the bonded devices are loaded.
+  btif_config_prefetch_encrypted_keys();
+
   // Include this for now to put btif config into a shutdown-able state
   bte_main_enable();
 
-  if (future_await(local_hack_future) != FUTURE_SUCCESS) {
+  auto trace_await = startup_trace::Clock::now();
+  startup_trace::AddEvent("bte_main_enable", trace_begin, trace_await);
+  void* result = future_await(local_hack_future);
+  startup_trace::AddEvent("await stack up", trace_await,
+                          startup_trace::Clock::now());
+  startup_trace::AddEvent("start_up_stack", trace_begin,
+                          startup_trace::Clock::now());
+  startup_trace::Finish();
+
+  if (result != FUTURE_SUCCESS) {
     LOG_ERROR("%s failed to start up the stack", __func__);
     stack_is_running = true;  // So stack shutdown actually happens
     event_shut_down_stack(nullptr);
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "btif/include/btif_a2dp_media_queue.h"
+#include "osi/include/allocator.h"
+
+namespace {
+
+constexpr uint32_t kSampleRate = 44100;
+// An SBC packet of 5 frames of 128 samples, about 14.5 ms
+constexpr uint32_t kPacketSamples = 640;
+
+// A packet of |frames| frames with RTP |timestamp|
+BT_HDR* MakePacket(uint32_t timestamp, uint16_t frames = 5) {
+  BT_HDR* p_buf =
+      static_cast<BT_HDR*>(osi_malloc(sizeof(BT_HDR) + sizeof(uint32_t) + 8));
+  p_buf->offset = sizeof(uint32_t);
+  p_buf->len = 8;
+  p_buf->layer_specific = frames;
+  *reinterpret_cast<uint32_t*>(p_buf + 1) = timestamp;
+  return p_buf;
+}
+
+uint32_t TimestampOf(const BT_HDR* p_buf) {
+  return *reinterpret_cast<const uint32_t*>(p_buf + 1);
+}
+
+// Fills |queue| with packets 0 to capacity - 1
+void Fill(BtifA2dpMediaQueue* queue) {
+  for (size_t i = 0; i < queue->Capacity(); i++) {
+    EXPECT_TRUE(queue->Enqueue(MakePacket(i * kPacketSamples), nullptr));
+  }
+}
+
+}  // namespace
+
+class BtifA2dpMediaQueueTest : public ::testing::TestWithParam<bool> {};
+
+TEST_P(BtifA2dpMediaQueueTest, no_drop_below_capacity) {
+  BtifA2dpMediaQueue queue(4, BtifA2dpDropPolicy::kFlush, GetParam());
+  Fill(&queue);
+  EXPECT_EQ(queue.Length(), 4u);
+  EXPECT_EQ(queue.drops().overflows, 0u);
+  for (uint32_t i = 0; i < 4; i++) {
+    BT_HDR* p_buf = queue.Dequeue();
+    ASSERT_NE(p_buf, nullptr);
+    EXPECT_EQ(TimestampOf(p_buf), i * kPacketSamples);
+    osi_free(p_buf);
+  }
+  EXPECT_EQ(queue.Dequeue(), nullptr);
+}
+
+TEST_P(BtifA2dpMediaQueueTest, flush_drops_everything_queued) {
+  BtifA2dpMediaQueue queue(4, BtifA2dpDropPolicy::kFlush, GetParam());
+  Fill(&queue);
+  BtifA2dpDropCounts dropped;
+  EXPECT_TRUE(queue.Enqueue(MakePacket(4 * kPacketSamples), &dropped));
+  EXPECT_EQ(dropped.overflows, 1u);
+  EXPECT_EQ(dropped.packets, 4u);
+  EXPECT_EQ(dropped.frames, 20u);
+  EXPECT_EQ(dropped.bytes, 32u);
+  ASSERT_EQ(queue.Length(), 1u);
+  BT_HDR* p_buf = queue.Dequeue();
+  EXPECT_EQ(TimestampOf(p_buf), 4 * kPacketSamples);
+  osi_free(p_buf);
+}
+
+TEST_P(BtifA2dpMediaQueueTest, oldest_drops_one) {
+  BtifA2dpMediaQueue queue(4, BtifA2dpDropPolicy::kOldest, GetParam());
+  Fill(&queue);
+  BtifA2dpDropCounts dropped;
+  EXPECT_TRUE(queue.Enqueue(MakePacket(4 * kPacketSamples), &dropped));
+  EXPECT_EQ(dropped.packets, 1u);
+  ASSERT_EQ(queue.Length(), 4u);
+  BT_HDR* p_buf = queue.Dequeue();
+  EXPECT_EQ(TimestampOf(p_buf), 1 * kPacketSamples);
+  osi_free(p_buf);
+}
+
+TEST_P(BtifA2dpMediaQueueTest, newest_drops_the_new_packet) {
+  BtifA2dpMediaQueue queue(4, BtifA2dpDropPolicy::kNewest, GetParam());
+  Fill(&queue);
+  BtifA2dpDropCounts dropped;
+  EXPECT_FALSE(queue.Enqueue(MakePacket(4 * kPacketSamples), &dropped));
+  EXPECT_EQ(dropped.packets, 1u);
+  ASSERT_EQ(queue.Length(), 4u);
+  BT_HDR* p_buf = queue.Dequeue();
+  EXPECT_EQ(TimestampOf(p_buf), 0u);
+  osi_free(p_buf);
+}
+
+TEST_P(BtifA2dpMediaQueueTest, deadline_drops_late_packets) {
+  BtifA2dpMediaQueue queue(8, BtifA2dpDropPolicy::kDeadline, GetParam());
+  queue.SetSampleRate(kSampleRate);
+  queue.SetDeadlineMs(50);
+  Fill(&queue);
+  // 8 packets of 14.5 ms: those more than 50 ms behind packet 8 are late
+  BtifA2dpDropCounts dropped;
+  EXPECT_TRUE(queue.Enqueue(MakePacket(8 * kPacketSamples), &dropped));
+  EXPECT_EQ(dropped.packets, 5u);
+  EXPECT_EQ(dropped.late_packets, 5u);
+  ASSERT_EQ(queue.Length(), 4u);
+  BT_HDR* p_buf = queue.Dequeue();
+  EXPECT_EQ(TimestampOf(p_buf), 5 * kPacketSamples);
+  osi_free(p_buf);
+}
+
+TEST_P(BtifA2dpMediaQueueTest, deadline_without_sample_rate_drops_oldest) {
+  BtifA2dpMediaQueue queue(4, BtifA2dpDropPolicy::kDeadline, GetParam());
+  Fill(&queue);
+  BtifA2dpDropCounts dropped;
+  EXPECT_TRUE(queue.Enqueue(MakePacket(4 * kPacketSamples), &dropped));
+  EXPECT_EQ(dropped.packets, 1u);
+  EXPECT_EQ(dropped.late_packets, 0u);
+  EXPECT_EQ(queue.Length(), 4u);
+}
+
+TEST_P(BtifA2dpMediaQueueTest, drops_accumulate) {
+  BtifA2dpMediaQueue queue(2, BtifA2dpDropPolicy::kOldest, GetParam());
+  for (uint32_t i = 0; i < 6; i++) {
+    queue.Enqueue(MakePacket(i * kPacketSamples), nullptr);
+  }
+  EXPECT_EQ(queue.drops().overflows, 4u);
+  EXPECT_EQ(queue.drops().packets, 4u);
+  EXPECT_EQ(queue.Flush(), 2u);
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_EQ(queue.drops().packets, 4u);
+}
+
+INSTANTIATE_TEST_CASE_P(LockFree, BtifA2dpMediaQueueTest, ::testing::Bool());
+
+// The source enqueues on its own thread while the BTA thread dequeues and
+// frees packets; the drops must only touch packets they took themselves.
+TEST(BtifA2dpMediaQueueConcurrencyTest, deadline_races_consumer) {
+  constexpr uint32_t kPackets = 20000;
+  BtifA2dpMediaQueue queue(8, BtifA2dpDropPolicy::kDeadline, true);
+  queue.SetSampleRate(kSampleRate);
+  queue.SetDeadlineMs(50);
+
+  std::atomic<bool> producing(true);
+  size_t consumed = 0;
+  bool in_order = true;
+  std::thread consumer([&]() {
+    uint32_t last_timestamp = 0;
+    while (producing || !queue.IsEmpty()) {
+      // Takes packets while the queue is full, when the producer drops
+      if (producing && queue.Length() < queue.Capacity()) {
+        std::this_thread::yield();
+        continue;
+      }
+      BT_HDR* p_buf = queue.Dequeue();
+      if (p_buf == nullptr) {
+        std::this_thread::yield();
+        continue;
+      }
+      uint32_t timestamp = TimestampOf(p_buf);
+      if (consumed > 0 && timestamp <= last_timestamp) in_order = false;
+      last_timestamp = timestamp;
+      consumed++;
+      osi_free(p_buf);
+    }
+  });
+
+  size_t enqueued = 0;
+  for (uint32_t i = 0; i < kPackets; i++) {
+    if (queue.Enqueue(MakePacket((i + 1) * kPacketSamples), nullptr)) {
+      enqueued++;
+    }
+  }
+  producing = false;
+  consumer.join();
+
+  EXPECT_TRUE(in_order);
+  EXPECT_GT(queue.drops().overflows, 0u);
+  EXPECT_EQ(enqueued, kPackets);
+  EXPECT_EQ(consumed + queue.drops().packets, kPackets);
+}
+
+TEST(BtifA2dpDropPolicyTest, parse) {
+  BtifA2dpDropPolicy policy = BtifA2dpDropPolicy::kFlush;
+  EXPECT_TRUE(BtifA2dpDropPolicyFromString("deadline", &policy));
+  EXPECT_EQ(policy, BtifA2dpDropPolicy::kDeadline);
+  EXPECT_STREQ(BtifA2dpDropPolicyText(policy), "deadline");
+  EXPECT_FALSE(BtifA2dpDropPolicyFromString("latest", &policy));
+  EXPECT_EQ(policy, BtifA2dpDropPolicy::kDeadline);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "btif/include/btif_a2dp_sink_jitter.h"
+
+namespace {
+
+constexpr uint32_t kSampleRate = 44100;
+// An SBC packet of 5 frames of 128 samples, about 14.5 ms
+constexpr uint32_t kPacketSamples = 640;
+constexpr uint64_t kPacketUs = kPacketSamples * 1000000ull / kSampleRate;
+
+// Feeds |count| packets from |*timestamp| and |*arrival_us|, each one
+// delayed by |jitter_us| every |period| packets.
+void Feed(BtifA2dpSinkJitter* jitter, uint32_t* timestamp,
+          uint64_t* arrival_us, int count, uint64_t jitter_us, int period) {
+  for (int i = 0; i < count; i++) {
+    uint64_t delay_us = (period > 0 && i % period == 0) ? jitter_us : 0;
+    jitter->OnPacket(*timestamp, *arrival_us + delay_us);
+    *timestamp += kPacketSamples;
+    *arrival_us += kPacketUs;
+  }
+}
+
+}  // namespace
+
+TEST(BtifA2dpSinkJitterTest, default_depth_until_first_window) {
+  BtifA2dpSinkJitter jitter;
+  EXPECT_EQ(jitter.TargetDepthUs(), BtifA2dpSinkJitter::kDefaultDepthUs);
+
+  jitter.Reset(kSampleRate);
+  uint32_t timestamp = 1000;
+  uint64_t arrival_us = 5000000;
+  Feed(&jitter, &timestamp, &arrival_us, 10, 0, 0);
+  EXPECT_EQ(jitter.packets(), 10u);
+  EXPECT_EQ(jitter.TargetDepthUs(), BtifA2dpSinkJitter::kDefaultDepthUs);
+}
+
+TEST(BtifA2dpSinkJitterTest, regular_arrivals_shrink_the_depth) {
+  BtifA2dpSinkJitter jitter;
+  jitter.Reset(kSampleRate);
+  uint32_t timestamp = 0;
+  uint64_t arrival_us = 0;
+  Feed(&jitter, &timestamp, &arrival_us, 1000, 0, 0);
+  EXPECT_EQ(jitter.TargetDepthUs(), BtifA2dpSinkJitter::kMinDepthUs);
+  EXPECT_LE(jitter.JitterUs(), 1u);
+}
+
+TEST(BtifA2dpSinkJitterTest, late_packets_grow_the_depth) {
+  BtifA2dpSinkJitter jitter;
+  jitter.Reset(kSampleRate);
+  uint32_t timestamp = 0;
+  uint64_t arrival_us = 0;
+  Feed(&jitter, &timestamp, &arrival_us, 1000, 80000, 50);
+  uint64_t target_us = jitter.TargetDepthUs();
+  EXPECT_GE(target_us, 80000 + BtifA2dpSinkJitter::kMarginUs - 1000);
+  EXPECT_LE(target_us, 80000 + BtifA2dpSinkJitter::kMarginUs + 1000);
+  EXPECT_GT(jitter.JitterUs(), 0u);
+
+  // The delays are forgotten after two windows without any
+  Feed(&jitter, &timestamp, &arrival_us, 1000, 0, 0);
+  EXPECT_EQ(jitter.TargetDepthUs(), BtifA2dpSinkJitter::kMinDepthUs);
+}
+
+TEST(BtifA2dpSinkJitterTest, depth_is_capped) {
+  BtifA2dpSinkJitter jitter;
+  jitter.Reset(kSampleRate);
+  uint32_t timestamp = 0;
+  uint64_t arrival_us = 0;
+  Feed(&jitter, &timestamp, &arrival_us, 1000, 900000, 100);
+  EXPECT_EQ(jitter.TargetDepthUs(), BtifA2dpSinkJitter::kMaxDepthUs);
+}
+
+TEST(BtifA2dpSinkJitterTest, timestamp_wrap_around) {
+  BtifA2dpSinkJitter jitter;
+  jitter.Reset(kSampleRate);
+  uint32_t timestamp = 0xffffffff - 100 * kPacketSamples;
+  uint64_t arrival_us = 0;
+  Feed(&jitter, &timestamp, &arrival_us, 1000, 0, 0);
+  EXPECT_EQ(jitter.resyncs(), 0u);
+  EXPECT_EQ(jitter.TargetDepthUs(), BtifA2dpSinkJitter::kMinDepthUs);
+}
+
+TEST(BtifA2dpSinkJitterTest, timestamp_jump_resyncs) {
+  BtifA2dpSinkJitter jitter;
+  jitter.Reset(kSampleRate);
+  uint32_t timestamp = 0;
+  uint64_t arrival_us = 0;
+  Feed(&jitter, &timestamp, &arrival_us, 1000, 0, 0);
+
+  timestamp += 10 * kSampleRate;
+  Feed(&jitter, &timestamp, &arrival_us, 10, 0, 0);
+  EXPECT_EQ(jitter.resyncs(), 1u);
+  EXPECT_EQ(jitter.TargetDepthUs(), BtifA2dpSinkJitter::kDefaultDepthUs);
+
+  // Going backwards as well
+  timestamp -= 100 * kPacketSamples;
+  Feed(&jitter, &timestamp, &arrival_us, 10, 0, 0);
+  EXPECT_EQ(jitter.resyncs(), 2u);
+}
+
+TEST(BtifA2dpSinkJitterTest, source_clock_drift) {
+  BtifA2dpSinkJitter jitter;
+  jitter.Reset(kSampleRate);
+  uint32_t timestamp = 0;
+  uint64_t arrival_us = 0;
+  // The source clock runs 0.1% fast: 1 ms of transit less per second
+  for (int i = 0; i < 3000; i++) {
+    jitter.OnPacket(timestamp, arrival_us);
+    timestamp += kPacketSamples;
+    arrival_us += kPacketUs - kPacketUs / 1000;
+  }
+  EXPECT_EQ(jitter.TargetDepthUs(), BtifA2dpSinkJitter::kMinDepthUs);
+}
+
+TEST(BtifA2dpSinkJitterTest, playback_tick_follows_the_band) {
+  BtifA2dpSinkJitter jitter;
+  jitter.Reset(kSampleRate);
+  uint64_t target_us = jitter.TargetDepthUs();
+
+  EXPECT_EQ(jitter.OnPlaybackTick(target_us), 0);
+  EXPECT_EQ(jitter.SmoothedDepthUs(), static_cast<int64_t>(target_us));
+
+  // A single deep sample is smoothed out
+  EXPECT_EQ(jitter.OnPlaybackTick(target_us * 2), 0);
+
+  int action = 0;
+  for (int i = 0; i < 200 && action == 0; i++)
+    action = jitter.OnPlaybackTick(target_us * 2);
+  EXPECT_EQ(action, 1);
+
+  jitter.RestartPlayback();
+  EXPECT_EQ(jitter.SmoothedDepthUs(), -1);
+  EXPECT_EQ(jitter.OnPlaybackTick(target_us / 2), -1);
+}
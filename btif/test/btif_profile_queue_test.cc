@@ -23,6 +23,13 @@
 #include <base/callback.h>
 #include <base/location.h>
 
+#include <map>
+#include <vector>
+
+#include "btif/include/btif_storage.h"
+#include "common/time_util.h"
+#include "stack/include/btm_api.h"
+#include "stack/include/sdpdefs.h"
 #include "stack_manager.h"
 #include "types/raw_address.h"
 
@@ -41,6 +48,16 @@ bt_status_t do_in_jni_thread(const base::Location& from_here,
   return BT_STATUS_SUCCESS;
 }
 bool is_on_jni_thread() { return true; }
+static std::map<RawAddress, int> sLastUsed;
+int btif_storage_get_remote_device_last_used(const RawAddress& bd_addr) {
+  return sLastUsed[bd_addr];
+}
+uint64_t bluetooth::common::time_get_os_boottime_ms() { return 0; }
+static bool sAclUp;
+bool BTM_IsAclConnectionUp(const RawAddress& remote_bda,
+                           tBT_TRANSPORT transport) {
+  return sAclUp;
+}
 
 enum ResultType {
   NOT_SET = 0,
@@ -52,6 +69,7 @@ enum ResultType {
 };
 
 static ResultType sResult;
+static std::vector<RawAddress> sConnected;
 
 class BtifProfileQueueTest : public ::testing::Test {
  public:
@@ -64,8 +82,13 @@ class BtifProfileQueueTest : public ::testing::Test {
   void SetUp() override {
     sStackRunning = true;
     sResult = NOT_SET;
+    sConnected.clear();
+    sAclUp = false;
+  };
+  void TearDown() override {
+    btif_queue_release();
+    sLastUsed.clear();
   };
-  void TearDown() override { btif_queue_release(); };
 };
 
 const RawAddress BtifProfileQueueTest::kTestAddr1{
@@ -126,17 +149,21 @@ TEST_F(BtifProfileQueueTest, test_connect_fail_still_can_advance_the_queue) {
   // not executed
   btif_queue_connect(kTestUuid2, &kTestAddr1, test_connect_cb_fail);
   EXPECT_EQ(sResult, NOT_SET);
-  // Third connect-message for UUID1-ADDR2 be pushed into connect-queue, but is
-  // not executed
-  btif_queue_connect(kTestUuid1, &kTestAddr2, test_connect_cb_fail);
-  EXPECT_EQ(sResult, NOT_SET);
+  // Third connect-message for UUID1-ADDR2 is for another device and is
+  // executed right away
+  btif_queue_connect(kTestUuid1, &kTestAddr2, test_connect_cb);
+  EXPECT_EQ(sResult, UUID1_ADDR2);
+  sResult = NOT_SET;
   // Fourth connect-message for UUID2-ADDR2 be pushed into connect-queue, but is
   // not executed
-  btif_queue_connect(kTestUuid2, &kTestAddr2, test_connect_cb_fail);
+  btif_queue_connect(kTestUuid2, &kTestAddr2, test_connect_cb);
   EXPECT_EQ(sResult, NOT_SET);
-  // removed First connect-message from connect-queue, check it can advance to
-  // subsequent connect-message.
-  btif_queue_advance();
+  // removed First connect-message from connect-queue, the second one fails
+  btif_queue_advance_by_address(kTestAddr1);
+  EXPECT_EQ(sResult, UUID2_ADDR1);
+  // check the failed one does not block subsequent connect-messages.
+  sResult = NOT_SET;
+  btif_queue_advance_by_address(kTestAddr2);
   EXPECT_EQ(sResult, UUID2_ADDR2);
 }
 
@@ -176,10 +203,10 @@ TEST_F(BtifProfileQueueTest, test_multiple_connects_without_advance) {
   sResult = NOT_SET;
   btif_queue_connect(kTestUuid2, &kTestAddr1, test_connect_cb);
   EXPECT_EQ(sResult, NOT_SET);
-  // Third item for same UUID1, but different address ADDR2
+  // Third item for same UUID1, but different address ADDR2 is executed
   sResult = NOT_SET;
   btif_queue_connect(kTestUuid1, &kTestAddr2, test_connect_cb);
-  EXPECT_EQ(sResult, NOT_SET);
+  EXPECT_EQ(sResult, UUID1_ADDR2);
   // Fourth item for same UUID2, but different address ADDR2
   sResult = NOT_SET;
   btif_queue_connect(kTestUuid2, &kTestAddr2, test_connect_cb);
@@ -192,16 +219,55 @@ TEST_F(BtifProfileQueueTest, test_multiple_connects_without_advance) {
   sResult = NOT_SET;
   btif_queue_advance();
   EXPECT_EQ(sResult, UUID2_ADDR1);
-  // Advance moves queue to execute third item
+  // Advancing ADDR2 moves queue to execute fourth item
   sResult = NOT_SET;
-  btif_queue_advance();
-  EXPECT_EQ(sResult, UUID1_ADDR2);
-  // Advance moves queue to execute fourth item
-  sResult = NOT_SET;
-  btif_queue_advance();
+  btif_queue_advance_by_address(kTestAddr2);
   EXPECT_EQ(sResult, UUID2_ADDR2);
 }
 
+static bt_status_t test_connect_cb_record(RawAddress* bda, uint16_t uuid) {
+  sConnected.push_back(*bda);
+  return BT_STATUS_SUCCESS;
+}
+
+TEST_F(BtifProfileQueueTest, test_advance_by_address_keeps_other_devices) {
+  btif_queue_connect(kTestUuid1, &kTestAddr1, test_connect_cb_record);
+  btif_queue_connect(kTestUuid1, &kTestAddr2, test_connect_cb_record);
+  btif_queue_connect(kTestUuid2, &kTestAddr2, test_connect_cb_record);
+  EXPECT_EQ(sConnected, std::vector<RawAddress>({kTestAddr1, kTestAddr2}));
+  // Completing ADDR1 leaves the request in progress for ADDR2 alone
+  btif_queue_advance_by_address(kTestAddr1);
+  EXPECT_EQ(sConnected.size(), 2u);
+  btif_queue_advance_by_address(kTestAddr2);
+  EXPECT_EQ(sConnected,
+            std::vector<RawAddress>({kTestAddr1, kTestAddr2, kTestAddr2}));
+}
+
+TEST_F(BtifProfileQueueTest, test_most_recently_used_device_first) {
+  sLastUsed[kTestAddr1] = 100;
+  sLastUsed[kTestAddr2] = 200;
+  sStackRunning = false;
+  btif_queue_connect(kTestUuid1, &kTestAddr1, test_connect_cb_record);
+  btif_queue_connect(kTestUuid1, &kTestAddr2, test_connect_cb_record);
+  EXPECT_TRUE(sConnected.empty());
+  sStackRunning = true;
+  btif_queue_connect_next();
+  EXPECT_EQ(sConnected, std::vector<RawAddress>({kTestAddr2, kTestAddr1}));
+}
+
+TEST_F(BtifProfileQueueTest, test_concurrent_devices_are_limited) {
+  std::vector<RawAddress> addresses;
+  for (uint8_t i = 0; i < 6; i++) {
+    addresses.push_back(RawAddress({0x11, 0x22, 0x33, 0x44, 0x55, i}));
+    btif_queue_connect(kTestUuid1, &addresses.back(), test_connect_cb_record);
+  }
+  EXPECT_EQ(sConnected.size(), 4u);
+  // A finished device makes room for the next one
+  btif_queue_advance_by_address(addresses[0]);
+  EXPECT_EQ(sConnected.size(), 5u);
+  EXPECT_EQ(sConnected.back(), addresses[4]);
+}
+
 TEST_F(BtifProfileQueueTest, test_cleanup_first_allow_second) {
   // First item is executed
   sResult = NOT_SET;
@@ -263,3 +329,34 @@ TEST_F(BtifProfileQueueTest, test_cleanup_both_reverse_order) {
   btif_queue_connect_next();
   EXPECT_EQ(sResult, NOT_SET);
 }
+
+static std::vector<uint16_t> sConnectedUuids;
+
+static bt_status_t test_connect_cb_record_uuid(RawAddress* bda,
+                                               uint16_t uuid) {
+  sConnectedUuids.push_back(uuid);
+  return BT_STATUS_SUCCESS;
+}
+
+TEST_F(BtifProfileQueueTest, test_audio_profiles_run_along_once_acl_is_up) {
+  sConnectedUuids.clear();
+  btif_queue_connect(UUID_SERVCLASS_AG_HANDSFREE, &kTestAddr1,
+                     test_connect_cb_record_uuid);
+  btif_queue_connect(UUID_SERVCLASS_AUDIO_SOURCE, &kTestAddr1,
+                     test_connect_cb_record_uuid);
+  // No ACL yet: the second profile waits for the first
+  EXPECT_EQ(sConnectedUuids,
+            std::vector<uint16_t>({UUID_SERVCLASS_AG_HANDSFREE}));
+  sAclUp = true;
+  btif_queue_connect_next();
+  EXPECT_EQ(sConnectedUuids,
+            std::vector<uint16_t>(
+                {UUID_SERVCLASS_AG_HANDSFREE, UUID_SERVCLASS_AUDIO_SOURCE}));
+  // Other profiles still wait for the audio ones to complete
+  btif_queue_connect(kTestUuid1, &kTestAddr1, test_connect_cb_record_uuid);
+  EXPECT_EQ(sConnectedUuids.size(), 2u);
+  btif_queue_advance_by_profile(UUID_SERVCLASS_AUDIO_SOURCE, kTestAddr1);
+  EXPECT_EQ(sConnectedUuids.size(), 2u);
+  btif_queue_advance_by_profile(UUID_SERVCLASS_AG_HANDSFREE, kTestAddr1);
+  EXPECT_EQ(sConnectedUuids.back(), kTestUuid1);
+}
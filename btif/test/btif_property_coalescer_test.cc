@@ -0,0 +1,168 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "btif/include/btif_property_coalescer.h"
+
+namespace {
+
+const RawAddress kAddress1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kAddress2({0x66, 0x55, 0x44, 0x33, 0x22, 0x11});
+
+bt_property_t NameProperty(const std::string& name) {
+  return {BT_PROPERTY_BDNAME, static_cast<int>(name.size()),
+          const_cast<char*>(name.data())};
+}
+
+bt_property_t RssiProperty(int8_t* rssi) {
+  return {BT_PROPERTY_REMOTE_RSSI, sizeof(*rssi), rssi};
+}
+
+// What one call of the deliver callback was given
+struct Delivery {
+  RawAddress bd_addr;
+  std::vector<bt_property_type_t> types;
+  std::vector<std::string> values;
+};
+
+std::vector<Delivery> FlushAll(BtifPropertyCoalescer* coalescer) {
+  std::vector<Delivery> deliveries;
+  coalescer->Flush([&deliveries](const RawAddress& bd_addr, int num_properties,
+                                 bt_property_t* properties) {
+    Delivery delivery{bd_addr, {}, {}};
+    for (int i = 0; i < num_properties; i++) {
+      delivery.types.push_back(properties[i].type);
+      delivery.values.emplace_back(static_cast<char*>(properties[i].val),
+                                   properties[i].len);
+    }
+    deliveries.push_back(delivery);
+  });
+  return deliveries;
+}
+
+}  // namespace
+
+TEST(BtifPropertyCoalescerTest, first_add_asks_for_flush) {
+  BtifPropertyCoalescer coalescer;
+  std::string name = "first";
+  bt_property_t property = NameProperty(name);
+  EXPECT_TRUE(coalescer.IsEmpty());
+  EXPECT_TRUE(coalescer.Add(kAddress1, 1, &property));
+  EXPECT_FALSE(coalescer.Add(kAddress1, 1, &property));
+  EXPECT_FALSE(coalescer.Add(kAddress2, 1, &property));
+  EXPECT_EQ(coalescer.PendingDevices(), 2u);
+}
+
+TEST(BtifPropertyCoalescerTest, latest_value_of_a_type_wins) {
+  BtifPropertyCoalescer coalescer;
+  std::string first = "first";
+  std::string second = "second";
+  bt_property_t property = NameProperty(first);
+  coalescer.Add(kAddress1, 1, &property);
+  property = NameProperty(second);
+  coalescer.Add(kAddress1, 1, &property);
+
+  std::vector<Delivery> deliveries = FlushAll(&coalescer);
+  ASSERT_EQ(deliveries.size(), 1u);
+  EXPECT_EQ(deliveries[0].bd_addr, kAddress1);
+  ASSERT_EQ(deliveries[0].values.size(), 1u);
+  EXPECT_EQ(deliveries[0].values[0], "second");
+  EXPECT_EQ(coalescer.added(), 2u);
+  EXPECT_EQ(coalescer.delivered(), 1u);
+}
+
+TEST(BtifPropertyCoalescerTest, types_keep_first_order) {
+  BtifPropertyCoalescer coalescer;
+  std::string name = "name";
+  int8_t rssi = -40;
+  bt_property_t properties[] = {NameProperty(name), RssiProperty(&rssi)};
+  coalescer.Add(kAddress1, 2, properties);
+  rssi = -60;
+  bt_property_t update = RssiProperty(&rssi);
+  coalescer.Add(kAddress1, 1, &update);
+
+  std::vector<Delivery> deliveries = FlushAll(&coalescer);
+  ASSERT_EQ(deliveries.size(), 1u);
+  ASSERT_EQ(deliveries[0].types.size(), 2u);
+  EXPECT_EQ(deliveries[0].types[0], BT_PROPERTY_BDNAME);
+  EXPECT_EQ(deliveries[0].types[1], BT_PROPERTY_REMOTE_RSSI);
+  EXPECT_EQ(static_cast<int8_t>(deliveries[0].values[1][0]), -60);
+}
+
+TEST(BtifPropertyCoalescerTest, devices_keep_first_order) {
+  BtifPropertyCoalescer coalescer;
+  std::string name = "name";
+  bt_property_t property = NameProperty(name);
+  coalescer.Add(kAddress2, 1, &property);
+  coalescer.Add(kAddress1, 1, &property);
+  coalescer.Add(kAddress2, 1, &property);
+
+  std::vector<Delivery> deliveries = FlushAll(&coalescer);
+  ASSERT_EQ(deliveries.size(), 2u);
+  EXPECT_EQ(deliveries[0].bd_addr, kAddress2);
+  EXPECT_EQ(deliveries[1].bd_addr, kAddress1);
+}
+
+TEST(BtifPropertyCoalescerTest, copies_the_values) {
+  BtifPropertyCoalescer coalescer;
+  std::string name = "before";
+  bt_property_t property = NameProperty(name);
+  coalescer.Add(kAddress1, 1, &property);
+  name = "after";
+
+  std::vector<Delivery> deliveries = FlushAll(&coalescer);
+  ASSERT_EQ(deliveries.size(), 1u);
+  EXPECT_EQ(deliveries[0].values[0], "before");
+}
+
+TEST(BtifPropertyCoalescerTest, flush_empties) {
+  BtifPropertyCoalescer coalescer;
+  std::string name = "name";
+  bt_property_t property = NameProperty(name);
+  coalescer.Add(kAddress1, 1, &property);
+  EXPECT_EQ(FlushAll(&coalescer).size(), 1u);
+  EXPECT_TRUE(coalescer.IsEmpty());
+  EXPECT_TRUE(FlushAll(&coalescer).empty());
+  EXPECT_TRUE(coalescer.Add(kAddress1, 1, &property));
+}
+
+TEST(BtifPropertyCoalescerTest, deliver_may_add) {
+  BtifPropertyCoalescer coalescer;
+  std::string name = "name";
+  bt_property_t property = NameProperty(name);
+  coalescer.Add(kAddress1, 1, &property);
+  size_t delivered = coalescer.Flush(
+      [&coalescer, &property](const RawAddress&, int, bt_property_t*) {
+        coalescer.Add(kAddress2, 1, &property);
+      });
+  EXPECT_EQ(delivered, 1u);
+  ASSERT_EQ(coalescer.PendingDevices(), 1u);
+  EXPECT_EQ(FlushAll(&coalescer)[0].bd_addr, kAddress2);
+}
+
+TEST(BtifPropertyCoalescerTest, clear_drops_pending) {
+  BtifPropertyCoalescer coalescer;
+  std::string name = "name";
+  bt_property_t property = NameProperty(name);
+  coalescer.Add(kAddress1, 1, &property);
+  coalescer.Clear();
+  EXPECT_TRUE(coalescer.IsEmpty());
+  EXPECT_TRUE(FlushAll(&coalescer).empty());
+  EXPECT_EQ(coalescer.delivered(), 0u);
+}
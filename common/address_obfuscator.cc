@@ -35,7 +35,16 @@ bool AddressObfuscator::IsSaltValid(const Octet32& salt_256bit) {
 
 void AddressObfuscator::Initialize(const Octet32& salt_256bit) {
   std::lock_guard<std::recursive_mutex> lock(instance_mutex_);
+  if (salt_256bit == salt_256bit_) return;
   salt_256bit_ = salt_256bit;
+  cache_.Clear();
+  if (!IsSaltValid(salt_256bit_)) return;
+  if (hmac_ctx_ == nullptr) {
+    hmac_ctx_ = HMAC_CTX_new();
+    CHECK(hmac_ctx_ != nullptr);
+  }
+  CHECK(HMAC_Init_ex(hmac_ctx_, salt_256bit_.data(), salt_256bit_.size(),
+                     EVP_sha256(), nullptr));
 }
 
 bool AddressObfuscator::IsInitialized() {
@@ -46,13 +55,36 @@ bool AddressObfuscator::IsInitialized() {
 std::string AddressObfuscator::Obfuscate(const RawAddress& address) {
   std::lock_guard<std::recursive_mutex> lock(instance_mutex_);
   CHECK(IsInitialized());
+  return ObfuscateLocked(address);
+}
+
+std::vector<std::string> AddressObfuscator::Obfuscate(
+    const std::vector<RawAddress>& addresses) {
+  std::lock_guard<std::recursive_mutex> lock(instance_mutex_);
+  CHECK(IsInitialized());
+  std::vector<std::string> obfuscated_addresses;
+  obfuscated_addresses.reserve(addresses.size());
+  for (const RawAddress& address : addresses) {
+    obfuscated_addresses.push_back(ObfuscateLocked(address));
+  }
+  return obfuscated_addresses;
+}
+
+std::string AddressObfuscator::ObfuscateLocked(const RawAddress& address) {
+  std::string obfuscated_address;
+  if (cache_.Get(address, &obfuscated_address)) return obfuscated_address;
+
   std::array<uint8_t, EVP_MAX_MD_SIZE> result = {};
   unsigned int out_len = 0;
-  CHECK(::HMAC(EVP_sha256(), salt_256bit_.data(), salt_256bit_.size(),
-               address.address, address.kLength, result.data(),
-               &out_len) != nullptr);
+  // Resets the context, keeping the salt
+  CHECK(HMAC_Init_ex(hmac_ctx_, nullptr, 0, nullptr, nullptr));
+  CHECK(HMAC_Update(hmac_ctx_, address.address, address.kLength));
+  CHECK(HMAC_Final(hmac_ctx_, result.data(), &out_len));
   CHECK_EQ(out_len, static_cast<unsigned int>(kOctet32Length));
-  return std::string(reinterpret_cast<const char*>(result.data()), out_len);
+  obfuscated_address.assign(reinterpret_cast<const char*>(result.data()),
+                            out_len);
+  cache_.Put(address, obfuscated_address);
+  return obfuscated_address;
 }
 
 }  // namespace common
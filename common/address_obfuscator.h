@@ -21,15 +21,20 @@
 #include <array>
 #include <mutex>
 #include <string>
+#include <vector>
 
+#include "lru.h"
 #include "raw_address.h"
 
+struct hmac_ctx_st;
+
 namespace bluetooth {
 namespace common {
 
 class AddressObfuscator {
  public:
   static constexpr unsigned int kOctet32Length = 32;
+  static constexpr size_t kMaxNumCachedAddresses = 256;
   using Octet32 = std::array<uint8_t, kOctet32Length>;
   static AddressObfuscator* GetInstance() {
     static auto instance = new AddressObfuscator();
@@ -49,6 +54,8 @@ class AddressObfuscator {
   /**
    * Initialize this obfuscator with necessary parameters
    *
+   * The obfuscated addresses cached with a previous salt are forgotten
+   *
    * @param salt_256bit a 256 bit salt used to hash the fixed length address
    */
   void Initialize(const Octet32& salt_256bit);
@@ -61,14 +68,33 @@ class AddressObfuscator {
   /**
    * Obfuscate Bluetooth MAC address into an anonymous ID string
    *
+   * The last kMaxNumCachedAddresses obfuscated addresses are cached, so that
+   * an address referenced repeatedly is only hashed once
+   *
    * @param address Bluetooth MAC address to be obfuscated
    * @return the obfuscated MAC address in 256 bit
    */
   std::string Obfuscate(const RawAddress& address);
 
+  /**
+   * Obfuscate Bluetooth MAC addresses into anonymous ID strings, locking the
+   * obfuscator once for all of them
+   *
+   * @param addresses Bluetooth MAC addresses to be obfuscated
+   * @return the obfuscated MAC addresses in 256 bit, in the same order
+   */
+  std::vector<std::string> Obfuscate(const std::vector<RawAddress>& addresses);
+
  private:
-  AddressObfuscator() : salt_256bit_({0}) {}
+  AddressObfuscator()
+      : salt_256bit_({0}),
+        cache_(kMaxNumCachedAddresses, "bt_address_obfuscator") {}
+  // Must be called with instance_mutex_ held
+  std::string ObfuscateLocked(const RawAddress& address);
   Octet32 salt_256bit_;
+  // Keyed with salt_256bit_, so that each address only hashes the address
+  hmac_ctx_st* hmac_ctx_ = nullptr;
+  LruCache<RawAddress, std::string> cache_;
   std::recursive_mutex instance_mutex_;
 };
 
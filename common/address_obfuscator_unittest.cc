@@ -117,4 +117,49 @@ TEST(AddressObfuscatorTest, test_obfuscate_address_key2_max_address) {
       AddressObfuscator::GetInstance()->Obfuscate(kTestData2_3);
   EXPECT_EQ(result.size(), AddressObfuscator::kOctet32Length);
   EXPECT_EQ(result, kTestResult2_3);
-}
\ No newline at end of file
+}
+
+TEST(AddressObfuscatorTest, test_obfuscate_address_cached) {
+  AddressObfuscator::GetInstance()->Initialize(kTestKey1);
+  EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData1),
+            kTestResult1);
+  EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData1),
+            kTestResult1);
+}
+
+TEST(AddressObfuscatorTest, test_salt_change_invalidates_cache) {
+  AddressObfuscator::GetInstance()->Initialize(kTestKey1);
+  std::string result =
+      AddressObfuscator::GetInstance()->Obfuscate(kTestData2_1);
+  EXPECT_NE(result, kTestResult2_1);
+  AddressObfuscator::GetInstance()->Initialize(kTestKey2);
+  EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData2_1),
+            kTestResult2_1);
+  AddressObfuscator::GetInstance()->Initialize(kTestKey1);
+  EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData2_1), result);
+}
+
+TEST(AddressObfuscatorTest, test_obfuscate_addresses) {
+  AddressObfuscator::GetInstance()->Initialize(kTestKey2);
+  std::vector<std::string> results =
+      AddressObfuscator::GetInstance()->Obfuscate(
+          {kTestData2_1, kTestData2_2, kTestData2_3, kTestData2_1});
+  ASSERT_EQ(results.size(), 4u);
+  EXPECT_EQ(results[0], kTestResult2_1);
+  EXPECT_EQ(results[1], kTestResult2_2);
+  EXPECT_EQ(results[2], kTestResult2_3);
+  EXPECT_EQ(results[3], kTestResult2_1);
+}
+
+TEST(AddressObfuscatorTest, test_obfuscate_more_addresses_than_cached) {
+  AddressObfuscator::GetInstance()->Initialize(kTestKey2);
+  EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData2_1),
+            kTestResult2_1);
+  for (size_t i = 0; i < AddressObfuscator::kMaxNumCachedAddresses; i++) {
+    RawAddress address = {{0x01, 0x02, 0x03, 0x04, static_cast<uint8_t>(i >> 8),
+                           static_cast<uint8_t>(i)}};
+    AddressObfuscator::GetInstance()->Obfuscate(address);
+  }
+  EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData2_1),
+            kTestResult2_1);
+}
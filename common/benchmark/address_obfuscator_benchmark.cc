@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <openssl/hmac.h>
+#include <string>
+#include <vector>
+
+#include "common/address_obfuscator.h"
+
+using ::benchmark::State;
+using bluetooth::common::AddressObfuscator;
+
+namespace {
+
+constexpr AddressObfuscator::Octet32 kSalt = {
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+    0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+    0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20};
+
+std::vector<RawAddress> Addresses(size_t count) {
+  std::vector<RawAddress> addresses;
+  for (size_t i = 0; i < count; i++) {
+    addresses.push_back(RawAddress({0xaa, 0xbb, 0xcc, 0xdd,
+                                    static_cast<uint8_t>(i >> 8),
+                                    static_cast<uint8_t>(i)}));
+  }
+  return addresses;
+}
+
+// Cost of an obfuscation without the obfuscator: one HMAC keyed per address
+void BM_HmacPerAddress(State& state) {
+  std::vector<RawAddress> addresses = Addresses(state.range(0));
+  uint8_t result[EVP_MAX_MD_SIZE];
+  unsigned int out_len;
+  for (auto _ : state) {
+    for (const RawAddress& address : addresses) {
+      ::HMAC(EVP_sha256(), kSalt.data(), kSalt.size(), address.address,
+             address.kLength, result, &out_len);
+      benchmark::DoNotOptimize(result);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * addresses.size());
+}
+
+// Cycles through state.range(0) addresses: every obfuscation misses the cache
+// once there are more addresses than it holds
+void BM_Obfuscate(State& state) {
+  AddressObfuscator::GetInstance()->Initialize(kSalt);
+  std::vector<RawAddress> addresses = Addresses(state.range(0));
+  for (auto _ : state) {
+    for (const RawAddress& address : addresses) {
+      benchmark::DoNotOptimize(
+          AddressObfuscator::GetInstance()->Obfuscate(address));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * addresses.size());
+}
+
+void BM_ObfuscateBatch(State& state) {
+  AddressObfuscator::GetInstance()->Initialize(kSalt);
+  std::vector<RawAddress> addresses = Addresses(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        AddressObfuscator::GetInstance()->Obfuscate(addresses));
+  }
+  state.SetItemsProcessed(state.iterations() * addresses.size());
+}
+
+BENCHMARK(BM_HmacPerAddress)->Arg(16)->Arg(1024);
+BENCHMARK(BM_Obfuscate)
+    ->Arg(16)
+    ->Arg(AddressObfuscator::kMaxNumCachedAddresses)
+    ->Arg(1024);
+BENCHMARK(BM_ObfuscateBatch)->Arg(16)->Arg(1024);
+
+}  // namespace
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "common/raw_address_flat_map.h"
+#include "osi/include/list.h"
+
+using ::benchmark::State;
+using bluetooth::common::RawAddressFlatMap;
+
+namespace {
+
+// A device record, as stored in the lists of the stack
+struct Record {
+  RawAddress address;
+  uint8_t payload[256];
+};
+
+std::vector<RawAddress> Addresses(size_t count) {
+  std::vector<RawAddress> addresses;
+  for (size_t i = 0; i < count; i++) {
+    addresses.push_back(RawAddress({0x5c, 0xf3, 0x70, 0x12,
+                                    static_cast<uint8_t>(i >> 8),
+                                    static_cast<uint8_t>(i)}));
+  }
+  return addresses;
+}
+
+// The addresses to look up: the even half of them, in a different order than
+// their insertion
+std::vector<RawAddress> Lookups(const std::vector<RawAddress>& addresses) {
+  std::vector<RawAddress> lookups;
+  for (size_t i = 0; i < addresses.size(); i += 2) {
+    lookups.push_back(addresses[(i * 7) % addresses.size()]);
+  }
+  return lookups;
+}
+
+bool is_record_address_not_equal(void* data, void* context) {
+  return static_cast<Record*>(data)->address !=
+         *static_cast<RawAddress*>(context);
+}
+
+// As btm_find_dev() scanned the device records
+void BM_OsiListForeach(State& state) {
+  std::vector<RawAddress> addresses = Addresses(state.range(0));
+  std::vector<RawAddress> lookups = Lookups(addresses);
+  std::vector<Record> records(addresses.size());
+  list_t* list = list_new(nullptr);
+  for (size_t i = 0; i < addresses.size(); i++) {
+    records[i].address = addresses[i];
+    list_append(list, &records[i]);
+  }
+  for (auto _ : state) {
+    for (RawAddress& address : lookups) {
+      benchmark::DoNotOptimize(
+          list_foreach(list, is_record_address_not_equal, &address));
+    }
+  }
+  list_free(list);
+  state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+
+template <typename Map>
+void BM_Find(State& state) {
+  std::vector<RawAddress> addresses = Addresses(state.range(0));
+  std::vector<RawAddress> lookups = Lookups(addresses);
+  std::vector<Record> records(addresses.size());
+  Map map;
+  for (size_t i = 0; i < addresses.size(); i++) {
+    map[addresses[i]] = &records[i];
+  }
+  for (auto _ : state) {
+    for (const RawAddress& address : lookups) {
+      benchmark::DoNotOptimize(map.find(address));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+
+void BM_RawAddressFlatMapFind(State& state) {
+  std::vector<RawAddress> addresses = Addresses(state.range(0));
+  std::vector<RawAddress> lookups = Lookups(addresses);
+  std::vector<Record> records(addresses.size());
+  RawAddressFlatMap<Record*> map;
+  for (size_t i = 0; i < addresses.size(); i++) {
+    map.Put(addresses[i], &records[i]);
+  }
+  for (auto _ : state) {
+    for (const RawAddress& address : lookups) {
+      benchmark::DoNotOptimize(map.Find(address));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+
+BENCHMARK(BM_OsiListForeach)->Arg(8)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_Find, std::map<RawAddress, Record*>)
+    ->Arg(8)
+    ->Arg(100)
+    ->Arg(1000);
+BENCHMARK_TEMPLATE(BM_Find, std::unordered_map<RawAddress, Record*>)
+    ->Arg(8)
+    ->Arg(100)
+    ->Arg(1000);
+BENCHMARK(BM_RawAddressFlatMapFind)->Arg(8)->Arg(100)->Arg(1000);
+
+}  // namespace
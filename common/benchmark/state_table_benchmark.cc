@@ -0,0 +1,122 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "common/state_table.h"
+
+using ::benchmark::State;
+using bluetooth::common::MakeStateTable;
+
+namespace {
+
+// A state machine shaped like the one of the HID host: 4 states, 17 events
+constexpr int kNumStates = 4;
+constexpr size_t kNumEvents = 17;
+constexpr uint8_t kFirstState = 1;
+constexpr uint8_t kNumActions = 8;
+constexpr uint8_t kIgnore = kNumActions;
+
+uint64_t action_count[kNumActions];
+
+template <int kAction>
+void action(int* /* p_cb */) {
+  action_count[kAction]++;
+}
+
+typedef void (*Action)(int* p_cb);
+constexpr Action actions[] = {action<0>, action<1>, action<2>, action<3>,
+                              action<4>, action<5>, action<6>, action<7>};
+
+// Row |event| of the table of |state|: an action on half of the events, and
+// a next state cycling through the states
+constexpr void fill_table(uint8_t (&table)[kNumEvents][2], size_t state) {
+  for (size_t event = 0; event < kNumEvents; event++) {
+    table[event][0] = (event + state) % 2 ? kIgnore : (event + state) % 8;
+    table[event][1] = kFirstState + (event * 3 + state) % kNumStates;
+  }
+}
+
+struct Tables {
+  uint8_t tables[kNumStates][kNumEvents][2] = {};
+
+  constexpr Tables() {
+    for (size_t state = 0; state < kNumStates; state++) {
+      fill_table(tables[state], state);
+    }
+  }
+};
+
+constexpr Tables tables;
+
+constexpr auto state_table = MakeStateTable<1>(
+    [](uint8_t action) {
+      return action == kIgnore ? nullptr : actions[action];
+    },
+    kFirstState, tables.tables[0], tables.tables[1], tables.tables[2],
+    tables.tables[3]);
+
+// The per state tables, as the BTA state machines looked them up
+typedef const uint8_t (*StTbl)[2];
+const StTbl st_tbl[] = {tables.tables[0], tables.tables[1], tables.tables[2],
+                        tables.tables[3]};
+
+std::vector<uint16_t> Events() {
+  std::vector<uint16_t> events;
+  uint32_t seed = 1;
+  for (size_t i = 0; i < 4096; i++) {
+    seed = seed * 1103515245 + 12345;
+    events.push_back((seed >> 16) % kNumEvents);
+  }
+  return events;
+}
+
+void BM_StateTablesDispatch(State& state) {
+  std::vector<uint16_t> events = Events();
+  int p_cb = kFirstState;
+  for (auto _ : state) {
+    for (uint16_t event : events) {
+      if (p_cb < kFirstState || p_cb >= kFirstState + kNumStates) continue;
+      StTbl table = st_tbl[p_cb - kFirstState];
+      uint8_t action = table[event][0];
+      p_cb = table[event][1];
+      if (action != kIgnore) (*actions[action])(&p_cb);
+    }
+  }
+  benchmark::DoNotOptimize(action_count);
+  state.SetItemsProcessed(state.iterations() * events.size());
+}
+
+void BM_StateTableDispatch(State& state) {
+  std::vector<uint16_t> events = Events();
+  int p_cb = kFirstState;
+  for (auto _ : state) {
+    for (uint16_t event : events) {
+      const auto* transition = state_table.Find(p_cb, event);
+      if (transition == nullptr) continue;
+      p_cb = transition->next_state;
+      if (transition->actions[0] != nullptr) (*transition->actions[0])(&p_cb);
+    }
+  }
+  benchmark::DoNotOptimize(action_count);
+  state.SetItemsProcessed(state.iterations() * events.size());
+}
+
+BENCHMARK(BM_StateTablesDispatch);
+BENCHMARK(BM_StateTableDispatch);
+
+}  // namespace
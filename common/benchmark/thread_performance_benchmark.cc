@@ -19,12 +19,16 @@
 #include <base/run_loop.h>
 #include <base/threading/thread.h>
 #include <benchmark/benchmark.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 #include <future>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "common/message_loop_thread.h"
 #include "osi/include/fixed_queue.h"
+#include "osi/include/reactor.h"
 #include "osi/include/thread.h"
 
 using ::benchmark::State;
@@ -320,6 +324,50 @@ BENCHMARK_F(BM_OsiReactorThread, sequential_execution_using_reactor)
   }
 };
 
+// Events spread over |state.range(0)| eventfds registered with the reactor, as
+// on the socket and UIPC threads which watch many fds at once
+void callback_eventfd(void* context) {
+  int fd = *static_cast<int*>(context);
+  eventfd_t value;
+  eventfd_read(fd, &value);
+  g_counter += value;
+  if (g_counter >= NUM_MESSAGES_TO_SEND) {
+    g_counter_promise->set_value();
+  }
+}
+
+BENCHMARK_DEFINE_F(BM_OsiReactorThread, events_from_many_fds_using_reactor)
+(State& state) {
+  std::vector<int> fds(state.range(0));
+  std::vector<reactor_object_t*> objects;
+  for (int& fd : fds) {
+    fd = eventfd(0, 0);
+    objects.push_back(reactor_register(thread_get_reactor(thread_), fd, &fd,
+                                       callback_eventfd, nullptr));
+  }
+  for (auto _ : state) {
+    g_counter = 0;
+    g_counter_promise = std::make_unique<std::promise<void>>();
+    std::future<void> counter_future = g_counter_promise->get_future();
+    for (int i = 0; i < NUM_MESSAGES_TO_SEND; i++) {
+      eventfd_write(fds[i % fds.size()], 1);
+    }
+    counter_future.wait();
+  }
+  for (reactor_object_t* object : objects) {
+    reactor_unregister(object);
+  }
+  for (int fd : fds) {
+    close(fd);
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_MESSAGES_TO_SEND);
+};
+BENCHMARK_REGISTER_F(BM_OsiReactorThread, events_from_many_fds_using_reactor)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(128)
+    ->UseRealTime();
+
 class BM_MessageLooopThread : public BM_ThreadPerformance {
  protected:
   void SetUp(State& st) override {
@@ -18,7 +18,9 @@
 #include <base/run_loop.h>
 #include <base/threading/thread.h>
 #include <benchmark/benchmark.h>
+#include <atomic>
 #include <future>
+#include <vector>
 
 #include "common/message_loop_thread.h"
 #include "common/once_timer.h"
@@ -46,6 +48,13 @@ int g_task_counter;
 
 void TimerFire(void*) { g_promise->set_value(); }
 
+std::atomic<int> g_fired_alarms;
+int g_expected_alarms;
+
+void ManyAlarmsFire(void*) {
+  if (++g_fired_alarms == g_expected_alarms) g_promise->set_value();
+}
+
 void AlarmSleepAndCountDelayedTime(void*) {
   auto end_time_us = time_get_os_boottime_us();
   auto time_after_start_ms = (end_time_us - g_start_time) / 1000;
@@ -99,6 +108,84 @@ BENCHMARK_REGISTER_F(BM_OsiAlarmTimer, timer_performance_ms)
     ->Iterations(1)
     ->UseManualTime();
 
+class BM_OsiManyAlarms : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    for (int i = 0; i < st.range(0); i++) {
+      alarms_.push_back(alarm_new("osi_many_alarms_test"));
+    }
+    g_promise = std::make_shared<std::promise<void>>();
+    g_fired_alarms = 0;
+    g_expected_alarms = 0;
+  }
+
+  void TearDown(State& st) override {
+    g_promise = nullptr;
+    for (alarm_t* alarm : alarms_) alarm_free(alarm);
+    alarms_.clear();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  // Returns pseudo random timeouts in [min_ms, min_ms + range_ms), one for
+  // each alarm.
+  std::vector<uint64_t> Timeouts(uint64_t min_ms, uint64_t range_ms) {
+    std::vector<uint64_t> timeouts;
+    uint32_t seed = 1;
+    for (size_t i = 0; i < alarms_.size(); i++) {
+      seed = seed * 1103515245 + 12345;
+      timeouts.push_back(min_ms + (seed >> 8) % range_ms);
+    }
+    return timeouts;
+  }
+
+  std::vector<alarm_t*> alarms_;
+};
+
+// Sets range(0) alarms a few seconds to minutes out, the typical timeouts of
+// a busy stack, then cancels them all. Reports set and cancel operations per
+// second.
+BENCHMARK_DEFINE_F(BM_OsiManyAlarms, set_cancel)(State& state) {
+  std::vector<uint64_t> timeouts = Timeouts(1000, 60000);
+  for (auto _ : state) {
+    for (size_t i = 0; i < alarms_.size(); i++) {
+      alarm_set(alarms_[i], timeouts[i], &ManyAlarmsFire, nullptr);
+    }
+    for (alarm_t* alarm : alarms_) alarm_cancel(alarm);
+  }
+  state.SetItemsProcessed(state.iterations() * alarms_.size() * 2);
+};
+
+BENCHMARK_REGISTER_F(BM_OsiManyAlarms, set_cancel)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000);
+
+// Sets range(0) alarms expiring within the next second and waits until all
+// of them have fired.
+BENCHMARK_DEFINE_F(BM_OsiManyAlarms, set_fire)(State& state) {
+  std::vector<uint64_t> timeouts = Timeouts(10, 1000);
+  for (auto _ : state) {
+    g_promise = std::make_shared<std::promise<void>>();
+    g_fired_alarms = 0;
+    g_expected_alarms = alarms_.size();
+    auto start_time_point = time_get_os_boottime_us();
+    for (size_t i = 0; i < alarms_.size(); i++) {
+      alarm_set(alarms_[i], timeouts[i], &ManyAlarmsFire, nullptr);
+    }
+    g_promise->get_future().get();
+    auto end_time_point = time_get_os_boottime_us();
+    auto duration = end_time_point - start_time_point;
+    state.SetIterationTime(duration * 1e-6);
+  }
+};
+
+BENCHMARK_REGISTER_F(BM_OsiManyAlarms, set_fire)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Iterations(1)
+    ->UseManualTime();
+
 class BM_AlarmTaskTimer : public ::benchmark::Fixture {
  protected:
   void SetUp(State& st) override {
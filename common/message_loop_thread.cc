@@ -16,18 +16,64 @@
 
 #include "message_loop_thread.h"
 
+#include <stdio.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 #include <thread>
 
+#include <base/bind.h>
 #include <base/strings/stringprintf.h>
 
+#include "gd/os/trace.h"
+
 namespace bluetooth {
 
 namespace common {
 
 static constexpr int kRealTimeFifoSchedulingPriority = 1;
 
+// Traces the wait of |task| in the queue of |thread_name| as a flow from the
+// posting thread, and its run as a slice named after the posting function
+static base::OnceClosure trace_task(const std::string& thread_name,
+                                    const base::Location& from_here,
+                                    base::OnceClosure task) {
+  std::string name = "Queued on " + thread_name;
+  int32_t flow_id = os::trace::NewFlowId();
+  os::trace::BeginFlow(name.c_str(), flow_id);
+  return base::BindOnce(
+      [](const std::string& name, int32_t flow_id, const char* function_name,
+         base::OnceClosure task) {
+        os::trace::EndFlow(name.c_str(), flow_id);
+        os::trace::ScopedSlice slice(function_name);
+        std::move(task).Run();
+      },
+      std::move(name), flow_id, from_here.function_name(), std::move(task));
+}
+
+// Records the wait of |task| in the queue, from when it is due, and its run
+// in |statistics|, under the location it was posted from
+static base::OnceClosure time_task(std::shared_ptr<TaskStatistics> statistics,
+                                   const base::Location& from_here,
+                                   base::OnceClosure task,
+                                   const base::TimeDelta& delay) {
+  statistics->OnPosted();
+  TaskStatistics::Clock::time_point due =
+      TaskStatistics::Clock::now() +
+      std::chrono::microseconds(delay.InMicroseconds());
+  TaskStatistics::Location location{from_here.function_name(),
+                                    from_here.file_name(),
+                                    from_here.line_number()};
+  return base::BindOnce(
+      [](std::shared_ptr<TaskStatistics> statistics,
+         TaskStatistics::Location location,
+         TaskStatistics::Clock::time_point due, base::OnceClosure task) {
+        TaskStatistics::Clock::time_point start = TaskStatistics::Clock::now();
+        std::move(task).Run();
+        statistics->OnRun(location, due, start, TaskStatistics::Clock::now());
+      },
+      std::move(statistics), location, due, std::move(task));
+}
+
 MessageLoopThread::MessageLoopThread(const std::string& thread_name)
     : thread_name_(thread_name),
       message_loop_(nullptr),
@@ -70,6 +116,12 @@ bool MessageLoopThread::DoInThreadDelayed(const base::Location& from_here,
                << ", from " << from_here.ToString();
     return false;
   }
+  if (os::trace::IsEnabled()) {
+    task = trace_task(thread_name_, from_here, std::move(task));
+  }
+  if (task_statistics_ != nullptr) {
+    task = time_task(task_statistics_, from_here, std::move(task), delay);
+  }
   if (!message_loop_->task_runner()->PostDelayedTask(from_here, std::move(task),
                                                      delay)) {
     LOG(ERROR) << __func__
@@ -80,6 +132,30 @@ bool MessageLoopThread::DoInThreadDelayed(const base::Location& from_here,
   return true;
 }
 
+void MessageLoopThread::EnableTaskStatistics(
+    std::chrono::microseconds watchdog_run_time, size_t watchdog_queue_depth) {
+  std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+  if (task_statistics_ != nullptr) {
+    LOG(WARNING) << __func__ << ": already enabled for thread " << *this;
+    return;
+  }
+  task_statistics_ = std::make_shared<TaskStatistics>(
+      thread_name_, watchdog_run_time, watchdog_queue_depth);
+}
+
+void MessageLoopThread::DumpTaskStatistics(int fd) const {
+  std::shared_ptr<TaskStatistics> task_statistics;
+  {
+    std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+    task_statistics = task_statistics_;
+  }
+  if (task_statistics == nullptr) {
+    dprintf(fd, "  %s: task statistics disabled\n", thread_name_.c_str());
+    return;
+  }
+  task_statistics->Dump(fd);
+}
+
 void MessageLoopThread::ShutDown() {
   {
     std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
@@ -164,6 +240,15 @@ bool MessageLoopThread::EnableRealTimeScheduling() {
   return true;
 }
 
+bool MessageLoopThread::ApplyThreadRole(ThreadRole role) {
+  std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+  if (!IsRunning()) {
+    LOG(ERROR) << __func__ << ": thread " << *this << " is not running";
+    return false;
+  }
+  return ApplyThreadProfile(linux_tid_, role);
+}
+
 base::WeakPtr<MessageLoopThread> MessageLoopThread::GetWeakPtr() {
   std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
   return weak_ptr_factory_.GetWeakPtr();
@@ -175,10 +260,13 @@ void MessageLoopThread::Run(std::promise<void> start_up_promise) {
     LOG(INFO) << __func__ << ": message loop starting for thread "
               << thread_name_;
     base::PlatformThread::SetName(thread_name_);
-    message_loop_ = new base::MessageLoop();
+    // An IO message loop, so that timers can watch their file descriptor
+    message_loop_ = new base::MessageLoop(base::MessageLoop::TYPE_IO);
     run_loop_ = new base::RunLoop();
     thread_id_ = base::PlatformThread::CurrentId();
     linux_tid_ = static_cast<pid_t>(syscall(SYS_gettid));
+    RegisterThread(linux_tid_, thread_name_);
+    os::trace::Init();
     start_up_promise.set_value();
   }
 
@@ -187,6 +275,7 @@ void MessageLoopThread::Run(std::promise<void> start_up_promise) {
 
   {
     std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+    UnregisterThread(linux_tid_);
     thread_id_ = -1;
     linux_tid_ = -1;
     delete message_loop_;
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <unistd.h>
+#include <chrono>
 #include <future>
 #include <memory>
 #include <string>
@@ -28,6 +29,9 @@
 #include <base/run_loop.h>
 #include <base/threading/platform_thread.h>
 
+#include "common/task_statistics.h"
+#include "common/thread_profile.h"
+
 namespace bluetooth {
 
 namespace common {
@@ -120,6 +124,31 @@ class MessageLoopThread final {
    */
   bool EnableRealTimeScheduling();
 
+  /**
+   * Schedule this thread as the profile of |role| asks
+   *
+   * @param role what this thread does
+   * @return true iff every setting of the profile was applied
+   */
+  bool ApplyThreadRole(ThreadRole role);
+
+  /**
+   * Record the wait and run times of the tasks posted from now on, per posting
+   * location, and log the busiest posting locations when a task runs longer
+   * than |watchdog_run_time| or more than |watchdog_queue_depth| tasks are
+   * queued. Zero disables either trigger. Off by default, as it costs two
+   * clock reads and a lock per task.
+   *
+   * Repeated call to this method keeps the first statistics
+   */
+  void EnableTaskStatistics(std::chrono::microseconds watchdog_run_time,
+                            size_t watchdog_queue_depth);
+
+  /**
+   * Write the task statistics of this thread to |fd|, if enabled
+   */
+  void DumpTaskStatistics(int fd) const;
+
   /**
    * Return the weak pointer to this object. This can be useful when posting
    * delayed tasks to this MessageLoopThread using Timer.
@@ -197,6 +226,8 @@ class MessageLoopThread final {
   pid_t linux_tid_;
   base::WeakPtrFactory<MessageLoopThread> weak_ptr_factory_;
   bool shutting_down_;
+  // Shared with the tasks posted while enabled, which may outlive this thread
+  std::shared_ptr<TaskStatistics> task_statistics_;
 
   DISALLOW_COPY_AND_ASSIGN(MessageLoopThread);
 };
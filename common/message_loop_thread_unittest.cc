@@ -172,6 +172,40 @@ TEST_F(MessageLoopThreadTest, test_set_realtime_priority_fail_before_start) {
   ASSERT_FALSE(message_loop_thread.EnableRealTimeScheduling());
 }
 
+TEST_F(MessageLoopThreadTest, test_apply_thread_role_fail_before_start) {
+  std::string name = "test_thread";
+  MessageLoopThread message_loop_thread(name);
+  ASSERT_FALSE(message_loop_thread.ApplyThreadRole(
+      bluetooth::common::ThreadRole::DEFAULT));
+}
+
+TEST_F(MessageLoopThreadTest, test_task_statistics) {
+  std::string name = "test_thread";
+  MessageLoopThread message_loop_thread(name);
+  message_loop_thread.EnableTaskStatistics(std::chrono::microseconds(0), 0);
+  message_loop_thread.StartUp();
+  std::promise<std::string> name_promise;
+  std::future<std::string> name_future = name_promise.get_future();
+  message_loop_thread.DoInThread(
+      FROM_HERE,
+      base::BindOnce(&MessageLoopThreadTest::SleepAndGetName,
+                     base::Unretained(this), std::move(name_promise), 10));
+  ASSERT_EQ(name_future.get(), name);
+  message_loop_thread.ShutDown();
+
+  FILE* dump = tmpfile();
+  ASSERT_NE(dump, nullptr);
+  message_loop_thread.DumpTaskStatistics(fileno(dump));
+  rewind(dump);
+  std::string text;
+  char buffer[256];
+  while (fgets(buffer, sizeof(buffer), dump) != nullptr) text += buffer;
+  fclose(dump);
+  ASSERT_NE(text.find("message_loop_thread_unittest.cc"), std::string::npos)
+      << text;
+  ASSERT_NE(text.find("1 tasks"), std::string::npos) << text;
+}
+
 TEST_F(MessageLoopThreadTest, test_set_realtime_priority_success) {
   std::string name = "test_thread";
   MessageLoopThread message_loop_thread(name);
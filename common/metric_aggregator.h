@@ -0,0 +1,139 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace bluetooth {
+
+namespace common {
+
+/**
+ * Aggregates identical metric events in memory until they are flushed, so
+ * that a burst of events costs a single write per distinct event
+ *
+ * Events are identified by a Key, typically a tuple of the address of the
+ * device and of the fields of the event. Each event carries up to kNumValues
+ * values that are summed per key, and the first of them is also counted in a
+ * histogram with power of two buckets.
+ *
+ * Thread safe.
+ */
+template <typename Key>
+class MetricAggregator {
+ public:
+  static constexpr size_t kNumValues = 4;
+  static constexpr size_t kNumBuckets = 16;
+
+  using Values = std::array<int64_t, kNumValues>;
+
+  struct Aggregate {
+    // Number of events aggregated
+    int64_t count = 0;
+    // Sums of the values of the events
+    Values sums = {};
+    // Bucket 0 counts the values 0 or below, bucket i the values in
+    // [2^(i-1), 2^i), and the last bucket all the values above
+    std::array<uint32_t, kNumBuckets> histogram = {};
+  };
+
+  using Aggregates = std::map<Key, Aggregate>;
+
+  /**
+   * Constructor of the aggregator
+   *
+   * @param flush_interval_ms time after the first event aggregated after
+   *                          which the aggregates are due to be flushed
+   * @param max_keys number of distinct events after which the aggregates are
+   *                 due to be flushed
+   */
+  MetricAggregator(uint64_t flush_interval_ms, size_t max_keys)
+      : flush_interval_ms_(flush_interval_ms), max_keys_(max_keys) {}
+
+  // delete copy constructor
+  MetricAggregator(MetricAggregator const&) = delete;
+  MetricAggregator& operator=(MetricAggregator const&) = delete;
+
+  /**
+   * Aggregate an event
+   *
+   * @param key identifies the event
+   * @param values values of the event
+   * @param now_ms current time, in milliseconds
+   * @return true if the aggregates are due to be flushed with Take()
+   */
+  bool Add(const Key& key, const Values& values, uint64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (aggregates_.empty()) first_event_ms_ = now_ms;
+    Aggregate& aggregate = aggregates_[key];
+    aggregate.count++;
+    for (size_t i = 0; i < kNumValues; i++) {
+      aggregate.sums[i] += values[i];
+    }
+    aggregate.histogram[BucketOf(values[0])]++;
+    return aggregates_.size() >= max_keys_ ||
+           now_ms - first_event_ms_ >= flush_interval_ms_;
+  }
+
+  /**
+   * @return a copy of the aggregates by key
+   */
+  Aggregates Get() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return aggregates_;
+  }
+
+  /**
+   * Take the aggregates, leaving the aggregator empty
+   *
+   * @return the aggregates by key
+   */
+  Aggregates Take() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Aggregates aggregates;
+    aggregates.swap(aggregates_);
+    return aggregates;
+  }
+
+  /**
+   * @return bucket of the histogram that counts |value|
+   */
+  static size_t BucketOf(int64_t value) {
+    size_t bucket = 0;
+    while (value > 0 && bucket < kNumBuckets - 1) {
+      value >>= 1;
+      bucket++;
+    }
+    return bucket;
+  }
+
+ private:
+  std::mutex mutex_;
+  Aggregates aggregates_;
+  uint64_t first_event_ms_ = 0;
+  const uint64_t flush_interval_ms_;
+  const size_t max_keys_;
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <string>
+#include <tuple>
+
+#include "common/metric_aggregator.h"
+
+namespace testing {
+
+using bluetooth::common::MetricAggregator;
+
+using TestKey = std::tuple<std::string, int>;
+
+TEST(BluetoothMetricAggregatorTest, AggregatesIdenticalEvents) {
+  MetricAggregator<TestKey> aggregator(1000, 10);
+  EXPECT_FALSE(aggregator.Add(TestKey("a", 1), {3, 1, 0, 0}, 0));
+  EXPECT_FALSE(aggregator.Add(TestKey("a", 1), {5, 1, 0, 0}, 1));
+  EXPECT_FALSE(aggregator.Add(TestKey("a", 2), {0, 0, 0, 7}, 2));
+
+  auto aggregates = aggregator.Take();
+  ASSERT_EQ(aggregates.size(), 2u);
+  const auto& a1 = aggregates[TestKey("a", 1)];
+  EXPECT_EQ(a1.count, 2);
+  EXPECT_EQ(a1.sums[0], 8);
+  EXPECT_EQ(a1.sums[1], 2);
+  EXPECT_EQ(a1.histogram[2], 1u);
+  EXPECT_EQ(a1.histogram[3], 1u);
+  const auto& a2 = aggregates[TestKey("a", 2)];
+  EXPECT_EQ(a2.count, 1);
+  EXPECT_EQ(a2.sums[3], 7);
+  EXPECT_EQ(a2.histogram[0], 1u);
+
+  EXPECT_TRUE(aggregator.Take().empty());
+}
+
+TEST(BluetoothMetricAggregatorTest, DueAfterFlushInterval) {
+  MetricAggregator<TestKey> aggregator(1000, 10);
+  EXPECT_FALSE(aggregator.Add(TestKey("a", 1), {}, 5000));
+  EXPECT_FALSE(aggregator.Add(TestKey("a", 1), {}, 5999));
+  EXPECT_TRUE(aggregator.Add(TestKey("a", 1), {}, 6000));
+  aggregator.Take();
+
+  // The interval starts again with the first event after Take()
+  EXPECT_FALSE(aggregator.Add(TestKey("a", 1), {}, 9000));
+  EXPECT_TRUE(aggregator.Add(TestKey("a", 1), {}, 10000));
+}
+
+TEST(BluetoothMetricAggregatorTest, DueAfterMaxKeys) {
+  MetricAggregator<TestKey> aggregator(1000, 3);
+  EXPECT_FALSE(aggregator.Add(TestKey("a", 1), {}, 0));
+  EXPECT_FALSE(aggregator.Add(TestKey("a", 2), {}, 0));
+  EXPECT_FALSE(aggregator.Add(TestKey("a", 2), {}, 0));
+  EXPECT_TRUE(aggregator.Add(TestKey("b", 1), {}, 0));
+  EXPECT_EQ(aggregator.Get().size(), 3u);
+}
+
+TEST(BluetoothMetricAggregatorTest, HistogramBuckets) {
+  using Aggregator = MetricAggregator<TestKey>;
+  EXPECT_EQ(Aggregator::BucketOf(-5), 0u);
+  EXPECT_EQ(Aggregator::BucketOf(0), 0u);
+  EXPECT_EQ(Aggregator::BucketOf(1), 1u);
+  EXPECT_EQ(Aggregator::BucketOf(2), 2u);
+  EXPECT_EQ(Aggregator::BucketOf(3), 2u);
+  EXPECT_EQ(Aggregator::BucketOf(4), 3u);
+  EXPECT_EQ(Aggregator::BucketOf(INT64_MAX), Aggregator::kNumBuckets - 1);
+}
+
+}  // namespace testing
@@ -19,12 +19,16 @@
 #include <unistd.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cerrno>
 #include <chrono>
+#include <cinttypes>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <memory>
 #include <mutex>
+#include <tuple>
 
 #include <base/base64.h>
 #include <base/logging.h>
@@ -37,6 +41,7 @@
 
 #include "address_obfuscator.h"
 #include "leaky_bonded_queue.h"
+#include "metric_aggregator.h"
 #include "metric_id_allocator.h"
 #include "metrics.h"
 #include "time_util.h"
@@ -53,8 +58,10 @@ using bluetooth::metrics::BluetoothMetricsProto::
     BluetoothSession_ConnectionTechnologyType;
 using bluetooth::metrics::BluetoothMetricsProto::
     BluetoothSession_DisconnectReasonType;
+using bluetooth::metrics::BluetoothMetricsProto::DeviceDiscoveryStats;
 using bluetooth::metrics::BluetoothMetricsProto::DeviceInfo;
 using bluetooth::metrics::BluetoothMetricsProto::DeviceInfo_DeviceType;
+using bluetooth::metrics::BluetoothMetricsProto::GattDiscoveryStats;
 using bluetooth::metrics::BluetoothMetricsProto::HeadsetProfileConnectionStats;
 using bluetooth::metrics::BluetoothMetricsProto::HeadsetProfileType;
 using bluetooth::metrics::BluetoothMetricsProto::HeadsetProfileType_ARRAYSIZE;
@@ -264,6 +271,8 @@ struct BluetoothMetricsLogger::impl {
         scan_event_queue_(new LeakyBondedQueue<ScanEvent>(max_scan_event)) {
     bluetooth_log_ = BluetoothLog::default_instance().New();
     headset_profile_connection_counts_.fill(0);
+    gatt_discovery_stats_ = GattDiscoveryStats();
+    device_discovery_stats_ = DeviceDiscoveryStats();
     bluetooth_session_ = nullptr;
     bluetooth_session_start_time_ms_ = 0;
     a2dp_session_metrics_ = A2dpSessionMetrics();
@@ -273,6 +282,8 @@ struct BluetoothMetricsLogger::impl {
   BluetoothLog* bluetooth_log_;
   std::array<int, HeadsetProfileType_ARRAYSIZE>
       headset_profile_connection_counts_;
+  GattDiscoveryStats gatt_discovery_stats_;
+  DeviceDiscoveryStats device_discovery_stats_;
   std::recursive_mutex bluetooth_log_lock_;
   /* End Bluetooth log lock protected */
   /* Bluetooth session lock protected */
@@ -453,6 +464,45 @@ void BluetoothMetricsLogger::LogHeadsetProfileRfcConnection(
   return;
 }
 
+void BluetoothMetricsLogger::LogGattDiscovery(bool from_cache,
+                                              int64_t duration_ms) {
+  std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
+  GattDiscoveryStats& stats = pimpl_->gatt_discovery_stats_;
+  if (from_cache) {
+    stats.set_num_cached_discoveries(stats.num_cached_discoveries() + 1);
+    stats.set_discovery_time_saved_ms(stats.discovery_time_saved_ms() +
+                                      duration_ms);
+  } else {
+    stats.set_num_full_discoveries(stats.num_full_discoveries() + 1);
+    stats.set_full_discovery_time_ms(stats.full_discovery_time_ms() +
+                                     duration_ms);
+  }
+}
+
+void BluetoothMetricsLogger::LogGattMtuExchange(int64_t duration_ms) {
+  std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
+  GattDiscoveryStats& stats = pimpl_->gatt_discovery_stats_;
+  stats.set_num_mtu_exchanges(stats.num_mtu_exchanges() + 1);
+  stats.set_mtu_exchange_time_ms(stats.mtu_exchange_time_ms() + duration_ms);
+}
+
+void BluetoothMetricsLogger::LogDeviceDiscovery(int64_t time_to_first_device_ms,
+                                                int64_t time_to_complete_ms,
+                                                int32_t num_devices) {
+  std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
+  DeviceDiscoveryStats& stats = pimpl_->device_discovery_stats_;
+  stats.set_num_discoveries(stats.num_discoveries() + 1);
+  if (time_to_first_device_ms >= 0) {
+    stats.set_num_discoveries_with_devices(
+        stats.num_discoveries_with_devices() + 1);
+    stats.set_time_to_first_device_ms(stats.time_to_first_device_ms() +
+                                      time_to_first_device_ms);
+  }
+  stats.set_time_to_complete_ms(stats.time_to_complete_ms() +
+                                time_to_complete_ms);
+  stats.set_num_devices_found(stats.num_devices_found() + num_devices);
+}
+
 void BluetoothMetricsLogger::WriteString(std::string* serialized) {
   std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
   LOG(INFO) << __func__ << ": building metrics";
@@ -544,6 +594,18 @@ void BluetoothMetricsLogger::Build() {
     }
   }
   pimpl_->headset_profile_connection_counts_.fill(0);
+  if (pimpl_->gatt_discovery_stats_.num_full_discoveries() > 0 ||
+      pimpl_->gatt_discovery_stats_.num_cached_discoveries() > 0 ||
+      pimpl_->gatt_discovery_stats_.num_mtu_exchanges() > 0) {
+    bluetooth_log->mutable_gatt_discovery_stats()->MergeFrom(
+        pimpl_->gatt_discovery_stats_);
+  }
+  pimpl_->gatt_discovery_stats_.Clear();
+  if (pimpl_->device_discovery_stats_.num_discoveries() > 0) {
+    bluetooth_log->mutable_device_discovery_stats()->MergeFrom(
+        pimpl_->device_discovery_stats_);
+  }
+  pimpl_->device_discovery_stats_.Clear();
 }
 
 void BluetoothMetricsLogger::ResetSession() {
@@ -570,12 +632,11 @@ void BluetoothMetricsLogger::Reset() {
   pimpl_->scan_event_queue_->Clear();
 }
 
-void LogLinkLayerConnectionEvent(const RawAddress* address,
-                                 uint32_t connection_handle,
-                                 android::bluetooth::DirectionEnum direction,
-                                 uint16_t link_type, uint32_t hci_cmd,
-                                 uint16_t hci_event, uint16_t hci_ble_event,
-                                 uint16_t cmd_status, uint16_t reason_code) {
+static void WriteLinkLayerConnectionEvent(
+    const RawAddress* address, uint32_t connection_handle,
+    android::bluetooth::DirectionEnum direction, uint16_t link_type,
+    uint32_t hci_cmd, uint16_t hci_event, uint16_t hci_ble_event,
+    uint16_t cmd_status, uint16_t reason_code) {
   std::string obfuscated_id;
   int metric_id = 0;
   if (address != nullptr) {
@@ -623,9 +684,9 @@ void LogRemoteVersionInfo(uint16_t handle, uint8_t status, uint8_t version,
   }
 }
 
-void LogA2dpAudioUnderrunEvent(const RawAddress& address,
-                               uint64_t encoding_interval_millis,
-                               int num_missing_pcm_bytes) {
+static void WriteA2dpAudioUnderrunEvent(const RawAddress& address,
+                                        uint64_t encoding_interval_millis,
+                                        int num_missing_pcm_bytes) {
   std::string obfuscated_id;
   int metric_id = 0;
   if (!address.IsEmpty()) {
@@ -648,11 +709,11 @@ void LogA2dpAudioUnderrunEvent(const RawAddress& address,
   }
 }
 
-void LogA2dpAudioOverrunEvent(const RawAddress& address,
-                              uint64_t encoding_interval_millis,
-                              int num_dropped_buffers,
-                              int num_dropped_encoded_frames,
-                              int num_dropped_encoded_bytes) {
+static void WriteA2dpAudioOverrunEvent(const RawAddress& address,
+                                       uint64_t encoding_interval_millis,
+                                       int num_dropped_buffers,
+                                       int num_dropped_encoded_frames,
+                                       int num_dropped_encoded_bytes) {
   std::string obfuscated_id;
   int metric_id = 0;
   if (!address.IsEmpty()) {
@@ -748,9 +809,9 @@ void LogReadTxPowerLevelResult(const RawAddress& address, uint16_t handle,
   }
 }
 
-void LogSmpPairingEvent(const RawAddress& address, uint8_t smp_cmd,
-                        android::bluetooth::DirectionEnum direction,
-                        uint8_t smp_fail_reason) {
+static void WriteSmpPairingEvent(const RawAddress& address, uint8_t smp_cmd,
+                                 android::bluetooth::DirectionEnum direction,
+                                 uint8_t smp_fail_reason) {
   std::string obfuscated_id;
   int metric_id = 0;
   if (!address.IsEmpty()) {
@@ -772,8 +833,8 @@ void LogSmpPairingEvent(const RawAddress& address, uint8_t smp_cmd,
   }
 }
 
-void LogClassicPairingEvent(const RawAddress& address, uint16_t handle, uint32_t hci_cmd, uint16_t hci_event,
-                            uint16_t cmd_status, uint16_t reason_code, int64_t event_value) {
+static void WriteClassicPairingEvent(const RawAddress& address, uint16_t handle, uint32_t hci_cmd, uint16_t hci_event,
+                                     uint16_t cmd_status, uint16_t reason_code, int64_t event_value) {
   std::string obfuscated_id;
   int metric_id = 0;
   if (!address.IsEmpty()) {
@@ -878,6 +939,199 @@ void LogManufacturerInfo(const RawAddress& address,
   }
 }
 
+// Events aggregated before being written, until either this time elapsed
+// since the first one or this many distinct events are aggregated
+static const uint64_t kMetricsFlushIntervalMs = 60000;
+static const size_t kMetricsMaxAggregatedEvents = 256;
+
+// Address is empty when has_address is false
+using LinkLayerConnectionEventKey =
+    std::tuple<bool, RawAddress, uint32_t, int, uint16_t, uint32_t, uint16_t,
+               uint16_t, uint16_t, uint16_t>;
+using A2dpAudioEventKey = std::tuple<RawAddress>;
+using SmpPairingEventKey = std::tuple<RawAddress, uint8_t, int, uint8_t>;
+using ClassicPairingEventKey =
+    std::tuple<RawAddress, uint16_t, uint32_t, uint16_t, uint16_t, uint16_t,
+               int64_t>;
+
+static std::atomic<bool> per_event_logging(false);
+static MetricAggregator<LinkLayerConnectionEventKey>
+    link_layer_connection_events(kMetricsFlushIntervalMs,
+                                 kMetricsMaxAggregatedEvents);
+// Values: num_missing_pcm_bytes, encoding_interval_millis
+static MetricAggregator<A2dpAudioEventKey> a2dp_audio_underrun_events(
+    kMetricsFlushIntervalMs, kMetricsMaxAggregatedEvents);
+// Values: num_dropped_encoded_bytes, num_dropped_buffers,
+// num_dropped_encoded_frames, encoding_interval_millis
+static MetricAggregator<A2dpAudioEventKey> a2dp_audio_overrun_events(
+    kMetricsFlushIntervalMs, kMetricsMaxAggregatedEvents);
+static MetricAggregator<SmpPairingEventKey> smp_pairing_events(
+    kMetricsFlushIntervalMs, kMetricsMaxAggregatedEvents);
+static MetricAggregator<ClassicPairingEventKey> classic_pairing_events(
+    kMetricsFlushIntervalMs, kMetricsMaxAggregatedEvents);
+
+void SetMetricsPerEventLogging(bool enable) { per_event_logging = enable; }
+
+void FlushMetrics() {
+  for (const auto& entry : link_layer_connection_events.Take()) {
+    const LinkLayerConnectionEventKey& key = entry.first;
+    WriteLinkLayerConnectionEvent(
+        std::get<0>(key) ? &std::get<1>(key) : nullptr, std::get<2>(key),
+        static_cast<android::bluetooth::DirectionEnum>(std::get<3>(key)),
+        std::get<4>(key), std::get<5>(key), std::get<6>(key),
+        std::get<7>(key), std::get<8>(key), std::get<9>(key));
+  }
+  for (const auto& entry : a2dp_audio_underrun_events.Take()) {
+    const auto& sums = entry.second.sums;
+    WriteA2dpAudioUnderrunEvent(std::get<0>(entry.first), sums[1], sums[0]);
+  }
+  for (const auto& entry : a2dp_audio_overrun_events.Take()) {
+    const auto& sums = entry.second.sums;
+    WriteA2dpAudioOverrunEvent(std::get<0>(entry.first), sums[3], sums[1],
+                               sums[2], sums[0]);
+  }
+  for (const auto& entry : smp_pairing_events.Take()) {
+    const SmpPairingEventKey& key = entry.first;
+    WriteSmpPairingEvent(
+        std::get<0>(key), std::get<1>(key),
+        static_cast<android::bluetooth::DirectionEnum>(std::get<2>(key)),
+        std::get<3>(key));
+  }
+  for (const auto& entry : classic_pairing_events.Take()) {
+    const ClassicPairingEventKey& key = entry.first;
+    WriteClassicPairingEvent(std::get<0>(key), std::get<1>(key),
+                             std::get<2>(key), std::get<3>(key),
+                             std::get<4>(key), std::get<5>(key),
+                             std::get<6>(key));
+  }
+}
+
+template <typename Key>
+static void DumpAggregates(int fd, const char* name,
+                           MetricAggregator<Key>* aggregator,
+                           const char* histogram_unit) {
+  int64_t count = 0;
+  std::array<uint32_t, MetricAggregator<Key>::kNumBuckets> histogram = {};
+  auto aggregates = aggregator->Get();
+  for (const auto& entry : aggregates) {
+    count += entry.second.count;
+    for (size_t i = 0; i < histogram.size(); i++) {
+      histogram[i] += entry.second.histogram[i];
+    }
+  }
+  dprintf(fd, "  %s: %" PRId64 " events, %zu distinct\n", name, count,
+          aggregates.size());
+  if (histogram_unit == nullptr) return;
+  for (size_t i = 0; i < histogram.size(); i++) {
+    if (histogram[i] == 0) continue;
+    dprintf(fd, "    < %" PRId64 " %s: %u\n", (int64_t)1 << i, histogram_unit,
+            histogram[i]);
+  }
+}
+
+void MetricsDebugDump(int fd) {
+  dprintf(fd, "\nBluetooth Metrics Aggregates:\n");
+  if (per_event_logging) {
+    dprintf(fd, "  Per event logging\n");
+    return;
+  }
+  DumpAggregates(fd, "Link layer connection", &link_layer_connection_events,
+                 nullptr);
+  DumpAggregates(fd, "A2DP audio underrun", &a2dp_audio_underrun_events,
+                 "missing PCM bytes");
+  DumpAggregates(fd, "A2DP audio overrun", &a2dp_audio_overrun_events,
+                 "dropped encoded bytes");
+  DumpAggregates(fd, "SMP pairing", &smp_pairing_events, nullptr);
+  DumpAggregates(fd, "Classic pairing", &classic_pairing_events, nullptr);
+}
+
+void LogLinkLayerConnectionEvent(const RawAddress* address,
+                                 uint32_t connection_handle,
+                                 android::bluetooth::DirectionEnum direction,
+                                 uint16_t link_type, uint32_t hci_cmd,
+                                 uint16_t hci_event, uint16_t hci_ble_event,
+                                 uint16_t cmd_status, uint16_t reason_code) {
+  if (per_event_logging) {
+    WriteLinkLayerConnectionEvent(address, connection_handle, direction,
+                                  link_type, hci_cmd, hci_event, hci_ble_event,
+                                  cmd_status, reason_code);
+    return;
+  }
+  LinkLayerConnectionEventKey key(
+      address != nullptr, address != nullptr ? *address : RawAddress::kEmpty,
+      connection_handle, direction, link_type, hci_cmd, hci_event,
+      hci_ble_event, cmd_status, reason_code);
+  if (link_layer_connection_events.Add(key, {}, time_get_os_boottime_ms())) {
+    FlushMetrics();
+  }
+}
+
+void LogA2dpAudioUnderrunEvent(const RawAddress& address,
+                               uint64_t encoding_interval_millis,
+                               int num_missing_pcm_bytes) {
+  if (per_event_logging) {
+    WriteA2dpAudioUnderrunEvent(address, encoding_interval_millis,
+                                num_missing_pcm_bytes);
+    return;
+  }
+  if (a2dp_audio_underrun_events.Add(
+          A2dpAudioEventKey(address),
+          {num_missing_pcm_bytes,
+           static_cast<int64_t>(encoding_interval_millis), 0, 0},
+          time_get_os_boottime_ms())) {
+    FlushMetrics();
+  }
+}
+
+void LogA2dpAudioOverrunEvent(const RawAddress& address,
+                              uint64_t encoding_interval_millis,
+                              int num_dropped_buffers,
+                              int num_dropped_encoded_frames,
+                              int num_dropped_encoded_bytes) {
+  if (per_event_logging) {
+    WriteA2dpAudioOverrunEvent(address, encoding_interval_millis,
+                               num_dropped_buffers, num_dropped_encoded_frames,
+                               num_dropped_encoded_bytes);
+    return;
+  }
+  if (a2dp_audio_overrun_events.Add(
+          A2dpAudioEventKey(address),
+          {num_dropped_encoded_bytes, num_dropped_buffers,
+           num_dropped_encoded_frames,
+           static_cast<int64_t>(encoding_interval_millis)},
+          time_get_os_boottime_ms())) {
+    FlushMetrics();
+  }
+}
+
+void LogSmpPairingEvent(const RawAddress& address, uint8_t smp_cmd,
+                        android::bluetooth::DirectionEnum direction,
+                        uint8_t smp_fail_reason) {
+  if (per_event_logging) {
+    WriteSmpPairingEvent(address, smp_cmd, direction, smp_fail_reason);
+    return;
+  }
+  if (smp_pairing_events.Add(
+          SmpPairingEventKey(address, smp_cmd, direction, smp_fail_reason), {},
+          time_get_os_boottime_ms())) {
+    FlushMetrics();
+  }
+}
+
+void LogClassicPairingEvent(const RawAddress& address, uint16_t handle, uint32_t hci_cmd, uint16_t hci_event,
+                            uint16_t cmd_status, uint16_t reason_code, int64_t event_value) {
+  if (per_event_logging) {
+    WriteClassicPairingEvent(address, handle, hci_cmd, hci_event, cmd_status,
+                             reason_code, event_value);
+    return;
+  }
+  ClassicPairingEventKey key(address, handle, hci_cmd, hci_event, cmd_status,
+                             reason_code, event_value);
+  if (classic_pairing_events.Add(key, {}, time_get_os_boottime_ms())) {
+    FlushMetrics();
+  }
+}
+
 }  // namespace common
 
 }  // namespace bluetooth
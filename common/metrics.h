@@ -225,6 +225,37 @@ class BluetoothMetricsLogger {
    */
   void LogHeadsetProfileRfcConnection(tBTA_SERVICE_ID service_id);
 
+  /**
+   * Log a GATT client service discovery of a server
+   *
+   * @param from_cache true if the discovery was skipped, because the Database
+   *                   Hash of the server matched its cached database
+   * @param duration_ms time the full discovery took, or would have taken
+   *                    when skipped, in milliseconds
+   */
+  void LogGattDiscovery(bool from_cache, int64_t duration_ms);
+
+  /**
+   * Log an ATT MTU exchange started by the stack as a LE link came up
+   *
+   * @param duration_ms time from the connection to the end of the exchange,
+   *                    in milliseconds
+   */
+  void LogGattMtuExchange(int64_t duration_ms);
+
+  /**
+   * Log a device discovery, from the start of the inquiry to the end of the
+   * name and service discovery of the devices found
+   *
+   * @param time_to_first_device_ms time until the first device was found, in
+   *                                milliseconds, negative if none was found
+   * @param time_to_complete_ms time until the discovery completed or was
+   *                            cancelled, in milliseconds
+   * @param num_devices number of devices found
+   */
+  void LogDeviceDiscovery(int64_t time_to_first_device_ms,
+                          int64_t time_to_complete_ms, int32_t num_devices);
+
   /*
    * Writes the metrics, in base64 protobuf format, into the descriptor FD,
    * metrics events are always cleared after dump
@@ -361,6 +392,33 @@ void LogA2dpAudioOverrunEvent(const RawAddress& address,
                               int num_dropped_encoded_frames,
                               int num_dropped_encoded_bytes);
 
+/**
+ * Enable or disable per event logging
+ *
+ * By default, the link layer connection, A2DP audio underrun and overrun, SMP
+ * pairing and classic pairing events are aggregated in memory, and each
+ * distinct event is written once per minute, or once 256 distinct events are
+ * aggregated. For the A2DP audio events, the written event carries the sums of
+ * the aggregated events. Per event logging writes each event as it is logged,
+ * for debugging.
+ *
+ * @param enable true to write each event as it is logged
+ */
+void SetMetricsPerEventLogging(bool enable);
+
+/**
+ * Write the aggregated events now
+ */
+void FlushMetrics();
+
+/**
+ * Dump the counts of the aggregated events, and the histograms of the values
+ * of the A2DP audio events
+ *
+ * @param fd file descriptor to dump to
+ */
+void MetricsDebugDump(int fd);
+
 /**
  * Log read RSSI result
  *
@@ -72,6 +72,15 @@ void BluetoothMetricsLogger::LogA2dpSession(
 void BluetoothMetricsLogger::LogHeadsetProfileRfcConnection(
     tBTA_SERVICE_ID service_id) {}
 
+void BluetoothMetricsLogger::LogGattDiscovery(bool from_cache,
+                                              int64_t duration_ms) {}
+
+void BluetoothMetricsLogger::LogGattMtuExchange(int64_t duration_ms) {}
+
+void BluetoothMetricsLogger::LogDeviceDiscovery(int64_t time_to_first_device_ms,
+                                                int64_t time_to_complete_ms,
+                                                int32_t num_devices) {}
+
 void BluetoothMetricsLogger::WriteString(std::string* serialized) {}
 
 void BluetoothMetricsLogger::WriteBase64String(std::string* serialized) {}
@@ -960,6 +960,64 @@ TEST_F(BluetoothMetricsLoggerTest, LogHeadsetProfileRfcConnectionTest) {
   delete metrics;
 }
 
+TEST_F(BluetoothMetricsLoggerTest, LogGattDiscoveryTest) {
+  BluetoothMetricsLogger::GetInstance()->LogGattDiscovery(false, 1500);
+  BluetoothMetricsLogger::GetInstance()->LogGattDiscovery(true, 1500);
+  BluetoothMetricsLogger::GetInstance()->LogGattDiscovery(true, 700);
+  std::string msg_str;
+  BluetoothMetricsLogger::GetInstance()->WriteString(&msg_str);
+  BluetoothLog* metrics = BluetoothLog::default_instance().New();
+  metrics->ParseFromString(msg_str);
+  ASSERT_TRUE(metrics->has_gatt_discovery_stats());
+  EXPECT_EQ(metrics->gatt_discovery_stats().num_full_discoveries(), 1);
+  EXPECT_EQ(metrics->gatt_discovery_stats().full_discovery_time_ms(), 1500);
+  EXPECT_EQ(metrics->gatt_discovery_stats().num_cached_discoveries(), 2);
+  EXPECT_EQ(metrics->gatt_discovery_stats().discovery_time_saved_ms(), 2200);
+  msg_str.clear();
+  // Verify that dump after clean up result in no statistics
+  BluetoothMetricsLogger::GetInstance()->WriteString(&msg_str);
+  metrics->ParseFromString(msg_str);
+  EXPECT_FALSE(metrics->has_gatt_discovery_stats());
+  delete metrics;
+}
+
+TEST_F(BluetoothMetricsLoggerTest, LogGattMtuExchangeTest) {
+  BluetoothMetricsLogger::GetInstance()->LogGattMtuExchange(40);
+  BluetoothMetricsLogger::GetInstance()->LogGattMtuExchange(60);
+  std::string msg_str;
+  BluetoothMetricsLogger::GetInstance()->WriteString(&msg_str);
+  BluetoothLog* metrics = BluetoothLog::default_instance().New();
+  metrics->ParseFromString(msg_str);
+  ASSERT_TRUE(metrics->has_gatt_discovery_stats());
+  EXPECT_EQ(metrics->gatt_discovery_stats().num_mtu_exchanges(), 2);
+  EXPECT_EQ(metrics->gatt_discovery_stats().mtu_exchange_time_ms(), 100);
+  EXPECT_EQ(metrics->gatt_discovery_stats().num_full_discoveries(), 0);
+  delete metrics;
+}
+
+TEST_F(BluetoothMetricsLoggerTest, LogDeviceDiscoveryTest) {
+  BluetoothMetricsLogger::GetInstance()->LogDeviceDiscovery(300, 9000, 4);
+  BluetoothMetricsLogger::GetInstance()->LogDeviceDiscovery(-1, 10240, 0);
+  BluetoothMetricsLogger::GetInstance()->LogDeviceDiscovery(500, 6000, 2);
+  std::string msg_str;
+  BluetoothMetricsLogger::GetInstance()->WriteString(&msg_str);
+  BluetoothLog* metrics = BluetoothLog::default_instance().New();
+  metrics->ParseFromString(msg_str);
+  ASSERT_TRUE(metrics->has_device_discovery_stats());
+  EXPECT_EQ(metrics->device_discovery_stats().num_discoveries(), 3);
+  EXPECT_EQ(metrics->device_discovery_stats().num_discoveries_with_devices(),
+            2);
+  EXPECT_EQ(metrics->device_discovery_stats().time_to_first_device_ms(), 800);
+  EXPECT_EQ(metrics->device_discovery_stats().time_to_complete_ms(), 25240);
+  EXPECT_EQ(metrics->device_discovery_stats().num_devices_found(), 6);
+  msg_str.clear();
+  // Verify that dump after clean up result in no statistics
+  BluetoothMetricsLogger::GetInstance()->WriteString(&msg_str);
+  metrics->ParseFromString(msg_str);
+  EXPECT_FALSE(metrics->has_device_discovery_stats());
+  delete metrics;
+}
+
 TEST_F(BluetoothMetricsLoggerTest, LogHeadsetProfileRfcConnectionErrorTest) {
   BluetoothMetricsLogger::GetInstance()->LogHeadsetProfileRfcConnection(
       BTA_HSP_SERVICE_ID);
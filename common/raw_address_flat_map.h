@@ -0,0 +1,217 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "raw_address.h"
+
+namespace bluetooth {
+
+namespace common {
+
+/**
+ * Hash map from RawAddress to V, with open addressing and linear probing
+ *
+ * The keys and values are stored inline in a single array, so that a lookup
+ * usually touches one cache line, without the node allocations of std::map
+ * and std::unordered_map. V must be default constructible and movable.
+ *
+ * Pointers to the values are invalidated by Put() and Erase().
+ *
+ * Not thread safe.
+ */
+template <typename V>
+class RawAddressFlatMap {
+ public:
+  /**
+   * Constructor of the map
+   *
+   * @param capacity number of entries the map holds without growing
+   */
+  explicit RawAddressFlatMap(size_t capacity = 8) {
+    size_t slots = kMinSlots;
+    while (slots * kMaxLoadNum < capacity * kMaxLoadDen) slots <<= 1;
+    Rehash(slots);
+  }
+
+  /**
+   * @return pointer to the value of |key|, nullptr if it is not in the map
+   */
+  V* Find(const RawAddress& key) {
+    size_t slot = FindSlot(key);
+    return slot == kNotFound ? nullptr : &slots_[slot].value;
+  }
+
+  const V* Find(const RawAddress& key) const {
+    size_t slot = FindSlot(key);
+    return slot == kNotFound ? nullptr : &slots_[slot].value;
+  }
+
+  bool Contains(const RawAddress& key) const {
+    return FindSlot(key) != kNotFound;
+  }
+
+  /**
+   * Insert |value| for |key|, replacing its current value if any
+   *
+   * @return true if |key| was not in the map
+   */
+  bool Put(const RawAddress& key, V value) {
+    size_t slot = FindSlot(key);
+    if (slot != kNotFound) {
+      slots_[slot].value = std::move(value);
+      return false;
+    }
+    if ((size_ + 1) * kMaxLoadDen > slots_.size() * kMaxLoadNum) {
+      Rehash(slots_.size() * 2);
+    }
+    InsertNew(key, std::move(value));
+    return true;
+  }
+
+  /**
+   * Remove |key| from the map
+   *
+   * @return true if |key| was in the map
+   */
+  bool Erase(const RawAddress& key) {
+    size_t slot = FindSlot(key);
+    if (slot == kNotFound) return false;
+    EraseSlot(slot);
+    return true;
+  }
+
+  /**
+   * Remove the entries for which |predicate(key, value)| is true
+   *
+   * @return number of entries removed
+   */
+  template <typename Predicate>
+  size_t EraseIf(Predicate predicate) {
+    std::vector<RawAddress> keys;
+    for (const Slot& slot : slots_) {
+      if (slot.used && predicate(slot.key, slot.value)) {
+        keys.push_back(slot.key);
+      }
+    }
+    for (const RawAddress& key : keys) Erase(key);
+    return keys.size();
+  }
+
+  /**
+   * Call |function(key, value)| for each entry, in no particular order
+   */
+  template <typename Function>
+  void ForEach(Function function) const {
+    for (const Slot& slot : slots_) {
+      if (slot.used) function(slot.key, slot.value);
+    }
+  }
+
+  void Clear() {
+    for (Slot& slot : slots_) slot = Slot();
+    size_ = 0;
+  }
+
+  size_t Size() const { return size_; }
+
+  bool IsEmpty() const { return size_ == 0; }
+
+ private:
+  static constexpr size_t kMinSlots = 8;
+  // Grows beyond a load factor of kMaxLoadNum / kMaxLoadDen, so that the probe
+  // sequences stay short
+  static constexpr size_t kMaxLoadNum = 3;
+  static constexpr size_t kMaxLoadDen = 4;
+  static constexpr size_t kNotFound = SIZE_MAX;
+
+  struct Slot {
+    RawAddress key;
+    bool used = false;
+    V value = V();
+  };
+
+  // Fibonacci hashing of the 48 bits of the address, taking the high bits of
+  // the product as they depend on all the bytes
+  size_t HomeSlot(const RawAddress& key) const {
+    uint64_t bits = 0;
+    memcpy(&bits, key.address, RawAddress::kLength);
+    return (bits * UINT64_C(0x9E3779B97F4A7C15)) >> shift_;
+  }
+
+  size_t FindSlot(const RawAddress& key) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = HomeSlot(key);; slot = (slot + 1) & mask) {
+      if (!slots_[slot].used) return kNotFound;
+      if (slots_[slot].key == key) return slot;
+    }
+  }
+
+  void InsertNew(const RawAddress& key, V value) {
+    size_t mask = slots_.size() - 1;
+    size_t slot = HomeSlot(key);
+    while (slots_[slot].used) slot = (slot + 1) & mask;
+    slots_[slot].key = key;
+    slots_[slot].used = true;
+    slots_[slot].value = std::move(value);
+    size_++;
+  }
+
+  // Shifts the entries following |slot| back, instead of leaving a tombstone,
+  // so that lookups of missing keys stop at the first free slot
+  void EraseSlot(size_t slot) {
+    size_t mask = slots_.size() - 1;
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; slots_[next].used;
+         next = (next + 1) & mask) {
+      // The entry can fill the hole unless its home slot is cyclically in
+      // (hole, next]
+      size_t home = HomeSlot(slots_[next].key);
+      if (((next - home) & mask) >= ((next - hole) & mask)) {
+        slots_[hole] = std::move(slots_[next]);
+        hole = next;
+      }
+    }
+    slots_[hole] = Slot();
+    size_--;
+  }
+
+  void Rehash(size_t num_slots) {
+    std::vector<Slot> old_slots(num_slots);
+    old_slots.swap(slots_);
+    shift_ = 64;
+    for (size_t slots = num_slots; slots > 1; slots >>= 1) shift_--;
+    size_ = 0;
+    for (Slot& slot : old_slots) {
+      if (slot.used) InsertNew(slot.key, std::move(slot.value));
+    }
+  }
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+  unsigned shift_ = 64;
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+
+#include "common/raw_address_flat_map.h"
+
+namespace testing {
+
+using bluetooth::common::RawAddressFlatMap;
+
+static RawAddress MakeAddress(uint32_t i) {
+  return RawAddress({0x00, 0x11, static_cast<uint8_t>(i >> 24),
+                     static_cast<uint8_t>(i >> 16),
+                     static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)});
+}
+
+TEST(RawAddressFlatMapTest, PutFindErase) {
+  RawAddressFlatMap<int> map;
+  EXPECT_TRUE(map.IsEmpty());
+  EXPECT_EQ(map.Find(MakeAddress(1)), nullptr);
+
+  EXPECT_TRUE(map.Put(MakeAddress(1), 10));
+  EXPECT_TRUE(map.Put(MakeAddress(2), 20));
+  EXPECT_FALSE(map.Put(MakeAddress(1), 11));
+  EXPECT_EQ(map.Size(), 2u);
+  ASSERT_NE(map.Find(MakeAddress(1)), nullptr);
+  EXPECT_EQ(*map.Find(MakeAddress(1)), 11);
+  EXPECT_TRUE(map.Contains(MakeAddress(2)));
+
+  EXPECT_TRUE(map.Erase(MakeAddress(1)));
+  EXPECT_FALSE(map.Erase(MakeAddress(1)));
+  EXPECT_EQ(map.Find(MakeAddress(1)), nullptr);
+  EXPECT_EQ(*map.Find(MakeAddress(2)), 20);
+  EXPECT_EQ(map.Size(), 1u);
+
+  map.Clear();
+  EXPECT_TRUE(map.IsEmpty());
+  EXPECT_FALSE(map.Contains(MakeAddress(2)));
+}
+
+TEST(RawAddressFlatMapTest, EraseIfAndForEach) {
+  RawAddressFlatMap<int> map;
+  for (int i = 0; i < 100; i++) map.Put(MakeAddress(i), i);
+  EXPECT_EQ(map.EraseIf([](const RawAddress&, int value) {
+    return value % 2 == 0;
+  }), 50u);
+
+  int sum = 0;
+  map.ForEach([&sum](const RawAddress& key, int value) {
+    EXPECT_EQ(key, MakeAddress(value));
+    sum += value;
+  });
+  EXPECT_EQ(sum, 2500);
+}
+
+// Random operations, checked against std::map
+TEST(RawAddressFlatMapTest, MatchesStdMap) {
+  std::mt19937 random(42);
+  RawAddressFlatMap<uint32_t> map(4);
+  std::map<RawAddress, uint32_t> expected;
+  for (int i = 0; i < 20000; i++) {
+    RawAddress key = MakeAddress(random() % 512);
+    uint32_t value = random();
+    switch (random() % 3) {
+      case 0:
+        EXPECT_EQ(map.Put(key, value), expected.count(key) == 0);
+        expected[key] = value;
+        break;
+      case 1:
+        EXPECT_EQ(map.Erase(key), expected.erase(key) == 1);
+        break;
+      default: {
+        auto it = expected.find(key);
+        uint32_t* found = map.Find(key);
+        if (it == expected.end()) {
+          EXPECT_EQ(found, nullptr);
+        } else {
+          ASSERT_NE(found, nullptr);
+          EXPECT_EQ(*found, it->second);
+        }
+      }
+    }
+    ASSERT_EQ(map.Size(), expected.size());
+  }
+  for (const auto& entry : expected) {
+    ASSERT_NE(map.Find(entry.first), nullptr);
+    EXPECT_EQ(*map.Find(entry.first), entry.second);
+  }
+}
+
+}  // namespace testing
@@ -0,0 +1,219 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "common/startup_trace.h"
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace bluetooth {
+
+namespace common {
+
+namespace startup_trace {
+
+namespace {
+
+// Number of the longest events listed by DebugDump()
+constexpr size_t kSummaryEvents = 20;
+
+struct Event {
+  std::string name;
+  pid_t tid;
+  Clock::time_point begin;
+  Clock::time_point end;
+  bool instant;
+};
+
+std::mutex trace_mutex;
+std::atomic_bool recording(false);
+Clock::time_point origin;
+Clock::time_point finish;
+std::vector<Event> events;
+size_t dropped_events = 0;
+std::map<pid_t, std::string> thread_names;
+
+int64_t to_us(Clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(time - origin)
+      .count();
+}
+
+// Must be called with trace_mutex held
+void add_event_locked(Event event) {
+  if (events.size() >= kMaxEvents) {
+    dropped_events++;
+    return;
+  }
+  if (thread_names.find(event.tid) == thread_names.end()) {
+    char name[16] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    thread_names[event.tid] = name;
+  }
+  events.push_back(std::move(event));
+}
+
+void add_event(const std::string& name, Clock::time_point begin,
+               Clock::time_point end, bool instant) {
+  pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  // Checked again under the lock, as Finish() may have raced with the caller
+  if (!recording) return;
+  add_event_locked(Event{name, tid, begin, end, instant});
+}
+
+std::string escape(const std::string& text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped.push_back('\\');
+      escaped.push_back(c);
+    } else if (static_cast<unsigned char>(c) >= 0x20) {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+}  // namespace
+
+void Start() {
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  if (recording) return;
+  events.clear();
+  thread_names.clear();
+  dropped_events = 0;
+  origin = Clock::now();
+  finish = origin;
+  recording = true;
+}
+
+void Finish() {
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  if (!recording) return;
+  finish = Clock::now();
+  recording = false;
+}
+
+bool IsRecording() { return recording; }
+
+void AddEvent(const std::string& name, Clock::time_point begin,
+              Clock::time_point end) {
+  if (!recording) return;
+  add_event(name, begin, end, false);
+}
+
+void AddInstant(const std::string& name) {
+  if (!recording) return;
+  Clock::time_point now = Clock::now();
+  add_event(name, now, now, true);
+}
+
+std::string ToChromeTraceJson() {
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  const int pid = getpid();
+  bool first = true;
+  char buffer[64];
+  for (const auto& thread : thread_names) {
+    if (!first) json += ",";
+    first = false;
+    snprintf(buffer, sizeof(buffer),
+             "{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,", pid, thread.first);
+    json += buffer;
+    json += "\"name\":\"thread_name\",\"args\":{\"name\":\"" +
+            escape(thread.second) + "\"}}";
+  }
+  for (const auto& event : events) {
+    if (!first) json += ",";
+    first = false;
+    json += "{\"name\":\"" + escape(event.name) + "\",";
+    if (event.instant) {
+      snprintf(buffer, sizeof(buffer),
+               "\"ph\":\"i\",\"s\":\"t\",\"ts\":%" PRId64 ",",
+               to_us(event.begin));
+    } else {
+      snprintf(buffer, sizeof(buffer),
+               "\"ph\":\"X\",\"ts\":%" PRId64 ",\"dur\":%" PRId64 ",",
+               to_us(event.begin), to_us(event.end) - to_us(event.begin));
+    }
+    json += buffer;
+    snprintf(buffer, sizeof(buffer), "\"pid\":%d,\"tid\":%d}", pid,
+             event.tid);
+    json += buffer;
+  }
+  json += "]}";
+  return json;
+}
+
+void DebugDump(int fd) {
+  std::vector<Event> longest;
+  {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    dprintf(fd, "\nBluetooth Startup Trace:\n");
+    if (events.empty()) {
+      dprintf(fd, "  No events recorded\n");
+      return;
+    }
+    Clock::time_point end = recording ? Clock::now() : finish;
+    dprintf(fd, "  Duration: %" PRId64 " ms%s\n", to_us(end) / 1000,
+            recording ? " (in progress)" : "");
+    dprintf(fd, "  Events: %zu (%zu dropped)\n", events.size(),
+            dropped_events);
+    for (const auto& event : events) {
+      if (!event.instant) longest.push_back(event);
+    }
+    std::sort(longest.begin(), longest.end(),
+              [](const Event& a, const Event& b) {
+                return (a.end - a.begin) > (b.end - b.begin);
+              });
+    if (longest.size() > kSummaryEvents) longest.resize(kSummaryEvents);
+    dprintf(fd, "  Longest events:\n");
+    dprintf(fd, "    %8s %8s  %-16s %s\n", "start_ms", "dur_ms", "thread",
+            "name");
+    for (const auto& event : longest) {
+      dprintf(fd, "    %8.1f %8.1f  %-16s %s\n", to_us(event.begin) / 1000.0,
+              (to_us(event.end) - to_us(event.begin)) / 1000.0,
+              thread_names[event.tid].c_str(), event.name.c_str());
+    }
+  }
+  dprintf(fd, "  Chrome trace JSON (load in ui.perfetto.dev):\n%s\n",
+          ToChromeTraceJson().c_str());
+}
+
+ScopedEvent::ScopedEvent(std::string name)
+    : name_(std::move(name)), begin_(Clock::now()), active_(recording) {}
+
+ScopedEvent::~ScopedEvent() {
+  if (active_) AddEvent(name_, begin_, Clock::now());
+}
+
+}  // namespace startup_trace
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace bluetooth {
+
+namespace common {
+
+// Records where the time of a stack enable goes: module lifecycle calls,
+// the futures the stack manager waits on and the HCI commands sent while the
+// stack comes up. Events are only kept between StartupTraceStart() and
+// StartupTraceFinish(), so recording costs nothing once the stack is up.
+namespace startup_trace {
+
+using Clock = std::chrono::steady_clock;
+
+// Maximum number of events kept for one recording; later ones are counted
+// as dropped.
+constexpr size_t kMaxEvents = 512;
+
+// Starts a new recording, dropping the previous one, unless a recording is
+// already in progress.
+void Start();
+
+// Ends the current recording. Events added afterwards are ignored.
+void Finish();
+
+// Returns true while a recording is in progress.
+bool IsRecording();
+
+// Adds an event named |name| that ran from |begin| to |end| on the calling
+// thread.
+void AddEvent(const std::string& name, Clock::time_point begin,
+              Clock::time_point end);
+
+// Adds an instant event named |name| on the calling thread.
+void AddInstant(const std::string& name);
+
+// Returns the last recording in the Chrome trace event JSON format, which
+// can be loaded in Perfetto (ui.perfetto.dev) or chrome://tracing.
+std::string ToChromeTraceJson();
+
+// Writes a summary of the last recording, followed by its JSON trace, to
+// |fd|.
+void DebugDump(int fd);
+
+// Records the lifetime of the enclosing scope as an event.
+class ScopedEvent {
+ public:
+  explicit ScopedEvent(std::string name);
+  ~ScopedEvent();
+  ScopedEvent(const ScopedEvent&) = delete;
+  ScopedEvent& operator=(const ScopedEvent&) = delete;
+
+ private:
+  std::string name_;
+  Clock::time_point begin_;
+  bool active_;
+};
+
+}  // namespace startup_trace
+
+}  // namespace common
+
+}  // namespace bluetooth
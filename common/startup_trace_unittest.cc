@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/startup_trace.h"
+
+namespace startup_trace = bluetooth::common::startup_trace;
+
+namespace {
+
+size_t count(const std::string& text, const std::string& pattern) {
+  size_t found = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    found++;
+  }
+  return found;
+}
+
+}  // namespace
+
+TEST(StartupTraceTest, ignores_events_when_not_recording) {
+  startup_trace::Start();
+  startup_trace::Finish();
+  startup_trace::AddInstant("ignored");
+  { startup_trace::ScopedEvent event("ignored_scope"); }
+  std::string json = startup_trace::ToChromeTraceJson();
+  EXPECT_EQ(json.find("ignored"), std::string::npos);
+  EXPECT_FALSE(startup_trace::IsRecording());
+}
+
+TEST(StartupTraceTest, records_scoped_and_instant_events) {
+  startup_trace::Start();
+  EXPECT_TRUE(startup_trace::IsRecording());
+  {
+    startup_trace::ScopedEvent outer("module_start_up \"outer\"");
+    startup_trace::AddInstant("stack up");
+  }
+  startup_trace::Finish();
+  std::string json = startup_trace::ToChromeTraceJson();
+  EXPECT_NE(json.find("\"name\":\"module_start_up \\\"outer\\\"\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"stack up\",\"ph\":\"i\""),
+            std::string::npos);
+  EXPECT_EQ(count(json, "\"ph\":\"X\""), 1u);
+  EXPECT_EQ(count(json, "\"thread_name\""), 1u);
+  EXPECT_EQ(json.front(), '{');
+  EXPECT_EQ(json.back(), '}');
+}
+
+TEST(StartupTraceTest, start_keeps_recording_in_progress) {
+  startup_trace::Start();
+  startup_trace::AddInstant("init");
+  startup_trace::Start();
+  startup_trace::AddInstant("start_up");
+  startup_trace::Finish();
+  std::string json = startup_trace::ToChromeTraceJson();
+  EXPECT_NE(json.find("\"init\""), std::string::npos);
+  EXPECT_NE(json.find("\"start_up\""), std::string::npos);
+
+  // A new recording drops the previous one
+  startup_trace::Start();
+  startup_trace::Finish();
+  EXPECT_EQ(startup_trace::ToChromeTraceJson().find("\"init\""),
+            std::string::npos);
+}
+
+TEST(StartupTraceTest, drops_events_beyond_limit) {
+  startup_trace::Start();
+  auto now = startup_trace::Clock::now();
+  for (size_t i = 0; i < startup_trace::kMaxEvents + 10; i++) {
+    startup_trace::AddEvent("HCI", now, now);
+  }
+  startup_trace::Finish();
+  std::string json = startup_trace::ToChromeTraceJson();
+  EXPECT_EQ(count(json, "\"ph\":\"X\""), startup_trace::kMaxEvents);
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace bluetooth {
+
+namespace common {
+
+/**
+ * State table of a BTA state machine, built at compile time
+ *
+ * The BTA state machines are described by one table per state, with a row per
+ * event holding the actions to execute and the next state. StateTable merges
+ * them into a single array of transitions, with the actions already resolved,
+ * e.g. to the action functions: an event is dispatched with one bounds checked
+ * lookup, instead of the two dependent loads of the per state tables and the
+ * load of the action function.
+ *
+ * Use MakeStateTable() to build it from the per state tables.
+ */
+template <typename Action, size_t kNumStates, size_t kNumEvents,
+          size_t kNumActions>
+class StateTable {
+ public:
+  struct Transition {
+    Action actions[kNumActions];
+    uint8_t next_state;
+  };
+
+  static constexpr size_t kStates = kNumStates;
+  static constexpr size_t kEvents = kNumEvents;
+
+  /**
+   * @param state the current state
+   * @param event the event, relative to the first event of the state machine
+   * @return the transition of |state| on |event|, nullptr if any of them is
+   * out of the table
+   */
+  constexpr const Transition* Find(size_t state, size_t event) const {
+    if (state < first_state_ || state - first_state_ >= kNumStates ||
+        event >= kNumEvents) {
+      return nullptr;
+    }
+    return &transitions_[state - first_state_][event];
+  }
+
+  constexpr uint8_t FirstState() const { return first_state_; }
+
+  Transition transitions_[kNumStates][kNumEvents] = {};
+  uint8_t first_state_ = 0;
+};
+
+namespace state_table_internal {
+
+// Not constexpr: calling it from MakeStateTable() fails the compilation of a
+// constexpr state table
+inline void InvalidNextState() {}
+
+}  // namespace state_table_internal
+
+/**
+ * Build the StateTable of the per state tables |tables|
+ *
+ * Each table has a row per event, of kNumCols = kNumActions + 1 columns: the
+ * actions, then the next state. The tables are given in the order of the
+ * states, starting at |first_state|. Declare the result constexpr, so that a
+ * next state out of the table fails the compilation.
+ *
+ * @param action_of constexpr function from the action number of the tables to
+ * the Action stored in the transitions
+ * @param first_state state of the first table
+ */
+template <size_t kNumActions, typename ActionOf, size_t kNumEvents,
+          size_t kNumCols, typename... Tables>
+constexpr auto MakeStateTable(ActionOf action_of, uint8_t first_state,
+                              const uint8_t (&table)[kNumEvents][kNumCols],
+                              const Tables&... tables) {
+  static_assert(kNumCols == kNumActions + 1,
+                "rows must hold the actions and the next state");
+  static_assert(
+      (std::is_same<Tables, uint8_t[kNumEvents][kNumCols]>::value && ...),
+      "all the states must have a row per event");
+
+  using Action = decltype(action_of(uint8_t{}));
+  constexpr size_t kNumStates = sizeof...(Tables) + 1;
+  const uint8_t(*const rows[kNumStates])[kNumCols] = {table, tables...};
+
+  StateTable<Action, kNumStates, kNumEvents, kNumActions> state_table;
+  state_table.first_state_ = first_state;
+  for (size_t state = 0; state < kNumStates; state++) {
+    for (size_t event = 0; event < kNumEvents; event++) {
+      const uint8_t* row = rows[state][event];
+      auto& transition = state_table.transitions_[state][event];
+      for (size_t i = 0; i < kNumActions; i++) {
+        transition.actions[i] = action_of(row[i]);
+      }
+      uint8_t next_state = row[kNumActions];
+      if (next_state < first_state ||
+          static_cast<size_t>(next_state - first_state) >= kNumStates) {
+        state_table_internal::InvalidNextState();
+      }
+      transition.next_state = next_state;
+    }
+  }
+  return state_table;
+}
+
+}  // namespace common
+
+}  // namespace bluetooth
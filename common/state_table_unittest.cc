@@ -0,0 +1,152 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "common/state_table.h"
+
+using bluetooth::common::MakeStateTable;
+
+namespace {
+
+enum { kStateNull, kStateIdle, kStateOpen };
+enum { kEventOpen, kEventData, kEventClose, kNumEvents };
+enum { kActionOpen, kActionData, kActionClose, kNumActions };
+constexpr uint8_t kIgnore = kNumActions;
+
+int last_action = -1;
+
+void action_open() { last_action = kActionOpen; }
+void action_data() { last_action = kActionData; }
+void action_close() { last_action = kActionClose; }
+
+typedef void (*Action)();
+constexpr Action actions[] = {action_open, action_data, action_close};
+
+constexpr uint8_t st_idle[][2] = {
+    /* kEventOpen */ {kActionOpen, kStateOpen},
+    /* kEventData */ {kIgnore, kStateIdle},
+    /* kEventClose */ {kIgnore, kStateIdle},
+};
+
+constexpr uint8_t st_open[][2] = {
+    /* kEventOpen */ {kIgnore, kStateOpen},
+    /* kEventData */ {kActionData, kStateOpen},
+    /* kEventClose */ {kActionClose, kStateIdle},
+};
+
+constexpr auto state_table = MakeStateTable<1>(
+    [](uint8_t action) constexpr {
+      return action == kIgnore ? nullptr : actions[action];
+    },
+    kStateIdle, st_idle, st_open);
+
+constexpr uint8_t sst_idle[][3] = {
+    /* kEventOpen */ {kActionOpen, kActionData, kStateOpen},
+    /* kEventData */ {kIgnore, kIgnore, kStateIdle},
+    /* kEventClose */ {kActionClose, kIgnore, kStateIdle},
+};
+
+constexpr uint8_t sst_open[][3] = {
+    /* kEventOpen */ {kIgnore, kIgnore, kStateOpen},
+    /* kEventData */ {kActionData, kIgnore, kStateOpen},
+    /* kEventClose */ {kActionClose, kIgnore, kStateIdle},
+};
+
+constexpr auto numbered_state_table = MakeStateTable<2>(
+    [](uint8_t action) constexpr { return action; }, kStateIdle, sst_idle,
+    sst_open);
+
+// The state machine the tables describe: the state and the action of an event
+void dispatch(int* state, int event) {
+  const auto* transition = state_table.Find(*state, event);
+  ASSERT_NE(transition, nullptr);
+  *state = transition->next_state;
+  if (transition->actions[0] != nullptr) transition->actions[0]();
+}
+
+}  // namespace
+
+TEST(StateTableTest, test_resolves_the_actions_at_compile_time) {
+  static_assert(state_table.Find(kStateIdle, kEventOpen)->actions[0] ==
+                    action_open,
+                "");
+  static_assert(state_table.Find(kStateIdle, kEventData)->actions[0] ==
+                    nullptr,
+                "");
+  static_assert(state_table.Find(kStateOpen, kEventClose)->next_state ==
+                    kStateIdle,
+                "");
+  static_assert(decltype(state_table)::kStates == 2, "");
+  static_assert(decltype(state_table)::kEvents == kNumEvents, "");
+  EXPECT_EQ(state_table.FirstState(), kStateIdle);
+}
+
+TEST(StateTableTest, test_matches_the_state_tables) {
+  const uint8_t(*tables[])[2] = {st_idle, st_open};
+  for (int state = kStateIdle; state <= kStateOpen; state++) {
+    for (int event = 0; event < kNumEvents; event++) {
+      const auto* transition = state_table.Find(state, event);
+      ASSERT_NE(transition, nullptr);
+      const uint8_t* row = tables[state - kStateIdle][event];
+      EXPECT_EQ(transition->next_state, row[1]);
+      EXPECT_EQ(transition->actions[0],
+                row[0] == kIgnore ? nullptr : actions[row[0]]);
+    }
+  }
+}
+
+TEST(StateTableTest, test_dispatch) {
+  int state = kStateIdle;
+  last_action = -1;
+
+  dispatch(&state, kEventData);
+  EXPECT_EQ(state, kStateIdle);
+  EXPECT_EQ(last_action, -1);
+
+  dispatch(&state, kEventOpen);
+  EXPECT_EQ(state, kStateOpen);
+  EXPECT_EQ(last_action, kActionOpen);
+
+  dispatch(&state, kEventData);
+  EXPECT_EQ(state, kStateOpen);
+  EXPECT_EQ(last_action, kActionData);
+
+  dispatch(&state, kEventClose);
+  EXPECT_EQ(state, kStateIdle);
+  EXPECT_EQ(last_action, kActionClose);
+}
+
+TEST(StateTableTest, test_out_of_table) {
+  EXPECT_EQ(state_table.Find(kStateNull, kEventOpen), nullptr);
+  EXPECT_EQ(state_table.Find(kStateOpen + 1, kEventOpen), nullptr);
+  EXPECT_EQ(state_table.Find(kStateIdle, kNumEvents), nullptr);
+  EXPECT_EQ(state_table.Find(kStateIdle, SIZE_MAX), nullptr);
+}
+
+TEST(StateTableTest, test_multiple_actions) {
+  const auto* transition = numbered_state_table.Find(kStateIdle, kEventOpen);
+  ASSERT_NE(transition, nullptr);
+  EXPECT_EQ(transition->actions[0], kActionOpen);
+  EXPECT_EQ(transition->actions[1], kActionData);
+  EXPECT_EQ(transition->next_state, kStateOpen);
+
+  transition = numbered_state_table.Find(kStateOpen, kEventClose);
+  ASSERT_NE(transition, nullptr);
+  EXPECT_EQ(transition->actions[0], kActionClose);
+  EXPECT_EQ(transition->actions[1], kIgnore);
+  EXPECT_EQ(transition->next_state, kStateIdle);
+}
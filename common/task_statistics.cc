@@ -0,0 +1,180 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "task_statistics.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <sstream>
+
+#include <base/logging.h>
+
+namespace bluetooth {
+
+namespace common {
+
+constexpr size_t TaskStatistics::kBuckets;
+constexpr size_t TaskStatistics::kWatchdogLocations;
+constexpr std::chrono::seconds TaskStatistics::kWatchdogInterval;
+
+namespace {
+
+uint64_t ToMicroseconds(TaskStatistics::Clock::duration duration) {
+  if (duration.count() < 0) return 0;
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+void DumpBuckets(int fd, const char* name,
+                 const std::array<uint64_t, TaskStatistics::kBuckets>& buckets) {
+  dprintf(fd, "      %s:", name);
+  for (size_t i = 0; i < buckets.size(); i++) {
+    if (buckets[i] == 0) continue;
+    if (i == 0) {
+      dprintf(fd, " <1us:%" PRIu64, buckets[i]);
+    } else if (i == buckets.size() - 1) {
+      dprintf(fd, " >=%" PRIu64 "us:%" PRIu64, (uint64_t)1 << (i - 1),
+              buckets[i]);
+    } else {
+      dprintf(fd, " <%" PRIu64 "us:%" PRIu64, (uint64_t)1 << i, buckets[i]);
+    }
+  }
+  dprintf(fd, "\n");
+}
+
+}  // namespace
+
+TaskStatistics::TaskStatistics(const std::string& thread_name,
+                               std::chrono::microseconds watchdog_run_time,
+                               size_t watchdog_queue_depth)
+    : thread_name_(thread_name),
+      watchdog_run_us_(watchdog_run_time.count()),
+      watchdog_queue_depth_(watchdog_queue_depth) {}
+
+size_t TaskStatistics::Bucket(uint64_t time_us) {
+  size_t bucket = 0;
+  while (time_us != 0 && bucket < kBuckets - 1) {
+    time_us >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void TaskStatistics::OnPosted() {
+  size_t depth = queue_depth_.fetch_add(1, std::memory_order_relaxed) + 1;
+  size_t max_depth = max_queue_depth_.load(std::memory_order_relaxed);
+  while (depth > max_depth && !max_queue_depth_.compare_exchange_weak(
+                                  max_depth, depth, std::memory_order_relaxed)) {
+  }
+  if (watchdog_queue_depth_ != 0 && depth > watchdog_queue_depth_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Watchdog(std::to_string(depth) + " tasks queued", Clock::now());
+  }
+}
+
+void TaskStatistics::OnRun(const Location& from_here, Clock::time_point due,
+                           Clock::time_point start, Clock::time_point end) {
+  queue_depth_.fetch_sub(1, std::memory_order_relaxed);
+  uint64_t wait_us = ToMicroseconds(start - due);
+  uint64_t run_us = ToMicroseconds(end - start);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Key key(from_here.function_name, from_here.file_name, from_here.line_number);
+  auto it = locations_.find(key);
+  if (it == locations_.end()) {
+    std::stringstream location;
+    location << (from_here.function_name ? from_here.function_name : "?")
+             << "@" << (from_here.file_name ? from_here.file_name : "?")
+             << ":" << from_here.line_number;
+    it = locations_.emplace(key, LocationStatistics()).first;
+    it->second.location = location.str();
+  }
+  LocationStatistics& statistics = it->second;
+  statistics.count++;
+  statistics.total_wait_us += wait_us;
+  statistics.max_wait_us = std::max(statistics.max_wait_us, wait_us);
+  statistics.total_run_us += run_us;
+  statistics.max_run_us = std::max(statistics.max_run_us, run_us);
+  statistics.wait_buckets[Bucket(wait_us)]++;
+  statistics.run_buckets[Bucket(run_us)]++;
+
+  if (watchdog_run_us_ != 0 && run_us > watchdog_run_us_) {
+    Watchdog("task from " + statistics.location + " ran " +
+                 std::to_string(run_us) + " us",
+             end);
+  }
+}
+
+std::vector<TaskStatistics::LocationStatistics> TaskStatistics::Get() const {
+  std::vector<LocationStatistics> statistics;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics.reserve(locations_.size());
+    for (const auto& location : locations_) {
+      statistics.push_back(location.second);
+    }
+  }
+  std::sort(statistics.begin(), statistics.end(),
+            [](const LocationStatistics& a, const LocationStatistics& b) {
+              return a.total_run_us > b.total_run_us;
+            });
+  return statistics;
+}
+
+void TaskStatistics::Watchdog(const std::string& reason, Clock::time_point now) {
+  if (watchdog_reported_ && now - last_watchdog_ < kWatchdogInterval) return;
+  watchdog_reported_ = true;
+  last_watchdog_ = now;
+
+  std::vector<const LocationStatistics*> worst;
+  for (const auto& location : locations_) {
+    worst.push_back(&location.second);
+  }
+  size_t count = std::min(worst.size(), kWatchdogLocations);
+  std::partial_sort(worst.begin(), worst.begin() + count, worst.end(),
+                    [](const LocationStatistics* a, const LocationStatistics* b) {
+                      return a->total_run_us > b->total_run_us;
+                    });
+  std::stringstream report;
+  report << thread_name_ << ": " << reason << ", busiest posters:";
+  for (size_t i = 0; i < count; i++) {
+    report << " " << worst[i]->location << " (" << worst[i]->count
+           << " tasks, " << worst[i]->total_run_us << " us, max "
+           << worst[i]->max_run_us << " us)";
+  }
+  LOG(WARNING) << report.str();
+}
+
+void TaskStatistics::Dump(int fd) const {
+  dprintf(fd, "  %s: queue depth %zu, max %zu\n", thread_name_.c_str(),
+          queue_depth(), max_queue_depth());
+  for (const auto& statistics : Get()) {
+    dprintf(fd,
+            "    %s: %" PRIu64 " tasks, wait total %" PRIu64 " us max %" PRIu64
+            " us, run total %" PRIu64 " us max %" PRIu64 " us\n",
+            statistics.location.c_str(), statistics.count,
+            statistics.total_wait_us, statistics.max_wait_us,
+            statistics.total_run_us, statistics.max_run_us);
+    DumpBuckets(fd, "wait", statistics.wait_buckets);
+    DumpBuckets(fd, "run", statistics.run_buckets);
+  }
+}
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace bluetooth {
+
+namespace common {
+
+// Wait and run times of the tasks posted to a thread, per posting location,
+// with a watchdog that logs the worst locations when a task runs for too long
+// or too many tasks are queued. Tasks are recorded on the thread running
+// them, the statistics can be read from any thread.
+class TaskStatistics {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Bucket 0 counts the times under 1 us, bucket i the times from 2^(i-1) up
+  // to 2^i us, the last one all the longer ones
+  static constexpr size_t kBuckets = 24;
+  // Number of locations the watchdog lists
+  static constexpr size_t kWatchdogLocations = 3;
+  // Minimum time between two watchdog reports
+  static constexpr std::chrono::seconds kWatchdogInterval{1};
+
+  // Where a task was posted from, as base::Location gives it
+  struct Location {
+    const char* function_name;
+    const char* file_name;
+    int line_number;
+  };
+
+  struct LocationStatistics {
+    // function@file:line
+    std::string location;
+    uint64_t count = 0;
+    uint64_t total_wait_us = 0;
+    uint64_t max_wait_us = 0;
+    uint64_t total_run_us = 0;
+    uint64_t max_run_us = 0;
+    std::array<uint64_t, kBuckets> wait_buckets{};
+    std::array<uint64_t, kBuckets> run_buckets{};
+  };
+
+  // The watchdog reports tasks running longer than |watchdog_run_time|, and
+  // queues deeper than |watchdog_queue_depth| tasks. Zero disables either.
+  TaskStatistics(const std::string& thread_name,
+                 std::chrono::microseconds watchdog_run_time,
+                 size_t watchdog_queue_depth);
+
+  static size_t Bucket(uint64_t time_us);
+
+  // A task was posted
+  void OnPosted();
+
+  // The task posted from |from_here| that was due at |due| ran from |start|
+  // to |end|
+  void OnRun(const Location& from_here, Clock::time_point due,
+             Clock::time_point start, Clock::time_point end);
+
+  // The statistics of every location, by decreasing total run time
+  std::vector<LocationStatistics> Get() const;
+
+  // Number of tasks posted that did not run yet
+  size_t queue_depth() const {
+    return queue_depth_.load(std::memory_order_relaxed);
+  }
+  size_t max_queue_depth() const {
+    return max_queue_depth_.load(std::memory_order_relaxed);
+  }
+
+  void Dump(int fd) const;
+
+ private:
+  using Key = std::tuple<const char*, const char*, int>;
+
+  // Logs the worst locations, unless a report was logged less than
+  // kWatchdogInterval ago. Called with |mutex_| held.
+  void Watchdog(const std::string& reason, Clock::time_point now);
+
+  const std::string thread_name_;
+  const uint64_t watchdog_run_us_;
+  const size_t watchdog_queue_depth_;
+  std::atomic<size_t> queue_depth_{0};
+  std::atomic<size_t> max_queue_depth_{0};
+  mutable std::mutex mutex_;
+  std::map<Key, LocationStatistics> locations_;
+  Clock::time_point last_watchdog_;
+  bool watchdog_reported_ = false;
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
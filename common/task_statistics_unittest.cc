@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/task_statistics.h"
+
+#include <gtest/gtest.h>
+
+using bluetooth::common::TaskStatistics;
+using std::chrono::microseconds;
+
+namespace {
+
+const TaskStatistics::Location kFirst{"First", "first.cc", 10};
+const TaskStatistics::Location kSecond{"Second", "second.cc", 20};
+
+// Posts and runs a task from |from_here| that waited |wait| and ran |run|
+void RunTask(TaskStatistics* statistics,
+             const TaskStatistics::Location& from_here, microseconds wait,
+             microseconds run) {
+  TaskStatistics::Clock::time_point due = TaskStatistics::Clock::now();
+  statistics->OnPosted();
+  statistics->OnRun(from_here, due, due + wait, due + wait + run);
+}
+
+}  // namespace
+
+TEST(TaskStatisticsTest, bucket) {
+  ASSERT_EQ(TaskStatistics::Bucket(0), 0u);
+  ASSERT_EQ(TaskStatistics::Bucket(1), 1u);
+  ASSERT_EQ(TaskStatistics::Bucket(3), 2u);
+  ASSERT_EQ(TaskStatistics::Bucket(4), 3u);
+  ASSERT_EQ(TaskStatistics::Bucket(UINT64_MAX), TaskStatistics::kBuckets - 1);
+}
+
+TEST(TaskStatisticsTest, per_location_times) {
+  TaskStatistics statistics("test", microseconds(0), 0);
+  RunTask(&statistics, kFirst, microseconds(10), microseconds(100));
+  RunTask(&statistics, kFirst, microseconds(30), microseconds(300));
+  RunTask(&statistics, kSecond, microseconds(0), microseconds(1000));
+
+  auto locations = statistics.Get();
+  ASSERT_EQ(locations.size(), 2u);
+  // By decreasing total run time
+  ASSERT_EQ(locations[0].location, "Second@second.cc:20");
+  ASSERT_EQ(locations[0].count, 1u);
+  ASSERT_EQ(locations[0].run_buckets[TaskStatistics::Bucket(1000)], 1u);
+  ASSERT_EQ(locations[0].wait_buckets[0], 1u);
+
+  ASSERT_EQ(locations[1].location, "First@first.cc:10");
+  ASSERT_EQ(locations[1].count, 2u);
+  ASSERT_EQ(locations[1].total_wait_us, 40u);
+  ASSERT_EQ(locations[1].max_wait_us, 30u);
+  ASSERT_EQ(locations[1].total_run_us, 400u);
+  ASSERT_EQ(locations[1].max_run_us, 300u);
+}
+
+TEST(TaskStatisticsTest, early_run_has_no_wait) {
+  TaskStatistics statistics("test", microseconds(0), 0);
+  TaskStatistics::Clock::time_point now = TaskStatistics::Clock::now();
+  statistics.OnPosted();
+  statistics.OnRun(kFirst, now, now - microseconds(50), now);
+  ASSERT_EQ(statistics.Get()[0].total_wait_us, 0u);
+}
+
+TEST(TaskStatisticsTest, queue_depth) {
+  TaskStatistics statistics("test", microseconds(0), 2);
+  statistics.OnPosted();
+  statistics.OnPosted();
+  statistics.OnPosted();
+  ASSERT_EQ(statistics.queue_depth(), 3u);
+  TaskStatistics::Clock::time_point now = TaskStatistics::Clock::now();
+  statistics.OnRun(kFirst, now, now, now);
+  statistics.OnRun(kFirst, now, now, now);
+  ASSERT_EQ(statistics.queue_depth(), 1u);
+  ASSERT_EQ(statistics.max_queue_depth(), 3u);
+}
+
+TEST(TaskStatisticsTest, watchdog_does_not_change_the_statistics) {
+  TaskStatistics statistics("test", microseconds(50), 0);
+  RunTask(&statistics, kFirst, microseconds(0), microseconds(100));
+  RunTask(&statistics, kFirst, microseconds(0), microseconds(100));
+  ASSERT_EQ(statistics.Get()[0].count, 2u);
+}
@@ -0,0 +1,530 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thread_profile.h"
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include <base/logging.h>
+
+#if defined(__ANDROID__)
+#include <processgroup/sched_policy.h>
+#endif
+
+namespace bluetooth {
+
+namespace common {
+
+namespace {
+
+constexpr int kNumThreadRoles = static_cast<int>(ThreadRole::STACK) + 1;
+constexpr int kMaxCpus = 64;
+constexpr int kMinNice = -20;
+constexpr int kMaxNice = 19;
+constexpr int kMaxUclamp = 1024;
+
+// struct sched_attr of sched_setattr(2), which libc does not declare
+struct SchedAttr {
+  uint32_t size;
+  uint32_t sched_policy;
+  uint64_t sched_flags;
+  int32_t sched_nice;
+  uint32_t sched_priority;
+  uint64_t sched_runtime;
+  uint64_t sched_deadline;
+  uint64_t sched_period;
+  uint32_t sched_util_min;
+  uint32_t sched_util_max;
+};
+// SCHED_FLAG_KEEP_POLICY | SCHED_FLAG_KEEP_PARAMS
+constexpr uint64_t kSchedFlagKeepAll = 0x18;
+constexpr uint64_t kSchedFlagUtilClampMin = 0x20;
+constexpr uint64_t kSchedFlagUtilClampMax = 0x40;
+
+// The real time threads share priority 1 unless the device configures
+// otherwise, so that none of them starves the others
+const std::array<ThreadProfile, kNumThreadRoles> kDefaultProfiles = {{
+    // DEFAULT
+    {},
+    // AUDIO_TX
+    {.policy = SCHED_FIFO, .priority = 1, .group = ThreadGroup::AUDIO},
+    // HCI_RX
+    {.policy = SCHED_FIFO, .priority = 1},
+    // SOCKET
+    {},
+    // STACK
+    {.policy = SCHED_FIFO, .priority = 1},
+}};
+
+std::mutex profiles_mutex;
+std::array<ThreadProfile, kNumThreadRoles> profiles = kDefaultProfiles;
+
+struct RegisteredThread {
+  std::string name;
+  bool has_role = false;
+  ThreadRole role = ThreadRole::DEFAULT;
+};
+
+std::mutex threads_mutex;
+std::map<pid_t, RegisteredThread> threads;
+
+std::vector<std::string> Split(const std::string& text, char delimiter) {
+  std::vector<std::string> fields;
+  size_t begin = 0;
+  while (true) {
+    size_t end = text.find(delimiter, begin);
+    fields.push_back(text.substr(begin, end - begin));
+    if (end == std::string::npos) {
+      return fields;
+    }
+    begin = end + 1;
+  }
+}
+
+bool ParseInt(const std::string& text, int* value) {
+  if (text.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  errno = 0;
+  long parsed = strtol(text.c_str(), &end, 10);
+  if (errno != 0 || *end != '\0' || parsed < INT32_MIN || parsed > INT32_MAX) {
+    return false;
+  }
+  *value = static_cast<int>(parsed);
+  return true;
+}
+
+bool ParseCpus(const std::string& text, uint64_t* cpus) {
+  uint64_t mask = 0;
+  for (const std::string& range : Split(text, ',')) {
+    std::vector<std::string> bounds = Split(range, '-');
+    int first = 0;
+    int last = 0;
+    if (bounds.size() > 2 || !ParseInt(bounds.front(), &first) ||
+        !ParseInt(bounds.back(), &last)) {
+      return false;
+    }
+    if (first < 0 || last >= kMaxCpus || first > last) {
+      return false;
+    }
+    for (int cpu = first; cpu <= last; cpu++) {
+      mask |= uint64_t{1} << cpu;
+    }
+  }
+  *cpus = mask;
+  return true;
+}
+
+bool ParseUclamp(const std::string& text, int* uclamp_min, int* uclamp_max) {
+  std::vector<std::string> bounds = Split(text, '-');
+  if (bounds.size() > 2) {
+    return false;
+  }
+  int min = -1;
+  int max = -1;
+  if (!bounds.front().empty() && !ParseInt(bounds.front(), &min)) {
+    return false;
+  }
+  if (bounds.size() == 2 && !bounds.back().empty() &&
+      !ParseInt(bounds.back(), &max)) {
+    return false;
+  }
+  if (min < -1 || min > kMaxUclamp || max < -1 || max > kMaxUclamp ||
+      (min != -1 && max != -1 && min > max)) {
+    return false;
+  }
+  *uclamp_min = min;
+  *uclamp_max = max;
+  return true;
+}
+
+bool ApplyUclamp(pid_t linux_tid, int uclamp_min, int uclamp_max) {
+  if (uclamp_min == -1 && uclamp_max == -1) {
+    return true;
+  }
+  SchedAttr attr = {};
+  attr.size = sizeof(attr);
+  attr.sched_flags = kSchedFlagKeepAll;
+  if (uclamp_min != -1) {
+    attr.sched_flags |= kSchedFlagUtilClampMin;
+    attr.sched_util_min = uclamp_min;
+  }
+  if (uclamp_max != -1) {
+    attr.sched_flags |= kSchedFlagUtilClampMax;
+    attr.sched_util_max = uclamp_max;
+  }
+  if (syscall(SYS_sched_setattr, linux_tid, &attr, 0) == 0) {
+    return true;
+  }
+  // Kernels before 5.3, or built without CONFIG_UCLAMP_TASK, have no
+  // utilization clamps. The clamps are only a hint, so a kernel without them
+  // is not a failure of the profile.
+  if (errno == EINVAL || errno == ENOSYS || errno == E2BIG ||
+      errno == EOPNOTSUPP) {
+    static std::once_flag unsupported_logged;
+    int error = errno;
+    std::call_once(unsupported_logged, [error]() {
+      LOG(WARNING) << "ApplyUclamp: the kernel does not support uclamp, "
+                   << "ignoring the clamps of thread profiles, error: "
+                   << strerror(error);
+    });
+    return true;
+  }
+  LOG(ERROR) << __func__ << ": unable to set uclamp " << uclamp_min << "-"
+             << uclamp_max << " for linux_tid " << linux_tid
+             << ", error: " << strerror(errno);
+  return false;
+}
+
+bool ApplyGroup(pid_t linux_tid, ThreadGroup group) {
+#if defined(__ANDROID__)
+  SchedPolicy sched_policy;
+  switch (group) {
+    case ThreadGroup::NONE:
+      return true;
+    case ThreadGroup::AUDIO:
+      sched_policy = SP_AUDIO_SYS;
+      break;
+    case ThreadGroup::FOREGROUND:
+      sched_policy = SP_FOREGROUND;
+      break;
+    case ThreadGroup::BACKGROUND:
+      sched_policy = SP_BACKGROUND;
+      break;
+  }
+  // set_sched_policy returns a negative errno
+  int rc = set_sched_policy(linux_tid, sched_policy);
+  if (rc != 0) {
+    LOG(ERROR) << __func__ << ": unable to set sched policy " << sched_policy
+               << " for linux_tid " << linux_tid
+               << ", error: " << strerror(-rc);
+    return false;
+  }
+#endif
+  // The process groups only exist on Android
+  return true;
+}
+
+std::string CpusText(const cpu_set_t& cpu_set) {
+  std::string text;
+  int cpu = 0;
+  while (cpu < kMaxCpus) {
+    if (!CPU_ISSET(cpu, &cpu_set)) {
+      cpu++;
+      continue;
+    }
+    int last = cpu;
+    while (last + 1 < kMaxCpus && CPU_ISSET(last + 1, &cpu_set)) {
+      last++;
+    }
+    if (!text.empty()) {
+      text += ",";
+    }
+    text += std::to_string(cpu);
+    if (last != cpu) {
+      text += "-" + std::to_string(last);
+    }
+    cpu = last + 1;
+  }
+  return text;
+}
+
+std::string PolicyText(int policy) {
+  switch (policy) {
+    case SCHED_OTHER:
+      return "other";
+    case SCHED_FIFO:
+      return "fifo";
+    case SCHED_RR:
+      return "rr";
+    case SCHED_BATCH:
+      return "batch";
+    case SCHED_IDLE:
+      return "idle";
+  }
+  return "?";
+}
+
+// Reads the CPU the thread last ran on and the CPU time it used from
+// /proc/self/task/<tid>/stat, see proc(5). Returns false if the thread is
+// gone.
+bool ReadThreadStat(pid_t linux_tid, int* last_cpu, uint64_t* cpu_time_ms) {
+  std::ifstream file("/proc/self/task/" + std::to_string(linux_tid) + "/stat");
+  std::string line;
+  if (!std::getline(file, line)) {
+    return false;
+  }
+  // The name may hold spaces, the fields after it start with the third one
+  size_t name_end = line.rfind(')');
+  if (name_end == std::string::npos) {
+    return false;
+  }
+  std::istringstream fields(line.substr(name_end + 1));
+  std::string field;
+  uint64_t utime = 0;
+  uint64_t stime = 0;
+  *last_cpu = -1;
+  for (int index = 3; fields >> field; index++) {
+    if (index == 14) {
+      utime = strtoull(field.c_str(), nullptr, 10);
+    } else if (index == 15) {
+      stime = strtoull(field.c_str(), nullptr, 10);
+    } else if (index == 39) {
+      *last_cpu = atoi(field.c_str());
+      break;
+    }
+  }
+  *cpu_time_ms = (utime + stime) * 1000 / sysconf(_SC_CLK_TCK);
+  return true;
+}
+
+}  // namespace
+
+std::string ThreadRoleText(ThreadRole role) {
+  switch (role) {
+    case ThreadRole::DEFAULT:
+      return "DEFAULT";
+    case ThreadRole::AUDIO_TX:
+      return "AUDIO_TX";
+    case ThreadRole::HCI_RX:
+      return "HCI_RX";
+    case ThreadRole::SOCKET:
+      return "SOCKET";
+    case ThreadRole::STACK:
+      return "STACK";
+  }
+  return "UNKNOWN";
+}
+
+ThreadProfile GetThreadProfile(ThreadRole role) {
+  std::lock_guard<std::mutex> lock(profiles_mutex);
+  return profiles[static_cast<int>(role)];
+}
+
+void SetThreadProfile(ThreadRole role, const ThreadProfile& profile) {
+  std::lock_guard<std::mutex> lock(profiles_mutex);
+  profiles[static_cast<int>(role)] = profile;
+}
+
+void ResetThreadProfiles() {
+  std::lock_guard<std::mutex> lock(profiles_mutex);
+  profiles = kDefaultProfiles;
+}
+
+bool ParseThreadProfile(const std::string& text, ThreadProfile* profile) {
+  CHECK(profile != nullptr);
+  std::vector<std::string> fields = Split(text, ':');
+  if (fields.size() < 2 || fields.size() > 5) {
+    return false;
+  }
+
+  ThreadProfile parsed;
+  if (fields[0] == "other") {
+    parsed.policy = SCHED_OTHER;
+  } else if (fields[0] == "fifo") {
+    parsed.policy = SCHED_FIFO;
+  } else if (fields[0] == "rr") {
+    parsed.policy = SCHED_RR;
+  } else {
+    return false;
+  }
+
+  if (!ParseInt(fields[1], &parsed.priority)) {
+    return false;
+  }
+  // SCHED_OTHER takes a nice value instead of a priority
+  int min_priority = parsed.policy == SCHED_OTHER
+                         ? kMinNice
+                         : sched_get_priority_min(parsed.policy);
+  int max_priority = parsed.policy == SCHED_OTHER
+                         ? kMaxNice
+                         : sched_get_priority_max(parsed.policy);
+  if (parsed.priority < min_priority || parsed.priority > max_priority) {
+    return false;
+  }
+
+  if (fields.size() > 2 && !fields[2].empty() &&
+      !ParseCpus(fields[2], &parsed.cpus)) {
+    return false;
+  }
+
+  if (fields.size() > 3 && !fields[3].empty()) {
+    if (fields[3] == "none") {
+      parsed.group = ThreadGroup::NONE;
+    } else if (fields[3] == "audio") {
+      parsed.group = ThreadGroup::AUDIO;
+    } else if (fields[3] == "foreground") {
+      parsed.group = ThreadGroup::FOREGROUND;
+    } else if (fields[3] == "background") {
+      parsed.group = ThreadGroup::BACKGROUND;
+    } else {
+      return false;
+    }
+  }
+
+  if (fields.size() > 4 &&
+      !ParseUclamp(fields[4], &parsed.uclamp_min, &parsed.uclamp_max)) {
+    return false;
+  }
+
+  *profile = parsed;
+  return true;
+}
+
+bool ApplyThreadProfile(pid_t linux_tid, ThreadRole role) {
+  ThreadProfile profile = GetThreadProfile(role);
+  // Only the scheduling policy decides success. The group, affinity and nice
+  // value depend on the cgroups, sepolicy and online CPUs of the device, and
+  // the thread runs correctly, if less well placed, without them.
+  bool scheduled = true;
+  bool complete = true;
+
+  // The group first, as joining a group may reset the affinity to its cpuset
+  if (!ApplyGroup(linux_tid, profile.group)) {
+    complete = false;
+  }
+
+  if (profile.cpus != 0) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu = 0; cpu < kMaxCpus; cpu++) {
+      if (profile.cpus & (uint64_t{1} << cpu)) {
+        CPU_SET(cpu, &cpu_set);
+      }
+    }
+    if (sched_setaffinity(linux_tid, sizeof(cpu_set), &cpu_set) != 0) {
+      LOG(ERROR) << __func__ << ": unable to set CPU affinity 0x" << std::hex
+                 << profile.cpus << std::dec << " for linux_tid " << linux_tid
+                 << ", error: " << strerror(errno);
+      complete = false;
+    }
+  }
+
+  struct sched_param sched_params = {
+      .sched_priority = profile.policy == SCHED_OTHER ? 0 : profile.priority};
+  if (sched_setscheduler(linux_tid, profile.policy, &sched_params) != 0) {
+    LOG(ERROR) << __func__ << ": unable to set scheduling policy "
+               << profile.policy << " priority " << sched_params.sched_priority
+               << " for linux_tid " << linux_tid
+               << ", error: " << strerror(errno);
+    scheduled = false;
+  } else if (profile.policy == SCHED_OTHER &&
+             setpriority(PRIO_PROCESS, linux_tid, profile.priority) != 0) {
+    LOG(ERROR) << __func__ << ": unable to set nice value " << profile.priority
+               << " for linux_tid " << linux_tid
+               << ", error: " << strerror(errno);
+    complete = false;
+  }
+
+  // Last, as a policy change may reset the clamps
+  if (!ApplyUclamp(linux_tid, profile.uclamp_min, profile.uclamp_max)) {
+    complete = false;
+  }
+
+  if (!scheduled || !complete) {
+    LOG(ERROR) << __func__ << ": profile " << ThreadRoleText(role)
+               << " only partly applied to linux_tid " << linux_tid;
+  }
+
+  std::lock_guard<std::mutex> lock(threads_mutex);
+  auto thread = threads.find(linux_tid);
+  if (thread != threads.end()) {
+    thread->second.has_role = true;
+    thread->second.role = role;
+  }
+  return scheduled;
+}
+
+void RegisterThread(pid_t linux_tid, const std::string& name) {
+  std::lock_guard<std::mutex> lock(threads_mutex);
+  threads[linux_tid] = {.name = name};
+}
+
+void UnregisterThread(pid_t linux_tid) {
+  std::lock_guard<std::mutex> lock(threads_mutex);
+  threads.erase(linux_tid);
+}
+
+void DumpThreads(int fd) {
+  std::lock_guard<std::mutex> lock(threads_mutex);
+  dprintf(fd, "\nStack threads:\n");
+  dprintf(fd, "  %-7s %-28s %-9s %-6s %4s %-9s %-12s %3s %10s\n", "tid",
+          "name", "role", "policy", "prio", "uclamp", "allowed cpus", "cpu",
+          "cpu time");
+  for (auto thread = threads.begin(); thread != threads.end();) {
+    pid_t linux_tid = thread->first;
+    int last_cpu = -1;
+    uint64_t cpu_time_ms = 0;
+    // A thread that exited without unregistering
+    if (!ReadThreadStat(linux_tid, &last_cpu, &cpu_time_ms)) {
+      thread = threads.erase(thread);
+      continue;
+    }
+
+    int policy = sched_getscheduler(linux_tid);
+    int priority = 0;
+    if (policy == SCHED_OTHER || policy == SCHED_BATCH) {
+      priority = getpriority(PRIO_PROCESS, linux_tid);
+    } else {
+      struct sched_param sched_params = {};
+      sched_getparam(linux_tid, &sched_params);
+      priority = sched_params.sched_priority;
+    }
+
+    std::string uclamp = "-";
+    SchedAttr attr = {};
+    if (syscall(SYS_sched_getattr, linux_tid, &attr, sizeof(attr), 0) == 0 &&
+        attr.size >= sizeof(attr)) {
+      uclamp = std::to_string(attr.sched_util_min) + "-" +
+               std::to_string(attr.sched_util_max);
+    }
+
+    std::string cpus = "?";
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(linux_tid, sizeof(cpu_set), &cpu_set) == 0) {
+      cpus = CpusText(cpu_set);
+    }
+
+    const RegisteredThread& registered = thread->second;
+    std::string role =
+        registered.has_role ? ThreadRoleText(registered.role) : "-";
+    dprintf(fd, "  %-7d %-28s %-9s %-6s %4d %-9s %-12s %3d %7" PRIu64 " ms\n",
+            linux_tid, registered.name.c_str(), role.c_str(),
+            PolicyText(policy).c_str(), priority, uclamp.c_str(), cpus.c_str(),
+            last_cpu, cpu_time_ms);
+    ++thread;
+  }
+}
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sched.h>
+#include <sys/types.h>
+
+#include <cstdint>
+#include <string>
+
+namespace bluetooth {
+
+namespace common {
+
+// What a stack thread does, which decides how the kernel should schedule it
+enum class ThreadRole {
+  // Control plane work with no latency budget
+  DEFAULT,
+  // Encodes and sends the outgoing audio stream, underruns when preempted
+  AUDIO_TX,
+  // Reads the packets from the controller
+  HCI_RX,
+  // Moves the data of RFCOMM and L2CAP sockets, yields to the stack threads
+  SOCKET,
+  // Runs the stack itself, the BTU, BTA and btif work of bt_main_thread
+  STACK,
+};
+
+// Process group a thread joins, for the cpuset and boost the platform gives it
+enum class ThreadGroup {
+  // Keep the group of the process
+  NONE,
+  AUDIO,
+  FOREGROUND,
+  BACKGROUND,
+};
+
+struct ThreadProfile {
+  // SCHED_OTHER, SCHED_FIFO or SCHED_RR
+  int policy = SCHED_OTHER;
+  // The real time priority under SCHED_FIFO and SCHED_RR, the nice value under
+  // SCHED_OTHER
+  int priority = 0;
+  // Bit n allows CPU n, 0 leaves the affinity of the process
+  uint64_t cpus = 0;
+  ThreadGroup group = ThreadGroup::NONE;
+  // The utilization clamps, from 0 to 1024, that steer the thread to a big
+  // or a little core on asymmetric CPUs. -1 leaves the clamp unchanged. Only
+  // a hint: ignored on kernels without uclamp.
+  int uclamp_min = -1;
+  int uclamp_max = -1;
+};
+
+std::string ThreadRoleText(ThreadRole role);
+
+// Get the profile currently set for |role|
+ThreadProfile GetThreadProfile(ThreadRole role);
+
+// Replace the profile of |role| for the threads that apply it from now on
+void SetThreadProfile(ThreadRole role, const ThreadProfile& profile);
+
+// Restore the built-in profile of every role
+void ResetThreadProfiles();
+
+// Parse a profile written as
+// <policy>:<priority>[:<cpus>[:<group>[:<uclamp>]]], where policy is one of
+// other, fifo or rr, cpus is a list of CPUs and CPU ranges such as 0,4-7,
+// group is one of none, audio, foreground or background, and uclamp is
+// <min>-<max> with either bound left out to keep it. An empty cpus field
+// leaves the affinity unchanged, an empty group field keeps the group.
+//
+// @return true and |profile| set on success, false and |profile| untouched if
+//         |text| is malformed
+bool ParseThreadProfile(const std::string& text, ThreadProfile* profile);
+
+// Apply the profile of |role| to the thread |linux_tid|. Every setting is
+// attempted even if an earlier one fails. The group, CPU affinity and nice
+// value are best effort: failing to apply them is logged but not reported.
+//
+// @return true iff the scheduling policy and priority of the profile were
+//         applied
+bool ApplyThreadProfile(pid_t linux_tid, ThreadRole role);
+
+// Add the thread |linux_tid| to the threads listed by DumpThreads(). The role
+// shown is the last one applied to the thread with ApplyThreadProfile().
+void RegisterThread(pid_t linux_tid, const std::string& name);
+
+// Remove the thread |linux_tid| from the listed threads, before it exits
+void UnregisterThread(pid_t linux_tid);
+
+// Dump the role, scheduling, CPU placement and CPU time of every registered
+// thread to |fd|
+void DumpThreads(int fd);
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/thread_profile.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <future>
+#include <string>
+#include <thread>
+
+using bluetooth::common::ApplyThreadProfile;
+using bluetooth::common::DumpThreads;
+using bluetooth::common::GetThreadProfile;
+using bluetooth::common::ParseThreadProfile;
+using bluetooth::common::RegisterThread;
+using bluetooth::common::ResetThreadProfiles;
+using bluetooth::common::SetThreadProfile;
+using bluetooth::common::ThreadGroup;
+using bluetooth::common::ThreadProfile;
+using bluetooth::common::ThreadRole;
+using bluetooth::common::UnregisterThread;
+
+namespace {
+
+std::string DumpThreadsToString() {
+  FILE* file = tmpfile();
+  DumpThreads(fileno(file));
+  std::string text;
+  rewind(file);
+  char buffer[256];
+  while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+    text += buffer;
+  }
+  fclose(file);
+  return text;
+}
+
+}  // namespace
+
+class ThreadProfileTest : public ::testing::Test {
+ protected:
+  void TearDown() override { ResetThreadProfiles(); }
+};
+
+TEST_F(ThreadProfileTest, parse_policy_and_priority) {
+  ThreadProfile profile;
+  ASSERT_TRUE(ParseThreadProfile("fifo:2", &profile));
+  ASSERT_EQ(profile.policy, SCHED_FIFO);
+  ASSERT_EQ(profile.priority, 2);
+  ASSERT_EQ(profile.cpus, 0u);
+  ASSERT_EQ(profile.group, ThreadGroup::NONE);
+
+  ASSERT_TRUE(ParseThreadProfile("rr:1", &profile));
+  ASSERT_EQ(profile.policy, SCHED_RR);
+
+  ASSERT_TRUE(ParseThreadProfile("other:-4", &profile));
+  ASSERT_EQ(profile.policy, SCHED_OTHER);
+  ASSERT_EQ(profile.priority, -4);
+}
+
+TEST_F(ThreadProfileTest, parse_cpus_and_group) {
+  ThreadProfile profile;
+  ASSERT_TRUE(ParseThreadProfile("fifo:1:0,4-6:audio", &profile));
+  ASSERT_EQ(profile.cpus, 0x71u);
+  ASSERT_EQ(profile.group, ThreadGroup::AUDIO);
+
+  ASSERT_TRUE(ParseThreadProfile("other:0::background", &profile));
+  ASSERT_EQ(profile.cpus, 0u);
+  ASSERT_EQ(profile.group, ThreadGroup::BACKGROUND);
+
+  ASSERT_TRUE(ParseThreadProfile("other:0:63", &profile));
+  ASSERT_EQ(profile.cpus, uint64_t{1} << 63);
+}
+
+TEST_F(ThreadProfileTest, parse_uclamp) {
+  ThreadProfile profile;
+  ASSERT_TRUE(ParseThreadProfile("fifo:1:4-7:audio:512-1024", &profile));
+  ASSERT_EQ(profile.uclamp_min, 512);
+  ASSERT_EQ(profile.uclamp_max, 1024);
+
+  ASSERT_TRUE(ParseThreadProfile("other:0:::256", &profile));
+  ASSERT_EQ(profile.uclamp_min, 256);
+  ASSERT_EQ(profile.uclamp_max, -1);
+
+  ASSERT_TRUE(ParseThreadProfile("other:0:::-128", &profile));
+  ASSERT_EQ(profile.uclamp_min, -1);
+  ASSERT_EQ(profile.uclamp_max, 128);
+
+  ASSERT_TRUE(ParseThreadProfile("other:0", &profile));
+  ASSERT_EQ(profile.uclamp_min, -1);
+  ASSERT_EQ(profile.uclamp_max, -1);
+}
+
+TEST_F(ThreadProfileTest, parse_malformed_leaves_profile_untouched) {
+  ThreadProfile profile;
+  ASSERT_TRUE(ParseThreadProfile("fifo:3:1:audio", &profile));
+  for (const char* text :
+       {"", "fifo", "idle:0", "fifo:", "fifo:0", "fifo:100", "other:20",
+        "other:1x", "fifo:1:64", "fifo:1:3-1", "fifo:1:1-2-3", "fifo:1:a",
+        "fifo:1:1,", "fifo:1:1:boost", "fifo:1:1:audio:extra",
+        "fifo:1:1:audio:1025", "fifo:1:1:audio:600-500",
+        "fifo:1:1:audio:1-2-3", "fifo:1:1:audio:0-1:extra"}) {
+    ASSERT_FALSE(ParseThreadProfile(text, &profile)) << text;
+  }
+  ASSERT_EQ(profile.policy, SCHED_FIFO);
+  ASSERT_EQ(profile.priority, 3);
+  ASSERT_EQ(profile.cpus, 0x2u);
+  ASSERT_EQ(profile.group, ThreadGroup::AUDIO);
+}
+
+TEST_F(ThreadProfileTest, set_and_reset_profile) {
+  ThreadProfile default_audio_tx = GetThreadProfile(ThreadRole::AUDIO_TX);
+  ASSERT_EQ(default_audio_tx.policy, SCHED_FIFO);
+  ASSERT_EQ(default_audio_tx.group, ThreadGroup::AUDIO);
+
+  ThreadProfile profile;
+  ASSERT_TRUE(ParseThreadProfile("fifo:3:2-3", &profile));
+  SetThreadProfile(ThreadRole::AUDIO_TX, profile);
+  ASSERT_EQ(GetThreadProfile(ThreadRole::AUDIO_TX).priority, 3);
+  ASSERT_EQ(GetThreadProfile(ThreadRole::AUDIO_TX).cpus, 0xcu);
+  ASSERT_EQ(GetThreadProfile(ThreadRole::HCI_RX).priority, 1);
+
+  ASSERT_EQ(GetThreadProfile(ThreadRole::STACK).policy, SCHED_FIFO);
+
+  ResetThreadProfiles();
+  ASSERT_EQ(GetThreadProfile(ThreadRole::AUDIO_TX).priority,
+            default_audio_tx.priority);
+  ASSERT_EQ(GetThreadProfile(ThreadRole::AUDIO_TX).cpus, 0u);
+}
+
+TEST_F(ThreadProfileTest, apply_profile_to_other_thread) {
+  ThreadProfile profile;
+  ASSERT_TRUE(ParseThreadProfile("other:5:0", &profile));
+  SetThreadProfile(ThreadRole::SOCKET, profile);
+
+  std::promise<pid_t> tid_promise;
+  std::promise<void> applied_promise;
+  std::future<void> applied = applied_promise.get_future();
+  cpu_set_t cpu_set;
+  int policy = -1;
+  int nice_value = 0;
+  std::thread thread([&]() {
+    tid_promise.set_value(static_cast<pid_t>(syscall(SYS_gettid)));
+    applied.wait();
+    policy = sched_getscheduler(0);
+    sched_getaffinity(0, sizeof(cpu_set), &cpu_set);
+    nice_value = getpriority(PRIO_PROCESS, 0);
+  });
+  // Raising the nice value and narrowing the affinity need no privilege
+  bool success =
+      ApplyThreadProfile(tid_promise.get_future().get(), ThreadRole::SOCKET);
+  applied_promise.set_value();
+  thread.join();
+
+  ASSERT_TRUE(success);
+  ASSERT_EQ(policy, SCHED_OTHER);
+  ASSERT_EQ(CPU_COUNT(&cpu_set), 1);
+  ASSERT_TRUE(CPU_ISSET(0, &cpu_set));
+  ASSERT_EQ(nice_value, 5);
+}
+
+TEST_F(ThreadProfileTest, affinity_failure_is_not_fatal) {
+  // Needs a CPU that does not exist
+  if (sysconf(_SC_NPROCESSORS_CONF) > 63) {
+    return;
+  }
+  ThreadProfile profile;
+  ASSERT_TRUE(ParseThreadProfile("other:6:63", &profile));
+  SetThreadProfile(ThreadRole::SOCKET, profile);
+
+  std::promise<pid_t> tid_promise;
+  std::promise<void> applied_promise;
+  std::future<void> applied = applied_promise.get_future();
+  int nice_value = 0;
+  std::thread thread([&]() {
+    tid_promise.set_value(static_cast<pid_t>(syscall(SYS_gettid)));
+    applied.wait();
+    nice_value = getpriority(PRIO_PROCESS, 0);
+  });
+  bool success =
+      ApplyThreadProfile(tid_promise.get_future().get(), ThreadRole::SOCKET);
+  applied_promise.set_value();
+  thread.join();
+
+  ASSERT_TRUE(success);
+  ASSERT_EQ(nice_value, 6);
+}
+
+TEST_F(ThreadProfileTest, uclamp_is_best_effort) {
+  // Applies where the kernel has uclamp, and is ignored where it has not
+  ThreadProfile profile;
+  ASSERT_TRUE(ParseThreadProfile("other:0:::0-512", &profile));
+  SetThreadProfile(ThreadRole::SOCKET, profile);
+
+  bool success = false;
+  std::thread thread([&]() {
+    success = ApplyThreadProfile(static_cast<pid_t>(syscall(SYS_gettid)),
+                                 ThreadRole::SOCKET);
+  });
+  thread.join();
+  ASSERT_TRUE(success);
+}
+
+TEST_F(ThreadProfileTest, dump_registered_threads) {
+  ThreadProfile profile;
+  ASSERT_TRUE(ParseThreadProfile("other:3", &profile));
+  SetThreadProfile(ThreadRole::SOCKET, profile);
+
+  std::promise<pid_t> tid_promise;
+  std::promise<void> done_promise;
+  std::future<void> done = done_promise.get_future();
+  std::thread thread([&]() {
+    pid_t linux_tid = static_cast<pid_t>(syscall(SYS_gettid));
+    RegisterThread(linux_tid, "registry_test_thread");
+    tid_promise.set_value(linux_tid);
+    done.wait();
+    UnregisterThread(linux_tid);
+  });
+  pid_t linux_tid = tid_promise.get_future().get();
+
+  std::string text = DumpThreadsToString();
+  size_t line = text.find(std::to_string(linux_tid));
+  ASSERT_NE(line, std::string::npos) << text;
+  std::string entry = text.substr(line, text.find('\n', line) - line);
+  ASSERT_NE(entry.find("registry_test_thread"), std::string::npos) << entry;
+  ASSERT_NE(entry.find(" - "), std::string::npos) << entry;
+
+  ASSERT_TRUE(ApplyThreadProfile(linux_tid, ThreadRole::SOCKET));
+  text = DumpThreadsToString();
+  line = text.find(std::to_string(linux_tid));
+  entry = text.substr(line, text.find('\n', line) - line);
+  ASSERT_NE(entry.find("SOCKET"), std::string::npos) << entry;
+  ASSERT_NE(entry.find("other"), std::string::npos) << entry;
+
+  done_promise.set_value();
+  thread.join();
+  ASSERT_EQ(DumpThreadsToString().find("registry_test_thread"),
+            std::string::npos);
+}
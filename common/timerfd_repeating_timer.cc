@@ -0,0 +1,232 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "timerfd_repeating_timer.h"
+
+#include <base/message_loop/message_loop_current.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "message_loop_thread.h"
+#include "time_util.h"
+
+namespace bluetooth {
+
+namespace common {
+
+constexpr base::TimeDelta kMinimumPeriod = base::TimeDelta::FromMicroseconds(1);
+constexpr uint64_t kNanosecondsPerMicrosecond = 1000;
+constexpr uint64_t kMicrosecondsPerSecond = 1000000;
+
+static struct timespec us_to_timespec(uint64_t time_us) {
+  struct timespec ts;
+  ts.tv_sec = time_us / kMicrosecondsPerSecond;
+  ts.tv_nsec = (time_us % kMicrosecondsPerSecond) * kNanosecondsPerMicrosecond;
+  return ts;
+}
+
+// This runs on user thread
+TimerFdRepeatingTimer::TimerFdRepeatingTimer()
+    : fd_watch_controller_(FROM_HERE),
+      timer_fd_(timerfd_create(CLOCK_BOOTTIME, TFD_NONBLOCK | TFD_CLOEXEC)),
+      expected_time_current_task_us_(0) {
+  if (timer_fd_ < 0) {
+    LOG(ERROR) << __func__ << ": unable to create timerfd: " << strerror(errno);
+  }
+}
+
+// This runs on user thread
+TimerFdRepeatingTimer::~TimerFdRepeatingTimer() {
+  std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+  if (message_loop_thread_ != nullptr && message_loop_thread_->IsRunning()) {
+    CancelAndWait();
+  }
+  if (timer_fd_ >= 0) close(timer_fd_);
+}
+
+// This runs on user thread
+bool TimerFdRepeatingTimer::SchedulePeriodic(
+    const base::WeakPtr<MessageLoopThread>& thread,
+    const base::Location& from_here, base::RepeatingClosure task,
+    base::TimeDelta period) {
+  if (period < kMinimumPeriod) {
+    LOG(ERROR) << __func__ << ": period must be at least " << kMinimumPeriod;
+    return false;
+  }
+
+  std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+  if (thread == nullptr) {
+    LOG(ERROR) << __func__ << ": thread must be non-null";
+    return false;
+  }
+  if (timer_fd_ < 0) {
+    LOG(ERROR) << __func__ << ": no timerfd";
+    return false;
+  }
+  CancelAndWait();
+  task_ = std::move(task);
+  message_loop_thread_ = thread;
+  period_ = period;
+  uint64_t time_first_task_us =
+      time_get_os_boottime_us() + period.InMicroseconds();
+
+  // The file descriptor must be watched from the thread of the message loop
+  bool watching = false;
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  if (thread->GetThreadId() == base::PlatformThread::CurrentId()) {
+    StartWatching(time_first_task_us, &watching, std::move(promise));
+  } else if (thread->DoInThread(
+                 from_here,
+                 base::BindOnce(&TimerFdRepeatingTimer::StartWatching,
+                                base::Unretained(this), time_first_task_us,
+                                &watching, std::move(promise)))) {
+    future.wait();
+  } else {
+    LOG(ERROR) << __func__
+               << ": failed to post task to message loop for thread " << *thread
+               << ", from " << from_here.ToString();
+  }
+  if (!watching) {
+    task_ = {};
+    message_loop_thread_ = nullptr;
+    period_ = {};
+    return false;
+  }
+  return true;
+}
+
+// This runs on message loop thread
+void TimerFdRepeatingTimer::StartWatching(uint64_t time_first_task_us,
+                                          bool* watching,
+                                          std::promise<void> promise) {
+  if (!base::MessageLoopCurrentForIO::IsSet() ||
+      !base::MessageLoopCurrentForIO::Get()->WatchFileDescriptor(
+          timer_fd_, true, base::MessagePumpForIO::WATCH_READ,
+          &fd_watch_controller_, this)) {
+    LOG(ERROR) << __func__ << ": unable to watch the timerfd";
+    promise.set_value();
+    return;
+  }
+
+  // The kernel reloads the timer with the period from the absolute time of the
+  // first task, so the ticks keep their phase whatever the task latency is
+  int64_t period_us = period_.InMicroseconds();
+  struct itimerspec spec;
+  spec.it_value = us_to_timespec(time_first_task_us);
+  spec.it_interval = us_to_timespec(period_us);
+  if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+    LOG(ERROR) << __func__ << ": unable to arm the timerfd: "
+               << strerror(errno);
+    fd_watch_controller_.StopWatchingFileDescriptor();
+    promise.set_value();
+    return;
+  }
+  expected_time_current_task_us_ = time_first_task_us - period_us;
+  *watching = true;
+  promise.set_value();
+}
+
+// This runs on user thread
+void TimerFdRepeatingTimer::Cancel() {
+  std::promise<void> promise;
+  CancelHelper(std::move(promise));
+}
+
+// This runs on user thread
+void TimerFdRepeatingTimer::CancelAndWait() {
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  CancelHelper(std::move(promise));
+  future.wait();
+}
+
+// This runs on user thread
+void TimerFdRepeatingTimer::CancelHelper(std::promise<void> promise) {
+  std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+  MessageLoopThread* scheduled_thread = message_loop_thread_.get();
+  if (scheduled_thread == nullptr) {
+    promise.set_value();
+    return;
+  }
+  if (scheduled_thread->GetThreadId() == base::PlatformThread::CurrentId()) {
+    CancelClosure(std::move(promise));
+    return;
+  }
+  scheduled_thread->DoInThread(
+      FROM_HERE, base::BindOnce(&TimerFdRepeatingTimer::CancelClosure,
+                                base::Unretained(this), std::move(promise)));
+}
+
+// This runs on message loop thread
+void TimerFdRepeatingTimer::CancelClosure(std::promise<void> promise) {
+  fd_watch_controller_.StopWatchingFileDescriptor();
+  // Disarming also drops the expirations not read yet
+  struct itimerspec spec = {};
+  timerfd_settime(timer_fd_, 0, &spec, nullptr);
+  message_loop_thread_ = nullptr;
+  task_ = {};
+  period_ = base::TimeDelta();
+  expected_time_current_task_us_ = 0;
+  promise.set_value();
+}
+
+// This runs on user thread
+bool TimerFdRepeatingTimer::IsScheduled() const {
+  std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+  return message_loop_thread_ != nullptr && message_loop_thread_->IsRunning();
+}
+
+// This runs on message loop thread
+uint64_t TimerFdRepeatingTimer::GetExpectedTimeCurrentTaskUs() const {
+  return expected_time_current_task_us_;
+}
+
+// This runs on message loop thread
+void TimerFdRepeatingTimer::OnFileCanReadWithoutBlocking(int fd) {
+  uint64_t expirations = 0;
+  if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+    // The timer was disarmed since the file became readable
+    return;
+  }
+  if (message_loop_thread_ == nullptr || !message_loop_thread_->IsRunning()) {
+    LOG(ERROR) << __func__
+               << ": message_loop_thread_ is null or is not running";
+    return;
+  }
+
+  // The ticks missed while the thread was busy are dropped, the task runs once
+  // for the latest one
+  int64_t period_us = period_.InMicroseconds();
+  expected_time_current_task_us_ += expirations * period_us;
+
+  uint64_t time_before_task_us = time_get_os_boottime_us();
+  task_.Run();
+  uint64_t time_after_task_us = time_get_os_boottime_us();
+  auto task_time_us =
+      static_cast<int64_t>(time_after_task_us - time_before_task_us);
+  if (task_time_us > period_us) {
+    LOG(ERROR) << __func__ << ": Periodic task execution took " << task_time_us
+               << " microseconds, longer than interval " << period_us
+               << " microseconds";
+  }
+}
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <base/bind.h>
+#include <base/location.h>
+#include <base/message_loop/message_pump_for_io.h>
+#include <future>
+#include <mutex>
+
+namespace bluetooth {
+
+namespace common {
+
+class MessageLoopThread;
+
+/**
+ * An alarm clock that runs a task periodically on a specified
+ * MessageLoopThread, from a timerfd watched by the message loop of the thread.
+ *
+ * Unlike RepeatingTimer, the ticks don't go through the delayed task queue:
+ * the kernel fires them at absolute times on the boot time clock, multiples of
+ * the period from the time the task was scheduled, so they don't drift and
+ * their jitter is the wakeup latency of the thread. A tick missed because the
+ * thread was busy is dropped, the next one keeps the phase.
+ *
+ * Warning: MessageLoopThread must be running when any task is scheduled or
+ * being executed, and the task must be cancelled before the thread is shut
+ * down
+ */
+class TimerFdRepeatingTimer final
+    : public base::MessagePumpForIO::FdWatcher {
+ public:
+  TimerFdRepeatingTimer();
+  ~TimerFdRepeatingTimer() override;
+
+  /**
+   * Schedule a periodic task to the MessageLoopThread. Only one task can be
+   * scheduled at a time. If another task is scheduled, it will cancel the
+   * previous task synchronously and schedule the new periodic task; this
+   * blocks until the previous task is cancelled.
+   *
+   * @param thread thread to run the task
+   * @param from_here location where this task is originated
+   * @param task task created through base::Bind()
+   * @param period period for the task to be executed
+   * @return true iff task is scheduled successfully
+   */
+  bool SchedulePeriodic(const base::WeakPtr<MessageLoopThread>& thread,
+                        const base::Location& from_here,
+                        base::RepeatingClosure task, base::TimeDelta period);
+
+  /**
+   * Post an event which cancels the current task asynchronously
+   */
+  void Cancel();
+
+  /**
+   * Post an event which cancels the current task and wait for the cancellation
+   * to be completed
+   */
+  void CancelAndWait();
+
+  /**
+   * Returns true when there is a pending task scheduled on a running thread,
+   * otherwise false.
+   */
+  bool IsScheduled() const;
+
+  /**
+   * Returns the time the running task was due at, using clock boot time in
+   * time_util.h. Only meaningful when called from the task.
+   */
+  uint64_t GetExpectedTimeCurrentTaskUs() const;
+
+  // base::MessagePumpForIO::FdWatcher
+  void OnFileCanReadWithoutBlocking(int fd) override;
+  void OnFileCanWriteWithoutBlocking(int fd) override {}
+
+ private:
+  base::WeakPtr<MessageLoopThread> message_loop_thread_;
+  base::MessagePumpForIO::FdWatchController fd_watch_controller_;
+  base::RepeatingClosure task_;
+  base::TimeDelta period_;
+  int timer_fd_;
+  uint64_t expected_time_current_task_us_;  // Using clock boot time
+  mutable std::recursive_mutex api_mutex_;
+  void StartWatching(uint64_t time_first_task_us, bool* watching,
+                     std::promise<void> promise);
+  void CancelHelper(std::promise<void> promise);
+  void CancelClosure(std::promise<void> promise);
+
+  DISALLOW_COPY_AND_ASSIGN(TimerFdRepeatingTimer);
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/bind.h>
+#include <base/bind_helpers.h>
+#include <base/logging.h>
+#include <gtest/gtest.h>
+#include <future>
+#include <vector>
+
+#include "message_loop_thread.h"
+#include "time_util.h"
+#include "timerfd_repeating_timer.h"
+
+using bluetooth::common::MessageLoopThread;
+using bluetooth::common::time_get_os_boottime_us;
+using bluetooth::common::TimerFdRepeatingTimer;
+
+// Allowed error between the expected and actual time of a tick
+constexpr uint32_t delay_error_ms = 100;
+
+class TimerFdRepeatingTimerTest : public ::testing::Test {
+ public:
+  void ShouldNotHappen() { FAIL() << "Should not happen"; }
+
+  void IncreaseTaskCounter(int scheduled_tasks, std::promise<void>* promise) {
+    counter_++;
+    if (counter_ == scheduled_tasks) {
+      promise->set_value();
+    }
+  }
+
+  // Records the due time of each tick, and sleeps |task_length_ms|
+  void RecordExpectedTime(int scheduled_tasks, int task_length_ms,
+                          std::promise<void>* promise) {
+    uint64_t now_us = time_get_os_boottime_us();
+    uint64_t expected_us = timer_->GetExpectedTimeCurrentTaskUs();
+    ASSERT_GE(now_us, expected_us);
+    ASSERT_LT(now_us - expected_us, delay_error_ms * 1000);
+    expected_times_us_.push_back(expected_us);
+    counter_++;
+    if (counter_ == scheduled_tasks) {
+      promise->set_value();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(task_length_ms));
+  }
+
+  void ScheduleFromThread(MessageLoopThread* thread, int scheduled_tasks,
+                          uint32_t delay_ms, std::promise<void>* promise) {
+    ASSERT_TRUE(timer_->SchedulePeriodic(
+        thread->GetWeakPtr(), FROM_HERE,
+        base::BindRepeating(&TimerFdRepeatingTimerTest::IncreaseTaskCounter,
+                            base::Unretained(this), scheduled_tasks, promise),
+        base::TimeDelta::FromMilliseconds(delay_ms)));
+  }
+
+ protected:
+  void SetUp() override {
+    ::testing::Test::SetUp();
+    counter_ = 0;
+    timer_ = new TimerFdRepeatingTimer();
+    promise_ = new std::promise<void>();
+  }
+
+  void TearDown() override {
+    if (promise_ != nullptr) {
+      delete promise_;
+      promise_ = nullptr;
+    }
+    if (timer_ != nullptr) {
+      delete timer_;
+      timer_ = nullptr;
+    }
+  }
+
+  int counter_;
+  std::vector<uint64_t> expected_times_us_;
+  TimerFdRepeatingTimer* timer_;
+  std::promise<void>* promise_;
+};
+
+TEST_F(TimerFdRepeatingTimerTest, initial_is_not_scheduled) {
+  ASSERT_FALSE(timer_->IsScheduled());
+}
+
+TEST_F(TimerFdRepeatingTimerTest, periodic_run) {
+  MessageLoopThread message_loop_thread("test_thread");
+  message_loop_thread.StartUp();
+  auto future = promise_->get_future();
+  uint32_t delay_ms = 5;
+  int num_tasks = 200;
+
+  ASSERT_TRUE(timer_->SchedulePeriodic(
+      message_loop_thread.GetWeakPtr(), FROM_HERE,
+      base::BindRepeating(&TimerFdRepeatingTimerTest::IncreaseTaskCounter,
+                          base::Unretained(this), num_tasks, promise_),
+      base::TimeDelta::FromMilliseconds(delay_ms)));
+  EXPECT_TRUE(timer_->IsScheduled());
+  future.get();
+  ASSERT_GE(counter_, num_tasks);
+  timer_->CancelAndWait();
+  EXPECT_FALSE(timer_->IsScheduled());
+}
+
+TEST_F(TimerFdRepeatingTimerTest, schedule_periodic_task_zero_interval) {
+  MessageLoopThread message_loop_thread("test_thread");
+  message_loop_thread.StartUp();
+
+  ASSERT_FALSE(timer_->SchedulePeriodic(
+      message_loop_thread.GetWeakPtr(), FROM_HERE,
+      base::BindRepeating(&TimerFdRepeatingTimerTest::ShouldNotHappen,
+                          base::Unretained(this)),
+      base::TimeDelta::FromMilliseconds(0)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(delay_error_ms));
+}
+
+// Verify that deleting the timer without cancelling it will cancel the task
+TEST_F(TimerFdRepeatingTimerTest, periodic_delete_without_cancel) {
+  MessageLoopThread message_loop_thread("test_thread");
+  message_loop_thread.StartUp();
+  uint32_t delay_ms = 5;
+  timer_->SchedulePeriodic(
+      message_loop_thread.GetWeakPtr(), FROM_HERE,
+      base::BindRepeating(&TimerFdRepeatingTimerTest::ShouldNotHappen,
+                          base::Unretained(this)),
+      base::TimeDelta::FromMilliseconds(delay_ms));
+  delete timer_;
+  timer_ = nullptr;
+  std::this_thread::sleep_for(std::chrono::milliseconds(delay_error_ms));
+}
+
+TEST_F(TimerFdRepeatingTimerTest, cancel_periodic_task) {
+  MessageLoopThread message_loop_thread("test_thread");
+  message_loop_thread.StartUp();
+  uint32_t delay_ms = 5;
+  int num_tasks = 5;
+  auto future = promise_->get_future();
+
+  timer_->SchedulePeriodic(
+      message_loop_thread.GetWeakPtr(), FROM_HERE,
+      base::BindRepeating(&TimerFdRepeatingTimerTest::IncreaseTaskCounter,
+                          base::Unretained(this), num_tasks, promise_),
+      base::TimeDelta::FromMilliseconds(delay_ms));
+  future.wait();
+  timer_->CancelAndWait();
+  int counter = counter_;
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(delay_ms + delay_error_ms));
+  ASSERT_EQ(counter, counter_);
+}
+
+// The media tick of A2DP is scheduled from the thread it runs on
+TEST_F(TimerFdRepeatingTimerTest, schedule_from_message_loop_thread) {
+  MessageLoopThread message_loop_thread("test_thread");
+  message_loop_thread.StartUp();
+  auto future = promise_->get_future();
+  uint32_t delay_ms = 2;
+  int num_tasks = 10;
+
+  message_loop_thread.DoInThread(
+      FROM_HERE,
+      base::BindOnce(&TimerFdRepeatingTimerTest::ScheduleFromThread,
+                     base::Unretained(this), &message_loop_thread, num_tasks,
+                     delay_ms, promise_));
+  future.get();
+  timer_->CancelAndWait();
+}
+
+// The ticks are due at multiples of the period, whatever the task length
+TEST_F(TimerFdRepeatingTimerTest, ticks_keep_phase) {
+  MessageLoopThread message_loop_thread("test_thread");
+  message_loop_thread.StartUp();
+  auto future = promise_->get_future();
+  uint32_t delay_ms = 4;
+  int num_tasks = 20;
+
+  timer_->SchedulePeriodic(
+      message_loop_thread.GetWeakPtr(), FROM_HERE,
+      base::BindRepeating(&TimerFdRepeatingTimerTest::RecordExpectedTime,
+                          base::Unretained(this), num_tasks, 1, promise_),
+      base::TimeDelta::FromMilliseconds(delay_ms));
+  future.get();
+  timer_->CancelAndWait();
+
+  for (size_t i = 1; i < expected_times_us_.size(); i++) {
+    uint64_t delta_us = expected_times_us_[i] - expected_times_us_[i - 1];
+    ASSERT_EQ(delta_us % (delay_ms * 1000), 0u) << i;
+    ASSERT_GT(delta_us, 0u) << i;
+  }
+}
+
+// A task longer than the period drops the ticks missed, and the next ones keep
+// the phase
+TEST_F(TimerFdRepeatingTimerTest, slow_task_drops_ticks) {
+  MessageLoopThread message_loop_thread("test_thread");
+  message_loop_thread.StartUp();
+  auto future = promise_->get_future();
+  uint32_t delay_ms = 2;
+  int num_tasks = 5;
+
+  timer_->SchedulePeriodic(
+      message_loop_thread.GetWeakPtr(), FROM_HERE,
+      base::BindRepeating(&TimerFdRepeatingTimerTest::RecordExpectedTime,
+                          base::Unretained(this), num_tasks, 5, promise_),
+      base::TimeDelta::FromMilliseconds(delay_ms));
+  future.get();
+  timer_->CancelAndWait();
+
+  for (size_t i = 1; i < expected_times_us_.size(); i++) {
+    uint64_t delta_us = expected_times_us_[i] - expected_times_us_[i - 1];
+    ASSERT_EQ(delta_us % (delay_ms * 1000), 0u) << i;
+    ASSERT_GE(delta_us, 2 * delay_ms * 1000u) << i;
+  }
+}
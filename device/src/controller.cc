@@ -26,19 +26,20 @@
 #include "btcore/include/event_mask.h"
 #include "btcore/include/module.h"
 #include "btcore/include/version.h"
+#include "gd/common/init_flags.h"
 #include "hcimsgs.h"
 #include "main/shim/controller.h"
 #include "main/shim/shim.h"
 #include "osi/include/future.h"
 #include "stack/include/btm_ble_api.h"
 
-const bt_event_mask_t BLE_EVENT_MASK = {{0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+const bt_event_mask_t BLE_EVENT_MASK = {{0x00, 0x00, 0x00, 0x00, 0x0F, 0x82,
 #if (BLE_PRIVACY_SPT == TRUE)
-                                         0x1E,
+                                         0xFE,
 #else
                                          /* Disable "LE Enhanced Connection
                                             Complete" when privacy is off */
-                                         0x1C,
+                                         0xFC,
 #endif
                                          0x7f}};
 
@@ -88,15 +89,30 @@ static bool readable;
 static bool ble_supported;
 static bool simple_pairing_supported;
 static bool secure_connections_supported;
+static bool pipeline_commands;
 
 #define AWAIT_COMMAND(command) \
   static_cast<BT_HDR*>(        \
       future_await(local_hci->transmit_command_futured(command)))
 
+#define AWAIT_RESPONSE(future) static_cast<BT_HDR*>(future_await(future))
+
+// Sends |command| and returns the future of its response. With command
+// pipelining the next commands are sent as far as the controller command
+// credits allow, before this one completes. Otherwise the response is awaited
+// here, so commands still go out one at a time.
+static future_t* send_command(BT_HDR* command) {
+  future_t* future = local_hci->transmit_command_futured(command);
+  if (pipeline_commands) return future;
+  return future_new_immediate(future_await(future));
+}
+
 // Module lifecycle functions
 
 static future_t* start_up(void) {
   BT_HDR* response;
+  pipeline_commands =
+      bluetooth::common::InitFlags::HciCommandPipeliningEnabled();
 
   // Send the initial reset command
   response = AWAIT_COMMAND(packet_factory->make_reset());
@@ -116,17 +132,21 @@ static future_t* start_up(void) {
   packet_parser->parse_generic_command_complete(response);
 
   // Read the local version info off the controller next, including
-  // information such as manufacturer and supported HCI version
-  response = AWAIT_COMMAND(packet_factory->make_read_local_version_info());
+  // information such as manufacturer and supported HCI version, along with
+  // the bluetooth address and the controller's supported commands
+  future_t* version_future =
+      send_command(packet_factory->make_read_local_version_info());
+  future_t* bd_addr_future = send_command(packet_factory->make_read_bd_addr());
+  future_t* supported_commands_future =
+      send_command(packet_factory->make_read_local_supported_commands());
+
+  response = AWAIT_RESPONSE(version_future);
   packet_parser->parse_read_local_version_info_response(response, &bt_version);
 
-  // Read the bluetooth address off the controller next
-  response = AWAIT_COMMAND(packet_factory->make_read_bd_addr());
+  response = AWAIT_RESPONSE(bd_addr_future);
   packet_parser->parse_read_bd_addr_response(response, &address);
 
-  // Request the controller's supported commands next
-  response =
-      AWAIT_COMMAND(packet_factory->make_read_local_supported_commands());
+  response = AWAIT_RESPONSE(supported_commands_future);
   packet_parser->parse_read_local_supported_commands_response(
       response, supported_commands, HCI_SUPPORTED_COMMANDS_ARRAY_SIZE);
 
@@ -195,58 +215,84 @@ static future_t* start_up(void) {
   ble_supported = last_features_classic_page_index >= 1 &&
                   HCI_LE_HOST_SUPPORTED(features_classic[1].as_array);
   if (ble_supported) {
-    // Request the ble white list size next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_white_list_size());
+    // Request the ble white list size, buffer size, supported states and
+    // supported features next
+    future_t* white_list_size_future =
+        send_command(packet_factory->make_ble_read_white_list_size());
+    future_t* buffer_size_future =
+        send_command(packet_factory->make_ble_read_buffer_size());
+    future_t* supported_states_future =
+        send_command(packet_factory->make_ble_read_supported_states());
+    future_t* features_future =
+        send_command(packet_factory->make_ble_read_local_supported_features());
+
+    response = AWAIT_RESPONSE(white_list_size_future);
     packet_parser->parse_ble_read_white_list_size_response(
         response, &ble_white_list_size);
 
-    // Request the ble buffer size next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_buffer_size());
+    response = AWAIT_RESPONSE(buffer_size_future);
     packet_parser->parse_ble_read_buffer_size_response(
         response, &acl_data_size_ble, &acl_buffer_count_ble);
 
     // Response of 0 indicates ble has the same buffer size as classic
     if (acl_data_size_ble == 0) acl_data_size_ble = acl_data_size_classic;
 
-    // Request the ble supported states next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_supported_states());
+    response = AWAIT_RESPONSE(supported_states_future);
     packet_parser->parse_ble_read_supported_states_response(
         response, ble_supported_states, sizeof(ble_supported_states));
 
-    // Request the ble supported features next
-    response =
-        AWAIT_COMMAND(packet_factory->make_ble_read_local_supported_features());
+    response = AWAIT_RESPONSE(features_future);
     packet_parser->parse_ble_read_local_supported_features_response(
         response, &features_ble);
 
+    // The reads depending on the ble supported features go out together
+    future_t* resolving_list_size_future = nullptr;
     if (HCI_LE_ENHANCED_PRIVACY_SUPPORTED(features_ble.as_array)) {
-      response =
-          AWAIT_COMMAND(packet_factory->make_ble_read_resolving_list_size());
+      resolving_list_size_future =
+          send_command(packet_factory->make_ble_read_resolving_list_size());
+    }
+
+    future_t* max_data_length_future = nullptr;
+    future_t* default_data_length_future = nullptr;
+    if (HCI_LE_DATA_LEN_EXT_SUPPORTED(features_ble.as_array)) {
+      max_data_length_future =
+          send_command(packet_factory->make_ble_read_maximum_data_length());
+      default_data_length_future = send_command(
+          packet_factory->make_ble_read_suggested_default_data_length());
+    }
+
+    future_t* max_advertising_data_length_future = nullptr;
+    future_t* advertising_sets_future = nullptr;
+    if (HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(features_ble.as_array)) {
+      max_advertising_data_length_future = send_command(
+          packet_factory->make_ble_read_maximum_advertising_data_length());
+      advertising_sets_future = send_command(
+          packet_factory->make_ble_read_number_of_supported_advertising_sets());
+    }
+
+    if (resolving_list_size_future) {
+      response = AWAIT_RESPONSE(resolving_list_size_future);
       packet_parser->parse_ble_read_resolving_list_size_response(
           response, &ble_resolving_list_max_size);
     }
 
-    if (HCI_LE_DATA_LEN_EXT_SUPPORTED(features_ble.as_array)) {
-      response =
-          AWAIT_COMMAND(packet_factory->make_ble_read_maximum_data_length());
+    if (max_data_length_future) {
+      response = AWAIT_RESPONSE(max_data_length_future);
       packet_parser->parse_ble_read_maximum_data_length_response(
           response, &ble_supported_max_tx_octets, &ble_supported_max_tx_time,
           &ble_supported_max_rx_octets, &ble_supported_max_rx_time);
 
-      response = AWAIT_COMMAND(
-          packet_factory->make_ble_read_suggested_default_data_length());
+      response = AWAIT_RESPONSE(default_data_length_future);
       packet_parser->parse_ble_read_suggested_default_data_length_response(
           response, &ble_suggested_default_data_length);
     }
 
-    if (HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(features_ble.as_array)) {
-      response = AWAIT_COMMAND(
-          packet_factory->make_ble_read_maximum_advertising_data_length());
+    if (max_advertising_data_length_future) {
+      response = AWAIT_RESPONSE(max_advertising_data_length_future);
       packet_parser->parse_ble_read_maximum_advertising_data_length(
           response, &ble_maxium_advertising_data_length);
 
-      response = AWAIT_COMMAND(
-          packet_factory->make_ble_read_number_of_supported_advertising_sets());
+      response = AWAIT_RESPONSE(advertising_sets_future);
       packet_parser->parse_ble_read_number_of_supported_advertising_sets(
           response, &ble_number_of_supported_advertising_sets);
     } else {
@@ -271,7 +317,8 @@ static future_t* start_up(void) {
     response =
         AWAIT_COMMAND(packet_factory->make_read_local_supported_codecs());
     packet_parser->parse_read_local_supported_codecs_response(
-        response, &number_of_local_supported_codecs, local_supported_codecs);
+        response, &number_of_local_supported_codecs, local_supported_codecs,
+        MAX_LOCAL_SUPPORTED_CODECS_SIZE);
   }
 
   if (!HCI_READ_ENCR_KEY_SIZE_SUPPORTED(supported_commands)) {
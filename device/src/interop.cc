@@ -21,22 +21,85 @@
 #include <base/logging.h>
 #include <string.h>  // For memcmp
 
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "btcore/include/module.h"
 #include "device/include/interop.h"
 #include "device/include/interop_database.h"
-#include "osi/include/allocator.h"
-#include "osi/include/list.h"
 #include "osi/include/log.h"
 
 #define CASE_RETURN_STR(const) \
   case const:                  \
     return #const;
 
-static list_t* interop_list = NULL;
+// The features matched by an entry are kept as a bit mask
+static_assert(INTEROP_DISABLE_NAME_REQUEST < 32,
+              "interop features do not fit in a uint32_t mask");
+#define INTEROP_FEATURE_BIT(feature) (1u << (feature))
+
+namespace {
+
+// Prefix trie of the entries of a static database. Each node holds the
+// features of the entries whose prefix ends at it, so that a single walk of
+// the key finds the features of all the entries that are one of its prefixes.
+class InteropTrie {
+ public:
+  void Add(const uint8_t* prefix, size_t length, interop_feature_t feature) {
+    uint32_t node = 0;
+    for (size_t i = 0; i != length; ++i) {
+      auto& children = nodes_[node].children;
+      auto child = std::lower_bound(children.begin(), children.end(),
+                                    std::make_pair(prefix[i], uint32_t{0}));
+      if (child == children.end() || child->first != prefix[i]) {
+        uint32_t index = nodes_.size();
+        children.insert(child, std::make_pair(prefix[i], index));
+        nodes_.emplace_back();
+        node = index;
+      } else {
+        node = child->second;
+      }
+    }
+    nodes_[node].features |= INTEROP_FEATURE_BIT(feature);
+  }
+
+  // Returns the features of the entries that are a prefix of |key|. The walk
+  // stops at the first NUL byte if |stop_at_nul| is true.
+  uint32_t Match(const uint8_t* key, size_t length, bool stop_at_nul) const {
+    uint32_t node = 0;
+    uint32_t features = nodes_[0].features;
+    for (size_t i = 0; i != length; ++i) {
+      if (stop_at_nul && key[i] == 0) break;
+      const auto& children = nodes_[node].children;
+      auto child = std::lower_bound(children.begin(), children.end(),
+                                    std::make_pair(key[i], uint32_t{0}));
+      if (child == children.end() || child->first != key[i]) break;
+      node = child->second;
+      features |= nodes_[node].features;
+    }
+    return features;
+  }
+
+ private:
+  struct Node {
+    uint32_t features = 0;
+    // Sorted by byte
+    std::vector<std::pair<uint8_t, uint32_t>> children;
+  };
+  std::vector<Node> nodes_ = std::vector<Node>(1);
+};
+
+}  // namespace
+
+// Entries added at run time, by address prefix and prefix length
+static std::unordered_map<uint64_t, uint32_t> interop_dynamic_index;
+// Bit n is set if an entry of length n was added
+static uint32_t interop_dynamic_lengths = 0;
 
 static const char* interop_feature_string_(const interop_feature_t feature);
-static void interop_free_entry_(void* data);
-static void interop_lazy_init_(void);
+static uint64_t interop_dynamic_key_(const RawAddress* addr, size_t length);
 static bool interop_match_fixed_(const interop_feature_t feature,
                                  const RawAddress* addr);
 static bool interop_match_dynamic_(const interop_feature_t feature,
@@ -61,17 +124,21 @@ bool interop_match_addr(const interop_feature_t feature,
 bool interop_match_name(const interop_feature_t feature, const char* name) {
   CHECK(name);
 
-  const size_t db_size =
-      sizeof(interop_name_database) / sizeof(interop_name_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_name_database[i].feature &&
-        strlen(name) >= interop_name_database[i].length &&
-        strncmp(name, interop_name_database[i].name,
-                interop_name_database[i].length) == 0) {
-      LOG_INFO("%s() Device %s is a match for interop workaround %s.", __func__,
-               name, interop_feature_string_(feature));
-      return true;
+  static const InteropTrie name_trie = [] {
+    InteropTrie trie;
+    for (const interop_name_entry_t& entry : interop_name_database) {
+      trie.Add(reinterpret_cast<const uint8_t*>(entry.name), entry.length,
+               entry.feature);
     }
+    return trie;
+  }();
+
+  if (name_trie.Match(reinterpret_cast<const uint8_t*>(name), SIZE_MAX,
+                      true) &
+      INTEROP_FEATURE_BIT(feature)) {
+    LOG_INFO("%s() Device %s is a match for interop workaround %s.", __func__,
+             name, interop_feature_string_(feature));
+    return true;
   }
 
   return false;
@@ -82,26 +149,22 @@ void interop_database_add(uint16_t feature, const RawAddress* addr,
   CHECK(addr);
   CHECK(length > 0);
   CHECK(length < RawAddress::kLength);
+  CHECK(feature <= INTEROP_DISABLE_NAME_REQUEST);
 
-  interop_addr_entry_t* entry = static_cast<interop_addr_entry_t*>(
-      osi_calloc(sizeof(interop_addr_entry_t)));
-  memcpy(&entry->addr, addr, length);
-  entry->feature = static_cast<interop_feature_t>(feature);
-  entry->length = length;
-
-  interop_lazy_init_();
-  list_append(interop_list, entry);
+  interop_dynamic_index[interop_dynamic_key_(addr, length)] |=
+      INTEROP_FEATURE_BIT(feature);
+  interop_dynamic_lengths |= 1u << length;
 }
 
 void interop_database_clear() {
-  if (interop_list) list_clear(interop_list);
+  interop_dynamic_index.clear();
+  interop_dynamic_lengths = 0;
 }
 
 // Module life-cycle functions
 
 static future_t* interop_clean_up(void) {
-  list_free(interop_list);
-  interop_list = NULL;
+  interop_database_clear();
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -136,32 +199,24 @@ static const char* interop_feature_string_(const interop_feature_t feature) {
   return "UNKNOWN";
 }
 
-static void interop_free_entry_(void* data) {
-  interop_addr_entry_t* entry = (interop_addr_entry_t*)data;
-  osi_free(entry);
-}
-
-static void interop_lazy_init_(void) {
-  if (interop_list == NULL) {
-    interop_list = list_new(interop_free_entry_);
-  }
+// Key of the first |length| bytes of |addr| in the dynamic index. The length
+// is part of the key, so that entries of different lengths don't collide.
+static uint64_t interop_dynamic_key_(const RawAddress* addr, size_t length) {
+  uint64_t key = length;
+  for (size_t i = 0; i != length; ++i) key = (key << 8) | addr->address[i];
+  return key;
 }
 
 static bool interop_match_dynamic_(const interop_feature_t feature,
                                    const RawAddress* addr) {
-  if (interop_list == NULL || list_length(interop_list) == 0) return false;
+  if (interop_dynamic_lengths == 0) return false;
 
-  const list_node_t* node = list_begin(interop_list);
-  while (node != list_end(interop_list)) {
-    interop_addr_entry_t* entry =
-        static_cast<interop_addr_entry_t*>(list_node(node));
-    CHECK(entry);
-
-    if (feature == entry->feature &&
-        memcmp(addr, &entry->addr, entry->length) == 0)
+  for (size_t length = 1; length < RawAddress::kLength; ++length) {
+    if ((interop_dynamic_lengths & (1u << length)) == 0) continue;
+    auto it = interop_dynamic_index.find(interop_dynamic_key_(addr, length));
+    if (it != interop_dynamic_index.end() &&
+        (it->second & INTEROP_FEATURE_BIT(feature)))
       return true;
-
-    node = list_next(node);
   }
   return false;
 }
@@ -170,15 +225,14 @@ static bool interop_match_fixed_(const interop_feature_t feature,
                                  const RawAddress* addr) {
   CHECK(addr);
 
-  const size_t db_size =
-      sizeof(interop_addr_database) / sizeof(interop_addr_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_addr_database[i].feature &&
-        memcmp(addr, &interop_addr_database[i].addr,
-               interop_addr_database[i].length) == 0) {
-      return true;
+  static const InteropTrie addr_trie = [] {
+    InteropTrie trie;
+    for (const interop_addr_entry_t& entry : interop_addr_database) {
+      trie.Add(entry.addr.address, entry.length, entry.feature);
     }
-  }
+    return trie;
+  }();
 
-  return false;
+  return addr_trie.Match(addr->address, RawAddress::kLength, false) &
+         INTEROP_FEATURE_BIT(feature);
 }
@@ -80,3 +80,40 @@ TEST(InteropTest, test_name_miss) {
   EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "audi"));
   EXPECT_FALSE(interop_match_name(INTEROP_AUTO_RETRY_PAIRING, "BMW M3"));
 }
+
+TEST(InteropTest, test_lookup_shared_prefix) {
+  RawAddress test_address;
+  // 38:2c:4a:c9 and 38:2c:4a:e6 share their first 3 bytes
+  RawAddress::FromString("38:2c:4a:c9:00:01", test_address);
+  EXPECT_TRUE(
+      interop_match_addr(INTEROP_DISABLE_LE_SECURE_CONNECTIONS, &test_address));
+  EXPECT_TRUE(
+      interop_match_addr(INTEROP_HID_PREF_CONN_SUP_TIMEOUT_3S, &test_address));
+  RawAddress::FromString("38:2c:4a:c8:00:01", test_address);
+  EXPECT_FALSE(
+      interop_match_addr(INTEROP_DISABLE_LE_SECURE_CONNECTIONS, &test_address));
+}
+
+TEST(InteropTest, test_dynamic_lengths) {
+  RawAddress test_address;
+  RawAddress::FromString("11:22:33:44:55:66", test_address);
+
+  interop_database_add(INTEROP_DISABLE_AUTO_PAIRING, &test_address, 5);
+  interop_database_add(INTEROP_AUTO_RETRY_PAIRING, &test_address, 2);
+  EXPECT_TRUE(interop_match_addr(INTEROP_DISABLE_AUTO_PAIRING, &test_address));
+  EXPECT_TRUE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+
+  // Only the 2 byte prefix matches
+  RawAddress::FromString("11:22:33:44:00:66", test_address);
+  EXPECT_FALSE(interop_match_addr(INTEROP_DISABLE_AUTO_PAIRING, &test_address));
+  EXPECT_TRUE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+
+  interop_database_clear();
+  EXPECT_FALSE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+}
+
+TEST(InteropTest, test_name_shorter_than_prefix) {
+  EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, ""));
+  EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "Ca"));
+  EXPECT_TRUE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "Car"));
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+
+#include "g722_enc_dec.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// Frames of a 10 ms hearing aid packet at 16 kHz
+constexpr int kFrames = 160;
+
+void FillPcm(int16_t* pcm, int num_samples) {
+  uint32_t seed = 1;
+  for (int i = 0; i < num_samples; i++) {
+    seed = seed * 1103515245 + 12345;
+    pcm[i] = static_cast<int16_t>(seed >> 16);
+  }
+}
+
+bool SelectImpl(State& state) {
+  auto impl = static_cast<g722_impl_t>(state.range(0));
+  if (!g722_set_impl(impl)) {
+    state.SkipWithError("implementation not supported");
+    return false;
+  }
+  state.SetLabel(g722_impl_name(impl));
+  return true;
+}
+
+}  // namespace
+
+// Encodes 10 ms of binaural audio with one g722_encode() call per channel, or
+// with one g722_encode_stereo() call when range(1) is set, using the
+// implementation given by range(0). Reports the number of packets encoded per
+// second.
+static void BM_G722Encode(State& state) {
+  if (!SelectImpl(state)) return;
+  bool stereo = state.range(1);
+
+  int16_t pcm[2][kFrames];
+  int16_t interleaved[2 * kFrames];
+  FillPcm(pcm[0], kFrames);
+  FillPcm(pcm[1], kFrames);
+  for (int i = 0; i < kFrames; i++) {
+    interleaved[2 * i] = pcm[0][i];
+    interleaved[2 * i + 1] = pcm[1][i];
+  }
+
+  g722_encode_state_t encoders[2];
+  g722_encode_init(&encoders[0], 64000, G722_PACKED);
+  g722_encode_init(&encoders[1], 64000, G722_PACKED);
+  uint8_t encoded[2][kFrames / 2];
+  for (auto _ : state) {
+    if (stereo) {
+      benchmark::DoNotOptimize(
+          g722_encode_stereo(&encoders[0], &encoders[1], encoded[0],
+                             encoded[1], interleaved, kFrames));
+    } else {
+      for (int c = 0; c < 2; c++) {
+        benchmark::DoNotOptimize(
+            g722_encode(&encoders[c], encoded[c], pcm[c], kFrames));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Decodes 10 ms of binaural audio, as BM_G722Encode encodes it.
+static void BM_G722Decode(State& state) {
+  if (!SelectImpl(state)) return;
+  bool stereo = state.range(1);
+
+  int16_t pcm[kFrames];
+  FillPcm(pcm, kFrames);
+  g722_encode_state_t encoder;
+  g722_encode_init(&encoder, 64000, G722_PACKED);
+  uint8_t encoded[kFrames / 2];
+  g722_encode(&encoder, encoded, pcm, kFrames);
+
+  g722_decode_state_t decoders[2];
+  g722_decode_init(&decoders[0], 64000, G722_PACKED);
+  g722_decode_init(&decoders[1], 64000, G722_PACKED);
+  int16_t decoded[2 * kFrames];
+  for (auto _ : state) {
+    if (stereo) {
+      benchmark::DoNotOptimize(g722_decode_stereo(&decoders[0], &decoders[1],
+                                                  decoded, encoded, encoded,
+                                                  kFrames / 2, 0xffff));
+    } else {
+      for (int c = 0; c < 2; c++) {
+        benchmark::DoNotOptimize(g722_decode(&decoders[c],
+                                             decoded + c * kFrames, encoded,
+                                             kFrames / 2, 0xffff));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void G722Arguments(benchmark::internal::Benchmark* benchmark) {
+  for (int impl = G722_IMPL_C; impl < G722_IMPL_MAX; impl++) {
+    for (int stereo : {0, 1}) benchmark->Args({impl, stereo});
+  }
+}
+
+BENCHMARK(BM_G722Encode)->Apply(G722Arguments);
+BENCHMARK(BM_G722Decode)->Apply(G722Arguments);
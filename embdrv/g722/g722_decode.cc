@@ -30,6 +30,7 @@
 
 #include "g722_typedefs.h"
 #include "g722_enc_dec.h"
+#include "g722_kernels.h"
 
 #if !defined(FALSE)
 #define FALSE 0
@@ -252,169 +253,275 @@ static int16_t qm6[64] =
       1688,   1360,   1040,    728,
        432,    136,   -432,   -136
 };
-static int16_t qmf_coeffs_even[12] =
+/* Number of sample pairs filtered by each call to the QMF kernel */
+#define QMF_BLOCK_PAIRS 80
+
+/* Blocks 5L, 6L, 2L and 3L: reconstructs the low band signal of |code| from the prediction
+   |s| of |band|, and adapts the quantizer scale factor. Returns the reconstructed signal,
+   and the quantized difference for block 4 in |dlowt|. */
+static __inline int decode_low(g722_band_t *band, int s, int code, int *dlowt)
 {
-      3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
-};
-static int16_t qmf_coeffs_odd[12] =
+    int rlow;
+    int wd1;
+    int wd2;
+    int wd3;
+
+#if BITS_PER_SAMPLE == 8
+    wd1 = code & 0x3F;
+    wd2 = qm6[wd1];
+    wd1 >>= 2;
+#elif BITS_PER_SAMPLE == 7
+    wd1 = code & 0x1F;
+    wd2 = qm5[wd1];
+    wd1 >>= 1;
+#elif BITS_PER_SAMPLE == 6
+    wd1 = code & 0x0F;
+    wd2 = qm4[wd1];
+#endif
+    /* Block 5L, LOW BAND INVQBL */
+    wd2 = (band->det*wd2) >> 15;
+    /* Block 5L, RECONS */
+    rlow = s + wd2;
+    /* Block 6L, LIMIT */
+
+    // ANDREA
+    // rlow=ssat(rlow,2<<14)
+    if (rlow > 16383)
+    {
+        rlow = 16383;
+    }
+    else if (rlow < -16384)
+    {
+        rlow = -16384;
+    }
+
+    /* Block 2L, INVQAL */
+    wd2 = qm4[wd1];
+    *dlowt = (band->det*wd2) >> 15;
+
+    /* Block 3L, LOGSCL */
+    wd2 = rl42[wd1];
+    wd1 = (band->nb*127) >> 7;
+    wd1 += wl[wd2];
+    if (wd1 < 0)
+    {
+        wd1 = 0;
+    }
+    else if (wd1 > 18432)
+    {
+        wd1 = 18432;
+    }
+    band->nb = wd1;
+
+    /* Block 3L, SCALEL */
+    wd1 = (band->nb >> 6) & 31;
+    wd2 = 8 - (band->nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    band->det = wd3 << 2;
+    return rlow;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Blocks 2H, 5H, 6H and 3H: reconstructs the high band signal of |code| from the prediction
+   |s| of |band|, and adapts the quantizer scale factor. Returns the reconstructed signal,
+   and the quantized difference for block 4 in |dhigh|. */
+static __inline int decode_high(g722_band_t *band, int s, int code, int *dhigh)
 {
-    -11,   53, -156,  362, -805, 3876, 951,  -210,   32,   12,  -11,    3
-};
+    int ihigh;
+    int rhigh;
+    int wd1;
+    int wd2;
+    int wd3;
 
-uint32_t g722_decode(g722_decode_state_t *s, int16_t amp[], const uint8_t g722_data[], int len, uint16_t gain)
+#if BITS_PER_SAMPLE == 8
+    ihigh = (code >> 6) & 0x03;
+#elif BITS_PER_SAMPLE == 7
+    ihigh = (code >> 5) & 0x03;
+#elif BITS_PER_SAMPLE == 6
+    ihigh = (code >> 4) & 0x03;
+#endif
+    /* Block 2H, INVQAH */
+    wd2 = qm2[ihigh];
+    *dhigh = (band->det*wd2) >> 15;
+    /* Block 5H, RECONS */
+    rhigh = *dhigh + s;
+    /* Block 6H, LIMIT */
+
+    // ANDREA
+    // rhigh=ssat(rhigh,2<<14)
+
+    if (rhigh > 16383)
+        rhigh = 16383;
+    else if (rhigh < -16384)
+        rhigh = -16384;
+
+    /* Block 2H, INVQAH */
+    wd2 = rh2[ihigh];
+    wd1 = (band->nb*127) >> 7;
+    wd1 += wh[wd2];
+    if (wd1 < 0)
+        wd1 = 0;
+    else if (wd1 > 22528)
+        wd1 = 22528;
+    band->nb = wd1;
+
+    /* Block 3H, SCALEH */
+    wd1 = (band->nb >> 6) & 31;
+    wd2 = 10 - (band->nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    band->det = wd3 << 2;
+    return rhigh;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Loads the QMF history of |s| at the start of |window| */
+static void rx_qmf_load(const g722_decode_state_t *s, int16_t window[])
+{
+    int i;
+
+    /* The history only ever holds band sums and differences, which fit in 16 bits */
+    for (i = 0;  i < G722_QMF_HISTORY;  i++)
+        window[i] = (int16_t) s->x[i + 2];
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Applies the receive QMF to the |pairs| pairs of |window|, keeps the history in |s|, and
+   writes the output samples to |amp|, |stride| apart. */
+static void rx_qmf_block(g722_decode_state_t *s, const int16_t window[], int pairs,
+                         int16_t amp[], int stride, uint16_t gain)
 {
+    int xout1[QMF_BLOCK_PAIRS];
+    int xout2[QMF_BLOCK_PAIRS];
+    int out1;
+    int out2;
+    int i;
+
+    g722_kernels()->rx_qmf(window, pairs, xout1, xout2);
 
+    for (i = 0;  i < G722_QMF_HISTORY + 2;  i++)
+        s->x[i] = window[2*(pairs - 1) + i];
+
+    for (i = 0;  i < pairs;  i++)
+    {
+        out1 = NLDECOMPRESS_PREPROCESS_SAMPLE_WITH_GAIN((int16_t) __ssat16(xout1[i]), gain);
+        out2 = NLDECOMPRESS_PREPROCESS_SAMPLE_WITH_GAIN((int16_t) __ssat16(xout2[i]), gain);
+        if (s->dac_pcm)
+        {
+            amp[2*i*stride] = ((int16_t) (out1 >> 4) + 2048);
+            amp[(2*i + 1)*stride] = ((int16_t) (out2 >> 4) + 2048);
+        }
+        else
+        {
+            amp[2*i*stride] = out1;
+            amp[(2*i + 1)*stride] = out2;
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+uint32_t g722_decode(g722_decode_state_t *s, int16_t amp[], const uint8_t g722_data[], int len, uint16_t gain)
+{
+    int16_t window[G722_QMF_HISTORY + 2*QMF_BLOCK_PAIRS];
     int dlowt;
     int rlow;
-    int ihigh;
     int dhigh;
     int rhigh;
-    int xout1;
-    int xout2;
-    int wd1;
-    int wd2;
-    int wd3;
     int code;
+    int pairs;
     uint32_t outlen;
-    int i;
     int j;
 
     outlen = 0;
-    rhigh = 0;
 
     for (j = 0;  j < len;  )
     {
-#if PACKED_INPUT == 1
-        /* Unpack the code bits */
-        if (s->in_bits < s->bits_per_sample)
+        /* Decode a block of sample pairs, and then apply the receive QMF to all of them */
+        rx_qmf_load(s, window);
+        for (pairs = 0;  pairs < QMF_BLOCK_PAIRS  &&  j < len;  pairs++)
         {
-            s->in_buffer |= (g722_data[j++] << s->in_bits);
-            s->in_bits += 8;
-        }
-        code = s->in_buffer & ((1 << s->bits_per_sample) - 1);
-        s->in_buffer >>= s->bits_per_sample;
-        s->in_bits -= s->bits_per_sample;
+#if PACKED_INPUT == 1
+            /* Unpack the code bits */
+            if (s->in_bits < s->bits_per_sample)
+            {
+                s->in_buffer |= (g722_data[j++] << s->in_bits);
+                s->in_bits += 8;
+            }
+            code = s->in_buffer & ((1 << s->bits_per_sample) - 1);
+            s->in_buffer >>= s->bits_per_sample;
+            s->in_bits -= s->bits_per_sample;
 #else
-        code = g722_data[j++];
+            code = g722_data[j++];
 #endif
 
-#if BITS_PER_SAMPLE == 8
-        wd1 = code & 0x3F;
-        ihigh = (code >> 6) & 0x03;
-        wd2 = qm6[wd1];
-        wd1 >>= 2;
-#elif BITS_PER_SAMPLE == 7
-        wd1 = code & 0x1F;
-        ihigh = (code >> 5) & 0x03;
-        wd2 = qm5[wd1];
-        wd1 >>= 1;
-#elif BITS_PER_SAMPLE == 6
-       wd1 = code & 0x0F;
-       ihigh = (code >> 4) & 0x03;
-       wd2 = qm4[wd1];
-#endif
-        /* Block 5L, LOW BAND INVQBL */
-        wd2 = (s->band[0].det*wd2) >> 15;
-        /* Block 5L, RECONS */
-        rlow = s->band[0].s + wd2;
-        /* Block 6L, LIMIT */
-
-        // ANDREA
-        // rlow=ssat(rlow,2<<14)
-        if (rlow > 16383)
-        {
-            rlow = 16383;
-        }
-        else if (rlow < -16384)
-        {
-            rlow = -16384;
+            rlow = decode_low(&s->band[0], s->band[0].s, code, &dlowt);
+            block4(&s->band[0], dlowt);
+            rhigh = decode_high(&s->band[1], s->band[1].s, code, &dhigh);
+            block4(&s->band[1], dhigh);
+
+            window[G722_QMF_HISTORY + 2*pairs] = (int16_t) (rlow + rhigh);
+            window[G722_QMF_HISTORY + 2*pairs + 1] = (int16_t) (rlow - rhigh);
         }
+        rx_qmf_block(s, window, pairs, amp + outlen, 1, gain);
+        outlen += 2*pairs;
+    }
+    return outlen;
+}
+/*- End of function --------------------------------------------------------*/
 
-        /* Block 2L, INVQAL */
-        wd2 = qm4[wd1];
-        dlowt = (s->band[0].det*wd2) >> 15;
+uint32_t g722_decode_stereo(g722_decode_state_t *left, g722_decode_state_t *right, int16_t amp[],
+                            const uint8_t left_data[], const uint8_t right_data[], int len,
+                            uint16_t gain)
+{
+    g722_decode_state_t *channels[2];
+    const uint8_t *data[2];
+    int16_t window[2][G722_QMF_HISTORY + 2*QMF_BLOCK_PAIRS];
+    alignas(16) int32_t d[G722_BANDS_X4];
+    g722_bands_x4_t bands;
+    const g722_kernels_t *kernels;
+    int rlow;
+    int rhigh;
+    int pairs;
+    uint32_t outlen;
+    int c;
+    int j;
 
-        /* Block 3L, LOGSCL */
-        wd2 = rl42[wd1];
-        wd1 = (s->band[0].nb*127) >> 7;
-        wd1 += wl[wd2];
-        if (wd1 < 0)
-        {
-            wd1 = 0;
-        }
-        else if (wd1 > 18432)
-        {
-            wd1 = 18432;
-        }
-        s->band[0].nb = wd1;
-            
-        /* Block 3L, SCALEL */
-        wd1 = (s->band[0].nb >> 6) & 31;
-        wd2 = 8 - (s->band[0].nb >> 11);
-        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[0].det = wd3 << 2;
-
-        block4(&s->band[0], dlowt);
-        
-        /* Block 2H, INVQAH */
-        wd2 = qm2[ihigh];
-        dhigh = (s->band[1].det*wd2) >> 15;
-        /* Block 5H, RECONS */
-        rhigh = dhigh + s->band[1].s;
-        /* Block 6H, LIMIT */
-
-        // ANDREA
-        // rhigh=ssat(rhigh,2<<14)
-
-        if (rhigh > 16383)
-            rhigh = 16383;
-        else if (rhigh < -16384)
-            rhigh = -16384;
-
-        /* Block 2H, INVQAH */
-        wd2 = rh2[ihigh];
-        wd1 = (s->band[1].nb*127) >> 7;
-        wd1 += wh[wd2];
-        if (wd1 < 0)
-            wd1 = 0;
-        else if (wd1 > 22528)
-            wd1 = 22528;
-        s->band[1].nb = wd1;
-            
-        /* Block 3H, SCALEH */
-        wd1 = (s->band[1].nb >> 6) & 31;
-        wd2 = 10 - (s->band[1].nb >> 11);
-        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[1].det = wd3 << 2;
-
-        block4(&s->band[1], dhigh);
-
-        /* Apply the receive QMF */
-        for (i = 0;  i < 22;  i++)
-            s->x[i] = s->x[i + 2];
-        s->x[22] = rlow + rhigh;
-        s->x[23] = rlow - rhigh;
-
-        // we should get PERF numbers for the following loop 
-        xout1 = 0;
-        xout2 = 0;
-        for (i = 0;  i < 12;  i++)
-        {
-            xout2 += s->x[2*i]   * qmf_coeffs_even[i];
-            xout1 += s->x[2*i+1] * qmf_coeffs_odd[i];
-        }
-        xout1 = NLDECOMPRESS_PREPROCESS_SAMPLE_WITH_GAIN((int16_t) __ssat16(xout1 >> 11), gain);
-        xout2 = NLDECOMPRESS_PREPROCESS_SAMPLE_WITH_GAIN((int16_t) __ssat16(xout2 >> 11), gain);
-        if (s->dac_pcm)
-        {
-            amp[outlen++] = ((int16_t) (xout1 >> 4) + 2048);
-            amp[outlen++] = ((int16_t) (xout2 >> 4) + 2048);
-        }
-        else
+    channels[0] = left;
+    channels[1] = right;
+    data[0] = left_data;
+    data[1] = right_data;
+    outlen = 0;
+
+    /* The lanes are the low and high band of the left channel, then of the right one */
+    kernels = g722_kernels();
+    for (c = 0;  c < 2;  c++)
+    {
+        g722_bands_x4_load(&bands, 2*c, &channels[c]->band[0]);
+        g722_bands_x4_load(&bands, 2*c + 1, &channels[c]->band[1]);
+    }
+    for (j = 0;  j < len;  )
+    {
+        for (c = 0;  c < 2;  c++)
+            rx_qmf_load(channels[c], window[c]);
+        for (pairs = 0;  pairs < QMF_BLOCK_PAIRS  &&  j < len;  pairs++, j++)
         {
-            amp[outlen++] = xout1;
-            amp[outlen++] = xout2;
+            for (c = 0;  c < 2;  c++)
+            {
+                rlow = decode_low(&channels[c]->band[0], bands.s[2*c], data[c][j], &d[2*c]);
+                rhigh = decode_high(&channels[c]->band[1], bands.s[2*c + 1], data[c][j],
+                                    &d[2*c + 1]);
+                window[c][G722_QMF_HISTORY + 2*pairs] = (int16_t) (rlow + rhigh);
+                window[c][G722_QMF_HISTORY + 2*pairs + 1] = (int16_t) (rlow - rhigh);
+            }
+            kernels->block4_x4(&bands, d);
         }
+        for (c = 0;  c < 2;  c++)
+            rx_qmf_block(channels[c], window[c], pairs, amp + 2*outlen + c, 2, gain);
+        outlen += 2*pairs;
+    }
+    for (c = 0;  c < 2;  c++)
+    {
+        g722_bands_x4_store(&bands, 2*c, &channels[c]->band[0]);
+        g722_bands_x4_store(&bands, 2*c + 1, &channels[c]->band[1]);
     }
     return outlen;
 }
@@ -129,6 +129,16 @@ typedef struct
     int out_bits;
 } g722_decode_state_t;
 
+/*! Implementations of the QMF and adaptive predictor kernels of the encoder and the decoder.
+    All of them are bit exact. */
+typedef enum
+{
+    G722_IMPL_C,
+    G722_IMPL_SSE4,
+    G722_IMPL_NEON,
+    G722_IMPL_MAX
+} g722_impl_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -137,9 +147,32 @@ g722_encode_state_t *g722_encode_init(g722_encode_state_t *s, unsigned int rate,
 int g722_encode_release(g722_encode_state_t *s);
 int g722_encode(g722_encode_state_t *s, uint8_t g722_data[], const int16_t amp[], int len);
 
+/*! Encodes |len| frames of interleaved stereo |amp| with one encoder per channel, and
+    returns the number of bytes written to each of |left_data| and |right_data|. The result
+    is the same as encoding each channel on its own, but the adaptive predictors of the four
+    bands are run together. */
+int g722_encode_stereo(g722_encode_state_t *left, g722_encode_state_t *right,
+                       uint8_t left_data[], uint8_t right_data[], const int16_t amp[], int len);
+
 g722_decode_state_t *g722_decode_init(g722_decode_state_t *s, unsigned int rate, int options);
 int g722_decode_release(g722_decode_state_t *s);
 uint32_t g722_decode(g722_decode_state_t *s, int16_t amp[], const uint8_t g722_data[], int len, uint16_t aGain);
+/*! Decodes |len| bytes of each of |left_data| and |right_data| with one decoder per channel
+    into interleaved stereo |amp|, and returns the number of samples written per channel. The
+    result is the same as decoding each channel on its own. */
+uint32_t g722_decode_stereo(g722_decode_state_t *left, g722_decode_state_t *right, int16_t amp[],
+                            const uint8_t left_data[], const uint8_t right_data[], int len,
+                            uint16_t gain);
+
+/*! Returns TRUE if |impl| is available in this build and on this CPU. */
+int g722_impl_supported(g722_impl_t impl);
+/*! Selects the kernels used by the encoders and the decoders. By default the fastest supported
+    implementation is used. Returns FALSE and keeps the current implementation if |impl| is
+    not supported. */
+int g722_set_impl(g722_impl_t impl);
+g722_impl_t g722_get_impl(void);
+/*! Returns a printable name for |impl|. */
+const char *g722_impl_name(g722_impl_t impl);
 
 #ifdef __cplusplus
 }
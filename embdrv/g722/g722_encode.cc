@@ -31,6 +31,7 @@
 
 #include "g722_typedefs.h"
 #include "g722_enc_dec.h"
+#include "g722_kernels.h"
 
 #if !defined(FALSE)
 #define FALSE 0
@@ -259,45 +260,195 @@ static int16_t qm2[4] =
 {
     -7408,  -1616,   7408,   1616
 };
-static int16_t qmf_coeffs[12] =
-{
-       3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
-};
 static int16_t ihn[3] = {0, 1, 0};
 static int16_t ihp[3] = {0, 3, 2};
 static int16_t wh[3] = {0, -214, 798};
 static int16_t rh2[4] = {2, 1, 2, 1};
 
-int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
-                       const int16_t amp[], int len)
+/* Number of sample pairs filtered by each call to the QMF kernel */
+#define QMF_BLOCK_PAIRS 80
+
+/* Runs the transmit QMF over up to QMF_BLOCK_PAIRS pairs of |amp|, and returns the
+   number of pairs filtered. The samples of |amp| are |stride| apart. An odd trailing
+   sample is paired with a zero. */
+static int tx_qmf_block(g722_encode_state_t *s, const int16_t amp[], int stride, int len,
+                        int xlow[], int xhigh[])
+{
+    int16_t window[G722_QMF_HISTORY + 2*QMF_BLOCK_PAIRS];
+    int pairs;
+    int i;
+
+    pairs = (len + 1) >> 1;
+    if (pairs > QMF_BLOCK_PAIRS)
+        pairs = QMF_BLOCK_PAIRS;
+    if (len > 2*pairs)
+        len = 2*pairs;
+
+    /* The history only ever holds input samples */
+    for (i = 0;  i < G722_QMF_HISTORY;  i++)
+        window[i] = (int16_t) s->x[i + 2];
+    if (stride == 1)
+    {
+        memcpy(window + G722_QMF_HISTORY, amp, len*sizeof(amp[0]));
+    }
+    else
+    {
+        for (i = 0;  i < len;  i++)
+            window[G722_QMF_HISTORY + i] = amp[i*stride];
+    }
+    if (len < 2*pairs)
+        window[G722_QMF_HISTORY + len] = 0;
+
+    g722_kernels()->tx_qmf(window, pairs, xlow, xhigh);
+
+    for (i = 0;  i < G722_QMF_HISTORY + 2;  i++)
+        s->x[i] = window[2*(pairs - 1) + i];
+    return pairs;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Blocks 1L, 2L and 3L: quantizes |xlow| against the prediction |s| of |band|, and adapts
+   the quantizer scale factor. Returns the quantized difference for block 4. */
+static __inline int encode_low(g722_band_t *band, int s, int xlow, int *ilow)
 {
-    int dlow;
-    int dhigh;
     int el;
     int wd;
     int wd1;
-    int ril;
     int wd2;
-    int il4;
-    int ih2;
     int wd3;
+    int ril;
+    int il4;
+    int i;
+    int lo;
+    int hi;
+    int dlow;
+
+    /* Block 1L, SUBTRA */
+    el = saturate(xlow - s);
+
+    /* Block 1L, QUANTL */
+    wd = (el >= 0)  ?  el  :  -(el + 1);
+
+    /* The levels of q6 increase, binary search the first one above wd */
+    lo = 1;
+    hi = 30;
+    while (lo < hi)
+    {
+        i = (lo + hi) >> 1;
+        wd1 = (q6[i]*band->det) >> 12;
+        if (wd < wd1)
+            hi = i;
+        else
+            lo = i + 1;
+    }
+    i = lo;
+    *ilow = (el < 0)  ?  iln[i]  :  ilp[i];
+
+    /* Block 2L, INVQAL */
+    ril = *ilow >> 2;
+    wd2 = qm4[ril];
+    dlow = (band->det*wd2) >> 15;
+
+    /* Block 3L, LOGSCL */
+    il4 = rl42[ril];
+    wd = (band->nb*127) >> 7;
+    band->nb = wd + wl[il4];
+    if (band->nb < 0)
+        band->nb = 0;
+    else if (band->nb > 18432)
+        band->nb = 18432;
+
+    /* Block 3L, SCALEL */
+    wd1 = (band->nb >> 6) & 31;
+    wd2 = 8 - (band->nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    band->det = wd3 << 2;
+    return dlow;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Blocks 1H, 2H and 3H: quantizes |xhigh| against the prediction |s| of |band|, and adapts
+   the quantizer scale factor. Returns the quantized difference for block 4. */
+static __inline int encode_high(g722_band_t *band, int s, int xhigh, int *ihigh)
+{
     int eh;
+    int wd;
+    int wd1;
+    int wd2;
+    int wd3;
     int mih;
-    int i;
+    int ih2;
+    int nb;
+    int dhigh;
+
+    /* Block 1H, SUBTRA */
+    eh = saturate(xhigh - s);
+
+    /* Block 1H, QUANTH */
+    wd = (eh >= 0)  ?  eh  :  -(eh + 1);
+    wd1 = (564*band->det) >> 12;
+    mih = (wd >= wd1)  ?  2  :  1;
+    *ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
+
+    /* Block 2H, INVQAH */
+    wd2 = qm2[*ihigh];
+    dhigh = (band->det*wd2) >> 15;
+
+    /* Block 3H, LOGSCH */
+    ih2 = rh2[*ihigh];
+    wd = (band->nb*127) >> 7;
+
+    nb = wd + wh[ih2];
+    if (nb < 0)
+        nb = 0;
+    else if (nb > 22528)
+        nb = 22528;
+    band->nb = nb;
+
+    /* Block 3H, SCALEH */
+    wd1 = (band->nb >> 6) & 31;
+    wd2 = 10 - (band->nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    band->det = wd3 << 2;
+    return dhigh;
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline int encode_code(int ilow, int ihigh)
+{
+#if   BITS_PER_SAMPLE == 8
+    return ((ihigh << 6) | ilow);
+#elif BITS_PER_SAMPLE == 7
+    return ((ihigh << 6) | ilow) >> 1;
+#elif BITS_PER_SAMPLE == 6
+    return ((ihigh << 6) | ilow) >> 2;
+#endif
+}
+/*- End of function --------------------------------------------------------*/
+
+int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
+                       const int16_t amp[], int len)
+{
+    int dlow;
+    int dhigh;
     int j;
     /* Low and high band PCM from the QMF */
     int xlow;
     int xhigh;
     int g722_bytes;
-    /* Even and odd tap accumulators */
-    int sumeven;
-    int sumodd;
     int ihigh;
     int ilow;
     int code;
+    /* QMF outputs of the current block */
+    int qmf_low[QMF_BLOCK_PAIRS];
+    int qmf_high[QMF_BLOCK_PAIRS];
+    int qmf_pairs;
+    int qmf_next;
 
     g722_bytes = 0;
     xhigh = 0;
+    qmf_pairs = 0;
+    qmf_next = 0;
     for (j = 0;  j < len;  )
     {
         if (s->itu_test_mode)
@@ -308,27 +459,16 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
         else
         {
             {
-                /* Apply the transmit QMF */
-                /* Shuffle the buffer down */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                //TODO: if len is odd, then this can be a buffer overrun
-                s->x[22] = amp[j++];
-                s->x[23] = amp[j++];
-    
-                /* Discard every other QMF output */
-                sumeven = 0;
-                sumodd = 0;
-                for (i = 0;  i < 12;  i++)
+                /* Apply the transmit QMF, a block of sample pairs at a time */
+                if (qmf_next == qmf_pairs)
                 {
-                    sumodd += s->x[2*i]*qmf_coeffs[i];
-                    sumeven += s->x[2*i + 1]*qmf_coeffs[11 - i];
+                    qmf_pairs = tx_qmf_block(s, amp + j, 1, len - j, qmf_low, qmf_high);
+                    qmf_next = 0;
                 }
-                /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
-                   to allow for us summing two filters, plus 1 to allow for the 15 bit
-                   input to the G.722 algorithm. */
-                xlow = (sumeven + sumodd) >> 14;
-                xhigh = (sumeven - sumodd) >> 14;
+                xlow = qmf_low[qmf_next];
+                xhigh = qmf_high[qmf_next];
+                qmf_next++;
+                j += 2;
 
 #ifdef RUN_LIKE_REFERENCE_G722
                 /* The following lines are only used to verify bit-exactness
@@ -340,83 +480,11 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
 #endif
             }
         }
-        /* Block 1L, SUBTRA */
-        el = saturate(xlow - s->band[0].s);
-
-        /* Block 1L, QUANTL */
-        wd = (el >= 0)  ?  el  :  -(el + 1);
-
-        for (i = 1;  i < 30;  i++)
-        {
-            wd1 = (q6[i]*s->band[0].det) >> 12;
-            if (wd < wd1)
-                break;
-        }
-        ilow = (el < 0)  ?  iln[i]  :  ilp[i];
-
-        /* Block 2L, INVQAL */
-        ril = ilow >> 2;
-        wd2 = qm4[ril];
-        dlow = (s->band[0].det*wd2) >> 15;
-
-        /* Block 3L, LOGSCL */
-        il4 = rl42[ril];
-        wd = (s->band[0].nb*127) >> 7;
-        s->band[0].nb = wd + wl[il4];
-        if (s->band[0].nb < 0)
-            s->band[0].nb = 0;
-        else if (s->band[0].nb > 18432)
-            s->band[0].nb = 18432;
-
-        /* Block 3L, SCALEL */
-        wd1 = (s->band[0].nb >> 6) & 31;
-        wd2 = 8 - (s->band[0].nb >> 11);
-        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[0].det = wd3 << 2;
-
+        dlow = encode_low(&s->band[0], s->band[0].s, xlow, &ilow);
         block4(&s->band[0], dlow);
-        {
-	    int nb;
-
-            /* Block 1H, SUBTRA */
-            eh = saturate(xhigh - s->band[1].s);
-
-            /* Block 1H, QUANTH */
-            wd = (eh >= 0)  ?  eh  :  -(eh + 1);
-            wd1 = (564*s->band[1].det) >> 12;
-            mih = (wd >= wd1)  ?  2  :  1;
-            ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
-
-            /* Block 2H, INVQAH */
-            wd2 = qm2[ihigh];
-            dhigh = (s->band[1].det*wd2) >> 15;
-
-            /* Block 3H, LOGSCH */
-            ih2 = rh2[ihigh];
-            wd = (s->band[1].nb*127) >> 7;
-
-            nb = wd + wh[ih2];
-            if (nb < 0)
-                nb = 0;
-            else if (nb > 22528)
-                nb = 22528;
-	    s->band[1].nb = nb;
-
-            /* Block 3H, SCALEH */
-            wd1 = (s->band[1].nb >> 6) & 31;
-            wd2 = 10 - (s->band[1].nb >> 11);
-            wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-            s->band[1].det = wd3 << 2;
-
-            block4(&s->band[1], dhigh);
-#if   BITS_PER_SAMPLE == 8
-            code = ((ihigh << 6) | ilow);
-#elif BITS_PER_SAMPLE == 7
-            code = ((ihigh << 6) | ilow) >> 1;
-#elif BITS_PER_SAMPLE == 6
-            code = ((ihigh << 6) | ilow) >> 2;
-#endif
-        }
+        dhigh = encode_high(&s->band[1], s->band[1].s, xhigh, &ihigh);
+        block4(&s->band[1], dhigh);
+        code = encode_code(ilow, ihigh);
 
 #if PACKED_OUTPUT == 1
             /* Pack the code bits */
@@ -435,4 +503,81 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
     return g722_bytes;
 }
 /*- End of function --------------------------------------------------------*/
+
+int g722_encode_stereo(g722_encode_state_t *left, g722_encode_state_t *right,
+                       uint8_t left_data[], uint8_t right_data[], const int16_t amp[], int len)
+{
+    g722_encode_state_t *channels[2];
+    uint8_t *data[2];
+    alignas(16) int32_t d[G722_BANDS_X4];
+    g722_bands_x4_t bands;
+    const g722_kernels_t *kernels;
+    int qmf_low[2][QMF_BLOCK_PAIRS];
+    int qmf_high[2][QMF_BLOCK_PAIRS];
+    int16_t mono[2*QMF_BLOCK_PAIRS];
+    int g722_bytes;
+    int pairs;
+    int ilow;
+    int ihigh;
+    int c;
+    int j;
+    int k;
+
+    channels[0] = left;
+    channels[1] = right;
+    data[0] = left_data;
+    data[1] = right_data;
+    g722_bytes = 0;
+
+    if (left->itu_test_mode || right->itu_test_mode)
+    {
+        /* No QMF to share: deinterleave and encode each channel on its own */
+        int bytes[2] = {0, 0};
+
+        for (j = 0;  j < len;  j += 2*QMF_BLOCK_PAIRS)
+        {
+            int frames = (len - j < 2*QMF_BLOCK_PAIRS)  ?  (len - j)  :  2*QMF_BLOCK_PAIRS;
+
+            for (c = 0;  c < 2;  c++)
+            {
+                for (k = 0;  k < frames;  k++)
+                    mono[k] = amp[2*(j + k) + c];
+                bytes[c] += g722_encode(channels[c], data[c] + bytes[c], mono, frames);
+            }
+        }
+        return bytes[0];
+    }
+
+    /* The lanes are the low and high band of the left channel, then of the right one */
+    kernels = g722_kernels();
+    for (c = 0;  c < 2;  c++)
+    {
+        g722_bands_x4_load(&bands, 2*c, &channels[c]->band[0]);
+        g722_bands_x4_load(&bands, 2*c + 1, &channels[c]->band[1]);
+    }
+    for (j = 0;  j < len;  j += 2*pairs)
+    {
+        for (c = 0;  c < 2;  c++)
+            pairs = tx_qmf_block(channels[c], amp + 2*j + c, 2, len - j, qmf_low[c], qmf_high[c]);
+        for (k = 0;  k < pairs;  k++)
+        {
+            for (c = 0;  c < 2;  c++)
+            {
+                d[2*c] = encode_low(&channels[c]->band[0], bands.s[2*c], qmf_low[c][k], &ilow);
+                d[2*c + 1] = encode_high(&channels[c]->band[1], bands.s[2*c + 1], qmf_high[c][k],
+                                         &ihigh);
+                data[c][g722_bytes] = (uint8_t) encode_code(ilow, ihigh);
+            }
+            kernels->block4_x4(&bands, d);
+            g722_bytes++;
+        }
+    }
+    for (c = 0;  c < 2;  c++)
+    {
+        g722_bands_x4_store(&bands, 2*c, &channels[c]->band[0]);
+        g722_bands_x4_store(&bands, 2*c + 1, &channels[c]->band[1]);
+    }
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
@@ -0,0 +1,550 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Kernels of the G.722 QMFs and adaptive predictor, and selection of the
+// kernels used by the encoder and the decoder.
+//
+// Each QMF output sums 12 taps over the even samples of the window and 12
+// taps over the odd ones. The SIMD kernels turn both sums into 24 tap dot
+// products with interleaved coefficients. For the transmit QMF there is one
+// for the low band (even + odd) and one for the high band (even - odd). They
+// use exact 16x16 bit products accumulated on 32 bits.
+//
+// Block 4 runs on the four bands of a stereo stream at once, one per lane.
+// Every operation of the scalar code maps to an exact 32 bit lane operation,
+// and all products fit in 32 bits.
+//
+// All the kernels are therefore bit-exact with the C ones.
+
+#include "g722_kernels.h"
+
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define G722_X86_KERNELS
+#include <immintrin.h>
+#define G722_TARGET_SSE4 __attribute__((target("sse4.1")))
+#endif
+
+// NEON is a build time option on ARMv7 and always present on ARMv8
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define G722_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+#define G722_QMF_TAPS (G722_QMF_HISTORY + 2)
+
+static const int16_t qmf_coeffs[12] = {
+    3, -11, 12, 32, -210, 951, 3876, -805, 362, -156, 53, -11,
+};
+
+#if defined(G722_X86_KERNELS) || defined(G722_NEON_KERNELS)
+// Transmit QMF: qmf_coeffs[i] applies to sample 2 * i and qmf_coeffs[11 - i]
+// to sample 2 * i + 1
+alignas(16) static const int16_t tx_low_coeffs[G722_QMF_TAPS] = {
+    3,   -11,  -11,  53,   12,   -156, 32,  362,  -210, -805, 951, 3876,
+    3876, 951, -805, -210, 362,  32,   -156, 12,  53,   -11,  -11, 3,
+};
+alignas(16) static const int16_t tx_high_coeffs[G722_QMF_TAPS] = {
+    -3,   -11, 11,  53,   -12,  -156, -32, 362, 210,  -805, -951, 3876,
+    -3876, 951, 805, -210, -362, 32,   156, 12,  -53,  -11,  11,   3,
+};
+// Receive QMF: the second output only uses the even samples with
+// qmf_coeffs[i], the first one only the odd samples with qmf_coeffs[11 - i]
+alignas(16) static const int16_t rx_out1_coeffs[G722_QMF_TAPS] = {
+    0, -11, 0, 53,  0, -156, 0, 362,  0, -805, 0, 3876,
+    0, 951, 0, -210, 0, 32,  0, 12,   0, -11,  0, 3,
+};
+alignas(16) static const int16_t rx_out2_coeffs[G722_QMF_TAPS] = {
+    3,    0, -11, 0, 12,  0, 32,   0, -210, 0, 951, 0,
+    3876, 0, -805, 0, 362, 0, -156, 0, 53,   0, -11, 0,
+};
+#endif
+
+static void g722_tx_qmf_c(const int16_t* window, int pairs, int xlow[],
+                          int xhigh[]) {
+  for (int k = 0; k < pairs; k++) {
+    const int16_t* x = window + 2 * k;
+    int sumeven = 0;
+    int sumodd = 0;
+    for (int i = 0; i < 12; i++) {
+      sumodd += x[2 * i] * qmf_coeffs[i];
+      sumeven += x[2 * i + 1] * qmf_coeffs[11 - i];
+    }
+    // We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1 to
+    // allow for us summing two filters, plus 1 to allow for the 15 bit input
+    // to the G.722 algorithm.
+    xlow[k] = (sumeven + sumodd) >> 14;
+    xhigh[k] = (sumeven - sumodd) >> 14;
+  }
+}
+
+static void g722_rx_qmf_c(const int16_t* window, int pairs, int xout1[],
+                          int xout2[]) {
+  for (int k = 0; k < pairs; k++) {
+    const int16_t* x = window + 2 * k;
+    int out1 = 0;
+    int out2 = 0;
+    for (int i = 0; i < 12; i++) {
+      out2 += x[2 * i] * qmf_coeffs[i];
+      out1 += x[2 * i + 1] * qmf_coeffs[11 - i];
+    }
+    xout1[k] = out1 >> 11;
+    xout2[k] = out2 >> 11;
+  }
+}
+
+static inline int32_t g722_sat16(int32_t x) {
+  if (x > 32767) return 32767;
+  if (x < -32768) return -32768;
+  return x;
+}
+
+static void g722_block4_x4_c(g722_bands_x4_t* bands,
+                             const int32_t d_in[G722_BANDS_X4]) {
+  for (int lane = 0; lane < G722_BANDS_X4; lane++) {
+    int32_t d = d_in[lane];
+
+    // Block 4, RECONS and PARREC
+    bands->d[0][lane] = d;
+    bands->r[0][lane] = g722_sat16(bands->s[lane] + d);
+    bands->p[0][lane] = g722_sat16(bands->sz[lane] + d);
+
+    // Block 4, UPPOL2
+    int32_t sg0 = bands->p[0][lane] >> 15;
+    int32_t sg1 = bands->p[1][lane] >> 15;
+    int32_t sg2 = bands->p[2][lane] >> 15;
+    int32_t wd1 = g722_sat16(bands->a[1][lane] * 4);
+    int32_t wd2 = (sg0 == sg1) ? -wd1 : wd1;
+    if (wd2 > 32767) wd2 = 32767;
+    int32_t ap2 = (wd2 >> 7) + ((sg0 == sg2) ? 128 : -128);
+    ap2 += (bands->a[2][lane] * 32512) >> 15;
+    if (ap2 > 12288)
+      ap2 = 12288;
+    else if (ap2 < -12288)
+      ap2 = -12288;
+    bands->ap[2][lane] = ap2;
+
+    // Block 4, UPPOL1
+    wd1 = (sg0 == sg1) ? 192 : -192;
+    wd2 = (bands->a[1][lane] * 32640) >> 15;
+    int32_t ap1 = g722_sat16(wd1 + wd2);
+    int32_t wd3 = g722_sat16(15360 - ap2);
+    if (ap1 > wd3)
+      ap1 = wd3;
+    else if (ap1 < -wd3)
+      ap1 = -wd3;
+    bands->ap[1][lane] = ap1;
+
+    // Block 4, UPZERO
+    wd1 = (d == 0) ? 0 : 128;
+    int32_t sgd = d >> 15;
+    for (int i = 1; i < 7; i++) {
+      wd2 = ((bands->d[i][lane] >> 15) == sgd) ? wd1 : -wd1;
+      wd3 = (bands->b[i][lane] * 32640) >> 15;
+      bands->bp[i][lane] = g722_sat16(wd2 + wd3);
+    }
+
+    // Block 4, DELAYA
+    int32_t sz = 0;
+    for (int i = 6; i > 0; i--) {
+      bands->d[i][lane] = bands->d[i - 1][lane];
+      bands->b[i][lane] = bands->bp[i][lane];
+      wd1 = g722_sat16(bands->d[i][lane] + bands->d[i][lane]);
+      sz += (bands->b[i][lane] * wd1) >> 15;
+    }
+    bands->sz[lane] = sz;
+    for (int i = 2; i > 0; i--) {
+      bands->r[i][lane] = bands->r[i - 1][lane];
+      bands->p[i][lane] = bands->p[i - 1][lane];
+      bands->a[i][lane] = bands->ap[i][lane];
+    }
+
+    // Block 4, FILTEP and PREDIC
+    wd1 = g722_sat16(bands->r[1][lane] + bands->r[1][lane]);
+    wd1 = (bands->a[1][lane] * wd1) >> 15;
+    wd2 = g722_sat16(bands->r[2][lane] + bands->r[2][lane]);
+    wd2 = (bands->a[2][lane] * wd2) >> 15;
+    bands->sp[lane] = g722_sat16(wd1 + wd2);
+    bands->s[lane] = g722_sat16(bands->sp[lane] + sz);
+  }
+}
+
+// Block 4 of four bands at once, |V| is the prefix of the vector operations:
+//  - V##_sel_eq(a, b, x, y) is x in the lanes where a == b, y elsewhere.
+//  - V##_mul_sr15(a, b) is (a * b) >> 15.
+#define G722_BLOCK4_X4(V, bands, d_in)                                       \
+  {                                                                          \
+    V##_t d = V##_ld(d_in);                                                  \
+    V##_t r0 = V##_sat16(V##_add(V##_ld(bands->s), d));                      \
+    V##_t p0 = V##_sat16(V##_add(V##_ld(bands->sz), d));                     \
+    V##_t p1 = V##_ld(bands->p[1]);                                          \
+    V##_t a1 = V##_ld(bands->a[1]);                                          \
+    V##_t a2 = V##_ld(bands->a[2]);                                          \
+    V##_t sg0 = V##_sr15(p0);                                                \
+    V##_t sg1 = V##_sr15(p1);                                                \
+    V##_t sg2 = V##_sr15(V##_ld(bands->p[2]));                               \
+    V##_t wd1, wd2, wd3;                                                     \
+    /* Block 4, UPPOL2 */                                                    \
+    wd1 = V##_sat16(V##_shl2(a1));                                           \
+    wd2 = V##_min(V##_sel_eq(sg0, sg1, V##_neg(wd1), wd1), V##_dup(32767));  \
+    V##_t ap2 = V##_add(V##_sr7(wd2),                                        \
+                        V##_sel_eq(sg0, sg2, V##_dup(128), V##_dup(-128)));  \
+    ap2 = V##_add(ap2, V##_mul_sr15(a2, V##_dup(32512)));                    \
+    ap2 = V##_min(V##_max(ap2, V##_dup(-12288)), V##_dup(12288));            \
+    /* Block 4, UPPOL1 */                                                    \
+    wd1 = V##_sel_eq(sg0, sg1, V##_dup(192), V##_dup(-192));                 \
+    V##_t ap1 = V##_sat16(V##_add(wd1, V##_mul_sr15(a1, V##_dup(32640))));   \
+    wd3 = V##_sat16(V##_sub(V##_dup(15360), ap2));                           \
+    ap1 = V##_min(V##_max(ap1, V##_neg(wd3)), wd3);                          \
+    /* Block 4, UPZERO, then DELAYA of the zero predictor */                 \
+    wd1 = V##_sel_eq(d, V##_dup(0), V##_dup(0), V##_dup(128));               \
+    V##_t sgd = V##_sr15(d);                                                 \
+    V##_t sz = V##_dup(0);                                                   \
+    V##_t d_prev = d;                                                        \
+    for (int i = 1; i < 7; i++) {                                            \
+      V##_t d_old = V##_ld(bands->d[i]);                                     \
+      wd2 = V##_sel_eq(V##_sr15(d_old), sgd, wd1, V##_neg(wd1));             \
+      wd3 = V##_mul_sr15(V##_ld(bands->b[i]), V##_dup(32640));               \
+      V##_t bp = V##_sat16(V##_add(wd2, wd3));                               \
+      V##_st(bands->bp[i], bp);                                              \
+      V##_st(bands->b[i], bp);                                               \
+      V##_st(bands->d[i], d_prev);                                           \
+      sz = V##_add(sz,                                                       \
+                   V##_mul_sr15(bp, V##_sat16(V##_add(d_prev, d_prev))));    \
+      d_prev = d_old;                                                        \
+    }                                                                        \
+    V##_st(bands->d[0], d);                                                  \
+    V##_st(bands->sz, sz);                                                   \
+    /* DELAYA of the pole predictor */                                       \
+    V##_t r1 = V##_ld(bands->r[1]);                                          \
+    V##_st(bands->r[2], r1);                                                 \
+    V##_st(bands->r[1], r0);                                                 \
+    V##_st(bands->r[0], r0);                                                 \
+    V##_st(bands->p[2], p1);                                                 \
+    V##_st(bands->p[1], p0);                                                 \
+    V##_st(bands->p[0], p0);                                                 \
+    V##_st(bands->ap[2], ap2);                                               \
+    V##_st(bands->ap[1], ap1);                                               \
+    V##_st(bands->a[2], ap2);                                                \
+    V##_st(bands->a[1], ap1);                                                \
+    /* Block 4, FILTEP and PREDIC */                                         \
+    wd1 = V##_mul_sr15(ap1, V##_sat16(V##_add(r0, r0)));                     \
+    wd2 = V##_mul_sr15(ap2, V##_sat16(V##_add(r1, r1)));                     \
+    V##_t sp = V##_sat16(V##_add(wd1, wd2));                                 \
+    V##_st(bands->sp, sp);                                                   \
+    V##_st(bands->s, V##_sat16(V##_add(sp, sz)));                            \
+  }
+
+#if defined(G722_X86_KERNELS)
+typedef __m128i sse4_t;
+
+G722_TARGET_SSE4 static inline sse4_t sse4_ld(const int32_t* p) {
+  return _mm_load_si128(reinterpret_cast<const __m128i*>(p));
+}
+G722_TARGET_SSE4 static inline void sse4_st(int32_t* p, sse4_t a) {
+  _mm_store_si128(reinterpret_cast<__m128i*>(p), a);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_dup(int32_t c) {
+  return _mm_set1_epi32(c);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_add(sse4_t a, sse4_t b) {
+  return _mm_add_epi32(a, b);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_sub(sse4_t a, sse4_t b) {
+  return _mm_sub_epi32(a, b);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_neg(sse4_t a) {
+  return _mm_sub_epi32(_mm_setzero_si128(), a);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_min(sse4_t a, sse4_t b) {
+  return _mm_min_epi32(a, b);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_max(sse4_t a, sse4_t b) {
+  return _mm_max_epi32(a, b);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_sat16(sse4_t a) {
+  return _mm_min_epi32(_mm_max_epi32(a, _mm_set1_epi32(-32768)),
+                       _mm_set1_epi32(32767));
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_shl2(sse4_t a) {
+  return _mm_slli_epi32(a, 2);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_sr7(sse4_t a) {
+  return _mm_srai_epi32(a, 7);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_sr15(sse4_t a) {
+  return _mm_srai_epi32(a, 15);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_mul_sr15(sse4_t a, sse4_t b) {
+  return _mm_srai_epi32(_mm_mullo_epi32(a, b), 15);
+}
+G722_TARGET_SSE4 static inline sse4_t sse4_sel_eq(sse4_t a, sse4_t b,
+                                                  sse4_t x, sse4_t y) {
+  return _mm_blendv_epi8(y, x, _mm_cmpeq_epi32(a, b));
+}
+
+// Returns the 4 partial sums of the dot product of the window at |x| with the
+// coefficients |c0|, |c1| and |c2|
+G722_TARGET_SSE4 static inline __m128i g722_dot_sse4(const int16_t* x,
+                                                      __m128i c0, __m128i c1,
+                                                      __m128i c2) {
+  __m128i acc = _mm_madd_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(x)), c0);
+  acc = _mm_add_epi32(
+      acc, _mm_madd_epi16(
+               _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + 8)), c1));
+  return _mm_add_epi32(
+      acc, _mm_madd_epi16(
+               _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + 16)), c2));
+}
+
+// Computes the dot products of the |pairs| windows with |coeffs_a| and
+// |coeffs_b|, shifted right by |shift|. Four pairs per iteration: the
+// horizontal adds reduce the partial sums of four windows into one vector.
+// Returns the number of pairs computed, a multiple of four.
+G722_TARGET_SSE4 static int g722_qmf_sse4(const int16_t* window, int pairs,
+                                          const int16_t* coeffs_a,
+                                          const int16_t* coeffs_b, int shift,
+                                          int out_a[], int out_b[]) {
+  const __m128i* ca = reinterpret_cast<const __m128i*>(coeffs_a);
+  const __m128i* cb = reinterpret_cast<const __m128i*>(coeffs_b);
+  const __m128i a0 = _mm_load_si128(ca), a1 = _mm_load_si128(ca + 1),
+                a2 = _mm_load_si128(ca + 2);
+  const __m128i b0 = _mm_load_si128(cb), b1 = _mm_load_si128(cb + 1),
+                b2 = _mm_load_si128(cb + 2);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+
+  int k = 0;
+  for (; k + 4 <= pairs; k += 4) {
+    const int16_t* x = window + 2 * k;
+    __m128i sum_a = _mm_hadd_epi32(
+        _mm_hadd_epi32(g722_dot_sse4(x, a0, a1, a2),
+                       g722_dot_sse4(x + 2, a0, a1, a2)),
+        _mm_hadd_epi32(g722_dot_sse4(x + 4, a0, a1, a2),
+                       g722_dot_sse4(x + 6, a0, a1, a2)));
+    __m128i sum_b = _mm_hadd_epi32(
+        _mm_hadd_epi32(g722_dot_sse4(x, b0, b1, b2),
+                       g722_dot_sse4(x + 2, b0, b1, b2)),
+        _mm_hadd_epi32(g722_dot_sse4(x + 4, b0, b1, b2),
+                       g722_dot_sse4(x + 6, b0, b1, b2)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out_a + k),
+                     _mm_sra_epi32(sum_a, count));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out_b + k),
+                     _mm_sra_epi32(sum_b, count));
+  }
+  return k;
+}
+
+G722_TARGET_SSE4 static void g722_tx_qmf_sse4(const int16_t* window, int pairs,
+                                              int xlow[], int xhigh[]) {
+  int k = g722_qmf_sse4(window, pairs, tx_low_coeffs, tx_high_coeffs, 14,
+                        xlow, xhigh);
+  g722_tx_qmf_c(window + 2 * k, pairs - k, xlow + k, xhigh + k);
+}
+
+G722_TARGET_SSE4 static void g722_rx_qmf_sse4(const int16_t* window, int pairs,
+                                              int xout1[], int xout2[]) {
+  int k = g722_qmf_sse4(window, pairs, rx_out1_coeffs, rx_out2_coeffs, 11,
+                        xout1, xout2);
+  g722_rx_qmf_c(window + 2 * k, pairs - k, xout1 + k, xout2 + k);
+}
+
+G722_TARGET_SSE4 static void g722_block4_x4_sse4(
+    g722_bands_x4_t* bands, const int32_t d_in[G722_BANDS_X4])
+    G722_BLOCK4_X4(sse4, bands, d_in)
+
+static const g722_kernels_t g722_kernels_sse4 = {
+    g722_tx_qmf_sse4, g722_rx_qmf_sse4, g722_block4_x4_sse4};
+#endif
+
+#if defined(G722_NEON_KERNELS)
+typedef int32x4_t neon_t;
+
+static inline neon_t neon_ld(const int32_t* p) { return vld1q_s32(p); }
+static inline void neon_st(int32_t* p, neon_t a) { vst1q_s32(p, a); }
+static inline neon_t neon_dup(int32_t c) { return vdupq_n_s32(c); }
+static inline neon_t neon_add(neon_t a, neon_t b) { return vaddq_s32(a, b); }
+static inline neon_t neon_sub(neon_t a, neon_t b) { return vsubq_s32(a, b); }
+static inline neon_t neon_neg(neon_t a) { return vnegq_s32(a); }
+static inline neon_t neon_min(neon_t a, neon_t b) { return vminq_s32(a, b); }
+static inline neon_t neon_max(neon_t a, neon_t b) { return vmaxq_s32(a, b); }
+static inline neon_t neon_sat16(neon_t a) {
+  return vminq_s32(vmaxq_s32(a, vdupq_n_s32(-32768)), vdupq_n_s32(32767));
+}
+static inline neon_t neon_shl2(neon_t a) { return vshlq_n_s32(a, 2); }
+static inline neon_t neon_sr7(neon_t a) { return vshrq_n_s32(a, 7); }
+static inline neon_t neon_sr15(neon_t a) { return vshrq_n_s32(a, 15); }
+static inline neon_t neon_mul_sr15(neon_t a, neon_t b) {
+  return vshrq_n_s32(vmulq_s32(a, b), 15);
+}
+static inline neon_t neon_sel_eq(neon_t a, neon_t b, neon_t x, neon_t y) {
+  return vbslq_s32(vceqq_s32(a, b), x, y);
+}
+
+// Computes the dot products of the |pairs| windows with |coeffs_a| and
+// |coeffs_b|, shifted right by |shift|.
+static void g722_qmf_neon(const int16_t* window, int pairs,
+                          const int16_t* coeffs_a, const int16_t* coeffs_b,
+                          int shift, int out_a[], int out_b[]) {
+  int16x4_t ca[G722_QMF_TAPS / 4];
+  int16x4_t cb[G722_QMF_TAPS / 4];
+  for (int i = 0; i < G722_QMF_TAPS / 4; i++) {
+    ca[i] = vld1_s16(coeffs_a + 4 * i);
+    cb[i] = vld1_s16(coeffs_b + 4 * i);
+  }
+  const int32x2_t count = vdup_n_s32(-shift);
+
+  for (int k = 0; k < pairs; k++) {
+    const int16_t* x = window + 2 * k;
+    int16x4_t samples = vld1_s16(x);
+    int32x4_t sum_a = vmull_s16(samples, ca[0]);
+    int32x4_t sum_b = vmull_s16(samples, cb[0]);
+    for (int i = 1; i < G722_QMF_TAPS / 4; i++) {
+      samples = vld1_s16(x + 4 * i);
+      sum_a = vmlal_s16(sum_a, samples, ca[i]);
+      sum_b = vmlal_s16(sum_b, samples, cb[i]);
+    }
+    // Lane 0 is the first output, lane 1 the second one
+    int32x2_t sums =
+        vshl_s32(vpadd_s32(vadd_s32(vget_low_s32(sum_a), vget_high_s32(sum_a)),
+                           vadd_s32(vget_low_s32(sum_b), vget_high_s32(sum_b))),
+                 count);
+    out_a[k] = vget_lane_s32(sums, 0);
+    out_b[k] = vget_lane_s32(sums, 1);
+  }
+}
+
+static void g722_tx_qmf_neon(const int16_t* window, int pairs, int xlow[],
+                             int xhigh[]) {
+  g722_qmf_neon(window, pairs, tx_low_coeffs, tx_high_coeffs, 14, xlow, xhigh);
+}
+
+static void g722_rx_qmf_neon(const int16_t* window, int pairs, int xout1[],
+                             int xout2[]) {
+  g722_qmf_neon(window, pairs, rx_out1_coeffs, rx_out2_coeffs, 11, xout1,
+                xout2);
+}
+
+static void g722_block4_x4_neon(g722_bands_x4_t* bands,
+                                const int32_t d_in[G722_BANDS_X4])
+    G722_BLOCK4_X4(neon, bands, d_in)
+
+static const g722_kernels_t g722_kernels_neon = {
+    g722_tx_qmf_neon, g722_rx_qmf_neon, g722_block4_x4_neon};
+#endif
+
+static const g722_kernels_t g722_kernels_c = {g722_tx_qmf_c, g722_rx_qmf_c,
+                                              g722_block4_x4_c};
+
+static const g722_kernels_t* g722_selected_kernels = NULL;
+static g722_impl_t g722_selected_impl = G722_IMPL_C;
+
+static const g722_kernels_t* g722_get_kernels(g722_impl_t impl) {
+  switch (impl) {
+    case G722_IMPL_C:
+      return &g722_kernels_c;
+#if defined(G722_X86_KERNELS)
+    case G722_IMPL_SSE4:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse4.1") ? &g722_kernels_sse4 : NULL;
+#endif
+#if defined(G722_NEON_KERNELS)
+    case G722_IMPL_NEON:
+      return &g722_kernels_neon;
+#endif
+    default:
+      return NULL;
+  }
+}
+
+const g722_kernels_t* g722_kernels(void) {
+  if (g722_selected_kernels == NULL) {
+    // Fastest first
+    static const g722_impl_t preferred[] = {G722_IMPL_NEON, G722_IMPL_SSE4,
+                                            G722_IMPL_C};
+    for (g722_impl_t impl : preferred) {
+      if (g722_set_impl(impl)) break;
+    }
+  }
+  return g722_selected_kernels;
+}
+
+void g722_bands_x4_load(g722_bands_x4_t* bands, int lane,
+                        const g722_band_t* band) {
+  bands->s[lane] = band->s;
+  bands->sp[lane] = band->sp;
+  bands->sz[lane] = band->sz;
+  for (int i = 0; i < 3; i++) {
+    bands->r[i][lane] = band->r[i];
+    bands->a[i][lane] = band->a[i];
+    bands->ap[i][lane] = band->ap[i];
+    bands->p[i][lane] = band->p[i];
+  }
+  for (int i = 0; i < 7; i++) {
+    bands->d[i][lane] = band->d[i];
+    bands->b[i][lane] = band->b[i];
+    bands->bp[i][lane] = band->bp[i];
+  }
+}
+
+void g722_bands_x4_store(const g722_bands_x4_t* bands, int lane,
+                         g722_band_t* band) {
+  band->s = bands->s[lane];
+  band->sp = bands->sp[lane];
+  band->sz = bands->sz[lane];
+  for (int i = 0; i < 3; i++) {
+    band->r[i] = bands->r[i][lane];
+    band->a[i] = bands->a[i][lane];
+    band->ap[i] = bands->ap[i][lane];
+    band->p[i] = bands->p[i][lane];
+  }
+  for (int i = 0; i < 7; i++) {
+    band->d[i] = bands->d[i][lane];
+    band->b[i] = bands->b[i][lane];
+    band->bp[i] = bands->bp[i][lane];
+  }
+}
+
+int g722_impl_supported(g722_impl_t impl) {
+  return g722_get_kernels(impl) != NULL;
+}
+
+int g722_set_impl(g722_impl_t impl) {
+  const g722_kernels_t* kernels = g722_get_kernels(impl);
+  if (kernels == NULL) return 0;
+  g722_selected_kernels = kernels;
+  g722_selected_impl = impl;
+  return 1;
+}
+
+g722_impl_t g722_get_impl(void) {
+  g722_kernels();
+  return g722_selected_impl;
+}
+
+const char* g722_impl_name(g722_impl_t impl) {
+  switch (impl) {
+    case G722_IMPL_C:
+      return "C";
+    case G722_IMPL_SSE4:
+      return "SSE4.1";
+    case G722_IMPL_NEON:
+      return "NEON";
+    default:
+      return "unknown";
+  }
+}
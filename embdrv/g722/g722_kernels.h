@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "g722_enc_dec.h"
+
+// Number of samples of signal history used by the QMFs, in addition to the
+// two new samples of each output.
+#define G722_QMF_HISTORY 22
+
+// Number of bands predicted together by |block4_x4|
+#define G722_BANDS_X4 4
+
+// Adaptive predictor state of four independent bands, one per lane, for the
+// stereo encoder and decoder: the low and high bands of the left channel, then
+// of the right channel. Only holds the fields used by block 4.
+typedef struct {
+  alignas(16) int32_t s[G722_BANDS_X4];
+  alignas(16) int32_t sp[G722_BANDS_X4];
+  alignas(16) int32_t sz[G722_BANDS_X4];
+  alignas(16) int32_t r[3][G722_BANDS_X4];
+  alignas(16) int32_t a[3][G722_BANDS_X4];
+  alignas(16) int32_t ap[3][G722_BANDS_X4];
+  alignas(16) int32_t p[3][G722_BANDS_X4];
+  alignas(16) int32_t d[7][G722_BANDS_X4];
+  alignas(16) int32_t b[7][G722_BANDS_X4];
+  alignas(16) int32_t bp[7][G722_BANDS_X4];
+} g722_bands_x4_t;
+
+typedef struct {
+  // Applies the transmit QMF to |pairs| consecutive pairs of samples.
+  // |window| holds G722_QMF_HISTORY samples of history followed by the
+  // 2 * |pairs| new samples. The low and high band of each pair are written to
+  // |xlow| and |xhigh|.
+  void (*tx_qmf)(const int16_t* window, int pairs, int xlow[], int xhigh[]);
+
+  // Applies the receive QMF to |pairs| consecutive pairs of band sums and
+  // differences in |window|, laid out as for |tx_qmf|. The two output samples
+  // of each pair are written to |xout1| and |xout2|, before saturation.
+  void (*rx_qmf)(const int16_t* window, int pairs, int xout1[], int xout2[]);
+
+  // Runs block 4 (reconstruction, pole and zero predictor adaptation and
+  // prediction) of the four bands of |bands| with the quantized differences
+  // |d|.
+  void (*block4_x4)(g722_bands_x4_t* bands, const int32_t d[G722_BANDS_X4]);
+} g722_kernels_t;
+
+// Returns the kernels of the selected implementation, see g722_set_impl().
+const g722_kernels_t* g722_kernels(void);
+
+// Copies the predictor state of |band| to lane |lane| of |bands|, and back.
+void g722_bands_x4_load(g722_bands_x4_t* bands, int lane,
+                        const g722_band_t* band);
+void g722_bands_x4_store(const g722_bands_x4_t* bands, int lane,
+                         g722_band_t* band);
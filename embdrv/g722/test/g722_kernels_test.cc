@@ -0,0 +1,207 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#include "g722_enc_dec.h"
+
+namespace {
+
+constexpr size_t kNumSamples = 16000;
+
+// Returns pseudo random PCM with full scale bursts, different for each
+// |channel|.
+std::vector<int16_t> MakePcm(size_t num_samples, uint32_t channel) {
+  std::vector<int16_t> pcm(num_samples);
+  uint32_t seed = 1 + channel;
+  for (size_t i = 0; i < num_samples; i++) {
+    seed = seed * 1103515245 + 12345;
+    pcm[i] = static_cast<int16_t>(seed >> 16);
+    if ((i / 500) % 5 == channel) pcm[i] = (i & 1) ? INT16_MAX : INT16_MIN;
+  }
+  return pcm;
+}
+
+std::vector<int16_t> Interleave(const std::vector<int16_t>& left,
+                                const std::vector<int16_t>& right) {
+  std::vector<int16_t> stereo;
+  for (size_t i = 0; i < left.size(); i++) {
+    stereo.push_back(left[i]);
+    stereo.push_back(right[i]);
+  }
+  return stereo;
+}
+
+// Encodes |pcm|, |chunk| samples per call.
+std::vector<uint8_t> Encode(const std::vector<int16_t>& pcm, size_t chunk) {
+  g722_encode_state_t* state = g722_encode_init(nullptr, 64000, G722_PACKED);
+  std::vector<uint8_t> encoded(pcm.size());
+  size_t encoded_size = 0;
+  for (size_t i = 0; i < pcm.size(); i += chunk) {
+    int len = static_cast<int>(std::min(chunk, pcm.size() - i));
+    encoded_size += g722_encode(state, encoded.data() + encoded_size,
+                                pcm.data() + i, len);
+  }
+  g722_encode_release(state);
+  encoded.resize(encoded_size);
+  return encoded;
+}
+
+// Decodes |encoded|, |chunk| bytes per call.
+std::vector<int16_t> Decode(const std::vector<uint8_t>& encoded, size_t chunk) {
+  g722_decode_state_t* state = g722_decode_init(nullptr, 64000, G722_PACKED);
+  std::vector<int16_t> pcm(2 * encoded.size());
+  size_t pcm_size = 0;
+  for (size_t i = 0; i < encoded.size(); i += chunk) {
+    int len = static_cast<int>(std::min(chunk, encoded.size() - i));
+    pcm_size += g722_decode(state, pcm.data() + pcm_size, encoded.data() + i,
+                            len, 0xffff);
+  }
+  g722_decode_release(state);
+  pcm.resize(pcm_size);
+  return pcm;
+}
+
+class G722KernelsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { default_impl_ = g722_get_impl(); }
+  void TearDown() override { g722_set_impl(default_impl_); }
+
+  // Returns the supported implementations
+  std::vector<g722_impl_t> Impls() {
+    std::vector<g722_impl_t> impls;
+    for (int i = G722_IMPL_C; i < G722_IMPL_MAX; i++) {
+      auto impl = static_cast<g722_impl_t>(i);
+      if (g722_impl_supported(impl)) impls.push_back(impl);
+    }
+    return impls;
+  }
+
+  g722_impl_t default_impl_;
+};
+
+TEST_F(G722KernelsTest, c_is_always_supported) {
+  EXPECT_TRUE(g722_impl_supported(G722_IMPL_C));
+  EXPECT_FALSE(g722_impl_supported(G722_IMPL_MAX));
+  EXPECT_FALSE(g722_set_impl(G722_IMPL_MAX));
+  EXPECT_EQ(default_impl_, g722_get_impl());
+}
+
+TEST_F(G722KernelsTest, chunking_does_not_change_output) {
+  ASSERT_TRUE(g722_set_impl(G722_IMPL_C));
+  std::vector<int16_t> pcm = MakePcm(kNumSamples, 0);
+  std::vector<uint8_t> encoded = Encode(pcm, kNumSamples);
+  EXPECT_EQ(kNumSamples / 2, encoded.size());
+  std::vector<int16_t> decoded = Decode(encoded, encoded.size());
+  EXPECT_EQ(kNumSamples, decoded.size());
+  for (size_t chunk : {2, 6, 160, 162, 320, 480}) {
+    EXPECT_EQ(encoded, Encode(pcm, chunk)) << "chunk " << chunk;
+    EXPECT_EQ(decoded, Decode(encoded, chunk / 2)) << "chunk " << chunk;
+  }
+}
+
+TEST_F(G722KernelsTest, bit_exact_with_c) {
+  std::vector<int16_t> pcm = MakePcm(kNumSamples, 0);
+  for (size_t chunk : std::vector<size_t>{2, 14, 160, 320, kNumSamples}) {
+    ASSERT_TRUE(g722_set_impl(G722_IMPL_C));
+    std::vector<uint8_t> encoded = Encode(pcm, chunk);
+    std::vector<int16_t> decoded = Decode(encoded, chunk / 2);
+    for (g722_impl_t impl : Impls()) {
+      ASSERT_TRUE(g722_set_impl(impl));
+      EXPECT_EQ(encoded, Encode(pcm, chunk))
+          << g722_impl_name(impl) << " chunk " << chunk;
+      EXPECT_EQ(decoded, Decode(encoded, chunk / 2))
+          << g722_impl_name(impl) << " chunk " << chunk;
+    }
+  }
+}
+
+TEST_F(G722KernelsTest, stereo_matches_mono) {
+  std::vector<int16_t> left = MakePcm(kNumSamples, 0);
+  std::vector<int16_t> right = MakePcm(kNumSamples, 2);
+  std::vector<int16_t> stereo = Interleave(left, right);
+
+  ASSERT_TRUE(g722_set_impl(G722_IMPL_C));
+  std::vector<uint8_t> left_encoded = Encode(left, kNumSamples);
+  std::vector<uint8_t> right_encoded = Encode(right, kNumSamples);
+  std::vector<int16_t> decoded = Interleave(Decode(left_encoded, kNumSamples),
+                                            Decode(right_encoded, kNumSamples));
+
+  for (g722_impl_t impl : Impls()) {
+    ASSERT_TRUE(g722_set_impl(impl));
+    for (size_t chunk : std::vector<size_t>{1, 2, 7, 160, 320, kNumSamples}) {
+      g722_encode_state_t* encoders[2];
+      g722_decode_state_t* decoders[2];
+      for (int c = 0; c < 2; c++) {
+        encoders[c] = g722_encode_init(nullptr, 64000, G722_PACKED);
+        decoders[c] = g722_decode_init(nullptr, 64000, G722_PACKED);
+      }
+
+      // Odd chunks pad the last frame of each call, only use one
+      std::vector<uint8_t> encoded[2];
+      for (size_t i = 0; i < kNumSamples; i += chunk) {
+        size_t len = std::min(chunk, kNumSamples - i);
+        uint8_t data[2][kNumSamples / 2 + 1];
+        int bytes = g722_encode_stereo(encoders[0], encoders[1], data[0],
+                                       data[1], stereo.data() + 2 * i,
+                                       static_cast<int>(len));
+        EXPECT_EQ(static_cast<int>((len + 1) / 2), bytes);
+        for (int c = 0; c < 2; c++)
+          encoded[c].insert(encoded[c].end(), data[c], data[c] + bytes);
+        if (len & 1) break;
+      }
+      if (chunk & 1) {
+        // Only the pairs before the padded frame match the mono encoding
+        size_t pairs = chunk / 2;
+        ASSERT_EQ(pairs + 1, encoded[0].size()) << g722_impl_name(impl);
+        EXPECT_TRUE(std::equal(encoded[0].begin(), encoded[0].begin() + pairs,
+                               left_encoded.begin()))
+            << g722_impl_name(impl);
+        EXPECT_TRUE(std::equal(encoded[1].begin(), encoded[1].begin() + pairs,
+                               right_encoded.begin()))
+            << g722_impl_name(impl);
+      } else {
+        EXPECT_EQ(left_encoded, encoded[0])
+            << g722_impl_name(impl) << " chunk " << chunk;
+        EXPECT_EQ(right_encoded, encoded[1])
+            << g722_impl_name(impl) << " chunk " << chunk;
+
+        std::vector<int16_t> stereo_decoded(2 * kNumSamples);
+        size_t decoded_size = 0;
+        for (size_t i = 0; i < left_encoded.size(); i += chunk / 2) {
+          int len = std::min(chunk / 2, left_encoded.size() - i);
+          decoded_size += g722_decode_stereo(
+              decoders[0], decoders[1],
+              stereo_decoded.data() + 2 * decoded_size, left_encoded.data() + i,
+              right_encoded.data() + i, len, 0xffff);
+        }
+        EXPECT_EQ(decoded, stereo_decoded)
+            << g722_impl_name(impl) << " chunk " << chunk;
+        EXPECT_EQ(kNumSamples, decoded_size);
+      }
+
+      for (int c = 0; c < 2; c++) {
+        g722_encode_release(encoders[c]);
+        g722_decode_release(decoders[c]);
+      }
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+#include <vector>
+
+#include "embdrv/pcm_converter/pcm_converter.h"
+
+using ::benchmark::State;
+using bluetooth::audio::PcmConverter;
+using bluetooth::audio::PcmConverterImpl;
+using bluetooth::audio::PcmFormat;
+
+namespace {
+
+// Frames of the 20 ms read of an A2DP encoder at 48 kHz
+constexpr size_t kOutputFrames = 960;
+
+std::vector<uint8_t> MakePcm(size_t bytes) {
+  std::vector<uint8_t> pcm(bytes);
+  uint32_t seed = 1;
+  for (auto& byte : pcm) {
+    seed = seed * 1103515245 + 12345;
+    byte = static_cast<uint8_t>(seed >> 24);
+  }
+  return pcm;
+}
+
+bool SelectImpl(State& state) {
+  auto impl = static_cast<PcmConverterImpl>(state.range(0));
+  if (!bluetooth::audio::PcmConverterSetImpl(impl)) {
+    state.SkipWithError("implementation not supported");
+    return false;
+  }
+  state.SetLabel(bluetooth::audio::PcmConverterImplName(impl));
+  return true;
+}
+
+// Pulls kOutputFrames frames of |output| out of |input| per iteration, the
+// way the A2DP source feeds its encoder. Reports the number of output frames
+// per second.
+void Convert(State& state, const PcmFormat& input, const PcmFormat& output) {
+  PcmConverter converter;
+  if (!converter.Init(input, output)) {
+    state.SkipWithError("conversion not supported");
+    return;
+  }
+
+  // Enough input for any of the reads
+  std::vector<uint8_t> in =
+      MakePcm((kOutputFrames * input.sample_rate / output.sample_rate +
+               2 * PcmConverter::kTaps) *
+              input.FrameSize());
+  std::vector<uint8_t> out(kOutputFrames * output.FrameSize());
+  for (auto _ : state) {
+    size_t needed = converter.InputFramesNeeded(kOutputFrames);
+    benchmark::DoNotOptimize(
+        converter.Convert(in.data(), needed, out.data(), kOutputFrames));
+  }
+  state.SetItemsProcessed(state.iterations() * kOutputFrames);
+}
+
+}  // namespace
+
+// 44.1 kHz 16 bit stereo to 48 kHz, with the implementation given by range(0)
+static void BM_Resample44To48(State& state) {
+  if (!SelectImpl(state)) return;
+  Convert(state, {44100, 16, 2}, {48000, 16, 2});
+}
+
+// 48 kHz 16 bit stereo to 16 kHz mono, as for a hearing aid
+static void BM_Resample48To16Mono(State& state) {
+  if (!SelectImpl(state)) return;
+  Convert(state, {48000, 16, 2}, {16000, 16, 1});
+}
+
+// 48 kHz 16 bit stereo to 24 bit, without resampling
+static void BM_SampleSize16To24(State& state) {
+  if (!SelectImpl(state)) return;
+  Convert(state, {48000, 16, 2}, {48000, 24, 2});
+}
+
+static void ImplArguments(benchmark::internal::Benchmark* benchmark) {
+  for (int impl = 0; impl < static_cast<int>(PcmConverterImpl::kMax); impl++) {
+    benchmark->Arg(impl);
+  }
+}
+
+BENCHMARK(BM_Resample44To48)->Apply(ImplArguments);
+BENCHMARK(BM_Resample48To16Mono)->Apply(ImplArguments);
+BENCHMARK(BM_SampleSize16To24)->Arg(static_cast<int>(PcmConverterImpl::kC));
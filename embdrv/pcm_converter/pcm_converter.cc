@@ -0,0 +1,404 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The output sample of phase p is at p / up_ input samples after the middle
+// of its window. Its coefficients are the windowed sinc sampled at that
+// fraction, so each phase is a plain kTaps float dot product over the input
+// buffer of the channel. The SIMD filters only change how that dot product
+// is computed.
+
+#include "pcm_converter.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PCM_CONVERTER_X86_KERNELS
+#include <immintrin.h>
+#define PCM_CONVERTER_TARGET_SSE __attribute__((target("sse")))
+#define PCM_CONVERTER_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+// NEON is a build time option on ARMv7 and always present on ARMv8
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PCM_CONVERTER_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+namespace bluetooth {
+namespace audio {
+
+namespace {
+
+// Largest number of phases of the filter, after reduction of the sample rate
+// ratio. 44.1 kHz to 96 kHz needs 320.
+constexpr uint32_t kMaxPhases = 512;
+
+// Pass band edge, relative to the lower of the two Nyquist frequencies
+constexpr double kPassBand = 0.90;
+
+// Kaiser window shape, about 70 dB of stop band attenuation
+constexpr double kKaiserBeta = 7.0;
+
+using DotFn = float (*)(const float* x, const float* c, size_t n);
+
+float DotC(const float* x, const float* c, size_t n) {
+  float sum = 0;
+  for (size_t i = 0; i < n; i++) sum += x[i] * c[i];
+  return sum;
+}
+
+#if defined(PCM_CONVERTER_X86_KERNELS)
+PCM_CONVERTER_TARGET_SSE float DotSse(const float* x, const float* c,
+                                      size_t n) {
+  __m128 sum0 = _mm_setzero_ps();
+  __m128 sum1 = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(x + i),
+                                       _mm_loadu_ps(c + i)));
+    sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(x + i + 4),
+                                       _mm_loadu_ps(c + i + 4)));
+  }
+  sum0 = _mm_add_ps(sum0, sum1);
+  sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+  sum0 = _mm_add_ss(sum0, _mm_shuffle_ps(sum0, sum0, 1));
+  float sum = _mm_cvtss_f32(sum0);
+  for (; i < n; i++) sum += x[i] * c[i];
+  return sum;
+}
+
+PCM_CONVERTER_TARGET_AVX2 float DotAvx2(const float* x, const float* c,
+                                        size_t n) {
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(c + i),
+                           sum0);
+    sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8),
+                           _mm256_loadu_ps(c + i + 8), sum1);
+  }
+  sum0 = _mm256_add_ps(sum0, sum1);
+  __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum0),
+                           _mm256_extractf128_ps(sum0, 1));
+  sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+  float sum = _mm_cvtss_f32(sum4);
+  for (; i < n; i++) sum += x[i] * c[i];
+  return sum;
+}
+#endif
+
+#if defined(PCM_CONVERTER_NEON_KERNELS)
+float DotNeon(const float* x, const float* c, size_t n) {
+  float32x4_t sum0 = vdupq_n_f32(0);
+  float32x4_t sum1 = vdupq_n_f32(0);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    sum0 = vmlaq_f32(sum0, vld1q_f32(x + i), vld1q_f32(c + i));
+    sum1 = vmlaq_f32(sum1, vld1q_f32(x + i + 4), vld1q_f32(c + i + 4));
+  }
+  sum0 = vaddq_f32(sum0, sum1);
+  float32x2_t sum2 = vadd_f32(vget_low_f32(sum0), vget_high_f32(sum0));
+  float sum = vget_lane_f32(vpadd_f32(sum2, sum2), 0);
+  for (; i < n; i++) sum += x[i] * c[i];
+  return sum;
+}
+#endif
+
+DotFn GetDot(PcmConverterImpl impl) {
+  switch (impl) {
+    case PcmConverterImpl::kC:
+      return DotC;
+#if defined(PCM_CONVERTER_X86_KERNELS)
+    case PcmConverterImpl::kSse:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse") ? DotSse : nullptr;
+    case PcmConverterImpl::kAvx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+                 ? DotAvx2
+                 : nullptr;
+#endif
+#if defined(PCM_CONVERTER_NEON_KERNELS)
+    case PcmConverterImpl::kNeon:
+      return DotNeon;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+DotFn selected_dot = nullptr;
+
+DotFn Dot() {
+  if (selected_dot == nullptr) {
+    // Fastest first
+    for (PcmConverterImpl impl :
+         {PcmConverterImpl::kNeon, PcmConverterImpl::kAvx2,
+          PcmConverterImpl::kSse, PcmConverterImpl::kC}) {
+      if (PcmConverterSetImpl(impl)) break;
+    }
+  }
+  return selected_dot;
+}
+
+bool FormatSupported(const PcmFormat& format) {
+  return format.sample_rate > 0 &&
+         (format.bits_per_sample == 16 || format.bits_per_sample == 24 ||
+          format.bits_per_sample == 32) &&
+         (format.channel_count == 1 || format.channel_count == 2);
+}
+
+float Load(const uint8_t* p, uint8_t bits_per_sample) {
+  switch (bits_per_sample) {
+    case 16: {
+      int16_t sample;
+      memcpy(&sample, p, sizeof(sample));
+      return sample * (1.0f / 32768);
+    }
+    case 24: {
+      int32_t sample = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 |
+                                 (uint32_t)p[2] << 24) >>
+                       8;
+      return sample * (1.0f / 8388608);
+    }
+    default: {
+      int32_t sample;
+      memcpy(&sample, p, sizeof(sample));
+      return sample * (1.0f / 2147483648.0f);
+    }
+  }
+}
+
+void Store(float value, uint8_t bits_per_sample, uint8_t* p) {
+  switch (bits_per_sample) {
+    case 16: {
+      int16_t sample = std::min(std::max(lrintf(value * 32768), -32768L),
+                                32767L);
+      memcpy(p, &sample, sizeof(sample));
+      break;
+    }
+    case 24: {
+      int32_t sample = std::min(std::max(lrintf(value * 8388608), -8388608L),
+                                8388607L);
+      p[0] = sample;
+      p[1] = sample >> 8;
+      p[2] = sample >> 16;
+      break;
+    }
+    default: {
+      // Clipped as a double, the float closest to INT32_MAX is 2^31
+      double scaled = std::min(std::max(value * 2147483648.0, -2147483648.0),
+                               2147483647.0);
+      int32_t sample = lrint(scaled);
+      memcpy(p, &sample, sizeof(sample));
+      break;
+    }
+  }
+}
+
+// Zeroth order modified Bessel function of the first kind
+double BesselI0(double x) {
+  double sum = 1;
+  double term = 1;
+  for (int k = 1; k < 32; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+    if (term < sum * 1e-12) break;
+  }
+  return sum;
+}
+
+}  // namespace
+
+bool PcmConverterImplSupported(PcmConverterImpl impl) {
+  return GetDot(impl) != nullptr;
+}
+
+bool PcmConverterSetImpl(PcmConverterImpl impl) {
+  DotFn dot = GetDot(impl);
+  if (dot == nullptr) return false;
+  selected_dot = dot;
+  return true;
+}
+
+const char* PcmConverterImplName(PcmConverterImpl impl) {
+  switch (impl) {
+    case PcmConverterImpl::kC:
+      return "C";
+    case PcmConverterImpl::kSse:
+      return "SSE";
+    case PcmConverterImpl::kAvx2:
+      return "AVX2";
+    case PcmConverterImpl::kNeon:
+      return "NEON";
+    default:
+      return "unknown";
+  }
+}
+
+PcmConverter::PcmConverter()
+    : input_{},
+      output_{},
+      pass_through_(true),
+      up_(1),
+      down_(1),
+      taps_(1),
+      coeffs_(1, 1.0f),
+      buffer_frames_(0),
+      position_(0),
+      phase_(0) {}
+
+bool PcmConverter::Init(const PcmFormat& input, const PcmFormat& output) {
+  if (!FormatSupported(input) || !FormatSupported(output)) return false;
+
+  uint32_t gcd = std::gcd(input.sample_rate, output.sample_rate);
+  uint32_t up = output.sample_rate / gcd;
+  if (up > kMaxPhases) return false;
+
+  input_ = input;
+  output_ = output;
+  pass_through_ = input == output;
+  up_ = up;
+  down_ = input.sample_rate / gcd;
+  DesignFilter();
+  Reset();
+  return true;
+}
+
+void PcmConverter::DesignFilter() {
+  if (up_ == 1 && down_ == 1) {
+    taps_ = 1;
+    coeffs_.assign(1, 1.0f);
+    return;
+  }
+
+  taps_ = kTaps;
+  coeffs_.resize(up_ * taps_);
+
+  // Cut off, in cycles per input sample
+  double cutoff = 0.5 * kPassBand * std::min<double>(1, (double)up_ / down_);
+  double half_width = taps_ / 2.0;
+  double i0_beta = BesselI0(kKaiserBeta);
+
+  for (uint32_t phase = 0; phase < up_; phase++) {
+    float* c = &coeffs_[phase * taps_];
+    // Position of the output sample in the window
+    double center = half_width - 1 + (double)phase / up_;
+    double sum = 0;
+    for (size_t j = 0; j < taps_; j++) {
+      double t = j - center;
+      double x = 2 * cutoff * t;
+      double sinc = (t == 0) ? 1 : sin(M_PI * x) / (M_PI * x);
+      double r = t / half_width;
+      double window = (fabs(r) >= 1)
+                          ? 0
+                          : BesselI0(kKaiserBeta * sqrt(1 - r * r)) / i0_beta;
+      c[j] = 2 * cutoff * sinc * window;
+      sum += c[j];
+    }
+    // Unity gain at DC for every phase
+    for (size_t j = 0; j < taps_; j++) c[j] /= sum;
+  }
+}
+
+void PcmConverter::Reset() {
+  // The first output sample is in the middle of the first window
+  size_t history = taps_ / 2 - (taps_ > 1 ? 1 : 0);
+  for (auto& buffer : buffer_) buffer.assign(history, 0);
+  buffer_frames_ = history;
+  position_ = 0;
+  phase_ = 0;
+}
+
+size_t PcmConverter::InputFramesNeeded(size_t output_frames) const {
+  if (output_frames == 0) return 0;
+  size_t last = position_ + ((uint64_t)phase_ +
+                             (uint64_t)(output_frames - 1) * down_) / up_;
+  size_t end = last + taps_;
+  return end > buffer_frames_ ? end - buffer_frames_ : 0;
+}
+
+void PcmConverter::Append(const uint8_t* input, size_t input_frames) {
+  // The samples before the window of the next output are not needed anymore
+  if (position_ > 0) {
+    for (uint8_t ch = 0; ch < output_.channel_count; ch++) {
+      std::copy(buffer_[ch].begin() + position_,
+                buffer_[ch].begin() + buffer_frames_, buffer_[ch].begin());
+    }
+    buffer_frames_ -= position_;
+    position_ = 0;
+  }
+
+  for (uint8_t ch = 0; ch < output_.channel_count; ch++) {
+    buffer_[ch].resize(buffer_frames_ + input_frames);
+  }
+
+  size_t sample_size = input_.bits_per_sample / 8;
+  size_t frame_size = input_.FrameSize();
+  float* left = buffer_[0].data() + buffer_frames_;
+  float* right = (output_.channel_count == 2)
+                     ? buffer_[1].data() + buffer_frames_
+                     : nullptr;
+  for (size_t i = 0; i < input_frames; i++) {
+    const uint8_t* p = input + i * frame_size;
+    float l = Load(p, input_.bits_per_sample);
+    float r = (input_.channel_count == 2)
+                  ? Load(p + sample_size, input_.bits_per_sample)
+                  : l;
+    if (output_.channel_count == 2) {
+      left[i] = l;
+      right[i] = r;
+    } else {
+      left[i] = 0.5f * (l + r);
+    }
+  }
+  buffer_frames_ += input_frames;
+}
+
+size_t PcmConverter::Convert(const uint8_t* input, size_t input_frames,
+                             uint8_t* output, size_t output_frames) {
+  if (input_frames > 0) Append(input, input_frames);
+
+  DotFn dot = Dot();
+  size_t sample_size = output_.bits_per_sample / 8;
+  size_t frame_size = output_.FrameSize();
+  size_t produced = 0;
+
+  while (produced < output_frames && position_ + taps_ <= buffer_frames_) {
+    const float* c = &coeffs_[phase_ * taps_];
+    uint8_t* p = output + produced * frame_size;
+    for (uint8_t ch = 0; ch < output_.channel_count; ch++) {
+      const float* x = buffer_[ch].data() + position_;
+      float value = (taps_ == 1) ? x[0] : dot(x, c, taps_);
+      Store(value, output_.bits_per_sample, p + ch * sample_size);
+    }
+    produced++;
+
+    phase_ += down_;
+    position_ += phase_ / up_;
+    phase_ %= up_;
+  }
+
+  return produced;
+}
+
+}  // namespace audio
+}  // namespace bluetooth
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace bluetooth {
+namespace audio {
+
+// Interleaved PCM. 24 bit samples are packed on 3 bytes, like
+// AUDIO_FORMAT_PCM_24_BIT_PACKED.
+struct PcmFormat {
+  uint32_t sample_rate;
+  uint8_t bits_per_sample;  // 16, 24 or 32
+  uint8_t channel_count;    // 1 or 2
+
+  size_t FrameSize() const { return channel_count * (bits_per_sample / 8); }
+
+  bool operator==(const PcmFormat& other) const {
+    return sample_rate == other.sample_rate &&
+           bits_per_sample == other.bits_per_sample &&
+           channel_count == other.channel_count;
+  }
+  bool operator!=(const PcmFormat& other) const { return !(*this == other); }
+};
+
+// Implementations of the resampling filter. They give the same output up to
+// the rounding of the float sums.
+enum class PcmConverterImpl { kC, kSse, kAvx2, kNeon, kMax };
+
+// Returns true if |impl| can run on this CPU.
+bool PcmConverterImplSupported(PcmConverterImpl impl);
+
+// Selects the filter used by all the converters. By default the fastest
+// supported one is used. Returns false and keeps the current one if |impl|
+// is not supported.
+bool PcmConverterSetImpl(PcmConverterImpl impl);
+
+const char* PcmConverterImplName(PcmConverterImpl impl);
+
+// Converts a PCM stream to another sample rate, sample size and channel
+// count, for the codecs that need their own format.
+//
+// The sample rate is changed with a polyphase windowed sinc filter, which
+// keeps the input it has not used yet and its history from one call to the
+// next. The other conversions are done sample per sample. All the
+// processing is done on floats, and output samples are rounded and clipped.
+class PcmConverter {
+ public:
+  // Filter taps per phase
+  static constexpr size_t kTaps = 32;
+
+  PcmConverter();
+
+  // Sets the formats up and resets the stream. Returns false if one of them
+  // is not supported, or if the ratio of the sample rates can't be reduced
+  // enough for the filter.
+  bool Init(const PcmFormat& input, const PcmFormat& output);
+
+  // Drops the buffered input and the filter history, for a new stream.
+  void Reset();
+
+  // True when the input is copied as is
+  bool IsPassThrough() const { return pass_through_; }
+
+  const PcmFormat& input() const { return input_; }
+  const PcmFormat& output() const { return output_; }
+
+  // Returns the number of input frames that Convert() needs to produce
+  // |output_frames| output frames now, taking the buffered input into
+  // account.
+  size_t InputFramesNeeded(size_t output_frames) const;
+
+  // Converts the |input_frames| frames of |input| and the buffered input
+  // into up to |output_frames| frames written to |output|. The input not used
+  // is buffered. Returns the number of frames written.
+  size_t Convert(const uint8_t* input, size_t input_frames, uint8_t* output,
+                 size_t output_frames);
+
+ private:
+  void DesignFilter();
+  void Append(const uint8_t* input, size_t input_frames);
+
+  PcmFormat input_;
+  PcmFormat output_;
+  bool pass_through_;
+
+  // Output sample |k| is at input position k * down_ / up_
+  uint32_t up_;
+  uint32_t down_;
+  size_t taps_;
+
+  // |taps_| coefficients per phase, in the order of the input samples
+  std::vector<float> coeffs_;
+
+  // Input of each output channel: history and the pending frames. The
+  // filter window of the next output sample starts at |position_| and uses
+  // phase |phase_|.
+  std::vector<float> buffer_[2];
+  size_t buffer_frames_;
+  size_t position_;
+  uint32_t phase_;
+};
+
+}  // namespace audio
+}  // namespace bluetooth
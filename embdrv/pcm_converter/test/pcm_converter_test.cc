@@ -0,0 +1,234 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "embdrv/pcm_converter/pcm_converter.h"
+
+using bluetooth::audio::PcmConverter;
+using bluetooth::audio::PcmConverterImpl;
+using bluetooth::audio::PcmFormat;
+
+namespace {
+
+constexpr PcmFormat k44k16Stereo = {44100, 16, 2};
+constexpr PcmFormat k48k16Stereo = {48000, 16, 2};
+
+// Returns |frames| frames of a |freq| Hz sine at |rate|, on all the
+// |channels|, as 16 bit PCM.
+std::vector<int16_t> MakeSine(size_t frames, uint32_t rate, double freq,
+                              uint8_t channels) {
+  std::vector<int16_t> pcm;
+  for (size_t i = 0; i < frames; i++) {
+    double value = 16384 * sin(2 * M_PI * freq * i / rate);
+    for (uint8_t c = 0; c < channels; c++) pcm.push_back(lrint(value));
+  }
+  return pcm;
+}
+
+std::vector<int16_t> MakeNoise(size_t samples) {
+  std::vector<int16_t> pcm(samples);
+  uint32_t seed = 1;
+  for (auto& sample : pcm) {
+    seed = seed * 1103515245 + 12345;
+    sample = static_cast<int16_t>(seed >> 16);
+  }
+  return pcm;
+}
+
+// Converts |input| in chunks of |chunk| input frames, and returns all the
+// output that could be produced.
+template <typename Out, typename In>
+std::vector<Out> ConvertAll(PcmConverter& converter, const std::vector<In>& in,
+                            size_t chunk) {
+  size_t in_frame_size = converter.input().FrameSize();
+  size_t out_frame_size = converter.output().FrameSize();
+  size_t in_frames = in.size() * sizeof(In) / in_frame_size;
+  std::vector<uint8_t> out;
+  for (size_t i = 0; i < in_frames; i += chunk) {
+    size_t frames = std::min(chunk, in_frames - i);
+    size_t offset = out.size();
+    // Upper bound of the output of |frames| input frames
+    size_t max_frames = 2 + frames * converter.output().sample_rate /
+                                converter.input().sample_rate;
+    out.resize(offset + max_frames * out_frame_size);
+    size_t produced = converter.Convert(
+        reinterpret_cast<const uint8_t*>(in.data()) + i * in_frame_size,
+        frames, out.data() + offset, max_frames + 1);
+    out.resize(offset + produced * out_frame_size);
+  }
+  std::vector<Out> result(out.size() / sizeof(Out));
+  memcpy(result.data(), out.data(), result.size() * sizeof(Out));
+  return result;
+}
+
+}  // namespace
+
+TEST(PcmConverterTest, test_same_format_is_copied) {
+  PcmConverter converter;
+  ASSERT_TRUE(converter.Init(k48k16Stereo, k48k16Stereo));
+  EXPECT_TRUE(converter.IsPassThrough());
+
+  std::vector<int16_t> in = MakeNoise(2 * 480);
+  EXPECT_EQ(in, ConvertAll<int16_t>(converter, in, 100));
+}
+
+TEST(PcmConverterTest, test_sample_size) {
+  PcmConverter to_24;
+  PcmConverter to_16;
+  ASSERT_TRUE(to_24.Init(k48k16Stereo, {48000, 24, 2}));
+  ASSERT_TRUE(to_16.Init({48000, 24, 2}, k48k16Stereo));
+  EXPECT_FALSE(to_24.IsPassThrough());
+
+  std::vector<int16_t> in = MakeNoise(2 * 480);
+  std::vector<uint8_t> packed = ConvertAll<uint8_t>(to_24, in, 480);
+  ASSERT_EQ(in.size() * 3, packed.size());
+  EXPECT_EQ(in, ConvertAll<int16_t>(to_16, packed, 480));
+
+  PcmConverter to_32;
+  ASSERT_TRUE(to_32.Init(k48k16Stereo, {48000, 32, 2}));
+  std::vector<int32_t> wide = ConvertAll<int32_t>(to_32, in, 480);
+  ASSERT_EQ(in.size(), wide.size());
+  for (size_t i = 0; i < in.size(); i++) EXPECT_EQ(in[i] * 65536, wide[i]);
+}
+
+TEST(PcmConverterTest, test_channel_count) {
+  PcmConverter to_stereo;
+  ASSERT_TRUE(to_stereo.Init({48000, 16, 1}, k48k16Stereo));
+  std::vector<int16_t> mono = {1, -2, 300, -32768};
+  EXPECT_EQ(std::vector<int16_t>({1, 1, -2, -2, 300, 300, -32768, -32768}),
+            ConvertAll<int16_t>(to_stereo, mono, 4));
+
+  PcmConverter to_mono;
+  ASSERT_TRUE(to_mono.Init(k48k16Stereo, {48000, 16, 1}));
+  std::vector<int16_t> stereo = {100, 300, -32768, -32768, 32767, 32767};
+  EXPECT_EQ(std::vector<int16_t>({200, -32768, 32767}),
+            ConvertAll<int16_t>(to_mono, stereo, 3));
+}
+
+TEST(PcmConverterTest, test_unsupported_formats) {
+  PcmConverter converter;
+  EXPECT_FALSE(converter.Init({48000, 8, 2}, k48k16Stereo));
+  EXPECT_FALSE(converter.Init(k48k16Stereo, {48000, 16, 6}));
+  EXPECT_FALSE(converter.Init({0, 16, 2}, k48k16Stereo));
+  // 1009 and 48000 are coprime
+  EXPECT_FALSE(converter.Init({1009, 16, 2}, k48k16Stereo));
+}
+
+// The output of a sine is the same sine at the output rate, aligned on the
+// input.
+TEST(PcmConverterTest, test_resampled_sine) {
+  for (auto rates : std::vector<std::pair<uint32_t, uint32_t>>{
+           {44100, 48000}, {48000, 44100}, {16000, 48000}, {48000, 16000}}) {
+    PcmConverter converter;
+    ASSERT_TRUE(converter.Init({rates.first, 16, 2}, {rates.second, 16, 2}));
+
+    double freq = 1000;
+    std::vector<int16_t> in = MakeSine(rates.first, rates.first, freq, 2);
+    std::vector<int16_t> out = ConvertAll<int16_t>(converter, in, 441);
+    ASSERT_GT(out.size(), 2 * (rates.second - 2 * PcmConverter::kTaps));
+
+    // The ends are filtered with the zeros around the input
+    std::vector<int16_t> expected = MakeSine(out.size() / 2, rates.second,
+                                             freq, 2);
+    double signal = 0;
+    double noise = 0;
+    for (size_t i = 2 * PcmConverter::kTaps; i < out.size(); i++) {
+      signal += (double)expected[i] * expected[i];
+      noise += (double)(out[i] - expected[i]) * (out[i] - expected[i]);
+    }
+    EXPECT_GT(10 * log10(signal / noise), 50)
+        << rates.first << " Hz to " << rates.second << " Hz";
+  }
+}
+
+// Frequencies that don't fit at the output rate are filtered out
+TEST(PcmConverterTest, test_aliasing) {
+  PcmConverter converter;
+  ASSERT_TRUE(converter.Init(k48k16Stereo, {16000, 16, 2}));
+
+  std::vector<int16_t> in = MakeSine(48000, 48000, 12000, 2);
+  std::vector<int16_t> out = ConvertAll<int16_t>(converter, in, 480);
+  int16_t peak = 0;
+  for (size_t i = 2 * PcmConverter::kTaps; i < out.size(); i++) {
+    peak = std::max<int16_t>(peak, std::abs(out[i]));
+  }
+  // 16384 in, at least 50 dB down
+  EXPECT_LT(peak, 52);
+}
+
+TEST(PcmConverterTest, test_chunk_size_does_not_matter) {
+  PcmConverter whole;
+  PcmConverter chunked;
+  ASSERT_TRUE(whole.Init(k44k16Stereo, k48k16Stereo));
+  ASSERT_TRUE(chunked.Init(k44k16Stereo, k48k16Stereo));
+
+  std::vector<int16_t> in = MakeNoise(2 * 4410);
+  EXPECT_EQ(ConvertAll<int16_t>(whole, in, 4410),
+            ConvertAll<int16_t>(chunked, in, 7));
+}
+
+// Reading what InputFramesNeeded() asks for gives the output wanted, like
+// the A2DP source reads for its encoder.
+TEST(PcmConverterTest, test_input_frames_needed) {
+  PcmConverter converter;
+  ASSERT_TRUE(converter.Init(k44k16Stereo, k48k16Stereo));
+
+  std::vector<int16_t> in = MakeNoise(2 * 44100);
+  size_t read = 0;
+  std::vector<int16_t> out(2 * 128);
+  for (int i = 0; i < 300; i++) {
+    size_t needed = converter.InputFramesNeeded(128);
+    ASSERT_LE(read + needed, in.size() / 2);
+    EXPECT_EQ(128u, converter.Convert(
+                        reinterpret_cast<const uint8_t*>(&in[2 * read]),
+                        needed, reinterpret_cast<uint8_t*>(out.data()), 128));
+    read += needed;
+    EXPECT_EQ(0u, converter.InputFramesNeeded(0));
+  }
+  // 300 * 128 frames at 48 kHz are 35280 frames at 44.1 kHz, plus the
+  // filter delay
+  EXPECT_NEAR(35280 + PcmConverter::kTaps / 2, read, 1);
+}
+
+TEST(PcmConverterTest, test_implementations_match) {
+  std::vector<int16_t> in = MakeNoise(2 * 4410);
+  ASSERT_TRUE(bluetooth::audio::PcmConverterSetImpl(PcmConverterImpl::kC));
+  PcmConverter reference_converter;
+  ASSERT_TRUE(reference_converter.Init(k44k16Stereo, k48k16Stereo));
+  std::vector<int16_t> reference =
+      ConvertAll<int16_t>(reference_converter, in, 441);
+
+  for (int i = 0; i < static_cast<int>(PcmConverterImpl::kMax); i++) {
+    auto impl = static_cast<PcmConverterImpl>(i);
+    if (!bluetooth::audio::PcmConverterSetImpl(impl)) continue;
+
+    PcmConverter converter;
+    ASSERT_TRUE(converter.Init(k44k16Stereo, k48k16Stereo));
+    std::vector<int16_t> out = ConvertAll<int16_t>(converter, in, 441);
+    ASSERT_EQ(reference.size(), out.size());
+    for (size_t j = 0; j < out.size(); j++) {
+      // Only the float rounding differs
+      ASSERT_NEAR(reference[j], out[j], 1)
+          << bluetooth::audio::PcmConverterImplName(impl) << " at " << j;
+    }
+  }
+}
@@ -79,6 +79,14 @@ Declarations of codec functions, data types, and macros.
 
 #define OI_SBC_SYNCWORD 0x9c
 #define OI_SBC_ENHANCED_SYNCWORD 0x9d
+#define OI_mSBC_SYNCWORD 0xad
+
+/* mSBC, the wide band speech codec of HFP, uses fixed parameters: 16 kHz mono,
+ * 15 blocks, 8 subbands, loudness allocation and a bitpool of 26. */
+#define OI_mSBC_BLOCKS 15
+#define OI_mSBC_BITPOOL 26
+#define OI_mSBC_FRAME_LEN 57
+#define OI_mSBC_SAMPLES_PER_FRAME 120
 
 /**@name Sampling frequencies */
 /**@{*/
@@ -238,6 +246,10 @@ typedef struct {
   uint8_t restrictSubbands;
   uint8_t enhancedEnabled;
   uint8_t bufferedBlocks;
+  /* Boolean, set by OI_CODEC_SBC_DecoderEnableSimd() */
+  uint8_t simdEnabled;
+  /* Boolean, set by OI_CODEC_mSBC_DecoderReset() */
+  uint8_t mSbcEnabled;
 } OI_CODEC_SBC_DECODER_CONTEXT;
 
 typedef struct {
@@ -275,6 +287,18 @@ OI_STATUS OI_CODEC_SBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                     uint8_t maxChannels, uint8_t pcmStride,
                                     OI_BOOL enhanced);
 
+/**
+ * This function resets the decoder for an mSBC stream. The decoder then only
+ * recognizes the mSBC syncword, and takes the frame parameters, which mSBC
+ * does not carry in its header, from the mSBC specification. The PCM output is
+ * mono with a stride of 1.
+ *
+ * @param context   Pointer to the decoder context structure to be reset.
+ */
+OI_STATUS OI_CODEC_mSBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                     uint32_t* decoderData,
+                                     uint32_t decoderDataBytes);
+
 /**
  * This function restricts the kind of SBC frames that the Decoder will
  * process.  Its use is optional.  If used, it must be called after
@@ -395,6 +419,61 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                    uint32_t* frameBytes, int16_t* pcmData,
                                    uint32_t* pcmBytes);
 
+/**
+ * Decode consecutive SBC frames, such as all the frames of an A2DP media
+ * packet, with the same semantics as successive calls to
+ * OI_CODEC_SBC_DecodeFrame(). Decoding stops at the first frame that fails
+ * to decode.
+ *
+ * @param context       Pointer to a decoder context structure. The same context
+ *                      must be used each time when decoding from the same
+ *                      stream.
+ *
+ * @param frameCount    Pointer to a uint8_t in/out parameter. On input, it
+ *                      should contain the number of frames to decode. On
+ *                      output, it will contain the number of frames decoded.
+ *
+ * @param frameData     Address of a pointer to the SBC data to decode. This
+ *                      value will be updated to point past the last frame
+ *                      decoded.
+ *
+ * @param frameBytes    Pointer to a uint32_t containing the number of available
+ *                      bytes of frame data. This value will be updated to
+ *                      reflect the number of bytes remaining.
+ *
+ * @param pcmData       Address of an array of int16_t pairs, which will be
+ *                      populated with the decoded audio data of all the
+ *                      frames. This address is not updated.
+ *
+ * @param pcmBytes      Pointer to a uint32_t in/out parameter. On input, it
+ *                      should contain the number of bytes available for pcm
+ *                      data. On output, it will contain the number of bytes
+ *                      written by the frames decoded.
+ *
+ * @return              OI_OK if all the frames were decoded, otherwise the
+ *                      status of the frame that failed to decode.
+ */
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    uint8_t* frameCount,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, int16_t* pcmData,
+                                    uint32_t* pcmBytes);
+
+/**
+ * Enable or disable the SIMD (SSE4.1 or NEON) implementation of the synthesis
+ * filterbank. It is enabled by OI_CODEC_SBC_DecoderReset() when supported by
+ * the CPU and produces the same output as the C implementation.
+ *
+ * @param context   Pointer to the decoder context structure.
+ *
+ * @param enable    If true, use the SIMD implementation when available.
+ *
+ * @return          OI_STATUS_NOT_IMPLEMENTED if enable is true and the SIMD
+ *                  implementation is not available, otherwise OI_OK.
+ */
+OI_STATUS OI_CODEC_SBC_DecoderEnableSimd(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                         OI_BOOL enable);
+
 /**
  * Calculate the number of SBC frames but don't decode. CRC's are not checked,
  * but the Sync word is found prior to count calculation.
@@ -127,6 +127,15 @@ typedef struct {
 
 #define DCT_SHIFT 15
 
+/* Constants of the 8-point AAN DCT, shared with the SIMD synthesis */
+#define AAN_C4_FIX (759250125) /* S1.30  759250125   0.707107*/
+
+#define AAN_C6_FIX (410903207) /* S1.30  410903207   0.382683*/
+
+#define AAN_Q0_FIX (581104888) /* S1.30  581104888   0.541196*/
+
+#define AAN_Q1_FIX (1402911301) /* S1.30 1402911301   1.306563*/
+
 #define DCTIII_4_SHIFT_IN 2
 #define DCTIII_4_SHIFT_OUT 15
 
@@ -184,6 +193,35 @@ PRIVATE void cosineModulateSynth4(SBC_BUFFER_T* RESTRICT out,
 PRIVATE void SynthWindow40_int32_int32_symmetry_with_sum(
     int16_t* pcm, SBC_BUFFER_T buffer[80], OI_UINT strideShift);
 
+PRIVATE void dct2_8(SBC_BUFFER_T* RESTRICT out, int32_t const* RESTRICT in);
+PRIVATE void SynthWindow80_generated(int16_t* pcm,
+                                     SBC_BUFFER_T const* RESTRICT buffer,
+                                     OI_UINT strideShift);
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__ARM_NEON) || \
+    defined(__ARM_NEON__)
+#define SBC_SYNTH_SIMD
+#endif
+
+#ifdef SBC_SYNTH_SIMD
+/**
+ * Returns TRUE if the CPU supports the SIMD synthesis filterbank.
+ */
+PRIVATE OI_BOOL OI_SBC_SynthSimdSupported(void);
+
+/**
+ * Equivalent of DCT2_8 followed by SYNTH80 for blkcount consecutive blocks of
+ * one channel. Block n uses the filter buffer at buffer - 8 * n, the subband
+ * samples at subdata + n * subdataStride and writes its pcm samples at
+ * pcm + n * (8 << strideShift). The filter buffer must not wrap around within
+ * the blocks.
+ */
+PRIVATE void OI_SBC_SynthBlocks8_Simd(SBC_BUFFER_T* buffer,
+                                      int32_t const* subdata,
+                                      OI_UINT subdataStride, int16_t* pcm,
+                                      OI_UINT strideShift, OI_UINT blkcount);
+#endif
+
 INLINE void dct3_4(int32_t* RESTRICT out, int32_t const* RESTRICT in);
 PRIVATE void analyze4_generated(SBC_BUFFER_T analysisBuffer[RESTRICT 40],
                                 int16_t* pcm, OI_UINT strideShift,
@@ -75,6 +75,10 @@ INLINE OI_STATUS internal_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
   context->limitFrameFormat = FALSE;
   OI_SBC_ExpandFrameFields(&context->common.frameInfo);
 
+#ifdef SBC_SYNTH_SIMD
+  context->simdEnabled = OI_SBC_SynthSimdSupported();
+#endif
+
   /*PLATFORM_DECODER_RESET(context);*/
 
   return OI_OK;
@@ -90,7 +94,26 @@ INLINE void OI_SBC_ReadHeader(OI_CODEC_SBC_COMMON_CONTEXT* common,
   OI_CODEC_SBC_FRAME_INFO* frame = &common->frameInfo;
   uint8_t d1;
 
-  OI_ASSERT(data[0] == OI_SBC_SYNCWORD || data[0] == OI_SBC_ENHANCED_SYNCWORD);
+  OI_ASSERT(data[0] == OI_SBC_SYNCWORD || data[0] == OI_SBC_ENHANCED_SYNCWORD ||
+            data[0] == OI_mSBC_SYNCWORD);
+
+  /* The two bytes following the mSBC syncword are reserved, the parameters of
+   * the frame are fixed instead. Only a context reset for mSBC finds this
+   * syncword, so the cached information of standard headers is left alone. */
+  if (data[0] == OI_mSBC_SYNCWORD) {
+    frame->freqIndex = SBC_FREQ_16000;
+    frame->frequency = freq_values[frame->freqIndex];
+    frame->blocks = 0;
+    frame->nrof_blocks = OI_mSBC_BLOCKS;
+    frame->mode = SBC_MONO;
+    frame->nrof_channels = channel_values[frame->mode];
+    frame->alloc = SBC_LOUDNESS;
+    frame->subbands = SBC_SUBBANDS_8;
+    frame->nrof_subbands = band_values[frame->subbands];
+    frame->bitpool = OI_mSBC_BITPOOL;
+    frame->crc = data[3];
+    return;
+  }
 
   /* Avoid filling out all these strucutures if we already remember the values
    * from last time. Just in case we get a stream corresponding to data[1] ==
@@ -42,7 +42,8 @@
 /**
  * Scans through a buffer looking for a codec syncword. If the decoder has been
  * set for enhanced operation using OI_CODEC_SBC_DecoderReset(), it will search
- * for both a standard and an enhanced syncword.
+ * for both a standard and an enhanced syncword. If it has been reset with
+ * OI_CODEC_mSBC_DecoderReset(), it only searches for the mSBC syncword.
  */
 PRIVATE OI_STATUS FindSyncword(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                const OI_BYTE** frameData,
@@ -56,6 +57,15 @@ PRIVATE OI_STATUS FindSyncword(OI_CODEC_SBC_DECODER_CONTEXT* context,
     return OI_CODEC_SBC_NOT_ENOUGH_HEADER_DATA;
   }
 
+  if (context->mSbcEnabled) {
+    while (*frameBytes && (**frameData != OI_mSBC_SYNCWORD)) {
+      (*frameBytes)--;
+      (*frameData)++;
+    }
+    context->common.frameInfo.enhanced = FALSE;
+    return *frameBytes ? OI_OK : OI_CODEC_SBC_NO_SYNCWORD;
+  }
+
 #ifdef SBC_ENHANCED
   if (context->limitFrameFormat && context->enhancedEnabled) {
     /* If the context is restricted, only search for specified SYNCWORD */
@@ -240,6 +250,18 @@ OI_STATUS OI_CODEC_SBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                maxChannels, pcmStride, enhanced);
 }
 
+OI_STATUS OI_CODEC_mSBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                     uint32_t* decoderData,
+                                     uint32_t decoderDataBytes) {
+  OI_STATUS status = internal_DecoderReset(context, decoderData,
+                                           decoderDataBytes, 1, 1, FALSE);
+  if (!OI_SUCCESS(status)) {
+    return status;
+  }
+  context->mSbcEnabled = TRUE;
+  return OI_OK;
+}
+
 OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                    const OI_BYTE** frameData,
                                    uint32_t* frameBytes, int16_t* pcmData,
@@ -352,6 +374,50 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
   return status;
 }
 
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    uint8_t* frameCount,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, int16_t* pcmData,
+                                    uint32_t* pcmBytes) {
+  OI_STATUS status = OI_OK;
+  uint8_t decoded = 0;
+  uint32_t pcmAvail = *pcmBytes;
+
+  TRACE(("+OI_CODEC_SBC_DecodeFrames"));
+
+  while (decoded < *frameCount) {
+    uint32_t frameOut = pcmAvail;
+    status = OI_CODEC_SBC_DecodeFrame(context, frameData, frameBytes, pcmData,
+                                      &frameOut);
+    if (!OI_SUCCESS(status)) {
+      break;
+    }
+    pcmAvail -= frameOut;
+    pcmData += frameOut / sizeof(*pcmData);
+    decoded++;
+  }
+
+  *pcmBytes -= pcmAvail;
+  *frameCount = decoded;
+  TRACE(("-OI_CODEC_SBC_DecodeFrames: %d", status));
+  return status;
+}
+
+OI_STATUS OI_CODEC_SBC_DecoderEnableSimd(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                         OI_BOOL enable) {
+  if (!enable) {
+    context->simdEnabled = FALSE;
+    return OI_OK;
+  }
+#ifdef SBC_SYNTH_SIMD
+  if (OI_SBC_SynthSimdSupported()) {
+    context->simdEnabled = TRUE;
+    return OI_OK;
+  }
+#endif
+  return OI_STATUS_NOT_IMPLEMENTED;
+}
+
 OI_STATUS OI_CODEC_SBC_SkipFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                  const OI_BYTE** frameData,
                                  uint32_t* frameBytes) {
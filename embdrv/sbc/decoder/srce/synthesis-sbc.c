@@ -243,14 +243,9 @@ INLINE int32_t default_mul_16s_32s_hi(int16_t u, int32_t v) {
 
 #define LONG_MULT_DCT(K, sample) (MUL_16S_32S_HI(K, sample) << 2)
 
-PRIVATE void SynthWindow80_generated(int16_t* pcm,
-                                     SBC_BUFFER_T const* RESTRICT buffer,
-                                     OI_UINT strideShift);
 PRIVATE void SynthWindow112_generated(int16_t* pcm,
                                       SBC_BUFFER_T const* RESTRICT buffer,
                                       OI_UINT strideShift);
-PRIVATE void dct2_8(SBC_BUFFER_T* RESTRICT out, int32_t const* RESTRICT x);
-
 typedef void (*SYNTH_FRAME)(OI_CODEC_SBC_DECODER_CONTEXT* context, int16_t* pcm,
                             OI_UINT blkstart, OI_UINT blkcount);
 
@@ -301,6 +296,28 @@ PRIVATE void OI_SBC_SynthFrame_80(OI_CODEC_SBC_DECODER_CONTEXT* context,
       offset -= 1 * 8;
     }
 
+#ifdef SBC_SYNTH_SIMD
+    /* The channels of a block overlap when stereo is decoded with stride 1;
+     * leave the order of their stores to the C implementation. */
+    if (context->simdEnabled && (pcmStrideShift || nrof_channels == 1)) {
+      /* Synthesize all the blocks up to the next shift of the filter buffer */
+      OI_UINT count = offset / 8 + 1;
+      if (count > blkstop - blk) {
+        count = blkstop - blk;
+      }
+      for (ch = 0; ch < nrof_channels; ch++) {
+        OI_SBC_SynthBlocks8_Simd(context->common.filterBuffer[ch] + offset,
+                                 s + 8 * ch, 8 * nrof_channels, pcm + ch,
+                                 pcmStrideShift, count);
+      }
+      s += 8 * nrof_channels * count;
+      pcm += (8 << pcmStrideShift) * count;
+      offset -= 8 * (count - 1);
+      blk += count - 1;
+      continue;
+    }
+#endif
+
     for (ch = 0; ch < nrof_channels; ch++) {
       DCT2_8(context->common.filterBuffer[ch] + offset, s);
       SYNTH80(pcm + ch, context->common.filterBuffer[ch] + offset,
@@ -0,0 +1,565 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/** @file
+
+SSE4.1 and NEON versions of the 8-subband synthesis filterbank, dct2_8()
+followed by SynthWindow80_generated().
+
+Both functions are applied to groups of up to 8 consecutive blocks of one
+channel, one block per vector lane. This way every operation of the C code
+is performed unchanged on every lane and the output is bit-exact:
+
+- The DCT works on 32 bit lanes, in two halves of 4 blocks. MUL_32S_32S_HI
+  keeps the 32 most significant bits of the 64 bit product.
+
+- The window works on 16 bit lanes. Since the filter buffer of block n + 1
+  starts 8 values before the one of block n, the 17 rows of 8 values used by
+  the group are transposed once, after which each term of the window is an
+  unaligned load, a widening multiply by a constant, and a shift.
+
+@ingroup codec_internal
+*/
+
+/**
+@addtogroup codec_internal
+@{
+*/
+
+#include "oi_codec_sbc_private.h"
+
+#ifdef SBC_SYNTH_SIMD
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SBC_SYNTH_SSE4
+#include <immintrin.h>
+#define SSE4_TARGET __attribute__((target("sse4.1")))
+#else
+#include <arm_neon.h>
+#endif
+
+/* Number of blocks synthesized together */
+#define GROUP_BLOCKS 8
+
+/* Rows of 8 filter buffer values used by a group */
+#define GROUP_ROWS (GROUP_BLOCKS + 9)
+
+/* Terms of SynthWindow80_generated: T(pcm index, buffer index, coefficient,
+ * shift of the product, left if positive) */
+#define SYNTH80_TERMS(T) \
+  T(0, 12, 8235, -3)     \
+  T(0, 20, -23167, -3)   \
+  T(0, 28, 26479, -2)    \
+  T(0, 36, -17397, 1)    \
+  T(0, 44, 9399, 3)      \
+  T(0, 52, 17397, 1)     \
+  T(0, 60, 26479, -2)    \
+  T(0, 68, 23167, -3)    \
+  T(0, 76, 8235, -3)     \
+  T(1, 5, -3263, -5)     \
+  T(7, 5, 9293, -3)      \
+  T(1, 11, 29293, -5)    \
+  T(7, 11, -6087, -2)    \
+  T(1, 21, -5229, 0)     \
+  T(7, 21, 1247, 3)      \
+  T(1, 27, 30835, -3)    \
+  T(7, 27, -2893, 3)     \
+  T(1, 37, -27021, 1)    \
+  T(7, 37, 23671, 2)     \
+  T(1, 43, 31633, 1)     \
+  T(7, 43, 18055, 1)     \
+  T(1, 53, 17319, 1)     \
+  T(7, 53, 11537, -1)    \
+  T(1, 59, 26663, -2)    \
+  T(7, 59, 1747, 1)      \
+  T(1, 69, 4555, -1)     \
+  T(7, 69, 685, 1)       \
+  T(1, 75, 12419, -4)    \
+  T(7, 75, 8721, -7)     \
+  T(2, 6, -10385, -6)    \
+  T(6, 6, 11167, -4)     \
+  T(2, 10, 24995, -5)    \
+  T(6, 10, -10337, -4)   \
+  T(2, 22, -309, 4)      \
+  T(6, 22, 1917, 2)      \
+  T(2, 26, 9161, -3)     \
+  T(6, 26, -30605, -1)   \
+  T(2, 38, -23063, 1)    \
+  T(6, 38, 8317, 3)      \
+  T(2, 42, 27561, 1)     \
+  T(6, 42, 9553, 2)      \
+  T(2, 54, 2309, 3)      \
+  T(6, 54, 22117, -4)    \
+  T(2, 58, 12705, -1)    \
+  T(6, 58, 16383, -2)    \
+  T(2, 70, 6239, -3)     \
+  T(6, 70, 7543, -3)     \
+  T(2, 74, 9251, -4)     \
+  T(6, 74, 8603, -6)     \
+  T(3, 7, -16457, -6)    \
+  T(5, 7, 16913, -5)     \
+  T(3, 9, 19083, -5)     \
+  T(5, 9, -8443, -7)     \
+  T(3, 23, -23641, -2)   \
+  T(5, 23, 3687, 1)      \
+  T(3, 25, -29015, -4)   \
+  T(5, 25, -301, 5)      \
+  T(3, 39, -12889, 2)    \
+  T(5, 39, 15447, 2)     \
+  T(3, 41, 6145, 3)      \
+  T(5, 41, 10255, 2)     \
+  T(3, 55, 24211, -1)    \
+  T(5, 55, -18233, -3)   \
+  T(3, 57, 23469, -2)    \
+  T(5, 57, 9405, -1)     \
+  T(3, 71, 21223, -8)    \
+  T(5, 71, 1499, -1)     \
+  T(3, 73, 26913, -6)    \
+  T(5, 73, 26189, -7)    \
+  T(4, 8, 10445, -4)     \
+  T(4, 24, -5297, 1)     \
+  T(4, 40, 22299, 2)     \
+  T(4, 56, 10603, 0)     \
+  T(4, 72, 9539, -4)
+
+/* The window of block n reads row (index / 8 - n) at column (index % 8).
+ * Column c of the transposed rows holds row (9 - i) at position i, so the
+ * values used by the group are contiguous. */
+#define COLUMN_POSITION(index) (9 - ((index) >> 3))
+
+/* Operations of dct2_8(), |V| is the prefix of the vector operations */
+#define DCT2_8_VECTOR(V, in, out)                      \
+  {                                                    \
+    V##_t L00, L01, L02, L03, L04, L05, L06, L07, L25; \
+    L00 = V##_add(in[0], in[7]);                       \
+    L01 = V##_add(in[1], in[6]);                       \
+    L02 = V##_add(in[2], in[5]);                       \
+    L03 = V##_add(in[3], in[4]);                       \
+    L04 = V##_sub(in[3], in[4]);                       \
+    L05 = V##_sub(in[2], in[5]);                       \
+    L06 = V##_sub(in[1], in[6]);                       \
+    L07 = V##_sub(in[0], in[7]);                       \
+    V##_butterfly(&L00, &L03);                         \
+    V##_butterfly(&L01, &L02);                         \
+    L02 = V##_add(L02, L03);                           \
+    L02 = V##_mult_dct(L02, AAN_C4_FIX);               \
+    V##_butterfly(&L00, &L01);                         \
+    out[0] = V##_scale(L00, DCTII_8_SHIFT_0);          \
+    out[4] = V##_scale(L01, DCTII_8_SHIFT_4);          \
+    V##_butterfly(&L03, &L02);                         \
+    out[6] = V##_scale(L02, DCTII_8_SHIFT_6);          \
+    out[2] = V##_scale(L03, DCTII_8_SHIFT_2);          \
+    L04 = V##_add(L04, L05);                           \
+    L05 = V##_add(L05, L06);                           \
+    L06 = V##_add(L06, L07);                           \
+    L04 = V##_div2(L04);                               \
+    L05 = V##_div2(L05);                               \
+    L06 = V##_div2(L06);                               \
+    L07 = V##_div2(L07);                               \
+    L05 = V##_mult_dct(L05, AAN_C4_FIX);               \
+    L25 = V##_sub(L06, L04);                           \
+    L25 = V##_mult_dct(L25, AAN_C6_FIX);               \
+    L04 = V##_mult_dct(L04, AAN_Q0_FIX);               \
+    L04 = V##_sub(L04, L25);                           \
+    L06 = V##_mult_dct(L06, AAN_Q1_FIX);               \
+    L06 = V##_sub(L06, L25);                           \
+    V##_butterfly(&L07, &L05);                         \
+    V##_butterfly(&L05, &L04);                         \
+    out[3] = V##_scale(L04, DCTII_8_SHIFT_3 - 1);      \
+    out[5] = V##_scale(L05, DCTII_8_SHIFT_5 - 1);      \
+    V##_butterfly(&L07, &L06);                         \
+    out[7] = V##_scale(L06, DCTII_8_SHIFT_7 - 1);      \
+    out[1] = V##_scale(L07, DCTII_8_SHIFT_1 - 1);      \
+  }
+
+#if DCTII_8_SHIFT_IN != 0
+#error "The SIMD synthesis does not scale the DCT input"
+#endif
+
+static const int32_t zero_subdata[8] = {0};
+
+/* Returns the subband samples of the blocks of a group, or zeros for the
+ * lanes past the last block */
+static void group_subdata(int32_t const* subdata, OI_UINT subdataStride,
+                          OI_UINT count, int32_t const* rows[GROUP_BLOCKS]) {
+  OI_UINT blk;
+  for (blk = 0; blk < GROUP_BLOCKS; blk++) {
+    rows[blk] = blk < count ? subdata + blk * subdataStride : zero_subdata;
+  }
+}
+
+/* Copies the rows of filter buffer used by the window of a group. Row i is
+ * the row starting at buffer + 8 * (9 - i). The rows past the last block of
+ * the group are zeroed, as they may be outside of the filter buffer. */
+static void group_rows(SBC_BUFFER_T const* buffer, OI_UINT count,
+                       SBC_BUFFER_T rows[GROUP_ROWS][8]) {
+  OI_UINT i, j;
+  for (i = 0; i < GROUP_ROWS; i++) {
+    SBC_BUFFER_T const* row = buffer + 8 * (9 - (int)i);
+    for (j = 0; j < 8; j++) {
+      rows[i][j] = i < 9 + count ? row[j] : 0;
+    }
+  }
+}
+
+#ifdef SBC_SYNTH_SSE4
+
+typedef __m128i sse4_t;
+
+#define sse4_add(a, b) _mm_add_epi32(a, b)
+#define sse4_sub(a, b) _mm_sub_epi32(a, b)
+
+SSE4_TARGET static inline void sse4_butterfly(__m128i* x, __m128i* y) {
+  *x = _mm_add_epi32(*x, *y);
+  *y = _mm_sub_epi32(*x, _mm_slli_epi32(*y, 1));
+}
+
+/* MUL_32S_32S_HI(K, x) << 2 */
+SSE4_TARGET static inline __m128i sse4_mult_dct(__m128i x, int32_t k) {
+  __m128i coeff = _mm_set1_epi32(k);
+  __m128i even = _mm_srli_epi64(_mm_mul_epi32(x, coeff), 32);
+  __m128i odd = _mm_mul_epi32(_mm_srli_epi64(x, 32), coeff);
+  return _mm_slli_epi32(_mm_blend_epi16(even, odd, 0xCC), 2);
+}
+
+/* SCALE(x, shift) */
+SSE4_TARGET static inline __m128i sse4_scale(__m128i x, int shift) {
+  return _mm_srai_epi32(_mm_add_epi32(x, _mm_set1_epi32(1 << (shift - 1))),
+                        shift);
+}
+
+/* x / 2, rounded toward zero */
+SSE4_TARGET static inline __m128i sse4_div2(__m128i x) {
+  return _mm_srai_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 31)), 1);
+}
+
+/* x / 32768, rounded toward zero, then clipped to 16 bits */
+SSE4_TARGET static inline __m128i sse4_div32768_clip(__m128i lo, __m128i hi) {
+  __m128i bias = _mm_set1_epi32(32767);
+  lo = _mm_add_epi32(lo, _mm_and_si128(_mm_srai_epi32(lo, 31), bias));
+  hi = _mm_add_epi32(hi, _mm_and_si128(_mm_srai_epi32(hi, 31), bias));
+  return _mm_packs_epi32(_mm_srai_epi32(lo, 15), _mm_srai_epi32(hi, 15));
+}
+
+/* (int16_t) cast of 8 32 bit values */
+SSE4_TARGET static inline __m128i sse4_truncate16(__m128i lo, __m128i hi) {
+  lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+  hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+  return _mm_packs_epi32(lo, hi);
+}
+
+SSE4_TARGET static inline void sse4_transpose4x4(__m128i* r) {
+  __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+  __m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+  __m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+  __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+  r[0] = _mm_unpacklo_epi64(t0, t1);
+  r[1] = _mm_unpackhi_epi64(t0, t1);
+  r[2] = _mm_unpacklo_epi64(t2, t3);
+  r[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+SSE4_TARGET static inline void sse4_transpose8x8_16(__m128i* r) {
+  __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+  __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+  __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+  __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+  __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+  __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+  __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+  __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+  __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+  __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+  __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+  __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+  __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+  __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+  __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+  __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+  r[0] = _mm_unpacklo_epi64(b0, b4);
+  r[1] = _mm_unpackhi_epi64(b0, b4);
+  r[2] = _mm_unpacklo_epi64(b1, b5);
+  r[3] = _mm_unpackhi_epi64(b1, b5);
+  r[4] = _mm_unpacklo_epi64(b2, b6);
+  r[5] = _mm_unpackhi_epi64(b2, b6);
+  r[6] = _mm_unpacklo_epi64(b3, b7);
+  r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/* DCT of 4 blocks, returns out[i] with block n in lane n */
+SSE4_TARGET static inline void sse4_dct2_8(int32_t const* const* subdata,
+                                           __m128i out[8]) {
+  __m128i in[8];
+  OI_UINT blk;
+  for (blk = 0; blk < 4; blk++) {
+    in[blk] = _mm_loadu_si128((__m128i const*)subdata[blk]);
+    in[4 + blk] = _mm_loadu_si128((__m128i const*)(subdata[blk] + 4));
+  }
+  sse4_transpose4x4(&in[0]);
+  sse4_transpose4x4(&in[4]);
+  DCT2_8_VECTOR(sse4, in, out);
+}
+
+#define SSE4_SHIFT(x, s)                          \
+  ((s) > 0 ? _mm_slli_epi32(x, (s) > 0 ? (s) : 0) \
+           : _mm_srai_epi32(x, (s) < 0 ? -(s) : 0))
+
+#define SSE4_TERM(n, index, coeff, s)                                     \
+  {                                                                       \
+    __m128i x = _mm_loadu_si128(                                          \
+        (__m128i*)&columns[(index)&7][COLUMN_POSITION(index)]);           \
+    __m128i c = _mm_set1_epi16(coeff);                                    \
+    __m128i lo = _mm_mullo_epi16(x, c);                                   \
+    __m128i hi = _mm_mulhi_epi16(x, c);                                   \
+    acc[n][0] = _mm_add_epi32(acc[n][0],                                  \
+                              SSE4_SHIFT(_mm_unpacklo_epi16(lo, hi), s)); \
+    acc[n][1] = _mm_add_epi32(acc[n][1],                                  \
+                              SSE4_SHIFT(_mm_unpackhi_epi16(lo, hi), s)); \
+  }
+
+SSE4_TARGET static void sse4_synth_group(SBC_BUFFER_T* buffer,
+                                         int32_t const* subdata,
+                                         OI_UINT subdataStride, int16_t* pcm,
+                                         OI_UINT strideShift, OI_UINT count) {
+  int32_t const* subdata_rows[GROUP_BLOCKS];
+  SBC_BUFFER_T rows[GROUP_ROWS][8];
+  SBC_BUFFER_T columns[8][GROUP_ROWS + 7];
+  __m128i lo[8], hi[8], v[8], acc[8][2];
+  OI_UINT blk, i, j;
+
+  /* DCT of every block, written to the filter buffer */
+  group_subdata(subdata, subdataStride, count, subdata_rows);
+  sse4_dct2_8(&subdata_rows[0], lo);
+  sse4_dct2_8(&subdata_rows[4], hi);
+  for (i = 0; i < 8; i++) v[i] = sse4_truncate16(lo[i], hi[i]);
+  sse4_transpose8x8_16(v);
+  for (blk = 0; blk < count; blk++) {
+    _mm_storeu_si128((__m128i*)(buffer - 8 * blk), v[blk]);
+  }
+
+  /* Window */
+  group_rows(buffer, count, rows);
+  for (i = 0; i < GROUP_ROWS - 1; i += 8) {
+    for (j = 0; j < 8; j++) v[j] = _mm_loadu_si128((__m128i*)rows[i + j]);
+    sse4_transpose8x8_16(v);
+    for (j = 0; j < 8; j++) _mm_storeu_si128((__m128i*)&columns[j][i], v[j]);
+  }
+  for (j = 0; j < 8; j++) columns[j][GROUP_ROWS - 1] = rows[GROUP_ROWS - 1][j];
+
+  for (i = 0; i < 8; i++) acc[i][0] = acc[i][1] = _mm_setzero_si128();
+  SYNTH80_TERMS(SSE4_TERM)
+  for (i = 0; i < 8; i++) v[i] = sse4_div32768_clip(acc[i][0], acc[i][1]);
+  sse4_transpose8x8_16(v);
+
+  for (blk = 0; blk < count; blk++) {
+    if (strideShift == 0) {
+      _mm_storeu_si128((__m128i*)(pcm + 8 * blk), v[blk]);
+    } else {
+      int16_t samples[8];
+      _mm_storeu_si128((__m128i*)samples, v[blk]);
+      for (i = 0; i < 8; i++) pcm[(8 * blk + i) << 1] = samples[i];
+    }
+  }
+}
+
+#else /* NEON */
+
+typedef int32x4_t neon_t;
+
+#define neon_add(a, b) vaddq_s32(a, b)
+#define neon_sub(a, b) vsubq_s32(a, b)
+#define neon_scale(x, shift) \
+  vshrq_n_s32(vaddq_s32(x, vdupq_n_s32(1 << ((shift)-1))), shift)
+
+static inline void neon_butterfly(int32x4_t* x, int32x4_t* y) {
+  *x = vaddq_s32(*x, *y);
+  *y = vsubq_s32(*x, vshlq_n_s32(*y, 1));
+}
+
+/* MUL_32S_32S_HI(K, x) << 2 */
+static inline int32x4_t neon_mult_dct(int32x4_t x, int32_t k) {
+  int32x2_t coeff = vdup_n_s32(k);
+  int32x2_t lo = vshrn_n_s64(vmull_s32(vget_low_s32(x), coeff), 32);
+  int32x2_t hi = vshrn_n_s64(vmull_s32(vget_high_s32(x), coeff), 32);
+  return vshlq_n_s32(vcombine_s32(lo, hi), 2);
+}
+
+/* x / 2, rounded toward zero */
+static inline int32x4_t neon_div2(int32x4_t x) {
+  int32x4_t sign = vreinterpretq_s32_u32(
+      vshrq_n_u32(vreinterpretq_u32_s32(x), 31));
+  return vshrq_n_s32(vaddq_s32(x, sign), 1);
+}
+
+/* x / 32768, rounded toward zero, then clipped to 16 bits */
+static inline int16x8_t neon_div32768_clip(int32x4_t lo, int32x4_t hi) {
+  int32x4_t bias = vdupq_n_s32(32767);
+  lo = vaddq_s32(lo, vandq_s32(vshrq_n_s32(lo, 31), bias));
+  hi = vaddq_s32(hi, vandq_s32(vshrq_n_s32(hi, 31), bias));
+  return vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, 15)),
+                      vqmovn_s32(vshrq_n_s32(hi, 15)));
+}
+
+static inline void neon_transpose4x4(int32x4_t* r) {
+  int32x4x2_t t01 = vtrnq_s32(r[0], r[1]);
+  int32x4x2_t t23 = vtrnq_s32(r[2], r[3]);
+  r[0] = vcombine_s32(vget_low_s32(t01.val[0]), vget_low_s32(t23.val[0]));
+  r[1] = vcombine_s32(vget_low_s32(t01.val[1]), vget_low_s32(t23.val[1]));
+  r[2] = vcombine_s32(vget_high_s32(t01.val[0]), vget_high_s32(t23.val[0]));
+  r[3] = vcombine_s32(vget_high_s32(t01.val[1]), vget_high_s32(t23.val[1]));
+}
+
+static inline void neon_transpose8x8_16(int16x8_t* r) {
+  int16x8x2_t t01 = vtrnq_s16(r[0], r[1]);
+  int16x8x2_t t23 = vtrnq_s16(r[2], r[3]);
+  int16x8x2_t t45 = vtrnq_s16(r[4], r[5]);
+  int16x8x2_t t67 = vtrnq_s16(r[6], r[7]);
+  int32x4x2_t u02 = vtrnq_s32(vreinterpretq_s32_s16(t01.val[0]),
+                              vreinterpretq_s32_s16(t23.val[0]));
+  int32x4x2_t u13 = vtrnq_s32(vreinterpretq_s32_s16(t01.val[1]),
+                              vreinterpretq_s32_s16(t23.val[1]));
+  int32x4x2_t u46 = vtrnq_s32(vreinterpretq_s32_s16(t45.val[0]),
+                              vreinterpretq_s32_s16(t67.val[0]));
+  int32x4x2_t u57 = vtrnq_s32(vreinterpretq_s32_s16(t45.val[1]),
+                              vreinterpretq_s32_s16(t67.val[1]));
+  r[0] = vreinterpretq_s16_s32(
+      vcombine_s32(vget_low_s32(u02.val[0]), vget_low_s32(u46.val[0])));
+  r[1] = vreinterpretq_s16_s32(
+      vcombine_s32(vget_low_s32(u13.val[0]), vget_low_s32(u57.val[0])));
+  r[2] = vreinterpretq_s16_s32(
+      vcombine_s32(vget_low_s32(u02.val[1]), vget_low_s32(u46.val[1])));
+  r[3] = vreinterpretq_s16_s32(
+      vcombine_s32(vget_low_s32(u13.val[1]), vget_low_s32(u57.val[1])));
+  r[4] = vreinterpretq_s16_s32(
+      vcombine_s32(vget_high_s32(u02.val[0]), vget_high_s32(u46.val[0])));
+  r[5] = vreinterpretq_s16_s32(
+      vcombine_s32(vget_high_s32(u13.val[0]), vget_high_s32(u57.val[0])));
+  r[6] = vreinterpretq_s16_s32(
+      vcombine_s32(vget_high_s32(u02.val[1]), vget_high_s32(u46.val[1])));
+  r[7] = vreinterpretq_s16_s32(
+      vcombine_s32(vget_high_s32(u13.val[1]), vget_high_s32(u57.val[1])));
+}
+
+/* DCT of 4 blocks, returns out[i] with block n in lane n */
+static inline void neon_dct2_8(int32_t const* const* subdata,
+                               int32x4_t out[8]) {
+  int32x4_t in[8];
+  OI_UINT blk;
+  for (blk = 0; blk < 4; blk++) {
+    in[blk] = vld1q_s32(subdata[blk]);
+    in[4 + blk] = vld1q_s32(subdata[blk] + 4);
+  }
+  neon_transpose4x4(&in[0]);
+  neon_transpose4x4(&in[4]);
+  DCT2_8_VECTOR(neon, in, out);
+}
+
+/* The shift immediates must be in range even in the branch not taken */
+#define NEON_SHIFT(x, s)                       \
+  ((s) > 0 ? vshlq_n_s32(x, (s) > 0 ? (s) : 1) \
+           : (s) < 0 ? vshrq_n_s32(x, (s) < 0 ? -(s) : 1) : (x))
+
+#define NEON_TERM(n, index, coeff, s)                                     \
+  {                                                                       \
+    int16x8_t x = vld1q_s16(&columns[(index)&7][COLUMN_POSITION(index)]); \
+    int16x4_t c = vdup_n_s16(coeff);                                      \
+    acc[n][0] = vaddq_s32(acc[n][0],                                      \
+                          NEON_SHIFT(vmull_s16(vget_low_s16(x), c), s));  \
+    acc[n][1] = vaddq_s32(acc[n][1],                                      \
+                          NEON_SHIFT(vmull_s16(vget_high_s16(x), c), s)); \
+  }
+
+static void neon_synth_group(SBC_BUFFER_T* buffer, int32_t const* subdata,
+                             OI_UINT subdataStride, int16_t* pcm,
+                             OI_UINT strideShift, OI_UINT count) {
+  int32_t const* subdata_rows[GROUP_BLOCKS];
+  SBC_BUFFER_T rows[GROUP_ROWS][8];
+  SBC_BUFFER_T columns[8][GROUP_ROWS + 7];
+  int32x4_t lo[8], hi[8], acc[8][2];
+  int16x8_t v[8];
+  OI_UINT blk, i, j;
+
+  /* DCT of every block, written to the filter buffer */
+  group_subdata(subdata, subdataStride, count, subdata_rows);
+  neon_dct2_8(&subdata_rows[0], lo);
+  neon_dct2_8(&subdata_rows[4], hi);
+  for (i = 0; i < 8; i++) {
+    v[i] = vcombine_s16(vmovn_s32(lo[i]), vmovn_s32(hi[i]));
+  }
+  neon_transpose8x8_16(v);
+  for (blk = 0; blk < count; blk++) vst1q_s16(buffer - 8 * blk, v[blk]);
+
+  /* Window */
+  group_rows(buffer, count, rows);
+  for (i = 0; i < GROUP_ROWS - 1; i += 8) {
+    for (j = 0; j < 8; j++) v[j] = vld1q_s16(rows[i + j]);
+    neon_transpose8x8_16(v);
+    for (j = 0; j < 8; j++) vst1q_s16(&columns[j][i], v[j]);
+  }
+  for (j = 0; j < 8; j++) columns[j][GROUP_ROWS - 1] = rows[GROUP_ROWS - 1][j];
+
+  for (i = 0; i < 8; i++) acc[i][0] = acc[i][1] = vdupq_n_s32(0);
+  SYNTH80_TERMS(NEON_TERM)
+  for (i = 0; i < 8; i++) v[i] = neon_div32768_clip(acc[i][0], acc[i][1]);
+  neon_transpose8x8_16(v);
+
+  for (blk = 0; blk < count; blk++) {
+    if (strideShift == 0) {
+      vst1q_s16(pcm + 8 * blk, v[blk]);
+    } else {
+      int16_t samples[8];
+      vst1q_s16(samples, v[blk]);
+      for (i = 0; i < 8; i++) pcm[(8 * blk + i) << 1] = samples[i];
+    }
+  }
+}
+
+#endif /* SBC_SYNTH_SSE4 */
+
+PRIVATE OI_BOOL OI_SBC_SynthSimdSupported(void) {
+#ifdef SBC_SYNTH_SSE4
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.1") ? TRUE : FALSE;
+#else
+  return TRUE;
+#endif
+}
+
+PRIVATE void OI_SBC_SynthBlocks8_Simd(SBC_BUFFER_T* buffer,
+                                      int32_t const* subdata,
+                                      OI_UINT subdataStride, int16_t* pcm,
+                                      OI_UINT strideShift, OI_UINT blkcount) {
+  while (blkcount > 0) {
+    OI_UINT count = blkcount < GROUP_BLOCKS ? blkcount : GROUP_BLOCKS;
+#ifdef SBC_SYNTH_SSE4
+    sse4_synth_group(buffer, subdata, subdataStride, pcm, strideShift, count);
+#else
+    neon_synth_group(buffer, subdata, subdataStride, pcm, strideShift, count);
+#endif
+    buffer -= 8 * count;
+    subdata += subdataStride * count;
+    pcm += (8 << strideShift) * count;
+    blkcount -= count;
+  }
+}
+
+#endif /* SBC_SYNTH_SIMD */
+
+/**
+@}
+*/
@@ -0,0 +1,128 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <vector>
+
+#include "oi_codec_sbc.h"
+#include "oi_status.h"
+#include "sbc_encoder.h"
+
+namespace {
+
+constexpr int kNumFrames = 100;
+
+struct StreamConfig {
+  int16_t channel_mode;
+  int16_t num_subbands;
+  int16_t num_blocks;
+};
+
+// Encodes |kNumFrames| frames of pseudo random PCM with full scale bursts.
+std::vector<uint8_t> Encode(const StreamConfig& config) {
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = SBC_sf44100;
+  params.s16ChannelMode = config.channel_mode;
+  params.s16NumOfChannels = config.channel_mode == SBC_MONO ? 1 : 2;
+  params.s16NumOfSubBands = config.num_subbands;
+  params.s16NumOfBlocks = config.num_blocks;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.s16BitPool = params.s16NumOfChannels * 4 * config.num_subbands;
+  params.u16BitRate = 328;
+  SBC_Encoder_Init(&params);
+
+  std::vector<uint8_t> encoded;
+  uint32_t seed = 1;
+  int samples =
+      config.num_blocks * config.num_subbands * params.s16NumOfChannels;
+  for (int frame = 0; frame < kNumFrames; frame++) {
+    int16_t pcm[SBC_MAX_PCM_BUFFER_SIZE];
+    uint8_t output[512];
+    for (int i = 0; i < samples; i++) {
+      seed = seed * 1103515245 + 12345;
+      pcm[i] = static_cast<int16_t>(seed >> 16);
+      if (frame % 7 == 0) pcm[i] = (i & 1) ? INT16_MAX : INT16_MIN;
+    }
+    uint32_t size = SBC_Encode(&params, pcm, output);
+    encoded.insert(encoded.end(), output, output + size);
+  }
+  return encoded;
+}
+
+class SbcSynthesisSimdTest : public ::testing::Test {
+ protected:
+  // Decodes |encoded| into stride 2 PCM, |frames_per_call| frames at a time.
+  std::vector<int16_t> Decode(const std::vector<uint8_t>& encoded, bool simd,
+                              uint8_t frames_per_call) {
+    // The filter buffers are not cleared by OI_CODEC_SBC_DecoderReset()
+    memset(&context_data_, 0, sizeof(context_data_));
+    EXPECT_EQ(OI_OK,
+              OI_CODEC_SBC_DecoderReset(&context_, context_data_.data,
+                                        sizeof(context_data_), 2, 2, FALSE));
+    EXPECT_EQ(OI_OK, OI_CODEC_SBC_DecoderEnableSimd(&context_, simd));
+
+    std::vector<int16_t> decoded;
+    const OI_BYTE* data = encoded.data();
+    uint32_t data_size = encoded.size();
+    for (int frame = 0; frame < kNumFrames; frame += frames_per_call) {
+      int16_t pcm[SBC_MAX_SAMPLES_PER_FRAME * SBC_MAX_CHANNELS * 15];
+      uint32_t pcm_size = sizeof(pcm);
+      uint8_t frame_count = frames_per_call;
+      if (frame_count > kNumFrames - frame) frame_count = kNumFrames - frame;
+      uint8_t requested = frame_count;
+      EXPECT_EQ(OI_OK, OI_CODEC_SBC_DecodeFrames(&context_, &frame_count, &data,
+                                                 &data_size, pcm, &pcm_size));
+      EXPECT_EQ(requested, frame_count);
+      decoded.insert(decoded.end(), pcm, pcm + pcm_size / sizeof(*pcm));
+    }
+    EXPECT_EQ(0u, data_size);
+    return decoded;
+  }
+
+  OI_CODEC_SBC_DECODER_CONTEXT context_;
+  OI_CODEC_SBC_CODEC_DATA_STEREO context_data_;
+};
+
+TEST_F(SbcSynthesisSimdTest, decode_frames_matches_decode_frame) {
+  std::vector<uint8_t> encoded = Encode({SBC_JOINT_STEREO, 8, 16});
+  std::vector<int16_t> reference = Decode(encoded, false, 1);
+  EXPECT_EQ(reference.size(), kNumFrames * 8 * 16 * 2u);
+  EXPECT_EQ(reference, Decode(encoded, false, 7));
+}
+
+TEST_F(SbcSynthesisSimdTest, bit_exact_with_c) {
+  OI_CODEC_SBC_DecoderReset(&context_, context_data_.data,
+                            sizeof(context_data_), 2, 2, FALSE);
+  if (OI_CODEC_SBC_DecoderEnableSimd(&context_, TRUE) != OI_OK) {
+    GTEST_SKIP() << "SIMD synthesis not supported";
+  }
+  for (int16_t mode : {SBC_MONO, SBC_DUAL, SBC_STEREO, SBC_JOINT_STEREO}) {
+    for (int16_t subbands : {4, 8}) {
+      for (int16_t blocks : {4, 8, 12, 16}) {
+        std::vector<uint8_t> encoded = Encode({mode, subbands, blocks});
+        EXPECT_EQ(Decode(encoded, false, 1), Decode(encoded, true, 5))
+            << "mode " << mode << " subbands " << subbands << " blocks "
+            << blocks;
+      }
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+#include "sbc_encoder.h"
+
+using ::benchmark::State;
+
+// Encodes stereo frames of 16 blocks at 44.1 kHz, the A2DP high quality
+// configuration, with the analysis implementation given by range(0) and
+// range(1) subbands. Reports the number of frames encoded per second.
+static void BM_SbcEncode(State& state) {
+  auto impl = static_cast<tSBC_ANALYSIS_IMPL>(state.range(0));
+  if (!SBC_Encoder_SetAnalysisImpl(impl)) {
+    state.SkipWithError("analysis implementation not supported");
+    return;
+  }
+  state.SetLabel(SBC_Encoder_AnalysisImplName(impl));
+
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = SBC_sf44100;
+  params.s16ChannelMode = SBC_JOINT_STEREO;
+  params.s16NumOfChannels = 2;
+  params.s16NumOfSubBands = state.range(1);
+  params.s16NumOfBlocks = 16;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.s16BitPool = 53;
+  params.u16BitRate = 328;
+  SBC_Encoder_Init(&params);
+
+  int16_t pcm[SBC_MAX_PCM_BUFFER_SIZE];
+  uint32_t seed = 1;
+  for (int16_t& sample : pcm) {
+    seed = seed * 1103515245 + 12345;
+    sample = static_cast<int16_t>(seed >> 16);
+  }
+
+  uint8_t output[512];
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(SBC_Encode(&params, pcm, output));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void SbcEncodeArguments(benchmark::internal::Benchmark* benchmark) {
+  for (int impl = SBC_ANALYSIS_IMPL_C; impl < SBC_ANALYSIS_IMPL_MAX; impl++) {
+    for (int subbands : {4, 8}) benchmark->Args({impl, subbands});
+  }
+}
+
+BENCHMARK(BM_SbcEncode)->Apply(SbcEncodeArguments);
@@ -48,6 +48,34 @@ extern void SbcAnalysisFilter8(SBC_ENC_PARAMS* strEncParams, int16_t* input);
 extern void SBC_FastIDCT8(int32_t* pInVect, int32_t* pOutVect);
 extern void SBC_FastIDCT4(int32_t* x0, int32_t* pOutVect);
 
+#if (SBC_SIMD_ANALYSIS == TRUE)
+/* Analysis window coefficients, per tap: s32DCTY[k] is the sum over the taps
+ * j of gas16AnalysisWindowN[j * 2 * N + k] * s16X[ChOffset + j * 2 * N + k] */
+extern const int16_t gas16AnalysisWindow4[];
+extern const int16_t gas16AnalysisWindow8[];
+
+/* Kernels of one analysis implementation. The window functions compute
+ * s32DCTY for one channel of one block from s16X + ChOffset. The DCT
+ * functions transform |count| consecutive s32DCTY vectors of 2 * N values
+ * into |count| consecutive vectors of N subband samples. */
+typedef struct {
+  void (*window4)(int16_t* ps16X, int32_t* ps32DCTY);
+  void (*window8)(int16_t* ps16X, int32_t* ps32DCTY);
+  void (*dct4)(int32_t* ps32DCTY, int32_t* ps32SbBuf, int32_t s32Count);
+  void (*dct8)(int32_t* ps32DCTY, int32_t* ps32SbBuf, int32_t s32Count);
+} tSBC_ANALYSIS_KERNELS;
+
+extern void SbcAnalysisWindow4_C(int16_t* ps16X, int32_t* ps32DCTY);
+extern void SbcAnalysisWindow8_C(int16_t* ps16X, int32_t* ps32DCTY);
+extern void SbcAnalysisDct4_C(int32_t* ps32DCTY, int32_t* ps32SbBuf,
+                              int32_t s32Count);
+extern void SbcAnalysisDct8_C(int32_t* ps32DCTY, int32_t* ps32SbBuf,
+                              int32_t s32Count);
+
+/* Kernels of the currently selected implementation */
+extern const tSBC_ANALYSIS_KERNELS* SbcAnalysisKernels(void);
+#endif
+
 extern uint32_t EncPacking(SBC_ENC_PARAMS* strEncParams, uint8_t* output);
 extern void EncQuantizer(SBC_ENC_PARAMS*);
 #if (SBC_DSP_OPT == TRUE)
@@ -65,6 +65,17 @@
 
 #define SBC_NULL 0
 
+#define SBC_FORMAT_GENERAL 0
+#define SBC_FORMAT_MSBC 1
+
+/* mSBC, the wide band speech codec of HFP, always encodes 16 kHz mono with 15
+ * blocks, 8 subbands, loudness allocation and a bitpool of 26 */
+#define SBC_MSBC_SYNCWORD 0xAD
+#define SBC_MSBC_BLOCKS 15
+#define SBC_MSBC_BITPOOL 26
+#define SBC_MSBC_FRAME_LEN 57
+#define SBC_MSBC_SAMPLES_PER_FRAME 120
+
 #ifndef SBC_MAX_NUM_FRAME
 #define SBC_MAX_NUM_FRAME 1
 #endif
@@ -138,6 +149,22 @@
 #define SBC_FAST_DCT TRUE
 #endif /*SBC_FAST_DCT */
 
+/* Set SBC_SIMD_ANALYSIS to TRUE to run the analysis filter and the DCT with
+ * SSE4.1, AVX2 or NEON kernels selected at runtime. The output is bit-exact
+ * with the C implementation.
+ */
+/* CAUTION: It only applies to the SBC_IPAQ_OPT configuration with 16 bit
+ * window coefficients and the 32x16 bit fast DCT */
+#ifndef SBC_SIMD_ANALYSIS
+#if ((SBC_IPAQ_OPT == TRUE) && (SBC_ARM_ASM_OPT == FALSE) &&   \
+     (SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE) &&               \
+     (SBC_FAST_DCT == TRUE) && (SBC_IS_64_MULT_IN_IDCT == FALSE))
+#define SBC_SIMD_ANALYSIS TRUE
+#else
+#define SBC_SIMD_ANALYSIS FALSE
+#endif
+#endif /*SBC_SIMD_ANALYSIS */
+
 /* In case we do not use joint stereo mode the flag save some RAM and ROM in
  * case it is set to FALSE */
 #ifndef SBC_JOINT_STE_INCLUDED
@@ -185,8 +212,18 @@ typedef struct SBC_ENC_PARAMS_TAG {
 
   uint16_t FrameHeader;
 
+  uint8_t Format; /* SBC_FORMAT_GENERAL or SBC_FORMAT_MSBC */
 } SBC_ENC_PARAMS;
 
+/* Implementations of the analysis filter and DCT */
+typedef enum {
+  SBC_ANALYSIS_IMPL_C,
+  SBC_ANALYSIS_IMPL_SSE4,
+  SBC_ANALYSIS_IMPL_AVX2,
+  SBC_ANALYSIS_IMPL_NEON,
+  SBC_ANALYSIS_IMPL_MAX
+} tSBC_ANALYSIS_IMPL;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -195,8 +232,23 @@ extern "C" {
  * number of bytes written. */
 extern uint32_t SBC_Encode(SBC_ENC_PARAMS* strEncParams, int16_t* input,
                            uint8_t* output);
+/* Initialize the encoder for the parameters in |strEncParams|. With Format set
+ * to SBC_FORMAT_MSBC the other frame parameters are overridden with the fixed
+ * mSBC ones. */
 extern void SBC_Encoder_Init(SBC_ENC_PARAMS* strEncParams);
 
+/* Returns true if |impl| is available in this build and on this CPU. */
+extern bool SBC_Encoder_IsAnalysisImplSupported(tSBC_ANALYSIS_IMPL impl);
+
+/* Selects the analysis implementation used by the following frames. By
+ * default the fastest supported one is used. Return false and keep the
+ * current implementation if |impl| is not supported. */
+extern bool SBC_Encoder_SetAnalysisImpl(tSBC_ANALYSIS_IMPL impl);
+extern tSBC_ANALYSIS_IMPL SBC_Encoder_GetAnalysisImpl(void);
+
+/* Returns a printable name for |impl|. */
+extern const char* SBC_Encoder_AnalysisImplName(tSBC_ANALYSIS_IMPL impl);
+
 #ifdef __cplusplus
 }
 #endif
@@ -200,7 +200,14 @@
 #if (SBC_USE_ARM_PRAGMA == TRUE)
 #pragma arm section zidata = "sbc_s32_analysis_section"
 #endif
+#if (SBC_SIMD_ANALYSIS == TRUE)
+/* Window outputs of all channels and blocks of a frame, transformed together
+ * after the last block */
+static int32_t s32DCTYBuffer[SBC_MAX_NUM_OF_BLOCKS * SBC_MAX_NUM_OF_CHANNELS *
+                             2 * SBC_MAX_NUM_OF_SUBBANDS];
+#else
 static int32_t s32DCTY[16] = {0};
+#endif
 static int32_t s32X[ENC_VX_BUFFER_SIZE / 2];
 static int16_t* s16X =
     (int16_t*)s32X; /* s16X must be 32 bits aligned cf  SHIFTUP_X8_2*/
@@ -1185,6 +1192,102 @@ static int16_t* s16X =
 #endif
 #endif
 
+#if (SBC_SIMD_ANALYSIS == TRUE)
+const int16_t gas16AnalysisWindow4[5 * 2 * SUB_BANDS_4] = {
+    /* tap 0 */
+    0, WIND_4_SUBBANDS_1_0, WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_3_0,
+    WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_2_4,
+    WIND_4_SUBBANDS_1_4,
+    /* tap 1 */
+    WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_1, WIND_4_SUBBANDS_2_1,
+    WIND_4_SUBBANDS_3_1, WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_3,
+    WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_1_3,
+    /* tap 2 */
+    WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_2, WIND_4_SUBBANDS_2_2,
+    WIND_4_SUBBANDS_3_2, WIND_4_SUBBANDS_4_2, WIND_4_SUBBANDS_3_2,
+    WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_1_2,
+    /* tap 3 */
+    -WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_3, WIND_4_SUBBANDS_2_3,
+    WIND_4_SUBBANDS_3_3, WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_1,
+    WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_1_1,
+    /* tap 4 */
+    -WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_4, WIND_4_SUBBANDS_2_4,
+    WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_0,
+    WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_1_0,
+};
+
+const int16_t gas16AnalysisWindow8[5 * 2 * SUB_BANDS_8] = {
+    /* tap 0 */
+    0, WIND_8_SUBBANDS_1_0, WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_3_0,
+    WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_5_0, WIND_8_SUBBANDS_6_0,
+    WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_4,
+    WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_5_4, WIND_8_SUBBANDS_4_4,
+    WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_1_4,
+    /* tap 1 */
+    WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_1, WIND_8_SUBBANDS_2_1,
+    WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_5_1,
+    WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_8_1,
+    WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_5_3,
+    WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_2_3,
+    WIND_8_SUBBANDS_1_3,
+    /* tap 2 */
+    WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_2, WIND_8_SUBBANDS_2_2,
+    WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_5_2,
+    WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_8_2,
+    WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_5_2,
+    WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_2_2,
+    WIND_8_SUBBANDS_1_2,
+    /* tap 3 */
+    -WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_3, WIND_8_SUBBANDS_2_3,
+    WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_5_3,
+    WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_8_1,
+    WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_5_1,
+    WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_2_1,
+    WIND_8_SUBBANDS_1_1,
+    /* tap 4 */
+    -WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_4, WIND_8_SUBBANDS_2_4,
+    WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_5_4,
+    WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_7_4, WIND_8_SUBBANDS_8_0,
+    WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_5_0,
+    WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_3_0, WIND_8_SUBBANDS_2_0,
+    WIND_8_SUBBANDS_1_0,
+};
+
+/* C kernels. The parameters shadow the static buffers used by the
+ * WINDOW_PARTIAL macros */
+void SbcAnalysisWindow4_C(int16_t* s16X, int32_t* s32DCTY) {
+  int32_t ChOffset = 0;
+  register int32_t s32Temp, s32Temp2;
+
+  WINDOW_PARTIAL_4
+}
+
+void SbcAnalysisWindow8_C(int16_t* s16X, int32_t* s32DCTY) {
+  int32_t ChOffset = 0;
+  register int32_t s32Temp, s32Temp2;
+
+  WINDOW_PARTIAL_8
+}
+
+void SbcAnalysisDct4_C(int32_t* ps32DCTY, int32_t* ps32SbBuf,
+                       int32_t s32Count) {
+  for (; s32Count > 0; s32Count--) {
+    SBC_FastIDCT4(ps32DCTY, ps32SbBuf);
+    ps32DCTY += 2 * SUB_BANDS_4;
+    ps32SbBuf += SUB_BANDS_4;
+  }
+}
+
+void SbcAnalysisDct8_C(int32_t* ps32DCTY, int32_t* ps32SbBuf,
+                       int32_t s32Count) {
+  for (; s32Count > 0; s32Count--) {
+    SBC_FastIDCT8(ps32DCTY, ps32SbBuf);
+    ps32DCTY += 2 * SUB_BANDS_8;
+    ps32SbBuf += SUB_BANDS_8;
+  }
+}
+#endif
+
 static int16_t ShiftCounter = 0;
 extern int16_t EncMaxShiftCounter;
 /****************************************************************************
@@ -1194,7 +1297,12 @@ extern int16_t EncMaxShiftCounter;
 */
 void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   int16_t* ps16PcmBuf;
+#if (SBC_SIMD_ANALYSIS == TRUE)
+  const tSBC_ANALYSIS_KERNELS* kernels = SbcAnalysisKernels();
+  int32_t* ps32DCTY;
+#else
   int32_t* ps32SbBuf;
+#endif
   int32_t s32Blk, s32Ch;
   int32_t s32NumOfChannels, s32NumOfBlocks;
   int32_t i, *ps32X, *ps32X2;
@@ -1205,7 +1313,7 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
 #if (SBC_IPAQ_OPT == TRUE)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
   register int64_t s64Temp, s64Temp2;
-#else
+#elif (SBC_SIMD_ANALYSIS == FALSE)
   register int32_t s32Temp, s32Temp2;
 #endif
 #else
@@ -1222,7 +1330,11 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
 
   ps16PcmBuf = input;
 
+#if (SBC_SIMD_ANALYSIS == TRUE)
+  ps32DCTY = s32DCTYBuffer;
+#else
   ps32SbBuf = pstrEncParams->s32SbBuffer;
+#endif
   Offset2 = (int32_t)(EncMaxShiftCounter + 40);
   for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
     Offset = (int32_t)(EncMaxShiftCounter - ShiftCounter);
@@ -1257,11 +1369,17 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
+#if (SBC_SIMD_ANALYSIS == TRUE)
+      kernels->window4(s16X + ChOffset, ps32DCTY);
+
+      ps32DCTY += 2 * SUB_BANDS_4;
+#else
       WINDOW_PARTIAL_4
 
       SBC_FastIDCT4(s32DCTY, ps32SbBuf);
 
       ps32SbBuf += SUB_BANDS_4;
+#endif
     }
     if (s32NumOfChannels == 1) {
       if (ShiftCounter >= EncMaxShiftCounter) {
@@ -1279,12 +1397,21 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+#if (SBC_SIMD_ANALYSIS == TRUE)
+  kernels->dct4(s32DCTYBuffer, pstrEncParams->s32SbBuffer,
+                s32NumOfBlocks * s32NumOfChannels);
+#endif
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
 void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   int16_t* ps16PcmBuf;
+#if (SBC_SIMD_ANALYSIS == TRUE)
+  const tSBC_ANALYSIS_KERNELS* kernels = SbcAnalysisKernels();
+  int32_t* ps32DCTY;
+#else
   int32_t* ps32SbBuf;
+#endif
   int32_t s32Blk, s32Ch; /* counter for block*/
   int32_t Offset, Offset2;
   int32_t s32NumOfChannels, s32NumOfBlocks;
@@ -1296,7 +1423,7 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
 #if (SBC_IPAQ_OPT == TRUE)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
   register int64_t s64Temp, s64Temp2;
-#else
+#elif (SBC_SIMD_ANALYSIS == FALSE)
   register int32_t s32Temp, s32Temp2;
 #endif
 #else
@@ -1311,7 +1438,11 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
 
   ps16PcmBuf = input;
 
+#if (SBC_SIMD_ANALYSIS == TRUE)
+  ps32DCTY = s32DCTYBuffer;
+#else
   ps32SbBuf = pstrEncParams->s32SbBuffer;
+#endif
   Offset2 = (int32_t)(EncMaxShiftCounter + 80);
   for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
     Offset = (int32_t)(EncMaxShiftCounter - ShiftCounter);
@@ -1370,11 +1501,17 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
+#if (SBC_SIMD_ANALYSIS == TRUE)
+      kernels->window8(s16X + ChOffset, ps32DCTY);
+
+      ps32DCTY += 2 * SUB_BANDS_8;
+#else
       WINDOW_PARTIAL_8
 
       SBC_FastIDCT8(s32DCTY, ps32SbBuf);
 
       ps32SbBuf += SUB_BANDS_8;
+#endif
     }
     if (s32NumOfChannels == 1) {
       if (ShiftCounter >= EncMaxShiftCounter) {
@@ -1392,6 +1529,10 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+#if (SBC_SIMD_ANALYSIS == TRUE)
+  kernels->dct8(s32DCTYBuffer, pstrEncParams->s32SbBuffer,
+                s32NumOfBlocks * s32NumOfChannels);
+#endif
 }
 
 void SbcAnalysisInit(void) {
@@ -0,0 +1,596 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  SIMD kernels of the analysis filter and the fast DCT, and selection of the
+ *  kernels used by the encoder.
+ *
+ *  The window is computed for one channel of one block at a time: each tap
+ *  is a widening 16x16 bit multiply of 2 * N consecutive samples with a row
+ *  of gas16AnalysisWindowN, accumulated on 32 bits.
+ *
+ *  The DCT is computed for all the blocks and channels of a frame at once,
+ *  with one s32DCTY vector per lane, so the butterflies of SBC_FastIDCT8 and
+ *  SBC_FastIDCT4 are applied unchanged. SBC_IDCT_MULT keeps bits 15 to 46 of
+ *  the 64 bit product.
+ *
+ *  Both only use exact integer operations in the same order as the C code,
+ *  the output is therefore bit-exact.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "sbc_dct.h"
+#include "sbc_enc_func_declare.h"
+#include "sbc_encoder.h"
+
+#if (SBC_SIMD_ANALYSIS == TRUE)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SBC_X86_KERNELS TRUE
+#include <immintrin.h>
+#define SBC_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define SBC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SBC_X86_KERNELS FALSE
+#endif
+
+/* NEON is a build time option on ARMv7 and always present on ARMv8 */
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SBC_NEON_KERNELS TRUE
+#include <arm_neon.h>
+#else
+#define SBC_NEON_KERNELS FALSE
+#endif
+
+/* Butterflies of SBC_FastIDCT8, |V| is the prefix of the vector operations */
+#define SBC_DCT8_VECTOR(V, in, out)                                         \
+  {                                                                         \
+    V##_t x0, x1, x2, x3, x4, x5, x6, x7, temp;                             \
+    V##_t even0, even1, even2, even3, odd0, odd1, odd2, odd3;               \
+    x0 = V##_mult(in[4], SBC_COS_PI_SUR_4);                                 \
+    x1 = V##_sra1(V##_add(in[3], in[5]));                                   \
+    x2 = V##_sra1(V##_add(in[2], in[6]));                                   \
+    x3 = V##_sra1(V##_add(in[1], in[7]));                                   \
+    x4 = V##_sra1(V##_add(in[0], in[8]));                                   \
+    x5 = V##_sra1(V##_sub(in[9], in[15]));                                  \
+    x6 = V##_sra1(V##_sub(in[10], in[14]));                                 \
+    x7 = V##_sra1(V##_sub(in[11], in[13]));                                 \
+    temp = x0;                                                              \
+    x0 = V##_mult(V##_add(x0, x4), SBC_COS_PI_SUR_4);                       \
+    x4 = V##_mult(V##_sub(temp, x4), SBC_COS_PI_SUR_4);                     \
+    x2 = V##_sub(x2, x6);                                                   \
+    x6 = V##_shl1(x6);                                                      \
+    x6 = V##_mult(x6, SBC_COS_PI_SUR_4);                                    \
+    temp = x2;                                                              \
+    x2 = V##_mult(V##_add(x2, x6), SBC_COS_PI_SUR_8);                       \
+    x6 = V##_mult(V##_sub(temp, x6), SBC_COS_3PI_SUR_8);                    \
+    even0 = V##_add(x0, x2);                                                \
+    even1 = V##_add(x4, x6);                                                \
+    even2 = V##_sub(x4, x6);                                                \
+    even3 = V##_sub(x0, x2);                                                \
+    x7 = V##_shl1(x7);                                                      \
+    x5 = V##_sub(V##_shl1(x5), x7);                                         \
+    x3 = V##_sub(V##_shl1(x3), x5);                                         \
+    x1 = V##_sub(x1, V##_sra1(x3));                                         \
+    x5 = V##_mult(x5, SBC_COS_PI_SUR_4);                                    \
+    temp = x1;                                                              \
+    x1 = V##_add(x1, x5);                                                   \
+    x5 = V##_sub(temp, x5);                                                 \
+    x3 = V##_sub(x3, x7);                                                   \
+    x7 = V##_shl1(x7);                                                      \
+    x7 = V##_mult(x7, SBC_COS_PI_SUR_4);                                    \
+    temp = x3;                                                              \
+    x3 = V##_mult(V##_add(x3, x7), SBC_COS_PI_SUR_8);                       \
+    x7 = V##_mult(V##_sub(temp, x7), SBC_COS_3PI_SUR_8);                    \
+    odd0 = V##_mult(V##_add(x1, x3), SBC_COS_PI_SUR_16);                    \
+    odd1 = V##_mult(V##_add(x5, x7), SBC_COS_3PI_SUR_16);                   \
+    odd2 = V##_mult(V##_sub(x5, x7), SBC_COS_5PI_SUR_16);                   \
+    odd3 = V##_mult(V##_sub(x1, x3), SBC_COS_7PI_SUR_16);                   \
+    out[0] = V##_add(even0, odd0);                                          \
+    out[1] = V##_add(even1, odd1);                                          \
+    out[2] = V##_add(even2, odd2);                                          \
+    out[3] = V##_add(even3, odd3);                                          \
+    out[7] = V##_sub(even0, odd0);                                          \
+    out[6] = V##_sub(even1, odd1);                                          \
+    out[5] = V##_sub(even2, odd2);                                          \
+    out[4] = V##_sub(even3, odd3);                                          \
+  }
+
+/* Butterflies of SBC_FastIDCT4, |V| is the prefix of the vector operations */
+#define SBC_DCT4_VECTOR(V, in, out)                      \
+  {                                                      \
+    V##_t temp, x2, tmp0, tmp1, tmp2, tmp3, tmp4, tmp5;  \
+    x2 = V##_sra1(in[2]);                                \
+    temp = V##_add(in[0], in[4]);                        \
+    tmp0 = V##_mult(temp, SBC_COS_PI_SUR_4 >> 1);        \
+    tmp1 = V##_sub(x2, tmp0);                            \
+    tmp0 = V##_add(tmp0, x2);                            \
+    temp = V##_add(in[1], in[3]);                        \
+    tmp3 = V##_mult(temp, SBC_COS_3PI_SUR_8 >> 1);       \
+    tmp2 = V##_mult(temp, SBC_COS_PI_SUR_8 >> 1);        \
+    temp = V##_sub(in[5], in[7]);                        \
+    tmp5 = V##_mult(temp, SBC_COS_3PI_SUR_8 >> 1);       \
+    tmp4 = V##_mult(temp, SBC_COS_PI_SUR_8 >> 1);        \
+    tmp2 = V##_add(tmp2, tmp5);                          \
+    tmp3 = V##_sub(tmp3, tmp4);                          \
+    out[0] = V##_add(tmp0, tmp2);                        \
+    out[1] = V##_add(tmp1, tmp3);                        \
+    out[2] = V##_sub(tmp1, tmp3);                        \
+    out[3] = V##_sub(tmp0, tmp2);                        \
+  }
+
+#if (SBC_X86_KERNELS == TRUE)
+/*******************************************************************************
+ *
+ * SSE4.1 kernels, 4 lanes
+ *
+ ******************************************************************************/
+typedef __m128i sse4_t;
+
+#define sse4_add(a, b) _mm_add_epi32(a, b)
+#define sse4_sub(a, b) _mm_sub_epi32(a, b)
+#define sse4_sra1(a) _mm_srai_epi32(a, 1)
+#define sse4_shl1(a) _mm_slli_epi32(a, 1)
+
+SBC_TARGET_SSE4 static inline __m128i sse4_mult(__m128i a, int32_t c) {
+  __m128i coeff = _mm_set1_epi32(c);
+  /* 64 bit products of the even and the odd lanes */
+  __m128i even = _mm_mul_epi32(a, coeff);
+  __m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), coeff);
+  /* Move bits 15 to 46 to the low half of even lanes, high half of odd ones */
+  even = _mm_srli_epi64(even, 15);
+  odd = _mm_slli_epi64(odd, 17);
+  return _mm_blend_epi16(even, odd, 0xCC);
+}
+
+SBC_TARGET_SSE4 static inline void sse4_transpose(__m128i* r0, __m128i* r1,
+                                                  __m128i* r2, __m128i* r3) {
+  __m128i t0 = _mm_unpacklo_epi32(*r0, *r1);
+  __m128i t1 = _mm_unpacklo_epi32(*r2, *r3);
+  __m128i t2 = _mm_unpackhi_epi32(*r0, *r1);
+  __m128i t3 = _mm_unpackhi_epi32(*r2, *r3);
+  *r0 = _mm_unpacklo_epi64(t0, t1);
+  *r1 = _mm_unpackhi_epi64(t0, t1);
+  *r2 = _mm_unpacklo_epi64(t2, t3);
+  *r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* Loads values [first, first + 4) of 4 vectors of |stride| values */
+SBC_TARGET_SSE4 static inline void sse4_load_columns(int32_t* src,
+                                                     int32_t stride,
+                                                     int32_t first,
+                                                     __m128i* columns) {
+  columns[0] = _mm_loadu_si128((__m128i*)(src + first));
+  columns[1] = _mm_loadu_si128((__m128i*)(src + stride + first));
+  columns[2] = _mm_loadu_si128((__m128i*)(src + 2 * stride + first));
+  columns[3] = _mm_loadu_si128((__m128i*)(src + 3 * stride + first));
+  sse4_transpose(&columns[0], &columns[1], &columns[2], &columns[3]);
+}
+
+/* Stores |columns| as values [first, first + 4) of 4 vectors */
+SBC_TARGET_SSE4 static inline void sse4_store_columns(int32_t* dst,
+                                                      int32_t stride,
+                                                      int32_t first,
+                                                      __m128i* columns) {
+  sse4_transpose(&columns[0], &columns[1], &columns[2], &columns[3]);
+  _mm_storeu_si128((__m128i*)(dst + first), columns[0]);
+  _mm_storeu_si128((__m128i*)(dst + stride + first), columns[1]);
+  _mm_storeu_si128((__m128i*)(dst + 2 * stride + first), columns[2]);
+  _mm_storeu_si128((__m128i*)(dst + 3 * stride + first), columns[3]);
+}
+
+/* Accumulates the 32 bit products of 8 samples and 8 coefficients */
+SBC_TARGET_SSE4 static inline void sse4_window_tap(int16_t* ps16X,
+                                                   const int16_t* ps16Coeff,
+                                                   __m128i* acc_lo,
+                                                   __m128i* acc_hi) {
+  __m128i x = _mm_loadu_si128((__m128i*)ps16X);
+  __m128i c = _mm_loadu_si128((__m128i*)ps16Coeff);
+  __m128i lo = _mm_mullo_epi16(x, c);
+  __m128i hi = _mm_mulhi_epi16(x, c);
+  *acc_lo = _mm_add_epi32(*acc_lo, _mm_unpacklo_epi16(lo, hi));
+  *acc_hi = _mm_add_epi32(*acc_hi, _mm_unpackhi_epi16(lo, hi));
+}
+
+SBC_TARGET_SSE4 static void SbcAnalysisWindow4_SSE4(int16_t* ps16X,
+                                                    int32_t* ps32DCTY) {
+  __m128i acc_lo = _mm_setzero_si128();
+  __m128i acc_hi = _mm_setzero_si128();
+  int32_t j;
+  for (j = 0; j < 5; j++) {
+    sse4_window_tap(ps16X + j * 8, gas16AnalysisWindow4 + j * 8, &acc_lo,
+                    &acc_hi);
+  }
+  _mm_storeu_si128((__m128i*)ps32DCTY, acc_lo);
+  _mm_storeu_si128((__m128i*)(ps32DCTY + 4), acc_hi);
+}
+
+SBC_TARGET_SSE4 static void SbcAnalysisWindow8_SSE4(int16_t* ps16X,
+                                                    int32_t* ps32DCTY) {
+  __m128i acc[4] = {_mm_setzero_si128(), _mm_setzero_si128(),
+                    _mm_setzero_si128(), _mm_setzero_si128()};
+  int32_t j;
+  for (j = 0; j < 5; j++) {
+    sse4_window_tap(ps16X + j * 16, gas16AnalysisWindow8 + j * 16, &acc[0],
+                    &acc[1]);
+    sse4_window_tap(ps16X + j * 16 + 8, gas16AnalysisWindow8 + j * 16 + 8,
+                    &acc[2], &acc[3]);
+  }
+  for (j = 0; j < 4; j++) {
+    _mm_storeu_si128((__m128i*)(ps32DCTY + j * 4), acc[j]);
+  }
+}
+
+SBC_TARGET_SSE4 static void SbcAnalysisDct4_SSE4(int32_t* ps32DCTY,
+                                                 int32_t* ps32SbBuf,
+                                                 int32_t s32Count) {
+  __m128i in[8], out[4];
+  for (; s32Count >= 4; s32Count -= 4) {
+    sse4_load_columns(ps32DCTY, 8, 0, &in[0]);
+    sse4_load_columns(ps32DCTY, 8, 4, &in[4]);
+    SBC_DCT4_VECTOR(sse4, in, out);
+    sse4_store_columns(ps32SbBuf, 4, 0, &out[0]);
+    ps32DCTY += 4 * 8;
+    ps32SbBuf += 4 * 4;
+  }
+  SbcAnalysisDct4_C(ps32DCTY, ps32SbBuf, s32Count);
+}
+
+SBC_TARGET_SSE4 static void SbcAnalysisDct8_SSE4(int32_t* ps32DCTY,
+                                                 int32_t* ps32SbBuf,
+                                                 int32_t s32Count) {
+  __m128i in[16], out[8];
+  for (; s32Count >= 4; s32Count -= 4) {
+    sse4_load_columns(ps32DCTY, 16, 0, &in[0]);
+    sse4_load_columns(ps32DCTY, 16, 4, &in[4]);
+    sse4_load_columns(ps32DCTY, 16, 8, &in[8]);
+    sse4_load_columns(ps32DCTY, 16, 12, &in[12]);
+    SBC_DCT8_VECTOR(sse4, in, out);
+    sse4_store_columns(ps32SbBuf, 8, 0, &out[0]);
+    sse4_store_columns(ps32SbBuf, 8, 4, &out[4]);
+    ps32DCTY += 4 * 16;
+    ps32SbBuf += 4 * 8;
+  }
+  SbcAnalysisDct8_C(ps32DCTY, ps32SbBuf, s32Count);
+}
+
+/*******************************************************************************
+ *
+ * AVX2 kernels, 8 lanes
+ *
+ ******************************************************************************/
+typedef __m256i avx2_t;
+
+#define avx2_add(a, b) _mm256_add_epi32(a, b)
+#define avx2_sub(a, b) _mm256_sub_epi32(a, b)
+#define avx2_sra1(a) _mm256_srai_epi32(a, 1)
+#define avx2_shl1(a) _mm256_slli_epi32(a, 1)
+
+SBC_TARGET_AVX2 static inline __m256i avx2_mult(__m256i a, int32_t c) {
+  __m256i coeff = _mm256_set1_epi32(c);
+  __m256i even = _mm256_mul_epi32(a, coeff);
+  __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), coeff);
+  even = _mm256_srli_epi64(even, 15);
+  odd = _mm256_slli_epi64(odd, 17);
+  return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+SBC_TARGET_AVX2 static inline void avx2_transpose(__m256i* r) {
+  __m256i t[8], u[8];
+  int32_t i;
+  for (i = 0; i < 8; i += 2) {
+    t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+    t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+  }
+  for (i = 0; i < 8; i += 4) {
+    u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+    u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+    u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+    u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+  }
+  for (i = 0; i < 4; i++) {
+    r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+    r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+  }
+}
+
+/* Loads values [first, first + 8) of 8 vectors of |stride| values */
+SBC_TARGET_AVX2 static inline void avx2_load_columns(int32_t* src,
+                                                     int32_t stride,
+                                                     int32_t first,
+                                                     __m256i* columns) {
+  int32_t i;
+  for (i = 0; i < 8; i++) {
+    columns[i] = _mm256_loadu_si256((__m256i*)(src + i * stride + first));
+  }
+  avx2_transpose(columns);
+}
+
+SBC_TARGET_AVX2 static void SbcAnalysisWindow8_AVX2(int16_t* ps16X,
+                                                    int32_t* ps32DCTY) {
+  __m256i acc_lo = _mm256_setzero_si256();
+  __m256i acc_hi = _mm256_setzero_si256();
+  int32_t j;
+  for (j = 0; j < 5; j++) {
+    __m256i x = _mm256_loadu_si256((__m256i*)(ps16X + j * 16));
+    __m256i c =
+        _mm256_loadu_si256((__m256i*)(gas16AnalysisWindow8 + j * 16));
+    __m256i lo = _mm256_mullo_epi16(x, c);
+    __m256i hi = _mm256_mulhi_epi16(x, c);
+    /* Values 0-3 and 8-11, then 4-7 and 12-15 */
+    acc_lo = _mm256_add_epi32(acc_lo, _mm256_unpacklo_epi16(lo, hi));
+    acc_hi = _mm256_add_epi32(acc_hi, _mm256_unpackhi_epi16(lo, hi));
+  }
+  _mm256_storeu_si256((__m256i*)ps32DCTY,
+                      _mm256_permute2x128_si256(acc_lo, acc_hi, 0x20));
+  _mm256_storeu_si256((__m256i*)(ps32DCTY + 8),
+                      _mm256_permute2x128_si256(acc_lo, acc_hi, 0x31));
+}
+
+SBC_TARGET_AVX2 static void SbcAnalysisDct4_AVX2(int32_t* ps32DCTY,
+                                                 int32_t* ps32SbBuf,
+                                                 int32_t s32Count) {
+  __m256i in[8], out[4];
+  __m128i half[4];
+  int32_t i;
+  for (; s32Count >= 8; s32Count -= 8) {
+    avx2_load_columns(ps32DCTY, 8, 0, in);
+    SBC_DCT4_VECTOR(avx2, in, out);
+    /* 4 values per vector, transpose each half on its own */
+    for (i = 0; i < 4; i++) half[i] = _mm256_castsi256_si128(out[i]);
+    sse4_store_columns(ps32SbBuf, 4, 0, half);
+    for (i = 0; i < 4; i++) half[i] = _mm256_extracti128_si256(out[i], 1);
+    sse4_store_columns(ps32SbBuf + 4 * 4, 4, 0, half);
+    ps32DCTY += 8 * 8;
+    ps32SbBuf += 8 * 4;
+  }
+  SbcAnalysisDct4_SSE4(ps32DCTY, ps32SbBuf, s32Count);
+}
+
+SBC_TARGET_AVX2 static void SbcAnalysisDct8_AVX2(int32_t* ps32DCTY,
+                                                 int32_t* ps32SbBuf,
+                                                 int32_t s32Count) {
+  __m256i in[16], out[8];
+  int32_t i;
+  for (; s32Count >= 8; s32Count -= 8) {
+    avx2_load_columns(ps32DCTY, 16, 0, &in[0]);
+    avx2_load_columns(ps32DCTY, 16, 8, &in[8]);
+    SBC_DCT8_VECTOR(avx2, in, out);
+    avx2_transpose(out);
+    for (i = 0; i < 8; i++) {
+      _mm256_storeu_si256((__m256i*)(ps32SbBuf + i * 8), out[i]);
+    }
+    ps32DCTY += 8 * 16;
+    ps32SbBuf += 8 * 8;
+  }
+  SbcAnalysisDct8_SSE4(ps32DCTY, ps32SbBuf, s32Count);
+}
+
+static const tSBC_ANALYSIS_KERNELS sbc_analysis_kernels_sse4 = {
+    SbcAnalysisWindow4_SSE4, SbcAnalysisWindow8_SSE4, SbcAnalysisDct4_SSE4,
+    SbcAnalysisDct8_SSE4};
+
+/* The 4 subband window only fills 128 bits */
+static const tSBC_ANALYSIS_KERNELS sbc_analysis_kernels_avx2 = {
+    SbcAnalysisWindow4_SSE4, SbcAnalysisWindow8_AVX2, SbcAnalysisDct4_AVX2,
+    SbcAnalysisDct8_AVX2};
+#endif /* SBC_X86_KERNELS */
+
+#if (SBC_NEON_KERNELS == TRUE)
+/*******************************************************************************
+ *
+ * NEON kernels, 4 lanes
+ *
+ ******************************************************************************/
+typedef int32x4_t neon_t;
+
+#define neon_add(a, b) vaddq_s32(a, b)
+#define neon_sub(a, b) vsubq_s32(a, b)
+#define neon_sra1(a) vshrq_n_s32(a, 1)
+#define neon_shl1(a) vshlq_n_s32(a, 1)
+
+static inline int32x4_t neon_mult(int32x4_t a, int32_t c) {
+  int32x2_t coeff = vdup_n_s32(c);
+  int64x2_t lo = vmull_s32(vget_low_s32(a), coeff);
+  int64x2_t hi = vmull_s32(vget_high_s32(a), coeff);
+  return vcombine_s32(vshrn_n_s64(lo, 15), vshrn_n_s64(hi, 15));
+}
+
+static inline void neon_transpose(int32x4_t* r) {
+  int32x4x2_t t01 = vtrnq_s32(r[0], r[1]);
+  int32x4x2_t t23 = vtrnq_s32(r[2], r[3]);
+  r[0] = vcombine_s32(vget_low_s32(t01.val[0]), vget_low_s32(t23.val[0]));
+  r[1] = vcombine_s32(vget_low_s32(t01.val[1]), vget_low_s32(t23.val[1]));
+  r[2] = vcombine_s32(vget_high_s32(t01.val[0]), vget_high_s32(t23.val[0]));
+  r[3] = vcombine_s32(vget_high_s32(t01.val[1]), vget_high_s32(t23.val[1]));
+}
+
+/* Loads values [first, first + 4) of 4 vectors of |stride| values */
+static inline void neon_load_columns(int32_t* src, int32_t stride,
+                                     int32_t first, int32x4_t* columns) {
+  int32_t i;
+  for (i = 0; i < 4; i++) columns[i] = vld1q_s32(src + i * stride + first);
+  neon_transpose(columns);
+}
+
+/* Stores |columns| as values [first, first + 4) of 4 vectors */
+static inline void neon_store_columns(int32_t* dst, int32_t stride,
+                                      int32_t first, int32x4_t* columns) {
+  int32_t i;
+  neon_transpose(columns);
+  for (i = 0; i < 4; i++) vst1q_s32(dst + i * stride + first, columns[i]);
+}
+
+static void SbcAnalysisWindow4_NEON(int16_t* ps16X, int32_t* ps32DCTY) {
+  int32x4_t acc_lo = vmull_s16(vld1_s16(ps16X), vld1_s16(gas16AnalysisWindow4));
+  int32x4_t acc_hi =
+      vmull_s16(vld1_s16(ps16X + 4), vld1_s16(gas16AnalysisWindow4 + 4));
+  int32_t j;
+  for (j = 1; j < 5; j++) {
+    acc_lo = vmlal_s16(acc_lo, vld1_s16(ps16X + j * 8),
+                       vld1_s16(gas16AnalysisWindow4 + j * 8));
+    acc_hi = vmlal_s16(acc_hi, vld1_s16(ps16X + j * 8 + 4),
+                       vld1_s16(gas16AnalysisWindow4 + j * 8 + 4));
+  }
+  vst1q_s32(ps32DCTY, acc_lo);
+  vst1q_s32(ps32DCTY + 4, acc_hi);
+}
+
+static void SbcAnalysisWindow8_NEON(int16_t* ps16X, int32_t* ps32DCTY) {
+  int32x4_t acc[4];
+  int32_t i, j;
+  for (i = 0; i < 4; i++) {
+    acc[i] = vmull_s16(vld1_s16(ps16X + i * 4),
+                       vld1_s16(gas16AnalysisWindow8 + i * 4));
+  }
+  for (j = 1; j < 5; j++) {
+    for (i = 0; i < 4; i++) {
+      acc[i] = vmlal_s16(acc[i], vld1_s16(ps16X + j * 16 + i * 4),
+                         vld1_s16(gas16AnalysisWindow8 + j * 16 + i * 4));
+    }
+  }
+  for (i = 0; i < 4; i++) vst1q_s32(ps32DCTY + i * 4, acc[i]);
+}
+
+static void SbcAnalysisDct4_NEON(int32_t* ps32DCTY, int32_t* ps32SbBuf,
+                                 int32_t s32Count) {
+  int32x4_t in[8], out[4];
+  for (; s32Count >= 4; s32Count -= 4) {
+    neon_load_columns(ps32DCTY, 8, 0, &in[0]);
+    neon_load_columns(ps32DCTY, 8, 4, &in[4]);
+    SBC_DCT4_VECTOR(neon, in, out);
+    neon_store_columns(ps32SbBuf, 4, 0, &out[0]);
+    ps32DCTY += 4 * 8;
+    ps32SbBuf += 4 * 4;
+  }
+  SbcAnalysisDct4_C(ps32DCTY, ps32SbBuf, s32Count);
+}
+
+static void SbcAnalysisDct8_NEON(int32_t* ps32DCTY, int32_t* ps32SbBuf,
+                                 int32_t s32Count) {
+  int32x4_t in[16], out[8];
+  for (; s32Count >= 4; s32Count -= 4) {
+    neon_load_columns(ps32DCTY, 16, 0, &in[0]);
+    neon_load_columns(ps32DCTY, 16, 4, &in[4]);
+    neon_load_columns(ps32DCTY, 16, 8, &in[8]);
+    neon_load_columns(ps32DCTY, 16, 12, &in[12]);
+    SBC_DCT8_VECTOR(neon, in, out);
+    neon_store_columns(ps32SbBuf, 8, 0, &out[0]);
+    neon_store_columns(ps32SbBuf, 8, 4, &out[4]);
+    ps32DCTY += 4 * 16;
+    ps32SbBuf += 4 * 8;
+  }
+  SbcAnalysisDct8_C(ps32DCTY, ps32SbBuf, s32Count);
+}
+
+static const tSBC_ANALYSIS_KERNELS sbc_analysis_kernels_neon = {
+    SbcAnalysisWindow4_NEON, SbcAnalysisWindow8_NEON, SbcAnalysisDct4_NEON,
+    SbcAnalysisDct8_NEON};
+#endif /* SBC_NEON_KERNELS */
+
+static const tSBC_ANALYSIS_KERNELS sbc_analysis_kernels_c = {
+    SbcAnalysisWindow4_C, SbcAnalysisWindow8_C, SbcAnalysisDct4_C,
+    SbcAnalysisDct8_C};
+
+static const tSBC_ANALYSIS_KERNELS* sbc_analysis_kernels = NULL;
+static tSBC_ANALYSIS_IMPL sbc_analysis_impl = SBC_ANALYSIS_IMPL_C;
+
+static const tSBC_ANALYSIS_KERNELS* sbc_get_kernels(tSBC_ANALYSIS_IMPL impl) {
+  switch (impl) {
+    case SBC_ANALYSIS_IMPL_C:
+      return &sbc_analysis_kernels_c;
+#if (SBC_X86_KERNELS == TRUE)
+    case SBC_ANALYSIS_IMPL_SSE4:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse4.1") ? &sbc_analysis_kernels_sse4
+                                              : NULL;
+    case SBC_ANALYSIS_IMPL_AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") ? &sbc_analysis_kernels_avx2
+                                            : NULL;
+#endif
+#if (SBC_NEON_KERNELS == TRUE)
+    case SBC_ANALYSIS_IMPL_NEON:
+      return &sbc_analysis_kernels_neon;
+#endif
+    default:
+      return NULL;
+  }
+}
+
+const tSBC_ANALYSIS_KERNELS* SbcAnalysisKernels(void) {
+  if (sbc_analysis_kernels == NULL) {
+    /* Fastest first */
+    static const tSBC_ANALYSIS_IMPL preferred[] = {
+        SBC_ANALYSIS_IMPL_AVX2, SBC_ANALYSIS_IMPL_NEON, SBC_ANALYSIS_IMPL_SSE4,
+        SBC_ANALYSIS_IMPL_C};
+    uint32_t i;
+    for (i = 0; i < sizeof(preferred) / sizeof(preferred[0]); i++) {
+      if (SBC_Encoder_SetAnalysisImpl(preferred[i])) break;
+    }
+  }
+  return sbc_analysis_kernels;
+}
+#endif /* SBC_SIMD_ANALYSIS */
+
+bool SBC_Encoder_IsAnalysisImplSupported(tSBC_ANALYSIS_IMPL impl) {
+#if (SBC_SIMD_ANALYSIS == TRUE)
+  return sbc_get_kernels(impl) != NULL;
+#else
+  return impl == SBC_ANALYSIS_IMPL_C;
+#endif
+}
+
+bool SBC_Encoder_SetAnalysisImpl(tSBC_ANALYSIS_IMPL impl) {
+#if (SBC_SIMD_ANALYSIS == TRUE)
+  const tSBC_ANALYSIS_KERNELS* kernels = sbc_get_kernels(impl);
+  if (kernels == NULL) return false;
+  sbc_analysis_kernels = kernels;
+  sbc_analysis_impl = impl;
+  return true;
+#else
+  return impl == SBC_ANALYSIS_IMPL_C;
+#endif
+}
+
+tSBC_ANALYSIS_IMPL SBC_Encoder_GetAnalysisImpl(void) {
+#if (SBC_SIMD_ANALYSIS == TRUE)
+  SbcAnalysisKernels();
+  return sbc_analysis_impl;
+#else
+  return SBC_ANALYSIS_IMPL_C;
+#endif
+}
+
+const char* SBC_Encoder_AnalysisImplName(tSBC_ANALYSIS_IMPL impl) {
+  switch (impl) {
+    case SBC_ANALYSIS_IMPL_C:
+      return "C";
+    case SBC_ANALYSIS_IMPL_SSE4:
+      return "SSE4.1";
+    case SBC_ANALYSIS_IMPL_AVX2:
+      return "AVX2";
+    case SBC_ANALYSIS_IMPL_NEON:
+      return "NEON";
+    default:
+      return "unknown";
+  }
+}
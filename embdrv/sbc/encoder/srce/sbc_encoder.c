@@ -167,6 +167,14 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS* pstrEncParams) {
   int16_t s16FrameLen;      /*to store frame length*/
   uint16_t HeaderParams;
 
+  if (pstrEncParams->Format == SBC_FORMAT_MSBC) {
+    pstrEncParams->s16SamplingFreq = SBC_sf16000;
+    pstrEncParams->s16ChannelMode = SBC_MONO;
+    pstrEncParams->s16NumOfSubBands = SUB_BANDS_8;
+    pstrEncParams->s16NumOfBlocks = SBC_MSBC_BLOCKS;
+    pstrEncParams->s16AllocationMethod = SBC_LOUDNESS;
+  }
+
   /* Required number of channels */
   if (pstrEncParams->s16ChannelMode == SBC_MONO)
     pstrEncParams->s16NumOfChannels = 1;
@@ -228,6 +236,10 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS* pstrEncParams) {
   }
 
   if (pstrEncParams->s16BitPool < 0) pstrEncParams->s16BitPool = 0;
+
+  /* The mSBC bitpool is fixed rather than derived from the bit rate */
+  if (pstrEncParams->Format == SBC_FORMAT_MSBC)
+    pstrEncParams->s16BitPool = SBC_MSBC_BITPOOL;
   /* sampling freq */
   HeaderParams = ((pstrEncParams->s16SamplingFreq & 3) << 6);
 
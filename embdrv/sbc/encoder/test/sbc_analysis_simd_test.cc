@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <vector>
+
+#include "sbc_encoder.h"
+
+namespace {
+
+constexpr int kNumFrames = 100;
+
+struct EncoderConfig {
+  int16_t channel_mode;
+  int16_t num_subbands;
+  int16_t num_blocks;
+};
+
+// Encodes |kNumFrames| frames of pseudo random PCM with full scale bursts,
+// using the analysis implementation |impl|.
+std::vector<uint8_t> Encode(tSBC_ANALYSIS_IMPL impl,
+                            const EncoderConfig& config) {
+  EXPECT_TRUE(SBC_Encoder_SetAnalysisImpl(impl));
+
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = SBC_sf44100;
+  params.s16ChannelMode = config.channel_mode;
+  params.s16NumOfChannels = config.channel_mode == SBC_MONO ? 1 : 2;
+  params.s16NumOfSubBands = config.num_subbands;
+  params.s16NumOfBlocks = config.num_blocks;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.s16BitPool = params.s16NumOfChannels * 2 * config.num_subbands;
+  params.u16BitRate = 328;
+  SBC_Encoder_Init(&params);
+
+  std::vector<uint8_t> encoded;
+  uint32_t seed = 1;
+  int samples =
+      config.num_blocks * config.num_subbands * params.s16NumOfChannels;
+  for (int frame = 0; frame < kNumFrames; frame++) {
+    int16_t pcm[SBC_MAX_PCM_BUFFER_SIZE];
+    uint8_t output[512];
+    for (int i = 0; i < samples; i++) {
+      seed = seed * 1103515245 + 12345;
+      pcm[i] = static_cast<int16_t>(seed >> 16);
+      if (frame % 7 == 0) pcm[i] = (i & 1) ? INT16_MAX : INT16_MIN;
+    }
+    uint32_t size = SBC_Encode(&params, pcm, output);
+    encoded.insert(encoded.end(), output, output + size);
+  }
+  return encoded;
+}
+
+class SbcAnalysisSimdTest : public ::testing::Test {
+ protected:
+  void SetUp() override { default_impl_ = SBC_Encoder_GetAnalysisImpl(); }
+  void TearDown() override { SBC_Encoder_SetAnalysisImpl(default_impl_); }
+
+  tSBC_ANALYSIS_IMPL default_impl_;
+};
+
+TEST_F(SbcAnalysisSimdTest, c_is_always_supported) {
+  EXPECT_TRUE(SBC_Encoder_IsAnalysisImplSupported(SBC_ANALYSIS_IMPL_C));
+  EXPECT_FALSE(SBC_Encoder_IsAnalysisImplSupported(SBC_ANALYSIS_IMPL_MAX));
+  EXPECT_FALSE(SBC_Encoder_SetAnalysisImpl(SBC_ANALYSIS_IMPL_MAX));
+  EXPECT_EQ(default_impl_, SBC_Encoder_GetAnalysisImpl());
+}
+
+TEST_F(SbcAnalysisSimdTest, bit_exact_with_c) {
+  for (int16_t mode : {SBC_MONO, SBC_DUAL, SBC_STEREO, SBC_JOINT_STEREO}) {
+    for (int16_t subbands : {4, 8}) {
+      for (int16_t blocks : {4, 8, 12, 16}) {
+        EncoderConfig config = {mode, subbands, blocks};
+        std::vector<uint8_t> reference = Encode(SBC_ANALYSIS_IMPL_C, config);
+        for (int i = SBC_ANALYSIS_IMPL_C + 1; i < SBC_ANALYSIS_IMPL_MAX; i++) {
+          auto impl = static_cast<tSBC_ANALYSIS_IMPL>(i);
+          if (!SBC_Encoder_IsAnalysisImplSupported(impl)) continue;
+          EXPECT_EQ(reference, Encode(impl, config))
+              << SBC_Encoder_AnalysisImplName(impl) << " mode " << mode
+              << " subbands " << subbands << " blocks " << blocks;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
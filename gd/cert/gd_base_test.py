@@ -52,6 +52,7 @@ class GdBaseTestClass(BaseTestClass):
 
         # Start root-canal if needed
         self.rootcanal_running = False
+        self.rootcanal_test_port = None
         if 'rootcanal' in self.controller_configs:
             self.rootcanal_running = True
             # Get root canal binary
@@ -68,6 +69,7 @@ class GdBaseTestClass(BaseTestClass):
             asserts.assert_true(
                 make_ports_available((rootcanal_test_port, rootcanal_hci_port, rootcanal_link_layer_port)),
                 "Failed to make root canal ports available")
+            self.rootcanal_test_port = rootcanal_test_port
 
             # Start root canal process
             rootcanal_cmd = [
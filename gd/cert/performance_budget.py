@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+#
+#   Copyright 2020 - The Android Open Source Project
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+
+import json
+import os
+
+from mobly import asserts
+
+BUDGETS_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'performance_budgets.json')
+RESULTS_FILE_NAME = 'performance_results.json'
+
+
+class PerformanceBudget(object):
+    """
+    Checks measured metrics against the budgets checked in to performance_budgets.json, so that a
+    performance regression fails the test instead of only showing up in its log.
+
+    Each budget has a limit and a direction: "max" for metrics such as latencies that must stay at or
+    below the limit, "min" for metrics such as throughputs that must stay at or above it.
+    """
+
+    def __init__(self, budgets_file=BUDGETS_FILE):
+        with open(budgets_file) as f:
+            self.budgets = json.load(f)
+        self.results = {}
+
+    def check(self, metric, value):
+        """
+        Records |value| for |metric| and fails the current test if it is over budget.
+        """
+        asserts.assert_true(metric in self.budgets, "No budget for metric %s" % metric)
+        budget = self.budgets[metric]
+        limit = budget['limit']
+        if budget['direction'] == 'max':
+            within_budget = value <= limit
+        else:
+            within_budget = value >= limit
+        self.results[metric] = {
+            'value': value,
+            'limit': limit,
+            'direction': budget['direction'],
+            'pass': within_budget,
+        }
+        asserts.assert_true(
+            within_budget, "%s is %s, budget is %s %s" % (metric, value, budget['direction'], limit),
+            extras=self.results[metric])
+
+    def write_results(self, log_path):
+        """
+        Writes every checked metric to performance_results.json in |log_path|, to track the trend across runs.
+        """
+        if not self.results:
+            return
+        with open(os.path.join(log_path, RESULTS_FILE_NAME), 'w') as f:
+            json.dump(self.results, f, indent=2, sort_keys=True)
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+#
+#   Copyright 2020 - The Android Open Source Project
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+
+import socket
+import struct
+
+from cert.closable import Closable
+
+
+class PyRootCanal(Closable):
+    """
+    Adds and removes the simulated devices of root-canal through its test channel
+    """
+
+    # The phys root-canal creates on start up, in order
+    BR_EDR_PHY = 0
+    LOW_ENERGY_PHY = 1
+
+    def __init__(self, test_port):
+        self._socket = socket.create_connection(('localhost', test_port))
+
+    def close(self):
+        if self._socket is None:
+            return
+        self._send_command('CLOSE_TEST_CHANNEL', [])
+        self._socket.close()
+        self._socket = None
+
+    def add_device(self, device_type, *args):
+        """
+        Add a device of the given type, such as beacon or keyboard, with its type specific arguments
+        :return: the index of the new device
+        """
+        response = self.send_command('add', [device_type] + [str(arg) for arg in args])
+        index, separator, _ = response.partition(':')
+        if not separator:
+            raise RuntimeError("root-canal could not add %s: %s" % (device_type, response))
+        return int(index)
+
+    def add_device_to_phy(self, index, phy):
+        self.send_command('add_device_to_phy', [str(index), str(phy)])
+
+    def remove_device(self, index):
+        self.send_command('del', [str(index)])
+
+    def set_tick_workers(self, worker_count):
+        """
+        Tick the simulated devices from worker_count threads, so that large simulations keep up with real time
+        """
+        self.send_command('set_tick_workers', [str(worker_count)])
+
+    def send_command(self, name, args):
+        self._send_command(name, args)
+        return self._receive_response()
+
+    def _send_command(self, name, args):
+        command = bytes([len(name)]) + name.encode() + bytes([len(args)])
+        for arg in args:
+            command += bytes([len(arg)]) + arg.encode()
+        self._socket.sendall(command)
+
+    def _receive_response(self):
+        size = struct.unpack('<I', self._receive(4))[0]
+        return self._receive(size).decode()
+
+    def _receive(self, size):
+        data = b''
+        while len(data) < size:
+            chunk = self._socket.recv(size - len(data))
+            if not chunk:
+                raise ConnectionError("root-canal closed the test channel")
+            data += chunk
+        return data
@@ -29,6 +29,7 @@ class BidiQueueEnd : public ::bluetooth::os::IQueueEnqueue<TENQUEUE>, public ::b
  public:
   using EnqueueCallback = Callback<std::unique_ptr<TENQUEUE>()>;
   using DequeueCallback = Callback<void()>;
+  using DequeueBatchCallback = Callback<void(std::vector<std::unique_ptr<TDEQUEUE>>)>;
 
   BidiQueueEnd(::bluetooth::os::IQueueEnqueue<TENQUEUE>* tx, ::bluetooth::os::IQueueDequeue<TDEQUEUE>* rx)
       : tx_(tx), rx_(rx) {}
@@ -45,6 +46,11 @@ class BidiQueueEnd : public ::bluetooth::os::IQueueEnqueue<TENQUEUE>, public ::b
     rx_->RegisterDequeue(handler, callback);
   }
 
+  void RegisterDequeueBatch(
+      ::bluetooth::os::Handler* handler, size_t max_batch_size, DequeueBatchCallback callback) override {
+    rx_->RegisterDequeueBatch(handler, max_batch_size, callback);
+  }
+
   void UnregisterDequeue() override {
     rx_->UnregisterDequeue();
   }
@@ -53,6 +59,10 @@ class BidiQueueEnd : public ::bluetooth::os::IQueueEnqueue<TENQUEUE>, public ::b
     return rx_->TryDequeue();
   }
 
+  std::vector<std::unique_ptr<TDEQUEUE>> TryDequeueBatch(size_t max_count) override {
+    return rx_->TryDequeueBatch(max_count);
+  }
+
  private:
   ::bluetooth::os::IQueueEnqueue<TENQUEUE>* tx_;
   ::bluetooth::os::IQueueDequeue<TDEQUEUE>* rx_;
@@ -61,7 +61,7 @@ class ContextualOnceCallback<R(Args...)> {
 
  private:
   common::OnceCallback<R(Args...)> callback_;
-  IPostableContext* context_;
+  IPostableContext* context_ = nullptr;
 };
 
 template <typename R, typename... Args>
@@ -85,6 +85,15 @@ class ContextualCallback<R(Args...)> {
     context_->Post(common::BindOnce(callback_, std::forward<Args>(args)...));
   }
 
+  // Runs the callback right away when the caller already runs in its context |current|, saving the post
+  void InvokeFrom(const IPostableContext* current, Args... args) {
+    if (context_ == current) {
+      callback_.Run(std::forward<Args>(args)...);
+    } else {
+      context_->Post(common::BindOnce(callback_, std::forward<Args>(args)...));
+    }
+  }
+
   void InvokeIfNotEmpty(Args... args) {
     if (context_ != nullptr) {
       context_->Post(common::BindOnce(callback_, std::forward<Args>(args)...));
@@ -97,7 +106,7 @@ class ContextualCallback<R(Args...)> {
 
  private:
   common::Callback<R(Args...)> callback_;
-  IPostableContext* context_;
+  IPostableContext* context_ = nullptr;
 };
 
 }  // namespace common
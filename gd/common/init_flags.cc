@@ -34,9 +34,33 @@ bool InitFlags::gd_controller_enabled = false;
 const std::string kGdCoreFlag = "INIT_gd_core";
 bool InitFlags::gd_core_enabled = false;
 
+const std::string kOsiSlabAllocatorFlag = "INIT_osi_slab_allocator";
+bool InitFlags::osi_slab_allocator_enabled = false;
+
+const std::string kGdParallelModuleStartFlag = "INIT_gd_parallel_module_start";
+bool InitFlags::gd_parallel_module_start_enabled = false;
+
+const std::string kHciCommandPipeliningFlag = "INIT_hci_command_pipelining";
+bool InitFlags::hci_command_pipelining_enabled = false;
+
+const std::string kSdpDiscoveryCacheFlag = "INIT_sdp_discovery_cache";
+bool InitFlags::sdp_discovery_cache_enabled = false;
+
+const std::string kMetricsPerEventFlag = "INIT_metrics_per_event";
+bool InitFlags::metrics_per_event_enabled = false;
+
+const std::string kOsiAllocationProfilingFlag = "INIT_osi_allocation_profiling";
+bool InitFlags::osi_allocation_profiling_enabled = false;
+
 void InitFlags::Load(const char** flags) {
   gd_core_enabled = false;
   gd_hci_enabled = false;
+  osi_slab_allocator_enabled = false;
+  gd_parallel_module_start_enabled = false;
+  hci_command_pipelining_enabled = false;
+  sdp_discovery_cache_enabled = false;
+  metrics_per_event_enabled = false;
+  osi_allocation_profiling_enabled = false;
   while (flags != nullptr && *flags != nullptr) {
     if (kGdCoreFlag == *flags) {
       gd_core_enabled = true;
@@ -44,6 +68,18 @@ void InitFlags::Load(const char** flags) {
       gd_hci_enabled = true;
     } else if (kGdControllerFlag == *flags) {
       gd_controller_enabled = true;
+    } else if (kOsiSlabAllocatorFlag == *flags) {
+      osi_slab_allocator_enabled = true;
+    } else if (kGdParallelModuleStartFlag == *flags) {
+      gd_parallel_module_start_enabled = true;
+    } else if (kHciCommandPipeliningFlag == *flags) {
+      hci_command_pipelining_enabled = true;
+    } else if (kSdpDiscoveryCacheFlag == *flags) {
+      sdp_discovery_cache_enabled = true;
+    } else if (kMetricsPerEventFlag == *flags) {
+      metrics_per_event_enabled = true;
+    } else if (kOsiAllocationProfilingFlag == *flags) {
+      osi_allocation_profiling_enabled = true;
     }
     flags++;
   }
@@ -56,10 +92,18 @@ void InitFlags::Load(const char** flags) {
   }
 
   LOG_INFO(
-      "Flags loaded: gd_hci_enabled: %s, gd_controller_enabled: %s, gd_core_enabled: %s",
+      "Flags loaded: gd_hci_enabled: %s, gd_controller_enabled: %s, gd_core_enabled: %s, "
+      "osi_slab_allocator_enabled: %s, gd_parallel_module_start_enabled: %s, hci_command_pipelining_enabled: %s, "
+      "sdp_discovery_cache_enabled: %s, metrics_per_event_enabled: %s, osi_allocation_profiling_enabled: %s",
       gd_hci_enabled ? "true" : "false",
       gd_controller_enabled ? "true" : "false",
-      gd_core_enabled ? "true" : "false");
+      gd_core_enabled ? "true" : "false",
+      osi_slab_allocator_enabled ? "true" : "false",
+      gd_parallel_module_start_enabled ? "true" : "false",
+      hci_command_pipelining_enabled ? "true" : "false",
+      sdp_discovery_cache_enabled ? "true" : "false",
+      metrics_per_event_enabled ? "true" : "false",
+      osi_allocation_profiling_enabled ? "true" : "false");
 }
 
 }  // namespace common
@@ -35,10 +35,40 @@ class InitFlags final {
     return gd_core_enabled;
   }
 
+  static bool OsiSlabAllocatorEnabled() {
+    return osi_slab_allocator_enabled;
+  }
+
+  static bool GdParallelModuleStartEnabled() {
+    return gd_parallel_module_start_enabled;
+  }
+
+  static bool HciCommandPipeliningEnabled() {
+    return hci_command_pipelining_enabled;
+  }
+
+  static bool SdpDiscoveryCacheEnabled() {
+    return sdp_discovery_cache_enabled;
+  }
+
+  static bool MetricsPerEventEnabled() {
+    return metrics_per_event_enabled;
+  }
+
+  static bool OsiAllocationProfilingEnabled() {
+    return osi_allocation_profiling_enabled;
+  }
+
  private:
   static bool gd_hci_enabled;
   static bool gd_controller_enabled;
   static bool gd_core_enabled;
+  static bool osi_slab_allocator_enabled;
+  static bool gd_parallel_module_start_enabled;
+  static bool hci_command_pipelining_enabled;
+  static bool sdp_discovery_cache_enabled;
+  static bool metrics_per_event_enabled;
+  static bool osi_allocation_profiling_enabled;
 };
 
 }  // namespace common
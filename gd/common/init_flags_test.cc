@@ -44,3 +44,45 @@ TEST(InitFlagsTest, test_load_good_case) {
   InitFlags::Load(input);
   ASSERT_EQ(true, InitFlags::GdCoreEnabled());
 }
+
+TEST(InitFlagsTest, test_load_osi_slab_allocator) {
+  const char* input[] = {"INIT_osi_slab_allocator", nullptr};
+  InitFlags::Load(input);
+  ASSERT_EQ(true, InitFlags::OsiSlabAllocatorEnabled());
+  ASSERT_EQ(false, InitFlags::GdCoreEnabled());
+}
+
+TEST(InitFlagsTest, test_load_gd_parallel_module_start) {
+  const char* input[] = {"INIT_gd_parallel_module_start", nullptr};
+  InitFlags::Load(input);
+  ASSERT_EQ(true, InitFlags::GdParallelModuleStartEnabled());
+  ASSERT_EQ(false, InitFlags::GdCoreEnabled());
+}
+
+TEST(InitFlagsTest, test_load_hci_command_pipelining) {
+  const char* input[] = {"INIT_hci_command_pipelining", nullptr};
+  InitFlags::Load(input);
+  ASSERT_EQ(true, InitFlags::HciCommandPipeliningEnabled());
+  ASSERT_EQ(false, InitFlags::GdCoreEnabled());
+}
+
+TEST(InitFlagsTest, test_load_sdp_discovery_cache) {
+  const char* input[] = {"INIT_sdp_discovery_cache", nullptr};
+  InitFlags::Load(input);
+  ASSERT_EQ(true, InitFlags::SdpDiscoveryCacheEnabled());
+  ASSERT_EQ(false, InitFlags::HciCommandPipeliningEnabled());
+}
+
+TEST(InitFlagsTest, test_load_metrics_per_event) {
+  const char* input[] = {"INIT_metrics_per_event", nullptr};
+  InitFlags::Load(input);
+  ASSERT_EQ(true, InitFlags::MetricsPerEventEnabled());
+  ASSERT_EQ(false, InitFlags::SdpDiscoveryCacheEnabled());
+}
+
+TEST(InitFlagsTest, test_load_osi_allocation_profiling) {
+  const char* input[] = {"INIT_osi_allocation_profiling", nullptr};
+  InitFlags::Load(input);
+  ASSERT_EQ(true, InitFlags::OsiAllocationProfilingEnabled());
+  ASSERT_EQ(false, InitFlags::OsiSlabAllocatorEnabled());
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace common {
+
+// A move-only closure that can be run once. Unlike OnceClosure, a callable of up to kInlineSize bytes is kept in
+// place instead of on the heap, which covers an object pointer, a member function pointer and a few arguments.
+// Bigger callables, and those that may throw when moved, are moved to the heap.
+class InlineClosure {
+ public:
+  static constexpr size_t kInlineSize = 6 * sizeof(void*);
+
+  template <typename F>
+  static constexpr bool IsStoredInline() {
+    return sizeof(F) <= kInlineSize && alignof(F) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible<F>::value;
+  }
+
+  InlineClosure() = default;
+
+  template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, InlineClosure>::value>>
+  InlineClosure(F&& callable) {
+    using Callable = std::decay_t<F>;
+    if constexpr (IsStoredInline<Callable>()) {
+      new (storage_) Callable(std::forward<F>(callable));
+      ops_ = &inline_ops<Callable>;
+    } else {
+      new (storage_) Callable*(new Callable(std::forward<F>(callable)));
+      ops_ = &heap_ops<Callable>;
+    }
+  }
+
+  InlineClosure(InlineClosure&& other) noexcept {
+    take(std::move(other));
+  }
+
+  InlineClosure& operator=(InlineClosure&& other) noexcept {
+    if (this != &other) {
+      reset();
+      take(std::move(other));
+    }
+    return *this;
+  }
+
+  ~InlineClosure() {
+    reset();
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(InlineClosure);
+
+  explicit operator bool() const {
+    return ops_ != nullptr;
+  }
+
+  // Runs the callable and releases it, leaving the closure empty
+  void Run() && {
+    InlineClosure closure(std::move(*this));
+    closure.ops_->run(closure.storage_);
+  }
+
+ private:
+  struct Ops {
+    void (*run)(void* storage);
+    // Moves the callable from |from| into the uninitialized |to| and destroys it in |from|
+    void (*relocate)(void* from, void* to);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename Callable>
+  static constexpr Ops inline_ops = {
+      [](void* storage) { (*static_cast<Callable*>(storage))(); },
+      [](void* from, void* to) {
+        new (to) Callable(std::move(*static_cast<Callable*>(from)));
+        static_cast<Callable*>(from)->~Callable();
+      },
+      [](void* storage) { static_cast<Callable*>(storage)->~Callable(); },
+  };
+
+  template <typename Callable>
+  static constexpr Ops heap_ops = {
+      [](void* storage) { (**static_cast<Callable**>(storage))(); },
+      [](void* from, void* to) { new (to) Callable*(*static_cast<Callable**>(from)); },
+      [](void* storage) { delete *static_cast<Callable**>(storage); },
+  };
+
+  void take(InlineClosure&& other) {
+    ops_ = other.ops_;
+    if (ops_ != nullptr) {
+      ops_->relocate(other.storage_, storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  void reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+};
+
+}  // namespace common
+}  // namespace bluetooth
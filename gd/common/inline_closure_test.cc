@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/inline_closure.h"
+
+#include <array>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace common {
+namespace {
+
+TEST(InlineClosureTest, empty) {
+  InlineClosure closure;
+  EXPECT_FALSE(closure);
+}
+
+TEST(InlineClosureTest, run_small_callable) {
+  int runs = 0;
+  auto callable = [&runs] { runs++; };
+  static_assert(InlineClosure::IsStoredInline<decltype(callable)>(), "a reference capture should be inline");
+  InlineClosure closure(callable);
+  EXPECT_TRUE(closure);
+  std::move(closure).Run();
+  EXPECT_EQ(runs, 1);
+  EXPECT_FALSE(closure);
+}
+
+TEST(InlineClosureTest, run_large_callable) {
+  std::array<int, 64> values{};
+  values[63] = 7;
+  int result = 0;
+  auto callable = [values, &result] { result = values[63]; };
+  static_assert(!InlineClosure::IsStoredInline<decltype(callable)>(), "a large capture should be on the heap");
+  InlineClosure closure(callable);
+  InlineClosure moved(std::move(closure));
+  EXPECT_FALSE(closure);
+  std::move(moved).Run();
+  EXPECT_EQ(result, 7);
+}
+
+TEST(InlineClosureTest, move_only_capture_destroyed_once) {
+  auto counter = std::make_shared<int>(0);
+  {
+    InlineClosure closure([value = std::make_unique<int>(1), counter] { (*counter)++; });
+    InlineClosure other;
+    other = std::move(closure);
+    EXPECT_EQ(counter.use_count(), 2);
+  }
+  EXPECT_EQ(*counter, 0);
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(InlineClosureTest, run_releases_capture) {
+  auto counter = std::make_shared<int>(0);
+  InlineClosure closure([counter] { (*counter)++; });
+  std::move(closure).Run();
+  EXPECT_EQ(*counter, 1);
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace bluetooth
@@ -0,0 +1,467 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bluetooth {
+namespace common {
+
+// A map that maintains order of its element as a list, like ListMap. Unlike ListMap, an element, its list links and
+// its hash chain link share a single node, hence an element costs one allocation and its key is stored once. Nodes
+// can also come from a pool reserved at construction, which is used before the heap.
+//
+// Performance:
+//   - Key look-up and modification is O(1)
+//   - Value operated by replacement, no in-place modification
+//   - Memory consumption is:
+//     O(capacity*(sizeof(K)+sizeof(V)+4*sizeof(nullptr)+sizeof(size_t)))
+//   - NOT THREAD SAFE
+//
+// Template:
+//   - Key key
+//   - T value
+//   - Hash hash of the key
+template <typename Key, typename T, typename Hash = std::hash<Key>>
+class IntrusiveListMap {
+ private:
+  struct Link {
+    Link* prev;
+    Link* next;
+  };
+  struct Node;
+
+ public:
+  using value_type = std::pair<const Key, T>;
+  // different from c++17 node_type on purpose as we want node to be copyable
+  using node_type = std::pair<Key, T>;
+
+  template <bool kConst>
+  class Iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = IntrusiveListMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<kConst, const value_type*, value_type*>;
+    using reference = std::conditional_t<kConst, const value_type&, value_type&>;
+
+    Iterator() = default;
+
+    // An iterator converts to a const_iterator
+    template <bool kOtherConst, typename = std::enable_if_t<kConst && !kOtherConst>>
+    Iterator(const Iterator<kOtherConst>& other) : link_(other.link_) {}
+
+    reference operator*() const {
+      return static_cast<Node*>(link_)->value;
+    }
+    pointer operator->() const {
+      return &static_cast<Node*>(link_)->value;
+    }
+    Iterator& operator++() {
+      link_ = link_->next;
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator previous = *this;
+      link_ = link_->next;
+      return previous;
+    }
+    Iterator& operator--() {
+      link_ = link_->prev;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator previous = *this;
+      link_ = link_->prev;
+      return previous;
+    }
+    bool operator==(const Iterator& rhs) const {
+      return link_ == rhs.link_;
+    }
+    bool operator!=(const Iterator& rhs) const {
+      return link_ != rhs.link_;
+    }
+
+   private:
+    friend class IntrusiveListMap;
+    template <bool>
+    friend class Iterator;
+    explicit Iterator(Link* link) : link_(link) {}
+    Link* link_ = nullptr;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  // Constructor of the list map, the first |pool_size| elements use nodes reserved now
+  explicit IntrusiveListMap(size_t pool_size = 0) : pool_size_(pool_size) {
+    reset();
+    if (pool_size_ > 0) {
+      pool_.reset(new NodeStorage[pool_size_]);
+      size_t num_buckets = kMinBuckets;
+      while (num_buckets < pool_size_) {
+        num_buckets *= 2;
+      }
+      buckets_.assign(num_buckets, nullptr);
+    }
+  }
+
+  // for move
+  IntrusiveListMap(IntrusiveListMap&& other) noexcept {
+    take(std::move(other));
+  }
+  IntrusiveListMap& operator=(IntrusiveListMap&& other) noexcept {
+    if (&other != this) {
+      clear();
+      take(std::move(other));
+    }
+    return *this;
+  }
+
+  // copy-constructor, reserves the same pool size
+  IntrusiveListMap(const IntrusiveListMap& other) : IntrusiveListMap(other.pool_size_) {
+    for (const auto& element : other) {
+      try_emplace_back(element.first, element.second);
+    }
+  }
+
+  // copy-assignment
+  IntrusiveListMap& operator=(const IntrusiveListMap& other) {
+    if (&other == this) {
+      return *this;
+    }
+    clear();
+    for (const auto& element : other) {
+      try_emplace_back(element.first, element.second);
+    }
+    return *this;
+  }
+
+  // comparison operators
+  bool operator==(const IntrusiveListMap& rhs) const {
+    return size_ == rhs.size_ && std::equal(begin(), end(), rhs.begin());
+  }
+  bool operator!=(const IntrusiveListMap& rhs) const {
+    return !(*this == rhs);
+  }
+
+  ~IntrusiveListMap() {
+    clear();
+  }
+
+  // Clear the list map, reserved nodes stay reserved
+  void clear() {
+    for (Link* link = head_.next; link != &head_;) {
+      Node* node = static_cast<Node*>(link);
+      link = link->next;
+      free_node(node);
+    }
+    head_.prev = &head_;
+    head_.next = &head_;
+    std::fill(buckets_.begin(), buckets_.end(), nullptr);
+    size_ = 0;
+  }
+
+  // const version of find()
+  const_iterator find(const Key& key) const {
+    return const_cast<IntrusiveListMap*>(this)->find(key);
+  }
+
+  // Get the value of a key. Return iterator to the item if found, end() if not found
+  iterator find(const Key& key) {
+    Node* node = find_node(key, hash_(key));
+    return node != nullptr ? iterator(node) : end();
+  }
+
+  // Check if key exist in the map. Return true if key exist in map, false if not.
+  bool contains(const Key& key) const {
+    return find(key) != end();
+  }
+
+  // Try emplace an element before a specific position |pos| of the list map. If the |key| already exists, does nothing.
+  // Moved arguments won't be moved when key already exists. Return <iterator, true> when key does not exist, <iterator,
+  // false> when key exist and iterator is the position where it was placed.
+  template <class... Args>
+  std::pair<iterator, bool> try_emplace(const_iterator pos, const Key& key, Args&&... args) {
+    size_t hash = hash_(key);
+    if (find_node(key, hash) != nullptr) {
+      return std::make_pair(end(), false);
+    }
+    Node* node = new (allocate_node()) Node(hash, key, std::forward<Args>(args)...);
+    link_before(pos.link_, node);
+    add_node(node);
+    return std::make_pair(iterator(node), true);
+  }
+
+  // Try emplace an element before the end of the list map. If the key already exists, does nothing. Moved arguments
+  // won't be moved when key already exists return <iterator, true> when key does not exist, <iterator, false> when key
+  // exist and iterator is the position where it was placed
+  template <class... Args>
+  std::pair<iterator, bool> try_emplace_back(const Key& key, Args&&... args) {
+    return try_emplace(end(), key, std::forward<Args>(args)...);
+  }
+
+  // Put a key-value pair to the map before position. If key already exist, |pos| will be ignored and existing value
+  // will be replaced
+  void insert_or_assign(const_iterator pos, const Key& key, T value) {
+    Node* node = find_node(key, hash_(key));
+    if (node != nullptr) {
+      node->value.second = std::move(value);
+      return;
+    }
+    try_emplace(pos, key, std::move(value));
+  }
+
+  // Put a key-value pair to the tail of the map or replace the current value without moving the key if key exists
+  void insert_or_assign(const Key& key, T value) {
+    insert_or_assign(end(), key, std::move(value));
+  }
+
+  // STL splice, same as std::list::splice
+  // - pos: element before which the content will be inserted
+  // - other: another container to transfer the content from
+  // - it: the element to transfer from other to *this
+  // A node reserved by |other| can't change owner, hence its element is moved to a node of *this instead
+  void splice(const_iterator pos, IntrusiveListMap& other, const_iterator it) {
+    Node* node = static_cast<Node*>(it.link_);
+    if (&other == this) {
+      if (pos.link_ != it.link_) {
+        unlink(node);
+        link_before(pos.link_, node);
+      }
+      return;
+    }
+    if (other.is_in_pool(node)) {
+      try_emplace(pos, node->value.first, std::move(node->value.second));
+      other.remove(node);
+      return;
+    }
+    other.remove_from_bucket(node);
+    unlink(node);
+    other.size_--;
+    link_before(pos.link_, node);
+    add_node(node);
+  }
+
+  // Remove a key from the list map and return removed value if key exits, std::nullopt if not. The return value will be
+  // evaluated to true in a boolean context if a value is contained by std::optional, false otherwise.
+  std::optional<node_type> extract(const Key& key) {
+    Node* node = find_node(key, hash_(key));
+    if (node == nullptr) {
+      return std::nullopt;
+    }
+    std::optional<node_type> removed_node(std::in_place, node->value.first, std::move(node->value.second));
+    remove(node);
+    return removed_node;
+  }
+
+  // Remove an iterator pointed item from the list map and return the iterator immediately after the erased item
+  iterator erase(const_iterator iter) {
+    Link* next = iter.link_->next;
+    remove(static_cast<Node*>(iter.link_));
+    return iterator(next);
+  }
+
+  // Return size of the list map
+  inline size_t size() const {
+    return size_;
+  }
+
+  // Return iterator interface for begin
+  inline iterator begin() {
+    return iterator(head_.next);
+  }
+
+  // Iterator interface for begin, const
+  inline const_iterator begin() const {
+    return const_iterator(head_.next);
+  }
+
+  // Return iterator interface for end
+  inline iterator end() {
+    return iterator(&head_);
+  }
+
+  // Iterator interface for end, const
+  inline const_iterator end() const {
+    return const_iterator(const_cast<Link*>(&head_));
+  }
+
+ private:
+  static constexpr size_t kMinBuckets = 8;
+
+  struct Node : Link {
+    template <class... Args>
+    explicit Node(size_t hash, const Key& key, Args&&... args)
+        : hash(hash),
+          value(
+              std::piecewise_construct,
+              std::forward_as_tuple(key),
+              std::forward_as_tuple(std::forward<Args>(args)...)) {}
+    Node* hash_next = nullptr;
+    size_t hash;
+    value_type value;
+  };
+
+  // A node that is not constructed, in the pool or on the free list
+  union NodeStorage {
+    NodeStorage* next_free;
+    alignas(Node) unsigned char bytes[sizeof(Node)];
+  };
+
+  void reset() {
+    head_.prev = &head_;
+    head_.next = &head_;
+    size_ = 0;
+  }
+
+  void take(IntrusiveListMap&& other) {
+    pool_size_ = other.pool_size_;
+    pool_ = std::move(other.pool_);
+    pool_used_ = other.pool_used_;
+    free_list_ = other.free_list_;
+    buckets_ = std::move(other.buckets_);
+    if (other.size_ == 0) {
+      reset();
+    } else {
+      head_ = other.head_;
+      head_.next->prev = &head_;
+      head_.prev->next = &head_;
+      size_ = other.size_;
+    }
+    other.pool_size_ = 0;
+    other.pool_used_ = 0;
+    other.free_list_ = nullptr;
+    other.buckets_.clear();
+    other.reset();
+  }
+
+  bool is_in_pool(void* storage) const {
+    return pool_ && storage >= static_cast<void*>(pool_.get()) &&
+           storage < static_cast<void*>(pool_.get() + pool_size_);
+  }
+
+  void* allocate_node() {
+    if (free_list_ != nullptr) {
+      NodeStorage* storage = free_list_;
+      free_list_ = storage->next_free;
+      return storage;
+    }
+    if (pool_used_ < pool_size_) {
+      return &pool_[pool_used_++];
+    }
+    return ::operator new(sizeof(NodeStorage));
+  }
+
+  void free_node(Node* node) {
+    node->~Node();
+    if (is_in_pool(node)) {
+      NodeStorage* storage = reinterpret_cast<NodeStorage*>(node);
+      storage->next_free = free_list_;
+      free_list_ = storage;
+    } else {
+      ::operator delete(static_cast<void*>(node));
+    }
+  }
+
+  Node* find_node(const Key& key, size_t hash) const {
+    if (buckets_.empty()) {
+      return nullptr;
+    }
+    for (Node* node = buckets_[hash & (buckets_.size() - 1)]; node != nullptr; node = node->hash_next) {
+      if (node->hash == hash && node->value.first == key) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  void insert_in_bucket(Node* node) {
+    if (buckets_.empty()) {
+      buckets_.assign(kMinBuckets, nullptr);
+    }
+    Node*& bucket = buckets_[node->hash & (buckets_.size() - 1)];
+    node->hash_next = bucket;
+    bucket = node;
+  }
+
+  void rehash(size_t num_buckets) {
+    buckets_.assign(num_buckets, nullptr);
+    for (Link* link = head_.next; link != &head_; link = link->next) {
+      insert_in_bucket(static_cast<Node*>(link));
+    }
+  }
+
+  static void link_before(Link* pos, Link* link) {
+    link->prev = pos->prev;
+    link->next = pos;
+    pos->prev->next = link;
+    pos->prev = link;
+  }
+
+  static void unlink(Link* link) {
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+  }
+
+  // Count a node already linked in the list and index it, growing the buckets to keep chains short
+  void add_node(Node* node) {
+    insert_in_bucket(node);
+    size_++;
+    if (size_ > buckets_.size()) {
+      rehash(buckets_.size() * 2);
+    }
+  }
+
+  void remove_from_bucket(Node* node) {
+    Node** slot = &buckets_[node->hash & (buckets_.size() - 1)];
+    while (*slot != node) {
+      slot = &(*slot)->hash_next;
+    }
+    *slot = node->hash_next;
+  }
+
+  void remove(Node* node) {
+    remove_from_bucket(node);
+    unlink(node);
+    free_node(node);
+    size_--;
+  }
+
+  // Sentinel of the circular element list, begin() is head_.next and end() is head_ itself
+  Link head_;
+  size_t size_ = 0;
+  std::vector<Node*> buckets_;
+  size_t pool_size_ = 0;
+  std::unique_ptr<NodeStorage[]> pool_;
+  size_t pool_used_ = 0;
+  NodeStorage* free_list_ = nullptr;
+  Hash hash_;
+};
+
+}  // namespace common
+}  // namespace bluetooth
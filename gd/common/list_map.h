@@ -34,8 +34,9 @@ namespace common {
 // Performance:
 //   - Key look-up and modification is O(1)
 //   - Value operated by replacement, no in-place modification
+//   - Keys are stored once, in the list, and indexed by reference
 //   - Memory consumption is:
-//     O(2*capacity*sizeof(K) + capacity*(sizeof(nullptr)+sizeof(V)))
+//     O(capacity*sizeof(K) + capacity*(2*sizeof(nullptr)+sizeof(V)))
 //   - NOT THREAD SAFE
 //
 // Template:
@@ -71,8 +72,9 @@ class ListMap {
     if (&other == this) {
       return *this;
     }
-    node_list_ = other.node_list_;
+    // keys of key_map_ refer to nodes that the assignment may release
     key_map_.clear();
+    node_list_ = other.node_list_;
     for (auto iter = node_list_.begin(); iter != node_list_.end(); iter++) {
       key_map_.emplace(iter->first, iter);
     }
@@ -126,7 +128,7 @@ class ListMap {
       return std::make_pair(end(), false);
     }
     auto list_iterator = node_list_.emplace(pos, key, std::forward<Args>(args)...);
-    key_map_.emplace(key, list_iterator);
+    key_map_.emplace(list_iterator->first, list_iterator);
     return std::make_pair(list_iterator, true);
   }
 
@@ -147,7 +149,7 @@ class ListMap {
       return;
     }
     auto list_iterator = node_list_.emplace(pos, key, std::move(value));
-    key_map_.emplace(key, list_iterator);
+    key_map_.emplace(list_iterator->first, list_iterator);
   }
 
   // Put a key-value pair to the tail of the map or replace the current value without moving the key if key exists
@@ -174,9 +176,11 @@ class ListMap {
     if (map_iterator == key_map_.end()) {
       return std::nullopt;
     }
-    std::optional<node_type> removed_node(std::move(*map_iterator->second));
-    node_list_.erase(map_iterator->second);
+    auto list_iterator = map_iterator->second;
+    std::optional<node_type> removed_node(std::move(*list_iterator));
+    // erase the key first as it refers to the node
     key_map_.erase(map_iterator);
+    node_list_.erase(list_iterator);
     return removed_node;
   }
 
@@ -213,7 +217,8 @@ class ListMap {
 
  private:
   std::list<value_type> node_list_;
-  std::unordered_map<Key, iterator> key_map_;
+  // Keys refer to the keys in node_list_, whose nodes never move
+  std::unordered_map<std::reference_wrapper<const Key>, iterator, std::hash<Key>, std::equal_to<Key>> key_map_;
 };
 
 }  // namespace common
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <malloc.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/intrusive_list_map.h"
+#include "common/list_map.h"
+
+using ::benchmark::State;
+using ::bluetooth::common::IntrusiveListMap;
+using ::bluetooth::common::ListMap;
+
+namespace {
+
+// The maps compared, keyed like the properties of a ConfigCache section
+struct StdListMap {
+  using Map = ListMap<std::string, std::string>;
+  static std::unique_ptr<Map> Make(size_t) {
+    return std::make_unique<Map>();
+  }
+};
+
+struct Intrusive {
+  using Map = IntrusiveListMap<std::string, std::string>;
+  static std::unique_ptr<Map> Make(size_t) {
+    return std::make_unique<Map>();
+  }
+};
+
+struct IntrusiveReserved {
+  using Map = IntrusiveListMap<std::string, std::string>;
+  static std::unique_ptr<Map> Make(size_t num_entries) {
+    return std::make_unique<Map>(num_entries);
+  }
+};
+
+std::vector<std::string> MakeKeys(size_t num_entries) {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < num_entries; i++) {
+    keys.push_back("Property" + std::to_string(i));
+  }
+  return keys;
+}
+
+constexpr size_t kMeasuredContainers = 100;
+
+size_t AllocatedBytes() {
+  return mallinfo().uordblks;
+}
+
+// Heap bytes an entry costs once |num_entries| are in a map, including what the map reserved. Many maps are measured
+// at once as the allocator may reuse a few blocks freed earlier without accounting for them.
+template <typename Factory>
+double BytesPerEntry(const std::vector<std::string>& keys) {
+  std::vector<std::unique_ptr<typename Factory::Map>> maps;
+  maps.reserve(kMeasuredContainers);
+  size_t before = AllocatedBytes();
+  for (size_t i = 0; i < kMeasuredContainers; i++) {
+    maps.push_back(Factory::Make(keys.size()));
+    for (const auto& key : keys) {
+      maps.back()->insert_or_assign(key, "0");
+    }
+  }
+  size_t after = AllocatedBytes();
+  return static_cast<double>(after - before) / (kMeasuredContainers * keys.size());
+}
+
+// Fill a map with |num_entries| then clear it
+template <typename Factory>
+void BM_InsertThenClear(State& state) {
+  auto keys = MakeKeys(state.range(0));
+  auto map = Factory::Make(keys.size());
+  for (auto _ : state) {
+    for (const auto& key : keys) {
+      map->insert_or_assign(key, "0");
+    }
+    map->clear();
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+  state.counters["bytes_per_entry"] = BytesPerEntry<Factory>(keys);
+}
+
+// Look up every key of a map with |num_entries|
+template <typename Factory>
+void BM_Find(State& state) {
+  auto keys = MakeKeys(state.range(0));
+  auto map = Factory::Make(keys.size());
+  for (const auto& key : keys) {
+    map->insert_or_assign(key, "0");
+  }
+  for (auto _ : state) {
+    for (const auto& key : keys) {
+      benchmark::DoNotOptimize(map->find(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Remove every key of a map with |num_entries| and put it back at the tail
+template <typename Factory>
+void BM_ExtractThenInsert(State& state) {
+  auto keys = MakeKeys(state.range(0));
+  auto map = Factory::Make(keys.size());
+  for (const auto& key : keys) {
+    map->insert_or_assign(key, "0");
+  }
+  for (auto _ : state) {
+    for (const auto& key : keys) {
+      auto node = map->extract(key);
+      map->insert_or_assign(key, std::move(node->second));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Sections have about ten properties, tens of sections make a config
+BENCHMARK_TEMPLATE(BM_InsertThenClear, StdListMap)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_InsertThenClear, Intrusive)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_InsertThenClear, IntrusiveReserved)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_Find, StdListMap)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_Find, Intrusive)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_ExtractThenInsert, StdListMap)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_ExtractThenInsert, Intrusive)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_ExtractThenInsert, IntrusiveReserved)->Arg(10)->Arg(100);
+
+}  // namespace
@@ -43,7 +43,7 @@ namespace common {
 // Performance:
 //   - Key look-up and modification is O(1)
 //   - Memory consumption is:
-//     O(2*capacity*sizeof(K) + capacity*(sizeof(nullptr)+sizeof(V)))
+//     O(capacity*sizeof(K) + capacity*(2*sizeof(nullptr)+sizeof(V)))
 //
 // Template:
 //   - Key key type
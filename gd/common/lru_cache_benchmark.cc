@@ -0,0 +1,104 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <malloc.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/intrusive_lru_cache.h"
+#include "common/lru_cache.h"
+
+using ::benchmark::State;
+using ::bluetooth::common::IntrusiveLruCache;
+using ::bluetooth::common::LruCache;
+
+namespace {
+
+using StdLruCache = LruCache<std::string, std::string>;
+using Intrusive = IntrusiveLruCache<std::string, std::string>;
+
+std::vector<std::string> MakeKeys(size_t num_keys) {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < num_keys; i++) {
+    keys.push_back("AA:BB:CC:DD:" + std::to_string(i / 256) + ":" + std::to_string(i % 256));
+  }
+  return keys;
+}
+
+constexpr size_t kMeasuredContainers = 100;
+
+size_t AllocatedBytes() {
+  return mallinfo().uordblks;
+}
+
+// Heap bytes an entry costs once a cache of |capacity| is full, including what the cache reserved. Many caches are
+// measured at once as the allocator may reuse a few blocks freed earlier without accounting for them.
+template <typename Cache>
+double BytesPerEntry(const std::vector<std::string>& keys) {
+  std::vector<std::unique_ptr<Cache>> caches;
+  caches.reserve(kMeasuredContainers);
+  size_t before = AllocatedBytes();
+  for (size_t i = 0; i < kMeasuredContainers; i++) {
+    caches.push_back(std::make_unique<Cache>(keys.size()));
+    for (const auto& key : keys) {
+      caches.back()->insert_or_assign(key, "0");
+    }
+  }
+  size_t after = AllocatedBytes();
+  return static_cast<double>(after - before) / (kMeasuredContainers * keys.size());
+}
+
+// Insert twice as many keys as a cache of |capacity| holds, hence half of the insertions evict
+template <typename Cache>
+void BM_InsertAndEvict(State& state) {
+  auto keys = MakeKeys(state.range(0) * 2);
+  Cache cache(state.range(0));
+  for (auto _ : state) {
+    for (const auto& key : keys) {
+      benchmark::DoNotOptimize(cache.insert_or_assign(key, "0"));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+  keys.resize(state.range(0));
+  state.counters["bytes_per_entry"] = BytesPerEntry<Cache>(keys);
+}
+
+// Look up every key of a full cache of |capacity|, each look up warming its key
+template <typename Cache>
+void BM_FindAndWarm(State& state) {
+  auto keys = MakeKeys(state.range(0));
+  Cache cache(state.range(0));
+  for (const auto& key : keys) {
+    cache.insert_or_assign(key, "0");
+  }
+  for (auto _ : state) {
+    for (const auto& key : keys) {
+      benchmark::DoNotOptimize(cache.find(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Caches of devices range from a few entries to a few hundreds
+BENCHMARK_TEMPLATE(BM_InsertAndEvict, StdLruCache)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_InsertAndEvict, Intrusive)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_FindAndWarm, StdLruCache)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_FindAndWarm, Intrusive)->Arg(10)->Arg(100);
+
+}  // namespace
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <limits>
 #include <type_traits>
 
@@ -44,5 +45,16 @@ bool IsNumberInNumericLimits(InputType input) {
   return true;
 }
 
+// Scramble all bits of |value| into all bits of the result (splitmix64 finalizer), so that keys differing in a few
+// bits, like addresses of the same vendor, spread over all buckets of a hash table
+constexpr uint64_t MixHash(uint64_t value) {
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebULL;
+  value ^= value >> 31;
+  return value;
+}
+
 }  // namespace common
 }  // namespace bluetooth
\ No newline at end of file
@@ -47,6 +47,33 @@ std::string ToHexString(InputIt first, InputIt last) {
 // Convenience method for normal cases and initializer list, e.g. ToHexString({0x12, 0x34, 0x56, 0xab})
 std::string ToHexString(const std::vector<uint8_t>& value);
 
+// Write the two lower case hex decimal chars of |byte| at |out|, returning the position after them
+inline char* ByteToHexChars(uint8_t byte, char* out) {
+  static constexpr char kHexDigits[] = "0123456789abcdef";
+  out[0] = kHexDigits[byte >> 4];
+  out[1] = kHexDigits[byte & 0x0f];
+  return out + 2;
+}
+
+// Return the value of hex decimal char |c| [0-9a-fA-F], or -1 if |c| is not one
+inline int HexCharValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Parse the two hex decimal chars at |str| into |byte|, return false without modifying |byte| if they are not
+inline bool HexCharsToByte(const char* str, uint8_t& byte) {
+  int high = HexCharValue(str[0]);
+  int low = HexCharValue(str[1]);
+  if (high < 0 || low < 0) {
+    return false;
+  }
+  byte = static_cast<uint8_t>((high << 4) | low);
+  return true;
+}
+
 // Return true if |str| is a valid hex demical strings contains only hex decimal chars [0-9a-fA-F]
 bool IsValidHexString(const std::string& str);
 
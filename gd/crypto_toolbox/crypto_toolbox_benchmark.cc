@@ -0,0 +1,57 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "crypto_toolbox/crypto_toolbox.h"
+
+using ::benchmark::State;
+using ::bluetooth::crypto_toolbox::aes_128;
+using ::bluetooth::crypto_toolbox::aes_cmac;
+using ::bluetooth::crypto_toolbox::Octet16;
+
+namespace {
+
+constexpr Octet16 kKey{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+// A single block, as used by address resolution (ah) and the legacy pairing functions
+void BM_Aes128(State& state) {
+  Octet16 message{};
+  for (auto _ : state) {
+    message = aes_128(kKey, message);
+    benchmark::DoNotOptimize(message);
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+
+// Signing of ATT Signed Write Commands, over a message of |state.range(0)| bytes
+void BM_AesCmac(State& state) {
+  std::vector<uint8_t> message(state.range(0), 0xa5);
+  for (auto _ : state) {
+    Octet16 signature = aes_cmac(kKey, message.data(), message.size());
+    benchmark::DoNotOptimize(signature);
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+
+BENCHMARK(BM_Aes128);
+// Signed data of a Signed Write Command is ATT_MTU - 8 bytes at most: for the default ATT_MTU of 23, for an ATT_MTU
+// filling a 251 byte LE data PDU and for the largest ATT_MTU of 517
+BENCHMARK(BM_AesCmac)->Arg(15)->Arg(243)->Arg(509);
+
+}  // namespace
@@ -195,3 +195,9 @@ void bluetooth::dumpsys::FilterInPlace(
   auto filter = Filter::Factory(filter_type, reflection_schema);
   filter->FilterInPlace(dumpsys_data->data());
 }
+
+void bluetooth::dumpsys::FilterInPlace(
+    FilterType filter_type, const ReflectionSchema& reflection_schema, uint8_t* dumpsys_data) {
+  auto filter = Filter::Factory(filter_type, reflection_schema);
+  filter->FilterInPlace(reinterpret_cast<char*>(dumpsys_data));
+}
@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 
+#include <cstdint>
 #include <string>
+
 #include "dumpsys/reflection_schema.h"
 
 namespace bluetooth {
@@ -24,5 +26,8 @@ enum FilterType { AS_USER = 0, AS_DEVELOPER };
 
 void FilterInPlace(FilterType filter_type, const ReflectionSchema& reflection_schema, std::string* dumpsys_data);
 
+// Same as above on a finished flatbuffer that is still in its builder, hence without copying it out first
+void FilterInPlace(FilterType filter_type, const ReflectionSchema& reflection_schema, uint8_t* dumpsys_data);
+
 }  // namespace dumpsys
 }  // namespace bluetooth
@@ -18,11 +18,15 @@
 
 #include <grpc++/grpc++.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <utility>
+#include <vector>
 
-#include "common/blocking_queue.h"
 #include "facade/common.pb.h"
 #include "os/log.h"
 
@@ -32,17 +36,27 @@ namespace grpc {
 template <typename T>
 class GrpcEventQueue {
  public:
+  // Events held for a stream that is not keeping up before new ones are dropped
+  static constexpr size_t kDefaultCapacity = 4096;
+  // Events taken from the queue and handed to gRPC at once
+  static constexpr size_t kMaxBatchSize = 64;
+
   /**
    * Create a GrpcEventQueue that can be used to shuffle event from one thread to another
    * @param log_name
+   * @param capacity number of events held before new ones are dropped
    */
-  explicit GrpcEventQueue(std::string log_name) : log_name_(std::move(log_name)){};
+  explicit GrpcEventQueue(std::string log_name, size_t capacity = kDefaultCapacity)
+      : log_name_(std::move(log_name)), capacity_(capacity){};
 
   /**
    * Run the event loop and blocks until client cancels the stream request
    * Event queue will be cleared before entering the loop. Hence, only events occurred after gRPC request will be
    * delivered to the user. Hence user is advised to run the loop before generating pending events.
    *
+   * Events are taken from the queue in batches, and all but the last event of a batch are written with a buffer
+   * hint, so that gRPC sends a burst of events in as few transport writes as it can.
+   *
    * @param context client context
    * @param writer output writer
    * @return gRPC status
@@ -50,17 +64,34 @@ class GrpcEventQueue {
   ::grpc::Status RunLoop(::grpc::ServerContext* context, ::grpc::ServerWriter<T>* writer) {
     using namespace std::chrono_literals;
     LOG_INFO("%s: Entering Loop", log_name_.c_str());
-    pending_events_.clear();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      pending_events_.clear();
+      dropped_events_ = 0;
+      overflowing_ = false;
+    }
     running_ = true;
+    std::vector<T> batch;
     while (!context->IsCancelled()) {
       // Wait for 500 ms so that cancellation can be caught in amortized 250 ms latency
-      if (pending_events_.wait_to_take(500ms)) {
-        LOG_DEBUG("%s: Got event after queue", log_name_.c_str());
-        writer->Write(pending_events_.take());
+      if (!take_batch(500ms, &batch)) {
+        continue;
+      }
+      LOG_DEBUG("%s: Got %zu events after queue", log_name_.c_str(), batch.size());
+      for (size_t i = 0; i < batch.size(); i++) {
+        ::grpc::WriteOptions options;
+        if (i + 1 < batch.size()) {
+          options.set_buffer_hint();
+        }
+        if (!writer->Write(batch[i], options)) {
+          LOG_WARN("%s: Stream closed, dropping %zu events", log_name_.c_str(), batch.size() - i);
+          break;
+        }
       }
+      batch.clear();
     }
     running_ = false;
-    LOG_INFO("%s: Exited Loop", log_name_.c_str());
+    LOG_INFO("%s: Exited Loop, %zu events dropped", log_name_.c_str(), GetDroppedEventCount());
     return ::grpc::Status::OK;
   }
 
@@ -74,13 +105,54 @@ class GrpcEventQueue {
       return;
     }
     LOG_DEBUG("%s: Got event before queue", log_name_.c_str());
-    pending_events_.push(std::move(event));
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (pending_events_.size() >= capacity_) {
+      // Only the start of each overflow is logged, the total is logged when the loop exits
+      if (!overflowing_) {
+        LOG_WARN("%s: Queue full with %zu events, dropping", log_name_.c_str(), capacity_);
+        overflowing_ = true;
+      }
+      dropped_events_++;
+      return;
+    }
+    pending_events_.push_back(std::move(event));
+    if (pending_events_.size() == 1) {
+      not_empty_.notify_one();
+    }
+  }
+
+  /**
+   * Number of events dropped because the queue was full since the loop was entered
+   */
+  size_t GetDroppedEventCount() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return dropped_events_;
   }
 
  private:
+  // Moves up to kMaxBatchSize events to |batch|, waiting up to |timeout| for one. Returns false on timeout.
+  bool take_batch(std::chrono::milliseconds timeout, std::vector<T>* batch) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!not_empty_.wait_for(lock, timeout, [this] { return !pending_events_.empty(); })) {
+      return false;
+    }
+    size_t count = std::min(pending_events_.size(), kMaxBatchSize);
+    for (size_t i = 0; i < count; i++) {
+      batch->push_back(std::move(pending_events_.front()));
+      pending_events_.pop_front();
+    }
+    overflowing_ = false;
+    return true;
+  }
+
   std::string log_name_;
+  size_t capacity_;
   std::atomic<bool> running_ = false;
-  common::BlockingQueue<T> pending_events_;
+  mutable std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::deque<T> pending_events_;
+  size_t dropped_events_ = 0;
+  bool overflowing_ = false;
 };
 
 }  // namespace grpc
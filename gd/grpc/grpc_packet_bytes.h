@@ -0,0 +1,36 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "packet/packet_view.h"
+
+namespace bluetooth {
+namespace grpc {
+
+// Returns the bytes of |view| for a protobuf bytes field, copied a fragment at a time rather than through an Iterator
+// one byte at a time. Move the result into the message (set_payload(PacketViewToBytes(...))) so it is the only copy.
+template <bool little_endian>
+std::string PacketViewToBytes(const packet::PacketView<little_endian>& view) {
+  std::string bytes(view.size(), '\0');
+  view.CopyTo(reinterpret_cast<uint8_t*>(&bytes[0]));
+  return bytes;
+}
+
+}  // namespace grpc
+}  // namespace bluetooth
@@ -31,6 +31,7 @@ class FuzzHciHal : public HciHal {
 
   void sendHciCommand(HciPacket command) override;
   void sendAclData(HciPacket packet) override {}
+  void sendAclDataSegments(const HciPacketSegments& segments) override {}
   void sendScoData(HciPacket packet) override {}
 
   void injectArbitrary(FuzzedDataProvider& fdp);
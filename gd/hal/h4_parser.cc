@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/h4_parser.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+constexpr size_t kAclHeaderSize = 4;
+constexpr size_t kScoHeaderSize = 3;
+constexpr size_t kEventHeaderSize = 2;
+constexpr size_t kCommandHeaderSize = 3;
+}  // namespace
+
+constexpr uint8_t H4Parser::kCommand;
+constexpr uint8_t H4Parser::kAcl;
+constexpr uint8_t H4Parser::kSco;
+constexpr uint8_t H4Parser::kEvent;
+
+H4Parser::H4Parser(PacketCallback on_packet) : on_packet_(std::move(on_packet)) {}
+
+size_t H4Parser::HeaderSize(uint8_t type) {
+  switch (type) {
+    case kCommand:
+      return kCommandHeaderSize;
+    case kAcl:
+      return kAclHeaderSize;
+    case kSco:
+      return kScoHeaderSize;
+    case kEvent:
+      return kEventHeaderSize;
+    default:
+      return 0;
+  }
+}
+
+size_t H4Parser::PayloadSize(uint8_t type, const uint8_t* header) {
+  switch (type) {
+    case kCommand:
+      return header[2];
+    case kAcl:
+      return header[2] | (header[3] << 8);
+    case kSco:
+      return header[2];
+    case kEvent:
+      return header[1];
+    default:
+      return 0;
+  }
+}
+
+bool H4Parser::Consume(const uint8_t* data, size_t length) {
+  const uint8_t* end = data + length;
+  while (data != end) {
+    switch (state_) {
+      case State::TYPE: {
+        type_ = *data++;
+        bytes_wanted_ = HeaderSize(type_);
+        if (bytes_wanted_ == 0) {
+          LOG_ERROR("Unknown H4 packet type 0x%02hhx", type_);
+          return false;
+        }
+        // Most packets are complete in the chunk: copy them at once
+        size_t available = end - data;
+        if (available >= bytes_wanted_) {
+          size_t packet_size = bytes_wanted_ + PayloadSize(type_, data);
+          if (available >= packet_size) {
+            on_packet_(type_, std::vector<uint8_t>(data, data + packet_size));
+            data += packet_size;
+            break;
+          }
+        }
+        packet_.clear();
+        state_ = State::HEADER;
+        break;
+      }
+      case State::HEADER:
+      case State::PAYLOAD: {
+        size_t bytes = std::min(bytes_wanted_, static_cast<size_t>(end - data));
+        packet_.insert(packet_.end(), data, data + bytes);
+        data += bytes;
+        bytes_wanted_ -= bytes;
+        if (bytes_wanted_ != 0) {
+          break;
+        }
+        if (state_ == State::HEADER) {
+          bytes_wanted_ = PayloadSize(type_, packet_.data());
+          state_ = State::PAYLOAD;
+          packet_.reserve(packet_.size() + bytes_wanted_);
+          if (bytes_wanted_ != 0) {
+            break;
+          }
+        }
+        on_packet_(type_, std::move(packet_));
+        packet_ = std::vector<uint8_t>();
+        state_ = State::TYPE;
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+
+// Splits an H4 byte stream into HCI packets. The stream can be fed in chunks of any size, as read from the transport:
+// a packet split across reads is completed by the next ones, and every packet complete in a chunk is delivered as soon
+// as that chunk is consumed. Reading large chunks thus takes a single syscall for many packets.
+class H4Parser {
+ public:
+  static constexpr uint8_t kCommand = 0x01;
+  static constexpr uint8_t kAcl = 0x02;
+  static constexpr uint8_t kSco = 0x03;
+  static constexpr uint8_t kEvent = 0x04;
+
+  // Called with the H4 type and the HCI packet, without the type byte
+  using PacketCallback = std::function<void(uint8_t type, std::vector<uint8_t> packet)>;
+
+  explicit H4Parser(PacketCallback on_packet);
+
+  // Parse |length| bytes of the stream. Returns false if the stream is malformed, after which the parser must not be
+  // used anymore as the packet boundaries are lost.
+  bool Consume(const uint8_t* data, size_t length);
+
+ private:
+  enum class State {
+    TYPE,
+    HEADER,
+    PAYLOAD,
+  };
+
+  // Size of the header of the packets of |type|, 0 if the type is unknown
+  static size_t HeaderSize(uint8_t type);
+  // Size of the payload of the packet of |type| whose header is |header|
+  static size_t PayloadSize(uint8_t type, const uint8_t* header);
+
+  PacketCallback on_packet_;
+  State state_ = State::TYPE;
+  uint8_t type_ = 0;
+  // Bytes of the current state still to be read
+  size_t bytes_wanted_ = 0;
+  std::vector<uint8_t> packet_;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
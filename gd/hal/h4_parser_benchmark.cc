@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hal/h4_parser.h"
+
+using ::benchmark::State;
+using bluetooth::hal::H4Parser;
+
+namespace {
+
+constexpr size_t kStreamSize = 1 << 16;
+
+// A stream of ACL packets of |payload_size| bytes, as many as fit in kStreamSize
+std::vector<uint8_t> AclStream(size_t payload_size, size_t* packet_count) {
+  std::vector<uint8_t> stream;
+  *packet_count = 0;
+  while (stream.size() + 5 + payload_size <= kStreamSize) {
+    stream.insert(stream.end(), {H4Parser::kAcl, 0x01, 0x20});
+    stream.push_back(static_cast<uint8_t>(payload_size));
+    stream.push_back(static_cast<uint8_t>(payload_size >> 8));
+    stream.insert(stream.end(), payload_size, 0xa5);
+    (*packet_count)++;
+  }
+  return stream;
+}
+
+// Feeds the stream in chunks of state.range(1) bytes, the size of each read from the transport
+void BM_H4ParserAcl(State& state) {
+  size_t packet_count;
+  std::vector<uint8_t> stream = AclStream(state.range(0), &packet_count);
+  size_t chunk_size = state.range(1);
+  size_t received = 0;
+  H4Parser parser([&received](uint8_t, std::vector<uint8_t> packet) {
+    benchmark::DoNotOptimize(packet.data());
+    received++;
+  });
+  for (auto _ : state) {
+    for (size_t offset = 0; offset < stream.size(); offset += chunk_size) {
+      parser.Consume(stream.data() + offset, std::min(chunk_size, stream.size() - offset));
+    }
+  }
+  if (received != state.iterations() * packet_count) {
+    state.SkipWithError("Packets were lost");
+  }
+  state.SetItemsProcessed(state.iterations() * packet_count);
+  state.SetBytesProcessed(state.iterations() * stream.size());
+}
+
+BENCHMARK(BM_H4ParserAcl)
+    ->ArgPair(27, 1)
+    ->ArgPair(27, 1 << 16)
+    ->ArgPair(251, 1 << 10)
+    ->ArgPair(251, 1 << 16)
+    ->ArgPair(1021, 1 << 16);
+
+}  // namespace
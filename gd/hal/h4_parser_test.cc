@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/h4_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+using Packet = std::pair<uint8_t, std::vector<uint8_t>>;
+
+class H4ParserTest : public ::testing::Test {
+ protected:
+  H4ParserTest() : parser_([this](uint8_t type, std::vector<uint8_t> packet) {
+    packets_.emplace_back(type, std::move(packet));
+  }) {}
+
+  // An event, an ACL packet with a 16 bit length, a SCO packet and a command, back to back
+  static std::vector<uint8_t> Stream() {
+    std::vector<uint8_t> stream = {H4Parser::kEvent, 0x0e, 0x04, 0x01, 0x03, 0x0c, 0x00};
+    stream.insert(stream.end(), {H4Parser::kAcl, 0x01, 0x20, 0x2c, 0x01});
+    for (int i = 0; i < 300; i++) {
+      stream.push_back(static_cast<uint8_t>(i));
+    }
+    stream.insert(stream.end(), {H4Parser::kSco, 0x02, 0x00, 0x03, 0xaa, 0xbb, 0xcc});
+    stream.insert(stream.end(), {H4Parser::kCommand, 0x03, 0x0c, 0x00});
+    return stream;
+  }
+
+  void ExpectStreamPackets() {
+    ASSERT_EQ(packets_.size(), 4u);
+    EXPECT_EQ(packets_[0].first, H4Parser::kEvent);
+    EXPECT_EQ(packets_[0].second, std::vector<uint8_t>({0x0e, 0x04, 0x01, 0x03, 0x0c, 0x00}));
+    EXPECT_EQ(packets_[1].first, H4Parser::kAcl);
+    ASSERT_EQ(packets_[1].second.size(), 304u);
+    EXPECT_EQ(packets_[1].second[4], 0);
+    EXPECT_EQ(packets_[1].second[303], static_cast<uint8_t>(299));
+    EXPECT_EQ(packets_[2].first, H4Parser::kSco);
+    EXPECT_EQ(packets_[2].second, std::vector<uint8_t>({0x02, 0x00, 0x03, 0xaa, 0xbb, 0xcc}));
+    EXPECT_EQ(packets_[3].first, H4Parser::kCommand);
+    EXPECT_EQ(packets_[3].second, std::vector<uint8_t>({0x03, 0x0c, 0x00}));
+  }
+
+  std::vector<Packet> packets_;
+  H4Parser parser_;
+};
+
+TEST_F(H4ParserTest, whole_stream_in_one_chunk) {
+  std::vector<uint8_t> stream = Stream();
+  ASSERT_TRUE(parser_.Consume(stream.data(), stream.size()));
+  ExpectStreamPackets();
+}
+
+TEST_F(H4ParserTest, one_byte_at_a_time) {
+  std::vector<uint8_t> stream = Stream();
+  for (uint8_t byte : stream) {
+    ASSERT_TRUE(parser_.Consume(&byte, 1));
+  }
+  ExpectStreamPackets();
+}
+
+TEST_F(H4ParserTest, every_split_point) {
+  std::vector<uint8_t> stream = Stream();
+  for (size_t split = 0; split <= stream.size(); split++) {
+    packets_.clear();
+    ASSERT_TRUE(parser_.Consume(stream.data(), split));
+    ASSERT_TRUE(parser_.Consume(stream.data() + split, stream.size() - split));
+    ExpectStreamPackets();
+  }
+}
+
+TEST_F(H4ParserTest, empty_payload) {
+  std::vector<uint8_t> stream = {H4Parser::kEvent, 0x13, 0x00, H4Parser::kAcl, 0x01, 0x00, 0x00, 0x00};
+  ASSERT_TRUE(parser_.Consume(stream.data(), 2));
+  EXPECT_TRUE(packets_.empty());
+  ASSERT_TRUE(parser_.Consume(stream.data() + 2, stream.size() - 2));
+  ASSERT_EQ(packets_.size(), 2u);
+  EXPECT_EQ(packets_[0].second, std::vector<uint8_t>({0x13, 0x00}));
+  EXPECT_EQ(packets_[1].second, std::vector<uint8_t>({0x01, 0x00, 0x00, 0x00}));
+}
+
+TEST_F(H4ParserTest, unknown_type_is_rejected) {
+  std::vector<uint8_t> stream = {H4Parser::kEvent, 0x13, 0x00, 0x05, 0x00};
+  ASSERT_FALSE(parser_.Consume(stream.data(), stream.size()));
+  EXPECT_EQ(packets_.size(), 1u);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
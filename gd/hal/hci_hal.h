@@ -19,11 +19,13 @@
 #include <vector>
 
 #include "module.h"
+#include "packet/segmenting_inserter.h"
 
 namespace bluetooth {
 namespace hal {
 
 using HciPacket = std::vector<uint8_t>;
+using HciPacketSegments = std::vector<packet::Segment>;
 
 enum class Status : int32_t { SUCCESS, TRANSPORT_ERROR, INITIALIZATION_ERROR, UNKNOWN };
 
@@ -84,6 +86,17 @@ class HciHal : public ::bluetooth::Module {
   // Packets must be processed in order.
   virtual void sendAclData(HciPacket data) = 0;
 
+  // Send an HCI ACL data packet made of the concatenation of |segments|. The segments only need to stay valid until
+  // this call returns. Implementations that can hand the segments to the transport as-is (e.g. with writev) should
+  // override this, by default they are first flattened into a single HciPacket.
+  virtual void sendAclDataSegments(const HciPacketSegments& segments) {
+    HciPacket data;
+    for (const auto& segment : segments) {
+      data.insert(data.end(), segment.data, segment.data + segment.size);
+    }
+    sendAclData(std::move(data));
+  }
+
   // Send an SCO data packet (as specified in the Bluetooth Specification
   // V4.2, Vol 2, Part 5, Section 5.4.3) to the Bluetooth controller.
   // Packets must be processed in order.
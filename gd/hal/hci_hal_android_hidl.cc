@@ -19,6 +19,7 @@
 #include <android/hardware/bluetooth/1.0/types.h>
 #include <stdlib.h>
 
+#include <cstring>
 #include <future>
 #include <vector>
 
@@ -47,6 +48,13 @@ class HciDeathRecipient : public ::android::hardware::hidl_death_recipient {
 
 android::sp<HciDeathRecipient> hci_death_recipient_ = new HciDeathRecipient();
 
+// Converting a std::vector to a hidl_vec copies it, point the hidl_vec at the bytes of |packet| instead.
+hidl_vec<uint8_t> WrapPacket(HciPacket& packet) {
+  hidl_vec<uint8_t> wrapped;
+  wrapped.setToExternal(packet.data(), packet.size());
+  return wrapped;
+}
+
 class InternalHciCallbacks : public IBluetoothHciCallbacks {
  public:
   InternalHciCallbacks(SnoopLogger* btsnoop_logger) : btsnoop_logger_(btsnoop_logger) {
@@ -122,17 +130,34 @@ class HciHalHidl : public HciHal {
 
   void sendHciCommand(HciPacket command) override {
     btsnoop_logger_->capture(command, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
-    bt_hci_->sendHciCommand(command);
+    bt_hci_->sendHciCommand(WrapPacket(command));
   }
 
   void sendAclData(HciPacket packet) override {
     btsnoop_logger_->capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+    bt_hci_->sendAclData(WrapPacket(packet));
+  }
+
+  void sendAclDataSegments(const HciPacketSegments& segments) override {
+    btsnoop_logger_->capture(segments, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+    // The HIDL transport needs contiguous bytes, gather the segments straight into the hidl_vec that is sent.
+    size_t size = 0;
+    for (const auto& segment : segments) {
+      size += segment.size;
+    }
+    hidl_vec<uint8_t> packet;
+    packet.resize(size);
+    size_t offset = 0;
+    for (const auto& segment : segments) {
+      memcpy(packet.data() + offset, segment.data, segment.size);
+      offset += segment.size;
+    }
     bt_hci_->sendAclData(packet);
   }
 
   void sendScoData(HciPacket packet) override {
     btsnoop_logger_->capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
-    bt_hci_->sendScoData(packet);
+    bt_hci_->sendScoData(WrapPacket(packet));
   }
 
  protected:
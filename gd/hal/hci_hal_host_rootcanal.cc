@@ -19,13 +19,15 @@
 #include <netdb.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <chrono>
 #include <csignal>
+#include <deque>
 #include <mutex>
-#include <queue>
 
+#include "hal/h4_parser.h"
 #include "hal/hci_hal.h"
 #include "hal/snoop_logger.h"
 #include "os/log.h"
@@ -41,10 +43,10 @@ constexpr uint8_t kH4Sco = 0x03;
 constexpr uint8_t kH4Event = 0x04;
 
 constexpr uint8_t kH4HeaderSize = 1;
-constexpr uint8_t kHciAclHeaderSize = 4;
-constexpr uint8_t kHciScoHeaderSize = 3;
-constexpr uint8_t kHciEvtHeaderSize = 2;
-constexpr int kBufSize = 1024 + 4 + 1;  // DeviceProperties::acl_data_packet_size_ + ACL header + H4 header
+// Bytes read from the socket at once, enough for dozens of full size ACL packets
+constexpr size_t kReadBufferSize = 64 * 1024;
+// Queued packets written by a single writev()
+constexpr size_t kMaxPacketsPerWrite = 64;
 
 int ConnectToRootCanal(const std::string& server, int port) {
   int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
@@ -120,7 +122,7 @@ class HciHalHostRootcanal : public HciHal {
     std::vector<uint8_t> packet = std::move(command);
     btsnoop_logger_->capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
     packet.insert(packet.cbegin(), kH4Command);
-    write_to_rootcanal_fd(packet);
+    write_to_rootcanal_fd(std::move(packet));
   }
 
   void sendAclData(HciPacket data) override {
@@ -129,7 +131,53 @@ class HciHalHostRootcanal : public HciHal {
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
     packet.insert(packet.cbegin(), kH4Acl);
-    write_to_rootcanal_fd(packet);
+    write_to_rootcanal_fd(std::move(packet));
+  }
+
+  void sendAclDataSegments(const HciPacketSegments& segments) override {
+    std::lock_guard<std::mutex> lock(api_mutex_);
+    ASSERT(sock_fd_ != INVALID_FD);
+    btsnoop_logger_->capture(segments, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+    std::vector<iovec> iov;
+    iov.reserve(segments.size() + 1);
+    iov.push_back({const_cast<uint8_t*>(&kH4Acl), kH4HeaderSize});
+    size_t total_size = kH4HeaderSize;
+    for (const auto& segment : segments) {
+      iov.push_back({const_cast<uint8_t*>(segment.data), segment.size});
+      total_size += segment.size;
+    }
+
+    // Write straight from the segments when nothing is queued ahead of this packet, without blocking the caller.
+    size_t bytes_written = 0;
+    if (hci_outgoing_queue_.empty()) {
+      msghdr msg = {};
+      msg.msg_iov = iov.data();
+      msg.msg_iovlen = iov.size();
+      ssize_t ret;
+      RUN_NO_INTR(ret = sendmsg(sock_fd_, &msg, MSG_DONTWAIT));
+      if (ret == -1) {
+        ASSERT_LOG(errno == EAGAIN || errno == EWOULDBLOCK, "Can't write to socket: %s", strerror(errno));
+        ret = 0;
+      }
+      bytes_written = ret;
+      if (bytes_written == total_size) {
+        return;
+      }
+    }
+
+    // The segments are only valid during this call, copy what the socket did not take yet.
+    std::vector<uint8_t> remainder;
+    remainder.reserve(total_size - bytes_written);
+    for (const auto& entry : iov) {
+      const uint8_t* base = static_cast<const uint8_t*>(entry.iov_base);
+      if (bytes_written >= entry.iov_len) {
+        bytes_written -= entry.iov_len;
+        continue;
+      }
+      remainder.insert(remainder.end(), base + bytes_written, base + entry.iov_len);
+      bytes_written = 0;
+    }
+    write_to_rootcanal_fd(std::move(remainder));
   }
 
   void sendScoData(HciPacket data) override {
@@ -138,7 +186,7 @@ class HciHalHostRootcanal : public HciHal {
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
     packet.insert(packet.cbegin(), kH4Sco);
-    write_to_rootcanal_fd(packet);
+    write_to_rootcanal_fd(std::move(packet));
   }
 
  protected:
@@ -190,12 +238,16 @@ class HciHalHostRootcanal : public HciHal {
   bluetooth::os::Thread hci_incoming_thread_ =
       bluetooth::os::Thread("hci_incoming_thread", bluetooth::os::Thread::Priority::NORMAL);
   bluetooth::os::Reactor::Reactable* reactable_ = nullptr;
-  std::queue<std::vector<uint8_t>> hci_outgoing_queue_;
+  std::deque<std::vector<uint8_t>> hci_outgoing_queue_;
+  // Bytes of the front packet of hci_outgoing_queue_ the socket already took
+  size_t hci_outgoing_offset_ = 0;
   SnoopLogger* btsnoop_logger_ = nullptr;
+  std::vector<uint8_t> read_buffer_ = std::vector<uint8_t>(kReadBufferSize);
+  H4Parser h4_parser_{[this](uint8_t type, HciPacket packet) { h4_packet_received(type, std::move(packet)); }};
 
   void write_to_rootcanal_fd(HciPacket packet) {
     // TODO: replace this with new queue when it's ready
-    hci_outgoing_queue_.emplace(packet);
+    hci_outgoing_queue_.emplace_back(std::move(packet));
     if (hci_outgoing_queue_.size() == 1) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(
           reactable_,
@@ -204,14 +256,37 @@ class HciHalHostRootcanal : public HciHal {
     }
   }
 
+  // Writes as many queued packets as the socket takes with a single writev()
   void send_packet_ready() {
     std::lock_guard<std::mutex> lock(this->api_mutex_);
-    auto packet_to_send = this->hci_outgoing_queue_.front();
-    auto bytes_written = write(this->sock_fd_, (void*)packet_to_send.data(), packet_to_send.size());
-    this->hci_outgoing_queue_.pop();
+    iovec iov[kMaxPacketsPerWrite];
+    size_t iov_count = 0;
+    for (const auto& packet : hci_outgoing_queue_) {
+      if (iov_count == kMaxPacketsPerWrite) {
+        break;
+      }
+      size_t offset = iov_count == 0 ? hci_outgoing_offset_ : 0;
+      iov[iov_count++] = {const_cast<uint8_t*>(packet.data()) + offset, packet.size() - offset};
+    }
+    ssize_t bytes_written;
+    RUN_NO_INTR(bytes_written = writev(this->sock_fd_, iov, iov_count));
     if (bytes_written == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return;
+      }
       abort();
     }
+    size_t remaining = bytes_written;
+    while (remaining > 0) {
+      size_t front_remaining = hci_outgoing_queue_.front().size() - hci_outgoing_offset_;
+      if (remaining < front_remaining) {
+        hci_outgoing_offset_ += remaining;
+        break;
+      }
+      remaining -= front_remaining;
+      hci_outgoing_offset_ = 0;
+      hci_outgoing_queue_.pop_front();
+    }
     if (hci_outgoing_queue_.empty()) {
       this->hci_incoming_thread_.GetReactor()->ModifyRegistration(
           this->reactable_,
@@ -220,6 +295,7 @@ class HciHalHostRootcanal : public HciHal {
     }
   }
 
+  // Reads whatever the socket holds, up to kReadBufferSize bytes, and delivers every packet completed by these bytes
   void incoming_packet_received() {
     {
       std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -228,99 +304,49 @@ class HciHalHostRootcanal : public HciHal {
         return;
       }
     }
-    uint8_t buf[kBufSize] = {};
 
     ssize_t received_size;
-    RUN_NO_INTR(received_size = recv(sock_fd_, buf, kH4HeaderSize, 0));
+    RUN_NO_INTR(received_size = recv(sock_fd_, read_buffer_.data(), read_buffer_.size(), 0));
     ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
     if (received_size == 0) {
       LOG_WARN("Can't read H4 header. EOF received");
       raise(SIGINT);
       return;
     }
+    ASSERT_LOG(h4_parser_.Consume(read_buffer_.data(), received_size), "malformed H4 stream received");
+  }
 
-    if (buf[0] == kH4Event) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciEvtHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciEvtHeaderSize, "malformed HCI event header received");
-
-      uint8_t hci_evt_parameter_total_length = buf[2];
-      ssize_t payload_size;
-      RUN_NO_INTR(
-          payload_size = recv(sock_fd_, buf + kH4HeaderSize + kHciEvtHeaderSize, hci_evt_parameter_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(
-          payload_size == hci_evt_parameter_total_length,
-          "malformed HCI event total parameter size received: %zu != %d",
-          payload_size,
-          hci_evt_parameter_total_length);
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciEvtHeaderSize + payload_size);
-      btsnoop_logger_->capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
+  void h4_packet_received(uint8_t type, HciPacket packet) {
+    std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
+    switch (type) {
+      case H4Parser::kEvent:
+        btsnoop_logger_->capture(packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping an event after processing");
           return;
         }
-        incoming_packet_callback_->hciEventReceived(receivedHciPacket);
-      }
-    }
-
-    if (buf[0] == kH4Acl) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciAclHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciAclHeaderSize, "malformed ACL header received");
-
-      uint16_t hci_acl_data_total_length = (buf[4] << 8) + buf[3];
-      int payload_size;
-      RUN_NO_INTR(payload_size = recv(sock_fd_, buf + kH4HeaderSize + kHciAclHeaderSize, hci_acl_data_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(
-          payload_size == hci_acl_data_total_length,
-          "malformed ACL length received: %d != %d",
-          payload_size,
-          hci_acl_data_total_length);
-      ASSERT_LOG(hci_acl_data_total_length <= kBufSize - kH4HeaderSize - kHciAclHeaderSize, "packet too long");
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciAclHeaderSize + payload_size);
-      btsnoop_logger_->capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
+        incoming_packet_callback_->hciEventReceived(std::move(packet));
+        break;
+      case H4Parser::kAcl:
+        btsnoop_logger_->capture(packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping an ACL packet after processing");
           return;
         }
-        incoming_packet_callback_->aclDataReceived(receivedHciPacket);
-      }
-    }
-
-    if (buf[0] == kH4Sco) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciScoHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciScoHeaderSize, "malformed SCO header received");
-
-      uint8_t hci_sco_data_total_length = buf[3];
-      int payload_size;
-      RUN_NO_INTR(payload_size = recv(sock_fd_, buf + kH4HeaderSize + kHciScoHeaderSize, hci_sco_data_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(payload_size == hci_sco_data_total_length, "malformed SCO packet received: size mismatch");
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciScoHeaderSize + payload_size);
-      btsnoop_logger_->capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::SCO);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
+        incoming_packet_callback_->aclDataReceived(std::move(packet));
+        break;
+      case H4Parser::kSco:
+        btsnoop_logger_->capture(packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::SCO);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping a SCO packet after processing");
           return;
         }
-        incoming_packet_callback_->scoDataReceived(receivedHciPacket);
-      }
+        incoming_packet_callback_->scoDataReceived(std::move(packet));
+        break;
+      default:
+        LOG_WARN("Dropping an H4 packet of type 0x%02hhx", type);
+        break;
     }
-    memset(buf, 0, kBufSize);
   }
 };
 
@@ -347,6 +347,36 @@ TEST_F(HciHalRootcanalTest, send_acl) {
   check_packet_equal({kH4Acl, acl_packet}, read_buf);
 }
 
+TEST_F(HciHalRootcanalTest, send_acl_segments) {
+  uint8_t acl_payload_size = 200;
+  HciPacket acl_packet = make_sample_hci_acl_pkt(acl_payload_size);
+  HciPacketSegments segments = {{acl_packet.data(), 4}, {acl_packet.data() + 4, acl_packet.size() - 4}};
+  hal_->sendAclDataSegments(segments);
+  H4Packet read_buf(1 + 2 + 2 + acl_payload_size);
+  SetFakeServerSocketToBlocking();
+  auto size_read = read_with_retry(fake_server_socket_, read_buf.data(), read_buf.size());
+
+  ASSERT_EQ(size_read, 1 + acl_packet.size());
+  check_packet_equal({kH4Acl, acl_packet}, read_buf);
+}
+
+TEST_F(HciHalRootcanalTest, send_multiple_acl_segments_batch) {
+  uint8_t acl_payload_size = 200;
+  int num_packets = 1000;
+  HciPacket acl_packet = make_sample_hci_acl_pkt(acl_payload_size);
+  HciPacketSegments segments = {{acl_packet.data(), 4}, {acl_packet.data() + 4, acl_packet.size() - 4}};
+  for (int i = 0; i < num_packets; i++) {
+    hal_->sendAclDataSegments(segments);
+  }
+  H4Packet read_buf(1 + 2 + 2 + acl_payload_size);
+  SetFakeServerSocketToBlocking();
+  for (int i = 0; i < num_packets; i++) {
+    auto size_read = read_with_retry(fake_server_socket_, read_buf.data(), read_buf.size());
+    ASSERT_EQ(size_read, 1 + acl_packet.size());
+    check_packet_equal({kH4Acl, acl_packet}, read_buf);
+  }
+}
+
 TEST_F(HciHalRootcanalTest, send_sco) {
   uint8_t sco_payload_size = 200;
   HciPacket sco_packet = make_sample_hci_sco_pkt(sco_payload_size);
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Replays a btsnoop capture through the stack and reports the CPU time and the allocations of each layer, so that
+// captures of field problems can be reproduced as performance tests. Each layer runs on its own thread, the HAL
+// replays from the main thread.
+//
+// Usage: bluetooth_gd_hci_replay [--recorded-speed] <btsnoop file>
+
+#include <time.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "common/bind.h"
+#include "hal/replay/snoop_replay_hci_hal.h"
+#include "hci/acl_manager.h"
+#include "hci/controller.h"
+#include "hci/hci_layer.h"
+#include "hci/le_advertising_manager.h"
+#include "hci/le_scanning_manager.h"
+#include "l2cap/classic/l2cap_classic_module.h"
+#include "l2cap/le/l2cap_le_module.h"
+#include "module.h"
+#include "os/handler.h"
+#include "os/log.h"
+#include "os/thread.h"
+
+using ::bluetooth::TestModuleRegistry;
+using ::bluetooth::hal::HciHal;
+using ::bluetooth::hal::replay::SnoopReplayHciHal;
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::Thread;
+
+namespace {
+
+// Counted per thread, so that each layer is charged for its own allocations
+thread_local uint64_t allocation_count = 0;
+thread_local uint64_t allocated_bytes = 0;
+
+struct Usage {
+  std::chrono::nanoseconds cpu_time{0};
+  uint64_t allocations = 0;
+  uint64_t allocated_bytes = 0;
+};
+
+Usage current_thread_usage() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  Usage usage;
+  usage.cpu_time = std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+  usage.allocations = allocation_count;
+  usage.allocated_bytes = allocated_bytes;
+  return usage;
+}
+
+struct Layer {
+  explicit Layer(const std::string& name) : thread(name, Thread::Priority::NORMAL), handler(&thread) {}
+
+  ~Layer() {
+    handler.Clear();
+    handler.WaitUntilStopped(std::chrono::milliseconds(2000));
+  }
+
+  Usage GetUsage() {
+    std::promise<Usage> promise;
+    auto future = promise.get_future();
+    handler.Post(bluetooth::common::BindOnce(
+        [](std::promise<Usage> promise) { promise.set_value(current_thread_usage()); }, std::move(promise)));
+    return future.get();
+  }
+
+  // Wait for the packets of the replay to be processed by this layer
+  void WaitForIdle() {
+    while (!thread.GetReactor()->WaitForIdle(std::chrono::milliseconds(100))) {
+    }
+  }
+
+  Thread thread;
+  Handler handler;
+};
+
+void print_usage(const char* layer, const Usage& before, const Usage& after) {
+  std::chrono::duration<double, std::milli> cpu_time = after.cpu_time - before.cpu_time;
+  printf("%-8s %12.3f %12llu %14llu\n", layer, cpu_time.count(),
+         static_cast<unsigned long long>(after.allocations - before.allocations),
+         static_cast<unsigned long long>(after.allocated_bytes - before.allocated_bytes));
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocation_count++;
+  allocated_bytes += size;
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+int main(int argc, const char** argv) {
+  SnoopReplayHciHal::Speed speed = SnoopReplayHciHal::Speed::MAX;
+  const std::string arg_recorded_speed = "--recorded-speed";
+  std::string path;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == arg_recorded_speed) {
+      speed = SnoopReplayHciHal::Speed::RECORDED;
+    } else {
+      path = arg;
+    }
+  }
+  if (path.empty()) {
+    fprintf(stderr, "Usage: %s [%s] <btsnoop file>\n", argv[0], arg_recorded_speed.c_str());
+    return EXIT_FAILURE;
+  }
+
+  auto hal = new SnoopReplayHciHal();
+  if (!hal->Load(path)) {
+    delete hal;
+    return EXIT_FAILURE;
+  }
+
+  TestModuleRegistry registry;
+  registry.InjectTestModule(&HciHal::Factory, hal);
+
+  std::vector<std::pair<const char*, Layer*>> layers;
+  {
+    auto hci = new Layer("hci_layer");
+    registry.Start<bluetooth::hci::HciLayer>(&hci->thread);
+    registry.Start<bluetooth::hci::Controller>(&hci->thread);
+    layers.emplace_back("hci", hci);
+
+    auto acl = new Layer("acl_layer");
+    registry.Start<bluetooth::hci::AclManager>(&acl->thread);
+    registry.Start<bluetooth::hci::LeAdvertisingManager>(&acl->thread);
+    registry.Start<bluetooth::hci::LeScanningManager>(&acl->thread);
+    layers.emplace_back("acl", acl);
+
+    auto l2cap = new Layer("l2cap_layer");
+    registry.Start<bluetooth::l2cap::classic::L2capClassicModule>(&l2cap->thread);
+    registry.Start<bluetooth::l2cap::le::L2capLeModule>(&l2cap->thread);
+    layers.emplace_back("l2cap", l2cap);
+  }
+  for (auto& layer : layers) {
+    layer.second->WaitForIdle();
+  }
+
+  std::vector<Usage> before;
+  for (auto& layer : layers) {
+    before.push_back(layer.second->GetUsage());
+  }
+  Usage hal_before = current_thread_usage();
+  auto start = std::chrono::steady_clock::now();
+
+  size_t replayed = hal->Replay(speed);
+  Usage hal_after = current_thread_usage();
+  for (auto& layer : layers) {
+    layer.second->WaitForIdle();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  printf("Replayed %zu packets in %.3f ms, %zu commands without a recorded response\n", replayed,
+         std::chrono::duration<double, std::milli>(elapsed).count(), hal->GetNumUnansweredCommands());
+  printf("%-8s %12s %12s %14s\n", "layer", "cpu_ms", "allocations", "allocated_B");
+  print_usage("hal", hal_before, hal_after);
+  for (size_t i = 0; i < layers.size(); i++) {
+    print_usage(layers[i].first, before[i], layers[i].second->GetUsage());
+  }
+
+  registry.StopAll();
+  for (auto& layer : layers) {
+    delete layer.second;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/replay/snoop_replay_hci_hal.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "hal/h4_parser.h"
+#include "hci/fuzz/status_vs_complete_commands.h"
+#include "hci/hci_packets.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+namespace replay {
+
+namespace {
+constexpr uint8_t kIdentificationPattern[] = {'b', 't', 's', 'n', 'o', 'o', 'p', 0x00};
+constexpr uint32_t kDatalinkTypeH4 = 1002;
+constexpr size_t kFileHeaderSize = 16;
+constexpr size_t kRecordHeaderSize = 24;
+// Set for the packets received from the controller
+constexpr uint32_t kFlagIncoming = 1 << 0;
+
+constexpr uint8_t kCommandCompleteCode = static_cast<uint8_t>(hci::EventCode::COMMAND_COMPLETE);
+constexpr uint8_t kCommandStatusCode = static_cast<uint8_t>(hci::EventCode::COMMAND_STATUS);
+constexpr uint8_t kUnknownCommandStatus = static_cast<uint8_t>(hci::ErrorCode::UNKNOWN_HCI_COMMAND);
+
+// The fields of btsnoop files are big endian
+uint32_t read_be32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 |
+         static_cast<uint32_t>(data[2]) << 8 | data[3];
+}
+
+uint64_t read_be64(const uint8_t* data) {
+  return static_cast<uint64_t>(read_be32(data)) << 32 | read_be32(data + 4);
+}
+
+// Offset of the Num_HCI_Command_Packets field in a Command Complete or Command Status event, followed by the opcode
+size_t num_command_packets_offset(uint8_t event_code) {
+  return event_code == kCommandCompleteCode ? 2 : 3;
+}
+}  // namespace
+
+bool SnoopReplayHciHal::Load(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    LOG_ERROR("Unable to open %s", path.c_str());
+    return false;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  if (data.size() < kFileHeaderSize ||
+      memcmp(data.data(), kIdentificationPattern, sizeof(kIdentificationPattern)) != 0) {
+    LOG_ERROR("%s is not a btsnoop file", path.c_str());
+    return false;
+  }
+  if (read_be32(data.data() + 12) != kDatalinkTypeH4) {
+    LOG_ERROR("%s is not an H4 capture", path.c_str());
+    return false;
+  }
+
+  records_.clear();
+  responses_.clear();
+  uint64_t first_timestamp = 0;
+  size_t offset = kFileHeaderSize;
+  while (offset + kRecordHeaderSize <= data.size()) {
+    const uint8_t* header = data.data() + offset;
+    uint32_t length = read_be32(header + 4);
+    uint32_t flags = read_be32(header + 8);
+    uint64_t timestamp = read_be64(header + 16);
+    offset += kRecordHeaderSize;
+    if (length > data.size() - offset) {
+      LOG_WARN("Truncated record at offset %zu", offset - kRecordHeaderSize);
+      break;
+    }
+    const uint8_t* packet = data.data() + offset;
+    offset += length;
+    if (length < 1 || (flags & kFlagIncoming) == 0) {
+      continue;
+    }
+    if (first_timestamp == 0) {
+      first_timestamp = timestamp;
+    }
+
+    uint8_t type = packet[0];
+    std::vector<uint8_t> bytes(packet + 1, packet + length);
+    if (type == H4Parser::kEvent && bytes.size() >= 2 &&
+        (bytes[0] == kCommandCompleteCode || bytes[0] == kCommandStatusCode)) {
+      size_t opcode_offset = num_command_packets_offset(bytes[0]) + 1;
+      if (bytes.size() < opcode_offset + 2) {
+        continue;
+      }
+      uint16_t opcode = bytes[opcode_offset] | (bytes[opcode_offset + 1] << 8);
+      // Responses to opcode NONE only return credits, the stack gets them from the answers to its own commands
+      if (opcode != static_cast<uint16_t>(hci::OpCode::NONE)) {
+        responses_[opcode].push_back(std::move(bytes));
+      }
+      continue;
+    }
+    records_.push_back({std::chrono::microseconds(timestamp - first_timestamp), type, std::move(bytes)});
+  }
+
+  LOG_INFO("Loaded %zu packets and responses to %zu opcodes from %s", records_.size(), responses_.size(),
+           path.c_str());
+  return true;
+}
+
+size_t SnoopReplayHciHal::Replay(Speed speed) {
+  auto start = std::chrono::steady_clock::now();
+  for (const Record& record : records_) {
+    if (speed == Speed::RECORDED) {
+      std::this_thread::sleep_until(start + record.timestamp);
+    }
+    deliver(record.type, record.packet);
+  }
+  return records_.size();
+}
+
+void SnoopReplayHciHal::registerIncomingPacketCallback(HciHalCallbacks* callbacks) {
+  callbacks_ = callbacks;
+}
+
+void SnoopReplayHciHal::unregisterIncomingPacketCallback() {
+  callbacks_ = nullptr;
+}
+
+void SnoopReplayHciHal::sendHciCommand(HciPacket command) {
+  if (command.size() < 2) {
+    return;
+  }
+  uint16_t opcode = command[0] | (command[1] << 8);
+
+  std::vector<uint8_t> response;
+  auto recorded = responses_.find(opcode);
+  if (recorded != responses_.end()) {
+    std::deque<std::vector<uint8_t>>& queue = recorded->second;
+    response = queue.front();
+    if (queue.size() > 1) {
+      queue.pop_front();
+    }
+    // The stack waits for credits after each command, whatever the controller of the capture returned
+    response[num_command_packets_offset(response[0])] = 1;
+  } else {
+    unanswered_commands_++;
+    uint8_t opcode_low = opcode & 0xff;
+    uint8_t opcode_high = opcode >> 8;
+    if (hci::fuzz::uses_command_status(static_cast<hci::OpCode>(opcode))) {
+      response = {kCommandStatusCode, 4, kUnknownCommandStatus, 1, opcode_low, opcode_high};
+    } else {
+      response = {kCommandCompleteCode, 4, 1, opcode_low, opcode_high, kUnknownCommandStatus};
+    }
+  }
+  deliver(H4Parser::kEvent, std::move(response));
+}
+
+void SnoopReplayHciHal::deliver(uint8_t type, HciPacket packet) {
+  HciHalCallbacks* callbacks = callbacks_;
+  if (callbacks == nullptr) {
+    return;
+  }
+  switch (type) {
+    case H4Parser::kEvent:
+      callbacks->hciEventReceived(std::move(packet));
+      break;
+    case H4Parser::kAcl:
+      callbacks->aclDataReceived(std::move(packet));
+      break;
+    case H4Parser::kSco:
+      callbacks->scoDataReceived(std::move(packet));
+      break;
+    default:
+      LOG_WARN("Dropping packet of unknown type 0x%02hhx", type);
+      break;
+  }
+}
+
+const ModuleFactory SnoopReplayHciHal::Factory = ModuleFactory([]() { return new SnoopReplayHciHal(); });
+
+}  // namespace replay
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hal/hci_hal.h"
+
+namespace bluetooth {
+namespace hal {
+namespace replay {
+
+// Plays the controller side of a btsnoop capture to the stack. The packets received in the capture are fed to the
+// stack in order, except the command responses: each command sent by the stack is answered with the response to the
+// same opcode recorded in the capture, as the commands of the stack need not match the ones captured.
+class SnoopReplayHciHal : public HciHal {
+ public:
+  enum class Speed {
+    // Keep the intervals between the packets of the capture
+    RECORDED,
+    // Feed the packets back to back
+    MAX,
+  };
+
+  struct Record {
+    // Relative to the first packet of the capture
+    std::chrono::microseconds timestamp;
+    uint8_t type;
+    std::vector<uint8_t> packet;
+  };
+
+  // Load an uncompressed H4 btsnoop capture. Must be called before the module is started.
+  // Return false if the file can't be read or isn't a btsnoop capture.
+  bool Load(const std::string& path);
+
+  // Feed the packets received in the capture to the stack, from the calling thread.
+  // Return the number of packets fed.
+  size_t Replay(Speed speed);
+
+  size_t GetNumReplayRecords() const {
+    return records_.size();
+  }
+
+  // Commands sent by the stack that had no response in the capture, and got a generic one instead
+  size_t GetNumUnansweredCommands() const {
+    return unanswered_commands_;
+  }
+
+  void registerIncomingPacketCallback(HciHalCallbacks* callbacks) override;
+  void unregisterIncomingPacketCallback() override;
+
+  void sendHciCommand(HciPacket command) override;
+  void sendAclData(HciPacket packet) override {}
+  void sendAclDataSegments(const HciPacketSegments& segments) override {}
+  void sendScoData(HciPacket packet) override {}
+
+  std::string ToString() const override {
+    return "SnoopReplayHciHal";
+  }
+
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) override {}
+  void Start() override {}
+  void Stop() override {}
+
+ private:
+  void deliver(uint8_t type, HciPacket packet);
+
+  std::atomic<HciHalCallbacks*> callbacks_{nullptr};
+  std::vector<Record> records_;
+  // Recorded Command Complete and Command Status events by opcode, in capture order. The last one is kept to answer
+  // the commands the stack sends more often than the capture did.
+  std::unordered_map<uint16_t, std::deque<std::vector<uint8_t>>> responses_;
+  std::atomic<size_t> unanswered_commands_{0};
+};
+
+}  // namespace replay
+}  // namespace hal
+}  // namespace bluetooth
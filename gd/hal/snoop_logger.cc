@@ -17,10 +17,15 @@
 #include "hal/snoop_logger.h"
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <bitset>
 #include <chrono>
+#include <cstring>
+#include <vector>
 
 #include "os/log.h"
 
@@ -66,18 +71,41 @@ constexpr btsnoop_file_header_t BTSNOOP_FILE_HEADER = {
     .identification_pattern = {'b', 't', 's', 'n', 'o', 'o', 'p', 0x00},
     .version_number = BTSNOOP_VERSION_NUMBER,
     .datalink_type = BTSNOOP_DATALINK_TYPE};
+
+std::string get_file_path(const std::string& file_path, bool compressed) {
+  return compressed ? file_path + ".gz" : file_path;
+}
+
+std::string get_last_file_path(const std::string& file_path, bool compressed) {
+  return get_file_path(file_path + ".last", compressed);
+}
 }  // namespace
 
-SnoopLogger::SnoopLogger() {
-  bool file_exists;
-  {
-    std::ifstream btsnoop_istream(file_path);
-    file_exists = btsnoop_istream.is_open();
+SnoopLogger::SnoopLogger()
+    : writer_(SnoopWriter::kDefaultCapacity, SnoopWriter::FsyncPolicy::ON_FLUSH, SnoopWriter::kDefaultFlushInterval,
+              compressed ? SnoopWriter::Compression::GZIP : SnoopWriter::Compression::NONE) {
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  open_file(false);
+}
+
+void SnoopLogger::open_file(bool truncate) {
+  std::string path = get_file_path(file_path, compressed);
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : O_APPEND),
+                S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  file_opened_time_ = std::chrono::system_clock::now();
+  initial_file_size_ = 0;
+  if (fd == -1) {
+    LOG_ERROR("Unable to open BTSNOOP %s: %s", path.c_str(), strerror(errno));
+    return;
   }
-  btsnoop_ostream_.open(file_path, std::ios::binary | std::ios::app | std::ios::out);
-  if (!file_exists) {
+  struct stat file_stat;
+  initial_file_size_ = fstat(fd, &file_stat) == 0 ? file_stat.st_size : 0;
+  writer_.SetFd(fd);
+  // Appending to a compressed file starts a new gzip member, decompressing concatenates it to the records before
+  if (initial_file_size_ == 0) {
     LOG_INFO("Creating new BTSNOOP");
-    btsnoop_ostream_.write(reinterpret_cast<const char*>(&BTSNOOP_FILE_HEADER), sizeof(btsnoop_file_header_t));
+    struct iovec iov = {const_cast<btsnoop_file_header_t*>(&BTSNOOP_FILE_HEADER), sizeof(btsnoop_file_header_t)};
+    writer_.Append(&iov, 1);
   } else {
     LOG_INFO("Appending to old BTSNOOP");
   }
@@ -87,7 +115,24 @@ void SnoopLogger::SetFilePath(const std::string& filename) {
   file_path = filename;
 }
 
+void SnoopLogger::SetCompressed(bool compressed_log) {
+  compressed = compressed_log;
+}
+
+void SnoopLogger::SetFileLimits(uint64_t max_size, std::chrono::seconds max_age) {
+  max_file_size = max_size;
+  max_file_age = max_age;
+}
+
 void SnoopLogger::capture(const HciPacket& packet, Direction direction, PacketType type) {
+  capture(HciPacketSegments{{packet.data(), packet.size()}}, direction, type);
+}
+
+void SnoopLogger::capture(const HciPacketSegments& segments, Direction direction, PacketType type) {
+  size_t packet_size = 0;
+  for (const auto& segment : segments) {
+    packet_size += segment.size;
+  }
   uint64_t timestamp_us =
       std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
           .count();
@@ -111,16 +156,34 @@ void SnoopLogger::capture(const HciPacket& packet, Direction direction, PacketTy
       flags.set(1, true);
       break;
   }
-  uint32_t length = packet.size() + /* type byte */ 1;
+  uint32_t length = packet_size + /* type byte */ 1;
   btsnoop_packet_header_t header = {.length_original = htonl(length),
                                     .length_captured = htonl(length),
                                     .flags = htonl(static_cast<uint32_t>(flags.to_ulong())),
-                                    .dropped_packets = 0,
+                                    .dropped_packets = htonl(writer_.GetDroppedPackets()),
                                     .timestamp = htonll(timestamp_us + BTSNOOP_EPOCH_DELTA),
                                     .type = static_cast<uint8_t>(type)};
-  btsnoop_ostream_.write(reinterpret_cast<const char*>(&header), sizeof(btsnoop_packet_header_t));
-  btsnoop_ostream_.write(reinterpret_cast<const char*>(packet.data()), packet.size());
-  if (AlwaysFlush) btsnoop_ostream_.flush();
+  std::vector<struct iovec> iov;
+  iov.reserve(segments.size() + 1);
+  iov.push_back({&header, sizeof(btsnoop_packet_header_t)});
+  for (const auto& segment : segments) {
+    iov.push_back({const_cast<uint8_t*>(segment.data), segment.size});
+  }
+  // The writer thread does the file I/O, capturing only copies into its ring
+  writer_.Append(iov.data(), iov.size());
+  if (AlwaysFlush) writer_.Flush();
+
+  if ((max_file_size > 0 && initial_file_size_ + writer_.GetFileSize() >= max_file_size) ||
+      (max_file_age.count() > 0 && std::chrono::system_clock::now() - file_opened_time_ >= max_file_age)) {
+    // Finish the current file before renaming it
+    writer_.SetFd(-1);
+    std::string path = get_file_path(file_path, compressed);
+    std::string last_path = get_last_file_path(file_path, compressed);
+    if (rename(path.c_str(), last_path.c_str()) != 0 && errno != ENOENT) {
+      LOG_ERROR("Unable to rename BTSNOOP %s to %s: %s", path.c_str(), last_path.c_str(), strerror(errno));
+    }
+    open_file(true);
+  }
 }
 
 void SnoopLogger::ListDependencies(ModuleList* list) {
@@ -129,9 +192,14 @@ void SnoopLogger::ListDependencies(ModuleList* list) {
 
 void SnoopLogger::Start() {}
 
-void SnoopLogger::Stop() {}
+void SnoopLogger::Stop() {
+  writer_.Flush();
+}
 
 std::string SnoopLogger::file_path = SnoopLogger::DefaultFilePath;
+bool SnoopLogger::compressed = false;
+uint64_t SnoopLogger::max_file_size = 0;
+std::chrono::seconds SnoopLogger::max_file_age = std::chrono::seconds(0);
 
 const ModuleFactory SnoopLogger::Factory = ModuleFactory([]() { return new SnoopLogger(); });
 
@@ -16,12 +16,12 @@
 
 #pragma once
 
-#include <fstream>
-#include <iostream>
+#include <chrono>
 #include <mutex>
 #include <string>
 
 #include "hal/hci_hal.h"
+#include "hal/snoop_writer.h"
 #include "module.h"
 
 namespace bluetooth {
@@ -37,6 +37,11 @@ class SnoopLogger : public ::bluetooth::Module {
   static void SetFilePath(const std::string& filename);
   // Flag to allow flush into persistent memory on every packet captured. This is enabled on host for debugging.
   static const bool AlwaysFlush;
+  // Set before module is started to write the log gzip compressed, to the file path with a ".gz" suffix
+  static void SetCompressed(bool compressed);
+  // Set before module is started to move the log to a ".last" file and start a new one once the current one holds
+  // |max_file_size| bytes, after compression, or was opened |max_file_age| ago. Zero disables a limit.
+  static void SetFileLimits(uint64_t max_file_size, std::chrono::seconds max_file_age);
 
   enum class PacketType {
     CMD = 1,
@@ -51,6 +56,8 @@ class SnoopLogger : public ::bluetooth::Module {
   };
 
   void capture(const HciPacket& packet, Direction direction, PacketType type);
+  // Capture a packet made of the concatenation of |segments|.
+  void capture(const HciPacketSegments& segments, Direction direction, PacketType type);
 
  protected:
   void ListDependencies(ModuleList* list) override;
@@ -59,8 +66,15 @@ class SnoopLogger : public ::bluetooth::Module {
 
  private:
   SnoopLogger();
+  // Must be called with |file_mutex_| held
+  void open_file(bool truncate);
   static std::string file_path;
-  std::ofstream btsnoop_ostream_;
+  static bool compressed;
+  static uint64_t max_file_size;
+  static std::chrono::seconds max_file_age;
+  SnoopWriter writer_;
+  std::chrono::system_clock::time_point file_opened_time_;
+  uint64_t initial_file_size_ = 0;
   std::mutex file_mutex_;
 };
 
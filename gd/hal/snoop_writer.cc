@@ -0,0 +1,213 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_writer.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "os/log.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+// Output buffer of the compressor, written out whenever it fills
+constexpr size_t kCompressedBufferSize = 1 << 16;
+
+size_t round_up_to_power_of_two(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+}  // namespace
+
+SnoopWriter::SnoopWriter(size_t capacity, FsyncPolicy fsync_policy, std::chrono::milliseconds flush_interval,
+                         Compression compression)
+    : ring_(round_up_to_power_of_two(capacity)), mask_(ring_.size() - 1), fsync_policy_(fsync_policy),
+      flush_interval_(flush_interval), compression_(compression),
+      compressed_(compression == Compression::GZIP ? kCompressedBufferSize : 0), thread_(&SnoopWriter::run, this) {}
+
+SnoopWriter::~SnoopWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  wakeup_.notify_one();
+  thread_.join();
+  SetFd(-1);
+}
+
+void SnoopWriter::SetFd(int fd) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  write_out(Z_FINISH);
+  if (stream_started_) {
+    deflateEnd(&stream_);
+    stream_started_ = false;
+  }
+  if (fd_ != -1) {
+    if (fsync_policy_ != FsyncPolicy::NEVER) {
+      fsync(fd_);
+    }
+    close(fd_);
+  }
+  fd_ = fd;
+  file_size_.store(0, std::memory_order_relaxed);
+}
+
+bool SnoopWriter::Append(const struct iovec* iov, size_t iovcnt) {
+  size_t length = 0;
+  for (size_t i = 0; i < iovcnt; i++) {
+    length += iov[i].iov_len;
+  }
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  uint64_t tail = tail_.load(std::memory_order_acquire);
+  if (head - tail + length > ring_.size()) {
+    dropped_packets_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  for (size_t i = 0; i < iovcnt; i++) {
+    const uint8_t* data = static_cast<const uint8_t*>(iov[i].iov_base);
+    size_t remaining = iov[i].iov_len;
+    while (remaining > 0) {
+      size_t offset = head & mask_;
+      size_t chunk = std::min(remaining, ring_.size() - offset);
+      std::memcpy(ring_.data() + offset, data, chunk);
+      data += chunk;
+      remaining -= chunk;
+      head += chunk;
+    }
+  }
+  head_.store(head, std::memory_order_release);
+
+  // Notifying without |mutex_| may race with the writer going to sleep, the flush interval bounds the delay then
+  if (head - tail >= ring_.size() / 4 && !wakeup_requested_.exchange(true, std::memory_order_relaxed)) {
+    wakeup_.notify_one();
+  }
+  return true;
+}
+
+void SnoopWriter::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  write_out();
+  if (fd_ != -1 && fsync_policy_ != FsyncPolicy::NEVER) {
+    fsync(fd_);
+  }
+}
+
+uint32_t SnoopWriter::GetDroppedPackets() const {
+  return dropped_packets_.load(std::memory_order_relaxed);
+}
+
+uint64_t SnoopWriter::GetFileSize() const {
+  return file_size_.load(std::memory_order_relaxed);
+}
+
+void SnoopWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopped_) {
+    wakeup_.wait_for(lock, flush_interval_,
+                     [this] { return stopped_ || wakeup_requested_.load(std::memory_order_relaxed); });
+    wakeup_requested_.store(false, std::memory_order_relaxed);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    write_out();
+    if (fd_ != -1 && fsync_policy_ == FsyncPolicy::EVERY_BATCH && tail != tail_.load(std::memory_order_relaxed)) {
+      fsync(fd_);
+    }
+  }
+}
+
+void SnoopWriter::write_out(int flush) {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  if (fd_ != -1 && compression_ == Compression::GZIP) {
+    if (!stream_started_) {
+      stream_ = {};
+      // 16 on top of the window bits picks the gzip wrapper
+      if (deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        LOG_ERROR("Unable to start compressing snoop log");
+        return;
+      }
+      stream_started_ = true;
+    }
+    if (tail == head && flush != Z_FINISH) {
+      return;
+    }
+    while (tail != head) {
+      size_t offset = tail & mask_;
+      size_t length = std::min<size_t>(head - tail, ring_.size() - offset);
+      deflate_out(ring_.data() + offset, length, Z_NO_FLUSH);
+      tail += length;
+      tail_.store(tail, std::memory_order_release);
+    }
+    deflate_out(nullptr, 0, flush);
+    return;
+  }
+
+  while (tail != head) {
+    size_t offset = tail & mask_;
+    size_t length = head - tail;
+    size_t first = std::min(length, ring_.size() - offset);
+    struct iovec iov[] = {{ring_.data() + offset, first}, {ring_.data(), length - first}};
+    ssize_t written = length;
+    if (fd_ != -1) {
+      RUN_NO_INTR(written = writev(fd_, iov, length > first ? 2 : 1));
+      if (written <= 0) {
+        LOG_ERROR("Unable to write %zu bytes of snoop log: %s", length, strerror(errno));
+        // Give up on these records rather than retrying them forever
+        written = length;
+      } else {
+        file_size_.fetch_add(written, std::memory_order_relaxed);
+      }
+    }
+    tail += written;
+    tail_.store(tail, std::memory_order_release);
+  }
+}
+
+void SnoopWriter::deflate_out(const uint8_t* data, size_t length, int flush) {
+  stream_.next_in = const_cast<uint8_t*>(data);
+  stream_.avail_in = length;
+  do {
+    stream_.next_out = compressed_.data();
+    stream_.avail_out = compressed_.size();
+    deflate(&stream_, flush);
+    write_fully(compressed_.data(), compressed_.size() - stream_.avail_out);
+  } while (stream_.avail_out == 0);
+}
+
+void SnoopWriter::write_fully(const uint8_t* data, size_t length) {
+  while (length > 0) {
+    ssize_t written;
+    RUN_NO_INTR(written = write(fd_, data, length));
+    if (written <= 0) {
+      LOG_ERROR("Unable to write %zu bytes of snoop log: %s", length, strerror(errno));
+      return;
+    }
+    file_size_.fetch_add(written, std::memory_order_relaxed);
+    data += written;
+    length -= written;
+  }
+}
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/uio.h>
+#include <zlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+
+// Writes btsnoop records to a file descriptor from a background thread, so that capturing a packet only copies it
+// into an in-memory ring. The thread writes whatever the ring holds with a single writev(), every flush interval or as
+// soon as a quarter of the ring is filled.
+//
+// Append() must not be called concurrently, callers already serialize their captures. It never waits for the writer:
+// the ring is shared without locks, and a record that doesn't fit is dropped and counted instead.
+//
+// With Compression::GZIP the file is written as a gzip stream, compressed on the writer thread too. Each batch ends
+// with a sync point so that the file decompresses up to the last batch even if the stack dies, and replacing the file
+// descriptor finishes the stream. gunzip gives back the plain btsnoop file, and Wireshark opens it as is.
+//
+// Only depends on the standard library, POSIX and zlib in this header, so that the legacy stack can share it.
+class SnoopWriter {
+ public:
+  enum class FsyncPolicy {
+    NEVER,
+    // After Flush(), and before the file descriptor is replaced or closed
+    ON_FLUSH,
+    // After every batch written by the background thread, on top of ON_FLUSH
+    EVERY_BATCH,
+  };
+
+  enum class Compression {
+    NONE,
+    GZIP,
+  };
+
+  static constexpr size_t kDefaultCapacity = 1 << 20;
+  static constexpr std::chrono::milliseconds kDefaultFlushInterval = std::chrono::milliseconds(250);
+
+  // |capacity| is rounded up to a power of two
+  explicit SnoopWriter(size_t capacity = kDefaultCapacity, FsyncPolicy fsync_policy = FsyncPolicy::ON_FLUSH,
+                       std::chrono::milliseconds flush_interval = kDefaultFlushInterval,
+                       Compression compression = Compression::NONE);
+  SnoopWriter(const SnoopWriter&) = delete;
+  SnoopWriter& operator=(const SnoopWriter&) = delete;
+  // Writes out the records left in the ring and closes the file descriptor
+  ~SnoopWriter();
+
+  // Write out the records appended so far to the current file descriptor and close it, then take ownership of |fd|,
+  // or stop writing if |fd| is -1. Must not be called concurrently with Append(). Records appended while there is no
+  // file descriptor are discarded.
+  void SetFd(int fd);
+
+  // Queue the concatenation of |iov| as one record. Returns false when it doesn't fit in the ring.
+  bool Append(const struct iovec* iov, size_t iovcnt);
+
+  // Write out the records appended so far before returning
+  void Flush();
+
+  // Number of records dropped so far because the ring was full
+  uint32_t GetDroppedPackets() const;
+
+  // Bytes written to the current file descriptor so far, after compression. Lags behind Append() until the next batch.
+  uint64_t GetFileSize() const;
+
+ private:
+  void run();
+  // Must be called with |mutex_| held. |flush| is the zlib flush mode ending the batch when compressing.
+  void write_out(int flush = Z_SYNC_FLUSH);
+  void write_fully(const uint8_t* data, size_t length);
+  void deflate_out(const uint8_t* data, size_t length, int flush);
+
+  std::vector<uint8_t> ring_;
+  const size_t mask_;
+  const FsyncPolicy fsync_policy_;
+  const std::chrono::milliseconds flush_interval_;
+  const Compression compression_;
+  // Positions in bytes since the start, the ring holds [tail_, head_). Only Append() moves head_, only write_out()
+  // moves tail_.
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<uint32_t> dropped_packets_{0};
+  std::atomic<uint64_t> file_size_{0};
+  std::atomic<bool> wakeup_requested_{false};
+
+  // Serializes write_out() and guards the members below
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  int fd_ = -1;
+  // Compression state of the stream written to |fd_|
+  z_stream stream_;
+  bool stream_started_ = false;
+  std::vector<uint8_t> compressed_;
+  bool stopped_ = false;
+  std::thread thread_;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
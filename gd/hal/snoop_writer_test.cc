@@ -0,0 +1,187 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_writer.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <thread>
+#include <vector>
+
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+constexpr std::chrono::milliseconds kNoPeriodicFlush = std::chrono::hours(1);
+
+class SnoopWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(pipe2(pipe_fds_, O_NONBLOCK), 0);
+  }
+
+  void TearDown() override {
+    close(pipe_fds_[0]);
+  }
+
+  // Everything available on the read end of the pipe
+  std::vector<uint8_t> Read() {
+    std::vector<uint8_t> result;
+    uint8_t buffer[256];
+    ssize_t length;
+    while (true) {
+      RUN_NO_INTR(length = read(pipe_fds_[0], buffer, sizeof(buffer)));
+      if (length <= 0) {
+        return result;
+      }
+      result.insert(result.end(), buffer, buffer + length);
+    }
+  }
+
+  // Decompress a gzip stream, which doesn't need to be finished. Sets |finished| when it is.
+  static std::vector<uint8_t> Inflate(std::vector<uint8_t> compressed, bool* finished) {
+    z_stream stream = {};
+    EXPECT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+    std::vector<uint8_t> result(1 << 16);
+    stream.next_in = compressed.data();
+    stream.avail_in = compressed.size();
+    stream.next_out = result.data();
+    stream.avail_out = result.size();
+    int status = inflate(&stream, Z_SYNC_FLUSH);
+    EXPECT_TRUE(status == Z_OK || status == Z_STREAM_END);
+    *finished = status == Z_STREAM_END;
+    result.resize(result.size() - stream.avail_out);
+    inflateEnd(&stream);
+    return result;
+  }
+
+  static bool Append(SnoopWriter* writer, std::vector<uint8_t> header, std::vector<uint8_t> payload) {
+    struct iovec iov[] = {{header.data(), header.size()}, {payload.data(), payload.size()}};
+    return writer->Append(iov, 2);
+  }
+
+  int pipe_fds_[2];
+};
+
+TEST_F(SnoopWriterTest, flush_writes_records_in_order) {
+  SnoopWriter writer(64, SnoopWriter::FsyncPolicy::NEVER, kNoPeriodicFlush);
+  writer.SetFd(pipe_fds_[1]);
+  ASSERT_TRUE(Append(&writer, {1, 2}, {3}));
+  ASSERT_TRUE(Append(&writer, {4}, {5, 6}));
+  writer.Flush();
+  ASSERT_EQ(Read(), std::vector<uint8_t>({1, 2, 3, 4, 5, 6}));
+  ASSERT_EQ(writer.GetDroppedPackets(), 0u);
+}
+
+TEST_F(SnoopWriterTest, records_wrap_around_the_ring) {
+  SnoopWriter writer(64, SnoopWriter::FsyncPolicy::NEVER, kNoPeriodicFlush);
+  writer.SetFd(pipe_fds_[1]);
+  std::vector<uint8_t> expected;
+  for (uint8_t i = 0; i < 20; i++) {
+    std::vector<uint8_t> payload(10, i);
+    ASSERT_TRUE(Append(&writer, {i}, payload));
+    expected.push_back(i);
+    expected.insert(expected.end(), payload.begin(), payload.end());
+    if (i % 3 == 0) {
+      writer.Flush();
+    }
+  }
+  writer.Flush();
+  ASSERT_EQ(Read(), expected);
+}
+
+TEST_F(SnoopWriterTest, record_larger_than_free_space_is_dropped) {
+  SnoopWriter writer(64, SnoopWriter::FsyncPolicy::NEVER, kNoPeriodicFlush);
+  writer.SetFd(pipe_fds_[1]);
+  ASSERT_FALSE(Append(&writer, {1}, std::vector<uint8_t>(64, 2)));
+  ASSERT_EQ(writer.GetDroppedPackets(), 1u);
+  ASSERT_TRUE(Append(&writer, {3}, {4}));
+  writer.Flush();
+  ASSERT_EQ(Read(), std::vector<uint8_t>({3, 4}));
+  ASSERT_EQ(writer.GetDroppedPackets(), 1u);
+}
+
+TEST_F(SnoopWriterTest, background_thread_writes_without_flush) {
+  SnoopWriter writer(64, SnoopWriter::FsyncPolicy::EVERY_BATCH, std::chrono::milliseconds(10));
+  writer.SetFd(pipe_fds_[1]);
+  ASSERT_TRUE(Append(&writer, {1}, {2}));
+  std::vector<uint8_t> data;
+  for (int i = 0; i < 100 && data.size() < 2; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    auto read = Read();
+    data.insert(data.end(), read.begin(), read.end());
+  }
+  ASSERT_EQ(data, std::vector<uint8_t>({1, 2}));
+}
+
+TEST_F(SnoopWriterTest, set_fd_writes_out_to_previous_fd) {
+  int other_pipe_fds[2];
+  ASSERT_EQ(pipe2(other_pipe_fds, O_NONBLOCK), 0);
+  {
+    SnoopWriter writer(64, SnoopWriter::FsyncPolicy::ON_FLUSH, kNoPeriodicFlush);
+    writer.SetFd(pipe_fds_[1]);
+    ASSERT_TRUE(Append(&writer, {1}, {2}));
+    writer.SetFd(other_pipe_fds[1]);
+    ASSERT_TRUE(Append(&writer, {3}, {4}));
+    ASSERT_EQ(Read(), std::vector<uint8_t>({1, 2}));
+    // The destructor writes out the rest and closes the file descriptor
+  }
+  uint8_t buffer[4];
+  ssize_t length;
+  RUN_NO_INTR(length = read(other_pipe_fds[0], buffer, sizeof(buffer)));
+  ASSERT_EQ(length, 2);
+  ASSERT_EQ(buffer[0], 3);
+  ASSERT_EQ(buffer[1], 4);
+  RUN_NO_INTR(length = read(other_pipe_fds[0], buffer, sizeof(buffer)));
+  ASSERT_EQ(length, 0);
+  close(other_pipe_fds[0]);
+}
+
+TEST_F(SnoopWriterTest, gzip_stream_decompresses_up_to_each_flush) {
+  SnoopWriter writer(8192, SnoopWriter::FsyncPolicy::NEVER, kNoPeriodicFlush, SnoopWriter::Compression::GZIP);
+  writer.SetFd(pipe_fds_[1]);
+  std::vector<uint8_t> expected;
+  for (uint8_t i = 0; i < 50; i++) {
+    std::vector<uint8_t> payload(100, i % 4);
+    ASSERT_TRUE(Append(&writer, {i}, payload));
+    expected.push_back(i);
+    expected.insert(expected.end(), payload.begin(), payload.end());
+  }
+  writer.Flush();
+  std::vector<uint8_t> compressed = Read();
+  ASSERT_EQ(writer.GetFileSize(), compressed.size());
+  ASSERT_LT(compressed.size(), expected.size() / 4);
+  bool finished;
+  ASSERT_EQ(Inflate(compressed, &finished), expected);
+  ASSERT_FALSE(finished);
+
+  ASSERT_TRUE(Append(&writer, {1, 2}, {3}));
+  expected.insert(expected.end(), {1, 2, 3});
+  writer.SetFd(-1);
+  std::vector<uint8_t> rest = Read();
+  compressed.insert(compressed.end(), rest.begin(), rest.end());
+  ASSERT_EQ(Inflate(compressed, &finished), expected);
+  ASSERT_TRUE(finished);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
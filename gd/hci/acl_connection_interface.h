@@ -39,6 +39,7 @@ constexpr EventCode AclConnectionEvents[] = {
     EventCode::READ_REMOTE_EXTENDED_FEATURES_COMPLETE,
     EventCode::READ_REMOTE_VERSION_INFORMATION_COMPLETE,
     EventCode::LINK_SUPERVISION_TIMEOUT_CHANGED,
+    EventCode::PAGE_SCAN_REPETITION_MODE_CHANGE,
 };
 
 typedef CommandInterface<ConnectionManagementCommandBuilder> AclConnectionInterface;
@@ -24,7 +24,7 @@
 #include "hci/acl_manager/connection_management_callbacks.h"
 #include "hci/acl_manager/le_acl_connection.h"
 #include "hci/acl_manager/le_impl.h"
-#include "hci/acl_manager/round_robin_scheduler.h"
+#include "hci/acl_manager/weighted_fair_scheduler.h"
 #include "hci/controller.h"
 #include "hci/hci_layer.h"
 #include "security/security_module.h"
@@ -46,7 +46,9 @@ using acl_manager::le_impl;
 using acl_manager::LeAclConnection;
 using acl_manager::LeConnectionCallbacks;
 
-using acl_manager::RoundRobinScheduler;
+using acl_manager::AclPriority;
+using acl_manager::AclScheduler;
+using acl_manager::WeightedFairScheduler;
 
 struct AclManager::impl {
   impl(const AclManager& acl_manager) : acl_manager_(acl_manager) {}
@@ -55,20 +57,20 @@ struct AclManager::impl {
     hci_layer_ = acl_manager_.GetDependency<HciLayer>();
     handler_ = acl_manager_.GetHandler();
     controller_ = acl_manager_.GetDependency<Controller>();
-    round_robin_scheduler_ = new RoundRobinScheduler(handler_, controller_, hci_layer_->GetAclQueueEnd());
+    acl_scheduler_ = new WeightedFairScheduler(handler_, controller_, hci_layer_->GetAclQueueEnd());
 
     hci_queue_end_ = hci_layer_->GetAclQueueEnd();
     hci_queue_end_->RegisterDequeue(
         handler_, common::Bind(&impl::dequeue_and_route_acl_packet_to_connection, common::Unretained(this)));
-    classic_impl_ = new classic_impl(hci_layer_, controller_, handler_, round_robin_scheduler_);
-    le_impl_ = new le_impl(hci_layer_, controller_, handler_, round_robin_scheduler_, classic_impl_);
+    classic_impl_ = new classic_impl(hci_layer_, controller_, handler_, acl_scheduler_);
+    le_impl_ = new le_impl(hci_layer_, controller_, handler_, acl_scheduler_, classic_impl_);
   }
 
   void Stop() {
     delete le_impl_;
     delete classic_impl_;
     hci_queue_end_->UnregisterDequeue();
-    delete round_robin_scheduler_;
+    delete acl_scheduler_;
     if (enqueue_registered_.exchange(false)) {
       hci_queue_end_->UnregisterEnqueue();
     }
@@ -109,7 +111,7 @@ struct AclManager::impl {
   os::Handler* handler_ = nullptr;
   Controller* controller_ = nullptr;
   HciLayer* hci_layer_ = nullptr;
-  RoundRobinScheduler* round_robin_scheduler_ = nullptr;
+  AclScheduler* acl_scheduler_ = nullptr;
   common::BidiQueueEnd<AclPacketBuilder, AclPacketView>* hci_queue_end_ = nullptr;
   std::atomic_bool enqueue_registered_ = false;
   uint16_t default_link_policy_settings_ = 0xffff;
@@ -137,6 +139,20 @@ void AclManager::CreateConnection(Address address) {
   CallOn(pimpl_->classic_impl_, &classic_impl::create_connection, address);
 }
 
+void AclManager::SetPageScanHint(
+    Address address,
+    PageScanRepetitionMode page_scan_repetition_mode,
+    uint16_t clock_offset,
+    ClockOffsetValid clock_offset_valid) {
+  CallOn(
+      pimpl_->classic_impl_,
+      &classic_impl::set_page_scan_hint,
+      address,
+      page_scan_repetition_mode,
+      clock_offset,
+      clock_offset_valid);
+}
+
 void AclManager::CreateLeConnection(AddressWithType address_with_type) {
   CallOn(pimpl_->le_impl_, &le_impl::create_le_connection, address_with_type, true);
 }
@@ -219,6 +235,10 @@ void AclManager::WriteDefaultLinkPolicySettings(uint16_t default_link_policy_set
   CallOn(pimpl_->classic_impl_, &classic_impl::write_default_link_policy_settings, default_link_policy_settings);
 }
 
+void AclManager::SetAclPriority(uint16_t handle, AclPriority priority) {
+  CallOn(pimpl_->acl_scheduler_, &AclScheduler::SetPriority, handle, priority);
+}
+
 void AclManager::SetSecurityModule(security::SecurityModule* security_module) {
   CallOn(pimpl_->classic_impl_, &classic_impl::set_security_module, security_module);
 }
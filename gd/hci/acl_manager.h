@@ -20,6 +20,7 @@
 
 #include "common/bidi_queue.h"
 #include "common/callback.h"
+#include "hci/acl_manager/acl_scheduler.h"
 #include "hci/acl_manager/connection_callbacks.h"
 #include "hci/acl_manager/le_connection_callbacks.h"
 #include "hci/address.h"
@@ -61,6 +62,13 @@ class AclManager : public Module {
   // Generates OnConnectSuccess if connected, or OnConnectFail otherwise
   virtual void CreateConnection(Address address);
 
+  // Page scan parameters last seen for |address|, e.g. in an inquiry result, used by later CreateConnection calls
+  virtual void SetPageScanHint(
+      Address address,
+      PageScanRepetitionMode page_scan_repetition_mode,
+      uint16_t clock_offset,
+      ClockOffsetValid clock_offset_valid);
+
   // Generates OnLeConnectSuccess if connected, or OnLeConnectFail otherwise
   virtual void CreateLeConnection(AddressWithType address_with_type);
 
@@ -97,6 +105,9 @@ class AclManager : public Module {
   virtual uint16_t ReadDefaultLinkPolicySettings();
   virtual void WriteDefaultLinkPolicySettings(uint16_t default_link_policy_settings);
 
+  // Share of the controller buffers given to the connection |handle| when other connections are busy too
+  virtual void SetAclPriority(uint16_t handle, acl_manager::AclPriority priority);
+
   // In order to avoid circular dependency use setter rather than module dependency.
   virtual void SetSecurityModule(security::SecurityModule* security_module);
 
@@ -0,0 +1,328 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/bidi_queue.h"
+#include "common/bind.h"
+#include "hci/acl_manager/round_robin_scheduler.h"
+#include "hci/acl_manager/weighted_fair_scheduler.h"
+#include "hci/controller.h"
+#include "hci/hci_packets.h"
+#include "os/handler.h"
+#include "os/repeating_alarm.h"
+#include "os/thread.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+using ::bluetooth::common::BidiQueue;
+using ::bluetooth::common::Bind;
+using ::bluetooth::common::BindOnce;
+using ::bluetooth::common::Unretained;
+using ::bluetooth::hci::AclPacketBuilder;
+using ::bluetooth::hci::AclPacketView;
+using ::bluetooth::hci::Controller;
+using ::bluetooth::hci::LeBufferSize;
+using ::bluetooth::hci::acl_manager::AclConnection;
+using ::bluetooth::hci::acl_manager::AclPriority;
+using ::bluetooth::hci::acl_manager::AclScheduler;
+using ::bluetooth::hci::acl_manager::RoundRobinScheduler;
+using ::bluetooth::hci::acl_manager::WeightedFairScheduler;
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::RepeatingAlarm;
+using ::bluetooth::os::Thread;
+
+namespace {
+
+enum SchedulerKind { ROUND_ROBIN, WEIGHTED_FAIR };
+
+constexpr uint16_t kCredits = 8;
+constexpr uint16_t kMtu = 1021;
+// The controller sends this many packets over the air every slot, and reports them completed
+constexpr int kPacketsPerSlot = 4;
+constexpr std::chrono::milliseconds kSlot(1);
+constexpr size_t kBulkPacketSize = 3 * kMtu;
+constexpr size_t kAudioPacketSize = 600;
+// An audio packet is ready every this many fragments sent
+constexpr uint64_t kAudioInterval = 16;
+constexpr uint64_t kFragmentsPerIteration = 1000;
+constexpr uint16_t kAudioHandle = 0x01;
+constexpr uint16_t kFirstBulkHandle = 0x10;
+
+class BenchmarkController : public Controller {
+ public:
+  uint16_t GetNumAclPacketBuffers() const override {
+    return kCredits;
+  }
+
+  uint16_t GetAclPacketLength() const override {
+    return kMtu;
+  }
+
+  LeBufferSize GetLeBufferSize() const override {
+    LeBufferSize le_buffer_size;
+    le_buffer_size.le_data_packet_length_ = 27;
+    le_buffer_size.total_num_le_packets_ = kCredits;
+    return le_buffer_size;
+  }
+
+  void RegisterCompletedAclPacketsCallback(CompletedAclPacketsCallback cb) override {
+    acl_credits_callback_ = cb;
+  }
+
+  void UnregisterCompletedAclPacketsCallback() override {
+    acl_credits_callback_ = {};
+  }
+
+  void SendCompletedAclPacketsCallback(uint16_t handle, uint16_t credits) {
+    acl_credits_callback_.Invoke(handle, credits);
+  }
+
+ private:
+  CompletedAclPacketsCallback acl_credits_callback_;
+};
+
+// Bulk connections keep their queues full while an audio connection sends a short packet at regular intervals,
+// and the controller drains its buffers at a fixed air rate
+class BM_AclScheduler : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    thread_ = std::make_unique<Thread>("acl_scheduler_benchmark", Thread::Priority::NORMAL);
+    handler_ = std::make_unique<Handler>(thread_.get());
+    controller_ = std::make_unique<BenchmarkController>();
+    hci_queue_ = std::make_unique<BidiQueue<AclPacketView, AclPacketBuilder>>(3);
+    stopping_ = false;
+    fragments_sent_ = 0;
+    target_ = 0;
+    done_ = nullptr;
+    audio_pending_ = false;
+    audio_enqueue_registered_ = false;
+    audio_packets_ = 0;
+    audio_latency_sum_us_ = 0;
+    audio_latency_max_us_ = 0;
+    in_flight_ = {};
+
+    if (st.range(0) == ROUND_ROBIN) {
+      scheduler_ = std::make_unique<RoundRobinScheduler>(handler_.get(), controller_.get(), hci_queue_->GetUpEnd());
+    } else {
+      scheduler_ = std::make_unique<WeightedFairScheduler>(handler_.get(), controller_.get(), hci_queue_->GetUpEnd());
+    }
+    run_on_handler(BindOnce(&BM_AclScheduler::start, Unretained(this), static_cast<int>(st.range(1))));
+  }
+
+  void TearDown(State& st) override {
+    run_on_handler(BindOnce(&BM_AclScheduler::stop_traffic, Unretained(this)));
+    // Without completed packets the scheduler runs out of credits and goes idle
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    run_on_handler(BindOnce(&BM_AclScheduler::stop, Unretained(this)));
+    handler_->Clear();
+    handler_ = nullptr;
+    thread_ = nullptr;
+    hci_queue_ = nullptr;
+    bulk_queues_.clear();
+    audio_queue_ = nullptr;
+    controller_ = nullptr;
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  void run_on_handler(bluetooth::common::OnceClosure task) {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_->Post(BindOnce(
+        [](bluetooth::common::OnceClosure task, std::promise<void>* promise) {
+          std::move(task).Run();
+          promise->set_value();
+        },
+        std::move(task),
+        Unretained(&promise)));
+    future.wait();
+  }
+
+  void start(int bulk_connections) {
+    hci_queue_->GetDownEnd()->RegisterDequeue(handler_.get(), Bind(&BM_AclScheduler::on_hci_packet, Unretained(this)));
+    air_ = std::make_unique<RepeatingAlarm>(handler_.get());
+    air_->Schedule(Bind(&BM_AclScheduler::on_slot, Unretained(this)), kSlot);
+
+    audio_queue_ = std::make_shared<AclConnection::Queue>(10);
+    scheduler_->Register(AclScheduler::ConnectionType::CLASSIC, kAudioHandle, audio_queue_);
+    scheduler_->SetPriority(kAudioHandle, AclPriority::AUDIO);
+    for (int i = 0; i < bulk_connections; i++) {
+      auto queue = std::make_shared<AclConnection::Queue>(10);
+      scheduler_->Register(AclScheduler::ConnectionType::CLASSIC, kFirstBulkHandle + i, queue);
+      queue->GetUpEnd()->RegisterEnqueue(handler_.get(), Bind(&BM_AclScheduler::make_bulk_packet));
+      bulk_queues_.push_back(queue);
+    }
+  }
+
+  void stop_traffic() {
+    stopping_ = true;
+    air_->Cancel();
+    air_ = nullptr;
+    for (auto& queue : bulk_queues_) {
+      queue->GetUpEnd()->UnregisterEnqueue();
+    }
+    if (audio_enqueue_registered_) {
+      audio_enqueue_registered_ = false;
+      audio_queue_->GetUpEnd()->UnregisterEnqueue();
+    }
+  }
+
+  void stop() {
+    hci_queue_->GetDownEnd()->UnregisterDequeue();
+    scheduler_ = nullptr;
+  }
+
+  static std::unique_ptr<bluetooth::packet::BasePacketBuilder> make_bulk_packet() {
+    auto packet = std::make_unique<bluetooth::packet::RawBuilder>();
+    packet->AddOctets(std::vector<uint8_t>(kBulkPacketSize, 0xb0));
+    return packet;
+  }
+
+  std::unique_ptr<bluetooth::packet::BasePacketBuilder> make_audio_packet() {
+    audio_enqueue_registered_ = false;
+    audio_queue_->GetUpEnd()->UnregisterEnqueue();
+    auto packet = std::make_unique<bluetooth::packet::RawBuilder>();
+    packet->AddOctets(std::vector<uint8_t>(kAudioPacketSize, 0xa0));
+    return packet;
+  }
+
+  void on_hci_packet() {
+    auto packet = hci_queue_->GetDownEnd()->TryDequeue();
+    auto bytes = std::make_shared<std::vector<uint8_t>>();
+    bluetooth::packet::BitInserter inserter(*bytes);
+    bytes->reserve(packet->size());
+    packet->Serialize(inserter);
+    auto acl_packet_view =
+        AclPacketView::Create(bluetooth::packet::PacketView<bluetooth::packet::kLittleEndian>(bytes));
+    ASSERT(acl_packet_view.IsValid());
+    if (stopping_) {
+      return;
+    }
+
+    uint16_t handle = acl_packet_view.GetHandle();
+    in_flight_.push(handle);
+    fragments_sent_++;
+    if (handle == kAudioHandle) {
+      auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                           audio_ready_time_);
+      audio_packets_++;
+      audio_latency_sum_us_ += latency.count();
+      audio_latency_max_us_ = std::max<uint64_t>(audio_latency_max_us_, latency.count());
+      audio_pending_ = false;
+    }
+    if (!audio_pending_ && fragments_sent_ % kAudioInterval == 0) {
+      audio_pending_ = true;
+      audio_ready_time_ = std::chrono::steady_clock::now();
+      audio_enqueue_registered_ = true;
+      audio_queue_->GetUpEnd()->RegisterEnqueue(
+          handler_.get(), Bind(&BM_AclScheduler::make_audio_packet, Unretained(this)));
+    }
+    if (done_ != nullptr && fragments_sent_ >= target_) {
+      done_->set_value();
+      done_ = nullptr;
+    }
+  }
+
+  void on_slot() {
+    std::map<uint16_t, uint16_t> completed;
+    for (int i = 0; i < kPacketsPerSlot && !in_flight_.empty(); i++) {
+      completed[in_flight_.front()]++;
+      in_flight_.pop();
+    }
+    for (const auto& [handle, credits] : completed) {
+      controller_->SendCompletedAclPacketsCallback(handle, credits);
+    }
+  }
+
+  void wait_for_fragments(std::promise<void>* done) {
+    target_ = fragments_sent_ + kFragmentsPerIteration;
+    done_ = done;
+  }
+
+  void read_audio_stats(uint64_t* packets, uint64_t* latency_sum_us, uint64_t* latency_max_us) {
+    *packets = audio_packets_;
+    *latency_sum_us = audio_latency_sum_us_;
+    *latency_max_us = audio_latency_max_us_;
+  }
+
+  void WaitForNextFragments() {
+    std::promise<void> done;
+    auto future = done.get_future();
+    run_on_handler(BindOnce(&BM_AclScheduler::wait_for_fragments, Unretained(this), Unretained(&done)));
+    future.wait();
+  }
+
+  void ReportAudioLatency(State& state) {
+    uint64_t audio_packets = 0;
+    uint64_t audio_latency_sum_us = 0;
+    uint64_t audio_latency_max_us = 0;
+    run_on_handler(BindOnce(&BM_AclScheduler::read_audio_stats, Unretained(this), Unretained(&audio_packets),
+                            Unretained(&audio_latency_sum_us), Unretained(&audio_latency_max_us)));
+    state.counters["audio_packets"] = audio_packets;
+    state.counters["audio_latency_mean_us"] = audio_packets == 0 ? 0 : audio_latency_sum_us / audio_packets;
+    state.counters["audio_latency_max_us"] = audio_latency_max_us;
+  }
+
+  std::unique_ptr<Thread> thread_;
+  std::unique_ptr<Handler> handler_;
+  std::unique_ptr<BenchmarkController> controller_;
+  std::unique_ptr<BidiQueue<AclPacketView, AclPacketBuilder>> hci_queue_;
+  std::unique_ptr<AclScheduler> scheduler_;
+  std::unique_ptr<RepeatingAlarm> air_;
+  std::vector<std::shared_ptr<AclConnection::Queue>> bulk_queues_;
+  std::shared_ptr<AclConnection::Queue> audio_queue_;
+
+  // Accessed on the handler thread only
+  bool stopping_;
+  uint64_t fragments_sent_;
+  uint64_t target_;
+  std::promise<void>* done_;
+  std::queue<uint16_t> in_flight_;
+  bool audio_pending_;
+  bool audio_enqueue_registered_;
+  std::chrono::steady_clock::time_point audio_ready_time_;
+  uint64_t audio_packets_;
+  uint64_t audio_latency_sum_us_;
+  uint64_t audio_latency_max_us_;
+};
+
+BENCHMARK_DEFINE_F(BM_AclScheduler, bulk_and_audio)(State& state) {
+  for (auto _ : state) {
+    WaitForNextFragments();
+  }
+  state.SetItemsProcessed(state.iterations() * kFragmentsPerIteration);
+  ReportAudioLatency(state);
+}
+
+BENCHMARK_REGISTER_F(BM_AclScheduler, bulk_and_audio)
+    ->Args({ROUND_ROBIN, 1})
+    ->Args({WEIGHTED_FAIR, 1})
+    ->Args({ROUND_ROBIN, 3})
+    ->Args({WEIGHTED_FAIR, 3})
+    ->Iterations(8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -17,10 +17,10 @@
 #pragma once
 
 #include "common/bind.h"
+#include "hci/acl_manager/acl_scheduler.h"
 #include "hci/acl_manager/assembler.h"
 #include "hci/acl_manager/disconnector_for_le.h"
 #include "hci/acl_manager/event_checkers.h"
-#include "hci/acl_manager/round_robin_scheduler.h"
 #include "hci/controller.h"
 #include "security/security_manager_listener.h"
 #include "security/security_module.h"
@@ -38,10 +38,16 @@ struct acl_connection {
   ConnectionManagementCallbacks* connection_management_callbacks_ = nullptr;
 };
 
+// What is known about how a remote pages, used to skip the default R1 page train when connecting to it
+struct page_scan_hint {
+  PageScanRepetitionMode page_scan_repetition_mode_ = PageScanRepetitionMode::R1;
+  uint16_t clock_offset_ = 0;
+  ClockOffsetValid clock_offset_valid_ = ClockOffsetValid::INVALID;
+};
+
 struct classic_impl : public DisconnectorForLe, public security::ISecurityManagerListener {
-  classic_impl(HciLayer* hci_layer, Controller* controller, os::Handler* handler,
-               RoundRobinScheduler* round_robin_scheduler)
-      : hci_layer_(hci_layer), controller_(controller), round_robin_scheduler_(round_robin_scheduler) {
+  classic_impl(HciLayer* hci_layer, Controller* controller, os::Handler* handler, AclScheduler* acl_scheduler)
+      : hci_layer_(hci_layer), controller_(controller), acl_scheduler_(acl_scheduler) {
     hci_layer_ = hci_layer;
     controller_ = controller;
     handler_ = handler;
@@ -104,6 +110,9 @@ struct classic_impl : public DisconnectorForLe, public security::ISecurityManage
       case EventCode::LINK_SUPERVISION_TIMEOUT_CHANGED:
         on_link_supervision_timeout_changed(event_packet);
         break;
+      case EventCode::PAGE_SCAN_REPETITION_MODE_CHANGE:
+        on_page_scan_repetition_mode_change(event_packet);
+        break;
       default:
         LOG_ALWAYS_FATAL("Unhandled event code %s", EventCodeText(event_code).c_str());
     }
@@ -112,7 +121,7 @@ struct classic_impl : public DisconnectorForLe, public security::ISecurityManage
   void on_classic_disconnect(uint16_t handle, ErrorCode reason) {
     if (acl_connections_.count(handle) == 1) {
       auto& connection = acl_connections_.find(handle)->second;
-      round_robin_scheduler_->Unregister(handle);
+      acl_scheduler_->Unregister(handle);
       connection.connection_management_callbacks_->OnDisconnection(reason);
       acl_connections_.erase(handle);
     }
@@ -167,6 +176,12 @@ struct classic_impl : public DisconnectorForLe, public security::ISecurityManage
     PageScanRepetitionMode page_scan_repetition_mode = PageScanRepetitionMode::R1;
     uint16_t clock_offset = 0;
     ClockOffsetValid clock_offset_valid = ClockOffsetValid::INVALID;
+    auto hint = page_scan_hints_.find(address);
+    if (hint != page_scan_hints_.end()) {
+      page_scan_repetition_mode = hint->second.page_scan_repetition_mode_;
+      clock_offset = hint->second.clock_offset_;
+      clock_offset_valid = hint->second.clock_offset_valid_;
+    }
     CreateConnectionRoleSwitch allow_role_switch = CreateConnectionRoleSwitch::ALLOW_ROLE_SWITCH;
     ASSERT(client_callbacks_ != nullptr);
     std::unique_ptr<CreateConnectionBuilder> packet = CreateConnectionBuilder::Create(
@@ -212,7 +227,7 @@ struct classic_impl : public DisconnectorForLe, public security::ISecurityManage
     acl_connections_.emplace(std::piecewise_construct, std::forward_as_tuple(handle),
                              std::forward_as_tuple(AddressWithType{address, AddressType::PUBLIC_DEVICE_ADDRESS},
                                                    queue->GetDownEnd(), handler_));
-    round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::CLASSIC, handle, queue);
+    acl_scheduler_->Register(AclScheduler::ConnectionType::CLASSIC, handle, queue);
     std::unique_ptr<ClassicAclConnection> connection(
         new ClassicAclConnection(std::move(queue), acl_connection_interface_, handle, address));
     auto& connection_proxy = check_and_get_connection(handle);
@@ -351,9 +366,33 @@ struct classic_impl : public DisconnectorForLe, public security::ISecurityManage
     uint16_t handle = complete_view.GetConnectionHandle();
     auto& acl_connection = acl_connections_.find(handle)->second;
     uint16_t clock_offset = complete_view.GetClockOffset();
+    auto& hint = page_scan_hints_[acl_connection.address_with_type_.GetAddress()];
+    hint.clock_offset_ = clock_offset;
+    hint.clock_offset_valid_ = ClockOffsetValid::VALID;
     acl_connection.connection_management_callbacks_->OnReadClockOffsetComplete(clock_offset);
   }
 
+  void on_page_scan_repetition_mode_change(EventPacketView packet) {
+    PageScanRepetitionModeChangeView mode_change_view = PageScanRepetitionModeChangeView::Create(packet);
+    if (!mode_change_view.IsValid()) {
+      LOG_ERROR("Received on_page_scan_repetition_mode_change with invalid packet");
+      return;
+    }
+    page_scan_hints_[mode_change_view.GetBdAddr()].page_scan_repetition_mode_ =
+        mode_change_view.GetPageScanRepetitionMode();
+  }
+
+  void set_page_scan_hint(Address address, PageScanRepetitionMode page_scan_repetition_mode, uint16_t clock_offset,
+                          ClockOffsetValid clock_offset_valid) {
+    auto& hint = page_scan_hints_[address];
+    hint.page_scan_repetition_mode_ = page_scan_repetition_mode;
+    // Keep an offset learned from a connection over an invalid one, e.g. a hint restored from storage
+    if (clock_offset_valid == ClockOffsetValid::VALID || hint.clock_offset_valid_ == ClockOffsetValid::INVALID) {
+      hint.clock_offset_ = clock_offset & 0x7fff;
+      hint.clock_offset_valid_ = clock_offset_valid;
+    }
+  }
+
   void on_mode_change(EventPacketView packet) {
     ModeChangeView mode_change_view = ModeChangeView::Create(packet);
     if (!mode_change_view.IsValid()) {
@@ -531,7 +570,7 @@ struct classic_impl : public DisconnectorForLe, public security::ISecurityManage
 
   HciLayer* hci_layer_ = nullptr;
   Controller* controller_ = nullptr;
-  RoundRobinScheduler* round_robin_scheduler_ = nullptr;
+  AclScheduler* acl_scheduler_ = nullptr;
   AclConnectionInterface* acl_connection_interface_ = nullptr;
   os::Handler* handler_ = nullptr;
   ConnectionCallbacks* client_callbacks_ = nullptr;
@@ -541,6 +580,7 @@ struct classic_impl : public DisconnectorForLe, public security::ISecurityManage
   Address incoming_connecting_address_{Address::kEmpty};
   common::Callback<bool(Address, ClassOfDevice)> should_accept_connection_;
   std::queue<std::pair<Address, std::unique_ptr<CreateConnectionBuilder>>> pending_outgoing_connections_;
+  std::unordered_map<Address, page_scan_hint> page_scan_hints_;
 
   std::unique_ptr<security::SecurityManager> security_manager_;
 };
@@ -18,9 +18,9 @@
 
 #include "common/bind.h"
 #include "crypto_toolbox/crypto_toolbox.h"
+#include "hci/acl_manager/acl_scheduler.h"
 #include "hci/acl_manager/assembler.h"
 #include "hci/acl_manager/disconnector_for_le.h"
-#include "hci/acl_manager/round_robin_scheduler.h"
 #include "hci/le_address_manager.h"
 #include "os/alarm.h"
 #include "os/rand.h"
@@ -44,9 +44,9 @@ struct le_acl_connection {
 };
 
 struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
-  le_impl(HciLayer* hci_layer, Controller* controller, os::Handler* handler, RoundRobinScheduler* round_robin_scheduler,
+  le_impl(HciLayer* hci_layer, Controller* controller, os::Handler* handler, AclScheduler* acl_scheduler,
           DisconnectorForLe* disconnector)
-      : hci_layer_(hci_layer), controller_(controller), round_robin_scheduler_(round_robin_scheduler),
+      : hci_layer_(hci_layer), controller_(controller), acl_scheduler_(acl_scheduler),
         disconnector_(disconnector) {
     hci_layer_ = hci_layer;
     controller_ = controller;
@@ -92,7 +92,7 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
   void on_le_disconnect(uint16_t handle, ErrorCode reason) {
     if (le_acl_connections_.count(handle) == 1) {
       auto& connection = le_acl_connections_.find(handle)->second;
-      round_robin_scheduler_->Unregister(handle);
+      acl_scheduler_->Unregister(handle);
       connection.le_connection_management_callbacks_->OnDisconnection(reason);
       le_acl_connections_.erase(handle);
     }
@@ -150,7 +150,7 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     auto& connection_proxy = check_and_get_le_connection(handle);
     auto do_disconnect =
         common::BindOnce(&DisconnectorForLe::handle_disconnect, common::Unretained(disconnector_), handle);
-    round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::LE, handle, queue);
+    acl_scheduler_->Register(AclScheduler::ConnectionType::LE, handle, queue);
     std::unique_ptr<LeAclConnection> connection(new LeAclConnection(std::move(queue), le_acl_connection_interface_,
                                                                     std::move(do_disconnect), handle, local_address,
                                                                     remote_address, role));
@@ -201,7 +201,7 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     le_acl_connections_.emplace(std::piecewise_construct, std::forward_as_tuple(handle),
                                 std::forward_as_tuple(remote_address, queue->GetDownEnd(), handler_));
     auto& connection_proxy = check_and_get_le_connection(handle);
-    round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::LE, handle, queue);
+    acl_scheduler_->Register(AclScheduler::ConnectionType::LE, handle, queue);
     auto role = connection_complete.GetRole();
     auto do_disconnect =
         common::BindOnce(&DisconnectorForLe::handle_disconnect, common::Unretained(disconnector_), handle);
@@ -513,7 +513,7 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
   HciLayer* hci_layer_ = nullptr;
   Controller* controller_ = nullptr;
   os::Handler* handler_ = nullptr;
-  RoundRobinScheduler* round_robin_scheduler_ = nullptr;
+  AclScheduler* acl_scheduler_ = nullptr;
   LeAddressManager* le_address_manager_ = nullptr;
   LeAclConnectionInterface* le_acl_connection_interface_ = nullptr;
   LeConnectionCallbacks* le_client_callbacks_ = nullptr;
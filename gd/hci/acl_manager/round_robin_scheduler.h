@@ -20,6 +20,7 @@
 
 #include "common/bidi_queue.h"
 #include "hci/acl_manager.h"
+#include "hci/acl_manager/acl_scheduler.h"
 #include "hci/controller.h"
 #include "hci/hci_packets.h"
 #include "os/handler.h"
@@ -28,13 +29,11 @@ namespace bluetooth {
 namespace hci {
 namespace acl_manager {
 
-class RoundRobinScheduler {
+class RoundRobinScheduler : public AclScheduler {
  public:
   RoundRobinScheduler(os::Handler* handler, Controller* controller,
                       common::BidiQueueEnd<AclPacketBuilder, AclPacketView>* hci_queue_end);
-  ~RoundRobinScheduler();
-
-  enum ConnectionType { CLASSIC, LE };
+  ~RoundRobinScheduler() override;
 
   struct acl_queue_handler {
     ConnectionType connection_type_;
@@ -44,10 +43,10 @@ class RoundRobinScheduler {
   };
 
   void Register(ConnectionType connection_type, uint16_t handle,
-                std::shared_ptr<acl_manager::AclConnection::Queue> queue);
-  void Unregister(uint16_t handle);
-  uint16_t GetCredits();
-  uint16_t GetLeCredits();
+                std::shared_ptr<acl_manager::AclConnection::Queue> queue) override;
+  void Unregister(uint16_t handle) override;
+  uint16_t GetCredits() override;
+  uint16_t GetLeCredits() override;
 
  private:
   void start_round_robin();
@@ -0,0 +1,292 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/weighted_fair_scheduler.h"
+
+#include <algorithm>
+
+#include "hci/acl_manager/acl_fragmenter.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+namespace {
+// Handle, flags and length preceding the payload of an HCI ACL packet
+constexpr size_t kAclHeaderSize = 4;
+}  // namespace
+
+WeightedFairScheduler::WeightedFairScheduler(os::Handler* handler, Controller* controller,
+                                             common::BidiQueueEnd<AclPacketBuilder, AclPacketView>* hci_queue_end)
+    : handler_(handler), controller_(controller), hci_queue_end_(hci_queue_end) {
+  max_acl_packet_credits_ = controller_->GetNumAclPacketBuffers();
+  acl_packet_credits_ = max_acl_packet_credits_;
+  hci_mtu_ = controller_->GetAclPacketLength();
+  LeBufferSize le_buffer_size = controller_->GetLeBufferSize();
+  le_max_acl_packet_credits_ = le_buffer_size.total_num_le_packets_;
+  le_acl_packet_credits_ = le_max_acl_packet_credits_;
+  le_hci_mtu_ = le_buffer_size.le_data_packet_length_;
+  controller_->RegisterCompletedAclPacketsCallback(handler->BindOn(this, &WeightedFairScheduler::incoming_acl_credits));
+}
+
+WeightedFairScheduler::~WeightedFairScheduler() {
+  for (auto& connection : connections_) {
+    unregister_dequeue(&connection.second);
+  }
+  if (enqueue_registered_) {
+    enqueue_registered_ = false;
+    hci_queue_end_->UnregisterEnqueue();
+  }
+  controller_->UnregisterCompletedAclPacketsCallback();
+}
+
+size_t WeightedFairScheduler::GetWeight(AclPriority priority) {
+  switch (priority) {
+    case AclPriority::AUDIO:
+      return 4;
+    case AclPriority::HID:
+      return 2;
+    case AclPriority::BULK:
+      return 1;
+  }
+  return 1;
+}
+
+void WeightedFairScheduler::Register(ConnectionType connection_type, uint16_t handle,
+                                     std::shared_ptr<acl_manager::AclConnection::Queue> queue) {
+  ASSERT(connections_.count(handle) == 0);
+  connection& connection = connections_[handle];
+  connection.connection_type_ = connection_type;
+  connection.queue_ = std::move(queue);
+  register_dequeue(handle, &connection);
+}
+
+void WeightedFairScheduler::Unregister(uint16_t handle) {
+  ASSERT(connections_.count(handle) == 1);
+  connection& connection = connections_.find(handle)->second;
+  // Reclaim outstanding packets
+  if (connection.connection_type_ == ConnectionType::CLASSIC) {
+    acl_packet_credits_ += connection.number_of_sent_packets_;
+  } else {
+    le_acl_packet_credits_ += connection.number_of_sent_packets_;
+  }
+  unregister_dequeue(&connection);
+  active_.remove(handle);
+  connections_.erase(handle);
+
+  if (select_next_fragment() == connections_.end()) {
+    if (enqueue_registered_) {
+      enqueue_registered_ = false;
+      hci_queue_end_->UnregisterEnqueue();
+    }
+  } else {
+    // Lower priority connections may use the buffers this connection held back
+    send_next_fragment();
+  }
+}
+
+void WeightedFairScheduler::SetPriority(uint16_t handle, AclPriority priority) {
+  auto connection = connections_.find(handle);
+  if (connection == connections_.end()) {
+    LOG_INFO("Dropping priority of unknown connection 0x%0hx", handle);
+    return;
+  }
+  connection->second.priority_ = priority;
+  // The new weight applies from the next turn, the credits held back for it apply right away
+  send_next_fragment();
+}
+
+uint16_t WeightedFairScheduler::GetCredits() {
+  return acl_packet_credits_;
+}
+
+uint16_t WeightedFairScheduler::GetLeCredits() {
+  return le_acl_packet_credits_;
+}
+
+void WeightedFairScheduler::register_dequeue(uint16_t handle, connection* connection) {
+  if (connection->dequeue_is_registered_) {
+    return;
+  }
+  connection->dequeue_is_registered_ = true;
+  connection->queue_->GetDownEnd()->RegisterDequeue(
+      handler_, common::Bind(&WeightedFairScheduler::buffer_packet, common::Unretained(this), handle));
+}
+
+void WeightedFairScheduler::unregister_dequeue(connection* connection) {
+  if (connection->dequeue_is_registered_) {
+    connection->dequeue_is_registered_ = false;
+    connection->queue_->GetDownEnd()->UnregisterDequeue();
+  }
+}
+
+void WeightedFairScheduler::buffer_packet(uint16_t handle) {
+  auto connection = connections_.find(handle);
+  ASSERT(connection != connections_.end());
+  auto packet = connection->second.queue_->GetDownEnd()->TryDequeue();
+  ASSERT(packet != nullptr);
+  // Only one packet per connection is fragmented at a time, the others wait in the connection queue
+  unregister_dequeue(&connection->second);
+
+  BroadcastFlag broadcast_flag = BroadcastFlag::POINT_TO_POINT;
+  ConnectionType connection_type = connection->second.connection_type_;
+  size_t mtu = connection_type == ConnectionType::CLASSIC ? hci_mtu_ : le_hci_mtu_;
+  PacketBoundaryFlag packet_boundary_flag =
+      (connection_type == ConnectionType::CLASSIC ? PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE
+                                                  : PacketBoundaryFlag::FIRST_NON_AUTOMATICALLY_FLUSHABLE);
+  if (packet->size() <= mtu) {
+    connection->second.fragments_.push(
+        AclPacketBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(packet)));
+  } else {
+    auto fragments = AclFragmenter(mtu, std::move(packet)).GetFragments();
+    for (size_t i = 0; i < fragments.size(); i++) {
+      connection->second.fragments_.push(
+          AclPacketBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(fragments[i])));
+      packet_boundary_flag = PacketBoundaryFlag::CONTINUING_FRAGMENT;
+    }
+  }
+  ASSERT(!connection->second.fragments_.empty());
+
+  activate(handle, &connection->second);
+  send_next_fragment();
+}
+
+void WeightedFairScheduler::activate(uint16_t handle, connection* connection) {
+  if (!active_.empty()) {
+    auto& current = connections_.find(active_.front())->second;
+    if (connection->priority_ > current.priority_) {
+      // Preempt at the next fragment, the connection holding the turn keeps its deficit for its next turn
+      current.has_turn_ = false;
+      active_.push_front(handle);
+      return;
+    }
+  }
+  active_.push_back(handle);
+}
+
+bool WeightedFairScheduler::has_credits(const connection& connection) const {
+  bool classic = connection.connection_type_ == ConnectionType::CLASSIC;
+  uint16_t credits = classic ? acl_packet_credits_ : le_acl_packet_credits_;
+  uint16_t max_credits = classic ? max_acl_packet_credits_ : le_max_acl_packet_credits_;
+  uint16_t reserved = 0;
+  for (const auto& other : connections_) {
+    if (other.second.connection_type_ == connection.connection_type_ &&
+        other.second.priority_ > connection.priority_) {
+      reserved++;
+    }
+  }
+  // Always leave at least one buffer to the lowest priority
+  reserved = std::min<uint16_t>(reserved, std::max<uint16_t>(max_credits, 1) - 1);
+  return credits > reserved;
+}
+
+std::map<uint16_t, WeightedFairScheduler::connection>::iterator WeightedFairScheduler::select_next_fragment() {
+  // Leave the turns alone while every active connection waits for buffers
+  bool can_send = std::any_of(active_.begin(), active_.end(), [this](uint16_t handle) {
+    return has_credits(connections_.find(handle)->second);
+  });
+  if (!can_send) {
+    return connections_.end();
+  }
+
+  // A fresh quantum always covers a fragment, so past the connection ending its turn, one pass over the active
+  // connections is enough
+  for (size_t visited = 0; visited <= active_.size(); visited++) {
+    auto current = connections_.find(active_.front());
+    ASSERT(current != connections_.end());
+    connection& connection = current->second;
+    if (has_credits(connection)) {
+      if (!connection.has_turn_) {
+        size_t mtu = connection.connection_type_ == ConnectionType::CLASSIC ? hci_mtu_ : le_hci_mtu_;
+        connection.has_turn_ = true;
+        connection.deficit_ += (mtu + kAclHeaderSize) * GetWeight(connection.priority_);
+      }
+      if (connection.deficit_ >= connection.fragments_.front()->size()) {
+        return current;
+      }
+    }
+    // Connections waiting for buffers keep their deficit but don't earn more
+    connection.has_turn_ = false;
+    active_.splice(active_.end(), active_, active_.begin());
+  }
+  ASSERT_LOG(false, "No fragment fits a fresh quantum");
+  return connections_.end();
+}
+
+void WeightedFairScheduler::send_next_fragment() {
+  if (!enqueue_registered_ && select_next_fragment() != connections_.end()) {
+    enqueue_registered_ = true;
+    hci_queue_end_->RegisterEnqueue(
+        handler_, common::Bind(&WeightedFairScheduler::handle_enqueue_next_fragment, common::Unretained(this)));
+  }
+}
+
+// Invoked from some external Queue Reactable context 1
+std::unique_ptr<AclPacketBuilder> WeightedFairScheduler::handle_enqueue_next_fragment() {
+  auto current = select_next_fragment();
+  ASSERT(current != connections_.end());
+  uint16_t handle = current->first;
+  connection& connection = current->second;
+
+  if (connection.connection_type_ == ConnectionType::CLASSIC) {
+    ASSERT(acl_packet_credits_ > 0);
+    acl_packet_credits_ -= 1;
+  } else {
+    ASSERT(le_acl_packet_credits_ > 0);
+    le_acl_packet_credits_ -= 1;
+  }
+  connection.number_of_sent_packets_++;
+
+  auto fragment = std::move(connection.fragments_.front());
+  connection.fragments_.pop();
+  connection.deficit_ -= fragment->size();
+  if (connection.fragments_.empty()) {
+    // An idle connection doesn't bank deficit
+    ASSERT(active_.front() == handle);
+    active_.pop_front();
+    connection.deficit_ = 0;
+    connection.has_turn_ = false;
+    register_dequeue(handle, &connection);
+  }
+
+  if (select_next_fragment() == connections_.end() && enqueue_registered_) {
+    enqueue_registered_ = false;
+    hci_queue_end_->UnregisterEnqueue();
+  }
+  return fragment;
+}
+
+void WeightedFairScheduler::incoming_acl_credits(uint16_t handle, uint16_t credits) {
+  auto connection = connections_.find(handle);
+  if (connection == connections_.end()) {
+    LOG_INFO("Dropping %hx received credits to unknown connection 0x%0hx", credits, handle);
+    return;
+  }
+  connection->second.number_of_sent_packets_ -= credits;
+  if (connection->second.connection_type_ == ConnectionType::CLASSIC) {
+    acl_packet_credits_ += credits;
+  } else {
+    le_acl_packet_credits_ += credits;
+  }
+  ASSERT(acl_packet_credits_ <= max_acl_packet_credits_);
+  ASSERT(le_acl_packet_credits_ <= le_max_acl_packet_credits_);
+  send_next_fragment();
+}
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <queue>
+
+#include "common/bidi_queue.h"
+#include "hci/acl_manager/acl_scheduler.h"
+#include "hci/controller.h"
+#include "hci/hci_packets.h"
+#include "os/handler.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+// Deficit round robin over the connections with pending fragments. Each turn a connection earns a quantum of
+// its MTU times the weight of its priority, and sends fragments while its deficit covers them, so fragments of
+// different connections interleave on the HCI queue. A connection becoming ready with a higher priority than the
+// one holding the turn takes the next turn, and one controller buffer per higher priority connection of the same
+// transport is kept out of reach of lower priority connections.
+class WeightedFairScheduler : public AclScheduler {
+ public:
+  WeightedFairScheduler(os::Handler* handler, Controller* controller,
+                        common::BidiQueueEnd<AclPacketBuilder, AclPacketView>* hci_queue_end);
+  ~WeightedFairScheduler() override;
+
+  void Register(ConnectionType connection_type, uint16_t handle,
+                std::shared_ptr<acl_manager::AclConnection::Queue> queue) override;
+  void Unregister(uint16_t handle) override;
+  void SetPriority(uint16_t handle, AclPriority priority) override;
+  uint16_t GetCredits() override;
+  uint16_t GetLeCredits() override;
+
+  static size_t GetWeight(AclPriority priority);
+
+ private:
+  struct connection {
+    ConnectionType connection_type_;
+    std::shared_ptr<acl_manager::AclConnection::Queue> queue_;
+    AclPriority priority_ = AclPriority::BULK;
+    bool dequeue_is_registered_ = false;
+    // Fragments of the packet being sent, the next packet is dequeued once they are all sent
+    std::queue<std::unique_ptr<AclPacketBuilder>> fragments_;
+    size_t deficit_ = 0;
+    bool has_turn_ = false;
+    uint16_t number_of_sent_packets_ = 0;  // Track credits
+  };
+
+  void register_dequeue(uint16_t handle, connection* connection);
+  void unregister_dequeue(connection* connection);
+  void buffer_packet(uint16_t handle);
+  void activate(uint16_t handle, connection* connection);
+  bool has_credits(const connection& connection) const;
+  std::map<uint16_t, connection>::iterator select_next_fragment();
+  void send_next_fragment();
+  std::unique_ptr<AclPacketBuilder> handle_enqueue_next_fragment();
+  void incoming_acl_credits(uint16_t handle, uint16_t credits);
+
+  os::Handler* handler_ = nullptr;
+  Controller* controller_ = nullptr;
+  std::map<uint16_t, connection> connections_;
+  // Handles of the connections with fragments to send, the front holds the current turn
+  std::list<uint16_t> active_;
+  uint16_t max_acl_packet_credits_ = 0;
+  uint16_t acl_packet_credits_ = 0;
+  uint16_t le_max_acl_packet_credits_ = 0;
+  uint16_t le_acl_packet_credits_ = 0;
+  size_t hci_mtu_{0};
+  size_t le_hci_mtu_{0};
+  bool enqueue_registered_ = false;
+  common::BidiQueueEnd<AclPacketBuilder, AclPacketView>* hci_queue_end_ = nullptr;
+};
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
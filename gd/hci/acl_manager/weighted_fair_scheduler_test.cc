@@ -0,0 +1,441 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/weighted_fair_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include "common/bidi_queue.h"
+#include "common/callback.h"
+#include "hci/acl_manager.h"
+#include "hci/controller.h"
+#include "hci/hci_packets.h"
+#include "os/handler.h"
+#include "os/log.h"
+#include "packet/raw_builder.h"
+
+using ::bluetooth::common::BidiQueue;
+using ::bluetooth::common::Callback;
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::Thread;
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+class TestController : public Controller {
+ public:
+  uint16_t GetNumAclPacketBuffers() const {
+    return max_acl_packet_credits_;
+  }
+
+  uint16_t GetAclPacketLength() const {
+    return hci_mtu_;
+  }
+
+  LeBufferSize GetLeBufferSize() const {
+    LeBufferSize le_buffer_size;
+    le_buffer_size.le_data_packet_length_ = le_hci_mtu_;
+    le_buffer_size.total_num_le_packets_ = le_max_acl_packet_credits_;
+    return le_buffer_size;
+  }
+
+  void RegisterCompletedAclPacketsCallback(CompletedAclPacketsCallback cb) {
+    acl_credits_callback_ = cb;
+  }
+
+  void SendCompletedAclPacketsCallback(uint16_t handle, uint16_t credits) {
+    acl_credits_callback_.Invoke(handle, credits);
+  }
+
+  void UnregisterCompletedAclPacketsCallback() {
+    acl_credits_callback_ = {};
+  }
+
+  const uint16_t max_acl_packet_credits_ = 10;
+  const uint16_t hci_mtu_ = 1024;
+  const uint16_t le_max_acl_packet_credits_ = 15;
+  const uint16_t le_hci_mtu_ = 27;
+
+ private:
+  CompletedAclPacketsCallback acl_credits_callback_;
+};
+
+class WeightedFairSchedulerTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    thread_ = new Thread("thread", Thread::Priority::NORMAL);
+    handler_ = new Handler(thread_);
+    controller_ = new TestController();
+    scheduler_ = new WeightedFairScheduler(handler_, controller_, hci_queue_.GetUpEnd());
+    hci_queue_.GetDownEnd()->RegisterDequeue(
+        handler_, common::Bind(&WeightedFairSchedulerTest::HciDownEndDequeue, common::Unretained(this)));
+  }
+
+  void TearDown() override {
+    hci_queue_.GetDownEnd()->UnregisterDequeue();
+    delete scheduler_;
+    delete controller_;
+    handler_->Clear();
+    delete handler_;
+    delete thread_;
+  }
+
+  void sync_handler() {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_->BindOnceOn(&promise, &std::promise<void>::set_value).Invoke();
+    auto status = future.wait_for(std::chrono::milliseconds(3));
+    EXPECT_EQ(status, std::future_status::ready);
+  }
+
+  // Run |task| on the handler, for the calls the scheduler only expects from its handler
+  void run_on_handler(common::OnceClosure task) {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_->Post(common::BindOnce(
+        [](common::OnceClosure task, std::promise<void>* promise) {
+          std::move(task).Run();
+          promise->set_value();
+        },
+        std::move(task),
+        common::Unretained(&promise)));
+    future.wait();
+  }
+
+  void EnqueueAclUpEnd(AclConnection::QueueUpEnd* queue_up_end, std::vector<uint8_t> packet) {
+    if (enqueue_promise_ != nullptr) {
+      enqueue_future_->wait();
+    }
+    enqueue_promise_ = std::make_unique<std::promise<void>>();
+    enqueue_future_ = std::make_unique<std::future<void>>(enqueue_promise_->get_future());
+    queue_up_end->RegisterEnqueue(handler_, common::Bind(&WeightedFairSchedulerTest::enqueue_callback,
+                                                         common::Unretained(this), queue_up_end, packet));
+  }
+
+  // Wait for the packets given to EnqueueAclUpEnd to be taken by the scheduler
+  void WaitForEnqueue() {
+    if (enqueue_promise_ != nullptr) {
+      enqueue_future_->wait();
+    }
+    sync_handler();
+  }
+
+  std::unique_ptr<packet::BasePacketBuilder> enqueue_callback(AclConnection::QueueUpEnd* queue_up_end,
+                                                              std::vector<uint8_t> packet) {
+    auto packet_one = std::make_unique<packet::RawBuilder>(2000);
+    packet_one->AddOctets(packet);
+    queue_up_end->UnregisterEnqueue();
+    enqueue_promise_->set_value();
+    return packet_one;
+  };
+
+  void HciDownEndDequeue() {
+    auto packet = hci_queue_.GetDownEnd()->TryDequeue();
+    // Convert from a Builder to a View
+    auto bytes = std::make_shared<std::vector<uint8_t>>();
+    bluetooth::packet::BitInserter i(*bytes);
+    bytes->reserve(packet->size());
+    packet->Serialize(i);
+    auto packet_view = bluetooth::packet::PacketView<bluetooth::packet::kLittleEndian>(bytes);
+    AclPacketView acl_packet_view = AclPacketView::Create(packet_view);
+    ASSERT_TRUE(acl_packet_view.IsValid());
+    sent_acl_packets_.push(acl_packet_view);
+
+    packet_count_--;
+    if (packet_count_ == 0) {
+      // Let the test set the next future as soon as this one is ready
+      auto packet_promise = std::move(packet_promise_);
+      packet_promise->set_value();
+    }
+  }
+
+  void VerifyPacket(uint16_t handle, std::vector<uint8_t> packet) {
+    auto acl_packet_view = sent_acl_packets_.front();
+    ASSERT_EQ(handle, acl_packet_view.GetHandle());
+    auto payload = acl_packet_view.GetPayload();
+    ASSERT_EQ(payload.size(), packet.size());
+    for (size_t i = 0; i < payload.size(); i++) {
+      ASSERT_EQ(payload[i], packet[i]);
+    }
+    sent_acl_packets_.pop();
+  }
+
+  void VerifyHandle(uint16_t handle) {
+    ASSERT_EQ(handle, sent_acl_packets_.front().GetHandle());
+    sent_acl_packets_.pop();
+  }
+
+  void SetPacketFuture(uint16_t count) {
+    ASSERT_LOG(packet_promise_ == nullptr, "Promises, Promises, ... Only one at a time.");
+    packet_count_ = count;
+    packet_promise_ = std::make_unique<std::promise<void>>();
+    packet_future_ = std::make_unique<std::future<void>>(packet_promise_->get_future());
+  }
+
+  // Use every LE buffer with single fragment packets of |handle|, so that the next packets wait for credits
+  void UseAllLeCredits(uint16_t handle, AclConnection::QueueUpEnd* queue_up_end) {
+    SetPacketFuture(controller_->le_max_acl_packet_credits_);
+    for (uint16_t i = 0; i < controller_->le_max_acl_packet_credits_; i++) {
+      EnqueueAclUpEnd(queue_up_end, {0x01, 0x02, 0x03});
+    }
+    packet_future_->wait();
+    for (uint16_t i = 0; i < controller_->le_max_acl_packet_credits_; i++) {
+      VerifyHandle(handle);
+    }
+    ASSERT_EQ(scheduler_->GetLeCredits(), 0);
+  }
+
+  std::vector<uint8_t> LePacket(size_t fragments, uint8_t tag) {
+    return std::vector<uint8_t>(controller_->le_hci_mtu_ * fragments, tag);
+  }
+
+  BidiQueue<AclPacketView, AclPacketBuilder> hci_queue_{3};
+  Thread* thread_;
+  Handler* handler_;
+  TestController* controller_;
+  WeightedFairScheduler* scheduler_;
+  std::queue<AclPacketView> sent_acl_packets_;
+  uint16_t packet_count_;
+  std::unique_ptr<std::promise<void>> packet_promise_;
+  std::unique_ptr<std::future<void>> packet_future_;
+  std::unique_ptr<std::promise<void>> enqueue_promise_;
+  std::unique_ptr<std::future<void>> enqueue_future_;
+};
+
+TEST_F(WeightedFairSchedulerTest, startup_teardown) {}
+
+TEST_F(WeightedFairSchedulerTest, register_unregister_connection) {
+  uint16_t handle = 0x01;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(10);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+  scheduler_->Unregister(handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, buffer_packet) {
+  uint16_t handle = 0x01;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(10);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+
+  SetPacketFuture(2);
+  AclConnection::QueueUpEnd* queue_up_end = connection_queue->GetUpEnd();
+  std::vector<uint8_t> packet1 = {0x01, 0x02, 0x03};
+  std::vector<uint8_t> packet2 = {0x04, 0x05, 0x06};
+  EnqueueAclUpEnd(queue_up_end, packet1);
+  EnqueueAclUpEnd(queue_up_end, packet2);
+
+  packet_future_->wait();
+  VerifyPacket(handle, packet1);
+  VerifyPacket(handle, packet2);
+  ASSERT_EQ(scheduler_->GetCredits(), controller_->max_acl_packet_credits_ - 2);
+
+  scheduler_->Unregister(handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, send_packets_when_credits_come_back) {
+  uint16_t handle = 0x01;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(15);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+
+  SetPacketFuture(10);
+  AclConnection::QueueUpEnd* queue_up_end = connection_queue->GetUpEnd();
+  for (uint8_t i = 0; i < 15; i++) {
+    std::vector<uint8_t> packet = {0x01, 0x02, 0x03, i};
+    EnqueueAclUpEnd(queue_up_end, packet);
+  }
+
+  packet_future_->wait();
+  for (uint8_t i = 0; i < 10; i++) {
+    std::vector<uint8_t> packet = {0x01, 0x02, 0x03, i};
+    VerifyPacket(handle, packet);
+  }
+  ASSERT_EQ(scheduler_->GetCredits(), 0);
+
+  SetPacketFuture(5);
+  controller_->SendCompletedAclPacketsCallback(handle, 10);
+  packet_future_->wait();
+  for (uint8_t i = 10; i < 15; i++) {
+    std::vector<uint8_t> packet = {0x01, 0x02, 0x03, i};
+    VerifyPacket(handle, packet);
+  }
+  sync_handler();
+  ASSERT_EQ(scheduler_->GetCredits(), 5);
+
+  scheduler_->Unregister(handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, received_completed_callback_with_unknown_handle) {
+  controller_->SendCompletedAclPacketsCallback(0x00, 1);
+  sync_handler();
+  EXPECT_EQ(scheduler_->GetCredits(), controller_->max_acl_packet_credits_);
+  EXPECT_EQ(scheduler_->GetLeCredits(), controller_->le_max_acl_packet_credits_);
+}
+
+TEST_F(WeightedFairSchedulerTest, interleave_fragments_of_equal_priority) {
+  uint16_t filler_handle = 0x01;
+  uint16_t handle1 = 0x02;
+  uint16_t handle2 = 0x03;
+  auto filler_queue = std::make_shared<AclConnection::Queue>(20);
+  auto connection_queue1 = std::make_shared<AclConnection::Queue>(10);
+  auto connection_queue2 = std::make_shared<AclConnection::Queue>(10);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::LE, filler_handle, filler_queue);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::LE, handle1, connection_queue1);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::LE, handle2, connection_queue2);
+  UseAllLeCredits(filler_handle, filler_queue->GetUpEnd());
+
+  EnqueueAclUpEnd(connection_queue1->GetUpEnd(), LePacket(3, 0x11));
+  WaitForEnqueue();
+  EnqueueAclUpEnd(connection_queue2->GetUpEnd(), LePacket(3, 0x22));
+  WaitForEnqueue();
+
+  SetPacketFuture(6);
+  controller_->SendCompletedAclPacketsCallback(filler_handle, controller_->le_max_acl_packet_credits_);
+  packet_future_->wait();
+  for (int i = 0; i < 3; i++) {
+    VerifyPacket(handle1, LePacket(1, 0x11));
+    VerifyPacket(handle2, LePacket(1, 0x22));
+  }
+
+  scheduler_->Unregister(filler_handle);
+  scheduler_->Unregister(handle1);
+  scheduler_->Unregister(handle2);
+}
+
+TEST_F(WeightedFairSchedulerTest, higher_priority_takes_next_turn) {
+  uint16_t filler_handle = 0x01;
+  uint16_t bulk_handle = 0x02;
+  uint16_t audio_handle = 0x03;
+  auto filler_queue = std::make_shared<AclConnection::Queue>(20);
+  auto bulk_queue = std::make_shared<AclConnection::Queue>(10);
+  auto audio_queue = std::make_shared<AclConnection::Queue>(10);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::LE, filler_handle, filler_queue);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::LE, bulk_handle, bulk_queue);
+  UseAllLeCredits(filler_handle, filler_queue->GetUpEnd());
+
+  run_on_handler(common::BindOnce(
+      [](WeightedFairScheduler* scheduler, uint16_t handle, std::shared_ptr<AclConnection::Queue> queue) {
+        scheduler->Register(WeightedFairScheduler::ConnectionType::LE, handle, queue);
+        scheduler->SetPriority(handle, AclPriority::AUDIO);
+      },
+      common::Unretained(scheduler_),
+      audio_handle,
+      audio_queue));
+  EnqueueAclUpEnd(bulk_queue->GetUpEnd(), LePacket(5, 0x11));
+  WaitForEnqueue();
+  EnqueueAclUpEnd(audio_queue->GetUpEnd(), LePacket(1, 0x22));
+  WaitForEnqueue();
+
+  SetPacketFuture(6);
+  controller_->SendCompletedAclPacketsCallback(filler_handle, controller_->le_max_acl_packet_credits_);
+  packet_future_->wait();
+  VerifyPacket(audio_handle, LePacket(1, 0x22));
+  for (int i = 0; i < 5; i++) {
+    VerifyPacket(bulk_handle, LePacket(1, 0x11));
+  }
+
+  scheduler_->Unregister(filler_handle);
+  scheduler_->Unregister(bulk_handle);
+  scheduler_->Unregister(audio_handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, share_turns_by_weight) {
+  uint16_t filler_handle = 0x01;
+  uint16_t bulk_handle = 0x02;
+  uint16_t audio_handle = 0x03;
+  auto filler_queue = std::make_shared<AclConnection::Queue>(20);
+  auto bulk_queue = std::make_shared<AclConnection::Queue>(10);
+  auto audio_queue = std::make_shared<AclConnection::Queue>(10);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::LE, filler_handle, filler_queue);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::LE, bulk_handle, bulk_queue);
+  UseAllLeCredits(filler_handle, filler_queue->GetUpEnd());
+
+  run_on_handler(common::BindOnce(
+      [](WeightedFairScheduler* scheduler, uint16_t handle, std::shared_ptr<AclConnection::Queue> queue) {
+        scheduler->Register(WeightedFairScheduler::ConnectionType::LE, handle, queue);
+        scheduler->SetPriority(handle, AclPriority::AUDIO);
+      },
+      common::Unretained(scheduler_),
+      audio_handle,
+      audio_queue));
+  EnqueueAclUpEnd(audio_queue->GetUpEnd(), LePacket(8, 0x22));
+  WaitForEnqueue();
+  EnqueueAclUpEnd(bulk_queue->GetUpEnd(), LePacket(4, 0x11));
+  WaitForEnqueue();
+
+  size_t audio_weight = WeightedFairScheduler::GetWeight(AclPriority::AUDIO);
+  ASSERT_EQ(audio_weight, 4u);
+  SetPacketFuture(12);
+  controller_->SendCompletedAclPacketsCallback(filler_handle, controller_->le_max_acl_packet_credits_);
+  packet_future_->wait();
+  // One bulk fragment per turn against four audio fragments
+  for (int i = 0; i < 4; i++) VerifyHandle(audio_handle);
+  VerifyHandle(bulk_handle);
+  for (int i = 0; i < 4; i++) VerifyHandle(audio_handle);
+  for (int i = 0; i < 3; i++) VerifyHandle(bulk_handle);
+
+  scheduler_->Unregister(filler_handle);
+  scheduler_->Unregister(bulk_handle);
+  scheduler_->Unregister(audio_handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, keep_credit_for_higher_priority) {
+  uint16_t bulk_handle = 0x01;
+  uint16_t audio_handle = 0x02;
+  auto bulk_queue = std::make_shared<AclConnection::Queue>(20);
+  auto audio_queue = std::make_shared<AclConnection::Queue>(10);
+  run_on_handler(common::BindOnce(
+      [](WeightedFairScheduler* scheduler, uint16_t handle, std::shared_ptr<AclConnection::Queue> queue) {
+        scheduler->Register(WeightedFairScheduler::ConnectionType::LE, handle, queue);
+        scheduler->SetPriority(handle, AclPriority::AUDIO);
+      },
+      common::Unretained(scheduler_),
+      audio_handle,
+      audio_queue));
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::LE, bulk_handle, bulk_queue);
+
+  uint16_t usable_credits = controller_->le_max_acl_packet_credits_ - 1;
+  SetPacketFuture(usable_credits);
+  for (uint16_t i = 0; i < controller_->le_max_acl_packet_credits_; i++) {
+    EnqueueAclUpEnd(bulk_queue->GetUpEnd(), {0x01, 0x02, 0x03});
+  }
+  packet_future_->wait();
+  sync_handler();
+  ASSERT_EQ(sent_acl_packets_.size(), usable_credits);
+  ASSERT_EQ(scheduler_->GetLeCredits(), 1);
+  for (uint16_t i = 0; i < usable_credits; i++) {
+    VerifyHandle(bulk_handle);
+  }
+
+  SetPacketFuture(1);
+  EnqueueAclUpEnd(audio_queue->GetUpEnd(), {0x04, 0x05, 0x06});
+  packet_future_->wait();
+  VerifyPacket(audio_handle, {0x04, 0x05, 0x06});
+  sync_handler();
+  ASSERT_EQ(scheduler_->GetLeCredits(), 0);
+
+  // The bulk packet left behind goes out once a buffer beyond the one kept for audio is free
+  SetPacketFuture(1);
+  controller_->SendCompletedAclPacketsCallback(bulk_handle, 2);
+  packet_future_->wait();
+  VerifyHandle(bulk_handle);
+
+  scheduler_->Unregister(bulk_handle);
+  scheduler_->Unregister(audio_handle);
+}
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
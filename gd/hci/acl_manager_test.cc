@@ -568,6 +568,22 @@ TEST_F(AclManagerTest, invoke_registered_callback_connection_complete_fail) {
   fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, std::chrono::milliseconds(20));
 }
 
+TEST_F(AclManagerTest, create_connection_uses_page_scan_hint) {
+  acl_manager_->SetPageScanHint(remote, PageScanRepetitionMode::R2, 0x1234, ClockOffsetValid::VALID);
+  test_hci_layer_->SetCommandFuture();
+  acl_manager_->CreateConnection(remote);
+
+  auto last_command = test_hci_layer_->GetCommandPacket(OpCode::CREATE_CONNECTION);
+  while (!last_command.IsValid()) {
+    last_command = test_hci_layer_->GetCommandPacket(OpCode::CREATE_CONNECTION);
+  }
+  auto command_view = CreateConnectionView::Create(last_command);
+  ASSERT_TRUE(command_view.IsValid());
+  ASSERT_EQ(command_view.GetPageScanRepetitionMode(), PageScanRepetitionMode::R2);
+  ASSERT_EQ(command_view.GetClockOffset(), 0x1234);
+  ASSERT_EQ(command_view.GetClockOffsetValid(), ClockOffsetValid::VALID);
+}
+
 class AclManagerWithLeConnectionTest : public AclManagerTest {
  protected:
   void SetUp() override {
@@ -20,9 +20,6 @@
 
 #include <algorithm>
 #include <cstdint>
-#include <cstdio>
-#include <iomanip>
-#include <sstream>
 
 #include "common/strings.h"
 
@@ -42,15 +39,19 @@ Address::Address(std::initializer_list<uint8_t> l) {
   std::copy(l.begin(), std::min(l.begin() + kLength, l.end()), data());
 }
 
-std::string Address::ToString() const {
-  std::stringstream ss;
+Address::StringBuffer Address::ToStringBuffer() const {
+  StringBuffer buffer;
+  char* out = buffer.data();
   for (auto it = address.rbegin(); it != address.rend(); it++) {
-    ss << std::nouppercase << std::hex << std::setw(2) << std::setfill('0') << +*it;
-    if (std::next(it) != address.rend()) {
-      ss << ':';
-    }
+    out = common::ByteToHexChars(*it, out);
+    *out++ = ':';
   }
-  return ss.str();
+  buffer[kStringLength] = '\0';
+  return buffer;
+}
+
+std::string Address::ToString() const {
+  return std::string(ToStringBuffer().data(), kStringLength);
 }
 
 std::string Address::ToLegacyConfigString() const {
@@ -62,39 +63,19 @@ std::optional<Address> Address::FromLegacyConfigString(const std::string& str) {
 }
 
 std::optional<Address> Address::FromString(const std::string& from) {
-  if (from.length() != 17) {
+  if (from.length() != kStringLength) {
     return std::nullopt;
   }
 
   Address addr{};
-  std::istringstream stream(from);
-  std::string token;
-  int index = 0;
-  while (getline(stream, token, ':')) {
-    if (index >= 6) {
+  const char* in = from.data();
+  for (size_t index = 0; index < kLength; index++, in += 3) {
+    if (index != 0 && in[-1] != ':') {
       return std::nullopt;
     }
-
-    if (token.length() != 2) {
+    if (!common::HexCharsToByte(in, addr.address[kLength - 1 - index])) {
       return std::nullopt;
     }
-
-    char* temp = nullptr;
-    addr.address.at(5 - index) = std::strtol(token.c_str(), &temp, 16);
-    if (temp == token.c_str()) {
-      // string token is empty or has wrong format
-      return std::nullopt;
-    }
-    if (temp != (token.c_str() + token.size())) {
-      // cannot parse whole string
-      return std::nullopt;
-    }
-
-    index++;
-  }
-
-  if (index != 6) {
-    return std::nullopt;
   }
 
   return addr;
@@ -24,6 +24,7 @@
 #include <optional>
 #include <string>
 
+#include "common/numbers.h"
 #include "packet/custom_field_fixed_size_interface.h"
 #include "storage/serializable.h"
 
@@ -33,6 +34,10 @@ namespace hci {
 class Address final : public packet::CustomFieldFixedSizeInterface<Address>, public storage::Serializable<Address> {
  public:
   static constexpr size_t kLength = 6;
+  // Length of the "xx:xx:xx:xx:xx:xx" string form
+  static constexpr size_t kStringLength = 17;
+
+  using StringBuffer = std::array<char, kStringLength + 1>;
 
   std::array<uint8_t, kLength> address = {};
 
@@ -54,6 +59,9 @@ class Address final : public packet::CustomFieldFixedSizeInterface<Address>, pub
   std::string ToLegacyConfigString() const override;
   static std::optional<Address> FromLegacyConfigString(const std::string& str);
 
+  // Same text as ToString(), NUL terminated in a fixed buffer, for logs and keys that do not need a std::string
+  StringBuffer ToStringBuffer() const;
+
   bool operator<(const Address& rhs) const {
     return address < rhs.address;
   }
@@ -107,7 +115,7 @@ struct hash<bluetooth::hci::Address> {
     static_assert(sizeof(uint64_t) >= bluetooth::hci::Address::kLength);
     uint64_t int_addr = 0;
     memcpy(reinterpret_cast<uint8_t*>(&int_addr), val.data(), bluetooth::hci::Address::kLength);
-    return std::hash<uint64_t>{}(int_addr);
+    return bluetooth::common::MixHash(int_addr);
   }
 };
 }  // namespace std
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/address.h"
+#include "hci/uuid.h"
+
+using ::benchmark::State;
+using ::bluetooth::hci::Address;
+using ::bluetooth::hci::Uuid;
+
+namespace {
+
+// Addresses of a single vendor, as found in the config of a user with many accessories of one brand
+std::vector<Address> MakeAddresses(size_t count) {
+  std::vector<Address> addresses;
+  for (size_t i = 0; i < count; i++) {
+    addresses.push_back(Address({static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), 0x00, 0x1a, 0x7d, 0xda}));
+  }
+  return addresses;
+}
+
+std::vector<std::string> MakeAddressStrings(size_t count) {
+  std::vector<std::string> strings;
+  for (const Address& address : MakeAddresses(count)) {
+    strings.push_back(address.ToString());
+  }
+  return strings;
+}
+
+void BM_AddressToString(State& state) {
+  std::vector<Address> addresses = MakeAddresses(64);
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(addresses[index++ % addresses.size()].ToString());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_AddressToStringBuffer(State& state) {
+  std::vector<Address> addresses = MakeAddresses(64);
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(addresses[index++ % addresses.size()].ToStringBuffer());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_AddressFromString(State& state) {
+  std::vector<std::string> strings = MakeAddressStrings(64);
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Address::FromString(strings[index++ % strings.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Lookups in a map of |state.range(0)| addresses of the same vendor
+void BM_AddressUnorderedMapFind(State& state) {
+  std::vector<Address> addresses = MakeAddresses(state.range(0));
+  std::unordered_map<Address, int> map;
+  for (size_t i = 0; i < addresses.size(); i++) {
+    map[addresses[i]] = i;
+  }
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.find(addresses[index++ % addresses.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_UuidToString(State& state) {
+  Uuid uuid = Uuid::FromString("e39c6285-867f-4b1d-9db0-35fbd9aebf22").value();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(uuid.ToString());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_UuidFromString(State& state) {
+  std::vector<std::string> strings = {"110b", "0000110e-0000-1000-8000-00805f9b34fb",
+                                      "e39c6285-867f-4b1d-9db0-35fbd9aebf22"};
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Uuid::FromString(strings[index++ % strings.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_UuidHash(State& state) {
+  Uuid uuid = Uuid::From16Bit(0x110b);
+  std::hash<Uuid> hasher;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hasher(uuid));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_AddressToString);
+BENCHMARK(BM_AddressToStringBuffer);
+BENCHMARK(BM_AddressFromString);
+BENCHMARK(BM_AddressUnorderedMapFind)->Arg(16)->Arg(1024);
+BENCHMARK(BM_UuidToString);
+BENCHMARK(BM_UuidFromString);
+BENCHMARK(BM_UuidHash);
+
+}  // namespace
@@ -233,3 +233,18 @@ TEST(AddressTest, BdAddrHashDifferentForDifferentAddressesZeroAndFullAddr) {
   struct std::hash<Address> hasher;
   ASSERT_NE(hasher(Address::kEmpty), hasher(Address::kAny));
 }
+
+TEST(AddressTest, ToStringBufferSameAsToString) {
+  Address addr{{0x9f, 0x21, 0xd5, 0x4c, 0x01, 0xab}};
+  ASSERT_STREQ("ab:01:4c:d5:21:9f", addr.ToStringBuffer().data());
+  ASSERT_EQ(addr.ToString(), std::string(addr.ToStringBuffer().data()));
+}
+
+TEST(AddressTest, BdAddrHashDifferentForAddressesOfSameVendor) {
+  struct std::hash<Address> hasher;
+  Address addr1{{0x01, 0x00, 0x00, 0x1a, 0x7d, 0xda}};
+  Address addr2{{0x02, 0x00, 0x00, 0x1a, 0x7d, 0xda}};
+  // Both the low and the high bits of the hash differ, not only the bits of the changed octet
+  ASSERT_NE(hasher(addr1) & 0xff, hasher(addr2) & 0xff);
+  ASSERT_NE(hasher(addr1) >> 56, hasher(addr2) >> 56);
+}
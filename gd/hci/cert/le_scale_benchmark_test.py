@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+#
+#   Copyright 2020 - The Android Open Source Project
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+
+import json
+import os
+import time
+from datetime import timedelta
+
+from acts import asserts
+from cert.closable import safeClose
+from cert.event_stream import EventStream
+from cert.gd_base_test import GdBaseTestClass
+from cert.performance_test_logger import PerformanceTestLogger
+from cert.py_le_acl_manager import PyLeAclManager
+from cert.py_rootcanal import PyRootCanal
+from facade import common_pb2 as common
+from google.protobuf import empty_pb2 as empty_proto
+from hci.facade import le_acl_manager_facade_pb2 as le_acl_manager_facade
+from hci.facade import le_initiator_address_facade_pb2 as le_initiator_address_facade
+
+# Threads ticking the simulated devices in root-canal, overridden by the rootcanal_tick_workers user param
+DEFAULT_TICK_WORKERS = 4
+# How many simulated devices each scenario runs with, overridden by the scale_device_counts user param
+DEFAULT_DEVICE_COUNTS = [1, 10, 100, 250]
+SCAN_WINDOW = timedelta(seconds=5)
+BEACON_INTERVAL_MS = 100
+KEYBOARD_INTERVAL_MS = 100
+
+
+def _percentile(values, percent):
+    ordered = sorted(values)
+    return ordered[(len(ordered) - 1) * percent // 100]
+
+
+class LeScaleBenchmarkTest(GdBaseTestClass):
+    """
+    Runs the DUT against growing numbers of devices simulated by root-canal, to find where scanning and
+    connection setup stop scaling. Run it on its own with gd/cert/run --host LeScaleBenchmarkTest; the
+    results are logged and written to le_scale_benchmark.json in the test output directory.
+    """
+
+    def setup_class(self):
+        super().setup_class(dut_module='HCI_INTERFACES', cert_module='HCI_INTERFACES')
+        asserts.skip_if(self.rootcanal_test_port is None, "Simulated devices need root-canal")
+        device_counts = self.user_params.get('scale_device_counts', DEFAULT_DEVICE_COUNTS)
+        self.device_counts = [int(count) for count in device_counts]
+        self.tick_workers = int(self.user_params.get('rootcanal_tick_workers', DEFAULT_TICK_WORKERS))
+        self.results = {}
+
+    def teardown_class(self):
+        if self.results:
+            with open(os.path.join(self.log_path_base, 'le_scale_benchmark.json'), 'w') as results_file:
+                json.dump(self.results, results_file, indent=2)
+        super().teardown_class()
+
+    def setup_test(self):
+        super().setup_test()
+        self.rootcanal = PyRootCanal(self.rootcanal_test_port)
+        self.rootcanal.set_tick_workers(self.tick_workers)
+        self.devices = []
+        self.dut_le_acl_manager = PyLeAclManager(self.dut)
+        self.performance_test_logger = PerformanceTestLogger()
+        private_policy = le_initiator_address_facade.PrivacyPolicy(
+            address_policy=le_initiator_address_facade.AddressPolicy.USE_STATIC_ADDRESS,
+            address_with_type=common.BluetoothAddressWithType(
+                address=common.BluetoothAddress(address=bytes(b'D0:05:04:03:02:01')),
+                type=common.RANDOM_DEVICE_ADDRESS))
+        self.dut.hci_le_initiator_address.SetPrivacyPolicyForInitiatorAddress(private_policy)
+
+    def teardown_test(self):
+        self._remove_devices()
+        safeClose(self.dut_le_acl_manager)
+        safeClose(self.rootcanal)
+        super().teardown_test()
+
+    def _add_devices(self, device_type, address_prefix, count, interval_ms):
+        addresses = []
+        for i in range(count):
+            address = "%s:%02x:%02x" % (address_prefix, i >> 8, i & 0xff)
+            index = self.rootcanal.add_device(device_type, address, interval_ms)
+            self.rootcanal.add_device_to_phy(index, PyRootCanal.LOW_ENERGY_PHY)
+            self.devices.append(index)
+            addresses.append(address)
+        return addresses
+
+    def _remove_devices(self):
+        for index in self.devices:
+            self.rootcanal.remove_device(index)
+        self.devices = []
+
+    def _record(self, scenario, count, result):
+        self.log.info("%s with %d devices: %s" % (scenario, count, result))
+        self.results.setdefault(scenario, {})[str(count)] = result
+
+    def test_scan_report_rate(self):
+        """
+        Count the advertising reports the DUT delivers while every beacon advertises each BEACON_INTERVAL_MS
+        """
+        for count in self.device_counts:
+            self._add_devices('beacon', 'be:ac:00:00', count, BEACON_INTERVAL_MS)
+            reports = []
+            with EventStream(self.dut.hci_le_scanning_manager.StartScan(empty_proto.Empty())) as scan_stream:
+                scan_stream.register_callback(lambda report: reports.append(report),
+                                              lambda report: b'gDevice-beacon' in report.event)
+                time.sleep(SCAN_WINDOW.total_seconds())
+                self.dut.hci_le_scanning_manager.StopScan(empty_proto.Empty())
+            offered_rate = count * 1000 / BEACON_INTERVAL_MS
+            received_rate = len(reports) / SCAN_WINDOW.total_seconds()
+            self._record('scan_reports_per_second', count, {
+                'offered': offered_rate,
+                'received': received_rate,
+            })
+            self._remove_devices()
+
+    def test_connection_setup_time(self):
+        """
+        Connect the DUT to each keyboard in turn, keeping the earlier links up, and time every connection
+        """
+        for count in self.device_counts:
+            addresses = self._add_devices('keyboard', 'cc:1c:00:00', count, KEYBOARD_INTERVAL_MS)
+            connections = []
+            for address in addresses:
+                remote_addr = common.BluetoothAddressWithType(
+                    address=common.BluetoothAddress(address=bytes(address, 'utf8')), type=common.PUBLIC_DEVICE_ADDRESS)
+                self.performance_test_logger.start_interval(str(count))
+                connections.append(self.dut_le_acl_manager.connect_to_remote(remote_addr))
+                self.performance_test_logger.end_interval(str(count))
+            durations_ms = [
+                duration / timedelta(milliseconds=1)
+                for duration in self.performance_test_logger.get_duration_of_intervals(str(count))
+            ]
+            self._record('connection_setup_ms', count, {
+                'p50': _percentile(durations_ms, 50),
+                'p99': _percentile(durations_ms, 99),
+                'max': max(durations_ms),
+            })
+            for connection in connections:
+                self.dut.hci_le_acl_manager.Disconnect(le_acl_manager_facade.LeHandleMsg(handle=connection.handle))
+                connection.wait_for_disconnection_complete()
+            self._remove_devices()
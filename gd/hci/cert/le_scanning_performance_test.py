@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+#
+#   Copyright 2020 - The Android Open Source Project
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+
+import time
+from datetime import timedelta
+
+from acts import asserts
+from cert.closable import safeClose
+from cert.event_stream import EventStream
+from cert.gd_base_test import GdBaseTestClass
+from cert.performance_budget import PerformanceBudget
+from cert.py_rootcanal import PyRootCanal
+from facade import common_pb2 as common
+from google.protobuf import empty_pb2 as empty_proto
+from hci.facade import le_initiator_address_facade_pb2 as le_initiator_address_facade
+
+BEACON_COUNT = 10
+BEACON_INTERVAL_MS = 100
+SCAN_WINDOW = timedelta(seconds=5)
+
+
+class LeScanningPerformanceTest(GdBaseTestClass):
+    """
+    Checks the rate at which the DUT delivers advertising reports against its budget, with beacons simulated by
+    root-canal so that the offered rate is known.
+    """
+
+    def setup_class(self):
+        super().setup_class(dut_module='HCI_INTERFACES', cert_module='HCI_INTERFACES')
+        asserts.skip_if(self.rootcanal_test_port is None, "Simulated beacons need root-canal")
+        self.performance_budget = PerformanceBudget()
+
+    def teardown_class(self):
+        self.performance_budget.write_results(self.log_path_base)
+        super().teardown_class()
+
+    def setup_test(self):
+        super().setup_test()
+        self.rootcanal = PyRootCanal(self.rootcanal_test_port)
+        self.devices = []
+        privacy_policy = le_initiator_address_facade.PrivacyPolicy(
+            address_policy=le_initiator_address_facade.AddressPolicy.USE_STATIC_ADDRESS,
+            address_with_type=common.BluetoothAddressWithType(
+                address=common.BluetoothAddress(address=bytes(b'D0:05:04:03:02:01')),
+                type=common.RANDOM_DEVICE_ADDRESS))
+        self.dut.hci_le_initiator_address.SetPrivacyPolicyForInitiatorAddress(privacy_policy)
+
+    def teardown_test(self):
+        for index in self.devices:
+            self.rootcanal.remove_device(index)
+        safeClose(self.rootcanal)
+        super().teardown_test()
+
+    def test_scan_report_rate(self):
+        for i in range(BEACON_COUNT):
+            index = self.rootcanal.add_device('beacon', "be:ac:00:00:00:%02x" % i, BEACON_INTERVAL_MS)
+            self.rootcanal.add_device_to_phy(index, PyRootCanal.LOW_ENERGY_PHY)
+            self.devices.append(index)
+
+        reports = []
+        with EventStream(self.dut.hci_le_scanning_manager.StartScan(empty_proto.Empty())) as scan_stream:
+            scan_stream.register_callback(lambda report: reports.append(report),
+                                          lambda report: b'gDevice-beacon' in report.event)
+            time.sleep(SCAN_WINDOW.total_seconds())
+            self.dut.hci_le_scanning_manager.StopScan(empty_proto.Empty())
+
+        offered = BEACON_COUNT * SCAN_WINDOW / timedelta(milliseconds=BEACON_INTERVAL_MS)
+        self.log.info("Received %d of %d advertising reports" % (len(reports), offered))
+        self.performance_budget.check("le_scan_reports_received_percent", len(reports) * 100 / offered)
@@ -45,16 +45,19 @@ struct Controller::impl {
                          handler->BindOnceOn(this, &Controller::impl::read_local_name_complete_handler));
     hci_->EnqueueCommand(ReadLocalVersionInformationBuilder::Create(),
                          handler->BindOnceOn(this, &Controller::impl::read_local_version_information_complete_handler));
+    // The supported commands decide which of the reads below are sent, the extended features are read meanwhile
+    std::promise<void> supported_commands_promise;
+    auto supported_commands_future = supported_commands_promise.get_future();
     hci_->EnqueueCommand(ReadLocalSupportedCommandsBuilder::Create(),
-                         handler->BindOnceOn(this, &Controller::impl::read_local_supported_commands_complete_handler));
+                         handler->BindOnceOn(this, &Controller::impl::read_local_supported_commands_complete_handler,
+                                             std::move(supported_commands_promise)));
 
-    // Wait for all extended features read
     std::promise<void> features_promise;
     auto features_future = features_promise.get_future();
     hci_->EnqueueCommand(ReadLocalExtendedFeaturesBuilder::Create(0x00),
                          handler->BindOnceOn(this, &Controller::impl::read_local_extended_features_complete_handler,
                                              std::move(features_promise)));
-    features_future.wait();
+    supported_commands_future.wait();
 
     hci_->EnqueueCommand(ReadBufferSizeBuilder::Create(),
                          handler->BindOnceOn(this, &Controller::impl::read_buffer_size_complete_handler));
@@ -103,13 +106,15 @@ struct Controller::impl {
     hci_->EnqueueCommand(LeGetVendorCapabilitiesBuilder::Create(),
                          handler->BindOnceOn(this, &Controller::impl::le_get_vendor_capabilities_handler));
 
-    // We only need to synchronize the last read. Make BD_ADDR to be the last one.
+    // Besides the extended features, which are read page by page, we only need to synchronize the last read. Make
+    // BD_ADDR to be the last one. With command pipelining, the reads may complete in any order.
     std::promise<void> promise;
     auto future = promise.get_future();
     hci_->EnqueueCommand(
         ReadBdAddrBuilder::Create(),
         handler->BindOnceOn(this, &Controller::impl::read_controller_mac_address_handler, std::move(promise)));
     future.wait();
+    features_future.wait();
   }
 
   void Stop() {
@@ -162,12 +167,13 @@ struct Controller::impl {
     local_version_information_ = complete_view.GetLocalVersionInformation();
   }
 
-  void read_local_supported_commands_complete_handler(CommandCompleteView view) {
+  void read_local_supported_commands_complete_handler(std::promise<void> promise, CommandCompleteView view) {
     auto complete_view = ReadLocalSupportedCommandsCompleteView::Create(view);
     ASSERT(complete_view.IsValid());
     ErrorCode status = complete_view.GetStatus();
     ASSERT_LOG(status == ErrorCode::SUCCESS, "Status 0x%02hhx, %s", status, ErrorCodeText(status).c_str());
     local_supported_commands_ = complete_view.GetSupportedCommands();
+    promise.set_value();
   }
 
   void read_local_extended_features_complete_handler(std::promise<void> promise, CommandCompleteView view) {
@@ -22,6 +22,7 @@
 
 #include "common/bind.h"
 #include "grpc/grpc_event_queue.h"
+#include "grpc/grpc_packet_bytes.h"
 #include "hci/acl_manager.h"
 #include "hci/facade/acl_manager_facade.grpc.pb.h"
 #include "hci/facade/acl_manager_facade.pb.h"
@@ -330,8 +331,8 @@ class AclManagerFacadeService : public AclManagerFacade::Service, public Connect
     ASSERT_LOG(connection_tracker != acl_connections_.end(), "handle %d", handle);
     AclData acl_data;
     acl_data.set_handle(handle);
-    acl_data.set_payload(std::string(packet->begin(), packet->end()));
-    connection_tracker->second.pending_acl_data_.OnIncomingEvent(acl_data);
+    acl_data.set_payload(::bluetooth::grpc::PacketViewToBytes(*packet));
+    connection_tracker->second.pending_acl_data_.OnIncomingEvent(std::move(acl_data));
   }
 
   void OnConnectSuccess(std::unique_ptr<ClassicAclConnection> connection) override {
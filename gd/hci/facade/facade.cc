@@ -20,6 +20,7 @@
 
 #include "common/bind.h"
 #include "grpc/grpc_event_queue.h"
+#include "grpc/grpc_packet_bytes.h"
 #include "hci/controller.h"
 #include "hci/facade/facade.grpc.pb.h"
 #include "hci/hci_layer.h"
@@ -180,7 +181,7 @@ class HciLayerFacadeService : public HciLayerFacade::Service {
     ASSERT(acl_ptr->IsValid());
     LOG_INFO("Got an Acl message for handle 0x%hx", acl_ptr->GetHandle());
     AclMsg incoming;
-    incoming.set_data(std::string(acl_ptr->begin(), acl_ptr->end()));
+    incoming.set_data(::bluetooth::grpc::PacketViewToBytes(*acl_ptr));
     pending_acl_events_.OnIncomingEvent(std::move(incoming));
   }
 
@@ -188,7 +189,7 @@ class HciLayerFacadeService : public HciLayerFacade::Service {
     ASSERT(view.IsValid());
     LOG_INFO("Got an Event %s", EventCodeText(view.GetEventCode()).c_str());
     EventMsg response;
-    response.set_event(std::string(view.begin(), view.end()));
+    response.set_event(::bluetooth::grpc::PacketViewToBytes(view));
     pending_events_.OnIncomingEvent(std::move(response));
   }
 
@@ -196,7 +197,7 @@ class HciLayerFacadeService : public HciLayerFacade::Service {
     ASSERT(view.IsValid());
     LOG_INFO("Got an LE Event %s", SubeventCodeText(view.GetSubeventCode()).c_str());
     LeSubeventMsg response;
-    response.set_event(std::string(view.begin(), view.end()));
+    response.set_event(::bluetooth::grpc::PacketViewToBytes(view));
     pending_le_events_.OnIncomingEvent(std::move(response));
   }
 
@@ -204,7 +205,7 @@ class HciLayerFacadeService : public HciLayerFacade::Service {
     ASSERT(view.IsValid());
     LOG_INFO("Got a Command complete %s", OpCodeText(view.GetCommandOpCode()).c_str());
     EventMsg response;
-    response.set_event(std::string(view.begin(), view.end()));
+    response.set_event(::bluetooth::grpc::PacketViewToBytes(view));
     pending_events_.OnIncomingEvent(std::move(response));
   }
 
@@ -212,7 +213,7 @@ class HciLayerFacadeService : public HciLayerFacade::Service {
     ASSERT(view.IsValid());
     LOG_INFO("Got a Command status %s", OpCodeText(view.GetCommandOpCode()).c_str());
     EventMsg response;
-    response.set_event(std::string(view.begin(), view.end()));
+    response.set_event(::bluetooth::grpc::PacketViewToBytes(view));
     pending_events_.OnIncomingEvent(std::move(response));
   }
 
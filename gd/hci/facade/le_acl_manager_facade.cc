@@ -22,6 +22,7 @@
 
 #include "common/bind.h"
 #include "grpc/grpc_event_queue.h"
+#include "grpc/grpc_packet_bytes.h"
 #include "hci/acl_manager.h"
 #include "hci/facade/le_acl_manager_facade.grpc.pb.h"
 #include "hci/facade/le_acl_manager_facade.pb.h"
@@ -211,8 +212,8 @@ class LeAclManagerFacadeService : public LeAclManagerFacade::Service, public LeC
     ASSERT_LOG(connection_tracker != acl_connections_.end(), "handle %d", handle);
     LeAclData acl_data;
     acl_data.set_handle(handle);
-    acl_data.set_payload(std::string(packet->begin(), packet->end()));
-    connection_tracker->second.pending_acl_data_.OnIncomingEvent(acl_data);
+    acl_data.set_payload(::bluetooth::grpc::PacketViewToBytes(*packet));
+    connection_tracker->second.pending_acl_data_.OnIncomingEvent(std::move(acl_data));
   }
 
   void OnLeConnectSuccess(AddressWithType address_with_type, std::unique_ptr<LeAclConnection> connection) override {
@@ -26,7 +26,7 @@
 #include "hci/facade/le_scanning_manager_facade.grpc.pb.h"
 #include "hci/facade/le_scanning_manager_facade.h"
 #include "hci/facade/le_scanning_manager_facade.pb.h"
-#include "hci/le_report.h"
+#include "hci/le_report_view.h"
 #include "os/log.h"
 #include "packet/raw_builder.h"
 
@@ -65,18 +65,18 @@ class LeScanningManagerFacadeService : public LeScanningManagerFacade::Service,
     return ::grpc::Status::OK;
   }
 
-  void on_advertisements(std::vector<std::shared_ptr<LeReport>> reports) override {
-    for (const auto report : reports) {
-      switch (report->report_type_) {
-        case hci::LeReport::ReportType::ADVERTISING_EVENT: {
+  void on_advertisements(std::vector<LeReportView> reports) override {
+    for (const LeReportView& report : reports) {
+      switch (report.GetReportType()) {
+        case hci::LeReportView::ReportType::ADVERTISING_EVENT: {
           LeReportMsg le_report_msg;
           std::vector<LeAdvertisingReport> advertisements;
           LeAdvertisingReport le_advertising_report;
-          le_advertising_report.address_type_ = report->address_type_;
-          le_advertising_report.address_ = report->address_;
-          le_advertising_report.advertising_data_ = report->gap_data_;
-          le_advertising_report.event_type_ = report->advertising_event_type_;
-          le_advertising_report.rssi_ = report->rssi_;
+          le_advertising_report.address_type_ = report.GetAddressType();
+          le_advertising_report.address_ = report.GetAddress();
+          le_advertising_report.advertising_data_ = report.GetGapData();
+          le_advertising_report.event_type_ = report.GetAdvertisingEventType();
+          le_advertising_report.rssi_ = report.GetRssi();
           advertisements.push_back(le_advertising_report);
 
           auto builder = LeAdvertisingReportBuilder::Create(advertisements);
@@ -86,13 +86,13 @@ class LeScanningManagerFacadeService : public LeScanningManagerFacade::Service,
           le_report_msg.set_event(std::string(bytes.begin(), bytes.end()));
           pending_events_.OnIncomingEvent(std::move(le_report_msg));
         } break;
-        case hci::LeReport::ReportType::EXTENDED_ADVERTISING_EVENT: {
+        case hci::LeReportView::ReportType::EXTENDED_ADVERTISING_EVENT: {
           LeReportMsg le_report_msg;
           std::vector<LeExtendedAdvertisingReport> advertisements;
           LeExtendedAdvertisingReport le_extended_advertising_report;
-          le_extended_advertising_report.address_ = report->address_;
-          le_extended_advertising_report.advertising_data_ = report->gap_data_;
-          le_extended_advertising_report.rssi_ = report->rssi_;
+          le_extended_advertising_report.address_ = report.GetAddress();
+          le_extended_advertising_report.advertising_data_ = report.GetGapData();
+          le_extended_advertising_report.rssi_ = report.GetRssi();
           advertisements.push_back(le_extended_advertising_report);
 
           auto builder = LeExtendedAdvertisingReportBuilder::Create(advertisements);
@@ -102,15 +102,15 @@ class LeScanningManagerFacadeService : public LeScanningManagerFacade::Service,
           le_report_msg.set_event(std::string(bytes.begin(), bytes.end()));
           pending_events_.OnIncomingEvent(std::move(le_report_msg));
         } break;
-        case hci::LeReport::ReportType::DIRECTED_ADVERTISING_EVENT: {
+        case hci::LeReportView::ReportType::DIRECTED_ADVERTISING_EVENT: {
           LeReportMsg le_report_msg;
           std::vector<LeDirectedAdvertisingReport> advertisements;
           LeDirectedAdvertisingReport le_directed_advertising_report;
-          le_directed_advertising_report.address_ = report->address_;
-          le_directed_advertising_report.direct_address_ = ((DirectedLeReport*)report.get())->direct_address_;
+          le_directed_advertising_report.address_ = report.GetAddress();
+          le_directed_advertising_report.direct_address_ = report.GetDirectAddress();
           le_directed_advertising_report.direct_address_type_ = DirectAddressType::RANDOM_DEVICE_ADDRESS;
           le_directed_advertising_report.event_type_ = DirectAdvertisingEventType::ADV_DIRECT_IND;
-          le_directed_advertising_report.rssi_ = report->rssi_;
+          le_directed_advertising_report.rssi_ = report.GetRssi();
           advertisements.push_back(le_directed_advertising_report);
 
           auto builder = LeDirectedAdvertisingReportBuilder::Create(advertisements);
@@ -121,7 +121,7 @@ class LeScanningManagerFacadeService : public LeScanningManagerFacade::Service,
           pending_events_.OnIncomingEvent(std::move(le_report_msg));
         } break;
         default:
-          LOG_INFO("Skipping unknown report type %d", static_cast<int>(report->report_type_));
+          LOG_INFO("Skipping unknown report type %d", static_cast<int>(report.GetReportType()));
       }
     }
   }
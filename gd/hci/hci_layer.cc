@@ -16,10 +16,18 @@
 
 #include "hci/hci_layer.h"
 
+#include <algorithm>
+#include <array>
+#include <string>
+
 #include "common/bind.h"
+#include "common/init_flags.h"
+#include "hci/hci_statistics.h"
+#include "hci_layer_generated.h"
 #include "os/alarm.h"
 #include "os/queue.h"
 #include "packet/packet_builder.h"
+#include "packet/segmenting_inserter.h"
 
 namespace bluetooth {
 namespace hci {
@@ -52,6 +60,16 @@ static void on_hci_timeout(OpCode op_code) {
   ASSERT_LOG(false, "Timed out waiting for 0x%02hx (%s)", op_code, OpCodeText(op_code).c_str());
 }
 
+// Reads don't change the controller state, so their order doesn't matter
+static bool is_read_command(OpCode op_code) {
+  std::string name = OpCodeText(op_code);
+  return name.rfind("READ_", 0) == 0 || name.rfind("LE_READ_", 0) == 0;
+}
+
+static uint16_t opcode_group(OpCode op_code) {
+  return static_cast<uint16_t>(op_code) >> 10;
+}
+
 class CommandQueueEntry {
  public:
   CommandQueueEntry(unique_ptr<CommandPacketBuilder> command_packet,
@@ -63,6 +81,11 @@ class CommandQueueEntry {
       : command(move(command_packet)), waiting_for_status_(true), on_status(move(on_status_function)) {}
 
   unique_ptr<CommandPacketBuilder> command;
+  // Set once the command is serialized, which happens when it gets to the front of the queue
+  std::shared_ptr<std::vector<uint8_t>> bytes_;
+  OpCode op_code_{OpCode::NONE};
+  bool is_read_{false};
+  std::chrono::steady_clock::time_point sent_time_;
   bool waiting_for_status_;
   ContextualOnceCallback<void(CommandStatusView)> on_status;
   ContextualOnceCallback<void(CommandCompleteView)> on_complete;
@@ -84,7 +107,8 @@ class CommandQueueEntry {
 };
 
 struct HciLayer::impl {
-  impl(hal::HciHal* hal, HciLayer& module) : hal_(hal), module_(module) {
+  impl(hal::HciHal* hal, HciLayer& module)
+      : hal_(hal), module_(module), pipelining_enabled_(common::InitFlags::HciCommandPipeliningEnabled()) {
     hci_timeout_alarm_ = new Alarm(module.GetHandler());
   }
 
@@ -92,16 +116,19 @@ struct HciLayer::impl {
     incoming_acl_buffer_.Clear();
     delete hci_timeout_alarm_;
     command_queue_.clear();
+    waiting_commands_.clear();
   }
 
   void drop(EventPacketView) {}
 
   void on_outbound_acl_ready() {
     auto packet = acl_queue_.GetDownEnd()->TryDequeue();
-    std::vector<uint8_t> bytes;
-    BitInserter bi(bytes);
-    packet->Serialize(bi);
-    hal_->sendAclData(bytes);
+    // Only the headers are copied, the payload is handed to the HAL in place and |packet| outlives the send.
+    std::vector<uint8_t> scratch;
+    packet::SegmentingInserter it(scratch);
+    packet->Serialize(it);
+    statistics_.RecordAclOut((scratch[0] | (scratch[1] << 8)) & 0x0fff, packet->size());
+    hal_->sendAclDataSegments(it.GetSegments());
   }
 
   template <typename TResponse>
@@ -130,80 +157,128 @@ struct HciLayer::impl {
     }
     bool is_status = logging_id == "status";
 
-    ASSERT_LOG(!command_queue_.empty(), "Unexpected %s event with OpCode 0x%02hx (%s)", logging_id.c_str(), op_code,
-               OpCodeText(op_code).c_str());
-    ASSERT_LOG(waiting_command_ == op_code, "Waiting for 0x%02hx (%s), got 0x%02hx (%s)", waiting_command_,
-               OpCodeText(waiting_command_).c_str(), op_code, OpCodeText(op_code).c_str());
-    ASSERT_LOG(command_queue_.front().waiting_for_status_ == is_status, "0x%02hx (%s) was not expecting %s event",
-               op_code, OpCodeText(op_code).c_str(), logging_id.c_str());
-
-    command_queue_.front().GetCallback<TResponse>()->Invoke(move(response_view));
-    command_queue_.pop_front();
-    waiting_command_ = OpCode::NONE;
+    std::list<CommandQueueEntry>::iterator waiting =
+        std::find_if(waiting_commands_.begin(), waiting_commands_.end(),
+                     [op_code](const CommandQueueEntry& entry) { return entry.op_code_ == op_code; });
+    ASSERT_LOG(waiting != waiting_commands_.end(), "Unexpected %s event with OpCode 0x%02hx (%s)", logging_id.c_str(),
+               op_code, OpCodeText(op_code).c_str());
+    ASSERT_LOG(waiting->waiting_for_status_ == is_status, "0x%02hx (%s) was not expecting %s event", op_code,
+               OpCodeText(op_code).c_str(), logging_id.c_str());
+
+    statistics_.RecordCommandLatency(static_cast<uint16_t>(op_code),
+                                     std::chrono::steady_clock::now() - waiting->sent_time_);
+    waiting->GetCallback<TResponse>()->Invoke(move(response_view));
+    waiting_commands_.erase(waiting);
     hci_timeout_alarm_->Cancel();
+    if (!waiting_commands_.empty()) {
+      schedule_timeout(waiting_commands_.front().op_code_);
+    }
     send_next_command();
   }
 
-  void send_next_command() {
-    if (command_credits_ == 0) {
-      return;
+  // Without pipelining only one command is outstanding at a time. With it, as many commands as the controller has
+  // credits for are sent back to back, in the order they were queued, as long as the ordering rules allow:
+  // - a Reset is only sent and followed once nothing else is outstanding
+  // - no two commands with the same opcode are outstanding, so that responses match their command
+  // - a command changing the controller state waits for the outstanding ones of its group (OGF) that do too, as
+  //   e.g. LE Set Scan Parameters must complete before LE Set Scan Enable
+  bool can_send(const CommandQueueEntry& command) const {
+    if (waiting_commands_.empty()) {
+      return true;
     }
-    if (waiting_command_ != OpCode::NONE) {
-      return;
+    if (!pipelining_enabled_ || command.op_code_ == OpCode::RESET ||
+        waiting_commands_.back().op_code_ == OpCode::RESET) {
+      return false;
     }
-    if (command_queue_.size() == 0) {
-      return;
+    for (const auto& waiting : waiting_commands_) {
+      if (waiting.op_code_ == command.op_code_) {
+        return false;
+      }
+      if (!command.is_read_ && !waiting.is_read_ && opcode_group(waiting.op_code_) == opcode_group(command.op_code_)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void send_next_command() {
+    while (command_credits_ > 0 && !command_queue_.empty()) {
+      CommandQueueEntry& command = command_queue_.front();
+      if (command.bytes_ == nullptr) {
+        command.bytes_ = std::make_shared<std::vector<uint8_t>>();
+        BitInserter bi(*command.bytes_);
+        command.command->Serialize(bi);
+
+        auto cmd_view = CommandPacketView::Create(PacketView<kLittleEndian>(command.bytes_));
+        ASSERT(cmd_view.IsValid());
+        command.op_code_ = cmd_view.GetOpCode();
+        command.is_read_ = is_read_command(command.op_code_);
+      }
+      if (!can_send(command)) {
+        return;
+      }
+      hal_->sendHciCommand(*command.bytes_);
+      command.sent_time_ = std::chrono::steady_clock::now();
+
+      OpCode op_code = command.op_code_;
+      waiting_commands_.splice(waiting_commands_.end(), command_queue_, command_queue_.begin());
+      if (pipelining_enabled_) {
+        command_credits_--;
+      } else {
+        command_credits_ = 0;  // Only allow one outstanding command
+      }
+      if (waiting_commands_.size() == 1) {
+        schedule_timeout(op_code);
+      }
     }
-    std::shared_ptr<std::vector<uint8_t>> bytes = std::make_shared<std::vector<uint8_t>>();
-    BitInserter bi(*bytes);
-    command_queue_.front().command->Serialize(bi);
-    hal_->sendHciCommand(*bytes);
-
-    auto cmd_view = CommandPacketView::Create(PacketView<kLittleEndian>(bytes));
-    ASSERT(cmd_view.IsValid());
-    OpCode op_code = cmd_view.GetOpCode();
-    waiting_command_ = op_code;
-    command_credits_ = 0;  // Only allow one outstanding command
+  }
+
+  void schedule_timeout(OpCode op_code) {
     hci_timeout_alarm_->Schedule(BindOnce(&on_hci_timeout, op_code), kHciTimeoutMs);
   }
 
   void register_event(EventCode event, ContextualCallback<void(EventPacketView)> handler) {
-    ASSERT_LOG(event_handlers_.count(event) == 0, "Can not register a second handler for %02hhx (%s)", event,
+    auto& entry = event_handlers_[static_cast<uint8_t>(event)];
+    ASSERT_LOG(entry.IsEmpty(), "Can not register a second handler for %02hhx (%s)", event,
                EventCodeText(event).c_str());
-    event_handlers_[event] = handler;
+    entry = handler;
   }
 
   void unregister_event(EventCode event) {
-    event_handlers_.erase(event_handlers_.find(event));
+    event_handlers_[static_cast<uint8_t>(event)] = ContextualCallback<void(EventPacketView)>();
   }
 
   void register_le_event(SubeventCode event, ContextualCallback<void(LeMetaEventView)> handler) {
-    ASSERT_LOG(subevent_handlers_.count(event) == 0, "Can not register a second handler for %02hhx (%s)", event,
+    auto& entry = subevent_handlers_[static_cast<uint8_t>(event)];
+    ASSERT_LOG(entry.IsEmpty(), "Can not register a second handler for %02hhx (%s)", event,
                SubeventCodeText(event).c_str());
-    subevent_handlers_[event] = handler;
+    entry = handler;
   }
 
   void unregister_le_event(SubeventCode event) {
-    subevent_handlers_.erase(subevent_handlers_.find(event));
+    subevent_handlers_[static_cast<uint8_t>(event)] = ContextualCallback<void(LeMetaEventView)>();
   }
 
   void on_hci_event(EventPacketView event) {
     ASSERT(event.IsValid());
     EventCode event_code = event.GetEventCode();
-    if (event_handlers_.find(event_code) == event_handlers_.end()) {
+    statistics_.RecordEvent(static_cast<uint8_t>(event_code));
+    auto& handler = event_handlers_[static_cast<uint8_t>(event_code)];
+    if (handler.IsEmpty()) {
       LOG_DEBUG("Dropping unregistered event of type 0x%02hhx (%s)", event_code, EventCodeText(event_code).c_str());
       return;
     }
-    event_handlers_[event_code].Invoke(event);
+    handler.InvokeFrom(module_.GetHandler(), event);
   }
 
   void on_le_meta_event(EventPacketView event) {
     LeMetaEventView meta_event_view = LeMetaEventView::Create(event);
     ASSERT(meta_event_view.IsValid());
     SubeventCode subevent_code = meta_event_view.GetSubeventCode();
-    ASSERT_LOG(subevent_handlers_.find(subevent_code) != subevent_handlers_.end(),
-               "Unhandled le event of type 0x%02hhx (%s)", subevent_code, SubeventCodeText(subevent_code).c_str());
-    subevent_handlers_[subevent_code].Invoke(meta_event_view);
+    auto& handler = subevent_handlers_[static_cast<uint8_t>(subevent_code)];
+    ASSERT_LOG(!handler.IsEmpty(), "Unhandled le event of type 0x%02hhx (%s)", subevent_code,
+               SubeventCodeText(subevent_code).c_str());
+    handler.InvokeFrom(module_.GetHandler(), meta_event_view);
   }
 
   hal::HciHal* hal_;
@@ -211,12 +286,18 @@ struct HciLayer::impl {
 
   // Command Handling
   std::list<CommandQueueEntry> command_queue_;
-
-  std::map<EventCode, ContextualCallback<void(EventPacketView)>> event_handlers_;
-  std::map<SubeventCode, ContextualCallback<void(LeMetaEventView)>> subevent_handlers_;
-  OpCode waiting_command_{OpCode::NONE};
+  // Commands sent to the controller, in the order they were sent
+  std::list<CommandQueueEntry> waiting_commands_;
+  const bool pipelining_enabled_;
+
+  // Indexed by event and subevent code. Handlers bound to the HCI handler, such as the command responses and the LE
+  // meta event, are called right away rather than through another post.
+  std::array<ContextualCallback<void(EventPacketView)>, 256> event_handlers_;
+  std::array<ContextualCallback<void(LeMetaEventView)>, 256> subevent_handlers_;
   uint8_t command_credits_{1};  // Send reset first
   Alarm* hci_timeout_alarm_{nullptr};
+  // Written on the handler and the HAL thread, read by dumpsys on any thread
+  HciStatistics statistics_;
 
   // Acl packets
   BidiQueue<AclPacketView, AclPacketBuilder> acl_queue_{3 /* TODO: Set queue depth */};
@@ -228,12 +309,15 @@ struct HciLayer::hal_callbacks : public hal::HciHalCallbacks {
   hal_callbacks(HciLayer& module) : module_(module) {}
 
   void hciEventReceived(hal::HciPacket event_bytes) override {
-    auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(event_bytes));
+    auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(event_bytes)));
     EventPacketView event = EventPacketView::Create(packet);
     module_.CallOn(module_.impl_, &impl::on_hci_event, move(event));
   }
 
   void aclDataReceived(hal::HciPacket data_bytes) override {
+    if (data_bytes.size() >= 2) {
+      module_.impl_->statistics_.RecordAclIn((data_bytes[0] | (data_bytes[1] << 8)) & 0x0fff, data_bytes.size());
+    }
     auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(data_bytes)));
     auto acl = std::make_unique<AclPacketView>(AclPacketView::Create(packet));
     module_.impl_->incoming_acl_buffer_.Enqueue(move(acl), module_.GetHandler());
@@ -366,7 +450,6 @@ void HciLayer::Start() {
   RegisterEventHandler(EventCode::DISCONNECTION_COMPLETE, handler->BindOn(this, &HciLayer::on_disconnection_complete));
   // TODO find the right place
   auto drop_packet = handler->BindOn(impl_, &impl::drop);
-  RegisterEventHandler(EventCode::PAGE_SCAN_REPETITION_MODE_CHANGE, drop_packet);
   RegisterEventHandler(EventCode::MAX_SLOTS_CHANGE, drop_packet);
   RegisterEventHandler(EventCode::VENDOR_SPECIFIC, drop_packet);
 
@@ -383,5 +466,47 @@ void HciLayer::Stop() {
   delete impl_;
 }
 
+DumpsysDataFinisher HciLayer::GetDumpsysData(flatbuffers::FlatBufferBuilder* fb_builder) const {
+  ASSERT(fb_builder != nullptr);
+  // The statistics are lock-free, so they can be read right away instead of on the module handler
+  const HciStatistics& statistics = impl_->statistics_;
+
+  std::vector<flatbuffers::Offset<CommandLatencyData>> latency_offsets;
+  for (const auto& latency : statistics.GetCommandLatencies()) {
+    auto buckets = fb_builder->CreateVector(latency.buckets.data(), latency.buckets.size());
+    CommandLatencyDataBuilder builder(*fb_builder);
+    builder.add_op_code(latency.op_code);
+    builder.add_count(latency.count);
+    builder.add_total_us(latency.total_us);
+    builder.add_max_us(latency.max_us);
+    builder.add_buckets(buckets);
+    latency_offsets.push_back(builder.Finish());
+  }
+  auto command_latencies = fb_builder->CreateVector(latency_offsets);
+
+  std::vector<flatbuffers::Offset<EventCountData>> event_offsets;
+  for (const auto& event : statistics.GetEventCounts()) {
+    event_offsets.push_back(CreateEventCountData(*fb_builder, event.event_code, event.count));
+  }
+  auto event_counts = fb_builder->CreateVector(event_offsets);
+
+  std::vector<flatbuffers::Offset<AclBytesData>> acl_offsets;
+  for (const auto& acl : statistics.GetAclBytes()) {
+    acl_offsets.push_back(
+        CreateAclBytesData(*fb_builder, acl.handle, acl.packets_in, acl.bytes_in, acl.packets_out, acl.bytes_out));
+  }
+  auto acl_bytes = fb_builder->CreateVector(acl_offsets);
+
+  auto title = fb_builder->CreateString("----- Hci Layer Dumpsys -----");
+  HciLayerDataBuilder builder(*fb_builder);
+  builder.add_title(title);
+  builder.add_command_latencies(command_latencies);
+  builder.add_event_counts(event_counts);
+  builder.add_acl_bytes(acl_bytes);
+  flatbuffers::Offset<HciLayerData> dumpsys_data = builder.Finish();
+
+  return [dumpsys_data](DumpsysDataBuilder* dumpsys_builder) { dumpsys_builder->add_hci_dumpsys_data(dumpsys_data); };
+}
+
 }  // namespace hci
 }  // namespace bluetooth
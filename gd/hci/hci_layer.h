@@ -96,6 +96,8 @@ class HciLayer : public Module, public CommandInterface<CommandPacketBuilder> {
 
   void Stop() override;
 
+  DumpsysDataFinisher GetDumpsysData(flatbuffers::FlatBufferBuilder* builder) const override;  // Module
+
   virtual void Disconnect(uint16_t handle, ErrorCode reason);
 
  private:
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/bind.h"
+#include "common/init_flags.h"
+#include "hal/hci_hal.h"
+#include "hci/hci_layer.h"
+#include "module.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+using ::bluetooth::TestModuleRegistry;
+using ::bluetooth::common::InitFlags;
+using ::bluetooth::hci::CommandCompleteBuilder;
+using ::bluetooth::hci::CommandCompleteView;
+using ::bluetooth::hci::CommandPacketBuilder;
+using ::bluetooth::hci::HciLayer;
+using ::bluetooth::hci::OpCode;
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::Thread;
+using ::bluetooth::packet::BitInserter;
+using ::bluetooth::packet::RawBuilder;
+
+namespace {
+
+// Round trip of a command over a UART transport to a controller answering right away
+constexpr std::chrono::microseconds kControllerLatency(500);
+
+// Answers every command with a Command Complete after kControllerLatency, granting |credits| commands. Like RootCanal,
+// it works on commands in parallel, so the throughput depends on how many the host keeps in flight.
+class FakeController : public bluetooth::hal::HciHal {
+ public:
+  explicit FakeController(uint8_t credits) : credits_(credits), responder_(&FakeController::respond, this) {}
+
+  ~FakeController() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    cv_.notify_one();
+    responder_.join();
+  }
+
+  void registerIncomingPacketCallback(bluetooth::hal::HciHalCallbacks* callbacks) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_ = callbacks;
+  }
+
+  void unregisterIncomingPacketCallback() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_ = nullptr;
+  }
+
+  void sendHciCommand(bluetooth::hal::HciPacket command) override {
+    auto op_code = static_cast<OpCode>(command[0] | (command[1] << 8));
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back({std::chrono::steady_clock::now() + kControllerLatency, op_code});
+    }
+    cv_.notify_one();
+  }
+
+  void sendAclData(bluetooth::hal::HciPacket data) override {}
+
+  void sendScoData(bluetooth::hal::HciPacket data) override {}
+
+  void Start() override {}
+
+  void Stop() override {}
+
+  void ListDependencies(bluetooth::ModuleList*) override {}
+
+ private:
+  struct Pending {
+    std::chrono::steady_clock::time_point deadline;
+    OpCode op_code;
+  };
+
+  void respond() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopped_) {
+      if (pending_.empty()) {
+        cv_.wait(lock);
+        continue;
+      }
+      Pending next = pending_.front();
+      if (std::chrono::steady_clock::now() < next.deadline) {
+        cv_.wait_until(lock, next.deadline);
+        continue;
+      }
+      pending_.pop_front();
+      // Only the status is returned, which is all the benchmark and the Reset check look at
+      std::vector<uint8_t> bytes;
+      BitInserter inserter(bytes);
+      CommandCompleteBuilder::Create(credits_, next.op_code, std::make_unique<RawBuilder>(std::vector<uint8_t>{0x00}))
+          ->Serialize(inserter);
+      // Only posts to the HCI thread, so it is fine to hold the lock
+      if (callbacks_ != nullptr) {
+        callbacks_->hciEventReceived(bytes);
+      }
+    }
+  }
+
+  const uint8_t credits_;
+  bluetooth::hal::HciHalCallbacks* callbacks_ = nullptr;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Pending> pending_;
+  bool stopped_ = false;
+  std::thread responder_;
+};
+
+// Reads of the controller start up, each a different opcode
+std::vector<std::function<std::unique_ptr<CommandPacketBuilder>()>> StartupReads() {
+  using namespace bluetooth::hci;
+  return {
+      [] { return ReadLocalVersionInformationBuilder::Create(); },
+      [] { return ReadLocalSupportedCommandsBuilder::Create(); },
+      [] { return ReadLocalSupportedFeaturesBuilder::Create(); },
+      [] { return ReadBufferSizeBuilder::Create(); },
+      [] { return ReadBdAddrBuilder::Create(); },
+      [] { return LeReadBufferSizeV1Builder::Create(); },
+      [] { return LeReadLocalSupportedFeaturesBuilder::Create(); },
+      [] { return LeReadSupportedStatesBuilder::Create(); },
+  };
+}
+
+// Sends a batch of start up reads and waits for all of them to complete, with the controller granting
+// |state.range(0)| credits. A single credit is sent without pipelining, as HciLayer does by default.
+void BM_HciCommandThroughput(State& state) {
+  const uint8_t credits = state.range(0);
+  const char* pipelining_flags[] = {"INIT_hci_command_pipelining", nullptr};
+  InitFlags::Load(credits > 1 ? pipelining_flags : nullptr);
+
+  auto* controller = new FakeController(credits);
+  TestModuleRegistry registry;
+  registry.InjectTestModule(&bluetooth::hal::HciHal::Factory, controller);
+  registry.Start<HciLayer>(&registry.GetTestThread());
+  auto* hci = registry.GetModuleUnderTest<HciLayer>();
+  Thread thread("hci_benchmark", Thread::Priority::NORMAL);
+  Handler handler(&thread);
+
+  auto reads = StartupReads();
+  for (auto _ : state) {
+    std::promise<void> done;
+    size_t remaining = reads.size();
+    for (const auto& read : reads) {
+      hci->EnqueueCommand(read(), handler.BindOnce(
+                                      [](size_t* remaining, std::promise<void>* done, CommandCompleteView) {
+                                        if (--*remaining == 0) {
+                                          done->set_value();
+                                        }
+                                      },
+                                      &remaining, &done));
+    }
+    done.get_future().wait();
+  }
+  state.SetItemsProcessed(state.iterations() * reads.size());
+
+  handler.Clear();
+  // Deletes the controller too
+  registry.StopAll();
+  InitFlags::Load(nullptr);
+}
+
+// One command in flight at a time, and the credits commonly granted by controllers and RootCanal
+BENCHMARK(BM_HciCommandThroughput)->Arg(1)->Arg(4)->Arg(8)->UseRealTime();
+
+}  // namespace
@@ -20,6 +20,7 @@
 #include <list>
 #include <memory>
 
+#include "common/init_flags.h"
 #include "hal/hci_hal.h"
 #include "hci/hci_packets.h"
 #include "module.h"
@@ -500,6 +501,149 @@ TEST_F(HciTest, creditsTest) {
           .IsValid());
 }
 
+class HciPipeliningTest : public HciTest {
+ public:
+  void SetUp() override {
+    const char* flags[] = {"INIT_hci_command_pipelining", nullptr};
+    common::InitFlags::Load(flags);
+    HciTest::SetUp();
+  }
+
+  void TearDown() override {
+    HciTest::TearDown();
+    common::InitFlags::Load(nullptr);
+  }
+
+  // Command Complete events are handled after a second post to the HCI handler
+  void SetCredits(uint8_t num_packets) {
+    hal->callbacks->hciEventReceived(GetPacketBytes(NoCommandCompleteBuilder::Create(num_packets)));
+    ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+    ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+  }
+};
+
+TEST_F(HciPipeliningTest, commandsSentUpToCredits) {
+  ASSERT_EQ(0, hal->GetNumSentCommands());
+
+  uint8_t num_packets = 3;
+  SetCredits(num_packets);
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedCommandsBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedFeaturesBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadBdAddrBuilder::Create());
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+
+  // Verify that one command per credit was sent
+  ASSERT_EQ(3, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalVersionInformationView::Create(hal->GetSentCommand()).IsValid());
+  ASSERT_TRUE(ReadLocalSupportedCommandsView::Create(hal->GetSentCommand()).IsValid());
+  ASSERT_TRUE(ReadLocalSupportedFeaturesView::Create(hal->GetSentCommand()).IsValid());
+
+  // Complete the second command first, which frees a credit for the fourth one
+  auto event_future = upper->GetReceivedEventFuture();
+  auto command_future = hal->GetSentCommandFuture();
+  num_packets = 1;
+  ErrorCode error_code = ErrorCode::SUCCESS;
+  std::array<uint8_t, 64> supported_commands{};
+  hal->callbacks->hciEventReceived(
+      GetPacketBytes(ReadLocalSupportedCommandsCompleteBuilder::Create(num_packets, error_code, supported_commands)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(ReadLocalSupportedCommandsCompleteView::Create(
+                  CommandCompleteView::Create(EventPacketView::Create(upper->GetReceivedEvent())))
+                  .IsValid());
+  ASSERT_EQ(command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadBdAddrView::Create(hal->GetSentCommand()).IsValid());
+
+  // The remaining commands complete in any order
+  event_future = upper->GetReceivedEventFuture();
+  hal->callbacks->hciEventReceived(
+      GetPacketBytes(ReadBdAddrCompleteBuilder::Create(num_packets, error_code, Address::kAny)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(
+      ReadBdAddrCompleteView::Create(CommandCompleteView::Create(EventPacketView::Create(upper->GetReceivedEvent())))
+          .IsValid());
+
+  event_future = upper->GetReceivedEventFuture();
+  uint64_t lmp_features = 0x012345678abcdef;
+  hal->callbacks->hciEventReceived(
+      GetPacketBytes(ReadLocalSupportedFeaturesCompleteBuilder::Create(num_packets, error_code, lmp_features)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  upper->GetReceivedEvent();
+
+  event_future = upper->GetReceivedEventFuture();
+  LocalVersionInformation local_version_information;
+  local_version_information.hci_version_ = HciVersion::V_5_0;
+  local_version_information.hci_revision_ = 0x1234;
+  local_version_information.lmp_version_ = LmpVersion::V_4_2;
+  local_version_information.manufacturer_name_ = 0xBAD;
+  local_version_information.lmp_subversion_ = 0x5678;
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      ReadLocalVersionInformationCompleteBuilder::Create(num_packets, error_code, local_version_information)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  upper->GetReceivedEvent();
+  ASSERT_EQ(0, hal->GetNumSentCommands());
+}
+
+TEST_F(HciPipeliningTest, resetNotPipelined) {
+  uint8_t num_packets = 3;
+  SetCredits(num_packets);
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ResetBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadBdAddrBuilder::Create());
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+
+  // Reset waits for the outstanding command
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ReadLocalVersionInformationView::Create(hal->GetSentCommand()).IsValid());
+
+  auto event_future = upper->GetReceivedEventFuture();
+  ErrorCode error_code = ErrorCode::SUCCESS;
+  LocalVersionInformation local_version_information;
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      ReadLocalVersionInformationCompleteBuilder::Create(num_packets, error_code, local_version_information)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  upper->GetReceivedEvent();
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+
+  // Nothing follows the Reset until it completes
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_TRUE(ResetView::Create(hal->GetSentCommand()).IsValid());
+
+  event_future = upper->GetReceivedEventFuture();
+  auto command_future = hal->GetSentCommandFuture();
+  hal->callbacks->hciEventReceived(GetPacketBytes(ResetCompleteBuilder::Create(num_packets, error_code)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  upper->GetReceivedEvent();
+  ASSERT_EQ(command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(ReadBdAddrView::Create(hal->GetSentCommand()).IsValid());
+}
+
+TEST_F(HciPipeliningTest, stateChangesOrderedWithinGroup) {
+  uint8_t num_packets = 3;
+  SetCredits(num_packets);
+  upper->SendHciCommandExpectingComplete(WriteScanEnableBuilder::Create(ScanEnable::INQUIRY_AND_PAGE_SCAN));
+  upper->SendHciCommandExpectingComplete(LeSetScanParametersBuilder::Create(
+      LeScanType::ACTIVE, 0x0060, 0x0030, AddressType::PUBLIC_DEVICE_ADDRESS, LeScanningFilterPolicy::ACCEPT_ALL));
+  upper->SendHciCommandExpectingComplete(LeSetScanEnableBuilder::Create(Enable::ENABLED, Enable::DISABLED));
+  ASSERT_TRUE(fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, kTimeout));
+
+  // Commands of different groups go out together, the scan enable waits for the scan parameters
+  ASSERT_EQ(2, hal->GetNumSentCommands());
+  ASSERT_TRUE(WriteScanEnableView::Create(DiscoveryCommandView::Create(hal->GetSentCommand())).IsValid());
+  ASSERT_TRUE(LeSetScanParametersView::Create(LeScanningCommandView::Create(hal->GetSentCommand())).IsValid());
+
+  auto event_future = upper->GetReceivedEventFuture();
+  auto command_future = hal->GetSentCommandFuture();
+  ErrorCode error_code = ErrorCode::SUCCESS;
+  hal->callbacks->hciEventReceived(
+      GetPacketBytes(LeSetScanParametersCompleteBuilder::Create(num_packets, error_code)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  upper->GetReceivedEvent();
+  ASSERT_EQ(command_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(LeSetScanEnableView::Create(LeScanningCommandView::Create(hal->GetSentCommand())).IsValid());
+}
+
 TEST_F(HciTest, leSecurityInterfaceTest) {
   // Send LeRand to the controller
   auto command_future = hal->GetSentCommandFuture();
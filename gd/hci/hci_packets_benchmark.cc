@@ -0,0 +1,107 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <forward_list>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/hci_packets.h"
+#include "packet/bit_inserter.h"
+
+using ::benchmark::State;
+using ::bluetooth::hci::Address;
+using ::bluetooth::hci::AddressType;
+using ::bluetooth::hci::ClockAccuracy;
+using ::bluetooth::hci::CommandCompleteView;
+using ::bluetooth::hci::ErrorCode;
+using ::bluetooth::hci::EventPacketView;
+using ::bluetooth::hci::LeConnectionCompleteBuilder;
+using ::bluetooth::hci::LeConnectionCompleteView;
+using ::bluetooth::hci::LeMetaEventView;
+using ::bluetooth::hci::ReadRssiCompleteBuilder;
+using ::bluetooth::hci::ReadRssiCompleteView;
+using ::bluetooth::hci::Role;
+using ::bluetooth::packet::BasePacketBuilder;
+using ::bluetooth::packet::BitInserter;
+using ::bluetooth::packet::kLittleEndian;
+using ::bluetooth::packet::PacketView;
+using ::bluetooth::packet::View;
+
+namespace {
+
+// The generated getters of the fields at fixed offsets load them directly from a single fragment, as the events
+// received from the HAL are. Split in two fragments, the same getters gather the bytes through an Iterator from
+// begin(), as they all did before.
+enum Layout { SINGLE_FRAGMENT, TWO_FRAGMENTS };
+
+PacketView<kLittleEndian> MakeEvent(std::unique_ptr<BasePacketBuilder> builder, Layout layout) {
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  BitInserter bit_inserter(*bytes);
+  builder->Serialize(bit_inserter);
+  if (layout == SINGLE_FRAGMENT) {
+    return PacketView<kLittleEndian>(bytes);
+  }
+  return PacketView<kLittleEndian>(std::forward_list<View>{View(bytes, 0, 1), View(bytes, 1, bytes->size())});
+}
+
+// A command complete of a few scalar fields, as polled for each connection
+void BM_HciReadRssiComplete(State& state) {
+  auto event = MakeEvent(ReadRssiCompleteBuilder::Create(1, ErrorCode::SUCCESS, 0x0042, static_cast<uint8_t>(-60)),
+                         static_cast<Layout>(state.range(0)));
+  for (auto _ : state) {
+    auto view = ReadRssiCompleteView::Create(CommandCompleteView::Create(EventPacketView::Create(event)));
+    if (!view.IsValid()) {
+      state.SkipWithError("Invalid event");
+      return;
+    }
+    benchmark::DoNotOptimize(view.GetStatus());
+    benchmark::DoNotOptimize(view.GetConnectionHandle());
+    benchmark::DoNotOptimize(view.GetRssi());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// An LE meta event with most of its fields read, as on each new connection
+void BM_HciLeConnectionComplete(State& state) {
+  auto event = MakeEvent(
+      LeConnectionCompleteBuilder::Create(ErrorCode::SUCCESS, 0x0042, Role::SLAVE, AddressType::RANDOM_DEVICE_ADDRESS,
+                                          Address({0x01, 0x02, 0x03, 0x04, 0x05, 0x06}), 0x0018, 0, 0x01f4,
+                                          ClockAccuracy::PPM_500),
+      static_cast<Layout>(state.range(0)));
+  for (auto _ : state) {
+    auto view = LeConnectionCompleteView::Create(LeMetaEventView::Create(EventPacketView::Create(event)));
+    if (!view.IsValid()) {
+      state.SkipWithError("Invalid event");
+      return;
+    }
+    benchmark::DoNotOptimize(view.GetStatus());
+    benchmark::DoNotOptimize(view.GetConnectionHandle());
+    benchmark::DoNotOptimize(view.GetRole());
+    benchmark::DoNotOptimize(view.GetPeerAddressType());
+    benchmark::DoNotOptimize(view.GetPeerAddress());
+    benchmark::DoNotOptimize(view.GetConnInterval());
+    benchmark::DoNotOptimize(view.GetConnLatency());
+    benchmark::DoNotOptimize(view.GetSupervisionTimeout());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_HciReadRssiComplete)->Arg(SINGLE_FRAGMENT)->Arg(TWO_FRAGMENTS);
+BENCHMARK(BM_HciLeConnectionComplete)->Arg(SINGLE_FRAGMENT)->Arg(TWO_FRAGMENTS);
+
+}  // namespace
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <vector>
+
+namespace bluetooth {
+namespace hci {
+
+// Always-on counters of the HCI traffic: command latency histograms per opcode, events per event code and ACL bytes
+// per connection handle. Recording is lock-free and may happen on any thread, as may reading. Header only, as the
+// legacy HCI layer uses it too.
+class HciStatistics {
+ public:
+  // Bucket 0 counts latencies under 1us, bucket i latencies from 2^(i-1) up to 2^i us, the last one all above
+  static constexpr size_t kLatencyBuckets = 24;
+  // Commands with more distinct opcodes, or connections with more distinct handles, are counted as "other"
+  static constexpr size_t kMaxOpCodes = 64;
+  static constexpr size_t kMaxHandles = 16;
+  static constexpr uint16_t kOtherOpCode = 0xffff;
+  static constexpr uint16_t kOtherHandle = 0xffff;
+
+  struct CommandLatency {
+    uint16_t op_code;
+    uint64_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+    std::array<uint32_t, kLatencyBuckets> buckets;
+  };
+
+  struct EventCount {
+    uint8_t event_code;
+    uint64_t count;
+  };
+
+  struct AclBytes {
+    uint16_t handle;
+    uint64_t packets_in;
+    uint64_t bytes_in;
+    uint64_t packets_out;
+    uint64_t bytes_out;
+  };
+
+  static size_t LatencyBucket(uint64_t latency_us) {
+    size_t bucket = 0;
+    while (latency_us != 0 && bucket < kLatencyBuckets - 1) {
+      latency_us >>= 1;
+      bucket++;
+    }
+    return bucket;
+  }
+
+  void RecordCommandLatency(uint16_t op_code, std::chrono::steady_clock::duration latency) {
+    uint64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    CommandSlot& slot = find_slot(command_slots_, op_code, kOtherOpCode);
+    slot.count.fetch_add(1, std::memory_order_relaxed);
+    slot.total_us.fetch_add(latency_us, std::memory_order_relaxed);
+    slot.buckets[LatencyBucket(latency_us)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max_us = slot.max_us.load(std::memory_order_relaxed);
+    while (latency_us > max_us && !slot.max_us.compare_exchange_weak(max_us, latency_us, std::memory_order_relaxed)) {
+    }
+  }
+
+  void RecordEvent(uint8_t event_code) {
+    event_counts_[event_code].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void RecordAclIn(uint16_t handle, size_t bytes) {
+    AclSlot& slot = find_slot(acl_slots_, handle, kOtherHandle);
+    slot.packets_in.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes_in.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  void RecordAclOut(uint16_t handle, size_t bytes) {
+    AclSlot& slot = find_slot(acl_slots_, handle, kOtherHandle);
+    slot.packets_out.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes_out.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  std::vector<CommandLatency> GetCommandLatencies() const {
+    std::vector<CommandLatency> latencies;
+    for (const auto& slot : command_slots_) {
+      if (slot.count.load(std::memory_order_relaxed) == 0) {
+        continue;
+      }
+      CommandLatency latency{static_cast<uint16_t>(slot.key.load(std::memory_order_relaxed)),
+                             slot.count.load(std::memory_order_relaxed), slot.total_us.load(std::memory_order_relaxed),
+                             slot.max_us.load(std::memory_order_relaxed), {}};
+      for (size_t i = 0; i < kLatencyBuckets; i++) {
+        latency.buckets[i] = slot.buckets[i].load(std::memory_order_relaxed);
+      }
+      latencies.push_back(latency);
+    }
+    return latencies;
+  }
+
+  std::vector<EventCount> GetEventCounts() const {
+    std::vector<EventCount> counts;
+    for (size_t i = 0; i < event_counts_.size(); i++) {
+      uint64_t count = event_counts_[i].load(std::memory_order_relaxed);
+      if (count != 0) {
+        counts.push_back({static_cast<uint8_t>(i), count});
+      }
+    }
+    return counts;
+  }
+
+  std::vector<AclBytes> GetAclBytes() const {
+    std::vector<AclBytes> acl_bytes;
+    for (const auto& slot : acl_slots_) {
+      uint32_t key = slot.key.load(std::memory_order_relaxed);
+      if (key == kEmptyKey) {
+        continue;
+      }
+      acl_bytes.push_back({static_cast<uint16_t>(key), slot.packets_in.load(std::memory_order_relaxed),
+                           slot.bytes_in.load(std::memory_order_relaxed),
+                           slot.packets_out.load(std::memory_order_relaxed),
+                           slot.bytes_out.load(std::memory_order_relaxed)});
+    }
+    return acl_bytes;
+  }
+
+  // Writes the statistics as text, for the legacy dumpsys
+  void Dump(int fd) const {
+    dprintf(fd, "  Command latencies (us): opcode count mean max, then bucket upper bound:count\n");
+    for (const auto& latency : GetCommandLatencies()) {
+      dprintf(fd, "    0x%04x %" PRIu64 " %" PRIu64 " %" PRIu64 "  ", latency.op_code, latency.count,
+              latency.total_us / latency.count, latency.max_us);
+      for (size_t i = 0; i < kLatencyBuckets; i++) {
+        if (latency.buckets[i] == 0) {
+          continue;
+        }
+        if (i == kLatencyBuckets - 1) {
+          dprintf(fd, " inf:%u", latency.buckets[i]);
+        } else {
+          dprintf(fd, " %" PRIu64 ":%u", uint64_t{1} << i, latency.buckets[i]);
+        }
+      }
+      dprintf(fd, "\n");
+    }
+    dprintf(fd, "  Events: event_code count\n");
+    for (const auto& event : GetEventCounts()) {
+      dprintf(fd, "    0x%02x %" PRIu64 "\n", event.event_code, event.count);
+    }
+    dprintf(fd, "  ACL: handle packets_in bytes_in packets_out bytes_out\n");
+    for (const auto& acl : GetAclBytes()) {
+      dprintf(fd, "    0x%04x %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 "\n", acl.handle, acl.packets_in,
+              acl.bytes_in, acl.packets_out, acl.bytes_out);
+    }
+  }
+
+ private:
+  static constexpr uint32_t kEmptyKey = 0x10000;
+
+  struct CommandSlot {
+    std::atomic<uint32_t> key{kEmptyKey};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_us{0};
+    std::atomic<uint64_t> max_us{0};
+    std::array<std::atomic<uint32_t>, kLatencyBuckets> buckets{};
+  };
+
+  struct AclSlot {
+    std::atomic<uint32_t> key{kEmptyKey};
+    std::atomic<uint64_t> packets_in{0};
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> packets_out{0};
+    std::atomic<uint64_t> bytes_out{0};
+  };
+
+  // Finds the slot of |key|, claiming an empty one the first time. The last slot is kept for |other_key|, which takes
+  // all keys once the others are used.
+  template <typename Slot, size_t kSize>
+  static Slot& find_slot(std::array<Slot, kSize>& slots, uint16_t key, uint16_t other_key) {
+    if (key != other_key) {
+      size_t start = key % (kSize - 1);
+      for (size_t i = 0; i < kSize - 1; i++) {
+        Slot& slot = slots[(start + i) % (kSize - 1)];
+        uint32_t current = slot.key.load(std::memory_order_relaxed);
+        if (current == kEmptyKey && slot.key.compare_exchange_strong(current, key, std::memory_order_relaxed)) {
+          return slot;
+        }
+        // Also reached when another thread claimed the slot for the same key first
+        if (current == key) {
+          return slot;
+        }
+      }
+    }
+    Slot& other = slots[kSize - 1];
+    uint32_t empty = kEmptyKey;
+    other.key.compare_exchange_strong(empty, other_key, std::memory_order_relaxed);
+    return other;
+  }
+
+  std::array<CommandSlot, kMaxOpCodes> command_slots_{};
+  std::array<std::atomic<uint64_t>, 256> event_counts_{};
+  std::array<AclSlot, kMaxHandles> acl_slots_{};
+};
+
+}  // namespace hci
+}  // namespace bluetooth
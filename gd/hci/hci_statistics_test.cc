@@ -0,0 +1,140 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/hci_statistics.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+using std::chrono::microseconds;
+
+TEST(HciStatisticsTest, latencyBuckets) {
+  EXPECT_EQ(HciStatistics::LatencyBucket(0), 0u);
+  EXPECT_EQ(HciStatistics::LatencyBucket(1), 1u);
+  EXPECT_EQ(HciStatistics::LatencyBucket(2), 2u);
+  EXPECT_EQ(HciStatistics::LatencyBucket(3), 2u);
+  EXPECT_EQ(HciStatistics::LatencyBucket(4), 3u);
+  EXPECT_EQ(HciStatistics::LatencyBucket(1000), 10u);
+  EXPECT_EQ(HciStatistics::LatencyBucket(UINT64_MAX), HciStatistics::kLatencyBuckets - 1);
+}
+
+TEST(HciStatisticsTest, commandLatencies) {
+  HciStatistics statistics;
+  statistics.RecordCommandLatency(0x0c03, microseconds(100));
+  statistics.RecordCommandLatency(0x0c03, microseconds(300));
+  statistics.RecordCommandLatency(0x1001, microseconds(5000));
+
+  auto latencies = statistics.GetCommandLatencies();
+  ASSERT_EQ(latencies.size(), 2u);
+  for (const auto& latency : latencies) {
+    if (latency.op_code == 0x0c03) {
+      EXPECT_EQ(latency.count, 2u);
+      EXPECT_EQ(latency.total_us, 400u);
+      EXPECT_EQ(latency.max_us, 300u);
+      EXPECT_EQ(latency.buckets[HciStatistics::LatencyBucket(100)], 1u);
+      EXPECT_EQ(latency.buckets[HciStatistics::LatencyBucket(300)], 1u);
+    } else {
+      EXPECT_EQ(latency.op_code, 0x1001);
+      EXPECT_EQ(latency.count, 1u);
+      EXPECT_EQ(latency.max_us, 5000u);
+    }
+  }
+}
+
+TEST(HciStatisticsTest, opCodesBeyondTableCountedAsOther) {
+  HciStatistics statistics;
+  for (uint16_t op_code = 0; op_code < HciStatistics::kMaxOpCodes + 10; op_code++) {
+    statistics.RecordCommandLatency(op_code, microseconds(1));
+  }
+  auto latencies = statistics.GetCommandLatencies();
+  ASSERT_EQ(latencies.size(), HciStatistics::kMaxOpCodes);
+  uint64_t total = 0;
+  uint64_t other = 0;
+  for (const auto& latency : latencies) {
+    total += latency.count;
+    if (latency.op_code == HciStatistics::kOtherOpCode) {
+      other = latency.count;
+    }
+  }
+  EXPECT_EQ(total, HciStatistics::kMaxOpCodes + 10);
+  EXPECT_EQ(other, 11u);
+}
+
+TEST(HciStatisticsTest, eventsAndAcl) {
+  HciStatistics statistics;
+  statistics.RecordEvent(0x0e);
+  statistics.RecordEvent(0x0e);
+  statistics.RecordEvent(0x3e);
+  statistics.RecordAclIn(0x0040, 27);
+  statistics.RecordAclOut(0x0040, 100);
+  statistics.RecordAclOut(0x0040, 50);
+
+  auto events = statistics.GetEventCounts();
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].event_code, 0x0e);
+  EXPECT_EQ(events[0].count, 2u);
+  EXPECT_EQ(events[1].event_code, 0x3e);
+  EXPECT_EQ(events[1].count, 1u);
+
+  auto acl = statistics.GetAclBytes();
+  ASSERT_EQ(acl.size(), 1u);
+  EXPECT_EQ(acl[0].handle, 0x0040);
+  EXPECT_EQ(acl[0].packets_in, 1u);
+  EXPECT_EQ(acl[0].bytes_in, 27u);
+  EXPECT_EQ(acl[0].packets_out, 2u);
+  EXPECT_EQ(acl[0].bytes_out, 150u);
+}
+
+TEST(HciStatisticsTest, concurrentRecording) {
+  HciStatistics statistics;
+  constexpr size_t kThreads = 4;
+  constexpr size_t kRecords = 10000;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; i++) {
+    threads.emplace_back([&statistics] {
+      for (size_t j = 0; j < kRecords; j++) {
+        statistics.RecordCommandLatency(0x0c00 + (j % 8), microseconds(j));
+        statistics.RecordAclOut(j % 4, 10);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Each key has exactly one slot, even when threads race to claim it
+  auto latencies = statistics.GetCommandLatencies();
+  ASSERT_EQ(latencies.size(), 8u);
+  for (const auto& latency : latencies) {
+    EXPECT_EQ(latency.count, kThreads * kRecords / 8);
+  }
+  auto acl = statistics.GetAclBytes();
+  ASSERT_EQ(acl.size(), 4u);
+  for (const auto& handle : acl) {
+    EXPECT_EQ(handle.bytes_out, kThreads * kRecords / 4 * 10);
+  }
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
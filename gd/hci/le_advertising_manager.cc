@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
 #include <memory>
 #include <mutex>
 
@@ -37,12 +38,34 @@ enum class AdvertisingApiType {
   LE_5_0 = 3,
 };
 
+// Largest Advertising_Data or Scan_Response_Data fragment of a single LE Set Extended Advertising Data or Scan
+// Response command
+constexpr size_t kMaxExtendedDataFragmentSize = 251;
+
 struct Advertiser {
   os::Handler* handler;
   common::Callback<void(Address, AddressType)> scan_callback;
   common::Callback<void(ErrorCode, uint8_t, uint8_t)> set_terminated_callback;
+  // Data last sent to the controller, serialized, to skip the updates that don't change it
+  std::vector<uint8_t> advertisement;
+  std::vector<uint8_t> scan_response;
+  FragmentPreference fragment_preference = FragmentPreference::CONTROLLER_SHOULD_NOT;
 };
 
+static std::vector<uint8_t> serialize_gap_data(const std::vector<GapData>& data) {
+  size_t size = 0;
+  for (const auto& gap_data : data) {
+    size += gap_data.size();
+  }
+  std::vector<uint8_t> bytes;
+  bytes.reserve(size);
+  packet::BitInserter it(bytes);
+  for (const auto& gap_data : data) {
+    gap_data.Serialize(it);
+  }
+  return bytes;
+}
+
 ExtendedAdvertisingConfig::ExtendedAdvertisingConfig(const AdvertisingConfig& config) : AdvertisingConfig(config) {
   switch (config.event_type) {
     case AdvertisingType::ADV_IND:
@@ -72,7 +95,6 @@ ExtendedAdvertisingConfig::ExtendedAdvertisingConfig(const AdvertisingConfig& co
   } else if (config.address_type == AddressType::RANDOM_DEVICE_ADDRESS) {
     own_address_type = OwnAddressType::RANDOM_DEVICE_ADDRESS;
   }
-  // TODO(b/149221472): Support fragmentation
   operation = Operation::COMPLETE_ADVERTISEMENT;
 }
 
@@ -175,6 +197,8 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
     advertising_sets_[id].scan_callback = scan_callback;
     advertising_sets_[id].set_terminated_callback = set_terminated_callback;
     advertising_sets_[id].handler = handler;
+    advertising_sets_[id].advertisement = serialize_gap_data(config.advertisement);
+    advertising_sets_[id].scan_response = serialize_gap_data(config.scan_response);
 
     if (!address_manager_registered) {
       le_address_manager_->Register(this);
@@ -267,9 +291,13 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
       return;
     }
 
-    advertising_sets_[id].scan_callback = scan_callback;
-    advertising_sets_[id].set_terminated_callback = set_terminated_callback;
-    advertising_sets_[id].handler = handler;
+    Advertiser& advertiser = advertising_sets_[id];
+    advertiser.scan_callback = scan_callback;
+    advertiser.set_terminated_callback = set_terminated_callback;
+    advertiser.handler = handler;
+    advertiser.advertisement = serialize_gap_data(config.advertisement);
+    advertiser.scan_response = serialize_gap_data(config.scan_response);
+    advertiser.fragment_preference = config.fragment_preference;
 
     if (!address_manager_registered) {
       le_address_manager_->Register(this);
@@ -317,16 +345,10 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
         hci::LeSetExtendedAdvertisingRandomAddressBuilder::Create(
             id, le_address_manager_->GetAnotherAddress().GetAddress()),
         module_handler_->BindOnce(impl::check_status<LeSetExtendedAdvertisingRandomAddressCompleteView>));
-    if (!config.scan_response.empty()) {
-      le_advertising_interface_->EnqueueCommand(
-          hci::LeSetExtendedAdvertisingScanResponseBuilder::Create(id, config.operation, config.fragment_preference,
-                                                                   config.scan_response),
-          module_handler_->BindOnce(impl::check_status<LeSetExtendedAdvertisingScanResponseCompleteView>));
+    if (!advertiser.scan_response.empty()) {
+      send_extended_data(id, true, advertiser.scan_response, advertiser.fragment_preference);
     }
-    le_advertising_interface_->EnqueueCommand(
-        hci::LeSetExtendedAdvertisingDataBuilder::Create(id, config.operation, config.fragment_preference,
-                                                         config.advertisement),
-        module_handler_->BindOnce(impl::check_status<LeSetExtendedAdvertisingDataCompleteView>));
+    send_extended_data(id, false, advertiser.advertisement, advertiser.fragment_preference);
 
     EnabledSet curr_set;
     curr_set.advertising_handle_ = id;
@@ -342,6 +364,88 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
     }
   }
 
+  // Send |data| in fragments of at most kMaxExtendedDataFragmentSize bytes. The commands are all built before the
+  // first one is enqueued, each one from a slice of |data|.
+  void send_extended_data(AdvertiserId id, bool set_scan_rsp, const std::vector<uint8_t>& data,
+                          FragmentPreference fragment_preference) {
+    size_t num_fragments = std::max<size_t>(1, (data.size() + kMaxExtendedDataFragmentSize - 1) /
+                                                   kMaxExtendedDataFragmentSize);
+    std::vector<std::unique_ptr<LeAdvertisingCommandBuilder>> commands;
+    commands.reserve(num_fragments);
+    for (size_t i = 0; i < num_fragments; i++) {
+      Operation operation = Operation::INTERMEDIATE_FRAGMENT;
+      if (num_fragments == 1) {
+        operation = Operation::COMPLETE_ADVERTISEMENT;
+      } else if (i == 0) {
+        operation = Operation::FIRST_FRAGMENT;
+      } else if (i == num_fragments - 1) {
+        operation = Operation::LAST_FRAGMENT;
+      }
+      auto begin = data.begin() + std::min(data.size(), i * kMaxExtendedDataFragmentSize);
+      auto end = data.begin() + std::min(data.size(), (i + 1) * kMaxExtendedDataFragmentSize);
+      std::vector<uint8_t> fragment(begin, end);
+      if (set_scan_rsp) {
+        commands.push_back(LeSetExtendedAdvertisingScanResponseRawBuilder::Create(id, operation, fragment_preference,
+                                                                                  std::move(fragment)));
+      } else {
+        commands.push_back(LeSetExtendedAdvertisingDataRawBuilder::Create(id, operation, fragment_preference,
+                                                                          std::move(fragment)));
+      }
+    }
+    for (auto& command : commands) {
+      if (set_scan_rsp) {
+        le_advertising_interface_->EnqueueCommand(
+            std::move(command),
+            module_handler_->BindOnce(impl::check_status<LeSetExtendedAdvertisingScanResponseCompleteView>));
+      } else {
+        le_advertising_interface_->EnqueueCommand(
+            std::move(command), module_handler_->BindOnce(impl::check_status<LeSetExtendedAdvertisingDataCompleteView>));
+      }
+    }
+  }
+
+  void set_data(AdvertiserId id, bool set_scan_rsp, std::vector<GapData> data) {
+    auto advertiser = advertising_sets_.find(id);
+    if (advertiser == advertising_sets_.end()) {
+      LOG_INFO("Unknown advertising set %u", id);
+      return;
+    }
+    std::vector<uint8_t> bytes = serialize_gap_data(data);
+    std::vector<uint8_t>& sent = set_scan_rsp ? advertiser->second.scan_response : advertiser->second.advertisement;
+    if (bytes == sent) {
+      return;
+    }
+    sent = std::move(bytes);
+
+    switch (advertising_api_type_) {
+      case (AdvertisingApiType::LE_4_0):
+        if (set_scan_rsp) {
+          le_advertising_interface_->EnqueueCommand(
+              hci::LeSetScanResponseDataBuilder::Create(std::move(data)),
+              module_handler_->BindOnce(impl::check_status<LeSetScanResponseDataCompleteView>));
+        } else {
+          le_advertising_interface_->EnqueueCommand(
+              hci::LeSetAdvertisingDataBuilder::Create(std::move(data)),
+              module_handler_->BindOnce(impl::check_status<LeSetAdvertisingDataCompleteView>));
+        }
+        break;
+      case (AdvertisingApiType::ANDROID_HCI):
+        if (set_scan_rsp) {
+          le_advertising_interface_->EnqueueCommand(
+              hci::LeMultiAdvtSetScanRespBuilder::Create(std::move(data), id),
+              module_handler_->BindOnce(impl::check_status<LeMultiAdvtCompleteView>));
+        } else {
+          le_advertising_interface_->EnqueueCommand(
+              hci::LeMultiAdvtSetDataBuilder::Create(std::move(data), id),
+              module_handler_->BindOnce(impl::check_status<LeMultiAdvtCompleteView>));
+        }
+        break;
+      case (AdvertisingApiType::LE_5_0):
+        send_extended_data(id, set_scan_rsp, sent, advertiser->second.fragment_preference);
+        break;
+    }
+  }
+
   void stop_advertising(AdvertiserId advertising_set) {
     if (advertising_sets_.find(advertising_set) == advertising_sets_.end()) {
       LOG_INFO("Unknown advertising set %u", advertising_set);
@@ -565,6 +669,11 @@ AdvertiserId LeAdvertisingManager::ExtendedCreateAdvertiser(
   return id;
 }
 
+void LeAdvertisingManager::SetData(AdvertiserId id, bool set_scan_rsp, std::vector<GapData> data) {
+  GetHandler()->Post(
+      common::BindOnce(&impl::set_data, common::Unretained(pimpl_.get()), id, set_scan_rsp, std::move(data)));
+}
+
 void LeAdvertisingManager::RemoveAdvertiser(AdvertiserId id) {
   GetHandler()->Post(common::BindOnce(&impl::remove_advertiser, common::Unretained(pimpl_.get()), id));
 }
@@ -53,7 +53,7 @@ class ExtendedAdvertisingConfig : public AdvertisingConfig {
   uint8_t sid = 0x00;
   Enable enable_scan_request_notifications = Enable::DISABLED;
   OwnAddressType own_address_type;
-  Operation operation;  // TODO(b/149221472): Support fragmentation
+  Operation operation;  // Unused, the data is fragmented by the LeAdvertisingManager as needed
   FragmentPreference fragment_preference = FragmentPreference::CONTROLLER_SHOULD_NOT;
   ExtendedAdvertisingConfig() = default;
   ExtendedAdvertisingConfig(const AdvertisingConfig& config);
@@ -77,6 +77,10 @@ class LeAdvertisingManager : public bluetooth::Module {
       const ExtendedAdvertisingConfig& config, const common::Callback<void(Address, AddressType)>& scan_callback,
       const common::Callback<void(ErrorCode, uint8_t, uint8_t)>& set_terminated_callback, os::Handler* handler);
 
+  // Update the advertising data, or the scan response data if |set_scan_rsp|. Nothing is sent to the controller if
+  // the data of the set didn't change.
+  void SetData(AdvertiserId id, bool set_scan_rsp, std::vector<GapData> data);
+
   void RemoveAdvertiser(AdvertiserId id);
 
   static const ModuleFactory Factory;
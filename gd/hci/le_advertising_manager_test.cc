@@ -484,6 +484,84 @@ TEST_F(LeExtendedAdvertisingManagerTest, create_advertiser_test) {
   ASSERT_EQ(std::future_status::ready, result);
   test_hci_layer_->IncomingEvent(LeSetExtendedAdvertisingEnableCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
 }
+
+TEST_F(LeExtendedAdvertisingManagerTest, set_data_test) {
+  ExtendedAdvertisingConfig advertising_config{};
+  advertising_config.event_type = AdvertisingType::ADV_NONCONN_IND;
+  advertising_config.address_type = AddressType::PUBLIC_DEVICE_ADDRESS;
+  std::vector<GapData> gap_data{};
+  GapData data_item{};
+  data_item.data_type_ = GapDataType::COMPLETE_LOCAL_NAME;
+  data_item.data_ = {'r', 'a', 'n', 'd', 'o', 'm', ' ', 'd', 'e', 'v', 'i', 'c', 'e'};
+  gap_data.push_back(data_item);
+  advertising_config.advertisement = gap_data;
+  advertising_config.channel_map = 1;
+  advertising_config.sid = 0x01;
+
+  auto last_command_future = test_hci_layer_->GetCommandFuture(OpCode::LE_SET_EXTENDED_ADVERTISING_ENABLE);
+  auto id = le_advertising_manager_->ExtendedCreateAdvertiser(advertising_config, scan_callback,
+                                                              set_terminated_callback, client_handler_);
+  ASSERT_NE(LeAdvertisingManager::kInvalidId, id);
+  std::vector<OpCode> adv_opcodes = {
+      OpCode::LE_SET_EXTENDED_ADVERTISING_PARAMETERS,
+      OpCode::LE_SET_EXTENDED_ADVERTISING_RANDOM_ADDRESS,
+      OpCode::LE_SET_EXTENDED_ADVERTISING_DATA,
+      OpCode::LE_SET_EXTENDED_ADVERTISING_ENABLE,
+  };
+  auto result = last_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  std::vector<uint8_t> success_vector{static_cast<uint8_t>(ErrorCode::SUCCESS)};
+  ASSERT_EQ(std::future_status::ready, result);
+  for (size_t i = 0; i < adv_opcodes.size(); i++) {
+    test_hci_layer_->GetCommandPacket(adv_opcodes[i]);
+    if (adv_opcodes[i] == OpCode::LE_SET_EXTENDED_ADVERTISING_PARAMETERS) {
+      test_hci_layer_->IncomingEvent(LeSetExtendedAdvertisingParametersCompleteBuilder::Create(
+          uint8_t{1}, ErrorCode::SUCCESS, static_cast<uint8_t>(-23)));
+    } else {
+      test_hci_layer_->IncomingEvent(
+          CommandCompleteBuilder::Create(uint8_t{1}, adv_opcodes[i], std::make_unique<RawBuilder>(success_vector)));
+    }
+  }
+
+  // The unchanged data is not sent again, the data too large for a single command is sent in fragments
+  std::vector<GapData> large_data{};
+  for (uint8_t i = 0; i < 3; i++) {
+    data_item.data_type_ = GapDataType::MANUFACTURER_SPECIFIC_DATA;
+    data_item.data_ = std::vector<uint8_t>(200, i);
+    large_data.push_back(data_item);
+  }
+  auto data_command_future = test_hci_layer_->GetCommandFuture(OpCode::LE_SET_EXTENDED_ADVERTISING_DATA);
+  le_advertising_manager_->SetData(id, false, gap_data);
+  le_advertising_manager_->SetData(id, false, large_data);
+  result = data_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  ASSERT_EQ(1u, data_command_future.get());
+  fake_registry_.SynchronizeModuleHandler(&LeAdvertisingManager::Factory, std::chrono::milliseconds(20));
+
+  std::vector<Operation> operations = {
+      Operation::FIRST_FRAGMENT,
+      Operation::INTERMEDIATE_FRAGMENT,
+      Operation::LAST_FRAGMENT,
+  };
+  size_t data_size = 0;
+  for (auto operation : operations) {
+    auto packet_view = test_hci_layer_->GetCommandPacket(OpCode::LE_SET_EXTENDED_ADVERTISING_DATA);
+    auto data_view = LeSetExtendedAdvertisingDataRawView::Create(LeAdvertisingCommandView::Create(packet_view));
+    ASSERT_TRUE(data_view.IsValid());
+    ASSERT_EQ(operation, data_view.GetOperation());
+    data_size += data_view.GetAdvertisingData().size();
+    test_hci_layer_->IncomingEvent(CommandCompleteBuilder::Create(
+        uint8_t{1}, OpCode::LE_SET_EXTENDED_ADVERTISING_DATA, std::make_unique<RawBuilder>(success_vector)));
+  }
+  ASSERT_EQ(3u * 202, data_size);
+
+  // Disable the advertiser
+  last_command_future = test_hci_layer_->GetCommandFuture(OpCode::LE_SET_EXTENDED_ADVERTISING_ENABLE);
+  le_advertising_manager_->RemoveAdvertiser(id);
+  result = last_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  test_hci_layer_->IncomingEvent(LeSetExtendedAdvertisingEnableCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+}
+
 }  // namespace
 }  // namespace hci
 }  // namespace bluetooth
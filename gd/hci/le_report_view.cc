@@ -0,0 +1,219 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "hci/le_report_view.h"
+
+#include <algorithm>
+
+#include "os/log.h"
+
+namespace bluetooth::hci {
+
+namespace {
+// Event code, parameter length and subevent code
+constexpr size_t kLeMetaEventHeaderSize = 3;
+
+// Fixed fields of each report, see the structures of the same name in hci_packets.pdl
+constexpr size_t kAdvertisingReportDataOffset = 9;  // RSSI follows the data
+constexpr size_t kDirectedAdvertisingReportSize = 16;
+constexpr size_t kExtendedAdvertisingReportDataOffset = 24;
+}  // namespace
+
+bool LeReportView::Parse(const LeMetaEventView& event, std::vector<LeReportView>* reports) {
+  ReportType report_type;
+  switch (event.GetSubeventCode()) {
+    case SubeventCode::ADVERTISING_REPORT:
+      report_type = ReportType::ADVERTISING_EVENT;
+      break;
+    case SubeventCode::DIRECTED_ADVERTISING_REPORT:
+      report_type = ReportType::DIRECTED_ADVERTISING_EVENT;
+      break;
+    case SubeventCode::EXTENDED_ADVERTISING_REPORT:
+      report_type = ReportType::EXTENDED_ADVERTISING_EVENT;
+      break;
+    default:
+      return false;
+  }
+
+  if (event.size() <= kLeMetaEventHeaderSize || event.size() > UINT16_MAX) {
+    return false;
+  }
+  auto bytes = std::make_shared<std::vector<uint8_t>>(event.size());
+  event.CopyTo(bytes->data());
+
+  size_t num_reports = (*bytes)[kLeMetaEventHeaderSize];
+  size_t first = reports->size();
+  reports->reserve(first + num_reports);
+  size_t offset = kLeMetaEventHeaderSize + 1;
+  for (size_t i = 0; i < num_reports; i++) {
+    size_t remaining = bytes->size() - offset;
+    size_t data_offset;
+    size_t size;
+    switch (report_type) {
+      case ReportType::ADVERTISING_EVENT:
+        data_offset = kAdvertisingReportDataOffset;
+        size = data_offset + 1;
+        break;
+      case ReportType::DIRECTED_ADVERTISING_EVENT:
+        data_offset = kDirectedAdvertisingReportSize;
+        size = kDirectedAdvertisingReportSize;
+        break;
+      case ReportType::EXTENDED_ADVERTISING_EVENT:
+        data_offset = kExtendedAdvertisingReportDataOffset;
+        size = data_offset;
+        break;
+    }
+    uint8_t data_size = 0;
+    if (report_type != ReportType::DIRECTED_ADVERTISING_EVENT) {
+      if (remaining < data_offset) {
+        break;
+      }
+      data_size = (*bytes)[offset + data_offset - 1];
+      size += data_size;
+    }
+    if (remaining < size) {
+      break;
+    }
+    reports->push_back(LeReportView(bytes, report_type, offset, offset + data_offset, data_size));
+    offset += size;
+  }
+
+  if (reports->size() - first != num_reports) {
+    reports->erase(reports->begin() + first, reports->end());
+    return false;
+  }
+  return true;
+}
+
+Address LeReportView::AddressAt(size_t index) const {
+  Address address;
+  std::copy_n(event_->data() + offset_ + index, Address::kLength, address.address.begin());
+  return address;
+}
+
+AdvertisingEventType LeReportView::GetAdvertisingEventType() const {
+  ASSERT(report_type_ == ReportType::ADVERTISING_EVENT);
+  return static_cast<AdvertisingEventType>(At(0));
+}
+
+Address LeReportView::GetAddress() const {
+  return AddressAt(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT ? 3 : 2);
+}
+
+AddressType LeReportView::GetAddressType() const {
+  return static_cast<AddressType>(At(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT ? 2 : 1));
+}
+
+int8_t LeReportView::GetRssi() const {
+  switch (report_type_) {
+    case ReportType::ADVERTISING_EVENT:
+      return static_cast<int8_t>(At(kAdvertisingReportDataOffset + data_size_));
+    case ReportType::DIRECTED_ADVERTISING_EVENT:
+      return static_cast<int8_t>(At(15));
+    case ReportType::EXTENDED_ADVERTISING_EVENT:
+      return static_cast<int8_t>(At(13));
+  }
+  return 0;
+}
+
+DirectAdvertisingAddressType LeReportView::GetDirectAddressType() const {
+  ASSERT(report_type_ != ReportType::ADVERTISING_EVENT);
+  return static_cast<DirectAdvertisingAddressType>(
+      At(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT ? 16 : 8));
+}
+
+Address LeReportView::GetDirectAddress() const {
+  ASSERT(report_type_ != ReportType::ADVERTISING_EVENT);
+  return AddressAt(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT ? 17 : 9);
+}
+
+bool LeReportView::IsConnectable() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return At(0) & 0x01;
+}
+
+bool LeReportView::IsScannable() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return At(0) & 0x02;
+}
+
+bool LeReportView::IsDirected() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return At(0) & 0x04;
+}
+
+bool LeReportView::IsScanResponse() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return At(0) & 0x08;
+}
+
+DataStatus LeReportView::GetDataStatus() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return static_cast<DataStatus>((At(0) >> 4) & 0x03);
+}
+
+PrimaryPhyType LeReportView::GetPrimaryPhy() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return static_cast<PrimaryPhyType>(At(9));
+}
+
+SecondaryPhyType LeReportView::GetSecondaryPhy() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return static_cast<SecondaryPhyType>(At(10));
+}
+
+uint8_t LeReportView::GetAdvertisingSid() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return At(11) & 0x0f;
+}
+
+int8_t LeReportView::GetTxPower() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return static_cast<int8_t>(At(12));
+}
+
+uint16_t LeReportView::GetPeriodicAdvertisingInterval() const {
+  ASSERT(report_type_ == ReportType::EXTENDED_ADVERTISING_EVENT);
+  return At(14) | (At(15) << 8);
+}
+
+bool LeReportView::FindGapData(GapDataType data_type, GapDataView* gap_data) const {
+  bool found = false;
+  ForEachGapData([&](const GapDataView& view) {
+    if (view.data_type_ != data_type) {
+      return true;
+    }
+    *gap_data = view;
+    found = true;
+    return false;
+  });
+  return found;
+}
+
+std::vector<GapData> LeReportView::GetGapData() const {
+  std::vector<GapData> gap_data;
+  ForEachGapData([&gap_data](const GapDataView& view) {
+    GapData data;
+    data.data_type_ = view.data_type_;
+    data.data_.assign(view.data_, view.data_ + view.size_);
+    gap_data.push_back(std::move(data));
+    return true;
+  });
+  return gap_data;
+}
+
+}  // namespace bluetooth::hci
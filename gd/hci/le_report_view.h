@@ -0,0 +1,125 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "hci/address.h"
+#include "hci/hci_packets.h"
+
+namespace bluetooth::hci {
+
+// One AD structure of an advertising report, pointing into the bytes of the event it was received in
+struct GapDataView {
+  GapDataType data_type_;
+  const uint8_t* data_;
+  uint8_t size_;
+};
+
+// LeReportView is one report of an LE advertising report event. It references the bytes of the event, shared by all
+// the reports of the event, and reads its fields and AD structures on demand, so that no allocation is made per report.
+class LeReportView {
+ public:
+  enum class ReportType {
+    ADVERTISING_EVENT = 1,
+    DIRECTED_ADVERTISING_EVENT = 2,
+    EXTENDED_ADVERTISING_EVENT = 3,
+  };
+
+  // Appends the reports of |event| to |reports|. Returns false, and appends nothing, if |event| is not an advertising
+  // report event or is malformed.
+  static bool Parse(const LeMetaEventView& event, std::vector<LeReportView>* reports);
+
+  ReportType GetReportType() const {
+    return report_type_;
+  }
+
+  // Legacy advertising reports only
+  AdvertisingEventType GetAdvertisingEventType() const;
+
+  Address GetAddress() const;
+  // Directed and extended reports can also carry CONTROLLER_UNABLE_TO_RESOLVE and NO_ADDRESS, see
+  // DirectAdvertisingAddressType
+  AddressType GetAddressType() const;
+  int8_t GetRssi() const;
+
+  // Directed and extended advertising reports only
+  DirectAdvertisingAddressType GetDirectAddressType() const;
+  Address GetDirectAddress() const;
+
+  // Extended advertising reports only
+  bool IsConnectable() const;
+  bool IsScannable() const;
+  bool IsDirected() const;
+  bool IsScanResponse() const;
+  DataStatus GetDataStatus() const;
+  PrimaryPhyType GetPrimaryPhy() const;
+  SecondaryPhyType GetSecondaryPhy() const;
+  uint8_t GetAdvertisingSid() const;
+  int8_t GetTxPower() const;
+  uint16_t GetPeriodicAdvertisingInterval() const;
+
+  // The advertising data, empty for directed advertising reports
+  const uint8_t* GetAdvertisingData() const {
+    return event_->data() + data_offset_;
+  }
+  uint8_t GetAdvertisingDataSize() const {
+    return data_size_;
+  }
+
+  // Calls |callback| with a GapDataView for each AD structure of the advertising data, in order, until it returns
+  // false. A truncated last AD structure is skipped.
+  template <typename Callback>
+  void ForEachGapData(Callback callback) const {
+    const uint8_t* p = GetAdvertisingData();
+    const uint8_t* end = p + data_size_;
+    while (end - p >= 2 && p[0] != 0 && p[0] <= end - p - 1) {
+      GapDataView gap_data{static_cast<GapDataType>(p[1]), p + 2, static_cast<uint8_t>(p[0] - 1)};
+      if (!callback(gap_data)) {
+        return;
+      }
+      p += p[0] + 1;
+    }
+  }
+
+  // Finds the first AD structure of |data_type|, returns false if there is none
+  bool FindGapData(GapDataType data_type, GapDataView* gap_data) const;
+
+  // Copies the AD structures out, as the generated report structures hold them
+  std::vector<GapData> GetGapData() const;
+
+ private:
+  LeReportView(std::shared_ptr<const std::vector<uint8_t>> event, ReportType report_type, uint16_t offset,
+               uint16_t data_offset, uint8_t data_size)
+      : event_(std::move(event)), report_type_(report_type), offset_(offset), data_offset_(data_offset),
+        data_size_(data_size) {}
+
+  uint8_t At(size_t index) const {
+    return (*event_)[offset_ + index];
+  }
+  Address AddressAt(size_t index) const;
+
+  std::shared_ptr<const std::vector<uint8_t>> event_;
+  ReportType report_type_;
+  uint16_t offset_;  // of the report in the event
+  uint16_t data_offset_;
+  uint8_t data_size_;
+};
+
+}  // namespace bluetooth::hci
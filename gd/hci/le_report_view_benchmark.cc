@@ -0,0 +1,129 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/le_report_view.h"
+#include "packet/bit_inserter.h"
+
+using ::benchmark::State;
+using ::bluetooth::hci::AdvertisingEventType;
+using ::bluetooth::hci::EventPacketView;
+using ::bluetooth::hci::GapData;
+using ::bluetooth::hci::GapDataType;
+using ::bluetooth::hci::GapDataView;
+using ::bluetooth::hci::LeAdvertisingReport;
+using ::bluetooth::hci::LeAdvertisingReportBuilder;
+using ::bluetooth::hci::LeAdvertisingReportView;
+using ::bluetooth::hci::LeMetaEventView;
+using ::bluetooth::hci::LeReportView;
+using ::bluetooth::packet::BitInserter;
+using ::bluetooth::packet::kLittleEndian;
+using ::bluetooth::packet::PacketView;
+
+namespace {
+
+GapData MakeGapData(GapDataType data_type, std::vector<uint8_t> data) {
+  GapData gap_data;
+  gap_data.data_type_ = data_type;
+  gap_data.data_ = std::move(data);
+  return gap_data;
+}
+
+// Advertising data of common beacons: an iBeacon, an Eddystone-URL beacon and a named peripheral
+std::vector<std::vector<GapData>> BeaconData() {
+  std::vector<uint8_t> ibeacon{0x4c, 0x00, 0x02, 0x15};
+  ibeacon.resize(25, 0xa5);
+  return {
+      {MakeGapData(GapDataType::FLAGS, {0x06}), MakeGapData(GapDataType::MANUFACTURER_SPECIFIC_DATA, ibeacon)},
+      {MakeGapData(GapDataType::FLAGS, {0x06}), MakeGapData(GapDataType::COMPLETE_LIST_16_BIT_UUIDS, {0xaa, 0xfe}),
+       MakeGapData(GapDataType::SERVICE_DATA_16_BIT_UUIDS,
+                   {0xaa, 0xfe, 0x10, 0xeb, 0x03, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x07})},
+      {MakeGapData(GapDataType::FLAGS, {0x1a}), MakeGapData(GapDataType::TX_POWER_LEVEL, {0x08}),
+       MakeGapData(GapDataType::COMPLETE_LOCAL_NAME, {'h', 'e', 'a', 'r', 't', ' ', 'r', 'a', 't', 'e'})},
+  };
+}
+
+// Advertising report events of |num_reports| reports each, cycling through the beacons
+std::vector<LeMetaEventView> MakeEvents(size_t num_reports) {
+  std::vector<std::vector<GapData>> beacons = BeaconData();
+  std::vector<LeMetaEventView> events;
+  for (size_t i = 0; i < beacons.size(); i++) {
+    std::vector<LeAdvertisingReport> reports;
+    for (size_t j = 0; j < num_reports; j++) {
+      LeAdvertisingReport report;
+      report.event_type_ = AdvertisingEventType::ADV_NONCONN_IND;
+      report.address_ =
+          bluetooth::hci::Address({0x01, 0x02, 0x03, 0x04, static_cast<uint8_t>(i), static_cast<uint8_t>(j)});
+      report.advertising_data_ = beacons[(i + j) % beacons.size()];
+      report.rssi_ = static_cast<uint8_t>(-70);
+      reports.push_back(report);
+    }
+    auto bytes = std::make_shared<std::vector<uint8_t>>();
+    BitInserter bit_inserter(*bytes);
+    LeAdvertisingReportBuilder::Create(reports)->Serialize(bit_inserter);
+    auto event = LeMetaEventView::Create(EventPacketView::Create(PacketView<kLittleEndian>(bytes)));
+    event.IsValid();
+    events.push_back(event);
+  }
+  return events;
+}
+
+// Parses every report the way the generated packet structures do, copying each AD structure out
+void BM_LeReportGenerated(State& state) {
+  std::vector<LeMetaEventView> events = MakeEvents(state.range(0));
+  size_t index = 0;
+  for (auto _ : state) {
+    auto view = LeAdvertisingReportView::Create(events[index++ % events.size()]);
+    view.IsValid();
+    for (const LeAdvertisingReport& report : view.GetAdvertisingReports()) {
+      for (const GapData& gap_data : report.advertising_data_) {
+        benchmark::DoNotOptimize(gap_data.data_type_);
+      }
+      benchmark::DoNotOptimize(report.rssi_);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Parses every report with LeReportView, iterating its AD structures in place
+void BM_LeReportView(State& state) {
+  std::vector<LeMetaEventView> events = MakeEvents(state.range(0));
+  std::vector<LeReportView> reports;
+  size_t index = 0;
+  for (auto _ : state) {
+    reports.clear();
+    LeReportView::Parse(events[index++ % events.size()], &reports);
+    for (const LeReportView& report : reports) {
+      report.ForEachGapData([](const GapDataView& gap_data) {
+        benchmark::DoNotOptimize(gap_data.data_type_);
+        return true;
+      });
+      benchmark::DoNotOptimize(report.GetRssi());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Reports per event: controllers mostly send one, a few batch several
+BENCHMARK(BM_LeReportGenerated)->Arg(1)->Arg(4);
+BENCHMARK(BM_LeReportView)->Arg(1)->Arg(4);
+
+}  // namespace
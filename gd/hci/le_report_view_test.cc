@@ -0,0 +1,193 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "hci/le_report_view.h"
+
+#include <gtest/gtest.h>
+
+#include "packet/bit_inserter.h"
+
+using bluetooth::packet::BitInserter;
+using bluetooth::packet::kLittleEndian;
+using bluetooth::packet::PacketView;
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+LeMetaEventView MakeEvent(std::unique_ptr<LeMetaEventBuilder> builder) {
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  BitInserter i(*bytes);
+  builder->Serialize(i);
+  auto event = LeMetaEventView::Create(EventPacketView::Create(PacketView<kLittleEndian>(bytes)));
+  EXPECT_TRUE(event.IsValid());
+  return event;
+}
+
+std::vector<GapData> MakeGapData() {
+  std::vector<GapData> gap_data;
+  GapData data_item;
+  data_item.data_type_ = GapDataType::FLAGS;
+  data_item.data_ = {0x06};
+  gap_data.push_back(data_item);
+  data_item.data_type_ = GapDataType::COMPLETE_LOCAL_NAME;
+  data_item.data_ = {'d', 'e', 'v', 'i', 'c', 'e'};
+  gap_data.push_back(data_item);
+  return gap_data;
+}
+
+TEST(LeReportViewTest, advertising_reports) {
+  LeAdvertisingReport report1;
+  report1.event_type_ = AdvertisingEventType::ADV_IND;
+  report1.address_type_ = AddressType::RANDOM_DEVICE_ADDRESS;
+  report1.address_ = Address({0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+  report1.advertising_data_ = MakeGapData();
+  report1.rssi_ = static_cast<uint8_t>(-60);
+  LeAdvertisingReport report2;
+  report2.event_type_ = AdvertisingEventType::SCAN_RESPONSE;
+  report2.address_type_ = AddressType::PUBLIC_DEVICE_ADDRESS;
+  report2.address_ = Address({0x11, 0x12, 0x13, 0x14, 0x15, 0x16});
+  report2.rssi_ = static_cast<uint8_t>(-70);
+
+  std::vector<LeReportView> reports;
+  ASSERT_TRUE(LeReportView::Parse(MakeEvent(LeAdvertisingReportBuilder::Create({report1, report2})), &reports));
+  ASSERT_EQ(reports.size(), 2u);
+
+  EXPECT_EQ(reports[0].GetReportType(), LeReportView::ReportType::ADVERTISING_EVENT);
+  EXPECT_EQ(reports[0].GetAdvertisingEventType(), AdvertisingEventType::ADV_IND);
+  EXPECT_EQ(reports[0].GetAddressType(), AddressType::RANDOM_DEVICE_ADDRESS);
+  EXPECT_EQ(reports[0].GetAddress(), report1.address_);
+  EXPECT_EQ(reports[0].GetRssi(), -60);
+  EXPECT_EQ(reports[0].GetAdvertisingDataSize(), 11);
+
+  std::vector<GapData> gap_data = reports[0].GetGapData();
+  ASSERT_EQ(gap_data.size(), 2u);
+  EXPECT_EQ(gap_data[0].data_type_, GapDataType::FLAGS);
+  EXPECT_EQ(gap_data[0].data_, report1.advertising_data_[0].data_);
+  EXPECT_EQ(gap_data[1].data_type_, GapDataType::COMPLETE_LOCAL_NAME);
+  EXPECT_EQ(gap_data[1].data_, report1.advertising_data_[1].data_);
+
+  GapDataView name;
+  ASSERT_TRUE(reports[0].FindGapData(GapDataType::COMPLETE_LOCAL_NAME, &name));
+  EXPECT_EQ(std::string(name.data_, name.data_ + name.size_), "device");
+  EXPECT_FALSE(reports[0].FindGapData(GapDataType::TX_POWER_LEVEL, &name));
+
+  EXPECT_EQ(reports[1].GetAdvertisingEventType(), AdvertisingEventType::SCAN_RESPONSE);
+  EXPECT_EQ(reports[1].GetAddress(), report2.address_);
+  EXPECT_EQ(reports[1].GetRssi(), -70);
+  EXPECT_EQ(reports[1].GetAdvertisingDataSize(), 0);
+  EXPECT_TRUE(reports[1].GetGapData().empty());
+}
+
+TEST(LeReportViewTest, directed_advertising_report) {
+  LeDirectedAdvertisingReport report;
+  report.event_type_ = DirectAdvertisingEventType::ADV_DIRECT_IND;
+  report.address_type_ = DirectAdvertisingAddressType::RANDOM_DEVICE_ADDRESS;
+  report.address_ = Address({0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+  report.direct_address_type_ = DirectAddressType::RANDOM_DEVICE_ADDRESS;
+  report.direct_address_ = Address({0x21, 0x22, 0x23, 0x24, 0x25, 0x26});
+  report.rssi_ = static_cast<uint8_t>(-50);
+
+  std::vector<LeReportView> reports;
+  ASSERT_TRUE(LeReportView::Parse(MakeEvent(LeDirectedAdvertisingReportBuilder::Create({report})), &reports));
+  ASSERT_EQ(reports.size(), 1u);
+  EXPECT_EQ(reports[0].GetReportType(), LeReportView::ReportType::DIRECTED_ADVERTISING_EVENT);
+  EXPECT_EQ(reports[0].GetAddress(), report.address_);
+  EXPECT_EQ(reports[0].GetDirectAddressType(), DirectAdvertisingAddressType::RANDOM_DEVICE_ADDRESS);
+  EXPECT_EQ(reports[0].GetDirectAddress(), report.direct_address_);
+  EXPECT_EQ(reports[0].GetRssi(), -50);
+  EXPECT_EQ(reports[0].GetAdvertisingDataSize(), 0);
+}
+
+TEST(LeReportViewTest, extended_advertising_report) {
+  LeExtendedAdvertisingReport report;
+  report.connectable_ = 1;
+  report.scannable_ = 0;
+  report.directed_ = 0;
+  report.scan_response_ = 1;
+  report.data_status_ = DataStatus::TRUNCATED;
+  report.address_type_ = DirectAdvertisingAddressType::PUBLIC_DEVICE_ADDRESS;
+  report.address_ = Address({0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+  report.primary_phy_ = PrimaryPhyType::LE_CODED;
+  report.secondary_phy_ = SecondaryPhyType::LE_2M;
+  report.advertising_sid_ = 0x0a;
+  report.tx_power_ = static_cast<uint8_t>(-4);
+  report.rssi_ = static_cast<uint8_t>(-80);
+  report.periodic_advertising_interval_ = 0x1234;
+  report.direct_address_type_ = DirectAdvertisingAddressType::NO_ADDRESS;
+  report.advertising_data_ = MakeGapData();
+
+  std::vector<LeReportView> reports;
+  ASSERT_TRUE(LeReportView::Parse(MakeEvent(LeExtendedAdvertisingReportBuilder::Create({report})), &reports));
+  ASSERT_EQ(reports.size(), 1u);
+  const LeReportView& view = reports[0];
+  EXPECT_EQ(view.GetReportType(), LeReportView::ReportType::EXTENDED_ADVERTISING_EVENT);
+  EXPECT_TRUE(view.IsConnectable());
+  EXPECT_FALSE(view.IsScannable());
+  EXPECT_FALSE(view.IsDirected());
+  EXPECT_TRUE(view.IsScanResponse());
+  EXPECT_EQ(view.GetDataStatus(), DataStatus::TRUNCATED);
+  EXPECT_EQ(view.GetAddress(), report.address_);
+  EXPECT_EQ(view.GetPrimaryPhy(), PrimaryPhyType::LE_CODED);
+  EXPECT_EQ(view.GetSecondaryPhy(), SecondaryPhyType::LE_2M);
+  EXPECT_EQ(view.GetAdvertisingSid(), 0x0a);
+  EXPECT_EQ(view.GetTxPower(), -4);
+  EXPECT_EQ(view.GetRssi(), -80);
+  EXPECT_EQ(view.GetPeriodicAdvertisingInterval(), 0x1234);
+  EXPECT_EQ(view.GetDirectAddressType(), DirectAdvertisingAddressType::NO_ADDRESS);
+  EXPECT_EQ(view.GetGapData().size(), 2u);
+}
+
+TEST(LeReportViewTest, reject_truncated_event) {
+  LeAdvertisingReport report;
+  report.advertising_data_ = MakeGapData();
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  BitInserter i(*bytes);
+  LeAdvertisingReportBuilder::Create({report, report})->Serialize(i);
+  bytes->pop_back();
+  (*bytes)[1]--;
+  auto event = LeMetaEventView::Create(EventPacketView::Create(PacketView<kLittleEndian>(bytes)));
+  ASSERT_TRUE(event.IsValid());
+
+  std::vector<LeReportView> reports;
+  EXPECT_FALSE(LeReportView::Parse(event, &reports));
+  EXPECT_TRUE(reports.empty());
+}
+
+TEST(LeReportViewTest, skip_truncated_gap_data) {
+  LeAdvertisingReport report;
+  GapData data_item;
+  data_item.data_type_ = GapDataType::FLAGS;
+  data_item.data_ = {0x06};
+  report.advertising_data_ = {data_item};
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  BitInserter i(*bytes);
+  LeAdvertisingReportBuilder::Create({report})->Serialize(i);
+  // The AD structure claims one more byte than the advertising data holds
+  (*bytes)[13]++;
+  auto event = LeMetaEventView::Create(EventPacketView::Create(PacketView<kLittleEndian>(bytes)));
+  ASSERT_TRUE(event.IsValid());
+
+  std::vector<LeReportView> reports;
+  ASSERT_TRUE(LeReportView::Parse(event, &reports));
+  ASSERT_EQ(reports.size(), 1u);
+  EXPECT_TRUE(reports[0].GetGapData().empty());
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
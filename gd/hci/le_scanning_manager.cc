@@ -71,16 +71,9 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
   void handle_scan_results(LeMetaEventView event) {
     switch (event.GetSubeventCode()) {
       case hci::SubeventCode::ADVERTISING_REPORT:
-        handle_advertising_report<LeAdvertisingReportView, LeAdvertisingReport, LeReport>(
-            LeAdvertisingReportView::Create(event));
-        break;
       case hci::SubeventCode::DIRECTED_ADVERTISING_REPORT:
-        handle_advertising_report<LeDirectedAdvertisingReportView, LeDirectedAdvertisingReport, DirectedLeReport>(
-            LeDirectedAdvertisingReportView::Create(event));
-        break;
       case hci::SubeventCode::EXTENDED_ADVERTISING_REPORT:
-        handle_advertising_report<LeExtendedAdvertisingReportView, LeExtendedAdvertisingReport, ExtendedLeReport>(
-            LeExtendedAdvertisingReportView::Create(event));
+        handle_advertising_report(event);
         break;
       case hci::SubeventCode::SCAN_TIMEOUT:
         if (registered_callback_ != nullptr) {
@@ -94,28 +87,23 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     }
   }
 
-  template <class EventType, class ReportStructType, class ReportType>
-  void handle_advertising_report(EventType event_view) {
+  void handle_advertising_report(LeMetaEventView event) {
     if (registered_callback_ == nullptr) {
       LOG_INFO("Dropping advertising event (no registered handler)");
       return;
     }
-    if (!event_view.IsValid()) {
+    std::vector<LeReportView> reports;
+    if (!LeReportView::Parse(event, &reports)) {
       LOG_INFO("Dropping invalid advertising event");
       return;
     }
-    std::vector<ReportStructType> report_vector = event_view.GetAdvertisingReports();
-    if (report_vector.empty()) {
+    if (reports.empty()) {
       LOG_INFO("Zero results in advertising event");
       return;
     }
-    std::vector<std::shared_ptr<LeReport>> param;
-    param.reserve(report_vector.size());
-    for (const ReportStructType& report : report_vector) {
-      param.push_back(std::shared_ptr<LeReport>(static_cast<LeReport*>(new ReportType(report))));
-    }
     registered_callback_->Handler()->Post(common::BindOnce(&LeScanningManagerCallbacks::on_advertisements,
-                                                           common::Unretained(registered_callback_), param));
+                                                           common::Unretained(registered_callback_),
+                                                           std::move(reports)));
   }
 
   void configure_scan() {
@@ -19,7 +19,7 @@
 
 #include "common/callback.h"
 #include "hci/hci_packets.h"
-#include "hci/le_report.h"
+#include "hci/le_report_view.h"
 #include "module.h"
 
 namespace bluetooth {
@@ -28,7 +28,7 @@ namespace hci {
 class LeScanningManagerCallbacks {
  public:
   virtual ~LeScanningManagerCallbacks() = default;
-  virtual void on_advertisements(std::vector<std::shared_ptr<LeReport>>) = 0;
+  virtual void on_advertisements(std::vector<LeReportView>) = 0;
   virtual void on_timeout() = 0;
   virtual os::Handler* Handler() = 0;
 };
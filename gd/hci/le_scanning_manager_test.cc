@@ -267,7 +267,7 @@ class LeScanningManagerTest : public ::testing::Test {
 
   class MockLeScanningManagerCallbacks : public LeScanningManagerCallbacks {
    public:
-    MOCK_METHOD(void, on_advertisements, (std::vector<std::shared_ptr<LeReport>>), (override));
+    MOCK_METHOD(void, on_advertisements, (std::vector<LeReportView>), (override));
     MOCK_METHOD(void, on_timeout, (), (override));
     os::Handler* Handler() {
       return handler_;
@@ -22,6 +22,8 @@
 
 #include <algorithm>
 
+#include "common/strings.h"
+
 namespace bluetooth {
 namespace hci {
 
@@ -58,64 +60,36 @@ uint32_t Uuid::As32Bit() const {
   return (((uint32_t)uu[0]) << 24) + (((uint32_t)uu[1]) << 16) + (((uint32_t)uu[2]) << 8) + uu[3];
 }
 
-std::optional<Uuid> Uuid::FromString(const std::string& uuid) {
-  if (uuid.empty()) {
-    return std::nullopt;
+namespace {
+// Parse the |count| bytes written as hex decimal pairs at |str| into |out|
+bool ParseHexBytes(const char* str, size_t count, uint8_t* out) {
+  for (size_t i = 0; i < count; i++, str += 2) {
+    if (!common::HexCharsToByte(str, out[i])) {
+      return false;
+    }
   }
+  return true;
+}
+}  // namespace
 
+std::optional<Uuid> Uuid::FromString(const std::string& uuid) {
   Uuid ret = kBase;
   uint8_t* p = ret.uu.data();
+  const char* in = uuid.data();
   if (uuid.size() == kString128BitLen) {
     if (uuid[8] != '-' || uuid[13] != '-' || uuid[18] != '-' || uuid[23] != '-') {
       return std::nullopt;
     }
-
-    int c;
-    int rc = sscanf(
-        uuid.c_str(),
-        "%02hhx%02hhx%02hhx%02hhx-%02hhx%02hhx-%02hhx%02hhx"
-        "-%02hhx%02hhx-%02hhx%02hhx%02hhx%02hhx%02hhx%02hhx%n",
-        &p[0],
-        &p[1],
-        &p[2],
-        &p[3],
-        &p[4],
-        &p[5],
-        &p[6],
-        &p[7],
-        &p[8],
-        &p[9],
-        &p[10],
-        &p[11],
-        &p[12],
-        &p[13],
-        &p[14],
-        &p[15],
-        &c);
-    if (rc != 16) {
-      return std::nullopt;
-    }
-    if (c != kString128BitLen) {
+    if (!ParseHexBytes(in, 4, p) || !ParseHexBytes(in + 9, 2, p + 4) || !ParseHexBytes(in + 14, 2, p + 6) ||
+        !ParseHexBytes(in + 19, 2, p + 8) || !ParseHexBytes(in + 24, 6, p + 10)) {
       return std::nullopt;
     }
-
   } else if (uuid.size() == 8) {
-    int c;
-    int rc = sscanf(uuid.c_str(), "%02hhx%02hhx%02hhx%02hhx%n", &p[0], &p[1], &p[2], &p[3], &c);
-    if (rc != 4) {
-      return std::nullopt;
-    }
-    if (c != 8) {
+    if (!ParseHexBytes(in, 4, p)) {
       return std::nullopt;
     }
-
   } else if (uuid.size() == 4) {
-    int c;
-    int rc = sscanf(uuid.c_str(), "%02hhx%02hhx%n", &p[2], &p[3], &c);
-    if (rc != 2) {
-      return std::nullopt;
-    }
-    if (c != 4) {
+    if (!ParseHexBytes(in, 2, p + 2)) {
       return std::nullopt;
     }
   } else {
@@ -197,29 +171,21 @@ bool Uuid::operator!=(const Uuid& rhs) const {
   return uu != rhs.uu;
 }
 
+Uuid::StringBuffer Uuid::ToStringBuffer() const {
+  StringBuffer buffer;
+  char* out = buffer.data();
+  for (size_t i = 0; i < kNumBytes128; i++) {
+    if (i == 4 || i == 6 || i == 8 || i == 10) {
+      *out++ = '-';
+    }
+    out = common::ByteToHexChars(uu[i], out);
+  }
+  *out = '\0';
+  return buffer;
+}
+
 std::string Uuid::ToString() const {
-  char buf[kString128BitLen + 1] = {};
-  std::snprintf(
-      buf,
-      sizeof(buf),
-      "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-      uu[0],
-      uu[1],
-      uu[2],
-      uu[3],
-      uu[4],
-      uu[5],
-      uu[6],
-      uu[7],
-      uu[8],
-      uu[9],
-      uu[10],
-      uu[11],
-      uu[12],
-      uu[13],
-      uu[14],
-      uu[15]);
-  return std::string(buf);
+  return std::string(ToStringBuffer().data(), kString128BitLen);
 }
 
 std::string Uuid::ToLegacyConfigString() const {
@@ -20,9 +20,11 @@
 
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <optional>
 #include <string>
 
+#include "common/numbers.h"
 #include "storage/serializable.h"
 
 namespace bluetooth {
@@ -46,6 +48,7 @@ class Uuid final : public storage::Serializable<Uuid> {
   static const Uuid kEmpty;  // 00000000-0000-0000-0000-000000000000
 
   using UUID128Bit = std::array<uint8_t, kNumBytes128>;
+  using StringBuffer = std::array<char, kString128BitLen + 1>;
 
   Uuid() = default;
 
@@ -67,6 +70,9 @@ class Uuid final : public storage::Serializable<Uuid> {
   // xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx format, lowercase.
   std::string ToString() const override;
   std::string ToLegacyConfigString() const override;
+  // Same text as ToString(), NUL terminated in a fixed buffer, for logs and
+  // keys that do not need a std::string
+  StringBuffer ToStringBuffer() const;
 
   // Creates and returns a random 128-bit UUID.
   static Uuid GetRandom();
@@ -144,9 +150,10 @@ namespace std {
 template <>
 struct hash<bluetooth::hci::Uuid> {
   std::size_t operator()(const bluetooth::hci::Uuid& key) const {
-    const auto& uuid_bytes = key.To128BitBE();
-    std::hash<std::string> hash_fn;
-    return hash_fn(std::string(reinterpret_cast<const char*>(uuid_bytes.data()), uuid_bytes.size()));
+    uint64_t high, low;
+    memcpy(&high, key.data(), sizeof(high));
+    memcpy(&low, key.data() + sizeof(high), sizeof(low));
+    return bluetooth::common::MixHash(high ^ bluetooth::common::MixHash(low));
   }
 };
 
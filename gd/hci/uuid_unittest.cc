@@ -141,4 +141,22 @@ TEST(UuidTest, test_string_to_uuid_invalid) {
   ASSERT_FALSE(Uuid::FromString("12234567-89ab-cdef-abcd-ef01234567ZZ"));
 }
 
+TEST(UuidTest, ToStringBuffer) {
+  ASSERT_STREQ("00000000-0000-1000-8000-00805f9b34fb", kBase.ToStringBuffer().data());
+  ASSERT_EQ(SEQUENTIAL.ToString(), std::string(SEQUENTIAL.ToStringBuffer().data()));
+}
+
+TEST(UuidTest, test_string_to_uuid_rejects_signs_and_spaces) {
+  ASSERT_FALSE(Uuid::FromString("+1ae"));
+  ASSERT_FALSE(Uuid::FromString(" 1ae"));
+  ASSERT_FALSE(Uuid::FromString("1234 678"));
+  ASSERT_FALSE(Uuid::FromString("e39c6285-867f-4b1d-9db0-35fbd9aebf2 "));
+}
+
+TEST(UuidTest, HashDifferentForDifferentUuids) {
+  std::hash<Uuid> hasher;
+  ASSERT_NE(hasher(Uuid::From16Bit(0x110a)), hasher(Uuid::From16Bit(0x110b)));
+  ASSERT_NE(hasher(kBase), hasher(Uuid::kEmpty));
+}
+
 }  // namespace testing
@@ -18,6 +18,7 @@ from datetime import datetime, timedelta
 from bluetooth_packets_python3 import RawBuilder
 from cert.matchers import L2capMatchers
 from cert.truth import assertThat
+from cert.performance_budget import PerformanceBudget
 from cert.performance_test_logger import PerformanceTestLogger
 from l2cap.classic.cert.cert_l2cap import CertL2cap
 from l2cap.classic.cert.l2cap_test import L2capTestBase
@@ -26,8 +27,20 @@ from bluetooth_packets_python3.l2cap_packets import FcsType
 from bluetooth_packets_python3.l2cap_packets import SupervisoryFunction
 
 
+def _kbps(mtu, packets, duration):
+    return mtu * packets * 8 / 1000 / duration.total_seconds()
+
+
 class L2capPerformanceTest(L2capTestBase):
 
+    def setup_class(self):
+        super().setup_class()
+        self.performance_budget = PerformanceBudget()
+
+    def teardown_class(self):
+        self.performance_budget.write_results(self.log_path_base)
+        super().teardown_class()
+
     def setup_test(self):
         super().setup_test()
         self.performance_test_logger = PerformanceTestLogger()
@@ -89,6 +102,8 @@ class L2capPerformanceTest(L2capTestBase):
         duration = self.performance_test_logger.get_duration_of_intervals("RX")[0]
         self.log.info("Duration: %s" % str(duration))
 
+        return duration
+
     def _ertm_mode_tx(self, mtu, packets, tx_window_size=10):
         """
         Send the specified number of packets and return the time interval in ms.
@@ -146,20 +161,29 @@ class L2capPerformanceTest(L2capTestBase):
         duration = self.performance_test_logger.get_duration_of_intervals("RX")[0]
         self.log.info("Duration: %s" % str(duration))
 
+    def test_acl_connection_time(self):
+        self.performance_test_logger.start_interval("CONNECT")
+        self._setup_link_from_cert()
+        self.performance_test_logger.end_interval("CONNECT")
+
+        duration = self.performance_test_logger.get_duration_of_intervals("CONNECT")[0]
+        self.performance_budget.check("classic_acl_connection_ms", duration / timedelta(milliseconds=1))
+
     def test_basic_mode_tx_672_100(self):
         duration = self._basic_mode_tx(672, 100)
-        assertThat(duration).isWithin(timedelta(seconds=2))
+        self.performance_budget.check("l2cap_basic_tx_672_kbps", _kbps(672, 100, duration))
 
     def test_basic_mode_tx_100_100(self):
         duration = self._basic_mode_tx(100, 100)
-        assertThat(duration).isWithin(timedelta(seconds=2))
+        self.performance_budget.check("l2cap_basic_tx_100_kbps", _kbps(100, 100, duration))
 
     def test_ertm_mode_tx_672_100(self):
         duration = self._ertm_mode_tx(672, 100)
-        assertThat(duration).isWithin(timedelta(seconds=5))
+        self.performance_budget.check("l2cap_ertm_tx_672_kbps", _kbps(672, 100, duration))
 
     def test_basic_mode_rx_672_100(self):
-        self._basic_mode_rx(672, 100)
+        duration = self._basic_mode_rx(672, 100)
+        self.performance_budget.check("l2cap_basic_rx_672_kbps", _kbps(672, 100, duration))
 
     def test_ertm_mode_rx_672_100(self):
         self._ertm_mode_rx(672, 100)
@@ -179,6 +203,7 @@ class L2capPerformanceTest(L2capTestBase):
         duration = self.performance_test_logger.get_duration_of_intervals("RX")
         mean = sum(duration, timedelta()) / len(duration)
         self.log.info("Mean: %s" % str(mean))
+        self.performance_budget.check("l2cap_basic_rx_latency_ms", mean / timedelta(milliseconds=1))
 
     def test_basic_mode_number_of_packets_10_seconds_672(self):
         number_packets = self._basic_mode_tx_fixed_interval(672)
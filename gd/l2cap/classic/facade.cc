@@ -21,6 +21,7 @@
 #include "common/bidi_queue.h"
 #include "common/bind.h"
 #include "grpc/grpc_event_queue.h"
+#include "grpc/grpc_packet_bytes.h"
 #include "hci/address.h"
 #include "l2cap/classic/facade.grpc.pb.h"
 #include "l2cap/classic/facade.h"
@@ -235,11 +236,11 @@ class L2capClassicModuleFacadeService : public L2capClassicModuleFacade::Service
 
     void on_incoming_packet() {
       auto packet = channel_->GetQueueUpEnd()->TryDequeue();
-      std::string data = std::string(packet->begin(), packet->end());
+      std::string data = ::bluetooth::grpc::PacketViewToBytes(*packet);
       L2capPacket l2cap_data;
       l2cap_data.set_psm(psm_);
-      l2cap_data.set_payload(data);
-      facade_service_->pending_l2cap_data_.OnIncomingEvent(l2cap_data);
+      l2cap_data.set_payload(std::move(data));
+      facade_service_->pending_l2cap_data_.OnIncomingEvent(std::move(l2cap_data));
     }
 
     bool SendPacket(std::vector<uint8_t> packet) {
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Header only, so that the legacy stack computes the L2CAP FCS with the same code without linking against GD.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define L2CAP_CRC16_CLMUL
+#include <immintrin.h>
+#define L2CAP_CRC16_CLMUL_TARGET __attribute__((target("pclmul,sse2")))
+#elif defined(__aarch64__) && defined(__linux__)
+#define L2CAP_CRC16_CLMUL
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define L2CAP_CRC16_CLMUL_TARGET __attribute__((target("crypto")))
+#endif
+
+namespace bluetooth {
+namespace l2cap {
+namespace crc16 {
+
+// CRC-16 with the polynomial x^16 + x^15 + x^2 + 1, bit reflected, initial value 0 (L2CAP FCS, Vol 3, Part A, 3.3.5)
+constexpr uint16_t kReflectedPolynomial = 0xa001;
+
+namespace internal {
+
+using Tables = std::array<std::array<uint16_t, 256>, 8>;
+
+constexpr Tables MakeTables() {
+  Tables tables{};
+  for (int byte = 0; byte < 256; byte++) {
+    uint16_t crc = byte;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ kReflectedPolynomial : crc >> 1;
+    }
+    tables[0][byte] = crc;
+  }
+  for (size_t slice = 1; slice < tables.size(); slice++) {
+    for (int byte = 0; byte < 256; byte++) {
+      uint16_t crc = tables[slice - 1][byte];
+      tables[slice][byte] = (crc >> 8) ^ tables[0][crc & 0xff];
+    }
+  }
+  return tables;
+}
+
+// kTables[n][byte] is the CRC of the byte followed by n zero bytes
+inline constexpr Tables kTables = MakeTables();
+
+#ifdef L2CAP_CRC16_CLMUL
+// Folding needs 4 blocks of 16 bytes to start with
+constexpr size_t kMinClmulLength = 64;
+
+// x^degree mod P, with the coefficient of x^d in bit 63 - d, as the bit reflected operands of a carry-less multiply.
+// The product of two such operands comes out multiplied by x, hence the degree - 1 in the fold constants.
+constexpr uint64_t FoldConstant(int degree) {
+  uint32_t remainder = 1;
+  for (int i = 0; i < degree; i++) {
+    remainder <<= 1;
+    if (remainder & 0x10000) {
+      remainder ^= 0x18005;
+    }
+  }
+  uint64_t constant = 0;
+  for (int d = 0; d < 16; d++) {
+    if (remainder & (1u << d)) {
+      constant |= uint64_t{1} << (63 - d);
+    }
+  }
+  return constant;
+}
+
+// A block of 16 bytes holds L * x^64 + H, with L in its first 8 bytes. Moving it forward by D bits is
+// L * x^(64 + D) + H * x^D, so the constants are x^(64 + D - 1) for L and x^(D - 1) for H.
+constexpr uint64_t kFold128Low = FoldConstant(64 + 128 - 1);
+constexpr uint64_t kFold128High = FoldConstant(128 - 1);
+constexpr uint64_t kFold512Low = FoldConstant(64 + 512 - 1);
+constexpr uint64_t kFold512High = FoldConstant(512 - 1);
+#endif
+
+}  // namespace internal
+
+// Returns the CRC of data continuing from crc, one byte at a time
+inline uint16_t UpdateBytewise(uint16_t crc, const uint8_t* data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    crc = (crc >> 8) ^ internal::kTables[0][(crc ^ data[i]) & 0xff];
+  }
+  return crc;
+}
+
+// Returns the CRC of data continuing from crc, 8 bytes at a time
+inline uint16_t UpdateSlicingBy8(uint16_t crc, const uint8_t* data, size_t length) {
+  const auto& t = internal::kTables;
+  while (length >= 8) {
+    uint8_t b0 = data[0] ^ (crc & 0xff);
+    uint8_t b1 = data[1] ^ (crc >> 8);
+    crc = t[7][b0] ^ t[6][b1] ^ t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^
+          t[0][data[7]];
+    data += 8;
+    length -= 8;
+  }
+  return UpdateBytewise(crc, data, length);
+}
+
+#ifdef L2CAP_CRC16_CLMUL
+#if defined(__x86_64__) || defined(__i386__)
+
+namespace internal {
+L2CAP_CRC16_CLMUL_TARGET inline __m128i Fold(__m128i block, __m128i constants, __m128i next) {
+  __m128i low = _mm_clmulepi64_si128(block, constants, 0x00);
+  __m128i high = _mm_clmulepi64_si128(block, constants, 0x11);
+  return _mm_xor_si128(_mm_xor_si128(low, high), next);
+}
+
+L2CAP_CRC16_CLMUL_TARGET inline __m128i Load(const uint8_t* data) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+}  // namespace internal
+
+inline bool HasCarrylessMultiply() {
+  static const bool supported = __builtin_cpu_supports("pclmul");
+  return supported;
+}
+
+// Returns the CRC of data continuing from crc, folding 64 bytes at a time with carry-less multiplies. Only call when
+// HasCarrylessMultiply().
+L2CAP_CRC16_CLMUL_TARGET inline uint16_t UpdateClmul(uint16_t crc, const uint8_t* data, size_t length) {
+  using namespace internal;
+  if (length < kMinClmulLength) {
+    return UpdateSlicingBy8(crc, data, length);
+  }
+  const __m128i fold_512 = _mm_set_epi64x(static_cast<long long>(kFold512High), static_cast<long long>(kFold512Low));
+  const __m128i fold_128 = _mm_set_epi64x(static_cast<long long>(kFold128High), static_cast<long long>(kFold128Low));
+  // With a reflected CRC, continuing from crc is the same as starting from 0 with crc added to the first 2 bytes
+  __m128i x0 = _mm_xor_si128(Load(data), _mm_cvtsi32_si128(crc));
+  __m128i x1 = Load(data + 16);
+  __m128i x2 = Load(data + 32);
+  __m128i x3 = Load(data + 48);
+  data += 64;
+  length -= 64;
+  while (length >= 64) {
+    x0 = Fold(x0, fold_512, Load(data));
+    x1 = Fold(x1, fold_512, Load(data + 16));
+    x2 = Fold(x2, fold_512, Load(data + 32));
+    x3 = Fold(x3, fold_512, Load(data + 48));
+    data += 64;
+    length -= 64;
+  }
+  __m128i x = Fold(x0, fold_128, x1);
+  x = Fold(x, fold_128, x2);
+  x = Fold(x, fold_128, x3);
+  while (length >= 16) {
+    x = Fold(x, fold_128, Load(data));
+    data += 16;
+    length -= 16;
+  }
+  // The folded block is congruent to everything before it, so it has the same CRC
+  uint8_t folded[16];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(folded), x);
+  return UpdateSlicingBy8(UpdateSlicingBy8(0, folded, sizeof(folded)), data, length);
+}
+
+#else
+
+namespace internal {
+L2CAP_CRC16_CLMUL_TARGET inline uint64x2_t Fold(uint64x2_t block, uint64x2_t constants, uint64x2_t next) {
+  poly64x2_t a = vreinterpretq_p64_u64(block);
+  poly64x2_t b = vreinterpretq_p64_u64(constants);
+  uint64x2_t low = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_p64(a, 0), vgetq_lane_p64(b, 0)));
+  uint64x2_t high = vreinterpretq_u64_p128(vmull_high_p64(a, b));
+  return veorq_u64(veorq_u64(low, high), next);
+}
+
+L2CAP_CRC16_CLMUL_TARGET inline uint64x2_t Load(const uint8_t* data) {
+  return vreinterpretq_u64_u8(vld1q_u8(data));
+}
+}  // namespace internal
+
+inline bool HasCarrylessMultiply() {
+  static const bool supported = (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+  return supported;
+}
+
+// Returns the CRC of data continuing from crc, folding 64 bytes at a time with carry-less multiplies. Only call when
+// HasCarrylessMultiply().
+L2CAP_CRC16_CLMUL_TARGET inline uint16_t UpdateClmul(uint16_t crc, const uint8_t* data, size_t length) {
+  using namespace internal;
+  if (length < kMinClmulLength) {
+    return UpdateSlicingBy8(crc, data, length);
+  }
+  const uint64x2_t fold_512 = vcombine_u64(vcreate_u64(kFold512Low), vcreate_u64(kFold512High));
+  const uint64x2_t fold_128 = vcombine_u64(vcreate_u64(kFold128Low), vcreate_u64(kFold128High));
+  // With a reflected CRC, continuing from crc is the same as starting from 0 with crc added to the first 2 bytes
+  uint64x2_t x0 = veorq_u64(Load(data), vcombine_u64(vcreate_u64(crc), vcreate_u64(0)));
+  uint64x2_t x1 = Load(data + 16);
+  uint64x2_t x2 = Load(data + 32);
+  uint64x2_t x3 = Load(data + 48);
+  data += 64;
+  length -= 64;
+  while (length >= 64) {
+    x0 = Fold(x0, fold_512, Load(data));
+    x1 = Fold(x1, fold_512, Load(data + 16));
+    x2 = Fold(x2, fold_512, Load(data + 32));
+    x3 = Fold(x3, fold_512, Load(data + 48));
+    data += 64;
+    length -= 64;
+  }
+  uint64x2_t x = Fold(x0, fold_128, x1);
+  x = Fold(x, fold_128, x2);
+  x = Fold(x, fold_128, x3);
+  while (length >= 16) {
+    x = Fold(x, fold_128, Load(data));
+    data += 16;
+    length -= 16;
+  }
+  // The folded block is congruent to everything before it, so it has the same CRC
+  uint8_t folded[16];
+  vst1q_u8(folded, vreinterpretq_u8_u64(x));
+  return UpdateSlicingBy8(UpdateSlicingBy8(0, folded, sizeof(folded)), data, length);
+}
+
+#endif
+#endif
+
+// Returns the CRC of data continuing from crc, with the fastest implementation the CPU supports
+inline uint16_t Update(uint16_t crc, const uint8_t* data, size_t length) {
+#ifdef L2CAP_CRC16_CLMUL
+  if (length >= internal::kMinClmulLength && HasCarrylessMultiply()) {
+    return UpdateClmul(crc, data, length);
+  }
+#endif
+  return UpdateSlicingBy8(crc, data, length);
+}
+
+}  // namespace crc16
+}  // namespace l2cap
+}  // namespace bluetooth
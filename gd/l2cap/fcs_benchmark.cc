@@ -0,0 +1,75 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "l2cap/crc16.h"
+
+using ::benchmark::State;
+
+namespace {
+
+enum Implementation { BYTEWISE, SLICING_BY_8, CARRYLESS_MULTIPLY };
+
+// Typical SDU sizes, from a default MTU to the largest L2CAP SDU
+constexpr int64_t kMinSduSize = 1 << 10;
+constexpr int64_t kMaxSduSize = (1 << 16) - 1;
+
+void BM_L2capFcs(State& state) {
+  auto implementation = static_cast<Implementation>(state.range(0));
+  std::vector<uint8_t> sdu(state.range(1));
+  for (size_t i = 0; i < sdu.size(); i++) {
+    sdu[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  uint16_t (*update)(uint16_t, const uint8_t*, size_t) = nullptr;
+  switch (implementation) {
+    case BYTEWISE:
+      update = bluetooth::l2cap::crc16::UpdateBytewise;
+      break;
+    case SLICING_BY_8:
+      update = bluetooth::l2cap::crc16::UpdateSlicingBy8;
+      break;
+    case CARRYLESS_MULTIPLY:
+#ifdef L2CAP_CRC16_CLMUL
+      if (bluetooth::l2cap::crc16::HasCarrylessMultiply()) {
+        update = bluetooth::l2cap::crc16::UpdateClmul;
+      }
+#endif
+      break;
+  }
+  if (update == nullptr) {
+    state.SkipWithError("Carry-less multiply is not supported");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(update(0, sdu.data(), sdu.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * sdu.size());
+}
+
+void SduSizes(benchmark::internal::Benchmark* benchmark) {
+  for (int implementation : {BYTEWISE, SLICING_BY_8, CARRYLESS_MULTIPLY}) {
+    for (int64_t sdu_size : {kMinSduSize, int64_t{1} << 12, int64_t{1} << 14, kMaxSduSize}) {
+      benchmark->Args({implementation, sdu_size});
+    }
+  }
+}
+
+BENCHMARK(BM_L2capFcs)->Apply(SduSizes);
+
+}  // namespace
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/fcs.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "l2cap/crc16.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace {
+
+std::vector<uint8_t> RandomBytes(size_t length) {
+  std::mt19937 generator(length);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<uint8_t> bytes(length);
+  for (auto& byte : bytes) {
+    byte = distribution(generator);
+  }
+  return bytes;
+}
+
+TEST(L2capFcsTest, check_value) {
+  std::string data = "123456789";
+  Fcs fcs;
+  fcs.Initialize();
+  for (char c : data) {
+    fcs.AddByte(c);
+  }
+  EXPECT_EQ(fcs.GetChecksum(), 0xbb3d);
+}
+
+TEST(L2capFcsTest, rr_frame) {
+  std::vector<uint8_t> rr_frame = {0x04, 0x00, 0x40, 0x00, 0x01, 0x01};
+  Fcs fcs;
+  fcs.Initialize();
+  fcs.AddBytes(rr_frame.data(), rr_frame.size());
+  EXPECT_EQ(fcs.GetChecksum(), 0x14d4);
+}
+
+TEST(L2capFcsTest, add_bytes_matches_add_byte) {
+  for (size_t length : {0, 1, 7, 8, 9, 63, 64, 65, 127, 200, 1021, 4096, 65535}) {
+    auto data = RandomBytes(length);
+    Fcs bytewise;
+    bytewise.Initialize();
+    for (uint8_t byte : data) {
+      bytewise.AddByte(byte);
+    }
+    Fcs batched;
+    batched.Initialize();
+    batched.AddBytes(data.data(), data.size());
+    EXPECT_EQ(batched.GetChecksum(), bytewise.GetChecksum()) << "length " << length;
+  }
+}
+
+TEST(L2capFcsTest, implementations_agree) {
+  auto data = RandomBytes(1024);
+  for (size_t offset = 0; offset < 16; offset++) {
+    for (size_t length = 0; length + offset <= data.size(); length += 13) {
+      uint16_t crc = crc16::UpdateBytewise(0xabcd, data.data() + offset, length);
+      EXPECT_EQ(crc16::UpdateSlicingBy8(0xabcd, data.data() + offset, length), crc) << "length " << length;
+      EXPECT_EQ(crc16::Update(0xabcd, data.data() + offset, length), crc) << "length " << length;
+#ifdef L2CAP_CRC16_CLMUL
+      if (crc16::HasCarrylessMultiply()) {
+        EXPECT_EQ(crc16::UpdateClmul(0xabcd, data.data() + offset, length), crc) << "length " << length;
+      }
+#endif
+    }
+  }
+}
+
+TEST(L2capFcsTest, continue_from_previous_crc) {
+  auto data = RandomBytes(4096);
+  uint16_t crc = crc16::Update(0, data.data(), 1000);
+  crc = crc16::Update(crc, data.data() + 1000, data.size() - 1000);
+  EXPECT_EQ(crc, crc16::UpdateBytewise(0, data.data(), data.size()));
+}
+
+}  // namespace
+}  // namespace l2cap
+}  // namespace bluetooth
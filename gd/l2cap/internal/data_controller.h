@@ -46,6 +46,12 @@ class DataController {
   // This only applies to some modes (ERTM).
   virtual void SetRetransmissionAndFlowControlOptions(
       const RetransmissionAndFlowControlConfigurationOption& option) = 0;
+
+  // Whether another SDU can be taken from the channel queue. Modes with flow control (LE credit based) return false
+  // while PDUs wait for the peer, so that the upper layer is held back instead of queueing without bound.
+  virtual bool IsReadyForSdu() const {
+    return true;
+  }
 };
 
 }  // namespace internal
@@ -27,6 +27,15 @@ namespace bluetooth {
 namespace l2cap {
 namespace internal {
 
+std::unique_ptr<Scheduler> DataPipelineManager::create_scheduler(SchedulerType scheduler_type,
+                                                                 LowerQueueUpEnd* link_queue_up_end,
+                                                                 os::Handler* handler) {
+  if (scheduler_type == SchedulerType::PRIORITY) {
+    return std::make_unique<PriorityScheduler>(this, link_queue_up_end, handler);
+  }
+  return std::make_unique<Fifo>(this, link_queue_up_end, handler);
+}
+
 void DataPipelineManager::AttachChannel(Cid cid, std::shared_ptr<ChannelImpl> channel, ChannelMode mode) {
   ASSERT(sender_map_.find(cid) == sender_map_.end());
   sender_map_.emplace(std::piecewise_construct, std::forward_as_tuple(cid),
@@ -36,6 +45,7 @@ void DataPipelineManager::AttachChannel(Cid cid, std::shared_ptr<ChannelImpl> ch
 void DataPipelineManager::DetachChannel(Cid cid) {
   ASSERT(sender_map_.find(cid) != sender_map_.end());
   sender_map_.erase(cid);
+  scheduler_->OnChannelDetached(cid);
 }
 
 DataController* DataPipelineManager::GetDataController(Cid cid) {
@@ -55,6 +65,10 @@ void DataPipelineManager::UpdateClassicConfiguration(Cid cid, classic::internal:
   sender_map_.find(cid)->second.UpdateClassicConfiguration(config);
 }
 
+void DataPipelineManager::SetChannelWeight(Cid cid, int weight) {
+  scheduler_->SetChannelWeight(cid, weight);
+}
+
 }  // namespace internal
 }  // namespace l2cap
 }  // namespace bluetooth
@@ -28,6 +28,7 @@
 #include "l2cap/internal/receiver.h"
 #include "l2cap/internal/scheduler.h"
 #include "l2cap/internal/scheduler_fifo.h"
+#include "l2cap/internal/scheduler_priority.h"
 #include "l2cap/l2cap_packets.h"
 #include "l2cap/mtu.h"
 #include "os/handler.h"
@@ -55,8 +56,16 @@ class DataPipelineManager {
   using LowerDequeue = UpperEnqueue;
   using LowerQueueUpEnd = common::BidiQueueEnd<LowerEnqueue, LowerDequeue>;
 
-  DataPipelineManager(os::Handler* handler, ILink* link, LowerQueueUpEnd* link_queue_up_end)
-      : handler_(handler), link_(link), scheduler_(std::make_unique<Fifo>(this, link_queue_up_end, handler)),
+  enum class SchedulerType {
+    // Channels are served in the order their packets became ready
+    FIFO,
+    // Fixed channels in strict priority, then dynamic channels in weighted round robin
+    PRIORITY,
+  };
+
+  DataPipelineManager(os::Handler* handler, ILink* link, LowerQueueUpEnd* link_queue_up_end,
+                      SchedulerType scheduler_type = SchedulerType::FIFO)
+      : handler_(handler), link_(link), scheduler_(create_scheduler(scheduler_type, link_queue_up_end, handler)),
         receiver_(link_queue_up_end, handler, this) {}
 
   using ChannelMode = Sender::ChannelMode;
@@ -66,9 +75,13 @@ class DataPipelineManager {
   virtual DataController* GetDataController(Cid cid);
   virtual void OnPacketSent(Cid cid);
   virtual void UpdateClassicConfiguration(Cid cid, classic::internal::ChannelConfigurationState config);
+  virtual void SetChannelWeight(Cid cid, int weight);
   virtual ~DataPipelineManager() = default;
 
  private:
+  std::unique_ptr<Scheduler> create_scheduler(SchedulerType scheduler_type, LowerQueueUpEnd* link_queue_up_end,
+                                              os::Handler* handler);
+
   os::Handler* handler_;
   ILink* link_;
   std::unordered_map<Cid, Sender> sender_map_;
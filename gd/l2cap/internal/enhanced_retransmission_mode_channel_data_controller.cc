@@ -16,7 +16,10 @@
 
 #include "l2cap/internal/enhanced_retransmission_mode_channel_data_controller.h"
 
-#include <map>
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <optional>
 #include <queue>
 #include <vector>
 
@@ -45,11 +48,12 @@ struct ErtmController::impl {
   ErtmController* controller_;
   os::Handler* handler_;
 
-  // We don't support extended window
+  // Sequence numbers are modulo 64 with the enhanced control field. We don't support the extended control field,
+  // which would only raise this modulo to 16384.
   static constexpr uint8_t kMaxTxWin = 64;
 
-  // We don't support sending SREJ
-  static constexpr bool kSendSrej = false;
+  // On a TxSeq gap, request the missing I-frames one by one instead of rejecting everything from the first one
+  static constexpr bool kSendSrej = true;
 
   // States (@see 8.6.5.2): Transmitter state and receiver state
 
@@ -78,13 +82,17 @@ struct ErtmController::impl {
   bool remote_busy_ = false;
   bool local_busy_ = false;
   int unacked_frames_ = 0;
-  // TODO: Instead of having a map, we may consider about a better data structure
-  // Map from TxSeq to (SAR, SDU size for START packet, information payload)
-  std::map<uint8_t, std::tuple<SegmentationAndReassembly, uint16_t, std::shared_ptr<packet::RawBuilder>>> unacked_list_;
+  struct UnackedFrame {
+    SegmentationAndReassembly sar_ = SegmentationAndReassembly::UNSEGMENTED;
+    uint16_t sdu_size_ = 0;  // Only for START packet
+    std::shared_ptr<packet::RawBuilder> payload_;
+    int retry_count_ = 0;
+  };
+  // Indexed by TxSeq, a slot holds a payload from send_data() until the I-frame is acknowledged
+  std::array<UnackedFrame, kMaxTxWin> unacked_list_;
   // Stores (SAR, SDU size for START packet, information payload)
   std::queue<std::tuple<SegmentationAndReassembly, uint16_t, std::unique_ptr<packet::RawBuilder>>> pending_frames_;
   int retry_count_ = 0;
-  std::map<uint8_t /* tx_seq, */, int /* count */> retry_i_frames_;
   bool rnr_sent_ = false;
   bool rej_actioned_ = false;
   bool srej_actioned_ = false;
@@ -92,6 +100,15 @@ struct ErtmController::impl {
   bool send_rej_ = false;
   int buffer_seq_srej_ = 0;
   int frames_sent_ = 0;
+  struct ReceivedFrame {
+    SegmentationAndReassembly sar_;
+    uint16_t sdu_size_;
+    packet::PacketView<true> payload_;
+  };
+  // Indexed by TxSeq, holds the I-frames received past a gap until the gap is filled
+  std::array<std::optional<ReceivedFrame>, kMaxTxWin> srej_rcv_buffer_;
+  // TxSeq of the I-frames requested with SREJ, in the order they are expected
+  std::deque<uint8_t> srej_list_;
   os::Alarm retrans_timer_;
   os::Alarm monitor_timer_;
 
@@ -198,7 +215,11 @@ struct ErtmController::impl {
       } else if (with_unexpected_tx_seq(tx_seq) && with_valid_req_seq(req_seq) && with_valid_f_bit(f) &&
                  !local_busy()) {
         if constexpr (kSendSrej) {
-          // We don't support sending SREJ
+          pass_to_tx(req_seq, f);
+          init_srej();
+          save_i_frame_srej(tx_seq, sar, sdu_size, payload);
+          send_srej(tx_seq);
+          rx_state_ = RxState::SREJ_SENT;
         } else {
           pass_to_tx(req_seq, f);
           send_rej();
@@ -240,12 +261,44 @@ struct ErtmController::impl {
         pass_to_tx(req_seq, f);
       }
     } else if (rx_state_ == RxState::SREJ_SENT) {
-      // SREJ NOT SUPPORTED
+      if (with_expected_tx_seq_srej(tx_seq) && with_valid_req_seq(req_seq) && with_valid_f_bit(f)) {
+        pass_to_tx(req_seq, f);
+        save_i_frame_srej(tx_seq, sar, sdu_size, payload);
+        pop_srej_list();
+        data_indication_srej();
+        if (srej_list_is_empty()) {
+          send_ack(Final::NOT_SET);
+          rx_state_ = RxState::RECV;
+        }
+      } else if (with_unexpected_tx_seq_srej(tx_seq) && with_valid_req_seq(req_seq) && with_valid_f_bit(f)) {
+        // The peer skipped the I-frames requested before this one, request them again
+        pass_to_tx(req_seq, f);
+        save_i_frame_srej(tx_seq, sar, sdu_size, payload);
+        resend_srej_list_until(tx_seq);
+        pop_srej_list();
+      } else if (with_duplicate_tx_seq_srej(tx_seq) && with_valid_req_seq(req_seq) && with_valid_f_bit(f)) {
+        pass_to_tx(req_seq, f);
+      } else if (with_expected_tx_seq(tx_seq) && within_srej_window(tx_seq) && with_valid_req_seq(req_seq) &&
+                 with_valid_f_bit(f)) {
+        increment_expected_tx_seq();
+        pass_to_tx(req_seq, f);
+        save_i_frame_srej(tx_seq, sar, sdu_size, payload);
+      } else if (with_unexpected_tx_seq(tx_seq) && within_srej_window(tx_seq) && with_valid_req_seq(req_seq) &&
+                 with_valid_f_bit(f)) {
+        pass_to_tx(req_seq, f);
+        save_i_frame_srej(tx_seq, sar, sdu_size, payload);
+        send_srej(tx_seq);
+      } else if (with_invalid_req_seq(req_seq)) {
+        CloseChannel();
+      } else if (with_valid_req_seq(req_seq) && with_valid_f_bit(f)) {
+        // Duplicate of a delivered I-frame, or past the receive window which starts at the oldest missing I-frame
+        pass_to_tx(req_seq, f);
+      }
     }
   }
 
   void recv_rr(uint8_t req_seq, Poll p = Poll::NOT_SET, Final f = Final::NOT_SET) {
-    if (rx_state_ == RxState::RECV) {
+    if (rx_state_ == RxState::RECV || rx_state_ == RxState::SREJ_SENT) {
       if (p == Poll::NOT_SET && f == Final::NOT_SET && with_valid_req_seq(req_seq) && with_valid_f_bit(f)) {
         pass_to_tx(req_seq, f);
         if (remote_busy() && unacked_frames_ > 0) {
@@ -295,13 +348,11 @@ struct ErtmController::impl {
       } else if (with_invalid_req_seq(req_seq)) {
         CloseChannel();
       }
-    } else if (rx_state_ == RxState::SREJ_SENT) {
-      // SREJ NOT SUPPORTED
     }
   }
 
   void recv_rej(uint8_t req_seq, Poll p = Poll::NOT_SET, Final f = Final::NOT_SET) {
-    if (rx_state_ == RxState::RECV) {
+    if (rx_state_ == RxState::RECV || rx_state_ == RxState::SREJ_SENT) {
       if (f == Final::NOT_SET && with_valid_req_seq_retrans(req_seq) &&
           retry_i_frames_less_than_max_transmit(req_seq) && with_valid_f_bit(f)) {
         remote_busy_ = false;
@@ -351,13 +402,11 @@ struct ErtmController::impl {
       } else if (with_invalid_req_seq_retrans(req_seq)) {
         CloseChannel();
       }
-    } else if (rx_state_ == RxState::SREJ_SENT) {
-      // SREJ NOT SUPPORTED
     }
   }
 
   void recv_rnr(uint8_t req_seq, Poll p = Poll::NOT_SET, Final f = Final::NOT_SET) {
-    if (rx_state_ == RxState::RECV) {
+    if (rx_state_ == RxState::RECV || rx_state_ == RxState::SREJ_SENT) {
       if (p == Poll::NOT_SET && with_valid_req_seq(req_seq) && with_valid_f_bit(f)) {
         remote_busy_ = true;
         pass_to_tx(req_seq, f);
@@ -382,13 +431,11 @@ struct ErtmController::impl {
       } else if (with_invalid_req_seq_retrans(req_seq)) {
         CloseChannel();
       }
-    } else if (rx_state_ == RxState::SREJ_SENT) {
-      // SREJ NOT SUPPORTED
     }
   }
 
   void recv_srej(uint8_t req_seq, Poll p = Poll::NOT_SET, Final f = Final::NOT_SET) {
-    if (rx_state_ == RxState::RECV) {
+    if (rx_state_ == RxState::RECV || rx_state_ == RxState::SREJ_SENT) {
       if (p == Poll::NOT_SET && f == Final::NOT_SET && with_valid_req_seq_retrans(req_seq) &&
           retry_i_frames_less_than_max_transmit(req_seq) && with_valid_f_bit(f)) {
         remote_busy_ = false;
@@ -456,8 +503,6 @@ struct ErtmController::impl {
       } else if (with_invalid_req_seq_retrans(req_seq)) {
         CloseChannel();
       }
-    } else if (rx_state_ == RxState::SREJ_SENT) {
-      // SREJ NOT SUPPORTED
     }
   }
 
@@ -483,7 +528,7 @@ struct ErtmController::impl {
   }
 
   bool retry_i_frames_less_than_max_transmit(uint8_t req_seq) {
-    return retry_i_frames_[req_seq] < controller_->local_max_transmit_;
+    return unacked_list_[req_seq].retry_count_ < controller_->local_max_transmit_;
   }
 
   bool retry_count_less_than_max_transmit() {
@@ -547,9 +592,8 @@ struct ErtmController::impl {
     return !with_invalid_tx_seq(tx_seq) && !with_expected_tx_seq(tx_seq);
   }
 
-  bool with_expected_tx_seq_srej() {
-    // We don't support sending SREJ
-    return false;
+  bool with_expected_tx_seq_srej(uint8_t tx_seq) {
+    return !srej_list_.empty() && srej_list_.front() == tx_seq;
   }
 
   bool send_req_is_true() {
@@ -558,18 +602,25 @@ struct ErtmController::impl {
   }
 
   bool srej_list_is_one() {
-    // We don't support sending SREJ
-    return false;
+    return srej_list_.size() == 1;
   }
 
-  bool with_unexpected_tx_seq_srej() {
-    // We don't support sending SREJ
-    return false;
+  bool srej_list_is_empty() {
+    return srej_list_.empty();
   }
 
-  bool with_duplicate_tx_seq_srej() {
-    // We don't support sending SREJ
-    return false;
+  bool with_unexpected_tx_seq_srej(uint8_t tx_seq) {
+    return !with_expected_tx_seq_srej(tx_seq) &&
+           std::find(srej_list_.begin(), srej_list_.end(), tx_seq) != srej_list_.end();
+  }
+
+  bool with_duplicate_tx_seq_srej(uint8_t tx_seq) {
+    return srej_rcv_buffer_[tx_seq].has_value();
+  }
+
+  // In SREJ_SENT, frames are buffered from BufferSeq (the oldest missing I-frame) on
+  bool within_srej_window(uint8_t tx_seq) {
+    return (tx_seq - buffer_seq_ + kMaxTxWin) % kMaxTxWin < controller_->local_tx_window_;
   }
 
   // Actions (@see 8.6.5.6)
@@ -599,16 +650,17 @@ struct ErtmController::impl {
 
   void send_data(SegmentationAndReassembly sar, uint16_t sdu_size, std::unique_ptr<packet::RawBuilder> segment,
                  Final f = Final::NOT_SET) {
-    std::shared_ptr<packet::RawBuilder> shared_segment(segment.release());
-    unacked_list_.emplace(std::piecewise_construct, std::forward_as_tuple(next_tx_seq_),
-                          std::forward_as_tuple(sar, sdu_size, shared_segment));
+    UnackedFrame& frame = unacked_list_[next_tx_seq_];
+    frame.sar_ = sar;
+    frame.sdu_size_ = sdu_size;
+    frame.payload_.reset(segment.release());
+    frame.retry_count_ = 1;
 
     std::unique_ptr<CopyablePacketBuilder> copyable_packet_builder =
-        std::make_unique<CopyablePacketBuilder>(std::get<2>(unacked_list_.find(next_tx_seq_)->second));
+        std::make_unique<CopyablePacketBuilder>(frame.payload_);
     _send_i_frame(sar, std::move(copyable_packet_builder), buffer_seq_, next_tx_seq_, sdu_size, f);
     unacked_frames_++;
     frames_sent_++;
-    retry_i_frames_[next_tx_seq_] = 1;
     next_tx_seq_ = (next_tx_seq_ + 1) % kMaxTxWin;
     start_retrans_timer();
   }
@@ -618,9 +670,8 @@ struct ErtmController::impl {
   }
 
   void process_req_seq(uint8_t req_seq) {
-    for (int i = expected_ack_seq_; i < req_seq; i++) {
-      unacked_list_.erase(i);
-      retry_i_frames_[i] = 0;
+    for (uint8_t i = expected_ack_seq_; i != req_seq; i = (i + 1) % kMaxTxWin) {
+      unacked_list_[i] = UnackedFrame();
     }
     unacked_frames_ -= ((req_seq - expected_ack_seq_) + kMaxTxWin) % kMaxTxWin;
     expected_ack_seq_ = req_seq;
@@ -639,20 +690,21 @@ struct ErtmController::impl {
     controller_->send_pdu(std::move(builder));
   }
 
+  // Acknowledge up to BufferSeq, which only lags behind ExpectedTxSeq while I-frames requested with SREJ are missing
   void send_rr(Poll p) {
-    _send_s_frame(SupervisoryFunction::RECEIVER_READY, expected_tx_seq_, p, Final::NOT_SET);
+    _send_s_frame(SupervisoryFunction::RECEIVER_READY, buffer_seq_, p, Final::NOT_SET);
   }
 
   void send_rr(Final f) {
-    _send_s_frame(SupervisoryFunction::RECEIVER_READY, expected_tx_seq_, Poll::NOT_SET, f);
+    _send_s_frame(SupervisoryFunction::RECEIVER_READY, buffer_seq_, Poll::NOT_SET, f);
   }
 
   void send_rnr(Poll p) {
-    _send_s_frame(SupervisoryFunction::RECEIVER_NOT_READY, expected_tx_seq_, p, Final::NOT_SET);
+    _send_s_frame(SupervisoryFunction::RECEIVER_NOT_READY, buffer_seq_, p, Final::NOT_SET);
   }
 
   void send_rnr(Final f) {
-    _send_s_frame(SupervisoryFunction::RECEIVER_NOT_READY, expected_tx_seq_, Poll::NOT_SET, f);
+    _send_s_frame(SupervisoryFunction::RECEIVER_NOT_READY, buffer_seq_, Poll::NOT_SET, f);
     rnr_sent_ = true;
   }
 
@@ -683,8 +735,23 @@ struct ErtmController::impl {
     }
   }
 
-  void send_srej() {
-    // Sending SREJ is not supported
+  // Request each I-frame from ExpectedTxSeq up to (excluding) tx_seq
+  void send_srej(uint8_t tx_seq) {
+    for (uint8_t i = expected_tx_seq_; i != tx_seq; i = (i + 1) % kMaxTxWin) {
+      _send_s_frame(SupervisoryFunction::SELECT_REJECT, i, Poll::NOT_SET, Final::NOT_SET);
+      srej_list_.push_back(i);
+    }
+    expected_tx_seq_ = (tx_seq + 1) % kMaxTxWin;
+  }
+
+  // Request again the I-frames listed before tx_seq, and keep them in the list behind it
+  void resend_srej_list_until(uint8_t tx_seq) {
+    while (srej_list_.front() != tx_seq) {
+      uint8_t missing = srej_list_.front();
+      srej_list_.pop_front();
+      _send_s_frame(SupervisoryFunction::SELECT_REJECT, missing, Poll::NOT_SET, Final::NOT_SET);
+      srej_list_.push_back(missing);
+    }
   }
 
   void start_retrans_timer() {
@@ -733,11 +800,12 @@ struct ErtmController::impl {
   }
 
   void init_srej() {
-    // We don't support sending SREJ
+    srej_list_.clear();
   }
 
-  void save_i_frame_srej() {
-    // We don't support sending SREJ
+  void save_i_frame_srej(uint8_t tx_seq, SegmentationAndReassembly sar, uint16_t sdu_size,
+                         const packet::PacketView<true>& payload) {
+    srej_rcv_buffer_[tx_seq] = ReceivedFrame{sar, sdu_size, payload};
   }
 
   void store_or_ignore() {
@@ -751,19 +819,19 @@ struct ErtmController::impl {
   void retransmit_i_frames(uint8_t req_seq, Poll p = Poll::NOT_SET) {
     uint8_t i = req_seq;
     Final f = (p == Poll::NOT_SET ? Final::NOT_SET : Final::POLL_RESPONSE);
-    while (unacked_list_.find(i) != unacked_list_.end()) {
-      if (retry_i_frames_[i] == controller_->local_max_transmit_) {
+    while (i != next_tx_seq_ && unacked_list_[i].payload_ != nullptr) {
+      UnackedFrame& frame = unacked_list_[i];
+      if (frame.retry_count_ == controller_->local_max_transmit_) {
         CloseChannel();
         return;
       }
       std::unique_ptr<CopyablePacketBuilder> copyable_packet_builder =
-          std::make_unique<CopyablePacketBuilder>(std::get<2>(unacked_list_.find(i)->second));
-      _send_i_frame(std::get<0>(unacked_list_.find(i)->second), std::move(copyable_packet_builder), buffer_seq_, i,
-                    std::get<1>(unacked_list_.find(i)->second), f);
-      retry_i_frames_[i]++;
+          std::make_unique<CopyablePacketBuilder>(frame.payload_);
+      _send_i_frame(frame.sar_, std::move(copyable_packet_builder), buffer_seq_, i, frame.sdu_size_, f);
+      frame.retry_count_++;
       frames_sent_++;
       f = Final::NOT_SET;
-      i++;
+      i = (i + 1) % kMaxTxWin;
     }
     if (i != req_seq) {
       start_retrans_timer();
@@ -772,15 +840,15 @@ struct ErtmController::impl {
 
   void retransmit_requested_i_frame(uint8_t req_seq, Poll p) {
     Final f = p == Poll::POLL ? Final::POLL_RESPONSE : Final::NOT_SET;
-    if (unacked_list_.find(req_seq) == unacked_list_.end()) {
+    UnackedFrame& frame = unacked_list_[req_seq];
+    if (frame.payload_ == nullptr) {
       LOG_ERROR("Received invalid SREJ");
       return;
     }
     std::unique_ptr<CopyablePacketBuilder> copyable_packet_builder =
-        std::make_unique<CopyablePacketBuilder>(std::get<2>(unacked_list_.find(req_seq)->second));
-    _send_i_frame(std::get<0>(unacked_list_.find(req_seq)->second), std::move(copyable_packet_builder), buffer_seq_,
-                  req_seq, std::get<1>(unacked_list_.find(req_seq)->second), f);
-    retry_i_frames_[req_seq]++;
+        std::make_unique<CopyablePacketBuilder>(frame.payload_);
+    _send_i_frame(frame.sar_, std::move(copyable_packet_builder), buffer_seq_, req_seq, frame.sdu_size_, f);
+    frame.retry_count_++;
     start_retrans_timer();
   }
 
@@ -801,11 +869,16 @@ struct ErtmController::impl {
   }
 
   void pop_srej_list() {
-    // We don't support sending SREJ
+    srej_list_.pop_front();
   }
 
+  // Deliver the buffered I-frames up to the next missing one
   void data_indication_srej() {
-    // We don't support sending SREJ
+    while (srej_rcv_buffer_[buffer_seq_].has_value()) {
+      ReceivedFrame frame = std::move(*srej_rcv_buffer_[buffer_seq_]);
+      srej_rcv_buffer_[buffer_seq_].reset();
+      data_indication(frame.sar_, frame.sdu_size_, frame.payload_);
+    }
   }
 };
 
@@ -42,6 +42,37 @@ PacketView<kLittleEndian> GetPacketView(std::unique_ptr<packet::BasePacketBuilde
   return packet::PacketView<packet::kLittleEndian>(bytes);
 }
 
+EnhancedSupervisoryFrameView GetSupervisoryFrameView(std::unique_ptr<packet::BasePacketBuilder> packet) {
+  auto pdu_view = BasicFrameView::Create(GetPacketView(std::move(packet)));
+  EXPECT_TRUE(pdu_view.IsValid());
+  auto standard_view = StandardFrameView::Create(pdu_view);
+  EXPECT_TRUE(standard_view.IsValid());
+  EXPECT_EQ(standard_view.GetFrameType(), FrameType::S_FRAME);
+  auto view = EnhancedSupervisoryFrameView::Create(standard_view);
+  EXPECT_TRUE(view.IsValid());
+  return view;
+}
+
+EnhancedInformationFrameView GetInformationFrameView(std::unique_ptr<packet::BasePacketBuilder> packet) {
+  auto pdu_view = BasicFrameView::Create(GetPacketView(std::move(packet)));
+  EXPECT_TRUE(pdu_view.IsValid());
+  auto standard_view = StandardFrameView::Create(pdu_view);
+  EXPECT_TRUE(standard_view.IsValid());
+  EXPECT_EQ(standard_view.GetFrameType(), FrameType::I_FRAME);
+  auto view = EnhancedInformationFrameView::Create(standard_view);
+  EXPECT_TRUE(view.IsValid());
+  return view;
+}
+
+PacketView<kLittleEndian> CreateIFrame(uint8_t tx_seq, uint8_t req_seq, std::vector<uint8_t> payload) {
+  return GetPacketView(EnhancedInformationFrameBuilder::Create(
+      1, tx_seq, Final::NOT_SET, req_seq, SegmentationAndReassembly::UNSEGMENTED, CreateSdu(std::move(payload))));
+}
+
+PacketView<kLittleEndian> CreateSFrame(SupervisoryFunction s, uint8_t req_seq) {
+  return GetPacketView(EnhancedSupervisoryFrameBuilder::Create(1, s, Poll::NOT_SET, Final::NOT_SET, req_seq));
+}
+
 void sync_handler(os::Handler* handler) {
   std::promise<void> promise;
   auto future = promise.get_future();
@@ -204,6 +235,81 @@ TEST_F(ErtmDataControllerTest, receive_packet_with_fcs) {
   EXPECT_EQ(data, "abcd");
 }
 
+TEST_F(ErtmDataControllerTest, receive_out_of_order_sends_srej_and_delivers_in_order) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  ErtmController controller{&link, 1, 1, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  controller.OnPdu(CreateIFrame(0, 0, {'a'}));
+  auto rr_view = GetSupervisoryFrameView(controller.GetNextPacket());
+  EXPECT_EQ(rr_view.GetS(), SupervisoryFunction::RECEIVER_READY);
+  EXPECT_EQ(rr_view.GetReqSeq(), 1);
+
+  // I-frames 1 and 2 are lost
+  controller.OnPdu(CreateIFrame(3, 0, {'d'}));
+  auto srej_view = GetSupervisoryFrameView(controller.GetNextPacket());
+  EXPECT_EQ(srej_view.GetS(), SupervisoryFunction::SELECT_REJECT);
+  EXPECT_EQ(srej_view.GetReqSeq(), 1);
+  srej_view = GetSupervisoryFrameView(controller.GetNextPacket());
+  EXPECT_EQ(srej_view.GetS(), SupervisoryFunction::SELECT_REJECT);
+  EXPECT_EQ(srej_view.GetReqSeq(), 2);
+  controller.OnPdu(CreateIFrame(4, 0, {'e'}));
+
+  controller.OnPdu(CreateIFrame(1, 0, {'b'}));
+  controller.OnPdu(CreateIFrame(2, 0, {'c'}));
+  // Depending on the upper queue, delivering the buffered I-frames at once may be acknowledged with RNR
+  EXPECT_EQ(GetSupervisoryFrameView(controller.GetNextPacket()).GetReqSeq(), 5);
+
+  std::string data;
+  for (int i = 0; i < 10 && data.size() < 5; i++) {
+    sync_handler(queue_handler_);
+    while (auto payload = channel_queue.GetUpEnd()->TryDequeue()) {
+      data += std::string(payload->begin(), payload->end());
+    }
+  }
+  EXPECT_EQ(data, "abcde");
+}
+
+TEST_F(ErtmDataControllerTest, receive_srej_retransmits_requested_frame_only) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  ErtmController controller{&link, 1, 1, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  for (uint8_t i = 0; i < 3; i++) {
+    controller.OnSdu(CreateSdu({'a', 'b', 'c', static_cast<uint8_t>('0' + i)}));
+    EXPECT_EQ(GetInformationFrameView(controller.GetNextPacket()).GetTxSeq(), i);
+  }
+  EXPECT_CALL(scheduler, OnPacketsReady(1, 1));
+  controller.OnPdu(CreateSFrame(SupervisoryFunction::SELECT_REJECT, 1));
+  auto i_frame_view = GetInformationFrameView(controller.GetNextPacket());
+  EXPECT_EQ(i_frame_view.GetTxSeq(), 1);
+  auto payload = i_frame_view.GetPayload();
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "abc1");
+}
+
+TEST_F(ErtmDataControllerTest, receive_rej_after_tx_seq_wraps_around) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  ErtmController controller{&link, 1, 1, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  // Each I-frame is acknowledged right away, so TxSeq goes past the modulo with a single unacked frame
+  for (int i = 0; i < 70; i++) {
+    controller.OnSdu(CreateSdu({'a'}));
+    EXPECT_EQ(GetInformationFrameView(controller.GetNextPacket()).GetTxSeq(), i % 64);
+    controller.OnPdu(CreateSFrame(SupervisoryFunction::RECEIVER_READY, (i + 1) % 64));
+  }
+  controller.OnSdu(CreateSdu({'x'}));
+  controller.OnSdu(CreateSdu({'y'}));
+  EXPECT_EQ(GetInformationFrameView(controller.GetNextPacket()).GetTxSeq(), 6);
+  EXPECT_EQ(GetInformationFrameView(controller.GetNextPacket()).GetTxSeq(), 7);
+  controller.OnPdu(CreateSFrame(SupervisoryFunction::REJECT, 6));
+  auto i_frame_view = GetInformationFrameView(controller.GetNextPacket());
+  EXPECT_EQ(i_frame_view.GetTxSeq(), 6);
+  auto payload = i_frame_view.GetPayload();
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "x");
+  EXPECT_EQ(GetInformationFrameView(controller.GetNextPacket()).GetTxSeq(), 7);
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace l2cap
@@ -16,9 +16,11 @@
 
 #include "l2cap/internal/le_credit_based_channel_data_controller.h"
 
+#include <algorithm>
+
 #include "l2cap/l2cap_packets.h"
 #include "l2cap/le/internal/link.h"
-#include "packet/fragmenting_inserter.h"
+#include "packet/bit_inserter.h"
 #include "packet/raw_builder.h"
 
 namespace bluetooth {
@@ -40,11 +42,17 @@ void LeCreditBasedDataController::OnSdu(std::unique_ptr<packet::BasePacketBuilde
   if (sdu_size > mtu_) {
     LOG_WARN("Received sdu_size %d > mtu %d", static_cast<int>(sdu_size), mtu_);
   }
+  std::vector<uint8_t> sdu_bytes;
+  sdu_bytes.reserve(sdu_size);
+  packet::BitInserter inserter(sdu_bytes);
+  sdu->Serialize(inserter);
+  // Only the first K-frame carries the 2 byte SDU length, the continuation ones fill the whole MPS
   std::vector<std::unique_ptr<packet::RawBuilder>> segments;
-  // TODO: We don't need to waste 2 bytes for continuation segment.
-  packet::FragmentingInserter fragmenting_inserter(mps_ - 2, std::back_insert_iterator(segments));
-  sdu->Serialize(fragmenting_inserter);
-  fragmenting_inserter.finalize();
+  size_t segment_size = mps_ - 2;
+  for (size_t offset = 0; offset < sdu_bytes.size(); offset += segment_size, segment_size = mps_) {
+    auto end = sdu_bytes.begin() + std::min(sdu_bytes.size(), offset + segment_size);
+    segments.push_back(std::make_unique<packet::RawBuilder>(std::vector<uint8_t>(sdu_bytes.begin() + offset, end)));
+  }
   std::unique_ptr<BasicFrameBuilder> builder;
   builder = FirstLeInformationFrameBuilder::Create(remote_cid_, sdu_size, std::move(segments[0]));
   pdu_queue_.emplace(std::move(builder));
@@ -97,8 +105,13 @@ void LeCreditBasedDataController::OnPdu(packet::PacketView<true> pdu) {
     remaining_sdu_continuation_packet_size_ = 0;
     link_->SendDisconnectionRequest(cid_, remote_cid_);
   }
-  // TODO: Improve the logic by sending credit only after user dequeued the SDU
-  link_->SendLeCredit(cid_, 1);
+  // Return the credits in bulk once the remote is down to half of the credits we granted, rather than one Flow
+  // Control Credit packet per K-frame. The remote keeps enough credits to send meanwhile.
+  credits_to_return_++;
+  if (credits_to_return_ >= std::max(1, initial_credits_ / 2)) {
+    link_->SendLeCredit(cid_, credits_to_return_);
+    credits_to_return_ = 0;
+  }
 }
 
 std::unique_ptr<packet::BasePacketBuilder> LeCreditBasedDataController::GetNextPacket() {
@@ -108,6 +121,11 @@ std::unique_ptr<packet::BasePacketBuilder> LeCreditBasedDataController::GetNextP
   return next;
 }
 
+bool LeCreditBasedDataController::IsReadyForSdu() const {
+  // Segments still waiting for credits: taking more SDUs would only grow the queue
+  return pending_frames_count_ == 0;
+}
+
 void LeCreditBasedDataController::SetMtu(Mtu mtu) {
   mtu_ = mtu;
 }
@@ -116,6 +134,10 @@ void LeCreditBasedDataController::SetMps(uint16_t mps) {
   mps_ = mps;
 }
 
+void LeCreditBasedDataController::SetInitialCredit(uint16_t credits) {
+  initial_credits_ = credits;
+}
+
 void LeCreditBasedDataController::OnCredit(uint16_t credits) {
   int total_credits = credits_ + credits;
   if (total_credits > 0xffff) {
@@ -124,8 +146,8 @@ void LeCreditBasedDataController::OnCredit(uint16_t credits) {
   credits_ = total_credits;
   if (pending_frames_count_ > 0 && credits_ >= pending_frames_count_) {
     scheduler_->OnPacketsReady(cid_, pending_frames_count_);
-    pending_frames_count_ = 0;
     credits_ -= pending_frames_count_;
+    pending_frames_count_ = 0;
   } else if (pending_frames_count_ > 0) {
     scheduler_->OnPacketsReady(cid_, credits_);
     pending_frames_count_ -= credits_;
@@ -51,10 +51,14 @@ class LeCreditBasedDataController : public DataController {
 
   void EnableFcs(bool enabled) override {}
   void SetRetransmissionAndFlowControlOptions(const RetransmissionAndFlowControlConfigurationOption& option) override {}
+  bool IsReadyForSdu() const override;
 
   // TODO: Set MTU and MPS from signalling channel
   void SetMtu(Mtu mtu);
   void SetMps(uint16_t mps);
+  // Credits granted to the remote when the channel was opened. The credits consumed by the remote are returned once
+  // it is down to half of them.
+  void SetInitialCredit(uint16_t credits);
   // TODO: Handle credits
   void OnCredit(uint16_t credits);
 
@@ -69,6 +73,8 @@ class LeCreditBasedDataController : public DataController {
   Mtu mtu_ = 512;
   uint16_t mps_ = 251;
   uint16_t credits_ = 0;
+  uint16_t initial_credits_ = 0;
+  uint16_t credits_to_return_ = 0;
   uint16_t pending_frames_count_ = 0;
 
   class PacketViewForReassembly : public packet::PacketView<kLittleEndian> {
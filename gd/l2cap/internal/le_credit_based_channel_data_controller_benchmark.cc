@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/bidi_queue.h"
+#include "l2cap/cid.h"
+#include "l2cap/internal/ilink.h"
+#include "l2cap/internal/le_credit_based_channel_data_controller.h"
+#include "l2cap/internal/scheduler.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+using ::bluetooth::common::BidiQueue;
+using ::bluetooth::l2cap::Cid;
+using ::bluetooth::l2cap::internal::ILink;
+using ::bluetooth::l2cap::internal::LeCreditBasedDataController;
+using ::bluetooth::l2cap::internal::Scheduler;
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::Thread;
+using ::bluetooth::packet::BasePacketBuilder;
+using ::bluetooth::packet::BitInserter;
+
+namespace {
+
+constexpr Cid kCid = 0x41;
+// SDUs as written by an app socket, segmented to a 251 byte LE data PDU
+constexpr uint16_t kMps = 247;
+constexpr size_t kSduSize = 1000;
+
+class BenchmarkLink : public ILink {
+ public:
+  void SendDisconnectionRequest(Cid local_cid, Cid remote_cid) override {}
+  bluetooth::hci::AddressWithType GetDevice() const override {
+    return bluetooth::hci::AddressWithType();
+  }
+  void SendLeCredit(Cid local_cid, uint16_t credit) override {}
+};
+
+// Counts the PDUs the data controller marks ready, as the link would send them
+class BenchmarkScheduler : public Scheduler {
+ public:
+  void OnPacketsReady(Cid cid, int number_packets) override {
+    ready_ += number_packets;
+  }
+  int ready_ = 0;
+};
+
+// The app keeps the channel busy while the peer returns |state.range(0)| credits at a time, each after that many
+// PDUs were sent. Only SDUs the controller is ready for are taken, as the sender does.
+void BM_LeCreditBasedTransmit(State& state) {
+  Thread thread("le_coc_benchmark", Thread::Priority::NORMAL);
+  Handler handler(&thread);
+  BidiQueue<LeCreditBasedDataController::UpperEnqueue, LeCreditBasedDataController::UpperDequeue> channel_queue{10};
+  BenchmarkLink link;
+  BenchmarkScheduler scheduler;
+  LeCreditBasedDataController controller{&link, kCid, kCid, channel_queue.GetDownEnd(), &handler, &scheduler};
+  controller.SetMtu(kSduSize);
+  controller.SetMps(kMps);
+  const uint16_t credits_per_batch = state.range(0);
+  controller.OnCredit(credits_per_batch);
+  std::vector<uint8_t> payload(kSduSize, 0xa5);
+  std::vector<uint8_t> bytes;
+  bytes.reserve(kMps + 4);
+  int sent_in_batch = 0;
+  size_t max_ready = 0;
+  for (auto _ : state) {
+    if (controller.IsReadyForSdu()) {
+      controller.OnSdu(std::make_unique<bluetooth::packet::RawBuilder>(payload));
+    }
+    max_ready = std::max(max_ready, static_cast<size_t>(scheduler.ready_));
+    while (scheduler.ready_ > 0) {
+      scheduler.ready_--;
+      bytes.clear();
+      BitInserter inserter(bytes);
+      controller.GetNextPacket()->Serialize(inserter);
+      benchmark::DoNotOptimize(bytes.data());
+      if (++sent_in_batch == credits_per_batch) {
+        sent_in_batch = 0;
+        controller.OnCredit(credits_per_batch);
+      }
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kSduSize);
+  state.counters["max_ready_pdus"] = max_ready;
+  handler.Clear();
+}
+
+// Peers return credits one by one, or in batches of a few SDUs
+BENCHMARK(BM_LeCreditBasedTransmit)->Arg(1)->Arg(5)->Arg(20);
+
+}  // namespace
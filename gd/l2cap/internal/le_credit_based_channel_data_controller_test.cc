@@ -121,6 +121,31 @@ TEST_F(LeCreditBasedDataControllerTest, transmit_segmented) {
   EXPECT_EQ(data, "cd");
 }
 
+TEST_F(LeCreditBasedDataControllerTest, transmit_waits_for_credits) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  LeCreditBasedDataController controller{&link, 0x41, 0x41, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  controller.OnCredit(1);
+  controller.SetMps(4);
+  EXPECT_TRUE(controller.IsReadyForSdu());
+  // Two segments, only the first of which can be sent
+  EXPECT_CALL(scheduler, OnPacketsReady(0x41, 1));
+  controller.OnSdu(CreateSdu({'a', 'b', 'c', 'd'}));
+  EXPECT_FALSE(controller.IsReadyForSdu());
+  ::testing::Mock::VerifyAndClearExpectations(&scheduler);
+
+  EXPECT_CALL(scheduler, OnPacketsReady(0x41, 1));
+  controller.OnCredit(2);
+  EXPECT_TRUE(controller.IsReadyForSdu());
+  ::testing::Mock::VerifyAndClearExpectations(&scheduler);
+
+  // One credit is left for the next SDU
+  EXPECT_CALL(scheduler, OnPacketsReady(0x41, 1));
+  controller.OnSdu(CreateSdu({'e', 'f', 'g', 'h'}));
+  EXPECT_FALSE(controller.IsReadyForSdu());
+}
+
 TEST_F(LeCreditBasedDataControllerTest, receive_unsegmented) {
   common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
   testing::MockScheduler scheduler;
@@ -160,6 +185,44 @@ TEST_F(LeCreditBasedDataControllerTest, receive_segmented) {
   EXPECT_EQ(data, "abcdefg");
 }
 
+TEST_F(LeCreditBasedDataControllerTest, transmit_continuation_segments_use_whole_mps) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  LeCreditBasedDataController controller{&link, 0x41, 0x41, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  controller.OnCredit(10);
+  controller.SetMps(4);
+  EXPECT_CALL(scheduler, OnPacketsReady(0x41, 2));
+  // Should be divided into 'ab', and 'cdef'
+  controller.OnSdu(CreateSdu({'a', 'b', 'c', 'd', 'e', 'f'}));
+  auto view = GetPacketView(controller.GetNextPacket());
+  auto first_le_info_view = FirstLeInformationFrameView::Create(BasicFrameView::Create(view));
+  EXPECT_TRUE(first_le_info_view.IsValid());
+  auto payload = first_le_info_view.GetPayload();
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "ab");
+
+  view = GetPacketView(controller.GetNextPacket());
+  auto pdu_view = BasicFrameView::Create(view);
+  EXPECT_TRUE(pdu_view.IsValid());
+  payload = pdu_view.GetPayload();
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "cdef");
+}
+
+TEST_F(LeCreditBasedDataControllerTest, receive_returns_credits_in_bulk) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  LeCreditBasedDataController controller{&link, 0x41, 0x41, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  controller.OnCredit(10);
+  controller.SetInitialCredit(10);
+  EXPECT_CALL(link, SendLeCredit(0x41, 5)).Times(1);
+  for (int i = 0; i < 9; i++) {
+    auto builder = FirstLeInformationFrameBuilder::Create(0x41, 1, CreateSdu({'a'}));
+    controller.OnPdu(GetPacketView(std::move(builder)));
+  }
+  sync_handler(queue_handler_);
+}
+
 TEST_F(LeCreditBasedDataControllerTest, receive_segmented_with_wrong_sdu_length) {
   common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
   testing::MockScheduler scheduler;
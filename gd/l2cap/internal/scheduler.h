@@ -54,6 +54,18 @@ class Scheduler {
    */
   virtual void OnPacketsReady(Cid cid, int number_packets) {}
 
+  /**
+   * Callback from the data pipeline manager to indicate that the channel is detached, so its pending packets are
+   * dropped
+   */
+  virtual void OnChannelDetached(Cid cid) {}
+
+  /**
+   * Set the share of the link a dynamic channel gets relative to the other dynamic channels, for schedulers that
+   * support it
+   */
+  virtual void SetChannelWeight(Cid cid, int weight) {}
+
   virtual ~Scheduler() = default;
 };
 
@@ -0,0 +1,330 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/bidi_queue.h"
+#include "common/bind.h"
+#include "l2cap/cid.h"
+#include "l2cap/classic/internal/channel_configuration_state.h"
+#include "l2cap/internal/channel_impl.h"
+#include "l2cap/internal/data_pipeline_manager.h"
+#include "l2cap/internal/ilink.h"
+#include "l2cap/l2cap_packets.h"
+#include "os/handler.h"
+#include "os/queue.h"
+#include "os/repeating_alarm.h"
+#include "os/thread.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+using ::bluetooth::common::BidiQueue;
+using ::bluetooth::common::BidiQueueEnd;
+using ::bluetooth::common::Bind;
+using ::bluetooth::common::BindOnce;
+using ::bluetooth::common::Unretained;
+using ::bluetooth::l2cap::BasicFrameBuilder;
+using ::bluetooth::l2cap::BasicFrameView;
+using ::bluetooth::l2cap::Cid;
+using ::bluetooth::l2cap::EnhancedInformationFrameView;
+using ::bluetooth::l2cap::EnhancedSupervisoryFrameBuilder;
+using ::bluetooth::l2cap::FcsType;
+using ::bluetooth::l2cap::Final;
+using ::bluetooth::l2cap::kLeAttributeCid;
+using ::bluetooth::l2cap::Poll;
+using ::bluetooth::l2cap::RetransmissionAndFlowControlConfigurationOption;
+using ::bluetooth::l2cap::RetransmissionAndFlowControlModeOption;
+using ::bluetooth::l2cap::StandardFrameView;
+using ::bluetooth::l2cap::SupervisoryFunction;
+using ::bluetooth::l2cap::classic::internal::ChannelConfigurationState;
+using ::bluetooth::l2cap::internal::ChannelImpl;
+using ::bluetooth::l2cap::internal::DataPipelineManager;
+using ::bluetooth::l2cap::internal::ILink;
+using ::bluetooth::os::EnqueueBuffer;
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::RepeatingAlarm;
+using ::bluetooth::os::Thread;
+using ::bluetooth::packet::BasePacketBuilder;
+using PacketViewLe = ::bluetooth::packet::PacketView<::bluetooth::packet::kLittleEndian>;
+
+namespace {
+
+constexpr Cid kErtmCid = 0x40;
+// The controller sends this many L2CAP packets over the air every slot
+constexpr int kPacketsPerSlot = 2;
+constexpr std::chrono::milliseconds kSlot(1);
+// Segmented into several I-frames, which become ready at once
+constexpr size_t kErtmSduSize = 8000;
+constexpr size_t kAttPduSize = 23;
+constexpr uint8_t kMaxTxSeq = 64;
+constexpr uint8_t kTxWindow = 63;
+constexpr uint64_t kRoundTripsPerIteration = 20;
+
+class BenchmarkLink : public ILink {
+ public:
+  void SendDisconnectionRequest(Cid local_cid, Cid remote_cid) override {}
+  bluetooth::hci::AddressWithType GetDevice() const override {
+    return bluetooth::hci::AddressWithType();
+  }
+  void SendLeCredit(Cid local_cid, uint16_t credit) override {}
+};
+
+class BenchmarkChannel : public ChannelImpl {
+ public:
+  explicit BenchmarkChannel(Cid cid) : cid_(cid) {}
+
+  BidiQueueEnd<BasePacketBuilder, PacketViewLe>* GetQueueUpEnd() override {
+    return queue_.GetUpEnd();
+  }
+
+  BidiQueueEnd<PacketViewLe, BasePacketBuilder>* GetQueueDownEnd() override {
+    return queue_.GetDownEnd();
+  }
+
+  Cid GetCid() const override {
+    return cid_;
+  }
+
+  Cid GetRemoteCid() const override {
+    return cid_;
+  }
+
+ private:
+  Cid cid_;
+  BidiQueue<PacketViewLe, BasePacketBuilder> queue_{10};
+};
+
+PacketViewLe GetPacketView(std::unique_ptr<BasePacketBuilder> packet) {
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  bluetooth::packet::BitInserter inserter(*bytes);
+  bytes->reserve(packet->size());
+  packet->Serialize(inserter);
+  return PacketViewLe(bytes);
+}
+
+std::unique_ptr<BasePacketBuilder> CreateSdu(size_t size, uint8_t value) {
+  auto sdu = std::make_unique<bluetooth::packet::RawBuilder>();
+  sdu->AddOctets(std::vector<uint8_t>(size, value));
+  return sdu;
+}
+
+// A window wider than the link queue, as configured for throughput, so I-frames wait in the scheduler
+ChannelConfigurationState GetErtmConfiguration() {
+  ChannelConfigurationState config;
+  config.retransmission_and_flow_control_mode_ = RetransmissionAndFlowControlModeOption::ENHANCED_RETRANSMISSION;
+  RetransmissionAndFlowControlConfigurationOption option;
+  option.mode_ = RetransmissionAndFlowControlModeOption::ENHANCED_RETRANSMISSION;
+  option.tx_window_size_ = kTxWindow;
+  option.max_transmit_ = 20;
+  option.retransmission_time_out_ = 2000;
+  option.monitor_time_out_ = 12000;
+  option.maximum_pdu_size_ = 1010;
+  config.local_retransmission_and_flow_control_ = option;
+  config.remote_retransmission_and_flow_control_ = option;
+  config.fcs_type_ = FcsType::NO_FCS;
+  return config;
+}
+
+// An ERTM channel keeps its queue full while an ATT client sends one request at a time. The controller drains the
+// link queue at a fixed air rate, and the peer acknowledges every I-frame and answers every ATT request right away.
+class BM_L2capScheduler : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    thread_ = std::make_unique<Thread>("l2cap_scheduler_benchmark", Thread::Priority::NORMAL);
+    handler_ = std::make_unique<Handler>(thread_.get());
+    link_queue_ = std::make_unique<BidiQueue<PacketViewLe, BasePacketBuilder>>(10);
+    target_ = 0;
+    done_ = nullptr;
+    round_trips_ = 0;
+    latency_sum_us_ = 0;
+    latency_max_us_ = 0;
+    auto scheduler_type = static_cast<DataPipelineManager::SchedulerType>(st.range(0));
+    run_on_handler(BindOnce(&BM_L2capScheduler::start, Unretained(this), scheduler_type));
+  }
+
+  void TearDown(State& st) override {
+    run_on_handler(BindOnce(&BM_L2capScheduler::stop, Unretained(this)));
+    handler_->Clear();
+    handler_ = nullptr;
+    thread_ = nullptr;
+    link_queue_ = nullptr;
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  void run_on_handler(bluetooth::common::OnceClosure task) {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_->Post(BindOnce(
+        [](bluetooth::common::OnceClosure task, std::promise<void>* promise) {
+          std::move(task).Run();
+          promise->set_value();
+        },
+        std::move(task),
+        Unretained(&promise)));
+    future.wait();
+  }
+
+  void start(DataPipelineManager::SchedulerType scheduler_type) {
+    data_pipeline_manager_ =
+        std::make_unique<DataPipelineManager>(handler_.get(), &link_, link_queue_->GetUpEnd(), scheduler_type);
+    peer_enqueue_buffer_ = std::make_unique<EnqueueBuffer<PacketViewLe>>(link_queue_->GetDownEnd());
+    air_ = std::make_unique<RepeatingAlarm>(handler_.get());
+    air_->Schedule(Bind(&BM_L2capScheduler::on_slot, Unretained(this)), kSlot);
+
+    ertm_channel_ = std::make_shared<BenchmarkChannel>(kErtmCid);
+    data_pipeline_manager_->AttachChannel(kErtmCid, ertm_channel_, DataPipelineManager::ChannelMode::BASIC);
+    data_pipeline_manager_->UpdateClassicConfiguration(kErtmCid, GetErtmConfiguration());
+    ertm_channel_->GetQueueUpEnd()->RegisterEnqueue(
+        handler_.get(), Bind(&CreateSdu, kErtmSduSize, static_cast<uint8_t>(0xe0)));
+
+    att_channel_ = std::make_shared<BenchmarkChannel>(kLeAttributeCid);
+    data_pipeline_manager_->AttachChannel(kLeAttributeCid, att_channel_, DataPipelineManager::ChannelMode::BASIC);
+    att_enqueue_buffer_ = std::make_unique<EnqueueBuffer<BasePacketBuilder>>(att_channel_->GetQueueUpEnd());
+    att_channel_->GetQueueUpEnd()->RegisterDequeue(handler_.get(),
+                                                   Bind(&BM_L2capScheduler::on_att_response, Unretained(this)));
+    send_att_request();
+  }
+
+  void stop() {
+    air_->Cancel();
+    air_ = nullptr;
+    ertm_channel_->GetQueueUpEnd()->UnregisterEnqueue();
+    att_channel_->GetQueueUpEnd()->UnregisterDequeue();
+    att_enqueue_buffer_ = nullptr;
+    peer_enqueue_buffer_ = nullptr;
+    data_pipeline_manager_->DetachChannel(kErtmCid);
+    data_pipeline_manager_->DetachChannel(kLeAttributeCid);
+    data_pipeline_manager_ = nullptr;
+    ertm_channel_ = nullptr;
+    att_channel_ = nullptr;
+  }
+
+  void send_att_request() {
+    att_request_time_ = std::chrono::steady_clock::now();
+    att_enqueue_buffer_->Enqueue(CreateSdu(kAttPduSize, 0x0a), handler_.get());
+  }
+
+  void on_att_response() {
+    auto response = att_channel_->GetQueueUpEnd()->TryDequeue();
+    ASSERT(response != nullptr);
+    auto latency =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - att_request_time_);
+    round_trips_++;
+    latency_sum_us_ += latency.count();
+    latency_max_us_ = std::max<uint64_t>(latency_max_us_, latency.count());
+    if (done_ != nullptr && round_trips_ >= target_) {
+      done_->set_value();
+      done_ = nullptr;
+    }
+    send_att_request();
+  }
+
+  // The peer acknowledges I-frames one by one and answers ATT requests with a PDU of the same size
+  void on_slot() {
+    for (int i = 0; i < kPacketsPerSlot; i++) {
+      auto packet = link_queue_->GetDownEnd()->TryDequeue();
+      if (packet == nullptr) {
+        return;
+      }
+      auto basic_frame_view = BasicFrameView::Create(GetPacketView(std::move(packet)));
+      ASSERT(basic_frame_view.IsValid());
+      if (basic_frame_view.GetChannelId() == kLeAttributeCid) {
+        auto response = BasicFrameBuilder::Create(kLeAttributeCid, CreateSdu(kAttPduSize, 0x0b));
+        peer_enqueue_buffer_->Enqueue(std::make_unique<PacketViewLe>(GetPacketView(std::move(response))),
+                                      handler_.get());
+        continue;
+      }
+      auto i_frame_view = EnhancedInformationFrameView::Create(StandardFrameView::Create(basic_frame_view));
+      if (!i_frame_view.IsValid()) {
+        continue;
+      }
+      auto ack = EnhancedSupervisoryFrameBuilder::Create(kErtmCid, SupervisoryFunction::RECEIVER_READY, Poll::NOT_SET,
+                                                         Final::NOT_SET, (i_frame_view.GetTxSeq() + 1) % kMaxTxSeq);
+      peer_enqueue_buffer_->Enqueue(std::make_unique<PacketViewLe>(GetPacketView(std::move(ack))), handler_.get());
+    }
+  }
+
+  void wait_for_round_trips(std::promise<void>* done) {
+    target_ = round_trips_ + kRoundTripsPerIteration;
+    done_ = done;
+  }
+
+  void read_stats(uint64_t* round_trips, uint64_t* latency_sum_us, uint64_t* latency_max_us) {
+    *round_trips = round_trips_;
+    *latency_sum_us = latency_sum_us_;
+    *latency_max_us = latency_max_us_;
+  }
+
+  void WaitForNextRoundTrips() {
+    std::promise<void> done;
+    auto future = done.get_future();
+    run_on_handler(BindOnce(&BM_L2capScheduler::wait_for_round_trips, Unretained(this), Unretained(&done)));
+    future.wait();
+  }
+
+  void ReportAttLatency(State& state) {
+    uint64_t round_trips = 0;
+    uint64_t latency_sum_us = 0;
+    uint64_t latency_max_us = 0;
+    run_on_handler(BindOnce(&BM_L2capScheduler::read_stats, Unretained(this), Unretained(&round_trips),
+                            Unretained(&latency_sum_us), Unretained(&latency_max_us)));
+    state.counters["att_round_trips"] = round_trips;
+    state.counters["att_latency_mean_us"] = round_trips == 0 ? 0 : latency_sum_us / round_trips;
+    state.counters["att_latency_max_us"] = latency_max_us;
+  }
+
+  std::unique_ptr<Thread> thread_;
+  std::unique_ptr<Handler> handler_;
+  std::unique_ptr<BidiQueue<PacketViewLe, BasePacketBuilder>> link_queue_;
+  BenchmarkLink link_;
+
+  // Accessed on the handler thread only
+  std::unique_ptr<DataPipelineManager> data_pipeline_manager_;
+  std::unique_ptr<RepeatingAlarm> air_;
+  std::unique_ptr<EnqueueBuffer<PacketViewLe>> peer_enqueue_buffer_;
+  std::shared_ptr<BenchmarkChannel> ertm_channel_;
+  std::shared_ptr<BenchmarkChannel> att_channel_;
+  std::unique_ptr<EnqueueBuffer<BasePacketBuilder>> att_enqueue_buffer_;
+  uint64_t target_;
+  std::promise<void>* done_;
+  std::chrono::steady_clock::time_point att_request_time_;
+  uint64_t round_trips_;
+  uint64_t latency_sum_us_;
+  uint64_t latency_max_us_;
+};
+
+BENCHMARK_DEFINE_F(BM_L2capScheduler, att_under_saturated_ertm)(State& state) {
+  for (auto _ : state) {
+    WaitForNextRoundTrips();
+  }
+  state.SetItemsProcessed(state.iterations() * kRoundTripsPerIteration);
+  ReportAttLatency(state);
+}
+
+BENCHMARK_REGISTER_F(BM_L2capScheduler, att_under_saturated_ertm)
+    ->Arg(static_cast<int>(DataPipelineManager::SchedulerType::FIFO))
+    ->Arg(static_cast<int>(DataPipelineManager::SchedulerType::PRIORITY))
+    ->Iterations(8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/internal/scheduler_priority.h"
+
+#include "l2cap/internal/data_pipeline_manager.h"
+#include "l2cap/l2cap_packets.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+PriorityScheduler::PriorityScheduler(DataPipelineManager* data_pipeline_manager, LowerQueueUpEnd* link_queue_up_end,
+                                     os::Handler* handler)
+    : data_pipeline_manager_(data_pipeline_manager), link_queue_up_end_(link_queue_up_end), handler_(handler) {
+  ASSERT(link_queue_up_end_ != nullptr && handler_ != nullptr);
+}
+
+// Invoked from some external Handler context
+PriorityScheduler::~PriorityScheduler() {
+  try_unregister_link_queue_enqueue();
+}
+
+int PriorityScheduler::GetFixedChannelPriority(Cid cid) {
+  switch (cid) {
+    case kClassicSignallingCid:
+    case kLeSignallingCid:
+      return 0;
+    case kLeAttributeCid:
+      return 1;
+    case kSmpCid:
+    case kSmpBrCid:
+      return 2;
+    default:
+      return 3;
+  }
+}
+
+// Invoked within L2CAP Handler context
+void PriorityScheduler::OnPacketsReady(Cid cid, int number_packets) {
+  if (number_packets == 0) {
+    return;
+  }
+  if (cid <= kLastFixedChannel) {
+    fixed_channels_[std::make_pair(GetFixedChannelPriority(cid), cid)] += number_packets;
+  } else {
+    auto& channel = dynamic_channels_[cid];
+    if (channel.pending_packets_ == 0) {
+      active_dynamic_channels_.push_back(cid);
+    }
+    channel.pending_packets_ += number_packets;
+  }
+  try_register_link_queue_enqueue();
+}
+
+// Invoked within L2CAP Handler context
+void PriorityScheduler::OnChannelDetached(Cid cid) {
+  if (cid <= kLastFixedChannel) {
+    fixed_channels_.erase(std::make_pair(GetFixedChannelPriority(cid), cid));
+  } else {
+    dynamic_channels_.erase(cid);
+    active_dynamic_channels_.remove(cid);
+  }
+  if (fixed_channels_.empty() && active_dynamic_channels_.empty()) {
+    try_unregister_link_queue_enqueue();
+  }
+}
+
+// Invoked within L2CAP Handler context
+void PriorityScheduler::SetChannelWeight(Cid cid, int weight) {
+  ASSERT(cid >= kFirstDynamicChannel);
+  ASSERT(weight > 0);
+  dynamic_channels_[cid].weight_ = weight;
+}
+
+Cid PriorityScheduler::select_next_channel() {
+  if (!fixed_channels_.empty()) {
+    auto highest = fixed_channels_.begin();
+    Cid cid = highest->first.second;
+    if (--highest->second == 0) {
+      fixed_channels_.erase(highest);
+    }
+    return cid;
+  }
+  ASSERT(!active_dynamic_channels_.empty());
+  Cid cid = active_dynamic_channels_.front();
+  auto& channel = dynamic_channels_[cid];
+  if (channel.remaining_turn_ == 0) {
+    channel.remaining_turn_ = channel.weight_;
+  }
+  channel.pending_packets_--;
+  channel.remaining_turn_--;
+  if (channel.pending_packets_ == 0) {
+    // An idle channel doesn't keep the rest of its turn
+    channel.remaining_turn_ = 0;
+    active_dynamic_channels_.pop_front();
+  } else if (channel.remaining_turn_ == 0) {
+    active_dynamic_channels_.splice(active_dynamic_channels_.end(), active_dynamic_channels_,
+                                    active_dynamic_channels_.begin());
+  }
+  return cid;
+}
+
+// Invoked from some external Queue Reactable context
+std::unique_ptr<PriorityScheduler::LowerEnqueue> PriorityScheduler::link_queue_enqueue_callback() {
+  ASSERT(!fixed_channels_.empty() || !active_dynamic_channels_.empty());
+  auto channel_id = select_next_channel();
+  auto packet = data_pipeline_manager_->GetDataController(channel_id)->GetNextPacket();
+
+  data_pipeline_manager_->OnPacketSent(channel_id);
+  if (fixed_channels_.empty() && active_dynamic_channels_.empty()) {
+    try_unregister_link_queue_enqueue();
+  }
+  return packet;
+}
+
+void PriorityScheduler::try_register_link_queue_enqueue() {
+  if (link_queue_enqueue_registered_.exchange(true)) {
+    return;
+  }
+  link_queue_up_end_->RegisterEnqueue(
+      handler_, common::Bind(&PriorityScheduler::link_queue_enqueue_callback, common::Unretained(this)));
+}
+
+void PriorityScheduler::try_unregister_link_queue_enqueue() {
+  if (link_queue_enqueue_registered_.exchange(false)) {
+    link_queue_up_end_->UnregisterEnqueue();
+  }
+}
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "common/bidi_queue.h"
+#include "common/bind.h"
+#include "l2cap/cid.h"
+#include "l2cap/internal/scheduler.h"
+#include "os/handler.h"
+#include "os/queue.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+class DataPipelineManager;
+
+/**
+ * Serves fixed channels in strict priority (signalling, then ATT, then SMP, then the other fixed channels) ahead of
+ * dynamic channels, so control traffic doesn't wait behind bulk data. Dynamic channels share what is left in weighted
+ * round robin: each turn a channel sends up to its weight in packets.
+ */
+class PriorityScheduler : public Scheduler {
+ public:
+  PriorityScheduler(DataPipelineManager* data_pipeline_manager, LowerQueueUpEnd* link_queue_up_end,
+                    os::Handler* handler);
+  ~PriorityScheduler() override;
+  void OnPacketsReady(Cid cid, int number_packets) override;
+  void OnChannelDetached(Cid cid) override;
+  void SetChannelWeight(Cid cid, int weight) override;
+
+  // Lower value is served first
+  static int GetFixedChannelPriority(Cid cid);
+
+ private:
+  struct DynamicChannel {
+    int pending_packets_ = 0;
+    int weight_ = 1;
+    int remaining_turn_ = 0;
+  };
+
+  DataPipelineManager* data_pipeline_manager_;
+  LowerQueueUpEnd* link_queue_up_end_;
+  os::Handler* handler_;
+  // Pending packets of fixed channels, keyed by (priority, cid)
+  std::map<std::pair<int, Cid>, int> fixed_channels_;
+  std::unordered_map<Cid, DynamicChannel> dynamic_channels_;
+  // Dynamic channels with pending packets, the front holds the current turn
+  std::list<Cid> active_dynamic_channels_;
+  std::atomic_bool link_queue_enqueue_registered_ = false;
+
+  Cid select_next_channel();
+  void try_register_link_queue_enqueue();
+  void try_unregister_link_queue_enqueue();
+  std::unique_ptr<LowerEnqueue> link_queue_enqueue_callback();
+};
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/internal/scheduler_priority.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <future>
+#include <map>
+#include <vector>
+
+#include "l2cap/internal/data_controller_mock.h"
+#include "l2cap/internal/data_pipeline_manager_mock.h"
+#include "os/handler.h"
+#include "os/queue.h"
+#include "os/thread.h"
+#include "packet/raw_builder.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+namespace {
+
+using ::testing::_;
+using ::testing::Invoke;
+
+PacketView<kLittleEndian> GetPacketView(std::unique_ptr<packet::BasePacketBuilder> packet) {
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  BitInserter i(*bytes);
+  bytes->reserve(packet->size());
+  packet->Serialize(i);
+  return packet::PacketView<packet::kLittleEndian>(bytes);
+}
+
+void sync_handler(os::Handler* handler) {
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  handler->Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)));
+  auto status = future.wait_for(std::chrono::milliseconds(300));
+  EXPECT_EQ(status, std::future_status::ready);
+}
+
+// Sends a basic frame carrying the cid of its channel each time it is asked
+class MyDataController : public testing::MockDataController {
+ public:
+  explicit MyDataController(Cid cid) : cid_(cid) {}
+
+  std::unique_ptr<BasePacketBuilder> GetNextPacket() override {
+    auto payload = std::make_unique<packet::RawBuilder>();
+    payload->AddOctets1(0x00);
+    return BasicFrameBuilder::Create(cid_, std::move(payload));
+  }
+
+ private:
+  Cid cid_;
+};
+
+class L2capSchedulerPriorityTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    thread_ = new os::Thread("test_thread", os::Thread::Priority::NORMAL);
+    queue_handler_ = new os::Handler(thread_);
+    mock_data_pipeline_manager_ =
+        new ::testing::NiceMock<testing::MockDataPipelineManager>(queue_handler_, link_queue_.GetUpEnd());
+    ON_CALL(*mock_data_pipeline_manager_, GetDataController(_)).WillByDefault(Invoke([this](Cid cid) {
+      auto data_controller = data_controllers_.find(cid);
+      if (data_controller == data_controllers_.end()) {
+        data_controller = data_controllers_.emplace(cid, std::make_unique<MyDataController>(cid)).first;
+      }
+      return data_controller->second.get();
+    }));
+    scheduler_ = new PriorityScheduler(mock_data_pipeline_manager_, link_queue_.GetUpEnd(), queue_handler_);
+  }
+
+  void TearDown() override {
+    delete scheduler_;
+    delete mock_data_pipeline_manager_;
+    queue_handler_->Clear();
+    delete queue_handler_;
+    delete thread_;
+  }
+
+  // Report all the packets at once, so the scheduler picks among them
+  void OnPacketsReady(std::vector<std::pair<Cid, int>> channels) {
+    queue_handler_->Post(common::BindOnce(
+        [](PriorityScheduler* scheduler, std::vector<std::pair<Cid, int>> channels) {
+          for (auto& channel : channels) {
+            scheduler->OnPacketsReady(channel.first, channel.second);
+          }
+        },
+        common::Unretained(scheduler_), std::move(channels)));
+    sync_handler(queue_handler_);
+  }
+
+  // Returns the channels of the packets sent to the link, waiting until there are count of them
+  std::vector<Cid> Dequeue(size_t count) {
+    std::vector<Cid> cids;
+    for (int attempt = 0; attempt < 100 && cids.size() < count; attempt++) {
+      sync_handler(queue_handler_);
+      while (auto packet = link_queue_.GetDownEnd()->TryDequeue()) {
+        auto basic_frame_view = BasicFrameView::Create(GetPacketView(std::move(packet)));
+        EXPECT_TRUE(basic_frame_view.IsValid());
+        cids.push_back(basic_frame_view.GetChannelId());
+      }
+    }
+    return cids;
+  }
+
+  os::Thread* thread_ = nullptr;
+  os::Handler* queue_handler_ = nullptr;
+  common::BidiQueue<Scheduler::LowerDequeue, Scheduler::LowerEnqueue> link_queue_{10};
+  ::testing::NiceMock<testing::MockDataPipelineManager>* mock_data_pipeline_manager_ = nullptr;
+  std::map<Cid, std::unique_ptr<MyDataController>> data_controllers_;
+  PriorityScheduler* scheduler_ = nullptr;
+};
+
+TEST_F(L2capSchedulerPriorityTest, send_packet) {
+  EXPECT_CALL(*mock_data_pipeline_manager_, OnPacketSent(kLeAttributeCid));
+  OnPacketsReady({{kLeAttributeCid, 1}});
+  EXPECT_EQ(Dequeue(1), std::vector<Cid>({kLeAttributeCid}));
+}
+
+TEST_F(L2capSchedulerPriorityTest, fixed_channels_in_priority_order) {
+  OnPacketsReady({{kConnectionlessCid, 1}, {kSmpCid, 1}, {kLeAttributeCid, 2}, {kLeSignallingCid, 1}});
+  EXPECT_EQ(Dequeue(5),
+            std::vector<Cid>({kLeSignallingCid, kLeAttributeCid, kLeAttributeCid, kSmpCid, kConnectionlessCid}));
+}
+
+TEST_F(L2capSchedulerPriorityTest, fixed_channel_before_dynamic_channel) {
+  OnPacketsReady({{0x40, 3}, {kClassicSignallingCid, 1}});
+  EXPECT_EQ(Dequeue(4), std::vector<Cid>({kClassicSignallingCid, 0x40, 0x40, 0x40}));
+}
+
+TEST_F(L2capSchedulerPriorityTest, round_robin_dynamic_channels) {
+  OnPacketsReady({{0x40, 3}, {0x41, 2}});
+  EXPECT_EQ(Dequeue(5), std::vector<Cid>({0x40, 0x41, 0x40, 0x41, 0x40}));
+}
+
+TEST_F(L2capSchedulerPriorityTest, share_turns_by_weight) {
+  scheduler_->SetChannelWeight(0x40, 2);
+  OnPacketsReady({{0x40, 4}, {0x41, 4}});
+  EXPECT_EQ(Dequeue(8), std::vector<Cid>({0x40, 0x40, 0x41, 0x40, 0x40, 0x41, 0x41, 0x41}));
+}
+
+TEST_F(L2capSchedulerPriorityTest, drop_packets_of_detached_channel) {
+  queue_handler_->Post(common::BindOnce(
+      [](PriorityScheduler* scheduler) {
+        scheduler->OnPacketsReady(0x40, 2);
+        scheduler->OnPacketsReady(0x41, 2);
+        scheduler->OnPacketsReady(kLeAttributeCid, 1);
+        scheduler->OnChannelDetached(0x40);
+        scheduler->OnChannelDetached(kLeAttributeCid);
+      },
+      common::Unretained(scheduler_)));
+  EXPECT_EQ(Dequeue(2), std::vector<Cid>({0x41, 0x41}));
+  EXPECT_TRUE(Dequeue(1).empty());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
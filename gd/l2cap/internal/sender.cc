@@ -61,7 +61,10 @@ Sender::~Sender() {
 }
 
 void Sender::OnPacketSent() {
-  try_register_dequeue();
+  // Once the data controller holds PDUs back, the last of them being sent resumes the dequeue
+  if (data_controller_->IsReadyForSdu()) {
+    try_register_dequeue();
+  }
 }
 
 std::unique_ptr<Sender::UpperDequeue> Sender::GetNextPacket() {
@@ -0,0 +1,123 @@
+#
+#   Copyright 2020 - The Android Open Source Project
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+
+import json
+import os
+from datetime import timedelta
+
+from acts import asserts
+from bluetooth_packets_python3 import RawBuilder
+from cert.closable import safeClose
+from cert.matchers import L2capMatchers
+from cert.performance_test_logger import PerformanceTestLogger
+from cert.py_rootcanal import PyRootCanal
+from cert.truth import assertThat
+from l2cap.le.cert.le_l2cap_test import LeL2capTestBase
+
+# Threads ticking the simulated devices in root-canal, overridden by the rootcanal_tick_workers user param
+DEFAULT_TICK_WORKERS = 4
+# How many simulated devices each scenario runs with, overridden by the scale_device_counts user param
+DEFAULT_DEVICE_COUNTS = [0, 10, 100, 250]
+BEACON_INTERVAL_MS = 100
+PACKETS = 100
+# An ATT-sized SDU, and the largest SDU a single frame carries, as the DUT counts the frame header in its MPS
+SDU_SIZES = [23, 245]
+MPS = 251
+
+
+class LeL2capScaleBenchmarkTest(LeL2capTestBase):
+    """
+    Measures LE credit based channel throughput between the DUT and the cert while a growing number of beacons
+    simulated by root-canal advertise around them. Run it on its own with
+    gd/cert/run --host LeL2capScaleBenchmarkTest; the results are logged and written to
+    le_l2cap_scale_benchmark.json in the test output directory.
+    """
+
+    def setup_class(self):
+        super().setup_class()
+        asserts.skip_if(self.rootcanal_test_port is None, "Simulated devices need root-canal")
+        device_counts = self.user_params.get('scale_device_counts', DEFAULT_DEVICE_COUNTS)
+        self.device_counts = [int(count) for count in device_counts]
+        self.tick_workers = int(self.user_params.get('rootcanal_tick_workers', DEFAULT_TICK_WORKERS))
+        self.results = {}
+
+    def teardown_class(self):
+        if self.results:
+            with open(os.path.join(self.log_path_base, 'le_l2cap_scale_benchmark.json'), 'w') as results_file:
+                json.dump(self.results, results_file, indent=2)
+        super().teardown_class()
+
+    def setup_test(self):
+        super().setup_test()
+        self.rootcanal = PyRootCanal(self.rootcanal_test_port)
+        self.rootcanal.set_tick_workers(self.tick_workers)
+        self.devices = []
+        self.performance_test_logger = PerformanceTestLogger()
+
+    def teardown_test(self):
+        for index in self.devices:
+            self.rootcanal.remove_device(index)
+        safeClose(self.rootcanal)
+        super().teardown_test()
+
+    def _add_beacons(self, count):
+        # Only added beyond the ones of earlier rounds
+        for i in range(len(self.devices), count):
+            address = "be:ac:00:01:%02x:%02x" % (i >> 8, i & 0xff)
+            index = self.rootcanal.add_device('beacon', address, BEACON_INTERVAL_MS)
+            self.rootcanal.add_device_to_phy(index, PyRootCanal.LOW_ENERGY_PHY)
+            self.devices.append(index)
+
+    def _record(self, scenario, label, duration):
+        bytes_per_second = PACKETS * int(label.split('/')[1]) / duration.total_seconds()
+        self.log.info("%s %s: %s, %d B/s" % (scenario, label, str(duration), bytes_per_second))
+        self.results.setdefault(scenario, {})[label] = bytes_per_second
+
+    def test_tx_throughput(self):
+        self._setup_link_from_cert()
+        (dut_channel, cert_channel) = self._open_channel_from_cert(mps=MPS, initial_credit=0)
+        for count in self.device_counts:
+            self._add_beacons(count)
+            for sdu_size in SDU_SIZES:
+                label = "%d/%d" % (count, sdu_size)
+                data = b'a' * sdu_size
+                self.performance_test_logger.start_interval(label)
+                cert_channel.send_credits(PACKETS)
+                for _ in range(PACKETS):
+                    dut_channel.send(data)
+                assertThat(cert_channel).emits(
+                    L2capMatchers.FirstLeIFrame(data, sdu_size=sdu_size),
+                    at_least_times=PACKETS,
+                    timeout=timedelta(seconds=60))
+                self.performance_test_logger.end_interval(label)
+                self._record('tx_bytes_per_second', label,
+                             self.performance_test_logger.get_duration_of_intervals(label)[0])
+
+    def test_rx_throughput(self):
+        self._setup_link_from_cert()
+        (dut_channel, cert_channel) = self._open_channel_from_cert(mps=MPS)
+        for count in self.device_counts:
+            self._add_beacons(count)
+            for sdu_size in SDU_SIZES:
+                label = "%d/%d" % (count, sdu_size)
+                data = b'a' * sdu_size
+                self.performance_test_logger.start_interval(label)
+                for _ in range(PACKETS):
+                    cert_channel.send_first_le_i_frame(sdu_size, RawBuilder([x for x in data]))
+                assertThat(dut_channel).emits(
+                    L2capMatchers.PacketPayloadRawData(data), at_least_times=PACKETS, timeout=timedelta(seconds=60))
+                self.performance_test_logger.end_interval(label)
+                self._record('rx_bytes_per_second', label,
+                             self.performance_test_logger.get_duration_of_intervals(label)[0])
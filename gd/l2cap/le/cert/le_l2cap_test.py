@@ -33,7 +33,7 @@ from l2cap.le.facade_pb2 import SecurityLevel
 SAMPLE_PACKET = bt_packets.RawBuilder([0x19, 0x26, 0x08, 0x17])
 
 
-class LeL2capTest(GdBaseTestClass):
+class LeL2capTestBase(GdBaseTestClass):
 
     def setup_class(self):
         super().setup_class(dut_module='L2CAP', cert_module='HCI_INTERFACES')
@@ -132,6 +132,9 @@ class LeL2capTest(GdBaseTestClass):
         cert_channel = self.cert_l2cap.open_fixed_channel(cid)
         return (dut_channel, cert_channel)
 
+
+class LeL2capTest(LeL2capTestBase):
+
     def test_fixed_channel_send(self):
         self.dut_l2cap.enable_fixed_channel(4)
         self._setup_link_from_cert()
@@ -17,6 +17,7 @@
 #include "l2cap/le/facade.h"
 
 #include "grpc/grpc_event_queue.h"
+#include "grpc/grpc_packet_bytes.h"
 #include "l2cap/le/dynamic_channel.h"
 #include "l2cap/le/dynamic_channel_manager.h"
 #include "l2cap/le/dynamic_channel_service.h"
@@ -199,11 +200,11 @@ class L2capLeModuleFacadeService : public L2capLeModuleFacade::Service {
 
     void on_incoming_packet() {
       auto packet = channel_->GetQueueUpEnd()->TryDequeue();
-      std::string data = std::string(packet->begin(), packet->end());
+      std::string data = ::bluetooth::grpc::PacketViewToBytes(*packet);
       L2capPacket l2cap_data;
       l2cap_data.set_psm(psm_);
-      l2cap_data.set_payload(data);
-      facade_service_->pending_l2cap_data_.OnIncomingEvent(l2cap_data);
+      l2cap_data.set_payload(std::move(data));
+      facade_service_->pending_l2cap_data_.OnIncomingEvent(std::move(l2cap_data));
     }
 
     bool SendPacket(std::vector<uint8_t> packet) {
@@ -349,11 +350,11 @@ class L2capLeModuleFacadeService : public L2capLeModuleFacade::Service {
 
     void on_incoming_packet() {
       auto packet = channel_->GetQueueUpEnd()->TryDequeue();
-      std::string data = std::string(packet->begin(), packet->end());
+      std::string data = ::bluetooth::grpc::PacketViewToBytes(*packet);
       L2capPacket l2cap_data;
       l2cap_data.set_fixed_cid(cid_);
-      l2cap_data.set_payload(data);
-      facade_service_->pending_l2cap_data_.OnIncomingEvent(l2cap_data);
+      l2cap_data.set_payload(std::move(data));
+      facade_service_->pending_l2cap_data_.OnIncomingEvent(std::move(l2cap_data));
     }
 
     bool SendPacket(std::vector<uint8_t> packet) {
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/hci_packets.h"
+#include "l2cap/l2cap_packets.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+using ::bluetooth::hci::AclPacketBuilder;
+using ::bluetooth::hci::BroadcastFlag;
+using ::bluetooth::hci::PacketBoundaryFlag;
+using ::bluetooth::l2cap::BasicFrameBuilder;
+using ::bluetooth::l2cap::ConnectionRequestBuilder;
+using ::bluetooth::l2cap::EnhancedInformationFrameWithFcsBuilder;
+using ::bluetooth::l2cap::Final;
+using ::bluetooth::l2cap::SegmentationAndReassembly;
+using ::bluetooth::packet::BasePacketBuilder;
+using ::bluetooth::packet::BitInserter;
+using ::bluetooth::packet::RawBuilder;
+
+namespace {
+
+constexpr uint16_t kHandle = 0x0042;
+constexpr uint16_t kChannelId = 0x0040;
+constexpr uint16_t kSignallingChannelId = 0x0001;
+
+std::unique_ptr<RawBuilder> MakePayload(size_t size) {
+  std::vector<uint8_t> payload(size);
+  for (size_t i = 0; i < payload.size(); i++) {
+    payload[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return std::make_unique<RawBuilder>(std::move(payload));
+}
+
+std::unique_ptr<BasePacketBuilder> MakeAcl(std::unique_ptr<BasePacketBuilder> l2cap) {
+  return AclPacketBuilder::Create(kHandle, PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE,
+                                  BroadcastFlag::POINT_TO_POINT, std::move(l2cap));
+}
+
+// Serializes |acl| to a new vector, as HciLayer does for each packet sent to the HAL
+void SerializePackets(State& state, const BasePacketBuilder& acl) {
+  for (auto _ : state) {
+    std::vector<uint8_t> bytes;
+    BitInserter it(bytes);
+    acl.Serialize(it);
+    benchmark::DoNotOptimize(bytes.data());
+  }
+  state.SetBytesProcessed(state.iterations() * acl.size());
+}
+
+// A basic mode frame: the headers are a few scalar fields, the payload is written in bulk
+void BM_AclBasicFrameSerialize(State& state) {
+  auto acl = MakeAcl(BasicFrameBuilder::Create(kChannelId, MakePayload(state.range(0))));
+  SerializePackets(state, *acl);
+}
+
+// An ERTM frame: the FCS observer sees every byte, so nothing is written in bulk
+void BM_AclEnhancedInformationFrameWithFcsSerialize(State& state) {
+  auto acl = MakeAcl(EnhancedInformationFrameWithFcsBuilder::Create(
+      kChannelId, 1, Final::NOT_SET, 0, SegmentationAndReassembly::UNSEGMENTED, MakePayload(state.range(0))));
+  SerializePackets(state, *acl);
+}
+
+// A signalling command, four levels of builders around a handful of bytes
+void BM_AclSignallingSerialize(State& state) {
+  auto acl =
+      MakeAcl(BasicFrameBuilder::Create(kSignallingChannelId, ConnectionRequestBuilder::Create(1, 0x0019, 0x0041)));
+  SerializePackets(state, *acl);
+}
+
+// Payloads of a default LE data length, an extended LE data length and a 3-DH5 baseband packet
+BENCHMARK(BM_AclBasicFrameSerialize)->Arg(23)->Arg(247)->Arg(1017);
+BENCHMARK(BM_AclEnhancedInformationFrameWithFcsSerialize)->Arg(23)->Arg(247)->Arg(1017);
+BENCHMARK(BM_AclSignallingSerialize);
+
+}  // namespace
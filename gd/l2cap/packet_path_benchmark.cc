@@ -0,0 +1,1080 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// End to end benchmarks of the packet path between the HAL and the channels a profile sees, through the real
+// HciLayer, AclManager and L2CAP classic and LE modules. A fake behind the HAL plays both the controller and the
+// remote device: it connects a classic and an LE link, opens a dynamic channel on each, answers the signalling and
+// returns ACL credits as soon as a packet is sent.
+//
+// The BM_Shim benchmarks run the classic dynamic channel path again through shim::L2cap, the bridge the legacy stack
+// uses, to compare with the channel used directly.
+//
+// Each benchmark reports the throughput and the p50/p99 latency of a packet going through the path in one direction.
+// For dashboards, run with --benchmark_format=json, or --benchmark_out=<file> --benchmark_out_format=json.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/bind.h"
+#include "hal/hci_hal.h"
+#include "hci/acl_manager.h"
+#include "hci/address.h"
+#include "hci/controller.h"
+#include "hci/hci_packets.h"
+#include "l2cap/cid.h"
+#include "l2cap/classic/dynamic_channel_manager.h"
+#include "l2cap/classic/fixed_channel_manager.h"
+#include "l2cap/classic/l2cap_classic_module.h"
+#include "l2cap/l2cap_packets.h"
+#include "l2cap/le/dynamic_channel_manager.h"
+#include "l2cap/le/fixed_channel_manager.h"
+#include "l2cap/le/l2cap_le_module.h"
+#include "l2cap/psm.h"
+#include "module.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+#include "shim/l2cap.h"
+
+using ::benchmark::State;
+using ::bluetooth::TestModuleRegistry;
+using ::bluetooth::hci::Address;
+using ::bluetooth::hci::AddressType;
+using ::bluetooth::hci::AddressWithType;
+using ::bluetooth::hci::ErrorCode;
+using ::bluetooth::hci::OpCode;
+using ::bluetooth::l2cap::Cid;
+using ::bluetooth::l2cap::Psm;
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::Thread;
+using ::bluetooth::packet::BasePacketBuilder;
+using ::bluetooth::packet::BitInserter;
+using ::bluetooth::packet::kLittleEndian;
+using ::bluetooth::packet::PacketView;
+using ::bluetooth::packet::RawBuilder;
+
+namespace classic = ::bluetooth::l2cap::classic;
+namespace hal = ::bluetooth::hal;
+namespace hci = ::bluetooth::hci;
+namespace l2cap = ::bluetooth::l2cap;
+namespace le = ::bluetooth::l2cap::le;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class ChannelKind {
+  CLASSIC_FIXED,
+  CLASSIC_DYNAMIC,
+  LE_FIXED,
+  LE_DYNAMIC,
+  // A classic dynamic channel of its own, through shim::L2cap
+  SHIM_CLASSIC_DYNAMIC,
+};
+
+constexpr uint16_t kClassicHandle = 0x0001;
+constexpr uint16_t kLeHandle = 0x0002;
+constexpr uint16_t kAclPacketLength = 1021;
+constexpr uint16_t kLeAclPacketLength = 251;
+constexpr uint16_t kAclBuffers = 8;
+
+constexpr Cid kClassicFixedCid = l2cap::kSmpBrCid;
+constexpr Cid kLeFixedCid = l2cap::kLeAttributeCid;
+constexpr Psm kClassicPsm = 0x1001;
+constexpr Psm kLePsm = 0x0081;
+// The shim asks for an encrypted transport on all its channels but SDP ones, and the benchmark links are not encrypted
+constexpr uint16_t kShimPsm = 0x0001;
+constexpr uint16_t kShimMtu = 672;
+constexpr l2cap::Mtu kLeMtu = 512;
+// The channels of the remote device
+constexpr Cid kRemoteClassicCid = 0x0040;
+constexpr Cid kRemoteLeCid = 0x0041;
+constexpr Cid kRemoteShimCid = 0x0042;
+constexpr uint16_t kRemoteLeMps = 251;
+constexpr uint16_t kRemoteLeCredits = 0xffff;
+
+constexpr size_t kAttPacketSize = 23;
+// Packets of a burst share the links, as a profile streaming or a GATT client writing without response does
+constexpr size_t kBurstSize = 64;
+// Injected packets the remote may have in flight on the way to the channel
+constexpr size_t kReceiveWindow = 8;
+constexpr std::chrono::seconds kSetupTimeout(5);
+
+const Address kLocalAddress({0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+const Address kRemoteAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+
+std::vector<uint8_t> Serialize(std::unique_ptr<BasePacketBuilder> builder) {
+  std::vector<uint8_t> bytes;
+  BitInserter inserter(bytes);
+  builder->Serialize(inserter);
+  return bytes;
+}
+
+// The commands HciLayer expects a Command Status for, among those this benchmark leads the stack to send
+bool IsCommandWithStatus(OpCode op_code) {
+  switch (op_code) {
+    case OpCode::ACCEPT_CONNECTION_REQUEST:
+    case OpCode::CREATE_CONNECTION:
+    case OpCode::DISCONNECT:
+    case OpCode::LE_CONNECTION_UPDATE:
+    case OpCode::LE_CREATE_CONNECTION:
+    case OpCode::LE_EXTENDED_CREATE_CONNECTION:
+    case OpCode::LE_READ_REMOTE_FEATURES:
+    case OpCode::READ_CLOCK_OFFSET:
+    case OpCode::READ_REMOTE_EXTENDED_FEATURES:
+    case OpCode::READ_REMOTE_SUPPORTED_FEATURES:
+    case OpCode::READ_REMOTE_VERSION_INFORMATION:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Grants the ACL buffers and reports the packets the fake remote device completes, without the command exchange of
+// the real controller start up
+class FakeController : public hci::Controller {
+ public:
+  void RegisterCompletedAclPacketsCallback(hci::Controller::CompletedAclPacketsCallback cb) override {
+    acl_cb_ = cb;
+  }
+
+  void UnregisterCompletedAclPacketsCallback() override {
+    acl_cb_ = {};
+  }
+
+  uint16_t GetAclPacketLength() const override {
+    return kAclPacketLength;
+  }
+
+  uint16_t GetNumAclPacketBuffers() const override {
+    return kAclBuffers;
+  }
+
+  hci::LeBufferSize GetLeBufferSize() const override {
+    hci::LeBufferSize le_buffer_size;
+    le_buffer_size.le_data_packet_length_ = kLeAclPacketLength;
+    le_buffer_size.total_num_le_packets_ = kAclBuffers;
+    return le_buffer_size;
+  }
+
+  Address GetMacAddress() const override {
+    return kLocalAddress;
+  }
+
+  uint8_t GetLeConnectListSize() const override {
+    return 8;
+  }
+
+  uint8_t GetLeResolvingListSize() const override {
+    return 8;
+  }
+
+  bool IsSupported(OpCode op_code) const override {
+    return false;
+  }
+
+  void CompletePackets(uint16_t handle, uint16_t packets) {
+    acl_cb_.Invoke(handle, packets);
+  }
+
+ protected:
+  void Start() override {}
+  void Stop() override {}
+  void ListDependencies(bluetooth::ModuleList*) override {}
+
+ private:
+  hci::Controller::CompletedAclPacketsCallback acl_cb_;
+};
+
+// The controller and the remote device behind the HAL, on a thread of their own as the HAL has
+class FakeRemoteDevice : public hal::HciHal {
+ public:
+  // Called on the thread of the fake with the time the last fragment of |payload| reached the HAL
+  using Sink = std::function<void(ChannelKind, Clock::time_point, PacketView<kLittleEndian> payload)>;
+
+  explicit FakeRemoteDevice(FakeController* controller) : controller_(controller) {}
+
+  ~FakeRemoteDevice() {
+    handler_.Clear();
+    handler_.WaitUntilStopped(std::chrono::milliseconds(1000));
+  }
+
+  // HciLayer sends its first command before it registers, so the callbacks are set on the thread of the fake, which
+  // holds the events until then
+  void registerIncomingPacketCallback(hal::HciHalCallbacks* callbacks) override {
+    handler_.Post(bluetooth::common::BindOnce(&FakeRemoteDevice::on_register, bluetooth::common::Unretained(this),
+                                              callbacks));
+  }
+
+  void unregisterIncomingPacketCallback() override {
+    std::promise<void> unregistered;
+    handler_.Post(bluetooth::common::BindOnce(
+        [](FakeRemoteDevice* self, std::promise<void>* unregistered) {
+          self->callbacks_ = nullptr;
+          unregistered->set_value();
+        },
+        bluetooth::common::Unretained(this), &unregistered));
+    unregistered.get_future().wait();
+  }
+
+  void sendHciCommand(hal::HciPacket command) override {
+    handler_.Post(bluetooth::common::BindOnce(&FakeRemoteDevice::on_command, bluetooth::common::Unretained(this),
+                                              std::move(command)));
+  }
+
+  void sendAclData(hal::HciPacket data) override {
+    handler_.Post(bluetooth::common::BindOnce(&FakeRemoteDevice::on_acl, bluetooth::common::Unretained(this),
+                                              Clock::now(), std::move(data)));
+  }
+
+  void sendScoData(hal::HciPacket data) override {}
+
+  void Start() override {}
+
+  void Stop() override {}
+
+  void ListDependencies(bluetooth::ModuleList*) override {}
+
+  void SetSink(Sink sink) {
+    handler_.Post(bluetooth::common::BindOnce([](FakeRemoteDevice* self, Sink sink) { self->sink_ = std::move(sink); },
+                                              bluetooth::common::Unretained(this), std::move(sink)));
+  }
+
+  // Page the local device, then open the classic dynamic channel once connected
+  void ConnectClassic() {
+    handler_.Post(bluetooth::common::BindOnce(&FakeRemoteDevice::send_event, bluetooth::common::Unretained(this),
+                                              hci::ConnectionRequestBuilder::Create(
+                                                  kRemoteAddress, hci::ClassOfDevice(),
+                                                  hci::ConnectionRequestLinkType::ACL)));
+  }
+
+  // Connect to the advertising local device, then open the LE dynamic channel
+  void ConnectLe() {
+    handler_.Post(bluetooth::common::BindOnce(&FakeRemoteDevice::connect_le, bluetooth::common::Unretained(this)));
+  }
+
+  // Send |payload| to the local device on |kind|, from the thread of the fake. |on_sent| is given the time the HAL
+  // handed the first fragment over.
+  void Send(ChannelKind kind, std::vector<uint8_t> payload, std::function<void(Clock::time_point)> on_sent) {
+    handler_.Post(bluetooth::common::BindOnce(&FakeRemoteDevice::send, bluetooth::common::Unretained(this), kind,
+                                              std::move(payload), std::move(on_sent)));
+  }
+
+  Handler* GetFakeHandler() {
+    return &handler_;
+  }
+
+ private:
+  void on_register(hal::HciHalCallbacks* callbacks) {
+    callbacks_ = callbacks;
+    for (auto& event : pending_events_) {
+      callbacks_->hciEventReceived(std::move(event));
+    }
+    pending_events_.clear();
+  }
+
+  void send_event(std::unique_ptr<hci::EventPacketBuilder> event) {
+    if (callbacks_ == nullptr) {
+      pending_events_.push_back(Serialize(std::move(event)));
+      return;
+    }
+    callbacks_->hciEventReceived(Serialize(std::move(event)));
+  }
+
+  void on_command(hal::HciPacket command) {
+    auto op_code = static_cast<OpCode>(command[0] | (command[1] << 8));
+    if (IsCommandWithStatus(op_code)) {
+      send_event(hci::CommandStatusBuilder::Create(ErrorCode::SUCCESS, 1, op_code, std::make_unique<RawBuilder>()));
+    } else {
+      // Only the status is returned, which is all the stack looks at for the commands it sends here
+      send_event(hci::CommandCompleteBuilder::Create(
+          1, op_code, std::make_unique<RawBuilder>(std::vector<uint8_t>{static_cast<uint8_t>(ErrorCode::SUCCESS)})));
+    }
+    if (op_code == OpCode::ACCEPT_CONNECTION_REQUEST) {
+      send_event(hci::ConnectionCompleteBuilder::Create(ErrorCode::SUCCESS, kClassicHandle, kRemoteAddress,
+                                                        hci::LinkType::ACL, hci::Enable::DISABLED));
+      send_signal(kClassicHandle, l2cap::kClassicSignallingCid,
+                  l2cap::ConnectionRequestBuilder::Create(next_signal_id_++, kClassicPsm, kRemoteClassicCid));
+      send_signal(kClassicHandle, l2cap::kClassicSignallingCid,
+                  l2cap::ConnectionRequestBuilder::Create(next_signal_id_++, kShimPsm, kRemoteShimCid));
+    }
+  }
+
+  void connect_le() {
+    send_event(hci::LeConnectionCompleteBuilder::Create(ErrorCode::SUCCESS, kLeHandle, hci::Role::MASTER,
+                                                        AddressType::PUBLIC_DEVICE_ADDRESS, kRemoteAddress, 0x0018,
+                                                        0x0000, 0x01f4, hci::ClockAccuracy::PPM_500));
+    send_signal(kLeHandle, l2cap::kLeSignallingCid,
+                l2cap::LeCreditBasedConnectionRequestBuilder::Create(next_signal_id_++, kLePsm, kRemoteLeCid, kLeMtu,
+                                                                     kRemoteLeMps, kRemoteLeCredits));
+  }
+
+  // Fragments |frame| to the ACL packet length of the link, as a controller does
+  void send_frame(uint16_t handle, std::vector<uint8_t> frame) {
+    size_t max_fragment = handle == kClassicHandle ? kAclPacketLength : kLeAclPacketLength;
+    for (size_t offset = 0; offset < frame.size(); offset += max_fragment) {
+      size_t length = std::min(max_fragment, frame.size() - offset);
+      auto boundary_flag = offset == 0 ? hci::PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE
+                                       : hci::PacketBoundaryFlag::CONTINUING_FRAGMENT;
+      uint16_t handle_and_flags = handle | (static_cast<uint16_t>(boundary_flag) << 12);
+      hal::HciPacket acl = {static_cast<uint8_t>(handle_and_flags), static_cast<uint8_t>(handle_and_flags >> 8),
+                            static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8)};
+      acl.insert(acl.end(), frame.begin() + offset, frame.begin() + offset + length);
+      if (callbacks_ != nullptr) {
+        callbacks_->aclDataReceived(std::move(acl));
+      }
+    }
+  }
+
+  void send_signal(uint16_t handle, Cid cid, std::unique_ptr<BasePacketBuilder> command) {
+    send_frame(handle, Serialize(l2cap::BasicFrameBuilder::Create(cid, std::move(command))));
+  }
+
+  void send(ChannelKind kind, std::vector<uint8_t> payload, std::function<void(Clock::time_point)> on_sent) {
+    auto sent_at = Clock::now();
+    switch (kind) {
+      case ChannelKind::CLASSIC_FIXED:
+        send_frame(kClassicHandle, Serialize(l2cap::BasicFrameBuilder::Create(
+                                       kClassicFixedCid, std::make_unique<RawBuilder>(std::move(payload)))));
+        break;
+      case ChannelKind::CLASSIC_DYNAMIC:
+        send_frame(kClassicHandle, Serialize(l2cap::BasicFrameBuilder::Create(
+                                       classic_dynamic_cid_, std::make_unique<RawBuilder>(std::move(payload)))));
+        break;
+      case ChannelKind::LE_FIXED:
+        send_frame(kLeHandle, Serialize(l2cap::BasicFrameBuilder::Create(
+                                  kLeFixedCid, std::make_unique<RawBuilder>(std::move(payload)))));
+        break;
+      case ChannelKind::SHIM_CLASSIC_DYNAMIC:
+        send_frame(kClassicHandle, Serialize(l2cap::BasicFrameBuilder::Create(
+                                       shim_dynamic_cid_, std::make_unique<RawBuilder>(std::move(payload)))));
+        break;
+      case ChannelKind::LE_DYNAMIC:
+        segment_le_sdu(std::move(payload));
+        sent_at = Clock::now();
+        send_le_frames();
+        break;
+    }
+    on_sent(sent_at);
+  }
+
+  // Segments an SDU to the MPS of the local device, the frames leaving as it grants credits. The local device counts
+  // the basic frame header in its MPS, so the segments leave room for it.
+  void segment_le_sdu(std::vector<uint8_t> sdu) {
+    constexpr size_t kBasicHeaderSize = 4;
+    constexpr size_t kSduLengthSize = 2;
+    size_t offset = std::min(sdu.size(), le_dynamic_mps_ - kBasicHeaderSize - kSduLengthSize);
+    std::vector<uint8_t> first(sdu.begin(), sdu.begin() + offset);
+    le_pending_frames_.push_back(Serialize(l2cap::FirstLeInformationFrameBuilder::Create(
+        le_dynamic_cid_, sdu.size(), std::make_unique<RawBuilder>(std::move(first)))));
+    while (offset < sdu.size()) {
+      size_t length = std::min(sdu.size() - offset, le_dynamic_mps_ - kBasicHeaderSize);
+      std::vector<uint8_t> segment(sdu.begin() + offset, sdu.begin() + offset + length);
+      le_pending_frames_.push_back(Serialize(
+          l2cap::BasicFrameBuilder::Create(le_dynamic_cid_, std::make_unique<RawBuilder>(std::move(segment)))));
+      offset += length;
+    }
+  }
+
+  void send_le_frames() {
+    while (le_dynamic_credits_ > 0 && !le_pending_frames_.empty()) {
+      le_dynamic_credits_--;
+      send_frame(kLeHandle, std::move(le_pending_frames_.front()));
+      le_pending_frames_.pop_front();
+    }
+  }
+
+  void on_acl(Clock::time_point received_at, hal::HciPacket data) {
+    auto packet = PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(std::move(data)));
+    auto acl = hci::AclPacketView::Create(packet);
+    ASSERT(acl.IsValid());
+    uint16_t handle = acl.GetHandle();
+    // The controller sends every packet right away, and frees its buffer
+    controller_->CompletePackets(handle, 1);
+
+    auto payload = acl.GetPayload();
+    auto& reassembly = reassembly_[handle];
+    if (acl.GetPacketBoundaryFlag() != hci::PacketBoundaryFlag::CONTINUING_FRAGMENT) {
+      reassembly.clear();
+    }
+    reassembly.insert(reassembly.end(), payload.begin(), payload.end());
+    if (reassembly.size() < 4 || reassembly.size() < 4u + (reassembly[0] | (reassembly[1] << 8))) {
+      return;
+    }
+    auto frame = l2cap::BasicFrameView::Create(
+        PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(std::move(reassembly))));
+    reassembly_.erase(handle);
+    ASSERT(frame.IsValid());
+    on_frame(handle, received_at, frame);
+  }
+
+  void on_frame(uint16_t handle, Clock::time_point received_at, l2cap::BasicFrameView frame) {
+    Cid cid = frame.GetChannelId();
+    if (handle == kClassicHandle && cid == l2cap::kClassicSignallingCid) {
+      on_classic_signal(l2cap::ControlView::Create(frame.GetPayload()));
+    } else if (handle == kClassicHandle && cid == kClassicFixedCid) {
+      deliver(ChannelKind::CLASSIC_FIXED, received_at, frame.GetPayload());
+    } else if (handle == kClassicHandle && cid == kRemoteClassicCid) {
+      deliver(ChannelKind::CLASSIC_DYNAMIC, received_at, frame.GetPayload());
+    } else if (handle == kClassicHandle && cid == kRemoteShimCid) {
+      deliver(ChannelKind::SHIM_CLASSIC_DYNAMIC, received_at, frame.GetPayload());
+    } else if (handle == kLeHandle && cid == l2cap::kLeSignallingCid) {
+      on_le_signal(l2cap::LeControlView::Create(frame.GetPayload()));
+    } else if (handle == kLeHandle && cid == kLeFixedCid) {
+      deliver(ChannelKind::LE_FIXED, received_at, frame.GetPayload());
+    } else if (handle == kLeHandle && cid == kRemoteLeCid) {
+      on_le_dynamic_frame(received_at, frame);
+    }
+  }
+
+  void deliver(ChannelKind kind, Clock::time_point received_at, PacketView<kLittleEndian> payload) {
+    if (sink_) {
+      sink_(kind, received_at, payload);
+    }
+  }
+
+  void on_le_dynamic_frame(Clock::time_point received_at, l2cap::BasicFrameView frame) {
+    // Give the credit back right away, as a remote with room to spare does
+    send_signal(kLeHandle, l2cap::kLeSignallingCid,
+                l2cap::LeFlowControlCreditBuilder::Create(next_signal_id_++, kRemoteLeCid, 1));
+    if (le_sdu_remaining_ == 0) {
+      auto first = l2cap::FirstLeInformationFrameView::Create(frame);
+      ASSERT(first.IsValid());
+      auto payload = first.GetPayload();
+      le_sdu_.assign(payload.begin(), payload.end());
+      le_sdu_remaining_ = first.GetL2capSduLength() - payload.size();
+    } else {
+      auto payload = frame.GetPayload();
+      le_sdu_.insert(le_sdu_.end(), payload.begin(), payload.end());
+      le_sdu_remaining_ -= payload.size();
+    }
+    if (le_sdu_remaining_ == 0) {
+      deliver(ChannelKind::LE_DYNAMIC, received_at,
+              PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(std::move(le_sdu_))));
+      le_sdu_.clear();
+    }
+  }
+
+  void on_classic_signal(l2cap::ControlView control) {
+    ASSERT(control.IsValid());
+    switch (control.GetCode()) {
+      case l2cap::CommandCode::INFORMATION_REQUEST: {
+        auto request = l2cap::InformationRequestView::Create(control);
+        ASSERT(request.IsValid());
+        if (request.GetInfoType() == l2cap::InformationRequestInfoType::EXTENDED_FEATURES_SUPPORTED) {
+          // Basic mode only, with the fixed channels listed below
+          send_signal(kClassicHandle, l2cap::kClassicSignallingCid,
+                      l2cap::InformationResponseExtendedFeaturesBuilder::Create(
+                          request.GetIdentifier(), l2cap::InformationRequestResult::SUCCESS, 0, 0, 0, 0, 0, 0, 0, 1,
+                          0, 0));
+        } else if (request.GetInfoType() == l2cap::InformationRequestInfoType::FIXED_CHANNELS_SUPPORTED) {
+          send_signal(kClassicHandle, l2cap::kClassicSignallingCid,
+                      l2cap::InformationResponseFixedChannelsBuilder::Create(
+                          request.GetIdentifier(), l2cap::InformationRequestResult::SUCCESS,
+                          (1 << l2cap::kClassicSignallingCid) | (1 << kClassicFixedCid)));
+        }
+        break;
+      }
+      case l2cap::CommandCode::CONNECTION_RESPONSE: {
+        auto response = l2cap::ConnectionResponseView::Create(control);
+        ASSERT(response.IsValid());
+        ASSERT(response.GetResult() == l2cap::ConnectionResponseResult::SUCCESS);
+        Cid local_cid = response.GetDestinationCid();
+        if (response.GetSourceCid() == kRemoteShimCid) {
+          shim_dynamic_cid_ = local_cid;
+        } else {
+          classic_dynamic_cid_ = local_cid;
+        }
+        send_signal(kClassicHandle, l2cap::kClassicSignallingCid,
+                    l2cap::ConfigurationRequestBuilder::Create(next_signal_id_++, local_cid, l2cap::Continuation::END,
+                                                               {}));
+        break;
+      }
+      case l2cap::CommandCode::CONFIGURATION_REQUEST: {
+        auto request = l2cap::ConfigurationRequestView::Create(control);
+        ASSERT(request.IsValid());
+        Cid local_cid = request.GetDestinationCid() == kRemoteShimCid ? shim_dynamic_cid_ : classic_dynamic_cid_;
+        send_signal(kClassicHandle, l2cap::kClassicSignallingCid,
+                    l2cap::ConfigurationResponseBuilder::Create(request.GetIdentifier(), local_cid,
+                                                                l2cap::Continuation::END,
+                                                                l2cap::ConfigurationResponseResult::SUCCESS, {}));
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  void on_le_signal(l2cap::LeControlView control) {
+    ASSERT(control.IsValid());
+    switch (control.GetCode()) {
+      case l2cap::LeCommandCode::LE_CREDIT_BASED_CONNECTION_RESPONSE: {
+        auto response = l2cap::LeCreditBasedConnectionResponseView::Create(control);
+        ASSERT(response.IsValid());
+        ASSERT(response.GetResult() == l2cap::LeCreditBasedConnectionResponseResult::SUCCESS);
+        le_dynamic_cid_ = response.GetDestinationCid();
+        le_dynamic_mps_ = response.GetMps();
+        le_dynamic_credits_ = response.GetInitialCredits();
+        break;
+      }
+      case l2cap::LeCommandCode::LE_FLOW_CONTROL_CREDIT: {
+        auto credit = l2cap::LeFlowControlCreditView::Create(control);
+        ASSERT(credit.IsValid());
+        le_dynamic_credits_ += credit.GetCredits();
+        send_le_frames();
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  FakeController* controller_;
+  hal::HciHalCallbacks* callbacks_ = nullptr;
+  std::vector<hal::HciPacket> pending_events_;
+  Thread thread_{"fake_remote_device", Thread::Priority::NORMAL};
+  Handler handler_{&thread_};
+  Sink sink_;
+  uint8_t next_signal_id_ = 1;
+  std::map<uint16_t, std::vector<uint8_t>> reassembly_;
+  Cid classic_dynamic_cid_ = l2cap::kInvalidCid;
+  Cid shim_dynamic_cid_ = l2cap::kInvalidCid;
+  Cid le_dynamic_cid_ = l2cap::kInvalidCid;
+  size_t le_dynamic_mps_ = 0;
+  size_t le_dynamic_credits_ = 0;
+  std::deque<std::vector<uint8_t>> le_pending_frames_;
+  std::vector<uint8_t> le_sdu_;
+  size_t le_sdu_remaining_ = 0;
+};
+
+using ChannelQueueEnd =
+    bluetooth::common::BidiQueueEnd<BasePacketBuilder, PacketView<kLittleEndian>>;
+
+// The stack from the HAL to the L2CAP modules, with one channel of each kind open to the fake remote device. The
+// profile side of the channels runs on a thread of its own, as the profiles do, and so does the legacy client of
+// the shim channel.
+class PacketPath {
+ public:
+  PacketPath() {
+    auto* controller = new FakeController();
+    remote_ = new FakeRemoteDevice(controller);
+    registry_.InjectTestModule(&hal::HciHal::Factory, remote_);
+    registry_.InjectTestModule(&hci::Controller::Factory, controller);
+    registry_.Start<classic::L2capClassicModule>(&registry_.GetTestThread());
+    registry_.Start<le::L2capLeModule>(&registry_.GetTestThread());
+    registry_.Start<bluetooth::shim::L2cap>(&registry_.GetTestThread());
+    registry_.GetModuleUnderTest<hci::AclManager>()->SetPrivacyPolicyForInitiatorAddress(
+        hci::LeAddressManager::AddressPolicy::USE_PUBLIC_ADDRESS,
+        AddressWithType(kLocalAddress, AddressType::PUBLIC_DEVICE_ADDRESS), {}, std::chrono::milliseconds(0),
+        std::chrono::milliseconds(0));
+
+    auto* classic_module = registry_.GetModuleUnderTest<classic::L2capClassicModule>();
+    auto* le_module = registry_.GetModuleUnderTest<le::L2capLeModule>();
+    shim_ = registry_.GetModuleUnderTest<bluetooth::shim::L2cap>();
+    std::promise<void> classic_registered;
+    std::promise<void> le_registered;
+    classic_fixed_manager_ = classic_module->GetFixedChannelManager();
+    classic_fixed_manager_->RegisterService(
+        kClassicFixedCid,
+        bluetooth::common::BindOnce(
+            [](PacketPath* self, classic::FixedChannelManager::RegistrationResult result,
+               std::unique_ptr<classic::FixedChannelService> service) {
+              ASSERT(result == classic::FixedChannelManager::RegistrationResult::SUCCESS);
+              self->classic_fixed_service_ = std::move(service);
+            },
+            bluetooth::common::Unretained(this)),
+        bluetooth::common::Bind(&PacketPath::on_classic_fixed_channel, bluetooth::common::Unretained(this)),
+        &profile_handler_);
+    classic_dynamic_manager_ = classic_module->GetDynamicChannelManager();
+    classic_dynamic_manager_->RegisterService(
+        kClassicPsm, {}, classic::SecurityPolicy::_SDP_ONLY_NO_SECURITY_WHATSOEVER_PLAINTEXT_TRANSPORT_OK,
+        profile_handler_.BindOnce(
+            [](PacketPath* self, std::promise<void>* registered,
+               classic::DynamicChannelManager::RegistrationResult result,
+               std::unique_ptr<classic::DynamicChannelService> service) {
+              ASSERT(result == classic::DynamicChannelManager::RegistrationResult::SUCCESS);
+              self->classic_dynamic_service_ = std::move(service);
+              registered->set_value();
+            },
+            bluetooth::common::Unretained(this), &classic_registered),
+        profile_handler_.BindOn(this, &PacketPath::on_classic_dynamic_channel));
+    le_fixed_manager_ = le_module->GetFixedChannelManager();
+    le_fixed_manager_->RegisterService(
+        kLeFixedCid,
+        bluetooth::common::BindOnce(
+            [](PacketPath* self, le::FixedChannelManager::RegistrationResult result,
+               std::unique_ptr<le::FixedChannelService> service) {
+              ASSERT(result == le::FixedChannelManager::RegistrationResult::SUCCESS);
+              self->le_fixed_service_ = std::move(service);
+            },
+            bluetooth::common::Unretained(this)),
+        bluetooth::common::Bind(&PacketPath::on_le_fixed_channel, bluetooth::common::Unretained(this)),
+        &profile_handler_);
+    le::DynamicChannelConfigurationOption le_configuration;
+    le_configuration.mtu = kLeMtu;
+    le_dynamic_manager_ = le_module->GetDynamicChannelManager();
+    le_dynamic_manager_->RegisterService(
+        kLePsm, le_configuration, le::SecurityPolicy::NO_SECURITY_WHATSOEVER_PLAINTEXT_TRANSPORT_OK,
+        bluetooth::common::BindOnce(
+            [](PacketPath* self, std::promise<void>* registered, le::DynamicChannelManager::RegistrationResult result,
+               std::unique_ptr<le::DynamicChannelService> service) {
+              ASSERT(result == le::DynamicChannelManager::RegistrationResult::SUCCESS);
+              self->le_dynamic_service_ = std::move(service);
+              registered->set_value();
+            },
+            bluetooth::common::Unretained(this), &le_registered),
+        bluetooth::common::Bind(&PacketPath::on_le_dynamic_channel, bluetooth::common::Unretained(this)),
+        &profile_handler_);
+    std::promise<uint16_t> shim_registered;
+    auto shim_registered_future = shim_registered.get_future();
+    shim_->RegisterClassicService(
+        kShimPsm, false, kShimMtu,
+        [this](std::string address, uint16_t psm, uint16_t cid, uint16_t remote_cid, bool is_connected) {
+          ASSERT(is_connected);
+          profile_handler_.Post(
+              bluetooth::common::BindOnce(&PacketPath::on_shim_channel, bluetooth::common::Unretained(this), cid));
+        },
+        std::move(shim_registered));
+    // The services are registered in order on the L2CAP handler, so the last ones registered tell for all
+    ASSERT(shim_registered_future.wait_for(kSetupTimeout) == std::future_status::ready);
+    ASSERT(classic_registered.get_future().wait_for(kSetupTimeout) == std::future_status::ready);
+    ASSERT(le_registered.get_future().wait_for(kSetupTimeout) == std::future_status::ready);
+
+    remote_->ConnectClassic();
+    remote_->ConnectLe();
+    ASSERT(all_channels_open_.get_future().wait_for(kSetupTimeout) == std::future_status::ready);
+  }
+
+  ~PacketPath() {
+    remote_->SetSink({});
+    // No more packets are read from the shim once closed
+    shim_->CloseClassicConnection(shim_cid_);
+    ASSERT(registry_.SynchronizeModuleHandler(&bluetooth::shim::L2cap::Factory, kSetupTimeout));
+    std::promise<void> released;
+    profile_handler_.Post(bluetooth::common::BindOnce(
+        [](PacketPath* self, std::promise<void>* released) {
+          self->classic_fixed_channel_->Release();
+          self->le_fixed_channel_->Release();
+          self->classic_fixed_channel_.reset();
+          self->classic_dynamic_channel_.reset();
+          self->le_fixed_channel_.reset();
+          self->le_dynamic_channel_.reset();
+          released->set_value();
+        },
+        bluetooth::common::Unretained(this), &released));
+    released.get_future().wait();
+    profile_handler_.Clear();
+    // Deletes the fake remote device and controller too
+    registry_.StopAll();
+  }
+
+  ChannelQueueEnd* GetQueueUpEnd(ChannelKind kind) {
+    switch (kind) {
+      case ChannelKind::CLASSIC_FIXED:
+        return classic_fixed_channel_->GetQueueUpEnd();
+      case ChannelKind::CLASSIC_DYNAMIC:
+        return classic_dynamic_channel_->GetQueueUpEnd();
+      case ChannelKind::LE_FIXED:
+        return le_fixed_channel_->GetQueueUpEnd();
+      case ChannelKind::LE_DYNAMIC:
+        return le_dynamic_channel_->GetQueueUpEnd();
+      case ChannelKind::SHIM_CLASSIC_DYNAMIC:
+        // Owned by the shim, which is used through GetShim() instead
+        break;
+    }
+    return nullptr;
+  }
+
+  Handler* GetProfileHandler() {
+    return &profile_handler_;
+  }
+
+  FakeRemoteDevice* GetRemote() {
+    return remote_;
+  }
+
+  bluetooth::shim::L2cap* GetShim() {
+    return shim_;
+  }
+
+  uint16_t GetShimCid() const {
+    return shim_cid_;
+  }
+
+  // Called on the profile thread with each packet read from the shim channel, set on the profile thread too
+  void SetShimReader(std::function<void(PacketView<kLittleEndian>)> reader) {
+    shim_reader_ = std::move(reader);
+  }
+
+ private:
+  void on_classic_fixed_channel(std::unique_ptr<classic::FixedChannel> channel) {
+    channel->RegisterOnCloseCallback(&profile_handler_, bluetooth::common::BindOnce([](hci::ErrorCode) {}));
+    channel->Acquire();
+    classic_fixed_channel_ = std::move(channel);
+    on_channel_open();
+  }
+
+  void on_classic_dynamic_channel(std::unique_ptr<classic::DynamicChannel> channel) {
+    classic_dynamic_channel_ = std::move(channel);
+    on_channel_open();
+  }
+
+  void on_le_fixed_channel(std::unique_ptr<le::FixedChannel> channel) {
+    channel->RegisterOnCloseCallback(&profile_handler_, bluetooth::common::BindOnce([](hci::ErrorCode) {}));
+    channel->Acquire();
+    le_fixed_channel_ = std::move(channel);
+    on_channel_open();
+  }
+
+  void on_le_dynamic_channel(std::unique_ptr<le::DynamicChannel> channel) {
+    le_dynamic_channel_ = std::move(channel);
+    on_channel_open();
+  }
+
+  void on_shim_channel(uint16_t cid) {
+    shim_cid_ = cid;
+    // The shim calls back on the L2CAP handler, and the packets are handed over to the client thread in one task, as
+    // the legacy stack does
+    shim_->SetReadDataReadyCallback(cid, [this](uint16_t cid, std::vector<PacketView<kLittleEndian>> packets) {
+      profile_handler_.Post(bluetooth::common::BindOnce(&PacketPath::on_shim_packets,
+                                                        bluetooth::common::Unretained(this), std::move(packets)));
+    });
+    shim_->SetConnectionClosedCallback(cid, [](uint16_t cid, int error_code) {});
+    on_channel_open();
+  }
+
+  void on_shim_packets(std::vector<PacketView<kLittleEndian>> packets) {
+    for (auto& packet : packets) {
+      if (shim_reader_) {
+        shim_reader_(packet);
+      }
+    }
+  }
+
+  void on_channel_open() {
+    if (classic_fixed_channel_ && classic_dynamic_channel_ && le_fixed_channel_ && le_dynamic_channel_ &&
+        shim_cid_ != 0) {
+      all_channels_open_.set_value();
+    }
+  }
+
+  TestModuleRegistry registry_;
+  FakeRemoteDevice* remote_;
+  bluetooth::shim::L2cap* shim_;
+  uint16_t shim_cid_ = 0;
+  std::function<void(PacketView<kLittleEndian>)> shim_reader_;
+  Thread profile_thread_{"profile", Thread::Priority::NORMAL};
+  Handler profile_handler_{&profile_thread_};
+  std::promise<void> all_channels_open_;
+  std::unique_ptr<classic::FixedChannelManager> classic_fixed_manager_;
+  std::unique_ptr<classic::DynamicChannelManager> classic_dynamic_manager_;
+  std::unique_ptr<le::FixedChannelManager> le_fixed_manager_;
+  std::unique_ptr<le::DynamicChannelManager> le_dynamic_manager_;
+  std::unique_ptr<classic::FixedChannelService> classic_fixed_service_;
+  std::unique_ptr<classic::DynamicChannelService> classic_dynamic_service_;
+  std::unique_ptr<le::FixedChannelService> le_fixed_service_;
+  std::unique_ptr<le::DynamicChannelService> le_dynamic_service_;
+  std::unique_ptr<classic::FixedChannel> classic_fixed_channel_;
+  std::unique_ptr<classic::DynamicChannel> classic_dynamic_channel_;
+  std::unique_ptr<le::FixedChannel> le_fixed_channel_;
+  std::unique_ptr<le::DynamicChannel> le_dynamic_channel_;
+};
+
+// A payload of |size| bytes starting with its sequence number within the burst
+std::vector<uint8_t> MakePayload(size_t size, uint32_t sequence) {
+  std::vector<uint8_t> payload(size, 0x5a);
+  for (size_t i = 0; i < sizeof(sequence); i++) {
+    payload[i] = static_cast<uint8_t>(sequence >> (8 * i));
+  }
+  return payload;
+}
+
+uint32_t GetSequence(PacketView<kLittleEndian> payload) {
+  return payload.begin().extract<uint32_t>();
+}
+
+void ReportLatencies(State& state, std::vector<Clock::duration>* latencies) {
+  if (latencies->empty()) {
+    return;
+  }
+  std::sort(latencies->begin(), latencies->end());
+  auto percentile_us = [&](size_t percent) {
+    auto latency = (*latencies)[(latencies->size() - 1) * percent / 100];
+    return std::chrono::duration<double, std::micro>(latency).count();
+  };
+  state.counters["p50_us"] = percentile_us(50);
+  state.counters["p99_us"] = percentile_us(99);
+}
+
+// A profile sends bursts of |state.range(0)| bytes packets, timed from the channel queue to the HAL
+template <ChannelKind kKind>
+void BM_ProfileToHal(State& state) {
+  const size_t packet_size = state.range(0);
+  PacketPath path;
+  auto* queue = path.GetQueueUpEnd(kKind);
+
+  std::vector<Clock::time_point> sent_at(kBurstSize);
+  std::vector<Clock::duration> latencies;
+  latencies.reserve(kBurstSize * 1000);
+  std::atomic<size_t> received{0};
+  std::promise<void>* burst_done = nullptr;
+  path.GetRemote()->SetSink([&](ChannelKind kind, Clock::time_point received_at, PacketView<kLittleEndian> payload) {
+    ASSERT(kind == kKind);
+    latencies.push_back(received_at - sent_at[GetSequence(payload)]);
+    if (++received == kBurstSize) {
+      burst_done->set_value();
+    }
+  });
+
+  for (auto _ : state) {
+    std::promise<void> done;
+    burst_done = &done;
+    received = 0;
+    size_t next = 0;
+    path.GetProfileHandler()->Post(bluetooth::common::BindOnce(
+        [](ChannelQueueEnd* queue, Handler* handler, size_t packet_size, size_t* next,
+           std::vector<Clock::time_point>* sent_at) {
+          queue->RegisterEnqueue(handler, bluetooth::common::Bind(
+                                              [](ChannelQueueEnd* queue, size_t packet_size, size_t* next,
+                                                 std::vector<Clock::time_point>* sent_at) {
+                                                uint32_t sequence = (*next)++;
+                                                if (*next == kBurstSize) {
+                                                  queue->UnregisterEnqueue();
+                                                }
+                                                auto packet =
+                                                    std::make_unique<RawBuilder>(MakePayload(packet_size, sequence));
+                                                (*sent_at)[sequence] = Clock::now();
+                                                return std::unique_ptr<BasePacketBuilder>(std::move(packet));
+                                              },
+                                              queue, packet_size, next, sent_at));
+        },
+        queue, path.GetProfileHandler(), packet_size, &next, &sent_at));
+    done.get_future().wait();
+  }
+  path.GetRemote()->SetSink({});
+  state.SetItemsProcessed(state.iterations() * kBurstSize);
+  state.SetBytesProcessed(state.iterations() * kBurstSize * packet_size);
+  ReportLatencies(state, &latencies);
+}
+
+// The remote device sends bursts of |state.range(0)| bytes packets, timed from the HAL to the profile dequeuing them
+template <ChannelKind kKind>
+void BM_HalToProfile(State& state) {
+  const size_t packet_size = state.range(0);
+  PacketPath path;
+  auto* queue = path.GetQueueUpEnd(kKind);
+  auto* remote = path.GetRemote();
+  auto* handler = path.GetProfileHandler();
+
+  // Written on the thread of the fake, read on the profile thread once the packet got through the stack
+  std::vector<Clock::time_point> sent_at(kBurstSize);
+  std::vector<Clock::duration> latencies;
+  latencies.reserve(kBurstSize * 1000);
+  size_t next = 0;
+  size_t received = 0;
+  std::promise<void>* burst_done = nullptr;
+
+  auto send = [&](uint32_t sequence) {
+    remote->Send(kKind, MakePayload(packet_size, sequence),
+                 [&sent_at, sequence](Clock::time_point time) { sent_at[sequence] = time; });
+  };
+  std::promise<void> registered;
+  handler->Post(bluetooth::common::BindOnce(
+      [](ChannelQueueEnd* queue, Handler* handler, std::function<void()> on_packet, std::promise<void>* registered) {
+        queue->RegisterDequeue(handler, bluetooth::common::Bind([](std::function<void()> on_packet) { on_packet(); },
+                                                                std::move(on_packet)));
+        registered->set_value();
+      },
+      queue, handler,
+      std::function<void()>([&]() {
+        auto packet = queue->TryDequeue();
+        auto received_at = Clock::now();
+        latencies.push_back(received_at - sent_at[GetSequence(*packet)]);
+        if (next < kBurstSize) {
+          send(next++);
+        }
+        if (++received == kBurstSize) {
+          burst_done->set_value();
+        }
+      }),
+      &registered));
+  registered.get_future().wait();
+
+  for (auto _ : state) {
+    std::promise<void> done;
+    std::future<void> burst = done.get_future();
+    handler->Post(bluetooth::common::BindOnce(
+        [](std::promise<void>* done, std::promise<void>** burst_done, size_t* next, size_t* received,
+           std::function<void(uint32_t)> send) {
+          *burst_done = done;
+          *received = 0;
+          *next = 0;
+          while (*next < kReceiveWindow) {
+            send((*next)++);
+          }
+        },
+        &done, &burst_done, &next, &received, std::function<void(uint32_t)>(send)));
+    burst.wait();
+  }
+
+  std::promise<void> unregistered;
+  handler->Post(bluetooth::common::BindOnce(
+      [](ChannelQueueEnd* queue, std::promise<void>* unregistered) {
+        queue->UnregisterDequeue();
+        unregistered->set_value();
+      },
+      queue, &unregistered));
+  unregistered.get_future().wait();
+  state.SetItemsProcessed(state.iterations() * kBurstSize);
+  state.SetBytesProcessed(state.iterations() * kBurstSize * packet_size);
+  ReportLatencies(state, &latencies);
+}
+
+// A legacy client writes bursts of |state.range(0)| bytes packets to a shim channel, from its own thread, timed from
+// the write to the HAL
+void BM_ShimProfileToHal(State& state) {
+  const size_t packet_size = state.range(0);
+  PacketPath path;
+  auto* shim = path.GetShim();
+  uint16_t cid = path.GetShimCid();
+
+  std::vector<Clock::time_point> sent_at(kBurstSize);
+  std::vector<Clock::duration> latencies;
+  latencies.reserve(kBurstSize * 1000);
+  std::atomic<size_t> received{0};
+  std::promise<void>* burst_done = nullptr;
+  path.GetRemote()->SetSink([&](ChannelKind kind, Clock::time_point received_at, PacketView<kLittleEndian> payload) {
+    ASSERT(kind == ChannelKind::SHIM_CLASSIC_DYNAMIC);
+    latencies.push_back(received_at - sent_at[GetSequence(payload)]);
+    if (++received == kBurstSize) {
+      burst_done->set_value();
+    }
+  });
+
+  for (auto _ : state) {
+    std::promise<void> done;
+    burst_done = &done;
+    received = 0;
+    path.GetProfileHandler()->Post(bluetooth::common::BindOnce(
+        [](bluetooth::shim::L2cap* shim, uint16_t cid, size_t packet_size, std::vector<Clock::time_point>* sent_at) {
+          for (uint32_t sequence = 0; sequence < kBurstSize; sequence++) {
+            std::vector<uint8_t> payload = MakePayload(packet_size, sequence);
+            (*sent_at)[sequence] = Clock::now();
+            shim->Write(cid, payload.data(), payload.size());
+          }
+        },
+        shim, cid, packet_size, &sent_at));
+    done.get_future().wait();
+  }
+  path.GetRemote()->SetSink({});
+  state.SetItemsProcessed(state.iterations() * kBurstSize);
+  state.SetBytesProcessed(state.iterations() * kBurstSize * packet_size);
+  ReportLatencies(state, &latencies);
+}
+
+// The remote device sends bursts of |state.range(0)| bytes packets on the shim channel, timed from the HAL to the
+// legacy client thread
+void BM_ShimHalToProfile(State& state) {
+  const size_t packet_size = state.range(0);
+  PacketPath path;
+  auto* remote = path.GetRemote();
+  auto* handler = path.GetProfileHandler();
+
+  std::vector<Clock::time_point> sent_at(kBurstSize);
+  std::vector<Clock::duration> latencies;
+  latencies.reserve(kBurstSize * 1000);
+  size_t next = 0;
+  size_t received = 0;
+  std::promise<void>* burst_done = nullptr;
+
+  auto send = [&](uint32_t sequence) {
+    remote->Send(ChannelKind::SHIM_CLASSIC_DYNAMIC, MakePayload(packet_size, sequence),
+                 [&sent_at, sequence](Clock::time_point time) { sent_at[sequence] = time; });
+  };
+  std::promise<void> reader_set;
+  handler->Post(bluetooth::common::BindOnce(
+      [](PacketPath* path, std::function<void(PacketView<kLittleEndian>)> reader, std::promise<void>* reader_set) {
+        path->SetShimReader(std::move(reader));
+        reader_set->set_value();
+      },
+      &path,
+      std::function<void(PacketView<kLittleEndian>)>([&](PacketView<kLittleEndian> packet) {
+        auto received_at = Clock::now();
+        latencies.push_back(received_at - sent_at[GetSequence(packet)]);
+        if (next < kBurstSize) {
+          send(next++);
+        }
+        if (++received == kBurstSize) {
+          burst_done->set_value();
+        }
+      }),
+      &reader_set));
+  reader_set.get_future().wait();
+
+  for (auto _ : state) {
+    std::promise<void> done;
+    std::future<void> burst = done.get_future();
+    handler->Post(bluetooth::common::BindOnce(
+        [](std::promise<void>* done, std::promise<void>** burst_done, size_t* next, size_t* received,
+           std::function<void(uint32_t)> send) {
+          *burst_done = done;
+          *received = 0;
+          *next = 0;
+          while (*next < kReceiveWindow) {
+            send((*next)++);
+          }
+        },
+        &done, &burst_done, &next, &received, std::function<void(uint32_t)>(send)));
+    burst.wait();
+  }
+
+  std::promise<void> reader_cleared;
+  handler->Post(bluetooth::common::BindOnce(
+      [](PacketPath* path, std::promise<void>* reader_cleared) {
+        path->SetShimReader({});
+        reader_cleared->set_value();
+      },
+      &path, &reader_cleared));
+  reader_cleared.get_future().wait();
+  state.SetItemsProcessed(state.iterations() * kBurstSize);
+  state.SetBytesProcessed(state.iterations() * kBurstSize * packet_size);
+  ReportLatencies(state, &latencies);
+}
+
+// ATT-sized packets, then the largest SDU of the channel: the default classic MTU, a full LE data packet for ATT and
+// the MTU of the LE dynamic channel
+BENCHMARK_TEMPLATE(BM_ProfileToHal, ChannelKind::CLASSIC_FIXED)->Arg(kAttPacketSize)->Arg(672)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProfileToHal, ChannelKind::CLASSIC_DYNAMIC)->Arg(kAttPacketSize)->Arg(672)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProfileToHal, ChannelKind::LE_FIXED)->Arg(kAttPacketSize)->Arg(247)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProfileToHal, ChannelKind::LE_DYNAMIC)->Arg(kAttPacketSize)->Arg(kLeMtu)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HalToProfile, ChannelKind::CLASSIC_FIXED)->Arg(kAttPacketSize)->Arg(672)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HalToProfile, ChannelKind::CLASSIC_DYNAMIC)->Arg(kAttPacketSize)->Arg(672)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HalToProfile, ChannelKind::LE_FIXED)->Arg(kAttPacketSize)->Arg(247)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HalToProfile, ChannelKind::LE_DYNAMIC)->Arg(kAttPacketSize)->Arg(kLeMtu)->UseRealTime();
+BENCHMARK(BM_ShimProfileToHal)->Arg(kAttPacketSize)->Arg(kShimMtu)->UseRealTime();
+BENCHMARK(BM_ShimHalToProfile)->Arg(kAttPacketSize)->Arg(kShimMtu)->UseRealTime();
+
+}  // namespace
@@ -16,12 +16,19 @@
 
 #include "module.h"
 
+#include <condition_variable>
+#include <cstdio>
+#include <queue>
+#include <thread>
+
 using ::bluetooth::os::Handler;
 using ::bluetooth::os::Thread;
 
 namespace bluetooth {
 
 constexpr std::chrono::milliseconds kModuleStopTimeout = std::chrono::milliseconds(2000);
+// Module start is mostly spent waiting on the controller and on storage, so a few threads are enough to overlap it
+constexpr size_t kMaxModuleStartThreads = 4;
 
 ModuleFactory::ModuleFactory(std::function<Module*()> ctor) : ctor_(ctor) {
 }
@@ -55,12 +62,14 @@ Module* Module::GetDependency(const ModuleFactory* module) const {
 }
 
 Module* ModuleRegistry::Get(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   auto instance = started_modules_.find(module);
   ASSERT(instance != started_modules_.end());
   return instance->second;
 }
 
 bool ModuleRegistry::IsStarted(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   return started_modules_.find(module) != started_modules_.end();
 }
 
@@ -76,9 +85,12 @@ void ModuleRegistry::set_registry_and_handler(Module* instance, Thread* thread)
 }
 
 Module* ModuleRegistry::Start(const ModuleFactory* module, Thread* thread) {
-  auto started_instance = started_modules_.find(module);
-  if (started_instance != started_modules_.end()) {
-    return started_instance->second;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto started_instance = started_modules_.find(module);
+    if (started_instance != started_modules_.end()) {
+      return started_instance->second;
+    }
   }
 
   Module* instance = module->ctor_();
@@ -87,10 +99,95 @@ Module* ModuleRegistry::Start(const ModuleFactory* module, Thread* thread) {
   instance->ListDependencies(&instance->dependencies_);
   Start(&instance->dependencies_, thread);
 
+  start_instance(module, instance);
+  return instance;
+}
+
+void ModuleRegistry::start_instance(const ModuleFactory* module, Module* instance) {
+  StartTime start_time;
+  start_time.begin = std::chrono::steady_clock::now();
   instance->Start();
+  start_time.end = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(mutex_);
   start_order_.push_back(module);
   started_modules_[module] = instance;
-  return instance;
+  start_times_[module] = start_time;
+}
+
+void ModuleRegistry::StartInParallel(ModuleList* modules, Thread* thread) {
+  struct Node {
+    Module* instance;
+    size_t pending_dependencies = 0;
+    std::vector<const ModuleFactory*> dependents;
+  };
+
+  // Instantiate every module that is not started yet and link it to the dependencies it waits for
+  std::map<const ModuleFactory*, Node> graph;
+  std::function<void(const ModuleFactory*)> add_to_graph = [&](const ModuleFactory* module) {
+    if (IsStarted(module) || graph.find(module) != graph.end()) {
+      return;
+    }
+    Node& node = graph[module];
+    node.instance = module->ctor_();
+    set_registry_and_handler(node.instance, thread);
+    node.instance->ListDependencies(&node.instance->dependencies_);
+    for (const ModuleFactory* dependency : node.instance->dependencies_.list_) {
+      add_to_graph(dependency);
+      auto dependency_node = graph.find(dependency);
+      if (dependency_node != graph.end()) {
+        dependency_node->second.dependents.push_back(module);
+        node.pending_dependencies++;
+      }
+    }
+  };
+  for (const ModuleFactory* module : modules->list_) {
+    add_to_graph(module);
+  }
+
+  std::mutex ready_mutex;
+  std::condition_variable ready_cv;
+  std::queue<const ModuleFactory*> ready;
+  size_t started = 0;
+  for (auto& node : graph) {
+    if (node.second.pending_dependencies == 0) {
+      ready.push(node.first);
+    }
+  }
+
+  auto start_ready_modules = [&]() {
+    std::unique_lock<std::mutex> lock(ready_mutex);
+    while (started < graph.size()) {
+      if (ready.empty()) {
+        ready_cv.wait(lock);
+        continue;
+      }
+      const ModuleFactory* module = ready.front();
+      ready.pop();
+      Node& node = graph[module];
+      lock.unlock();
+      start_instance(module, node.instance);
+      lock.lock();
+      started++;
+      for (const ModuleFactory* dependent : node.dependents) {
+        if (--graph[dependent].pending_dependencies == 0) {
+          ready.push(dependent);
+        }
+      }
+      ready_cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  size_t num_workers = std::min(kMaxModuleStartThreads, graph.size());
+  for (size_t i = 1; i < num_workers; i++) {
+    workers.emplace_back(start_ready_modules);
+  }
+  // The calling thread takes part as well
+  start_ready_modules();
+  for (auto& worker : workers) {
+    worker.join();
+  }
 }
 
 void ModuleRegistry::StopAll() {
@@ -116,9 +213,11 @@ void ModuleRegistry::StopAll() {
 
   ASSERT(started_modules_.empty());
   start_order_.clear();
+  start_times_.clear();
 }
 
 os::Handler* ModuleRegistry::GetModuleHandler(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   auto started_instance = started_modules_.find(module);
   if (started_instance != started_modules_.end()) {
     return started_instance->second->GetHandler();
@@ -151,4 +250,59 @@ void ModuleDumper::DumpState(std::string* output) const {
   *output = std::string(builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize());
 }
 
+bool ModuleDumper::DumpModuleState(size_t index, flatbuffers::FlatBufferBuilder* builder) const {
+  ASSERT(builder != nullptr);
+
+  Module* module = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(module_registry_.mutex_);
+    if (index >= module_registry_.start_order_.size()) {
+      return false;
+    }
+    auto instance = module_registry_.started_modules_.find(*(module_registry_.start_order_.rbegin() + index));
+    ASSERT(instance != module_registry_.started_modules_.end());
+    module = instance->second;
+  }
+
+  builder->Clear();
+  auto title = builder->CreateString(module->ToString());
+  DumpsysDataFinisher finisher = module->GetDumpsysData(builder);
+
+  DumpsysDataBuilder data_builder(*builder);
+  data_builder.add_title(title);
+  finisher(&data_builder);
+  builder->Finish(data_builder.Finish());
+  return true;
+}
+
+void ModuleDumper::DumpStartTimes(std::string* output) const {
+  ASSERT(output != nullptr);
+  std::lock_guard<std::mutex> lock(module_registry_.mutex_);
+
+  output->clear();
+  if (module_registry_.start_times_.empty()) {
+    return;
+  }
+  std::chrono::steady_clock::time_point begin = module_registry_.start_times_.begin()->second.begin;
+  for (const auto& start_time : module_registry_.start_times_) {
+    begin = std::min(begin, start_time.second.begin);
+  }
+
+  for (const ModuleFactory* module : module_registry_.start_order_) {
+    auto start_time = module_registry_.start_times_.find(module);
+    if (start_time == module_registry_.start_times_.end()) {
+      // Injected by a test, not started by the registry
+      continue;
+    }
+    auto offset = std::chrono::duration_cast<std::chrono::milliseconds>(start_time->second.begin - begin);
+    auto duration =
+        std::chrono::duration_cast<std::chrono::milliseconds>(start_time->second.end - start_time->second.begin);
+    char line[128];
+    snprintf(line, sizeof(line), "%-40s started at %5lld ms, took %5lld ms\n",
+             module_registry_.started_modules_.at(module)->ToString().c_str(), static_cast<long long>(offset.count()),
+             static_cast<long long>(duration.count()));
+    output->append(line);
+  }
+}
+
 }  // namespace bluetooth
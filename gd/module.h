@@ -17,9 +17,11 @@
 #pragma once
 
 #include <flatbuffers/flatbuffers.h>
+#include <chrono>
 #include <functional>
 #include <future>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -137,6 +139,10 @@ class ModuleRegistry {
   // in dependency order
   void Start(ModuleList* modules, ::bluetooth::os::Thread* thread);
 
+  // Start all the modules on this list and their dependencies, running Start() of modules that do not depend on each
+  // other concurrently. A module still only starts once all of its dependencies are started.
+  void StartInParallel(ModuleList* modules, ::bluetooth::os::Thread* thread);
+
   template <class T>
   T* Start(::bluetooth::os::Thread* thread) {
     return static_cast<T*>(Start(&T::Factory, thread));
@@ -148,14 +154,26 @@ class ModuleRegistry {
   void StopAll();
 
  protected:
+  // When a module's Start() was called and returned
+  struct StartTime {
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::time_point end;
+  };
+
   Module* Get(const ModuleFactory* module) const;
 
   void set_registry_and_handler(Module* instance, ::bluetooth::os::Thread* thread) const;
 
+  // Calls Start() of an instance whose dependencies are all started, then marks it started
+  void start_instance(const ModuleFactory* module, Module* instance);
+
   os::Handler* GetModuleHandler(const ModuleFactory* module) const;
 
+  // Guards the maps below, which modules starting in parallel look up their dependencies in
+  mutable std::mutex mutex_;
   std::map<const ModuleFactory*, Module*> started_modules_;
   std::vector<const ModuleFactory*> start_order_;
+  std::map<const ModuleFactory*, StartTime> start_times_;
 };
 
 class ModuleDumper {
@@ -164,6 +182,14 @@ class ModuleDumper {
       : module_registry_(module_registry), title_(title) {}
   void DumpState(std::string* output) const;
 
+  // Builds into |builder| a DumpsysData titled with the module name that holds only the data of the |index|th module,
+  // in the order of DumpState(). Returns false once |index| is past the last module. The builder is cleared first so
+  // that one builder, and its buffer, serves all modules of a dump.
+  bool DumpModuleState(size_t index, flatbuffers::FlatBufferBuilder* builder) const;
+
+  // Writes when each module started, relative to the first one, and how long its Start() took, in start order
+  void DumpStartTimes(std::string* output) const;
+
  private:
   const ModuleRegistry& module_registry_;
   const std::string title_;
@@ -21,8 +21,11 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <future>
+#include <thread>
 
 using ::bluetooth::os::Thread;
 
@@ -157,6 +160,59 @@ const ModuleFactory TestModuleTwoDependencies::Factory = ModuleFactory([]() {
   return new TestModuleTwoDependencies();
 });
 
+// Modules that only return from Start() once both of them are in it, or after a timeout
+std::atomic_int rendezvous_modules_in_start{0};
+std::atomic_bool rendezvous_met{false};
+
+void rendezvous() {
+  rendezvous_modules_in_start++;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (rendezvous_modules_in_start < 2 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (rendezvous_modules_in_start == 2) {
+    rendezvous_met = true;
+  }
+}
+
+class TestModuleRendezvous : public Module {
+ public:
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) override {
+    list->add<TestModuleNoDependency>();
+  }
+
+  void Start() override {
+    EXPECT_TRUE(GetModuleRegistry()->IsStarted<TestModuleNoDependency>());
+    rendezvous();
+  }
+
+  void Stop() override {}
+};
+
+const ModuleFactory TestModuleRendezvous::Factory = ModuleFactory([]() { return new TestModuleRendezvous(); });
+
+class TestModuleRendezvousTwo : public Module {
+ public:
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) override {
+    list->add<TestModuleNoDependency>();
+  }
+
+  void Start() override {
+    EXPECT_TRUE(GetModuleRegistry()->IsStarted<TestModuleNoDependency>());
+    rendezvous();
+  }
+
+  void Stop() override {}
+};
+
+const ModuleFactory TestModuleRendezvousTwo::Factory = ModuleFactory([]() { return new TestModuleRendezvousTwo(); });
+
 // To generate module unittest flatbuffer headers:
 // $ flatc --cpp module_unittest.fbs
 class TestModuleDumpState : public Module {
@@ -252,6 +308,55 @@ TEST_F(ModuleTest, two_dependencies) {
   EXPECT_FALSE(registry_->IsStarted<TestModuleTwoDependencies>());
 }
 
+TEST_F(ModuleTest, two_dependencies_in_parallel) {
+  ModuleList list;
+  list.add<TestModuleTwoDependencies>();
+  registry_->StartInParallel(&list, thread_);
+
+  EXPECT_TRUE(registry_->IsStarted<TestModuleNoDependency>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleOneDependency>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleNoDependencyTwo>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleTwoDependencies>());
+
+  registry_->StopAll();
+
+  EXPECT_FALSE(registry_->IsStarted<TestModuleNoDependency>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleOneDependency>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleNoDependencyTwo>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleTwoDependencies>());
+}
+
+TEST_F(ModuleTest, independent_modules_start_concurrently) {
+  rendezvous_modules_in_start = 0;
+  rendezvous_met = false;
+  ModuleList list;
+  list.add<TestModuleRendezvous>();
+  list.add<TestModuleRendezvousTwo>();
+  registry_->StartInParallel(&list, thread_);
+
+  EXPECT_TRUE(rendezvous_met);
+  EXPECT_TRUE(registry_->IsStarted<TestModuleRendezvous>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleRendezvousTwo>());
+
+  registry_->StopAll();
+}
+
+TEST_F(ModuleTest, dump_start_times) {
+  ModuleList list;
+  list.add<TestModuleOneDependency>();
+  registry_->Start(&list, thread_);
+
+  ModuleDumper dumper(*registry_, "Test Dump Title");
+  std::string output;
+  dumper.DumpStartTimes(&output);
+  // One line per module, in start order
+  EXPECT_EQ(2, std::count(output.begin(), output.end(), '\n'));
+
+  registry_->StopAll();
+  dumper.DumpStartTimes(&output);
+  EXPECT_TRUE(output.empty());
+}
+
 void post_to_module_one_handler() {
   std::this_thread::sleep_for(std::chrono::milliseconds(100));
   test_module_one_dependency_handler->Post(common::BindOnce([] { FAIL(); }));
@@ -295,5 +400,29 @@ TEST_F(ModuleTest, dump_state) {
   registry_->StopAll();
 }
 
+TEST_F(ModuleTest, dump_module_state) {
+  ModuleList list;
+  list.add<TestModuleDumpState>();
+  registry_->Start(&list, thread_);
+
+  ModuleDumper dumper(*registry_, "Test Dump Title");
+  flatbuffers::FlatBufferBuilder builder(1024);
+  // Modules are dumped from the last started, as DumpState() does
+  EXPECT_TRUE(dumper.DumpModuleState(0, &builder));
+  auto data = flatbuffers::GetRoot<DumpsysData>(builder.GetBufferPointer());
+  EXPECT_STREQ("Initial Test String", data->module_unittest_data()->title()->c_str());
+
+  // The dependency has no data of its own
+  EXPECT_TRUE(dumper.DumpModuleState(1, &builder));
+  data = flatbuffers::GetRoot<DumpsysData>(builder.GetBufferPointer());
+  EXPECT_NE(nullptr, data->title());
+  EXPECT_EQ(nullptr, data->module_unittest_data());
+
+  EXPECT_FALSE(dumper.DumpModuleState(2, &builder));
+
+  registry_->StopAll();
+  EXPECT_FALSE(dumper.DumpModuleState(0, &builder));
+}
+
 }  // namespace
 }  // namespace bluetooth
@@ -20,6 +20,7 @@
 
 #include "common/bind.h"
 #include "grpc/grpc_event_queue.h"
+#include "grpc/grpc_packet_bytes.h"
 #include "hci/hci_packets.h"
 #include "neighbor/facade/facade.grpc.pb.h"
 
@@ -178,7 +179,7 @@ class NeighborFacadeService : public NeighborFacade::Service {
  private:
   void on_incoming_inquiry_result(hci::EventPacketView view) {
     InquiryResultMsg inquiry_result_msg;
-    inquiry_result_msg.set_packet(std::string(view.begin(), view.end()));
+    inquiry_result_msg.set_packet(::bluetooth::grpc::PacketViewToBytes(view));
     pending_events_.OnIncomingEvent(std::move(inquiry_result_msg));
   }
 
@@ -17,7 +17,10 @@
 
 #include "neighbor/name_db.h"
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
@@ -26,6 +29,8 @@
 #include "neighbor/name.h"
 #include "os/handler.h"
 #include "os/log.h"
+#include "storage/classic_device.h"
+#include "storage/storage_module.h"
 
 namespace bluetooth {
 namespace neighbor {
@@ -35,6 +40,10 @@ struct PendingRemoteNameRead {
   ReadRemoteNameDbCallback callback_;
   os::Handler* handler_;
 };
+
+int64_t GetUnixTimestamp() {
+  return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
 }  // namespace
 
 struct NameDbModule::impl {
@@ -43,6 +52,10 @@ struct NameDbModule::impl {
   bool IsNameCached(hci::Address address) const;
   RemoteName ReadCachedRemoteName(hci::Address address) const;
 
+  void CacheRemoteName(hci::Address address, RemoteName name);
+  void SetPageScanHint(
+      hci::Address address, hci::PageScanRepetitionMode page_scan_repetition_mode, uint16_t clock_offset);
+
   impl(const NameDbModule& module);
 
   void Start();
@@ -50,11 +63,12 @@ struct NameDbModule::impl {
 
  private:
   std::unordered_map<hci::Address, PendingRemoteNameRead> address_to_pending_read_map_;
-  std::unordered_map<hci::Address, RemoteName> address_to_name_map_;
 
   void OnRemoteNameResponse(hci::ErrorCode status, hci::Address address, RemoteName name);
+  storage::Device GetClassicDevice(hci::Address address);
 
   neighbor::NameModule* name_module_;
+  storage::StorageModule* storage_module_;
 
   const NameDbModule& module_;
   os::Handler* handler_;
@@ -71,12 +85,25 @@ void neighbor::NameDbModule::impl::ReadRemoteNameRequest(
     return;
   }
 
+  if (IsNameCached(address)) {
+    handler->Post(common::BindOnce(std::move(callback), address, true));
+    return;
+  }
+
   address_to_pending_read_map_[address] = {std::move(callback), std::move(handler)};
 
-  // TODO(cmanton) Use remote name request defaults for now
   hci::PageScanRepetitionMode page_scan_repetition_mode = hci::PageScanRepetitionMode::R1;
   uint16_t clock_offset = 0;
   hci::ClockOffsetValid clock_offset_valid = hci::ClockOffsetValid::INVALID;
+  storage::ClassicDevice device = GetClassicDevice(address).Classic();
+  auto hint_clock_offset = device.GetTempClockOffset();
+  auto hint_page_scan_repetition_mode = device.GetTempPageScanRepetitionMode();
+  if (hint_clock_offset && hint_page_scan_repetition_mode &&
+      *hint_page_scan_repetition_mode <= static_cast<uint8_t>(hci::PageScanRepetitionMode::R2)) {
+    page_scan_repetition_mode = static_cast<hci::PageScanRepetitionMode>(*hint_page_scan_repetition_mode);
+    clock_offset = *hint_clock_offset;
+    clock_offset_valid = hci::ClockOffsetValid::VALID;
+  }
   name_module_->ReadRemoteNameRequest(
       address,
       page_scan_repetition_mode,
@@ -89,21 +116,59 @@ void neighbor::NameDbModule::impl::ReadRemoteNameRequest(
 void neighbor::NameDbModule::impl::OnRemoteNameResponse(hci::ErrorCode status, hci::Address address, RemoteName name) {
   ASSERT(address_to_pending_read_map_.find(address) != address_to_pending_read_map_.end());
   PendingRemoteNameRead callback_handler = std::move(address_to_pending_read_map_.at(address));
+  address_to_pending_read_map_.erase(address);
 
   if (status == hci::ErrorCode::SUCCESS) {
-    address_to_name_map_[address] = name;
+    CacheRemoteName(address, name);
   }
   callback_handler.handler_->Post(
       common::BindOnce(std::move(callback_handler.callback_), address, status == hci::ErrorCode::SUCCESS));
 }
 
+storage::Device neighbor::NameDbModule::impl::GetClassicDevice(hci::Address address) {
+  storage::Device device = storage_module_->GetDeviceByClassicMacAddress(address);
+  auto device_type = device.GetDeviceType();
+  if (device_type != hci::DeviceType::BR_EDR && device_type != hci::DeviceType::DUAL) {
+    auto mutation = storage_module_->Modify();
+    mutation.Add(device.SetDeviceType(hci::DeviceType::BR_EDR));
+    mutation.Commit();
+  }
+  return device;
+}
+
+void neighbor::NameDbModule::impl::CacheRemoteName(hci::Address address, RemoteName name) {
+  storage::Device device = GetClassicDevice(address);
+  auto mutation = storage_module_->Modify();
+  mutation.Add(device.SetName(std::string(name.begin(), std::find(name.begin(), name.end(), '\0'))));
+  mutation.Add(device.SetNameUnixTimestamp(GetUnixTimestamp()));
+  mutation.Commit();
+}
+
+void neighbor::NameDbModule::impl::SetPageScanHint(
+    hci::Address address, hci::PageScanRepetitionMode page_scan_repetition_mode, uint16_t clock_offset) {
+  storage::ClassicDevice device = GetClassicDevice(address).Classic();
+  auto mutation = storage_module_->Modify();
+  mutation.Add(device.SetTempClockOffset(clock_offset));
+  mutation.Add(device.SetTempPageScanRepetitionMode(static_cast<uint8_t>(page_scan_repetition_mode)));
+  mutation.Commit();
+}
+
 bool neighbor::NameDbModule::impl::IsNameCached(hci::Address address) const {
-  return address_to_name_map_.count(address) == 1;
+  storage::Device device = storage_module_->GetDeviceByClassicMacAddress(address);
+  auto timestamp = device.GetNameUnixTimestamp();
+  if (!device.GetName() || !timestamp) {
+    return false;
+  }
+  int64_t age = GetUnixTimestamp() - *timestamp;
+  return age >= 0 && age < std::chrono::duration_cast<std::chrono::seconds>(kNameCacheTtl).count();
 }
 
 RemoteName neighbor::NameDbModule::impl::ReadCachedRemoteName(hci::Address address) const {
   ASSERT(IsNameCached(address));
-  return address_to_name_map_.at(address);
+  std::string name = *storage_module_->GetDeviceByClassicMacAddress(address).GetName();
+  RemoteName remote_name{};
+  std::copy_n(name.begin(), std::min(name.size(), remote_name.size() - 1), remote_name.begin());
+  return remote_name;
 }
 
 /**
@@ -133,8 +198,24 @@ RemoteName neighbor::NameDbModule::ReadCachedRemoteName(hci::Address address) co
   return pimpl_->ReadCachedRemoteName(address);
 }
 
+void neighbor::NameDbModule::CacheRemoteName(hci::Address address, RemoteName name) {
+  GetHandler()->Post(
+      common::BindOnce(&NameDbModule::impl::CacheRemoteName, common::Unretained(pimpl_.get()), address, name));
+}
+
+void neighbor::NameDbModule::SetPageScanHint(
+    hci::Address address, hci::PageScanRepetitionMode page_scan_repetition_mode, uint16_t clock_offset) {
+  GetHandler()->Post(common::BindOnce(
+      &NameDbModule::impl::SetPageScanHint,
+      common::Unretained(pimpl_.get()),
+      address,
+      page_scan_repetition_mode,
+      clock_offset));
+}
+
 void neighbor::NameDbModule::impl::Start() {
   name_module_ = module_.GetDependency<neighbor::NameModule>();
+  storage_module_ = module_.GetDependency<storage::StorageModule>();
   handler_ = module_.GetHandler();
 }
 
@@ -145,6 +226,7 @@ void neighbor::NameDbModule::impl::Stop() {}
  */
 void neighbor::NameDbModule::ListDependencies(ModuleList* list) {
   list->add<neighbor::NameModule>();
+  list->add<storage::StorageModule>();
 }
 
 void neighbor::NameDbModule::Start() {
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 
@@ -30,13 +31,26 @@ namespace neighbor {
 
 using ReadRemoteNameDbCallback = common::OnceCallback<void(hci::Address address, bool success)>;
 
+// Remote names are kept in storage with the time they were read or learned. A name younger than |kNameCacheTtl| is
+// used without paging the device again. Names of paired devices are kept on disk, names of other devices are kept by
+// storage for as long as the stack runs
 class NameDbModule : public bluetooth::Module {
  public:
+  static constexpr std::chrono::hours kNameCacheTtl{24};
+
+  // Completes at once with a cached name, otherwise pages the device with the hints of its last inquiry response
   void ReadRemoteNameRequest(hci::Address address, ReadRemoteNameDbCallback callback, os::Handler* handler);
 
   bool IsNameCached(hci::Address address) const;
   RemoteName ReadCachedRemoteName(hci::Address address) const;
 
+  // Caches a name learned without a remote name request, e.g. the complete local name of an extended inquiry response
+  void CacheRemoteName(hci::Address address, RemoteName name);
+
+  // Keeps the page scan repetition mode and clock offset of an inquiry response to page the device faster
+  void SetPageScanHint(
+      hci::Address address, hci::PageScanRepetitionMode page_scan_repetition_mode, uint16_t clock_offset);
+
   static const ModuleFactory Factory;
 
   NameDbModule();
@@ -28,6 +28,8 @@
 namespace bluetooth {
 namespace os {
 
+class AlarmGroup;
+
 // A single-shot alarm for reactor-based thread, implemented by Linux timerfd.
 // When it's constructed, it will register a reactable on the specified thread; when it's destroyed, it will unregister
 // itself from the thread.
@@ -36,6 +38,10 @@ class Alarm {
   // Create and register a single-shot alarm on a given handler
   explicit Alarm(Handler* handler);
 
+  // Create a single-shot alarm sharing the timer of |group|, firing on the handler of the group. The alarm may fire
+  // up to the coalescing window of the group after its deadline.
+  explicit Alarm(AlarmGroup* group);
+
   // Unregister this alarm from the thread and release resource
   ~Alarm();
 
@@ -53,7 +59,10 @@ class Alarm {
   int fd_ = 0;
   Reactor::Reactable* token_;
   mutable std::mutex mutex_;
+  AlarmGroup* group_ = nullptr;
+  int group_id_ = -1;
   void on_fire();
+  void on_group_fire();
 };
 
 }  // namespace os
@@ -14,19 +14,24 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <chrono>
 #include <future>
 #include <unordered_map>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "common/bind.h"
 #include "os/alarm.h"
+#include "os/alarm_group.h"
 #include "os/repeating_alarm.h"
 #include "os/thread.h"
 
 using ::benchmark::State;
 using ::bluetooth::common::Bind;
+using ::bluetooth::common::BindOnce;
 using ::bluetooth::os::Alarm;
+using ::bluetooth::os::AlarmGroup;
 using ::bluetooth::os::Handler;
 using ::bluetooth::os::RepeatingAlarm;
 using ::bluetooth::os::Thread;
@@ -140,3 +145,111 @@ BENCHMARK_REGISTER_F(BM_ReactableAlarm, periodic_accuracy)
     ->Args({2000, 15, 20})
     ->Iterations(1)
     ->UseRealTime();
+
+// A mix of timers as seen on a busy stack, scaled down in time: repeating timers for connection supervision,
+// sniff and RSSI polling, advertising and address rotation, plus single-shot timeouts re-armed when they fire, like
+// scan and page timeouts.
+constexpr int kRepeatingPeriodsMs[] = {20, 30, 45, 50, 100, 100, 250, 500};
+constexpr int kTimeoutDelaysMs[] = {12, 37, 80, 160};
+// The coalescing window given to BM_AlarmGroup for alarms that aren't in a group
+constexpr int kNoGroup = -1;
+
+class BM_AlarmGroup : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    thread_ = std::make_unique<Thread>("timer_benchmark", Thread::Priority::REAL_TIME);
+    handler_ = std::make_unique<Handler>(thread_.get());
+    if (st.range(0) != kNoGroup) {
+      group_ = std::make_unique<AlarmGroup>(handler_.get(), std::chrono::milliseconds(st.range(0)));
+    }
+    fired_ = 0;
+  }
+
+  void TearDown(State& st) override {
+    repeating_alarms_.clear();
+    alarms_.clear();
+    group_ = nullptr;
+    handler_->Clear();
+    handler_ = nullptr;
+    thread_->Stop();
+    thread_ = nullptr;
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  template <typename T>
+  std::unique_ptr<T> NewAlarm() {
+    if (group_ != nullptr) return std::make_unique<T>(group_.get());
+    return std::make_unique<T>(handler_.get());
+  }
+
+  void StartTimerMix() {
+    for (int period_ms : kRepeatingPeriodsMs) {
+      repeating_alarms_.push_back(NewAlarm<RepeatingAlarm>());
+      repeating_alarms_.back()->Schedule(
+          Bind(&BM_AlarmGroup::RepeatingFire, bluetooth::common::Unretained(this)),
+          std::chrono::milliseconds(period_ms));
+    }
+    for (size_t i = 0; i < sizeof(kTimeoutDelaysMs) / sizeof(kTimeoutDelaysMs[0]); i++) {
+      alarms_.push_back(NewAlarm<Alarm>());
+      handler_->Post(BindOnce(&BM_AlarmGroup::TimeoutFire, bluetooth::common::Unretained(this), i));
+    }
+  }
+
+  // Cancels on the handler thread, so no timeout is re-armed after it's canceled
+  void StopTimerMix() {
+    std::promise<void> canceled;
+    handler_->Post(BindOnce(
+        &BM_AlarmGroup::CancelAll, bluetooth::common::Unretained(this), bluetooth::common::Unretained(&canceled)));
+    canceled.get_future().get();
+  }
+
+  void CancelAll(std::promise<void>* canceled) {
+    for (auto& alarm : repeating_alarms_) alarm->Cancel();
+    for (auto& alarm : alarms_) alarm->Cancel();
+    canceled->set_value();
+  }
+
+  void RepeatingFire() {
+    fired_++;
+  }
+
+  void TimeoutFire(size_t index) {
+    fired_++;
+    alarms_[index]->Schedule(
+        Bind(&BM_AlarmGroup::TimeoutFire, bluetooth::common::Unretained(this), index),
+        std::chrono::milliseconds(kTimeoutDelaysMs[index]));
+  }
+
+  std::unique_ptr<Thread> thread_;
+  std::unique_ptr<Handler> handler_;
+  std::unique_ptr<AlarmGroup> group_;
+  std::vector<std::unique_ptr<Alarm>> alarms_;
+  std::vector<std::unique_ptr<RepeatingAlarm>> repeating_alarms_;
+  std::atomic<uint64_t> fired_;
+};
+
+// Runs the timer mix for range(1) ms with the coalescing window range(0), or with one timerfd per alarm for kNoGroup.
+// Reports the reactor wakeups and the alarm callbacks per second; every alarm fire is a wakeup without a group.
+BENCHMARK_DEFINE_F(BM_AlarmGroup, wakeups_per_second)(State& state) {
+  for (auto _ : state) {
+    StartTimerMix();
+    std::this_thread::sleep_for(std::chrono::milliseconds(state.range(1)));
+    StopTimerMix();
+  }
+
+  double seconds = state.iterations() * state.range(1) / 1000.0;
+  uint64_t wakeups = group_ != nullptr ? group_->GetWakeupCount() : fired_.load();
+  state.counters["wakeups_per_second"] = wakeups / seconds;
+  state.counters["alarms_per_second"] = fired_ / seconds;
+  if (group_ != nullptr) state.SetLabel("coalescing " + std::to_string(state.range(0)) + " ms");
+};
+
+BENCHMARK_REGISTER_F(BM_AlarmGroup, wakeups_per_second)
+    ->Args({kNoGroup, 2000})
+    ->Args({0, 2000})
+    ->Args({5, 2000})
+    ->Args({10, 2000})
+    ->Args({20, 2000})
+    ->Iterations(1)
+    ->UseRealTime();
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include "common/callback.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace os {
+
+// A group of alarms sharing a single Linux timerfd on a reactor-based thread, so that alarms with nearby deadlines
+// wake the thread up once instead of once each. Alarms of the group may fire up to |coalescing_window| after their
+// deadline, never before it; a zero window keeps exact deadlines and only saves the per alarm timerfd.
+// The group must outlive the Alarm and RepeatingAlarm instances created with it.
+class AlarmGroup {
+ public:
+  // Create and register an alarm group on a given handler
+  AlarmGroup(Handler* handler, std::chrono::milliseconds coalescing_window);
+
+  // Unregister this group from the thread and release resource
+  ~AlarmGroup();
+
+  DISALLOW_COPY_AND_ASSIGN(AlarmGroup);
+
+  std::chrono::milliseconds GetCoalescingWindow() const {
+    return coalescing_window_;
+  }
+
+  // Number of times the timer of this group woke the thread up
+  uint64_t GetWakeupCount() const;
+
+ private:
+  friend class Alarm;
+  friend class RepeatingAlarm;
+
+  using Deadlines = std::multimap<std::chrono::milliseconds, int>;
+
+  struct Member {
+    common::Closure on_fire;
+    bool scheduled = false;
+    // Bumped whenever the member is scheduled or canceled, to discard expirations collected before that
+    uint64_t generation = 0;
+    Deadlines::iterator deadline;
+  };
+
+  // Time on the clock of the timerfd, used for absolute deadlines
+  static std::chrono::milliseconds Now();
+
+  // Add a member whose |on_fire| is run on the thread of the group when it expires. Returns the member id.
+  int Register(common::Closure on_fire);
+  void Unregister(int id);
+
+  // Schedule member |id| at the absolute |deadline|, replacing any pending deadline
+  void ScheduleAt(int id, std::chrono::milliseconds deadline);
+  // No-op if member |id| is not scheduled
+  void Cancel(int id);
+
+  // Must be called with |mutex_| held
+  void cancel_locked(Member* member);
+  void rearm_locked();
+  void on_fire();
+
+  Handler* handler_;
+  std::chrono::milliseconds coalescing_window_;
+  int fd_ = 0;
+  Reactor::Reactable* token_;
+  mutable std::mutex mutex_;
+  std::unordered_map<int, Member> members_;
+  int next_id_ = 0;
+  Deadlines deadlines_;
+  // The time the timer is armed for, zero if disarmed
+  std::chrono::milliseconds armed_time_{0};
+  uint64_t wakeup_count_ = 0;
+};
+
+}  // namespace os
+}  // namespace bluetooth
@@ -40,5 +40,11 @@ std::optional<std::string> ReadSmallFile(const std::string& path);
 // Return true on success, false on failure
 bool WriteToFile(const std::string& path, const std::string& data);
 
+// Append |data| to the end of the file at |path|, creating it if needed, and sync it to storage media before
+// returning. Unlike WriteToFile(), a failure or a crash can leave a partial |data| at the end of the file, so callers
+// must be able to detect it.
+// Return true on success, false on failure
+bool AppendToFile(const std::string& path, const std::string& data);
+
 }  // namespace os
 }  // namespace bluetooth
\ No newline at end of file
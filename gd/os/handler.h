@@ -20,10 +20,14 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 #include "common/bind.h"
 #include "common/callback.h"
 #include "common/contextual_callback.h"
+#include "common/inline_closure.h"
 #include "os/thread.h"
 #include "os/utils.h"
 
@@ -52,14 +56,24 @@ class Handler : public common::IPostableContext {
   // Die if the current reactable doesn't stop before the timeout.  Must be called after Clear()
   void WaitUntilStopped(std::chrono::milliseconds timeout);
 
+  // Call() and CallOn() keep the functor and its arguments in an InlineClosure, so that the common calls don't
+  // allocate. Functors that need the BindOnce() argument wrappers, or callbacks, still go through BindOnce().
   template <typename Functor, typename... Args>
   void Call(Functor&& functor, Args&&... args) {
-    Post(common::BindOnce(std::forward<Functor>(functor), std::forward<Args>(args)...));
+    if constexpr (std::is_invocable<std::decay_t<Functor>, std::decay_t<Args>...>::value) {
+      enqueue(make_closure(std::forward<Functor>(functor), std::forward<Args>(args)...));
+    } else {
+      Post(common::BindOnce(std::forward<Functor>(functor), std::forward<Args>(args)...));
+    }
   }
 
   template <typename T, typename Functor, typename... Args>
   void CallOn(T* obj, Functor&& functor, Args&&... args) {
-    Post(common::BindOnce(std::forward<Functor>(functor), common::Unretained(obj), std::forward<Args>(args)...));
+    if constexpr (std::is_invocable<std::decay_t<Functor>, T*, std::decay_t<Args>...>::value) {
+      enqueue(make_closure(std::forward<Functor>(functor), obj, std::forward<Args>(args)...));
+    } else {
+      Post(common::BindOnce(std::forward<Functor>(functor), common::Unretained(obj), std::forward<Args>(args)...));
+    }
   }
 
   template <typename Functor, typename... Args>
@@ -96,16 +110,29 @@ class Handler : public common::IPostableContext {
 
   friend class RepeatingAlarm;
 
+  friend class AlarmGroup;
+
  private:
-  inline bool was_cleared() const {
-    return tasks_ == nullptr;
-  };
-  std::queue<common::OnceClosure>* tasks_;
+  // Arguments are moved into the call, as BindOnce() does
+  template <typename Functor, typename... Args>
+  static common::InlineClosure make_closure(Functor&& functor, Args&&... args) {
+    return common::InlineClosure(
+        [functor = std::forward<Functor>(functor), bound = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+          std::apply([&functor](auto&... bound_args) { std::invoke(std::move(functor), std::move(bound_args)...); },
+                     bound);
+        });
+  }
+  void enqueue(common::InlineClosure closure);
+  // Wraps |closure| to trace its wait in the queue and its run
+  common::InlineClosure trace_task(common::InlineClosure closure);
+  bool was_cleared() const;
+  // Lock-free queue of the posted tasks, defined in handler.cc. The reactable holds a reference too, so that the
+  // tasks of a wake up may go on after one of them clears and destroys the handler.
+  class TaskQueue;
+  static void handle_next_event(std::shared_ptr<TaskQueue> tasks);
+  std::shared_ptr<TaskQueue> tasks_;
   Thread* thread_;
-  int fd_;
   Reactor::Reactable* reactable_;
-  mutable std::mutex mutex_;
-  void handle_next_event();
 };
 
 }  // namespace os
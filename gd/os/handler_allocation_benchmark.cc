@@ -0,0 +1,128 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <new>
+
+#include "benchmark/benchmark.h"
+#include "common/bind.h"
+#include "os/handler.h"
+#include "os/thread.h"
+
+using ::benchmark::State;
+using ::bluetooth::common::BindOnce;
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::Thread;
+
+// This file is built into its own benchmark binary, bluetooth_allocation_benchmark_gd, because it replaces the global
+// operator new to count allocations. Keep other benchmarks out of that binary.
+
+namespace {
+
+std::atomic<int64_t> allocation_count(0);
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+class BM_HandlerAllocation : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    benchmark::Fixture::SetUp(st);
+    thread_ = std::make_unique<Thread>("BM_HandlerAllocation thread", Thread::Priority::NORMAL);
+    handler_ = std::make_unique<Handler>(thread_.get());
+  }
+  void TearDown(State& st) override {
+    handler_->Clear();
+    handler_ = nullptr;
+    thread_->Stop();
+    thread_ = nullptr;
+    benchmark::Fixture::TearDown(st);
+  }
+  void callback_batch() {
+    counter_++;
+    if (counter_ >= num_messages_to_send_) {
+      counter_promise_.set_value();
+    }
+  }
+
+  int64_t num_messages_to_send_;
+  int64_t counter_;
+  std::promise<void> counter_promise_;
+  std::unique_ptr<Thread> thread_;
+  std::unique_ptr<Handler> handler_;
+};
+
+// Posts through Post(BindOnce()) and through CallOn(), which keeps the call inline, reporting posts per second and
+// allocations per post
+BENCHMARK_DEFINE_F(BM_HandlerAllocation, batch_post_bind_once)(State& state) {
+  int64_t allocations = 0;
+  for (auto _ : state) {
+    num_messages_to_send_ = state.range(0);
+    counter_ = 0;
+    counter_promise_ = std::promise<void>();
+    std::future<void> counter_future = counter_promise_.get_future();
+    int64_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+    for (int i = 0; i < num_messages_to_send_; i++) {
+      handler_->Post(BindOnce(
+          &BM_HandlerAllocation_batch_post_bind_once_Benchmark::callback_batch, bluetooth::common::Unretained(this)));
+    }
+    counter_future.wait();
+    allocations += allocation_count.load(std::memory_order_relaxed) - allocations_before;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["allocs_per_post"] = static_cast<double>(allocations) / (state.iterations() * state.range(0));
+};
+
+BENCHMARK_REGISTER_F(BM_HandlerAllocation, batch_post_bind_once)->Arg(100000)->Iterations(1)->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_HandlerAllocation, batch_call_on)(State& state) {
+  int64_t allocations = 0;
+  for (auto _ : state) {
+    num_messages_to_send_ = state.range(0);
+    counter_ = 0;
+    counter_promise_ = std::promise<void>();
+    std::future<void> counter_future = counter_promise_.get_future();
+    int64_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+    for (int i = 0; i < num_messages_to_send_; i++) {
+      handler_->CallOn(this, &BM_HandlerAllocation_batch_call_on_Benchmark::callback_batch);
+    }
+    counter_future.wait();
+    allocations += allocation_count.load(std::memory_order_relaxed) - allocations_before;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["allocs_per_post"] = static_cast<double>(allocations) / (state.iterations() * state.range(0));
+};
+
+BENCHMARK_REGISTER_F(BM_HandlerAllocation, batch_call_on)->Arg(100000)->Iterations(1)->UseRealTime();
@@ -22,6 +22,7 @@
 #include <cstring>
 
 #include "common/bind.h"
+#include "os/alarm_group.h"
 #include "os/linux_generic/linux.h"
 #include "os/log.h"
 #include "os/utils.h"
@@ -44,7 +45,16 @@ Alarm::Alarm(Handler* handler) : handler_(handler), fd_(TIMERFD_CREATE(ALARM_CLO
       fd_, common::Bind(&Alarm::on_fire, common::Unretained(this)), Closure());
 }
 
+Alarm::Alarm(AlarmGroup* group) : handler_(group->handler_), fd_(-1), token_(nullptr), group_(group) {
+  group_id_ = group_->Register(common::Bind(&Alarm::on_group_fire, common::Unretained(this)));
+}
+
 Alarm::~Alarm() {
+  if (group_ != nullptr) {
+    group_->Unregister(group_id_);
+    return;
+  }
+
   handler_->thread_->GetReactor()->Unregister(token_);
 
   int close_status;
@@ -54,6 +64,12 @@ Alarm::~Alarm() {
 
 void Alarm::Schedule(OnceClosure task, std::chrono::milliseconds delay) {
   std::lock_guard<std::mutex> lock(mutex_);
+  if (group_ != nullptr) {
+    task_ = std::move(task);
+    group_->ScheduleAt(group_id_, AlarmGroup::Now() + delay);
+    return;
+  }
+
   long delay_ms = delay.count();
   itimerspec timer_itimerspec{{/* interval for periodic timer */}, {delay_ms / 1000, delay_ms % 1000 * 1000000}};
   int result = TIMERFD_SETTIME(fd_, 0, &timer_itimerspec, nullptr);
@@ -64,6 +80,11 @@ void Alarm::Schedule(OnceClosure task, std::chrono::milliseconds delay) {
 
 void Alarm::Cancel() {
   std::lock_guard<std::mutex> lock(mutex_);
+  if (group_ != nullptr) {
+    group_->Cancel(group_id_);
+    return;
+  }
+
   itimerspec disarm_itimerspec{/* disarm timer */};
   int result = TIMERFD_SETTIME(fd_, 0, &disarm_itimerspec, nullptr);
   ASSERT(result == 0);
@@ -80,5 +101,12 @@ void Alarm::on_fire() {
   ASSERT(times_invoked == static_cast<uint64_t>(1));
 }
 
+void Alarm::on_group_fire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto task = std::move(task_);
+  lock.unlock();
+  std::move(task).Run();
+}
+
 }  // namespace os
 }  // namespace bluetooth
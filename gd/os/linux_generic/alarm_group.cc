@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/alarm_group.h"
+
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "common/bind.h"
+#include "os/linux_generic/linux.h"
+#include "os/log.h"
+#include "os/utils.h"
+
+#ifdef OS_ANDROID
+#define ALARM_CLOCK CLOCK_BOOTTIME_ALARM
+#else
+#define ALARM_CLOCK CLOCK_BOOTTIME
+#endif
+
+namespace bluetooth {
+namespace os {
+using common::Closure;
+
+AlarmGroup::AlarmGroup(Handler* handler, std::chrono::milliseconds coalescing_window)
+    : handler_(handler), coalescing_window_(coalescing_window), fd_(TIMERFD_CREATE(ALARM_CLOCK, 0)) {
+  ASSERT_LOG(fd_ != -1, "cannot create timerfd: %s", strerror(errno));
+  ASSERT(coalescing_window_.count() >= 0);
+
+  token_ = handler_->thread_->GetReactor()->Register(
+      fd_, common::Bind(&AlarmGroup::on_fire, common::Unretained(this)), Closure());
+}
+
+AlarmGroup::~AlarmGroup() {
+  handler_->thread_->GetReactor()->Unregister(token_);
+
+  int close_status;
+  RUN_NO_INTR(close_status = TIMERFD_CLOSE(fd_));
+  ASSERT(close_status != -1);
+  ASSERT_LOG(members_.empty(), "%zu alarms outlived their group", members_.size());
+}
+
+uint64_t AlarmGroup::GetWakeupCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return wakeup_count_;
+}
+
+std::chrono::milliseconds AlarmGroup::Now() {
+  timespec now;
+  int result = clock_gettime(CLOCK_BOOTTIME, &now);
+  ASSERT(result == 0);
+  return std::chrono::milliseconds(now.tv_sec * 1000LL + now.tv_nsec / 1000000);
+}
+
+int AlarmGroup::Register(Closure on_fire) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int id = next_id_++;
+  members_[id].on_fire = std::move(on_fire);
+  return id;
+}
+
+void AlarmGroup::Unregister(int id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto member = members_.find(id);
+  ASSERT(member != members_.end());
+  cancel_locked(&member->second);
+  members_.erase(member);
+}
+
+void AlarmGroup::ScheduleAt(int id, std::chrono::milliseconds deadline) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Member& member = members_.at(id);
+  cancel_locked(&member);
+
+  member.scheduled = true;
+  member.deadline = deadlines_.emplace(deadline, id);
+  // Only an earlier deadline moves the timer; a later one is picked up when the timer fires
+  if (member.deadline == deadlines_.begin()) rearm_locked();
+}
+
+void AlarmGroup::Cancel(int id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cancel_locked(&members_.at(id));
+}
+
+void AlarmGroup::cancel_locked(Member* member) {
+  member->generation++;
+  if (!member->scheduled) return;
+
+  bool was_first = member->deadline == deadlines_.begin();
+  deadlines_.erase(member->deadline);
+  member->scheduled = false;
+  if (was_first) rearm_locked();
+}
+
+void AlarmGroup::rearm_locked() {
+  itimerspec timer_itimerspec{/* disarm timer */};
+  armed_time_ = std::chrono::milliseconds(0);
+  if (!deadlines_.empty()) {
+    // Wait for as long as the earliest deadline tolerates, so later alarms can join the same wakeup
+    armed_time_ = deadlines_.begin()->first + coalescing_window_;
+    long delay_ms = std::max<long>((armed_time_ - Now()).count(), 1);
+    timer_itimerspec.it_value = {delay_ms / 1000, delay_ms % 1000 * 1000000};
+  }
+  int result = TIMERFD_SETTIME(fd_, 0, &timer_itimerspec, nullptr);
+  ASSERT(result == 0);
+}
+
+void AlarmGroup::on_fire() {
+  std::vector<std::pair<int, uint64_t>> expired;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t times_invoked;
+    auto bytes_read = read(fd_, &times_invoked, sizeof(uint64_t));
+    ASSERT(bytes_read == static_cast<ssize_t>(sizeof(uint64_t)));
+    wakeup_count_++;
+
+    // The timer doesn't fire before its armed time, so anything due by then has expired even if the clock we
+    // read rounds down
+    auto now = std::max(Now(), armed_time_);
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+      Member& member = members_.at(deadlines_.begin()->second);
+      expired.emplace_back(deadlines_.begin()->second, member.generation);
+      member.scheduled = false;
+      deadlines_.erase(deadlines_.begin());
+    }
+    rearm_locked();
+  }
+
+  for (const auto& [id, generation] : expired) {
+    Closure on_fire;
+    {
+      // An earlier callback may have canceled, rescheduled, or destroyed this alarm
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto member = members_.find(id);
+      if (member == members_.end() || member->second.generation != generation) continue;
+      on_fire = member->second.on_fire;
+    }
+    on_fire.Run();
+  }
+}
+
+}  // namespace os
+}  // namespace bluetooth
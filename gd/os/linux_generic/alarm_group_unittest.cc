@@ -0,0 +1,151 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/alarm_group.h"
+
+#include <future>
+
+#include "common/bind.h"
+#include "gtest/gtest.h"
+#include "os/alarm.h"
+#include "os/repeating_alarm.h"
+
+namespace bluetooth {
+namespace os {
+namespace {
+
+using common::BindOnce;
+
+constexpr int kCoalescingWindowMs = 20;
+constexpr int kDelayErrorMs = 5;
+
+class AlarmGroupTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    thread_ = new Thread("test_thread", Thread::Priority::NORMAL);
+    handler_ = new Handler(thread_);
+    group_ = new AlarmGroup(handler_, std::chrono::milliseconds(kCoalescingWindowMs));
+  }
+
+  void TearDown() override {
+    delete group_;
+    handler_->Clear();
+    delete handler_;
+    delete thread_;
+  }
+  AlarmGroup* group_;
+
+ private:
+  Handler* handler_;
+  Thread* thread_;
+};
+
+TEST_F(AlarmGroupTest, cancel_while_not_armed) {
+  Alarm alarm(group_);
+  alarm.Cancel();
+}
+
+TEST_F(AlarmGroupTest, schedule_fires_within_window) {
+  Alarm alarm(group_);
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  auto before = std::chrono::steady_clock::now();
+  int delay_ms = 10;
+  alarm.Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)), std::chrono::milliseconds(delay_ms));
+  future.get();
+  auto after = std::chrono::steady_clock::now();
+  auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+  ASSERT_GE(duration_ms.count(), delay_ms);
+  ASSERT_LE(duration_ms.count(), delay_ms + kCoalescingWindowMs + kDelayErrorMs);
+}
+
+TEST_F(AlarmGroupTest, nearby_alarms_share_one_wakeup) {
+  Alarm first(group_);
+  Alarm second(group_);
+  std::promise<void> first_promise;
+  std::promise<void> second_promise;
+  first.Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&first_promise)), std::chrono::milliseconds(10));
+  second.Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&second_promise)), std::chrono::milliseconds(20));
+  first_promise.get_future().get();
+  second_promise.get_future().get();
+  ASSERT_EQ(group_->GetWakeupCount(), 1u);
+}
+
+TEST_F(AlarmGroupTest, cancel_alarm) {
+  Alarm alarm(group_);
+  alarm.Schedule(BindOnce([]() { ASSERT_TRUE(false) << "Should not happen"; }), std::chrono::milliseconds(3));
+  alarm.Cancel();
+  std::this_thread::sleep_for(std::chrono::milliseconds(3 + kCoalescingWindowMs + 5));
+  ASSERT_EQ(group_->GetWakeupCount(), 0u);
+}
+
+TEST_F(AlarmGroupTest, cancel_other_alarm_from_callback) {
+  Alarm first(group_);
+  Alarm second(group_);
+  std::promise<void> promise;
+  first.Schedule(
+      BindOnce(
+          [](Alarm* other, std::promise<void>* promise) {
+            other->Cancel();
+            promise->set_value();
+          },
+          common::Unretained(&second),
+          common::Unretained(&promise)),
+      std::chrono::milliseconds(1));
+  second.Schedule(BindOnce([]() { ASSERT_TRUE(false) << "Should not happen"; }), std::chrono::milliseconds(2));
+  promise.get_future().get();
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+TEST_F(AlarmGroupTest, delete_while_alarm_armed) {
+  auto alarm = std::make_unique<Alarm>(group_);
+  alarm->Schedule(BindOnce([]() { ASSERT_TRUE(false) << "Should not happen"; }), std::chrono::milliseconds(1));
+  alarm = nullptr;
+  std::this_thread::sleep_for(std::chrono::milliseconds(1 + kCoalescingWindowMs + 5));
+}
+
+TEST_F(AlarmGroupTest, repeating_alarm_keeps_period) {
+  RepeatingAlarm alarm(group_);
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  int counter = 0;
+  int period_ms = 30;
+  int cycles = 5;
+  auto before = std::chrono::steady_clock::now();
+  alarm.Schedule(
+      common::Bind(
+          [](int* counter, int cycles, std::promise<void>* promise) {
+            if (++*counter == cycles) promise->set_value();
+          },
+          common::Unretained(&counter),
+          cycles,
+          common::Unretained(&promise)),
+      std::chrono::milliseconds(period_ms));
+  future.get();
+  alarm.Cancel();
+  auto after = std::chrono::steady_clock::now();
+  auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+  // The lateness of each occurrence doesn't accumulate
+  ASSERT_GE(duration_ms.count(), period_ms * cycles);
+  ASSERT_LE(duration_ms.count(), period_ms * cycles + kCoalescingWindowMs + kDelayErrorMs);
+}
+
+}  // namespace
+}  // namespace os
+}  // namespace bluetooth
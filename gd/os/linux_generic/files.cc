@@ -187,5 +187,57 @@ bool WriteToFile(const std::string& path, const std::string& data) {
   return true;
 }
 
+bool AppendToFile(const std::string& path, const std::string& data) {
+  ASSERT(!path.empty());
+  bool is_new_file = !FileExists(path);
+  int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd < 0) {
+    LOG_ERROR("unable to open file '%s', error: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t result = write(fd, data.data() + written, data.size() - written);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERROR("unable to append to file '%s', error: %s", path.c_str(), strerror(errno));
+      close(fd);
+      return false;
+    }
+    written += result;
+  }
+
+  // Unlike WriteToFile(), the appended data is only safe once this returns, hence fail when fsync() fails
+  if (fsync(fd) != 0) {
+    LOG_ERROR("unable to fsync file '%s', error: %s", path.c_str(), strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  if (close(fd) != 0) {
+    LOG_ERROR("unable to close file '%s', error: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  if (is_new_file) {
+    // A new directory entry must also make it to disk for the file to be found after a crash
+    std::string temp_path_for_dir(path);
+    std::string directory_path(dirname(temp_path_for_dir.data()));
+    int dir_fd = open(directory_path.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0) {
+      LOG_ERROR("unable to open dir '%s', error: %s", directory_path.c_str(), strerror(errno));
+      return false;
+    }
+    if (fsync(dir_fd) != 0) {
+      LOG_WARN("unable to fsync dir '%s', error: %s", directory_path.c_str(), strerror(errno));
+    }
+    close(dir_fd);
+  }
+  return true;
+}
+
 }  // namespace os
 }  // namespace bluetooth
\ No newline at end of file
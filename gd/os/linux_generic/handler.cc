@@ -19,12 +19,18 @@
 #include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "common/bind.h"
 #include "common/callback.h"
 #include "os/log.h"
 #include "os/reactor.h"
+#include "os/trace.h"
 #include "os/utils.h"
 
 #ifndef EFD_SEMAPHORE
@@ -33,53 +39,172 @@
 
 namespace bluetooth {
 namespace os {
+using common::InlineClosure;
 using common::OnceClosure;
 
-Handler::Handler(Thread* thread)
-    : tasks_(new std::queue<OnceClosure>()), thread_(thread), fd_(eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK)) {
-  ASSERT(fd_ != -1);
+// Multiple producer, single consumer queue after Dmitry Vyukov's: producers link their task with a single exchange
+// on |head_|, the reactor thread pops from |tail_|, which always points at an already consumed node. The eventfd is
+// only written by the post that finds the queue idle, so a busy handler takes no system call per task.
+class Handler::TaskQueue {
+ public:
+  // Tasks run per wake up before the other reactables of the thread get a turn
+  static constexpr size_t kMaxTasksPerWakeUp = 32;
+
+  TaskQueue() : fd_(eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK)), head_(new Task()), tail_(head_.load()) {
+    ASSERT(fd_ != -1);
+  }
+
+  ~TaskQueue() {
+    // Also frees the tasks posted while the handler was being cleared
+    while (tail_ != nullptr) {
+      Task* next = tail_->next.load(std::memory_order_acquire);
+      delete tail_;
+      tail_ = next;
+    }
+    int close_status;
+    RUN_NO_INTR(close_status = close(fd_));
+    ASSERT(close_status != -1);
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(TaskQueue);
+
+  int GetFd() const {
+    return fd_;
+  }
+
+  bool IsCleared() const {
+    return cleared_.load(std::memory_order_acquire);
+  }
+
+  // May be called on any thread
+  void Push(InlineClosure closure) {
+    Task* task = new Task(std::move(closure));
+    Task* previous = head_.exchange(task, std::memory_order_acq_rel);
+    previous->next.store(task, std::memory_order_release);
+    if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+      wake_up();
+    }
+  }
+
+  void Clear() {
+    std::vector<InlineClosure> discarded;
+    {
+      std::lock_guard<std::mutex> lock(consumer_mutex_);
+      ASSERT_LOG(!cleared_, "Handlers must only be cleared once");
+      cleared_ = true;
+      InlineClosure closure;
+      while (try_pop(&closure)) {
+        discarded.push_back(std::move(closure));
+      }
+    }
+    uint64_t val;
+    while (eventfd_read(fd_, &val) == 0) {
+    }
+  }
+
+  // Runs on the reactor thread
+  void RunTasks() {
+    uint64_t val = 0;
+    auto read_result = eventfd_read(fd_, &val);
+    for (size_t i = 0; i < kMaxTasksPerWakeUp; i++) {
+      InlineClosure closure;
+      {
+        std::lock_guard<std::mutex> lock(consumer_mutex_);
+        if (cleared_) {
+          return;
+        }
+        ASSERT_LOG(read_result != -1, "eventfd read error %d %s", errno, strerror(errno));
+        if (pending_.load(std::memory_order_acquire) == 0) {
+          return;
+        }
+        // A producer counts its task only once it's queued, but the link from the previous task may not be visible
+        // yet
+        while (!try_pop(&closure)) {
+          std::this_thread::yield();
+        }
+      }
+      std::move(closure).Run();
+      if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Idle again, the next post wakes the reactor up
+        return;
+      }
+    }
+    wake_up();
+  }
+
+ private:
+  struct Task {
+    Task() = default;
+    explicit Task(InlineClosure closure) : closure(std::move(closure)) {}
+    std::atomic<Task*> next{nullptr};
+    InlineClosure closure;
+  };
+
+  void wake_up() {
+    auto write_result = eventfd_write(fd_, 1);
+    ASSERT(write_result != -1);
+  }
+
+  // Must be called with |consumer_mutex_| held
+  bool try_pop(InlineClosure* closure) {
+    Task* next = tail_->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    *closure = std::move(next->closure);
+    delete tail_;
+    tail_ = next;
+    return true;
+  }
+
+  const int fd_;
+  std::atomic<Task*> head_;
+  // Tasks queued and not run yet
+  std::atomic<size_t> pending_{0};
+  // Only serializes the reactor thread with Clear(), producers never take it
+  std::mutex consumer_mutex_;
+  Task* tail_;
+  std::atomic_bool cleared_{false};
+};
+
+Handler::Handler(Thread* thread) : tasks_(std::make_shared<TaskQueue>()), thread_(thread) {
   reactable_ = thread_->GetReactor()->Register(
-      fd_, common::Bind(&Handler::handle_next_event, common::Unretained(this)), common::Closure());
+      tasks_->GetFd(), common::Bind(&Handler::handle_next_event, tasks_), common::Closure());
 }
 
 Handler::~Handler() {
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    ASSERT_LOG(was_cleared(), "Handlers must be cleared before they are destroyed");
-  }
-
-  int close_status;
-  RUN_NO_INTR(close_status = close(fd_));
-  ASSERT(close_status != -1);
+  ASSERT_LOG(was_cleared(), "Handlers must be cleared before they are destroyed");
 }
 
 void Handler::Post(OnceClosure closure) {
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (was_cleared()) {
-      LOG_WARN("Posting to a handler which has been cleared");
-      return;
-    }
-    tasks_->emplace(std::move(closure));
-  }
-  uint64_t val = 1;
-  auto write_result = eventfd_write(fd_, val);
-  ASSERT(write_result != -1);
+  enqueue(InlineClosure([closure = std::move(closure)]() mutable { std::move(closure).Run(); }));
 }
 
-void Handler::Clear() {
-  std::queue<OnceClosure>* tmp = nullptr;
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    ASSERT_LOG(!was_cleared(), "Handlers must only be cleared once");
-    std::swap(tasks_, tmp);
+void Handler::enqueue(InlineClosure closure) {
+  if (was_cleared()) {
+    LOG_WARN("Posting to a handler which has been cleared");
+    return;
   }
-  delete tmp;
-
-  uint64_t val;
-  while (eventfd_read(fd_, &val) == 0) {
+  if (trace::IsEnabled()) {
+    closure = trace_task(std::move(closure));
   }
+  tasks_->Push(std::move(closure));
+}
+
+InlineClosure Handler::trace_task(InlineClosure closure) {
+  // The wait in the queue is a flow from the posting thread, the run a slice of the handler thread
+  std::string name = "Queued on " + thread_->GetThreadName();
+  int32_t flow_id = trace::NewFlowId();
+  trace::BeginFlow(name.c_str(), flow_id);
+  return InlineClosure([closure = std::move(closure), name = std::move(name), flow_id]() mutable {
+    trace::EndFlow(name.c_str(), flow_id);
+    trace::ScopedSlice slice("Handler task");
+    std::move(closure).Run();
+  });
+}
 
+void Handler::Clear() {
+  tasks_->Clear();
   thread_->GetReactor()->Unregister(reactable_);
   reactable_ = nullptr;
 }
@@ -89,22 +214,12 @@ void Handler::WaitUntilStopped(std::chrono::milliseconds timeout) {
   ASSERT(thread_->GetReactor()->WaitForUnregisteredReactable(timeout));
 }
 
-void Handler::handle_next_event() {
-  common::OnceClosure closure;
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    uint64_t val = 0;
-    auto read_result = eventfd_read(fd_, &val);
-
-    if (was_cleared()) {
-      return;
-    }
-    ASSERT_LOG(read_result != -1, "eventfd read error %d %s", errno, strerror(errno));
+bool Handler::was_cleared() const {
+  return tasks_->IsCleared();
+}
 
-    closure = std::move(tasks_->front());
-    tasks_->pop();
-  }
-  std::move(closure).Run();
+void Handler::handle_next_event(std::shared_ptr<TaskQueue> tasks) {
+  tasks->RunTasks();
 }
 
 }  // namespace os
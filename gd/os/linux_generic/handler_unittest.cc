@@ -20,6 +20,7 @@
 
 #include <future>
 #include <thread>
+#include <vector>
 
 #include "common/bind.h"
 #include "common/callback.h"
@@ -110,6 +111,63 @@ TEST_F(HandlerTest, callback_with_promise) {
   handler_->Clear();
 }
 
+TEST_F(HandlerTest, call_with_move_only_argument) {
+  std::promise<int> promise;
+  auto future = promise.get_future();
+  handler_->Call([](std::promise<int>* promise, std::unique_ptr<int> value) { promise->set_value(*value); }, &promise,
+                 std::make_unique<int>(42));
+  EXPECT_EQ(future.get(), 42);
+  handler_->Clear();
+}
+
+TEST_F(HandlerTest, call_on_with_wrapped_argument) {
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  int val = 0;
+  // Unretained() needs BindOnce(), which CallOn() falls back to
+  handler_->CallOn(
+      &promise,
+      [](std::promise<void>* promise, int* val) {
+        *val = 1;
+        promise->set_value();
+      },
+      common::Unretained(&val));
+  future.wait();
+  EXPECT_EQ(val, 1);
+  handler_->Clear();
+}
+
+TEST_F(HandlerTest, post_from_multiple_threads) {
+  constexpr int kThreads = 4;
+  constexpr int kTasksPerThread = 10000;
+  // Only touched on the handler thread
+  std::vector<int> last_task(kThreads, -1);
+  int tasks_run = 0;
+  bool in_order = true;
+  std::promise<void> all_run;
+  auto future = all_run.get_future();
+  std::vector<std::thread> producers;
+  for (int thread = 0; thread < kThreads; thread++) {
+    producers.emplace_back([&, thread] {
+      for (int task = 0; task < kTasksPerThread; task++) {
+        handler_->Call([&, thread, task] {
+          in_order &= last_task[thread] == task - 1;
+          last_task[thread] = task;
+          if (++tasks_run == kThreads * kTasksPerThread) {
+            all_run.set_value();
+          }
+        });
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  future.wait();
+  EXPECT_TRUE(in_order);
+  handler_->Clear();
+}
+
 // For Death tests, all the threading needs to be done in the ASSERT_DEATH call
 class HandlerDeathTest : public ::testing::Test {
  protected:
@@ -65,6 +65,20 @@ void Queue<T>::RegisterDequeue(Handler* handler, DequeueCallback callback) {
       dequeue_.reactive_semaphore_.GetFd(), callback, base::Closure());
 }
 
+template <typename T>
+void Queue<T>::RegisterDequeueBatch(Handler* handler, size_t max_batch_size, DequeueBatchCallback callback) {
+  ASSERT(max_batch_size > 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(dequeue_.handler_ == nullptr);
+  ASSERT(dequeue_.reactable_ == nullptr);
+  dequeue_.handler_ = handler;
+  dequeue_.reactable_ = dequeue_.handler_->thread_->GetReactor()->Register(
+      dequeue_.reactive_semaphore_.GetFd(),
+      base::Bind(
+          &Queue<T>::DequeueBatchCallbackInternal, base::Unretained(this), max_batch_size, std::move(callback)),
+      base::Closure());
+}
+
 template <typename T>
 void Queue<T>::UnregisterDequeue() {
   Reactor* reactor = nullptr;
@@ -93,22 +107,58 @@ std::unique_ptr<T> Queue<T>::TryDequeue() {
     return nullptr;
   }
 
-  dequeue_.reactive_semaphore_.Decrease();
-
   std::unique_ptr<T> data = std::move(queue_.front());
   queue_.pop();
 
+  if (queue_.empty()) {
+    dequeue_.reactive_semaphore_.Decrease();
+  }
   enqueue_.reactive_semaphore_.Increase();
 
   return data;
 }
 
+template <typename T>
+std::vector<std::unique_ptr<T>> Queue<T>::TryDequeueBatch(size_t max_count) {
+  std::vector<std::unique_ptr<T>> batch;
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (queue_.empty() || max_count == 0) {
+    return batch;
+  }
+
+  size_t count = std::min(max_count, queue_.size());
+  batch.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    batch.push_back(std::move(queue_.front()));
+    queue_.pop();
+  }
+
+  if (queue_.empty()) {
+    dequeue_.reactive_semaphore_.Decrease();
+  }
+  enqueue_.reactive_semaphore_.Increase(count);
+
+  return batch;
+}
+
 template <typename T>
 void Queue<T>::EnqueueCallbackInternal(EnqueueCallback callback) {
   std::unique_ptr<T> data = callback.Run();
   ASSERT(data != nullptr);
   std::lock_guard<std::mutex> lock(mutex_);
   enqueue_.reactive_semaphore_.Decrease();
+  bool was_empty = queue_.empty();
   queue_.push(std::move(data));
-  dequeue_.reactive_semaphore_.Increase();
+  if (was_empty) {
+    dequeue_.reactive_semaphore_.Increase();
+  }
+}
+
+template <typename T>
+void Queue<T>::DequeueBatchCallbackInternal(size_t max_batch_size, DequeueBatchCallback callback) {
+  std::vector<std::unique_ptr<T>> batch = TryDequeueBatch(max_batch_size);
+  if (!batch.empty()) {
+    callback.Run(std::move(batch));
+  }
 }
@@ -21,6 +21,7 @@
 #include <atomic>
 #include <future>
 #include <unordered_map>
+#include <vector>
 
 #include "common/bind.h"
 #include "gtest/gtest.h"
@@ -800,6 +801,80 @@ TEST_F(QueueTest, unregister_dequeue_and_wait) {
   delete indicator;
 }
 
+void fill_queue(Queue<std::string>* queue, Handler* handler, int count) {
+  TestEnqueueEnd test_enqueue_end(queue, handler);
+  for (int i = 0; i < count; i++) {
+    test_enqueue_end.buffer_.push(std::make_unique<std::string>(std::to_string(i)));
+  }
+  std::unordered_map<int, std::promise<int>> enqueue_promise_map;
+  enqueue_promise_map.emplace(std::piecewise_construct, std::forward_as_tuple(0), std::forward_as_tuple());
+  auto enqueue_future = enqueue_promise_map[0].get_future();
+  test_enqueue_end.RegisterEnqueue(&enqueue_promise_map);
+  enqueue_future.wait();
+}
+
+TEST_F(QueueTest, try_dequeue_batch) {
+  Queue<std::string> queue(kQueueSize);
+  EXPECT_TRUE(queue.TryDequeueBatch(kQueueSize).empty());
+
+  fill_queue(&queue, enqueue_handler_, kQueueSize);
+
+  auto batch = queue.TryDequeueBatch(kHalfOfQueueSize);
+  ASSERT_EQ(batch.size(), (size_t)kHalfOfQueueSize);
+  for (int i = 0; i < kHalfOfQueueSize; i++) {
+    EXPECT_EQ(*batch[i], std::to_string(i));
+  }
+
+  // Asking for more than is available returns the rest
+  batch = queue.TryDequeueBatch(kDoubleOfQueueSize);
+  ASSERT_EQ(batch.size(), (size_t)(kQueueSize - kHalfOfQueueSize));
+  EXPECT_EQ(*batch.front(), std::to_string(kHalfOfQueueSize));
+  EXPECT_EQ(queue.TryDequeue(), nullptr);
+
+  // The freed capacity is available to the enqueue end again
+  fill_queue(&queue, enqueue_handler_, kQueueSize);
+  EXPECT_EQ(queue.TryDequeueBatch(kDoubleOfQueueSize).size(), (size_t)kQueueSize);
+}
+
+TEST_F(QueueTest, register_dequeue_batch) {
+  constexpr size_t kMaxBatchSize = 4;
+  Queue<std::string> queue(kQueueSize);
+  fill_queue(&queue, enqueue_handler_, kQueueSize);
+
+  std::vector<size_t> batch_sizes;
+  std::vector<std::string> received;
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  queue.RegisterDequeueBatch(
+      dequeue_handler_,
+      kMaxBatchSize,
+      common::Bind(
+          [](Queue<std::string>* queue,
+             std::vector<size_t>* batch_sizes,
+             std::vector<std::string>* received,
+             std::promise<void>* promise,
+             std::vector<std::unique_ptr<std::string>> batch) {
+            batch_sizes->push_back(batch.size());
+            for (auto& data : batch) {
+              received->push_back(*data);
+            }
+            if (received->size() == (size_t)kQueueSize) {
+              queue->UnregisterDequeue();
+              promise->set_value();
+            }
+          },
+          common::Unretained(&queue),
+          common::Unretained(&batch_sizes),
+          common::Unretained(&received),
+          common::Unretained(&promise)));
+  future.wait();
+
+  EXPECT_EQ(batch_sizes, (std::vector<size_t>{4, 4, 2}));
+  for (int i = 0; i < kQueueSize; i++) {
+    EXPECT_EQ(received[i], std::to_string(i));
+  }
+}
+
 // Create all threads for death tests in the function that dies
 class QueueDeathTest : public ::testing::Test {
  public:
@@ -44,9 +44,8 @@ void ReactiveSemaphore::Decrease() {
   ASSERT_LOG(read_result != -1, "decrease failed: %s", strerror(errno));
 }
 
-void ReactiveSemaphore::Increase() {
-  uint64_t val = 1;
-  auto write_result = eventfd_write(fd_, val);
+void ReactiveSemaphore::Increase(uint64_t value) {
+  auto write_result = eventfd_write(fd_, value);
   ASSERT_LOG(write_result != -1, "increase failed: %s", strerror(errno));
 }
 
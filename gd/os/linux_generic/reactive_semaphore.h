@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 #include "os/utils.h"
 
 namespace bluetooth {
@@ -29,8 +31,8 @@ class ReactiveSemaphore {
   ~ReactiveSemaphore();
   // Decrements the value of |fd_|, this will cause a crash if |fd_| unreadable.
   void Decrease();
-  // Increase the value of |fd_|, this will cause a crash if |fd_| unwritable.
-  void Increase();
+  // Increase the value of |fd_| by |value|, this will cause a crash if |fd_| unwritable.
+  void Increase(uint64_t value = 1);
   int GetFd();
 
   DISALLOW_COPY_AND_ASSIGN(ReactiveSemaphore);
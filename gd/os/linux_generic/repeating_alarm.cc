@@ -22,6 +22,7 @@
 #include <cstring>
 
 #include "common/bind.h"
+#include "os/alarm_group.h"
 #include "os/linux_generic/linux.h"
 #include "os/log.h"
 #include "os/utils.h"
@@ -43,7 +44,17 @@ RepeatingAlarm::RepeatingAlarm(Handler* handler) : handler_(handler), fd_(TIMERF
       fd_, common::Bind(&RepeatingAlarm::on_fire, common::Unretained(this)), common::Closure());
 }
 
+RepeatingAlarm::RepeatingAlarm(AlarmGroup* group)
+    : handler_(group->handler_), fd_(-1), token_(nullptr), group_(group) {
+  group_id_ = group_->Register(common::Bind(&RepeatingAlarm::on_group_fire, common::Unretained(this)));
+}
+
 RepeatingAlarm::~RepeatingAlarm() {
+  if (group_ != nullptr) {
+    group_->Unregister(group_id_);
+    return;
+  }
+
   handler_->thread_->GetReactor()->Unregister(token_);
 
   int close_status;
@@ -53,6 +64,15 @@ RepeatingAlarm::~RepeatingAlarm() {
 
 void RepeatingAlarm::Schedule(Closure task, std::chrono::milliseconds period) {
   std::lock_guard<std::mutex> lock(mutex_);
+  if (group_ != nullptr) {
+    ASSERT(period.count() > 0);
+    task_ = std::move(task);
+    period_ = period;
+    next_deadline_ = AlarmGroup::Now() + period;
+    group_->ScheduleAt(group_id_, next_deadline_);
+    return;
+  }
+
   long period_ms = period.count();
   itimerspec timer_itimerspec{{period_ms / 1000, period_ms % 1000 * 1000000},
                               {period_ms / 1000, period_ms % 1000 * 1000000}};
@@ -64,6 +84,11 @@ void RepeatingAlarm::Schedule(Closure task, std::chrono::milliseconds period) {
 
 void RepeatingAlarm::Cancel() {
   std::lock_guard<std::mutex> lock(mutex_);
+  if (group_ != nullptr) {
+    group_->Cancel(group_id_);
+    return;
+  }
+
   itimerspec disarm_itimerspec{/* disarm timer */};
   int result = TIMERFD_SETTIME(fd_, 0, &disarm_itimerspec, nullptr);
   ASSERT(result == 0);
@@ -79,5 +104,18 @@ void RepeatingAlarm::on_fire() {
   ASSERT(bytes_read == static_cast<ssize_t>(sizeof(uint64_t)));
 }
 
+void RepeatingAlarm::on_group_fire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto task = task_;
+  // Keep to the original schedule, skipping the occurrences whose coalescing window has already passed
+  auto latest = AlarmGroup::Now() - group_->GetCoalescingWindow();
+  do {
+    next_deadline_ += period_;
+  } while (next_deadline_ < latest);
+  group_->ScheduleAt(group_id_, next_deadline_);
+  lock.unlock();
+  task.Run();
+}
+
 }  // namespace os
 }  // namespace bluetooth
@@ -24,6 +24,7 @@
 #include <cstring>
 
 #include "os/log.h"
+#include "os/trace.h"
 
 namespace bluetooth {
 namespace os {
@@ -45,6 +46,7 @@ void Thread::run(Priority priority) {
       LOG_ERROR("unable to set SCHED_FIFO priority: %s", strerror(errno));
     }
   }
+  trace::Init();
   reactor_.Run();
 }
 
@@ -18,9 +18,11 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <functional>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 #include "common/bind.h"
 #include "common/callback.h"
@@ -48,10 +50,13 @@ template <typename T>
 class IQueueDequeue {
  public:
   using DequeueCallback = common::Callback<void()>;
+  using DequeueBatchCallback = common::Callback<void(std::vector<std::unique_ptr<T>>)>;
   virtual ~IQueueDequeue() = default;
   virtual void RegisterDequeue(Handler* handler, DequeueCallback callback) = 0;
+  virtual void RegisterDequeueBatch(Handler* handler, size_t max_batch_size, DequeueBatchCallback callback) = 0;
   virtual void UnregisterDequeue() = 0;
   virtual std::unique_ptr<T> TryDequeue() = 0;
+  virtual std::vector<std::unique_ptr<T>> TryDequeueBatch(size_t max_count) = 0;
 };
 
 template <typename T>
@@ -63,6 +68,9 @@ class Queue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
   // A function moving data form queue to dequeue end buffer, it will be continually be invoked until queue
   // is empty. TryDequeue should be use in this function to get data from queue.
   using DequeueCallback = common::Callback<void()>;
+  // A function receiving up to the registered maximum number of pieces of data, in queue order, each time the
+  // queue has data ready for dequeue.
+  using DequeueBatchCallback = common::Callback<void(std::vector<std::unique_ptr<T>>)>;
   // Create a queue with |capacity| is the maximum number of messages a queue can contain
   explicit Queue(size_t capacity);
   ~Queue();
@@ -74,19 +82,30 @@ class Queue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
   // Register |callback| that will be called on |handler| when the queue has at least one piece of data ready
   // for dequeue. This will cause a crash if handler or callback has already been registered before.
   void RegisterDequeue(Handler* handler, DequeueCallback callback) override;
-  // Unregister current DequeueCallback from this queue, this will cause a crash if not registered yet.
+  // Register |callback| that will be called on |handler| with at most |max_batch_size| pieces of data each time the
+  // queue has data ready for dequeue. This will cause a crash if handler or callback has already been registered
+  // before. Use UnregisterDequeue to unregister.
+  void RegisterDequeueBatch(Handler* handler, size_t max_batch_size, DequeueBatchCallback callback) override;
+  // Unregister current DequeueCallback or DequeueBatchCallback from this queue, this will cause a crash if not
+  // registered yet.
   void UnregisterDequeue() override;
 
   // Try to dequeue an item from this queue. Return nullptr when there is nothing in the queue.
   std::unique_ptr<T> TryDequeue() override;
+  // Try to dequeue up to |max_count| items from this queue, in queue order. Return an empty vector when there is
+  // nothing in the queue.
+  std::vector<std::unique_ptr<T>> TryDequeueBatch(size_t max_count) override;
 
  private:
   void EnqueueCallbackInternal(EnqueueCallback callback);
+  void DequeueBatchCallbackInternal(size_t max_batch_size, DequeueBatchCallback callback);
   // An internal queue that holds at most |capacity| pieces of data
   std::queue<std::unique_ptr<T>> queue_;
   // A mutex that guards data in this queue
   std::mutex mutex_;
 
+  // The dequeue end semaphore is only raised when the queue goes from empty to non-empty and lowered when it becomes
+  // empty again, so a burst of enqueued data costs a single eventfd write and its reactor stays level triggered.
   class QueueEndpoint {
    public:
 #ifdef OS_LINUX_GENERIC
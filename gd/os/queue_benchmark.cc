@@ -15,6 +15,7 @@
  */
 
 #include <future>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "os/handler.h"
@@ -137,6 +138,45 @@ class TestDequeueEnd {
   }
 };
 
+class TestBatchDequeueEnd {
+ public:
+  explicit TestBatchDequeueEnd(
+      int64_t count, size_t max_batch_size, Queue<std::string>* queue, Handler* handler, std::promise<void>* promise)
+      : count_(count), max_batch_size_(max_batch_size), handler_(handler), queue_(queue), promise_(promise) {}
+
+  void RegisterDequeue() {
+    handler_->Post(common::BindOnce(&TestBatchDequeueEnd::handle_register_dequeue, common::Unretained(this)));
+  }
+
+  void DequeueBatchCallbackForTest(std::vector<std::unique_ptr<std::string>> batch) {
+    for (auto& data : batch) {
+      buffer_.push(std::move(*data));
+    }
+
+    count_ -= batch.size();
+    if (count_ == 0) {
+      queue_->UnregisterDequeue();
+      promise_->set_value();
+    }
+  }
+
+  std::queue<std::string> buffer_;
+  int64_t count_;
+
+ private:
+  size_t max_batch_size_;
+  Handler* handler_;
+  Queue<std::string>* queue_;
+  std::promise<void>* promise_;
+
+  void handle_register_dequeue() {
+    queue_->RegisterDequeueBatch(
+        handler_,
+        max_batch_size_,
+        common::Bind(&TestBatchDequeueEnd::DequeueBatchCallbackForTest, common::Unretained(this)));
+  }
+};
+
 BENCHMARK_DEFINE_F(BM_QueuePerformance, send_packet_vary_by_packet_num)(State& state) {
   for (auto _ : state) {
     int64_t num_data_to_send_ = state.range(0);
@@ -159,6 +199,7 @@ BENCHMARK_DEFINE_F(BM_QueuePerformance, send_packet_vary_by_packet_num)(State& s
   }
 
   state.SetBytesProcessed(static_cast<int_fast64_t>(state.iterations()) * state.range(0));
+  state.SetItemsProcessed(static_cast<int_fast64_t>(state.iterations()) * state.range(0));
 };
 
 BENCHMARK_REGISTER_F(BM_QueuePerformance, send_packet_vary_by_packet_num)
@@ -193,6 +234,7 @@ BENCHMARK_DEFINE_F(BM_QueuePerformance, send_10000_packet_vary_by_packet_size)(S
   }
 
   state.SetBytesProcessed(static_cast<int_fast64_t>(state.iterations()) * state.range(0) * 10000);
+  state.SetItemsProcessed(static_cast<int_fast64_t>(state.iterations()) * 10000);
 };
 
 BENCHMARK_REGISTER_F(BM_QueuePerformance, send_10000_packet_vary_by_packet_size)
@@ -202,5 +244,82 @@ BENCHMARK_REGISTER_F(BM_QueuePerformance, send_10000_packet_vary_by_packet_size)
     ->Iterations(100)
     ->UseRealTime();
 
+BENCHMARK_DEFINE_F(BM_QueuePerformance, send_packet_batched_vary_by_packet_num)(State& state) {
+  for (auto _ : state) {
+    int64_t num_data_to_send_ = state.range(0);
+    size_t max_batch_size = state.range(1);
+    Queue<std::string> queue(num_data_to_send_);
+
+    // register batched dequeue
+    std::promise<void> dequeue_promise;
+    auto dequeue_future = dequeue_promise.get_future();
+    TestBatchDequeueEnd test_dequeue_end(num_data_to_send_, max_batch_size, &queue, enqueue_handler_, &dequeue_promise);
+    test_dequeue_end.RegisterDequeue();
+
+    // Push data to enqueue end buffer and register enqueue
+    std::promise<void> enqueue_promise;
+    TestEnqueueEnd test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
+    for (int i = 0; i < num_data_to_send_; i++) {
+      std::string data = std::to_string(1);
+      test_enqueue_end.push(std::move(data));
+    }
+    dequeue_future.wait();
+  }
+
+  state.SetBytesProcessed(static_cast<int_fast64_t>(state.iterations()) * state.range(0));
+  state.SetItemsProcessed(static_cast<int_fast64_t>(state.iterations()) * state.range(0));
+};
+
+BENCHMARK_REGISTER_F(BM_QueuePerformance, send_packet_batched_vary_by_packet_num)
+    ->Args({10, 8})
+    ->Args({10, 64})
+    ->Args({100, 8})
+    ->Args({100, 64})
+    ->Args({1000, 8})
+    ->Args({1000, 64})
+    ->Args({10000, 8})
+    ->Args({10000, 64})
+    ->Args({100000, 8})
+    ->Args({100000, 64})
+    ->Iterations(100)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_QueuePerformance, send_10000_packet_batched_vary_by_packet_size)(State& state) {
+  for (auto _ : state) {
+    int64_t num_data_to_send_ = 10000;
+    int64_t packet_size = state.range(0);
+    size_t max_batch_size = state.range(1);
+    Queue<std::string> queue(num_data_to_send_);
+
+    // register batched dequeue
+    std::promise<void> dequeue_promise;
+    auto dequeue_future = dequeue_promise.get_future();
+    TestBatchDequeueEnd test_dequeue_end(num_data_to_send_, max_batch_size, &queue, enqueue_handler_, &dequeue_promise);
+    test_dequeue_end.RegisterDequeue();
+
+    // Push data to enqueue end buffer and register enqueue
+    std::promise<void> enqueue_promise;
+    TestEnqueueEnd test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
+    for (int i = 0; i < num_data_to_send_; i++) {
+      std::string data = std::string(packet_size, 'x');
+      test_enqueue_end.push(std::move(data));
+    }
+    dequeue_future.wait();
+  }
+
+  state.SetBytesProcessed(static_cast<int_fast64_t>(state.iterations()) * state.range(0) * 10000);
+  state.SetItemsProcessed(static_cast<int_fast64_t>(state.iterations()) * 10000);
+};
+
+BENCHMARK_REGISTER_F(BM_QueuePerformance, send_10000_packet_batched_vary_by_packet_size)
+    ->Args({10, 8})
+    ->Args({10, 64})
+    ->Args({100, 8})
+    ->Args({100, 64})
+    ->Args({1000, 8})
+    ->Args({1000, 64})
+    ->Iterations(100)
+    ->UseRealTime();
+
 }  // namespace os
 }  // namespace bluetooth
@@ -28,6 +28,8 @@
 namespace bluetooth {
 namespace os {
 
+class AlarmGroup;
+
 // A repeating alarm for reactor-based thread, implemented by Linux timerfd.
 // When it's constructed, it will register a reactable on the specified thread; when it's destroyed, it will unregister
 // itself from the thread.
@@ -36,6 +38,10 @@ class RepeatingAlarm {
   // Create and register a repeating alarm on a given handler
   explicit RepeatingAlarm(Handler* handler);
 
+  // Create a repeating alarm sharing the timer of |group|, firing on the handler of the group. Each occurrence may
+  // fire up to the coalescing window of the group late, without the lateness accumulating over periods.
+  explicit RepeatingAlarm(AlarmGroup* group);
+
   // Unregister this alarm from the thread and release resource
   ~RepeatingAlarm();
 
@@ -53,7 +59,12 @@ class RepeatingAlarm {
   int fd_ = 0;
   Reactor::Reactable* token_;
   mutable std::mutex mutex_;
+  AlarmGroup* group_ = nullptr;
+  int group_id_ = -1;
+  std::chrono::milliseconds period_{0};
+  std::chrono::milliseconds next_deadline_{0};
   void on_fire();
+  void on_group_fire();
 };
 
 }  // namespace os
@@ -17,6 +17,7 @@
 #include <future>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "common/bind.h"
@@ -64,6 +65,7 @@ class BM_ReactorThread : public BM_ThreadPerformance {
     handler_ = std::make_unique<Handler>(thread_.get());
   }
   void TearDown(State& st) override {
+    handler_->Clear();
     handler_ = nullptr;
     thread_->Stop();
     thread_ = nullptr;
@@ -115,3 +117,29 @@ BENCHMARK_REGISTER_F(BM_ReactorThread, sequential_execution)
     ->Arg(100000)
     ->Iterations(1)
     ->UseRealTime();
+
+// Posts from several threads at once, as the HCI, L2CAP and profile threads do
+BENCHMARK_DEFINE_F(BM_ReactorThread, batch_call_on_multiple_producers)(State& state) {
+  constexpr int kProducers = 4;
+  for (auto _ : state) {
+    num_messages_to_send_ = state.range(0);
+    counter_ = 0;
+    counter_promise_ = std::promise<void>();
+    std::future<void> counter_future = counter_promise_.get_future();
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducers; producer++) {
+      producers.emplace_back([this] {
+        for (int i = 0; i < num_messages_to_send_ / kProducers; i++) {
+          handler_->CallOn(this, &BM_ReactorThread_batch_call_on_multiple_producers_Benchmark::callback_batch);
+        }
+      });
+    }
+    for (auto& producer : producers) {
+      producer.join();
+    }
+    counter_future.wait();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+};
+
+BENCHMARK_REGISTER_F(BM_ReactorThread, batch_call_on_multiple_producers)->Arg(100000)->Iterations(1)->UseRealTime();
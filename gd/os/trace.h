@@ -0,0 +1,120 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__ANDROID__)
+#include <cutils/trace.h>
+#endif
+
+// Always-on tracing of the work crossing the stack threads, shared by gd and the legacy stack, hence header only and
+// free of gd dependencies. On Android, events go to atrace under the app tag, which Perfetto records with
+// atrace_apps: "com.android.bluetooth". Elsewhere tracing is compiled out.
+//
+// Each trace point first checks IsEnabled(), which is a single load and branch, and only then builds its event.
+namespace bluetooth {
+namespace os {
+namespace trace {
+
+#if defined(__ANDROID__)
+
+constexpr uint64_t kTraceTag = ATRACE_TAG_APP;
+
+// Reads the enabled tags for IsEnabled(), to be called once per thread before its first trace point. Until then, the
+// not-ready tags read as disabled.
+inline void Init() {
+  atrace_init();
+}
+
+inline bool IsEnabled() {
+  return __builtin_expect((atrace_enabled_tags & kTraceTag) != 0, 0);
+}
+
+// A slice of the calling thread, ended by the next EndSlice() of the same thread
+inline void BeginSlice(const char* name) {
+  atrace_begin(kTraceTag, name);
+}
+
+inline void EndSlice() {
+  atrace_end(kTraceTag);
+}
+
+// A slice that may end on another thread, matched by |name| and |flow_id|
+inline void BeginFlow(const char* name, int32_t flow_id) {
+  atrace_async_begin(kTraceTag, name, flow_id);
+}
+
+inline void EndFlow(const char* name, int32_t flow_id) {
+  atrace_async_end(kTraceTag, name, flow_id);
+}
+
+inline void Counter(const char* name, int64_t value) {
+  atrace_int64(kTraceTag, name, value);
+}
+
+#else
+
+inline void Init() {}
+inline bool IsEnabled() {
+  return false;
+}
+inline void BeginSlice(const char* name) {}
+inline void EndSlice() {}
+inline void BeginFlow(const char* name, int32_t flow_id) {}
+inline void EndFlow(const char* name, int32_t flow_id) {}
+inline void Counter(const char* name, int64_t value) {}
+
+#endif
+
+// A flow id for work that has no identity of its own, such as a posted task
+inline int32_t NewFlowId() {
+  static std::atomic<int32_t> next_flow_id{1};
+  return next_flow_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The flow id of an object that crosses threads by pointer, such as a packet, so that the threads it goes through
+// annotate it alike
+inline int32_t FlowIdOf(const void* object) {
+  uint64_t address = reinterpret_cast<uintptr_t>(object);
+  return static_cast<int32_t>(address ^ (address >> 32));
+}
+
+// Traces the enclosing scope as a slice when tracing is enabled
+class ScopedSlice {
+ public:
+  explicit ScopedSlice(const char* name) : active_(IsEnabled()) {
+    if (active_) {
+      BeginSlice(name);
+    }
+  }
+  ~ScopedSlice() {
+    if (active_) {
+      EndSlice();
+    }
+  }
+  ScopedSlice(const ScopedSlice&) = delete;
+  ScopedSlice& operator=(const ScopedSlice&) = delete;
+
+ private:
+  const bool active_;
+};
+
+}  // namespace trace
+}  // namespace os
+}  // namespace bluetooth
@@ -44,5 +44,25 @@ void BitInserter::insert_byte(uint8_t byte) {
   insert_bits(byte, 8);
 }
 
+void BitInserter::insert_bytes(const uint8_t* data, size_t size) {
+  copy_bytes(data, size);
+}
+
+void BitInserter::copy_bytes(const uint8_t* data, size_t size) {
+  if (num_saved_bits_ == 0 && !has_observers()) {
+    container->insert(container->end(), data, data + size);
+    return;
+  }
+  for (size_t i = 0; i < size; i++) {
+    insert_byte(data[i]);
+  }
+}
+
+void BitInserter::reserve(size_t num_bytes) {
+  if (container->empty()) {
+    container->reserve(num_bytes);
+  }
+}
+
 }  // namespace packet
 }  // namespace bluetooth
@@ -35,6 +35,18 @@ class BitInserter : public ByteInserter {
 
   void insert_byte(uint8_t byte) override;
 
+  // Insert |size| bytes starting at |data|. Subclasses may keep a reference to |data| instead of copying it, in
+  // which case the bytes must stay valid until the serialized packet has been consumed.
+  virtual void insert_bytes(const uint8_t* data, size_t size);
+
+  // Insert a copy of |size| bytes starting at |data|, which only need to be valid during the call. Appended to the
+  // vector at once when byte aligned and no observer needs to see the bytes one by one.
+  virtual void copy_bytes(const uint8_t* data, size_t size);
+
+  // Reserve room for |num_bytes| bytes if nothing was inserted yet. Called by the outermost packet serialized with its
+  // total size, so that the vector is only allocated once.
+  virtual void reserve(size_t num_bytes);
+
  protected:
   size_t num_saved_bits_{0};
   uint8_t saved_bits_{0};
@@ -40,6 +40,8 @@ class ByteInserter : public std::back_insert_iterator<std::vector<uint8_t>> {
  protected:
   void on_byte(uint8_t);
 
+  bool has_observers() const;
+
  private:
   std::vector<ByteObserver> registered_observers_;
 };
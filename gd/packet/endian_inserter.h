@@ -42,13 +42,15 @@ class EndianInserter {
   template <typename FixedWidthPODType, typename std::enable_if<std::is_pod<FixedWidthPODType>::value, int>::type = 0>
   void insert(FixedWidthPODType value, BitInserter& it) const {
     uint8_t* raw_bytes = (uint8_t*)&value;
+    if (little_endian == true) {
+      it.copy_bytes(raw_bytes, sizeof(FixedWidthPODType));
+      return;
+    }
+    uint8_t bytes[sizeof(FixedWidthPODType)];
     for (size_t i = 0; i < sizeof(FixedWidthPODType); i++) {
-      if (little_endian == true) {
-        it.insert_byte(raw_bytes[i]);
-      } else {
-        it.insert_byte(raw_bytes[sizeof(FixedWidthPODType) - i - 1]);
-      }
+      bytes[i] = raw_bytes[sizeof(FixedWidthPODType) - i - 1];
     }
+    it.copy_bytes(bytes, sizeof(FixedWidthPODType));
   }
 
   // Write sizeof(FixedWidthCustomType) bytes using the iterator
@@ -57,13 +59,15 @@ class EndianInserter {
       typename std::enable_if<std::is_base_of<CustomFieldFixedSizeInterface<T>, T>::value, int>::type = 0>
   void insert(const T& value, BitInserter& it) const {
     auto* raw_bytes = value.data();
+    if (little_endian == true) {
+      it.copy_bytes(raw_bytes, CustomFieldFixedSizeInterface<T>::length());
+      return;
+    }
+    uint8_t bytes[CustomFieldFixedSizeInterface<T>::length()];
     for (size_t i = 0; i < CustomFieldFixedSizeInterface<T>::length(); i++) {
-      if (little_endian == true) {
-        it.insert_byte(raw_bytes[i]);
-      } else {
-        it.insert_byte(raw_bytes[CustomFieldFixedSizeInterface<T>::length() - i - 1]);
-      }
+      bytes[i] = raw_bytes[CustomFieldFixedSizeInterface<T>::length() - i - 1];
     }
+    it.copy_bytes(bytes, CustomFieldFixedSizeInterface<T>::length());
   }
 
   // Write num_bits bits using the iterator
@@ -72,13 +76,15 @@ class EndianInserter {
   void insert(FixedWidthIntegerType value, BitInserter& it, size_t num_bits) const {
     ASSERT(num_bits <= (sizeof(FixedWidthIntegerType) * 8));
 
+    uint8_t bytes[sizeof(FixedWidthIntegerType)];
     for (size_t i = 0; i < num_bits / 8; i++) {
       if (little_endian == true) {
-        it.insert_byte(static_cast<uint8_t>(value >> (i * 8)));
+        bytes[i] = static_cast<uint8_t>(value >> (i * 8));
       } else {
-        it.insert_byte(static_cast<uint8_t>(value >> (((num_bits / 8) - i - 1) * 8)));
+        bytes[i] = static_cast<uint8_t>(value >> (((num_bits / 8) - i - 1) * 8));
       }
     }
+    it.copy_bytes(bytes, num_bits / 8);
     if (num_bits % 8) {
       it.insert_bits(static_cast<uint8_t>(value >> ((num_bits / 8) * 8)), num_bits % 8);
     }
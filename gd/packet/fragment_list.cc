@@ -0,0 +1,56 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/fragment_list.h"
+
+#include <algorithm>
+
+namespace bluetooth {
+namespace packet {
+
+void FragmentList::push_back(const View& view) {
+  if (view.size() == 0) {
+    return;
+  }
+  if (!first_.has_value()) {
+    first_.emplace(view);
+    first_end_ = view.size();
+    return;
+  }
+  size_t end = total_size() + view.size();
+  if (rest_ == nullptr) {
+    rest_ = std::make_shared<std::vector<Fragment>>();
+  } else if (rest_.use_count() > 1) {
+    // Copied by another FragmentList, which must not see this fragment
+    rest_ = std::make_shared<std::vector<Fragment>>(*rest_);
+  }
+  rest_->push_back({view, end});
+}
+
+size_t FragmentList::Find(size_t offset, size_t hint) const {
+  if (hint < size() && begin_offset(hint) <= offset && offset < end_offset(hint)) {
+    return hint;
+  }
+  if (offset < first_end_) {
+    return 0;
+  }
+  auto fragment = std::upper_bound(rest_->begin(), rest_->end(), offset,
+                                   [](size_t offset, const Fragment& fragment) { return offset < fragment.end; });
+  return 1 + (fragment - rest_->begin());
+}
+
+}  // namespace packet
+}  // namespace bluetooth
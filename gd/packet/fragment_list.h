@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "packet/view.h"
+
+namespace bluetooth {
+namespace packet {
+
+// The fragments of a PacketView, in order, with the offset in the packet at which each one ends, so that the fragment
+// holding a byte is found with a binary search rather than by walking the fragments.
+//
+// A small vector: the first fragment is kept inline, so that copying the PacketView of a single buffer, as every
+// received packet is, allocates nothing. The other fragments are shared by the copies until one of them appends.
+class FragmentList {
+ public:
+  FragmentList() = default;
+  FragmentList(const FragmentList&) = default;
+  FragmentList& operator=(const FragmentList&) = default;
+
+  // Append |view| after the last fragment. Empty views are skipped, they hold no byte.
+  void push_back(const View& view);
+
+  // Number of fragments
+  size_t size() const {
+    return !first_.has_value() ? 0 : 1 + (rest_ == nullptr ? 0 : rest_->size());
+  }
+
+  const View& view(size_t i) const {
+    return i == 0 ? *first_ : (*rest_)[i - 1].view;
+  }
+
+  // Offset in the packet of the first byte of fragment |i|
+  size_t begin_offset(size_t i) const {
+    return i == 0 ? 0 : end_offset(i - 1);
+  }
+
+  // Offset in the packet just past the last byte of fragment |i|
+  size_t end_offset(size_t i) const {
+    return i == 0 ? first_end_ : (*rest_)[i - 1].end;
+  }
+
+  // Total number of bytes
+  size_t total_size() const {
+    return size() == 0 ? 0 : end_offset(size() - 1);
+  }
+
+  // Index of the fragment holding the byte at |offset|, which must be less than total_size(). The fragment |hint| is
+  // checked first: sequential accesses mostly stay in the same fragment.
+  size_t Find(size_t offset, size_t hint) const;
+
+ private:
+  struct Fragment {
+    View view;
+    size_t end;
+  };
+
+  std::optional<View> first_;
+  size_t first_end_{0};
+  std::shared_ptr<std::vector<Fragment>> rest_;
+};
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/fragment_list.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+namespace bluetooth {
+namespace packet {
+namespace {
+
+View MakeView(size_t size, uint8_t first) {
+  auto data = std::make_shared<std::vector<uint8_t>>(size);
+  for (size_t i = 0; i < size; i++) {
+    data->at(i) = first + i;
+  }
+  return View(data, 0, size);
+}
+
+TEST(FragmentListTest, emptyTest) {
+  FragmentList list;
+  ASSERT_EQ(list.size(), 0u);
+  ASSERT_EQ(list.total_size(), 0u);
+  list.push_back(MakeView(0, 0));
+  ASSERT_EQ(list.size(), 0u);
+}
+
+TEST(FragmentListTest, offsetsTest) {
+  FragmentList list;
+  list.push_back(MakeView(3, 0));
+  list.push_back(MakeView(0, 0));
+  list.push_back(MakeView(10, 3));
+  list.push_back(MakeView(19, 13));
+  ASSERT_EQ(list.size(), 3u);
+  ASSERT_EQ(list.total_size(), 32u);
+  ASSERT_EQ(list.begin_offset(0), 0u);
+  ASSERT_EQ(list.end_offset(0), 3u);
+  ASSERT_EQ(list.begin_offset(1), 3u);
+  ASSERT_EQ(list.end_offset(1), 13u);
+  ASSERT_EQ(list.begin_offset(2), 13u);
+  ASSERT_EQ(list.end_offset(2), 32u);
+  ASSERT_EQ(list.view(2).size(), 19u);
+}
+
+TEST(FragmentListTest, findTest) {
+  FragmentList list;
+  for (size_t i = 0; i < 8; i++) {
+    list.push_back(MakeView(4, i * 4));
+  }
+  for (size_t offset = 0; offset < list.total_size(); offset++) {
+    for (size_t hint = 0; hint < list.size() + 1; hint++) {
+      size_t fragment = list.Find(offset, hint);
+      ASSERT_EQ(fragment, offset / 4);
+      ASSERT_EQ(list.view(fragment).data()[offset - list.begin_offset(fragment)], offset);
+    }
+  }
+}
+
+TEST(FragmentListTest, copiesDoNotSeeLaterFragments) {
+  FragmentList list;
+  list.push_back(MakeView(1, 0));
+  list.push_back(MakeView(1, 1));
+  FragmentList copy(list);
+  list.push_back(MakeView(1, 2));
+  copy.push_back(MakeView(5, 2));
+  ASSERT_EQ(list.size(), 3u);
+  ASSERT_EQ(list.total_size(), 3u);
+  ASSERT_EQ(copy.size(), 3u);
+  ASSERT_EQ(copy.total_size(), 7u);
+}
+
+}  // namespace
+}  // namespace packet
+}  // namespace bluetooth
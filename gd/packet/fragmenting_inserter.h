@@ -33,6 +33,11 @@ class FragmentingInserter : public BitInserter {
 
   void insert_bits(uint8_t byte, size_t num_bits) override;
 
+  void copy_bytes(const uint8_t* data, size_t size) override;
+
+  // The fragments are allocated as they are filled
+  void reserve(size_t) override {}
+
   void finalize();
 
  protected:
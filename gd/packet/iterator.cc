@@ -22,14 +22,12 @@ namespace bluetooth {
 namespace packet {
 
 template <bool little_endian>
-Iterator<little_endian>::Iterator(std::forward_list<View> data, size_t offset) {
+Iterator<little_endian>::Iterator(FragmentList data, size_t offset) {
   data_ = data;
   index_ = offset;
   begin_ = 0;
-  end_ = 0;
-  for (auto& view : data) {
-    end_ += view.size();
-  }
+  end_ = data_.total_size();
+  fragment_ = 0;
 }
 
 template <bool little_endian>
@@ -98,6 +96,7 @@ Iterator<little_endian>& Iterator<little_endian>::operator=(const Iterator<littl
   this->begin_ = itr.begin_;
   this->end_ = itr.end_;
   this->index_ = itr.index_;
+  this->fragment_ = itr.fragment_;
   return *this;
 }
 
@@ -134,16 +133,22 @@ bool Iterator<little_endian>::operator>=(const Iterator<little_endian>& itr) con
 template <bool little_endian>
 uint8_t Iterator<little_endian>::operator*() const {
   ASSERT_LOG(index_ < end_ && !(begin_ > index_), "Index %zu out of bounds: [%zu,%zu)", index_, begin_, end_);
-  size_t index = index_;
+  fragment_ = data_.Find(index_, fragment_);
+  return data_.view(fragment_).data()[index_ - data_.begin_offset(fragment_)];
+}
 
-  for (auto view : data_) {
-    if (index < view.size()) {
-      return view[index];
-    }
-    index -= view.size();
+template <bool little_endian>
+const uint8_t* Iterator<little_endian>::ContiguousBytes(size_t length) const {
+  if (begin_ > index_ || index_ >= end_ || end_ - index_ < length) {
+    return nullptr;
+  }
+  fragment_ = data_.Find(index_, fragment_);
+  size_t offset = index_ - data_.begin_offset(fragment_);
+  const View& view = data_.view(fragment_);
+  if (view.size() - offset < length) {
+    return nullptr;
   }
-  ASSERT_LOG(false, "Out of fragments searching for index %zu", index_);
-  return 0;
+  return view.data() + offset;
 }
 
 template <bool little_endian>
@@ -17,11 +17,12 @@
 #pragma once
 
 #include <cstdint>
-#include <forward_list>
+#include <cstring>
 #include <memory>
 #include <type_traits>
 
 #include "packet/custom_field_fixed_size_interface.h"
+#include "packet/fragment_list.h"
 #include "packet/view.h"
 
 namespace bluetooth {
@@ -31,7 +32,7 @@ namespace packet {
 template <bool little_endian>
 class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t> {
  public:
-  Iterator(std::forward_list<View> data, size_t offset);
+  Iterator(FragmentList data, size_t offset);
   Iterator(const Iterator& itr) = default;
   virtual ~Iterator() = default;
 
@@ -72,9 +73,16 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
     FixedWidthPODType extracted_value{};
     uint8_t* value_ptr = (uint8_t*)&extracted_value;
 
+    const uint8_t* data = ContiguousBytes(sizeof(FixedWidthPODType));
+    if (data != nullptr && little_endian) {
+      std::memcpy(value_ptr, data, sizeof(FixedWidthPODType));
+      index_ += sizeof(FixedWidthPODType);
+      return extracted_value;
+    }
     for (size_t i = 0; i < sizeof(FixedWidthPODType); i++) {
       size_t index = (little_endian ? i : sizeof(FixedWidthPODType) - i - 1);
-      value_ptr[index] = *((*this)++);
+      value_ptr[index] = data != nullptr ? data[i] : **this;
+      ++(*this);
     }
     return extracted_value;
   }
@@ -82,18 +90,25 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
   template <typename T, typename std::enable_if<std::is_base_of_v<CustomFieldFixedSizeInterface<T>, T>, int>::type = 0>
   T extract() {
     T extracted_value{};
+    const uint8_t* data = ContiguousBytes(CustomFieldFixedSizeInterface<T>::length());
     for (size_t i = 0; i < CustomFieldFixedSizeInterface<T>::length(); i++) {
       size_t index = (little_endian ? i : CustomFieldFixedSizeInterface<T>::length() - i - 1);
-      extracted_value.data()[index] = *((*this)++);
+      extracted_value.data()[index] = data != nullptr ? data[i] : **this;
+      ++(*this);
     }
     return extracted_value;
   }
 
  private:
-  std::forward_list<View> data_;
+  // The next |length| bytes, if they are in bounds and within a single fragment, nullptr otherwise
+  const uint8_t* ContiguousBytes(size_t length) const;
+
+  FragmentList data_;
   size_t index_;
   size_t begin_;
   size_t end_;
+  // Fragment of the last byte read, where the next one most likely is
+  mutable size_t fragment_;
 };
 
 }  // namespace packet
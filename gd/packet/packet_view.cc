@@ -24,16 +24,25 @@ namespace bluetooth {
 namespace packet {
 
 template <bool little_endian>
-PacketView<little_endian>::PacketView(const std::forward_list<class View> fragments)
-    : fragments_(fragments), length_(0) {
-  for (auto fragment : fragments_) {
-    length_ += fragment.size();
+PacketView<little_endian>::PacketView(const std::forward_list<class View> fragments) {
+  for (const auto& fragment : fragments) {
+    fragments_.push_back(fragment);
   }
+  length_ = fragments_.total_size();
+  UpdateContiguousData();
 }
 
 template <bool little_endian>
-PacketView<little_endian>::PacketView(std::shared_ptr<std::vector<uint8_t>> packet)
-    : fragments_({View(packet, 0, packet->size())}), length_(packet->size()) {}
+PacketView<little_endian>::PacketView(std::shared_ptr<std::vector<uint8_t>> packet) : length_(packet->size()) {
+  fragments_.push_back(View(packet, 0, packet->size()));
+  UpdateContiguousData();
+}
+
+template <bool little_endian>
+PacketView<little_endian>::PacketView(FragmentList fragments)
+    : fragments_(fragments), length_(fragments_.total_size()) {
+  UpdateContiguousData();
+}
 
 template <bool little_endian>
 Iterator<little_endian> PacketView<little_endian>::begin() const {
@@ -53,14 +62,11 @@ uint8_t PacketView<little_endian>::operator[](size_t index) const {
 template <bool little_endian>
 uint8_t PacketView<little_endian>::at(size_t index) const {
   ASSERT_LOG(index < length_, "Index %zu out of bounds", index);
-  for (const auto& fragment : fragments_) {
-    if (index < fragment.size()) {
-      return fragment[index];
-    }
-    index -= fragment.size();
+  if (contiguous_data_ != nullptr) {
+    return contiguous_data_[index];
   }
-  ASSERT_LOG(false, "Out of fragments searching for index %zu", index);
-  return 0;
+  size_t fragment = fragments_.Find(index, 0);
+  return fragments_.view(fragment).data()[index - fragments_.begin_offset(fragment)];
 }
 
 template <bool little_endian>
@@ -69,22 +75,39 @@ size_t PacketView<little_endian>::size() const {
 }
 
 template <bool little_endian>
-std::forward_list<View> PacketView<little_endian>::GetSubviewList(size_t begin, size_t end) const {
+void PacketView<little_endian>::CopyTo(uint8_t* dest) const {
+  for (size_t i = 0; i < fragments_.size(); i++) {
+    const View& fragment = fragments_.view(i);
+    std::copy_n(fragment.data(), fragment.size(), dest);
+    dest += fragment.size();
+  }
+}
+
+template <bool little_endian>
+std::vector<Segment> PacketView<little_endian>::GetSegments() const {
+  std::vector<Segment> segments;
+  segments.reserve(fragments_.size());
+  for (size_t i = 0; i < fragments_.size(); i++) {
+    const View& fragment = fragments_.view(i);
+    segments.push_back({fragment.data(), fragment.size()});
+  }
+  return segments;
+}
+
+template <bool little_endian>
+FragmentList PacketView<little_endian>::GetSubviewList(size_t begin, size_t end) const {
   ASSERT(begin <= end);
   ASSERT(end <= length_);
 
-  std::forward_list<View> view_list;
-  std::forward_list<View>::iterator it = view_list.before_begin();
-  size_t length = end - begin;
-  for (const auto& fragment : fragments_) {
-    if (begin >= fragment.size()) {
-      begin -= fragment.size();
-    } else {
-      View view(fragment, begin, begin + std::min(length, fragment.size() - begin));
-      length -= view.size();
-      it = view_list.insert_after(it, view);
-      begin = 0;
-    }
+  FragmentList view_list;
+  if (begin == end) {
+    return view_list;
+  }
+  for (size_t i = fragments_.Find(begin, 0); i < fragments_.size() && fragments_.begin_offset(i) < end; i++) {
+    size_t fragment_begin = fragments_.begin_offset(i);
+    size_t view_begin = std::max(begin, fragment_begin) - fragment_begin;
+    size_t view_end = std::min(end, fragments_.end_offset(i)) - fragment_begin;
+    view_list.push_back(View(fragments_.view(i), view_begin, view_end));
   }
   return view_list;
 }
@@ -101,20 +124,19 @@ PacketView<false> PacketView<little_endian>::GetBigEndianSubview(size_t begin, s
 
 template <bool little_endian>
 void PacketView<little_endian>::Append(PacketView to_add) {
-  auto insertion_point = fragments_.begin();
-  size_t remaining_length = length_;
-  while (remaining_length > 0) {
-    remaining_length -= insertion_point->size();
-    if (remaining_length > 0) {
-      insertion_point++;
-    }
-  }
-  ASSERT(insertion_point != fragments_.end());
-  for (const auto& fragment : to_add.fragments_) {
-    fragments_.insert_after(insertion_point, fragment);
-    insertion_point++;
+  for (size_t i = 0; i < to_add.fragments_.size(); i++) {
+    fragments_.push_back(to_add.fragments_.view(i));
   }
   length_ += to_add.length_;
+  UpdateContiguousData();
+}
+
+template <bool little_endian>
+void PacketView<little_endian>::UpdateContiguousData() {
+  contiguous_data_ = nullptr;
+  if (fragments_.size() == 1) {
+    contiguous_data_ = fragments_.view(0).data();
+  }
 }
 
 // Explicit instantiations for both types of PacketViews.
@@ -17,9 +17,14 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <forward_list>
+#include <type_traits>
+#include <vector>
 
+#include "packet/fragment_list.h"
 #include "packet/iterator.h"
+#include "packet/segmenting_inserter.h"
 #include "packet/view.h"
 
 namespace bluetooth {
@@ -27,6 +32,31 @@ namespace packet {
 
 static const bool kLittleEndian = true;
 
+template <bool little_endian>
+class PacketView;
+
+// Reads a field at an offset known when the packet parser is generated, with the same interface as Iterator::extract.
+// When the PacketView is a single fragment, as the packets received from the HAL are, the field is loaded directly from
+// it; otherwise, the bytes are gathered through an Iterator.
+template <bool little_endian>
+class FixedOffsetReader {
+ public:
+  FixedOffsetReader(const PacketView<little_endian>* view, size_t offset) : view_(view), offset_(offset) {}
+
+  template <typename FixedWidthPODType, typename std::enable_if<std::is_pod<FixedWidthPODType>::value, int>::type = 0>
+  FixedWidthPODType extract() const;
+
+  template <typename T, typename std::enable_if<std::is_base_of_v<CustomFieldFixedSizeInterface<T>, T>, int>::type = 0>
+  T extract() const;
+
+ private:
+  // Copies |length| bytes at the offset to |dest| in host order, returns false if they are not in a single fragment
+  bool Load(uint8_t* dest, size_t length) const;
+
+  const PacketView<little_endian>* view_;
+  size_t offset_;
+};
+
 // Abstract base class that is subclassed to provide type-specifc accessors.
 // Holds a shared pointer to the underlying data.
 // The template parameter little_endian controls the generation of extract().
@@ -53,14 +83,74 @@ class PacketView {
 
   PacketView<false> GetBigEndianSubview(size_t begin, size_t end) const;
 
+  // Copy the bytes of every fragment, in order, to |dest|, which must hold size() bytes. Reassembled PacketViews keep
+  // the payloads they were built from as fragments, so this is where a consumer needing contiguous bytes copies them.
+  void CopyTo(uint8_t* dest) const;
+
+  // The contiguous runs of bytes backing this PacketView, in order, for consumers that can take them as they are (e.g.
+  // with writev). They stay valid for as long as this PacketView is alive.
+  std::vector<Segment> GetSegments() const;
+
  protected:
   void Append(PacketView to_add);
 
+  // Reader of the field at byte |offset|, for the generated getters of the fields at fixed offsets. The parser has
+  // already checked the size of the packet in IsValid().
+  FixedOffsetReader<little_endian> ReadFixedOffset(size_t offset) const {
+    return FixedOffsetReader<little_endian>(this, offset);
+  }
+
  private:
-  std::forward_list<View> fragments_;
+  friend class FixedOffsetReader<little_endian>;
+  template <bool>
+  friend class PacketView;
+
+  explicit PacketView(FragmentList fragments);
+
+  FragmentList fragments_;
   size_t length_;
-  std::forward_list<View> GetSubviewList(size_t begin, size_t end) const;
+  // The bytes of the only fragment, nullptr if there are several
+  const uint8_t* contiguous_data_;
+  FragmentList GetSubviewList(size_t begin, size_t end) const;
+  void UpdateContiguousData();
 };
 
+template <bool little_endian>
+bool FixedOffsetReader<little_endian>::Load(uint8_t* dest, size_t length) const {
+  const uint8_t* data = view_->contiguous_data_;
+  if (data == nullptr || offset_ + length > view_->length_) {
+    return false;
+  }
+  data += offset_;
+  if (little_endian) {
+    std::memcpy(dest, data, length);
+  } else {
+    for (size_t i = 0; i < length; i++) {
+      dest[length - i - 1] = data[i];
+    }
+  }
+  return true;
+}
+
+template <bool little_endian>
+template <typename FixedWidthPODType, typename std::enable_if<std::is_pod<FixedWidthPODType>::value, int>::type>
+FixedWidthPODType FixedOffsetReader<little_endian>::extract() const {
+  FixedWidthPODType extracted_value{};
+  if (!Load(reinterpret_cast<uint8_t*>(&extracted_value), sizeof(FixedWidthPODType))) {
+    extracted_value = (view_->begin() + offset_).template extract<FixedWidthPODType>();
+  }
+  return extracted_value;
+}
+
+template <bool little_endian>
+template <typename T, typename std::enable_if<std::is_base_of_v<CustomFieldFixedSizeInterface<T>, T>, int>::type>
+T FixedOffsetReader<little_endian>::extract() const {
+  T extracted_value{};
+  if (!Load(extracted_value.data(), CustomFieldFixedSizeInterface<T>::length())) {
+    extracted_value = (view_->begin() + offset_).template extract<T>();
+  }
+  return extracted_value;
+}
+
 }  // namespace packet
 }  // namespace bluetooth
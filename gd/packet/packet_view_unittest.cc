@@ -546,6 +546,45 @@ TEST_F(PacketViewMultiViewAppendTest, sizeTestAppend) {
   ASSERT_EQ(single_view.size(), multi_view.size());
 }
 
+TEST_F(PacketViewMultiViewAppendTest, copyToTestAppend) {
+  std::vector<uint8_t> copy(multi_view.size());
+  multi_view.CopyTo(copy.data());
+  ASSERT_EQ(copy, count_all);
+}
+
+TEST_F(PacketViewMultiViewAppendTest, copyToTestSubviewAcrossFragments) {
+  const size_t begin = count_1.size() - 1;
+  const size_t end = count_1.size() + count_2.size() + 1;
+  PacketView<true> subview = multi_view.GetLittleEndianSubview(begin, end);
+  std::vector<uint8_t> copy(subview.size());
+  subview.CopyTo(copy.data());
+  ASSERT_EQ(copy, std::vector<uint8_t>(count_all.begin() + begin, count_all.begin() + end));
+}
+
+TEST_F(PacketViewMultiViewAppendTest, getSegmentsTestAppend) {
+  std::vector<uint8_t> gathered;
+  for (const auto& segment : multi_view.GetSegments()) {
+    gathered.insert(gathered.end(), segment.data, segment.data + segment.size);
+  }
+  ASSERT_EQ(gathered, count_all);
+}
+
+TEST_F(PacketViewMultiViewAppendTest, getSegmentsTestSubviewReferencesFragments) {
+  const size_t begin = count_1.size() - 1;
+  const size_t end = count_1.size() + count_2.size() + 1;
+  PacketView<true> subview = multi_view.GetLittleEndianSubview(begin, end);
+  auto segments = subview.GetSegments();
+  ASSERT_EQ(segments.size(), 3u);
+  ASSERT_EQ(segments[0].size, 1u);
+  ASSERT_EQ(segments[1].size, count_2.size());
+  ASSERT_EQ(segments[2].size, 1u);
+  std::vector<uint8_t> gathered;
+  for (const auto& segment : segments) {
+    gathered.insert(gathered.end(), segment.data, segment.data + segment.size);
+  }
+  ASSERT_EQ(gathered, std::vector<uint8_t>(count_all.begin() + begin, count_all.begin() + end));
+}
+
 TEST_F(PacketViewMultiViewAppendTest, dereferenceTestLittleEndianAppend) {
   auto single_itr = single_view.begin();
   auto multi_itr = multi_view.begin();
@@ -571,6 +610,101 @@ TEST_F(PacketViewMultiViewAppendTest, arrayOperatorTestAppend) {
   ASSERT_DEATH(multi_view[single_view.size()], "");
 }
 
+// Exposes the reader used by the generated getters of the fields at fixed offsets
+template <bool little_endian>
+class FixedOffsetView : public PacketView<little_endian> {
+ public:
+  explicit FixedOffsetView(std::forward_list<View> fragments) : PacketView<little_endian>(fragments) {}
+  using PacketView<little_endian>::ReadFixedOffset;
+};
+
+std::forward_list<View> SingleFragment() {
+  return {View(std::make_shared<const vector<uint8_t>>(count_all), 0, count_all.size())};
+}
+
+std::forward_list<View> ThreeFragments() {
+  return {View(std::make_shared<const vector<uint8_t>>(count_1), 0, count_1.size()),
+          View(std::make_shared<const vector<uint8_t>>(count_2), 0, count_2.size()),
+          View(std::make_shared<const vector<uint8_t>>(count_3), 0, count_3.size())};
+}
+
+TEST(FixedOffsetReaderTest, littleEndianMatchesIterator) {
+  for (const auto& fragments : {SingleFragment(), ThreeFragments()}) {
+    FixedOffsetView<true> view(fragments);
+    for (int offset = 0; offset + 8 <= static_cast<int>(view.size()); offset++) {
+      ASSERT_EQ(view.ReadFixedOffset(offset).template extract<uint8_t>(), (view.begin() + offset).extract<uint8_t>());
+      ASSERT_EQ(view.ReadFixedOffset(offset).template extract<uint16_t>(), (view.begin() + offset).extract<uint16_t>());
+      ASSERT_EQ(view.ReadFixedOffset(offset).template extract<uint32_t>(), (view.begin() + offset).extract<uint32_t>());
+      ASSERT_EQ(view.ReadFixedOffset(offset).template extract<uint64_t>(), (view.begin() + offset).extract<uint64_t>());
+    }
+    ASSERT_EQ(view.ReadFixedOffset(2).template extract<uint16_t>(), 0x0302);
+  }
+}
+
+TEST(FixedOffsetReaderTest, bigEndianMatchesIterator) {
+  for (const auto& fragments : {SingleFragment(), ThreeFragments()}) {
+    FixedOffsetView<false> view(fragments);
+    for (int offset = 0; offset + 8 <= static_cast<int>(view.size()); offset++) {
+      ASSERT_EQ(view.ReadFixedOffset(offset).template extract<uint16_t>(), (view.begin() + offset).extract<uint16_t>());
+      ASSERT_EQ(view.ReadFixedOffset(offset).template extract<uint64_t>(), (view.begin() + offset).extract<uint64_t>());
+    }
+    ASSERT_EQ(view.ReadFixedOffset(2).template extract<uint16_t>(), 0x0203);
+  }
+}
+
+TEST(FixedOffsetReaderTest, customTypeMatchesIterator) {
+  for (const auto& fragments : {SingleFragment(), ThreeFragments()}) {
+    FixedOffsetView<true> view(fragments);
+    ASSERT_EQ(view.ReadFixedOffset(0x10).template extract<Address>(), Address({0x10, 0x11, 0x12, 0x13, 0x14, 0x15}));
+    FixedOffsetView<false> big_endian_view(fragments);
+    ASSERT_EQ(big_endian_view.ReadFixedOffset(0x10).template extract<Address>(),
+              Address({0x15, 0x14, 0x13, 0x12, 0x11, 0x10}));
+  }
+}
+
+TEST(FixedOffsetReaderTest, outOfBoundsReadFallsBackToIterator) {
+  FixedOffsetView<true> view(SingleFragment());
+  ASSERT_EQ(view.ReadFixedOffset(view.size() - 2).template extract<uint16_t>(), 0x1f1e);
+  ASSERT_DEATH(view.ReadFixedOffset(view.size() - 2).template extract<uint32_t>(), "");
+}
+
+TEST(PacketViewFragmentsTest, extractAcrossFragmentsMatchesBytes) {
+  PacketView<true> view(ThreeFragments());
+  for (size_t offset = 0; offset + 8 <= view.size(); offset++) {
+    uint64_t expected = 0;
+    for (size_t i = 0; i < 8; i++) {
+      expected |= static_cast<uint64_t>(view[offset + i]) << (8 * i);
+    }
+    auto it = view.begin() + offset;
+    ASSERT_EQ(it.extract<uint64_t>(), expected);
+    ASSERT_EQ(it, view.begin() + (offset + 8));
+  }
+  PacketView<false> big_endian_view(ThreeFragments());
+  ASSERT_EQ((big_endian_view.begin() + 1).extract<uint32_t>(), 0x01020304u);
+}
+
+TEST(PacketViewFragmentsTest, emptyFragmentsAreSkipped) {
+  auto empty = std::make_shared<const vector<uint8_t>>();
+  auto fragments = ThreeFragments();
+  fragments.push_front(View(empty, 0, 0));
+  PacketView<true> view(fragments);
+  ASSERT_EQ(view.size(), count_all.size());
+  ASSERT_EQ(view.GetSegments().size(), 3u);
+  for (size_t i = 0; i < view.size(); i++) {
+    ASSERT_EQ(view[i], count_all[i]);
+  }
+}
+
+TEST(PacketViewFragmentsTest, subviewWithinOneFragmentIsContiguous) {
+  PacketView<true> view(ThreeFragments());
+  auto subview = view.GetLittleEndianSubview(4, 12);
+  auto segments = subview.GetSegments();
+  ASSERT_EQ(segments.size(), 1u);
+  ASSERT_EQ(segments[0].size, 8u);
+  ASSERT_EQ(subview[0], 0x04);
+  ASSERT_EQ(view.GetLittleEndianSubview(2, 14).GetSegments().size(), 3u);
+}
+
 TEST(ViewTest, arrayOperatorTest) {
   View view_all(std::make_shared<const vector<uint8_t>>(count_all), 0, count_all.size());
   size_t past_end = view_all.size();
@@ -616,5 +750,29 @@ TEST(ViewTest, zeroSubviewTest) {
   View subview(view, view.size(), view.size() + 1);
   ASSERT_EQ(subview.size(), 0u);
 }
+
+TEST(ViewTest, externalBufferTest) {
+  uint8_t buffer[] = {0x00, 0x01, 0x02, 0x03};
+  int release_count = 0;
+  {
+    View view(buffer, sizeof(buffer), [&release_count]() { release_count++; });
+    ASSERT_EQ(view.size(), sizeof(buffer));
+    ASSERT_EQ(view[3], 0x03);
+
+    View subview(view, 1, 3);
+    PacketView<kLittleEndian> packet_view(std::forward_list<View>({subview}));
+    ASSERT_EQ(packet_view.size(), 2u);
+    ASSERT_EQ(packet_view[0], 0x01);
+    ASSERT_EQ(packet_view.begin().extract<uint16_t>(), 0x0201);
+    ASSERT_EQ(release_count, 0);
+  }
+  ASSERT_EQ(release_count, 1);
+}
+
+TEST(ViewTest, externalBufferEmptyReleaseTest) {
+  uint8_t buffer[] = {0x00, 0x01};
+  View view(buffer, sizeof(buffer), View::ReleaseCallback());
+  ASSERT_EQ(view[1], 0x01);
+}
 }  // namespace packet
 }  // namespace bluetooth
@@ -155,6 +155,11 @@ void ArrayField::GenParameterValidator(std::ostream&) const {
 }
 
 void ArrayField::GenInserter(std::ostream& s) const {
+  // Bytes are inserted at once
+  if (element_field_->GetFieldType() == ScalarField::kFieldType && element_field_->GetSize().bits() == 8) {
+    s << "i.insert_bytes(" << GetName() << "_.data(), " << GetName() << "_.size());";
+    return;
+  }
   s << "for (const auto& val_ : " << GetName() << "_) {";
   element_field_->GenInserter(s);
   s << "}\n";
@@ -97,8 +97,16 @@ std::string ScalarField::GetGetterFunctionName() const {
 void ScalarField::GenGetter(std::ostream& s, Size start_offset, Size end_offset) const {
   s << GetDataType() << " " << GetGetterFunctionName() << "() const {";
   s << "ASSERT(was_validated_);";
-  s << "auto to_bound = begin();";
-  int num_leading_bits = GenBounds(s, start_offset, end_offset, GetSize());
+  int num_leading_bits = 0;
+  if (!start_offset.empty() && !start_offset.has_dynamic()) {
+    // The offset is known now, and IsValid() checked the size of the fixed fields up front: read the field directly.
+    num_leading_bits = start_offset.bits() % 8;
+    s << "constexpr size_t " << GetName() << "_offset = " << start_offset.bits() / 8 << ";";
+    s << "auto " << GetName() << "_it = ReadFixedOffset(" << GetName() << "_offset);";
+  } else {
+    s << "auto to_bound = begin();";
+    num_leading_bits = GenBounds(s, start_offset, end_offset, GetSize());
+  }
   s << GetDataType() << " " << GetName() << "_value{};";
   s << GetDataType() << "* " << GetName() << "_ptr = &" << GetName() << "_value;";
   GenExtractor(s, num_leading_bits, false);
@@ -444,6 +444,10 @@ void ParentDef::GenSerialize(std::ostream& s) const {
 
   s << "public:";
   s << "virtual void Serialize(BitInserter& i) const override {";
+  if (parent_ == nullptr && GetDefinitionType() == Type::PACKET) {
+    // Only the outermost packet reserves, the inserter is already in use for the ones it contains
+    s << "i.reserve(size());";
+  }
   s << "SerializeHeader(i);";
   if (fields_.HasPayload()) {
     s << "payload_->Serialize(i);";
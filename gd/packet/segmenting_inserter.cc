@@ -0,0 +1,55 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/segmenting_inserter.h"
+
+namespace bluetooth {
+namespace packet {
+
+SegmentingInserter::SegmentingInserter(std::vector<uint8_t>& scratch) : BitInserter(scratch), scratch_(scratch) {}
+
+void SegmentingInserter::insert_bytes(const uint8_t* data, size_t size) {
+  if (size < kMinReferencedSize || num_saved_bits_ != 0 || has_observers()) {
+    BitInserter::insert_bytes(data, size);
+    return;
+  }
+  references_.push_back({scratch_.size(), {data, size}});
+  referenced_size_ += size;
+}
+
+std::vector<Segment> SegmentingInserter::GetSegments() const {
+  std::vector<Segment> segments;
+  segments.reserve(2 * references_.size() + 1);
+  size_t offset = 0;
+  for (const auto& reference : references_) {
+    if (reference.scratch_offset > offset) {
+      segments.push_back({scratch_.data() + offset, reference.scratch_offset - offset});
+      offset = reference.scratch_offset;
+    }
+    segments.push_back(reference.segment);
+  }
+  if (scratch_.size() > offset) {
+    segments.push_back({scratch_.data() + offset, scratch_.size() - offset});
+  }
+  return segments;
+}
+
+size_t SegmentingInserter::size() const {
+  return scratch_.size() + referenced_size_;
+}
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "packet/bit_inserter.h"
+
+namespace bluetooth {
+namespace packet {
+
+// A contiguous run of serialized bytes.
+struct Segment {
+  const uint8_t* data;
+  size_t size;
+};
+
+// Serializes a packet as a list of segments instead of a single buffer. Runs of bytes inserted with insert_bytes()
+// (e.g. the payload of a RawBuilder or a ViewBuilder) are referenced in place rather than copied, everything else
+// (headers, footers, unaligned bits) is copied to |scratch|. The builder being serialized must therefore outlive the
+// segments returned by GetSegments().
+//
+// Bytes are always copied while an observer is registered, since observers need to see every byte.
+class SegmentingInserter : public BitInserter {
+ public:
+  // Runs shorter than this are copied, writing them out separately costs more than copying them.
+  static constexpr size_t kMinReferencedSize = 64;
+
+  explicit SegmentingInserter(std::vector<uint8_t>& scratch);
+
+  void insert_bytes(const uint8_t* data, size_t size) override;
+
+  // |scratch| only holds the copied bytes, the total size would overestimate it
+  void reserve(size_t) override {}
+
+  // Returns the serialized packet, in order. Pointers into |scratch| are only valid until it is modified again.
+  std::vector<Segment> GetSegments() const;
+
+  // Total number of bytes serialized so far.
+  size_t size() const;
+
+ private:
+  struct Reference {
+    // Number of bytes in |scratch_| inserted before this reference.
+    size_t scratch_offset;
+    Segment segment;
+  };
+
+  std::vector<uint8_t>& scratch_;
+  std::vector<Reference> references_;
+  size_t referenced_size_{0};
+};
+
+}  // namespace packet
+}  // namespace bluetooth
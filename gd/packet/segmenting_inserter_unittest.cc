@@ -0,0 +1,175 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/segmenting_inserter.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "packet/packet_builder.h"
+#include "packet/raw_builder.h"
+#include "packet/view_builder.h"
+
+namespace bluetooth {
+namespace packet {
+namespace {
+
+// Two header bytes, the payload and one footer byte.
+class WrappingBuilder : public PacketBuilder<true> {
+ public:
+  explicit WrappingBuilder(std::unique_ptr<BasePacketBuilder> payload) : payload_(std::move(payload)) {}
+
+  size_t size() const override {
+    return payload_->size() + 3;
+  }
+
+  void Serialize(BitInserter& it) const override {
+    insert(static_cast<uint16_t>(payload_->size()), it);
+    payload_->Serialize(it);
+    insert(static_cast<uint8_t>(0xee), it);
+  }
+
+ private:
+  std::unique_ptr<BasePacketBuilder> payload_;
+};
+
+std::vector<uint8_t> make_payload(size_t size) {
+  std::vector<uint8_t> payload(size);
+  for (size_t i = 0; i < size; i++) {
+    payload[i] = static_cast<uint8_t>(i);
+  }
+  return payload;
+}
+
+std::vector<uint8_t> flatten(const std::vector<Segment>& segments) {
+  std::vector<uint8_t> bytes;
+  for (const auto& segment : segments) {
+    bytes.insert(bytes.end(), segment.data, segment.data + segment.size);
+  }
+  return bytes;
+}
+
+std::vector<uint8_t> serialize(const BasePacketBuilder& builder) {
+  std::vector<uint8_t> bytes;
+  BitInserter it(bytes);
+  builder.Serialize(it);
+  return bytes;
+}
+
+TEST(SegmentingInserterTest, referencesLargePayload) {
+  auto raw = std::make_unique<RawBuilder>(make_payload(200));
+  const RawBuilder* raw_ptr = raw.get();
+  WrappingBuilder builder(std::move(raw));
+
+  std::vector<uint8_t> scratch;
+  SegmentingInserter it(scratch);
+  builder.Serialize(it);
+  auto segments = it.GetSegments();
+
+  ASSERT_EQ(3, segments.size());
+  ASSERT_EQ(2, segments[0].size);
+  ASSERT_EQ(200, segments[1].size);
+  ASSERT_EQ(1, segments[2].size);
+  ASSERT_EQ(3, scratch.size());
+  ASSERT_EQ(builder.size(), it.size());
+  ASSERT_EQ(serialize(builder), flatten(segments));
+  ASSERT_EQ(serialize(*raw_ptr), std::vector<uint8_t>(segments[1].data, segments[1].data + segments[1].size));
+}
+
+TEST(SegmentingInserterTest, referencesViewWithoutCopy) {
+  std::vector<uint8_t> buffer = make_payload(100);
+  WrappingBuilder builder(std::make_unique<ViewBuilder>(View(buffer.data(), buffer.size(), nullptr)));
+
+  std::vector<uint8_t> scratch;
+  SegmentingInserter it(scratch);
+  builder.Serialize(it);
+  auto segments = it.GetSegments();
+
+  ASSERT_EQ(3, segments.size());
+  ASSERT_EQ(buffer.data(), segments[1].data);
+  ASSERT_EQ(serialize(builder), flatten(segments));
+}
+
+TEST(SegmentingInserterTest, copiesSmallPayload) {
+  WrappingBuilder builder(std::make_unique<RawBuilder>(make_payload(SegmentingInserter::kMinReferencedSize - 1)));
+
+  std::vector<uint8_t> scratch;
+  SegmentingInserter it(scratch);
+  builder.Serialize(it);
+  auto segments = it.GetSegments();
+
+  ASSERT_EQ(1, segments.size());
+  ASSERT_EQ(builder.size(), scratch.size());
+  ASSERT_EQ(serialize(builder), flatten(segments));
+}
+
+TEST(SegmentingInserterTest, copiesWhenObserved) {
+  WrappingBuilder builder(std::make_unique<RawBuilder>(make_payload(200)));
+
+  std::vector<uint8_t> scratch;
+  std::vector<uint8_t> observed;
+  SegmentingInserter it(scratch);
+  it.RegisterObserver(ByteObserver([&observed](uint8_t byte) { observed.push_back(byte); }, []() { return 0; }));
+  builder.Serialize(it);
+  it.UnregisterObserver();
+  auto segments = it.GetSegments();
+
+  ASSERT_EQ(1, segments.size());
+  ASSERT_EQ(serialize(builder), observed);
+  ASSERT_EQ(serialize(builder), flatten(segments));
+}
+
+TEST(SegmentingInserterTest, copiesWhenUnaligned) {
+  std::vector<uint8_t> payload = make_payload(100);
+
+  std::vector<uint8_t> scratch;
+  SegmentingInserter it(scratch);
+  it.insert_bits(0x5, 4);
+  it.insert_bytes(payload.data(), payload.size());
+  it.insert_bits(0xa, 4);
+  auto segments = it.GetSegments();
+
+  std::vector<uint8_t> expected;
+  BitInserter expected_it(expected);
+  expected_it.insert_bits(0x5, 4);
+  expected_it.insert_bytes(payload.data(), payload.size());
+  expected_it.insert_bits(0xa, 4);
+
+  ASSERT_EQ(1, segments.size());
+  ASSERT_EQ(expected, flatten(segments));
+}
+
+TEST(SegmentingInserterTest, multipleReferences) {
+  std::vector<uint8_t> first = make_payload(64);
+  std::vector<uint8_t> second = make_payload(80);
+
+  std::vector<uint8_t> scratch;
+  SegmentingInserter it(scratch);
+  it.insert_bytes(first.data(), first.size());
+  it.insert_bytes(second.data(), second.size());
+  it.insert_byte(0x42);
+  auto segments = it.GetSegments();
+
+  ASSERT_EQ(3, segments.size());
+  ASSERT_EQ(first.data(), segments[0].data);
+  ASSERT_EQ(second.data(), segments[1].data);
+  ASSERT_EQ(1, segments[2].size);
+  ASSERT_EQ(145, it.size());
+}
+
+}  // namespace
+}  // namespace packet
+}  // namespace bluetooth
@@ -22,8 +22,18 @@ namespace bluetooth {
 namespace packet {
 
 View::View(std::shared_ptr<const std::vector<uint8_t>> data, size_t begin, size_t end)
-    : data_(data), begin_(begin < data_->size() ? begin : data_->size()),
-      end_(end < data_->size() ? end : data_->size()) {}
+    : data_(data, data->data()), begin_(begin < data->size() ? begin : data->size()),
+      end_(end < data->size() ? end : data->size()) {}
+
+View::View(const uint8_t* data, size_t size, ReleaseCallback release)
+    : data_(
+          data,
+          [release](const uint8_t*) {
+            if (release) {
+              release();
+            }
+          }),
+      begin_(0), end_(size) {}
 
 View::View(const View& view, size_t begin, size_t end) : data_(view.data_) {
   begin_ = (begin < view.size() ? begin : view.size());
@@ -34,11 +44,15 @@ View::View(const View& view, size_t begin, size_t end) : data_(view.data_) {
 
 uint8_t View::operator[](size_t i) const {
   ASSERT_LOG(i + begin_ < end_, "Out of bounds access at %zu", i);
-  return data_->operator[](i + begin_);
+  return data_.get()[i + begin_];
 }
 
 size_t View::size() const {
   return end_ - begin_;
 }
+
+const uint8_t* View::data() const {
+  return data_.get() + begin_;
+}
 }  // namespace packet
 }  // namespace bluetooth
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -24,9 +25,16 @@ namespace bluetooth {
 namespace packet {
 
 // Base class that holds a shared pointer to data with bounds.
+// The data is either owned by a vector, or is an externally owned buffer that is handed back to its owner through a
+// release callback once the last View referencing it is destroyed.
 class View {
  public:
+  using ReleaseCallback = std::function<void()>;
+
   View(std::shared_ptr<const std::vector<uint8_t>> data, size_t begin, size_t end);
+  // Wrap |size| bytes at |data| without copying them. |data| must stay valid until |release| is called, which happens
+  // exactly once when neither this View nor any View derived from it is alive anymore. |release| may be empty.
+  View(const uint8_t* data, size_t size, ReleaseCallback release);
   View(const View& view, size_t begin, size_t end);
   View(const View& view) = default;
   virtual ~View() = default;
@@ -35,8 +43,11 @@ class View {
 
   size_t size() const;
 
+  // Contiguous bytes of this View, valid for as long as this View is alive.
+  const uint8_t* data() const;
+
  private:
-  std::shared_ptr<const std::vector<uint8_t>> data_;
+  std::shared_ptr<const uint8_t> data_;
   size_t begin_;
   size_t end_;
 };
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "packet/bit_inserter.h"
+#include "packet/packet_builder.h"
+#include "packet/view.h"
+
+namespace bluetooth {
+namespace packet {
+
+// Builder whose payload is the content of a View. The bytes are only read when the builder is serialized, so a
+// payload wrapping an externally owned buffer crosses into the stack without being copied first.
+class ViewBuilder : public PacketBuilder<true> {
+ public:
+  explicit ViewBuilder(View view);
+  virtual ~ViewBuilder() = default;
+
+  virtual size_t size() const override;
+
+  virtual void Serialize(BitInserter& it) const override;
+
+ private:
+  View view_;
+};
+
+}  // namespace packet
+}  // namespace bluetooth
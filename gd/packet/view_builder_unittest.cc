@@ -0,0 +1,45 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/view_builder.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+using std::vector;
+
+namespace bluetooth {
+namespace packet {
+
+TEST(ViewBuilderTest, serializeExternalBufferTest) {
+  uint8_t buffer[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05};
+  int release_count = 0;
+  {
+    View view(buffer, sizeof(buffer), [&release_count]() { release_count++; });
+    auto builder = std::make_unique<ViewBuilder>(View(view, 1, 5));
+    ASSERT_EQ(4u, builder->size());
+
+    vector<uint8_t> packet;
+    BitInserter it(packet);
+    builder->Serialize(it);
+    ASSERT_EQ(vector<uint8_t>({0x01, 0x02, 0x03, 0x04}), packet);
+    ASSERT_EQ(0, release_count);
+  }
+  ASSERT_EQ(1, release_count);
+}
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -107,6 +107,30 @@ TEST(SmpEccValidationTest, test_invalid_points) {
   EXPECT_FALSE(ECC_ValidatePoint(p));
 }
 
+// Test point multiplication with the sample data from Bluetooth Core Specification
+// Version 5.0 | Vol 2, Part G | 7.1.2
+TEST(SmpEccValidationTest, test_point_mult) {
+  uint32_t private_key_a[KEY_LENGTH_DWORDS_P256] = {0xcd3c1abd, 0x5899b8a6, 0xeb40b799, 0x4aff607b,
+                                                    0xd2103f50, 0x74c9b3e3, 0xa3c55f38, 0x3f49f6d4};
+  uint32_t private_key_b[KEY_LENGTH_DWORDS_P256] = {0xf47fc5fd, 0x6b4fdd49, 0xf19d7cfb, 0x59cb9ac2,
+                                                    0xeed4e72a, 0x900afcfb, 0x32f6bb9a, 0x55188b3d};
+  const uint32_t public_key_a_x[KEY_LENGTH_DWORDS_P256] = {0x0e359de6, 0xcc030148, 0xacf4fddb, 0xeff49111,
+                                                           0xe9f9a5b9, 0x5e2c83a7, 0xf297be2c, 0x20b003d2};
+  const uint32_t public_key_a_y[KEY_LENGTH_DWORDS_P256] = {0x1589d28b, 0x741c8ed0, 0x8fed3024, 0x766345c2,
+                                                           0x5a52155c, 0x63329abf, 0x652aeb6d, 0xdc809c49};
+  const uint32_t dhkey[KEY_LENGTH_DWORDS_P256] = {0x73bfa698, 0x868d34f3, 0xb4f866f1, 0x99796b13,
+                                                  0x0a397d9b, 0x341010a6, 0x57c8ad05, 0xec0234a3};
+
+  Point public_key_a;
+  ECC_PointMult(&public_key_a, &curve_p256.G, private_key_a);
+  EXPECT_EQ(multiprecision_compare(public_key_a.x, public_key_a_x), 0);
+  EXPECT_EQ(multiprecision_compare(public_key_a.y, public_key_a_y), 0);
+
+  Point dhkey_b;
+  ECC_PointMult(&dhkey_b, &public_key_a, private_key_b);
+  EXPECT_EQ(multiprecision_compare(dhkey_b.x, dhkey), 0);
+}
+
 }  // namespace ecc
 }  // namespace security
 }  // namespace bluetooth
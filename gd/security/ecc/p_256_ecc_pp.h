@@ -67,9 +67,8 @@ static constexpr elliptic_curve_t curve_p256{
 /* This function checks that point is on the elliptic curve*/
 bool ECC_ValidatePoint(const Point& point);
 
-void ECC_PointMult_Bin_NAF(Point* q, const Point* p, uint32_t* n);
-
-#define ECC_PointMult(q, p, n) ECC_PointMult_Bin_NAF(q, p, n)
+/* This function computes q = n * p, n is a 256-bit number stored least significant word first */
+void ECC_PointMult(Point* q, const Point* p, const uint32_t* n);
 
 }  // namespace ecc
 }  // namespace security
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "benchmark/benchmark.h"
+#include "security/ecc/p_256_ecc_pp.h"
+
+using ::benchmark::State;
+using ::bluetooth::security::ecc::curve_p256;
+using ::bluetooth::security::ecc::Point;
+
+namespace {
+
+// P-256 sample data from Bluetooth Core Specification Version 5.0 | Vol 2, Part G | 7.1.2
+constexpr uint32_t kPrivateKeyA[KEY_LENGTH_DWORDS_P256] = {0xcd3c1abd, 0x5899b8a6, 0xeb40b799, 0x4aff607b,
+                                                           0xd2103f50, 0x74c9b3e3, 0xa3c55f38, 0x3f49f6d4};
+constexpr Point kPublicKeyB = {
+    .x = {0x2faaa190, 0x559077b2, 0x8615a69f, 0x47b58afd, 0xf19e4c00, 0x09592284, 0x1faf1d96, 0x1ea1f0f0},
+    .y = {0x15b1214a, 0x5f89aff9, 0xe28e3676, 0x472d1130, 0x9ab85160, 0x7356703a, 0x429dad37, 0x4c55f33e},
+    .z = {0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}};
+
+// Public key generation, done for every LE Secure Connections pairing and OOB data generation
+void BM_GeneratePublicKey(State& state) {
+  Point public_key;
+  for (auto _ : state) {
+    uint32_t private_key[KEY_LENGTH_DWORDS_P256];
+    std::memcpy(private_key, kPrivateKeyA, sizeof(private_key));
+    ECC_PointMult(&public_key, &curve_p256.G, private_key);
+    benchmark::DoNotOptimize(public_key);
+  }
+}
+
+// DHKey computation from the peer public key
+void BM_ComputeDHKey(State& state) {
+  Point dhkey;
+  for (auto _ : state) {
+    uint32_t private_key[KEY_LENGTH_DWORDS_P256];
+    std::memcpy(private_key, kPrivateKeyA, sizeof(private_key));
+    ECC_PointMult(&dhkey, &kPublicKeyB, private_key);
+    benchmark::DoNotOptimize(dhkey);
+  }
+}
+
+BENCHMARK(BM_GeneratePublicKey);
+BENCHMARK(BM_ComputeDHKey);
+
+}  // namespace
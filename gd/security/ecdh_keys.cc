@@ -18,40 +18,18 @@
 
 #include "security/ecdh_keys.h"
 
-/**********************************************************************************************************************
- TODO: We should have random number management in separate file, and we
-       should honour all the random number requirements from the spec!!
-**********************************************************************************************************************/
-#include <chrono>
-#include <cstdlib>
+#include <cstring>
 
+#include "os/log.h"
+#include "os/rand.h"
 #include "security/ecc/p_256_ecc_pp.h"
 
-namespace {
-
-static bool srand_initiated = false;
-
-template <size_t SIZE>
-static std::array<uint8_t, SIZE> GenerateRandom() {
-  if (!srand_initiated) {
-    srand_initiated = true;
-    // TODO:  We need a proper  random number generator here.
-    // use current time as seed for random generator
-    std::srand(std::time(nullptr));
-  }
-
-  std::array<uint8_t, SIZE> r;
-  for (size_t i = 0; i < SIZE; i++) r[i] = std::rand();
-  return r;
-}
-}  // namespace
-/*********************************************************************************************************************/
-
 namespace bluetooth {
 namespace security {
 
 std::pair<std::array<uint8_t, 32>, EcdhPublicKey> GenerateECDHKeyPair() {
-  std::array<uint8_t, 32> private_key = GenerateRandom<32>();
+  // The key pairs are generated by the pairing threads, the generator must be thread safe
+  std::array<uint8_t, 32> private_key = os::GenerateRandom<32>();
   std::array<uint8_t, 32> private_key_copy = private_key;
   ecc::Point public_key;
 
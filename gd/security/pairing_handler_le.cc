@@ -35,6 +35,12 @@ MyOobData PairingHandlerLe::GenerateOobData() {
 void PairingHandlerLe::PairingMain(InitialInformations i) {
   LOG_INFO("Pairing Started");
 
+  // Secure Connections can only be used if we support it. The key pair is generated in parallel with the user prompt
+  // and the pairing feature exchange, rather than once the public keys are to be exchanged.
+  if (i.myPairingCapabilities.auth_req & AuthReqMaskSc) {
+    ecdh_key_pair_ = std::async(std::launch::async, GenerateECDHKeyPair);
+  }
+
   if (i.remotely_initiated) {
     LOG_INFO("Was remotely initiated, presenting user with the accept prompt");
     i.user_interface_handler->Post(common::BindOnce(&UI::DisplayPairingPrompt, common::Unretained(i.user_interface),
@@ -103,7 +109,7 @@ void PairingHandlerLe::PairingMain(InitialInformations i) {
     }
 
     Stage2ResultOrFailure stage_2_result = DoSecureConnectionsStage2(i, PKa, PKb, pairing_request, pairing_response,
-                                                                     std::get<Stage1Result>(stage1result), dhkey);
+                                                                     std::get<Stage1Result>(stage1result), dhkey.get());
     if (std::holds_alternative<PairingFailure>(stage_2_result)) {
       i.OnPairingFinished(std::get<PairingFailure>(stage_2_result));
       return;
@@ -21,6 +21,7 @@
 #include <array>
 #include <chrono>
 #include <condition_variable>
+#include <future>
 #include <mutex>
 #include <optional>
 #include <queue>
@@ -85,8 +86,10 @@ constexpr int SMP_TIMEOUT = 30;
 using CommandViewOrFailure = std::variant<CommandView, PairingFailure>;
 using Phase1Result = std::pair<PairingRequestView /* pairning_request*/, PairingResponseView /* pairing_response */>;
 using Phase1ResultOrFailure = std::variant<PairingFailure, Phase1Result>;
-using KeyExchangeResult =
-    std::tuple<EcdhPublicKey /* PKa */, EcdhPublicKey /* PKb */, std::array<uint8_t, 32> /*dhkey*/>;
+using EcdhKeyPair = std::pair<std::array<uint8_t, 32> /* private_key */, EcdhPublicKey>;
+// The DHKey is only needed in stage 2, it is computed while stage 1 runs
+using KeyExchangeResult = std::tuple<EcdhPublicKey /* PKa */, EcdhPublicKey /* PKb */,
+                                     std::shared_future<std::array<uint8_t, 32>> /*dhkey*/>;
 using Stage1Result = std::tuple<Octet16, Octet16, Octet16, Octet16>;
 using Stage1ResultOrFailure = std::variant<PairingFailure, Stage1Result>;
 using Stage2ResultOrFailure = std::variant<PairingFailure, Octet16 /* LTK */>;
@@ -466,6 +469,9 @@ class PairingHandlerLe {
   std::mutex queue_guard;
   std::queue<PairingEvent> queue;
 
+  // Own key pair for LE Secure Connections, generated while phase 1 runs. Declared before |thread_| that uses it.
+  std::future<EcdhKeyPair> ecdh_key_pair_;
+
   std::thread thread_;
 };
 }  // namespace security
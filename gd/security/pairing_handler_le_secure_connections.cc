@@ -27,10 +27,14 @@ namespace security {
 
 std::variant<PairingFailure, KeyExchangeResult> PairingHandlerLe::ExchangePublicKeys(const InitialInformations& i,
                                                                                      OobDataFlag remote_have_oob_data) {
-  // Generate ECDH, or use one that was used for OOB data
-  const auto [private_key, public_key] = (remote_have_oob_data == OobDataFlag::NOT_PRESENT || !i.my_oob_data)
-                                             ? GenerateECDHKeyPair()
-                                             : std::make_pair(i.my_oob_data->private_key, i.my_oob_data->public_key);
+  // Use the ECDH key pair generated while phase 1 ran, or the one that was used for OOB data
+  EcdhKeyPair key_pair;
+  if (remote_have_oob_data == OobDataFlag::NOT_PRESENT || !i.my_oob_data) {
+    key_pair = ecdh_key_pair_.valid() ? ecdh_key_pair_.get() : GenerateECDHKeyPair();
+  } else {
+    key_pair = std::make_pair(i.my_oob_data->private_key, i.my_oob_data->public_key);
+  }
+  const auto& [private_key, public_key] = key_pair;
 
   LOG_INFO("Public key exchange start");
   std::unique_ptr<PairingPublicKeyBuilder> myPublicKey = PairingPublicKeyBuilder::Create(public_key.x, public_key.y);
@@ -77,7 +81,8 @@ std::variant<PairingFailure, KeyExchangeResult> PairingHandlerLe::ExchangePublic
 
   LOG_INFO("Public key exchange finish");
 
-  std::array<uint8_t, 32> dhkey = ComputeDHKey(private_key, remote_public_key);
+  std::shared_future<std::array<uint8_t, 32>> dhkey =
+      std::async(std::launch::async, ComputeDHKey, private_key, remote_public_key).share();
 
   const EcdhPublicKey& PKa = IAmMaster(i) ? public_key : remote_public_key;
   const EcdhPublicKey& PKb = IAmMaster(i) ? remote_public_key : public_key;
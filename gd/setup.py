@@ -101,7 +101,7 @@ def main():
         install_requires=install_requires,
         package_data={
             '': host_executables + ['*.so', 'lib64/*.so', 'target/*', 'llvm_binutils/bin/*', 'llvm_binutils/lib64/*'],
-            'cert': ['all_test_cases'],
+            'cert': ['all_test_cases', 'performance_budgets.json', 'performance_cert_testcases'],
         },
         cmdclass={
             'install': InstallLocalPackagesForInstallation,
@@ -16,8 +16,10 @@
 #define LOG_TAG "bt_gd_shim"
 
 #include <future>
+#include <memory>
 #include <string>
 
+#include "common/bind.h"
 #include "dumpsys/filter.h"
 #include "generated_dumpsys_bundled_schema.h"
 #include "module.h"
@@ -38,21 +40,38 @@ constexpr char kDumpsysTitle[] = "----- Gd Dumpsys ------";
 
 struct Dumpsys::impl {
  public:
-  void DumpWithArgsSync(int fd, const char** args, std::promise<void> promise);
+  void DumpWithArgs(int fd, const char** args, std::promise<void> promise);
   int GetNumberOfBundledSchemas() const;
 
   impl(const Dumpsys& dumpsys_module, const dumpsys::ReflectionSchema& reflection_schema);
   ~impl() = default;
 
  protected:
-  void FilterAsUser(std::string* dumpsys_data);
-  void FilterAsDeveloper(std::string* dumpsys_data);
-  std::string PrintAsJson(std::string* dumpsys_data) const;
+  // A dump being streamed to its fd, one module per handler task
+  struct Progress {
+    Progress(int fd, const ModuleRegistry& registry, dumpsys::FilterType filter_type, std::promise<void> promise)
+        : fd(fd), dumper(registry, kDumpsysTitle), filter_type(filter_type), promise(std::move(promise)) {}
+    // Also releases the caller when the handler is cleared before the dump completes
+    ~Progress() {
+      promise.set_value();
+    }
+    const int fd;
+    const ModuleDumper dumper;
+    const dumpsys::FilterType filter_type;
+    std::promise<void> promise;
+    size_t module_index = 0;
+    flatbuffers::Parser parser;
+    // Reused by every module, hence only holds the largest module data
+    flatbuffers::FlatBufferBuilder builder{1024};
+  };
+
+  bool DeserializeRootSchema(flatbuffers::Parser* parser, std::string* error) const;
+  void FilterAndPrintAsJson(Progress* progress) const;
 
   bool IsDebuggable() const;
 
  private:
-  void DumpWithArgsAsync(int fd, const char** args);
+  void DumpNextModule(std::unique_ptr<Progress> progress);
 
   const Dumpsys& dumpsys_module_;
   const dumpsys::ReflectionSchema reflection_schema_;
@@ -72,70 +91,76 @@ bool Dumpsys::impl::IsDebuggable() const {
   return (os::GetSystemProperty(kReadOnlyDebuggableProperty) == "1");
 }
 
-void Dumpsys::impl::FilterAsDeveloper(std::string* dumpsys_data) {
-  ASSERT(dumpsys_data != nullptr);
-  dumpsys::FilterInPlace(dumpsys::FilterType::AS_DEVELOPER, reflection_schema_, dumpsys_data);
-}
-
-void Dumpsys::impl::FilterAsUser(std::string* dumpsys_data) {
-  ASSERT(dumpsys_data != nullptr);
-  dumpsys::FilterInPlace(dumpsys::FilterType::AS_USER, reflection_schema_, dumpsys_data);
-}
-
-std::string Dumpsys::impl::PrintAsJson(std::string* dumpsys_data) const {
-  ASSERT(dumpsys_data != nullptr);
+bool Dumpsys::impl::DeserializeRootSchema(flatbuffers::Parser* parser, std::string* error) const {
+  ASSERT(parser != nullptr);
+  ASSERT(error != nullptr);
 
   const std::string root_name = reflection_schema_.GetRootName();
   if (root_name.empty()) {
-    char buf[255];
-    snprintf(buf, sizeof(buf), "ERROR: Unable to find root name in prebundled reflection schema\n");
-    LOG_WARN("%s", buf);
-    return std::string(buf);
+    *error = "ERROR: Unable to find root name in prebundled reflection schema\n";
+    LOG_WARN("%s", error->c_str());
+    return false;
   }
 
   const reflection::Schema* schema = reflection_schema_.FindInReflectionSchema(root_name);
   if (schema == nullptr) {
-    char buf[255];
-    snprintf(buf, sizeof(buf), "ERROR: Unable to find schema root name:%s\n", root_name.c_str());
-    LOG_WARN("%s", buf);
-    return std::string(buf);
+    *error = "ERROR: Unable to find schema root name:" + root_name + "\n";
+    LOG_WARN("%s", error->c_str());
+    return false;
   }
 
-  flatbuffers::Parser parser;
-  if (!parser.Deserialize(schema)) {
-    char buf[255];
-    snprintf(buf, sizeof(buf), "ERROR: Unable to deserialize bundle root name:%s\n", root_name.c_str());
-    LOG_WARN("%s", buf);
-    return std::string(buf);
+  if (!parser->Deserialize(schema)) {
+    *error = "ERROR: Unable to deserialize bundle root name:" + root_name + "\n";
+    LOG_WARN("%s", error->c_str());
+    return false;
   }
+  return true;
+}
+
+void Dumpsys::impl::FilterAndPrintAsJson(Progress* progress) const {
+  ASSERT(progress != nullptr);
+  // Filter the module data before the next module is built, while it's still in the builder
+  uint8_t* dumpsys_data = progress->builder.GetBufferPointer();
+  dumpsys::FilterInPlace(progress->filter_type, reflection_schema_, dumpsys_data);
 
   std::string jsongen;
-  flatbuffers::GenerateText(parser, dumpsys_data->data(), &jsongen);
-  return jsongen;
+  flatbuffers::GenerateText(progress->parser, dumpsys_data, &jsongen);
+  dprintf(progress->fd, "%s", jsongen.c_str());
 }
 
-void Dumpsys::impl::DumpWithArgsAsync(int fd, const char** args) {
-  ParsedDumpsysArgs parsed_dumpsys_args(args);
-  const auto registry = dumpsys_module_.GetModuleRegistry();
+void Dumpsys::impl::DumpNextModule(std::unique_ptr<Progress> progress) {
+  if (progress->dumper.DumpModuleState(progress->module_index, &progress->builder)) {
+    FilterAndPrintAsJson(progress.get());
+    progress->module_index++;
+    // Let other tasks of the stack run between modules
+    dumpsys_module_.GetHandler()->Post(
+        common::BindOnce(&Dumpsys::impl::DumpNextModule, common::Unretained(this), std::move(progress)));
+    return;
+  }
 
-  ModuleDumper dumper(*registry, kDumpsysTitle);
-  std::string dumpsys_data;
-  dumper.DumpState(&dumpsys_data);
+  std::string start_times;
+  progress->dumper.DumpStartTimes(&start_times);
+  dprintf(progress->fd, " ----- Module start times -----\n%s", start_times.c_str());
+}
 
+void Dumpsys::impl::DumpWithArgs(int fd, const char** args, std::promise<void> promise) {
+  ParsedDumpsysArgs parsed_dumpsys_args(args);
+  dumpsys::FilterType filter_type = dumpsys::FilterType::AS_USER;
   if (parsed_dumpsys_args.IsDeveloper() || IsDebuggable()) {
     dprintf(fd, " ----- Filtering as Developer -----\n");
-    FilterAsDeveloper(&dumpsys_data);
+    filter_type = dumpsys::FilterType::AS_DEVELOPER;
   } else {
     dprintf(fd, " ----- Filtering as User -----\n");
-    FilterAsUser(&dumpsys_data);
   }
 
-  dprintf(fd, "%s", PrintAsJson(&dumpsys_data).c_str());
-}
-
-void Dumpsys::impl::DumpWithArgsSync(int fd, const char** args, std::promise<void> promise) {
-  DumpWithArgsAsync(fd, args);
-  promise.set_value();
+  auto progress =
+      std::make_unique<Progress>(fd, *dumpsys_module_.GetModuleRegistry(), filter_type, std::move(promise));
+  std::string error;
+  if (!DeserializeRootSchema(&progress->parser, &error)) {
+    dprintf(fd, "%s", error.c_str());
+    return;
+  }
+  DumpNextModule(std::move(progress));
 }
 
 Dumpsys::Dumpsys(const std::string& pre_bundled_schema)
@@ -144,12 +169,12 @@ Dumpsys::Dumpsys(const std::string& pre_bundled_schema)
 void Dumpsys::Dump(int fd, const char** args) {
   std::promise<void> promise;
   auto future = promise.get_future();
-  CallOn(pimpl_.get(), &Dumpsys::impl::DumpWithArgsSync, fd, args, std::move(promise));
+  CallOn(pimpl_.get(), &Dumpsys::impl::DumpWithArgs, fd, args, std::move(promise));
   future.get();
 }
 
 void Dumpsys::Dump(int fd, const char** args, std::promise<void> promise) {
-  CallOn(pimpl_.get(), &Dumpsys::impl::DumpWithArgsSync, fd, args, std::move(promise));
+  CallOn(pimpl_.get(), &Dumpsys::impl::DumpWithArgs, fd, args, std::move(promise));
 }
 
 os::Handler* Dumpsys::GetGdShimHandler() {
@@ -20,10 +20,11 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
-#include <queue>
+#include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "common/bind.h"
@@ -36,8 +37,10 @@
 #include "module.h"
 #include "os/handler.h"
 #include "os/log.h"
+#include "os/queue.h"
 #include "packet/packet_view.h"
 #include "packet/raw_builder.h"
+#include "packet/view_builder.h"
 #include "shim/dumpsys.h"
 
 namespace bluetooth {
@@ -55,6 +58,9 @@ constexpr ConnectionInterfaceDescriptor kInvalidConnectionInterfaceDescriptor =
 constexpr ConnectionInterfaceDescriptor kStartConnectionInterfaceDescriptor = 64;
 constexpr ConnectionInterfaceDescriptor kMaxConnections = UINT16_MAX - kStartConnectionInterfaceDescriptor - 1;
 
+// Received packets handed to the legacy stack at once, at most
+constexpr size_t kMaxReadBatchSize = 16;
+
 using PendingConnectionId = int;
 
 using ConnectionClosed = std::function<void(ConnectionInterfaceDescriptor)>;
@@ -66,11 +72,7 @@ using ServiceConnectionOpen =
     std::function<void(ConnectionCompleteCallback, std::unique_ptr<l2cap::classic::DynamicChannel>)>;
 
 std::unique_ptr<packet::RawBuilder> MakeUniquePacket(const uint8_t* data, size_t len) {
-  packet::RawBuilder builder;
-  std::vector<uint8_t> bytes(data, data + len);
-  auto payload = std::make_unique<packet::RawBuilder>();
-  payload->AddOctets(bytes);
-  return payload;
+  return std::make_unique<packet::RawBuilder>(std::vector<uint8_t>(data, data + len));
 }
 
 }  // namespace
@@ -88,10 +90,11 @@ class ConnectionInterface {
         on_data_ready_callback_(nullptr),
         on_connection_closed_callback_(nullptr),
         address_(channel_->GetDevice().GetAddress()),
-        on_closed_(on_closed) {
+        on_closed_(on_closed),
+        enqueue_buffer_(channel_->GetQueueUpEnd()) {
     channel_->RegisterOnCloseCallback(handler_->BindOnceOn(this, &ConnectionInterface::OnConnectionClosed));
-    channel_->GetQueueUpEnd()->RegisterDequeue(
-        handler_, common::Bind(&ConnectionInterface::OnReadReady, common::Unretained(this)));
+    channel_->GetQueueUpEnd()->RegisterDequeueBatch(
+        handler_, kMaxReadBatchSize, common::Bind(&ConnectionInterface::OnReadReady, common::Unretained(this)));
     dequeue_registered_ = true;
   }
 
@@ -99,15 +102,14 @@ class ConnectionInterface {
     ASSERT(!dequeue_registered_);
   }
 
-  void OnReadReady() {
-    std::unique_ptr<packet::PacketView<packet::kLittleEndian>> packet = channel_->GetQueueUpEnd()->TryDequeue();
-    if (packet == nullptr) {
-      LOG_WARN("Got read ready from gd l2cap but no packet is ready");
-      return;
+  void OnReadReady(std::vector<std::unique_ptr<packet::PacketView<packet::kLittleEndian>>> batch) {
+    std::vector<packet::PacketView<packet::kLittleEndian>> packets;
+    packets.reserve(batch.size());
+    for (auto& packet : batch) {
+      packets.push_back(std::move(*packet));
     }
-    std::vector<const uint8_t> data(packet->begin(), packet->end());
     ASSERT(on_data_ready_callback_ != nullptr);
-    on_data_ready_callback_(cid_, data);
+    on_data_ready_callback_(cid_, std::move(packets));
   }
 
   void SetReadDataReadyCallback(ReadDataReadyCallback on_data_ready) {
@@ -116,24 +118,9 @@ class ConnectionInterface {
     on_data_ready_callback_ = on_data_ready;
   }
 
-  std::unique_ptr<packet::BasePacketBuilder> WriteReady() {
-    auto data = std::move(write_queue_.front());
-    write_queue_.pop();
-    if (write_queue_.empty()) {
-      channel_->GetQueueUpEnd()->UnregisterEnqueue();
-      enqueue_registered_ = false;
-    }
-    return data;
-  }
-
-  void Write(std::unique_ptr<packet::RawBuilder> packet) {
+  void Write(std::unique_ptr<packet::BasePacketBuilder> packet) {
     LOG_DEBUG("Writing packet cid:%hd size:%zd", cid_, packet->size());
-    write_queue_.push(std::move(packet));
-    if (!enqueue_registered_) {
-      enqueue_registered_ = true;
-      channel_->GetQueueUpEnd()->RegisterEnqueue(
-          handler_, common::Bind(&ConnectionInterface::WriteReady, common::Unretained(this)));
-    }
+    enqueue_buffer_.Enqueue(std::move(packet), handler_);
   }
 
   void Close() {
@@ -141,7 +128,7 @@ class ConnectionInterface {
       channel_->GetQueueUpEnd()->UnregisterDequeue();
       dequeue_registered_ = false;
     }
-    ASSERT(write_queue_.empty());
+    ASSERT(enqueue_buffer_.Size() == 0);
     channel_->Close();
   }
 
@@ -182,9 +169,8 @@ class ConnectionInterface {
 
   ConnectionClosed on_closed_{};
 
-  std::queue<std::unique_ptr<packet::PacketBuilder<hci::kLittleEndian>>> write_queue_;
+  os::EnqueueBuffer<packet::BasePacketBuilder> enqueue_buffer_;
 
-  bool enqueue_registered_{false};
   bool dequeue_registered_{false};
 
   DISALLOW_COPY_AND_ASSIGN(ConnectionInterface);
@@ -198,7 +184,7 @@ class ConnectionInterfaceManager {
   void SetReadDataReadyCallback(ConnectionInterfaceDescriptor cid, ReadDataReadyCallback on_data_ready);
   void SetConnectionClosedCallback(ConnectionInterfaceDescriptor cid, ConnectionClosedCallback on_closed);
 
-  bool Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::RawBuilder> packet);
+  bool Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::BasePacketBuilder> packet);
 
   size_t NumberOfActiveConnections() const {
     return cid_to_interface_map_.size();
@@ -316,7 +302,8 @@ void ConnectionInterfaceManager::SetConnectionClosedCallback(
   return cid_to_interface_map_[cid]->SetConnectionClosedCallback(on_closed);
 }
 
-bool ConnectionInterfaceManager::Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::RawBuilder> packet) {
+bool ConnectionInterfaceManager::Write(
+    ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::BasePacketBuilder> packet) {
   if (!ConnectionExists(cid)) {
     return false;
   }
@@ -410,7 +397,9 @@ struct L2cap::impl {
   void SetReadDataReadyCallback(ConnectionInterfaceDescriptor cid, ReadDataReadyCallback on_data_ready);
   void SetConnectionClosedCallback(ConnectionInterfaceDescriptor cid, ConnectionClosedCallback on_closed);
 
-  void Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::RawBuilder> packet);
+  void Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::BasePacketBuilder> packet);
+  // Called from any thread, queues |packet| for the next batch of writes
+  void QueueWrite(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::BasePacketBuilder> packet);
 
   void SendLoopbackResponse(std::function<void()> function);
 
@@ -438,6 +427,12 @@ struct L2cap::impl {
       std::unique_ptr<PendingConnection> connection,
       l2cap::classic::DynamicChannelManager::ConnectionResult result);
   l2cap::classic::SecurityPolicy GetSecurityPolicy(l2cap::Psm psm) const;
+
+  void WritePending();
+
+  // Writes queued since the last WritePending, posted only when the first one is queued
+  std::mutex pending_writes_mutex_;
+  std::vector<std::pair<ConnectionInterfaceDescriptor, std::unique_ptr<packet::BasePacketBuilder>>> pending_writes_;
 };
 
 const ModuleFactory L2cap::Factory = ModuleFactory([]() { return new L2cap(); });
@@ -599,10 +594,33 @@ void L2cap::impl::SetConnectionClosedCallback(ConnectionInterfaceDescriptor cid,
   connection_interface_manager_.SetConnectionClosedCallback(cid, std::move(on_closed));
 }
 
-void L2cap::impl::Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::RawBuilder> packet) {
+void L2cap::impl::Write(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::BasePacketBuilder> packet) {
   connection_interface_manager_.Write(cid, std::move(packet));
 }
 
+void L2cap::impl::QueueWrite(ConnectionInterfaceDescriptor cid, std::unique_ptr<packet::BasePacketBuilder> packet) {
+  bool was_empty;
+  {
+    std::lock_guard<std::mutex> lock(pending_writes_mutex_);
+    was_empty = pending_writes_.empty();
+    pending_writes_.emplace_back(cid, std::move(packet));
+  }
+  if (was_empty) {
+    handler_->CallOn(this, &L2cap::impl::WritePending);
+  }
+}
+
+void L2cap::impl::WritePending() {
+  std::vector<std::pair<ConnectionInterfaceDescriptor, std::unique_ptr<packet::BasePacketBuilder>>> writes;
+  {
+    std::lock_guard<std::mutex> lock(pending_writes_mutex_);
+    writes.swap(pending_writes_);
+  }
+  for (auto& write : writes) {
+    Write(write.first, std::move(write.second));
+  }
+}
+
 void L2cap::impl::SendLoopbackResponse(std::function<void()> function) {
   function();
 }
@@ -672,8 +690,12 @@ void L2cap::SetConnectionClosedCallback(uint16_t raw_cid, ConnectionClosedCallba
 
 void L2cap::Write(uint16_t raw_cid, const uint8_t* data, size_t len) {
   ConnectionInterfaceDescriptor cid(raw_cid);
-  auto packet = MakeUniquePacket(data, len);
-  GetHandler()->Post(common::BindOnce(&L2cap::impl::Write, common::Unretained(pimpl_.get()), cid, std::move(packet)));
+  pimpl_->QueueWrite(cid, MakeUniquePacket(data, len));
+}
+
+void L2cap::Write(uint16_t raw_cid, packet::View payload) {
+  ConnectionInterfaceDescriptor cid(raw_cid);
+  pimpl_->QueueWrite(cid, std::make_unique<packet::ViewBuilder>(std::move(payload)));
 }
 
 void L2cap::SendLoopbackResponse(std::function<void()> function) {
@@ -22,6 +22,8 @@
 #include <string>
 
 #include "module.h"
+#include "packet/packet_view.h"
+#include "packet/view.h"
 
 namespace bluetooth {
 namespace shim {
@@ -29,7 +31,9 @@ namespace shim {
 using ConnectionClosedCallback = std::function<void(uint16_t cid, int error_code)>;
 using ConnectionCompleteCallback =
     std::function<void(std::string string_address, uint16_t psm, uint16_t cid, uint16_t remote_cid, bool is_connected)>;
-using ReadDataReadyCallback = std::function<void(uint16_t cid, std::vector<const uint8_t> data)>;
+// Called with the packets received on |cid| since the previous call, in order
+using ReadDataReadyCallback =
+    std::function<void(uint16_t cid, std::vector<packet::PacketView<packet::kLittleEndian>> packets)>;
 
 using RegisterServicePromise = std::promise<uint16_t>;
 using UnregisterServicePromise = std::promise<void>;
@@ -55,7 +59,11 @@ class L2cap : public bluetooth::Module {
   void SetReadDataReadyCallback(uint16_t cid, ReadDataReadyCallback on_data_ready);
   void SetConnectionClosedCallback(uint16_t cid, ConnectionClosedCallback on_closed);
 
+  // Writes may come from any thread. They are handed to the gd handler in batches, a single task taking all the
+  // packets written since the previous one.
   void Write(uint16_t cid, const uint8_t* data, size_t len);
+  // Write |payload| without copying it. Buffers wrapped by |payload| are released once it has been sent.
+  void Write(uint16_t cid, packet::View payload);
 
   void SendLoopbackResponse(std::function<void()>);
 
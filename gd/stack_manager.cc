@@ -32,14 +32,14 @@ using ::bluetooth::os::Thread;
 
 namespace bluetooth {
 
-void StackManager::StartUp(ModuleList* modules, Thread* stack_thread) {
+void StackManager::StartUp(ModuleList* modules, Thread* stack_thread, bool start_in_parallel) {
   management_thread_ = new Thread("management_thread", Thread::Priority::NORMAL);
   handler_ = new Handler(management_thread_);
 
   std::promise<void> promise;
   auto future = promise.get_future();
   handler_->Post(common::BindOnce(&StackManager::handle_start_up, common::Unretained(this), modules, stack_thread,
-                                  std::move(promise)));
+                                  start_in_parallel, std::move(promise)));
 
   auto init_status = future.wait_for(std::chrono::seconds(3));
   ASSERT_LOG(init_status == std::future_status::ready, "Can't start stack");
@@ -47,8 +47,13 @@ void StackManager::StartUp(ModuleList* modules, Thread* stack_thread) {
   LOG_INFO("init complete");
 }
 
-void StackManager::handle_start_up(ModuleList* modules, Thread* stack_thread, std::promise<void> promise) {
-  registry_.Start(modules, stack_thread);
+void StackManager::handle_start_up(ModuleList* modules, Thread* stack_thread, bool start_in_parallel,
+                                   std::promise<void> promise) {
+  if (start_in_parallel) {
+    registry_.StartInParallel(modules, stack_thread);
+  } else {
+    registry_.Start(modules, stack_thread);
+  }
   promise.set_value();
 }
 
@@ -24,7 +24,8 @@ namespace bluetooth {
 
 class StackManager {
  public:
-  void StartUp(ModuleList *modules, os::Thread* stack_thread);
+  // Modules that do not depend on each other are started concurrently when |start_in_parallel| is set
+  void StartUp(ModuleList *modules, os::Thread* stack_thread, bool start_in_parallel = false);
   void ShutDown();
 
   template <class T>
@@ -37,7 +38,8 @@ class StackManager {
   os::Handler* handler_ = nullptr;
   ModuleRegistry registry_;
 
-  void handle_start_up(ModuleList* modules, os::Thread* stack_thread, std::promise<void> promise);
+  void handle_start_up(ModuleList* modules, os::Thread* stack_thread, bool start_in_parallel,
+                       std::promise<void> promise);
   void handle_shut_down(std::promise<void> promise);
 };
 
@@ -52,5 +52,15 @@ TEST(StackManagerTest, get_module_instance) {
   stack_manager.ShutDown();
 }
 
+TEST(StackManagerTest, get_module_instance_started_in_parallel) {
+  StackManager stack_manager;
+  ModuleList module_list;
+  module_list.add<TestModuleNoDependency>();
+  os::Thread thread{"test_thread", os::Thread::Priority::NORMAL};
+  stack_manager.StartUp(&module_list, &thread, true);
+  EXPECT_NE(stack_manager.GetInstance<TestModuleNoDependency>(), nullptr);
+  stack_manager.ShutDown();
+}
+
 }  // namespace
 }  // namespace bluetooth
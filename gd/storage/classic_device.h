@@ -90,6 +90,9 @@ class ClassicDevice {
   GENERATE_PROPERTY_GETTER_SETTER_REMOVER(SdpDiModel, uint16_t, "SdpDiModel");
   GENERATE_PROPERTY_GETTER_SETTER_REMOVER(SdpDiHardwareVersion, uint16_t, "SdpDiHardwareVersion");
   GENERATE_PROPERTY_GETTER_SETTER_REMOVER(SdpDiVendorIdSource, uint16_t, "SdpDiVendorIdSource");
+  // Paging hints from the last inquiry response, the clock offset is only valid until the controller is reset
+  GENERATE_TEMP_PROPERTY_GETTER_SETTER_REMOVER(ClockOffset, uint16_t, "ClockOffset");
+  GENERATE_TEMP_PROPERTY_GETTER_SETTER_REMOVER(PageScanRepetitionMode, uint8_t, "PageScanRepetitionMode");
 };
 
 }  // namespace storage
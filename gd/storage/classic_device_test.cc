@@ -53,6 +53,21 @@ TEST(ClassicDeviceTest, set_property) {
   ASSERT_THAT(device.GetLinkKey(), Optional(Eq(kExampleLinkKey)));
 }
 
+TEST(ClassicDeviceTest, set_temp_property) {
+  ConfigCache config(10, Device::kLinkKeyProperties);
+  ConfigCache memory_only_config(10, {});
+  Address address = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}};
+  ClassicDevice device(&config, &memory_only_config, address.ToString());
+  ASSERT_FALSE(device.GetTempClockOffset());
+  Mutation mutation(&config, &memory_only_config);
+  mutation.Add(device.SetTempClockOffset(0x1234));
+  mutation.Add(device.SetTempPageScanRepetitionMode(0x01));
+  mutation.Commit();
+  ASSERT_THAT(device.GetTempClockOffset(), Optional(Eq(0x1234)));
+  ASSERT_THAT(device.GetTempPageScanRepetitionMode(), Optional(Eq(0x01)));
+  ASSERT_FALSE(config.HasSection(address.ToString()));
+}
+
 TEST(ClassicDeviceTest, equality_test) {
   ConfigCache config(10, Device::kLinkKeyProperties);
   ConfigCache memory_only_config(10, {});
@@ -55,38 +55,68 @@ ConfigCache::ConfigCache(size_t temp_device_capacity, std::unordered_set<std::st
       temporary_devices_(temp_device_capacity) {}
 
 void ConfigCache::SetPersistentConfigChangedCallback(std::function<void()> persistent_config_changed_callback) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   persistent_config_changed_callback_ = std::move(persistent_config_changed_callback);
 }
 
+void ConfigCache::SetPersistentMutationCallback(std::function<void(MutationEntry)> persistent_mutation_callback) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  persistent_mutation_callback_ = std::move(persistent_mutation_callback);
+}
+
+MutationEntry ConfigCache::PersistentSetEntry(std::string section, std::string property, std::string value) {
+  return MutationEntry(
+      MutationEntry::EntryType::SET,
+      MutationEntry::PropertyType::NORMAL,
+      std::move(section),
+      std::move(property),
+      std::move(value));
+}
+
 ConfigCache::ConfigCache(ConfigCache&& other) noexcept
     : persistent_config_changed_callback_(std::move(other.persistent_config_changed_callback_)),
+      persistent_mutation_callback_(std::move(other.persistent_mutation_callback_)),
       persistent_property_names_(std::move(other.persistent_property_names_)),
       information_sections_(std::move(other.information_sections_)),
       persistent_devices_(std::move(other.persistent_devices_)),
-      temporary_devices_(std::move(other.temporary_devices_)) {
+      temporary_devices_(std::move(other.temporary_devices_)),
+      persistent_snapshot_(std::move(other.persistent_snapshot_)),
+      section_snapshots_(std::move(other.section_snapshots_)) {
+  // Copies of sections taken from either cache are stale now
+  change_count_ = other.change_count_ + 1;
+  other.change_count_++;
   // std::function will be in a valid but unspecified state after std::move(), hence resetting it
   other.persistent_config_changed_callback_ = {};
+  other.persistent_mutation_callback_ = {};
 }
 
 ConfigCache& ConfigCache::operator=(ConfigCache&& other) noexcept {
   if (&other == this) {
     return *this;
   }
-  std::lock_guard<std::recursive_mutex> my_lock(mutex_);
-  std::lock_guard<std::recursive_mutex> others_lock(other.mutex_);
+  std::unique_lock<std::shared_mutex> my_lock(mutex_);
+  std::unique_lock<std::shared_mutex> others_lock(other.mutex_);
+  BumpChangeCountLocked();
+  other.BumpChangeCountLocked();
   persistent_config_changed_callback_.swap(other.persistent_config_changed_callback_);
   other.persistent_config_changed_callback_ = {};
+  persistent_mutation_callback_.swap(other.persistent_mutation_callback_);
+  other.persistent_mutation_callback_ = {};
   persistent_property_names_ = std::move(other.persistent_property_names_);
   information_sections_ = std::move(other.information_sections_);
   persistent_devices_ = std::move(other.persistent_devices_);
   temporary_devices_ = std::move(other.temporary_devices_);
+  persistent_snapshot_ = std::move(other.persistent_snapshot_);
+  section_snapshots_ = std::move(other.section_snapshots_);
   return *this;
 }
 
 bool ConfigCache::operator==(const ConfigCache& rhs) const {
-  std::lock_guard<std::recursive_mutex> my_lock(mutex_);
-  std::lock_guard<std::recursive_mutex> others_lock(rhs.mutex_);
+  if (&rhs == this) {
+    return true;
+  }
+  std::shared_lock<std::shared_mutex> my_lock(mutex_);
+  std::shared_lock<std::shared_mutex> others_lock(rhs.mutex_);
   return persistent_property_names_ == rhs.persistent_property_names_ &&
          information_sections_ == rhs.information_sections_ && persistent_devices_ == rhs.persistent_devices_ &&
          temporary_devices_ == rhs.temporary_devices_;
@@ -97,12 +127,19 @@ bool ConfigCache::operator!=(const ConfigCache& rhs) const {
 }
 
 void ConfigCache::Clear() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  BumpChangeCountLocked();
   if (information_sections_.size() > 0) {
+    for (const auto& section : information_sections_) {
+      PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section.first));
+    }
     information_sections_.clear();
     PersistentConfigChangedCallback();
   }
   if (persistent_devices_.size() > 0) {
+    for (const auto& section : persistent_devices_) {
+      PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section.first));
+    }
     persistent_devices_.clear();
     PersistentConfigChangedCallback();
   }
@@ -111,57 +148,59 @@ void ConfigCache::Clear() {
   }
 }
 
-bool ConfigCache::HasSection(const std::string& section) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  return information_sections_.contains(section) || persistent_devices_.contains(section) ||
-         temporary_devices_.contains(section);
-}
-
-bool ConfigCache::HasProperty(const std::string& section, const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+const ConfigCache::Properties* ConfigCache::FindPersistentSectionLocked(const std::string& section) const {
   auto section_iter = information_sections_.find(section);
   if (section_iter != information_sections_.end()) {
-    return section_iter->second.find(property) != section_iter->second.end();
+    return &section_iter->second;
   }
   section_iter = persistent_devices_.find(section);
   if (section_iter != persistent_devices_.end()) {
-    return section_iter->second.find(property) != section_iter->second.end();
+    return &section_iter->second;
   }
-  section_iter = temporary_devices_.find(section);
-  if (section_iter != temporary_devices_.end()) {
-    return section_iter->second.find(property) != section_iter->second.end();
-  }
-  return false;
+  return nullptr;
+}
+
+bool ConfigCache::HasSection(const std::string& section) const {
+  return ReadSection(section, [](const Properties* properties) { return properties != nullptr; });
+}
+
+bool ConfigCache::HasProperty(const std::string& section, const std::string& property) const {
+  return ReadSection(section, [&property](const Properties* properties) {
+    return properties != nullptr && properties->contains(property);
+  });
 }
 
 std::optional<std::string> ConfigCache::GetProperty(const std::string& section, const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  auto section_iter = information_sections_.find(section);
-  if (section_iter != information_sections_.end()) {
-    auto property_iter = section_iter->second.find(property);
-    if (property_iter != section_iter->second.end()) {
-      return property_iter->second;
+  return ReadSection(section, [&property](const Properties* properties) -> std::optional<std::string> {
+    if (properties == nullptr) {
+      return std::nullopt;
     }
-  }
-  section_iter = persistent_devices_.find(section);
-  if (section_iter != persistent_devices_.end()) {
-    auto property_iter = section_iter->second.find(property);
-    if (property_iter != section_iter->second.end()) {
-      return property_iter->second;
+    auto property_iter = properties->find(property);
+    if (property_iter == properties->end()) {
+      return std::nullopt;
     }
-  }
-  section_iter = temporary_devices_.find(section);
-  if (section_iter != temporary_devices_.end()) {
-    auto property_iter = section_iter->second.find(property);
-    if (property_iter != section_iter->second.end()) {
-      return property_iter->second;
+    return property_iter->second;
+  });
+}
+
+uint64_t ConfigCache::CopySection(
+    const std::string& section, std::vector<std::pair<std::string, std::string>>* properties) const {
+  properties->clear();
+  return ReadSection(section, [this, properties](const Properties* section_properties) {
+    if (section_properties != nullptr) {
+      properties->assign(section_properties->begin(), section_properties->end());
     }
-  }
-  return std::nullopt;
+    return change_count_.load(std::memory_order_relaxed);
+  });
 }
 
 void ConfigCache::SetProperty(std::string section, std::string property, std::string value) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  SetPropertyLocked(std::move(section), std::move(property), std::move(value));
+}
+
+void ConfigCache::SetPropertyLocked(std::string section, std::string property, std::string value) {
+  BumpChangeCountLocked();
   if (TrimAfterNewLine(section) || TrimAfterNewLine(property) || TrimAfterNewLine(value)) {
     android_errorWriteLog(0x534e4554, "70808273");
   }
@@ -172,12 +211,15 @@ void ConfigCache::SetProperty(std::string section, std::string property, std::st
     if (section_iter == information_sections_.end()) {
       section_iter = information_sections_.try_emplace_back(section, common::ListMap<std::string, std::string>{}).first;
     }
+    PersistentMutationCallback(PersistentSetEntry(section, property, value));
     section_iter->second.insert_or_assign(property, std::move(value));
     PersistentConfigChangedCallback();
     return;
   }
   auto section_iter = persistent_devices_.find(section);
+  bool is_new_persistent_section = false;
   if (section_iter == persistent_devices_.end() && IsPersistentProperty(property)) {
+    is_new_persistent_section = true;
     // move paired devices or create new paired device when a link key is set
     auto section_properties = temporary_devices_.extract(section);
     if (section_properties) {
@@ -187,7 +229,16 @@ void ConfigCache::SetProperty(std::string section, std::string property, std::st
     }
   }
   if (section_iter != persistent_devices_.end()) {
+    if (!is_new_persistent_section) {
+      PersistentMutationCallback(PersistentSetEntry(section, property, value));
+    }
     section_iter->second.insert_or_assign(property, std::move(value));
+    if (is_new_persistent_section) {
+      // All properties of a temporary section become persistent at once, the persistent one that moved it comes last
+      for (const auto& entry : section_iter->second) {
+        PersistentMutationCallback(PersistentSetEntry(section, entry.first, entry.second));
+      }
+    }
     PersistentConfigChangedCallback();
     return;
   }
@@ -200,9 +251,15 @@ void ConfigCache::SetProperty(std::string section, std::string property, std::st
 }
 
 bool ConfigCache::RemoveSection(const std::string& section) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return RemoveSectionLocked(section);
+}
+
+bool ConfigCache::RemoveSectionLocked(const std::string& section) {
+  BumpChangeCountLocked();
   // sections are unique among all three maps, hence removing from one of them is enough
   if (information_sections_.extract(section) || persistent_devices_.extract(section)) {
+    PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section));
     PersistentConfigChangedCallback();
     return true;
   } else {
@@ -211,7 +268,12 @@ bool ConfigCache::RemoveSection(const std::string& section) {
 }
 
 bool ConfigCache::RemoveProperty(const std::string& section, const std::string& property) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return RemovePropertyLocked(section, property);
+}
+
+bool ConfigCache::RemovePropertyLocked(const std::string& section, const std::string& property) {
+  BumpChangeCountLocked();
   auto section_iter = information_sections_.find(section);
   if (section_iter != information_sections_.end()) {
     auto value = section_iter->second.extract(property);
@@ -220,6 +282,7 @@ bool ConfigCache::RemoveProperty(const std::string& section, const std::string&
       information_sections_.erase(section_iter);
     }
     if (value.has_value()) {
+      PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section, property));
       PersistentConfigChangedCallback();
       return true;
     } else {
@@ -230,14 +293,22 @@ bool ConfigCache::RemoveProperty(const std::string& section, const std::string&
   if (section_iter != persistent_devices_.end()) {
     auto value = section_iter->second.extract(property);
     // if section is empty after removal, remove the whole section as empty section is not allowed
+    bool is_section_removed = false;
     if (section_iter->second.size() == 0) {
       persistent_devices_.erase(section_iter);
+      is_section_removed = true;
     } else if (value && IsPersistentProperty(property)) {
       // move unpaired device
       auto section_properties = persistent_devices_.extract(section);
       temporary_devices_.insert_or_assign(section, std::move(section_properties->second));
+      is_section_removed = true;
     }
     if (value.has_value()) {
+      if (is_section_removed) {
+        PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section));
+      } else {
+        PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, section, property));
+      }
       PersistentConfigChangedCallback();
       return true;
     } else {
@@ -264,12 +335,14 @@ bool ConfigCache::IsPersistentProperty(const std::string& property) const {
 }
 
 void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  BumpChangeCountLocked();
   size_t num_persistent_removed = 0;
   for (auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (auto it = config_section->begin(); it != config_section->end();) {
       if (it->second.contains(property)) {
         LOG_DEBUG("Removing persistent section %s with property %s", it->first.c_str(), property.c_str());
+        PersistentMutationCallback(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, it->first));
         it = config_section->erase(it);
         num_persistent_removed++;
         continue;
@@ -291,7 +364,7 @@ void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
 }
 
 std::vector<std::string> ConfigCache::GetPersistentSections() const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   std::vector<std::string> paired_devices;
   paired_devices.reserve(persistent_devices_.size());
   for (const auto& elem : persistent_devices_) {
@@ -301,19 +374,19 @@ std::vector<std::string> ConfigCache::GetPersistentSections() const {
 }
 
 void ConfigCache::Commit(std::queue<MutationEntry>& mutation_entries) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   while (!mutation_entries.empty()) {
     auto entry = std::move(mutation_entries.front());
     mutation_entries.pop();
     switch (entry.entry_type) {
       case MutationEntry::EntryType::SET:
-        SetProperty(std::move(entry.section), std::move(entry.property), std::move(entry.value));
+        SetPropertyLocked(std::move(entry.section), std::move(entry.property), std::move(entry.value));
         break;
       case MutationEntry::EntryType::REMOVE_PROPERTY:
-        RemoveProperty(entry.section, entry.property);
+        RemovePropertyLocked(entry.section, entry.property);
         break;
       case MutationEntry::EntryType::REMOVE_SECTION:
-        RemoveSection(entry.section);
+        RemoveSectionLocked(entry.section);
         break;
         // do not write a default case so that when a new enum is defined, compilation would fail automatically
     }
@@ -321,23 +394,51 @@ void ConfigCache::Commit(std::queue<MutationEntry>& mutation_entries) {
 }
 
 std::string ConfigCache::SerializeToLegacyFormat() const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  std::stringstream serialized;
-  for (const auto* config_section : {&information_sections_, &persistent_devices_}) {
-    for (const auto& section : *config_section) {
-      serialized << "[" << section.first << "]" << std::endl;
-      for (const auto& property : section.second) {
-        serialized << property.first << " = " << property.second << std::endl;
+  return GetPersistentSnapshot()->SerializeToLegacyFormat();
+}
+
+std::shared_ptr<const ConfigCache::PersistentSnapshot> ConfigCache::GetPersistentSnapshot() const {
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (persistent_snapshot_) {
+      return persistent_snapshot_;
+    }
+  }
+  // Building the snapshot updates section_snapshots_, hence the exclusive lock
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  if (!persistent_snapshot_) {
+    auto snapshot = std::make_shared<PersistentSnapshot>();
+    snapshot->sections.reserve(information_sections_.size() + persistent_devices_.size());
+    for (const auto* config_section : {&information_sections_, &persistent_devices_}) {
+      for (const auto& section : *config_section) {
+        auto& section_snapshot = section_snapshots_[section.first];
+        if (!section_snapshot) {
+          section_snapshot = std::make_shared<const PersistentSnapshot::Section>(
+              section.first, PersistentSnapshot::Section::second_type(section.second.begin(), section.second.end()));
+        }
+        snapshot->sections.push_back(section_snapshot);
       }
-      serialized << std::endl;
     }
+    persistent_snapshot_ = std::move(snapshot);
+  }
+  return persistent_snapshot_;
+}
+
+std::string ConfigCache::PersistentSnapshot::SerializeToLegacyFormat() const {
+  std::stringstream serialized;
+  for (const auto& section : sections) {
+    serialized << "[" << section->first << "]" << std::endl;
+    for (const auto& property : section->second) {
+      serialized << property.first << " = " << property.second << std::endl;
+    }
+    serialized << std::endl;
   }
   return serialized.str();
 }
 
 std::vector<ConfigCache::SectionAndPropertyValue> ConfigCache::GetSectionNamesWithProperty(
     const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   std::vector<SectionAndPropertyValue> result;
   for (auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (const auto& elem : *config_section) {
@@ -401,12 +502,14 @@ bool FixDeviceTypeInconsistencyInSection(
 }  // namespace
 
 bool ConfigCache::FixDeviceTypeInconsistencies() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  BumpChangeCountLocked();
   bool persistent_device_changed = false;
   for (auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (auto& elem : *config_section) {
       if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second)) {
         persistent_device_changed = true;
+        PersistentMutationCallback(PersistentSetEntry(elem.first, "DevType", elem.second.find("DevType")->second));
       }
     }
   }
@@ -424,34 +527,21 @@ bool ConfigCache::FixDeviceTypeInconsistencies() {
 
 bool ConfigCache::HasAtLeastOneMatchingPropertiesInSection(
     const std::string& section, const std::unordered_set<std::string_view>& property_names) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  const common::ListMap<std::string, std::string>* section_ptr;
-  if (!IsDeviceSection(section)) {
-    auto section_iter = information_sections_.find(section);
-    if (section_iter == information_sections_.end()) {
+  return ReadSection(section, [&property_names](const Properties* properties) {
+    if (properties == nullptr) {
       return false;
     }
-    section_ptr = &section_iter->second;
-  } else {
-    auto section_iter = persistent_devices_.find(section);
-    if (section_iter == persistent_devices_.end()) {
-      section_iter = temporary_devices_.find(section);
-      if (section_iter == temporary_devices_.end()) {
-        return false;
+    for (const auto& property : *properties) {
+      if (property_names.count(property.first) > 0) {
+        return true;
       }
     }
-    section_ptr = &section_iter->second;
-  }
-  for (const auto& property : *section_ptr) {
-    if (property_names.count(property.first) > 0) {
-      return true;
-    }
-  }
-  return false;
+    return false;
+  });
 }
 
 bool ConfigCache::IsPersistentSection(const std::string& section) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   return persistent_devices_.contains(section);
 }
 
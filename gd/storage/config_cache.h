@@ -15,13 +15,17 @@
  */
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -48,9 +52,21 @@ class Mutation;
 // The definition of persistent sections is up to the user and is defined through the |persistent_property_names|
 // argument. When these properties are link key properties, then persistent sections is equal to bonded devices
 //
-// This class is thread safe
+// This class is thread safe. Reads of information and persistent sections share the lock with each other and only wait
+// for changes, reads of temporary sections take it exclusively as they warm the section up
 class ConfigCache {
  public:
+  // An immutable copy of the persistent sections of a config cache, which can be read without holding the lock of
+  // the config cache it was taken from
+  struct PersistentSnapshot {
+    using Section = std::pair<std::string, std::vector<std::pair<std::string, std::string>>>;
+    // Information sections followed by persistent device sections, in the order they are written to disk. Sections
+    // that did not change are shared with earlier snapshots
+    std::vector<std::shared_ptr<const Section>> sections;
+    // Serialize to legacy config format
+    std::string SerializeToLegacyFormat() const;
+  };
+
   ConfigCache(size_t temp_device_capacity, std::unordered_set<std::string_view> persistent_property_names);
   virtual ~ConfigCache() = default;
 
@@ -81,6 +97,9 @@ class ConfigCache {
   virtual bool IsPersistentProperty(const std::string& property) const;
   // Serialize to legacy config format
   virtual std::string SerializeToLegacyFormat() const;
+  // Return a snapshot of the persistent sections. The same snapshot is shared until the next persistent change, and
+  // only the sections changed since the previous snapshot are copied while holding the lock
+  virtual std::shared_ptr<const PersistentSnapshot> GetPersistentSnapshot() const;
   // Return a copy of pair<section_name, property_value> with property
   struct SectionAndPropertyValue {
     std::string section;
@@ -93,6 +112,15 @@ class ConfigCache {
     }
   };
   virtual std::vector<SectionAndPropertyValue> GetSectionNamesWithProperty(const std::string& property) const;
+  // Copy the properties of |section| into |properties|, which is left empty if there is no such section, and return
+  // the change count the copy was taken at
+  virtual uint64_t CopySection(
+      const std::string& section, std::vector<std::pair<std::string, std::string>>* properties) const;
+  // Number of modifications made to this cache so far, it only grows. A copy of a section taken at the current change
+  // count is still accurate, which can be checked without taking the lock
+  uint64_t GetChangeCount() const {
+    return change_count_.load(std::memory_order_acquire);
+  }
 
   // modifiers
   // Commit all mutation entries in sequence while holding the config mutex
@@ -107,6 +135,9 @@ class ConfigCache {
   virtual void Clear();
   // Set a callback to notify interested party that a persistent config change has just happened
   virtual void SetPersistentConfigChangedCallback(std::function<void()> persistent_config_changed_callback);
+  // Set a callback to receive each persistent config change as a mutation entry. Committing these entries in order to
+  // a copy of the persistent sections reproduces the persistent sections of this cache
+  virtual void SetPersistentMutationCallback(std::function<void(MutationEntry)> persistent_mutation_callback);
 
   // Device config specific methods
   // TODO: methods here should be moved to a device specific config cache if this config cache is supposed to be generic
@@ -121,9 +152,15 @@ class ConfigCache {
   static const std::string kDefaultSectionName;
 
  private:
-  mutable std::recursive_mutex mutex_;
+  using Properties = common::ListMap<std::string, std::string>;
+
+  mutable std::shared_mutex mutex_;
+  // Bumped by every modifier with mutex_ held exclusively, before the modification
+  std::atomic<uint64_t> change_count_ = 0;
   // A callback to notify interested party that a persistent config change has just happened, empty by default
   std::function<void()> persistent_config_changed_callback_;
+  // A callback to receive persistent config changes one by one, empty by default
+  std::function<void(MutationEntry)> persistent_mutation_callback_;
   // A set of property names that if set would make a section persistent and if non of these properties are set, a
   // section would become temporary again
   std::unordered_set<std::string_view> persistent_property_names_;
@@ -134,13 +171,66 @@ class ConfigCache {
   // Information about temporary devices, normally unpaired, will not be written to disk, will be evicted automatically
   // if capacity exceeds given value during initialization
   common::LruCache<std::string, common::ListMap<std::string, std::string>> temporary_devices_;
+  // Snapshot of information_sections_ and persistent_devices_ shared by GetPersistentSnapshot(), empty when stale
+  mutable std::shared_ptr<const PersistentSnapshot> persistent_snapshot_;
+  // Immutable copies of persistent sections that did not change since they were last put in a snapshot
+  mutable std::unordered_map<std::string, std::shared_ptr<const PersistentSnapshot::Section>> section_snapshots_;
 
-  // Convenience method to check if the callback is valid before calling it
+  // Convenience method to check if the callback is valid before calling it, every persistent change goes through here
+  // hence it also drops the now stale snapshot
   inline void PersistentConfigChangedCallback() const {
+    persistent_snapshot_.reset();
     if (persistent_config_changed_callback_) {
       persistent_config_changed_callback_();
     }
   }
+
+  // Modifiers, called with mutex_ held exclusively
+  void BumpChangeCountLocked() {
+    change_count_.fetch_add(1, std::memory_order_release);
+  }
+  void SetPropertyLocked(std::string section, std::string property, std::string value);
+  bool RemoveSectionLocked(const std::string& section);
+  bool RemovePropertyLocked(const std::string& section, const std::string& property);
+
+  // Return the properties of an information or persistent section, nullptr if there is none, with mutex_ held
+  const Properties* FindPersistentSectionLocked(const std::string& section) const;
+
+  // Call |read| with the properties of |section|, or nullptr if there is no such section, and return its result.
+  // Information and persistent sections are read with mutex_ shared, temporary ones with mutex_ held exclusively
+  template <typename Read>
+  auto ReadSection(const std::string& section, Read read) const {
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      const Properties* properties = FindPersistentSectionLocked(section);
+      // Only device sections can be temporary
+      if (properties != nullptr || !IsDeviceSection(section)) {
+        return read(properties);
+      }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    // The section may have become persistent while the lock was released
+    const Properties* properties = FindPersistentSectionLocked(section);
+    if (properties == nullptr) {
+      auto section_iter = temporary_devices_.find(section);
+      if (section_iter != temporary_devices_.end()) {
+        properties = &section_iter->second;
+      }
+    }
+    return read(properties);
+  }
+
+  // Same as MutationEntry::Set(), but allows the empty values that are valid in a config cache
+  static MutationEntry PersistentSetEntry(std::string section, std::string property, std::string value);
+
+  // Convenience method to check if the callback is valid before calling it, every persistent change of a section goes
+  // through here hence it also drops the now stale copy of that section
+  inline void PersistentMutationCallback(MutationEntry entry) const {
+    section_snapshots_.erase(entry.section);
+    if (persistent_mutation_callback_) {
+      persistent_mutation_callback_(std::move(entry));
+    }
+  }
 };
 
 }  // namespace storage
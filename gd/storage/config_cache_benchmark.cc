@@ -0,0 +1,142 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "storage/config_cache.h"
+#include "storage/device.h"
+#include "storage/pinned_device.h"
+
+using ::benchmark::State;
+using ::bluetooth::storage::ConfigCache;
+using ::bluetooth::storage::Device;
+using ::bluetooth::storage::PinnedDevice;
+
+namespace {
+
+// A config with |num_devices| bonded devices, each with properties of a typical dual mode device
+void FillConfig(ConfigCache* config, int num_devices) {
+  config->SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  config->SetProperty("Adapter", "LE_LOCAL_KEY_IRK", "fedcba0987654321fedcba0987654321");
+  for (int i = 0; i < num_devices; i++) {
+    char address[18];
+    std::snprintf(address, sizeof(address), "AA:BB:CC:DD:%02X:%02X", i / 256, i % 256);
+    config->SetProperty(address, "Name", "Bluetooth headset " + std::to_string(i));
+    config->SetProperty(address, "DevClass", "2360344");
+    config->SetProperty(address, "DevType", "3");
+    config->SetProperty(address, "AddrType", "0");
+    config->SetProperty(
+        address, "Service", "0000110a-0000-1000-8000-00805f9b34fb 0000110b-0000-1000-8000-00805f9b34fb");
+    config->SetProperty(address, "LinkKeyType", "5");
+    config->SetProperty(address, "PinLength", "0");
+    config->SetProperty(address, "LinkKey", "fedcba0987654321fedcba0987654328");
+    config->SetProperty(address, "LE_KEY_PENC", "fedcba0987654321fedcba0987654328fedcba0987654321fedcba0987654328");
+    config->SetProperty(address, "LE_KEY_PID", "fedcba0987654321fedcba0987654328fedcba09876543");
+  }
+}
+
+// How long a save holds the config cache lock when it serializes the config under it
+void BM_SaveSerializeUnderLock(State& state) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  FillConfig(&config, state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    config.SetProperty("Adapter", "ScanMode", std::to_string(state.iterations()));
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(config.SerializeToLegacyFormat());
+  }
+}
+
+// How long a save holds the config cache lock when it takes a snapshot to serialize elsewhere
+void BM_SaveSnapshotUnderLock(State& state) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  FillConfig(&config, state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    config.SetProperty("Adapter", "ScanMode", std::to_string(state.iterations()));
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(config.GetPersistentSnapshot());
+  }
+}
+
+// Shared by all threads of BM_ConcurrentReadWrite
+ConfigCache* SharedConfig() {
+  static ConfigCache* config = [] {
+    auto* config = new ConfigCache(100, Device::kLinkKeyProperties);
+    FillConfig(config, 10);
+    return config;
+  }();
+  return config;
+}
+
+// Profiles reading properties of bonded devices on several threads, while every 16th access updates a timestamp
+void BM_ConcurrentReadWrite(State& state) {
+  ConfigCache* config = SharedConfig();
+  static std::atomic<int> next_device{0};
+  char address[18];
+  std::snprintf(address, sizeof(address), "AA:BB:CC:DD:00:%02X", next_device++ % 10);
+  int accesses = 0;
+  for (auto _ : state) {
+    if (++accesses % 16 == 0) {
+      config->SetProperty(address, "Timestamp", std::to_string(accesses));
+    } else {
+      benchmark::DoNotOptimize(config->GetProperty(address, "Name"));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Bonded devices: a typical phone has a few, a heavy user tens
+// The properties a connection event reads, through a Device
+void BM_DeviceReads(State& state) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  ConfigCache memory_only_config(100, {});
+  FillConfig(&config, 100);
+  Device device(&config, &memory_only_config, "AA:BB:CC:DD:00:2A");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(device.GetDeviceType());
+    benchmark::DoNotOptimize(device.GetClassOfDevice());
+    benchmark::DoNotOptimize(device.GetPinLength());
+  }
+}
+
+// Same reads through a PinnedDevice, with a change to another section every |state.range(0)| iterations
+void BM_PinnedDeviceReads(State& state) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  ConfigCache memory_only_config(100, {});
+  FillConfig(&config, 100);
+  PinnedDevice device(Device(&config, &memory_only_config, "AA:BB:CC:DD:00:2A"));
+  int64_t count = 0;
+  for (auto _ : state) {
+    if (state.range(0) != 0 && ++count % state.range(0) == 0) {
+      config.SetProperty("Adapter", "ScanMode", std::to_string(count));
+    }
+    benchmark::DoNotOptimize(device.Get<bluetooth::hci::DeviceType>("DevType"));
+    benchmark::DoNotOptimize(device.Get<bluetooth::hci::ClassOfDevice>("DevClass"));
+    benchmark::DoNotOptimize(device.Get<int>("PinLength"));
+  }
+}
+
+BENCHMARK(BM_SaveSerializeUnderLock)->Arg(10)->Arg(100);
+BENCHMARK(BM_SaveSnapshotUnderLock)->Arg(10)->Arg(100);
+BENCHMARK(BM_DeviceReads);
+BENCHMARK(BM_PinnedDeviceReads)->Arg(0)->Arg(100);
+BENCHMARK(BM_ConcurrentReadWrite)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+}  // namespace
@@ -55,61 +55,70 @@ class ConfigCacheHelper {
   virtual void SetBin(const std::string& section, const std::string& property, const std::vector<uint8_t>& value);
   virtual std::optional<std::vector<uint8_t>> GetBin(const std::string& section, const std::string& property) const;
 
-  template <typename T, typename std::enable_if<std::is_signed_v<T> && std::is_integral_v<T>, int>::type = 0>
+  template <typename T>
   std::optional<T> Get(const std::string& section, const std::string& property) {
-    auto value = GetInt64(section, property);
+    auto value = config_cache_.GetProperty(section, property);
     if (!value) {
       return std::nullopt;
     }
-    if (!common::IsNumberInNumericLimits<T>(*value)) {
+    return ParseValue<T>(*value);
+  }
+
+  // Parse |value| as stored in a config cache into a T, return std::nullopt if it does not represent one
+  template <typename T, typename std::enable_if<std::is_signed_v<T> && std::is_integral_v<T>, int>::type = 0>
+  static std::optional<T> ParseValue(const std::string& value) {
+    auto large_value = common::Int64FromString(value);
+    if (!large_value) {
+      return std::nullopt;
+    }
+    if (!common::IsNumberInNumericLimits<T>(*large_value)) {
       return std::nullopt;
     }
-    return static_cast<T>(*value);
+    return static_cast<T>(*large_value);
   }
 
-  template <typename T, typename std::enable_if<std::is_unsigned_v<T> && std::is_integral_v<T>, int>::type = 0>
-  std::optional<T> Get(const std::string& section, const std::string& property) {
-    auto value = GetUint64(section, property);
-    if (!value) {
+  template <
+      typename T,
+      typename std::enable_if<std::is_unsigned_v<T> && std::is_integral_v<T> && !std::is_same_v<T, bool>, int>::type =
+          0>
+  static std::optional<T> ParseValue(const std::string& value) {
+    auto large_value = common::Uint64FromString(value);
+    if (!large_value) {
       return std::nullopt;
     }
-    if (!common::IsNumberInNumericLimits<T>(*value)) {
+    if (!common::IsNumberInNumericLimits<T>(*large_value)) {
       return std::nullopt;
     }
-    return static_cast<T>(*value);
+    return static_cast<T>(*large_value);
   }
 
   template <typename T, typename std::enable_if<std::is_same_v<T, std::string>, int>::type = 0>
-  std::optional<T> Get(const std::string& section, const std::string& property) {
-    return config_cache_.GetProperty(section, property);
+  static std::optional<T> ParseValue(const std::string& value) {
+    return value;
   }
 
   template <typename T, typename std::enable_if<std::is_same_v<T, std::vector<uint8_t>>, int>::type = 0>
-  std::optional<T> Get(const std::string& section, const std::string& property) {
-    return GetBin(section, property);
+  static std::optional<T> ParseValue(const std::string& value) {
+    auto bytes = common::FromHexString(value);
+    if (!bytes) {
+      LOG_WARN("value_str cannot be parsed to std::vector<uint8_t>");
+    }
+    return bytes;
   }
 
   template <typename T, typename std::enable_if<std::is_same_v<T, bool>, int>::type = 0>
-  std::optional<T> Get(const std::string& section, const std::string& property) {
-    return GetBool(section, property);
+  static std::optional<T> ParseValue(const std::string& value) {
+    return common::BoolFromString(value);
   }
 
   template <typename T, typename std::enable_if<std::is_base_of_v<Serializable<T>, T>, int>::type = 0>
-  std::optional<T> Get(const std::string& section, const std::string& property) {
-    auto value = config_cache_.GetProperty(section, property);
-    if (!value) {
-      return std::nullopt;
-    }
-    return T::FromLegacyConfigString(*value);
+  static std::optional<T> ParseValue(const std::string& value) {
+    return T::FromLegacyConfigString(value);
   }
 
   template <typename T, typename std::enable_if<std::is_enum_v<T>, int>::type = 0>
-  std::optional<T> Get(const std::string& section, const std::string& property) {
-    auto value = config_cache_.GetProperty(section, property);
-    if (!value) {
-      return std::nullopt;
-    }
-    return bluetooth::FromLegacyConfigString<T>(*value);
+  static std::optional<T> ParseValue(const std::string& value) {
+    return bluetooth::FromLegacyConfigString<T>(value);
   }
 
   template <
@@ -118,12 +127,8 @@ class ConfigCacheHelper {
           bluetooth::common::is_specialization_of<T, std::vector>::value &&
               std::is_base_of_v<Serializable<typename T::value_type>, typename T::value_type>,
           int>::type = 0>
-  std::optional<T> Get(const std::string& section, const std::string& property) {
-    auto value = config_cache_.GetProperty(section, property);
-    if (!value) {
-      return std::nullopt;
-    }
-    auto values = common::StringSplit(*value, " ");
+  static std::optional<T> ParseValue(const std::string& value) {
+    auto values = common::StringSplit(value, " ");
     T result;
     result.reserve(values.size());
     for (const auto& str : values) {
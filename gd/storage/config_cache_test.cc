@@ -20,6 +20,9 @@
 #include <gtest/gtest.h>
 
 #include <cstdio>
+#include <queue>
+#include <thread>
+#include <vector>
 
 #include "hci/enum_helper.h"
 #include "storage/device.h"
@@ -37,6 +40,7 @@ std::string GetTestAddress(int i) {
 
 using bluetooth::storage::ConfigCache;
 using bluetooth::storage::Device;
+using bluetooth::storage::MutationEntry;
 using SectionAndPropertyValue = bluetooth::storage::ConfigCache::SectionAndPropertyValue;
 
 TEST(ConfigCacheTest, simple_set_get_test) {
@@ -275,6 +279,69 @@ TEST(ConfigCacheTest, persistent_config_changed_callback_test) {
   ASSERT_EQ(num_change, 4);
 }
 
+TEST(ConfigCacheTest, persistent_mutation_callback_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  std::queue<MutationEntry> entries;
+  config.SetPersistentMutationCallback([&entries](MutationEntry entry) { entries.push(std::move(entry)); });
+  config.SetProperty("A", "B", "C");
+  ASSERT_EQ(entries.size(), 1u);
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "B", "C");
+  ASSERT_EQ(entries.size(), 1u);
+  // the temporary property and the link key become persistent together
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "LinkKey", "AABBAABBCCDDEE");
+  ASSERT_EQ(entries.size(), 3u);
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "Name", "");
+  config.SetProperty("CC:DD:EE:FF:00:11", "LE_KEY_PENC", "AABBAABBCCDDEE");
+  config.SetProperty("CC:DD:EE:FF:00:11", "B", "C");
+  config.RemoveProperty("CC:DD:EE:FF:00:11", "LE_KEY_PENC");
+  config.RemoveProperty("AA:BB:CC:DD:EE:FF", "B");
+  config.RemoveProperty("A", "B");
+  config.SetProperty("D", "E", "F");
+  ASSERT_TRUE(config.FixDeviceTypeInconsistencies());
+
+  // committing the entries to an empty config gives the same persistent config
+  ConfigCache replica(100, Device::kLinkKeyProperties);
+  replica.Commit(entries);
+  ASSERT_EQ(replica.SerializeToLegacyFormat(), config.SerializeToLegacyFormat());
+  ASSERT_FALSE(replica.HasSection("CC:DD:EE:FF:00:11"));
+  ASSERT_THAT(replica.GetProperty("AA:BB:CC:DD:EE:FF", "Name"), Optional(StrEq("")));
+
+  config.RemoveSectionWithProperty("LinkKey");
+  config.Clear();
+  ASSERT_EQ(entries.size(), 2u);
+  replica.Commit(entries);
+  ASSERT_EQ(replica.SerializeToLegacyFormat(), "");
+}
+
+TEST(ConfigCacheTest, persistent_snapshot_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("A", "B", "C");
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "B", "C");
+  auto snapshot = config.GetPersistentSnapshot();
+  ASSERT_EQ(snapshot->SerializeToLegacyFormat(), config.SerializeToLegacyFormat());
+  // shared until a persistent change
+  ASSERT_EQ(config.GetPersistentSnapshot(), snapshot);
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "C", "D");
+  ASSERT_EQ(config.GetPersistentSnapshot(), snapshot);
+  config.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+  auto new_snapshot = config.GetPersistentSnapshot();
+  ASSERT_NE(new_snapshot, snapshot);
+  // earlier snapshots do not change
+  ASSERT_EQ(snapshot->SerializeToLegacyFormat(), "[A]\nB = C\n\n");
+  ASSERT_EQ(new_snapshot->SerializeToLegacyFormat(), "[A]\nB = C\n\n[CC:DD:EE:FF:00:11]\nLinkKey = AABBAABBCCDDEE\n\n");
+  // unchanged sections are shared
+  ASSERT_EQ(new_snapshot->sections[0], snapshot->sections[0]);
+  config.SetProperty("A", "B", "D");
+  auto last_snapshot = config.GetPersistentSnapshot();
+  ASSERT_NE(last_snapshot->sections[0], new_snapshot->sections[0]);
+  ASSERT_EQ(last_snapshot->sections[1], new_snapshot->sections[1]);
+  ASSERT_EQ(new_snapshot->sections[0]->second[0].second, "C");
+  config.RemoveSection("A");
+  ASSERT_EQ(new_snapshot->sections.size(), 2u);
+  ASSERT_EQ(
+      config.GetPersistentSnapshot()->SerializeToLegacyFormat(), "[CC:DD:EE:FF:00:11]\nLinkKey = AABBAABBCCDDEE\n\n");
+}
+
 TEST(ConfigCacheTest, fix_device_type_inconsistency_test) {
   ConfigCache config(100, Device::kLinkKeyProperties);
   config.SetProperty("A", "B", "C");
@@ -337,4 +404,33 @@ TEST(ConfigCacheTest, test_empty_persistent_properties) {
   ASSERT_THAT(config.GetPersistentSections(), ElementsAre());
 }
 
-}  // namespace testing
\ No newline at end of file
+TEST(ConfigCacheTest, concurrent_readers_and_writer_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "LinkKey", "AABBAABBCCDDEE");
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "Name", "Headset");
+  size_t num_changes = 0;
+  config.SetPersistentConfigChangedCallback([&num_changes] { num_changes++; });
+  constexpr int kNumWrites = 2000;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&config] {
+      for (int j = 0; j < kNumWrites; j++) {
+        ASSERT_EQ(config.GetProperty("AA:BB:CC:DD:EE:FF", "Name"), "Headset");
+        // A temporary section, read under the exclusive lock
+        config.HasSection("AA:BB:CC:DD:EE:00");
+      }
+    });
+  }
+  for (int j = 0; j < kNumWrites; j++) {
+    config.SetProperty("AA:BB:CC:DD:EE:FF", "Timestamp", std::to_string(j));
+    config.SetProperty("AA:BB:CC:DD:EE:00", "Rssi", std::to_string(j));
+  }
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(num_changes, static_cast<size_t>(kNumWrites));
+  ASSERT_EQ(config.GetProperty("AA:BB:CC:DD:EE:FF", "Timestamp"), std::to_string(kNumWrites - 1));
+  ASSERT_EQ(config.GetProperty("AA:BB:CC:DD:EE:00", "Rssi"), std::to_string(kNumWrites - 1));
+}
+
+}  // namespace testing
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_journal.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <sstream>
+
+#include "common/strings.h"
+#include "os/files.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace storage {
+
+namespace {
+
+constexpr char kSetRecord[] = "S";
+constexpr char kRemovePropertyRecord[] = "P";
+constexpr char kRemoveSectionRecord[] = "R";
+constexpr char kCommitRecord[] = "C";
+constexpr char kDelimiter[] = "\t";
+
+}  // namespace
+
+ConfigJournal::ConfigJournal(std::string path) : path_(std::move(path)) {
+  ASSERT(!path_.empty());
+};
+
+std::string ConfigJournal::SerializeBatch(const std::vector<MutationEntry>& entries) {
+  std::stringstream serialized;
+  for (const auto& entry : entries) {
+    switch (entry.entry_type) {
+      case MutationEntry::EntryType::SET:
+        serialized << kSetRecord << kDelimiter << entry.section << kDelimiter << entry.property << kDelimiter
+                   << entry.value << "\n";
+        break;
+      case MutationEntry::EntryType::REMOVE_PROPERTY:
+        serialized << kRemovePropertyRecord << kDelimiter << entry.section << kDelimiter << entry.property << "\n";
+        break;
+      case MutationEntry::EntryType::REMOVE_SECTION:
+        serialized << kRemoveSectionRecord << kDelimiter << entry.section << "\n";
+        break;
+        // do not write a default case so that when a new enum is defined, compilation would fail automatically
+    }
+  }
+  serialized << kCommitRecord << kDelimiter << entries.size() << "\n";
+  return serialized.str();
+}
+
+bool ConfigJournal::Append(const std::string& batch) {
+  return os::AppendToFile(path_, batch);
+}
+
+size_t ConfigJournal::Replay(ConfigCache* cache) {
+  ASSERT(cache != nullptr);
+  if (!os::FileExists(path_)) {
+    return 0;
+  }
+  auto journal = os::ReadSmallFile(path_);
+  if (!journal) {
+    LOG_ERROR("unable to read journal '%s'", path_.c_str());
+    return 0;
+  }
+  size_t num_committed = 0;
+  std::queue<MutationEntry> batch;
+  std::string::size_type line_start = 0;
+  // A line without a trailing new line was not completely written, hence stop there
+  for (auto line_end = journal->find('\n'); line_end != std::string::npos;
+       line_start = line_end + 1, line_end = journal->find('\n', line_start)) {
+    auto tokens = common::StringSplit(journal->substr(line_start, line_end - line_start), kDelimiter, 4);
+    if (tokens[0] == kSetRecord && tokens.size() == 4 && !tokens[1].empty() && !tokens[2].empty()) {
+      // Values can be empty, hence not using MutationEntry::Set()
+      batch.push(MutationEntry(
+          MutationEntry::EntryType::SET,
+          MutationEntry::PropertyType::NORMAL,
+          std::move(tokens[1]),
+          std::move(tokens[2]),
+          std::move(tokens[3])));
+    } else if (tokens[0] == kRemovePropertyRecord && tokens.size() == 3 && !tokens[1].empty() && !tokens[2].empty()) {
+      batch.push(
+          MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, std::move(tokens[1]), std::move(tokens[2])));
+    } else if (tokens[0] == kRemoveSectionRecord && tokens.size() == 2 && !tokens[1].empty()) {
+      batch.push(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, std::move(tokens[1])));
+    } else if (tokens[0] == kCommitRecord && tokens.size() == 2 && tokens[1] == std::to_string(batch.size())) {
+      num_committed += batch.size();
+      cache->Commit(batch);
+    } else {
+      LOG_WARN("dropping journal '%s' after %zu entries at malformed record", path_.c_str(), num_committed);
+      return num_committed;
+    }
+  }
+  if (!batch.empty()) {
+    LOG_WARN("dropping %zu uncommitted entries at the end of journal '%s'", batch.size(), path_.c_str());
+  }
+  return num_committed;
+}
+
+bool ConfigJournal::Delete() {
+  if (remove(path_.c_str()) != 0) {
+    LOG_WARN("unable to remove file '%s', error: %s", path_.c_str(), strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/config_cache.h"
+#include "storage/mutation_entry.h"
+
+namespace bluetooth {
+namespace storage {
+
+// An append-only log of the persistent config changes made since the legacy config file was last written
+//
+// Each append is a batch of records with one record per line, followed by a commit record:
+//   S<tab>section<tab>property<tab>value
+//   P<tab>section<tab>property
+//   R<tab>section
+//   C<tab>number of records in the batch
+// Batches without a matching commit record, e.g. cut short by a crash, are ignored when replaying
+class ConfigJournal {
+ public:
+  static ConfigJournal FromPath(std::string path) {
+    return ConfigJournal(std::move(path));
+  }
+  explicit ConfigJournal(std::string path);
+  // Serialize |entries| into a batch that can be appended to a journal
+  static std::string SerializeBatch(const std::vector<MutationEntry>& entries);
+  // Append |batch| to the journal, it is on disk when this returns true
+  bool Append(const std::string& batch);
+  // Commit all complete batches in the journal to |cache| in order, return the number of entries committed
+  size_t Replay(ConfigCache* cache);
+  bool Delete();
+
+ private:
+  std::string path_;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_journal.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "os/files.h"
+#include "storage/device.h"
+
+namespace testing {
+
+using bluetooth::os::AppendToFile;
+using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigJournal;
+using bluetooth::storage::Device;
+using bluetooth::storage::MutationEntry;
+
+class ConfigJournalTest : public Test {
+ protected:
+  void SetUp() override {
+    temp_journal_ = std::filesystem::temp_directory_path() / "temp_config.journal";
+    std::filesystem::remove(temp_journal_);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(temp_journal_);
+  }
+
+  std::filesystem::path temp_journal_;
+};
+
+TEST_F(ConfigJournalTest, append_and_replay_loop_back_test) {
+  auto journal = ConfigJournal::FromPath(temp_journal_.string());
+  ASSERT_TRUE(journal.Append(ConfigJournal::SerializeBatch(
+      {MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "A", "B", "C\tD"),
+       MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "AA:BB:CC:DD:EE:FF", "LinkKey", "AABBAABBCCDDEE"),
+       MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "AA:BB:CC:DD:EE:FF", "B", "C")})));
+  ASSERT_TRUE(journal.Append(ConfigJournal::SerializeBatch(
+      {MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, "AA:BB:CC:DD:EE:FF", "B"),
+       MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "E", "F", "G"),
+       MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, "E")})));
+
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  ASSERT_EQ(journal.Replay(&config), 6u);
+  EXPECT_THAT(config.GetProperty("A", "B"), Optional(StrEq("C\tD")));
+  EXPECT_THAT(config.GetPersistentSections(), ElementsAre("AA:BB:CC:DD:EE:FF"));
+  EXPECT_FALSE(config.HasProperty("AA:BB:CC:DD:EE:FF", "B"));
+  EXPECT_FALSE(config.HasSection("E"));
+  EXPECT_TRUE(journal.Delete());
+  EXPECT_FALSE(std::filesystem::exists(temp_journal_));
+}
+
+TEST_F(ConfigJournalTest, replay_empty_value_test) {
+  auto journal = ConfigJournal::FromPath(temp_journal_.string());
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "S\tA\tB\t\nC\t1\n"));
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  ASSERT_EQ(journal.Replay(&config), 1u);
+  EXPECT_THAT(config.GetProperty("A", "B"), Optional(StrEq("")));
+}
+
+TEST_F(ConfigJournalTest, replay_missing_journal_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  ASSERT_EQ(ConfigJournal::FromPath(temp_journal_.string()).Replay(&config), 0u);
+  EXPECT_EQ(config.SerializeToLegacyFormat(), "");
+}
+
+TEST_F(ConfigJournalTest, replay_ignores_partial_batch_test) {
+  auto journal = ConfigJournal::FromPath(temp_journal_.string());
+  ASSERT_TRUE(journal.Append(
+      ConfigJournal::SerializeBatch({MutationEntry::Set(MutationEntry::PropertyType::NORMAL, "A", "B", "C")})));
+  // a batch that was cut short before its commit record
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "S\tA\tB\tD\nS\tE\tF\tG\nC\t"));
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  ASSERT_EQ(journal.Replay(&config), 1u);
+  EXPECT_THAT(config.GetProperty("A", "B"), Optional(StrEq("C")));
+  EXPECT_FALSE(config.HasSection("E"));
+}
+
+TEST_F(ConfigJournalTest, replay_stops_at_malformed_record_test) {
+  auto journal = ConfigJournal::FromPath(temp_journal_.string());
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "S\tA\tB\tC\nC\t1\nS\tA\nC\t1\nS\tE\tF\tG\nC\t1\n"));
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  ASSERT_EQ(journal.Replay(&config), 1u);
+  EXPECT_THAT(config.GetProperty("A", "B"), Optional(StrEq("C")));
+  EXPECT_FALSE(config.HasSection("E"));
+}
+
+}  // namespace testing
@@ -37,6 +37,7 @@ namespace storage {
 
 class LeDevice;
 class ClassicDevice;
+class PinnedDevice;
 
 // Make sure our macro is used
 #ifdef GENERATE_PROPERTY_GETTER_SETTER_REMOVER
@@ -172,6 +173,7 @@ class Device {
   ConfigCache* memory_only_config_;
   std::string section_;
   friend std::hash<Device>;
+  friend PinnedDevice;
 
  public:
   // Macro generate getters, setters and removers
@@ -187,6 +189,8 @@ class Device {
   GENERATE_PROPERTY_GETTER_SETTER_REMOVER(PinLength, int, "PinLength");
   // unix timestamp in seconds from epoch
   GENERATE_PROPERTY_GETTER_SETTER_REMOVER(CreationUnixTimestamp, int, "DevClass");
+  // unix timestamp in seconds from epoch of when Name was read or learned
+  GENERATE_PROPERTY_GETTER_SETTER_REMOVER(NameUnixTimestamp, int64_t, "NameTimestamp");
 };
 
 }  // namespace storage
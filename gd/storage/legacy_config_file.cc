@@ -74,6 +74,10 @@ bool LegacyConfigFile::Write(const ConfigCache& cache) {
   return os::WriteToFile(path_, cache.SerializeToLegacyFormat());
 }
 
+bool LegacyConfigFile::Write(const ConfigCache::PersistentSnapshot& snapshot) {
+  return os::WriteToFile(path_, snapshot.SerializeToLegacyFormat());
+}
+
 bool LegacyConfigFile::Delete() {
   if (remove(path_.c_str()) != 0) {
     LOG_WARN("unable to remove file '%s', error: %s", path_.c_str(), strerror(errno));
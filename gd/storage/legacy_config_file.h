@@ -32,6 +32,7 @@ class LegacyConfigFile {
   explicit LegacyConfigFile(std::string path);
   std::optional<ConfigCache> Read(size_t temp_devices_capacity);
   bool Write(const ConfigCache& cache);
+  bool Write(const ConfigCache::PersistentSnapshot& snapshot);
   bool Delete();
 
  private:
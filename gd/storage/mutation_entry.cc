@@ -21,6 +21,13 @@
 namespace bluetooth {
 namespace storage {
 
+MutationEntry MutationEntry::Set(
+    PropertyType property_type, std::string section_param, std::string property_param, std::string value_param) {
+  ASSERT_LOG(!value_param.empty(), "value cannot be empty for EntryType::SET");
+  return MutationEntry(
+      EntryType::SET, property_type, std::move(section_param), std::move(property_param), std::move(value_param));
+}
+
 MutationEntry::MutationEntry(
     EntryType entry_type_param,
     PropertyType property_type_param,
@@ -34,9 +41,9 @@ MutationEntry::MutationEntry(
       value(std::move(value_param)) {
   switch (entry_type) {
     case EntryType::SET:
+      // empty values are allowed in config caches, hence only Set() rejects them
       ASSERT_LOG(!section.empty(), "section cannot be empty for EntryType::SET");
       ASSERT_LOG(!property.empty(), "property cannot be empty for EntryType::SET");
-      ASSERT_LOG(!value.empty(), "value cannot be empty for EntryType::SET");
       break;
     case EntryType::REMOVE_PROPERTY:
       ASSERT_LOG(!section.empty(), "section cannot be empty for EntryType::REMOVE_PROPERTY");
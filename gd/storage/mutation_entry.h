@@ -88,10 +88,7 @@ class MutationEntry {
   }
 
   static MutationEntry Set(
-      PropertyType property_type, std::string section_param, std::string property_param, std::string value_param) {
-    return MutationEntry(
-        EntryType::SET, property_type, std::move(section_param), std::move(property_param), std::move(value_param));
-  }
+      PropertyType property_type, std::string section_param, std::string property_param, std::string value_param);
 
   static MutationEntry Remove(PropertyType property_type, std::string section_param) {
     return MutationEntry(EntryType::REMOVE_SECTION, property_type, std::move(section_param));
@@ -104,6 +101,7 @@ class MutationEntry {
 
  private:
   friend class ConfigCache;
+  friend class ConfigJournal;
   friend class Mutation;
 
   MutationEntry(
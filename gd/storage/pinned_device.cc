@@ -0,0 +1,62 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "storage/pinned_device.h"
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace storage {
+
+PinnedDevice::PinnedDevice(Device device) : device_(std::move(device)) {
+  ASSERT(device_.config_ != nullptr);
+  ASSERT(device_.memory_only_config_ != nullptr);
+  normal_.config = device_.config_;
+  memory_only_.config = device_.memory_only_config_;
+}
+
+std::optional<std::string> PinnedDevice::GetProperty(const std::string& property) const {
+  const std::string* value = Find(normal_, property);
+  if (value == nullptr) {
+    return std::nullopt;
+  }
+  return *value;
+}
+
+std::optional<std::string> PinnedDevice::GetTempProperty(const std::string& property) const {
+  const std::string* value = Find(memory_only_, property);
+  if (value == nullptr) {
+    return std::nullopt;
+  }
+  return *value;
+}
+
+const std::string* PinnedDevice::Find(SectionCopy& copy, const std::string& property) const {
+  if (!copy.valid || copy.change_count != copy.config->GetChangeCount()) {
+    copy.change_count = copy.config->CopySection(device_.section_, &copy.properties);
+    copy.valid = true;
+    refresh_count_++;
+  }
+  // Device sections hold a couple dozen properties at most, a scan is cheaper than hashing the name
+  for (const auto& entry : copy.properties) {
+    if (entry.first == property) {
+      return &entry.second;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace storage
+}  // namespace bluetooth
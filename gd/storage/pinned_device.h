@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/config_cache.h"
+#include "storage/config_cache_helper.h"
+#include "storage/device.h"
+
+namespace bluetooth {
+namespace storage {
+
+// A copy of the properties of a Device, for code that reads them repeatedly, e.g. on each event of a connection
+//
+// Obtain one per connection from the Device. Reads return values from the copy without taking the ConfigCache lock nor
+// looking up the section. The copy is taken again on the first read after any change to the ConfigCache, so reads
+// always see the committed values.
+//
+// Changes still go through the Device returned by GetDevice() and a Mutation.
+//
+// Not thread safe, as reads refresh the copy. Use one PinnedDevice per thread.
+class PinnedDevice {
+ public:
+  explicit PinnedDevice(Device device);
+
+  const Device& GetDevice() const {
+    return device_;
+  }
+
+  // Property value in the normal config, std::nullopt if not set
+  std::optional<std::string> GetProperty(const std::string& property) const;
+  // Property value in the memory-only config, std::nullopt if not set
+  std::optional<std::string> GetTempProperty(const std::string& property) const;
+
+  // Typed access, same as what the getters of Device, ClassicDevice and LeDevice return
+  template <typename T>
+  std::optional<T> Get(const std::string& property) const {
+    const std::string* value = Find(normal_, property);
+    if (value == nullptr) {
+      return std::nullopt;
+    }
+    return ConfigCacheHelper::ParseValue<T>(*value);
+  }
+  template <typename T>
+  std::optional<T> GetTemp(const std::string& property) const {
+    const std::string* value = Find(memory_only_, property);
+    if (value == nullptr) {
+      return std::nullopt;
+    }
+    return ConfigCacheHelper::ParseValue<T>(*value);
+  }
+
+  // Number of times the copy was taken, for tests and dumpsys
+  uint64_t GetRefreshCount() const {
+    return refresh_count_;
+  }
+
+ private:
+  struct SectionCopy {
+    ConfigCache* config;
+    std::vector<std::pair<std::string, std::string>> properties;
+    uint64_t change_count;
+    bool valid = false;
+  };
+
+  // Return the value of |property| in |copy|, taking the copy again first if its config changed, nullptr if not set.
+  // The pointer is valid until the next read
+  const std::string* Find(SectionCopy& copy, const std::string& property) const;
+
+  Device device_;
+  mutable SectionCopy normal_;
+  mutable SectionCopy memory_only_;
+  mutable uint64_t refresh_count_ = 0;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "storage/pinned_device.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "hci/class_of_device.h"
+#include "storage/device.h"
+#include "storage/mutation.h"
+
+namespace testing {
+
+using bluetooth::hci::Address;
+using bluetooth::hci::ClassOfDevice;
+using bluetooth::hci::DeviceType;
+using bluetooth::storage::ConfigCache;
+using bluetooth::storage::Device;
+using bluetooth::storage::Mutation;
+using bluetooth::storage::PinnedDevice;
+
+class PinnedDeviceTest : public Test {
+ protected:
+  ConfigCache config_{10, Device::kLinkKeyProperties};
+  ConfigCache memory_only_config_{10, {}};
+  Address address_ = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06}};
+  Device device_{&config_, &memory_only_config_, address_, Device::ConfigKeyAddressType::CLASSIC_ADDRESS};
+};
+
+TEST_F(PinnedDeviceTest, reads_same_values_as_device) {
+  Mutation mutation(&config_, &memory_only_config_);
+  mutation.Add(device_.SetName("hello"));
+  mutation.Add(device_.SetDeviceType(DeviceType::BR_EDR));
+  mutation.Add(device_.SetManufacturerCode(0x0102));
+  mutation.Add(device_.SetClassOfDevice(ClassOfDevice({0x01, 0x02, 0x03})));
+  mutation.Commit();
+
+  PinnedDevice pinned(device_);
+  ASSERT_THAT(pinned.GetProperty("Name"), Optional(StrEq("hello")));
+  ASSERT_EQ(pinned.Get<DeviceType>("DevType"), device_.GetDeviceType());
+  ASSERT_EQ(pinned.Get<uint16_t>("Manufacturer"), device_.GetManufacturerCode());
+  ASSERT_EQ(pinned.Get<ClassOfDevice>("DevClass"), device_.GetClassOfDevice());
+  ASSERT_FALSE(pinned.GetProperty("LmpVer"));
+  ASSERT_FALSE(pinned.Get<uint8_t>("Name"));
+}
+
+TEST_F(PinnedDeviceTest, copies_section_once_until_config_changes) {
+  config_.SetProperty(address_.ToString(), "Name", "hello");
+  PinnedDevice pinned(device_);
+  ASSERT_THAT(pinned.GetProperty("Name"), Optional(StrEq("hello")));
+  ASSERT_THAT(pinned.GetProperty("Name"), Optional(StrEq("hello")));
+  ASSERT_FALSE(pinned.GetProperty("LmpVer"));
+  ASSERT_EQ(pinned.GetRefreshCount(), 1u);
+
+  Mutation mutation(&config_, &memory_only_config_);
+  mutation.Add(device_.SetName("world"));
+  mutation.Commit();
+  ASSERT_THAT(pinned.GetProperty("Name"), Optional(StrEq("world")));
+  ASSERT_EQ(pinned.GetRefreshCount(), 2u);
+
+  config_.RemoveSection(address_.ToString());
+  ASSERT_FALSE(pinned.GetProperty("Name"));
+}
+
+TEST_F(PinnedDeviceTest, temp_properties_come_from_memory_only_config) {
+  memory_only_config_.SetProperty(address_.ToString(), "Name", "temp");
+  PinnedDevice pinned(device_);
+  ASSERT_FALSE(pinned.GetProperty("Name"));
+  ASSERT_THAT(pinned.GetTempProperty("Name"), Optional(StrEq("temp")));
+  ASSERT_THAT(pinned.GetTemp<std::string>("Name"), Optional(StrEq("temp")));
+}
+
+}  // namespace testing
@@ -18,6 +18,7 @@
 
 #include <chrono>
 #include <ctime>
+#include <future>
 #include <iomanip>
 #include <memory>
 #include <utility>
@@ -28,7 +29,9 @@
 #include "os/handler.h"
 #include "os/parameter_provider.h"
 #include "os/system_properties.h"
+#include "os/thread.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
 #include "storage/legacy_config_file.h"
 #include "storage/mutation.h"
 
@@ -48,6 +51,11 @@ static const std::chrono::milliseconds kDefaultConfigSaveDelay = std::chrono::mi
 // Writing a config to disk takes a minimum 10 ms on a decent x86_64 machine, and 20 ms if including backup file
 // The config saving delay must be bigger than this value to avoid overwhelming the disk
 static const std::chrono::milliseconds kMinConfigSaveDelay = std::chrono::milliseconds(20);
+// Saved changes are appended to a journal until it grows past this size, then the whole config is written again and
+// the journal is emptied. This bounds both the journal replay time and the disk usage
+static const size_t kMaxConfigJournalSize = 16 * 1024;
+// Stop() waits for all saves to be written first, hence the I/O thread only has its last task to finish
+static const std::chrono::milliseconds kIoThreadStopTimeout = std::chrono::milliseconds(2000);
 
 const std::string StorageModule::kInfoSection = "Info";
 const std::string StorageModule::kFileSourceProperty = "FileSource";
@@ -69,6 +77,8 @@ StorageModule::StorageModule(
       is_single_user_mode_(is_single_user_mode) {
   // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.bak"
   config_backup_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".bak";
+  // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.journal"
+  config_journal_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".journal";
   ASSERT_LOG(
       config_save_delay > kMinConfigSaveDelay,
       "Config save delay of %lld ms is not enough, must be at least %lld ms to avoid overwhelming the disk",
@@ -89,10 +99,24 @@ const ModuleFactory StorageModule::Factory = ModuleFactory([]() {
 struct StorageModule::impl {
   explicit impl(Handler* handler, ConfigCache cache, size_t in_memory_cache_size_limit)
       : config_save_alarm_(handler), cache_(std::move(cache)), memory_only_cache_(in_memory_cache_size_limit, {}) {}
+  ~impl() {
+    io_handler_.Clear();
+    io_handler_.WaitUntilStopped(kIoThreadStopTimeout);
+  }
+  // Config files are written on this thread, in the order saves were requested, so that neither the module handler
+  // nor config cache readers wait for the disk
+  os::Thread io_thread_{"bt_storage_io_thread", os::Thread::Priority::NORMAL};
+  Handler io_handler_{&io_thread_};
   Alarm config_save_alarm_;
   ConfigCache cache_;
   ConfigCache memory_only_cache_;
   bool has_pending_config_save_ = false;
+  // Persistent changes not yet saved to disk
+  std::vector<MutationEntry> pending_journal_entries_;
+  // Size of the journal on disk since the config files were last written
+  size_t journal_size_ = 0;
+  // Whether the next save must write the whole config instead of appending to the journal
+  bool has_pending_compaction_ = true;
 };
 
 Mutation StorageModule::Modify() {
@@ -116,24 +140,74 @@ void StorageModule::SaveDelayed() {
     return;
   }
   pimpl_->config_save_alarm_.Schedule(
-      common::BindOnce(&StorageModule::SaveImmediately, common::Unretained(this)), config_save_delay_);
+      common::BindOnce(&StorageModule::PostSave, common::Unretained(this)), config_save_delay_);
   pimpl_->has_pending_config_save_ = true;
 }
 
 void StorageModule::SaveImmediately() {
+  std::promise<void> saved;
+  auto saved_future = saved.get_future();
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    PostSave();
+    pimpl_->io_handler_.Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(&saved)));
+  }
+  // Wait without holding the lock, the I/O thread takes it when an append fails
+  saved_future.wait();
+}
+
+void StorageModule::PostSave() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
   if (pimpl_->has_pending_config_save_) {
     pimpl_->config_save_alarm_.Cancel();
     pimpl_->has_pending_config_save_ = false;
   }
+  if (!pimpl_->has_pending_compaction_) {
+    if (pimpl_->pending_journal_entries_.empty()) {
+      return;
+    }
+    auto batch = ConfigJournal::SerializeBatch(pimpl_->pending_journal_entries_);
+    pimpl_->pending_journal_entries_.clear();
+    if (pimpl_->journal_size_ + batch.size() <= kMaxConfigJournalSize) {
+      pimpl_->journal_size_ += batch.size();
+      pimpl_->io_handler_.Post(
+          common::BindOnce(&StorageModule::AppendToJournal, common::Unretained(this), std::move(batch)));
+      return;
+    }
+  }
+  pimpl_->pending_journal_entries_.clear();
+  pimpl_->journal_size_ = 0;
+  pimpl_->has_pending_compaction_ = false;
+  // Later changes are journaled on top of this snapshot, and appended after it is written as the I/O thread runs tasks
+  // in order
+  pimpl_->io_handler_.Post(common::BindOnce(
+      &StorageModule::WriteConfigFiles, common::Unretained(this), pimpl_->cache_.GetPersistentSnapshot()));
+}
+
+void StorageModule::AppendToJournal(std::string batch) {
+  if (ConfigJournal::FromPath(config_journal_path_).Append(batch)) {
+    return;
+  }
+  // A failed append may leave a partial batch behind, which writing the whole config removes as well
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  pimpl_->has_pending_compaction_ = true;
+  SaveDelayed();
+}
+
+void StorageModule::WriteConfigFiles(std::shared_ptr<const ConfigCache::PersistentSnapshot> snapshot) {
   // 1. rename old config to backup name
   if (os::FileExists(config_file_path_)) {
     ASSERT(os::RenameFile(config_file_path_, config_backup_path_));
   }
-  // 2. write in-memory config to disk, if failed, backup can still be used
-  ASSERT(LegacyConfigFile::FromPath(config_file_path_).Write(pimpl_->cache_));
+  // 2. write in-memory config to disk, if failed, backup and journal can still be used
+  ASSERT(LegacyConfigFile::FromPath(config_file_path_).Write(*snapshot));
   // 3. now write back up to disk as well
-  ASSERT(LegacyConfigFile::FromPath(config_backup_path_).Write(pimpl_->cache_));
+  ASSERT(LegacyConfigFile::FromPath(config_backup_path_).Write(*snapshot));
+  // 4. drop the journal that is now part of both files. If this does not happen, replaying it again later is harmless
+  //    because each of its entries only sets or removes what the last entry for the same section and property set
+  if (os::FileExists(config_journal_path_)) {
+    ConfigJournal::FromPath(config_journal_path_).Delete();
+  }
 }
 
 void StorageModule::ListDependencies(ModuleList* list) {
@@ -146,6 +220,7 @@ void StorageModule::Start() {
   if (os::GetSystemProperty(kFactoryResetProperty) == "true") {
     LegacyConfigFile::FromPath(config_file_path_).Delete();
     LegacyConfigFile::FromPath(config_backup_path_).Delete();
+    ConfigJournal::FromPath(config_journal_path_).Delete();
   }
   auto config = LegacyConfigFile::FromPath(config_file_path_).Read(temp_devices_capacity_);
   if (!config || !config->HasSection(kAdapterSection)) {
@@ -158,6 +233,11 @@ void StorageModule::Start() {
     config.emplace(temp_devices_capacity_, Device::kLinkKeyProperties);
     file_source = "Empty";
   }
+  // Apply changes saved after the config files were last written, the first save below writes them into these files
+  auto num_replayed = ConfigJournal::FromPath(config_journal_path_).Replay(&config.value());
+  if (num_replayed > 0) {
+    LOG_INFO("replayed %zu config changes from %s", num_replayed, config_journal_path_.c_str());
+  }
   if (!file_source.empty()) {
     config->SetProperty(kInfoSection, kFileSourceProperty, std::move(file_source));
   }
@@ -176,14 +256,23 @@ void StorageModule::Start() {
   }
   config->FixDeviceTypeInconsistencies();
   config->SetPersistentConfigChangedCallback([this] { this->SaveDelayed(); });
+  config->SetPersistentMutationCallback([this](MutationEntry entry) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    pimpl_->pending_journal_entries_.push_back(std::move(entry));
+  });
   // TODO (b/158035889) Migrate metrics module to GD
   pimpl_ = std::make_unique<impl>(GetHandler(), std::move(config.value()), temp_devices_capacity_);
   SaveDelayed();
 }
 
 void StorageModule::Stop() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    // Leave the whole config in the config files for readers that do not know about the journal, e.g. legacy stack
+    pimpl_->has_pending_compaction_ = true;
+  }
   SaveImmediately();
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   pimpl_.reset();
 }
 
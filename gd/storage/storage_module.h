@@ -48,8 +48,9 @@ class StorageModule : public bluetooth::Module {
   static const std::string kAdapterSection;
 
   // Create the storage module where:
-  // - config_file_path is the path to the config file on disk, a .bak file will be created with the original
-  // - config_save_delay is the duration after which to dump config to disk after SaveDelayed() is called
+  // - config_file_path is the path to the config file on disk, a .bak file will be created with the original and a
+  //   .journal file will hold the changes saved since both were last written
+  // - config_save_delay is the duration after which to save config to disk after SaveDelayed() is called
   // - temp_devices_capacity is the number of temporary, typically unpaired devices to hold in a memory based LRU
   // - is_restricted_mode and is_single_user_mode are flags from upper layer
   StorageModule(
@@ -130,16 +131,26 @@ class StorageModule : public bluetooth::Module {
   // Normally, underlying config will be saved at most 3 seconds after the first config change in a series of changes
   // This method triggers the delayed saving automatically, the delay is equal to |config_save_delay_|
   void SaveDelayed();
-  // In some cases, one may want to save the config immediately to disk. Call this method with caution as it runs
-  // immediately on the calling thread
+  // In some cases, one may want to save the config immediately to disk. Call this method with caution as it blocks
+  // the calling thread until the config is on disk
+  // Changes are appended to the journal when possible, otherwise the whole config is written
   void SaveImmediately();
 
  private:
+  // Hand the changes since the last save to the I/O thread, either as a journal batch or as a snapshot of the whole
+  // config, and return without waiting for them to be written
+  void PostSave();
+  // Run on the I/O thread
+  void AppendToJournal(std::string batch);
+  // Run on the I/O thread, write |snapshot| to the config and backup files, then delete the journal
+  void WriteConfigFiles(std::shared_ptr<const ConfigCache::PersistentSnapshot> snapshot);
+
   struct impl;
   mutable std::recursive_mutex mutex_;
   std::unique_ptr<impl> pimpl_;
   std::string config_file_path_;
   std::string config_backup_path_;
+  std::string config_journal_path_;
   std::chrono::milliseconds config_save_delay_;
   size_t temp_devices_capacity_;
   bool is_restricted_mode_;
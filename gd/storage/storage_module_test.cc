@@ -30,6 +30,7 @@
 #include "module.h"
 #include "os/files.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
 #include "storage/device.h"
 #include "storage/legacy_config_file.h"
 
@@ -38,6 +39,7 @@ namespace testing {
 using bluetooth::TestModuleRegistry;
 using bluetooth::hci::Address;
 using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigJournal;
 using bluetooth::storage::Device;
 using bluetooth::storage::LegacyConfigFile;
 using bluetooth::storage::StorageModule;
@@ -108,9 +110,11 @@ class StorageModuleTest : public Test {
     temp_dir_ = std::filesystem::temp_directory_path();
     temp_config_ = temp_dir_ / "temp_config.txt";
     temp_backup_config_ = temp_dir_ / "temp_config.bak";
+    temp_journal_ = temp_dir_ / "temp_config.journal";
     DeleteConfigFiles();
     ASSERT_FALSE(std::filesystem::exists(temp_config_));
     ASSERT_FALSE(std::filesystem::exists(temp_backup_config_));
+    ASSERT_FALSE(std::filesystem::exists(temp_journal_));
   }
 
   void TearDown() override {
@@ -124,11 +128,24 @@ class StorageModuleTest : public Test {
     if (std::filesystem::exists(temp_backup_config_)) {
       ASSERT_TRUE(std::filesystem::remove(temp_backup_config_));
     }
+    if (std::filesystem::exists(temp_journal_)) {
+      ASSERT_TRUE(std::filesystem::remove(temp_journal_));
+    }
+  }
+
+  // Read the config as it would be loaded after a crash, i.e. the config file with the journal applied
+  std::optional<ConfigCache> ReadSavedConfig() {
+    auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+    if (config) {
+      ConfigJournal::FromPath(temp_journal_.string()).Replay(&config.value());
+    }
+    return config;
   }
 
   std::filesystem::path temp_dir_;
   std::filesystem::path temp_config_;
   std::filesystem::path temp_backup_config_;
+  std::filesystem::path temp_journal_;
 };
 
 TEST_F(StorageModuleTest, empty_config_no_op_test) {
@@ -251,28 +268,28 @@ TEST_F(StorageModuleTest, save_config_test) {
   storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:ea", "name", "foo");
   ASSERT_THAT(storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
   std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
-  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  auto config = ReadSavedConfig();
   ASSERT_TRUE(config);
   ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
 
   // Remove a property
   storage->GetConfigCachePublic()->RemoveProperty("01:02:03:ab:cd:ea", "name");
   std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
-  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  config = ReadSavedConfig();
   ASSERT_TRUE(config);
   ASSERT_FALSE(config->HasProperty("01:02:03:ab:cd:ea", "name"));
 
   // Remove a section
   storage->GetConfigCachePublic()->RemoveSection("01:02:03:ab:cd:ea");
   std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
-  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  config = ReadSavedConfig();
   ASSERT_TRUE(config);
   ASSERT_FALSE(config->HasSection("01:02:03:ab:cd:ea"));
 
   // Add a section and save immediately
   storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:eb", "LinkKey", "123456");
   storage->SaveImmediatelyPublic();
-  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  config = ReadSavedConfig();
   ASSERT_TRUE(config);
   ASSERT_TRUE(config->HasSection("01:02:03:ab:cd:eb"));
 
@@ -283,6 +300,59 @@ TEST_F(StorageModuleTest, save_config_test) {
   ASSERT_TRUE(std::filesystem::exists(temp_config_));
 }
 
+TEST_F(StorageModuleTest, save_to_journal_test) {
+  // Prepare config file
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+  // The first save writes the whole config
+  storage->SaveImmediatelyPublic();
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+  auto config_file_before = bluetooth::os::ReadSmallFile(temp_config_.string());
+  ASSERT_TRUE(config_file_before);
+
+  // Later saves only append the changes to the journal
+  storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:ea", "name", "foo");
+  storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:eb", "LinkKey", "123456");
+  storage->SaveImmediatelyPublic();
+  ASSERT_TRUE(std::filesystem::exists(temp_journal_));
+  ASSERT_THAT(bluetooth::os::ReadSmallFile(temp_config_.string()), Optional(StrEq(*config_file_before)));
+  auto config = ReadSavedConfig();
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  ASSERT_THAT(config->GetPersistentSections(), ElementsAre("01:02:03:ab:cd:ea", "01:02:03:ab:cd:eb"));
+
+  // Tear down writes the whole config and removes the journal
+  test_registry.StopAll();
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  ASSERT_TRUE(config->HasSection("01:02:03:ab:cd:eb"));
+}
+
+TEST_F(StorageModuleTest, replay_journal_test) {
+  // Prepare config file and changes saved to the journal before a crash
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_journal_.string(), "S\t01:02:03:ab:cd:ea\tname\tfoo\nC\t1\n"));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+  ASSERT_THAT(storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+
+  // Tear down
+  test_registry.StopAll();
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+}
+
 TEST_F(StorageModuleTest, get_bonded_devices_test) {
   // Prepare config file
   ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
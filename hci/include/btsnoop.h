@@ -51,6 +51,12 @@ typedef struct btsnoop_t {
   // Clear an L2CAP channel from being filtered.
   void (*clear_l2cap_whitelist)(uint16_t conn_handle, uint16_t local_cid,
                                 uint16_t remote_cid);
+
+  // Indicate the PSM of a connected L2CAP channel. In the truncated mode, the
+  // payloads of A2DP media channels and of channels using the configured PSMs
+  // are cut short in the snoop logs.
+  void (*add_l2c_channel_psm)(uint16_t conn_handle, uint16_t local_cid,
+                              uint16_t remote_cid, uint16_t psm);
 } btsnoop_t;
 
 const btsnoop_t* btsnoop_get_interface(void);
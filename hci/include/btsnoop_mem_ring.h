@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Crash-persistent history of the last HCI packets.
+//
+// The ring lives in a file mapped with MAP_SHARED: whatever was appended is in
+// the page cache, and ends up in the file, even if the process crashes right
+// after. The file holds a header followed by |record_count| fixed-size
+// records; record |i| of the history is in slot |i % record_count|, and holds
+// at most BTSNOOP_MEM_RING_DATA_SIZE bytes of the packet.
+//
+// Appending takes no lock and does not allocate: a slot is claimed by
+// incrementing the next index, its sequence is cleared while it is written,
+// then set to the index + 1. A reader only keeps the records whose sequence
+// are the expected one before and after reading them.
+
+#define BTSNOOP_MEM_RING_MAGIC 0x524d5442 /* "BTMR" */
+#define BTSNOOP_MEM_RING_VERSION 1
+#define BTSNOOP_MEM_RING_RECORD_SIZE 128
+#define BTSNOOP_MEM_RING_DATA_SIZE (BTSNOOP_MEM_RING_RECORD_SIZE - 24)
+
+// Opens the ring file at |path| with |record_count| records, and starts
+// appending the captured HCI packets to it. The history left in the file by
+// the previous run, if any, is first saved as a btsnoop file at |path|
+// followed by ".last.log", keeping the packets of its last |last_window_us|.
+// Must not be called concurrently with |btsnoop_mem_ring_append|.
+// Returns true on success.
+bool btsnoop_mem_ring_open(const char* path, uint32_t record_count,
+                           uint64_t last_window_us);
+
+// Stops appending and unmaps the ring. The file is kept.
+// Must not be called concurrently with |btsnoop_mem_ring_append|.
+void btsnoop_mem_ring_close(void);
+
+// Appends the HCI packet |data| of |length| bytes, of BT_EVT_* |type|, to the
+// ring, if open. Lock free, may be called from any thread.
+void btsnoop_mem_ring_append(uint16_t type, const uint8_t* data,
+                             size_t length, uint64_t timestamp_us);
+
+// Writes the packets of the ring received or sent within |window_us| of the
+// last one to |fd|, as a btsnoop file. Only makes write() calls, so it can be
+// used from a crash handler.
+// Returns true on success.
+bool btsnoop_mem_ring_write(int fd, uint64_t window_us);
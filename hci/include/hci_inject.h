@@ -22,6 +22,19 @@
 
 typedef struct hci_t hci_t;
 
+// Debug builds (BT_NET_DEBUG) listen on TCP port 8873 for clients that inject
+// packets into the stack, as frames of a type byte, a 2 byte little-endian
+// length and that many bytes:
+// - 1 (command), 2 (ACL), 3 (SCO), 5 (ISO): an HCI packet, sent to the
+//   controller. The completion of an injected command is reported back to
+//   the client in a latency report.
+// - 0x80 (generate): a packet type byte, a 4 byte count, a 2 byte interval
+//   in ms, a 2 byte burst size, then an HCI packet. The packet is sent
+//   |count| times, |burst| packets every |interval| ms. A new generate frame
+//   replaces the generator of the client; a count of 0 stops it.
+// Latency reports are frames of type 0x81 whose payload is the event code
+// that completed the command (command complete or status), its 2 byte
+// opcode, and the 4 byte time in us from injection to completion.
 typedef struct hci_inject_t {
   // Starts the HCI injection module. Returns true on success, false on failure.
   // Once started, this module must be shut down with |close|.
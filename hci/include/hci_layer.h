@@ -101,3 +101,7 @@ void post_to_main_message_loop(const base::Location& from_here, BT_HDR* p_msg);
 
 void hci_layer_cleanup_interface();
 bool hci_is_root_inflammation_event_received();
+
+// Writes the command latencies, event counts and ACL traffic seen by the HCI
+// layer to |fd|.
+void hci_debug_dump(int fd);
@@ -81,7 +81,7 @@ typedef struct {
 
   void (*parse_read_local_supported_codecs_response)(
       BT_HDR* response, uint8_t* number_of_local_supported_codecs,
-      uint8_t* local_supported_codecs);
+      uint8_t* local_supported_codecs, size_t local_supported_codecs_size);
 
 } hci_packet_parser_t;
 
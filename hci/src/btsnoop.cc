@@ -35,14 +35,19 @@
 #include <sys/time.h>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <algorithm>
+#include <bitset>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "bt_types.h"
 #include "common/time_util.h"
+#include "gd/hal/snoop_writer.h"
 #include "hci/include/btsnoop.h"
 #include "hci/include/btsnoop_mem.h"
+#include "hci/include/btsnoop_mem_ring.h"
 #include "hci_layer.h"
 #include "internal_include/bt_trace.h"
 #include "osi/include/log.h"
@@ -66,11 +71,42 @@
 #define BTSNOOP_MODE_DISABLED "disabled"
 #define BTSNOOP_MODE_FILTERED "filtered"
 #define BTSNOOP_MODE_FULL "full"
+// Logs everything like the full mode, but only keeps the first bytes of the
+// payloads of A2DP media channels and of channels using the PSMs listed in
+// BTSNOOP_TRUNCATED_PSMS_PROPERTY.
+#define BTSNOOP_MODE_TRUNCATED "truncated"
 
 #define BTSNOOP_PATH_PROPERTY "persist.bluetooth.btsnooppath"
 #define DEFAULT_BTSNOOP_PATH "/data/misc/bluetooth/logs/btsnoop_hci.log"
 #define BTSNOOP_MAX_PACKETS_PROPERTY "persist.bluetooth.btsnoopsize"
 
+// When set, snoop logs are gzip compressed and get a ".gz" suffix. gunzip
+// gives back a standard btsnoop file, which Wireshark also opens compressed.
+#define BTSNOOP_COMPRESSED_PROPERTY "persist.bluetooth.btsnoopcompressed"
+// Also rotate once a file holds this many bytes, after compression, or was
+// opened this many seconds ago. Zero disables the limit.
+#define BTSNOOP_MAX_FILE_BYTES_PROPERTY "persist.bluetooth.btsnoopmaxfilebytes"
+#define BTSNOOP_MAX_FILE_SECONDS_PROPERTY \
+  "persist.bluetooth.btsnoopmaxfileseconds"
+
+// Comma separated PSMs, e.g. "0x1001,0x0080", whose payloads are truncated in
+// the truncated mode, and the number of L2CAP payload bytes kept for them.
+#define BTSNOOP_TRUNCATED_PSMS_PROPERTY "persist.bluetooth.btsnooptruncatedpsms"
+#define BTSNOOP_TRUNCATED_SIZE_PROPERTY "persist.bluetooth.btsnooptruncatedsize"
+#define DEFAULT_BTSNOOP_TRUNCATED_SIZE 32
+
+// Number of records of the crash-persistent ring of the last HCI packets, see
+// btsnoop_mem_ring.h, zero to disable it. It is enabled by default on
+// userdebug/eng builds. At start up, the last seconds of the previous run are
+// saved next to it, as a btsnoop file.
+#define BTSNOOP_MEM_RING_RECORDS_PROPERTY \
+  "persist.bluetooth.btsnoopmemringrecords"
+#define BTSNOOP_MEM_RING_SECONDS_PROPERTY \
+  "persist.bluetooth.btsnoopmemringseconds"
+#define DEFAULT_BTSNOOP_MEM_RING_RECORDS 4096
+#define DEFAULT_BTSNOOP_MEM_RING_SECONDS 30
+#define BTSNOOP_MEM_RING_PATH "/data/misc/bluetooth/logs/btsnoop_mem_ring"
+
 typedef enum {
   kCommandPacket = 1,
   kAclPacket = 2,
@@ -91,12 +127,21 @@ static const size_t RFC_EVENT_OFFSET = 9;
 // The size of the L2CAP header. All information past this point is removed from
 // a filtered packet.
 static const uint32_t L2C_HEADER_SIZE = 9;
+// The size of the ACL header, all that is kept of the continuing fragments of
+// a truncated packet.
+static const uint32_t ACL_HEADER_SIZE = 5;
 
 static int logfile_fd = INVALID_FD;
+// Owns |logfile_fd| and writes the packets to it off the HCI thread
+static std::unique_ptr<bluetooth::hal::SnoopWriter> snoop_writer;
 static std::mutex btsnoop_mutex;
 
 static int32_t packets_per_file;
 static int32_t packet_counter;
+static bool is_btsnoop_compressed;
+static int32_t max_file_bytes;
+static int32_t max_file_seconds;
+static uint64_t file_opened_timestamp_us;
 
 // Channel tracking variables for filtering.
 
@@ -153,24 +198,48 @@ class FilterTracker {
   }
 };
 
+// The L2CAP channels of an ACL connection whose payloads are truncated, indexed
+// by CID so that the decision for a packet is a single bit test.
+struct TruncatedChannels {
+  // Destination CIDs of received packets
+  std::bitset<65536> local_cids;
+  // Destination CIDs of sent packets
+  std::bitset<65536> remote_cids;
+  // AVDTP sets up its signaling channel before any media channel, so the first
+  // AVDTP channel of a connection is the only one kept whole.
+  uint16_t avdtp_signaling_local_cid = 0;
+  // Whether the last start fragment sent or received was truncated, continuing
+  // fragments don't carry a CID.
+  bool continuation_truncated[2] = {false, false};
+};
+
 std::mutex filter_list_mutex;
 std::unordered_map<uint16_t, FilterTracker> filter_list;
 std::unordered_map<uint16_t, uint16_t> local_cid_to_acl;
+// Only allocated for connections with truncated channels, indexed by handle
+static std::array<std::unique_ptr<TruncatedChannels>, HCI_DATA_HANDLE_MASK + 1>
+    truncated_channels;
+static std::unordered_set<uint16_t> truncated_psms;
+static uint32_t truncated_payload_size;
 
 // Cached value for whether full snoop logs are enabled. So the property isn't
 // checked for every packet.
 static bool is_btsnoop_enabled;
 static bool is_btsnoop_filtered;
+static bool is_btsnoop_truncated;
 
 // TODO(zachoverflow): merge btsnoop and btsnoop_net together
 void btsnoop_net_open();
 void btsnoop_net_close();
-void btsnoop_net_write(const void* data, size_t length);
+void btsnoop_net_write(const void* header, size_t header_length,
+                       const void* packet, size_t packet_length);
 
 static void delete_btsnoop_files(bool filtered);
 static std::string get_btsnoop_log_path(bool filtered);
 static std::string get_btsnoop_last_log_path(std::string log_path);
+static std::string get_btsnoop_compressed_log_path(std::string log_path);
 static void open_next_snoop_file();
+static void load_truncated_psms();
 static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
                                  bool is_received, uint64_t timestamp_us);
 
@@ -199,21 +268,53 @@ static future_t* start_up() {
     LOG(INFO) << __func__ << ": Filtered Snoop Logs enabled";
     is_btsnoop_enabled = true;
     is_btsnoop_filtered = true;
+    is_btsnoop_truncated = false;
     delete_btsnoop_files(false);
   } else if (btsnoop_mode == BTSNOOP_MODE_FULL) {
     LOG(INFO) << __func__ << ": Snoop Logs fully enabled";
     is_btsnoop_enabled = true;
     is_btsnoop_filtered = false;
+    is_btsnoop_truncated = false;
     delete_btsnoop_files(true);
+  } else if (btsnoop_mode == BTSNOOP_MODE_TRUNCATED) {
+    LOG(INFO) << __func__ << ": Truncated Snoop Logs enabled";
+    is_btsnoop_enabled = true;
+    is_btsnoop_filtered = false;
+    is_btsnoop_truncated = true;
+    delete_btsnoop_files(false);
+    load_truncated_psms();
   } else {
     LOG(INFO) << __func__ << ": Snoop Logs disabled";
     is_btsnoop_enabled = false;
     is_btsnoop_filtered = false;
+    is_btsnoop_truncated = false;
     delete_btsnoop_files(true);
     delete_btsnoop_files(false);
   }
 
+  int32_t ring_records = osi_property_get_int32(
+      BTSNOOP_MEM_RING_RECORDS_PROPERTY,
+      is_debuggable ? DEFAULT_BTSNOOP_MEM_RING_RECORDS : 0);
+  if (ring_records > 0) {
+    int32_t ring_seconds = osi_property_get_int32(
+        BTSNOOP_MEM_RING_SECONDS_PROPERTY, DEFAULT_BTSNOOP_MEM_RING_SECONDS);
+    btsnoop_mem_ring_open(BTSNOOP_MEM_RING_PATH, ring_records,
+                          (uint64_t)std::max(ring_seconds, 0) * 1000000);
+  }
+
   if (is_btsnoop_enabled) {
+    is_btsnoop_compressed =
+        osi_property_get_bool(BTSNOOP_COMPRESSED_PROPERTY, false);
+    max_file_bytes = osi_property_get_int32(BTSNOOP_MAX_FILE_BYTES_PROPERTY, 0);
+    max_file_seconds =
+        osi_property_get_int32(BTSNOOP_MAX_FILE_SECONDS_PROPERTY, 0);
+    snoop_writer = std::make_unique<bluetooth::hal::SnoopWriter>(
+        bluetooth::hal::SnoopWriter::kDefaultCapacity,
+        bluetooth::hal::SnoopWriter::FsyncPolicy::ON_FLUSH,
+        bluetooth::hal::SnoopWriter::kDefaultFlushInterval,
+        is_btsnoop_compressed
+            ? bluetooth::hal::SnoopWriter::Compression::GZIP
+            : bluetooth::hal::SnoopWriter::Compression::NONE);
     open_next_snoop_file();
     packets_per_file = osi_property_get_int32(BTSNOOP_MAX_PACKETS_PROPERTY,
                                               DEFAULT_BTSNOOP_SIZE);
@@ -227,7 +328,7 @@ static future_t* shut_down(void) {
   std::lock_guard<std::mutex> lock(btsnoop_mutex);
 
   if (is_btsnoop_enabled) {
-    if (is_btsnoop_filtered) {
+    if (is_btsnoop_filtered || is_btsnoop_truncated) {
       delete_btsnoop_files(false);
     } else {
       delete_btsnoop_files(true);
@@ -237,9 +338,17 @@ static future_t* shut_down(void) {
     delete_btsnoop_files(false);
   }
 
-  if (logfile_fd != INVALID_FD) close(logfile_fd);
+  btsnoop_mem_ring_close();
+
+  // Writes out the pending packets and closes the log file
+  snoop_writer.reset();
   logfile_fd = INVALID_FD;
 
+  {
+    std::lock_guard filter_lock(filter_list_mutex);
+    for (auto& channels : truncated_channels) channels.reset();
+  }
+
   if (is_btsnoop_enabled) btsnoop_net_close();
 
   return NULL;
@@ -344,11 +453,55 @@ static void clear_l2cap_whitelist(uint16_t conn_handle, uint16_t local_cid,
   }
   std::lock_guard lock(filter_list_mutex);
   filter_list[conn_handle].removeL2cCid(local_cid, remote_cid);
+
+  auto& channels = truncated_channels[HCID_GET_HANDLE(conn_handle)];
+  if (channels) {
+    channels->local_cids.reset(local_cid);
+    channels->remote_cids.reset(remote_cid);
+    if (channels->avdtp_signaling_local_cid == local_cid) {
+      channels->avdtp_signaling_local_cid = 0;
+    }
+    if (channels->avdtp_signaling_local_cid == 0 &&
+        channels->local_cids.none() && channels->remote_cids.none()) {
+      channels.reset();
+    }
+  }
 }
 
-static const btsnoop_t interface = {capture, whitelist_l2c_channel,
-                                    whitelist_rfc_dlci, add_rfc_l2c_channel,
-                                    clear_l2cap_whitelist};
+static void add_l2c_channel_psm(uint16_t conn_handle, uint16_t local_cid,
+                                uint16_t remote_cid, uint16_t psm) {
+  if (!is_btsnoop_truncated || bluetooth::shim::is_gd_shim_enabled()) {
+    return;
+  }
+  std::lock_guard lock(filter_list_mutex);
+
+  auto& channels = truncated_channels[HCID_GET_HANDLE(conn_handle)];
+  if (psm == BT_PSM_AVDTP) {
+    if (!channels) channels = std::make_unique<TruncatedChannels>();
+    if (channels->avdtp_signaling_local_cid == 0 ||
+        channels->avdtp_signaling_local_cid == local_cid) {
+      channels->avdtp_signaling_local_cid = local_cid;
+      return;
+    }
+  } else if (truncated_psms.count(psm) == 0) {
+    return;
+  }
+
+  LOG(INFO) << __func__
+            << ": Truncating l2cap channel. conn_handle=" << conn_handle
+            << " cid=" << loghex(local_cid) << ":" << loghex(remote_cid)
+            << " psm=" << loghex(psm);
+  if (!channels) channels = std::make_unique<TruncatedChannels>();
+  channels->local_cids.set(local_cid);
+  channels->remote_cids.set(remote_cid);
+}
+
+static const btsnoop_t interface = {capture,
+                                    whitelist_l2c_channel,
+                                    whitelist_rfc_dlci,
+                                    add_rfc_l2c_channel,
+                                    clear_l2cap_whitelist,
+                                    add_l2c_channel_psm};
 
 const btsnoop_t* btsnoop_get_interface() { return &interface; }
 
@@ -356,8 +509,11 @@ static void delete_btsnoop_files(bool filtered) {
   LOG(INFO) << __func__
             << ": Deleting snoop logs if they exist. filtered = " << filtered;
   auto log_path = get_btsnoop_log_path(filtered);
+  auto last_log_path = get_btsnoop_last_log_path(log_path);
   remove(log_path.c_str());
-  remove(get_btsnoop_last_log_path(log_path).c_str());
+  remove(last_log_path.c_str());
+  remove(get_btsnoop_compressed_log_path(log_path).c_str());
+  remove(get_btsnoop_compressed_log_path(last_log_path).c_str());
 }
 
 std::string get_btsnoop_log_path(bool filtered) {
@@ -373,16 +529,47 @@ std::string get_btsnoop_last_log_path(std::string btsnoop_path) {
   return btsnoop_path.append(".last");
 }
 
+std::string get_btsnoop_compressed_log_path(std::string btsnoop_path) {
+  return btsnoop_path.append(".gz");
+}
+
+static void load_truncated_psms() {
+  char psms[PROPERTY_VALUE_MAX];
+  osi_property_get(BTSNOOP_TRUNCATED_PSMS_PROPERTY, psms, "");
+  truncated_psms.clear();
+  char* next = psms;
+  while (*next != '\0') {
+    char* end;
+    unsigned long psm = strtoul(next, &end, 0);
+    if (end == next) {
+      LOG(ERROR) << __func__ << ": invalid PSM list '" << psms << "'";
+      break;
+    }
+    truncated_psms.insert(psm);
+    next = end;
+    while (*next == ',' || *next == ' ') next++;
+  }
+  truncated_payload_size = std::max(
+      0, osi_property_get_int32(BTSNOOP_TRUNCATED_SIZE_PROPERTY,
+                                DEFAULT_BTSNOOP_TRUNCATED_SIZE));
+}
+
 static void open_next_snoop_file() {
   packet_counter = 0;
 
   if (logfile_fd != INVALID_FD) {
-    close(logfile_fd);
+    // Write out the previous file before renaming it
+    snoop_writer->SetFd(INVALID_FD);
     logfile_fd = INVALID_FD;
   }
 
-  auto log_path = get_btsnoop_log_path(is_btsnoop_filtered);
+  auto log_path =
+      get_btsnoop_log_path(is_btsnoop_filtered || is_btsnoop_truncated);
   auto last_log_path = get_btsnoop_last_log_path(log_path);
+  if (is_btsnoop_compressed) {
+    log_path = get_btsnoop_compressed_log_path(log_path);
+    last_log_path = get_btsnoop_compressed_log_path(last_log_path);
+  }
 
   if (rename(log_path.c_str(), last_log_path.c_str()) != 0 && errno != ENOENT)
     LOG(ERROR) << __func__ << ": unable to rename '" << log_path << "' to '"
@@ -398,7 +585,15 @@ static void open_next_snoop_file() {
     return;
   }
 
-  write(logfile_fd, "btsnoop\0\0\0\0\1\0\0\x3\xea", 16);
+  struct timespec ts_now = {};
+  clock_gettime(CLOCK_REALTIME, &ts_now);
+  file_opened_timestamp_us =
+      ((uint64_t)ts_now.tv_sec * 1000000L) + ((uint64_t)ts_now.tv_nsec / 1000);
+
+  // The file header goes through the writer to be compressed with the packets
+  snoop_writer->SetFd(logfile_fd);
+  iovec header = {const_cast<char*>("btsnoop\0\0\0\0\1\0\0\x3\xea"), 16};
+  snoop_writer->Append(&header, 1);
 }
 
 typedef struct {
@@ -445,6 +640,34 @@ static bool should_filter_log(bool is_received, uint8_t* packet) {
   return false;
 }
 
+// Returns the number of bytes of the ACL |packet| of |length| bytes, with the
+// type byte, to keep in the truncated mode.
+static uint32_t get_truncated_length(bool is_received, uint8_t* packet,
+                                     uint32_t length) {
+  uint16_t handle_and_flags = (packet[ACL_CHANNEL_OFFSET + 1] << 8) +
+                              packet[ACL_CHANNEL_OFFSET];
+
+  std::lock_guard lock(filter_list_mutex);
+  auto& channels = truncated_channels[HCID_GET_HANDLE(handle_and_flags)];
+  if (!channels) return length;
+
+  bool& continuation_truncated = channels->continuation_truncated[is_received];
+  if (HCID_GET_EVENT(handle_and_flags) == L2CAP_PKT_CONTINUE) {
+    return continuation_truncated ? std::min(length, ACL_HEADER_SIZE) : length;
+  }
+  if (length < L2C_HEADER_SIZE) {
+    continuation_truncated = false;
+    return length;
+  }
+  uint16_t l2c_channel =
+      (packet[L2C_CHANNEL_OFFSET + 1] << 8) + packet[L2C_CHANNEL_OFFSET];
+  const auto& cids =
+      is_received ? channels->local_cids : channels->remote_cids;
+  continuation_truncated = cids.test(l2c_channel);
+  if (!continuation_truncated) return length;
+  return std::min(length, L2C_HEADER_SIZE + truncated_payload_size);
+}
+
 static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
                                  bool is_received, uint64_t timestamp_us) {
   uint32_t length_he = 0;
@@ -484,22 +707,30 @@ static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
   header.length_captured =
       blacklisted ? htonl(L2C_HEADER_SIZE) : header.length_original;
   if (blacklisted) length_he = L2C_HEADER_SIZE;
+  if (is_btsnoop_truncated && type == kAclPacket) {
+    length_he = get_truncated_length(is_received, packet, length_he);
+    header.length_captured = htonl(length_he);
+  }
   header.flags = htonl(flags);
-  header.dropped_packets = 0;
+  header.dropped_packets =
+      snoop_writer ? htonl(snoop_writer->GetDroppedPackets()) : 0;
   header.timestamp = htonll(timestamp_us + BTSNOOP_EPOCH_DELTA);
   header.type = type;
 
-  btsnoop_net_write(&header, sizeof(btsnoop_header_t));
-  btsnoop_net_write(packet, length_he - 1);
+  btsnoop_net_write(&header, sizeof(btsnoop_header_t), packet, length_he - 1);
 
   if (logfile_fd != INVALID_FD) {
     packet_counter++;
-    if (packet_counter > packets_per_file) {
+    if (packet_counter > packets_per_file ||
+        (max_file_bytes > 0 &&
+         snoop_writer->GetFileSize() >= (uint64_t)max_file_bytes) ||
+        (max_file_seconds > 0 && timestamp_us - file_opened_timestamp_us >=
+                                     (uint64_t)max_file_seconds * 1000000)) {
       open_next_snoop_file();
     }
 
     iovec iov[] = {{&header, sizeof(btsnoop_header_t)},
                    {reinterpret_cast<void*>(packet), length_he - 1}};
-    TEMP_FAILURE_RETRY(writev(logfile_fd, iov, 2));
+    snoop_writer->Append(iov, 2);
   }
 }
@@ -19,14 +19,13 @@
 #include <base/logging.h>
 
 #include "hci/include/btsnoop_mem.h"
+#include "hci/include/btsnoop_mem_ring.h"
 
 static btsnoop_data_cb data_callback = NULL;
 
 void btsnoop_mem_set_callback(btsnoop_data_cb cb) { data_callback = cb; }
 
 void btsnoop_mem_capture(const BT_HDR* packet, uint64_t timestamp_us) {
-  if (!data_callback) return;
-
   CHECK(packet);
 
   const uint8_t* data = &packet->data[packet->offset];
@@ -53,5 +52,8 @@ void btsnoop_mem_capture(const BT_HDR* packet, uint64_t timestamp_us) {
       break;
   }
 
-  if (length) (*data_callback)(type, data, length, timestamp_us);
+  if (length == 0) return;
+
+  btsnoop_mem_ring_append(type, data, length, timestamp_us);
+  if (data_callback) (*data_callback)(type, data, length, timestamp_us);
 }
@@ -0,0 +1,337 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_snoop_mem_ring"
+
+#include "hci/include/btsnoop_mem_ring.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#include "bt_types.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the ring is appended to without a lock");
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+  uint32_t record_count;
+  uint32_t reserved;
+  std::atomic<uint64_t> next_index; /* index of the next record appended */
+  uint8_t padding[BTSNOOP_MEM_RING_RECORD_SIZE - 24];
+} btsnoop_mem_ring_header_t;
+
+typedef struct {
+  std::atomic<uint64_t> sequence; /* index + 1 once written, 0 while written */
+  uint64_t timestamp_us;
+  uint16_t type; /* BT_EVT_* */
+  uint16_t length;
+  uint16_t included_length;
+  uint16_t reserved;
+  uint8_t data[BTSNOOP_MEM_RING_DATA_SIZE];
+} btsnoop_mem_ring_record_t;
+
+static_assert(sizeof(btsnoop_mem_ring_header_t) ==
+                  BTSNOOP_MEM_RING_RECORD_SIZE,
+              "the records follow the header");
+static_assert(sizeof(btsnoop_mem_ring_record_t) ==
+                  BTSNOOP_MEM_RING_RECORD_SIZE,
+              "the records have a fixed size");
+
+// A record read out of the ring
+typedef struct {
+  uint64_t timestamp_us;
+  uint16_t type;
+  uint16_t length;
+  uint16_t included_length;
+  uint8_t data[BTSNOOP_MEM_RING_DATA_SIZE];
+} btsnoop_mem_ring_packet_t;
+
+// Same as the packet header of the btsnoop files in btsnoop.cc
+typedef struct {
+  uint32_t length_original;
+  uint32_t length_captured;
+  uint32_t flags;
+  uint32_t dropped_packets;
+  uint64_t timestamp;
+  uint8_t type;
+} __attribute__((__packed__)) btsnoop_mem_ring_btsnoop_header_t;
+
+// Epoch in microseconds since 01/01/0000.
+static const uint64_t BTSNOOP_EPOCH_DELTA = 0x00dcddb30f2f8000ULL;
+
+static btsnoop_mem_ring_header_t* ring_header = NULL;
+static size_t ring_map_size = 0;
+
+static size_t btsnoop_mem_ring_size(uint32_t record_count) {
+  return sizeof(btsnoop_mem_ring_header_t) +
+         (size_t)record_count * sizeof(btsnoop_mem_ring_record_t);
+}
+
+static btsnoop_mem_ring_record_t* btsnoop_mem_ring_records(
+    const btsnoop_mem_ring_header_t* header) {
+  return reinterpret_cast<btsnoop_mem_ring_record_t*>(
+      const_cast<btsnoop_mem_ring_header_t*>(header) + 1);
+}
+
+static bool btsnoop_mem_ring_is_valid(const btsnoop_mem_ring_header_t* header,
+                                      size_t size) {
+  return header->magic == BTSNOOP_MEM_RING_MAGIC &&
+         header->version == BTSNOOP_MEM_RING_VERSION &&
+         header->record_size == BTSNOOP_MEM_RING_RECORD_SIZE &&
+         header->record_count > 0 &&
+         btsnoop_mem_ring_size(header->record_count) == size;
+}
+
+static uint64_t btsnoop_mem_ring_htonll(uint64_t ll) {
+  const uint32_t l = 1;
+  if (*(reinterpret_cast<const uint8_t*>(&l)) == 1)
+    return static_cast<uint64_t>(htonl(ll & 0xffffffff)) << 32 |
+           htonl(ll >> 32);
+
+  return ll;
+}
+
+static bool btsnoop_mem_ring_write_all(int fd, const void* data,
+                                       size_t length) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  while (length > 0) {
+    ssize_t ret;
+    OSI_NO_INTR(ret = write(fd, p, length));
+    if (ret <= 0) return false;
+    p += ret;
+    length -= ret;
+  }
+  return true;
+}
+
+// Reads the record of |index| into |p_packet|. Returns false if it was
+// overwritten, or was being written.
+static bool btsnoop_mem_ring_read(const btsnoop_mem_ring_header_t* header,
+                                  uint64_t index,
+                                  btsnoop_mem_ring_packet_t* p_packet) {
+  const btsnoop_mem_ring_record_t* record =
+      btsnoop_mem_ring_records(header) + index % header->record_count;
+  if (record->sequence.load(std::memory_order_acquire) != index + 1)
+    return false;
+
+  p_packet->timestamp_us = record->timestamp_us;
+  p_packet->type = record->type;
+  p_packet->length = record->length;
+  p_packet->included_length =
+      std::min<uint16_t>(record->included_length, BTSNOOP_MEM_RING_DATA_SIZE);
+  memcpy(p_packet->data, record->data, p_packet->included_length);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return record->sequence.load(std::memory_order_relaxed) == index + 1;
+}
+
+static bool btsnoop_mem_ring_write_packet(
+    int fd, const btsnoop_mem_ring_packet_t* p_packet) {
+  btsnoop_mem_ring_btsnoop_header_t header;
+  uint32_t flags;
+
+  switch (p_packet->type) {
+    case BT_EVT_TO_LM_HCI_CMD:
+      header.type = 1;
+      flags = 2;
+      break;
+    case BT_EVT_TO_BTU_HCI_EVT:
+      header.type = 4;
+      flags = 3;
+      break;
+    case BT_EVT_TO_LM_HCI_ACL:
+    case BT_EVT_TO_BTU_HCI_ACL:
+      header.type = 2;
+      flags = p_packet->type == BT_EVT_TO_BTU_HCI_ACL;
+      break;
+    case BT_EVT_TO_LM_HCI_SCO:
+    case BT_EVT_TO_BTU_HCI_SCO:
+      header.type = 3;
+      flags = p_packet->type == BT_EVT_TO_BTU_HCI_SCO;
+      break;
+    default:
+      return true;
+  }
+
+  // +1 for the type byte
+  header.length_original = htonl(p_packet->length + 1);
+  header.length_captured = htonl(p_packet->included_length + 1);
+  header.flags = htonl(flags);
+  header.dropped_packets = 0;
+  header.timestamp =
+      btsnoop_mem_ring_htonll(p_packet->timestamp_us + BTSNOOP_EPOCH_DELTA);
+
+  return btsnoop_mem_ring_write_all(fd, &header, sizeof(header)) &&
+         btsnoop_mem_ring_write_all(fd, p_packet->data,
+                                    p_packet->included_length);
+}
+
+static bool btsnoop_mem_ring_write_from(const btsnoop_mem_ring_header_t* header,
+                                        int fd, uint64_t window_us) {
+  static const char btsnoop_file_header[] =
+      "btsnoop\0\0\0\0\1\0\0\x3\xea";
+  if (!btsnoop_mem_ring_write_all(fd, btsnoop_file_header, 16)) return false;
+
+  uint64_t next = header->next_index.load(std::memory_order_acquire);
+  uint64_t first =
+      next > header->record_count ? next - header->record_count : 0;
+  btsnoop_mem_ring_packet_t packet;
+
+  // The window ends with the last packet
+  uint64_t start_us = 0;
+  for (uint64_t index = next; index > first; index--) {
+    if (btsnoop_mem_ring_read(header, index - 1, &packet)) {
+      if (packet.timestamp_us > window_us)
+        start_us = packet.timestamp_us - window_us;
+      break;
+    }
+  }
+
+  for (uint64_t index = first; index < next; index++) {
+    if (!btsnoop_mem_ring_read(header, index, &packet)) continue;
+    if (packet.timestamp_us < start_us) continue;
+    if (!btsnoop_mem_ring_write_packet(fd, &packet)) return false;
+  }
+  return true;
+}
+
+// Saves the history of the ring file mapped from |fd|, if valid, to
+// |last_path|.
+static void btsnoop_mem_ring_save(int fd, const std::string& last_path,
+                                  uint64_t window_us) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (size_t)st.st_size < sizeof(btsnoop_mem_ring_header_t))
+    return;
+
+  size_t size = st.st_size;
+  void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) return;
+
+  const btsnoop_mem_ring_header_t* header =
+      static_cast<const btsnoop_mem_ring_header_t*>(map);
+  if (btsnoop_mem_ring_is_valid(header, size)) {
+    mode_t prevmask = umask(0);
+    int last_fd = open(last_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                       S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    umask(prevmask);
+    if (last_fd == INVALID_FD) {
+      LOG_ERROR("%s: unable to open '%s': %s", __func__, last_path.c_str(),
+                strerror(errno));
+    } else {
+      if (!btsnoop_mem_ring_write_from(header, last_fd, window_us))
+        LOG_ERROR("%s: unable to write '%s': %s", __func__, last_path.c_str(),
+                  strerror(errno));
+      close(last_fd);
+    }
+  }
+  munmap(map, size);
+}
+
+bool btsnoop_mem_ring_open(const char* path, uint32_t record_count,
+                           uint64_t last_window_us) {
+  btsnoop_mem_ring_close();
+  if (record_count == 0) return false;
+
+  mode_t prevmask = umask(0);
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC,
+                S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+  umask(prevmask);
+  if (fd == INVALID_FD) {
+    LOG_ERROR("%s: unable to open '%s': %s", __func__, path, strerror(errno));
+    return false;
+  }
+
+  btsnoop_mem_ring_save(fd, std::string(path) + ".last.log", last_window_us);
+
+  // Truncating first zeroes all the records
+  size_t size = btsnoop_mem_ring_size(record_count);
+  if (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0) {
+    LOG_ERROR("%s: unable to size '%s': %s", __func__, path, strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    LOG_ERROR("%s: unable to map '%s': %s", __func__, path, strerror(errno));
+    return false;
+  }
+
+  btsnoop_mem_ring_header_t* header =
+      static_cast<btsnoop_mem_ring_header_t*>(map);
+  header->version = BTSNOOP_MEM_RING_VERSION;
+  header->record_size = BTSNOOP_MEM_RING_RECORD_SIZE;
+  header->record_count = record_count;
+  header->next_index.store(0, std::memory_order_relaxed);
+  // Valid once completely initialized
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = BTSNOOP_MEM_RING_MAGIC;
+
+  ring_header = header;
+  ring_map_size = size;
+  return true;
+}
+
+void btsnoop_mem_ring_close(void) {
+  if (ring_header == NULL) return;
+  munmap(ring_header, ring_map_size);
+  ring_header = NULL;
+  ring_map_size = 0;
+}
+
+void btsnoop_mem_ring_append(uint16_t type, const uint8_t* data,
+                             size_t length, uint64_t timestamp_us) {
+  btsnoop_mem_ring_header_t* header = ring_header;
+  if (header == NULL || length == 0) return;
+
+  uint64_t index = header->next_index.fetch_add(1, std::memory_order_relaxed);
+  btsnoop_mem_ring_record_t* record =
+      btsnoop_mem_ring_records(header) + index % header->record_count;
+
+  record->sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  record->timestamp_us = timestamp_us;
+  record->type = type;
+  record->length = std::min<size_t>(length, UINT16_MAX);
+  record->included_length =
+      std::min<size_t>(length, BTSNOOP_MEM_RING_DATA_SIZE);
+  memcpy(record->data, data, record->included_length);
+
+  record->sequence.store(index + 1, std::memory_order_release);
+}
+
+bool btsnoop_mem_ring_write(int fd, uint64_t window_us) {
+  if (ring_header == NULL) return false;
+  return btsnoop_mem_ring_write_from(ring_header, fd, window_us);
+}
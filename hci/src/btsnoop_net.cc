@@ -20,44 +20,82 @@
 
 #include <base/logging.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/eventfd.h>
 #include <sys/prctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <memory>
 #include <mutex>
 
 #include "bt_types.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 
+// Packets are handed to each client through its own bounded buffer and sent
+// from the btsnoop_net thread, so that a slow client never blocks the HCI
+// thread logging the packet. When a buffer is full, packets are dropped for
+// that client only and counted.
+typedef struct {
+  int socket;
+  std::unique_ptr<uint8_t[]> buffer;  // ring of CLIENT_BUFFER_SIZE_ bytes
+  size_t start;                       // offset of the first byte to send
+  size_t size;                        // number of bytes waiting to be sent
+  uint64_t dropped_packets;
+} client_t;
+
 static void safe_close_(int* fd);
-static void* listen_fn_(void* context);
+static void* net_fn_(void* context);
+static void client_enqueue_locked_(client_t* client, const void* data,
+                                  size_t length);
+static void client_close_locked_(client_t* client);
 
-static const char* LISTEN_THREAD_NAME_ = "btsnoop_net_listen";
+static const char* NET_THREAD_NAME_ = "btsnoop_net";
 static const int LOCALHOST_ = 0x7F000001;
 static const int LISTEN_PORT_ = 8872;
+static const size_t MAX_CLIENTS_ = 4;
+static const size_t CLIENT_BUFFER_SIZE_ = 256 * 1024;
 
-static pthread_t listen_thread_;
-static bool listen_thread_valid_ = false;
-static std::mutex client_socket_mutex_;
+static pthread_t net_thread_;
+static bool net_thread_valid_ = false;
+static bool net_thread_stop_ = false;
 static int listen_socket_ = -1;
-static int client_socket_ = -1;
+static int wakeup_fd_ = -1;  // eventfd waking the thread for data or stop
+static std::mutex clients_mutex_;
+static client_t clients_[MAX_CLIENTS_];
 
 void btsnoop_net_open() {
 #if (BT_NET_DEBUG != TRUE)
   return;  // Disable using network sockets for security reasons
 #endif
 
-  listen_thread_valid_ =
-      (pthread_create(&listen_thread_, NULL, listen_fn_, NULL) == 0);
-  if (!listen_thread_valid_)
+  wakeup_fd_ = eventfd(0, EFD_CLOEXEC);
+  if (wakeup_fd_ == -1) {
+    LOG_ERROR("%s eventfd creation failed: %s", __func__, strerror(errno));
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    net_thread_stop_ = false;
+    for (client_t& client : clients_) client.socket = -1;
+  }
+
+  net_thread_valid_ =
+      (pthread_create(&net_thread_, NULL, net_fn_, NULL) == 0);
+  if (!net_thread_valid_) {
     LOG_ERROR("%s pthread_create failed: %s", __func__, strerror(errno));
+    safe_close_(&wakeup_fd_);
+  }
 }
 
 void btsnoop_net_close() {
@@ -65,86 +103,242 @@ void btsnoop_net_close() {
   return;  // Disable using network sockets for security reasons
 #endif
 
-  if (listen_thread_valid_) {
-    shutdown(listen_socket_, SHUT_RDWR);
-    pthread_join(listen_thread_, NULL);
-    safe_close_(&client_socket_);
-    listen_thread_valid_ = false;
+  if (net_thread_valid_) {
+    {
+      std::lock_guard<std::mutex> lock(clients_mutex_);
+      net_thread_stop_ = true;
+    }
+    eventfd_write(wakeup_fd_, 1);
+    pthread_join(net_thread_, NULL);
+    safe_close_(&wakeup_fd_);
+    net_thread_valid_ = false;
+
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (client_t& client : clients_) client.buffer.reset();
   }
 }
 
-void btsnoop_net_write(const void* data, size_t length) {
+void btsnoop_net_write(const void* header, size_t header_length,
+                       const void* packet, size_t packet_length) {
 #if (BT_NET_DEBUG != TRUE)
   return;  // Disable using network sockets for security reasons
 #endif
 
-  std::lock_guard<std::mutex> lock(client_socket_mutex_);
-  if (client_socket_ != -1) {
-    ssize_t ret;
-    OSI_NO_INTR(ret = send(client_socket_, data, length, 0));
+  bool wakeup = false;
+  {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (client_t& client : clients_) {
+      if (client.socket == -1) continue;
 
-    if (ret == -1 && errno == ECONNRESET) {
-      safe_close_(&client_socket_);
+      // A record is queued whole or not at all, so that the stream stays a
+      // valid btsnoop file for the client.
+      if (header_length + packet_length > CLIENT_BUFFER_SIZE_ - client.size) {
+        client.dropped_packets++;
+        continue;
+      }
+      // The thread is only woken when a buffer stops being empty; otherwise
+      // it is already waiting for the socket to take more.
+      wakeup |= client.size == 0;
+      client_enqueue_locked_(&client, header, header_length);
+      client_enqueue_locked_(&client, packet, packet_length);
     }
   }
+
+  if (wakeup) eventfd_write(wakeup_fd_, 1);
 }
 
-static void* listen_fn_(UNUSED_ATTR void* context) {
+static int open_listen_socket_() {
   int enable = 1;
 
-  prctl(PR_SET_NAME, (unsigned long)LISTEN_THREAD_NAME_, 0, 0, 0);
-
-  listen_socket_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-  if (listen_socket_ == -1) {
+  int listen_socket =
+      socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+  if (listen_socket == -1) {
     LOG_ERROR("%s socket creation failed: %s", __func__, strerror(errno));
-    goto cleanup;
+    return -1;
   }
 
-  if (setsockopt(listen_socket_, SOL_SOCKET, SO_REUSEADDR, &enable,
+  if (setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &enable,
                  sizeof(enable)) == -1) {
     LOG_ERROR("%s unable to set SO_REUSEADDR: %s", __func__, strerror(errno));
-    goto cleanup;
+    safe_close_(&listen_socket);
+    return -1;
   }
 
   struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
   addr.sin_family = AF_INET;
   addr.sin_addr.s_addr = htonl(LOCALHOST_);
   addr.sin_port = htons(LISTEN_PORT_);
-  if (bind(listen_socket_, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+  if (bind(listen_socket, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
     LOG_ERROR("%s unable to bind listen socket: %s", __func__, strerror(errno));
-    goto cleanup;
+    safe_close_(&listen_socket);
+    return -1;
   }
 
-  if (listen(listen_socket_, 10) == -1) {
+  if (listen(listen_socket, 10) == -1) {
     LOG_ERROR("%s unable to listen: %s", __func__, strerror(errno));
-    goto cleanup;
+    safe_close_(&listen_socket);
+    return -1;
+  }
+
+  return listen_socket;
+}
+
+static void accept_client_() {
+  int client_socket;
+  OSI_NO_INTR(client_socket = accept4(listen_socket_, NULL, NULL,
+                                      SOCK_NONBLOCK | SOCK_CLOEXEC));
+  if (client_socket == -1) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      LOG_WARN("%s error accepting socket: %s", __func__, strerror(errno));
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(clients_mutex_);
+  client_t* free_client = NULL;
+  for (client_t& client : clients_) {
+    if (client.socket == -1) {
+      free_client = &client;
+      break;
+    }
+  }
+  if (!free_client) {
+    LOG_WARN("%s already serving %zu clients, refusing another", __func__,
+             MAX_CLIENTS_);
+    safe_close_(&client_socket);
+    return;
+  }
+
+  if (!free_client->buffer) {
+    free_client->buffer.reset(new uint8_t[CLIENT_BUFFER_SIZE_]);
+  }
+  free_client->socket = client_socket;
+  free_client->start = 0;
+  free_client->size = 0;
+  free_client->dropped_packets = 0;
+
+  /* When a new client connects, we have to send the btsnoop file header. This
+   * allows a decoder to treat the session as a new, valid btsnoop file. */
+  client_enqueue_locked_(free_client, "btsnoop\0\0\0\0\1\0\0\x3\xea", 16);
+}
+
+// Sends as much of the buffer of |client| as its socket takes without
+// blocking. Returns false if the client went away.
+static bool client_send_(client_t* client) {
+  for (;;) {
+    const uint8_t* data;
+    size_t length;
+    {
+      std::lock_guard<std::mutex> lock(clients_mutex_);
+      if (client->size == 0) return true;
+      data = client->buffer.get() + client->start;
+      length = std::min(client->size, CLIENT_BUFFER_SIZE_ - client->start);
+    }
+
+    // Writers only append past |size|, so the bytes being sent stay put while
+    // the lock is released.
+    ssize_t ret;
+    OSI_NO_INTR(ret = send(client->socket, data, length,
+                           MSG_DONTWAIT | MSG_NOSIGNAL));
+    if (ret == -1) {
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    client->start = (client->start + ret) % CLIENT_BUFFER_SIZE_;
+    client->size -= ret;
   }
+}
+
+static void* net_fn_(UNUSED_ATTR void* context) {
+  prctl(PR_SET_NAME, (unsigned long)NET_THREAD_NAME_, 0, 0, 0);
+
+  listen_socket_ = open_listen_socket_();
+  if (listen_socket_ == -1) return NULL;
 
   for (;;) {
-    int client_socket;
-    OSI_NO_INTR(client_socket = accept(listen_socket_, NULL, NULL));
-    if (client_socket == -1) {
-      if (errno == EINVAL || errno == EBADF) {
-        break;
+    struct pollfd fds[2 + MAX_CLIENTS_];
+    client_t* polled_clients[MAX_CLIENTS_];
+    size_t nfds = 0;
+    fds[nfds++] = {.fd = wakeup_fd_, .events = POLLIN, .revents = 0};
+    fds[nfds++] = {.fd = listen_socket_, .events = POLLIN, .revents = 0};
+    {
+      std::lock_guard<std::mutex> lock(clients_mutex_);
+      if (net_thread_stop_) break;
+      for (client_t& client : clients_) {
+        if (client.socket == -1) continue;
+        // POLLIN only serves to notice the client closing its end
+        short events = POLLIN | (client.size ? POLLOUT : 0);
+        polled_clients[nfds - 2] = &client;
+        fds[nfds++] = {.fd = client.socket, .events = events, .revents = 0};
       }
-      LOG_WARN("%s error accepting socket: %s", __func__, strerror(errno));
-      continue;
     }
 
-    /* When a new client connects, we have to send the btsnoop file header. This
-     * allows a decoder to treat the session as a new, valid btsnoop file. */
-    std::lock_guard<std::mutex> lock(client_socket_mutex_);
-    safe_close_(&client_socket_);
-    client_socket_ = client_socket;
+    int ret;
+    OSI_NO_INTR(ret = poll(fds, nfds, -1));
+    if (ret == -1) {
+      LOG_ERROR("%s poll failed: %s", __func__, strerror(errno));
+      break;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      eventfd_t value;
+      eventfd_read(wakeup_fd_, &value);
+    }
+
+    if (fds[1].revents & POLLIN) accept_client_();
 
-    OSI_NO_INTR(send(client_socket_, "btsnoop\0\0\0\0\1\0\0\x3\xea", 16, 0));
+    for (size_t i = 2; i < nfds; i++) {
+      client_t* client = polled_clients[i - 2];
+      bool alive = !(fds[i].revents & (POLLERR | POLLHUP));
+      if (alive && fds[i].revents & POLLIN) {
+        uint8_t discard[64];
+        ssize_t read_ret;
+        OSI_NO_INTR(read_ret = recv(client->socket, discard, sizeof(discard),
+                                    MSG_DONTWAIT));
+        alive = read_ret > 0 || (read_ret == -1 && (errno == EAGAIN ||
+                                                    errno == EWOULDBLOCK));
+      }
+      // Anything queued since the poll is sent right away as well
+      if (alive) alive = client_send_(client);
+      if (!alive) {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        client_close_locked_(client);
+      }
+    }
   }
 
-cleanup:
+  {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (client_t& client : clients_) {
+      if (client.socket != -1) client_close_locked_(&client);
+    }
+  }
   safe_close_(&listen_socket_);
   return NULL;
 }
 
+// Copies |data| at the end of the buffer of |client|, which must have room.
+static void client_enqueue_locked_(client_t* client, const void* data,
+                                  size_t length) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  size_t end = (client->start + client->size) % CLIENT_BUFFER_SIZE_;
+  size_t first = std::min(length, CLIENT_BUFFER_SIZE_ - end);
+  memcpy(client->buffer.get() + end, bytes, first);
+  memcpy(client->buffer.get(), bytes + first, length - first);
+  client->size += length;
+}
+
+static void client_close_locked_(client_t* client) {
+  if (client->dropped_packets) {
+    LOG_WARN("%s client dropped %llu packets it could not keep up with",
+             __func__, (unsigned long long)client->dropped_packets);
+  }
+  safe_close_(&client->socket);
+  client->size = 0;
+}
+
 static void safe_close_(int* fd) {
   CHECK(fd != NULL);
   if (*fd != -1) {
@@ -22,11 +22,16 @@
 
 #include <base/logging.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <string.h>
 
 #include "bt_types.h"
 #include "buffer_allocator.h"
+#include "common/time_util.h"
+#include "hci_internals.h"
 #include "hci_layer.h"
+#include "hcidefs.h"
+#include "osi/include/alarm.h"
 #include "osi/include/allocator.h"
 #include "osi/include/list.h"
 #include "osi/include/log.h"
@@ -42,18 +47,70 @@ typedef enum {
   HCI_PACKET_ISO_DATA = 5,
 } hci_packet_t;
 
+// Frames of the inject protocol that are not HCI packets, see hci_inject.h
+#define HCI_INJECT_GENERATE 0x80
+#define HCI_INJECT_LATENCY_REPORT 0x81
+
+// Packet type, count, interval and burst, ahead of the generated packet
+#define HCI_INJECT_GENERATE_HEADER_SIZE 9
+// Event code, opcode and latency
+#define HCI_INJECT_LATENCY_REPORT_SIZE 7
+
+// Sends one packet, |burst| times every interval, on the alarm thread.
+typedef struct {
+  uint32_t client_id;
+  hci_packet_t packet_type;
+  uint32_t remaining;
+  uint16_t burst;
+  alarm_t* alarm;
+  uint8_t* packet;
+  size_t packet_len;
+  size_t sent;
+  size_t failed;
+} generator_t;
+
 typedef struct {
+  uint32_t id;
   socket_t* socket;
+  generator_t* generator;
   uint8_t buffer[65536 + 3];  // 2 bytes length prefix, 1 byte type prefix.
   size_t buffer_size;
+
+  // Statistics, logged when the client goes away
+  size_t injected;
+  size_t failed;
+  size_t commands_completed;
+  uint64_t total_latency_us;
+  uint32_t max_latency_us;
+  size_t reports_dropped;
 } client_t;
 
+// An injected command waiting for its completion
+typedef struct {
+  uint32_t client_id;
+  uint16_t opcode;
+  uint8_t event_code;
+  uint64_t sent_us;
+  uint32_t latency_us;
+} pending_command_t;
+
 static bool hci_inject_open(const hci_t* hci_interface);
 static void hci_inject_close(void);
 static int hci_packet_to_event(hci_packet_t packet);
 static void accept_ready(socket_t* socket, void* context);
 static void read_ready(socket_t* socket, void* context);
 static void client_free(void* ptr);
+static client_t* find_client(uint32_t id);
+static bool inject_packet(uint32_t client_id, hci_packet_t packet_type,
+                          const uint8_t* packet, size_t packet_len);
+static void command_complete(BT_HDR* response, void* context);
+static void command_status(uint8_t status, BT_HDR* command, void* context);
+static void complete_command(pending_command_t* pending, uint8_t event_code);
+static void deliver_latency_report(void* context);
+static void generator_start(client_t* client, const uint8_t* frame,
+                            size_t frame_len);
+static void generator_stop(client_t* client);
+static void generator_tick(void* context);
 
 static const port_t LISTEN_PORT = 8873;
 
@@ -64,6 +121,7 @@ static const allocator_t* buffer_allocator;
 static socket_t* listen_socket;
 static thread_t* thread;
 static list_t* clients;
+static uint32_t next_client_id;
 
 static bool hci_inject_open(const hci_t* hci_interface) {
 #if (BT_NET_DEBUG != TRUE)
@@ -136,6 +194,7 @@ static void accept_ready(socket_t* socket, UNUSED_ATTR void* context) {
 
   client_t* client = (client_t*)osi_calloc(sizeof(client_t));
 
+  client->id = ++next_client_id;
   client->socket = socket;
 
   if (!list_append(clients, client)) {
@@ -156,15 +215,16 @@ static void read_ready(UNUSED_ATTR socket_t* socket, void* context) {
   ssize_t ret =
       socket_read(client->socket, client->buffer + client->buffer_size,
                   sizeof(client->buffer) - client->buffer_size);
-  if (ret == 0 || (ret == -1 && ret != EWOULDBLOCK && ret != EAGAIN)) {
+  if (ret == 0 || (ret == -1 && errno != EWOULDBLOCK && errno != EAGAIN)) {
     list_remove(clients, client);
     return;
   }
+  if (ret < 0) return;
   client->buffer_size += ret;
 
   while (client->buffer_size > 3) {
     uint8_t* buffer = client->buffer;
-    hci_packet_t packet_type = (hci_packet_t)buffer[0];
+    uint8_t frame_type = buffer[0];
     size_t packet_len = (buffer[2] << 8) | buffer[1];
     size_t frame_len = 3 + packet_len;
 
@@ -174,17 +234,13 @@ static void read_ready(UNUSED_ATTR socket_t* socket, void* context) {
     // TODO(sharvil): once we have an HCI parser, we can eliminate
     //   the 2-byte size field since it will be contained in the packet.
 
-    BT_HDR* buf = (BT_HDR*)buffer_allocator->alloc(BT_HDR_SIZE + packet_len);
-    if (buf) {
-      buf->event = hci_packet_to_event(packet_type);
-      buf->offset = 0;
-      buf->layer_specific = 0;
-      buf->len = packet_len;
-      memcpy(buf->data, buffer + 3, packet_len);
-      hci->transmit_downward(buf->event, buf);
+    if (frame_type == HCI_INJECT_GENERATE) {
+      generator_start(client, buffer + 3, packet_len);
+    } else if (inject_packet(client->id, (hci_packet_t)frame_type,
+                             buffer + 3, packet_len)) {
+      client->injected++;
     } else {
-      LOG_ERROR("%s dropping injected packet of length %zu", __func__,
-                packet_len);
+      client->failed++;
     }
 
     size_t remainder = client->buffer_size - frame_len;
@@ -197,10 +253,194 @@ static void client_free(void* ptr) {
   if (!ptr) return;
 
   client_t* client = (client_t*)ptr;
+  generator_stop(client);
+  LOG_INFO(
+      "%s client %u: %zu packets injected, %zu failed, %zu commands completed "
+      "in %" PRIu64 " us on average, %u us at most, %zu reports dropped",
+      __func__, client->id, client->injected, client->failed,
+      client->commands_completed,
+      client->commands_completed
+          ? client->total_latency_us / client->commands_completed
+          : 0,
+      client->max_latency_us, client->reports_dropped);
   socket_free(client->socket);
   osi_free(client);
 }
 
+static client_t* find_client(uint32_t id) {
+  for (const list_node_t* node = list_begin(clients); node != list_end(clients);
+       node = list_next(node)) {
+    client_t* client = (client_t*)list_node(node);
+    if (client->id == id) return client;
+  }
+  return NULL;
+}
+
+// Sends a copy of |packet| to the controller. The completion of a command is
+// reported back to the client |client_id|.
+static bool inject_packet(uint32_t client_id, hci_packet_t packet_type,
+                          const uint8_t* packet, size_t packet_len) {
+  int event = hci_packet_to_event(packet_type);
+  if (event < 0) return false;
+  if (packet_type == HCI_PACKET_COMMAND &&
+      packet_len < HCI_COMMAND_PREAMBLE_SIZE) {
+    LOG_ERROR("%s dropping truncated command of length %zu", __func__,
+              packet_len);
+    return false;
+  }
+
+  BT_HDR* buf = (BT_HDR*)buffer_allocator->alloc(BT_HDR_SIZE + packet_len);
+  if (!buf) {
+    LOG_ERROR("%s dropping injected packet of length %zu", __func__,
+              packet_len);
+    return false;
+  }
+  buf->event = event;
+  buf->offset = 0;
+  buf->layer_specific = 0;
+  buf->len = packet_len;
+  memcpy(buf->data, packet, packet_len);
+
+  if (packet_type != HCI_PACKET_COMMAND) {
+    hci->transmit_downward(buf->event, buf);
+    return true;
+  }
+
+  pending_command_t* pending =
+      (pending_command_t*)osi_calloc(sizeof(pending_command_t));
+  pending->client_id = client_id;
+  pending->opcode = (packet[1] << 8) | packet[0];
+  pending->sent_us = bluetooth::common::time_get_os_boottime_us();
+  hci->transmit_command(buf, command_complete, command_status, pending);
+  return true;
+}
+
+static void command_complete(BT_HDR* response, void* context) {
+  complete_command((pending_command_t*)context, HCI_COMMAND_COMPLETE_EVT);
+  osi_free(response);
+}
+
+static void command_status(UNUSED_ATTR uint8_t status, BT_HDR* command,
+                           void* context) {
+  complete_command((pending_command_t*)context, HCI_COMMAND_STATUS_EVT);
+  osi_free(command);
+}
+
+// Called on the HCI thread, the report is written on the inject thread where
+// the clients live.
+static void complete_command(pending_command_t* pending, uint8_t event_code) {
+  pending->event_code = event_code;
+  pending->latency_us =
+      bluetooth::common::time_get_os_boottime_us() - pending->sent_us;
+  if (thread == NULL || !thread_post(thread, deliver_latency_report, pending))
+    osi_free(pending);
+}
+
+static void deliver_latency_report(void* context) {
+  pending_command_t* pending = (pending_command_t*)context;
+  client_t* client = find_client(pending->client_id);
+  if (client == NULL) {
+    osi_free(pending);
+    return;
+  }
+
+  client->commands_completed++;
+  client->total_latency_us += pending->latency_us;
+  if (pending->latency_us > client->max_latency_us)
+    client->max_latency_us = pending->latency_us;
+
+  uint8_t report[3 + HCI_INJECT_LATENCY_REPORT_SIZE];
+  uint8_t* stream = report;
+  UINT8_TO_STREAM(stream, HCI_INJECT_LATENCY_REPORT);
+  UINT16_TO_STREAM(stream, HCI_INJECT_LATENCY_REPORT_SIZE);
+  UINT8_TO_STREAM(stream, pending->event_code);
+  UINT16_TO_STREAM(stream, pending->opcode);
+  UINT32_TO_STREAM(stream, pending->latency_us);
+  // A client that does not read its reports loses them rather than stall the
+  // injection
+  if (socket_write(client->socket, report, sizeof(report)) !=
+      (ssize_t)sizeof(report)) {
+    client->reports_dropped++;
+  }
+  osi_free(pending);
+}
+
+// Parses a generate frame and replaces the generator of |client| with it.
+static void generator_start(client_t* client, const uint8_t* frame,
+                            size_t frame_len) {
+  generator_stop(client);
+
+  if (frame_len < HCI_INJECT_GENERATE_HEADER_SIZE) {
+    LOG_ERROR("%s truncated generate frame of length %zu", __func__,
+              frame_len);
+    return;
+  }
+  const uint8_t* stream = frame;
+  uint8_t packet_type;
+  uint32_t count;
+  uint16_t interval_ms;
+  uint16_t burst;
+  STREAM_TO_UINT8(packet_type, stream);
+  STREAM_TO_UINT32(count, stream);
+  STREAM_TO_UINT16(interval_ms, stream);
+  STREAM_TO_UINT16(burst, stream);
+  size_t packet_len = frame_len - HCI_INJECT_GENERATE_HEADER_SIZE;
+
+  if (count == 0) return;
+  if (hci_packet_to_event((hci_packet_t)packet_type) < 0 || packet_len == 0 ||
+      interval_ms == 0 || burst == 0) {
+    LOG_ERROR("%s invalid generator: type %u, %zu bytes every %u ms by %u",
+              __func__, packet_type, packet_len, interval_ms, burst);
+    return;
+  }
+
+  generator_t* generator = (generator_t*)osi_calloc(sizeof(generator_t));
+  generator->client_id = client->id;
+  generator->packet_type = (hci_packet_t)packet_type;
+  generator->remaining = count;
+  generator->burst = burst;
+  generator->packet = (uint8_t*)osi_malloc(packet_len);
+  memcpy(generator->packet, stream, packet_len);
+  generator->packet_len = packet_len;
+  generator->alarm = alarm_new_periodic("hci_inject.generator");
+  client->generator = generator;
+
+  LOG_INFO("%s client %u: %u packets of type %u, %u every %u ms", __func__,
+           client->id, count, packet_type, burst, interval_ms);
+  alarm_set(generator->alarm, interval_ms, generator_tick, generator);
+}
+
+static void generator_stop(client_t* client) {
+  generator_t* generator = client->generator;
+  if (generator == NULL) return;
+
+  // Waits for a tick in progress
+  alarm_free(generator->alarm);
+  LOG_INFO("%s client %u: %zu packets generated, %zu failed, %u not sent",
+           __func__, client->id, generator->sent, generator->failed,
+           generator->remaining);
+  client->injected += generator->sent;
+  client->failed += generator->failed;
+  osi_free(generator->packet);
+  osi_free(generator);
+  client->generator = NULL;
+}
+
+static void generator_tick(void* context) {
+  generator_t* generator = (generator_t*)context;
+
+  for (uint16_t i = 0; i < generator->burst && generator->remaining > 0; i++) {
+    generator->remaining--;
+    if (inject_packet(generator->client_id, generator->packet_type,
+                      generator->packet, generator->packet_len)) {
+      generator->sent++;
+    } else {
+      generator->failed++;
+    }
+  }
+  if (generator->remaining == 0) alarm_cancel(generator->alarm);
+}
+
 const hci_inject_t* hci_inject_get_interface() {
   buffer_allocator = buffer_allocator_get_interface();
   return &interface;
@@ -42,6 +42,8 @@
 #include "common/message_loop_thread.h"
 #include "common/metrics.h"
 #include "common/once_timer.h"
+#include "common/startup_trace.h"
+#include "gd/hci/hci_statistics.h"
 #include "hci_inject.h"
 #include "hci_internals.h"
 #include "hcidefs.h"
@@ -58,6 +60,7 @@
 
 using bluetooth::common::MessageLoopThread;
 using bluetooth::common::OnceTimer;
+namespace startup_trace = bluetooth::common::startup_trace;
 
 extern void hci_initialize();
 extern void hci_transmit(BT_HDR* packet);
@@ -121,6 +124,9 @@ static OnceTimer abort_timer;
 static uint8_t root_inflamed_error_code = 0;
 static uint8_t root_inflamed_vendor_error_code = 0;
 
+// Command latencies, events and ACL traffic, dumped by hci_debug_dump()
+static bluetooth::hci::HciStatistics hci_statistics;
+
 // The hand-off point for data going to a higher layer, set by the higher layer
 static base::Callback<void(const base::Location&, BT_HDR*)> send_data_upwards;
 
@@ -157,14 +163,28 @@ void initialization_complete() {
 
 void hci_event_received(const base::Location& from_here, BT_HDR* packet) {
   btsnoop->capture(packet, true);
+  hci_statistics.RecordEvent(packet->data[0]);
 
   if (!filter_incoming_event(packet)) {
     send_data_upwards.Run(from_here, packet);
   }
 }
 
+// Counts the bytes of an ACL packet, including its header, for its handle
+static void record_acl(const BT_HDR* packet, bool outgoing) {
+  if (packet->len < HCI_DATA_PREAMBLE_SIZE) return;
+  const uint8_t* stream = packet->data + packet->offset;
+  uint16_t handle = (stream[0] | (stream[1] << 8)) & 0x0fff;
+  if (outgoing) {
+    hci_statistics.RecordAclOut(handle, packet->len);
+  } else {
+    hci_statistics.RecordAclIn(handle, packet->len);
+  }
+}
+
 void acl_event_received(BT_HDR* packet) {
   btsnoop->capture(packet, true);
+  record_acl(packet, false);
   packet_fragmenter->reassemble_and_dispatch(packet);
 }
 
@@ -230,8 +250,8 @@ static future_t* hci_module_start_up(void) {
     LOG_ERROR("%s unable to start thread.", __func__);
     goto error;
   }
-  if (!hci_thread.EnableRealTimeScheduling()) {
-    LOG_ERROR("%s unable to make thread RT.", __func__);
+  if (!hci_thread.ApplyThreadRole(bluetooth::common::ThreadRole::HCI_RX)) {
+    LOG_ERROR("%s unable to apply the HCI RX thread profile.", __func__);
     goto error;
   }
 
@@ -437,6 +457,9 @@ static void event_packet_ready(void* pkt) {
 // Callback for the fragmenter to send a fragment
 static void transmit_fragment(BT_HDR* packet, bool send_transmit_finished) {
   btsnoop->capture(packet, false);
+  if ((packet->event & MSG_EVT_MASK) == MSG_STACK_TO_HC_HCI_ACL) {
+    record_acl(packet, true);
+  }
 
   // HCI command packets are freed on a different thread when the matching
   // event is received. Check packet->event before sending to avoid a race.
@@ -590,6 +613,11 @@ bool hci_is_root_inflammation_event_received() {
   return abort_timer.IsScheduled();
 }
 
+void hci_debug_dump(int fd) {
+  dprintf(fd, "\nHCI Statistics:\n");
+  hci_statistics.Dump(fd);
+}
+
 void handle_root_inflammation_event() {
   LOG(ERROR) << __func__
              << ": Root inflammation event! setting timer to restart.";
@@ -629,9 +657,22 @@ void handle_root_inflammation_event() {
   }
 }
 
+// Records how long a command waited for its response, in the statistics and
+// in the startup trace while the stack comes up
+static void record_command_response(const waiting_command_t* wait_entry) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  hci_statistics.RecordCommandLatency(wait_entry->opcode,
+                                      now - wait_entry->timestamp);
+  if (!startup_trace::IsRecording()) return;
+  char name[16];
+  snprintf(name, sizeof(name), "HCI 0x%04x", wait_entry->opcode);
+  startup_trace::AddEvent(name, wait_entry->timestamp, now);
+}
+
 // Returns true if the event was intercepted and should not proceed to
 // higher layers. Also inspects an incoming event for interesting
 // information, like how many commands are now able to be sent.
+
 static bool filter_incoming_event(BT_HDR* packet) {
   waiting_command_t* wait_entry = NULL;
   uint8_t* stream = packet->data;
@@ -659,6 +700,7 @@ static bool filter_incoming_event(BT_HDR* packet) {
       }
     } else {
       update_command_response_timer();
+      record_command_response(wait_entry);
       if (wait_entry->complete_callback) {
         wait_entry->complete_callback(packet, wait_entry->context);
       } else if (wait_entry->complete_future) {
@@ -685,6 +727,7 @@ static bool filter_incoming_event(BT_HDR* packet) {
           __func__, opcode);
     } else {
       update_command_response_timer();
+      record_command_response(wait_entry);
       if (wait_entry->status_callback)
         wait_entry->status_callback(status, wait_entry->command,
                                     wait_entry->context);
@@ -26,7 +26,9 @@
 
 #include <base/location.h>
 #include <base/logging.h>
-#include "buffer_allocator.h"
+#include "bt_target.h"
+#include "hci_internals.h"
+#include "osi/include/allocator.h"
 #include "osi/include/log.h"
 
 #include <android/hardware/bluetooth/1.0/IBluetoothHci.h>
@@ -39,6 +41,18 @@
 #define LOG_PATH "/data/misc/bluetooth/logs/firmware_events.log"
 #define LAST_LOG_PATH "/data/misc/bluetooth/logs/firmware_events.log.last"
 
+// Largest packets the received buffers are pooled for; larger ones, like ISO
+// SDUs past a 3-DH5 payload, come from the heap
+#define HCI_EVENT_BUFFER_SIZE (BT_HDR_SIZE + HCI_EVENT_PREAMBLE_SIZE + 255)
+#define HCI_ACL_BUFFER_SIZE (BT_HDR_SIZE + HCI_ACL_PREAMBLE_SIZE + 1021)
+#define HCI_SCO_BUFFER_SIZE (BT_HDR_SIZE + HCI_SCO_PREAMBLE_SIZE + 255)
+
+// Received buffers held by the stack at once: ACL packets wait in the L2CAP
+// reassembly and queues, events and SCO packets are handled right away
+#define HCI_EVENT_POOL_SIZE 16
+#define HCI_ACL_POOL_SIZE 64
+#define HCI_SCO_POOL_SIZE 16
+
 using ::android::hardware::hidl_death_recipient;
 using ::android::hardware::hidl_vec;
 using ::android::hardware::ProcessState;
@@ -72,19 +86,41 @@ android::sp<BluetoothHciDeathRecipient> bluetoothHciDeathRecipient = new Bluetoo
 class BluetoothHciCallbacks : public V1_1::IBluetoothHciCallbacks {
  public:
   BluetoothHciCallbacks() {
-    buffer_allocator = buffer_allocator_get_interface();
+    event_pool = osi_pool_new(HCI_EVENT_BUFFER_SIZE, HCI_EVENT_POOL_SIZE);
+    acl_pool = osi_pool_new(HCI_ACL_BUFFER_SIZE, HCI_ACL_POOL_SIZE);
+    sco_pool = osi_pool_new(HCI_SCO_BUFFER_SIZE, HCI_SCO_POOL_SIZE);
   }
 
+  ~BluetoothHciCallbacks() {
+    // Buffers still held by the stack go back to the heap once freed
+    osi_pool_free(event_pool);
+    osi_pool_free(acl_pool);
+    osi_pool_free(sco_pool);
+  }
+
+  // The packet is copied once, out of the HIDL buffer that is only valid
+  // during the callback, into a buffer recycled from the pool of its type
   BT_HDR* WrapPacketAndCopy(uint16_t event, const hidl_vec<uint8_t>& data) {
     size_t packet_size = data.size() + BT_HDR_SIZE;
+    CHECK(packet_size <= BT_DEFAULT_BUFFER_SIZE);
+    slab_pool_t* pool;
+    switch (event) {
+      case MSG_HC_TO_STACK_HCI_EVT:
+        pool = event_pool;
+        break;
+      case MSG_HC_TO_STACK_HCI_SCO:
+        pool = sco_pool;
+        break;
+      default:
+        pool = acl_pool;
+        break;
+    }
     BT_HDR* packet =
-        reinterpret_cast<BT_HDR*>(buffer_allocator->alloc(packet_size));
+        reinterpret_cast<BT_HDR*>(osi_malloc_from_pool(pool, packet_size));
     packet->offset = 0;
     packet->len = data.size();
     packet->layer_specific = 0;
     packet->event = event;
-    // TODO(eisenbach): Avoid copy here; if BT_HDR->data can be ensured to
-    // be the only way the data is accessed, a pointer could be passed here...
     memcpy(packet->data, data.data(), data.size());
     return packet;
   }
@@ -127,7 +163,9 @@ class BluetoothHciCallbacks : public V1_1::IBluetoothHciCallbacks {
     return Void();
   }
 
-  const allocator_t* buffer_allocator;
+  slab_pool_t* event_pool;
+  slab_pool_t* acl_pool;
+  slab_pool_t* sco_pool;
 };
 
 void hci_initialize() {
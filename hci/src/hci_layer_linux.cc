@@ -106,49 +106,59 @@ static int rfkill(int block);
 int reader_thread_ctrl_fd = -1;
 Thread* reader_thread = NULL;
 
-void monitor_socket(int ctrl_fd, int fd) {
+// Largest packet read from the HCI socket
+#define HCI_SOCKET_BUF_SIZE 2000
+// Packets read from the HCI socket with a single recvmmsg() call
+#define HCI_SOCKET_MAX_PACKETS_PER_READ 16
+
+static void dispatch_packet(const uint8_t* buf, size_t len) {
   const allocator_t* buffer_allocator = buffer_allocator_get_interface();
-  const size_t buf_size = 2000;
-  uint8_t buf[buf_size];
-  ssize_t len = read(fd, buf, buf_size);
-
-  while (len > 0) {
-    if (len == buf_size)
-      LOG(FATAL) << "This packet filled buffer, if it have continuation we "
-                    "don't know how to merge it, increase buffer size!";
-
-    uint8_t type = buf[0];
-
-    size_t packet_size = buf_size + BT_HDR_SIZE;
-    BT_HDR* packet =
-        reinterpret_cast<BT_HDR*>(buffer_allocator->alloc(packet_size));
-    packet->offset = 0;
-    packet->layer_specific = 0;
-    packet->len = len - 1;
-    memcpy(packet->data, buf + 1, len - 1);
-
-    switch (type) {
-      case HCI_PACKET_TYPE_COMMAND:
-        packet->event = MSG_HC_TO_STACK_HCI_EVT;
-        hci_event_received(FROM_HERE, packet);
-        break;
-      case HCI_PACKET_TYPE_ACL_DATA:
-        packet->event = MSG_HC_TO_STACK_HCI_ACL;
-        acl_event_received(packet);
-        break;
-      case HCI_PACKET_TYPE_SCO_DATA:
-        packet->event = MSG_HC_TO_STACK_HCI_SCO;
-        sco_data_received(packet);
-        break;
-      case HCI_PACKET_TYPE_EVENT:
-        packet->event = MSG_HC_TO_STACK_HCI_EVT;
-        hci_event_received(FROM_HERE, packet);
-        break;
-      default:
-        LOG(FATAL) << "Unexpected event type: " << +type;
-        break;
-    }
+  uint8_t type = buf[0];
+
+  size_t packet_size = HCI_SOCKET_BUF_SIZE + BT_HDR_SIZE;
+  BT_HDR* packet =
+      reinterpret_cast<BT_HDR*>(buffer_allocator->alloc(packet_size));
+  packet->offset = 0;
+  packet->layer_specific = 0;
+  packet->len = len - 1;
+  memcpy(packet->data, buf + 1, len - 1);
+
+  switch (type) {
+    case HCI_PACKET_TYPE_COMMAND:
+      packet->event = MSG_HC_TO_STACK_HCI_EVT;
+      hci_event_received(FROM_HERE, packet);
+      break;
+    case HCI_PACKET_TYPE_ACL_DATA:
+      packet->event = MSG_HC_TO_STACK_HCI_ACL;
+      acl_event_received(packet);
+      break;
+    case HCI_PACKET_TYPE_SCO_DATA:
+      packet->event = MSG_HC_TO_STACK_HCI_SCO;
+      sco_data_received(packet);
+      break;
+    case HCI_PACKET_TYPE_EVENT:
+      packet->event = MSG_HC_TO_STACK_HCI_EVT;
+      hci_event_received(FROM_HERE, packet);
+      break;
+    default:
+      LOG(FATAL) << "Unexpected event type: " << +type;
+      break;
+  }
+}
+
+// The HCI socket keeps the packet boundaries: each wake up reads all the
+// packets queued, up to HCI_SOCKET_MAX_PACKETS_PER_READ, with one syscall.
+void monitor_socket(int ctrl_fd, int fd) {
+  static uint8_t bufs[HCI_SOCKET_MAX_PACKETS_PER_READ][HCI_SOCKET_BUF_SIZE];
+  struct iovec iovs[HCI_SOCKET_MAX_PACKETS_PER_READ];
+  struct mmsghdr msgs[HCI_SOCKET_MAX_PACKETS_PER_READ];
 
+  for (int i = 0; i < HCI_SOCKET_MAX_PACKETS_PER_READ; i++) {
+    iovs[i].iov_base = bufs[i];
+    iovs[i].iov_len = HCI_SOCKET_BUF_SIZE;
+  }
+
+  while (true) {
     fd_set fds;
     FD_ZERO(&fds);
     FD_SET(ctrl_fd, &fds);
@@ -161,7 +171,27 @@ void monitor_socket(int ctrl_fd, int fd) {
       return;
     }
 
-    len = read(fd, buf, buf_size);
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < HCI_SOCKET_MAX_PACKETS_PER_READ; i++) {
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int count = recvmmsg(fd, msgs, HCI_SOCKET_MAX_PACKETS_PER_READ,
+                         MSG_DONTWAIT, NULL);
+    if (count < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+      LOG(ERROR) << "Unable to read from the HCI socket: " << strerror(errno);
+      return;
+    }
+    if (count == 0) return;
+
+    for (int i = 0; i < count; i++) {
+      if (msgs[i].msg_len == 0) return;
+      if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+        LOG(FATAL) << "This packet filled buffer, if it have continuation we "
+                      "don't know how to merge it, increase buffer size!";
+      dispatch_packet(bufs[i], msgs[i].msg_len);
+    }
   }
 }
 
@@ -33,7 +33,8 @@ static const allocator_t* buffer_allocator;
 
 static uint8_t* read_command_complete_header(BT_HDR* response,
                                              command_opcode_t expected_opcode,
-                                             size_t minimum_bytes_after);
+                                             size_t minimum_bytes_after,
+                                             size_t* bytes_after = NULL);
 
 static void parse_generic_command_complete(BT_HDR* response) {
   read_command_complete_header(response, NO_OPCODE_CHECKING,
@@ -71,15 +72,29 @@ static void parse_read_local_version_info_response(BT_HDR* response,
 
 static void parse_read_local_supported_codecs_response(
     BT_HDR* response, uint8_t* number_of_local_supported_codecs,
-    uint8_t* local_supported_codecs) {
-  uint8_t* stream = read_command_complete_header(
-      response, HCI_READ_LOCAL_SUPPORTED_CODECS, 0 /* bytes after */);
-  if (stream) {
-    STREAM_TO_UINT8(*number_of_local_supported_codecs, stream);
-    for (uint8_t i = 0; i < *number_of_local_supported_codecs; i++) {
-      STREAM_TO_UINT8(*local_supported_codecs, stream);
-      local_supported_codecs++;
+    uint8_t* local_supported_codecs, size_t local_supported_codecs_size) {
+  size_t bytes_after;
+  uint8_t* stream =
+      read_command_complete_header(response, HCI_READ_LOCAL_SUPPORTED_CODECS,
+                                   0 /* bytes after */, &bytes_after);
+  if (stream && bytes_after > 0) {
+    uint8_t number_of_codecs;
+    STREAM_TO_UINT8(number_of_codecs, stream);
+    // The count comes from the controller; only keep the codecs that are
+    // really in the event and that fit in the caller's array.
+    size_t codecs_in_event = bytes_after - 1;
+    if (number_of_codecs > codecs_in_event) {
+      LOG_ERROR("%s: %d codecs reported but only %zu present", __func__,
+                number_of_codecs, codecs_in_event);
+      number_of_codecs = codecs_in_event;
     }
+    if (number_of_codecs > local_supported_codecs_size) {
+      LOG_WARN("%s: dropping %zu codecs that do not fit", __func__,
+               number_of_codecs - local_supported_codecs_size);
+      number_of_codecs = local_supported_codecs_size;
+    }
+    *number_of_local_supported_codecs = number_of_codecs;
+    STREAM_TO_ARRAY(local_supported_codecs, stream, number_of_codecs);
   }
 
   buffer_allocator->free(response);
@@ -175,7 +190,9 @@ static void parse_ble_read_resolving_list_size_response(
     BT_HDR* response, uint8_t* resolving_list_size_ptr) {
   uint8_t* stream = read_command_complete_header(
       response, HCI_BLE_READ_RESOLVING_LIST_SIZE, 1 /* bytes after */);
-  STREAM_TO_UINT8(*resolving_list_size_ptr, stream);
+  if (stream) {
+    STREAM_TO_UINT8(*resolving_list_size_ptr, stream);
+  }
 
   buffer_allocator->free(response);
 }
@@ -184,7 +201,9 @@ static void parse_ble_read_suggested_default_data_length_response(
     BT_HDR* response, uint16_t* ble_default_packet_length_ptr) {
   uint8_t* stream = read_command_complete_header(
       response, HCI_BLE_READ_DEFAULT_DATA_LENGTH, 2 /* bytes after */);
-  STREAM_TO_UINT16(*ble_default_packet_length_ptr, stream);
+  if (stream) {
+    STREAM_TO_UINT16(*ble_default_packet_length_ptr, stream);
+  }
 
   buffer_allocator->free(response);
 }
@@ -195,10 +214,12 @@ static void parse_ble_read_maximum_data_length_response(
     uint16_t* ble_supported_max_rx_time) {
   uint8_t* stream = read_command_complete_header(
       response, HCI_BLE_READ_MAXIMUM_DATA_LENGTH, 8 /* bytes after */);
-  STREAM_TO_UINT16(*ble_supported_max_tx_octets, stream);
-  STREAM_TO_UINT16(*ble_supported_max_tx_time, stream);
-  STREAM_TO_UINT16(*ble_supported_max_rx_octets, stream);
-  STREAM_TO_UINT16(*ble_supported_max_rx_time, stream);
+  if (stream) {
+    STREAM_TO_UINT16(*ble_supported_max_tx_octets, stream);
+    STREAM_TO_UINT16(*ble_supported_max_tx_time, stream);
+    STREAM_TO_UINT16(*ble_supported_max_rx_octets, stream);
+    STREAM_TO_UINT16(*ble_supported_max_rx_time, stream);
+  }
 
   buffer_allocator->free(response);
 }
@@ -208,7 +229,9 @@ static void parse_ble_read_maximum_advertising_data_length(
   uint8_t* stream = read_command_complete_header(
       response, HCI_LE_READ_MAXIMUM_ADVERTISING_DATA_LENGTH,
       2 /* bytes after */);
-  STREAM_TO_UINT16(*ble_maximum_advertising_data_length_ptr, stream);
+  if (stream) {
+    STREAM_TO_UINT16(*ble_maximum_advertising_data_length_ptr, stream);
+  }
 
   buffer_allocator->free(response);
 }
@@ -218,16 +241,22 @@ static void parse_ble_read_number_of_supported_advertising_sets(
   uint8_t* stream = read_command_complete_header(
       response, HCI_LE_READ_NUMBER_OF_SUPPORTED_ADVERTISING_SETS,
       1 /* bytes after */);
-  STREAM_TO_UINT8(*ble_number_of_supported_advertising_sets_ptr, stream);
+  if (stream) {
+    STREAM_TO_UINT8(*ble_number_of_supported_advertising_sets_ptr, stream);
+  }
 
   buffer_allocator->free(response);
 }
 
 // Internal functions
 
+// Returns the return parameters of |response| after the status, read in place,
+// or NULL if the command failed. The number of bytes available there is stored
+// in |bytes_after| if it is not NULL.
 static uint8_t* read_command_complete_header(BT_HDR* response,
                                              command_opcode_t expected_opcode,
-                                             size_t minimum_bytes_after) {
+                                             size_t minimum_bytes_after,
+                                             size_t* bytes_after) {
   uint8_t* stream = response->data + response->offset;
 
   // Read the event header
@@ -240,8 +269,8 @@ static uint8_t* read_command_complete_header(BT_HDR* response,
 
   // Check the event header values against what we expect
   CHECK(event_code == HCI_COMMAND_COMPLETE_EVT);
-  CHECK(parameter_length >=
-        (parameter_bytes_we_read_here + minimum_bytes_after));
+  CHECK(parameter_length >= parameter_bytes_we_read_here);
+  CHECK(response->len >= 2 + parameter_length);
 
   // Read the command complete header
   command_opcode_t opcode;
@@ -262,6 +291,14 @@ static uint8_t* read_command_complete_header(BT_HDR* response,
     return NULL;
   }
 
+  // Failed commands may only carry the status, so the return parameters are
+  // only expected on success
+  CHECK(parameter_length >=
+        (parameter_bytes_we_read_here + minimum_bytes_after));
+
+  if (bytes_after) {
+    *bytes_after = parameter_length - parameter_bytes_we_read_here;
+  }
   return stream;
 }
 
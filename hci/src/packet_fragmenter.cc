@@ -22,7 +22,6 @@
 
 #include <base/logging.h>
 #include <string.h>
-#include <unordered_map>
 
 #include "bt_target.h"
 #include "buffer_allocator.h"
@@ -49,13 +48,21 @@ static const allocator_t* buffer_allocator;
 static const controller_t* controller;
 static const packet_fragmenter_callbacks_t* callbacks;
 
-static std::unordered_map<uint16_t /* handle */, BT_HDR*> partial_packets;
+// Packets being reassembled, indexed by the 12 bit connection handle
+static BT_HDR* partial_packets[HANDLE_MASK + 1];
 
 static void init(const packet_fragmenter_callbacks_t* result_callbacks) {
   callbacks = result_callbacks;
 }
 
-static void cleanup() { partial_packets.clear(); }
+static void cleanup() {
+  for (BT_HDR*& partial_packet : partial_packets) {
+    if (partial_packet != NULL) {
+      buffer_allocator->free(partial_packet);
+      partial_packet = NULL;
+    }
+  }
+}
 
 static void fragment_and_dispatch(BT_HDR* packet) {
   CHECK(packet != NULL);
@@ -141,16 +148,14 @@ static void reassemble_and_dispatch(UNUSED_ATTR BT_HDR* packet) {
       }
       uint16_t l2cap_length;
       STREAM_TO_UINT16(l2cap_length, stream);
-      auto map_iter = partial_packets.find(handle);
-      if (map_iter != partial_packets.end()) {
+      if (partial_packets[handle] != NULL) {
         LOG_WARN(
             "%s found unfinished packet for handle with start packet. "
             "Dropping old.",
             __func__);
 
-        BT_HDR* hdl = map_iter->second;
-        partial_packets.erase(map_iter);
-        buffer_allocator->free(hdl);
+        buffer_allocator->free(partial_packets[handle]);
+        partial_packets[handle] = NULL;
       }
 
       if (acl_length < L2CAP_HEADER_PDU_LEN_SIZE) {
@@ -174,6 +179,7 @@ static void reassemble_and_dispatch(UNUSED_ATTR BT_HDR* packet) {
         return;
       }
 
+      // The start fragment holds the whole L2CAP PDU, hand it up as is
       if (full_length <= packet->len) {
         if (full_length < packet->len)
           LOG_WARN("%s found l2cap full length %d less than the hci length %d.",
@@ -201,14 +207,13 @@ static void reassemble_and_dispatch(UNUSED_ATTR BT_HDR* packet) {
       // Free the old packet buffer, since we don't need it anymore
       buffer_allocator->free(packet);
     } else {
-      auto map_iter = partial_packets.find(handle);
-      if (map_iter == partial_packets.end()) {
+      BT_HDR* partial_packet = partial_packets[handle];
+      if (partial_packet == NULL) {
         LOG_WARN("%s got continuation for unknown packet. Dropping it.",
                  __func__);
         buffer_allocator->free(packet);
         return;
       }
-      BT_HDR* partial_packet = map_iter->second;
 
       packet->offset = HCI_ACL_PREAMBLE_SIZE;
       uint16_t projected_offset =
@@ -231,7 +236,7 @@ static void reassemble_and_dispatch(UNUSED_ATTR BT_HDR* packet) {
       partial_packet->offset = projected_offset;
 
       if (partial_packet->offset == partial_packet->len) {
-        partial_packets.erase(handle);
+        partial_packets[handle] = NULL;
         partial_packet->offset = 0;
         callbacks->reassembled(partial_packet);
       }
@@ -0,0 +1,200 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "bt_types.h"
+#include "hci/include/btsnoop_mem_ring.h"
+
+namespace {
+
+const size_t kFileHeaderSize = 16;
+const size_t kPacketHeaderSize = 25;
+
+// A packet of a btsnoop file
+struct SnoopPacket {
+  uint32_t length_original;
+  uint32_t flags;
+  uint8_t type;
+  std::vector<uint8_t> data;
+};
+
+std::vector<uint8_t> ReadFile(const std::string& path) {
+  std::vector<uint8_t> content;
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return content;
+  uint8_t buffer[4096];
+  ssize_t ret;
+  while ((ret = read(fd, buffer, sizeof(buffer))) > 0)
+    content.insert(content.end(), buffer, buffer + ret);
+  close(fd);
+  return content;
+}
+
+std::vector<SnoopPacket> ParseSnoop(const std::vector<uint8_t>& content) {
+  std::vector<SnoopPacket> packets;
+  EXPECT_GE(content.size(), kFileHeaderSize);
+  EXPECT_EQ(memcmp(content.data(), "btsnoop\0", 8), 0);
+  size_t offset = kFileHeaderSize;
+  while (offset + kPacketHeaderSize <= content.size()) {
+    const uint8_t* p = content.data() + offset;
+    uint32_t value;
+    SnoopPacket packet;
+    memcpy(&value, p, 4);
+    packet.length_original = ntohl(value);
+    memcpy(&value, p + 4, 4);
+    uint32_t length_captured = ntohl(value);
+    memcpy(&value, p + 8, 4);
+    packet.flags = ntohl(value);
+    packet.type = p[24];
+    p += kPacketHeaderSize;
+    packet.data.assign(p, p + length_captured - 1);
+    packets.push_back(packet);
+    offset += kPacketHeaderSize + length_captured - 1;
+  }
+  EXPECT_EQ(offset, content.size());
+  return packets;
+}
+
+}  // namespace
+
+class BtsnoopMemRingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+#if defined(OS_GENERIC)
+    tmp_dir_ = "/tmp/btmrXXXXXX";
+#else
+    tmp_dir_ = "/data/local/tmp/btmrXXXXXX";
+#endif  // !defined(OS_GENERIC)
+    ASSERT_NE(mkdtemp(const_cast<char*>(tmp_dir_.c_str())), nullptr);
+    ring_path_ = tmp_dir_ + "/ring";
+    last_path_ = ring_path_ + ".last.log";
+  }
+
+  void TearDown() override {
+    btsnoop_mem_ring_close();
+    unlink(ring_path_.c_str());
+    unlink(last_path_.c_str());
+    rmdir(tmp_dir_.c_str());
+  }
+
+  std::vector<SnoopPacket> Write(uint64_t window_us) {
+    std::string dump_path = tmp_dir_ + "/dump";
+    int fd = open(dump_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    EXPECT_GE(fd, 0);
+    EXPECT_TRUE(btsnoop_mem_ring_write(fd, window_us));
+    close(fd);
+    std::vector<SnoopPacket> packets = ParseSnoop(ReadFile(dump_path));
+    unlink(dump_path.c_str());
+    return packets;
+  }
+
+  std::string tmp_dir_;
+  std::string ring_path_;
+  std::string last_path_;
+};
+
+TEST_F(BtsnoopMemRingTest, keeps_the_last_records) {
+  ASSERT_TRUE(btsnoop_mem_ring_open(ring_path_.c_str(), 8, 0));
+  for (uint8_t i = 0; i < 12; i++) {
+    const uint8_t event[] = {0x0e, 0x01, i};
+    btsnoop_mem_ring_append(BT_EVT_TO_BTU_HCI_EVT, event, sizeof(event),
+                            1000000 + i * 1000);
+  }
+
+  std::vector<SnoopPacket> packets = Write(UINT64_MAX);
+  ASSERT_EQ(packets.size(), 8u);
+  for (size_t i = 0; i < packets.size(); i++) {
+    EXPECT_EQ(packets[i].type, 4);
+    EXPECT_EQ(packets[i].flags, 3u);
+    EXPECT_EQ(packets[i].length_original, 4u);
+    ASSERT_EQ(packets[i].data.size(), 3u);
+    EXPECT_EQ(packets[i].data[2], 4 + i);
+  }
+}
+
+TEST_F(BtsnoopMemRingTest, truncates_long_packets) {
+  ASSERT_TRUE(btsnoop_mem_ring_open(ring_path_.c_str(), 4, 0));
+  std::vector<uint8_t> acl(300, 0xaa);
+  btsnoop_mem_ring_append(BT_EVT_TO_LM_HCI_ACL, acl.data(), acl.size(), 1);
+  btsnoop_mem_ring_append(BT_EVT_TO_BTU_HCI_ACL, acl.data(), 10, 2);
+
+  std::vector<SnoopPacket> packets = Write(UINT64_MAX);
+  ASSERT_EQ(packets.size(), 2u);
+  EXPECT_EQ(packets[0].type, 2);
+  EXPECT_EQ(packets[0].flags, 0u);
+  EXPECT_EQ(packets[0].length_original, 301u);
+  EXPECT_EQ(packets[0].data.size(), (size_t)BTSNOOP_MEM_RING_DATA_SIZE);
+  EXPECT_EQ(packets[1].flags, 1u);
+  EXPECT_EQ(packets[1].data.size(), 10u);
+}
+
+TEST_F(BtsnoopMemRingTest, window_ends_with_the_last_packet) {
+  ASSERT_TRUE(btsnoop_mem_ring_open(ring_path_.c_str(), 64, 0));
+  for (uint8_t i = 0; i < 10; i++) {
+    const uint8_t command[] = {0x03, 0x0c, 0x00};
+    btsnoop_mem_ring_append(BT_EVT_TO_LM_HCI_CMD, command, sizeof(command),
+                            5000000 + i * 1000000);
+  }
+  EXPECT_EQ(Write(2500000).size(), 3u);
+  EXPECT_EQ(Write(0).size(), 1u);
+}
+
+TEST_F(BtsnoopMemRingTest, previous_run_is_saved_on_open) {
+  ASSERT_TRUE(btsnoop_mem_ring_open(ring_path_.c_str(), 16, 0));
+  const uint8_t event[] = {0x0e, 0x00};
+  btsnoop_mem_ring_append(BT_EVT_TO_BTU_HCI_EVT, event, sizeof(event), 1);
+  btsnoop_mem_ring_append(BT_EVT_TO_BTU_HCI_EVT, event, sizeof(event), 2);
+  // No close, as if the process crashed
+  ASSERT_TRUE(btsnoop_mem_ring_open(ring_path_.c_str(), 32, UINT64_MAX));
+
+  EXPECT_EQ(ParseSnoop(ReadFile(last_path_)).size(), 2u);
+  EXPECT_EQ(Write(UINT64_MAX).size(), 0u);
+
+  struct stat st;
+  ASSERT_EQ(stat(ring_path_.c_str(), &st), 0);
+  EXPECT_EQ((size_t)st.st_size, 33u * BTSNOOP_MEM_RING_RECORD_SIZE);
+}
+
+TEST_F(BtsnoopMemRingTest, invalid_file_is_not_saved) {
+  int fd = open(ring_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  ASSERT_GE(fd, 0);
+  std::vector<uint8_t> garbage(4096, 0x5a);
+  ASSERT_EQ(write(fd, garbage.data(), garbage.size()),
+            (ssize_t)garbage.size());
+  close(fd);
+
+  ASSERT_TRUE(btsnoop_mem_ring_open(ring_path_.c_str(), 8, UINT64_MAX));
+  EXPECT_NE(access(last_path_.c_str(), F_OK), 0);
+}
+
+TEST_F(BtsnoopMemRingTest, append_when_closed_is_ignored) {
+  const uint8_t event[] = {0x0e, 0x00};
+  btsnoop_mem_ring_append(BT_EVT_TO_BTU_HCI_EVT, event, sizeof(event), 1);
+  EXPECT_FALSE(btsnoop_mem_ring_write(STDOUT_FILENO, UINT64_MAX));
+}
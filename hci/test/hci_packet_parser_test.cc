@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "AllocationTestHarness.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "hci_packet_parser.h"
+#include "hcidefs.h"
+#include "osi/include/allocator.h"
+
+static const hci_packet_parser_t* parser;
+
+class HciPacketParserTest : public AllocationTestHarness {
+ protected:
+  void SetUp() override {
+    AllocationTestHarness::SetUp();
+    parser = hci_packet_parser_get_test_interface(
+        const_cast<allocator_t*>(&allocator_malloc));
+  }
+};
+
+// Builds a command complete event for |opcode| with |status| followed by
+// |return_parameters|.
+static BT_HDR* make_command_complete(
+    uint16_t opcode, uint8_t status,
+    const std::vector<uint8_t>& return_parameters) {
+  uint8_t parameter_length = 4 + return_parameters.size();
+  BT_HDR* response = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + 2 + parameter_length);
+  response->offset = 0;
+  response->len = 2 + parameter_length;
+  uint8_t* stream = response->data;
+  UINT8_TO_STREAM(stream, HCI_COMMAND_COMPLETE_EVT);
+  UINT8_TO_STREAM(stream, parameter_length);
+  UINT8_TO_STREAM(stream, 1);  // number of hci command packets
+  UINT16_TO_STREAM(stream, opcode);
+  UINT8_TO_STREAM(stream, status);
+  ARRAY_TO_STREAM(stream, return_parameters.data(),
+                  (int)return_parameters.size());
+  return response;
+}
+
+TEST_F(HciPacketParserTest, read_local_supported_codecs) {
+  uint8_t number_of_codecs = 0;
+  uint8_t codecs[4] = {};
+  parser->parse_read_local_supported_codecs_response(
+      make_command_complete(HCI_READ_LOCAL_SUPPORTED_CODECS, HCI_SUCCESS,
+                            {2, 0x02, 0x05}),
+      &number_of_codecs, codecs, sizeof(codecs));
+  EXPECT_EQ(number_of_codecs, 2);
+  EXPECT_EQ(codecs[0], 0x02);
+  EXPECT_EQ(codecs[1], 0x05);
+}
+
+TEST_F(HciPacketParserTest, read_local_supported_codecs_more_than_fit) {
+  uint8_t number_of_codecs = 0;
+  uint8_t codecs[2] = {};
+  parser->parse_read_local_supported_codecs_response(
+      make_command_complete(HCI_READ_LOCAL_SUPPORTED_CODECS, HCI_SUCCESS,
+                            {4, 0x01, 0x02, 0x03, 0x04}),
+      &number_of_codecs, codecs, sizeof(codecs));
+  EXPECT_EQ(number_of_codecs, 2);
+  EXPECT_EQ(codecs[0], 0x01);
+  EXPECT_EQ(codecs[1], 0x02);
+}
+
+TEST_F(HciPacketParserTest, read_local_supported_codecs_count_past_event) {
+  uint8_t number_of_codecs = 0;
+  uint8_t codecs[8] = {};
+  parser->parse_read_local_supported_codecs_response(
+      make_command_complete(HCI_READ_LOCAL_SUPPORTED_CODECS, HCI_SUCCESS,
+                            {200, 0x01}),
+      &number_of_codecs, codecs, sizeof(codecs));
+  EXPECT_EQ(number_of_codecs, 1);
+  EXPECT_EQ(codecs[0], 0x01);
+}
+
+TEST_F(HciPacketParserTest, failed_optional_read_keeps_value) {
+  uint8_t resolving_list_size = 5;
+  parser->parse_ble_read_resolving_list_size_response(
+      make_command_complete(HCI_BLE_READ_RESOLVING_LIST_SIZE,
+                            HCI_ERR_UNSUPPORTED_VALUE, {}),
+      &resolving_list_size);
+  EXPECT_EQ(resolving_list_size, 5);
+}
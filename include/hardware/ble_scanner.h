@@ -29,6 +29,15 @@ typedef void (*batchscan_reports_callback)(int client_if, int status,
                                            int report_format, int num_records,
                                            std::vector<uint8_t> data);
 
+/** Callback invoked with each chunk of batchscan reports as it is read from
+ * the controller. |more| is false on the last call of a read, which carries
+ * no records. When set, batchscan_reports_cb is not called */
+typedef void (*batchscan_reports_chunk_callback)(int client_if, int status,
+                                                 int report_format,
+                                                 int num_records,
+                                                 std::vector<uint8_t> data,
+                                                 bool more);
+
 /** Callback invoked when batchscan storage threshold limit is crossed */
 typedef void (*batchscan_threshold_callback)(int client_if);
 
@@ -44,11 +53,34 @@ typedef void (*scan_result_callback)(uint16_t event_type, uint8_t addr_type,
                                      int8_t rssi, uint16_t periodic_adv_int,
                                      std::vector<uint8_t> adv_data);
 
+/** Header of each result of a scan_results_batch_callback, followed by
+ * |adv_data_len| bytes of advertising data */
+typedef struct {
+  uint16_t event_type;
+  uint8_t addr_type;
+  RawAddress bda;
+  uint8_t primary_phy;
+  uint8_t secondary_phy;
+  uint8_t advertising_sid;
+  int8_t tx_power;
+  int8_t rssi;
+  uint16_t periodic_adv_int;
+  uint16_t adv_data_len;
+} __attribute__((packed)) btgatt_batched_scan_result_t;
+
+/** Callback for the scan results coalesced as set with
+ * BleScannerInterface::SetScanResultBatching. |data| holds |num_results|
+ * results back to back */
+typedef void (*scan_results_batch_callback)(int num_results,
+                                            std::vector<uint8_t> data);
+
 typedef struct {
   scan_result_callback scan_result_cb;
   batchscan_reports_callback batchscan_reports_cb;
   batchscan_threshold_callback batchscan_threshold_cb;
   track_adv_event_callback track_adv_event_cb;
+  batchscan_reports_chunk_callback batchscan_reports_chunk_cb;
+  scan_results_batch_callback scan_results_batch_cb;
 } btgatt_scanner_callbacks_t;
 
 class BleScannerInterface {
@@ -117,6 +149,11 @@ class BleScannerInterface {
   /* Read out batchscan reports */
   virtual void BatchscanReadReports(int client_if, int scan_mode) = 0;
 
+  /* Coalesce the scan results received within |window_ms|, up to
+   * |max_results| of them, into a single scan_results_batch_cb. A window of
+   * 0 reports each result with scan_result_cb. */
+  virtual void SetScanResultBatching(int window_ms, int max_results) = 0;
+
   using StartSyncCb =
       base::Callback<void(uint8_t status, uint16_t sync_handle,
                           uint8_t advertising_sid, uint8_t address_type,
@@ -129,6 +166,17 @@ class BleScannerInterface {
                          uint16_t timeout, StartSyncCb start_cb,
                          SyncReportCb report_cb, SyncLostCb lost_cb) = 0;
   virtual void StopSync(uint16_t handle) = 0;
+
+  using SyncTransferCb =
+      base::Callback<void(uint8_t status, RawAddress address)>;
+  /* Send the sync |sync_handle| to the connected peer |address| */
+  virtual void TransferSync(RawAddress address, uint16_t service_data,
+                            uint16_t sync_handle, SyncTransferCb cb) = 0;
+  /* Accept the syncs transferred by the connected peer |address| */
+  virtual void ReceiveSyncTransfer(RawAddress address, uint16_t skip,
+                                   uint16_t timeout, StartSyncCb start_cb,
+                                   SyncReportCb report_cb,
+                                   SyncLostCb lost_cb) = 0;
 };
 
 #endif /* ANDROID_INCLUDE_BLE_SCANNER_H */
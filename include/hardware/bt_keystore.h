@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <string>
+#include <vector>
+
 namespace bluetooth {
 namespace bluetooth_keystore {
 
@@ -45,6 +48,9 @@ class BluetoothKeystoreInterface {
 
   /** Interface for clear map. */
   virtual void clear_map() = 0;
+
+  /** Fetch the keys of |prefixes| ahead of their first use. */
+  virtual void prefetch_keys(std::vector<std::string> prefixes) = 0;
 };
 
 }  // namespace bluetooth_keystore
@@ -586,13 +586,24 @@
 #endif
 
 /*
- * Max bytes per connection to buffer locally before dropping the
- * connection if local client does not receive it  - default is 1MB
+ * Max bytes per connection to buffer locally for the local client. Once
+ * reached, the packets of PSM based channels are left in the L2CAP receive
+ * queue until the client catches up, fixed channels are dropped - default is
+ * 1MB
  */
 #ifndef L2CAP_MAX_RX_BUFFER
 #define L2CAP_MAX_RX_BUFFER 0x100000
 #endif
 
+/*
+ * Max bytes a PSM based connection may leave in the L2CAP receive queue while
+ * its reads are paused. ERTM local busy is not supported, so the peer is not
+ * throttled and the connection is dropped past this - default is 4MB
+ */
+#ifndef L2CAP_MAX_RX_PENDING
+#define L2CAP_MAX_RX_PENDING (4 * L2CAP_MAX_RX_BUFFER)
+#endif
+
 /******************************************************************************
  *
  * BLE
@@ -886,9 +897,11 @@
 /*
  * Size of the transmission window when using enhanced retransmission mode.
  * Not used in basic and streaming modes. Range: 1 - 63
+ * The largest window lets peers using OBEX single response mode stream large
+ * bodies, such as phonebooks, without waiting for acknowledgements.
  */
 #ifndef OBX_FCR_OPT_TX_WINDOW_SIZE_BR_EDR
-#define OBX_FCR_OPT_TX_WINDOW_SIZE_BR_EDR 20
+#define OBX_FCR_OPT_TX_WINDOW_SIZE_BR_EDR 63
 #endif
 
 /*
@@ -34,6 +34,9 @@ typedef struct {
   const std::string* (*get_pts_smp_options)(void);
   int (*get_pts_smp_failure_case)(void);
   config_t* (*get_all)(void);
+  bool (*get_task_statistics_enabled)(void);
+  int (*get_task_watchdog_ms)(void);
+  int (*get_task_watchdog_queue_depth)(void);
 } stack_config_t;
 
 const stack_config_t* stack_config_get_interface(void);
@@ -37,6 +37,7 @@
 #include "btsnoop.h"
 #include "btu.h"
 #include "device/include/interop.h"
+#include "gd/os/trace.h"
 #include "hci_layer.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
@@ -86,6 +87,10 @@ extern void btu_hci_msg_process(BT_HDR* p_msg);
  *
  *****************************************************************************/
 void post_to_main_message_loop(const base::Location& from_here, BT_HDR* p_msg) {
+  if (bluetooth::os::trace::IsEnabled()) {
+    bluetooth::os::trace::BeginFlow(BTU_HCI_PACKET_TRACE_FLOW,
+                                    bluetooth::os::trace::FlowIdOf(p_msg));
+  }
   if (do_in_main_thread(from_here, base::Bind(&btu_hci_msg_process, p_msg)) !=
       BT_STATUS_SUCCESS) {
     LOG(ERROR) << __func__ << ": do_in_main_thread failed from "
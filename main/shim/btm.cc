@@ -38,6 +38,7 @@
 #include "gd/neighbor/discoverability.h"
 #include "gd/neighbor/inquiry.h"
 #include "gd/neighbor/name.h"
+#include "gd/neighbor/name_db.h"
 #include "gd/neighbor/page.h"
 #include "gd/security/security_module.h"
 
@@ -84,7 +85,6 @@ namespace bluetooth {
 
 namespace shim {
 
-constexpr int kAdvertisingReportBufferSize = 1024;
 
 struct ExtendedEventTypeOptions {
   bool connectable{false};
@@ -150,32 +150,18 @@ static void store_le_address_type(RawAddress address, tBLE_ADDR_TYPE type) {
 }
 
 void Btm::ScanningCallbacks::on_advertisements(
-    std::vector<std::shared_ptr<hci::LeReport>> reports) {
-  for (auto le_report : reports) {
-    uint8_t address_type = static_cast<uint8_t>(le_report->address_type_);
+    std::vector<hci::LeReportView> reports) {
+  for (const hci::LeReportView& le_report : reports) {
+    uint8_t address_type = static_cast<uint8_t>(le_report.GetAddressType());
     uint16_t extended_event_type = 0;
-    uint8_t* report_data = nullptr;
-    size_t report_len = 0;
-
-    uint8_t advertising_data_buffer[kAdvertisingReportBufferSize];
-    // Copy gap data, if any, into temporary buffer as payload for legacy
-    // stack.
-    if (!le_report->gap_data_.empty()) {
-      bzero(advertising_data_buffer, kAdvertisingReportBufferSize);
-      uint8_t* p = advertising_data_buffer;
-      for (auto gap_data : le_report->gap_data_) {
-        *p++ = gap_data.data_.size() + sizeof(gap_data.data_type_);
-        *p++ = static_cast<uint8_t>(gap_data.data_type_);
-        p = (uint8_t*)memcpy(p, &gap_data.data_[0], gap_data.data_.size()) +
-            gap_data.data_.size();
-      }
-      report_data = advertising_data_buffer;
-      report_len = p - report_data;
-    }
-
-    switch (le_report->GetReportType()) {
-      case hci::LeReport::ReportType::ADVERTISING_EVENT: {
-        switch (le_report->advertising_event_type_) {
+    // The legacy stack copies the advertising data out before returning, so
+    // it is passed straight from the event bytes
+    uint8_t* report_data = const_cast<uint8_t*>(le_report.GetAdvertisingData());
+    size_t report_len = le_report.GetAdvertisingDataSize();
+
+    switch (le_report.GetReportType()) {
+      case hci::LeReportView::ReportType::ADVERTISING_EVENT: {
+        switch (le_report.GetAdvertisingEventType()) {
           case hci::AdvertisingEventType::ADV_IND:
             TransformToExtendedEventType(
                 &extended_event_type,
@@ -204,47 +190,46 @@ void Btm::ScanningCallbacks::on_advertisements(
           default:
             LOG_WARN(
                 "%s Unsupported event type:%s", __func__,
-                AdvertisingEventTypeText(le_report->advertising_event_type_)
+                AdvertisingEventTypeText(le_report.GetAdvertisingEventType())
                     .c_str());
             return;
         }
 
-        RawAddress raw_address = ToRawAddress(le_report->address_);
+        RawAddress raw_address = ToRawAddress(le_report.GetAddress());
 
         btm_ble_process_adv_addr(raw_address, &address_type);
         btm_ble_process_adv_pkt_cont(
             extended_event_type, address_type, raw_address, kPhyConnectionLe1M,
             kPhyConnectionNone, kAdvDataInfoNotPresent,
-            kTxPowerInformationNotPresent, le_report->rssi_,
+            kTxPowerInformationNotPresent, le_report.GetRssi(),
             kNotPeriodicAdvertisement, report_len, report_data);
         store_le_address_type(raw_address, address_type);
       } break;
 
-      case hci::LeReport::ReportType::DIRECTED_ADVERTISING_EVENT:
+      case hci::LeReportView::ReportType::DIRECTED_ADVERTISING_EVENT:
         LOG_WARN("%s Directed advertising is unsupported from device:%s",
-                 __func__, le_report->address_.ToString().c_str());
+                 __func__, le_report.GetAddress().ToString().c_str());
         break;
 
-      case hci::LeReport::ReportType::EXTENDED_ADVERTISING_EVENT: {
-        std::shared_ptr<hci::ExtendedLeReport> extended_le_report =
-            std::static_pointer_cast<hci::ExtendedLeReport>(le_report);
+      case hci::LeReportView::ReportType::EXTENDED_ADVERTISING_EVENT: {
+        hci::DataStatus data_status = le_report.GetDataStatus();
         TransformToExtendedEventType(
             &extended_event_type,
-            {.connectable = extended_le_report->connectable_,
-             .scannable = extended_le_report->scannable_,
-             .directed = extended_le_report->directed_,
-             .scan_response = extended_le_report->scan_response_,
+            {.connectable = le_report.IsConnectable(),
+             .scannable = le_report.IsScannable(),
+             .directed = le_report.IsDirected(),
+             .scan_response = le_report.IsScanResponse(),
              .legacy = false,
-             .continuing = !extended_le_report->complete_,
-             .truncated = extended_le_report->truncated_});
-        RawAddress raw_address = ToRawAddress(le_report->address_);
+             .continuing = data_status != hci::DataStatus::COMPLETE,
+             .truncated = data_status == hci::DataStatus::TRUNCATED});
+        RawAddress raw_address = ToRawAddress(le_report.GetAddress());
         if (address_type != BLE_ADDR_ANONYMOUS) {
           btm_ble_process_adv_addr(raw_address, &address_type);
         }
         btm_ble_process_adv_pkt_cont(
             extended_event_type, address_type, raw_address, kPhyConnectionLe1M,
             kPhyConnectionNone, kAdvDataInfoNotPresent,
-            kTxPowerInformationNotPresent, le_report->rssi_,
+            kTxPowerInformationNotPresent, le_report.GetRssi(),
             kNotPeriodicAdvertisement, report_len, report_data);
         store_le_address_type(raw_address, address_type);
       } break;
@@ -276,6 +261,12 @@ Btm::Btm(os::Handler* handler, neighbor::InquiryModule* inquiry)
 
 void Btm::OnInquiryResult(bluetooth::hci::InquiryResultView view) {
   for (auto& response : view.GetInquiryResults()) {
+    GetNameDb()->SetPageScanHint(response.bd_addr_,
+                                 response.page_scan_repetition_mode_,
+                                 response.clock_offset_);
+    GetAclManager()->SetPageScanHint(
+        response.bd_addr_, response.page_scan_repetition_mode_,
+        response.clock_offset_, bluetooth::hci::ClockOffsetValid::VALID);
     btm_api_process_inquiry_result(
         ToRawAddress(response.bd_addr_),
         static_cast<uint8_t>(response.page_scan_repetition_mode_),
@@ -286,6 +277,12 @@ void Btm::OnInquiryResult(bluetooth::hci::InquiryResultView view) {
 void Btm::OnInquiryResultWithRssi(
     bluetooth::hci::InquiryResultWithRssiView view) {
   for (auto& response : view.GetInquiryResults()) {
+    GetNameDb()->SetPageScanHint(response.address_,
+                                 response.page_scan_repetition_mode_,
+                                 response.clock_offset_);
+    GetAclManager()->SetPageScanHint(
+        response.address_, response.page_scan_repetition_mode_,
+        response.clock_offset_, bluetooth::hci::ClockOffsetValid::VALID);
     btm_api_process_inquiry_result_with_rssi(
         ToRawAddress(response.address_),
         static_cast<uint8_t>(response.page_scan_repetition_mode_),
@@ -301,10 +298,24 @@ void Btm::OnExtendedInquiryResult(
   uint8_t* data = nullptr;
   size_t data_len = 0;
 
+  GetNameDb()->SetPageScanHint(view.GetAddress(),
+                               view.GetPageScanRepetitionMode(),
+                               view.GetClockOffset());
+  GetAclManager()->SetPageScanHint(
+      view.GetAddress(), view.GetPageScanRepetitionMode(),
+      view.GetClockOffset(), bluetooth::hci::ClockOffsetValid::VALID);
+
   if (!view.GetExtendedInquiryResponse().empty()) {
     bzero(gap_data_buffer, sizeof(gap_data_buffer));
     uint8_t* p = gap_data_buffer;
     for (auto gap_data : view.GetExtendedInquiryResponse()) {
+      if (gap_data.data_type_ == hci::GapDataType::COMPLETE_LOCAL_NAME) {
+        neighbor::RemoteName name{};
+        std::copy_n(gap_data.data_.begin(),
+                    std::min(gap_data.data_.size(), name.size() - 1),
+                    name.begin());
+        GetNameDb()->CacheRemoteName(view.GetAddress(), name);
+      }
       *p++ = gap_data.data_.size() + sizeof(gap_data.data_type_);
       *p++ = static_cast<uint8_t>(gap_data.data_type_);
       p = (uint8_t*)memcpy(p, &gap_data.data_[0], gap_data.data_.size()) +
@@ -618,23 +629,23 @@ BtmStatus Btm::ReadClassicRemoteDeviceName(const RawAddress& raw_address,
 
   LOG_DEBUG("%s Start read name from address:%s", __func__,
             raw_address.ToString().c_str());
-  GetName()->ReadRemoteNameRequest(
-      ToGdAddress(raw_address), hci::PageScanRepetitionMode::R1,
-      0 /* clock_offset */, hci::ClockOffsetValid::INVALID,
-
+  // The name db answers with a cached name without paging the device
+  GetNameDb()->ReadRemoteNameRequest(
+      ToGdAddress(raw_address),
       base::Bind(
           [](tBTM_CMPL_CB* callback, ReadRemoteName* classic_read_remote_name,
-             hci::ErrorCode status, hci::Address address,
-             std::array<uint8_t, kRemoteDeviceNameLength> remote_name) {
+             hci::Address address, bool success) {
             RawAddress raw_address = ToRawAddress(address);
 
             BtmRemoteDeviceName name{
-                .status = (static_cast<uint8_t>(status) == 0)
-                              ? (BTM_SUCCESS)
-                              : (BTM_BAD_VALUE_RET),
+                .status = success ? (BTM_SUCCESS) : (BTM_BAD_VALUE_RET),
                 .bd_addr = raw_address,
                 .length = kRemoteDeviceNameLength,
             };
+            std::array<uint8_t, kRemoteDeviceNameLength> remote_name{};
+            if (success && GetNameDb()->IsNameCached(address)) {
+              remote_name = GetNameDb()->ReadCachedRemoteName(address);
+            }
             std::copy(remote_name.begin(), remote_name.end(),
                       name.remote_bd_name);
             LOG_DEBUG("%s Finish read name from address:%s name:%s", __func__,
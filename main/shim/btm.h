@@ -246,8 +246,7 @@ class Btm {
   ReadRemoteName classic_read_remote_name_;
 
   class ScanningCallbacks : public hci::LeScanningManagerCallbacks {
-    void on_advertisements(
-        std::vector<std::shared_ptr<hci::LeReport>> reports) override;
+    void on_advertisements(std::vector<hci::LeReportView> reports) override;
     void on_timeout() override;
     os::Handler* Handler() override;
   };
@@ -22,6 +22,7 @@
 #include "gd/neighbor/discoverability.h"
 #include "gd/neighbor/inquiry.h"
 #include "gd/neighbor/name.h"
+#include "gd/neighbor/name_db.h"
 #include "gd/neighbor/page.h"
 #include "gd/os/handler.h"
 #include "gd/security/security_module.h"
@@ -93,6 +94,12 @@ neighbor::NameModule* GetName() {
       ->GetInstance<neighbor::NameModule>();
 }
 
+neighbor::NameDbModule* GetNameDb() {
+  return Stack::GetInstance()
+      ->GetStackManager()
+      ->GetInstance<neighbor::NameDbModule>();
+}
+
 neighbor::PageModule* GetPage() {
   return Stack::GetInstance()
       ->GetStackManager()
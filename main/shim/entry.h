@@ -41,6 +41,7 @@ class ConnectabilityModule;
 class DiscoverabilityModule;
 class InquiryModule;
 class NameModule;
+class NameDbModule;
 class PageModule;
 }
 namespace hci {
@@ -79,6 +80,7 @@ hci::HciLayer* GetHciLayer();
 L2cap* GetL2cap();
 l2cap::le::L2capLeModule* GetL2capLeModule();
 neighbor::NameModule* GetName();
+neighbor::NameDbModule* GetNameDb();
 neighbor::PageModule* GetPage();
 hci::LeScanningManager* GetScanning();
 bluetooth::security::SecurityModule* GetSecurityModule();
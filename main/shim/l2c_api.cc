@@ -20,7 +20,7 @@
 #include "gd/l2cap/le/l2cap_le_module.h"
 #include "gd/os/log.h"
 #include "gd/os/queue.h"
-#include "gd/packet/raw_builder.h"
+#include "gd/packet/view_builder.h"
 #include "main/shim/btm.h"
 #include "main/shim/entry.h"
 #include "main/shim/helpers.h"
@@ -217,6 +217,11 @@ bool bluetooth::shim::L2CA_SetAclPriority(const RawAddress& bd_addr,
   return false;
 }
 
+bool bluetooth::shim::L2CA_SetChnlAclPriority(uint16_t cid, uint8_t priority) {
+  LOG_INFO("UNIMPLEMENTED %s", __func__);
+  return false;
+}
+
 bool bluetooth::shim::L2CA_SetFlushTimeout(const RawAddress& bd_addr,
                                            uint16_t flush_tout) {
   LOG_INFO("UNIMPLEMENTED %s", __func__);
@@ -293,11 +298,10 @@ struct LeFixedChannelHelper {
       return;
     }
     auto packet = channel->second->GetQueueUpEnd()->TryDequeue();
-    std::vector<uint8_t> packet_vector(packet->begin(), packet->end());
     BT_HDR* buffer =
-        static_cast<BT_HDR*>(osi_calloc(packet_vector.size() + sizeof(BT_HDR)));
-    std::copy(packet_vector.begin(), packet_vector.end(), buffer->data);
-    buffer->len = packet_vector.size();
+        static_cast<BT_HDR*>(osi_calloc(packet->size() + sizeof(BT_HDR)));
+    packet->CopyTo(buffer->data);
+    buffer->len = packet->size();
     auto address = bluetooth::ToRawAddress(remote.GetAddress());
     freg_.pL2CA_FixedData_Cb(cid_, address, buffer);
   }
@@ -386,13 +390,13 @@ bool bluetooth::shim::L2CA_ConnectFixedChnl(uint16_t cid,
   return bluetooth::shim::L2CA_ConnectFixedChnl(cid, rem_bda);
 }
 
-static std::unique_ptr<bluetooth::packet::RawBuilder> MakeUniquePacket(
-    const uint8_t* data, size_t len) {
-  bluetooth::packet::RawBuilder builder;
-  std::vector<uint8_t> bytes(data, data + len);
-  auto payload = std::make_unique<bluetooth::packet::RawBuilder>();
-  payload->AddOctets(bytes);
-  return payload;
+// Wraps the payload of |p_buf| without copying it. |p_buf| is freed once the
+// returned builder is destroyed.
+static std::unique_ptr<bluetooth::packet::ViewBuilder> MakeUniquePacket(
+    BT_HDR* p_buf) {
+  bluetooth::packet::View payload(p_buf->data + p_buf->offset, p_buf->len,
+                                  [p_buf]() { osi_free(p_buf); });
+  return std::make_unique<bluetooth::packet::ViewBuilder>(std::move(payload));
 }
 
 uint16_t bluetooth::shim::L2CA_SendFixedChnlData(uint16_t cid,
@@ -405,8 +409,7 @@ uint16_t bluetooth::shim::L2CA_SendFixedChnlData(uint16_t cid,
   auto* helper = &le_fixed_channel_helper_.find(cid)->second;
   auto remote = ToAddressWithType(rem_bda, Btm::GetAddressType(rem_bda));
   auto len = p_buf->len;
-  auto* data = p_buf->data + p_buf->offset;
-  bool sent = helper->send(remote, MakeUniquePacket(data, len));
+  bool sent = helper->send(remote, MakeUniquePacket(p_buf));
   return sent ? len : 0;
 }
 
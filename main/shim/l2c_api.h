@@ -393,6 +393,21 @@ uint16_t L2CA_FlushChannel(uint16_t lcid, uint16_t num_to_flush);
  ******************************************************************************/
 bool L2CA_SetAclPriority(const RawAddress& bd_addr, uint8_t priority);
 
+/*******************************************************************************
+ *
+ * Function         L2CA_SetChnlAclPriority
+ *
+ * Description      Sets the priority of the ACL link a channel needs, on a
+ *                  BR/EDR or LE link. (L2CAP_PRIORITY_NORMAL or
+ *                  L2CAP_PRIORITY_HIGH). The link has the highest priority of
+ *                  the one set by L2CA_SetAclPriority and the ones its open
+ *                  channels need.
+ *
+ * Returns          true if a valid channel, else false
+ *
+ ******************************************************************************/
+bool L2CA_SetChnlAclPriority(uint16_t cid, uint8_t priority);
+
 /*******************************************************************************
  *
  * Function         L2CA_SetTxPriority
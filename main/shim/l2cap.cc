@@ -16,6 +16,7 @@
 #define LOG_TAG "bt_shim_l2cap"
 
 #include <cstdint>
+#include <vector>
 
 #include "main/shim/dumpsys.h"
 #include "main/shim/entry.h"
@@ -304,25 +305,45 @@ bool bluetooth::shim::legacy::L2cap::Write(uint16_t cid, BT_HDR* bt_hdr) {
   const uint8_t* data = bt_hdr->data + bt_hdr->offset;
   size_t len = bt_hdr->len;
   if (!ConnectionExists(cid) || len == 0) {
+    osi_free(bt_hdr);
     return false;
   }
   LOG_DEBUG("Writing data cid:%hd len:%zd", cid, len);
-  bluetooth::shim::GetL2cap()->Write(cid, data, len);
+  // Hand the payload over without copying it; the buffer is freed once gd
+  // has sent it.
+  bluetooth::packet::View payload(data, len,
+                                  [bt_hdr]() { osi_free(bt_hdr); });
+  bluetooth::shim::GetL2cap()->Write(cid, std::move(payload));
   return true;
 }
 
 void bluetooth::shim::legacy::L2cap::SetDownstreamCallbacks(uint16_t cid) {
   bluetooth::shim::GetL2cap()->SetReadDataReadyCallback(
-      cid, [this](uint16_t cid, std::vector<const uint8_t> data) {
-        LOG_DEBUG("OnDataReady cid:%hd len:%zd", cid, data.size());
-        BT_HDR* bt_hdr =
-            static_cast<BT_HDR*>(osi_calloc(data.size() + kBtHdrSize));
-        std::copy(data.begin(), data.end(), bt_hdr->data);
-        bt_hdr->len = data.size();
+      cid, [this](uint16_t cid,
+                  std::vector<bluetooth::packet::PacketView<
+                      bluetooth::packet::kLittleEndian>>
+                      packets) {
+        LOG_DEBUG("OnDataReady cid:%hd packets:%zd", cid, packets.size());
+        // Each packet is copied once, into the buffer handed to the client,
+        // and all of them are delivered by a single task
+        std::vector<BT_HDR*> bt_hdrs;
+        bt_hdrs.reserve(packets.size());
+        for (const auto& packet : packets) {
+          BT_HDR* bt_hdr =
+              static_cast<BT_HDR*>(osi_calloc(packet.size() + kBtHdrSize));
+          packet.CopyTo(bt_hdr->data);
+          bt_hdr->len = packet.size();
+          bt_hdrs.push_back(bt_hdr);
+        }
         do_in_main_thread(
             FROM_HERE,
-            base::Bind(classic_.Callbacks(CidToPsm(cid))->pL2CA_DataInd_Cb, cid,
-                       base::Unretained(bt_hdr)));
+            base::BindOnce(
+                [](tL2CA_DATA_IND_CB* data_ind, uint16_t cid,
+                   std::vector<BT_HDR*> bt_hdrs) {
+                  for (BT_HDR* bt_hdr : bt_hdrs) data_ind(cid, bt_hdr);
+                },
+                classic_.Callbacks(CidToPsm(cid))->pL2CA_DataInd_Cb, cid,
+                std::move(bt_hdrs)));
       });
 
   bluetooth::shim::GetL2cap()->SetConnectionClosedCallback(
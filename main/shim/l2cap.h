@@ -66,6 +66,7 @@ class L2cap {
 
   uint16_t CreateConnection(uint16_t psm, const RawAddress& raw_address);
 
+  // Takes ownership of |bt_hdr|, which is freed once sent or on failure.
   bool Write(uint16_t cid, BT_HDR* bt_hdr);
 
   void OnLocalInitiatedConnectionCreated(std::string string_address,
@@ -17,6 +17,7 @@
 #define LOG_TAG "bt_gd_shim"
 
 #include "gd/att/att_module.h"
+#include "gd/common/init_flags.h"
 #include "gd/hal/hci_hal.h"
 #include "gd/hci/acl_manager.h"
 #include "gd/hci/hci_layer.h"
@@ -99,7 +100,8 @@ void Stack::Start(ModuleList* modules) {
 
   stack_thread_ =
       new os::Thread("gd_stack_thread", os::Thread::Priority::NORMAL);
-  stack_manager_.StartUp(modules, stack_thread_);
+  stack_manager_.StartUp(modules, stack_thread_,
+                         common::InitFlags::GdParallelModuleStartEnabled());
 
   stack_handler_ = new os::Handler(stack_thread_);
 
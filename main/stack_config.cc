@@ -22,6 +22,7 @@
 
 #include <base/logging.h>
 
+#include "common/thread_profile.h"
 #include "osi/include/future.h"
 #include "osi/include/log.h"
 
@@ -33,8 +34,74 @@ const char* PTS_LE_CONN_UPDATED_DISABLED = "PTS_DisableConnUpdates";
 const char* PTS_DISABLE_SDP_LE_PAIR = "PTS_DisableSDPOnLEPair";
 const char* PTS_SMP_PAIRING_OPTIONS_KEY = "PTS_SmpOptions";
 const char* PTS_SMP_FAILURE_CASE_KEY = "PTS_SmpFailureCase";
+const char* TASK_STATISTICS_KEY = "TaskStatistics";
+const char* TASK_WATCHDOG_MS_KEY = "TaskWatchdogMs";
+const char* TASK_WATCHDOG_QUEUE_DEPTH_KEY = "TaskWatchdogQueueDepth";
+
+// The thread profile of a role, written as ParseThreadProfile() expects
+const struct {
+  const char* key;
+  bluetooth::common::ThreadRole role;
+} THREAD_PROFILE_KEYS[] = {
+    {"ThreadProfileDefault", bluetooth::common::ThreadRole::DEFAULT},
+    {"ThreadProfileAudioTx", bluetooth::common::ThreadRole::AUDIO_TX},
+    {"ThreadProfileHciRx", bluetooth::common::ThreadRole::HCI_RX},
+    {"ThreadProfileSocket", bluetooth::common::ThreadRole::SOCKET},
+    {"ThreadProfileStack", bluetooth::common::ThreadRole::STACK},
+};
 
 static std::unique_ptr<config_t> config;
+
+// The scalar settings, resolved once at init so that the getters are loads
+// rather than a section lookup and string parse on every call.
+struct {
+  bool trace_config_enabled;
+  bool pts_avrcp_test;
+  bool pts_secure_only_mode;
+  bool pts_conn_updates_disabled;
+  bool pts_crosskey_sdp_disable;
+  int pts_smp_failure_case;
+  bool task_statistics_enabled;
+  int task_watchdog_ms;
+  int task_watchdog_queue_depth;
+} settings;
+
+void load_settings() {
+  settings.trace_config_enabled = config_get_bool(
+      *config, CONFIG_DEFAULT_SECTION, TRACE_CONFIG_ENABLED_KEY, false);
+  settings.pts_avrcp_test =
+      config_get_bool(*config, CONFIG_DEFAULT_SECTION, PTS_AVRCP_TEST, false);
+  settings.pts_secure_only_mode = config_get_bool(
+      *config, CONFIG_DEFAULT_SECTION, PTS_SECURE_ONLY_MODE, false);
+  settings.pts_conn_updates_disabled = config_get_bool(
+      *config, CONFIG_DEFAULT_SECTION, PTS_LE_CONN_UPDATED_DISABLED, false);
+  settings.pts_crosskey_sdp_disable = config_get_bool(
+      *config, CONFIG_DEFAULT_SECTION, PTS_DISABLE_SDP_LE_PAIR, false);
+  settings.pts_smp_failure_case = config_get_int(
+      *config, CONFIG_DEFAULT_SECTION, PTS_SMP_FAILURE_CASE_KEY, 0);
+  settings.task_statistics_enabled = config_get_bool(
+      *config, CONFIG_DEFAULT_SECTION, TASK_STATISTICS_KEY, false);
+  settings.task_watchdog_ms =
+      config_get_int(*config, CONFIG_DEFAULT_SECTION, TASK_WATCHDOG_MS_KEY, 0);
+  settings.task_watchdog_queue_depth = config_get_int(
+      *config, CONFIG_DEFAULT_SECTION, TASK_WATCHDOG_QUEUE_DEPTH_KEY, 0);
+}
+
+void load_thread_profiles() {
+  for (const auto& entry : THREAD_PROFILE_KEYS) {
+    const std::string* text =
+        config_get_string(*config, CONFIG_DEFAULT_SECTION, entry.key, NULL);
+    if (text == NULL) continue;
+    bluetooth::common::ThreadProfile profile;
+    if (!bluetooth::common::ParseThreadProfile(*text, &profile)) {
+      LOG_ERROR("%s ignoring malformed %s=%s", __func__, entry.key,
+                text->c_str());
+      continue;
+    }
+    LOG_INFO("%s %s=%s", __func__, entry.key, text->c_str());
+    bluetooth::common::SetThreadProfile(entry.role, profile);
+  }
+}
 }  // namespace
 
 // Module lifecycle functions
@@ -56,10 +123,14 @@ static future_t* init() {
     config = config_new_empty();
   }
 
+  load_settings();
+  load_thread_profiles();
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
 static future_t* clean_up() {
+  bluetooth::common::ResetThreadProfiles();
+  settings = {};
   config.reset();
   return future_new_immediate(FUTURE_SUCCESS);
 }
@@ -74,28 +145,21 @@ EXPORT_SYMBOL extern const module_t stack_config_module = {
 
 // Interface functions
 static bool get_trace_config_enabled(void) {
-  return config_get_bool(*config, CONFIG_DEFAULT_SECTION,
-                         TRACE_CONFIG_ENABLED_KEY, false);
+  return settings.trace_config_enabled;
 }
 
-static bool get_pts_avrcp_test(void) {
-  return config_get_bool(*config, CONFIG_DEFAULT_SECTION, PTS_AVRCP_TEST,
-                         false);
-}
+static bool get_pts_avrcp_test(void) { return settings.pts_avrcp_test; }
 
 static bool get_pts_secure_only_mode(void) {
-  return config_get_bool(*config, CONFIG_DEFAULT_SECTION, PTS_SECURE_ONLY_MODE,
-                         false);
+  return settings.pts_secure_only_mode;
 }
 
 static bool get_pts_conn_updates_disabled(void) {
-  return config_get_bool(*config, CONFIG_DEFAULT_SECTION,
-                         PTS_LE_CONN_UPDATED_DISABLED, false);
+  return settings.pts_conn_updates_disabled;
 }
 
 static bool get_pts_crosskey_sdp_disable(void) {
-  return config_get_bool(*config, CONFIG_DEFAULT_SECTION,
-                         PTS_DISABLE_SDP_LE_PAIR, false);
+  return settings.pts_crosskey_sdp_disable;
 }
 
 static const std::string* get_pts_smp_options(void) {
@@ -104,16 +168,27 @@ static const std::string* get_pts_smp_options(void) {
 }
 
 static int get_pts_smp_failure_case(void) {
-  return config_get_int(*config, CONFIG_DEFAULT_SECTION,
-                        PTS_SMP_FAILURE_CASE_KEY, 0);
+  return settings.pts_smp_failure_case;
 }
 
 static config_t* get_all(void) { return config.get(); }
 
+static bool get_task_statistics_enabled(void) {
+  return settings.task_statistics_enabled;
+}
+
+static int get_task_watchdog_ms(void) { return settings.task_watchdog_ms; }
+
+static int get_task_watchdog_queue_depth(void) {
+  return settings.task_watchdog_queue_depth;
+}
+
 const stack_config_t interface = {
     get_trace_config_enabled,     get_pts_avrcp_test,
     get_pts_secure_only_mode,     get_pts_conn_updates_disabled,
     get_pts_crosskey_sdp_disable, get_pts_smp_options,
-    get_pts_smp_failure_case,     get_all};
+    get_pts_smp_failure_case,     get_all,
+    get_task_statistics_enabled,  get_task_watchdog_ms,
+    get_task_watchdog_queue_depth};
 
 const stack_config_t* stack_config_get_interface(void) { return &interface; }
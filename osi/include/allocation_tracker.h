@@ -57,3 +57,18 @@ void* allocation_tracker_notify_free(allocator_id_t allocator_id, void* ptr);
 // Get the full size for an allocation, taking into account the size of
 // canaries.
 size_t allocation_tracker_resize_for_canary(size_t size);
+
+// Start sampling the allocations notified to the tracker, once per
+// |sample_interval| octets allocated on average, and attributing them to
+// their call stacks. An interval of 1 samples every allocation. Discards the
+// profile of a previous start. Works whether or not the tracker is
+// initialized.
+void allocation_tracker_profile_start(size_t sample_interval);
+
+// Stop sampling the allocations and discard the profile.
+void allocation_tracker_profile_stop(void);
+
+// Write the profile to |fd| in the legacy heap profile format read by pprof,
+// followed by the memory mappings of the process to symbolize it. Writes
+// nothing if the profiler is not started.
+void allocation_tracker_profile_dump(int fd);
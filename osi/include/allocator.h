@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -41,12 +42,30 @@ void* osi_malloc(size_t size);
 void* osi_calloc(size_t size);
 void osi_free(void* ptr);
 
+typedef struct slab_pool_t slab_pool_t;
+
+// Returns a buffer of |size| bytes from |pool| (see
+// osi/include/slab_allocator.h), or from the heap like |osi_malloc| when the
+// pool cannot serve it. The buffer is released with |osi_free|, which hands
+// it back to |pool|.
+void* osi_malloc_from_pool(slab_pool_t* pool, size_t size);
+
+// Creates and frees a pool for |osi_malloc_from_pool| holding |capacity|
+// buffers of |size| bytes.
+slab_pool_t* osi_pool_new(size_t size, size_t capacity);
+void osi_pool_free(slab_pool_t* pool);
+
 // Free a buffer that was previously allocated with function |osi_malloc|
 // or |osi_calloc| and reset the pointer to that buffer to NULL.
 // |p_ptr| is a pointer to the buffer pointer to be reset.
 // |p_ptr| cannot be NULL.
 void osi_free_and_reset(void** p_ptr);
 
+// Enables or disables recycling of small buffers through the per-size-class
+// caches of the slab allocator backend (see osi/include/slab_allocator.h).
+// Can be toggled at any time; disabled by default.
+void osi_allocator_enable_slab(bool enable);
+
 // Dump allocation-related statistics and debug info to the |fd| file
 // descriptor.
 // The information is in user-readable text format. The |fd| must be valid.
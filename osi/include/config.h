@@ -20,11 +20,95 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 // The default section name to use if a key/value pair is not defined within
 // a section.
 #define CONFIG_DEFAULT_SECTION "Global"
 
+// A list of |T| kept in insertion order, which is also indexed by the string
+// member |Key| so that elements are found in constant time. Elements must not
+// have their |Key| changed once inserted.
+template <typename T, std::string T::*Key>
+class indexed_list_t {
+ public:
+  using iterator = typename std::list<T>::iterator;
+  using const_iterator = typename std::list<T>::const_iterator;
+
+  indexed_list_t() = default;
+  indexed_list_t(const indexed_list_t& other) : list_(other.list_) {
+    Reindex();
+  }
+  // Moving a std::list keeps its iterators valid, and so the index
+  indexed_list_t(indexed_list_t&& other) = default;
+  indexed_list_t& operator=(const indexed_list_t& other) {
+    if (this != &other) {
+      list_ = other.list_;
+      Reindex();
+    }
+    return *this;
+  }
+  indexed_list_t& operator=(indexed_list_t&& other) = default;
+
+  iterator begin() { return list_.begin(); }
+  iterator end() { return list_.end(); }
+  const_iterator begin() const { return list_.begin(); }
+  const_iterator end() const { return list_.end(); }
+  size_t size() const { return list_.size(); }
+  bool empty() const { return list_.empty(); }
+
+  // Returns the first element whose |Key| is |key|, or end()
+  iterator find(const std::string& key) {
+    auto index_it = index_.find(key);
+    return index_it == index_.end() ? list_.end() : index_it->second;
+  }
+  const_iterator find(const std::string& key) const {
+    auto index_it = index_.find(key);
+    return index_it == index_.end() ? list_.end() : index_it->second;
+  }
+
+  T& emplace_back(T&& value) {
+    list_.emplace_back(std::move(value));
+    index_.emplace(list_.back().*Key, std::prev(list_.end()));
+    return list_.back();
+  }
+
+  iterator erase(iterator it) {
+    auto index_it = index_.find((*it).*Key);
+    bool indexed = index_it != index_.end() && index_it->second == it;
+    std::string key = (*it).*Key;
+    iterator next = list_.erase(it);
+    if (indexed) {
+      index_.erase(index_it);
+      // Duplicate keys are only possible through direct loading, keep the
+      // next one with the same key reachable
+      for (auto dup = list_.begin(); dup != list_.end(); ++dup) {
+        if ((*dup).*Key == key) {
+          index_.emplace(key, dup);
+          break;
+        }
+      }
+    }
+    return next;
+  }
+
+  void clear() {
+    list_.clear();
+    index_.clear();
+  }
+
+ private:
+  void Reindex() {
+    index_.clear();
+    for (auto it = list_.begin(); it != list_.end(); ++it) {
+      index_.emplace((*it).*Key, it);
+    }
+  }
+
+  std::list<T> list_;
+  std::unordered_map<std::string, iterator> index_;
+};
+
 struct entry_t {
   std::string key;
   std::string value;
@@ -32,14 +116,14 @@ struct entry_t {
 
 struct section_t {
   std::string name;
-  std::list<entry_t> entries;
+  indexed_list_t<entry_t, &entry_t::key> entries;
   void Set(std::string key, std::string value);
   std::list<entry_t>::iterator Find(const std::string& key);
   bool Has(const std::string& key);
 };
 
 struct config_t {
-  std::list<section_t> sections;
+  indexed_list_t<section_t, &section_t::name> sections;
   std::list<section_t>::iterator Find(const std::string& section);
   bool Has(const std::string& section);
 };
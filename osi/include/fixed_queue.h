@@ -36,6 +36,17 @@ typedef void (*fixed_queue_cb)(fixed_queue_t* queue, void* context);
 // the returned queue with |fixed_queue_free|.
 fixed_queue_t* fixed_queue_new(size_t capacity);
 
+// Creates a new lock-free fixed queue with the given |capacity|, which must
+// be between 1 and 65536. The queue is backed by a ring buffer and none of
+// its operations take a lock or a semaphore, which makes it suitable for hot
+// paths with one consumer and one or a bounded set of producers. The dequeue
+// file descriptor is only signalled on the empty to non-empty transition.
+// |fixed_queue_try_peek_last|, |fixed_queue_try_remove_from_queue|,
+// |fixed_queue_get_list| and |fixed_queue_get_enqueue_fd| are not supported
+// on such queues. Returns NULL on failure. The caller must free the returned
+// queue with |fixed_queue_free|.
+fixed_queue_t* fixed_queue_new_lock_free(size_t capacity);
+
 // Frees a queue and (optionally) the enqueued elements.
 // |queue| is the queue to free. If the |free_cb| callback is not null,
 // it is called on each queue element to free it.
@@ -18,10 +18,18 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct ringbuffer_t ringbuffer_t;
 
+// A contiguous part of the ringbuffer. Free or used space is described by up
+// to two spans, the second one starting where the buffer wraps around.
+typedef struct {
+  uint8_t* data;
+  size_t length;
+} ringbuffer_span_t;
+
 // NOTE:
 // None of the functions below are thread safe when it comes to accessing the
 // *rb pointer. It is *NOT* possible to insert and pop/delete at the same time.
@@ -32,6 +40,13 @@ typedef struct ringbuffer_t ringbuffer_t;
 // using |ringbuffer_free|.
 ringbuffer_t* ringbuffer_init(const size_t size);
 
+// Create a ringbuffer of at least the specified size, rounded up to a page,
+// whose buffer is mapped twice in a row: free or used space is then always
+// described by a single span. Falls back to |ringbuffer_init| where such a
+// mapping is not supported. Resulting pointer must be freed using
+// |ringbuffer_free|.
+ringbuffer_t* ringbuffer_init_mirrored(const size_t size);
+
 // Frees the ringbuffer structure and buffer
 // Save to call with NULL.
 void ringbuffer_free(ringbuffer_t* rb);
@@ -60,3 +75,19 @@ size_t ringbuffer_pop(ringbuffer_t* rb, uint8_t* p, size_t length);
 // Deletes |length| bytes from the ringbuffer starting from the head
 // Return actual number of bytes deleted.
 size_t ringbuffer_delete(ringbuffer_t* rb, size_t length);
+
+// Fills |spans| with the free space for up to |length| bytes, to be written
+// in place, and returns the number of spans filled, up to two. The bytes are
+// only added to the buffer by |ringbuffer_commit|.
+size_t ringbuffer_reserve(ringbuffer_t* rb, size_t length,
+                          ringbuffer_span_t spans[2]);
+
+// Adds the first |length| bytes of the space last reserved to the buffer.
+// |length| must not be more than the space reserved.
+void ringbuffer_commit(ringbuffer_t* rb, size_t length);
+
+// Fills |spans| with up to |length| bytes of data from the head, to be read
+// in place, and returns the number of spans filled, up to two. The bytes are
+// only consumed by |ringbuffer_delete|.
+size_t ringbuffer_peek_spans(const ringbuffer_t* rb, size_t length,
+                             ringbuffer_span_t spans[2]);
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Backend used by |osi_malloc| and friends. Every block carries a small
+// header that records the size class it was carved for, so blocks can be
+// released regardless of whether the slab cache was enabled at the time they
+// were allocated.
+//
+// When enabled, blocks whose size fits one of the size classes (tuned to HCI
+// ACL and L2CAP MTU sized BT_HDR buffers) are recycled through a per-thread
+// cache backed by a global per-class freelist instead of going back to the
+// system heap. Larger blocks always use the system heap.
+
+typedef struct {
+  size_t block_size;   // Usable size of the blocks in this class
+  size_t allocations;  // Number of allocations served by this class
+  size_t hits;         // Allocations served from a cache or freelist
+  size_t in_use;       // Blocks currently handed out
+  size_t high_water;   // Maximum value |in_use| has ever reached
+  size_t cached;       // Blocks held in the global freelist
+} slab_allocator_stats_t;
+
+// Enables or disables recycling of blocks through the size class caches.
+// Safe to call at any time; blocks allocated before the change are released
+// correctly.
+void slab_allocator_set_enabled(bool enabled);
+bool slab_allocator_is_enabled(void);
+
+// Returns a block of at least |size| bytes, aborting on allocation failure.
+// If |zero| is true the first |size| bytes of the block are zeroed.
+void* slab_allocator_alloc(size_t size, bool zero);
+
+// Releases a block returned by |slab_allocator_alloc|. Safe to call with NULL.
+void slab_allocator_free(void* ptr);
+
+// Returns all blocks held in the calling thread's cache and the global
+// freelists to the system heap. Statistics are not reset.
+void slab_allocator_trim(void);
+
+// Returns the number of size classes.
+size_t slab_allocator_size_class_count(void);
+
+// Fills |stats| with the statistics of size class |class_index|, which must
+// be less than |slab_allocator_size_class_count|. |stats| cannot be NULL.
+void slab_allocator_get_stats(size_t class_index,
+                              slab_allocator_stats_t* stats);
+
+// A fixed capacity pool of |block_size| blocks, all allocated up front.
+// Blocks handed out by a pool are released with |slab_allocator_free| (and so
+// |osi_free|) like any other block, from any thread, and go back to the pool
+// they came from.
+typedef struct slab_pool_t slab_pool_t;
+
+// Creates a pool of |capacity| blocks of |block_size| usable bytes.
+slab_pool_t* slab_pool_new(size_t block_size, size_t capacity);
+
+// Releases |pool|. Blocks still handed out return to the system heap when
+// they are released. Safe to call with NULL.
+void slab_pool_free(slab_pool_t* pool);
+
+// Returns a block of at least |size| bytes from |pool|. Falls back to
+// |slab_allocator_alloc| when |size| exceeds the pool block size or the pool
+// is exhausted. |pool| cannot be NULL.
+void* slab_pool_alloc(slab_pool_t* pool, size_t size);
+
+// Fills |stats| with the statistics of |pool|. |hits| counts the allocations
+// served by the pool itself. Neither |pool| nor |stats| can be NULL.
+void slab_pool_get_stats(slab_pool_t* pool, slab_allocator_stats_t* stats);
+
+// Dump slab allocator statistics to the |fd| file descriptor.
+void slab_allocator_debug_dump(int fd);
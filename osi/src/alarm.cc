@@ -36,11 +36,12 @@
 
 #include <hardware/bluetooth.h>
 
+#include <algorithm>
 #include <mutex>
+#include <vector>
 
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
-#include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/semaphore.h"
@@ -74,6 +75,12 @@ typedef struct {
   stat_t premature_scheduling;
 } alarm_stats_t;
 
+// Intrusive list of alarms sharing a slot of the timer wheel.
+typedef struct {
+  alarm_t* first;
+  alarm_t* last;
+} alarm_slot_t;
+
 /* Wrapper around CancellableClosure that let it be embedded in structs, without
  * need to define copy operator. */
 struct CancelableClosureInStruct {
@@ -105,8 +112,41 @@ struct alarm_t {
 
   bool for_msg_loop;  // True, if the alarm should be processed on message loop
   CancelableClosureInStruct closure;  // posted to message loop for processing
+
+  // The wheel slot (or the expired list) this alarm is linked into, or NULL
+  // if the alarm is not pending.
+  alarm_slot_t* slot;
+  alarm_t* slot_prev;
+  alarm_t* slot_next;
+  uint8_t slot_level;
+  uint8_t slot_index;
 };
 
+// Pending alarms are kept in a hierarchical timer wheel with millisecond
+// resolution, so that setting and cancelling an alarm costs O(1) regardless
+// of how many alarms are pending. Level |n| has ALARM_WHEEL_SLOTS slots of
+// 2^(n * ALARM_WHEEL_LEVEL_BITS) ms each; an alarm is filed in the lowest
+// level whose span covers its distance from |now_ms|, and is moved down a
+// level ("cascaded") when the wheel reaches the start of its slot. Alarms
+// that are due are moved to |expired|, in deadline order, until dispatched.
+static const int ALARM_WHEEL_LEVEL_BITS = 6;
+static const int ALARM_WHEEL_LEVELS = 6;
+static const int ALARM_WHEEL_SLOTS = 1 << ALARM_WHEEL_LEVEL_BITS;
+static const uint64_t ALARM_WHEEL_SLOT_MASK = ALARM_WHEEL_SLOTS - 1;
+// Deadlines further away than this (about 795 days) are filed at the far end
+// of the top level, and re-filed when that slot cascades.
+static const uint64_t ALARM_WHEEL_RANGE_MS =
+    1ULL << (ALARM_WHEEL_LEVELS * ALARM_WHEEL_LEVEL_BITS);
+
+typedef struct {
+  uint64_t now_ms;       // The first millisecond not yet processed
+  uint64_t earliest_ms;  // Earliest pending deadline, UINT64_MAX if none
+  size_t count;          // Number of pending alarms, including expired ones
+  uint64_t occupied[ALARM_WHEEL_LEVELS];  // Bitmaps of the non-empty slots
+  alarm_slot_t slots[ALARM_WHEEL_LEVELS][ALARM_WHEEL_SLOTS];
+  alarm_slot_t expired;
+} alarm_wheel_t;
+
 // If the next wakeup time is less than this threshold, we should acquire
 // a wakelock instead of setting a wake alarm so we're not bouncing in
 // and out of suspend frequently. This value is externally visible to allow
@@ -116,9 +156,9 @@ static const clockid_t CLOCK_ID = CLOCK_BOOTTIME;
 
 // This mutex ensures that the |alarm_set|, |alarm_cancel|, and alarm callback
 // functions execute serially and not concurrently. As a result, this mutex
-// also protects the |alarms| list.
+// also protects the |alarms| wheel.
 static std::mutex alarms_mutex;
-static list_t* alarms;
+static alarm_wheel_t* alarms;
 static timer_t timer;
 static timer_t wakeup_timer;
 static bool timer_set;
@@ -142,6 +182,10 @@ static void alarm_cancel_internal(alarm_t* alarm);
 static void remove_pending_alarm(alarm_t* alarm);
 static void schedule_next_instance(alarm_t* alarm);
 static void reschedule_root_alarm(void);
+static void wheel_insert(alarm_t* alarm);
+static void wheel_remove(alarm_t* alarm);
+static void wheel_advance(uint64_t time_ms);
+static uint64_t wheel_earliest_deadline(void);
 static void alarm_queue_ready(fixed_queue_t* queue, void* context);
 static void timer_callback(void* data);
 static void callback_dispatch(void* context);
@@ -166,7 +210,7 @@ alarm_t* alarm_new_periodic(const char* name) {
 }
 
 static alarm_t* alarm_new_internal(const char* name, bool is_periodic) {
-  // Make sure we have a list we can insert alarms into.
+  // Make sure we have a wheel we can insert alarms into.
   if (!alarms && !lazy_initialize()) {
     CHECK(false);  // if initialization failed, we should not continue
     return NULL;
@@ -261,7 +305,7 @@ void alarm_cancel(alarm_t* alarm) {
 // The caller must hold the |alarms_mutex|
 static void alarm_cancel_internal(alarm_t* alarm) {
   bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+      alarm->slot != NULL && alarm->deadline_ms == alarms->earliest_ms;
 
   remove_pending_alarm(alarm);
 
@@ -301,7 +345,25 @@ void alarm_cleanup(void) {
   semaphore_free(alarm_expired);
   alarm_expired = NULL;
 
-  list_free(alarms);
+  // Detach the alarms that are still pending, so they don't reference the
+  // freed wheel if they are set again after a later initialization.
+  for (int level = 0; level <= ALARM_WHEEL_LEVELS; level++) {
+    int num_slots = (level < ALARM_WHEEL_LEVELS) ? ALARM_WHEEL_SLOTS : 1;
+    for (int index = 0; index < num_slots; index++) {
+      alarm_slot_t* slot = (level < ALARM_WHEEL_LEVELS)
+                               ? &alarms->slots[level][index]
+                               : &alarms->expired;
+      for (alarm_t* alarm = slot->first; alarm != NULL;) {
+        alarm_t* next = alarm->slot_next;
+        alarm->slot = NULL;
+        alarm->slot_prev = NULL;
+        alarm->slot_next = NULL;
+        alarm = next;
+      }
+    }
+  }
+
+  osi_free(alarms);
   alarms = NULL;
 }
 
@@ -315,11 +377,12 @@ static bool lazy_initialize(void) {
 
   std::lock_guard<std::mutex> lock(alarms_mutex);
 
-  alarms = list_new(NULL);
+  alarms = static_cast<alarm_wheel_t*>(osi_calloc(sizeof(alarm_wheel_t)));
   if (!alarms) {
-    LOG_ERROR("%s unable to allocate alarm list.", __func__);
+    LOG_ERROR("%s unable to allocate alarm wheel.", __func__);
     goto error;
   }
+  alarms->earliest_ms = UINT64_MAX;
 
   if (!timer_create_internal(CLOCK_ID, &timer)) goto error;
   timer_initialized = true;
@@ -380,7 +443,7 @@ error:
 
   if (timer_initialized) timer_delete(timer);
 
-  list_free(alarms);
+  osi_free(alarms);
   alarms = NULL;
 
   return false;
@@ -398,10 +461,10 @@ static uint64_t now_ms(void) {
   return (ts.tv_sec * 1000LL) + (ts.tv_nsec / 1000000LL);
 }
 
-// Remove alarm from internal alarm list and the processing queue
+// Remove alarm from internal alarm wheel and the processing queue
 // The caller must hold the |alarms_mutex|
 static void remove_pending_alarm(alarm_t* alarm) {
-  list_remove(alarms, alarm);
+  if (alarm->slot != NULL) wheel_remove(alarm);
 
   if (alarm->for_msg_loop) {
     alarm->closure.i.Cancel();
@@ -416,10 +479,10 @@ static void remove_pending_alarm(alarm_t* alarm) {
 
 // Must be called with |alarms_mutex| held
 static void schedule_next_instance(alarm_t* alarm) {
-  // If the alarm is currently set and it's at the start of the list,
+  // If the alarm is currently set and it has the earliest deadline,
   // we'll need to re-schedule since we've adjusted the earliest deadline.
   bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+      alarm->slot != NULL && alarm->deadline_ms == alarms->earliest_ms;
   if (alarm->callback) remove_pending_alarm(alarm);
 
   // Calculate the next deadline for this alarm
@@ -430,28 +493,186 @@ static void schedule_next_instance(alarm_t* alarm) {
         ((just_now_ms - alarm->creation_time_ms) % alarm->period_ms);
   alarm->deadline_ms = just_now_ms + (alarm->period_ms - ms_into_period);
 
-  // Add it into the timer list sorted by deadline (earliest deadline first).
-  if (list_is_empty(alarms) ||
-      ((alarm_t*)list_front(alarms))->deadline_ms > alarm->deadline_ms) {
-    list_prepend(alarms, alarm);
-  } else {
-    for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-         node = list_next(node)) {
-      list_node_t* next = list_next(node);
-      if (next == list_end(alarms) ||
-          ((alarm_t*)list_node(next))->deadline_ms > alarm->deadline_ms) {
-        list_insert_after(alarms, node, alarm);
-        break;
-      }
-    }
+  // An empty wheel can skip ahead, so that the alarm is filed relative to
+  // the current time rather than to the last time the wheel advanced.
+  bool wheel_empty = true;
+  for (int level = 0; level < ALARM_WHEEL_LEVELS; level++) {
+    if (alarms->occupied[level] != 0) wheel_empty = false;
   }
+  if (wheel_empty && alarms->now_ms < just_now_ms) alarms->now_ms = just_now_ms;
+
+  wheel_insert(alarm);
+  alarms->count++;
 
   // If the new alarm has the earliest deadline, we need to re-evaluate our
   // schedule.
-  if (needs_reschedule ||
-      (!list_is_empty(alarms) && list_front(alarms) == alarm)) {
-    reschedule_root_alarm();
+  if (alarm->deadline_ms < alarms->earliest_ms) {
+    alarms->earliest_ms = alarm->deadline_ms;
+    needs_reschedule = true;
   }
+  if (needs_reschedule) reschedule_root_alarm();
+}
+
+static inline void slot_append(alarm_slot_t* slot, alarm_t* alarm) {
+  alarm->slot = slot;
+  alarm->slot_prev = slot->last;
+  alarm->slot_next = NULL;
+  if (slot->last != NULL)
+    slot->last->slot_next = alarm;
+  else
+    slot->first = alarm;
+  slot->last = alarm;
+}
+
+// Files |alarm| into the wheel slot for its deadline. Alarms whose deadline
+// the wheel has already processed go straight to the expired list.
+// NOTE: must be called with |alarms_mutex| held
+static void wheel_insert(alarm_t* alarm) {
+  if (alarm->deadline_ms < alarms->now_ms) {
+    slot_append(&alarms->expired, alarm);
+    return;
+  }
+
+  uint64_t expires = alarm->deadline_ms;
+  uint64_t delta = expires - alarms->now_ms;
+  if (delta >= ALARM_WHEEL_RANGE_MS) {
+    delta = ALARM_WHEEL_RANGE_MS - 1;
+    expires = alarms->now_ms + delta;
+  }
+
+  int level = 0;
+  while ((delta >> (ALARM_WHEEL_LEVEL_BITS * (level + 1))) != 0) level++;
+  int index = (expires >> (ALARM_WHEEL_LEVEL_BITS * level)) &
+              ALARM_WHEEL_SLOT_MASK;
+
+  slot_append(&alarms->slots[level][index], alarm);
+  alarm->slot_level = level;
+  alarm->slot_index = index;
+  alarms->occupied[level] |= 1ULL << index;
+}
+
+// Unlinks |alarm| from its wheel slot or from the expired list.
+// NOTE: must be called with |alarms_mutex| held
+static void wheel_remove(alarm_t* alarm) {
+  alarm_slot_t* slot = alarm->slot;
+  if (alarm->slot_prev != NULL)
+    alarm->slot_prev->slot_next = alarm->slot_next;
+  else
+    slot->first = alarm->slot_next;
+  if (alarm->slot_next != NULL)
+    alarm->slot_next->slot_prev = alarm->slot_prev;
+  else
+    slot->last = alarm->slot_prev;
+  alarm->slot = NULL;
+  alarm->slot_prev = NULL;
+  alarm->slot_next = NULL;
+
+  if (slot != &alarms->expired && slot->first == NULL)
+    alarms->occupied[alarm->slot_level] &= ~(1ULL << alarm->slot_index);
+
+  alarms->count--;
+  if (alarm->deadline_ms == alarms->earliest_ms)
+    alarms->earliest_ms = wheel_earliest_deadline();
+}
+
+// Returns the first millisecond at or after |now_ms| at which slot |index|
+// of |level| is processed.
+static uint64_t wheel_slot_time(int level, int index) {
+  int shift = ALARM_WHEEL_LEVEL_BITS * level;
+  uint64_t span = 1ULL << (shift + ALARM_WHEEL_LEVEL_BITS);
+  uint64_t time_ms =
+      (alarms->now_ms & ~(span - 1)) + ((uint64_t)index << shift);
+  if (time_ms < alarms->now_ms) time_ms += span;
+  return time_ms;
+}
+
+// Returns the non-empty slot of |level| that is processed first, or -1 if
+// the level is empty.
+static int wheel_first_slot(int level) {
+  uint64_t occupied = alarms->occupied[level];
+  if (occupied == 0) return -1;
+
+  // The slot holding |now_ms| was already processed in this rotation, unless
+  // |now_ms| is exactly at its start.
+  int shift = ALARM_WHEEL_LEVEL_BITS * level;
+  int start = ((alarms->now_ms + (1ULL << shift) - 1) >> shift) &
+              ALARM_WHEEL_SLOT_MASK;
+  uint64_t rotated = occupied >> start;
+  if (start != 0) rotated |= occupied << (ALARM_WHEEL_SLOTS - start);
+  return (start + __builtin_ctzll(rotated)) & ALARM_WHEEL_SLOT_MASK;
+}
+
+// Returns the earliest deadline of all pending alarms, UINT64_MAX if none.
+// Only the first non-empty slot of each level needs to be scanned, since the
+// alarms of any later slot are due after all of the alarms in it.
+static uint64_t wheel_earliest_deadline(void) {
+  uint64_t earliest_ms = UINT64_MAX;
+  for (alarm_t* alarm = alarms->expired.first; alarm != NULL;
+       alarm = alarm->slot_next) {
+    earliest_ms = std::min(earliest_ms, alarm->deadline_ms);
+  }
+
+  for (int level = 0; level < ALARM_WHEEL_LEVELS; level++) {
+    int index = wheel_first_slot(level);
+    if (index < 0) continue;
+    // No alarm in the slot is due before the slot is processed.
+    if (wheel_slot_time(level, index) >= earliest_ms) continue;
+    for (alarm_t* alarm = alarms->slots[level][index].first; alarm != NULL;
+         alarm = alarm->slot_next) {
+      earliest_ms = std::min(earliest_ms, alarm->deadline_ms);
+    }
+  }
+  return earliest_ms;
+}
+
+// Processes the wheel up to and including |time_ms|: the upper level slots
+// reached are cascaded, and the alarms that are due are appended to the
+// expired list. Empty stretches of the wheel are skipped over.
+// NOTE: must be called with |alarms_mutex| held
+static void wheel_advance(uint64_t time_ms) {
+  while (true) {
+    uint64_t next_ms = UINT64_MAX;
+    for (int level = 0; level < ALARM_WHEEL_LEVELS; level++) {
+      int index = wheel_first_slot(level);
+      if (index < 0) continue;
+      next_ms = std::min(next_ms, wheel_slot_time(level, index));
+    }
+    if (next_ms > time_ms) break;
+
+    alarms->now_ms = next_ms;
+    for (int level = 1; level < ALARM_WHEEL_LEVELS; level++) {
+      int shift = ALARM_WHEEL_LEVEL_BITS * level;
+      if ((next_ms & ((1ULL << shift) - 1)) != 0) break;
+
+      int index = (next_ms >> shift) & ALARM_WHEEL_SLOT_MASK;
+      alarm_slot_t* slot = &alarms->slots[level][index];
+      alarm_t* alarm = slot->first;
+      slot->first = NULL;
+      slot->last = NULL;
+      alarms->occupied[level] &= ~(1ULL << index);
+      while (alarm != NULL) {
+        alarm_t* next = alarm->slot_next;
+        wheel_insert(alarm);
+        alarm = next;
+      }
+    }
+
+    int index = next_ms & ALARM_WHEEL_SLOT_MASK;
+    alarm_slot_t* slot = &alarms->slots[0][index];
+    alarm_t* alarm = slot->first;
+    slot->first = NULL;
+    slot->last = NULL;
+    alarms->occupied[0] &= ~(1ULL << index);
+    while (alarm != NULL) {
+      alarm_t* next = alarm->slot_next;
+      slot_append(&alarms->expired, alarm);
+      alarm = next;
+    }
+
+    alarms->now_ms = next_ms + 1;
+  }
+
+  if (alarms->now_ms <= time_ms) alarms->now_ms = time_ms + 1;
 }
 
 // NOTE: must be called with |alarms_mutex| held
@@ -459,17 +680,17 @@ static void reschedule_root_alarm(void) {
   CHECK(alarms != NULL);
 
   const bool timer_was_set = timer_set;
-  alarm_t* next;
+  uint64_t next_deadline_ms;
   int64_t next_expiration;
 
   // If used in a zeroed state, disarms the timer.
   struct itimerspec timer_time;
   memset(&timer_time, 0, sizeof(timer_time));
 
-  if (list_is_empty(alarms)) goto done;
+  if (alarms->count == 0) goto done;
 
-  next = static_cast<alarm_t*>(list_front(alarms));
-  next_expiration = next->deadline_ms - now_ms();
+  next_deadline_ms = alarms->earliest_ms;
+  next_expiration = next_deadline_ms - now_ms();
   if (next_expiration < TIMER_INTERVAL_FOR_WAKELOCK_IN_MS) {
     if (!timer_set) {
       if (!wakelock_acquire()) {
@@ -478,8 +699,8 @@ static void reschedule_root_alarm(void) {
       }
     }
 
-    timer_time.it_value.tv_sec = (next->deadline_ms / 1000);
-    timer_time.it_value.tv_nsec = (next->deadline_ms % 1000) * 1000000LL;
+    timer_time.it_value.tv_sec = (next_deadline_ms / 1000);
+    timer_time.it_value.tv_nsec = (next_deadline_ms % 1000) * 1000000LL;
 
     // It is entirely unsafe to call timer_settime(2) with a zeroed timerspec
     // for timers with *_ALARM clock IDs. Although the man page states that the
@@ -504,8 +725,8 @@ static void reschedule_root_alarm(void) {
     struct itimerspec wakeup_time;
     memset(&wakeup_time, 0, sizeof(wakeup_time));
 
-    wakeup_time.it_value.tv_sec = (next->deadline_ms / 1000);
-    wakeup_time.it_value.tv_nsec = (next->deadline_ms % 1000) * 1000000LL;
+    wakeup_time.it_value.tv_sec = (next_deadline_ms / 1000);
+    wakeup_time.it_value.tv_nsec = (next_deadline_ms % 1000) * 1000000LL;
     if (timer_settime(wakeup_timer, TIMER_ABSTIME, &wakeup_time, NULL) == -1)
       LOG_ERROR("%s unable to set wakeup timer: %s", __func__, strerror(errno));
   }
@@ -624,19 +845,18 @@ static void callback_dispatch(UNUSED_ATTR void* context) {
     if (!dispatcher_thread_active) break;
 
     std::lock_guard<std::mutex> lock(alarms_mutex);
-    alarm_t* alarm;
+    wheel_advance(now_ms());
 
     // Take into account that the alarm may get cancelled before we get to it.
-    // We're done here if there are no alarms or the alarm at the front is in
-    // the future. Exit right away since there's nothing left to do.
-    if (list_is_empty(alarms) ||
-        (alarm = static_cast<alarm_t*>(list_front(alarms)))->deadline_ms >
-            now_ms()) {
+    // We're done here if no alarm has expired. Exit right away since there's
+    // nothing left to do.
+    alarm_t* alarm = alarms->expired.first;
+    if (alarm == NULL) {
       reschedule_root_alarm();
       continue;
     }
 
-    list_remove(alarms, alarm);
+    wheel_remove(alarm);
 
     if (alarm->is_periodic) {
       alarm->prev_deadline_ms = alarm->deadline_ms;
@@ -736,12 +956,30 @@ void alarm_debug_dump(int fd) {
 
   uint64_t just_now_ms = now_ms();
 
-  dprintf(fd, "  Total Alarms: %zu\n\n", list_length(alarms));
+  dprintf(fd, "  Total Alarms: %zu\n\n", alarms->count);
+
+  // Collect the pending alarms, and dump them in deadline order
+  std::vector<alarm_t*> pending;
+  pending.reserve(alarms->count);
+  for (alarm_t* alarm = alarms->expired.first; alarm != NULL;
+       alarm = alarm->slot_next) {
+    pending.push_back(alarm);
+  }
+  for (int level = 0; level < ALARM_WHEEL_LEVELS; level++) {
+    for (int index = 0; index < ALARM_WHEEL_SLOTS; index++) {
+      for (alarm_t* alarm = alarms->slots[level][index].first; alarm != NULL;
+           alarm = alarm->slot_next) {
+        pending.push_back(alarm);
+      }
+    }
+  }
+  std::stable_sort(pending.begin(), pending.end(),
+                   [](const alarm_t* a, const alarm_t* b) {
+                     return a->deadline_ms < b->deadline_ms;
+                   });
 
   // Dump info for each alarm
-  for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-       node = list_next(node)) {
-    alarm_t* alarm = (alarm_t*)list_node(node);
+  for (alarm_t* alarm : pending) {
     alarm_stats_t* stats = &alarm->stats;
 
     dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
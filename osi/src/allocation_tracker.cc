@@ -21,14 +21,26 @@
 #include "osi/include/allocation_tracker.h"
 
 #include <base/logging.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <unwind.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <mutex>
+#include <random>
 #include <unordered_map>
+#include <vector>
 
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/slab_allocator.h"
 
 typedef struct {
   uint8_t allocator_id;
@@ -49,6 +61,37 @@ static size_t free_counter = 0;
 static size_t alloc_total_size = 0;
 static size_t free_total_size = 0;
 
+// Sampling allocation profiler
+static const size_t profile_max_frames = 32;
+// Frames of the profiler and of the tracker on top of the captured stacks
+static const size_t profile_skipped_frames = 2;
+static const size_t profile_dump_top_sites = 10;
+
+typedef struct {
+  // Sampled allocations, and those of them that are not freed yet
+  size_t alloc_count;
+  size_t alloc_size;
+  size_t in_use_count;
+  size_t in_use_size;
+  // Allocations the samples stand for, unbiased for their size
+  double estimated_alloc_count;
+  double estimated_alloc_size;
+} profile_site_t;
+
+typedef struct {
+  profile_site_t* site;
+  size_t size;
+} profile_sample_t;
+
+// Average number of bytes allocated between samples, 0 when not profiling
+static std::atomic<size_t> profile_interval(0);
+// Bumped by each start, so that the threads draw a new sampling point
+static std::atomic<unsigned> profile_generation(0);
+static std::mutex profile_lock;
+static std::map<std::vector<uintptr_t>, profile_site_t> profile_sites;
+static std::unordered_map<void*, profile_sample_t> profile_samples;
+static std::chrono::steady_clock::time_point profile_start_time;
+
 void allocation_tracker_init(void) {
   std::unique_lock<std::mutex> lock(tracker_lock);
   if (enabled) return;
@@ -96,8 +139,8 @@ size_t allocation_tracker_expect_no_allocations(void) {
   return unfreed_memory_size;
 }
 
-void* allocation_tracker_notify_alloc(uint8_t allocator_id, void* ptr,
-                                      size_t requested_size) {
+static void* track_alloc(uint8_t allocator_id, void* ptr,
+                         size_t requested_size) {
   char* return_ptr;
   {
     std::unique_lock<std::mutex> lock(tracker_lock);
@@ -132,8 +175,7 @@ void* allocation_tracker_notify_alloc(uint8_t allocator_id, void* ptr,
   return return_ptr;
 }
 
-void* allocation_tracker_notify_free(UNUSED_ATTR uint8_t allocator_id,
-                                     void* ptr) {
+static void* track_free(UNUSED_ATTR uint8_t allocator_id, void* ptr) {
   std::unique_lock<std::mutex> lock(tracker_lock);
 
   if (!enabled || !ptr) return ptr;
@@ -169,6 +211,184 @@ void* allocation_tracker_notify_free(UNUSED_ATTR uint8_t allocator_id,
   return ((char*)ptr) - canary_size;
 }
 
+// Draws the number of bytes to allocate until the next sample, exponentially
+// distributed so that each byte allocated is sampled with the same odds
+static int64_t profile_next_sample(size_t interval) {
+  if (interval == 1) return 1;
+  static thread_local std::minstd_rand generator(osi_rand());
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  return (int64_t)(-log(1.0 - uniform(generator)) * interval) + 1;
+}
+
+static bool profile_should_sample(size_t size) {
+  size_t interval = profile_interval.load(std::memory_order_relaxed);
+  if (interval == 0) return false;
+
+  static thread_local unsigned generation = 0;
+  static thread_local int64_t bytes_until_sample = 0;
+  unsigned current = profile_generation.load(std::memory_order_relaxed);
+  if (generation != current) {
+    generation = current;
+    bytes_until_sample = profile_next_sample(interval);
+  }
+
+  bytes_until_sample -= size;
+  if (bytes_until_sample > 0) return false;
+  bytes_until_sample = profile_next_sample(interval);
+  return true;
+}
+
+static _Unwind_Reason_Code profile_unwind_frame(struct _Unwind_Context* context,
+                                                void* arg) {
+  std::vector<uintptr_t>* frames = static_cast<std::vector<uintptr_t>*>(arg);
+  uintptr_t pc = _Unwind_GetIP(context);
+  if (pc != 0) frames->push_back(pc);
+  return frames->size() < profile_skipped_frames + profile_max_frames
+             ? _URC_NO_REASON
+             : _URC_END_OF_STACK;
+}
+
+// Not inlined, so that the frames to skip are the same in all the builds
+__attribute__((noinline)) static void profile_record_alloc(void* ptr,
+                                                           size_t size) {
+  std::vector<uintptr_t> frames;
+  frames.reserve(profile_skipped_frames + profile_max_frames);
+  _Unwind_Backtrace(profile_unwind_frame, &frames);
+  size_t skipped = std::min(profile_skipped_frames, frames.size());
+  frames.erase(frames.begin(), frames.begin() + skipped);
+
+  std::unique_lock<std::mutex> lock(profile_lock);
+  size_t interval = profile_interval.load();
+  if (interval == 0) return;
+
+  // A sampled allocation of |size| bytes stands for 1 / P(sampled)
+  // allocations of that size
+  double weight = 1.0 / -expm1(-(double)size / interval);
+  profile_site_t& site = profile_sites[frames];
+  site.alloc_count++;
+  site.alloc_size += size;
+  site.in_use_count++;
+  site.in_use_size += size;
+  site.estimated_alloc_count += weight;
+  site.estimated_alloc_size += weight * size;
+  profile_samples[ptr] = {&site, size};
+}
+
+static void profile_record_free(void* ptr) {
+  std::unique_lock<std::mutex> lock(profile_lock);
+  auto sample = profile_samples.find(ptr);
+  if (sample == profile_samples.end()) return;
+  sample->second.site->in_use_count--;
+  sample->second.site->in_use_size -= sample->second.size;
+  profile_samples.erase(sample);
+}
+
+void* allocation_tracker_notify_alloc(uint8_t allocator_id, void* ptr,
+                                      size_t requested_size) {
+  void* return_ptr = track_alloc(allocator_id, ptr, requested_size);
+  if (return_ptr && profile_should_sample(requested_size)) {
+    profile_record_alloc(return_ptr, requested_size);
+  }
+  return return_ptr;
+}
+
+void* allocation_tracker_notify_free(uint8_t allocator_id, void* ptr) {
+  if (ptr && profile_interval.load(std::memory_order_relaxed) != 0) {
+    profile_record_free(ptr);
+  }
+  return track_free(allocator_id, ptr);
+}
+
+void allocation_tracker_profile_start(size_t sample_interval) {
+  CHECK(sample_interval > 0);
+  std::unique_lock<std::mutex> lock(profile_lock);
+  profile_sites.clear();
+  profile_samples.clear();
+  profile_start_time = std::chrono::steady_clock::now();
+  profile_generation++;
+  profile_interval = sample_interval;
+}
+
+void allocation_tracker_profile_stop(void) {
+  std::unique_lock<std::mutex> lock(profile_lock);
+  profile_interval = 0;
+  profile_sites.clear();
+  profile_samples.clear();
+}
+
+void allocation_tracker_profile_dump(int fd) {
+  std::unique_lock<std::mutex> lock(profile_lock);
+  size_t interval = profile_interval.load();
+  if (interval == 0) return;
+
+  profile_site_t total = {};
+  for (const auto& entry : profile_sites) {
+    total.alloc_count += entry.second.alloc_count;
+    total.alloc_size += entry.second.alloc_size;
+    total.in_use_count += entry.second.in_use_count;
+    total.in_use_size += entry.second.in_use_size;
+  }
+
+  // Legacy heap profile format of gperftools, which pprof reads and unsamples
+  // with the interval of the header
+  dprintf(fd, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n",
+          total.in_use_count, total.in_use_size, total.alloc_count,
+          total.alloc_size, interval);
+  for (const auto& entry : profile_sites) {
+    dprintf(fd, "%zu: %zu [%zu: %zu] @", entry.second.in_use_count,
+            entry.second.in_use_size, entry.second.alloc_count,
+            entry.second.alloc_size);
+    for (uintptr_t frame : entry.first) dprintf(fd, " 0x%" PRIxPTR, frame);
+    dprintf(fd, "\n");
+  }
+
+  // The mappings let pprof symbolize the addresses
+  dprintf(fd, "\nMAPPED_LIBRARIES:\n");
+  int maps_fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+  if (maps_fd == -1) return;
+  char buffer[4096];
+  ssize_t length;
+  while ((length = read(maps_fd, buffer, sizeof(buffer))) > 0) {
+    if (write(fd, buffer, length) != length) break;
+  }
+  close(maps_fd);
+}
+
+// Lists the call sites that allocate the most, with their allocation rates
+static void profile_debug_dump(int fd) {
+  std::unique_lock<std::mutex> lock(profile_lock);
+  size_t interval = profile_interval.load();
+  if (interval == 0) return;
+
+  std::vector<std::pair<const std::vector<uintptr_t>*, const profile_site_t*>>
+      sites;
+  for (const auto& entry : profile_sites) {
+    sites.emplace_back(&entry.first, &entry.second);
+  }
+  std::sort(sites.begin(), sites.end(), [](const auto& a, const auto& b) {
+    return a.second->estimated_alloc_size > b.second->estimated_alloc_size;
+  });
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - profile_start_time)
+                       .count();
+  if (seconds <= 0) return;
+
+  dprintf(fd, "  Allocation profile: 1 sample per %zu octets, %zu sites\n",
+          interval, sites.size());
+  dprintf(fd, "    allocs/s   octets/s  in use (sampled)  call stack\n");
+  for (size_t i = 0; i < sites.size() && i < profile_dump_top_sites; i++) {
+    const profile_site_t* site = sites[i].second;
+    dprintf(fd, "  %10.1f %10.0f %17zu ", site->estimated_alloc_count / seconds,
+            site->estimated_alloc_size / seconds, site->in_use_size);
+    // The first frame is the allocator called by the site
+    for (size_t f = 1; f < sites[i].first->size() && f < 5; f++) {
+      dprintf(fd, " 0x%" PRIxPTR, (*sites[i].first)[f]);
+    }
+    dprintf(fd, "\n");
+  }
+}
+
 size_t allocation_tracker_resize_for_canary(size_t size) {
   return (!enabled) ? size : size + (2 * canary_size);
 }
@@ -176,11 +396,16 @@ size_t allocation_tracker_resize_for_canary(size_t size) {
 void osi_allocator_debug_dump(int fd) {
   dprintf(fd, "\nBluetooth Memory Allocation Statistics:\n");
 
-  std::unique_lock<std::mutex> lock(tracker_lock);
+  {
+    std::unique_lock<std::mutex> lock(tracker_lock);
+
+    dprintf(fd, "  Total allocated/free/used counts : %zu / %zu / %zu\n",
+            alloc_counter, free_counter, alloc_counter - free_counter);
+    dprintf(fd, "  Total allocated/free/used octets : %zu / %zu / %zu\n",
+            alloc_total_size, free_total_size,
+            alloc_total_size - free_total_size);
+  }
 
-  dprintf(fd, "  Total allocated/free/used counts : %zu / %zu / %zu\n",
-          alloc_counter, free_counter, alloc_counter - free_counter);
-  dprintf(fd, "  Total allocated/free/used octets : %zu / %zu / %zu\n",
-          alloc_total_size, free_total_size,
-          alloc_total_size - free_total_size);
+  profile_debug_dump(fd);
+  slab_allocator_debug_dump(fd);
 }
@@ -21,14 +21,14 @@
 
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/allocator.h"
+#include "osi/include/slab_allocator.h"
 
 static const allocator_id_t alloc_allocator_id = 42;
 
 char* osi_strdup(const char* str) {
   size_t size = strlen(str) + 1;  // + 1 for the null terminator
   size_t real_size = allocation_tracker_resize_for_canary(size);
-  void* ptr = malloc(real_size);
-  CHECK(ptr);
+  void* ptr = slab_allocator_alloc(real_size, false);
 
   char* new_string = static_cast<char*>(
       allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size));
@@ -43,8 +43,7 @@ char* osi_strndup(const char* str, size_t len) {
   if (len < size) size = len;
 
   size_t real_size = allocation_tracker_resize_for_canary(size + 1);
-  void* ptr = malloc(real_size);
-  CHECK(ptr);
+  void* ptr = slab_allocator_alloc(real_size, false);
 
   char* new_string = static_cast<char*>(
       allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size + 1));
@@ -57,20 +56,34 @@ char* osi_strndup(const char* str, size_t len) {
 
 void* osi_malloc(size_t size) {
   size_t real_size = allocation_tracker_resize_for_canary(size);
-  void* ptr = malloc(real_size);
-  CHECK(ptr);
+  void* ptr = slab_allocator_alloc(real_size, false);
   return allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size);
 }
 
 void* osi_calloc(size_t size) {
   size_t real_size = allocation_tracker_resize_for_canary(size);
-  void* ptr = calloc(1, real_size);
-  CHECK(ptr);
+  void* ptr = slab_allocator_alloc(real_size, true);
   return allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size);
 }
 
 void osi_free(void* ptr) {
-  free(allocation_tracker_notify_free(alloc_allocator_id, ptr));
+  slab_allocator_free(allocation_tracker_notify_free(alloc_allocator_id, ptr));
+}
+
+void* osi_malloc_from_pool(slab_pool_t* pool, size_t size) {
+  size_t real_size = allocation_tracker_resize_for_canary(size);
+  void* ptr = slab_pool_alloc(pool, real_size);
+  return allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size);
+}
+
+slab_pool_t* osi_pool_new(size_t size, size_t capacity) {
+  return slab_pool_new(allocation_tracker_resize_for_canary(size), capacity);
+}
+
+void osi_pool_free(slab_pool_t* pool) { slab_pool_free(pool); }
+
+void osi_allocator_enable_slab(bool enable) {
+  slab_allocator_set_enabled(enable);
 }
 
 void osi_free_and_reset(void** p_ptr) {
@@ -35,11 +35,10 @@
 #include <type_traits>
 
 void section_t::Set(std::string key, std::string value) {
-  for (entry_t& entry : entries) {
-    if (entry.key == key) {
-      entry.value = value;
-      return;
-    }
+  auto entry = entries.find(key);
+  if (entry != entries.end()) {
+    entry->value = std::move(value);
+    return;
   }
   // add a new key to the section
   entries.emplace_back(
@@ -47,9 +46,7 @@ void section_t::Set(std::string key, std::string value) {
 }
 
 std::list<entry_t>::iterator section_t::Find(const std::string& key) {
-  return std::find_if(
-      entries.begin(), entries.end(),
-      [&key](const entry_t& entry) { return entry.key == key; });
+  return entries.find(key);
 }
 
 bool section_t::Has(const std::string& key) {
@@ -57,24 +54,20 @@ bool section_t::Has(const std::string& key) {
 }
 
 std::list<section_t>::iterator config_t::Find(const std::string& section) {
-  return std::find_if(
-      sections.begin(), sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return sections.find(section);
 }
 
 bool config_t::Has(const std::string& key) {
   return Find(key) != sections.end();
 }
 
-static bool config_parse(FILE* fp, config_t* config);
+static bool config_parse(char* contents, config_t* config);
 
 template <typename T,
           class = typename std::enable_if<std::is_same<
               config_t, typename std::remove_const<T>::type>::value>>
 static auto section_find(T& config, const std::string& section) {
-  return std::find_if(
-      config.sections.begin(), config.sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return config.sections.find(section);
 }
 
 static const entry_t* entry_find(const config_t& config,
@@ -83,11 +76,10 @@ static const entry_t* entry_find(const config_t& config,
   auto sec = section_find(config, section);
   if (sec == config.sections.end()) return nullptr;
 
-  for (const entry_t& entry : sec->entries) {
-    if (entry.key == key) return &entry;
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return nullptr;
 
-  return nullptr;
+  return &*entry;
 }
 
 std::unique_ptr<config_t> config_new_empty(void) {
@@ -97,20 +89,19 @@ std::unique_ptr<config_t> config_new_empty(void) {
 std::unique_ptr<config_t> config_new(const char* filename) {
   CHECK(filename != nullptr);
 
-  std::unique_ptr<config_t> config = config_new_empty();
-
-  FILE* fp = fopen(filename, "rt");
-  if (!fp) {
-    LOG(ERROR) << __func__ << ": unable to open file '" << filename
+  // Read the whole file at once and parse it in place, rather than issuing a
+  // read for every line
+  std::string contents;
+  if (!base::ReadFileToString(base::FilePath(filename), &contents)) {
+    LOG(ERROR) << __func__ << ": unable to read file '" << filename
                << "': " << strerror(errno);
     return nullptr;
   }
 
-  if (!config_parse(fp, config.get())) {
+  std::unique_ptr<config_t> config = config_new_empty();
+  if (!config_parse(&contents[0], config.get())) {
     config.reset();
   }
-
-  fclose(fp);
   return config;
 }
 
@@ -223,11 +214,10 @@ void config_set_string(config_t* config, const std::string& section,
     value_no_newline = value;
   }
 
-  for (entry_t& entry : sec->entries) {
-    if (entry.key == key) {
-      entry.value = value_no_newline;
-      return;
-    }
+  auto entry = sec->entries.find(key);
+  if (entry != sec->entries.end()) {
+    entry->value = value_no_newline;
+    return;
   }
 
   sec->entries.emplace_back(entry_t{.key = key, .value = value_no_newline});
@@ -249,15 +239,11 @@ bool config_remove_key(config_t* config, const std::string& section,
   auto sec = section_find(*config, section);
   if (sec == config->sections.end()) return false;
 
-  for (auto entry = sec->entries.begin(); entry != sec->entries.end();
-       ++entry) {
-    if (entry->key == key) {
-      sec->entries.erase(entry);
-      return true;
-    }
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return false;
 
-  return false;
+  sec->entries.erase(entry);
+  return true;
 }
 
 bool config_save(const config_t& config, const std::string& filename) {
@@ -488,16 +474,27 @@ static char* trim(char* str) {
   return str;
 }
 
-static bool config_parse(FILE* fp, config_t* config) {
-  CHECK(fp != nullptr);
+static bool config_parse(char* contents, config_t* config) {
+  CHECK(contents != nullptr);
   CHECK(config != nullptr);
 
   int line_num = 0;
-  char line[1024];
-  char section[1024];
-  strcpy(section, CONFIG_DEFAULT_SECTION);
+  std::string section = CONFIG_DEFAULT_SECTION;
+  // Keys of a section are consecutive in the file, so keep the section found
+  // for the last key instead of looking it up again for each one
+  section_t* current = nullptr;
+
+  char* next_line = contents;
+  while (*next_line != '\0') {
+    char* line = next_line;
+    char* line_end = strchr(line, '\n');
+    if (line_end) {
+      *line_end = '\0';
+      next_line = line_end + 1;
+    } else {
+      next_line = line + strlen(line);
+    }
 
-  while (fgets(line, sizeof(line), fp)) {
     char* line_ptr = trim(line);
     ++line_num;
 
@@ -511,8 +508,8 @@ static bool config_parse(FILE* fp, config_t* config) {
                 << line_num;
         return false;
       }
-      strncpy(section, line_ptr + 1, len - 2);  // NOLINT (len < 1024)
-      section[len - 2] = '\0';
+      section.assign(line_ptr + 1, len - 2);
+      current = nullptr;
     } else {
       char* split = strchr(line_ptr, '=');
       if (!split) {
@@ -522,7 +519,15 @@ static bool config_parse(FILE* fp, config_t* config) {
       }
 
       *split = '\0';
-      config_set_string(config, section, trim(line_ptr), trim(split + 1));
+      if (!current) {
+        auto sec = section_find(*config, section);
+        if (sec == config->sections.end()) {
+          current = &config->sections.emplace_back(section_t{.name = section});
+        } else {
+          current = &*sec;
+        }
+      }
+      current->Set(trim(line_ptr), trim(split + 1));
     }
   }
   return true;
@@ -17,18 +17,61 @@
  ******************************************************************************/
 
 #include <base/logging.h>
+#include <errno.h>
+#include <poll.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
+#include <atomic>
 #include <mutex>
 
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/list.h"
+#include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
 
+// Largest capacity supported by lock-free queues.
+static const size_t LOCK_FREE_MAX_CAPACITY = 1 << 16;
+
+typedef struct {
+  std::atomic<size_t> sequence;
+  void* data;
+} ring_cell_t;
+
+// Bounded multi-producer multi-consumer ring buffer. Each cell carries a
+// sequence number telling producers and consumers whose turn it is to use
+// the cell, so neither side ever takes a lock.
+typedef struct {
+  ring_cell_t* cells;
+  size_t mask;
+
+  alignas(64) std::atomic<size_t> enqueue_pos;
+  alignas(64) std::atomic<size_t> dequeue_pos;
+
+  // Number of elements reserved by producers, used to enforce the capacity.
+  std::atomic<size_t> reserved;
+  // Number of elements published to consumers. May briefly go negative when
+  // a consumer picks up an element before its producer accounted for it.
+  std::atomic<ssize_t> length;
+  // Number of producers blocked in |fixed_queue_enqueue|.
+  std::atomic<size_t> enqueue_waiters;
+
+  // Readable while the queue is non-empty. Only written on the empty to
+  // non-empty transition and only drained on the reverse transition.
+  int dequeue_fd;
+  // Signalled for blocked producers whenever an element is removed.
+  int enqueue_fd;
+} ring_queue_t;
+
 typedef struct fixed_queue_t {
+  // Non-NULL for queues created with |fixed_queue_new_lock_free|, in which
+  // case |list|, the semaphores and |mutex| are not used.
+  ring_queue_t* ring;
+
   list_t* list;
   semaphore_t* enqueue_sem;
   semaphore_t* dequeue_sem;
@@ -42,6 +85,13 @@ typedef struct fixed_queue_t {
 
 static void internal_dequeue_ready(void* context);
 
+static ring_queue_t* ring_new(size_t capacity);
+static void ring_free(ring_queue_t* ring);
+static bool ring_try_enqueue(fixed_queue_t* queue, void* data);
+static void* ring_try_dequeue(fixed_queue_t* queue);
+static void ring_wait_for_data(ring_queue_t* ring);
+static void ring_wait_for_space(fixed_queue_t* queue);
+
 fixed_queue_t* fixed_queue_new(size_t capacity) {
   fixed_queue_t* ret =
       static_cast<fixed_queue_t*>(osi_calloc(sizeof(fixed_queue_t)));
@@ -65,11 +115,40 @@ error:
   return NULL;
 }
 
+fixed_queue_t* fixed_queue_new_lock_free(size_t capacity) {
+  if (capacity == 0 || capacity > LOCK_FREE_MAX_CAPACITY) {
+    LOG_ERROR("%s unsupported capacity %zu", __func__, capacity);
+    return NULL;
+  }
+
+  fixed_queue_t* ret =
+      static_cast<fixed_queue_t*>(osi_calloc(sizeof(fixed_queue_t)));
+
+  ret->capacity = capacity;
+  ret->ring = ring_new(capacity);
+  if (!ret->ring) {
+    osi_free(ret);
+    return NULL;
+  }
+
+  return ret;
+}
+
 void fixed_queue_free(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
   if (!queue) return;
 
   fixed_queue_unregister_dequeue(queue);
 
+  if (queue->ring) {
+    void* data;
+    while ((data = ring_try_dequeue(queue)) != NULL) {
+      if (free_cb) free_cb(data);
+    }
+    ring_free(queue->ring);
+    osi_free(queue);
+    return;
+  }
+
   if (free_cb)
     for (const list_node_t* node = list_begin(queue->list);
          node != list_end(queue->list); node = list_next(node))
@@ -96,6 +175,8 @@ void fixed_queue_flush(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
 bool fixed_queue_is_empty(fixed_queue_t* queue) {
   if (queue == NULL) return true;
 
+  if (queue->ring) return queue->ring->length.load() <= 0;
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list);
 }
@@ -103,6 +184,11 @@ bool fixed_queue_is_empty(fixed_queue_t* queue) {
 size_t fixed_queue_length(fixed_queue_t* queue) {
   if (queue == NULL) return 0;
 
+  if (queue->ring) {
+    ssize_t length = queue->ring->length.load();
+    return length > 0 ? length : 0;
+  }
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_length(queue->list);
 }
@@ -117,6 +203,11 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) {
+    while (!ring_try_enqueue(queue, data)) ring_wait_for_space(queue);
+    return;
+  }
+
   semaphore_wait(queue->enqueue_sem);
 
   {
@@ -130,6 +221,14 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_dequeue(fixed_queue_t* queue) {
   CHECK(queue != NULL);
 
+  if (queue->ring) {
+    void* ret;
+    while ((ret = ring_try_dequeue(queue)) == NULL) {
+      ring_wait_for_data(queue->ring);
+    }
+    return ret;
+  }
+
   semaphore_wait(queue->dequeue_sem);
 
   void* ret = NULL;
@@ -148,6 +247,8 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) return ring_try_enqueue(queue, data);
+
   if (!semaphore_try_wait(queue->enqueue_sem)) return false;
 
   {
@@ -162,6 +263,8 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) return ring_try_dequeue(queue);
+
   if (!semaphore_try_wait(queue->dequeue_sem)) return NULL;
 
   void* ret = NULL;
@@ -179,6 +282,14 @@ void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
 void* fixed_queue_try_peek_first(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) {
+    ring_queue_t* ring = queue->ring;
+    size_t pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+    ring_cell_t* cell = &ring->cells[pos & ring->mask];
+    if (cell->sequence.load(std::memory_order_acquire) != pos + 1) return NULL;
+    return cell->data;
+  }
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_front(queue->list);
 }
@@ -186,6 +297,8 @@ void* fixed_queue_try_peek_first(fixed_queue_t* queue) {
 void* fixed_queue_try_peek_last(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  CHECK(queue->ring == NULL) << "not supported by lock-free queues";
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_back(queue->list);
 }
@@ -193,6 +306,8 @@ void* fixed_queue_try_peek_last(fixed_queue_t* queue) {
 void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
   if (queue == NULL) return NULL;
 
+  CHECK(queue->ring == NULL) << "not supported by lock-free queues";
+
   bool removed = false;
   {
     std::lock_guard<std::mutex> lock(*queue->mutex);
@@ -212,6 +327,7 @@ void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
 
 list_t* fixed_queue_get_list(fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  CHECK(queue->ring == NULL) << "not supported by lock-free queues";
 
   // NOTE: Using the list in this way is not thread-safe.
   // Using this list in any context where threads can call other functions
@@ -221,11 +337,13 @@ list_t* fixed_queue_get_list(fixed_queue_t* queue) {
 
 int fixed_queue_get_dequeue_fd(const fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  if (queue->ring) return queue->ring->dequeue_fd;
   return semaphore_get_fd(queue->dequeue_sem);
 }
 
 int fixed_queue_get_enqueue_fd(const fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  CHECK(queue->ring == NULL) << "not supported by lock-free queues";
   return semaphore_get_fd(queue->enqueue_sem);
 }
 
@@ -260,3 +378,143 @@ static void internal_dequeue_ready(void* context) {
   fixed_queue_t* queue = static_cast<fixed_queue_t*>(context);
   queue->dequeue_ready(queue, queue->dequeue_context);
 }
+
+static ring_queue_t* ring_new(size_t capacity) {
+  size_t cell_count = 1;
+  while (cell_count < capacity) cell_count <<= 1;
+
+  ring_queue_t* ring = new ring_queue_t();
+  ring->cells = new ring_cell_t[cell_count];
+  for (size_t i = 0; i < cell_count; i++) {
+    ring->cells[i].sequence.store(i, std::memory_order_relaxed);
+    ring->cells[i].data = NULL;
+  }
+  ring->mask = cell_count - 1;
+
+  ring->dequeue_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  ring->enqueue_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC | EFD_SEMAPHORE);
+  if (ring->dequeue_fd == INVALID_FD || ring->enqueue_fd == INVALID_FD) {
+    LOG_ERROR("%s unable to create eventfd: %s", __func__, strerror(errno));
+    ring_free(ring);
+    return NULL;
+  }
+
+  return ring;
+}
+
+static void ring_free(ring_queue_t* ring) {
+  if (ring->dequeue_fd != INVALID_FD) close(ring->dequeue_fd);
+  if (ring->enqueue_fd != INVALID_FD) close(ring->enqueue_fd);
+  delete[] ring->cells;
+  delete ring;
+}
+
+static void ring_signal(int fd) {
+  if (eventfd_write(fd, 1ULL) == -1)
+    LOG_ERROR("%s unable to signal eventfd: %s", __func__, strerror(errno));
+}
+
+static void ring_drain(int fd) {
+  eventfd_t value;
+  eventfd_read(fd, &value);
+}
+
+static void ring_wait_readable(int fd) {
+  struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+  int ret;
+  OSI_NO_INTR(ret = poll(&pfd, 1, -1));
+  if (ret == -1)
+    LOG_ERROR("%s unable to poll eventfd: %s", __func__, strerror(errno));
+}
+
+static bool ring_try_enqueue(fixed_queue_t* queue, void* data) {
+  ring_queue_t* ring = queue->ring;
+
+  // Reserve room first so that the ring itself can never overflow.
+  size_t reserved = ring->reserved.load(std::memory_order_relaxed);
+  do {
+    if (reserved >= queue->capacity) return false;
+  } while (!ring->reserved.compare_exchange_weak(reserved, reserved + 1));
+
+  size_t pos = ring->enqueue_pos.load(std::memory_order_relaxed);
+  ring_cell_t* cell;
+  for (;;) {
+    cell = &ring->cells[pos & ring->mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+    if (diff == 0) {
+      if (ring->enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed))
+        break;
+    } else {
+      // Either another producer claimed the cell, or a consumer has not
+      // finished releasing it yet. The reservation guarantees the latter is
+      // transient.
+      pos = ring->enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->data = data;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+
+  if (ring->length.fetch_add(1) == 0) ring_signal(ring->dequeue_fd);
+  return true;
+}
+
+static void* ring_try_dequeue(fixed_queue_t* queue) {
+  ring_queue_t* ring = queue->ring;
+
+  size_t pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+  ring_cell_t* cell;
+  for (;;) {
+    cell = &ring->cells[pos & ring->mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (ring->dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      // Empty. Make sure a stale signal doesn't leave the fd readable.
+      if (ring->length.load() <= 0) {
+        ring_drain(ring->dequeue_fd);
+        if (ring->length.load() > 0) ring_signal(ring->dequeue_fd);
+      }
+      return NULL;
+    } else {
+      pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  void* data = cell->data;
+  cell->sequence.store(pos + ring->mask + 1, std::memory_order_release);
+
+  if (ring->length.fetch_sub(1) <= 1) {
+    // Possibly became empty: drain, then re-check to avoid losing a wakeup
+    // from a producer racing with us.
+    ring_drain(ring->dequeue_fd);
+    if (ring->length.load() > 0) ring_signal(ring->dequeue_fd);
+  }
+
+  ring->reserved.fetch_sub(1);
+  if (ring->enqueue_waiters.load() > 0) ring_signal(ring->enqueue_fd);
+
+  return data;
+}
+
+static void ring_wait_for_data(ring_queue_t* ring) {
+  ring_wait_readable(ring->dequeue_fd);
+}
+
+static void ring_wait_for_space(fixed_queue_t* queue) {
+  ring_queue_t* ring = queue->ring;
+
+  ring->enqueue_waiters.fetch_add(1);
+  // Re-check after announcing ourselves so a consumer that freed space in
+  // the meantime can't be missed.
+  if (ring->reserved.load() >= queue->capacity) {
+    ring_wait_readable(ring->enqueue_fd);
+    ring_drain(ring->enqueue_fd);
+  }
+  ring->enqueue_waiters.fetch_sub(1);
+}
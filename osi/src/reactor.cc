@@ -29,10 +29,10 @@
 #include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <mutex>
 
 #include "osi/include/allocator.h"
-#include "osi/include/list.h"
 #include "osi/include/log.h"
 
 #if !defined(EFD_SEMAPHORE)
@@ -42,18 +42,21 @@
 struct reactor_t {
   int epoll_fd;
   int event_fd;
-  std::mutex* list_mutex;
-  list_t* invalidation_list;  // reactor objects that have been unregistered.
-  pthread_t run_thread;       // the pthread on which reactor_run is executing.
-  bool is_running;            // indicates whether |run_thread| is valid.
-  bool object_removed;
+  // Objects that have been unregistered but may still be referenced by the
+  // batch of events the reactor thread is handling. They are linked through
+  // |next_retired| and freed by the reactor thread once that batch is done.
+  std::atomic<reactor_object_t*> retired;
+  pthread_t run_thread;  // the pthread on which reactor_run is executing.
+  bool is_running;       // indicates whether |run_thread| is valid.
 };
 
 struct reactor_object_t {
   int fd;              // the file descriptor to monitor for events.
   void* context;       // a context that's passed back to the *_ready functions.
   reactor_t* reactor;  // the reactor instance this object is registered with.
-  std::mutex* mutex;  // protects the lifetime of this object and all variables.
+  std::mutex* mutex;  // serializes callbacks with changes to this object.
+  bool unregistered;  // set once the callbacks must no longer be called.
+  reactor_object_t* next_retired;  // next object in |reactor->retired|.
 
   void (*read_ready)(void* context);   // function to call when the file
                                        // descriptor becomes readable.
@@ -62,8 +65,11 @@ struct reactor_object_t {
 };
 
 static reactor_status_t run_reactor(reactor_t* reactor, int iterations);
+static void free_retired_objects(reactor_t* reactor);
 
-static const size_t MAX_EVENTS = 64;
+// Threads such as the socket and UIPC ones watch many fds, which tend to become
+// ready together; take them from the kernel in as few calls as possible.
+static const size_t MAX_EVENTS = 256;
 static const eventfd_t EVENT_REACTOR_STOP = 1;
 
 reactor_t* reactor_new(void) {
@@ -85,13 +91,6 @@ reactor_t* reactor_new(void) {
     goto error;
   }
 
-  ret->list_mutex = new std::mutex;
-  ret->invalidation_list = list_new(NULL);
-  if (!ret->invalidation_list) {
-    LOG_ERROR("%s unable to allocate object invalidation list.", __func__);
-    goto error;
-  }
-
   struct epoll_event event;
   memset(&event, 0, sizeof(event));
   event.events = EPOLLIN;
@@ -112,7 +111,7 @@ error:;
 void reactor_free(reactor_t* reactor) {
   if (!reactor) return;
 
-  list_free(reactor->invalidation_list);
+  free_retired_objects(reactor);
   close(reactor->event_fd);
   close(reactor->epoll_fd);
   osi_free(reactor);
@@ -203,27 +202,35 @@ void reactor_unregister(reactor_object_t* obj) {
 
   if (reactor->is_running &&
       pthread_equal(pthread_self(), reactor->run_thread)) {
-    reactor->object_removed = true;
-    return;
+    // Called from a callback, so no other callback can be running and the
+    // object lock may already be held by the reactor thread.
+    obj->unregistered = true;
+  } else {
+    // Taking the object lock here makes sure a callback for |obj| isn't
+    // currently executing. Once the flag is set, the reactor thread will not
+    // call into |obj| again even if it is still in the batch being handled.
+    std::lock_guard<std::mutex> lock(*obj->mutex);
+    obj->unregistered = true;
   }
 
-  {
-    std::unique_lock<std::mutex> lock(*reactor->list_mutex);
-    list_append(reactor->invalidation_list, obj);
+  // |obj| is out of the epoll set, so no batch read from now on can contain it.
+  // It is freed once the batch that is being handled, if any, is done with it.
+  obj->next_retired = reactor->retired.load(std::memory_order_relaxed);
+  while (!reactor->retired.compare_exchange_weak(obj->next_retired, obj,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
   }
+}
 
-  // Taking the object lock here makes sure a callback for |obj| isn't
-  // currently executing. The reactor thread must then either be before
-  // the callbacks or after. If after, we know that the object won't be
-  // referenced because it has been taken out of the epoll set. If before,
-  // it won't be referenced because the reactor thread will check the
-  // invalidation_list and find it in there. So by taking this lock, we
-  // are waiting until the reactor thread drops all references to |obj|.
-  // One the wait completes, we can unlock and destroy |obj| safely.
-  obj->mutex->lock();
-  obj->mutex->unlock();
-  delete obj->mutex;
-  osi_free(obj);
+static void free_retired_objects(reactor_t* reactor) {
+  reactor_object_t* obj =
+      reactor->retired.exchange(NULL, std::memory_order_acquire);
+  while (obj) {
+    reactor_object_t* next = obj->next_retired;
+    delete obj->mutex;
+    osi_free(obj);
+    obj = next;
+  }
 }
 
 // Runs the reactor loop for a maximum of |iterations|.
@@ -237,10 +244,8 @@ static reactor_status_t run_reactor(reactor_t* reactor, int iterations) {
 
   struct epoll_event events[MAX_EVENTS];
   for (int i = 0; iterations == 0 || i < iterations; ++i) {
-    {
-      std::lock_guard<std::mutex> lock(*reactor->list_mutex);
-      list_clear(reactor->invalidation_list);
-    }
+    // Nothing from a previous batch is referenced anymore.
+    free_retired_objects(reactor);
 
     int ret;
     OSI_NO_INTR(ret = epoll_wait(reactor->epoll_fd, events, MAX_EVENTS, -1));
@@ -258,37 +263,25 @@ static reactor_status_t run_reactor(reactor_t* reactor, int iterations) {
         eventfd_t value;
         eventfd_read(reactor->event_fd, &value);
         reactor->is_running = false;
+        free_retired_objects(reactor);
         return REACTOR_STATUS_STOP;
       }
 
       reactor_object_t* object = (reactor_object_t*)events[j].data.ptr;
 
-      std::unique_lock<std::mutex> lock(*reactor->list_mutex);
-      if (list_contains(reactor->invalidation_list, object)) {
-        continue;
-      }
+      std::lock_guard<std::mutex> obj_lock(*object->mutex);
+      if (object->unregistered) continue;
 
-      // Downgrade the list lock to an object lock.
-      {
-        std::lock_guard<std::mutex> obj_lock(*object->mutex);
-        lock.unlock();
-
-        reactor->object_removed = false;
-        if (events[j].events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP | EPOLLERR) &&
-            object->read_ready)
-          object->read_ready(object->context);
-        if (!reactor->object_removed && events[j].events & EPOLLOUT &&
-            object->write_ready)
-          object->write_ready(object->context);
-      }
-
-      if (reactor->object_removed) {
-        delete object->mutex;
-        osi_free(object);
-      }
+      if (events[j].events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP | EPOLLERR) &&
+          object->read_ready)
+        object->read_ready(object->context);
+      if (!object->unregistered && events[j].events & EPOLLOUT &&
+          object->write_ready)
+        object->write_ready(object->context);
     }
   }
 
   reactor->is_running = false;
+  free_retired_objects(reactor);
   return REACTOR_STATUS_DONE;
 }
@@ -17,9 +17,18 @@
  ******************************************************************************/
 
 #include <base/logging.h>
+#if defined(__linux__)
+#include <linux/memfd.h>
+#endif
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
 
 #include "osi/include/allocator.h"
+#include "osi/include/osi.h"
 #include "osi/include/ringbuffer.h"
 
 struct ringbuffer_t {
@@ -28,6 +37,7 @@ struct ringbuffer_t {
   uint8_t* base;
   uint8_t* head;
   uint8_t* tail;
+  bool mirrored;  // |base| is mapped again at |base| + |total|
 };
 
 ringbuffer_t* ringbuffer_init(const size_t size) {
@@ -41,8 +51,53 @@ ringbuffer_t* ringbuffer_init(const size_t size) {
   return p;
 }
 
+ringbuffer_t* ringbuffer_init_mirrored(const size_t size) {
+#if defined(__NR_memfd_create)
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t total = std::max((size + page_size - 1) / page_size, (size_t)1) *
+                       page_size;
+
+  int fd = syscall(__NR_memfd_create, "ringbuffer", MFD_CLOEXEC);
+  if (fd == INVALID_FD) return ringbuffer_init(size);
+  if (ftruncate(fd, total) != 0) {
+    close(fd);
+    return ringbuffer_init(size);
+  }
+
+  // Reserve both halves, then map the same pages in each
+  void* base =
+      mmap(NULL, 2 * total, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  bool mapped =
+      base != MAP_FAILED &&
+      mmap(base, total, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+           0) != MAP_FAILED &&
+      mmap(static_cast<uint8_t*>(base) + total, total, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+  close(fd);
+  if (!mapped) {
+    if (base != MAP_FAILED) munmap(base, 2 * total);
+    return ringbuffer_init(size);
+  }
+
+  ringbuffer_t* p =
+      static_cast<ringbuffer_t*>(osi_calloc(sizeof(ringbuffer_t)));
+  p->base = static_cast<uint8_t*>(base);
+  p->head = p->tail = p->base;
+  p->total = p->available = total;
+  p->mirrored = true;
+  return p;
+#else
+  return ringbuffer_init(size);
+#endif
+}
+
 void ringbuffer_free(ringbuffer_t* rb) {
-  if (rb != NULL) osi_free(rb->base);
+  if (rb != NULL) {
+    if (rb->mirrored)
+      munmap(rb->base, 2 * rb->total);
+    else
+      osi_free(rb->base);
+  }
   osi_free(rb);
 }
 
@@ -56,19 +111,58 @@ size_t ringbuffer_size(const ringbuffer_t* rb) {
   return rb->total - rb->available;
 }
 
-size_t ringbuffer_insert(ringbuffer_t* rb, const uint8_t* p, size_t length) {
+// Fills |spans| with the |length| bytes from |start|, in one span if they
+// are contiguous. Returns the number of spans filled.
+static size_t ringbuffer_spans(const ringbuffer_t* rb, uint8_t* start,
+                               size_t length, ringbuffer_span_t spans[2]) {
+  if (length == 0) return 0;
+
+  const size_t contiguous =
+      rb->mirrored
+          ? length
+          : std::min(length, (size_t)(rb->base + rb->total - start));
+  spans[0].data = start;
+  spans[0].length = contiguous;
+  if (contiguous == length) return 1;
+
+  spans[1].data = rb->base;
+  spans[1].length = length - contiguous;
+  return 2;
+}
+
+size_t ringbuffer_reserve(ringbuffer_t* rb, size_t length,
+                          ringbuffer_span_t spans[2]) {
   CHECK(rb);
-  CHECK(p);
+  CHECK(spans);
 
   if (length > ringbuffer_available(rb)) length = ringbuffer_available(rb);
+  return ringbuffer_spans(rb, rb->tail, length, spans);
+}
 
-  for (size_t i = 0; i != length; ++i) {
-    *rb->tail++ = *p++;
-    if (rb->tail >= (rb->base + rb->total)) rb->tail = rb->base;
-  }
+void ringbuffer_commit(ringbuffer_t* rb, size_t length) {
+  CHECK(rb);
+  CHECK(length <= ringbuffer_available(rb));
+
+  rb->tail += length;
+  if (rb->tail >= (rb->base + rb->total)) rb->tail -= rb->total;
 
   rb->available -= length;
-  return length;
+}
+
+size_t ringbuffer_insert(ringbuffer_t* rb, const uint8_t* p, size_t length) {
+  CHECK(rb);
+  CHECK(p);
+
+  ringbuffer_span_t spans[2];
+  const size_t count = ringbuffer_reserve(rb, length, spans);
+  size_t inserted = 0;
+  for (size_t i = 0; i < count; ++i) {
+    memcpy(spans[i].data, p + inserted, spans[i].length);
+    inserted += spans[i].length;
+  }
+
+  ringbuffer_commit(rb, inserted);
+  return inserted;
 }
 
 size_t ringbuffer_delete(ringbuffer_t* rb, size_t length) {
@@ -83,6 +177,15 @@ size_t ringbuffer_delete(ringbuffer_t* rb, size_t length) {
   return length;
 }
 
+size_t ringbuffer_peek_spans(const ringbuffer_t* rb, size_t length,
+                             ringbuffer_span_t spans[2]) {
+  CHECK(rb);
+  CHECK(spans);
+
+  if (length > ringbuffer_size(rb)) length = ringbuffer_size(rb);
+  return ringbuffer_spans(rb, rb->head, length, spans);
+}
+
 size_t ringbuffer_peek(const ringbuffer_t* rb, off_t offset, uint8_t* p,
                        size_t length) {
   CHECK(rb);
@@ -95,12 +198,15 @@ size_t ringbuffer_peek(const ringbuffer_t* rb, off_t offset, uint8_t* p,
                                    ? ringbuffer_size(rb) - offset
                                    : length;
 
-  for (size_t copied = 0; copied < bytes_to_copy; ++copied) {
-    *p++ = *b++;
-    if (b >= (rb->base + rb->total)) b = rb->base;
+  ringbuffer_span_t spans[2];
+  const size_t count = ringbuffer_spans(rb, b, bytes_to_copy, spans);
+  size_t copied = 0;
+  for (size_t i = 0; i < count; ++i) {
+    memcpy(p + copied, spans[i].data, spans[i].length);
+    copied += spans[i].length;
   }
 
-  return bytes_to_copy;
+  return copied;
 }
 
 size_t ringbuffer_pop(ringbuffer_t* rb, uint8_t* p, size_t length) {
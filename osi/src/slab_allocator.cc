@@ -0,0 +1,435 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_slab_allocator"
+
+#include "osi/include/slab_allocator.h"
+
+#include <base/logging.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#include "osi/include/log.h"
+
+// Block sizes are chosen to fit a BT_HDR plus the allocation tracker canaries
+// around the common buffer sizes: HCI events and commands, LE ACL (251 byte
+// payload), BT_SMALL_BUFFER_SIZE, BR/EDR ACL (1021 byte payload), the default
+// L2CAP MTU (1691) and BT_DEFAULT_BUFFER_SIZE.
+static const size_t size_classes[] = {64, 128, 320, 704, 1088, 1792, 4160};
+static const size_t size_class_count =
+    sizeof(size_classes) / sizeof(size_classes[0]);
+static const uint8_t heap_class = 0xff;
+static const uint8_t pool_class = 0xfe;
+
+// Maximum number of blocks per size class kept by each thread, and by the
+// global freelist shared by all threads.
+static const size_t thread_cache_depth = 16;
+static const size_t freelist_depth = 256;
+
+typedef union {
+  struct {
+    uint8_t size_class;
+    slab_pool_t* pool;  // Owner of |pool_class| blocks
+  } info;
+  max_align_t alignment;
+} block_header_t;
+
+// Free blocks are chained through their (unused) payload.
+typedef struct free_block_t {
+  struct free_block_t* next;
+} free_block_t;
+
+typedef struct {
+  std::mutex lock;
+  free_block_t* head;
+  size_t cached;
+
+  std::atomic<size_t> allocations;
+  std::atomic<size_t> hits;
+  std::atomic<size_t> in_use;
+  std::atomic<size_t> high_water;
+} size_class_t;
+
+// Fixed capacity pools hand out preallocated blocks and take them back when
+// they are released, from any thread. The pool is destroyed once its owner
+// released it and every outstanding block came back.
+struct slab_pool_t {
+  std::mutex lock;
+  free_block_t* head;
+  size_t block_size;
+  size_t capacity;
+  size_t cached;
+  bool released;
+  std::atomic<size_t> refs;  // The owner plus the blocks handed out
+
+  std::atomic<size_t> allocations;
+  std::atomic<size_t> hits;
+  std::atomic<size_t> high_water;
+};
+
+static std::atomic<bool> enabled(false);
+
+// Never destroyed so that blocks freed by threads exiting after static
+// destruction are still handled.
+static size_class_t* get_size_classes() {
+  static size_class_t* classes = new size_class_t[size_class_count]();
+  return classes;
+}
+
+static void freelist_push(size_class_t* size_class, free_block_t* first,
+                          free_block_t* last, size_t count);
+
+namespace {
+
+struct thread_cache_t {
+  free_block_t* head[size_class_count] = {};
+  size_t count[size_class_count] = {};
+  bool alive = true;
+
+  ~thread_cache_t() {
+    flush();
+    alive = false;
+  }
+
+  void flush() {
+    for (size_t i = 0; i < size_class_count; i++) flush_class(i, count[i]);
+  }
+
+  // Moves the first |n| blocks of class |i| to the global freelist.
+  void flush_class(size_t i, size_t n) {
+    if (n == 0) return;
+    free_block_t* first = head[i];
+    free_block_t* last = first;
+    for (size_t j = 1; j < n; j++) last = last->next;
+    head[i] = last->next;
+    count[i] -= n;
+    freelist_push(&get_size_classes()[i], first, last, n);
+  }
+};
+
+}  // namespace
+
+static thread_local thread_cache_t thread_cache;
+
+static uint8_t size_class_for(size_t size) {
+  for (size_t i = 0; i < size_class_count; i++) {
+    if (size <= size_classes[i]) return i;
+  }
+  return heap_class;
+}
+
+static void* block_to_payload(block_header_t* header) { return header + 1; }
+
+static block_header_t* payload_to_block(void* ptr) {
+  return static_cast<block_header_t*>(ptr) - 1;
+}
+
+static void freelist_push(size_class_t* size_class, free_block_t* first,
+                          free_block_t* last, size_t count) {
+  {
+    std::lock_guard<std::mutex> lock(size_class->lock);
+    if (size_class->cached + count <= freelist_depth) {
+      last->next = size_class->head;
+      size_class->head = first;
+      size_class->cached += count;
+      return;
+    }
+  }
+
+  // The freelist is full, give the blocks back to the system.
+  last->next = nullptr;
+  while (first) {
+    free_block_t* next = first->next;
+    free(payload_to_block(first));
+    first = next;
+  }
+}
+
+// Moves up to half a thread cache worth of blocks from the global freelist
+// into the calling thread's cache. Returns one of them, or nullptr if the
+// freelist was empty.
+static free_block_t* freelist_refill(uint8_t class_index) {
+  size_class_t* size_class = &get_size_classes()[class_index];
+  std::lock_guard<std::mutex> lock(size_class->lock);
+  free_block_t* block = size_class->head;
+  if (!block) return nullptr;
+
+  size_class->head = block->next;
+  size_class->cached--;
+
+  if (!thread_cache.alive) return block;
+  for (size_t n = 1; n < thread_cache_depth / 2 && size_class->head; n++) {
+    free_block_t* extra = size_class->head;
+    size_class->head = extra->next;
+    size_class->cached--;
+    extra->next = thread_cache.head[class_index];
+    thread_cache.head[class_index] = extra;
+    thread_cache.count[class_index]++;
+  }
+  return block;
+}
+
+static void update_high_water(std::atomic<size_t>* high_water_mark,
+                              size_t in_use) {
+  size_t high_water = high_water_mark->load(std::memory_order_relaxed);
+  while (in_use > high_water &&
+         !high_water_mark->compare_exchange_weak(high_water, in_use,
+                                                 std::memory_order_relaxed)) {
+  }
+}
+
+static void pool_unref(slab_pool_t* pool) {
+  if (pool->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete pool;
+}
+
+static void pool_release_block(block_header_t* header) {
+  slab_pool_t* pool = header->info.pool;
+  bool recycled = false;
+  {
+    std::lock_guard<std::mutex> lock(pool->lock);
+    if (!pool->released) {
+      free_block_t* block =
+          static_cast<free_block_t*>(block_to_payload(header));
+      block->next = pool->head;
+      pool->head = block;
+      pool->cached++;
+      recycled = true;
+    }
+  }
+  if (!recycled) free(header);
+  pool_unref(pool);
+}
+
+void slab_allocator_set_enabled(bool enable) {
+  enabled.store(enable, std::memory_order_relaxed);
+  LOG_INFO("%s slab allocator %s", __func__, enable ? "enabled" : "disabled");
+}
+
+bool slab_allocator_is_enabled(void) {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void* slab_allocator_alloc(size_t size, bool zero) {
+  uint8_t class_index = size_class_for(size);
+  if (class_index == heap_class || !slab_allocator_is_enabled()) {
+    size_t real_size = sizeof(block_header_t) + size;
+    block_header_t* header = static_cast<block_header_t*>(
+        zero ? calloc(1, real_size) : malloc(real_size));
+    CHECK(header);
+    header->info.size_class = heap_class;
+    return block_to_payload(header);
+  }
+
+  size_class_t* size_class = &get_size_classes()[class_index];
+  size_class->allocations.fetch_add(1, std::memory_order_relaxed);
+
+  free_block_t* block = nullptr;
+  if (thread_cache.alive && thread_cache.head[class_index]) {
+    block = thread_cache.head[class_index];
+    thread_cache.head[class_index] = block->next;
+    thread_cache.count[class_index]--;
+  } else {
+    block = freelist_refill(class_index);
+  }
+
+  void* ptr;
+  if (block) {
+    size_class->hits.fetch_add(1, std::memory_order_relaxed);
+    ptr = block;
+  } else {
+    block_header_t* header = static_cast<block_header_t*>(
+        malloc(sizeof(block_header_t) + size_classes[class_index]));
+    CHECK(header);
+    header->info.size_class = class_index;
+    ptr = block_to_payload(header);
+  }
+
+  size_t in_use =
+      size_class->in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+  update_high_water(&size_class->high_water, in_use);
+
+  if (zero) memset(ptr, 0, size);
+  return ptr;
+}
+
+void slab_allocator_free(void* ptr) {
+  if (!ptr) return;
+
+  block_header_t* header = payload_to_block(ptr);
+  if (header->info.size_class == heap_class) {
+    free(header);
+    return;
+  }
+  if (header->info.size_class == pool_class) {
+    pool_release_block(header);
+    return;
+  }
+
+  uint8_t class_index = header->info.size_class;
+  CHECK(class_index < size_class_count);
+  size_class_t* size_class = &get_size_classes()[class_index];
+  size_class->in_use.fetch_sub(1, std::memory_order_relaxed);
+
+  if (!slab_allocator_is_enabled()) {
+    free(header);
+    return;
+  }
+
+  free_block_t* block = static_cast<free_block_t*>(ptr);
+  if (!thread_cache.alive) {
+    freelist_push(size_class, block, block, 1);
+    return;
+  }
+
+  block->next = thread_cache.head[class_index];
+  thread_cache.head[class_index] = block;
+  if (++thread_cache.count[class_index] > thread_cache_depth) {
+    thread_cache.flush_class(class_index, thread_cache_depth / 2);
+  }
+}
+
+void slab_allocator_trim(void) {
+  if (thread_cache.alive) thread_cache.flush();
+
+  for (size_t i = 0; i < size_class_count; i++) {
+    size_class_t* size_class = &get_size_classes()[i];
+    free_block_t* block;
+    {
+      std::lock_guard<std::mutex> lock(size_class->lock);
+      block = size_class->head;
+      size_class->head = nullptr;
+      size_class->cached = 0;
+    }
+    while (block) {
+      free_block_t* next = block->next;
+      free(payload_to_block(block));
+      block = next;
+    }
+  }
+}
+
+slab_pool_t* slab_pool_new(size_t block_size, size_t capacity) {
+  slab_pool_t* pool = new slab_pool_t();
+  pool->block_size = block_size;
+  pool->capacity = capacity;
+  pool->refs = 1;
+  for (size_t i = 0; i < capacity; i++) {
+    block_header_t* header = static_cast<block_header_t*>(
+        malloc(sizeof(block_header_t) + block_size));
+    CHECK(header);
+    header->info.size_class = pool_class;
+    header->info.pool = pool;
+    free_block_t* block = static_cast<free_block_t*>(block_to_payload(header));
+    block->next = pool->head;
+    pool->head = block;
+  }
+  pool->cached = capacity;
+  return pool;
+}
+
+void slab_pool_free(slab_pool_t* pool) {
+  if (!pool) return;
+
+  free_block_t* block;
+  {
+    std::lock_guard<std::mutex> lock(pool->lock);
+    pool->released = true;
+    block = pool->head;
+    pool->head = nullptr;
+    pool->cached = 0;
+  }
+  while (block) {
+    free_block_t* next = block->next;
+    free(payload_to_block(block));
+    block = next;
+  }
+  pool_unref(pool);
+}
+
+void* slab_pool_alloc(slab_pool_t* pool, size_t size) {
+  CHECK(pool != NULL);
+  pool->allocations.fetch_add(1, std::memory_order_relaxed);
+  if (size > pool->block_size) return slab_allocator_alloc(size, false);
+
+  free_block_t* block;
+  size_t in_use;
+  {
+    std::lock_guard<std::mutex> lock(pool->lock);
+    block = pool->head;
+    if (!block) return slab_allocator_alloc(size, false);
+    pool->head = block->next;
+    pool->cached--;
+    in_use = pool->capacity - pool->cached;
+  }
+  pool->refs.fetch_add(1, std::memory_order_relaxed);
+  pool->hits.fetch_add(1, std::memory_order_relaxed);
+  update_high_water(&pool->high_water, in_use);
+  return block;
+}
+
+void slab_pool_get_stats(slab_pool_t* pool, slab_allocator_stats_t* stats) {
+  CHECK(pool != NULL);
+  CHECK(stats != NULL);
+
+  stats->block_size = pool->block_size;
+  stats->allocations = pool->allocations.load(std::memory_order_relaxed);
+  stats->hits = pool->hits.load(std::memory_order_relaxed);
+  stats->high_water = pool->high_water.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(pool->lock);
+  stats->cached = pool->cached;
+  stats->in_use = pool->capacity - pool->cached;
+}
+
+size_t slab_allocator_size_class_count(void) { return size_class_count; }
+
+void slab_allocator_get_stats(size_t class_index,
+                              slab_allocator_stats_t* stats) {
+  CHECK(class_index < size_class_count);
+  CHECK(stats != NULL);
+
+  size_class_t* size_class = &get_size_classes()[class_index];
+  stats->block_size = size_classes[class_index];
+  stats->allocations = size_class->allocations.load(std::memory_order_relaxed);
+  stats->hits = size_class->hits.load(std::memory_order_relaxed);
+  stats->in_use = size_class->in_use.load(std::memory_order_relaxed);
+  stats->high_water = size_class->high_water.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(size_class->lock);
+  stats->cached = size_class->cached;
+}
+
+void slab_allocator_debug_dump(int fd) {
+  dprintf(fd, "\nBluetooth Slab Allocator Statistics: %s\n",
+          slab_allocator_is_enabled() ? "enabled" : "disabled");
+  dprintf(fd, "  %10s %12s %8s %8s %10s %8s\n", "Block size", "Allocations",
+          "Hit %", "In use", "High water", "Cached");
+
+  for (size_t i = 0; i < size_class_count; i++) {
+    slab_allocator_stats_t stats;
+    slab_allocator_get_stats(i, &stats);
+    unsigned hit_rate =
+        stats.allocations ? (unsigned)(stats.hits * 100 / stats.allocations)
+                          : 0;
+    dprintf(fd, "  %10zu %12zu %7u%% %8zu %10zu %8zu\n", stats.block_size,
+            stats.allocations, hit_rate, stats.in_use, stats.high_water,
+            stats.cached);
+  }
+}
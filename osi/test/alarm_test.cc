@@ -297,6 +297,36 @@ TEST_F(AlarmTest, test_callback_ordering) {
   EXPECT_FALSE(WakeLockHeld());
 }
 
+// Test whether the callbacks are invoked in deadline order when alarms are
+// set in the reverse order, and some of them are canceled.
+TEST_F(AlarmTest, test_callback_ordering_set_in_reverse) {
+  alarm_t* alarms[100];
+
+  for (int i = 0; i < 100; i++) {
+    const std::string alarm_name =
+        "alarm_test.test_callback_ordering_set_in_reverse[" +
+        std::to_string(i) + "]";
+    alarms[i] = alarm_new(alarm_name.c_str());
+  }
+
+  // The deadlines span more than one level of slots in the alarm wheel.
+  for (int i = 99; i >= 0; i--) {
+    alarm_set(alarms[i], 50 + 3 * i, ordered_cb, INT_TO_PTR(i / 2));
+  }
+  for (int i = 1; i < 100; i += 2) alarm_cancel(alarms[i]);
+
+  for (int i = 1; i <= 50; i++) {
+    semaphore_wait(semaphore);
+    EXPECT_GE(cb_counter, i);
+  }
+  EXPECT_EQ(cb_counter, 50);
+  EXPECT_EQ(cb_misordered_counter, 0);
+
+  for (int i = 0; i < 100; i++) alarm_free(alarms[i]);
+
+  EXPECT_FALSE(WakeLockHeld());
+}
+
 // Test whether the callbacks are involed in the expected order on a
 // message loop.
 TEST_F(AlarmTest, test_callback_ordering_on_mloop) {
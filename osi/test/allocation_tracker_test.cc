@@ -62,3 +62,28 @@ TEST(AllocationTrackerTest, test_canaries_on) {
 
   free(dummy_allocation);
 }
+
+TEST(AllocationTrackerTest, test_profile_in_use_and_allocated) {
+  allocation_tracker_uninit();
+  allocation_tracker_profile_start(1);
+
+  void* first = malloc(4);
+  void* second = malloc(8);
+  allocation_tracker_notify_alloc(allocator_id, first, 4);
+  allocation_tracker_notify_alloc(allocator_id, second, 8);
+  allocation_tracker_notify_free(allocator_id, first);
+
+  FILE* profile = tmpfile();
+  ASSERT_NE(nullptr, profile);
+  allocation_tracker_profile_dump(fileno(profile));
+  rewind(profile);
+  char header[128] = {};
+  ASSERT_NE(nullptr, fgets(header, sizeof(header), profile));
+  EXPECT_STREQ("heap profile: 1: 8 [2: 12] @ heap_v2/1\n", header);
+  fclose(profile);
+
+  allocation_tracker_notify_free(allocator_id, second);
+  allocation_tracker_profile_stop();
+  free(first);
+  free(second);
+}
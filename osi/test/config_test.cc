@@ -244,6 +244,43 @@ TEST_F(ConfigTest, config_remove_key_missing) {
   EXPECT_EQ(config_get_int(*config, "DID", "productId", 999), 999);
 }
 
+TEST_F(ConfigTest, config_remove_section_re_add) {
+  std::unique_ptr<config_t> config = config_new(CONFIG_FILE);
+  EXPECT_TRUE(config_remove_section(config.get(), "DID"));
+  config_set_int(config.get(), "DID", "productId", 0x1300);
+  EXPECT_EQ(config_get_int(*config, "DID", "productId", 999), 0x1300);
+  EXPECT_FALSE(config_has_key(*config, "DID", "version"));
+  // re-added sections are saved after the existing ones
+  EXPECT_EQ(std::prev(config->sections.end())->name, "DID");
+}
+
+TEST_F(ConfigTest, config_copy_keeps_lookups) {
+  std::unique_ptr<config_t> config = config_new(CONFIG_FILE);
+  config_t copy = *config;
+  config.reset();
+  EXPECT_TRUE(config_has_section(copy, "DID"));
+  EXPECT_EQ(config_get_int(copy, "DID", "productId", 999), 0x1200);
+  EXPECT_TRUE(config_remove_key(&copy, "DID", "productId"));
+  EXPECT_FALSE(config_has_key(copy, "DID", "productId"));
+}
+
+TEST_F(ConfigTest, config_new_reopened_section_no_trailing_newline) {
+  auto filename = std::filesystem::temp_directory_path() / "reopened.conf";
+  std::string content = "[A]\na = 1\n[B]\nb = 2\n[A]\nc = 3";
+  base::FilePath file_path(filename.string());
+  ASSERT_EQ(base::WriteFile(file_path, content.data(), content.size()),
+            (int)content.size());
+
+  std::unique_ptr<config_t> config = config_new(filename.c_str());
+  ASSERT_NE(config, nullptr);
+  EXPECT_EQ(config->sections.size(), 2u);
+  EXPECT_EQ(config_get_int(*config, "A", "a", 0), 1);
+  EXPECT_EQ(config_get_int(*config, "B", "b", 0), 2);
+  EXPECT_EQ(config_get_int(*config, "A", "c", 0), 3);
+
+  EXPECT_TRUE(std::filesystem::remove(filename));
+}
+
 TEST_F(ConfigTest, config_save_basic) {
   std::unique_ptr<config_t> config = config_new(CONFIG_FILE);
   EXPECT_TRUE(config_save(*config, CONFIG_FILE));
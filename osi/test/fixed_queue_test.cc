@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
 #include <climits>
+#include <thread>
+#include <vector>
 
 #include "AllocationTestHarness.h"
 
@@ -348,3 +350,119 @@ TEST_F(FixedQueueTest, test_fixed_queue_register_dequeue) {
   thread_free(worker_thread);
   fixed_queue_free(queue, NULL);
 }
+
+TEST_F(FixedQueueTest, test_fixed_queue_lock_free_new_free) {
+  // Unsupported capacities
+  EXPECT_EQ(NULL, fixed_queue_new_lock_free(0));
+  EXPECT_EQ(NULL, fixed_queue_new_lock_free((size_t)-1));
+
+  fixed_queue_t* queue = fixed_queue_new_lock_free(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+  EXPECT_EQ(TEST_QUEUE_SIZE, fixed_queue_capacity(queue));
+
+  // Remaining elements are handed to the free callback
+  test_queue_entry_free_counter = 0;
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  fixed_queue_free(queue, test_queue_entry_free_cb);
+  EXPECT_EQ(2, test_queue_entry_free_counter);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_lock_free_enqueue_dequeue) {
+  fixed_queue_t* queue = fixed_queue_new_lock_free(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+  EXPECT_EQ(NULL, fixed_queue_try_peek_first(queue));
+  EXPECT_EQ(NULL, fixed_queue_try_dequeue(queue));
+
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  EXPECT_FALSE(fixed_queue_is_empty(queue));
+  EXPECT_EQ((size_t)2, fixed_queue_length(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING1, fixed_queue_try_peek_first(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING1, fixed_queue_dequeue(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING2, fixed_queue_try_dequeue(queue));
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+
+  // Capacity is enforced exactly, even if it isn't a power of two
+  for (size_t i = 0; i < TEST_QUEUE_SIZE; i++) {
+    EXPECT_TRUE(fixed_queue_try_enqueue(queue, (void*)DUMMY_DATA_STRING));
+  }
+  EXPECT_FALSE(fixed_queue_try_enqueue(queue, (void*)DUMMY_DATA_STRING));
+  fixed_queue_flush(queue, NULL);
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+
+  fixed_queue_free(queue, NULL);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_lock_free_dequeue_fd) {
+  fixed_queue_t* queue = fixed_queue_new_lock_free(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+
+  int dequeue_fd = fixed_queue_get_dequeue_fd(queue);
+  EXPECT_TRUE(dequeue_fd >= 0);
+  EXPECT_FALSE(is_fd_readable(dequeue_fd));
+
+  // Readable for as long as the queue isn't empty
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  EXPECT_TRUE(is_fd_readable(dequeue_fd));
+  fixed_queue_dequeue(queue);
+  EXPECT_TRUE(is_fd_readable(dequeue_fd));
+  fixed_queue_dequeue(queue);
+  EXPECT_FALSE(is_fd_readable(dequeue_fd));
+
+  fixed_queue_free(queue, NULL);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_lock_free_register_dequeue) {
+  fixed_queue_t* queue = fixed_queue_new_lock_free(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+
+  received_message_future = future_new();
+  ASSERT_TRUE(received_message_future != NULL);
+
+  thread_t* worker_thread = thread_new("test_fixed_queue_worker_thread");
+  ASSERT_TRUE(worker_thread != NULL);
+
+  fixed_queue_register_dequeue(queue, thread_get_reactor(worker_thread),
+                               fixed_queue_ready, NULL);
+
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING);
+  const char* msg = (const char*)future_await(received_message_future);
+  EXPECT_EQ(DUMMY_DATA_STRING, msg);
+
+  fixed_queue_unregister_dequeue(queue);
+  thread_free(worker_thread);
+  fixed_queue_free(queue, NULL);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_lock_free_multiple_producers) {
+  static const size_t kProducers = 4;
+  static const uintptr_t kItemsPerProducer = 10000;
+
+  fixed_queue_t* queue = fixed_queue_new_lock_free(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < kProducers; p++) {
+    producers.emplace_back([queue]() {
+      for (uintptr_t i = 1; i <= kItemsPerProducer; i++) {
+        fixed_queue_enqueue(queue, (void*)i);
+      }
+    });
+  }
+
+  // Blocking dequeue must see every element exactly once
+  uintptr_t sum = 0;
+  for (size_t i = 0; i < kProducers * kItemsPerProducer; i++) {
+    sum += (uintptr_t)fixed_queue_dequeue(queue);
+  }
+  for (auto& producer : producers) producer.join();
+
+  EXPECT_EQ(kProducers * kItemsPerProducer * (kItemsPerProducer + 1) / 2, sum);
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+
+  fixed_queue_free(queue, NULL);
+}
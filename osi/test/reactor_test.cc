@@ -111,3 +111,54 @@ TEST_F(ReactorTest, reactor_unregister_from_separate_thread) {
   close(fd);
   reactor_free(reactor);
 }
+
+typedef struct unregister_other_arg_t {
+  reactor_t* reactor;
+  reactor_object_t* other;
+  struct unregister_other_arg_t* other_arg;
+  int fd;
+  int calls;
+} unregister_other_arg_t;
+
+static void unregister_other_cb(void* context) {
+  unregister_other_arg_t* arg = (unregister_other_arg_t*)context;
+  eventfd_t value;
+  eventfd_read(arg->fd, &value);
+  arg->calls++;
+  if (arg->other) {
+    reactor_unregister(arg->other);
+    arg->other_arg->other = NULL;
+    arg->other = NULL;
+  }
+  reactor_stop(arg->reactor);
+}
+
+TEST_F(ReactorTest, reactor_unregister_other_in_same_batch) {
+  reactor_t* reactor = reactor_new();
+
+  int fd_a = eventfd(0, 0);
+  int fd_b = eventfd(0, 0);
+  unregister_other_arg_t arg_a = {reactor, NULL, NULL, fd_a, 0};
+  unregister_other_arg_t arg_b = {reactor, NULL, &arg_a, fd_b, 0};
+  arg_a.other_arg = &arg_b;
+  reactor_object_t* object_a =
+      reactor_register(reactor, fd_a, &arg_a, unregister_other_cb, NULL);
+  reactor_object_t* object_b =
+      reactor_register(reactor, fd_b, &arg_b, unregister_other_cb, NULL);
+  arg_a.other = object_b;
+  arg_b.other = object_a;
+
+  // Both fds are ready in the first batch; whichever callback runs first
+  // unregisters the other one, which must then not be called.
+  eventfd_write(fd_a, 1);
+  eventfd_write(fd_b, 1);
+  spawn_reactor_thread(reactor);
+  join_reactor_thread();
+
+  EXPECT_EQ(arg_a.calls + arg_b.calls, 1);
+  reactor_unregister(arg_a.calls ? object_a : object_b);
+
+  close(fd_a);
+  close(fd_b);
+  reactor_free(reactor);
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "osi/include/osi.h"
 #include "osi/include/ringbuffer.h"
 
@@ -137,3 +139,100 @@ TEST(RingbufferTest, test_multi_insert_delete) {
 
   ringbuffer_free(rb);
 }
+
+TEST(RingbufferTest, test_reserve_commit_wrap) {
+  ringbuffer_t* rb = ringbuffer_init(8);
+
+  uint8_t aa[] = {0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA};
+  ringbuffer_insert(rb, aa, sizeof(aa));
+  ringbuffer_delete(rb, 4);
+
+  // The free space wraps around, after the two bytes left
+  ringbuffer_span_t spans[2];
+  size_t count = ringbuffer_reserve(rb, 16, spans);
+  ASSERT_EQ((size_t)2, count);
+  EXPECT_EQ((size_t)2, spans[0].length);
+  EXPECT_EQ((size_t)4, spans[1].length);
+  uint8_t value = 0x01;
+  for (size_t i = 0; i < count; ++i)
+    for (size_t j = 0; j < spans[i].length; ++j) spans[i].data[j] = value++;
+
+  // Only what is committed is added
+  EXPECT_EQ((size_t)2, ringbuffer_size(rb));
+  ringbuffer_commit(rb, 5);
+  EXPECT_EQ((size_t)7, ringbuffer_size(rb));
+  EXPECT_EQ((size_t)1, ringbuffer_available(rb));
+
+  uint8_t expected[] = {0xAA, 0xAA, 0x01, 0x02, 0x03, 0x04, 0x05};
+  uint8_t peek[7] = {0};
+  EXPECT_EQ((size_t)7, ringbuffer_peek(rb, 0, peek, sizeof(peek)));
+  ASSERT_TRUE(0 == memcmp(expected, peek, sizeof(peek)));
+
+  ringbuffer_free(rb);
+}
+
+TEST(RingbufferTest, test_peek_spans_delete) {
+  ringbuffer_t* rb = ringbuffer_init(8);
+
+  uint8_t aa[] = {0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA};
+  uint8_t bb[] = {0xBB, 0xBB, 0xBB, 0xBB};
+  ringbuffer_insert(rb, aa, sizeof(aa));
+  ringbuffer_delete(rb, 5);
+  ringbuffer_insert(rb, bb, sizeof(bb));
+
+  ringbuffer_span_t spans[2];
+  ASSERT_EQ((size_t)2, ringbuffer_peek_spans(rb, 16, spans));
+  ASSERT_EQ((size_t)3, spans[0].length);
+  EXPECT_EQ(0xAA, spans[0].data[0]);
+  EXPECT_EQ(0xBB, spans[0].data[1]);
+  ASSERT_EQ((size_t)2, spans[1].length);
+  EXPECT_EQ(0xBB, spans[1].data[1]);
+
+  // Peeking does not consume
+  EXPECT_EQ((size_t)5, ringbuffer_size(rb));
+  ASSERT_EQ((size_t)1, ringbuffer_peek_spans(rb, 1, spans));
+  EXPECT_EQ((size_t)1, spans[0].length);
+  EXPECT_EQ((size_t)1, ringbuffer_delete(rb, spans[0].length));
+  EXPECT_EQ((size_t)4, ringbuffer_size(rb));
+
+  ringbuffer_delete(rb, 4);
+  EXPECT_EQ((size_t)0, ringbuffer_peek_spans(rb, 16, spans));
+
+  ringbuffer_free(rb);
+}
+
+TEST(RingbufferTest, test_mirrored_single_span) {
+  ringbuffer_t* rb = ringbuffer_init_mirrored(100);
+  ASSERT_TRUE(rb != NULL);
+  const size_t total = ringbuffer_available(rb);
+  EXPECT_GE(total, (size_t)100);
+
+  // Move the head and tail near the end of the buffer
+  std::vector<uint8_t> data(total - 2, 0x00);
+  ringbuffer_insert(rb, data.data(), data.size());
+  ringbuffer_delete(rb, data.size());
+
+  uint8_t aa[] = {0xAA, 0xBB, 0xCC, 0xDD};
+  ringbuffer_span_t spans[2];
+  size_t count = ringbuffer_reserve(rb, sizeof(aa), spans);
+  if (count == 1) {
+    // The buffer is mirrored: the span goes past the end of the buffer
+    EXPECT_EQ(sizeof(aa), spans[0].length);
+    memcpy(spans[0].data, aa, sizeof(aa));
+    ringbuffer_commit(rb, sizeof(aa));
+
+    ASSERT_EQ((size_t)1, ringbuffer_peek_spans(rb, 16, spans));
+    EXPECT_EQ(sizeof(aa), spans[0].length);
+    ASSERT_TRUE(0 == memcmp(aa, spans[0].data, sizeof(aa)));
+  } else {
+    // No mirroring on this platform
+    ASSERT_EQ((size_t)2, count);
+    ringbuffer_insert(rb, aa, sizeof(aa));
+  }
+
+  uint8_t peek[4] = {0};
+  EXPECT_EQ(sizeof(aa), ringbuffer_pop(rb, peek, sizeof(peek)));
+  ASSERT_TRUE(0 == memcmp(aa, peek, sizeof(peek)));
+
+  ringbuffer_free(rb);
+}
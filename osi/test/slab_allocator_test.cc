@@ -0,0 +1,193 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/allocator.h"
+#include "osi/include/slab_allocator.h"
+
+class SlabAllocatorTest : public AllocationTestHarness {
+ protected:
+  void SetUp() override {
+    AllocationTestHarness::SetUp();
+    slab_allocator_set_enabled(true);
+  }
+
+  void TearDown() override {
+    slab_allocator_trim();
+    slab_allocator_set_enabled(false);
+    AllocationTestHarness::TearDown();
+  }
+
+  static slab_allocator_stats_t stats_for(size_t block_size) {
+    slab_allocator_stats_t stats = {};
+    for (size_t i = 0; i < slab_allocator_size_class_count(); i++) {
+      slab_allocator_get_stats(i, &stats);
+      if (stats.block_size == block_size) break;
+    }
+    return stats;
+  }
+};
+
+TEST_F(SlabAllocatorTest, test_reuses_freed_block) {
+  void* first = slab_allocator_alloc(100, false);
+  slab_allocator_free(first);
+  void* second = slab_allocator_alloc(120, false);
+  EXPECT_EQ(first, second);
+  slab_allocator_free(second);
+}
+
+TEST_F(SlabAllocatorTest, test_hits_and_high_water) {
+  slab_allocator_stats_t before = stats_for(320);
+
+  void* a = slab_allocator_alloc(300, false);
+  void* b = slab_allocator_alloc(300, false);
+  slab_allocator_free(a);
+  void* c = slab_allocator_alloc(300, false);
+
+  slab_allocator_stats_t after = stats_for(320);
+  EXPECT_EQ(before.allocations + 3, after.allocations);
+  EXPECT_LE(before.hits + 1, after.hits);
+  EXPECT_EQ(before.in_use + 2, after.in_use);
+  EXPECT_LE(before.in_use + 2, after.high_water);
+
+  slab_allocator_free(b);
+  slab_allocator_free(c);
+  EXPECT_EQ(before.in_use, stats_for(320).in_use);
+}
+
+TEST_F(SlabAllocatorTest, test_zeroed_allocation) {
+  uint8_t* buffer = static_cast<uint8_t*>(slab_allocator_alloc(64, false));
+  memset(buffer, 0xaa, 64);
+  slab_allocator_free(buffer);
+
+  buffer = static_cast<uint8_t*>(slab_allocator_alloc(64, true));
+  for (size_t i = 0; i < 64; i++) EXPECT_EQ(0, buffer[i]);
+  slab_allocator_free(buffer);
+}
+
+TEST_F(SlabAllocatorTest, test_large_allocation_uses_heap) {
+  void* ptr = slab_allocator_alloc(64 * 1024, true);
+  EXPECT_NE(nullptr, ptr);
+  slab_allocator_free(ptr);
+}
+
+TEST_F(SlabAllocatorTest, test_toggle_with_outstanding_blocks) {
+  void* slab_block = slab_allocator_alloc(200, false);
+  slab_allocator_set_enabled(false);
+  void* heap_block = slab_allocator_alloc(200, false);
+  slab_allocator_set_enabled(true);
+  slab_allocator_free(heap_block);
+  slab_allocator_set_enabled(false);
+  slab_allocator_free(slab_block);
+}
+
+TEST_F(SlabAllocatorTest, test_osi_malloc_with_tracker) {
+  for (size_t size : {1, 80, 700, 1691, 4112, 10000}) {
+    uint8_t* buffer = static_cast<uint8_t*>(osi_calloc(size));
+    for (size_t i = 0; i < size; i++) ASSERT_EQ(0, buffer[i]);
+    memset(buffer, 0x5a, size);
+    osi_free(buffer);
+  }
+}
+
+TEST_F(SlabAllocatorTest, test_free_on_other_thread) {
+  std::vector<void*> blocks;
+  for (int i = 0; i < 100; i++) {
+    blocks.push_back(slab_allocator_alloc(1000, false));
+  }
+
+  std::thread consumer([&blocks]() {
+    for (void* block : blocks) slab_allocator_free(block);
+  });
+  consumer.join();
+
+  for (int i = 0; i < 100; i++) blocks[i] = slab_allocator_alloc(1000, false);
+  for (void* block : blocks) slab_allocator_free(block);
+}
+
+TEST_F(SlabAllocatorTest, test_pool_recycles_blocks) {
+  slab_pool_t* pool = slab_pool_new(512, 2);
+  void* a = slab_pool_alloc(pool, 400);
+  void* b = slab_pool_alloc(pool, 512);
+  slab_allocator_free(a);
+  void* c = slab_pool_alloc(pool, 100);
+  EXPECT_EQ(a, c);
+
+  slab_allocator_stats_t stats;
+  slab_pool_get_stats(pool, &stats);
+  EXPECT_EQ(512u, stats.block_size);
+  EXPECT_EQ(3u, stats.allocations);
+  EXPECT_EQ(3u, stats.hits);
+  EXPECT_EQ(2u, stats.in_use);
+  EXPECT_EQ(2u, stats.high_water);
+  EXPECT_EQ(0u, stats.cached);
+
+  slab_allocator_free(b);
+  slab_allocator_free(c);
+  slab_pool_free(pool);
+}
+
+TEST_F(SlabAllocatorTest, test_pool_falls_back_to_heap) {
+  slab_pool_t* pool = slab_pool_new(256, 1);
+  void* pooled = slab_pool_alloc(pool, 256);
+  void* exhausted = slab_pool_alloc(pool, 256);
+  void* too_large = slab_pool_alloc(pool, 257);
+  EXPECT_NE(nullptr, exhausted);
+  EXPECT_NE(nullptr, too_large);
+
+  slab_allocator_stats_t stats;
+  slab_pool_get_stats(pool, &stats);
+  EXPECT_EQ(3u, stats.allocations);
+  EXPECT_EQ(1u, stats.hits);
+
+  slab_allocator_free(exhausted);
+  slab_allocator_free(too_large);
+  slab_allocator_free(pooled);
+  slab_pool_get_stats(pool, &stats);
+  EXPECT_EQ(1u, stats.cached);
+  slab_pool_free(pool);
+}
+
+TEST_F(SlabAllocatorTest, test_pool_outlived_by_blocks) {
+  slab_pool_t* pool = slab_pool_new(1024, 4);
+  std::vector<void*> blocks;
+  for (int i = 0; i < 4; i++) blocks.push_back(slab_pool_alloc(pool, 1024));
+  slab_pool_free(pool);
+
+  std::thread consumer([&blocks]() {
+    for (void* block : blocks) slab_allocator_free(block);
+  });
+  consumer.join();
+}
+
+TEST_F(SlabAllocatorTest, test_osi_malloc_from_pool_with_tracker) {
+  slab_pool_t* pool = osi_pool_new(1000, 1);
+  uint8_t* first = static_cast<uint8_t*>(osi_malloc_from_pool(pool, 1000));
+  memset(first, 0x5a, 1000);
+  osi_free(first);
+  uint8_t* second = static_cast<uint8_t*>(osi_malloc_from_pool(pool, 1000));
+  EXPECT_EQ(first, second);
+  osi_free(second);
+  osi_pool_free(pool);
+}
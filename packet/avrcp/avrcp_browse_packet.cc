@@ -52,7 +52,7 @@ void BrowsePacketBuilder::PushHeader(
 
 std::shared_ptr<BrowsePacket> BrowsePacket::Parse(
     std::shared_ptr<::bluetooth::Packet> pkt) {
-  return std::shared_ptr<BrowsePacket>(new BrowsePacket(pkt));
+  return MakeShared<BrowsePacket>(pkt);
 }
 
 BrowsePdu BrowsePacket::GetPdu() const {
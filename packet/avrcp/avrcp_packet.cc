@@ -70,7 +70,7 @@ bool PacketBuilder::PushCompanyId(
 
 std::shared_ptr<Packet> Packet::Parse(
     std::shared_ptr<::bluetooth::Packet> pkt) {
-  return std::shared_ptr<Packet>(new Packet(pkt));
+  return MakeShared<Packet>(pkt);
 }
 
 CType Packet::GetCType() const {
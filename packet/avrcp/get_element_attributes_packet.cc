@@ -90,8 +90,21 @@ GetElementAttributesResponseBuilder::MakeBuilder(size_t mtu) {
   return builder;
 }
 
+std::unique_ptr<GetElementAttributesResponseBuilder>
+GetElementAttributesResponseBuilder::MakeBuilder(EncodedAttributes attributes) {
+  CHECK(attributes != nullptr && !attributes->empty());
+
+  std::unique_ptr<GetElementAttributesResponseBuilder> builder(
+      new GetElementAttributesResponseBuilder(VendorPacket::kMinSize() +
+                                              attributes->size()));
+  builder->encoded_ = std::move(attributes);
+
+  return builder;
+}
+
 bool GetElementAttributesResponseBuilder::AddAttributeEntry(
     AttributeEntry entry) {
+  CHECK(encoded_ == nullptr) << __func__ << ": attributes already encoded";
   CHECK_LT(entries_.size(), size_t(0xFF))
       << __func__ << ": attribute entry overflow";
 
@@ -113,7 +126,35 @@ bool GetElementAttributesResponseBuilder::AddAttributeEntry(Attribute attribute,
   return AddAttributeEntry(AttributeEntry(attribute, value));
 }
 
+GetElementAttributesResponseBuilder::EncodedAttributes
+GetElementAttributesResponseBuilder::EncodeAttributes() const {
+  if (encoded_ != nullptr) return encoded_;
+
+  auto data = std::make_shared<std::vector<uint8_t>>();
+  data->reserve(size() - VendorPacket::kMinSize());
+
+  // Entries are encoded in big endian, like PushAttributeValue() does
+  data->push_back(entries_.size());
+  for (const auto& attribute_entry : entries_) {
+    uint32_t attribute = static_cast<uint32_t>(attribute_entry.attribute());
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      data->push_back(attribute >> shift);
+    }
+    data->push_back(0x00);  // UTF-8 Character Set
+    data->push_back(0x6a);
+    std::string value = attribute_entry.value();
+    uint16_t value_length = value.length();
+    data->push_back(value_length >> 8);
+    data->push_back(value_length);
+    data->insert(data->end(), value.begin(), value.begin() + value_length);
+  }
+
+  return data;
+}
+
 size_t GetElementAttributesResponseBuilder::size() const {
+  if (encoded_ != nullptr) return VendorPacket::kMinSize() + encoded_->size();
+
   size_t attr_list_size = 0;
 
   for (auto& attribute_entry : entries_) {
@@ -131,6 +172,11 @@ bool GetElementAttributesResponseBuilder::Serialize(
 
   VendorPacketBuilder::PushHeader(pkt, size() - VendorPacket::kMinSize());
 
+  if (encoded_ != nullptr) {
+    AddPayloadBytes(pkt, encoded_->data(), encoded_->size());
+    return true;
+  }
+
   AddPayloadOctets1(pkt, entries_.size());
   for (const auto& attribute_entry : entries_) {
     PushAttributeValue(pkt, attribute_entry);
@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <memory>
 #include <set>
+#include <vector>
 #include "vendor_packet.h"
 
 namespace bluetooth {
@@ -62,18 +64,32 @@ class GetElementAttributesResponseBuilder : public VendorPacketBuilder {
  public:
   virtual ~GetElementAttributesResponseBuilder() = default;
 
+  // The number of attributes followed by the attribute entries, as they are
+  // laid out in the response payload
+  using EncodedAttributes = std::shared_ptr<const std::vector<uint8_t>>;
+
   static std::unique_ptr<GetElementAttributesResponseBuilder> MakeBuilder(
       size_t mtu);
 
+  // Makes a builder for a response with the attributes another builder
+  // encoded, see EncodeAttributes(). No entries can be added to it.
+  static std::unique_ptr<GetElementAttributesResponseBuilder> MakeBuilder(
+      EncodedAttributes attributes);
+
   bool AddAttributeEntry(AttributeEntry entry);
   bool AddAttributeEntry(Attribute attribute, std::string value);
 
+  // Returns the payload for the entries added so far, so that the same
+  // response can be sent again without going through each entry
+  EncodedAttributes EncodeAttributes() const;
+
   virtual size_t size() const override;
   virtual bool Serialize(
       const std::shared_ptr<::bluetooth::Packet>& pkt) override;
 
  private:
   std::set<AttributeEntry> entries_;
+  EncodedAttributes encoded_;
   size_t mtu_;
 
   GetElementAttributesResponseBuilder(size_t mtu)
@@ -61,9 +61,7 @@ size_t GetFolderItemsResponseBuilder::size() const {
 
   len += 2;  // UID Counter
   len += 2;  // Number of Items;
-  for (const auto& item : items_) {
-    len += item.size();
-  }
+  len += items_size_;
 
   return len;
 }
@@ -87,146 +85,148 @@ bool GetFolderItemsResponseBuilder::Serialize(
   AddPayloadOctets2(pkt, base::ByteSwap(num_items));
 
   for (const auto& item : items_) {
-    PushMediaListItem(pkt, item);
+    AddPayloadBytes(pkt, item->data(), item->size());
   }
 
   return true;
 }
 
 bool GetFolderItemsResponseBuilder::AddMediaPlayer(MediaPlayerItem item) {
-  CHECK(scope_ == Scope::MEDIA_PLAYER_LIST);
-
-  if (size() + item.size() > mtu_) return false;
-
-  items_.push_back(MediaListItem(item));
-  return true;
+  return AddEncodedItem(EncodeMediaPlayer(item));
 }
 
 bool GetFolderItemsResponseBuilder::AddSong(MediaElementItem item) {
-  CHECK(scope_ == Scope::VFS || scope_ == Scope::NOW_PLAYING);
-
-  if (size() + item.size() > mtu_) return false;
-
-  items_.push_back(MediaListItem(item));
-  return true;
+  return AddEncodedItem(EncodeSong(item));
 }
 
 bool GetFolderItemsResponseBuilder::AddFolder(FolderItem item) {
-  CHECK(scope_ == Scope::VFS);
-
-  if (size() + item.size() > mtu_) return false;
-
-  items_.push_back(MediaListItem(item));
-  return true;
+  return AddEncodedItem(EncodeFolder(item));
 }
 
-void GetFolderItemsResponseBuilder::PushMediaListItem(
-    const std::shared_ptr<::bluetooth::Packet>& pkt,
-    const MediaListItem& item) {
-  switch (item.type_) {
+bool GetFolderItemsResponseBuilder::AddEncodedItem(const EncodedItem& item) {
+  CHECK(!item->empty());
+  switch ((*item)[0]) {
     case MediaListItem::PLAYER:
-      PushMediaPlayerItem(pkt, item.player_);
+      CHECK(scope_ == Scope::MEDIA_PLAYER_LIST);
       break;
     case MediaListItem::FOLDER:
-      PushFolderItem(pkt, item.folder_);
+      CHECK(scope_ == Scope::VFS);
       break;
     case MediaListItem::SONG:
-      PushMediaElementItem(pkt, item.song_);
+      CHECK(scope_ == Scope::VFS || scope_ == Scope::NOW_PLAYING);
       break;
+    default:
+      LOG(FATAL) << "Unknown media list item type " << (int)(*item)[0];
   }
+
+  // The UID Counter and Number of Items fields come with the first item
+  size_t len = size() + item->size();
+  if (items_.size() == 0) len += 4;
+  if (len > mtu_) return false;
+
+  items_.push_back(item);
+  items_size_ += item->size();
+  return true;
 }
 
-void GetFolderItemsResponseBuilder::PushMediaPlayerItem(
-    const std::shared_ptr<::bluetooth::Packet>& pkt,
-    const MediaPlayerItem& item) {
-  AddPayloadOctets1(pkt, 0x01);  // Media Player Item
+namespace {
+
+// Items are encoded in big endian, like the rest of the AVRCP payloads
+void PushOctets1(std::vector<uint8_t>* data, uint8_t value) {
+  data->push_back(value);
+}
+
+void PushOctets2(std::vector<uint8_t>* data, uint16_t value) {
+  data->push_back(value >> 8);
+  data->push_back(value);
+}
+
+void PushOctets4(std::vector<uint8_t>* data, uint32_t value) {
+  PushOctets2(data, value >> 16);
+  PushOctets2(data, value);
+}
+
+void PushOctets8(std::vector<uint8_t>* data, uint64_t value) {
+  PushOctets4(data, value >> 32);
+  PushOctets4(data, value);
+}
+
+void PushString(std::vector<uint8_t>* data, const std::string& value) {
+  PushOctets2(data, 0x006a);  // UTF-8 Character Set
+  uint16_t len = value.size();
+  PushOctets2(data, len);
+  data->insert(data->end(), value.begin(), value.end());
+}
+
+}  // namespace
+
+GetFolderItemsResponseBuilder::EncodedItem
+GetFolderItemsResponseBuilder::EncodeMediaPlayer(const MediaPlayerItem& item) {
+  auto data = std::make_shared<std::vector<uint8_t>>();
+  data->reserve(item.size());
+
+  PushOctets1(data.get(), 0x01);  // Media Player Item
   uint16_t item_len = item.size() - 3;
-  AddPayloadOctets2(pkt, base::ByteSwap(item_len));  // Item length
-  AddPayloadOctets2(pkt, base::ByteSwap(item.id_));  // Player ID
-  AddPayloadOctets1(pkt, 0x01);                      // Player Type
-  AddPayloadOctets4(pkt, 0x00000000);                // Player Subtype
-  AddPayloadOctets1(
-      pkt, 0x02);  // Player Play Status // TODO: Add this as a passed field
+  PushOctets2(data.get(), item_len);    // Item length
+  PushOctets2(data.get(), item.id_);    // Player ID
+  PushOctets1(data.get(), 0x01);        // Player Type
+  PushOctets4(data.get(), 0x00000000);  // Player Subtype
+  PushOctets1(data.get(),
+              0x02);  // Player Play Status // TODO: Add this as a passed field
 
   // Features
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0xb7);
-  AddPayloadOctets1(pkt, 0x01);
+  PushOctets4(data.get(), 0x00000000);
+  PushOctets1(data.get(), 0x00);
+  PushOctets1(data.get(), 0xb7);
+  PushOctets1(data.get(), 0x01);
   if (item.browsable_) {
-    AddPayloadOctets1(pkt, 0x0C);
-    AddPayloadOctets1(pkt, 0x0a);
+    PushOctets1(data.get(), 0x0C);
+    PushOctets1(data.get(), 0x0a);
   } else {
-    AddPayloadOctets1(pkt, 0x04);
-    AddPayloadOctets1(pkt, 0x00);
-  }
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-  AddPayloadOctets1(pkt, 0x00);
-
-  AddPayloadOctets2(pkt, base::ByteSwap((uint16_t)0x006a));
-  uint16_t name_len = item.name_.size();
-  AddPayloadOctets2(pkt, base::ByteSwap(name_len));
-
-  for (const uint8_t& byte : item.name_) {
-    AddPayloadOctets1(pkt, byte);
+    PushOctets1(data.get(), 0x04);
+    PushOctets1(data.get(), 0x00);
   }
+  PushOctets4(data.get(), 0x00000000);
+  PushOctets2(data.get(), 0x0000);
+  PushOctets1(data.get(), 0x00);
+
+  PushString(data.get(), item.name_);
+  return data;
 }
 
-void GetFolderItemsResponseBuilder::PushFolderItem(
-    const std::shared_ptr<::bluetooth::Packet>& pkt, const FolderItem& item) {
-  AddPayloadOctets1(pkt, 0x02);  // Folder Item
+GetFolderItemsResponseBuilder::EncodedItem
+GetFolderItemsResponseBuilder::EncodeFolder(const FolderItem& item) {
+  auto data = std::make_shared<std::vector<uint8_t>>();
+  data->reserve(item.size());
+
+  PushOctets1(data.get(), 0x02);  // Folder Item
   uint16_t item_len = item.size() - 3;
-  AddPayloadOctets2(pkt, base::ByteSwap(item_len));
-  AddPayloadOctets8(pkt, base::ByteSwap(item.uid_));
-  AddPayloadOctets1(pkt, item.folder_type_);
-  AddPayloadOctets1(pkt, item.is_playable_ ? 0x01 : 0x00);
-  AddPayloadOctets2(pkt,
-                    base::ByteSwap((uint16_t)0x006a));  // UTF-8 Character Set
-  uint16_t name_len = item.name_.size();
-  AddPayloadOctets2(pkt, base::ByteSwap(name_len));
-  for (const uint8_t& byte : item.name_) {
-    AddPayloadOctets1(pkt, byte);
-  }
+  PushOctets2(data.get(), item_len);
+  PushOctets8(data.get(), item.uid_);
+  PushOctets1(data.get(), item.folder_type_);
+  PushOctets1(data.get(), item.is_playable_ ? 0x01 : 0x00);
+  PushString(data.get(), item.name_);
+  return data;
 }
 
-void GetFolderItemsResponseBuilder::PushMediaElementItem(
-    const std::shared_ptr<::bluetooth::Packet>& pkt,
-    const MediaElementItem& item) {
-  AddPayloadOctets1(pkt, 0x03);  // Media Element Item
+GetFolderItemsResponseBuilder::EncodedItem
+GetFolderItemsResponseBuilder::EncodeSong(const MediaElementItem& item) {
+  auto data = std::make_shared<std::vector<uint8_t>>();
+  data->reserve(item.size());
+
+  PushOctets1(data.get(), 0x03);  // Media Element Item
   uint16_t item_len = item.size() - 3;
-  AddPayloadOctets2(pkt, base::ByteSwap(item_len));
-  AddPayloadOctets8(pkt, base::ByteSwap(item.uid_));
-  AddPayloadOctets1(pkt, 0x00);  // Media Type Audio
-  AddPayloadOctets2(pkt,
-                    base::ByteSwap((uint16_t)0x006a));  // UTF-8 Character Set
-  uint16_t name_len = item.name_.size();
-  AddPayloadOctets2(pkt, base::ByteSwap(name_len));
-  for (const uint8_t& byte : item.name_) {
-    AddPayloadOctets1(pkt, byte);
-  }
+  PushOctets2(data.get(), item_len);
+  PushOctets8(data.get(), item.uid_);
+  PushOctets1(data.get(), 0x00);  // Media Type Audio
+  PushString(data.get(), item.name_);
 
-  AddPayloadOctets1(pkt, (uint8_t)item.attributes_.size());
+  PushOctets1(data.get(), (uint8_t)item.attributes_.size());
   for (const auto& entry : item.attributes_) {
-    AddPayloadOctets4(pkt, base::ByteSwap((uint32_t)entry.attribute()));
-    AddPayloadOctets2(pkt,
-                      base::ByteSwap((uint16_t)0x006a));  // UTF-8 Character Set
-
-    std::string attr_val = entry.value();
-    uint16_t attr_len = attr_val.size();
-
-    AddPayloadOctets2(pkt, base::ByteSwap(attr_len));
-    for (const uint8_t& byte : attr_val) {
-      AddPayloadOctets1(pkt, byte);
-    }
+    PushOctets4(data.get(), (uint32_t)entry.attribute());
+    PushString(data.get(), entry.value());
   }
+  return data;
 }
 
 Scope GetFolderItemsRequest::GetScope() const {
@@ -23,6 +23,11 @@ namespace avrcp {
 
 class GetFolderItemsResponseBuilder : public BrowsePacketBuilder {
  public:
+  // A media list item encoded as it is sent in the response. Items are encoded
+  // when they are added, so an encoding can be cached and added again to later
+  // responses.
+  using EncodedItem = std::shared_ptr<const std::vector<uint8_t>>;
+
   virtual ~GetFolderItemsResponseBuilder() = default;
   static std::unique_ptr<GetFolderItemsResponseBuilder> MakePlayerListBuilder(
       Status status, uint16_t uid_counter, size_t mtu);
@@ -39,10 +44,16 @@ class GetFolderItemsResponseBuilder : public BrowsePacketBuilder {
   bool AddMediaPlayer(MediaPlayerItem item);
   bool AddSong(MediaElementItem item);
   bool AddFolder(FolderItem item);
+  bool AddEncodedItem(const EncodedItem& item);
+
+  static EncodedItem EncodeMediaPlayer(const MediaPlayerItem& item);
+  static EncodedItem EncodeSong(const MediaElementItem& item);
+  static EncodedItem EncodeFolder(const FolderItem& item);
 
  protected:
   Scope scope_;
-  std::vector<MediaListItem> items_;
+  std::vector<EncodedItem> items_;
+  size_t items_size_ = 0;
   Status status_;
   uint16_t uid_counter_;
   size_t mtu_;
@@ -55,15 +66,6 @@ class GetFolderItemsResponseBuilder : public BrowsePacketBuilder {
         uid_counter_(uid_counter),
         mtu_(mtu){};
 
- private:
-  void PushMediaListItem(const std::shared_ptr<::bluetooth::Packet>& pkt,
-                         const MediaListItem& item);
-  void PushMediaPlayerItem(const std::shared_ptr<::bluetooth::Packet>& pkt,
-                           const MediaPlayerItem& item);
-  void PushMediaElementItem(const std::shared_ptr<::bluetooth::Packet>& pkt,
-                            const MediaElementItem& item);
-  void PushFolderItem(const std::shared_ptr<::bluetooth::Packet>& pkt,
-                      const FolderItem& item);
 };
 
 class GetFolderItemsRequest : public BrowsePacket {
@@ -22,12 +22,10 @@
 
 namespace bluetooth {
 
-Iterator::Iterator(std::shared_ptr<const Packet> packet, size_t i) {
-  packet_ = packet;
-  index_ = i;
-
-  CHECK_GE(index_, packet->packet_start_index_);
-  CHECK_LE(index_, packet->packet_end_index_);
+Iterator::Iterator(std::shared_ptr<const Packet> packet, size_t i)
+    : packet_(std::move(packet)), index_(i) {
+  CHECK_GE(index_, packet_->packet_start_index_);
+  CHECK_LE(index_, packet_->packet_end_index_);
 }
 
 Iterator::Iterator(const Iterator& itr) { *this = itr; }
@@ -126,4 +124,14 @@ uint8_t Iterator::operator*() const {
   return packet_->get_at_index(index_);
 }
 
+const uint8_t* Iterator::Consume(size_t length) {
+  CHECK_NE(index_, packet_->packet_end_index_);
+  CHECK_LE(length, packet_->packet_end_index_ - index_);
+  CHECK_LE(packet_->packet_end_index_, packet_->data_->size());
+
+  const uint8_t* data = packet_->data_->data() + index_;
+  index_ += length;
+  return data;
+}
+
 }  // namespace bluetooth
\ No newline at end of file
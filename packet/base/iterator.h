@@ -62,10 +62,10 @@ class Iterator
     static_assert(std::is_integral<FixedWidthIntegerType>::value,
                   "Iterator::extract requires an integral type.");
 
+    const uint8_t* data = Consume(sizeof(FixedWidthIntegerType));
     FixedWidthIntegerType extracted_value = 0;
     for (size_t i = 0; i < sizeof(FixedWidthIntegerType); i++) {
-      extracted_value |= static_cast<FixedWidthIntegerType>(**this) << i * 8;
-      (*this)++;
+      extracted_value |= static_cast<FixedWidthIntegerType>(data[i]) << i * 8;
     }
 
     return extracted_value;
@@ -77,11 +77,11 @@ class Iterator
     static_assert(std::is_integral<FixedWidthIntegerType>::value,
                   "Iterator::extract requires an integral type.");
 
+    const uint8_t* data = Consume(sizeof(FixedWidthIntegerType));
     FixedWidthIntegerType extracted_value = 0;
     for (size_t i = 0; i < sizeof(FixedWidthIntegerType); i++) {
-      extracted_value |= static_cast<FixedWidthIntegerType>(**this)
+      extracted_value |= static_cast<FixedWidthIntegerType>(data[i])
                          << (sizeof(FixedWidthIntegerType) - 1 - i) * 8;
-      (*this)++;
     }
 
     return extracted_value;
@@ -93,6 +93,11 @@ class Iterator
   uint64_t extract64() { return extract<uint64_t>(); }
 
  private:
+  // Checks that |length| bytes are left in the packet and moves past them.
+  // Returns a pointer to those bytes in the underlying data, so that
+  // extracting a value only checks the bounds once.
+  const uint8_t* Consume(size_t length);
+
   std::shared_ptr<const Packet> packet_;
   size_t index_;
 };  // Iterator
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -61,7 +62,8 @@ class Packet : public std::enable_shared_from_this<Packet> {
   virtual std::string ToString() const = 0;
 
   // Convert a packet horizontally in a layer, you may only specialize
-  // into a more specific type and doing otherwise will cause a compiler error
+  // into a more specific type and doing otherwise will cause a compiler error.
+  // The specialized packet is a view over the same data, nothing is copied.
   //
   // Example:
   // std::shared_ptr<AvrcpPacket> base;
@@ -75,11 +77,22 @@ class Packet : public std::enable_shared_from_this<Packet> {
                   "Unable to specialize to something that isn't a packet");
     static_assert(std::is_convertible<T*, U*>::value,
                   "Can not convert between the two packet types.");
-    return std::shared_ptr<T>(
-        new T(pkt, pkt->packet_start_index_, pkt->packet_end_index_));
+    return MakeShared<T>(pkt, pkt->packet_start_index_,
+                         pkt->packet_end_index_);
   };
 
  protected:
+  // Make a packet of type T along with its reference count in a single
+  // allocation, which std::make_shared can't do by itself as packet
+  // constructors aren't public.
+  template <class T, class... Args>
+  static std::shared_ptr<T> MakeShared(Args&&... args) {
+    struct SharedPacket : public T {
+      SharedPacket(Args&&... args) : T(std::forward<Args>(args)...) {}
+    };
+    return std::make_shared<SharedPacket>(std::forward<Args>(args)...);
+  }
+
   // Packet should be immutable other than when building
   size_t packet_start_index_;
   size_t packet_end_index_;
@@ -40,4 +40,10 @@ bool PacketBuilder::AddPayloadOctets(const std::shared_ptr<Packet>& pkt,
   return true;
 }
 
+void PacketBuilder::AddPayloadBytes(const std::shared_ptr<Packet>& pkt,
+                                    const uint8_t* data, size_t len) {
+  pkt->data_->insert(pkt->data_->end(), data, data + len);
+  pkt->packet_end_index_ += len;
+}
+
 }  // namespace bluetooth
\ No newline at end of file
@@ -50,6 +50,9 @@ class PacketBuilder {
   bool AddPayloadOctets8(const std::shared_ptr<Packet>& pkt, uint64_t value) {
     return AddPayloadOctets(pkt, 8, value);
   }
+  // Add the |len| bytes at |data| to the payload, in that order
+  void AddPayloadBytes(const std::shared_ptr<Packet>& pkt, const uint8_t* data,
+                       size_t len);
 
  private:
   // Add |octets| bytes to the payload.  Return true if:
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the AVRCP packet parsing, on the packets of
+// packet/tests/test_packets.h and packet/tests/avrcp/avrcp_test_packets.h.
+//
+// Each benchmark starts from a packet holding the received data, like the
+// one ConnectionHandler::MessageCb() gets, and goes through the layers down
+// to the getters the Device uses. They report the number of packets parsed
+// per second, BM_IteratorExtract the number of bytes extracted per second.
+
+#include <benchmark/benchmark.h>
+
+#include "avrcp_test_packets.h"
+#include "get_element_attributes_packet.h"
+#include "packet_test_helper.h"
+#include "register_notification_packet.h"
+#include "test_packets.h"
+#include "vendor_packet.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace avrcp {
+
+// The whole data being the payload, like the VectorPacket made by the
+// AvrcpMessageConverter
+class ReceivedPacket : public ::bluetooth::Packet {
+ public:
+  virtual bool IsValid() const override { return true; }
+  virtual std::string ToString() const override { return ""; }
+
+ protected:
+  using ::bluetooth::Packet::Packet;
+
+ private:
+  virtual std::pair<size_t, size_t> GetPayloadIndecies() const override {
+    return std::pair<size_t, size_t>(packet_start_index_, packet_end_index_);
+  }
+};
+
+using TestReceivedPacket = TestPacketType<ReceivedPacket>;
+using TestAvrcpPacket = TestPacketType<Packet>;
+
+// Get Element Attributes response, parsed down to the vendor header
+void BM_ParseVendorPacket(State& state) {
+  auto received = TestReceivedPacket::Make(test_avrcp_data);
+
+  for (auto _ : state) {
+    auto pkt = Packet::Parse(received);
+    auto vendor_pkt = Packet::Specialize<VendorPacket>(pkt);
+    benchmark::DoNotOptimize(vendor_pkt->IsValid());
+    benchmark::DoNotOptimize(vendor_pkt->GetCommandPdu());
+    benchmark::DoNotOptimize(vendor_pkt->GetParameterLength());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseVendorPacket);
+
+// Get Element Attributes request for all the attributes
+void BM_ParseGetElementAttributesRequest(State& state) {
+  auto received = TestReceivedPacket::Make(get_element_attributes_request_full);
+
+  for (auto _ : state) {
+    auto pkt = Packet::Parse(received);
+    auto vendor_pkt = Packet::Specialize<VendorPacket>(pkt);
+    auto request =
+        Packet::Specialize<GetElementAttributesRequest>(vendor_pkt);
+    benchmark::DoNotOptimize(request->IsValid());
+    benchmark::DoNotOptimize(request->GetIdentifier());
+    benchmark::DoNotOptimize(request->GetAttributesRequested());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseGetElementAttributesRequest);
+
+// Register Notification request for the play status
+void BM_ParseRegisterNotificationRequest(State& state) {
+  auto received = TestReceivedPacket::Make(register_play_status_notification);
+
+  for (auto _ : state) {
+    auto pkt = Packet::Parse(received);
+    auto vendor_pkt = Packet::Specialize<VendorPacket>(pkt);
+    auto request =
+        Packet::Specialize<RegisterNotificationRequest>(vendor_pkt);
+    benchmark::DoNotOptimize(request->IsValid());
+    benchmark::DoNotOptimize(request->GetEventRegistered());
+    benchmark::DoNotOptimize(request->GetInterval());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseRegisterNotificationRequest);
+
+// Extracts the whole L2CAP test packet, range(0) bytes at a time
+void BM_IteratorExtract(State& state) {
+  auto pkt = TestAvrcpPacket::Make(test_l2cap_data);
+
+  for (auto _ : state) {
+    auto it = pkt->begin();
+    while (pkt->end() - it >= state.range(0)) {
+      switch (state.range(0)) {
+        case 1:
+          benchmark::DoNotOptimize(it.extract8());
+          break;
+        case 2:
+          benchmark::DoNotOptimize(it.extractBE<uint16_t>());
+          break;
+        case 4:
+          benchmark::DoNotOptimize(it.extractBE<uint32_t>());
+          break;
+        default:
+          benchmark::DoNotOptimize(it.extractBE<uint64_t>());
+          break;
+      }
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * test_l2cap_data.size());
+}
+BENCHMARK(BM_IteratorExtract)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+}  // namespace avrcp
+}  // namespace bluetooth
@@ -103,6 +103,31 @@ TEST(GetElementAttributesResponseBuilderTest, builderTest) {
   ASSERT_EQ(test_packet->GetData(), get_elements_attributes_response_full);
 }
 
+TEST(GetElementAttributesResponseBuilderTest, builderEncodedAttributesTest) {
+  auto builder = GetElementAttributesResponseBuilder::MakeBuilder(0xFFFF);
+  builder->AddAttributeEntry(Attribute::TITLE, "Test Song");
+  builder->AddAttributeEntry(Attribute::ARTIST_NAME, "Test Artist");
+  builder->AddAttributeEntry(Attribute::ALBUM_NAME, "Test Album");
+  builder->AddAttributeEntry(Attribute::TRACK_NUMBER, "1");
+  builder->AddAttributeEntry(Attribute::TOTAL_NUMBER_OF_TRACKS, "2");
+  builder->AddAttributeEntry(Attribute::GENRE, "Test Genre");
+  builder->AddAttributeEntry(Attribute::PLAYING_TIME, "1000");
+
+  auto encoded = builder->EncodeAttributes();
+  ASSERT_EQ(encoded->size(), builder->size() - VendorPacket::kMinSize());
+
+  // A builder made from the encoded attributes sends the same response
+  auto encoded_builder =
+      GetElementAttributesResponseBuilder::MakeBuilder(encoded);
+  ASSERT_EQ(encoded_builder->size(),
+            get_elements_attributes_response_full.size());
+  ASSERT_EQ(encoded_builder->EncodeAttributes(), encoded);
+
+  auto test_packet = TestGetElemAttrReqPacket::Make();
+  encoded_builder->Serialize(test_packet);
+  ASSERT_EQ(test_packet->GetData(), get_elements_attributes_response_full);
+}
+
 TEST(GetElementAttributesResponseBuilderTest, truncateBuilderTest) {
   auto attribute = AttributeEntry(Attribute::TITLE, "1234");
   size_t truncated_size = VendorPacket::kMinSize();
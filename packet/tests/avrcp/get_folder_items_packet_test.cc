@@ -144,6 +144,29 @@ TEST(GetFolderItemsResponseBuilderTest, builderSongAddMtuTest) {
   ASSERT_TRUE(builder->AddSong(song3));
 }
 
+TEST(GetFolderItemsResponseBuilderTest, builderEncodedItemTest) {
+  std::set<AttributeEntry> attributes;
+  attributes.insert(AttributeEntry(Attribute::TITLE, "Test Title"));
+  auto song = GetFolderItemsResponseBuilder::EncodeSong(
+      MediaElementItem(0x02, "Test Title", attributes));
+
+  // The same encoding can be added to several responses
+  for (int i = 0; i < 2; i++) {
+    auto builder = GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(
+        Status::NO_ERROR, 0x0000, 0xFFFF);
+    ASSERT_TRUE(builder->AddEncodedItem(song));
+    ASSERT_EQ(builder->size(), get_folder_items_song_response.size());
+
+    auto test_packet = TestGetFolderItemsReqPacket::Make();
+    builder->Serialize(test_packet);
+    ASSERT_EQ(test_packet->GetData(), get_folder_items_song_response);
+  }
+
+  auto builder = GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(
+      Status::NO_ERROR, 0x0000, get_folder_items_song_response.size() - 1);
+  ASSERT_FALSE(builder->AddEncodedItem(song));
+}
+
 TEST(GetFolderItemsResponseBuilderTest, builderNoItemsTest) {
   auto builder = GetFolderItemsResponseBuilder::MakePlayerListBuilder(
       Status::NO_ERROR, 0x0000, 0xFFFF);
@@ -99,6 +99,19 @@ TEST_P(IteratorTest, extractBoundsDeathTest) {
                "index_ != packet_->packet_end_index_");
 }
 
+TEST_P(IteratorTest, extractPartialBoundsDeathTest) {
+  auto packet = GetTestPacket();
+  Iterator bounds_test = packet->end() - static_cast<size_t>(2);
+  ASSERT_DEATH(bounds_test.extract<uint32_t>(),
+               "length <= packet_->packet_end_index_ - index_");
+  ASSERT_DEATH(bounds_test.extractBE<uint64_t>(),
+               "length <= packet_->packet_end_index_ - index_");
+
+  // The bytes left can still be extracted
+  ASSERT_EQ(test_l2cap_data[GetLowerBound() + GetTestPacketLength() - 2],
+            bounds_test.extract<uint8_t>());
+}
+
 TEST_P(IteratorTest, extractBEBoundsDeathTest) {
   auto packet = GetTestPacket();
   Iterator bounds_test = packet->end();
@@ -35,6 +35,13 @@ namespace avrcp {
 #define VOL_NOT_SUPPORTED -1
 #define VOL_REGISTRATION_FAILED -2
 
+// Maximum number of VFS item encodings cached per device
+#define MAX_CACHED_FOLDER_ITEMS 1024
+
+// Minimum time between two play position changed notifications, however
+// often the media layer reports an update
+#define MIN_PLAY_POS_CHANGED_INTERVAL_MS 500
+
 Device::Device(
     const RawAddress& bdaddr, bool avrcp13_compatibility,
     base::Callback<void(uint8_t label, bool browse,
@@ -46,7 +53,8 @@ Device::Device(
       avrcp13_compatibility_(avrcp13_compatibility),
       send_message_cb_(send_msg_cb),
       ctrl_mtu_(ctrl_mtu),
-      browse_mtu_(browse_mtu) {}
+      browse_mtu_(browse_mtu),
+      vfs_item_cache_(MAX_CACHED_FOLDER_ITEMS) {}
 
 void Device::RegisterInterfaces(MediaInterface* media_interface,
                                 A2dpInterface* a2dp_interface,
@@ -152,6 +160,12 @@ void Device::VendorPacketHandler(uint8_t label,
         auto response = RejectBuilder::MakeBuilder(pkt->GetCommandPdu(), Status::INVALID_PARAMETER);
         send_message(label, false, std::move(response));
       }
+
+      if (element_attributes_cache_.valid()) {
+        GetElementAttributesResponse(label, get_element_attributes_request_pkt,
+                                     element_attributes_cache_.song_info());
+        break;
+      }
       media_interface_->GetSongInfo(base::Bind(&Device::GetElementAttributesResponse, weak_ptr_factory_.GetWeakPtr(),
                                                label, get_element_attributes_request_pkt));
     } break;
@@ -413,8 +427,11 @@ void Device::TrackChangedNotificationResponse(uint8_t label, bool interim,
   DEVICE_VLOG(1) << __func__;
   uint64_t uid = 0;
 
+  if (!interim) track_update_pending_ = false;
+
   if (interim) {
     track_changed_ = Notification(true, label);
+  } else if (!track_changed_.first) {
   } else if (!track_changed_.first) {
     DEVICE_VLOG(0) << __func__ << ": Device not registered for update";
     return;
@@ -453,6 +470,7 @@ void Device::TrackChangedNotificationResponse(uint8_t label, bool interim,
 void Device::PlaybackStatusNotificationResponse(uint8_t label, bool interim,
                                                 PlayStatus status) {
   DEVICE_VLOG(1) << __func__;
+  if (!interim) play_status_update_pending_ = false;
   if (status.state == PlayState::PAUSED) play_pos_update_cb_.Cancel();
 
   if (interim) {
@@ -487,6 +505,7 @@ void Device::PlaybackStatusNotificationResponse(uint8_t label, bool interim,
 void Device::PlaybackPosNotificationResponse(uint8_t label, bool interim,
                                              PlayStatus status) {
   DEVICE_VLOG(4) << __func__;
+  if (!interim) play_pos_update_pending_ = false;
 
   if (interim) {
     play_pos_changed_ = Notification(true, label);
@@ -511,6 +530,7 @@ void Device::PlaybackPosNotificationResponse(uint8_t label, bool interim,
   if (!interim) {
     active_labels_.erase(label);
     play_pos_changed_ = Notification(false, 0);
+    last_play_pos_changed_time_ = base::TimeTicks::Now();
   }
 
   // We still try to send updates while music is playing to the non active
@@ -518,14 +538,17 @@ void Device::PlaybackPosNotificationResponse(uint8_t label, bool interim,
   // the status bar on the remote device move.
   if (status.state == PlayState::PLAYING && !IsInSilenceMode()) {
     DEVICE_VLOG(0) << __func__ << ": Queue next play position update";
-    play_pos_update_cb_.Reset(base::Bind(&Device::HandlePlayPosUpdate,
-                                         weak_ptr_factory_.GetWeakPtr()));
-    base::MessageLoop::current()->task_runner()->PostDelayedTask(
-        FROM_HERE, play_pos_update_cb_.callback(),
-        base::TimeDelta::FromSeconds(play_pos_interval_));
+    SchedulePlayPosUpdate(base::TimeDelta::FromSeconds(play_pos_interval_));
   }
 }
 
+void Device::SchedulePlayPosUpdate(base::TimeDelta delay) {
+  play_pos_update_cb_.Reset(base::Bind(&Device::HandlePlayPosUpdate,
+                                       weak_ptr_factory_.GetWeakPtr()));
+  base::MessageLoop::current()->task_runner()->PostDelayedTask(
+      FROM_HERE, play_pos_update_cb_.callback(), delay);
+}
+
 // TODO (apanicke): Finish implementing when we add support for more than one
 // player
 void Device::AddressedPlayerNotificationResponse(
@@ -593,10 +616,26 @@ void Device::GetElementAttributesResponse(
   auto attributes_requested =
       get_element_attributes_pkt->GetAttributesRequested();
 
-  auto response = GetElementAttributesResponseBuilder::MakeBuilder(ctrl_mtu_);
+  // Song info coming from the media interface is current until the next
+  // metadata update, see SendMediaUpdate()
+  if (!element_attributes_cache_.valid()) {
+    element_attributes_cache_.update(info);
+  }
 
+  uint32_t attributes_key =
+      ElementAttributesCache::AttributesKey(*get_element_attributes_pkt);
+  auto encoded = element_attributes_cache_.get(attributes_key);
   last_song_info_ = info;
 
+  if (encoded != nullptr) {
+    DEVICE_VLOG(3) << __func__ << ": Sending cached attributes";
+    send_message(label, false,
+                 GetElementAttributesResponseBuilder::MakeBuilder(encoded));
+    return;
+  }
+
+  auto response = GetElementAttributesResponseBuilder::MakeBuilder(ctrl_mtu_);
+
   if (attributes_requested.size() != 0) {
     for (const auto& attribute : attributes_requested) {
       if (info.attributes.find(attribute) != info.attributes.end()) {
@@ -609,6 +648,8 @@ void Device::GetElementAttributesResponse(
     }
   }
 
+  element_attributes_cache_.insert(attributes_key,
+                                   response->EncodeAttributes());
   send_message(label, false, std::move(response));
 }
 
@@ -1135,6 +1176,30 @@ std::set<AttributeEntry> filter_attributes_requested(
   return result;
 }
 
+// Encodes a VFS item with the attributes requested by |pkt|
+static GetFolderItemsResponseBuilder::EncodedItem encode_vfs_item(
+    const ListItem& item, uint64_t uid, const GetFolderItemsRequest& pkt) {
+  if (item.type == ListItem::FOLDER) {
+    // right now we always use folders of mixed type
+    return GetFolderItemsResponseBuilder::EncodeFolder(
+        FolderItem(uid, 0x00, item.folder.is_playable, item.folder.name));
+  }
+
+  const auto& song = item.song;
+  auto title = song.attributes.find(Attribute::TITLE) != song.attributes.end()
+                   ? song.attributes.find(Attribute::TITLE)->value()
+                   : "No Song Info";
+  MediaElementItem song_item(uid, title, std::set<AttributeEntry>());
+
+  if (pkt.GetNumAttributes() == 0x00) {  // All attributes requested
+    song_item.attributes_ = song.attributes;
+  } else {
+    song_item.attributes_ =
+        filter_attributes_requested(song, pkt.GetAttributesRequested());
+  }
+  return GetFolderItemsResponseBuilder::EncodeSong(song_item);
+}
+
 void Device::GetVFSListResponse(uint8_t label,
                                 std::shared_ptr<GetFolderItemsRequest> pkt,
                                 std::vector<ListItem> items) {
@@ -1144,50 +1209,31 @@ void Device::GetVFSListResponse(uint8_t label,
   // The builder will automatically correct the status if there are zero items
   auto builder = GetFolderItemsResponseBuilder::MakeVFSBuilder(
       Status::NO_ERROR, 0x0000, browse_mtu_);
-
-  // TODO (apanicke): Add test that checks if vfs_ids_ is the correct size after
-  // an operation.
-  for (const auto& item : items) {
-    if (item.type == ListItem::FOLDER) {
-      vfs_ids_.insert(item.folder.media_id);
-    } else if (item.type == ListItem::SONG) {
-      vfs_ids_.insert(item.song.media_id);
-    }
-  }
-
-  // Add the elements retrieved in the last get folder items request and map
-  // them to UIDs The maps will be cleared every time a directory change
-  // happens. These items do not need to correspond with the now playing list as
-  // the UID's only need to be unique in the context of the current scope and
-  // the current folder
+  uint32_t attributes_key = FolderItemCache::AttributesKey(*pkt);
+
+  // Map the elements of the requested page to UIDs, the other ones get theirs
+  // when they are requested. These items do not need to correspond with the
+  // now playing list as the UID's only need to be unique in the context of
+  // the current scope. Only the items that fit in one response are encoded,
+  // and the encodings are cached to serve the same items again without
+  // encoding them.
   for (auto i = pkt->GetStartItem(); i <= pkt->GetEndItem() && i < items.size();
        i++) {
-    if (items[i].type == ListItem::FOLDER) {
-      auto folder = items[i].folder;
-      // right now we always use folders of mixed type
-      FolderItem folder_item(vfs_ids_.get_uid(folder.media_id), 0x00,
-                             folder.is_playable, folder.name);
-      if (!builder->AddFolder(folder_item)) break;
-    } else if (items[i].type == ListItem::SONG) {
-      auto song = items[i].song;
-      auto title =
-          song.attributes.find(Attribute::TITLE) != song.attributes.end()
-              ? song.attributes.find(Attribute::TITLE)->value()
-              : "No Song Info";
-      MediaElementItem song_item(vfs_ids_.get_uid(song.media_id), title,
-                                 std::set<AttributeEntry>());
-
-      if (pkt->GetNumAttributes() == 0x00) {  // All attributes requested
-        song_item.attributes_ = std::move(song.attributes);
-      } else {
-        song_item.attributes_ =
-            filter_attributes_requested(song, pkt->GetAttributesRequested());
-      }
-
-      // If we fail to add a song, don't accidentally add one later that might
-      // fit.
-      if (!builder->AddSong(song_item)) break;
+    const ListItem& item = items[i];
+    if (item.type != ListItem::FOLDER && item.type != ListItem::SONG) continue;
+
+    uint64_t uid = vfs_ids_.insert(item.type == ListItem::FOLDER
+                                       ? item.folder.media_id
+                                       : item.song.media_id);
+    auto encoded_item = vfs_item_cache_.get(uid, attributes_key);
+    if (encoded_item == nullptr) {
+      encoded_item = encode_vfs_item(item, uid, *pkt);
+      vfs_item_cache_.insert(uid, attributes_key, encoded_item);
     }
+
+    // If we fail to add an item, don't accidentally add one later that might
+    // fit.
+    if (!builder->AddEncodedItem(encoded_item)) break;
   }
 
   send_message(label, true, std::move(builder));
@@ -1207,14 +1253,14 @@ void Device::GetNowPlayingListResponse(
 
   for (size_t i = pkt->GetStartItem();
        i <= pkt->GetEndItem() && i < song_list.size(); i++) {
-    auto song = song_list[i];
+    const auto& song = song_list[i];
     auto title = song.attributes.find(Attribute::TITLE) != song.attributes.end()
                      ? song.attributes.find(Attribute::TITLE)->value()
                      : "No Song Info";
 
     MediaElementItem item(i + 1, title, std::set<AttributeEntry>());
     if (pkt->GetNumAttributes() == 0x00) {
-      item.attributes_ = std::move(song.attributes);
+      item.attributes_ = song.attributes;
     } else {
       item.attributes_ =
           filter_attributes_requested(song, pkt->GetAttributesRequested());
@@ -1258,6 +1304,7 @@ void Device::SetBrowsedPlayerResponse(
   }
 
   curr_browsed_player_id_ = pkt->GetPlayerId();
+  vfs_item_cache_.clear();
 
   // Clear the path and push the new root.
   current_path_ = std::stack<std::string>();
@@ -1276,6 +1323,8 @@ void Device::SendMediaUpdate(bool metadata, bool play_status, bool queue) {
                  << " : play_status= " << play_status << " : queue=" << queue
                  << " ; is_silence=" << is_silence;
 
+  if (metadata) element_attributes_cache_.invalidate();
+
   if (queue) {
     HandleNowPlayingUpdate();
   }
@@ -1295,6 +1344,10 @@ void Device::SendFolderUpdate(bool available_players, bool addressed_player,
   CHECK(media_interface_);
   DEVICE_VLOG(4) << __func__;
 
+  // The media layer changed, so the cached items may no longer be up to date
+  vfs_item_cache_.clear();
+  if (addressed_player) element_attributes_cache_.invalidate();
+
   if (available_players) {
     HandleAvailablePlayerUpdate();
   }
@@ -1311,6 +1364,12 @@ void Device::HandleTrackUpdate() {
     return;
   }
 
+  if (track_update_pending_) {
+    DEVICE_VLOG(3) << __func__ << ": Track changed update already pending";
+    return;
+  }
+
+  track_update_pending_ = true;
   media_interface_->GetNowPlayingList(
       base::Bind(&Device::TrackChangedNotificationResponse,
                  weak_ptr_factory_.GetWeakPtr(), track_changed_.second, false));
@@ -1323,6 +1382,12 @@ void Device::HandlePlayStatusUpdate() {
     return;
   }
 
+  if (play_status_update_pending_) {
+    DEVICE_VLOG(3) << __func__ << ": Play status update already pending";
+    return;
+  }
+
+  play_status_update_pending_ = true;
   media_interface_->GetPlayStatus(base::Bind(
       &Device::PlaybackStatusNotificationResponse,
       weak_ptr_factory_.GetWeakPtr(), play_status_changed_.second, false));
@@ -1373,6 +1438,24 @@ void Device::HandlePlayPosUpdate() {
     return;
   }
 
+  if (play_pos_update_pending_) {
+    DEVICE_VLOG(3) << __func__ << ": Play position update already pending";
+    return;
+  }
+
+  // Seeking reports a play status update for every step, hold back the
+  // position changes following the last one too closely
+  base::TimeDelta min_interval =
+      base::TimeDelta::FromMilliseconds(MIN_PLAY_POS_CHANGED_INTERVAL_MS);
+  base::TimeDelta elapsed =
+      base::TimeTicks::Now() - last_play_pos_changed_time_;
+  if (!last_play_pos_changed_time_.is_null() && elapsed < min_interval) {
+    DEVICE_VLOG(3) << __func__ << ": Deferring play position update";
+    SchedulePlayPosUpdate(min_interval - elapsed);
+    return;
+  }
+
+  play_pos_update_pending_ = true;
   media_interface_->GetPlayStatus(base::Bind(
       &Device::PlaybackPosNotificationResponse, weak_ptr_factory_.GetWeakPtr(),
       play_pos_changed_.second, false));
@@ -1412,6 +1495,7 @@ void Device::HandleAddressedPlayerUpdate() {
 void Device::DeviceDisconnected() {
   DEVICE_LOG(INFO) << "Device was disconnected";
   play_pos_update_cb_.Cancel();
+  element_attributes_cache_.invalidate();
 
   // TODO (apanicke): Once the interfaces are set in the Device construction,
   // remove these conditionals.
@@ -1449,6 +1533,8 @@ std::ostream& operator<<(std::ostream& out, const Device& d) {
   out << "Last Play State: " << d.last_play_status_.state << std::endl;
   out << "Last Song Sent ID: \"" << d.last_song_info_.media_id << "\"\n";
   out << "Current Folder: \"" << d.CurrentFolder() << "\"\n";
+  out << "Cached VFS Items: " << d.vfs_item_cache_.size() << "\n";
+  out << "Song Info Cached: " << d.element_attributes_cache_.valid() << "\n";
   out << "MTU Sizes: CTRL=" << d.ctrl_mtu_ << " BROWSE=" << d.browse_mtu_
       << std::endl;
   // TODO (apanicke): Add supported features as well as media keys
@@ -22,6 +22,7 @@
 
 #include <base/bind.h>
 #include <base/cancelable_callback.h>
+#include <base/time/time.h>
 
 #include "avrcp_internal.h"
 #include "hardware/avrcp/avrcp.h"
@@ -38,6 +39,8 @@
 #include "packet/avrcp/set_addressed_player.h"
 #include "packet/avrcp/set_browsed_player.h"
 #include "packet/avrcp/vendor_packet.h"
+#include "profile/avrcp/element_attributes_cache.h"
+#include "profile/avrcp/folder_item_cache.h"
 #include "profile/avrcp/media_id_map.h"
 #include "raw_address.h"
 
@@ -110,7 +113,8 @@ class Device {
   /**
    * Notify the device that metadata, play_status, and/or queue have updated
    * via a boolean. Each boolean represents whether its respective content has
-   * updated.
+   * updated. The song info of the current track is cached until an update
+   * with metadata set comes in.
    */
   virtual void SendMediaUpdate(bool metadata, bool play_status, bool queue);
 
@@ -162,6 +166,7 @@ class Device {
 
   // PLAY POSITION CHANGED
   virtual void HandlePlayPosUpdate();
+  virtual void SchedulePlayPosUpdate(base::TimeDelta delay);
   virtual void PlaybackPosNotificationResponse(uint8_t label, bool interim,
                                                PlayStatus status);
 
@@ -310,15 +315,30 @@ class Device {
   Notification avail_players_changed_ = Notification(false, 0);
   Notification uids_changed_ = Notification(false, 0);
 
+  // Whether the media interface is already being asked for a changed
+  // notification. Since a notification is only sent once per registration,
+  // further updates until the answer comes back can be dropped.
+  bool track_update_pending_ = false;
+  bool play_status_update_pending_ = false;
+  bool play_pos_update_pending_ = false;
+
   MediaIdMap vfs_ids_;
   MediaIdMap now_playing_ids_;
 
+  // Encodings of the VFS items, keyed by their vfs_ids_ UID
+  FolderItemCache vfs_item_cache_;
+
+  // Song info and encoded Get Element Attributes responses of the current
+  // track
+  ElementAttributesCache element_attributes_cache_;
+
   uint32_t play_pos_interval_ = 0;
 
   SongInfo last_song_info_;
   PlayStatus last_play_status_;
 
   base::CancelableClosure play_pos_update_cb_;
+  base::TimeTicks last_play_pos_changed_time_;
 
   MediaInterface* media_interface_ = nullptr;
   A2dpInterface* a2dp_interface_ = nullptr;
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+#include "hardware/avrcp/avrcp.h"
+#include "packet/avrcp/get_element_attributes_packet.h"
+
+namespace bluetooth {
+namespace avrcp {
+
+// The song info of the current track along with the Get Element Attributes
+// responses already encoded for it, so that a remote device asking for the
+// metadata over and over again doesn't go through the media interface each
+// time. The cache is only valid until the media layer reports a metadata
+// change.
+class ElementAttributesCache {
+ public:
+  using EncodedAttributes =
+      GetElementAttributesResponseBuilder::EncodedAttributes;
+
+  bool valid() const { return valid_; }
+
+  const SongInfo& song_info() const { return song_info_; }
+
+  void update(const SongInfo& info) {
+    song_info_ = info;
+    valid_ = true;
+    encoded_.clear();
+  }
+
+  void invalidate() {
+    valid_ = false;
+    encoded_.clear();
+  }
+
+  // Returns an identifier of the attributes requested by |pkt|, or 0 if they
+  // are not cacheable
+  static uint32_t AttributesKey(const GetElementAttributesRequest& pkt) {
+    // Zero attributes means all of them
+    if (pkt.GetNumAttributes() == 0x00) return 0x00000001;
+
+    uint32_t key = 0x80000000;
+    for (const auto& attribute : pkt.GetAttributesRequested()) {
+      if ((uint32_t)attribute == 0 || (uint32_t)attribute >= 31) return 0;
+      key |= 1u << (uint32_t)attribute;
+    }
+    return key;
+  }
+
+  EncodedAttributes get(uint32_t attributes_key) const {
+    const auto& it = encoded_.find(attributes_key);
+    if (!valid_ || it == encoded_.end()) return nullptr;
+    return it->second;
+  }
+
+  void insert(uint32_t attributes_key, EncodedAttributes attributes) {
+    if (!valid_ || attributes_key == 0) return;
+    encoded_[attributes_key] = std::move(attributes);
+  }
+
+ private:
+  bool valid_ = false;
+  SongInfo song_info_;
+  std::unordered_map<uint32_t, EncodedAttributes> encoded_;
+};
+
+}  // namespace avrcp
+}  // namespace bluetooth
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "packet/avrcp/get_folder_items.h"
+
+namespace bluetooth {
+namespace avrcp {
+
+// A cache of the Get Folder Items encodings of browsed items, keyed by the
+// UIDs the MediaIdMap gave them, so that paging through a large folder
+// doesn't encode the same items again. An item is cached along with the
+// attributes requested when it was encoded, see AttributesKey().
+class FolderItemCache {
+ public:
+  using EncodedItem = GetFolderItemsResponseBuilder::EncodedItem;
+
+  explicit FolderItemCache(size_t max_items) : max_items_(max_items) {}
+
+  void clear() { items_.clear(); }
+
+  size_t size() const { return items_.size(); }
+
+  // Returns an identifier of the attributes requested by |pkt|, or 0 if they
+  // are not cacheable
+  static uint32_t AttributesKey(const GetFolderItemsRequest& pkt) {
+    // Zero attributes means all of them
+    if (pkt.GetNumAttributes() == 0x00) return 0x00000001;
+
+    uint32_t key = 0x80000000;
+    for (const auto& attribute : pkt.GetAttributesRequested()) {
+      if ((uint32_t)attribute == 0 || (uint32_t)attribute >= 31) return 0;
+      key |= 1u << (uint32_t)attribute;
+    }
+    return key;
+  }
+
+  EncodedItem get(uint64_t uid, uint32_t attributes_key) const {
+    const auto& it = items_.find(uid);
+    if (it == items_.end() || it->second.attributes_key != attributes_key) {
+      return nullptr;
+    }
+    return it->second.item;
+  }
+
+  void insert(uint64_t uid, uint32_t attributes_key, EncodedItem item) {
+    if (attributes_key == 0) return;
+
+    // Browsing moves on through the folders, so start over rather than keep
+    // track of the least recently used items
+    if (items_.size() >= max_items_ && items_.find(uid) == items_.end()) {
+      items_.clear();
+    }
+    items_[uid] = Entry{attributes_key, std::move(item)};
+  }
+
+ private:
+  struct Entry {
+    uint32_t attributes_key;
+    EncodedItem item;
+  };
+
+  size_t max_items_;
+  std::unordered_map<uint64_t, Entry> items_;
+};
+
+}  // namespace avrcp
+}  // namespace bluetooth
@@ -288,6 +288,52 @@ TEST_F(AvrcpDeviceTest, trackChangedBeforeInterimTest) {
   changed_cb.Run("test_id", list);
 }
 
+TEST_F(AvrcpDeviceTest, trackChangedCoalescingTest) {
+  MockMediaInterface interface;
+  NiceMock<MockA2dpInterface> a2dp_interface;
+
+  test_device->RegisterInterfaces(&interface, &a2dp_interface, nullptr);
+
+  // Pretend the device is active
+  EXPECT_CALL(a2dp_interface, active_peer())
+      .WillRepeatedly(Return(test_device->GetAddress()));
+
+  SongInfo info = {"test_id",
+                   {AttributeEntry(Attribute::TITLE, "Test Song")}};
+  std::vector<SongInfo> list = {info};
+
+  MediaInterface::NowPlayingCallback changed_cb;
+
+  // The updates coming in while the first one is pending are dropped
+  EXPECT_CALL(interface, GetNowPlayingList(_))
+      .Times(2)
+      .WillOnce(InvokeCb<0>("test_id", list))
+      .WillOnce(SaveArg<0>(&changed_cb));
+
+  ::testing::InSequence s;
+  auto interim_response =
+      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(true, 0x01);
+  EXPECT_CALL(response_cb,
+              Call(1, false, matchPacket(std::move(interim_response))))
+      .Times(1);
+  auto changed_response =
+      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(false, 0x01);
+  EXPECT_CALL(response_cb,
+              Call(1, false, matchPacket(std::move(changed_response))))
+      .Times(1);
+
+  auto request =
+      RegisterNotificationRequestBuilder::MakeBuilder(Event::TRACK_CHANGED, 0);
+  auto pkt = TestAvrcpPacket::Make();
+  request->Serialize(pkt);
+  SendMessage(1, pkt);
+
+  test_device->HandleTrackUpdate();
+  test_device->HandleTrackUpdate();
+  test_device->HandleTrackUpdate();
+  changed_cb.Run("test_id", list);
+}
+
 TEST_F(AvrcpDeviceTest, playStatusChangedBeforeInterimTest) {
   MockMediaInterface interface;
   NiceMock<MockA2dpInterface> a2dp_interface;
@@ -648,6 +694,55 @@ TEST_F(AvrcpDeviceTest, getElementAttributesMtuTest) {
       1, TestAvrcpPacket::Make(get_element_attributes_request_full));
 }
 
+TEST_F(AvrcpDeviceTest, getElementAttributesCacheTest) {
+  MockMediaInterface interface;
+  NiceMock<MockA2dpInterface> a2dp_interface;
+
+  test_device->RegisterInterfaces(&interface, &a2dp_interface, nullptr);
+
+  SongInfo info = {"test_id",
+                   {AttributeEntry(Attribute::TITLE, "Test Song"),
+                    AttributeEntry(Attribute::ARTIST_NAME, "Test Artist")}};
+  SongInfo next_info = {"next_id",
+                        {AttributeEntry(Attribute::TITLE, "Next Song")}};
+
+  // The song info is only fetched again after a metadata update
+  EXPECT_CALL(interface, GetSongInfo(_))
+      .Times(2)
+      .WillOnce(InvokeCb<0>(info))
+      .WillOnce(InvokeCb<0>(next_info));
+
+  auto compare_to_partial =
+      GetElementAttributesResponseBuilder::MakeBuilder(0xFFFF);
+  compare_to_partial->AddAttributeEntry(Attribute::TITLE, "Test Song");
+  EXPECT_CALL(response_cb,
+              Call(1, false, matchPacket(std::move(compare_to_partial))))
+      .Times(1);
+  SendMessage(1, TestAvrcpPacket::Make(get_element_attributes_request_partial));
+
+  auto compare_to_full =
+      GetElementAttributesResponseBuilder::MakeBuilder(0xFFFF);
+  compare_to_full->AddAttributeEntry(Attribute::TITLE, "Test Song");
+  compare_to_full->AddAttributeEntry(Attribute::ARTIST_NAME, "Test Artist");
+  EXPECT_CALL(response_cb,
+              Call(2, false, matchPacket(std::move(compare_to_full))))
+      .Times(2);
+  SendMessage(2, TestAvrcpPacket::Make(get_element_attributes_request_full));
+
+  // Sent again from the cached encoding
+  SendMessage(2, TestAvrcpPacket::Make(get_element_attributes_request_full));
+
+  test_device->SendMediaUpdate(true, false, false);
+
+  auto compare_to_next =
+      GetElementAttributesResponseBuilder::MakeBuilder(0xFFFF);
+  compare_to_next->AddAttributeEntry(Attribute::TITLE, "Next Song");
+  EXPECT_CALL(response_cb,
+              Call(3, false, matchPacket(std::move(compare_to_next))))
+      .Times(1);
+  SendMessage(3, TestAvrcpPacket::Make(get_element_attributes_request_full));
+}
+
 TEST_F(AvrcpDeviceTest, getTotalNumberOfItemsMediaPlayersTest) {
   MockMediaInterface interface;
   NiceMock<MockA2dpInterface> a2dp_interface;
@@ -841,6 +936,71 @@ TEST_F(AvrcpDeviceTest, getFolderItemsMtuTest) {
       1, TestBrowsePacket::Make(get_folder_items_request_vfs));
 }
 
+TEST_F(AvrcpDeviceTest, getFolderItemsPagingTest) {
+  MockMediaInterface interface;
+  NiceMock<MockA2dpInterface> a2dp_interface;
+
+  test_device->RegisterInterfaces(&interface, &a2dp_interface, nullptr);
+
+  SongInfo song0 = {"test_id0",
+                    {AttributeEntry(Attribute::TITLE, "Test Song0"),
+                     AttributeEntry(Attribute::ARTIST_NAME, "Test Artist")}};
+  SongInfo song1 = {"test_id1",
+                    {AttributeEntry(Attribute::TITLE, "Test Song1"),
+                     AttributeEntry(Attribute::ARTIST_NAME, "Test Artist")}};
+  SongInfo song2 = {"test_id2",
+                    {AttributeEntry(Attribute::TITLE, "Test Song2"),
+                     AttributeEntry(Attribute::ARTIST_NAME, "Test Artist")}};
+  std::vector<ListItem> list = {{ListItem::SONG, FolderInfo(), song0},
+                                {ListItem::SONG, FolderInfo(), song1},
+                                {ListItem::SONG, FolderInfo(), song2}};
+  EXPECT_CALL(interface, GetFolderItems(_, "", _))
+      .WillRepeatedly(InvokeCb<2>(list));
+
+  // UIDs are given in the order the items are requested in. Requests without
+  // attributes get items without attributes.
+  auto response = GetFolderItemsResponseBuilder::MakeVFSBuilder(
+      Status::NO_ERROR, 0x0000, 0xFFFF);
+  response->AddSong(
+      MediaElementItem(1, "Test Song1", std::set<AttributeEntry>()));
+  response->AddSong(
+      MediaElementItem(2, "Test Song2", std::set<AttributeEntry>()));
+  EXPECT_CALL(response_cb, Call(1, true, matchPacket(std::move(response))))
+      .Times(1);
+  auto request_builder =
+      GetFolderItemsRequestBuilder::MakeBuilder(Scope::VFS, 1, 2, {});
+  auto request = TestBrowsePacket::Make();
+  request_builder->Serialize(request);
+  SendBrowseMessage(1, request);
+
+  // The cached items are served again with the attributes requested
+  response = GetFolderItemsResponseBuilder::MakeVFSBuilder(Status::NO_ERROR,
+                                                           0x0000, 0xFFFF);
+  response->AddSong(MediaElementItem(
+      3, "Test Song0", {AttributeEntry(Attribute::TITLE, "Test Song0")}));
+  response->AddSong(MediaElementItem(
+      1, "Test Song1", {AttributeEntry(Attribute::TITLE, "Test Song1")}));
+  EXPECT_CALL(response_cb, Call(2, true, matchPacket(std::move(response))))
+      .Times(1);
+  request_builder = GetFolderItemsRequestBuilder::MakeBuilder(
+      Scope::VFS, 0, 1, {Attribute::TITLE});
+  request = TestBrowsePacket::Make();
+  request_builder->Serialize(request);
+  SendBrowseMessage(2, request);
+
+  response = GetFolderItemsResponseBuilder::MakeVFSBuilder(Status::NO_ERROR,
+                                                           0x0000, 0xFFFF);
+  response->AddSong(
+      MediaElementItem(2, "Test Song2", std::set<AttributeEntry>()));
+  EXPECT_CALL(response_cb, Call(3, true, matchPacket(std::move(response))))
+      .Times(1);
+  request_builder =
+      GetFolderItemsRequestBuilder::MakeBuilder(Scope::VFS, 2, 5, {});
+  request = TestBrowsePacket::Make();
+  request_builder->Serialize(request);
+  SendBrowseMessage(3, request);
+}
+
 TEST_F(AvrcpDeviceTest, changePathTest) {
   MockMediaInterface interface;
   NiceMock<MockA2dpInterface> a2dp_interface;
@@ -340,6 +340,13 @@ class CLIBluetoothLeScannerCallback
     return Status::ok();
   }
 
+  Status OnBatchScanResults(
+      const std::vector<android::bluetooth::ScanResult>& scan_results)
+      override {
+    for (const auto& scan_result : scan_results) OnScanResult(scan_result);
+    return Status::ok();
+  }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(CLIBluetoothLeScannerCallback);
 };
@@ -116,6 +116,33 @@ void BluetoothLeScannerBinderServer::OnScanResult(
   cb->OnScanResult(result);
 }
 
+bool BluetoothLeScannerBinderServer::OnScanResults(
+    bluetooth::LowEnergyScanner* scanner,
+    const std::vector<bluetooth::ScanResult>& results) {
+  VLOG(2) << __func__ << " - " << results.size() << " results";
+  std::lock_guard<std::mutex> lock(*maps_lock());
+
+  int scanner_id = scanner->GetInstanceId();
+  auto cb = GetLECallback(scanner->GetInstanceId());
+  if (!cb.get()) {
+    VLOG(2) << "Scanner was unregistered - scanner_id: " << scanner_id;
+    return true;
+  }
+
+  // All the results go in a single parcel. A oneway call fails when the
+  // client still has too many transactions to process, the batch is then
+  // kept by the scanner and delivered again with the next one.
+  std::vector<android::bluetooth::ScanResult> parcelables(results.begin(),
+                                                          results.end());
+  Status status = cb->OnBatchScanResults(parcelables);
+  if (!status.isOk()) {
+    VLOG(1) << "Failed to deliver " << results.size()
+            << " scan results - scanner_id: " << scanner_id << ", "
+            << status.toString8();
+  }
+  return status.isOk();
+}
+
 android::sp<IBluetoothLeScannerCallback>
 BluetoothLeScannerBinderServer::GetLECallback(int scanner_id) {
   auto cb = GetCallback(scanner_id);
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <base/macros.h>
 
@@ -63,6 +64,9 @@ class BluetoothLeScannerBinderServer
 
   void OnScanResult(bluetooth::LowEnergyScanner* scanner,
                     const bluetooth::ScanResult& result) override;
+  bool OnScanResults(
+      bluetooth::LowEnergyScanner* scanner,
+      const std::vector<bluetooth::ScanResult>& results) override;
 
  private:
   // Returns a pointer to the IBluetoothLowEnergyCallback instance associated
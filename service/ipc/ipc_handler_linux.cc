@@ -16,8 +16,14 @@
 
 #include "service/ipc/ipc_handler_linux.h"
 
+#include <fcntl.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <unistd.h>
+
+#include <memory>
+#include <unordered_map>
 
 #include <base/bind.h>
 
@@ -28,6 +34,22 @@
 
 namespace ipc {
 
+namespace {
+
+// Maximum number of events handled per epoll_wait call.
+const int kMaxEvents = 32;
+
+// A client of the IPC socket, and the fds it is polled on.
+struct Client {
+  std::unique_ptr<LinuxIPCHost> host;
+  // The GATT pipe of |host| added to the epoll set, -1 if none.
+  int gatt_fd;
+  // True if the IPC socket is polled for writing.
+  bool polling_out;
+};
+
+}  // namespace
+
 IPCHandlerLinux::IPCHandlerLinux(bluetooth::Adapter* adapter,
                                  IPCManager::Delegate* delegate)
     : IPCHandler(adapter, delegate),
@@ -118,14 +140,15 @@ bool IPCHandlerLinux::Run() {
 void IPCHandlerLinux::Stop() {
   keep_running_ = false;
 
-  // At this moment the listening thread might be blocking on the accept
-  // syscall. Shutdown and close the server socket before joining the thread to
-  // interrupt accept so that the main thread doesn't keep blocking.
+  // At this moment the listening thread might be blocking on epoll_wait.
+  // Shutting the server socket down makes it readable for good, which
+  // interrupts the wait, so that the thread can be joined before the socket is
+  // closed under it.
   shutdown(socket_.get(), SHUT_RDWR);
-  socket_.reset();
 
   // Join and clean up the thread.
   thread_.Stop();
+  socket_.reset();
 
   // Thread exited. Notify the delegate. Post this on the event loop so that the
   // callback isn't reentrant.
@@ -149,27 +172,131 @@ void IPCHandlerLinux::StartListeningOnThread() {
 
   NotifyStartedOnOriginThread();
 
-  // TODO(armansito): The code below can cause the daemon to run indefinitely if
-  // the thread is joined while it's in the middle of the EventLoop() call. The
-  // EventLoop() won't exit until a client terminates the connection, however
-  // this can be fixed by using the |thread_|'s MessageLoopForIO instead (since
-  // it gets stopped along with the thread).
-  // TODO(icoolidge): accept simultaneous clients
-  while (keep_running_.load()) {
-    int client_socket = accept4(socket_.get(), nullptr, nullptr, SOCK_NONBLOCK);
-    if (client_socket < 0) {
-      PLOG(ERROR) << "Failed to accept client connection";
-      continue;
-    }
+  ServeClientsOnThread();
+}
+
+void IPCHandlerLinux::ServeClientsOnThread() {
+  base::ScopedFD epoll_fd(epoll_create1(EPOLL_CLOEXEC));
+  if (!epoll_fd.is_valid()) {
+    PLOG(ERROR) << "Failed to create the epoll instance";
+    return;
+  }
 
-    LOG(INFO) << "Established client connection: fd=" << client_socket;
+  // Clients by IPC socket, and the IPC sockets of the clients by GATT pipe.
+  std::unordered_map<int, Client> clients;
+  std::unordered_map<int, int> gatt_fd_clients;
+
+  auto poll_fd = [&epoll_fd](int op, int fd, uint32_t events) {
+    struct epoll_event event = {};
+    event.events = events;
+    event.data.fd = fd;
+    return epoll_ctl(epoll_fd.get(), op, fd, &event) == 0;
+  };
+
+  // Follows the changes of the GATT pipe and of the pending writes of a
+  // client after its handlers ran.
+  auto update_client = [&](Client& client) {
+    int ipc_fd = client.host->ipc_fd();
+    int gatt_fd = client.host->gatt_fd();
+    if (gatt_fd != client.gatt_fd) {
+      // A closed pipe already left the epoll set.
+      if (client.gatt_fd != -1) {
+        epoll_ctl(epoll_fd.get(), EPOLL_CTL_DEL, client.gatt_fd, nullptr);
+        gatt_fd_clients.erase(client.gatt_fd);
+      }
+      if (gatt_fd != -1 && poll_fd(EPOLL_CTL_ADD, gatt_fd, EPOLLIN)) {
+        gatt_fd_clients[gatt_fd] = ipc_fd;
+        client.gatt_fd = gatt_fd;
+      } else {
+        client.gatt_fd = -1;
+      }
+    }
+    bool polling_out = client.host->HasPendingWrites();
+    if (polling_out != client.polling_out &&
+        poll_fd(EPOLL_CTL_MOD, ipc_fd,
+                EPOLLIN | (polling_out ? EPOLLOUT : 0u))) {
+      client.polling_out = polling_out;
+    }
+  };
+
+  auto disconnect_client = [&](int ipc_fd) {
+    auto it = clients.find(ipc_fd);
+    if (it == clients.end()) return;
+    LOG(INFO) << "Closing client connection: fd=" << ipc_fd;
+    if (it->second.gatt_fd != -1) {
+      epoll_ctl(epoll_fd.get(), EPOLL_CTL_DEL, it->second.gatt_fd, nullptr);
+      gatt_fd_clients.erase(it->second.gatt_fd);
+    }
+    epoll_ctl(epoll_fd.get(), EPOLL_CTL_DEL, ipc_fd, nullptr);
+    clients.erase(it);
+  };
+
+  int server_fd = socket_.get();
+  fcntl(server_fd, F_SETFL, fcntl(server_fd, F_GETFL) | O_NONBLOCK);
+  if (!poll_fd(EPOLL_CTL_ADD, server_fd, EPOLLIN)) {
+    PLOG(ERROR) << "Failed to poll the domain socket";
+    return;
+  }
 
-    LinuxIPCHost ipc_host(client_socket, adapter());
+  // Stop() shuts the server socket down, which wakes epoll_wait up.
+  struct epoll_event events[kMaxEvents];
+  while (keep_running_.load()) {
+    int count = epoll_wait(epoll_fd.get(), events, kMaxEvents, -1);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      PLOG(ERROR) << "Failed to wait for IPC events";
+      break;
+    }
 
-    // TODO(armansito): Use |thread_|'s MessageLoopForIO instead of using a
-    // custom event loop to poll from the socket.
-    ipc_host.EventLoop();
+    for (int i = 0; i < count && keep_running_.load(); i++) {
+      int fd = events[i].data.fd;
+      uint32_t ready = events[i].events;
+
+      if (fd == server_fd) {
+        int client_socket = accept4(server_fd, nullptr, nullptr,
+                                    SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket < 0) {
+          if (keep_running_.load() && errno != EAGAIN && errno != EWOULDBLOCK)
+            PLOG(ERROR) << "Failed to accept client connection";
+          continue;
+        }
+        if (!poll_fd(EPOLL_CTL_ADD, client_socket, EPOLLIN)) {
+          PLOG(ERROR) << "Failed to poll client connection";
+          close(client_socket);
+          continue;
+        }
+        LOG(INFO) << "Established client connection: fd=" << client_socket;
+        clients[client_socket] = {
+            std::make_unique<LinuxIPCHost>(client_socket, adapter()), -1,
+            false};
+        continue;
+      }
+
+      auto gatt_it = gatt_fd_clients.find(fd);
+      int ipc_fd = gatt_it != gatt_fd_clients.end() ? gatt_it->second : fd;
+      auto it = clients.find(ipc_fd);
+      // The client was disconnected by an earlier event of this batch.
+      if (it == clients.end()) continue;
+      LinuxIPCHost* host = it->second.host.get();
+
+      bool keep_client;
+      if (fd != ipc_fd) {
+        keep_client = host->OnGattWrite();
+      } else {
+        keep_client = true;
+        if (ready & EPOLLOUT) keep_client = host->OnWritable();
+        if (keep_client && (ready & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+          keep_client = host->OnMessage();
+      }
+
+      if (keep_client)
+        update_client(it->second);
+      else
+        disconnect_client(ipc_fd);
+    }
   }
+
+  while (!clients.empty()) disconnect_client(clients.begin()->first);
 }
 
 void IPCHandlerLinux::ShutDownOnOriginThread() {
@@ -47,6 +47,11 @@ class IPCHandlerLinux : public IPCHandler {
   // Starts listening for incoming connections. Posted on |thread_| by Run().
   void StartListeningOnThread();
 
+  // Accepts clients and serves all of them until Stop() is called, waiting on
+  // their sockets with epoll. A client whose socket is full gets its replies
+  // queued, so that it does not block the others.
+  void ServeClientsOnThread();
+
   // Stops the IPC thread. This helper is needed since base::Thread requires
   // threads to be stopped on the thread that started them.
   void ShutDownOnOriginThread();
@@ -57,15 +57,6 @@ const char kStartServiceCommand[] = "start-service";
 const char kStopServiceCommand[] = "stop-service";
 const char kWriteCharacteristicCommand[] = "write-characteristic";
 
-// Useful values for indexing LinuxIPCHost::pfds_
-// Not super general considering that we should be able to support
-// many GATT FDs owned by one LinuxIPCHost.
-enum {
-  kFdIpc = 0,
-  kFdGatt = 1,
-  kPossibleFds = 2,
-};
-
 bool TokenBool(const std::string& text) { return text == "true"; }
 
 }  // namespace
@@ -73,27 +64,43 @@ bool TokenBool(const std::string& text) { return text == "true"; }
 namespace ipc {
 
 LinuxIPCHost::LinuxIPCHost(int sockfd, Adapter* adapter)
-    : adapter_(adapter), pfds_(1, {sockfd, POLLIN, 0}) {}
+    : adapter_(adapter), ipc_fd_(sockfd), gatt_fd_(-1), write_queue_bytes_(0) {}
 
-LinuxIPCHost::~LinuxIPCHost() { close(pfds_[0].fd); }
+LinuxIPCHost::~LinuxIPCHost() { close(ipc_fd_); }
 
-bool LinuxIPCHost::EventLoop() {
-  while (true) {
-    int status =
-        TEMP_FAILURE_RETRY(ppoll(pfds_.data(), pfds_.size(), nullptr, nullptr));
-    if (status < 1) {
-      LOG_ERROR("ppoll error");
+bool LinuxIPCHost::Send(std::string message) {
+  if (write_queue_.empty()) {
+    ssize_t r;
+    OSI_NO_INTR(r = send(ipc_fd_, message.data(), message.size(), 0));
+    if (r >= 0) return true;
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      LOG_ERROR("Error replying to IPC: %s", strerror(errno));
       return false;
     }
+  }
 
-    if (pfds_[kFdIpc].revents && !OnMessage()) {
-      return false;
-    }
+  if (write_queue_bytes_ + message.size() > kMaxPendingWriteBytes) {
+    LOG_ERROR("%s: client fd=%d is not reading its replies", __func__,
+              ipc_fd_);
+    return false;
+  }
+  write_queue_bytes_ += message.size();
+  write_queue_.push_back(std::move(message));
+  return true;
+}
 
-    if (pfds_.size() == kPossibleFds && pfds_[kFdGatt].revents &&
-        !OnGattWrite()) {
+bool LinuxIPCHost::OnWritable() {
+  while (!write_queue_.empty()) {
+    const std::string& message = write_queue_.front();
+    ssize_t r;
+    OSI_NO_INTR(r = send(ipc_fd_, message.data(), message.size(), 0));
+    if (r < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+      LOG_ERROR("Error replying to IPC: %s", strerror(errno));
       return false;
     }
+    write_queue_bytes_ -= message.size();
+    write_queue_.pop_front();
   }
   return true;
 }
@@ -105,6 +112,8 @@ bool LinuxIPCHost::OnSetAdapterName(const std::string& name) {
 }
 
 bool LinuxIPCHost::OnCreateService(const std::string& service_uuid) {
+  // Replacing a GATT server closes its pipe.
+  gatt_fd_ = -1;
   gatt_servers_[service_uuid] = std::unique_ptr<Server>(new Server);
 
   int gattfd;
@@ -114,15 +123,14 @@ bool LinuxIPCHost::OnCreateService(const std::string& service_uuid) {
     LOG_ERROR("Failed to initialize bluetooth");
     return false;
   }
-  pfds_.resize(kPossibleFds);
-  pfds_[kFdGatt] = {gattfd, POLLIN, 0};
+  gatt_fd_ = gattfd;
   return true;
 }
 
 bool LinuxIPCHost::OnDestroyService(const std::string& service_uuid) {
+  // The GATT server closes its pipe.
   gatt_servers_.erase(service_uuid);
-  close(pfds_[1].fd);
-  pfds_.resize(1);
+  gatt_fd_ = -1;
   return true;
 }
 
@@ -247,9 +255,10 @@ bool LinuxIPCHost::OnMessage() {
   std::string ipc_msg;
   ssize_t size;
 
-  OSI_NO_INTR(size =
-                  recv(pfds_[kFdIpc].fd, &ipc_msg[0], 0, MSG_PEEK | MSG_TRUNC));
+  OSI_NO_INTR(size = recv(ipc_fd_, &ipc_msg[0], 0, MSG_PEEK | MSG_TRUNC));
   if (-1 == size) {
+    // The socket is non-blocking, nothing to read after all.
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
     LOG_ERROR("Error reading datagram size: %s", strerror(errno));
     return false;
   } else if (0 == size) {
@@ -258,7 +267,7 @@ bool LinuxIPCHost::OnMessage() {
   }
 
   ipc_msg.resize(size);
-  OSI_NO_INTR(size = read(pfds_[kFdIpc].fd, &ipc_msg[0], ipc_msg.size()));
+  OSI_NO_INTR(size = read(ipc_fd_, &ipc_msg[0], ipc_msg.size()));
   if (-1 == size) {
     LOG_ERROR("Error reading IPC: %s", strerror(errno));
     return false;
@@ -307,7 +316,7 @@ bool LinuxIPCHost::OnGattWrite() {
   Uuid::UUID128Bit id;
   ssize_t r;
 
-  OSI_NO_INTR(r = read(pfds_[kFdGatt].fd, id.data(), id.size()));
+  OSI_NO_INTR(r = read(gatt_fd_, id.data(), id.size()));
   if (r != id.size()) {
     LOG_ERROR("Error reading GATT attribute ID");
     return false;
@@ -326,13 +335,7 @@ bool LinuxIPCHost::OnGattWrite() {
   transmit += "|" + base::HexEncode(id.data(), id.size());
   transmit += "|" + encoded_value;
 
-  OSI_NO_INTR(r = write(pfds_[kFdIpc].fd, transmit.data(), transmit.size()));
-  if (-1 == r) {
-    LOG_ERROR("Error replying to IPC: %s", strerror(errno));
-    return false;
-  }
-
-  return true;
+  return Send(std::move(transmit));
 }
 
 }  // namespace ipc
@@ -15,9 +15,8 @@
 //
 #pragma once
 
-#include <poll.h>
-
 #include <bluetooth/uuid.h>
+#include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -30,28 +29,50 @@ class Adapter;
 
 namespace ipc {
 
-// This implements a single threaded event loop which dispatches
-// reads from a set of FDs (pfds_) to a set of handlers.
-// Reads from the GATT pipe read end will result in a write to
-// to the IPC socket, and vise versa.
+// This serves a single client of the IPC socket, dispatching its messages to
+// a set of handlers. The event loop of IPCHandlerLinux polls the IPC socket
+// and the GATT pipe of every client, and calls the handlers below when they
+// are ready. Reads from the GATT pipe read end will result in a write to the
+// IPC socket, and vise versa.
 class LinuxIPCHost {
  public:
-  // LinuxIPCHost owns the passed sockfd.
+  // Maximum number of bytes in the messages queued for a client which does not
+  // read its IPC socket. It is disconnected beyond, so that it does not hold
+  // the memory of the daemon.
+  static constexpr size_t kMaxPendingWriteBytes = 256 * 1024;
+
+  // LinuxIPCHost owns the passed sockfd, which must be non-blocking.
   LinuxIPCHost(int sockfd, bluetooth::Adapter* adapter);
   ~LinuxIPCHost();
 
-  // Synchronously handle all events on input FDs.
-  bool EventLoop();
+  // The IPC socket of the client.
+  int ipc_fd() const { return ipc_fd_; }
+
+  // The read end of the GATT pipe of the service of the client, -1 if it has
+  // none.
+  int gatt_fd() const { return gatt_fd_; }
+
+  // True if messages are queued, waiting for the IPC socket to be writable.
+  bool HasPendingWrites() const { return !write_queue_.empty(); }
 
- private:
   // Handler for IPC message receives.
   // Decodes protocol and dispatches to another handler.
+  // The handlers return false when the client must be disconnected.
   bool OnMessage();
 
   // Handler for GATT characteristic writes.
   // Encodes to protocol and transmits IPC.
   bool OnGattWrite();
 
+  // Handler for the IPC socket becoming writable.
+  // Transmits the queued messages.
+  bool OnWritable();
+
+ private:
+  // Transmits |message| without blocking, queueing what the IPC socket cannot
+  // take yet. Returns false when the client has too many messages queued.
+  bool Send(std::string message);
+
   // Applies adapter name changes to stack.
   bool OnSetAdapterName(const std::string& name);
 
@@ -95,8 +116,15 @@ class LinuxIPCHost {
   // weak reference.
   bluetooth::Adapter* adapter_;
 
-  // File descripters that we will block against.
-  std::vector<struct pollfd> pfds_;
+  // See getters above for documentation. |gatt_fd_| is owned by the GATT
+  // server of the service.
+  int ipc_fd_;
+  int gatt_fd_;
+
+  // Messages waiting for the IPC socket to be writable, each one being sent as
+  // a single packet, and their total size.
+  std::deque<std::string> write_queue_;
+  size_t write_queue_bytes_;
 
   // Container for multiple GATT servers. Currently only one is supported.
   // TODO(icoolidge): support many to one for real.
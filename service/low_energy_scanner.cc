@@ -25,6 +25,8 @@
 #include <base/callback.h>
 #include <base/logging.h>
 
+#include <algorithm>
+
 using std::lock_guard;
 using std::mutex;
 
@@ -66,6 +68,14 @@ size_t GetScanRecordLength(std::vector<uint8_t> bytes) {
 // LowEnergyScanner implementation
 // ========================================================
 
+bool LowEnergyScanner::Delegate::OnScanResults(
+    LowEnergyScanner* client, const std::vector<ScanResult>& scan_results) {
+  for (const auto& scan_result : scan_results) {
+    OnScanResult(client, scan_result);
+  }
+  return true;
+}
+
 LowEnergyScanner::LowEnergyScanner(Adapter& adapter, const Uuid& uuid,
                                    int scanner_id)
     : adapter_(adapter),
@@ -111,6 +121,10 @@ bool LowEnergyScanner::StartScan(const ScanSettings& settings,
     return false;
   }
 
+  {
+    lock_guard<mutex> lock(scan_fields_lock_);
+    scan_settings_ = settings;
+  }
   scan_started_ = true;
   return true;
 }
@@ -129,6 +143,10 @@ bool LowEnergyScanner::StopScan() {
   }
 
   scan_started_ = false;
+
+  lock_guard<mutex> lock(delegate_mutex_);
+  DeliverPendingResultsLocked();
+  pending_results_.clear();
   return true;
 }
 
@@ -155,7 +173,51 @@ void LowEnergyScanner::ScanResultCallback(
 
   ScanResult result(BtAddrString(&bda), scan_record, rssi);
 
-  delegate_->OnScanResult(this, result);
+  base::TimeDelta report_delay;
+  {
+    lock_guard<mutex> lock(scan_fields_lock_);
+    report_delay = scan_settings_.report_delay();
+  }
+  if (report_delay.is_zero()) {
+    delegate_->OnScanResult(this, result);
+    return;
+  }
+
+  // Batch the results, so that a client pays for one IPC per batch instead
+  // of one per result.
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (pending_results_.empty()) pending_since_ = now;
+  if (pending_results_.size() >= kMaxPendingScanResults) {
+    VLOG(1) << "Scanner " << scanner_id_ << " is not taking its results, "
+            << "dropping the oldest one";
+    pending_results_.pop_front();
+  }
+  pending_results_.push_back(std::move(result));
+
+  if (pending_results_.size() >= kMaxScanResultBatchSize ||
+      now - pending_since_ >= report_delay) {
+    DeliverPendingResultsLocked();
+  }
+}
+
+void LowEnergyScanner::DeliverPendingResultsLocked() {
+  if (!delegate_) return;
+
+  while (!pending_results_.empty()) {
+    size_t batch_size =
+        std::min(pending_results_.size(), kMaxScanResultBatchSize);
+    std::vector<ScanResult> batch(pending_results_.begin(),
+                                  pending_results_.begin() + batch_size);
+    if (!delegate_->OnScanResults(this, batch)) {
+      // The client is busy, keep the results for the next batch
+      VLOG(1) << "Scanner " << scanner_id_ << " did not take "
+              << pending_results_.size() << " scan results";
+      break;
+    }
+    pending_results_.erase(pending_results_.begin(),
+                           pending_results_.begin() + batch_size);
+  }
+  pending_since_ = base::TimeTicks::Now();
 }
 
 // LowEnergyScannerFactory implementation
@@ -17,11 +17,14 @@
 #pragma once
 
 #include <atomic>
+#include <deque>
 #include <functional>
 #include <map>
 #include <mutex>
+#include <vector>
 
 #include <base/macros.h>
+#include <base/time/time.h>
 #include <bluetooth/uuid.h>
 
 #include "service/bluetooth_instance.h"
@@ -43,6 +46,14 @@ class Adapter;
 class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
                          public BluetoothInstance {
  public:
+  // Maximum number of scan results delivered in a batch. A full batch is
+  // delivered without waiting for the report delay.
+  static constexpr size_t kMaxScanResultBatchSize = 64;
+
+  // Maximum number of scan results kept for a delegate which does not take
+  // its batches, the oldest results being dropped beyond.
+  static constexpr size_t kMaxPendingScanResults = 512;
+
   // The Delegate interface is used to notify asynchronous events related to LE
   // scan.
   class Delegate {
@@ -55,6 +66,13 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
     virtual void OnScanResult(LowEnergyScanner* client,
                               const ScanResult& scan_result) = 0;
 
+    // Called asynchronously with a batch of scan results, when the scan
+    // settings have a report delay. Returns false if the batch could not be
+    // delivered, in which case it is delivered again with the next batch. The
+    // default implementation notifies the results one by one.
+    virtual bool OnScanResults(LowEnergyScanner* client,
+                               const std::vector<ScanResult>& scan_results);
+
    private:
     DISALLOW_COPY_AND_ASSIGN(Delegate);
   };
@@ -74,7 +92,8 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
   bool StartScan(const ScanSettings& settings,
                  const std::vector<ScanFilter>& filters);
 
-  // Stops an ongoing BLE device scan for this client.
+  // Stops an ongoing BLE device scan for this client. The scan results still
+  // waiting for their report delay are delivered first.
   bool StopScan();
 
   // Returns the current scan settings.
@@ -99,6 +118,10 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
   void InvokeAndClearStartCallback(BLEStatus status);
   void InvokeAndClearStopCallback(BLEStatus status);
 
+  // Delivers the pending scan results to the delegate, in batches of at most
+  // kMaxScanResultBatchSize. Must be called with |delegate_mutex_| held.
+  void DeliverPendingResultsLocked();
+
   // Raw pointer to the Bluetooth Adapter.
   Adapter& adapter_;
 
@@ -120,6 +143,11 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
   std::mutex delegate_mutex_;
   Delegate* delegate_;
 
+  // Scan results waiting for the report delay of the scan settings, and the
+  // time the oldest of them was received. Protected by |delegate_mutex_|.
+  std::deque<ScanResult> pending_results_;
+  base::TimeTicks pending_since_;
+
   DISALLOW_COPY_AND_ASSIGN(LowEnergyScanner);
 };
 
@@ -66,10 +66,16 @@ class MockScannerHandler : public BleScannerInterface {
   MOCK_METHOD1(BatchscanDisable, void(Callback cb));
 
   MOCK_METHOD2(BatchscanReadReports, void(int client_if, int scan_mode));
+  MOCK_METHOD2(SetScanResultBatching, void(int window_ms, int max_results));
 
   MOCK_METHOD7(StartSync, void(uint8_t, RawAddress, uint16_t, uint16_t,
                                StartSyncCb, SyncReportCb, SyncLostCb));
   MOCK_METHOD1(StopSync, void(uint16_t));
+  MOCK_METHOD4(TransferSync,
+               void(RawAddress, uint16_t, uint16_t, SyncTransferCb));
+  MOCK_METHOD6(ReceiveSyncTransfer, void(RawAddress, uint16_t, uint16_t,
+                                         StartSyncCb, SyncReportCb,
+                                         SyncLostCb));
 
   void ScanFilterAdd(int filter_index, std::vector<ApcfCommand> filters,
                      FilterConfigCallback cb) override{};
@@ -106,6 +112,33 @@ class TestDelegate : public LowEnergyScanner::Delegate {
   DISALLOW_COPY_AND_ASSIGN(TestDelegate);
 };
 
+class BatchTestDelegate : public LowEnergyScanner::Delegate {
+ public:
+  BatchTestDelegate() = default;
+  ~BatchTestDelegate() override = default;
+
+  const std::vector<size_t>& batch_sizes() const { return batch_sizes_; }
+  void set_busy(bool busy) { busy_ = busy; }
+
+  void OnScanResult(LowEnergyScanner* scanner,
+                    const ScanResult& scan_result) override {
+    ADD_FAILURE() << "Scan result delivered out of a batch";
+  }
+
+  bool OnScanResults(LowEnergyScanner* scanner,
+                     const std::vector<ScanResult>& scan_results) override {
+    if (busy_) return false;
+    batch_sizes_.push_back(scan_results.size());
+    return true;
+  }
+
+ private:
+  std::vector<size_t> batch_sizes_;
+  bool busy_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(BatchTestDelegate);
+};
+
 class LowEnergyScannerTest : public ::testing::Test {
  public:
   LowEnergyScannerTest() = default;
@@ -345,5 +378,51 @@ TEST_F(LowEnergyScannerPostRegisterTest, ScanRecord) {
   le_scanner_->SetDelegate(nullptr);
 }
 
+TEST_F(LowEnergyScannerPostRegisterTest, BatchedScanResults) {
+  BatchTestDelegate delegate;
+  le_scanner_->SetDelegate(&delegate);
+
+  const std::vector<uint8_t> kTestRecord({0x02, 0x01, 0x00, 0x00});
+  const RawAddress kTestAddress = {{0x01, 0x02, 0x03, 0x0A, 0x0B, 0x0C}};
+  const int kTestRssi = 64;
+  const size_t kBatchSize = LowEnergyScanner::kMaxScanResultBatchSize;
+
+  EXPECT_CALL(mock_adapter_, IsEnabled()).Times(1).WillOnce(Return(true));
+  EXPECT_CALL(*mock_handler_, Scan(_))
+      .Times(2)
+      .WillOnce(Return())
+      .WillOnce(Return());
+  ScanSettings settings;
+  settings.set_report_delay(base::TimeDelta::FromHours(1));
+  std::vector<ScanFilter> filters;
+  ASSERT_TRUE(le_scanner_->StartScan(settings, filters));
+
+  // The results wait for the report delay until a batch is full.
+  for (size_t i = 0; i < kBatchSize - 1; i++) {
+    fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress, kTestRssi,
+                                                   kTestRecord);
+  }
+  EXPECT_TRUE(delegate.batch_sizes().empty());
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress, kTestRssi,
+                                                 kTestRecord);
+  EXPECT_EQ(std::vector<size_t>({kBatchSize}), delegate.batch_sizes());
+
+  // A busy delegate gets the results it did not take with the next batch.
+  delegate.set_busy(true);
+  for (size_t i = 0; i < kBatchSize + 1; i++) {
+    fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress, kTestRssi,
+                                                   kTestRecord);
+  }
+  EXPECT_EQ(1U, delegate.batch_sizes().size());
+  delegate.set_busy(false);
+
+  // Stopping the scan delivers the pending results.
+  EXPECT_TRUE(le_scanner_->StopScan());
+  EXPECT_EQ(std::vector<size_t>({kBatchSize, kBatchSize, 1}),
+            delegate.batch_sizes());
+
+  le_scanner_->SetDelegate(nullptr);
+}
+
 }  // namespace
 }  // namespace bluetooth
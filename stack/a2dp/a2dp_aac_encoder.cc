@@ -19,7 +19,6 @@
 #include "a2dp_aac_encoder.h"
 
 #include <inttypes.h>
-#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -27,6 +26,8 @@
 #include <base/logging.h>
 
 #include "a2dp_aac.h"
+#include "a2dp_abr.h"
+#include "a2dp_feeding_clock.h"
 #include "bt_common.h"
 #include "common/time_util.h"
 #include "osi/include/log.h"
@@ -55,12 +56,6 @@ typedef struct {
   int max_encoded_buffer_bytes;  // Max encoded bytes per frame
 } tA2DP_AAC_ENCODER_PARAMS;
 
-typedef struct {
-  uint32_t counter;
-  uint32_t bytes_per_tick;              // pcm bytes read each media task tick
-  uint64_t last_frame_timestamp_100ns;  // values in 1/10 microseconds
-} tA2DP_AAC_FEEDING_STATE;
-
 typedef struct {
   uint64_t session_start_us;
 
@@ -76,6 +71,7 @@ typedef struct {
 typedef struct {
   a2dp_source_read_callback_t read_callback;
   a2dp_source_enqueue_callback_t enqueue_callback;
+  a2dp_source_alloc_callback_t alloc_callback;
   uint16_t TxAaMtuSize;
 
   bool use_SCMS_T;
@@ -89,7 +85,12 @@ typedef struct {
 
   tA2DP_FEEDING_PARAMS feeding_params;
   tA2DP_AAC_ENCODER_PARAMS aac_encoder_params;
-  tA2DP_AAC_FEEDING_STATE aac_feeding_state;
+  tA2DP_FEEDING_CLOCK feeding_clock;
+
+  size_t TxQueueLength;
+  tA2DP_ABR abr;
+  bool use_abr;          // True if the bit rate is constant and ABR adjusts it
+  int abr_max_bit_rate;  // Bit rate at ABR level 0
 
   a2dp_aac_encoder_stats_t stats;
 } tA2DP_AAC_ENCODER_CB;
@@ -124,7 +125,8 @@ void A2DP_UnloadEncoderAac(void) {
 void a2dp_aac_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
                            A2dpCodecConfig* a2dp_codec_config,
                            a2dp_source_read_callback_t read_callback,
-                           a2dp_source_enqueue_callback_t enqueue_callback) {
+                           a2dp_source_enqueue_callback_t enqueue_callback,
+                           a2dp_source_alloc_callback_t alloc_callback) {
   if (a2dp_aac_encoder_cb.has_aac_handle)
     aacEncClose(&a2dp_aac_encoder_cb.aac_handle);
   memset(&a2dp_aac_encoder_cb, 0, sizeof(a2dp_aac_encoder_cb));
@@ -134,6 +136,7 @@ void a2dp_aac_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
 
   a2dp_aac_encoder_cb.read_callback = read_callback;
   a2dp_aac_encoder_cb.enqueue_callback = enqueue_callback;
+  a2dp_aac_encoder_cb.alloc_callback = alloc_callback;
   a2dp_aac_encoder_cb.is_peer_edr = p_peer_params->is_peer_edr;
   a2dp_aac_encoder_cb.peer_supports_3mbps = p_peer_params->peer_supports_3mbps;
   a2dp_aac_encoder_cb.peer_mtu = p_peer_params->peer_mtu;
@@ -191,6 +194,7 @@ static void a2dp_aac_encoder_update(uint16_t peer_mtu,
   *p_restart_input = false;
   *p_restart_output = false;
   *p_config_updated = false;
+  a2dp_aac_encoder_cb.use_abr = false;
 
   if (!a2dp_aac_encoder_cb.has_aac_handle) {
     AACENC_ERROR aac_error = aacEncOpen(&a2dp_aac_encoder_cb.aac_handle, 0,
@@ -353,6 +357,7 @@ static void a2dp_aac_encoder_update(uint16_t peer_mtu,
         __func__, aac_param_value, aac_error);
     return;  // TODO: Return an error?
   }
+  a2dp_aac_encoder_cb.abr_max_bit_rate = aac_param_value;
 
   // Set the encoder's parameters: PEAK Bit Rate
   aac_error = aacEncoder_SetParam(a2dp_aac_encoder_cb.aac_handle,
@@ -445,6 +450,8 @@ static void a2dp_aac_encoder_update(uint16_t peer_mtu,
         __func__, aac_param_value, aac_error);
     return;  // TODO: Return an error?
   }
+  // The encoder picks its own bit rate in VBR mode
+  bool use_abr = (aac_param_value == A2DP_AAC_VARIABLE_BIT_RATE_DISABLED);
 
   // Mark the end of setting the encoder's parameters
   aac_error =
@@ -475,6 +482,9 @@ static void a2dp_aac_encoder_update(uint16_t peer_mtu,
 
   // After encoder params ready, reset the feeding state and its interval.
   a2dp_aac_feeding_reset();
+
+  a2dp_abr_init(&a2dp_aac_encoder_cb.abr, a2dp_aac_encoder_interval_ms);
+  a2dp_aac_encoder_cb.use_abr = use_abr;
 }
 
 void a2dp_aac_encoder_cleanup(void) {
@@ -501,24 +511,17 @@ void a2dp_aac_feeding_reset(void) {
       a2dp_aac_encoder_interval_ms = A2DP_AAC_ENCODER_INTERVAL_MS;
   }
 
-  /* By default, just clear the entire state */
-  memset(&a2dp_aac_encoder_cb.aac_feeding_state, 0,
-         sizeof(a2dp_aac_encoder_cb.aac_feeding_state));
-
-  a2dp_aac_encoder_cb.aac_feeding_state.bytes_per_tick =
-      (a2dp_aac_encoder_cb.feeding_params.sample_rate *
-       a2dp_aac_encoder_cb.feeding_params.bits_per_sample / 8 *
-       a2dp_aac_encoder_cb.feeding_params.channel_count *
-       a2dp_aac_encoder_interval_ms) /
-      1000;
+  a2dp_feeding_clock_reset(&a2dp_aac_encoder_cb.feeding_clock,
+                           &a2dp_aac_encoder_cb.feeding_params,
+                           a2dp_aac_encoder_interval_ms);
 
   LOG_INFO("%s: PCM bytes %u per tick %u ms", __func__,
-           a2dp_aac_encoder_cb.aac_feeding_state.bytes_per_tick,
+           a2dp_aac_encoder_cb.feeding_clock.bytes_per_tick,
            a2dp_aac_encoder_interval_ms);
 }
 
 void a2dp_aac_feeding_flush(void) {
-  a2dp_aac_encoder_cb.aac_feeding_state.counter = 0;
+  a2dp_feeding_clock_flush(&a2dp_aac_encoder_cb.feeding_clock);
 }
 
 uint64_t a2dp_aac_get_encoder_interval_ms(void) {
@@ -529,6 +532,25 @@ void a2dp_aac_send_frames(uint64_t timestamp_us) {
   uint8_t nb_frame = 0;
   uint8_t nb_iterations = 0;
 
+  if (a2dp_aac_encoder_cb.use_abr &&
+      a2dp_abr_proc(&a2dp_aac_encoder_cb.abr,
+                    a2dp_aac_encoder_cb.TxQueueLength)) {
+    // The ABR lowers the bit rate down to half of the configured one
+    int bit_rate = a2dp_abr_scale(&a2dp_aac_encoder_cb.abr,
+                                  a2dp_aac_encoder_cb.abr_max_bit_rate,
+                                  a2dp_aac_encoder_cb.abr_max_bit_rate / 2);
+    AACENC_ERROR aac_error = aacEncoder_SetParam(
+        a2dp_aac_encoder_cb.aac_handle, AACENC_BITRATE, bit_rate);
+    if (aac_error != AACENC_OK) {
+      LOG_ERROR("%s: Cannot set AAC parameter AACENC_BITRATE to %d: "
+                "AAC error 0x%x",
+                __func__, bit_rate, aac_error);
+    } else {
+      LOG_INFO("%s: ABR level %u, bit rate %d", __func__,
+               a2dp_aac_encoder_cb.abr.level, bit_rate);
+    }
+  }
+
   a2dp_aac_get_num_frame_iteration(&nb_iterations, &nb_frame, timestamp_us);
   LOG_VERBOSE("%s: Sending %d frames per iteration, %d iterations", __func__,
               nb_frame, nb_iterations);
@@ -556,32 +578,12 @@ static void a2dp_aac_get_num_frame_iteration(uint8_t* num_of_iterations,
       a2dp_aac_encoder_cb.feeding_params.bits_per_sample / 8;
   LOG_VERBOSE("%s: pcm_bytes_per_frame %u", __func__, pcm_bytes_per_frame);
 
-  uint32_t hecto_ns_this_tick = a2dp_aac_encoder_interval_ms * 10000;
-  uint64_t* last_100ns =
-      &a2dp_aac_encoder_cb.aac_feeding_state.last_frame_timestamp_100ns;
-  uint64_t now_100ns = timestamp_us * 10;
-  if (*last_100ns != 0) {
-    hecto_ns_this_tick = (now_100ns - *last_100ns);
-  }
-  *last_100ns = now_100ns;
-
-  uint32_t bytes_this_tick =
-      a2dp_aac_encoder_cb.aac_feeding_state.bytes_per_tick *
-      hecto_ns_this_tick / (a2dp_aac_encoder_interval_ms * 10000);
-  a2dp_aac_encoder_cb.aac_feeding_state.counter += bytes_this_tick;
-  // Without this erratum, there was a three microseocnd shift per tick which
-  // would cause one frame mismatched after every 180 seconds
-  uint32_t erratum_100ns =
-      ceil(1.0f * bytes_this_tick * a2dp_aac_encoder_interval_ms * 10000 /
-           a2dp_aac_encoder_cb.aac_feeding_state.bytes_per_tick);
-  if (erratum_100ns < hecto_ns_this_tick) {
-    LOG_VERBOSE("%s: hecto_ns_this_tick=%d, bytes=%d, erratum_100ns=%d",
-                __func__, hecto_ns_this_tick, bytes_this_tick, erratum_100ns);
-    *last_100ns -= hecto_ns_this_tick - erratum_100ns;
-  }
+  a2dp_feeding_clock_tick(&a2dp_aac_encoder_cb.feeding_clock, timestamp_us);
 
-  result = a2dp_aac_encoder_cb.aac_feeding_state.counter / pcm_bytes_per_frame;
-  a2dp_aac_encoder_cb.aac_feeding_state.counter -= result * pcm_bytes_per_frame;
+  result = a2dp_feeding_clock_frames(&a2dp_aac_encoder_cb.feeding_clock,
+                                     pcm_bytes_per_frame);
+  a2dp_feeding_clock_consume(&a2dp_aac_encoder_cb.feeding_clock, result,
+                             pcm_bytes_per_frame);
   nof = result;
 
   LOG_VERBOSE("%s: effective num of frames %u, iterations %u", __func__, nof,
@@ -642,7 +644,7 @@ static void a2dp_aac_encode_frames(uint8_t nb_frame) {
   int written = 0;
 
   while (nb_frame) {
-    BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
+    BT_HDR* p_buf = a2dp_aac_encoder_cb.alloc_callback(BT_DEFAULT_BUFFER_SIZE);
     p_buf->offset = A2DP_AAC_OFFSET;
     p_buf->len = 0;
     p_buf->layer_specific = 0;
@@ -680,10 +682,10 @@ static void a2dp_aac_encode_frames(uint8_t nb_frame) {
         p_buf->layer_specific++;  // added a frame to the buffer
       } else {
         LOG_WARN("%s: underflow %d", __func__, nb_frame);
-        a2dp_aac_encoder_cb.aac_feeding_state.counter +=
-            nb_frame * p_encoder_params->frame_length *
-            p_feeding_params->channel_count *
-            p_feeding_params->bits_per_sample / 8;
+        a2dp_feeding_clock_underflow(
+            &a2dp_aac_encoder_cb.feeding_clock, nb_frame,
+            p_encoder_params->frame_length * p_feeding_params->channel_count *
+                p_feeding_params->bits_per_sample / 8);
 
         // no more pcm to read
         nb_frame = 0;
@@ -751,6 +753,14 @@ int A2dpCodecConfigAacSource::getEffectiveMtu() const {
   return a2dp_aac_encoder_cb.TxAaMtuSize;
 }
 
+void a2dp_aac_set_transmit_queue_length(size_t transmit_queue_length) {
+  a2dp_aac_encoder_cb.TxQueueLength = transmit_queue_length;
+}
+
+void a2dp_aac_report_congestion(void) {
+  a2dp_abr_report_congestion(&a2dp_aac_encoder_cb.abr);
+}
+
 void A2dpCodecConfigAacSource::debug_codec_dump(int fd) {
   a2dp_aac_encoder_stats_t* stats = &a2dp_aac_encoder_cb.stats;
 
@@ -781,4 +791,13 @@ void A2dpCodecConfigAacSource::debug_codec_dump(int fd) {
           "%zu\n",
           stats->media_read_total_expected_read_bytes,
           stats->media_read_total_actual_read_bytes);
+
+  if (a2dp_aac_encoder_cb.use_abr) {
+    dprintf(fd,
+            "  AAC adaptive bit rate level                             : %u\n",
+            a2dp_aac_encoder_cb.abr.level);
+    dprintf(fd,
+            "  AAC adaptive bit rate adjustments                       : %zu\n",
+            a2dp_aac_encoder_cb.abr.adjustments);
+  }
 }
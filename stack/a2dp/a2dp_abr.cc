@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "a2dp_abr"
+
+#include "a2dp_abr.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "osi/include/log.h"
+
+// Transmit queue length at which the bit rate goes straight to the last level.
+#define A2DP_ABR_THRESHOLD_CRITICAL 6
+
+// Transmit queue length at which a growing queue lowers the bit rate.
+#define A2DP_ABR_THRESHOLD_DANGEROUS_TREND 4
+
+// Transmit queue length up to which the link keeps up with the encoder.
+#define A2DP_ABR_THRESHOLD_SAFETY 2
+
+// Time the link has to keep up before the bit rate is raised. Lowering the
+// bit rate doubles it, raising the bit rate halves it again.
+#define A2DP_ABR_RAISE_MIN_MS 5000
+#define A2DP_ABR_RAISE_MAX_MS 60000
+
+static uint32_t a2dp_abr_ticks(const tA2DP_ABR* p_abr, uint64_t duration_ms) {
+  return std::max<uint64_t>(duration_ms / p_abr->interval_ms, 1);
+}
+
+void a2dp_abr_init(tA2DP_ABR* p_abr, uint64_t interval_ms) {
+  memset(p_abr, 0, sizeof(*p_abr));
+  p_abr->interval_ms = std::max<uint64_t>(interval_ms, 1);
+  p_abr->raise_ticks = a2dp_abr_ticks(p_abr, A2DP_ABR_RAISE_MIN_MS);
+}
+
+void a2dp_abr_report_congestion(tA2DP_ABR* p_abr) {
+  p_abr->congestion_reported = true;
+}
+
+bool a2dp_abr_proc(tA2DP_ABR* p_abr, size_t transmit_queue_length) {
+  if (p_abr->interval_ms == 0) return false;  // Not initialized
+
+  uint32_t level = p_abr->level;
+  bool growing = transmit_queue_length > p_abr->last_txq_length;
+
+  if (transmit_queue_length >= A2DP_ABR_THRESHOLD_CRITICAL) {
+    level = A2DP_ABR_NUM_LEVELS - 1;
+  } else if (p_abr->congestion_reported ||
+             (growing &&
+              transmit_queue_length >= A2DP_ABR_THRESHOLD_DANGEROUS_TREND)) {
+    level = std::min<uint32_t>(level + 1, A2DP_ABR_NUM_LEVELS - 1);
+  }
+  p_abr->congestion_reported = false;
+  p_abr->last_txq_length = transmit_queue_length;
+
+  if (level > p_abr->level) {
+    p_abr->stable_ticks = 0;
+    p_abr->raise_ticks =
+        std::min(p_abr->raise_ticks * 2,
+                 a2dp_abr_ticks(p_abr, A2DP_ABR_RAISE_MAX_MS));
+  } else if (transmit_queue_length <= A2DP_ABR_THRESHOLD_SAFETY) {
+    p_abr->stable_ticks++;
+    if (level > 0 && p_abr->stable_ticks >= p_abr->raise_ticks) {
+      level--;
+      p_abr->stable_ticks = 0;
+      p_abr->raise_ticks =
+          std::max(p_abr->raise_ticks / 2,
+                   a2dp_abr_ticks(p_abr, A2DP_ABR_RAISE_MIN_MS));
+    }
+  } else {
+    p_abr->stable_ticks = 0;
+  }
+
+  if (level == p_abr->level) return false;
+
+  LOG_DEBUG("%s: bit rate level %u -> %u, transmit queue length %zu",
+            __func__, p_abr->level, level, transmit_queue_length);
+  p_abr->level = level;
+  p_abr->adjustments++;
+  return true;
+}
+
+uint32_t a2dp_abr_scale(const tA2DP_ABR* p_abr, uint32_t value,
+                        uint32_t min_value) {
+  if (min_value >= value) return value;
+  return value - (value - min_value) * p_abr->level / (A2DP_ABR_NUM_LEVELS - 1);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "a2dp_feeding_clock"
+
+#include "a2dp_feeding_clock.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "osi/include/log.h"
+
+// 1/10 microseconds in a second
+#define A2DP_FEEDING_CLOCK_100NS_PER_SECOND 10000000
+
+void a2dp_feeding_clock_reset(tA2DP_FEEDING_CLOCK* p_clock,
+                              const tA2DP_FEEDING_PARAMS* p_feeding_params,
+                              uint64_t interval_ms) {
+  memset(p_clock, 0, sizeof(*p_clock));
+  p_clock->bytes_per_second = p_feeding_params->sample_rate *
+                              p_feeding_params->bits_per_sample / 8 *
+                              p_feeding_params->channel_count;
+  p_clock->bytes_per_tick = p_clock->bytes_per_second * interval_ms / 1000;
+  p_clock->interval_100ns = interval_ms * 10000;
+}
+
+uint32_t a2dp_feeding_clock_tick(tA2DP_FEEDING_CLOCK* p_clock,
+                                 uint64_t timestamp_us) {
+  if (p_clock->bytes_per_second == 0) return 0;  // Not reset
+
+  uint64_t now_100ns = timestamp_us * 10;
+  uint64_t elapsed_100ns = p_clock->interval_100ns;
+  if (p_clock->last_tick_100ns != 0) {
+    elapsed_100ns = now_100ns > p_clock->last_tick_100ns
+                        ? now_100ns - p_clock->last_tick_100ns
+                        : 0;
+  }
+  p_clock->last_tick_100ns = now_100ns;
+
+  // The bytes are counted from the byte rate rather than from
+  // |bytes_per_tick|, which is rounded down when the interval is not a whole
+  // number of bytes, like 23 ms at 44.1 kHz. Without carrying the fraction of
+  // a byte left over, there was a three microsecond shift per tick, which
+  // would cause one SBC frame mismatched after every 20 seconds.
+  uint64_t due = p_clock->bytes_per_second * elapsed_100ns + p_clock->residue;
+  uint32_t bytes_this_tick = due / A2DP_FEEDING_CLOCK_100NS_PER_SECOND;
+  p_clock->residue = due % A2DP_FEEDING_CLOCK_100NS_PER_SECOND;
+  p_clock->counter += bytes_this_tick;
+
+  LOG_VERBOSE("%s: elapsed_100ns=%" PRIu64 ", bytes=%u, residue=%u", __func__,
+              elapsed_100ns, bytes_this_tick, p_clock->residue);
+  return bytes_this_tick;
+}
+
+uint32_t a2dp_feeding_clock_frames(const tA2DP_FEEDING_CLOCK* p_clock,
+                                   uint32_t pcm_bytes_per_frame) {
+  if (pcm_bytes_per_frame == 0) return 0;
+  return p_clock->counter / pcm_bytes_per_frame;
+}
+
+void a2dp_feeding_clock_consume(tA2DP_FEEDING_CLOCK* p_clock,
+                                uint32_t num_frames,
+                                uint32_t pcm_bytes_per_frame) {
+  uint32_t bytes = num_frames * pcm_bytes_per_frame;
+  p_clock->counter = bytes < p_clock->counter ? p_clock->counter - bytes : 0;
+}
+
+void a2dp_feeding_clock_underflow(tA2DP_FEEDING_CLOCK* p_clock,
+                                  uint32_t num_frames,
+                                  uint32_t pcm_bytes_per_frame) {
+  p_clock->counter += num_frames * pcm_bytes_per_frame;
+}
+
+void a2dp_feeding_clock_flush(tA2DP_FEEDING_CLOCK* p_clock) {
+  p_clock->counter = 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "a2dp_pcm.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void a2dp_pcm_deinterleave_16(const uint16_t* p_pcm, size_t num_frames,
+                              uint32_t* p_left, uint32_t* p_right) {
+  size_t frame = 0;
+
+#if defined(__SSE2__)
+  // 8 frames at a time: separate the even and odd 16-bit words of the 32-bit
+  // frames, then widen them with zeros
+  const __m128i low_mask = _mm_set1_epi32(0xffff);
+  for (; frame + 8 <= num_frames; frame += 8) {
+    __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_pcm + 2 * frame));
+    __m128i b = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(p_pcm + 2 * frame + 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p_left + frame),
+                     _mm_and_si128(a, low_mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p_left + frame + 4),
+                     _mm_and_si128(b, low_mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p_right + frame),
+                     _mm_srli_epi32(a, 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p_right + frame + 4),
+                     _mm_srli_epi32(b, 16));
+  }
+#elif defined(__ARM_NEON)
+  for (; frame + 8 <= num_frames; frame += 8) {
+    uint16x8x2_t samples = vld2q_u16(p_pcm + 2 * frame);
+    vst1q_u32(p_left + frame, vmovl_u16(vget_low_u16(samples.val[0])));
+    vst1q_u32(p_left + frame + 4, vmovl_u16(vget_high_u16(samples.val[0])));
+    vst1q_u32(p_right + frame, vmovl_u16(vget_low_u16(samples.val[1])));
+    vst1q_u32(p_right + frame + 4, vmovl_u16(vget_high_u16(samples.val[1])));
+  }
+#endif
+
+  for (; frame < num_frames; frame++) {
+    p_left[frame] = p_pcm[2 * frame];
+    p_right[frame] = p_pcm[2 * frame + 1];
+  }
+}
+
+// Sign extends the little endian 24-bit sample |p|
+static inline uint32_t a2dp_pcm_load_24(const uint8_t* p) {
+  return (p[0] << 0) | (p[1] << 8) | (((int8_t)p[2]) << 16);
+}
+
+// Sign extends the 24-bit sample at bit |shift| of |word|
+static inline uint32_t a2dp_pcm_extract_24(uint64_t word, int shift) {
+  return (uint32_t)((int64_t)(word << (40 - shift)) >> 40);
+}
+
+void a2dp_pcm_deinterleave_24_packed(const uint8_t* p_pcm, size_t num_frames,
+                                     uint32_t* p_left, uint32_t* p_right) {
+  size_t frame = 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // 4 stereo frames are 24 bytes, read as 3 words: the shifts of the words
+  // replace the 24 byte loads of the samples. Samples 2 and 5 straddle two
+  // words.
+  for (; frame + 4 <= num_frames; frame += 4) {
+    uint64_t w[3];
+    memcpy(w, p_pcm + 6 * frame, sizeof(w));
+    p_left[frame + 0] = a2dp_pcm_extract_24(w[0], 0);
+    p_right[frame + 0] = a2dp_pcm_extract_24(w[0], 24);
+    p_left[frame + 1] =
+        (uint32_t)(w[0] >> 48) | a2dp_pcm_extract_24(w[1] << 16, 0);
+    p_right[frame + 1] = a2dp_pcm_extract_24(w[1], 8);
+    p_left[frame + 2] = a2dp_pcm_extract_24(w[1], 32);
+    p_right[frame + 2] =
+        (uint32_t)(w[1] >> 56) | a2dp_pcm_extract_24(w[2] << 8, 0);
+    p_left[frame + 3] = a2dp_pcm_extract_24(w[2], 16);
+    p_right[frame + 3] = a2dp_pcm_extract_24(w[2], 40);
+  }
+#endif
+
+  for (; frame < num_frames; frame++) {
+    p_left[frame] = a2dp_pcm_load_24(p_pcm + 6 * frame);
+    p_right[frame] = a2dp_pcm_load_24(p_pcm + 6 * frame + 3);
+  }
+}
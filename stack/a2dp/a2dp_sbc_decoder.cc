@@ -72,24 +72,18 @@ bool a2dp_sbc_decoder_decode_packet(BT_HDR* p_buf) {
 
   const OI_BYTE* oi_data = data;
   uint32_t oi_size = data_size;
-  size_t out_avail = sizeof(a2dp_sbc_decoder_cb.decode_buf);
-  int16_t* out_ptr = a2dp_sbc_decoder_cb.decode_buf;
-
-  for (size_t i = 0; i < num_frames; ++i) {
-    uint32_t out_size = out_avail;
-    OI_STATUS status =
-        OI_CODEC_SBC_DecodeFrame(&a2dp_sbc_decoder_cb.decoder_context, &oi_data,
-                                 &oi_size, out_ptr, &out_size);
-    if (!OI_SUCCESS(status)) {
-      LOG_ERROR("%s: Decoding failure: %d", __func__, status);
-      return false;
-    }
-    out_avail -= out_size;
-    out_ptr += out_size / sizeof(*out_ptr);
+  uint8_t frame_count = num_frames;
+  uint32_t out_used = sizeof(a2dp_sbc_decoder_cb.decode_buf);
+
+  OI_STATUS status = OI_CODEC_SBC_DecodeFrames(
+      &a2dp_sbc_decoder_cb.decoder_context, &frame_count, &oi_data, &oi_size,
+      a2dp_sbc_decoder_cb.decode_buf, &out_used);
+  if (!OI_SUCCESS(status)) {
+    LOG_ERROR("%s: Decoding failure at frame %d of %zu: %d", __func__,
+              frame_count, num_frames, status);
+    return false;
   }
 
-  size_t out_used =
-      (out_ptr - a2dp_sbc_decoder_cb.decode_buf) * sizeof(*out_ptr);
   a2dp_sbc_decoder_cb.decode_callback(
       reinterpret_cast<uint8_t*>(a2dp_sbc_decoder_cb.decode_buf), out_used);
   return true;
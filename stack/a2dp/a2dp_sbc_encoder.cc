@@ -22,10 +22,13 @@
 #include "a2dp_sbc_encoder.h"
 
 #include <limits.h>
-#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+
+#include "a2dp_abr.h"
+#include "a2dp_feeding_clock.h"
 #include "a2dp_sbc.h"
 #include "a2dp_sbc_up_sample.h"
 #include "bt_common.h"
@@ -71,9 +74,6 @@ typedef struct {
   uint32_t aa_frame_counter;
   int32_t aa_feed_counter;
   int32_t aa_feed_residue;
-  uint32_t counter;
-  uint32_t bytes_per_tick;              // pcm bytes read each media task tick
-  uint64_t last_frame_timestamp_100ns;  // values in 1/10 microseconds
 } tA2DP_SBC_FEEDING_STATE;
 
 typedef struct {
@@ -94,6 +94,7 @@ typedef struct {
 typedef struct {
   a2dp_source_read_callback_t read_callback;
   a2dp_source_enqueue_callback_t enqueue_callback;
+  a2dp_source_alloc_callback_t alloc_callback;
   uint16_t TxAaMtuSize;
   uint8_t tx_sbc_frames;
   bool is_peer_edr;         /* True if the peer device supports EDR */
@@ -103,8 +104,14 @@ typedef struct {
   SBC_ENC_PARAMS sbc_encoder_params;
   tA2DP_FEEDING_PARAMS feeding_params;
   tA2DP_SBC_FEEDING_STATE feeding_state;
+  tA2DP_FEEDING_CLOCK feeding_clock;
   int16_t pcmBuffer[SBC_MAX_PCM_BUFFER_SIZE];
 
+  size_t TxQueueLength;
+  tA2DP_ABR abr;
+  int16_t abr_max_bitpool; /* Bitpool at ABR level 0 */
+  int16_t abr_min_bitpool; /* Bitpool at the last ABR level */
+
   a2dp_sbc_encoder_stats_t stats;
 } tA2DP_SBC_ENCODER_CB;
 
@@ -136,7 +143,8 @@ void A2DP_UnloadEncoderSbc(void) {
 void a2dp_sbc_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
                            A2dpCodecConfig* a2dp_codec_config,
                            a2dp_source_read_callback_t read_callback,
-                           a2dp_source_enqueue_callback_t enqueue_callback) {
+                           a2dp_source_enqueue_callback_t enqueue_callback,
+                           a2dp_source_alloc_callback_t alloc_callback) {
   memset(&a2dp_sbc_encoder_cb, 0, sizeof(a2dp_sbc_encoder_cb));
 
   a2dp_sbc_encoder_cb.stats.session_start_us =
@@ -144,6 +152,7 @@ void a2dp_sbc_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
 
   a2dp_sbc_encoder_cb.read_callback = read_callback;
   a2dp_sbc_encoder_cb.enqueue_callback = enqueue_callback;
+  a2dp_sbc_encoder_cb.alloc_callback = alloc_callback;
   a2dp_sbc_encoder_cb.is_peer_edr = p_peer_params->is_peer_edr;
   a2dp_sbc_encoder_cb.peer_supports_3mbps = p_peer_params->peer_supports_3mbps;
   a2dp_sbc_encoder_cb.peer_mtu = p_peer_params->peer_mtu;
@@ -367,6 +376,12 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
   /* Reset the SBC encoder */
   SBC_Encoder_Init(&a2dp_sbc_encoder_cb.sbc_encoder_params);
   a2dp_sbc_encoder_cb.tx_sbc_frames = calculate_max_frames_per_packet();
+
+  /* The ABR lowers the bitpool down to half of the computed one */
+  a2dp_abr_init(&a2dp_sbc_encoder_cb.abr, A2DP_SBC_ENCODER_INTERVAL_MS);
+  a2dp_sbc_encoder_cb.abr_max_bitpool = p_encoder_params->s16BitPool;
+  a2dp_sbc_encoder_cb.abr_min_bitpool =
+      std::max<int16_t>(p_encoder_params->s16BitPool / 2, min_bitpool);
 }
 
 void a2dp_sbc_encoder_cleanup(void) {
@@ -378,19 +393,16 @@ void a2dp_sbc_feeding_reset(void) {
   memset(&a2dp_sbc_encoder_cb.feeding_state, 0,
          sizeof(a2dp_sbc_encoder_cb.feeding_state));
 
-  a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick =
-      (a2dp_sbc_encoder_cb.feeding_params.sample_rate *
-       a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8 *
-       a2dp_sbc_encoder_cb.feeding_params.channel_count *
-       A2DP_SBC_ENCODER_INTERVAL_MS) /
-      1000;
+  a2dp_feeding_clock_reset(&a2dp_sbc_encoder_cb.feeding_clock,
+                           &a2dp_sbc_encoder_cb.feeding_params,
+                           A2DP_SBC_ENCODER_INTERVAL_MS);
 
   LOG_DEBUG("%s: PCM bytes per tick %u", __func__,
-            a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick);
+            a2dp_sbc_encoder_cb.feeding_clock.bytes_per_tick);
 }
 
 void a2dp_sbc_feeding_flush(void) {
-  a2dp_sbc_encoder_cb.feeding_state.counter = 0;
+  a2dp_feeding_clock_flush(&a2dp_sbc_encoder_cb.feeding_clock);
   a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue = 0;
 }
 
@@ -402,6 +414,18 @@ void a2dp_sbc_send_frames(uint64_t timestamp_us) {
   uint8_t nb_frame = 0;
   uint8_t nb_iterations = 0;
 
+  if (a2dp_abr_proc(&a2dp_sbc_encoder_cb.abr,
+                    a2dp_sbc_encoder_cb.TxQueueLength)) {
+    // The bitpool is read for every frame, the SBC encoder state is kept
+    SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+    p_encoder_params->s16BitPool = a2dp_abr_scale(
+        &a2dp_sbc_encoder_cb.abr, a2dp_sbc_encoder_cb.abr_max_bitpool,
+        a2dp_sbc_encoder_cb.abr_min_bitpool);
+    a2dp_sbc_encoder_cb.tx_sbc_frames = calculate_max_frames_per_packet();
+    LOG_INFO("%s: ABR level %u, bitpool %d", __func__,
+             a2dp_sbc_encoder_cb.abr.level, p_encoder_params->s16BitPool);
+  }
+
   a2dp_sbc_get_num_frame_iteration(&nb_iterations, &nb_frame, timestamp_us);
   LOG_VERBOSE("%s: Sending %d frames per iteration, %d iterations", __func__,
               nb_frame, nb_iterations);
@@ -430,33 +454,11 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
       a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8;
   LOG_VERBOSE("%s: pcm_bytes_per_frame %u", __func__, pcm_bytes_per_frame);
 
-  uint32_t hecto_ns_this_tick = A2DP_SBC_ENCODER_INTERVAL_MS * 10000;
-  uint64_t* last_100ns =
-      &a2dp_sbc_encoder_cb.feeding_state.last_frame_timestamp_100ns;
-  uint64_t now_100ns = timestamp_us * 10;
-  if (*last_100ns != 0) {
-    hecto_ns_this_tick = (now_100ns - *last_100ns);
-  }
-  *last_100ns = now_100ns;
-
-  uint32_t bytes_this_tick = a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick *
-                             hecto_ns_this_tick /
-                             (A2DP_SBC_ENCODER_INTERVAL_MS * 10000);
-  a2dp_sbc_encoder_cb.feeding_state.counter += bytes_this_tick;
-  // Without this erratum, there was a three microseocnd shift per tick which
-  // would cause one SBC frame mismatched after every 20 seconds
-  uint32_t erratum_100ns =
-      ceil(1.0f * A2DP_SBC_ENCODER_INTERVAL_MS * 10000 * bytes_this_tick /
-           a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick);
-  if (erratum_100ns < hecto_ns_this_tick) {
-    LOG_VERBOSE("%s: hecto_ns_this_tick=%d, bytes=%d, erratum_100ns=%d",
-                __func__, hecto_ns_this_tick, bytes_this_tick, erratum_100ns);
-    *last_100ns -= hecto_ns_this_tick - erratum_100ns;
-  }
+  a2dp_feeding_clock_tick(&a2dp_sbc_encoder_cb.feeding_clock, timestamp_us);
 
   /* Calculate the number of frames pending for this media tick */
-  projected_nof =
-      a2dp_sbc_encoder_cb.feeding_state.counter / pcm_bytes_per_frame;
+  projected_nof = a2dp_feeding_clock_frames(&a2dp_sbc_encoder_cb.feeding_clock,
+                                            pcm_bytes_per_frame);
   // Update the stats
   a2dp_sbc_encoder_cb.stats.media_read_total_expected_frames += projected_nof;
 
@@ -492,7 +494,7 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
           LOG_ERROR("%s: Audio Congestion (iterations:%d > max (%d))", __func__,
                     noi, A2DP_SBC_MAX_PCM_ITER_NUM_PER_TICK);
           noi = A2DP_SBC_MAX_PCM_ITER_NUM_PER_TICK;
-          a2dp_sbc_encoder_cb.feeding_state.counter =
+          a2dp_sbc_encoder_cb.feeding_clock.counter =
               noi * nof * pcm_bytes_per_frame;
         }
         projected_nof = nof;
@@ -514,12 +516,13 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
       a2dp_sbc_encoder_cb.stats.media_read_total_dropped_frames += delta;
 
       projected_nof = MAX_PCM_FRAME_NUM_PER_TICK;
-      a2dp_sbc_encoder_cb.feeding_state.counter =
+      a2dp_sbc_encoder_cb.feeding_clock.counter =
           noi * projected_nof * pcm_bytes_per_frame;
     }
     nof = projected_nof;
   }
-  a2dp_sbc_encoder_cb.feeding_state.counter -= noi * nof * pcm_bytes_per_frame;
+  a2dp_feeding_clock_consume(&a2dp_sbc_encoder_cb.feeding_clock, noi * nof,
+                             pcm_bytes_per_frame);
   LOG_VERBOSE("%s: effective num of frames %u, iterations %u", __func__, nof,
               noi);
 
@@ -536,7 +539,7 @@ static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
   uint8_t last_frame_len = 0;
 
   while (nb_frame) {
-    BT_HDR* p_buf = (BT_HDR*)osi_malloc(A2DP_SBC_BUFFER_SIZE);
+    BT_HDR* p_buf = a2dp_sbc_encoder_cb.alloc_callback(A2DP_SBC_BUFFER_SIZE);
     uint32_t bytes_read = 0;
 
     p_buf->offset = A2DP_SBC_OFFSET;
@@ -567,11 +570,12 @@ static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
       } else {
         LOG_WARN("%s: underflow %d, %d", __func__, nb_frame,
                  a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue);
-        a2dp_sbc_encoder_cb.feeding_state.counter +=
-            nb_frame * p_encoder_params->s16NumOfSubBands *
-            p_encoder_params->s16NumOfBlocks *
-            a2dp_sbc_encoder_cb.feeding_params.channel_count *
-            a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8;
+        a2dp_feeding_clock_underflow(
+            &a2dp_sbc_encoder_cb.feeding_clock, nb_frame,
+            p_encoder_params->s16NumOfSubBands *
+                p_encoder_params->s16NumOfBlocks *
+                a2dp_sbc_encoder_cb.feeding_params.channel_count *
+                a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8);
         /* no more pcm to read */
         nb_frame = 0;
       }
@@ -900,6 +904,14 @@ static uint32_t a2dp_sbc_frame_length(void) {
   return frame_len;
 }
 
+void a2dp_sbc_set_transmit_queue_length(size_t transmit_queue_length) {
+  a2dp_sbc_encoder_cb.TxQueueLength = transmit_queue_length;
+}
+
+void a2dp_sbc_report_congestion(void) {
+  a2dp_abr_report_congestion(&a2dp_sbc_encoder_cb.abr);
+}
+
 uint32_t a2dp_sbc_get_bitrate() {
   SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
   LOG_DEBUG("%s: bit rate %d ", __func__, p_encoder_params->u16BitRate);
@@ -942,4 +954,14 @@ void A2dpCodecConfigSbcSource::debug_codec_dump(int fd) {
           "%zu\n",
           stats->media_read_total_expected_frames,
           stats->media_read_total_dropped_frames);
+
+  dprintf(fd,
+          "  SBC adaptive bit rate (level/bitpool)                   : %u / "
+          "%d\n",
+          a2dp_sbc_encoder_cb.abr.level,
+          a2dp_sbc_encoder_cb.sbc_encoder_params.s16BitPool);
+
+  dprintf(fd,
+          "  SBC adaptive bit rate adjustments                       : %zu\n",
+          a2dp_sbc_encoder_cb.abr.adjustments);
 }
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "a2dp_pcm.h"
 #include "a2dp_vendor.h"
 #include "a2dp_vendor_aptx.h"
 #include "bt_common.h"
@@ -87,6 +88,7 @@ typedef struct {
 typedef struct {
   a2dp_source_read_callback_t read_callback;
   a2dp_source_enqueue_callback_t enqueue_callback;
+  a2dp_source_alloc_callback_t alloc_callback;
 
   bool use_SCMS_T;
   bool is_peer_edr;          // True if the peer device supports EDR
@@ -110,8 +112,8 @@ static void a2dp_vendor_aptx_encoder_update(uint16_t peer_mtu,
 static void aptx_init_framing_params(tAPTX_FRAMING_PARAMS* framing_params);
 static void aptx_update_framing_params(tAPTX_FRAMING_PARAMS* framing_params);
 static size_t aptx_encode_16bit(tAPTX_FRAMING_PARAMS* framing_params,
-                                size_t* data_out_index, uint16_t* data16_in,
-                                uint8_t* data_out);
+                                size_t* data_out_index, uint32_t* pcm_left,
+                                uint32_t* pcm_right, uint8_t* data_out);
 
 bool A2DP_VendorLoadEncoderAptx(void) {
   if (aptx_encoder_lib_handle != NULL) return true;  // Already loaded
@@ -169,7 +171,8 @@ void a2dp_vendor_aptx_encoder_init(
     const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
     A2dpCodecConfig* a2dp_codec_config,
     a2dp_source_read_callback_t read_callback,
-    a2dp_source_enqueue_callback_t enqueue_callback) {
+    a2dp_source_enqueue_callback_t enqueue_callback,
+    a2dp_source_alloc_callback_t alloc_callback) {
   memset(&a2dp_aptx_encoder_cb, 0, sizeof(a2dp_aptx_encoder_cb));
 
   a2dp_aptx_encoder_cb.stats.session_start_us =
@@ -177,6 +180,7 @@ void a2dp_vendor_aptx_encoder_init(
 
   a2dp_aptx_encoder_cb.read_callback = read_callback;
   a2dp_aptx_encoder_cb.enqueue_callback = enqueue_callback;
+  a2dp_aptx_encoder_cb.alloc_callback = alloc_callback;
   a2dp_aptx_encoder_cb.is_peer_edr = p_peer_params->is_peer_edr;
   a2dp_aptx_encoder_cb.peer_supports_3mbps = p_peer_params->peer_supports_3mbps;
   a2dp_aptx_encoder_cb.peer_mtu = p_peer_params->peer_mtu;
@@ -375,7 +379,7 @@ void a2dp_vendor_aptx_send_frames(uint64_t timestamp_us) {
   tAPTX_FRAMING_PARAMS* framing_params = &a2dp_aptx_encoder_cb.framing_params;
 
   // Prepare the packet to send
-  BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
+  BT_HDR* p_buf = a2dp_aptx_encoder_cb.alloc_callback(BT_DEFAULT_BUFFER_SIZE);
   p_buf->offset = A2DP_APTX_OFFSET;
   p_buf->len = 0;
   p_buf->layer_specific = 0;
@@ -413,11 +417,20 @@ void a2dp_vendor_aptx_send_frames(uint64_t timestamp_us) {
   }
   a2dp_aptx_encoder_cb.stats.media_read_total_actual_reads_count++;
 
+  // Split the channels of the whole packet at once, the encoder reads them
+  // 4 samples at a time
+  const uint32_t BYTES_PER_STEREO_FRAME = 4;
+  uint32_t pcm_left[A2DP_APTX_MAX_PCM_BYTES_PER_READ / BYTES_PER_STEREO_FRAME];
+  uint32_t pcm_right[A2DP_APTX_MAX_PCM_BYTES_PER_READ / BYTES_PER_STEREO_FRAME];
+  a2dp_pcm_deinterleave_16(read_buffer16, bytes_read / BYTES_PER_STEREO_FRAME,
+                           pcm_left, pcm_right);
+
   for (uint32_t reads = 0, offset = 0; reads < framing_params->pcm_reads;
        reads++, offset +=
-                (framing_params->pcm_bytes_per_read / sizeof(uint16_t))) {
-    pcm_bytes_encoded += aptx_encode_16bit(framing_params, &encoded_ptr_index,
-                                           read_buffer16 + offset, encoded_ptr);
+                framing_params->pcm_bytes_per_read / BYTES_PER_STEREO_FRAME) {
+    pcm_bytes_encoded +=
+        aptx_encode_16bit(framing_params, &encoded_ptr_index,
+                          pcm_left + offset, pcm_right + offset, encoded_ptr);
   }
 
   // Compute the number of encoded bytes
@@ -444,24 +457,18 @@ void a2dp_vendor_aptx_send_frames(uint64_t timestamp_us) {
 }
 
 static size_t aptx_encode_16bit(tAPTX_FRAMING_PARAMS* framing_params,
-                                size_t* data_out_index, uint16_t* data16_in,
-                                uint8_t* data_out) {
+                                size_t* data_out_index, uint32_t* pcm_left,
+                                uint32_t* pcm_right, uint8_t* data_out) {
   size_t pcm_bytes_encoded = 0;
   size_t frame = 0;
 
   for (size_t aptx_samples = 0;
        aptx_samples < framing_params->pcm_bytes_per_read / 16; aptx_samples++) {
-    uint32_t pcmL[4];
-    uint32_t pcmR[4];
     uint16_t encoded_sample[2];
 
-    for (size_t i = 0, j = frame; i < 4; i++, j++) {
-      pcmL[i] = (uint16_t) * (data16_in + (2 * j));
-      pcmR[i] = (uint16_t) * (data16_in + ((2 * j) + 1));
-    }
-
     aptx_encoder_encode_stereo_func(a2dp_aptx_encoder_cb.aptx_encoder_state,
-                                    &pcmL, &pcmR, &encoded_sample);
+                                    pcm_left + frame, pcm_right + frame,
+                                    &encoded_sample);
 
     data_out[*data_out_index + 0] = (uint8_t)((encoded_sample[0] >> 8) & 0xff);
     data_out[*data_out_index + 1] = (uint8_t)((encoded_sample[0] >> 0) & 0xff);
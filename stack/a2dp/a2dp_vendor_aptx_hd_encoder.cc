@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "a2dp_pcm.h"
 #include "a2dp_vendor.h"
 #include "a2dp_vendor_aptx_hd.h"
 #include "bt_common.h"
@@ -87,6 +88,7 @@ typedef struct {
 typedef struct {
   a2dp_source_read_callback_t read_callback;
   a2dp_source_enqueue_callback_t enqueue_callback;
+  a2dp_source_alloc_callback_t alloc_callback;
 
   bool use_SCMS_T;
   bool is_peer_edr;          // True if the peer device supports EDR
@@ -110,8 +112,8 @@ static void aptx_hd_init_framing_params(
 static void aptx_hd_update_framing_params(
     tAPTX_HD_FRAMING_PARAMS* framing_params);
 static size_t aptx_hd_encode_24bit(tAPTX_HD_FRAMING_PARAMS* framing_params,
-                                   size_t* data_out_index, uint32_t* data32_in,
-                                   uint8_t* data_out);
+                                   size_t* data_out_index, uint32_t* pcm_left,
+                                   uint32_t* pcm_right, uint8_t* data_out);
 
 bool A2DP_VendorLoadEncoderAptxHd(void) {
   if (aptx_hd_encoder_lib_handle != NULL) return true;  // Already loaded
@@ -169,7 +171,8 @@ void a2dp_vendor_aptx_hd_encoder_init(
     const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
     A2dpCodecConfig* a2dp_codec_config,
     a2dp_source_read_callback_t read_callback,
-    a2dp_source_enqueue_callback_t enqueue_callback) {
+    a2dp_source_enqueue_callback_t enqueue_callback,
+    a2dp_source_alloc_callback_t alloc_callback) {
   memset(&a2dp_aptx_hd_encoder_cb, 0, sizeof(a2dp_aptx_hd_encoder_cb));
 
   a2dp_aptx_hd_encoder_cb.stats.session_start_us =
@@ -177,6 +180,7 @@ void a2dp_vendor_aptx_hd_encoder_init(
 
   a2dp_aptx_hd_encoder_cb.read_callback = read_callback;
   a2dp_aptx_hd_encoder_cb.enqueue_callback = enqueue_callback;
+  a2dp_aptx_hd_encoder_cb.alloc_callback = alloc_callback;
   a2dp_aptx_hd_encoder_cb.is_peer_edr = p_peer_params->is_peer_edr;
   a2dp_aptx_hd_encoder_cb.peer_supports_3mbps =
       p_peer_params->peer_supports_3mbps;
@@ -360,7 +364,8 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
       &a2dp_aptx_hd_encoder_cb.framing_params;
 
   // Prepare the packet to send
-  BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
+  BT_HDR* p_buf =
+      a2dp_aptx_hd_encoder_cb.alloc_callback(BT_DEFAULT_BUFFER_SIZE);
   p_buf->offset = A2DP_APTX_HD_OFFSET;
   p_buf->len = 0;
   p_buf->layer_specific = 0;
@@ -400,12 +405,25 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
   }
   a2dp_aptx_hd_encoder_cb.stats.media_read_total_actual_reads_count++;
 
+  // Expand the whole packet from AUDIO_FORMAT_PCM_24_BIT_PACKED data (3 bytes
+  // per sample) into AUDIO_FORMAT_PCM_8_24_BIT (4 bytes per sample) at once,
+  // one buffer per channel
+  const uint32_t BYTES_PER_STEREO_FRAME = 6;
+  uint32_t
+      pcm_left[A2DP_APTX_HD_MAX_PCM_BYTES_PER_READ / BYTES_PER_STEREO_FRAME];
+  uint32_t
+      pcm_right[A2DP_APTX_HD_MAX_PCM_BYTES_PER_READ / BYTES_PER_STEREO_FRAME];
+  a2dp_pcm_deinterleave_24_packed((const uint8_t*)read_buffer32,
+                                  bytes_read / BYTES_PER_STEREO_FRAME,
+                                  pcm_left, pcm_right);
+
   for (uint32_t reads = 0, offset = 0; reads < framing_params->pcm_reads;
        reads++, offset +=
-                framing_params->pcm_bytes_per_read / sizeof(uint32_t)) {
+                framing_params->pcm_bytes_per_read / BYTES_PER_STEREO_FRAME) {
     pcm_bytes_encoded +=
         aptx_hd_encode_24bit(framing_params, &encoded_ptr_index,
-                             read_buffer32 + offset, encoded_ptr);
+                             pcm_left + offset, pcm_right + offset,
+                             encoded_ptr);
   }
 
   // Compute the number of encoded bytes
@@ -433,30 +451,19 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
 }
 
 static size_t aptx_hd_encode_24bit(tAPTX_HD_FRAMING_PARAMS* framing_params,
-                                   size_t* data_out_index, uint32_t* data32_in,
-                                   uint8_t* data_out) {
+                                   size_t* data_out_index, uint32_t* pcm_left,
+                                   uint32_t* pcm_right, uint8_t* data_out) {
   size_t pcm_bytes_encoded = 0;
-  const uint8_t* p = (const uint8_t*)(data32_in);
+  size_t frame = 0;
 
   for (size_t aptx_hd_samples = 0;
        aptx_hd_samples < framing_params->pcm_bytes_per_read / 24;
        aptx_hd_samples++) {
-    uint32_t pcmL[4];
-    uint32_t pcmR[4];
     uint32_t encoded_sample[2];
 
-    // Expand from AUDIO_FORMAT_PCM_24_BIT_PACKED data (3 bytes per sample)
-    // into AUDIO_FORMAT_PCM_8_24_BIT (4 bytes per sample).
-    for (size_t i = 0; i < 4; i++) {
-      pcmL[i] = ((p[0] << 0) | (p[1] << 8) | (((int8_t)p[2]) << 16));
-      p += 3;
-      pcmR[i] = ((p[0] << 0) | (p[1] << 8) | (((int8_t)p[2]) << 16));
-      p += 3;
-    }
-
     aptx_hd_encoder_encode_stereo_func(
-        a2dp_aptx_hd_encoder_cb.aptx_hd_encoder_state, &pcmL, &pcmR,
-        &encoded_sample);
+        a2dp_aptx_hd_encoder_cb.aptx_hd_encoder_state, pcm_left + frame,
+        pcm_right + frame, &encoded_sample);
 
     uint8_t* encoded_ptr = (uint8_t*)&encoded_sample[0];
     data_out[*data_out_index + 0] = *(encoded_ptr + 2);
@@ -466,6 +473,7 @@ static size_t aptx_hd_encode_24bit(tAPTX_HD_FRAMING_PARAMS* framing_params,
     data_out[*data_out_index + 4] = *(encoded_ptr + 5);
     data_out[*data_out_index + 5] = *(encoded_ptr + 4);
 
+    frame += 4;
     pcm_bytes_encoded += 24;
     *data_out_index += 6;
   }
@@ -29,6 +29,7 @@
 
 #include <ldacBT.h>
 
+#include "a2dp_feeding_clock.h"
 #include "a2dp_vendor.h"
 #include "a2dp_vendor_ldac.h"
 #include "a2dp_vendor_ldac_abr.h"
@@ -123,12 +124,6 @@ typedef struct {
   LDACBT_SMPL_FMT_T pcm_fmt;
 } tA2DP_LDAC_ENCODER_PARAMS;
 
-typedef struct {
-  uint32_t counter;
-  uint32_t bytes_per_tick; /* pcm bytes read each media task tick */
-  uint64_t last_frame_us;
-} tA2DP_LDAC_FEEDING_STATE;
-
 typedef struct {
   uint64_t session_start_us;
 
@@ -144,6 +139,7 @@ typedef struct {
 typedef struct {
   a2dp_source_read_callback_t read_callback;
   a2dp_source_enqueue_callback_t enqueue_callback;
+  a2dp_source_alloc_callback_t alloc_callback;
   uint16_t TxAaMtuSize;
   size_t TxQueueLength;
 
@@ -163,7 +159,7 @@ typedef struct {
 
   tA2DP_FEEDING_PARAMS feeding_params;
   tA2DP_LDAC_ENCODER_PARAMS ldac_encoder_params;
-  tA2DP_LDAC_FEEDING_STATE ldac_feeding_state;
+  tA2DP_FEEDING_CLOCK feeding_clock;
 
   a2dp_ldac_encoder_stats_t stats;
 } tA2DP_LDAC_ENCODER_CB;
@@ -278,7 +274,8 @@ void a2dp_vendor_ldac_encoder_init(
     const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
     A2dpCodecConfig* a2dp_codec_config,
     a2dp_source_read_callback_t read_callback,
-    a2dp_source_enqueue_callback_t enqueue_callback) {
+    a2dp_source_enqueue_callback_t enqueue_callback,
+    a2dp_source_alloc_callback_t alloc_callback) {
   if (a2dp_ldac_encoder_cb.has_ldac_handle)
     ldac_free_handle_func(a2dp_ldac_encoder_cb.ldac_handle);
   if (a2dp_ldac_encoder_cb.has_ldac_abr_handle)
@@ -290,6 +287,7 @@ void a2dp_vendor_ldac_encoder_init(
 
   a2dp_ldac_encoder_cb.read_callback = read_callback;
   a2dp_ldac_encoder_cb.enqueue_callback = enqueue_callback;
+  a2dp_ldac_encoder_cb.alloc_callback = alloc_callback;
   a2dp_ldac_encoder_cb.is_peer_edr = p_peer_params->is_peer_edr;
   a2dp_ldac_encoder_cb.peer_supports_3mbps = p_peer_params->peer_supports_3mbps;
   a2dp_ldac_encoder_cb.peer_mtu = p_peer_params->peer_mtu;
@@ -512,23 +510,16 @@ void a2dp_vendor_ldac_encoder_cleanup(void) {
 }
 
 void a2dp_vendor_ldac_feeding_reset(void) {
-  /* By default, just clear the entire state */
-  memset(&a2dp_ldac_encoder_cb.ldac_feeding_state, 0,
-         sizeof(a2dp_ldac_encoder_cb.ldac_feeding_state));
-
-  a2dp_ldac_encoder_cb.ldac_feeding_state.bytes_per_tick =
-      (a2dp_ldac_encoder_cb.feeding_params.sample_rate *
-       a2dp_ldac_encoder_cb.feeding_params.bits_per_sample / 8 *
-       a2dp_ldac_encoder_cb.feeding_params.channel_count *
-       A2DP_LDAC_ENCODER_INTERVAL_MS) /
-      1000;
+  a2dp_feeding_clock_reset(&a2dp_ldac_encoder_cb.feeding_clock,
+                           &a2dp_ldac_encoder_cb.feeding_params,
+                           A2DP_LDAC_ENCODER_INTERVAL_MS);
 
   LOG_DEBUG("%s: PCM bytes per tick %u", __func__,
-            a2dp_ldac_encoder_cb.ldac_feeding_state.bytes_per_tick);
+            a2dp_ldac_encoder_cb.feeding_clock.bytes_per_tick);
 }
 
 void a2dp_vendor_ldac_feeding_flush(void) {
-  a2dp_ldac_encoder_cb.ldac_feeding_state.counter = 0;
+  a2dp_feeding_clock_flush(&a2dp_ldac_encoder_cb.feeding_clock);
 }
 
 uint64_t a2dp_vendor_ldac_get_encoder_interval_ms(void) {
@@ -579,21 +570,12 @@ static void a2dp_ldac_get_num_frame_iteration(uint8_t* num_of_iterations,
       a2dp_ldac_encoder_cb.feeding_params.bits_per_sample / 8;
   LOG_VERBOSE("%s: pcm_bytes_per_frame %u", __func__, pcm_bytes_per_frame);
 
-  uint32_t us_this_tick = A2DP_LDAC_ENCODER_INTERVAL_MS * 1000;
-  uint64_t now_us = timestamp_us;
-  if (a2dp_ldac_encoder_cb.ldac_feeding_state.last_frame_us != 0)
-    us_this_tick =
-        (now_us - a2dp_ldac_encoder_cb.ldac_feeding_state.last_frame_us);
-  a2dp_ldac_encoder_cb.ldac_feeding_state.last_frame_us = now_us;
-
-  a2dp_ldac_encoder_cb.ldac_feeding_state.counter +=
-      a2dp_ldac_encoder_cb.ldac_feeding_state.bytes_per_tick * us_this_tick /
-      (A2DP_LDAC_ENCODER_INTERVAL_MS * 1000);
-
-  result =
-      a2dp_ldac_encoder_cb.ldac_feeding_state.counter / pcm_bytes_per_frame;
-  a2dp_ldac_encoder_cb.ldac_feeding_state.counter -=
-      result * pcm_bytes_per_frame;
+  a2dp_feeding_clock_tick(&a2dp_ldac_encoder_cb.feeding_clock, timestamp_us);
+
+  result = a2dp_feeding_clock_frames(&a2dp_ldac_encoder_cb.feeding_clock,
+                                     pcm_bytes_per_frame);
+  a2dp_feeding_clock_consume(&a2dp_ldac_encoder_cb.feeding_clock, result,
+                             pcm_bytes_per_frame);
   nof = result;
 
   LOG_VERBOSE("%s: effective num of frames %u, iterations %u", __func__, nof,
@@ -633,7 +615,7 @@ static void a2dp_ldac_encode_frames(uint8_t nb_frame) {
 
   uint32_t bytes_read = 0;
   while (nb_frame) {
-    BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
+    BT_HDR* p_buf = a2dp_ldac_encoder_cb.alloc_callback(BT_DEFAULT_BUFFER_SIZE);
     p_buf->offset = A2DP_LDAC_OFFSET;
     p_buf->len = 0;
     p_buf->layer_specific = 0;
@@ -676,10 +658,10 @@ static void a2dp_ldac_encode_frames(uint8_t nb_frame) {
         p_buf->layer_specific += out_frames;  // added a frame to the buffer
       } else {
         LOG_WARN("%s: underflow %d", __func__, nb_frame);
-        a2dp_ldac_encoder_cb.ldac_feeding_state.counter +=
-            nb_frame * LDACBT_ENC_LSU *
-            a2dp_ldac_encoder_cb.feeding_params.channel_count *
-            a2dp_ldac_encoder_cb.feeding_params.bits_per_sample / 8;
+        a2dp_feeding_clock_underflow(
+            &a2dp_ldac_encoder_cb.feeding_clock, nb_frame,
+            LDACBT_ENC_LSU * a2dp_ldac_encoder_cb.feeding_params.channel_count *
+                a2dp_ldac_encoder_cb.feeding_params.bits_per_sample / 8);
 
         // no more pcm to read
         nb_frame = 0;
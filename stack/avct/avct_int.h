@@ -78,7 +78,8 @@ typedef struct {
   uint8_t state;          /* The state machine state */
   uint8_t ch_state;       /* L2CAP channel state */
   uint8_t ch_flags;       /* L2CAP configuration flags */
-  BT_HDR* p_rx_msg;       /* Message being reassembled */
+  fixed_queue_t* rx_q;    /* Fragments of the message being reassembled */
+  uint16_t rx_len;        /* Length of the fragments in rx_q */
   uint16_t conflict_lcid; /* L2CAP channel LCID */
   RawAddress peer_addr;   /* BD address of peer */
   fixed_queue_t* tx_q;    /* Transmit data buffer queue       */
@@ -271,6 +271,7 @@ tAVCT_LCB* avct_lcb_alloc(const RawAddress& bd_addr) {
       p_lcb->peer_addr = bd_addr;
       AVCT_TRACE_DEBUG("avct_lcb_alloc %d", p_lcb->allocated);
       p_lcb->tx_q = fixed_queue_new(SIZE_MAX);
+      p_lcb->rx_q = fixed_queue_new(SIZE_MAX);
       break;
     }
   }
@@ -309,7 +310,7 @@ void avct_lcb_dealloc(tAVCT_LCB* p_lcb, UNUSED_ATTR tAVCT_LCB_EVT* p_data) {
   // If not, de-allocate now...
 
   AVCT_TRACE_DEBUG("%s Freeing LCB", __func__);
-  osi_free(p_lcb->p_rx_msg);
+  fixed_queue_free(p_lcb->rx_q, osi_free);
   fixed_queue_free(p_lcb->tx_q, NULL);
   memset(p_lcb, 0, sizeof(tAVCT_LCB));
 }
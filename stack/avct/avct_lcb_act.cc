@@ -37,11 +37,43 @@ const uint8_t avct_lcb_pkt_type_len[] = {AVCT_HDR_LEN_SINGLE,
                                          AVCT_HDR_LEN_START, AVCT_HDR_LEN_CONT,
                                          AVCT_HDR_LEN_END};
 
+/* Largest reassembled message, with the offset left by the lower layers */
+#define AVCT_MAX_RX_MSG_LEN (BT_DEFAULT_BUFFER_SIZE - BT_HDR_SIZE)
+
+/* Drop the fragments of the message being reassembled */
+static void avct_lcb_rx_flush(tAVCT_LCB* p_lcb) {
+  while (!fixed_queue_is_empty(p_lcb->rx_q)) {
+    osi_free(fixed_queue_try_dequeue(p_lcb->rx_q));
+  }
+  p_lcb->rx_len = 0;
+}
+
+/* Join the fragments of rx_q in a buffer of the size of the message */
+static BT_HDR* avct_lcb_rx_join(tAVCT_LCB* p_lcb) {
+  BT_HDR* p_start = (BT_HDR*)fixed_queue_try_dequeue(p_lcb->rx_q);
+  BT_HDR* p_msg =
+      (BT_HDR*)osi_malloc(BT_HDR_SIZE + p_start->offset + p_lcb->rx_len);
+  *p_msg = *p_start;
+
+  uint8_t* p = (uint8_t*)(p_msg + 1) + p_msg->offset;
+  for (BT_HDR* p_frag = p_start; p_frag != NULL;
+       p_frag = (BT_HDR*)fixed_queue_try_dequeue(p_lcb->rx_q)) {
+    memcpy(p, (uint8_t*)(p_frag + 1) + p_frag->offset, p_frag->len);
+    p += p_frag->len;
+    osi_free(p_frag);
+  }
+  p_msg->len = p_lcb->rx_len;
+  p_lcb->rx_len = 0;
+  return p_msg;
+}
+
 /*******************************************************************************
  *
  * Function         avct_lcb_msg_asmbl
  *
- * Description      Reassemble incoming message.
+ * Description      Reassemble incoming message. The fragments are queued as
+ *                  they are received, and copied once in a buffer of the
+ *                  size of the message when the end packet is received.
  *
  *
  * Returns          Pointer to reassembled message;  NULL if no message
@@ -51,12 +83,10 @@ const uint8_t avct_lcb_pkt_type_len[] = {AVCT_HDR_LEN_SINGLE,
 static BT_HDR* avct_lcb_msg_asmbl(tAVCT_LCB* p_lcb, BT_HDR* p_buf) {
   uint8_t* p;
   uint8_t pkt_type;
-  BT_HDR* p_ret;
 
   if (p_buf->len < 1) {
     osi_free(p_buf);
-    p_ret = NULL;
-    return p_ret;
+    return NULL;
   }
 
   /* parse the message header */
@@ -67,97 +97,61 @@ static BT_HDR* avct_lcb_msg_asmbl(tAVCT_LCB* p_lcb, BT_HDR* p_buf) {
   if (p_buf->len < avct_lcb_pkt_type_len[pkt_type]) {
     osi_free(p_buf);
     AVCT_TRACE_WARNING("Bad length during reassembly");
-    p_ret = NULL;
+    return NULL;
   }
+
   /* single packet */
-  else if (pkt_type == AVCT_PKT_TYPE_SINGLE) {
+  if (pkt_type == AVCT_PKT_TYPE_SINGLE) {
     /* if reassembly in progress drop message and process new single */
-    if (p_lcb->p_rx_msg != NULL)
+    if (!fixed_queue_is_empty(p_lcb->rx_q)) {
       AVCT_TRACE_WARNING("Got single during reassembly");
-
-    osi_free_and_reset((void**)&p_lcb->p_rx_msg);
-
-    p_ret = p_buf;
+      avct_lcb_rx_flush(p_lcb);
+    }
+    return p_buf;
   }
-  /* start packet */
-  else if (pkt_type == AVCT_PKT_TYPE_START) {
+
+  if (pkt_type == AVCT_PKT_TYPE_START) {
     /* if reassembly in progress drop message and process new start */
-    if (p_lcb->p_rx_msg != NULL)
+    if (!fixed_queue_is_empty(p_lcb->rx_q)) {
       AVCT_TRACE_WARNING("Got start during reassembly");
+      avct_lcb_rx_flush(p_lcb);
+    }
 
-    osi_free(p_lcb->p_rx_msg);
+    /* copy first header byte over nosp, for the message to start with the
+     * header of a single packet */
+    *(p + 1) = *p;
+    p_buf->offset += 1;
+    p_buf->len -= 1;
+  } else {
+    /* continue or end: if no reassembly in progress drop message */
+    if (fixed_queue_is_empty(p_lcb->rx_q)) {
+      osi_free(p_buf);
+      AVCT_TRACE_WARNING("Pkt type=%d out of order", pkt_type);
+      return NULL;
+    }
 
-    /*
-     * Allocate bigger buffer for reassembly. As lower layers are
-     * not aware of possible packet size after reassembly, they
-     * would have allocated smaller buffer.
-     */
-    p_lcb->p_rx_msg = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
-    memcpy(p_lcb->p_rx_msg, p_buf, sizeof(BT_HDR) + p_buf->offset + p_buf->len);
+    /* adjust offset and len of fragment for header byte */
+    p_buf->offset += AVCT_HDR_LEN_CONT;
+    p_buf->len -= AVCT_HDR_LEN_CONT;
+  }
 
-    /* Free original buffer */
+  /* verify length, the start offset is kept in the reassembled message */
+  BT_HDR* p_start = (BT_HDR*)fixed_queue_try_peek_first(p_lcb->rx_q);
+  uint16_t start_offset = p_start != NULL ? p_start->offset : p_buf->offset;
+  if (start_offset + p_lcb->rx_len + p_buf->len > AVCT_MAX_RX_MSG_LEN) {
+    /* won't fit; free everything */
+    AVCT_TRACE_WARNING("%s: Fragmented message too big!", __func__);
+    avct_lcb_rx_flush(p_lcb);
     osi_free(p_buf);
+    return NULL;
+  }
 
-    /* update p to point to new buffer */
-    p = (uint8_t*)(p_lcb->p_rx_msg + 1) + p_lcb->p_rx_msg->offset;
-
-    /* copy first header byte over nosp */
-    *(p + 1) = *p;
-
-    /* set offset to point to where to copy next */
-    p_lcb->p_rx_msg->offset += p_lcb->p_rx_msg->len;
+  fixed_queue_enqueue(p_lcb->rx_q, p_buf);
+  p_lcb->rx_len += p_buf->len;
 
-    /* adjust length for packet header */
-    p_lcb->p_rx_msg->len -= 1;
+  if (pkt_type != AVCT_PKT_TYPE_END) return NULL;
 
-    p_ret = NULL;
-  }
-  /* continue or end */
-  else {
-    /* if no reassembly in progress drop message */
-    if (p_lcb->p_rx_msg == NULL) {
-      osi_free(p_buf);
-      AVCT_TRACE_WARNING("Pkt type=%d out of order", pkt_type);
-      p_ret = NULL;
-    } else {
-      /* get size of buffer holding assembled message */
-      /*
-       * NOTE: The buffer is allocated above at the beginning of the
-       * reassembly, and is always of size BT_DEFAULT_BUFFER_SIZE.
-       */
-      uint16_t buf_len = BT_DEFAULT_BUFFER_SIZE - sizeof(BT_HDR);
-
-      /* adjust offset and len of fragment for header byte */
-      p_buf->offset += AVCT_HDR_LEN_CONT;
-      p_buf->len -= AVCT_HDR_LEN_CONT;
-
-      /* verify length */
-      if ((p_lcb->p_rx_msg->offset + p_buf->len) > buf_len) {
-        /* won't fit; free everything */
-        AVCT_TRACE_WARNING("%s: Fragmented message too big!", __func__);
-        osi_free_and_reset((void**)&p_lcb->p_rx_msg);
-        osi_free(p_buf);
-        p_ret = NULL;
-      } else {
-        /* copy contents of p_buf to p_rx_msg */
-        memcpy((uint8_t*)(p_lcb->p_rx_msg + 1) + p_lcb->p_rx_msg->offset,
-               (uint8_t*)(p_buf + 1) + p_buf->offset, p_buf->len);
-
-        if (pkt_type == AVCT_PKT_TYPE_END) {
-          p_lcb->p_rx_msg->offset -= p_lcb->p_rx_msg->len;
-          p_lcb->p_rx_msg->len += p_buf->len;
-          p_ret = p_lcb->p_rx_msg;
-          p_lcb->p_rx_msg = NULL;
-        } else {
-          p_lcb->p_rx_msg->offset += p_buf->len;
-          p_lcb->p_rx_msg->len += p_buf->len;
-          p_ret = NULL;
-        }
-        osi_free(p_buf);
-      }
-    }
-  }
-  return p_ret;
+  return avct_lcb_rx_join(p_lcb);
 }
 
 /*******************************************************************************
@@ -464,6 +464,15 @@ void avdt_ad_tc_data_ind(AvdtpTransportChannel* p_tbl, BT_HDR* p_buf) {
     AVDT_TRACE_ERROR("%s: buffer freed", __func__);
     return;
   }
+
+  /* In the streaming state, the packets are handled without going through the
+   * state machine, which only dispatches them to the same action. */
+  if (p_scb->state == AVDT_SCB_STREAM_ST) {
+    tAVDT_SCB_EVT avdt_scb_evt;
+    avdt_scb_evt.p_pkt = p_buf;
+    avdt_scb_hdl_pkt(p_scb, &avdt_scb_evt);
+    return;
+  }
   avdt_scb_event(p_scb, AVDT_SCB_TC_DATA_EVT, (tAVDT_SCB_EVT*)&p_buf);
 }
 
@@ -932,7 +932,14 @@ uint16_t AVDT_WriteReqOpt(uint8_t handle, BT_HDR* p_pkt, uint32_t time_stamp,
     evt.apiwrite.time_stamp = time_stamp;
     evt.apiwrite.m_pt = m_pt;
     evt.apiwrite.opt = opt;
-    avdt_scb_event(p_scb, AVDT_SCB_API_WRITE_REQ_EVT, &evt);
+    if (p_scb->state == AVDT_SCB_STREAM_ST) {
+      /* Same actions as the state machine in the streaming state, without its
+       * dispatch */
+      avdt_scb_hdl_write_req(p_scb, &evt);
+      avdt_scb_chk_snd_pkt(p_scb, &evt);
+    } else {
+      avdt_scb_event(p_scb, AVDT_SCB_API_WRITE_REQ_EVT, &evt);
+    }
   }
 
   AVDT_TRACE_DEBUG("%s: result=%d avdt_handle=%d", __func__, result, handle);
@@ -151,6 +151,7 @@ typedef struct {
   tSDP_DISCOVERY_DB* p_db;   /* pointer to discovery database */
   uint16_t service_uuid;     /* service UUID to search */
   uint8_t trace_level;
+  bool new_avrcp_enabled; /* persist.bluetooth.enablenewavrcp, read at init */
 } tAVRC_CB;
 
 /******************************************************************************
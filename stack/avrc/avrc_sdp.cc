@@ -26,6 +26,7 @@
 #include "avrc_api.h"
 #include "avrc_int.h"
 #include "bt_common.h"
+#include "osi/include/properties.h"
 
 using bluetooth::Uuid;
 
@@ -328,4 +329,8 @@ void AVRC_Init(void) {
 #else
   avrc_cb.trace_level = BT_TRACE_LEVEL_NONE;
 #endif
+
+  /* Read once here rather than for every outgoing message */
+  avrc_cb.new_avrcp_enabled =
+      osi_property_get_bool("persist.bluetooth.enablenewavrcp", true);
 }
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Offline benchmark of the A2DP encoders, through the same encoder interface
+// as the A2DP Source. Each codec is run at each of the sample rates, sample
+// sizes and channel modes it supports, on a standard test signal: a 1 kHz
+// sine at -6 dBFS with white noise at -40 dBFS. The media ticks run on a
+// simulated clock without jitter, and the encoded packets are dropped.
+// The configurations a codec does not support, and the codecs whose encoder
+// library cannot be loaded, are skipped.
+//
+// BM_A2dpEncoder reports as counters:
+//  - cpu_us_per_audio_s: thread CPU time spent encoding one second of audio
+//  - allocs_per_audio_s, alloc_bytes_per_audio_s: output buffers allocated by
+//    the encoder for one second of audio
+//  - bitrate_kbps: encoded bytes sent for one second of audio
+//  - frames_per_packet: mean number of codec frames per media packet
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include "osi/include/allocator.h"
+#include "stack/include/a2dp_codec_api.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// Seconds of audio encoded by each iteration
+constexpr uint64_t kSessionSeconds = 10;
+
+// L2CAP MTU of the fake peer
+constexpr uint16_t kPeerMtu = 895;
+
+// State of the encoding session, accessed by the encoder callbacks
+struct A2dpEncoderSession {
+  A2dpCodecs* codecs;
+  const tA2DP_ENCODER_INTERFACE* encoder_interface;
+  uint64_t encoder_interval_us;
+
+  // Test signal
+  uint32_t sample_rate;
+  uint8_t bytes_per_sample;
+  uint8_t channel_count;
+  uint64_t frame_index;
+  uint32_t noise_seed;
+  std::vector<uint8_t> frame;
+  size_t frame_offset;
+
+  size_t allocs;
+  size_t alloc_bytes;
+  size_t packets;
+  size_t codec_frames;
+  size_t encoded_bytes;
+};
+
+A2dpEncoderSession session;
+
+uint64_t thread_cpu_time_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Computes the next PCM frame of the test signal, little endian, with the same
+// sample on all the channels.
+void next_frame() {
+  double sine =
+      0.5 * sin(2 * M_PI * 1000 * session.frame_index / session.sample_rate);
+  session.noise_seed = session.noise_seed * 1103515245 + 12345;
+  double noise = 0.01 * ((session.noise_seed >> 16) / 32768.0 - 1);
+  session.frame_index++;
+
+  int bits = session.bytes_per_sample * 8;
+  int32_t sample =
+      static_cast<int32_t>(lrint((sine + noise) * ((1ll << (bits - 1)) - 1)));
+  uint8_t* p = session.frame.data();
+  for (uint8_t c = 0; c < session.channel_count; c++) {
+    for (uint8_t b = 0; b < session.bytes_per_sample; b++) {
+      *p++ = static_cast<uint8_t>(sample >> (8 * b));
+    }
+  }
+  session.frame_offset = 0;
+}
+
+uint32_t read_callback(uint8_t* p_buf, uint32_t len) {
+  for (uint32_t i = 0; i < len; i++) {
+    if (session.frame_offset == session.frame.size()) next_frame();
+    p_buf[i] = session.frame[session.frame_offset++];
+  }
+  return len;
+}
+
+bool enqueue_callback(BT_HDR* p_buf, size_t frames_n, uint32_t bytes_read) {
+  session.packets++;
+  session.codec_frames += frames_n;
+  session.encoded_bytes += p_buf->len;
+  osi_free(p_buf);
+  return true;
+}
+
+BT_HDR* alloc_callback(size_t size) {
+  session.allocs++;
+  session.alloc_bytes += size;
+  return (BT_HDR*)osi_malloc(size);
+}
+
+// Selects the codec of |codec_user_config|, with its own capabilities as the
+// capabilities of the peer, and initializes its encoder. Returns false if the
+// codec or the configuration is not available.
+bool start_session(A2dpCodecs* codecs,
+                   const btav_a2dp_codec_config_t& codec_user_config) {
+  AvdtpSepConfig sep_config;
+  uint8_t codec_info[AVDT_CODEC_SIZE];
+  if (!codecs->isSupportedCodec(codec_user_config.codec_type) ||
+      !A2DP_InitCodecConfig(codec_user_config.codec_type, &sep_config) ||
+      !codecs->setCodecConfig(sep_config.codec_info, true /* is_capability */,
+                              codec_info, true /* select_current_codec */)) {
+    return false;
+  }
+
+  tA2DP_ENCODER_INIT_PEER_PARAMS peer_params;
+  peer_params.is_peer_edr = true;
+  peer_params.peer_supports_3mbps = true;
+  peer_params.peer_mtu = kPeerMtu;
+  bool restart_input = false;
+  bool restart_output = false;
+  bool config_updated = false;
+  if (!codecs->setCodecUserConfig(codec_user_config, &peer_params,
+                                  sep_config.codec_info, codec_info,
+                                  &restart_input, &restart_output,
+                                  &config_updated)) {
+    return false;
+  }
+
+  // The codec falls back to its default for what it does not support
+  A2dpCodecConfig* codec_config = codecs->getCurrentCodecConfig();
+  btav_a2dp_codec_config_t config = codec_config->getCodecConfig();
+  if (config.codec_type != codec_user_config.codec_type ||
+      config.sample_rate != codec_user_config.sample_rate ||
+      config.bits_per_sample != codec_user_config.bits_per_sample ||
+      config.channel_mode != codec_user_config.channel_mode ||
+      !codec_config->copyOutOtaCodecConfig(codec_info)) {
+    return false;
+  }
+
+  session.encoder_interface = A2DP_GetEncoderInterface(codec_info);
+  if (session.encoder_interface == nullptr) return false;
+  session.codecs = codecs;
+
+  session.sample_rate = A2DP_GetTrackSampleRate(codec_info);
+  session.bytes_per_sample = A2DP_GetTrackBitsPerSample(codec_info) / 8;
+  session.channel_count = A2DP_GetTrackChannelCount(codec_info);
+  session.frame.resize(session.bytes_per_sample * session.channel_count);
+  session.frame_offset = session.frame.size();
+  session.noise_seed = 1;
+
+  session.encoder_interface->encoder_init(&peer_params, codec_config,
+                                          read_callback, enqueue_callback,
+                                          alloc_callback);
+  session.encoder_interface->feeding_reset();
+  session.encoder_interval_us =
+      session.encoder_interface->get_encoder_interval_ms() * 1000;
+  return true;
+}
+
+void end_session() {
+  session.encoder_interface->encoder_cleanup();
+  session = A2dpEncoderSession();
+}
+
+void BM_A2dpEncoder(State& state) {
+  btav_a2dp_codec_config_t codec_user_config = {};
+  codec_user_config.codec_type =
+      static_cast<btav_a2dp_codec_index_t>(state.range(0));
+  codec_user_config.codec_priority = BTAV_A2DP_CODEC_PRIORITY_HIGHEST;
+  codec_user_config.sample_rate =
+      static_cast<btav_a2dp_codec_sample_rate_t>(state.range(1));
+  codec_user_config.bits_per_sample =
+      static_cast<btav_a2dp_codec_bits_per_sample_t>(state.range(2));
+  codec_user_config.channel_mode =
+      static_cast<btav_a2dp_codec_channel_mode_t>(state.range(3));
+
+  A2dpCodecs codecs(std::vector<btav_a2dp_codec_config_t>{});
+  if (!codecs.init() || !start_session(&codecs, codec_user_config)) {
+    state.SkipWithError("codec configuration not available");
+    return;
+  }
+
+  uint64_t ticks = kSessionSeconds * 1000 * 1000 / session.encoder_interval_us;
+  uint64_t timestamp_us = 0;
+  uint64_t cpu_ns = 0;
+  for (auto _ : state) {
+    uint64_t start_ns = thread_cpu_time_ns();
+    for (uint64_t tick = 0; tick < ticks; tick++) {
+      timestamp_us += session.encoder_interval_us;
+      session.encoder_interface->send_frames(timestamp_us);
+    }
+    cpu_ns += thread_cpu_time_ns() - start_ns;
+  }
+
+  double audio_s = state.iterations() * ticks *
+                   session.encoder_interval_us / 1000000.0;
+  state.counters["cpu_us_per_audio_s"] = cpu_ns / 1000.0 / audio_s;
+  state.counters["allocs_per_audio_s"] = session.allocs / audio_s;
+  state.counters["alloc_bytes_per_audio_s"] = session.alloc_bytes / audio_s;
+  state.counters["bitrate_kbps"] = session.encoded_bytes * 8 / audio_s / 1000;
+  state.counters["frames_per_packet"] =
+      session.packets != 0 ? (double)session.codec_frames / session.packets
+                           : 0;
+  state.SetLabel(codec_user_config.ToString());
+  end_session();
+}
+
+void EncoderArguments(benchmark::internal::Benchmark* benchmark) {
+  const int sample_rates[] = {BTAV_A2DP_CODEC_SAMPLE_RATE_44100,
+                              BTAV_A2DP_CODEC_SAMPLE_RATE_48000,
+                              BTAV_A2DP_CODEC_SAMPLE_RATE_96000};
+  const int bits_per_samples[] = {BTAV_A2DP_CODEC_BITS_PER_SAMPLE_16,
+                                  BTAV_A2DP_CODEC_BITS_PER_SAMPLE_24,
+                                  BTAV_A2DP_CODEC_BITS_PER_SAMPLE_32};
+  const int channel_modes[] = {BTAV_A2DP_CODEC_CHANNEL_MODE_MONO,
+                               BTAV_A2DP_CODEC_CHANNEL_MODE_STEREO};
+  for (int codec_index = BTAV_A2DP_CODEC_INDEX_SOURCE_MIN;
+       codec_index < BTAV_A2DP_CODEC_INDEX_SOURCE_MAX; codec_index++) {
+    for (int sample_rate : sample_rates) {
+      for (int bits_per_sample : bits_per_samples) {
+        for (int channel_mode : channel_modes) {
+          benchmark->Args(
+              {codec_index, sample_rate, bits_per_sample, channel_mode});
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// The A2DP codecs query the current codec of BTA AV, the one configured by
+// start_session().
+A2dpCodecConfig* bta_av_get_a2dp_current_codec(void) {
+  return session.codecs != nullptr ? session.codecs->getCurrentCodecConfig()
+                                   : nullptr;
+}
+
+BENCHMARK(BM_A2dpEncoder)->Apply(EncoderArguments);
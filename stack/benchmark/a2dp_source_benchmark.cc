@@ -0,0 +1,358 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the A2DP Source media path: the media tick and TX queue
+// handling of btif_a2dp_source.cc around the A2DP encoders, fed with synthetic
+// audio and drained by a fake L2CAP sink. The codecs whose encoder library
+// cannot be loaded are skipped.
+//
+// BM_A2dpSourceSimulated runs the media ticks on a simulated clock, so the
+// queue behavior is reproducible from run to run. Each tick is late by a
+// random amount of up to range(1) milliseconds, and the fake L2CAP sink stops
+// reading for range(2) milliseconds every 5 seconds of audio.
+//
+// BM_A2dpSourceRealTime runs the media ticks from a RepeatingTimer on a
+// real-time MessageLoopThread, like the A2DP Source thread, and measures the
+// actual tick jitter.
+//
+// Both report the encode time per frame, the TX queue depth and the tick
+// jitter percentiles as counters. If A2DP_SOURCE_BENCHMARK_TRACE is set to a
+// file name, one line per tick is written to it with the tick timestamp,
+// jitter, TX queue depth, number of frames and encode time.
+
+#include <base/bind.h>
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "btif/include/btif_a2dp_source.h"
+#include "btif/include/btif_av_co.h"
+#include "common/message_loop_thread.h"
+#include "common/repeating_timer.h"
+#include "common/time_util.h"
+#include "osi/include/allocator.h"
+#include "osi/include/fixed_queue.h"
+#include "stack/include/a2dp_codec_api.h"
+
+using ::benchmark::State;
+using bluetooth::common::MessageLoopThread;
+using bluetooth::common::RepeatingTimer;
+using bluetooth::common::time_get_os_boottime_us;
+
+namespace {
+
+// Seconds of audio streamed by each iteration of BM_A2dpSourceSimulated
+constexpr uint64_t kSimulatedSessionSeconds = 60;
+
+// Seconds of audio streamed by BM_A2dpSourceRealTime
+constexpr uint64_t kRealTimeSessionSeconds = 10;
+
+// Period of the fake L2CAP sink stalls
+constexpr uint64_t kLinkStallPeriodUs = 5 * 1000 * 1000;
+
+// L2CAP MTU of the fake peer
+constexpr uint16_t kPeerMtu = 895;
+
+// Samples of one measurement, reported as percentiles
+class Samples {
+ public:
+  void Add(uint64_t value) { values_.push_back(value); }
+
+  uint64_t Percentile(double percentile) {
+    if (values_.empty()) return 0;
+    size_t index = percentile * (values_.size() - 1) / 100;
+    std::nth_element(values_.begin(), values_.begin() + index, values_.end());
+    return values_[index];
+  }
+
+  double Mean() const {
+    if (values_.empty()) return 0;
+    double sum = 0;
+    for (uint64_t value : values_) sum += value;
+    return sum / values_.size();
+  }
+
+ private:
+  std::vector<uint64_t> values_;
+};
+
+// State of the streaming session, accessed by the encoder callbacks
+struct A2dpSourceSession {
+  A2dpCodecs* codecs;
+  const tA2DP_ENCODER_INTERFACE* encoder_interface;
+  uint64_t encoder_interval_us;
+  fixed_queue_t* tx_audio_queue;
+  FILE* trace;
+
+  uint32_t audio_seed;
+  uint64_t last_tick_us;
+  size_t tick_frames;
+
+  size_t total_frames;
+  size_t tx_queue_dropouts;
+
+  Samples tick_jitter_us;
+  Samples tx_queue_depth;
+  Samples encode_ns_per_frame;
+};
+
+A2dpSourceSession session;
+
+// Synthetic audio feed
+uint32_t read_callback(uint8_t* p_buf, uint32_t len) {
+  for (uint32_t i = 0; i < len; i++) {
+    session.audio_seed = session.audio_seed * 1103515245 + 12345;
+    p_buf[i] = session.audio_seed >> 16;
+  }
+  return len;
+}
+
+// Same TX queue handling as btif_a2dp_source_enqueue_callback()
+bool enqueue_callback(BT_HDR* p_buf, size_t frames_n, uint32_t bytes_read) {
+  if (fixed_queue_length(session.tx_audio_queue) + frames_n >
+      MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ) {
+    session.tx_queue_dropouts++;
+    fixed_queue_flush(session.tx_audio_queue, osi_free);
+  }
+  session.tick_frames += frames_n;
+  fixed_queue_enqueue(session.tx_audio_queue, p_buf);
+  return true;
+}
+
+BT_HDR* alloc_callback(size_t size) { return (BT_HDR*)osi_malloc(size); }
+
+// Fake L2CAP sink, reads the TX queue until empty like the AV data path does
+// when the L2CAP channel is not congested.
+void l2cap_sink_read(uint64_t timestamp_us, uint64_t stall_us) {
+  if (timestamp_us % kLinkStallPeriodUs < stall_us) return;
+  void* p_buf;
+  while ((p_buf = fixed_queue_try_dequeue(session.tx_audio_queue)) != nullptr) {
+    osi_free(p_buf);
+  }
+}
+
+// Same steps as btif_a2dp_source_audio_handle_timer()
+void audio_handle_timer(uint64_t timestamp_us) {
+  size_t transmit_queue_length = fixed_queue_length(session.tx_audio_queue);
+  if (session.encoder_interface->set_transmit_queue_length != nullptr) {
+    session.encoder_interface->set_transmit_queue_length(
+        transmit_queue_length);
+  }
+
+  session.tick_frames = 0;
+  auto start_time = std::chrono::steady_clock::now();
+  session.encoder_interface->send_frames(timestamp_us);
+  uint64_t encode_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start_time)
+                           .count();
+
+  uint64_t jitter_us = 0;
+  if (session.last_tick_us != 0) {
+    uint64_t delta_us = timestamp_us - session.last_tick_us;
+    jitter_us = delta_us > session.encoder_interval_us
+                    ? delta_us - session.encoder_interval_us
+                    : session.encoder_interval_us - delta_us;
+    session.tick_jitter_us.Add(jitter_us);
+  }
+  session.last_tick_us = timestamp_us;
+  session.tx_queue_depth.Add(transmit_queue_length);
+  if (session.tick_frames > 0) {
+    session.encode_ns_per_frame.Add(encode_ns / session.tick_frames);
+  }
+  session.total_frames += session.tick_frames;
+
+  if (session.trace != nullptr) {
+    fprintf(session.trace, "%" PRIu64 " %" PRIu64 " %zu %zu %" PRIu64 "\n",
+            timestamp_us, jitter_us, transmit_queue_length, session.tick_frames,
+            encode_ns);
+  }
+}
+
+// Selects the codec |codec_index|, with its own capabilities as the
+// capabilities of the peer, and initializes its encoder. Returns false if the
+// codec is not available.
+bool start_session(A2dpCodecs* codecs, btav_a2dp_codec_index_t codec_index) {
+  AvdtpSepConfig sep_config;
+  uint8_t codec_info[AVDT_CODEC_SIZE];
+  if (!codecs->isSupportedCodec(codec_index) ||
+      !A2DP_InitCodecConfig(codec_index, &sep_config) ||
+      !codecs->setCodecConfig(sep_config.codec_info, true /* is_capability */,
+                              codec_info, true /* select_current_codec */)) {
+    return false;
+  }
+  session.encoder_interface = A2DP_GetEncoderInterface(codec_info);
+  if (session.encoder_interface == nullptr) return false;
+  session.codecs = codecs;
+
+  tA2DP_ENCODER_INIT_PEER_PARAMS peer_params;
+  peer_params.is_peer_edr = true;
+  peer_params.peer_supports_3mbps = true;
+  peer_params.peer_mtu = kPeerMtu;
+  session.encoder_interface->encoder_init(&peer_params,
+                                          codecs->getCurrentCodecConfig(),
+                                          read_callback, enqueue_callback,
+                                          alloc_callback);
+  session.encoder_interface->feeding_reset();
+  session.encoder_interval_us =
+      session.encoder_interface->get_encoder_interval_ms() * 1000;
+  session.tx_audio_queue = fixed_queue_new(SIZE_MAX);
+  session.audio_seed = 1;
+  session.last_tick_us = 0;
+
+  const char* trace = getenv("A2DP_SOURCE_BENCHMARK_TRACE");
+  session.trace = trace != nullptr ? fopen(trace, "w") : nullptr;
+  return true;
+}
+
+void end_session() {
+  session.encoder_interface->encoder_cleanup();
+  fixed_queue_free(session.tx_audio_queue, osi_free);
+  if (session.trace != nullptr) fclose(session.trace);
+  session = A2dpSourceSession();
+}
+
+void report_session(State& state) {
+  state.counters["encode_ns_per_frame_p50"] =
+      session.encode_ns_per_frame.Percentile(50);
+  state.counters["encode_ns_per_frame_p99"] =
+      session.encode_ns_per_frame.Percentile(99);
+  state.counters["tx_queue_depth_mean"] = session.tx_queue_depth.Mean();
+  state.counters["tx_queue_depth_p99"] = session.tx_queue_depth.Percentile(99);
+  state.counters["tx_queue_depth_max"] = session.tx_queue_depth.Percentile(100);
+  state.counters["tx_queue_dropouts"] = session.tx_queue_dropouts;
+  state.counters["tick_jitter_us_p50"] = session.tick_jitter_us.Percentile(50);
+  state.counters["tick_jitter_us_p90"] = session.tick_jitter_us.Percentile(90);
+  state.counters["tick_jitter_us_p99"] = session.tick_jitter_us.Percentile(99);
+  state.counters["tick_jitter_us_p999"] =
+      session.tick_jitter_us.Percentile(99.9);
+  state.counters["tick_jitter_us_max"] = session.tick_jitter_us.Percentile(100);
+  state.SetItemsProcessed(session.total_frames);
+  state.SetLabel(A2DP_CodecIndexStr(
+      static_cast<btav_a2dp_codec_index_t>(state.range(0))));
+}
+
+void BM_A2dpSourceSimulated(State& state) {
+  auto codec_index = static_cast<btav_a2dp_codec_index_t>(state.range(0));
+  uint64_t max_lateness_us = state.range(1) * 1000;
+  uint64_t stall_us = state.range(2) * 1000;
+
+  A2dpCodecs codecs(std::vector<btav_a2dp_codec_config_t>{});
+  if (!codecs.init() || !start_session(&codecs, codec_index)) {
+    state.SkipWithError("codec not available");
+    return;
+  }
+
+  std::mt19937 random(1);
+  std::uniform_int_distribution<uint64_t> lateness_us(0, max_lateness_us);
+  uint64_t ticks = kSimulatedSessionSeconds * 1000 * 1000 /
+                   session.encoder_interval_us;
+  uint64_t session_start_us = 0;
+  for (auto _ : state) {
+    for (uint64_t tick = 1; tick <= ticks; tick++) {
+      uint64_t timestamp_us = session_start_us +
+                              tick * session.encoder_interval_us +
+                              lateness_us(random);
+      audio_handle_timer(timestamp_us);
+      l2cap_sink_read(timestamp_us, stall_us);
+    }
+    session_start_us += ticks * session.encoder_interval_us;
+  }
+
+  report_session(state);
+  end_session();
+}
+
+void BM_A2dpSourceRealTime(State& state) {
+  auto codec_index = static_cast<btav_a2dp_codec_index_t>(state.range(0));
+
+  A2dpCodecs codecs(std::vector<btav_a2dp_codec_config_t>{});
+  if (!codecs.init() || !start_session(&codecs, codec_index)) {
+    state.SkipWithError("codec not available");
+    return;
+  }
+
+  MessageLoopThread thread("bt_a2dp_source_benchmark");
+  thread.StartUp();
+  if (!thread.EnableRealTimeScheduling()) {
+    LOG(WARNING) << "Unable to enable real time scheduling";
+  }
+
+  uint64_t ticks =
+      kRealTimeSessionSeconds * 1000 * 1000 / session.encoder_interval_us;
+  for (auto _ : state) {
+    uint64_t ticks_left = ticks;
+    std::promise<void> done;
+    RepeatingTimer media_alarm;
+    media_alarm.SchedulePeriodic(
+        thread.GetWeakPtr(), FROM_HERE,
+        base::Bind(
+            [](uint64_t* ticks_left, std::promise<void>* done) {
+              if (*ticks_left == 0) return;
+              uint64_t timestamp_us = time_get_os_boottime_us();
+              audio_handle_timer(timestamp_us);
+              l2cap_sink_read(timestamp_us, 0);
+              if (--*ticks_left == 0) done->set_value();
+            },
+            &ticks_left, &done),
+        base::TimeDelta::FromMicroseconds(session.encoder_interval_us));
+    done.get_future().wait();
+    media_alarm.CancelAndWait();
+  }
+
+  thread.ShutDown();
+  report_session(state);
+  end_session();
+}
+
+void SimulatedArguments(benchmark::internal::Benchmark* benchmark) {
+  for (int codec_index = BTAV_A2DP_CODEC_INDEX_SOURCE_MIN;
+       codec_index < BTAV_A2DP_CODEC_INDEX_SOURCE_MAX; codec_index++) {
+    // Ideal timer and link, late timer, stalled link
+    benchmark->Args({codec_index, 0, 0});
+    benchmark->Args({codec_index, 10, 0});
+    benchmark->Args({codec_index, 0, 200});
+  }
+}
+
+void RealTimeArguments(benchmark::internal::Benchmark* benchmark) {
+  for (int codec_index = BTAV_A2DP_CODEC_INDEX_SOURCE_MIN;
+       codec_index < BTAV_A2DP_CODEC_INDEX_SOURCE_MAX; codec_index++) {
+    benchmark->Arg(codec_index);
+  }
+}
+
+}  // namespace
+
+// The A2DP codecs query the current codec of BTA AV, the one configured by
+// start_session().
+A2dpCodecConfig* bta_av_get_a2dp_current_codec(void) {
+  return session.codecs != nullptr ? session.codecs->getCurrentCodecConfig()
+                                   : nullptr;
+}
+
+BENCHMARK(BM_A2dpSourceSimulated)->Apply(SimulatedArguments);
+BENCHMARK(BM_A2dpSourceRealTime)
+    ->Apply(RealTimeArguments)
+    ->Iterations(1)
+    ->UseRealTime();
@@ -0,0 +1,170 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the compilation and evaluation of the BNEP network
+ *  protocol type and multicast address filters.
+ *
+ ******************************************************************************/
+
+#include "bnep_filter.h"
+
+#include <string.h>
+
+#define BNEP_FILTER_ADDR_LEN 6
+
+/* Sorts the |num| ranges by start, then merges the overlapping and adjacent
+ * ones. Returns the number of ranges left. */
+static uint16_t bnep_filter_merge(uint64_t* p_start, uint64_t* p_end,
+                                  uint16_t num) {
+  /* There are a few ranges at most, an insertion sort is enough */
+  for (uint16_t i = 1; i < num; i++) {
+    uint64_t start = p_start[i], end = p_end[i];
+    uint16_t j = i;
+    for (; j > 0 && p_start[j - 1] > start; j--) {
+      p_start[j] = p_start[j - 1];
+      p_end[j] = p_end[j - 1];
+    }
+    p_start[j] = start;
+    p_end[j] = end;
+  }
+
+  uint16_t merged = 0;
+  for (uint16_t i = 0; i < num; i++) {
+    if (merged > 0 && p_start[i] <= p_end[merged - 1] + 1) {
+      if (p_end[i] > p_end[merged - 1]) p_end[merged - 1] = p_end[i];
+      continue;
+    }
+    p_start[merged] = p_start[i];
+    p_end[merged] = p_end[i];
+    merged++;
+  }
+  return merged;
+}
+
+/* Returns true if |value| is in one of the |num| sorted disjoint ranges */
+template <typename T>
+static bool bnep_filter_search(const T* p_start, const T* p_end, uint16_t num,
+                               T value) {
+  uint16_t low = 0, high = num;
+  while (low < high) {
+    uint16_t mid = (low + high) / 2;
+    if (value < p_start[mid])
+      high = mid;
+    else if (value > p_end[mid])
+      low = mid + 1;
+    else
+      return true;
+  }
+  return false;
+}
+
+static uint64_t bnep_filter_addr(const uint8_t* p_addr) {
+  uint64_t addr = 0;
+  for (int i = 0; i < BNEP_FILTER_ADDR_LEN; i++) addr = (addr << 8) | p_addr[i];
+  return addr;
+}
+
+void bnep_prot_filter_set(tBNEP_PROT_FILTER* p_filter, uint16_t num_filters,
+                          const uint8_t* p_filters) {
+  uint64_t start[BNEP_MAX_PROT_FILTERS], end[BNEP_MAX_PROT_FILTERS];
+
+  memset(p_filter, 0, sizeof(*p_filter));
+  if (num_filters == 0 || num_filters > BNEP_MAX_PROT_FILTERS) return;
+
+  for (uint16_t xx = 0; xx < num_filters; xx++) {
+    start[xx] = (p_filters[0] << 8) | p_filters[1];
+    end[xx] = (p_filters[2] << 8) | p_filters[3];
+    p_filters += 4;
+  }
+
+  p_filter->active = true;
+  p_filter->num_ranges = bnep_filter_merge(start, end, num_filters);
+  for (uint16_t xx = 0; xx < p_filter->num_ranges; xx++) {
+    p_filter->start[xx] = (uint16_t)start[xx];
+    p_filter->end[xx] = (uint16_t)end[xx];
+  }
+
+  const struct {
+    uint16_t proto;
+    uint8_t flag;
+  } common[] = {{0x0800, BNEP_FILTER_COMMON_IPV4},
+                {0x0806, BNEP_FILTER_COMMON_ARP},
+                {0x86DD, BNEP_FILTER_COMMON_IPV6}};
+  for (const auto& entry : common) {
+    if (bnep_filter_search(p_filter->start, p_filter->end,
+                           p_filter->num_ranges, entry.proto))
+      p_filter->common_allowed |= entry.flag;
+  }
+}
+
+bool bnep_prot_filter_allows(const tBNEP_PROT_FILTER* p_filter,
+                             uint16_t proto) {
+  if (!p_filter->active) return true;
+
+  switch (proto) {
+    case 0x0800:
+      return p_filter->common_allowed & BNEP_FILTER_COMMON_IPV4;
+    case 0x0806:
+      return p_filter->common_allowed & BNEP_FILTER_COMMON_ARP;
+    case 0x86DD:
+      return p_filter->common_allowed & BNEP_FILTER_COMMON_IPV6;
+    default:
+      return bnep_filter_search(p_filter->start, p_filter->end,
+                                p_filter->num_ranges, proto);
+  }
+}
+
+void bnep_mcast_filter_set(tBNEP_MCAST_FILTER* p_filter, uint16_t num_filters,
+                           const uint8_t* p_filters) {
+  memset(p_filter, 0, sizeof(*p_filter));
+  if (num_filters == 0 || num_filters > BNEP_MAX_MULTI_FILTERS) return;
+
+  p_filter->active = true;
+  for (uint16_t xx = 0; xx < num_filters; xx++) {
+    uint64_t start = bnep_filter_addr(p_filters);
+    uint64_t end = bnep_filter_addr(p_filters + BNEP_FILTER_ADDR_LEN);
+    p_filters += 2 * BNEP_FILTER_ADDR_LEN;
+
+    /* A range of null addresses filters every multicast address */
+    if (start == 0 && end == 0) {
+      p_filter->num_ranges = 0;
+      return;
+    }
+    p_filter->start[xx] = start;
+    p_filter->end[xx] = end;
+  }
+  p_filter->num_ranges =
+      bnep_filter_merge(p_filter->start, p_filter->end, num_filters);
+}
+
+bool bnep_mcast_filter_allows(tBNEP_MCAST_FILTER* p_filter,
+                              const RawAddress& addr) {
+  if (!p_filter->active) return true;
+
+  uint64_t value = bnep_filter_addr(addr.address);
+  if (p_filter->cache_valid && p_filter->cache_addr == value)
+    return p_filter->cache_allowed;
+
+  p_filter->cache_valid = true;
+  p_filter->cache_addr = value;
+  p_filter->cache_allowed = bnep_filter_search(
+      p_filter->start, p_filter->end, p_filter->num_ranges, value);
+  return p_filter->cache_allowed;
+}
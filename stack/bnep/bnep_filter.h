@@ -0,0 +1,122 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the compiled forms of the network protocol type and
+ *  multicast address filters set by a BNEP peer, checked for every frame
+ *  sent to it.
+ *
+ *  When set, the ranges are sorted and the overlapping or adjacent ones are
+ *  merged, so a frame is checked with a binary search. The result for the
+ *  common ethertypes is precomputed, and the result for the last multicast
+ *  address is cached, until the filters change.
+ *
+ ******************************************************************************/
+
+#ifndef BNEP_FILTER_H
+#define BNEP_FILTER_H
+
+#include <stdint.h>
+
+#include "bt_target.h"
+#include "types/raw_address.h"
+
+/* Common ethertypes with a precomputed filter result */
+#define BNEP_FILTER_COMMON_IPV4 0x01 /* 0x0800 */
+#define BNEP_FILTER_COMMON_ARP 0x02  /* 0x0806 */
+#define BNEP_FILTER_COMMON_IPV6 0x04 /* 0x86DD */
+
+typedef struct {
+  bool active; /* false if every protocol is allowed */
+  uint8_t common_allowed; /* BNEP_FILTER_COMMON_* allowed by the ranges */
+  uint16_t num_ranges;    /* Sorted, disjoint and not adjacent ranges */
+  uint16_t start[BNEP_MAX_PROT_FILTERS];
+  uint16_t end[BNEP_MAX_PROT_FILTERS];
+} tBNEP_PROT_FILTER;
+
+typedef struct {
+  bool active; /* false if every multicast address is allowed */
+  uint16_t num_ranges; /* Sorted, disjoint and not adjacent ranges */
+  uint64_t start[BNEP_MAX_MULTI_FILTERS]; /* 48 bit addresses, big endian */
+  uint64_t end[BNEP_MAX_MULTI_FILTERS];
+
+  /* Result for the last address checked */
+  bool cache_valid;
+  bool cache_allowed;
+  uint64_t cache_addr;
+} tBNEP_MCAST_FILTER;
+
+/*******************************************************************************
+ *
+ * Function         bnep_prot_filter_set
+ *
+ * Description      Compiles the |num_filters| network protocol type ranges
+ *                  of |p_filters|, in the format of a Filter Net Type Set
+ *                  message, already validated. No range allows every
+ *                  protocol.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bnep_prot_filter_set(tBNEP_PROT_FILTER* p_filter, uint16_t num_filters,
+                          const uint8_t* p_filters);
+
+/*******************************************************************************
+ *
+ * Function         bnep_prot_filter_allows
+ *
+ * Description      Checks the network protocol type |proto| against the
+ *                  filter.
+ *
+ * Returns          true if the protocol is allowed
+ *
+ ******************************************************************************/
+bool bnep_prot_filter_allows(const tBNEP_PROT_FILTER* p_filter,
+                             uint16_t proto);
+
+/*******************************************************************************
+ *
+ * Function         bnep_mcast_filter_set
+ *
+ * Description      Compiles the |num_filters| multicast address ranges of
+ *                  |p_filters|, in the format of a Filter Multi Addr Set
+ *                  message, already validated. No range allows every
+ *                  multicast address, and a range from and to the null
+ *                  address allows none.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bnep_mcast_filter_set(tBNEP_MCAST_FILTER* p_filter, uint16_t num_filters,
+                           const uint8_t* p_filters);
+
+/*******************************************************************************
+ *
+ * Function         bnep_mcast_filter_allows
+ *
+ * Description      Checks the multicast address |addr| against the filter,
+ *                  updating the cached result.
+ *
+ * Returns          true if the address is allowed
+ *
+ ******************************************************************************/
+bool bnep_mcast_filter_allows(tBNEP_MCAST_FILTER* p_filter,
+                              const RawAddress& addr);
+
+#endif /* BNEP_FILTER_H */
@@ -26,6 +26,7 @@
 #define BNEP_INT_H
 
 #include "bnep_api.h"
+#include "bnep_filter.h"
 #include "bt_common.h"
 #include "bt_target.h"
 #include "btm_int.h"
@@ -140,12 +141,10 @@ typedef struct {
   RawAddress sent_mcast_filter_end[BNEP_MAX_MULTI_FILTERS];
 
   uint16_t rcvd_num_filters;
-  uint16_t rcvd_prot_filter_start[BNEP_MAX_PROT_FILTERS];
-  uint16_t rcvd_prot_filter_end[BNEP_MAX_PROT_FILTERS];
+  tBNEP_PROT_FILTER rcvd_prot_filter;
 
   uint16_t rcvd_mcast_filters;
-  RawAddress rcvd_mcast_filter_start[BNEP_MAX_MULTI_FILTERS];
-  RawAddress rcvd_mcast_filter_end[BNEP_MAX_MULTI_FILTERS];
+  tBNEP_MCAST_FILTER rcvd_mcast_filter;
 
   uint16_t bad_pkts_rcvd;
   uint8_t re_transmits;
@@ -938,13 +938,7 @@ void bnepu_process_peer_filter_set(tBNEP_CONN* p_bcb, uint8_t* p_filters,
     (*bnep_cb.p_filter_ind_cb)(p_bcb->handle, true, 0, len, p_filters);
 
   p_bcb->rcvd_num_filters = num_filters;
-  for (xx = 0; xx < num_filters; xx++) {
-    BE_STREAM_TO_UINT16(start, p_filters);
-    BE_STREAM_TO_UINT16(end, p_filters);
-
-    p_bcb->rcvd_prot_filter_start[xx] = start;
-    p_bcb->rcvd_prot_filter_end[xx] = end;
-  }
+  bnep_prot_filter_set(&p_bcb->rcvd_prot_filter, num_filters, p_filters);
 
   bnepu_send_peer_filter_rsp(p_bcb, resp_code);
 }
@@ -1090,21 +1084,16 @@ void bnepu_process_peer_multicast_filter_set(tBNEP_CONN* p_bcb,
   }
 
   p_bcb->rcvd_mcast_filters = num_filters;
+  bnep_mcast_filter_set(&p_bcb->rcvd_mcast_filter, num_filters, p_filters);
   for (xx = 0; xx < num_filters; xx++) {
-    memcpy(p_bcb->rcvd_mcast_filter_start[xx].address, p_filters, BD_ADDR_LEN);
-    memcpy(p_bcb->rcvd_mcast_filter_end[xx].address, p_filters + BD_ADDR_LEN,
-           BD_ADDR_LEN);
-    p_filters += (BD_ADDR_LEN * 2);
-
     /* Check if any of the ranges have all zeros as both starting and ending
      * addresses */
-    if ((memcmp(null_bda, p_bcb->rcvd_mcast_filter_start[xx].address,
-                BD_ADDR_LEN) == 0) &&
-        (memcmp(null_bda, p_bcb->rcvd_mcast_filter_end[xx].address,
-                BD_ADDR_LEN) == 0)) {
+    if ((memcmp(null_bda, p_filters, BD_ADDR_LEN) == 0) &&
+        (memcmp(null_bda, p_filters + BD_ADDR_LEN, BD_ADDR_LEN) == 0)) {
       p_bcb->rcvd_mcast_filters = 0xFFFF;
       break;
     }
+    p_filters += (BD_ADDR_LEN * 2);
   }
 
   BNEP_TRACE_EVENT("BNEP multicast filters %d", p_bcb->rcvd_mcast_filters);
@@ -1261,7 +1250,7 @@ tBNEP_RESULT bnep_is_packet_allowed(tBNEP_CONN* p_bcb,
                                     uint16_t protocol, bool fw_ext_present,
                                     uint8_t* p_data, uint16_t org_len) {
   if (p_bcb->rcvd_num_filters) {
-    uint16_t i, proto;
+    uint16_t proto;
 
     /* Findout the actual protocol to check for the filtering */
     proto = protocol;
@@ -1290,45 +1279,19 @@ tBNEP_RESULT bnep_is_packet_allowed(tBNEP_CONN* p_bcb,
       BE_STREAM_TO_UINT16(proto, p_data);
     }
 
-    for (i = 0; i < p_bcb->rcvd_num_filters; i++) {
-      if ((p_bcb->rcvd_prot_filter_start[i] <= proto) &&
-          (proto <= p_bcb->rcvd_prot_filter_end[i]))
-        break;
-    }
-
-    if (i == p_bcb->rcvd_num_filters) {
+    if (!bnep_prot_filter_allows(&p_bcb->rcvd_prot_filter, proto)) {
       BNEP_TRACE_DEBUG("Ignoring protocol 0x%x in BNEP data write", proto);
       return BNEP_IGNORE_CMD;
     }
   }
 
   /* Ckeck for multicast address filtering */
-  if ((p_dest_addr.address[0] & 0x01) && p_bcb->rcvd_mcast_filters) {
-    uint16_t i;
-
-    /* Check if every multicast should be filtered */
-    if (p_bcb->rcvd_mcast_filters != 0xFFFF) {
-      /* Check if the address is mentioned in the filter range */
-      for (i = 0; i < p_bcb->rcvd_mcast_filters; i++) {
-        if ((memcmp(p_bcb->rcvd_mcast_filter_start[i].address,
-                    p_dest_addr.address, BD_ADDR_LEN) <= 0) &&
-            (memcmp(p_bcb->rcvd_mcast_filter_end[i].address,
-                    p_dest_addr.address, BD_ADDR_LEN) >= 0))
-          break;
-      }
-    }
-
-    /*
-    ** If every multicast should be filtered or the address is not in the filter
-    *range
-    ** drop the packet
-    */
-    if ((p_bcb->rcvd_mcast_filters == 0xFFFF) ||
-        (i == p_bcb->rcvd_mcast_filters)) {
-      VLOG(1) << "Ignoring multicast address " << p_dest_addr
-              << " in BNEP data write";
-      return BNEP_IGNORE_CMD;
-    }
+  if ((p_dest_addr.address[0] & 0x01) &&
+      !bnep_mcast_filter_allows(&p_bcb->rcvd_mcast_filter, p_dest_addr)) {
+    /* Every multicast is filtered or the address is not in the filter range */
+    VLOG(1) << "Ignoring multicast address " << p_dest_addr
+            << " in BNEP data write";
+    return BNEP_IGNORE_CMD;
   }
 
   return BNEP_SUCCESS;
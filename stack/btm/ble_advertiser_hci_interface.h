@@ -107,6 +107,9 @@ class BleAdvertiserHciInterface {
 
   // Some implementation don't behave well when handle value 0 is used.
   virtual bool QuirkAdvertiserZeroHandle() { return 0; }
+
+  // Whether |Enable| can take more than one set in a single command.
+  virtual bool SupportsMultiSetEnable() { return false; }
 };
 
 #endif  // BLE_ADVERTISER_HCI_INTERFACE_H
@@ -0,0 +1,378 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "ble_host_adv_filter.h"
+
+#include <string.h>
+#include <algorithm>
+
+using bluetooth::Uuid;
+
+static_assert(BTM_BLE_HOST_PF_MAX_CONDITIONS <= 256,
+              "condition indexes are stored on 8 bits");
+static_assert(BTM_BLE_PF_STR_LEN_MAX + 2 >= Uuid::kNumBytes128,
+              "patterns must hold a 128 bit UUID");
+
+namespace {
+/* Bluetooth Base UUID, 00000000-0000-1000-8000-00805F9B34FB, little endian.
+ * 16 and 32 bit UUIDs are stored in its last four bytes. */
+constexpr uint8_t kBaseUuidLE[Uuid::kNumBytes128] = {
+    0xFB, 0x34, 0x9B, 0x5F, 0x80, 0x00, 0x00, 0x80,
+    0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+constexpr size_t kShortUuidOffset = 12;
+
+size_t uuid_table(tBTM_BLE_PF_COND_TYPE type) {
+  return type == BTM_BLE_PF_SRVC_SOL_UUID ? 1 : 0;
+}
+}  // namespace
+
+BleHostAdvFilter::BleHostAdvFilter() : enabled_(false) { Clear(); }
+
+bool BleHostAdvFilter::AddCondition(tBTM_BLE_PF_FILT_INDEX filt_index,
+                                    const ApcfCommand& cmd) {
+  if (filt_index >= BTM_BLE_HOST_PF_MAX_FILTERS ||
+      conditions_.size() >= BTM_BLE_HOST_PF_MAX_CONDITIONS) {
+    return false;
+  }
+
+  Condition cond;
+  memset(&cond, 0, sizeof(cond));
+  cond.filt_index = filt_index;
+  cond.type = cmd.type;
+
+  switch (cmd.type) {
+    case BTM_BLE_PF_ADDR_FILTER:
+      cond.address = cmd.address;
+      break;
+
+    case BTM_BLE_PF_SRVC_DATA:
+      break;
+
+    case BTM_BLE_PF_SRVC_UUID:
+    case BTM_BLE_PF_SRVC_SOL_UUID: {
+      size_t uuid_len = cmd.uuid.GetShortestRepresentationSize();
+      const Uuid::UUID128Bit uuid = cmd.uuid.To128BitLE();
+      cond.len = Uuid::kNumBytes128;
+      memcpy(cond.pattern, uuid.data(), Uuid::kNumBytes128);
+      memset(cond.mask, 0xff, Uuid::kNumBytes128);
+
+      /* Short masks only apply to the short part of the UUID */
+      if (!cmd.uuid_mask.IsEmpty()) {
+        uint8_t* p = cond.mask + kShortUuidOffset;
+        if (uuid_len == Uuid::kNumBytes16) {
+          UINT16_TO_STREAM(p, cmd.uuid_mask.As16Bit());
+        } else if (uuid_len == Uuid::kNumBytes32) {
+          UINT32_TO_STREAM(p, cmd.uuid_mask.As32Bit());
+        } else {
+          const Uuid::UUID128Bit mask = cmd.uuid_mask.To128BitLE();
+          memcpy(cond.mask, mask.data(), Uuid::kNumBytes128);
+        }
+      }
+      break;
+    }
+
+    case BTM_BLE_PF_LOCAL_NAME:
+      if (cmd.name.empty()) return false;
+      /* Like the controller, only the beginning of long names is matched */
+      cond.exact_len = cmd.name.size() <= BTM_BLE_PF_STR_LEN_MAX;
+      cond.len = std::min(cmd.name.size(), (size_t)BTM_BLE_PF_STR_LEN_MAX);
+      memcpy(cond.pattern, cmd.name.data(), cond.len);
+      memset(cond.mask, 0xff, cond.len);
+      break;
+
+    case BTM_BLE_PF_MANU_DATA: {
+      uint8_t* p = cond.pattern;
+      UINT16_TO_STREAM(p, cmd.company);
+      p = cond.mask;
+      UINT16_TO_STREAM(p, cmd.company_mask != 0 ? cmd.company_mask : 0xFFFF);
+      cond.len = 2;
+
+      /* Data is only matched along with a mask, as on the controller */
+      size_t size =
+          std::min(cmd.data.size(), (size_t)(BTM_BLE_PF_STR_LEN_MAX - 2));
+      if (size > 0 && cmd.data_mask.size() >= size) {
+        memcpy(cond.pattern + 2, cmd.data.data(), size);
+        memcpy(cond.mask + 2, cmd.data_mask.data(), size);
+        cond.len += size;
+      }
+      break;
+    }
+
+    case BTM_BLE_PF_SRVC_DATA_PATTERN: {
+      size_t size =
+          std::min(cmd.data.size(), (size_t)(BTM_BLE_PF_STR_LEN_MAX - 2));
+      if (size == 0) return false;
+      memcpy(cond.pattern, cmd.data.data(), size);
+      if (cmd.data_mask.size() >= size) {
+        memcpy(cond.mask, cmd.data_mask.data(), size);
+      } else {
+        memset(cond.mask, 0xff, size);
+      }
+      cond.len = size;
+      break;
+    }
+
+    default:
+      return false;
+  }
+
+  for (size_t i = 0; i < cond.len; i++) cond.pattern[i] &= cond.mask[i];
+
+  conditions_.push_back(cond);
+  Compile();
+  return true;
+}
+
+void BleHostAdvFilter::ClearConditions(tBTM_BLE_PF_FILT_INDEX filt_index) {
+  conditions_.erase(std::remove_if(conditions_.begin(), conditions_.end(),
+                                   [filt_index](const Condition& cond) {
+                                     return cond.filt_index == filt_index;
+                                   }),
+                    conditions_.end());
+  Compile();
+}
+
+bool BleHostAdvFilter::SetParams(tBTM_BLE_PF_FILT_INDEX filt_index,
+                                 const btgatt_filt_param_setup_t& params) {
+  if (filt_index >= BTM_BLE_HOST_PF_MAX_FILTERS) return false;
+
+  Filter& filter = filters_[filt_index];
+  if (!filter.applied) num_applied_++;
+  filter.applied = true;
+  filter.feat_seln = params.feat_seln;
+  filter.list_logic_type = params.list_logic_type;
+  filter.filt_logic_type = params.filt_logic_type;
+  filter.rssi_high_thres = (int8_t)params.rssi_high_thres;
+  return true;
+}
+
+void BleHostAdvFilter::DeleteParams(tBTM_BLE_PF_FILT_INDEX filt_index) {
+  if (filt_index >= BTM_BLE_HOST_PF_MAX_FILTERS) return;
+
+  Filter& filter = filters_[filt_index];
+  if (filter.applied) num_applied_--;
+  filter.applied = false;
+}
+
+void BleHostAdvFilter::Clear() {
+  num_applied_ = 0;
+  conditions_.clear();
+  for (Filter& filter : filters_) filter.applied = false;
+  Compile();
+}
+
+void BleHostAdvFilter::Compile() {
+  for (Filter& filter : filters_) {
+    for (ConditionSet& set : filter.conditions) set.reset();
+  }
+  for (size_t table = 0; table < 2; table++) {
+    uuid16_bits_[table].reset();
+    uuid16_conds_[table].clear();
+    uuid_conds_[table].clear();
+  }
+  addr_conds_.clear();
+  name_conds_.clear();
+  manu_conds_.clear();
+  srvc_data_conds_.clear();
+  srvc_data_pattern_conds_.clear();
+
+  for (size_t i = 0; i < conditions_.size(); i++) {
+    const Condition& cond = conditions_[i];
+    filters_[cond.filt_index].conditions[cond.type].set(i);
+
+    switch (cond.type) {
+      case BTM_BLE_PF_ADDR_FILTER:
+        addr_conds_.push_back(i);
+        break;
+
+      case BTM_BLE_PF_SRVC_DATA:
+        srvc_data_conds_.push_back(i);
+        break;
+
+      case BTM_BLE_PF_SRVC_UUID:
+      case BTM_BLE_PF_SRVC_SOL_UUID: {
+        size_t table = uuid_table(cond.type);
+        bool unmasked = std::all_of(cond.mask, cond.mask + cond.len,
+                                    [](uint8_t m) { return m == 0xff; });
+        Uuid uuid = Uuid::From128BitLE(cond.pattern);
+        if (unmasked && uuid.Is16Bit()) {
+          uuid16_bits_[table].set(uuid.As16Bit());
+          uuid16_conds_[table].emplace_back(uuid.As16Bit(), i);
+        } else {
+          uuid_conds_[table].push_back(i);
+        }
+        break;
+      }
+
+      case BTM_BLE_PF_LOCAL_NAME:
+        name_conds_.push_back(i);
+        break;
+
+      case BTM_BLE_PF_MANU_DATA:
+        manu_conds_.push_back(i);
+        break;
+
+      case BTM_BLE_PF_SRVC_DATA_PATTERN:
+        srvc_data_pattern_conds_.push_back(i);
+        break;
+    }
+  }
+
+  for (size_t table = 0; table < 2; table++) {
+    std::sort(uuid16_conds_[table].begin(), uuid16_conds_[table].end());
+  }
+}
+
+void BleHostAdvFilter::MatchUuid(size_t table, const uint8_t* uuid,
+                                 size_t uuid_len, ConditionSet* matched) const {
+  uint8_t full[Uuid::kNumBytes128];
+  if (uuid_len == Uuid::kNumBytes128) {
+    memcpy(full, uuid, Uuid::kNumBytes128);
+  } else {
+    memcpy(full, kBaseUuidLE, Uuid::kNumBytes128);
+    memcpy(full + kShortUuidOffset, uuid, uuid_len);
+  }
+
+  bool is_16bit = memcmp(full, kBaseUuidLE, kShortUuidOffset) == 0 &&
+                  full[kShortUuidOffset + 2] == 0 &&
+                  full[kShortUuidOffset + 3] == 0;
+  if (is_16bit) {
+    uint16_t uuid16 =
+        full[kShortUuidOffset] | (full[kShortUuidOffset + 1] << 8);
+    if (uuid16_bits_[table].test(uuid16)) {
+      auto range = std::equal_range(
+          uuid16_conds_[table].begin(), uuid16_conds_[table].end(),
+          std::make_pair(uuid16, (uint8_t)0),
+          [](const std::pair<uint16_t, uint8_t>& a,
+             const std::pair<uint16_t, uint8_t>& b) {
+            return a.first < b.first;
+          });
+      for (auto it = range.first; it != range.second; ++it) {
+        matched->set(it->second);
+      }
+    }
+  }
+
+  for (uint8_t i : uuid_conds_[table]) {
+    const Condition& cond = conditions_[i];
+    size_t j = 0;
+    while (j < cond.len && (full[j] & cond.mask[j]) == cond.pattern[j]) j++;
+    if (j == cond.len) matched->set(i);
+  }
+}
+
+void BleHostAdvFilter::MatchData(const std::vector<uint8_t>& conditions,
+                                 const uint8_t* data, size_t data_len,
+                                 ConditionSet* matched) const {
+  for (uint8_t i : conditions) {
+    const Condition& cond = conditions_[i];
+    if (data_len < cond.len || (cond.exact_len && data_len != cond.len))
+      continue;
+
+    size_t j = 0;
+    while (j < cond.len && (data[j] & cond.mask[j]) == cond.pattern[j]) j++;
+    if (j == cond.len) matched->set(i);
+  }
+}
+
+bool BleHostAdvFilter::Matches(const RawAddress& bda, int8_t rssi,
+                               const uint8_t* data, size_t data_len) const {
+  ConditionSet matched;
+
+  for (uint8_t i : addr_conds_) {
+    if (conditions_[i].address == bda) matched.set(i);
+  }
+
+  const uint8_t* p = data;
+  const uint8_t* end = data + data_len;
+  while (p < end && *p != 0 && p + 1 + *p <= end) {
+    uint8_t ad_type = p[1];
+    const uint8_t* payload = p + 2;
+    size_t payload_len = *p - 1;
+    p += 1 + *p;
+
+    size_t table = 0;
+    size_t uuid_len = 0;
+    switch (ad_type) {
+      case BT_EIR_SOLICITED_16BITS_UUID_TYPE:
+        table = 1;
+        [[fallthrough]];
+      case BT_EIR_MORE_16BITS_UUID_TYPE:
+      case BT_EIR_COMPLETE_16BITS_UUID_TYPE:
+        uuid_len = Uuid::kNumBytes16;
+        break;
+
+      case BT_EIR_SOLICITED_32BITS_UUID_TYPE:
+        table = 1;
+        [[fallthrough]];
+      case BT_EIR_MORE_32BITS_UUID_TYPE:
+      case BT_EIR_COMPLETE_32BITS_UUID_TYPE:
+        uuid_len = Uuid::kNumBytes32;
+        break;
+
+      case BT_EIR_SOLICITED_128BITS_UUID_TYPE:
+        table = 1;
+        [[fallthrough]];
+      case BT_EIR_MORE_128BITS_UUID_TYPE:
+      case BT_EIR_COMPLETE_128BITS_UUID_TYPE:
+        uuid_len = Uuid::kNumBytes128;
+        break;
+
+      case BT_EIR_SHORTENED_LOCAL_NAME_TYPE:
+      case BT_EIR_COMPLETE_LOCAL_NAME_TYPE:
+        MatchData(name_conds_, payload, payload_len, &matched);
+        break;
+
+      case BT_EIR_MANUFACTURER_SPECIFIC_TYPE:
+        MatchData(manu_conds_, payload, payload_len, &matched);
+        break;
+
+      case BT_EIR_SERVICE_DATA_16BITS_UUID_TYPE:
+      case BT_EIR_SERVICE_DATA_32BITS_UUID_TYPE:
+      case BT_EIR_SERVICE_DATA_128BITS_UUID_TYPE:
+        for (uint8_t i : srvc_data_conds_) matched.set(i);
+        MatchData(srvc_data_pattern_conds_, payload, payload_len, &matched);
+        break;
+    }
+
+    for (size_t i = 0; uuid_len != 0 && i + uuid_len <= payload_len;
+         i += uuid_len) {
+      MatchUuid(table, payload + i, uuid_len, &matched);
+    }
+  }
+
+  for (const Filter& filter : filters_) {
+    if (!filter.applied || rssi < filter.rssi_high_thres) continue;
+    if (filter.feat_seln == 0) return true;
+
+    bool and_logic = filter.filt_logic_type == BTM_BLE_PF_LOGIC_AND;
+    bool result = and_logic;
+    for (size_t type = 0; type < BTM_BLE_PF_TYPE_ALL; type++) {
+      if (!(filter.feat_seln & (1 << type))) continue;
+
+      const ConditionSet& conditions = filter.conditions[type];
+      ConditionSet hits = matched & conditions;
+      bool feature = ((filter.list_logic_type >> type) & 0x01)
+                         ? conditions.any() && hits == conditions
+                         : hits.any();
+      result = and_logic ? (result && feature) : (result || feature);
+    }
+    if (result) return true;
+  }
+  return false;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <bitset>
+#include <utility>
+#include <vector>
+
+#include "bt_types.h"
+#include "btm_api_types.h"
+#include "btm_ble_api_types.h"
+#include "types/raw_address.h"
+
+/* Number of filter indexes handled by the host filter engine */
+#ifndef BTM_BLE_HOST_PF_MAX_FILTERS
+#define BTM_BLE_HOST_PF_MAX_FILTERS 16
+#endif
+
+/* Number of conditions handled by the host filter engine, all filters
+ * included */
+#ifndef BTM_BLE_HOST_PF_MAX_CONDITIONS
+#define BTM_BLE_HOST_PF_MAX_CONDITIONS 128
+#endif
+
+/* BleHostAdvFilter applies the advertising packet content filters
+ * (BTM_LE_PF_*) on the host, for controllers that do not support them.
+ *
+ * Conditions are compiled into mask-compare arrays, and unmasked 16 bit
+ * UUIDs into bitset indexed tables, so that a report is matched against all
+ * the filters by walking its advertising data once, without allocating.
+ * A filter selects features like the controller does: each selected feature
+ * matches if any (list logic OR) or all (list logic AND) of its conditions
+ * match, and the features are combined with the filter logic.
+ */
+class BleHostAdvFilter {
+ public:
+  BleHostAdvFilter();
+
+  /* Adds |cmd| to the conditions of |filt_index|. Returns false if the
+   * condition is malformed or no space is left. */
+  bool AddCondition(tBTM_BLE_PF_FILT_INDEX filt_index, const ApcfCommand& cmd);
+
+  /* Removes all the conditions of |filt_index| */
+  void ClearConditions(tBTM_BLE_PF_FILT_INDEX filt_index);
+
+  /* Selects the features of |filt_index| and how they are combined, the
+   * filter is applied from then on. Returns false if |filt_index| is out of
+   * range. */
+  bool SetParams(tBTM_BLE_PF_FILT_INDEX filt_index,
+                 const btgatt_filt_param_setup_t& params);
+
+  /* Stops applying |filt_index|, its conditions are kept */
+  void DeleteParams(tBTM_BLE_PF_FILT_INDEX filt_index);
+
+  /* Returns the number of conditions that can still be added */
+  size_t AvailableSpace() const {
+    return BTM_BLE_HOST_PF_MAX_CONDITIONS - conditions_.size();
+  }
+
+  /* Removes all the filters and their conditions, the engine stays enabled
+   * or disabled */
+  void Clear();
+
+  void Enable(bool enable) { enabled_ = enable; }
+
+  /* Returns true if reports have to go through Matches() */
+  bool IsActive() const { return enabled_ && num_applied_ != 0; }
+
+  /* Returns true if the report of |data| by |bda| received with |rssi|
+   * matches at least one of the applied filters. */
+  bool Matches(const RawAddress& bda, int8_t rssi, const uint8_t* data,
+               size_t data_len) const;
+
+ private:
+  using ConditionSet = std::bitset<BTM_BLE_HOST_PF_MAX_CONDITIONS>;
+
+  /* Pattern long enough for a company identifier followed by the longest
+   * data a condition can carry */
+  static constexpr size_t kMaxPatternLen = BTM_BLE_PF_STR_LEN_MAX + 2;
+
+  struct Condition {
+    tBTM_BLE_PF_FILT_INDEX filt_index;
+    tBTM_BLE_PF_COND_TYPE type;
+    RawAddress address;
+    /* |pattern| is pre-masked: a condition matches data d of at least |len|
+     * bytes (exactly |len| when |exact_len|) if (d[i] & mask[i]) ==
+     * pattern[i] for all i < len. UUIDs are compared in their 128 bit little
+     * endian form. */
+    bool exact_len;
+    uint8_t len;
+    uint8_t pattern[kMaxPatternLen];
+    uint8_t mask[kMaxPatternLen];
+  };
+
+  struct Filter {
+    bool applied;
+    uint16_t feat_seln;
+    uint16_t list_logic_type;
+    uint8_t filt_logic_type;
+    int8_t rssi_high_thres;
+    /* Conditions of this filter, per condition type */
+    ConditionSet conditions[BTM_BLE_PF_TYPE_MAX];
+  };
+
+  /* Rebuilds the per filter condition sets and the lookup tables from
+   * |conditions_| */
+  void Compile();
+
+  void MatchUuid(size_t table, const uint8_t* uuid, size_t uuid_len,
+                 ConditionSet* matched) const;
+  void MatchData(const std::vector<uint8_t>& conditions, const uint8_t* data,
+                 size_t data_len, ConditionSet* matched) const;
+
+  bool enabled_;
+  size_t num_applied_;
+  std::vector<Condition> conditions_;
+  std::array<Filter, BTM_BLE_HOST_PF_MAX_FILTERS> filters_;
+
+  /* Lookup tables built by Compile(), they hold indexes in |conditions_|.
+   * UUID tables are indexed by 0 for service UUIDs, 1 for solicitation.
+   * Masked UUIDs and UUIDs longer than 16 bit are in |uuid_conds_|. */
+  std::bitset<65536> uuid16_bits_[2];
+  std::vector<std::pair<uint16_t, uint8_t>> uuid16_conds_[2];
+  std::vector<uint8_t> uuid_conds_[2];
+  std::vector<uint8_t> addr_conds_;
+  std::vector<uint8_t> name_conds_;
+  std::vector<uint8_t> manu_conds_;
+  std::vector<uint8_t> srvc_data_conds_;
+  std::vector<uint8_t> srvc_data_pattern_conds_;
+};
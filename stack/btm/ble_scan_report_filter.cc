@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ble_scan_report_filter.h"
+
+namespace {
+/* Number of slots a report is looked up in */
+constexpr size_t kMaxProbe = 8;
+
+/* FNV-1a */
+uint32_t hash_bytes(uint32_t hash, const uint8_t* p, size_t len) {
+  while (len--) {
+    hash ^= *p++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+}  // namespace
+
+BleScanReportFilter::BleScanReportFilter(size_t capacity,
+                                         uint64_t min_interval_ms)
+    : min_interval_ms_(min_interval_ms) {
+  size_t size = kMaxProbe;
+  while (size < capacity) size <<= 1;
+  slots_.resize(size);
+  mask_ = size - 1;
+  Clear();
+}
+
+bool BleScanReportFilter::ShouldReport(const RawAddress& addr, uint8_t sid,
+                                       const std::vector<uint8_t>& data,
+                                       uint64_t now_ms) {
+  if (min_interval_ms_ == 0) return true;
+
+  uint32_t data_hash = hash_bytes(2166136261u, data.data(), data.size());
+  uint32_t hash = hash_bytes(data_hash, addr.address, RawAddress::kLength);
+  hash = hash_bytes(hash, &sid, sizeof(sid));
+
+  Slot* free_slot = nullptr;
+  Slot* oldest = nullptr;
+  for (size_t i = 0; i < kMaxProbe; i++) {
+    Slot& slot = slots_[(hash + i) & mask_];
+    bool expired =
+        !slot.in_use || now_ms - slot.last_report_ms >= min_interval_ms_;
+
+    if (slot.in_use && slot.data_hash == data_hash && slot.sid == sid &&
+        slot.addr == addr) {
+      if (!expired) return false;
+      slot.last_report_ms = now_ms;
+      return true;
+    }
+
+    if (expired && !free_slot) free_slot = &slot;
+    if (!oldest || slot.last_report_ms < oldest->last_report_ms)
+      oldest = &slot;
+  }
+
+  Slot* slot = free_slot ? free_slot : oldest;
+  slot->in_use = true;
+  slot->sid = sid;
+  slot->addr = addr;
+  slot->data_hash = data_hash;
+  slot->last_report_ms = now_ms;
+  return true;
+}
+
+void BleScanReportFilter::Clear() {
+  for (Slot& slot : slots_) slot.in_use = false;
+}
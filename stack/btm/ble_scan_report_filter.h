@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "types/raw_address.h"
+
+/* Default number of advertisers tracked by the scan report filter, it is
+ * rounded up to a power of two */
+#ifndef BTM_BLE_SCAN_REPORT_FILTER_SIZE
+#define BTM_BLE_SCAN_REPORT_FILTER_SIZE 1024
+#endif
+
+/* Default minimal interval between two identical reports of an advertiser */
+#ifndef BTM_BLE_SCAN_REPORT_MIN_INTERVAL_MS
+#define BTM_BLE_SCAN_REPORT_MIN_INTERVAL_MS 100
+#endif
+
+/* BleScanReportFilter drops advertising reports that repeat the previous
+ * report of the same advertiser, identified by its address, advertising SID
+ * and a hash of its data, until |min_interval_ms| has passed.
+ *
+ * Advertisers are kept in an open addressing table of fixed size, so that
+ * filtering a report does not allocate. A report is looked up in a bounded
+ * window of slots; when the window is full the least recently reported
+ * advertiser of the window is forgotten, which only lets its next report
+ * through.
+ */
+class BleScanReportFilter {
+ public:
+  BleScanReportFilter(size_t capacity, uint64_t min_interval_ms);
+
+  /* Returns true if the report of |data| by |addr, sid| received at |now_ms|
+   * has to be processed, false if it repeats a report let through less than
+   * |min_interval_ms| ago. */
+  bool ShouldReport(const RawAddress& addr, uint8_t sid,
+                    const std::vector<uint8_t>& data, uint64_t now_ms);
+
+  /* Forgets all the advertisers */
+  void Clear();
+
+ private:
+  struct Slot {
+    bool in_use;
+    uint8_t sid;
+    RawAddress addr;
+    uint32_t data_hash;
+    uint64_t last_report_ms;
+  };
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  uint64_t min_interval_ms_;
+};
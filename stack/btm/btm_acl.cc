@@ -234,6 +234,7 @@ void btm_acl_created(const RawAddress& bda, DEV_CLASS dc, BD_NAME bdn,
       p->switch_role_state = BTM_ACL_SWKEY_STATE_IDLE;
 
       btm_pm_sm_alloc(xx);
+      btm_lq_schedule();
 
       if (dc) memcpy(p->remote_dc, dc, DEV_CLASS_LEN);
 
@@ -964,6 +964,89 @@ void BTM_BleSetPhy(const RawAddress& bd_addr, uint8_t tx_phys, uint8_t rx_phys,
                             base::Bind(doNothing));
 }
 
+/* LE link policy: the links to peers supporting the Coded PHY move to the
+ * Coded PHY while the RSSI sampled by btm_link_quality.cc is below
+ * BTM_BLE_LINK_POLICY_CODED_RSSI, back to the fastest PHY above
+ * BTM_BLE_LINK_POLICY_UNCODED_RSSI. */
+#define BTM_BLE_LINK_POLICY_CODED_RSSI (-85)
+#define BTM_BLE_LINK_POLICY_UNCODED_RSSI (-75)
+
+/* PHY value of the LE Coded PHY in the LE PHY Update Complete event */
+#define BTM_BLE_PHY_UPDATE_CODED 0x03
+
+static bool btm_ble_link_policy_coded(const tACL_CONN* p_acl) {
+  return controller_get_interface()->supports_ble_coded_phy() &&
+         HCI_LE_CODED_PHY_SUPPORTED(p_acl->peer_le_features);
+}
+
+static bool btm_ble_link_policy_2m(const tACL_CONN* p_acl) {
+  return controller_get_interface()->supports_ble_2m_phy() &&
+         HCI_LE_2M_PHY_SUPPORTED(p_acl->peer_le_features);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_link_policy_rssi
+ *
+ * Description      This function is called with each RSSI sample of an LE
+ *                  link, and has the link change PHY when it crossed the
+ *                  thresholds of the LE link policy.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_link_policy_rssi(tACL_CONN* p_acl, int8_t rssi) {
+  if (!p_acl->le_link_policy || !btm_ble_link_policy_coded(p_acl)) return;
+
+  bool coded = (p_acl->le_tx_phy == BTM_BLE_PHY_UPDATE_CODED);
+  if (!coded && rssi < BTM_BLE_LINK_POLICY_CODED_RSSI) {
+    BTM_TRACE_DEBUG("%s: handle 0x%04x rssi %d, to the Coded PHY", __func__,
+                    p_acl->hci_handle, rssi);
+    BTM_BleSetPhy(p_acl->remote_addr, PHY_LE_CODED, PHY_LE_CODED, 0);
+  } else if (coded && rssi > BTM_BLE_LINK_POLICY_UNCODED_RSSI) {
+    uint8_t phy = btm_ble_link_policy_2m(p_acl) ? PHY_LE_2M : PHY_LE_1M;
+
+    BTM_TRACE_DEBUG("%s: handle 0x%04x rssi %d, to PHY 0x%02x", __func__,
+                    p_acl->hci_handle, rssi, phy);
+    BTM_BleSetPhy(p_acl->remote_addr, phy, phy, 0);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_link_policy_start
+ *
+ * Description      This function is called once the LE features of the peer
+ *                  of an LE link are known. When the LE link policy is
+ *                  enabled, it asks for the maximum data length and for the
+ *                  2M PHY if both sides support them, and has the link moved
+ *                  to the Coded PHY while its RSSI is poor if both sides
+ *                  support it. L2CAP then keeps the maximum data length
+ *                  instead of fitting it to the ATT MTU.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_link_policy_start(tACL_CONN* p_acl) {
+  if (!btm_cb.ble_ctr_cb.link_policy_enabled ||
+      p_acl->transport != BT_TRANSPORT_LE)
+    return;
+
+  if (controller_get_interface()->supports_ble_packet_extension() &&
+      HCI_LE_DATA_LEN_EXT_SUPPORTED(p_acl->peer_le_features)) {
+    p_acl->le_link_policy = true;
+    BTM_SetBleDataLength(p_acl->remote_addr, BTM_BLE_DATA_SIZE_MAX);
+  }
+
+  if (btm_ble_link_policy_2m(p_acl)) {
+    p_acl->le_link_policy = true;
+    BTM_BleSetPhy(p_acl->remote_addr, PHY_LE_2M, PHY_LE_2M, 0);
+  }
+
+  /* The RSSI of the link is sampled as long as it is up */
+  if (btm_ble_link_policy_coded(p_acl)) p_acl->le_link_policy = true;
+}
+
 /*******************************************************************************
  *
  * Function         btm_ble_determine_security_act
@@ -1318,6 +1401,7 @@ void btm_sec_save_le_key(const RawAddress& bd_addr, tBTM_LE_KEY_TYPE key_type,
         p_rec->bd_addr = p_keys->pid_key.identity_addr;
         /* combine DUMO device security record if needed */
         btm_consolidate_dev(p_rec);
+        btm_ble_clear_resolved_random_addr_cache();
         break;
 
       case BTM_LE_KEY_PCSRK:
@@ -33,8 +33,31 @@
 #include "hcimsgs.h"
 
 #include "btm_ble_int.h"
+#include "common/lru.h"
+#include "common/time_util.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 
+namespace {
+
+/* Outcome of the resolution of a random address. |p_dev_rec| is nullptr when
+ * no bonded device IRK matched. */
+struct RpaCacheEntry {
+  tBTM_SEC_DEV_REC* p_dev_rec;
+  uint64_t resolved_ms;
+};
+
+/* Advertising reports from the same RPA are not resolved again against the
+ * IRK of every bonded device. Entries expire after the default RPA timeout,
+ * negative entries are cleared when a new IRK is saved, and positive entries
+ * are checked against the device record before use. */
+constexpr size_t kRpaCacheCapacity = 256;
+constexpr uint64_t kRpaCacheTtlMs = 15 * 60 * 1000;
+
+bluetooth::common::LruCache<RawAddress, RpaCacheEntry> rpa_cache(
+    kRpaCacheCapacity, "rpa_cache");
+
+}  // namespace
+
 /* This function generates Resolvable Private Address (RPA) from Identity
  * Resolving Key |irk| and |random|*/
 RawAddress generate_rpa_from_irk_and_rand(const Octet16& irk,
@@ -201,6 +224,20 @@ static bool btm_ble_match_random_bda(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
   BTM_TRACE_EVENT("%s", __func__);
 
+  uint64_t current_ms = bluetooth::common::time_get_os_boottime_ms();
+  RpaCacheEntry entry;
+  if (rpa_cache.Get(random_bda, &entry) &&
+      current_ms - entry.resolved_ms < kRpaCacheTtlMs) {
+    if (entry.p_dev_rec == nullptr) return nullptr;
+    if (list_contains(btm_cb.sec_dev_rec, entry.p_dev_rec) &&
+        !btm_ble_match_random_bda(entry.p_dev_rec, (void*)&random_bda)) {
+#if (BLE_PRIVACY_SPT == TRUE)
+      btm_ble_resolving_list_note_activity(entry.p_dev_rec, false);
+#endif
+      return entry.p_dev_rec;
+    }
+  }
+
   /* start to resolve random address */
   /* check for next security record */
 
@@ -208,35 +245,65 @@ tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
                                 (void*)&random_bda);
   tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
   if (n != nullptr) p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  rpa_cache.Put(random_bda, {p_dev_rec, current_ms});
+#if (BLE_PRIVACY_SPT == TRUE)
+  if (p_dev_rec != nullptr)
+    btm_ble_resolving_list_note_activity(p_dev_rec, false);
+#endif
 
   BTM_TRACE_EVENT("%s:  %sresolved", __func__,
                   (p_dev_rec == nullptr ? "not " : ""));
   return p_dev_rec;
 }
 
+/** This function is called when the IRK of a device is saved, so that random
+ * addresses which did not resolve before are resolved again.
+ */
+void btm_ble_clear_resolved_random_addr_cache(void) { rpa_cache.Clear(); }
+
 /*******************************************************************************
  *  address mapping between pseudo address and real connection address
  ******************************************************************************/
-/** Find the security record whose LE identity address is matching */
+/** Find the security record whose LE identity address is matching. The
+ * records found are indexed by identity address, the index being checked
+ * against the record as its identity address is learnt or replaced later. */
 tBTM_SEC_DEV_REC* btm_find_dev_by_identity_addr(const RawAddress& bd_addr,
                                                 uint8_t addr_type) {
 #if (BLE_PRIVACY_SPT == TRUE)
-  list_node_t* end = list_end(btm_cb.sec_dev_rec);
-  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
-       node = list_next(node)) {
-    tBTM_SEC_DEV_REC* p_dev_rec =
-        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
-    if (p_dev_rec->ble.identity_addr == bd_addr) {
-      if ((p_dev_rec->ble.identity_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
-          (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
-        BTM_TRACE_WARNING(
-            "%s find pseudo->random match with diff addr type: %d vs %d",
-            __func__, p_dev_rec->ble.identity_addr_type, addr_type);
-
-      /* found the match */
-      return p_dev_rec;
+  tBTM_SEC_DEV_REC* p_dev_rec = NULL;
+  tBTM_SEC_DEV_REC** pp_indexed_rec =
+      btm_cb.sec_dev_identity_index->Find(bd_addr);
+  if (pp_indexed_rec != NULL) {
+    if ((*pp_indexed_rec)->ble.identity_addr == bd_addr)
+      p_dev_rec = *pp_indexed_rec;
+    else
+      btm_cb.sec_dev_identity_index->Erase(bd_addr);
+  }
+
+  if (p_dev_rec == NULL) {
+    list_node_t* end = list_end(btm_cb.sec_dev_rec);
+    for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
+         node = list_next(node)) {
+      tBTM_SEC_DEV_REC* p_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+      if (p_rec->ble.identity_addr == bd_addr) {
+        p_dev_rec = p_rec;
+        break;
+      }
     }
+    if (p_dev_rec == NULL) return NULL;
+    /* the records whose identity is unknown share the empty address */
+    if (!bd_addr.IsEmpty())
+      btm_cb.sec_dev_identity_index->Put(bd_addr, p_dev_rec);
   }
+
+  if ((p_dev_rec->ble.identity_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
+      (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
+    BTM_TRACE_WARNING(
+        "%s find pseudo->random match with diff addr type: %d vs %d",
+        __func__, p_dev_rec->ble.identity_addr_type, addr_type);
+
+  /* found the match */
+  return btm_dev_rec_touch(p_dev_rec);
 #endif
 
   return NULL;
@@ -259,6 +326,10 @@ bool btm_identity_addr_to_random_pseudo(RawAddress* bd_addr,
   BTM_TRACE_EVENT("%s", __func__);
   /* evt reported on static address, map static address to random pseudo */
   if (p_dev_rec != NULL) {
+    /* identity address types are reported for RPAs resolved by controller */
+    if (*p_addr_type & BLE_ADDR_TYPE_ID_BIT)
+      btm_ble_resolving_list_note_activity(p_dev_rec, true);
+
     /* if RPA offloading is supported, or 4.2 controller, do RPA refresh */
     if (refresh &&
         controller_get_interface()->get_ble_resolving_list_max_size() != 0)
@@ -20,6 +20,7 @@
 
 #include "bt_target.h"
 
+#include "ble_host_adv_filter.h"
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "btm_ble_api.h"
@@ -58,6 +59,9 @@ using bluetooth::Uuid;
 tBTM_BLE_ADV_FILTER_CB btm_ble_adv_filt_cb;
 tBTM_BLE_VSC_CB cmn_ble_vsc_cb;
 
+/* Filters applied on the host when the controller does not support them */
+static BleHostAdvFilter host_adv_filter;
+
 static uint8_t btm_ble_cs_update_pf_counter(tBTM_BLE_SCAN_COND_OP action,
                                             uint8_t cond_type,
                                             tBLE_BD_ADDR* p_bd_addr,
@@ -599,10 +603,7 @@ void BTM_LE_PF_uuid_filter(tBTM_BLE_SCAN_COND_OP action,
 void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
                    std::vector<ApcfCommand> commands,
                    tBTM_BLE_PF_CFG_CBACK cb) {
-  if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
-    return;
-  }
+  bool host_filtering = !is_filtering_supported();
 
   int action = BTM_BLE_SCAN_COND_ADD;
   for (const ApcfCommand& cmd : commands) {
@@ -614,6 +615,14 @@ void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
       continue;
     }
 
+    if (host_filtering) {
+      if (!host_adv_filter.AddCondition(filt_index, cmd)) {
+        LOG(ERROR) << __func__ << ": can't add host filter condition, type: "
+                   << +cmd.type;
+      }
+      continue;
+    }
+
     switch (cmd.type) {
       case BTM_BLE_PF_ADDR_FILTER: {
         tBLE_BD_ADDR target_addr;
@@ -668,7 +677,10 @@ void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
 void BTM_LE_PF_clear(tBTM_BLE_PF_FILT_INDEX filt_index,
                      tBTM_BLE_PF_CFG_CBACK cb) {
   if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    host_adv_filter.ClearConditions(filt_index);
+    host_adv_filter.DeleteParams(filt_index);
+    cb.Run(host_adv_filter.AvailableSpace(), BTM_BLE_SCAN_COND_CLEAR,
+           HCI_SUCCESS);
     return;
   }
 
@@ -745,7 +757,16 @@ void BTM_BleAdvFilterParamSetup(
   uint8_t param[len], *p;
 
   if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    bool success = true;
+    if (BTM_BLE_SCAN_COND_ADD == action) {
+      success = host_adv_filter.SetParams(filt_index, *p_filt_params);
+    } else if (BTM_BLE_SCAN_COND_DELETE == action) {
+      host_adv_filter.DeleteParams(filt_index);
+    } else if (BTM_BLE_SCAN_COND_CLEAR == action) {
+      host_adv_filter.Clear();
+    }
+    cb.Run(host_adv_filter.AvailableSpace(), action,
+           success ? HCI_SUCCESS : 1 /* BTA_FAILURE */);
     return;
   }
 
@@ -863,7 +884,8 @@ void enable_cmpl_cback(tBTM_BLE_PF_STATUS_CBACK p_stat_cback, uint8_t* p,
 void BTM_BleEnableDisableFilterFeature(uint8_t enable,
                                        tBTM_BLE_PF_STATUS_CBACK p_stat_cback) {
   if (!is_filtering_supported()) {
-    if (p_stat_cback) p_stat_cback.Run(BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    host_adv_filter.Enable(enable != 0);
+    if (p_stat_cback) p_stat_cback.Run(enable, BTM_SUCCESS);
     return;
   }
 
@@ -879,6 +901,26 @@ void BTM_BleEnableDisableFilterFeature(uint8_t enable,
                             base::Bind(&enable_cmpl_cback, p_stat_cback));
 }
 
+/*******************************************************************************
+ *
+ * Function         BTM_BleMaxAdvFilters
+ *
+ * Description      Get the number of adv data payload filters that can be
+ *                  set up, by the controller or, when the controller does not
+ *                  support APCF, by the host
+ *
+ * Returns          number of filter indexes
+ *
+ ******************************************************************************/
+uint8_t BTM_BleMaxAdvFilters(void) {
+  tBTM_BLE_VSC_CB vsc_cb;
+  BTM_BleGetVendorCapabilities(&vsc_cb);
+
+  if (vsc_cb.filter_support != 0 && vsc_cb.max_filter != 0)
+    return vsc_cb.max_filter;
+  return BTM_BLE_HOST_PF_MAX_FILTERS;
+}
+
 /*******************************************************************************
  *
  * Function         btm_ble_adv_filter_init
@@ -895,6 +937,9 @@ void btm_ble_adv_filter_init(void) {
 
   BTM_BleGetVendorCapabilities(&cmn_ble_vsc_cb);
 
+  host_adv_filter.Enable(false);
+  host_adv_filter.Clear();
+
   if (!is_filtering_supported()) return;
 
   if (cmn_ble_vsc_cb.max_filter > 0) {
@@ -916,4 +961,22 @@ void btm_ble_adv_filter_init(void) {
  ******************************************************************************/
 void btm_ble_adv_filter_cleanup(void) {
   osi_free_and_reset((void**)&btm_ble_adv_filt_cb.p_addr_filter_count);
+  host_adv_filter.Clear();
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_adv_filter_match
+ *
+ * Description      This function applies the host filters to an advertising
+ *                  report, when the controller does not filter reports itself
+ *
+ * Returns          true if the report has to be processed
+ *
+ ******************************************************************************/
+bool btm_ble_adv_filter_match(const RawAddress& bda, int8_t rssi,
+                              const std::vector<uint8_t>& data) {
+  if (!host_adv_filter.IsActive()) return true;
+
+  return host_adv_filter.Matches(bda, rssi, data.data(), data.size());
 }
@@ -245,10 +245,10 @@ void btm_ble_read_batchscan_reports(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
   btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_BLE_BATCH_SCAN, param, len, cb);
 }
 
-/* read reports. data is accumulated in |data_all|, number of records is
- * accumulated in |num_records_all| */
-void read_reports_cb(std::vector<uint8_t> data_all, uint8_t num_records_all,
-                     tBTM_BLE_SCAN_REP_CBACK cb, uint8_t* p, uint16_t len) {
+/* read reports. Records are delivered to |cb| as each event of the controller
+ * arrives, so that a large controller storage is never held in memory at
+ * once. The read ends with a call without records, that has |more| false. */
+void read_reports_cb(tBTM_BLE_SCAN_REP_CBACK cb, uint8_t* p, uint16_t len) {
   if (len < 2) {
     BTM_TRACE_ERROR("%s: wrong length", __func__);
     return;
@@ -273,18 +273,17 @@ void read_reports_cb(std::vector<uint8_t> data_all, uint8_t num_records_all,
                   num_records);
 
   if (num_records == 0) {
-    cb.Run(status, report_format, num_records_all, data_all);
+    cb.Run(status, report_format, 0, {}, false);
     return;
   }
 
   if (len > 4) {
-    data_all.insert(data_all.end(), p, p + len - 4);
-    num_records_all += num_records;
+    cb.Run(status, report_format, num_records,
+           std::vector<uint8_t>(p, p + len - 4), true);
 
     /* More records could be in the buffer and needs to be pulled out */
-    btm_ble_read_batchscan_reports(
-        report_format, base::Bind(&read_reports_cb, std::move(data_all),
-                                  num_records_all, std::move(cb)));
+    btm_ble_read_batchscan_reports(report_format,
+                                   base::Bind(&read_reports_cb, cb));
   }
 }
 
@@ -507,7 +506,7 @@ void BTM_BleReadScanReports(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
   }
 
   btm_ble_read_batchscan_reports(
-      scan_mode, base::Bind(&read_reports_cb, std::vector<uint8_t>(), 0, cb));
+      scan_mode, base::Bind(&read_reports_cb, cb));
   return;
 }
 
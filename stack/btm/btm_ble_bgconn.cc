@@ -74,12 +74,10 @@ static void background_connection_add(uint8_t addr_type,
   } else {
     BackgroundConnection* connection = &map_iter->second;
     if (addr_type != connection->addr_type) {
+      // The stale entry is replaced on the next white list update, the
+      // controller list can't be changed while connection is initiated.
       LOG(INFO) << __func__ << " Addr type mismatch " << address;
-      btsnd_hcic_ble_remove_from_white_list(
-        connection->addr_type_in_wl, connection->address,
-        base::Bind(&wl_remove_complete));
       connection->addr_type = addr_type;
-      connection->in_controller_wl = false;
     }
     connection->pending_removal = false;
   }
@@ -111,6 +109,24 @@ static bool background_connections_pending() {
   return false;
 }
 
+/** Returns true if the controller white list differs from what background
+ * connection needs right now */
+static bool background_connections_changed() {
+  for (auto& map_el : background_connections) {
+    BackgroundConnection* connection = &map_el.second;
+    if (connection->pending_removal) return true;
+    const bool connected =
+        BTM_IsAclConnectionUp(connection->address, BT_TRANSPORT_LE);
+    if (connection->in_controller_wl) {
+      if (connected || connection->addr_type_in_wl != connection->addr_type)
+        return true;
+    } else if (!connected) {
+      return true;
+    }
+  }
+  return false;
+}
+
 static int background_connections_count() {
   int count = 0;
   for (auto& map_el : background_connections) {
@@ -281,6 +297,13 @@ bool btm_execute_wl_dev_operation(void) {
     BackgroundConnection* connection = &map_el.second;
     const bool connected =
         BTM_IsAclConnectionUp(connection->address, BT_TRANSPORT_LE);
+    if (connection->in_controller_wl &&
+        connection->addr_type_in_wl != connection->addr_type) {
+      btsnd_hcic_ble_remove_from_white_list(
+          connection->addr_type_in_wl, connection->address,
+          base::BindOnce(&wl_remove_complete));
+      connection->in_controller_wl = false;
+    }
     if (!connection->in_controller_wl && !connected) {
       btsnd_hcic_ble_add_white_list(connection->addr_type, connection->address,
                                     base::BindOnce(&wl_add_complete));
@@ -300,6 +323,9 @@ bool btm_execute_wl_dev_operation(void) {
   return true;
 }
 
+// Whether a white list update is posted to the main thread already
+static bool wl_update_scheduled = false;
+
 /*******************************************************************************
  *
  * Function         btm_ble_white_list_init
@@ -309,6 +335,7 @@ bool btm_execute_wl_dev_operation(void) {
  ******************************************************************************/
 void btm_ble_white_list_init(uint8_t white_list_size) {
   BTM_TRACE_DEBUG("%s white_list_size = %d", __func__, white_list_size);
+  wl_update_scheduled = false;
 }
 
 uint8_t BTM_GetWhiteListSize() {
@@ -451,6 +478,34 @@ bool btm_ble_suspend_bg_conn(void) {
  ******************************************************************************/
 bool btm_ble_resume_bg_conn(void) { return btm_ble_start_auto_conn(); }
 
+/** Brings the controller white list in line with the background connection
+ * list, restarting background connection at most once */
+static void btm_ble_update_white_list() {
+  wl_update_scheduled = false;
+  bool started = btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT;
+  /* Background connection is still started when nothing changed, so that
+   * the devices already in the white list get connected */
+  if (!background_connections_changed() && started) return;
+
+  if (started) {
+    btm_ble_stop_auto_conn();
+  }
+  btm_ble_resume_bg_conn();
+}
+
+/** White list changes made while handling the current batch of main thread
+ * events are applied together once it is handled, so that many apps
+ * registering background connections cost a single restart */
+static void btm_ble_schedule_white_list_update() {
+  if (wl_update_scheduled) return;
+  if (do_in_main_thread(FROM_HERE, base::Bind(&btm_ble_update_white_list)) ==
+      BT_STATUS_SUCCESS) {
+    wl_update_scheduled = true;
+  } else {
+    btm_ble_update_white_list();
+  }
+}
+
 /** Adds the device into white list. Returns false if white list is full and
  * device can't be added, true otherwise. */
 bool BTM_WhiteListAdd(const RawAddress& address) {
@@ -462,22 +517,16 @@ bool BTM_WhiteListAdd(const RawAddress& address) {
     return false;
   }
 
-  if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT) {
-    btm_ble_stop_auto_conn();
-  }
   btm_add_dev_to_controller(true, address);
-  btm_ble_resume_bg_conn();
+  btm_ble_schedule_white_list_update();
   return true;
 }
 
 /** Removes the device from white list */
 void BTM_WhiteListRemove(const RawAddress& address) {
   VLOG(1) << __func__ << ": " << address;
-  if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT) {
-    btm_ble_stop_auto_conn();
-  }
   btm_add_dev_to_controller(false, address);
-  btm_ble_resume_bg_conn();
+  btm_ble_schedule_white_list_update();
 }
 
 /** clear white list complete */
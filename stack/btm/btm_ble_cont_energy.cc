@@ -29,6 +29,37 @@
 
 tBTM_BLE_ENERGY_INFO_CB ble_energy_info_cb;
 
+/* Parses the energy info VSC complete parameters into the totals of the
+ * controller, and has them sampled. Returns false on a malformed event. */
+static bool btm_ble_parse_energy_info(tBTM_VSC_CMPL* p_params, uint8_t* status,
+                                      uint32_t* total_tx_time,
+                                      uint32_t* total_rx_time,
+                                      uint32_t* total_idle_time,
+                                      uint32_t* total_energy_used) {
+  uint8_t* p = p_params->p_param_buf;
+
+  if (p_params->param_len < 17) {
+    BTM_TRACE_ERROR("wrong length for btm_ble_cont_energy_cmpl_cback");
+    return false;
+  }
+
+  STREAM_TO_UINT8(*status, p);
+  STREAM_TO_UINT32(*total_tx_time, p);
+  STREAM_TO_UINT32(*total_rx_time, p);
+  STREAM_TO_UINT32(*total_idle_time, p);
+  STREAM_TO_UINT32(*total_energy_used, p);
+
+  BTM_TRACE_DEBUG(
+      "energy_info status=%d,tx_t=%ld, rx_t=%ld, ener_used=%ld, idle_t=%ld",
+      *status, *total_tx_time, *total_rx_time, *total_energy_used,
+      *total_idle_time);
+
+  if (*status == HCI_SUCCESS)
+    btm_lq_energy_sample(*total_tx_time, *total_rx_time, *total_idle_time,
+                         *total_energy_used);
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         btm_ble_cont_energy_cmpl_cback
@@ -41,26 +72,14 @@ tBTM_BLE_ENERGY_INFO_CB ble_energy_info_cb;
  *
  ******************************************************************************/
 void btm_ble_cont_energy_cmpl_cback(tBTM_VSC_CMPL* p_params) {
-  uint8_t* p = p_params->p_param_buf;
-  uint16_t len = p_params->param_len;
   uint8_t status = 0;
   uint32_t total_tx_time = 0, total_rx_time = 0, total_idle_time = 0,
            total_energy_used = 0;
 
-  if (len < 17) {
-    BTM_TRACE_ERROR("wrong length for btm_ble_cont_energy_cmpl_cback");
+  if (!btm_ble_parse_energy_info(p_params, &status, &total_tx_time,
+                                 &total_rx_time, &total_idle_time,
+                                 &total_energy_used))
     return;
-  }
-
-  STREAM_TO_UINT8(status, p);
-  STREAM_TO_UINT32(total_tx_time, p);
-  STREAM_TO_UINT32(total_rx_time, p);
-  STREAM_TO_UINT32(total_idle_time, p);
-  STREAM_TO_UINT32(total_energy_used, p);
-
-  BTM_TRACE_DEBUG(
-      "energy_info status=%d,tx_t=%ld, rx_t=%ld, ener_used=%ld, idle_t=%ld",
-      status, total_tx_time, total_rx_time, total_energy_used, total_idle_time);
 
   if (NULL != ble_energy_info_cb.p_ener_cback)
     ble_energy_info_cb.p_ener_cback(total_tx_time, total_rx_time,
@@ -69,6 +88,38 @@ void btm_ble_cont_energy_cmpl_cback(tBTM_VSC_CMPL* p_params) {
   return;
 }
 
+/* Energy info read by the link quality sampling, not reported to the
+ * framework */
+static void btm_ble_energy_sample_cmpl_cback(tBTM_VSC_CMPL* p_params) {
+  uint8_t status = 0;
+  uint32_t total_tx_time = 0, total_rx_time = 0, total_idle_time = 0,
+           total_energy_used = 0;
+
+  btm_ble_parse_energy_info(p_params, &status, &total_tx_time, &total_rx_time,
+                            &total_idle_time, &total_energy_used);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_sample_energy_info
+ *
+ * Description      This function reads the energy info of the controller for
+ *                  the link quality sampling.
+ *
+ * Returns          true if the controller supports it and it was read
+ *
+ ******************************************************************************/
+bool btm_ble_sample_energy_info(void) {
+  tBTM_BLE_VSC_CB cmn_ble_vsc_cb;
+
+  BTM_BleGetVendorCapabilities(&cmn_ble_vsc_cb);
+  if (0 == cmn_ble_vsc_cb.energy_support) return false;
+
+  BTM_VendorSpecificCommand(HCI_BLE_ENERGY_INFO, 0, NULL,
+                            btm_ble_energy_sample_cmpl_cback);
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         BTM_BleGetEnergyInfo
@@ -30,7 +30,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
-#include <list>
+#include <array>
 #include <vector>
 
 #include "bt_types.h"
@@ -42,8 +42,10 @@
 #include "gap_api.h"
 #include "hcimsgs.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 
 #include "advertise_data_parser.h"
+#include "ble_scan_report_filter.h"
 #include "btm_ble_int.h"
 #include "gatt_int.h"
 #include "gattdefs.h"
@@ -61,6 +63,7 @@
 #define BTM_BLE_POLICY_UNKNOWN 0xff
 
 #define BTM_EXT_BLE_RMT_NAME_TIMEOUT_MS (30 * 1000)
+#define BTM_BLE_LINK_POLICY_PROPERTY "persist.bluetooth.le.link_policy"
 #define MIN_ADV_LENGTH 2
 #define BTM_VSC_CHIP_CAPABILITY_RSP_LEN 9
 #define BTM_VSC_CHIP_CAPABILITY_RSP_LEN_L_RELEASE \
@@ -71,88 +74,131 @@ namespace {
 
 class AdvertisingCache {
  public:
-  /* Set the data to |data| for device |addr_type, addr| */
+  /* Set the data to the |len| bytes at |data| for device |addr_type, addr|
+   * and advertising set |sid| */
   const std::vector<uint8_t>& Set(uint8_t addr_type, const RawAddress& addr,
-                                  std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data = std::move(data);
-      return it->data;
+                                  uint8_t sid, const uint8_t* data,
+                                  uint8_t len, bool remove_trailing_zeros,
+                                  uint64_t now_ms) {
+    Slot& slot = Get(addr_type, addr, sid, now_ms);
+    slot.data.clear();
+    Add(slot, data, len, remove_trailing_zeros);
+    return slot.data;
+  }
+
+  bool Exist(uint8_t addr_type, const RawAddress& addr, uint8_t sid) {
+    return Find(addr_type, addr, sid) != nullptr;
+  }
+
+  /* Append the |len| bytes at |data| for device |addr_type, addr| and
+   * advertising set |sid|. Returns nullptr, dropping the data, when it gets
+   * longer than advertising data can be */
+  const std::vector<uint8_t>* Append(uint8_t addr_type, const RawAddress& addr,
+                                     uint8_t sid, const uint8_t* data,
+                                     uint8_t len, bool remove_trailing_zeros,
+                                     uint64_t now_ms) {
+    Slot& slot = Get(addr_type, addr, sid, now_ms);
+    if (slot.data.size() + len > kMaxDataLen) {
+      Release(slot);
+      return nullptr;
     }
 
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
-  }
-
-  bool Exist(uint8_t addr_type, const RawAddress& addr) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-        return true;
-    }
-    return false;
-  }
-
-  /* Append |data| for device |addr_type, addr| */
-  const std::vector<uint8_t>& Append(uint8_t addr_type, const RawAddress& addr,
-                                     std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data.insert(it->data.end(), data.begin(), data.end());
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
+    Add(slot, data, len, remove_trailing_zeros);
+    return &slot.data;
   }
 
-  /* Clear data for device |addr_type, addr| */
-  void Clear(uint8_t addr_type, const RawAddress& addr) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      items.erase(it);
-    }
+  /* Clear data for device |addr_type, addr| and advertising set |sid| */
+  void Clear(uint8_t addr_type, const RawAddress& addr, uint8_t sid) {
+    Slot* slot = Find(addr_type, addr, sid);
+    if (slot != nullptr) Release(*slot);
   }
 
   void ClearAll() {
-    items.clear();
+    for (Slot& slot : slots) Release(slot);
   }
 
  private:
-  struct Item {
+  /* Maximum length of the extended advertising data */
+  static constexpr size_t kMaxDataLen = 1650;
+  /* Fragments older than this are not continued, but started over */
+  static constexpr uint64_t kStaleMs = 1000;
+
+  /* The buffers keep their capacity from one device to the next */
+  struct Slot {
+    bool in_use = false;
     uint8_t addr_type;
     RawAddress addr;
+    uint8_t sid;
+    uint64_t last_ms;
     std::vector<uint8_t> data;
-
-    Item(uint8_t addr_type, const RawAddress& addr, std::vector<uint8_t> data)
-        : addr_type(addr_type), addr(addr), data(data) {}
   };
 
-  std::list<Item>::iterator Find(uint8_t addr_type, const RawAddress& addr) {
-    for (auto it = items.begin(); it != items.end(); it++) {
-      if (it->addr_type == addr_type && it->addr == addr) {
-        return it;
+  Slot* Find(uint8_t addr_type, const RawAddress& addr, uint8_t sid) {
+    for (Slot& slot : slots) {
+      if (slot.in_use && slot.addr_type == addr_type && slot.addr == addr &&
+          slot.sid == sid) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  /* Find the slot of the device, or take a free one, or the least recently
+   * used one */
+  Slot& Get(uint8_t addr_type, const RawAddress& addr, uint8_t sid,
+            uint64_t now_ms) {
+    Slot* slot = Find(addr_type, addr, sid);
+    if (slot != nullptr) {
+      if (now_ms - slot->last_ms > kStaleMs) slot->data.clear();
+      slot->last_ms = now_ms;
+      return *slot;
+    }
+
+    slot = &slots[0];
+    for (Slot& it : slots) {
+      if (!it.in_use) {
+        slot = &it;
+        break;
       }
+      if (it.last_ms < slot->last_ms) slot = &it;
     }
-    return items.end();
+
+    if (slot->data.capacity() == 0) slot->data.reserve(kMaxDataLen);
+    slot->data.clear();
+    slot->in_use = true;
+    slot->addr_type = addr_type;
+    slot->addr = addr;
+    slot->sid = sid;
+    slot->last_ms = now_ms;
+    return *slot;
   }
 
-  /* we keep maximum 7 devices in the cache */
-  const size_t cache_max = 7;
-  std::list<Item> items;
+  void Add(Slot& slot, const uint8_t* data, uint8_t len,
+           bool remove_trailing_zeros) {
+    size_t position = slot.data.size();
+    slot.data.insert(slot.data.end(), data, data + len);
+    if (remove_trailing_zeros)
+      AdvertiseDataParser::RemoveTrailingZeros(slot.data, position);
+  }
+
+  void Release(Slot& slot) {
+    slot.in_use = false;
+    slot.data.clear();
+  }
+
+  /* we keep maximum 8 devices in the cache */
+  std::array<Slot, 8> slots;
 };
 
 /* Devices in this cache are waiting for eiter scan response, or chained packets
  * on secondary channel */
 AdvertisingCache cache;
 
+/* Drops the reports repeating the previous one of an advertiser, in dense
+ * environments most reports are */
+BleScanReportFilter report_filter(BTM_BLE_SCAN_REPORT_FILTER_SIZE,
+                                  BTM_BLE_SCAN_REPORT_MIN_INTERVAL_MS);
+
 }  // namespace
 
 #if (BLE_VND_INCLUDED == TRUE)
@@ -415,6 +461,7 @@ tBTM_STATUS BTM_BleObserve(bool start, uint8_t duration,
     if (!BTM_BLE_IS_SCAN_ACTIVE(btm_cb.ble_ctr_cb.scan_activity)) {
       /* allow config of scan type */
       cache.ClearAll();
+      report_filter.Clear();
       p_inq->scan_type = (p_inq->scan_type == BTM_BLE_SCAN_MODE_NONE)
                              ? BTM_BLE_SCAN_MODE_ACTI
                              : p_inq->scan_type;
@@ -1191,6 +1238,7 @@ tBTM_STATUS btm_ble_start_inquiry(uint8_t mode, uint8_t duration) {
 
   if (!BTM_BLE_IS_SCAN_ACTIVE(p_ble_cb->scan_activity)) {
     cache.ClearAll();
+    report_filter.Clear();
     btm_send_hci_set_scan_params(
         BTM_BLE_SCAN_MODE_ACTI, BTM_BLE_LOW_LATENCY_SCAN_INT,
         BTM_BLE_LOW_LATENCY_SCAN_WIN,
@@ -1649,6 +1697,7 @@ void btm_clear_all_pending_le_entry(void) {
         !p_ent->scan_rsp)
       p_ent->in_use = false;
   }
+  btm_inq_db_rebuild_index();
 }
 
 void btm_ble_process_adv_addr(RawAddress& bda, uint8_t* addr_type) {
@@ -1831,9 +1880,7 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
                                   uint8_t data_len, uint8_t* data) {
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
   bool update = true;
-
-  std::vector<uint8_t> tmp;
-  if (data_len != 0) tmp.insert(tmp.begin(), data, data + data_len);
+  uint64_t now_ms = bluetooth::common::time_get_os_boottime_ms();
 
   bool is_scannable = ble_evt_type_is_scannable(evt_type);
   bool is_scan_resp = ble_evt_type_is_scan_resp(evt_type);
@@ -1844,20 +1891,25 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
   // has no ad flag, the device will be set to DUMO mode. The createbond
   // procedure will use the wrong device mode.
   // In such case no necessary to report scan response
-  if(is_legacy && is_scan_resp && !cache.Exist(addr_type, bda))
+  if (is_legacy && is_scan_resp &&
+      !cache.Exist(addr_type, bda, advertising_sid))
     return;
 
   bool is_start = is_legacy && is_scannable && !is_scan_resp;
 
-  if (is_legacy)
-    AdvertiseDataParser::RemoveTrailingZeros(tmp);
-
   // We might have send scan request to this device before, but didn't get the
   // response. In such case make sure data is put at start, not appended to
   // already existing data.
-  std::vector<uint8_t> const& adv_data =
-      is_start ? cache.Set(addr_type, bda, std::move(tmp))
-               : cache.Append(addr_type, bda, std::move(tmp));
+  std::vector<uint8_t> const* p_adv_data =
+      is_start ? &cache.Set(addr_type, bda, advertising_sid, data, data_len,
+                            is_legacy, now_ms)
+               : cache.Append(addr_type, bda, advertising_sid, data, data_len,
+                              is_legacy, now_ms);
+  if (p_adv_data == nullptr) {
+    DVLOG(1) << __func__ << "Dropping too long advertising data " << bda;
+    return;
+  }
+  std::vector<uint8_t> const& adv_data = *p_adv_data;
 
   bool data_complete = (ble_evt_type_data_status(evt_type) != 0x01);
 
@@ -1881,6 +1933,16 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
     return;
   }
 
+  if (!btm_ble_adv_filter_match(bda, rssi, adv_data)) {
+    cache.Clear(addr_type, bda, advertising_sid);
+    return;
+  }
+
+  if (!report_filter.ShouldReport(bda, advertising_sid, adv_data, now_ms)) {
+    cache.Clear(addr_type, bda, advertising_sid);
+    return;
+  }
+
   tINQ_DB_ENT* p_i = btm_inq_db_find(bda);
 
   /* Check if this address has already been processed for this inquiry */
@@ -1894,7 +1956,7 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
       update = false;
     } else {
       /* if yes, skip it */
-      cache.Clear(addr_type, bda);
+      cache.Clear(addr_type, bda, advertising_sid);
       return; /* assumption: one result per event */
     }
   }
@@ -1921,7 +1983,7 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
 
   uint8_t result = btm_ble_is_discoverable(bda, adv_data);
   if (result == 0) {
-    cache.Clear(addr_type, bda);
+    cache.Clear(addr_type, bda, advertising_sid);
     LOG_WARN("%s device no longer discoverable, discarding advertising packet",
              __func__);
     return;
@@ -1964,7 +2026,7 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
                        const_cast<uint8_t*>(adv_data.data()), adv_data.size());
   }
 
-  cache.Clear(addr_type, bda);
+  cache.Clear(addr_type, bda, advertising_sid);
 }
 
 void btm_ble_process_phy_update_pkt(uint8_t len, uint8_t* data) {
@@ -1979,6 +2041,12 @@ void btm_ble_process_phy_update_pkt(uint8_t len, uint8_t* data) {
   STREAM_TO_UINT8(tx_phy, p);
   STREAM_TO_UINT8(rx_phy, p);
 
+  int idx = btm_handle_to_acl_index(handle);
+  if (status == HCI_SUCCESS && idx < MAX_L2CAP_LINKS) {
+    btm_cb.acl_db[idx].le_tx_phy = tx_phy;
+    btm_cb.acl_db[idx].le_rx_phy = rx_phy;
+  }
+
   gatt_notify_phy_updated(status, handle, tx_phy, rx_phy);
 }
 
@@ -2278,6 +2346,7 @@ void btm_ble_read_remote_features_complete(uint8_t* p) {
 
   if (status == HCI_SUCCESS) {
     STREAM_TO_ARRAY(btm_cb.acl_db[idx].peer_le_features, p, BD_FEATURES_LEN);
+    btm_ble_link_policy_start(&btm_cb.acl_db[idx]);
   }
 
   btsnd_hcic_rmt_ver_req(handle);
@@ -2462,6 +2531,9 @@ void btm_ble_init(void) {
   p_cb->addr_mgnt_cb.refresh_raddr_timer =
       alarm_new("btm_ble_addr.refresh_raddr_timer");
 
+  p_cb->link_policy_enabled =
+      osi_property_get_bool(BTM_BLE_LINK_POLICY_PROPERTY, true);
+
 #if (BLE_VND_INCLUDED == FALSE)
   btm_ble_adv_filter_init();
 #endif
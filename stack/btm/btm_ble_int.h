@@ -40,6 +40,11 @@ extern void btm_ble_refresh_raddr_timer_timeout(void* data);
 extern void btm_ble_process_adv_pkt(uint8_t len, uint8_t* p);
 extern void btm_ble_process_phy_update_pkt(uint8_t len, uint8_t* p);
 extern void btm_ble_process_ext_adv_pkt(uint8_t len, uint8_t* p);
+extern void btm_ble_process_periodic_sync_established(uint8_t len,
+                                                    uint8_t* p);
+extern void btm_ble_process_periodic_adv_pkt(uint8_t len, uint8_t* p);
+extern void btm_ble_process_periodic_sync_lost(uint8_t len, uint8_t* p);
+extern void btm_ble_process_periodic_sync_transfer(uint8_t len, uint8_t* p);
 extern tBTM_STATUS btm_ble_read_remote_name(const RawAddress& remote_bda,
                                             tBTM_CMPL_CB* p_cb);
 extern bool btm_ble_cancel_remote_name(const RawAddress& remote_bda);
@@ -62,6 +67,9 @@ extern void btm_ble_connected(const RawAddress& bda, uint16_t handle,
                               uint8_t enc_mode, uint8_t role,
                               tBLE_ADDR_TYPE addr_type, bool addr_matched);
 extern void btm_ble_read_remote_features_complete(uint8_t* p);
+extern void btm_ble_link_policy_start(tACL_CONN* p_acl);
+extern void btm_ble_link_policy_rssi(tACL_CONN* p_acl, int8_t rssi);
+extern bool btm_ble_sample_energy_info(void);
 extern void btm_ble_write_adv_enable_complete(uint8_t* p);
 extern void btm_ble_conn_complete(uint8_t* p, uint16_t evt_len, bool enhanced);
 extern tBTM_BLE_CONN_ST btm_ble_get_conn_st(void);
@@ -133,6 +141,7 @@ extern void btm_gen_resolvable_private_addr(
 
 extern tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(
     const RawAddress& random_bda);
+extern void btm_ble_clear_resolved_random_addr_cache(void);
 extern void btm_gen_resolve_paddr_low(const RawAddress& address);
 extern uint64_t btm_get_next_private_addrress_interval_ms();
 
@@ -160,6 +169,8 @@ extern bool btm_ble_disable_resolving_list(uint8_t rl_mask, bool to_resume);
 extern void btm_ble_enable_resolving_list_for_platform(uint8_t rl_mask);
 extern void btm_ble_resolving_list_init(uint8_t max_irk_list_sz);
 extern void btm_ble_resolving_list_cleanup(void);
+extern void btm_ble_resolving_list_note_activity(tBTM_SEC_DEV_REC* p_dev_rec,
+                                                 bool in_controller);
 #endif
 
 extern void btm_ble_adv_init(void);
@@ -168,6 +179,8 @@ extern void btm_ble_batchscan_init(void);
 extern void btm_ble_batchscan_cleanup(void);
 extern void btm_ble_adv_filter_init(void);
 extern void btm_ble_adv_filter_cleanup(void);
+extern bool btm_ble_adv_filter_match(const RawAddress& bda, int8_t rssi,
+                                     const std::vector<uint8_t>& data);
 extern bool btm_ble_topology_check(tBTM_BLE_STATE_MASK request);
 extern bool btm_ble_clear_topology_mask(tBTM_BLE_STATE_MASK request_state);
 extern bool btm_ble_set_topology_mask(tBTM_BLE_STATE_MASK request_state);
@@ -303,11 +303,17 @@ typedef struct {
   tBTM_BLE_RL_STATE suspended_rl_state;     /* Suspended resolving list state */
   uint8_t* irk_list_mask; /* IRK list availability mask, up to max entry bits */
   tBTM_BLE_RL_STATE rl_state; /* Resolving list state */
+  uint32_t rl_hit_count;  /* RPAs resolved by the controller */
+  uint32_t rl_miss_count; /* RPAs of bonded devices resolved by the host */
+  uint32_t rl_swap_count; /* resolving list entries replaced */
 #endif
 
   /* current BLE link state */
   tBTM_BLE_STATE_MASK cur_states; /* bit mask of tBTM_BLE_STATE */
   uint8_t link_count[2];          /* total link count master and slave*/
+
+  /* LE link policy, see btm_ble_link_policy_start */
+  bool link_policy_enabled;
 } tBTM_BLE_CB;
 
 #endif  // BTM_BLE_INT_TYPES_H
@@ -27,6 +27,7 @@
 #include "stack/btm/btm_ble_int.h"
 
 #include <string.h>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -138,6 +139,35 @@ void alarm_set_closure(const base::Location& posted_from, alarm_t* alarm,
   alarm_set_on_mloop(alarm, interval_ms, alarm_closure_cb, data);
 }
 
+/* Completion state of the commands issued for several advertising sets at
+ * once: |cb| runs with the first failure status when the last one completes */
+struct BatchStatus {
+  size_t pending;
+  uint8_t status;
+  MultiAdvCb cb;
+};
+
+using BatchStatusPtr = std::shared_ptr<BatchStatus>;
+
+BatchStatusPtr NewBatchStatus(size_t pending, MultiAdvCb cb) {
+  return BatchStatusPtr(new BatchStatus{pending, 0x00, std::move(cb)});
+}
+
+void BatchCommandDone(BatchStatusPtr batch, uint8_t status) {
+  if (status && !batch->status) batch->status = status;
+  if (--batch->pending == 0) batch->cb.Run(batch->status);
+}
+
+/* Addresses being generated for the sets of one RPA update round */
+struct RpaBatch {
+  std::vector<AdvertisingInstance*> insts;
+  std::vector<RawAddress> addresses;
+  size_t pending;
+  MultiAdvCb cb;
+};
+
+using RpaBatchPtr = std::shared_ptr<RpaBatch>;
+
 class BleAdvertisingManagerImpl;
 
 /* a temporary type for holding all the data needed in callbacks below*/
@@ -191,51 +221,119 @@ class BleAdvertisingManagerImpl
   }
 
   void ConfigureRpa(AdvertisingInstance* p_inst, MultiAdvCb configuredCb) {
-    /* Connectable advertising set must be disabled when updating RPA */
-    bool restart = p_inst->IsEnabled() && p_inst->IsConnectable();
-
-    // If there is any form of timeout on the set, schedule address update when
-    // the set stops, because there is no good way to compute new timeout value.
-    // Maximum duration value is around 10 minutes, so this is safe.
-    if (restart && (p_inst->duration || p_inst->maxExtAdvEvents)) {
-      p_inst->address_update_required = true;
+    ConfigureRpaForSets({p_inst}, std::move(configuredCb));
+  }
+
+  /* Updates the RPA of all the |insts| in one round: connectable sets that are
+   * advertising are disabled with one command, the addresses are set, and the
+   * sets are enabled again with one command. */
+  void ConfigureRpaForSets(std::vector<AdvertisingInstance*> insts,
+                           MultiAdvCb configuredCb) {
+    RpaBatchPtr batch(new RpaBatch);
+
+    for (AdvertisingInstance* p_inst : insts) {
+      /* Connectable advertising set must be disabled when updating RPA */
+      bool restart = p_inst->IsEnabled() && p_inst->IsConnectable();
+
+      // If there is any form of timeout on the set, schedule address update
+      // when the set stops, because there is no good way to compute new
+      // timeout value. Maximum duration value is around 10 minutes, so this is
+      // safe.
+      if (restart && (p_inst->duration || p_inst->maxExtAdvEvents)) {
+        p_inst->address_update_required = true;
+        continue;
+      }
+
+      batch->insts.push_back(p_inst);
+    }
+
+    if (batch->insts.empty()) {
       configuredCb.Run(0x01);
       return;
     }
 
-    GenerateRpa(Bind(
-        [](AdvertisingInstance* p_inst, MultiAdvCb configuredCb,
-           const RawAddress& bda) {
-          /* Connectable advertising set must be disabled when updating RPA */
-          bool restart = p_inst->IsEnabled() && p_inst->IsConnectable();
+    batch->addresses.resize(batch->insts.size());
+    batch->pending = batch->insts.size();
+    batch->cb = std::move(configuredCb);
+    for (size_t i = 0; i < batch->insts.size(); i++) {
+      GenerateRpa(Bind(&BleAdvertisingManagerImpl::OnRpaGenerated,
+                       weak_factory_.GetWeakPtr(), batch, i));
+    }
+  }
 
-          if (!instance_weakptr.get()) return;
-          auto hci_interface = instance_weakptr.get()->GetHciInterface();
+  void OnRpaGenerated(RpaBatchPtr batch, size_t index, const RawAddress& bda) {
+    batch->addresses[index] = bda;
+    if (--batch->pending) return;
 
-          if (restart) {
-            p_inst->enable_status = false;
-            hci_interface->Enable(false, p_inst->inst_id, 0x00, 0x00,
-                                  base::DoNothing());
-          }
+    std::vector<SetEnableData> restart;
+    for (AdvertisingInstance* p_inst : batch->insts) {
+      /* Connectable advertising set must be disabled when updating RPA */
+      if (p_inst->IsEnabled() && p_inst->IsConnectable()) {
+        p_inst->enable_status = false;
+        restart.emplace_back(SetEnableData{.handle = p_inst->inst_id});
+      }
+    }
 
-          /* set it to controller */
-          hci_interface->SetRandomAddress(
-              p_inst->inst_id, bda,
-              Bind(
-                  [](AdvertisingInstance* p_inst, RawAddress bda,
-                     MultiAdvCb configuredCb, uint8_t status) {
-                    p_inst->own_address = bda;
-                    configuredCb.Run(0x00);
-                  },
-                  p_inst, bda, configuredCb));
-
-          if (restart) {
-            p_inst->enable_status = true;
-            hci_interface->Enable(true, p_inst->inst_id, 0x00, 0x00,
-                                  base::DoNothing());
-          }
-        },
-        p_inst, std::move(configuredCb)));
+    if (!restart.empty()) EnableHciSets(false, restart, base::DoNothing());
+
+    /* set it to controller */
+    BatchStatusPtr done =
+        NewBatchStatus(batch->insts.size(), std::move(batch->cb));
+    for (size_t i = 0; i < batch->insts.size(); i++) {
+      AdvertisingInstance* p_inst = batch->insts[i];
+      GetHciInterface()->SetRandomAddress(
+          p_inst->inst_id, batch->addresses[i],
+          Bind(&BleAdvertisingManagerImpl::OnRandomAddressSet,
+               weak_factory_.GetWeakPtr(), p_inst, batch->addresses[i], done));
+    }
+
+    if (!restart.empty()) {
+      for (const SetEnableData& set : restart) {
+        adv_inst[set.handle].enable_status = true;
+      }
+      EnableHciSets(true, std::move(restart), base::DoNothing());
+    }
+  }
+
+  void OnRandomAddressSet(AdvertisingInstance* p_inst, RawAddress bda,
+                          BatchStatusPtr done, uint8_t status) {
+    p_inst->own_address = bda;
+    BatchCommandDone(std::move(done), status);
+  }
+
+  /* Called when the address of |p_expired| is due. The other sets using an RPA
+   * are updated along with it, and their timers restarted with the same
+   * interval, so that all the sets rotate their address in one round. */
+  void OnRpaTimeout(AdvertisingInstance* p_expired) {
+    uint64_t interval_ms = btm_get_next_private_addrress_interval_ms();
+    std::vector<AdvertisingInstance*> insts;
+
+    for (AdvertisingInstance& inst : adv_inst) {
+      if (!inst.in_use || inst.own_address_type != BLE_ADDR_RANDOM) continue;
+
+      alarm_set_on_mloop(inst.adv_raddr_timer, interval_ms,
+                         btm_ble_adv_raddr_timer_timeout, &inst);
+      insts.push_back(&inst);
+    }
+
+    if (insts.empty()) return;
+    ConfigureRpaForSets(std::move(insts), base::DoNothing());
+  }
+
+  /* Sends |sets| to the controller with a single command when it can enable
+   * several sets at once, or one command per set otherwise. */
+  void EnableHciSets(bool enable, std::vector<SetEnableData> sets,
+                     MultiAdvCb cb) {
+    if (sets.size() == 1 || GetHciInterface()->SupportsMultiSetEnable()) {
+      GetHciInterface()->Enable(enable, std::move(sets), std::move(cb));
+      return;
+    }
+
+    BatchStatusPtr batch = NewBatchStatus(sets.size(), std::move(cb));
+    for (const SetEnableData& set : sets) {
+      GetHciInterface()->Enable(enable, std::vector<SetEnableData>{set},
+                                Bind(&BatchCommandDone, batch));
+    }
   }
 
   void RegisterAdvertiser(
@@ -668,6 +766,65 @@ class BleAdvertisingManagerImpl
                               p_inst->maxExtAdvEvents, std::move(myCb));
   }
 
+  void EnableSets(std::vector<uint8_t> inst_ids, bool enable,
+                  MultiAdvCb cb) override {
+    VLOG(1) << __func__ << " sets: " << inst_ids.size()
+            << ", enable: " << enable;
+    if (inst_ids.empty()) {
+      cb.Run(BTM_BLE_MULTI_ADV_SUCCESS);
+      return;
+    }
+
+    std::vector<AdvertisingInstance*> insts;
+    std::vector<AdvertisingInstance*> rpa_insts;
+    for (uint8_t inst_id : inst_ids) {
+      if (inst_id >= inst_count || !adv_inst[inst_id].in_use) {
+        LOG(ERROR) << "bad or inactive instance id " << +inst_id;
+        cb.Run(BTM_BLE_MULTI_ADV_FAILURE);
+        return;
+      }
+      insts.push_back(&adv_inst[inst_id]);
+    }
+
+    for (AdvertisingInstance* p_inst : insts) {
+      p_inst->duration = 0;
+      p_inst->maxExtAdvEvents = 0;
+      if (p_inst->timeout_timer) {
+        alarm_cancel(p_inst->timeout_timer);
+        alarm_free(p_inst->timeout_timer);
+        p_inst->timeout_timer = nullptr;
+      }
+
+      if (enable && p_inst->address_update_required) {
+        p_inst->address_update_required = false;
+        rpa_insts.push_back(p_inst);
+      }
+    }
+
+    if (!rpa_insts.empty()) {
+      ConfigureRpaForSets(
+          std::move(rpa_insts),
+          base::Bind(&BleAdvertisingManagerImpl::EnableSetsFinish,
+                     weak_factory_.GetWeakPtr(), insts, enable,
+                     std::move(cb)));
+      return;
+    }
+
+    EnableSetsFinish(std::move(insts), enable, std::move(cb), 0);
+  }
+
+  void EnableSetsFinish(std::vector<AdvertisingInstance*> insts, bool enable,
+                        MultiAdvCb cb, uint8_t status) {
+    std::vector<SetEnableData> sets;
+    for (AdvertisingInstance* p_inst : insts) {
+      if (enable) p_inst->enable_time = TimeTicks::Now();
+      p_inst->enable_status = enable;
+      sets.emplace_back(SetEnableData{.handle = p_inst->inst_id});
+    }
+
+    EnableHciSets(enable, std::move(sets), std::move(cb));
+  }
+
   void SetParameters(uint8_t inst_id, tBTM_BLE_ADV_PARAMS* p_params,
                      ParametersCb cb) override {
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
@@ -752,6 +909,27 @@ class BleAdvertisingManagerImpl
                    weak_factory_.GetWeakPtr(), is_scan_rsp));
   }
 
+  void SetDataForSets(std::vector<AdvertisingSetData> sets,
+                      MultiAdvCb cb) override {
+    VLOG(1) << __func__ << " sets: " << sets.size();
+    if (sets.empty()) {
+      cb.Run(BTM_BLE_MULTI_ADV_SUCCESS);
+      return;
+    }
+
+    BatchStatusPtr batch = NewBatchStatus(sets.size(), std::move(cb));
+    for (AdvertisingSetData& set : sets) {
+      if (set.inst_id >= inst_count) {
+        LOG(ERROR) << "bad instance id " << +set.inst_id;
+        BatchCommandDone(batch, BTM_BLE_MULTI_ADV_FAILURE);
+        continue;
+      }
+
+      SetData(set.inst_id, set.is_scan_rsp, std::move(set.data),
+              Bind(&BatchCommandDone, batch));
+    }
+  }
+
   void SetDataAdvDataSender(uint8_t is_scan_rsp, uint8_t inst_id,
                             uint8_t operation, uint8_t length, uint8_t* data,
                             MultiAdvCb cb) {
@@ -1015,7 +1193,7 @@ class BleAdvertisingManagerImpl
 
 void btm_ble_adv_raddr_timer_timeout(void* data) {
   BleAdvertisingManagerImpl* ptr = instance_weakptr.get();
-  if (ptr) ptr->ConfigureRpa((AdvertisingInstance*)data, base::DoNothing());
+  if (ptr) ptr->OnRpaTimeout((AdvertisingInstance*)data);
 }
 }  // namespace
 
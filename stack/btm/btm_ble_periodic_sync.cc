@@ -0,0 +1,484 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the periodic advertising sync manager: syncs created
+ *  by the host, and syncs received from a connected peer with the Periodic
+ *  Advertising Sync Transfer (PAST) procedure.
+ *
+ ******************************************************************************/
+
+#include <base/bind.h>
+#include <base/logging.h>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "bt_target.h"
+#include "btm_ble_api.h"
+#include "btm_int.h"
+#include "btu.h"
+#include "device/include/controller.h"
+#include "hcidefs.h"
+#include "stack/btm/btm_ble_int.h"
+
+using base::Bind;
+
+/* length of each periodic sync command */
+#define BTM_BLE_PERIODIC_SYNC_CREATE_LEN 14
+#define BTM_BLE_PERIODIC_SYNC_TERMINATE_LEN 2
+#define BTM_BLE_PERIODIC_SYNC_TRANSFER_LEN 6
+#define BTM_BLE_PERIODIC_SYNC_TRANSFER_PARAM_LEN 8
+
+/* Maximum length of the periodic advertising data of one train */
+#define BTM_BLE_PERIODIC_ADV_DATA_MAX 1650
+
+/* Periodic Advertising Report Data_Status values */
+#define BTM_BLE_PERIODIC_DATA_COMPLETE 0x00
+#define BTM_BLE_PERIODIC_DATA_INCOMPLETE 0x01
+#define BTM_BLE_PERIODIC_DATA_TRUNCATED 0x02
+
+/* PAST Mode: sync to the transferred train, with reports enabled */
+#define BTM_BLE_PERIODIC_SYNC_TRANSFER_MODE_REPORTS 0x02
+
+namespace {
+
+struct SyncCallbacks {
+  PeriodicSyncStartedCb started_cb;
+  PeriodicSyncReportCb report_cb;
+  PeriodicSyncLostCb lost_cb;
+};
+
+/* Sync waiting for the controller to find the train */
+struct PendingSync {
+  uint8_t adv_sid;
+  RawAddress address;
+  uint16_t skip;
+  uint16_t timeout;
+  SyncCallbacks cbs;
+};
+
+/* Established sync. |data| holds the fragments of the report being received,
+ * and keeps its capacity from one train to the next. */
+struct PeriodicSync {
+  SyncCallbacks cbs;
+  std::vector<uint8_t> data;
+};
+
+/* Peer whose transferred syncs are accepted */
+struct SyncTransferReceiver {
+  RawAddress address;
+  SyncCallbacks cbs;
+};
+
+/* Controller only creates one sync at a time: the front entry is the one
+ * being created once |create_in_progress| is set. */
+std::deque<PendingSync> pending_syncs;
+bool create_in_progress = false;
+
+/* Established syncs, by sync handle */
+std::unordered_map<uint16_t, PeriodicSync> syncs;
+
+std::vector<SyncTransferReceiver> transfer_receivers;
+
+tBLE_ADDR_TYPE btm_ble_periodic_adv_address_type(const RawAddress& address) {
+  tINQ_DB_ENT* p_i = btm_inq_db_find(address);
+  if (p_i) return p_i->inq_info.results.ble_addr_type;
+  return BLE_ADDR_RANDOM;
+}
+
+void btm_ble_create_sync_status_cb(uint8_t* param, uint16_t param_len);
+
+void btm_ble_start_next_sync() {
+  if (create_in_progress || pending_syncs.empty()) return;
+
+  const PendingSync& sync = pending_syncs.front();
+  uint8_t param[BTM_BLE_PERIODIC_SYNC_CREATE_LEN];
+  uint8_t* pp = param;
+
+  UINT8_TO_STREAM(pp, 0x00); /* Options: use the SID and address below */
+  UINT8_TO_STREAM(pp, sync.adv_sid);
+  UINT8_TO_STREAM(pp, btm_ble_periodic_adv_address_type(sync.address));
+  BDADDR_TO_STREAM(pp, sync.address);
+  UINT16_TO_STREAM(pp, sync.skip);
+  UINT16_TO_STREAM(pp, sync.timeout);
+  UINT8_TO_STREAM(pp, 0x00); /* Sync_CTE_Type: no restriction */
+
+  create_in_progress = true;
+  btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_BLE_PERIODIC_ADVERTISING_CREATE_SYNC,
+                            param, BTM_BLE_PERIODIC_SYNC_CREATE_LEN,
+                            base::Bind(&btm_ble_create_sync_status_cb));
+}
+
+/* Only called when the command failed, success is reported by the LE
+ * Periodic Advertising Sync Established event */
+void btm_ble_create_sync_status_cb(uint8_t* param, uint16_t param_len) {
+  uint8_t status;
+  STREAM_TO_UINT8(status, param);
+
+  LOG(ERROR) << __func__ << ": create sync failed, status: " << loghex(status);
+  if (!create_in_progress || pending_syncs.empty()) return;
+
+  PendingSync sync = std::move(pending_syncs.front());
+  pending_syncs.pop_front();
+  create_in_progress = false;
+
+  sync.cbs.started_cb.Run(status, 0, sync.adv_sid, BLE_ADDR_PUBLIC,
+                          sync.address, 0, 0);
+  btm_ble_start_next_sync();
+}
+
+void btm_ble_sync_established(uint8_t status, uint16_t sync_handle,
+                              uint8_t adv_sid, uint8_t address_type,
+                              const RawAddress& address, uint8_t phy,
+                              uint16_t interval, SyncCallbacks cbs) {
+  if (status == HCI_SUCCESS) {
+    PeriodicSync& sync = syncs[sync_handle];
+    sync.cbs = cbs;
+    sync.data.clear();
+  }
+
+  cbs.started_cb.Run(status, sync_handle, adv_sid, address_type, address, phy,
+                     interval);
+}
+
+void btm_ble_terminate_sync(uint16_t sync_handle) {
+  uint8_t param[BTM_BLE_PERIODIC_SYNC_TERMINATE_LEN];
+  uint8_t* pp = param;
+  UINT16_TO_STREAM(pp, sync_handle);
+
+  btu_hcif_send_cmd_with_cb(
+      FROM_HERE, HCI_BLE_PERIODIC_ADVERTISING_TERMINATE_SYNC, param,
+      BTM_BLE_PERIODIC_SYNC_TERMINATE_LEN,
+      base::Bind([](uint8_t* param, uint16_t param_len) {
+        uint8_t status;
+        STREAM_TO_UINT8(status, param);
+        if (status != HCI_SUCCESS) {
+          LOG(ERROR) << "terminate sync failed, status: " << loghex(status);
+        }
+      }));
+}
+
+}  // namespace
+
+void BTM_BleStartPeriodicSync(uint8_t adv_sid, const RawAddress& address,
+                              uint16_t skip, uint16_t timeout,
+                              PeriodicSyncStartedCb started_cb,
+                              PeriodicSyncReportCb report_cb,
+                              PeriodicSyncLostCb lost_cb) {
+  VLOG(1) << __func__ << " adv_sid: " << +adv_sid << ", address: " << address;
+
+  if (!controller_get_interface()->supports_ble_periodic_advertising()) {
+    LOG(ERROR) << __func__ << ": periodic advertising not supported";
+    started_cb.Run(HCI_ERR_ILLEGAL_COMMAND, 0, adv_sid, BLE_ADDR_PUBLIC,
+                   address, 0, 0);
+    return;
+  }
+
+  pending_syncs.push_back(
+      PendingSync{adv_sid, address, skip, timeout,
+                  SyncCallbacks{std::move(started_cb), std::move(report_cb),
+                                std::move(lost_cb)}});
+  btm_ble_start_next_sync();
+}
+
+void BTM_BleCancelPeriodicSync(uint8_t adv_sid, const RawAddress& address) {
+  VLOG(1) << __func__ << " adv_sid: " << +adv_sid << ", address: " << address;
+
+  for (auto it = pending_syncs.begin(); it != pending_syncs.end(); it++) {
+    if (it->adv_sid != adv_sid || it->address != address) continue;
+
+    /* The controller reports the cancellation of the sync it is creating with
+     * the LE Periodic Advertising Sync Established event */
+    if (it == pending_syncs.begin() && create_in_progress) {
+      btu_hcif_send_cmd_with_cb(
+          FROM_HERE, HCI_BLE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL, nullptr,
+          0, base::Bind([](uint8_t* param, uint16_t param_len) {
+            uint8_t status;
+            STREAM_TO_UINT8(status, param);
+            if (status != HCI_SUCCESS) {
+              LOG(ERROR) << "create sync cancel failed, status: "
+                         << loghex(status);
+            }
+          }));
+      return;
+    }
+
+    PendingSync sync = std::move(*it);
+    pending_syncs.erase(it);
+    sync.cbs.started_cb.Run(HCI_ERR_OPERATION_CANCELLED_BY_HOST, 0,
+                            sync.adv_sid, BLE_ADDR_PUBLIC, sync.address, 0, 0);
+    return;
+  }
+
+  LOG(WARNING) << __func__ << ": no pending sync";
+}
+
+void BTM_BleStopPeriodicSync(uint16_t sync_handle) {
+  VLOG(1) << __func__ << " sync_handle: " << loghex(sync_handle);
+
+  if (syncs.erase(sync_handle) == 0) {
+    LOG(WARNING) << __func__ << ": unknown sync_handle "
+                 << loghex(sync_handle);
+    return;
+  }
+
+  btm_ble_terminate_sync(sync_handle);
+}
+
+void BTM_BlePeriodicSyncTransfer(
+    const RawAddress& bd_addr, uint16_t service_data, uint16_t sync_handle,
+    base::Callback<void(uint8_t status, RawAddress address)> cb) {
+  uint16_t conn_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_LE);
+  if (conn_handle == HCI_INVALID_HANDLE) {
+    LOG(ERROR) << __func__ << ": no LE connection to " << bd_addr;
+    cb.Run(HCI_ERR_NO_CONNECTION, bd_addr);
+    return;
+  }
+
+  uint8_t param[BTM_BLE_PERIODIC_SYNC_TRANSFER_LEN];
+  uint8_t* pp = param;
+  UINT16_TO_STREAM(pp, conn_handle);
+  UINT16_TO_STREAM(pp, service_data);
+  UINT16_TO_STREAM(pp, sync_handle);
+
+  btu_hcif_send_cmd_with_cb(
+      FROM_HERE, HCI_BLE_PERIODIC_ADVERTISING_SYNC_TRANSFER, param,
+      BTM_BLE_PERIODIC_SYNC_TRANSFER_LEN,
+      base::Bind(
+          [](base::Callback<void(uint8_t, RawAddress)> cb, RawAddress bd_addr,
+             uint8_t* param, uint16_t param_len) {
+            uint8_t status;
+            STREAM_TO_UINT8(status, param);
+            cb.Run(status, bd_addr);
+          },
+          std::move(cb), bd_addr));
+}
+
+void BTM_BleReceivePeriodicSyncTransfer(const RawAddress& bd_addr,
+                                        uint16_t skip, uint16_t timeout,
+                                        PeriodicSyncStartedCb started_cb,
+                                        PeriodicSyncReportCb report_cb,
+                                        PeriodicSyncLostCb lost_cb) {
+  uint16_t conn_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_LE);
+  if (conn_handle == HCI_INVALID_HANDLE) {
+    LOG(ERROR) << __func__ << ": no LE connection to " << bd_addr;
+    started_cb.Run(HCI_ERR_NO_CONNECTION, 0, 0, BLE_ADDR_PUBLIC,
+                   RawAddress::kEmpty, 0, 0);
+    return;
+  }
+
+  SyncCallbacks cbs{std::move(started_cb), std::move(report_cb),
+                    std::move(lost_cb)};
+  bool found = false;
+  for (SyncTransferReceiver& receiver : transfer_receivers) {
+    if (receiver.address != bd_addr) continue;
+    receiver.cbs = cbs;
+    found = true;
+  }
+  if (!found) transfer_receivers.push_back(SyncTransferReceiver{bd_addr, cbs});
+
+  uint8_t param[BTM_BLE_PERIODIC_SYNC_TRANSFER_PARAM_LEN];
+  uint8_t* pp = param;
+  UINT16_TO_STREAM(pp, conn_handle);
+  UINT8_TO_STREAM(pp, BTM_BLE_PERIODIC_SYNC_TRANSFER_MODE_REPORTS);
+  UINT16_TO_STREAM(pp, skip);
+  UINT16_TO_STREAM(pp, timeout);
+  UINT8_TO_STREAM(pp, 0x00); /* CTE_Type: no restriction */
+
+  btu_hcif_send_cmd_with_cb(
+      FROM_HERE, HCI_BLE_SET_PERIODIC_ADVERTISING_SYNC_TRANSFER_PARAM, param,
+      BTM_BLE_PERIODIC_SYNC_TRANSFER_PARAM_LEN,
+      base::Bind(
+          [](RawAddress bd_addr, uint8_t* param, uint16_t param_len) {
+            uint8_t status;
+            STREAM_TO_UINT8(status, param);
+            if (status == HCI_SUCCESS) return;
+
+            LOG(ERROR) << "setting sync transfer parameters failed, status: "
+                       << loghex(status);
+            for (auto it = transfer_receivers.begin();
+                 it != transfer_receivers.end(); it++) {
+              if (it->address != bd_addr) continue;
+              PeriodicSyncStartedCb started_cb = it->cbs.started_cb;
+              transfer_receivers.erase(it);
+              started_cb.Run(status, 0, 0, BLE_ADDR_PUBLIC, bd_addr, 0, 0);
+              return;
+            }
+          },
+          bd_addr));
+}
+
+/* LE Periodic Advertising Sync Established event */
+void btm_ble_process_periodic_sync_established(uint8_t len, uint8_t* p) {
+  uint8_t status, adv_sid, address_type, phy, clock_accuracy;
+  uint16_t sync_handle, interval;
+  RawAddress address;
+
+  if (len < 15) {
+    LOG(ERROR) << __func__ << ": bogus event, len: " << +len;
+    return;
+  }
+
+  STREAM_TO_UINT8(status, p);
+  STREAM_TO_UINT16(sync_handle, p);
+  STREAM_TO_UINT8(adv_sid, p);
+  STREAM_TO_UINT8(address_type, p);
+  STREAM_TO_BDADDR(address, p);
+  STREAM_TO_UINT8(phy, p);
+  STREAM_TO_UINT16(interval, p);
+  STREAM_TO_UINT8(clock_accuracy, p);
+
+  VLOG(1) << __func__ << " status: " << loghex(status)
+          << ", sync_handle: " << loghex(sync_handle)
+          << ", adv_sid: " << +adv_sid;
+
+  if (!create_in_progress || pending_syncs.empty()) {
+    LOG(WARNING) << __func__ << ": no sync being created";
+    if (status == HCI_SUCCESS) btm_ble_terminate_sync(sync_handle);
+    return;
+  }
+
+  PendingSync sync = std::move(pending_syncs.front());
+  pending_syncs.pop_front();
+  create_in_progress = false;
+
+  btm_ble_sync_established(status, sync_handle, adv_sid, address_type,
+                           address, phy, interval, std::move(sync.cbs));
+  btm_ble_start_next_sync();
+}
+
+/* LE Periodic Advertising Report event. A report that fits in one event is
+ * passed straight from the event buffer, fragmented ones are gathered in the
+ * buffer of the sync and passed once complete. */
+void btm_ble_process_periodic_adv_pkt(uint8_t len, uint8_t* p) {
+  uint16_t sync_handle;
+  int8_t tx_power, rssi;
+  uint8_t cte_type, data_status, data_len;
+
+  if (len < 7) {
+    LOG(ERROR) << __func__ << ": bogus event, len: " << +len;
+    return;
+  }
+
+  STREAM_TO_UINT16(sync_handle, p);
+  STREAM_TO_INT8(tx_power, p);
+  STREAM_TO_INT8(rssi, p);
+  STREAM_TO_UINT8(cte_type, p);
+  STREAM_TO_UINT8(data_status, p);
+  STREAM_TO_UINT8(data_len, p);
+
+  if (data_len > len - 7) {
+    LOG(ERROR) << __func__ << ": bogus report, data_len: " << +data_len;
+    return;
+  }
+
+  auto it = syncs.find(sync_handle);
+  if (it == syncs.end()) return;
+  PeriodicSync& sync = it->second;
+
+  if (data_status == BTM_BLE_PERIODIC_DATA_COMPLETE && sync.data.empty()) {
+    sync.cbs.report_cb.Run(sync_handle, tx_power, rssi, data_status, p,
+                           data_len);
+    return;
+  }
+
+  if (sync.data.size() + data_len > BTM_BLE_PERIODIC_ADV_DATA_MAX) {
+    data_status = BTM_BLE_PERIODIC_DATA_TRUNCATED;
+  } else {
+    sync.data.insert(sync.data.end(), p, p + data_len);
+  }
+
+  if (data_status == BTM_BLE_PERIODIC_DATA_INCOMPLETE) return;
+
+  sync.cbs.report_cb.Run(sync_handle, tx_power, rssi, data_status,
+                         sync.data.data(), sync.data.size());
+  sync.data.clear();
+}
+
+/* LE Periodic Advertising Sync Lost event */
+void btm_ble_process_periodic_sync_lost(uint8_t len, uint8_t* p) {
+  uint16_t sync_handle;
+
+  if (len < 2) {
+    LOG(ERROR) << __func__ << ": bogus event, len: " << +len;
+    return;
+  }
+
+  STREAM_TO_UINT16(sync_handle, p);
+  VLOG(1) << __func__ << " sync_handle: " << loghex(sync_handle);
+
+  auto it = syncs.find(sync_handle);
+  if (it == syncs.end()) return;
+
+  PeriodicSyncLostCb lost_cb = std::move(it->second.cbs.lost_cb);
+  syncs.erase(it);
+  lost_cb.Run(sync_handle);
+}
+
+/* LE Periodic Advertising Sync Transfer Received event */
+void btm_ble_process_periodic_sync_transfer(uint8_t len, uint8_t* p) {
+  uint8_t status, adv_sid, address_type, phy, clock_accuracy;
+  uint16_t conn_handle, service_data, sync_handle, interval;
+  RawAddress address;
+
+  if (len < 19) {
+    LOG(ERROR) << __func__ << ": bogus event, len: " << +len;
+    return;
+  }
+
+  STREAM_TO_UINT8(status, p);
+  STREAM_TO_UINT16(conn_handle, p);
+  STREAM_TO_UINT16(service_data, p);
+  STREAM_TO_UINT16(sync_handle, p);
+  STREAM_TO_UINT8(adv_sid, p);
+  STREAM_TO_UINT8(address_type, p);
+  STREAM_TO_BDADDR(address, p);
+  STREAM_TO_UINT8(phy, p);
+  STREAM_TO_UINT16(interval, p);
+  STREAM_TO_UINT8(clock_accuracy, p);
+
+  VLOG(1) << __func__ << " status: " << loghex(status)
+          << ", conn_handle: " << loghex(conn_handle)
+          << ", sync_handle: " << loghex(sync_handle);
+
+  uint8_t acl_idx = btm_handle_to_acl_index(conn_handle);
+  if (acl_idx >= MAX_L2CAP_LINKS) {
+    if (status == HCI_SUCCESS) btm_ble_terminate_sync(sync_handle);
+    return;
+  }
+
+  const RawAddress& peer = btm_cb.acl_db[acl_idx].remote_addr;
+  for (const SyncTransferReceiver& receiver : transfer_receivers) {
+    if (receiver.address != peer) continue;
+    btm_ble_sync_established(status, sync_handle, adv_sid, address_type,
+                             address, phy, interval, receiver.cbs);
+    return;
+  }
+
+  LOG(WARNING) << __func__ << ": sync transfer not expected from " << peer;
+  if (status == HCI_SUCCESS) btm_ble_terminate_sync(sync_handle);
+}
+
+void btm_ble_periodic_sync_cleanup(void) {
+  pending_syncs.clear();
+  create_in_progress = false;
+  syncs.clear();
+  transfer_receivers.clear();
+}
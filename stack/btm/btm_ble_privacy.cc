@@ -21,14 +21,17 @@
  *  This file contains functions for BLE controller based privacy.
  *
  ******************************************************************************/
+#include <stdio.h>
 #include <string.h>
 #include "bt_target.h"
 
 #if (BLE_PRIVACY_SPT == TRUE)
+#include <base/bind.h>
 #include "ble_advertiser.h"
 #include "bt_types.h"
 #include "btm_int.h"
 #include "btu.h"
+#include "common/time_util.h"
 #include "device/include/controller.h"
 #include "hcimsgs.h"
 #include "vendor_hcidefs.h"
@@ -48,6 +51,14 @@
 #define BTM_BLE_META_READ_IRK_LEN 2
 #define BTM_BLE_META_ADD_WL_ATTR_LEN 9
 
+/* A device keeps its resolving list entry for at least this long after it was
+ * last seen, so that a full list is not thrashed by a crowd of active peers */
+#define BTM_BLE_RL_MIN_RESIDENCY_MS (60 * 1000)
+
+/* Most recent device resolved on the host while not in the resolving list */
+static RawAddress rl_swap_in_bda;
+static bool rl_swap_in_scheduled = false;
+
 /*******************************************************************************
  *         Functions implemented controller based privacy using Resolving List
  ******************************************************************************/
@@ -662,6 +673,58 @@ bool btm_ble_disable_resolving_list(uint8_t rl_mask, bool to_resume) {
   return true;
 }
 
+typedef struct {
+  const tBTM_SEC_DEV_REC* p_exclude;
+  uint64_t seen_before_ms;
+  tBTM_SEC_DEV_REC* p_found;
+} tBTM_BLE_RL_LRU_SEARCH;
+
+static bool find_least_recent_resolving_list_dev(void* data, void* context) {
+  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
+  tBTM_BLE_RL_LRU_SEARCH* p_search =
+      static_cast<tBTM_BLE_RL_LRU_SEARCH*>(context);
+
+  /* devices in the white list need their entry for background connections */
+  if (p_dev_rec == p_search->p_exclude ||
+      (p_dev_rec->ble.in_controller_list &
+       (BTM_RESOLVING_LIST_BIT | BTM_WHITE_LIST_BIT)) !=
+          BTM_RESOLVING_LIST_BIT ||
+      p_dev_rec->ble.rl_active_ms > p_search->seen_before_ms ||
+      btm_ble_brcm_find_resolving_pending_entry(
+          p_dev_rec->bd_addr, BTM_BLE_META_REMOVE_IRK_ENTRY))
+    return true;
+
+  if (p_search->p_found == NULL ||
+      p_dev_rec->ble.rl_active_ms < p_search->p_found->ble.rl_active_ms)
+    p_search->p_found = p_dev_rec;
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_find_least_recent_resolving_list_dev
+ *
+ * Description      This function finds the device in the resolving list that
+ *                  was seen least recently, and not within the minimum
+ *                  residency time.
+ *
+ * Parameters       p_exclude: device that must not be returned
+ *
+ * Returns          pointer to device security record, or NULL if none
+ *
+ ******************************************************************************/
+static tBTM_SEC_DEV_REC* btm_ble_find_least_recent_resolving_list_dev(
+    const tBTM_SEC_DEV_REC* p_exclude) {
+  uint64_t current_ms = bluetooth::common::time_get_os_boottime_ms();
+  tBTM_BLE_RL_LRU_SEARCH search = {p_exclude, 0, NULL};
+  if (current_ms > BTM_BLE_RL_MIN_RESIDENCY_MS)
+    search.seen_before_ms = current_ms - BTM_BLE_RL_MIN_RESIDENCY_MS;
+
+  list_foreach(btm_cb.sec_dev_rec, find_least_recent_resolving_list_dev,
+               &search);
+  return search.p_found;
+}
+
 /*******************************************************************************
  *
  * Function         btm_ble_resolving_list_load_dev
@@ -712,14 +775,27 @@ bool btm_ble_resolving_list_load_dev(tBTM_SEC_DEV_REC* p_dev_rec) {
     return true;
   }
 
+  /* when the list is full, make room by replacing the least recently seen
+   * device, which is then resolved on the host until it is seen again */
+  tBTM_SEC_DEV_REC* p_evicted = NULL;
   if (btm_cb.ble_ctr_cb.resolving_list_avail_size == 0) {
-    return false;
+    p_evicted = btm_ble_find_least_recent_resolving_list_dev(p_dev_rec);
+    if (p_evicted == NULL) return false;
   }
 
   if (rl_state && !btm_ble_disable_resolving_list(rl_state, false)) {
     return false;
   }
 
+  if (p_evicted != NULL) {
+    BTM_TRACE_DEBUG("%s: replacing device %s in controller resolving list",
+                    __func__, p_evicted->bd_addr.ToString().c_str());
+    btm_ble_update_resolving_list(p_evicted->bd_addr, false);
+    btm_ble_remove_resolving_list_entry(p_evicted);
+    btm_cb.ble_ctr_cb.rl_swap_count++;
+  }
+
+  p_dev_rec->ble.rl_active_ms = bluetooth::common::time_get_os_boottime_ms();
   btm_ble_update_resolving_list(p_dev_rec->bd_addr, true);
   if (controller_get_interface()->supports_ble_privacy()) {
     const Octet16& peer_irk = p_dev_rec->ble.keys.irk;
@@ -800,6 +876,56 @@ void btm_ble_resolving_list_remove_dev(tBTM_SEC_DEV_REC* p_dev_rec) {
   if (rl_mask) btm_ble_enable_resolving_list(rl_mask);
 }
 
+static void btm_ble_resolving_list_swap_in(void) {
+  rl_swap_in_scheduled = false;
+
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(rl_swap_in_bda);
+  if (p_dev_rec == NULL ||
+      (p_dev_rec->ble.in_controller_list & BTM_RESOLVING_LIST_BIT))
+    return;
+
+  btm_ble_resolving_list_load_dev(p_dev_rec);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_resolving_list_note_activity
+ *
+ * Description      This function is called when a bonded device is seen with
+ *                  a resolvable private address. A device resolved on the host
+ *                  is loaded into the resolving list once the current batch of
+ *                  main thread events is handled, so that suspending and
+ *                  resuming the resolving list activity happens once.
+ *
+ * Parameters       p_dev_rec: pointer to device security record
+ *                  in_controller: true if the controller resolved the address
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_resolving_list_note_activity(tBTM_SEC_DEV_REC* p_dev_rec,
+                                          bool in_controller) {
+  if (controller_get_interface()->get_ble_resolving_list_max_size() == 0)
+    return;
+
+  p_dev_rec->ble.rl_active_ms = bluetooth::common::time_get_os_boottime_ms();
+  if (in_controller) {
+    btm_cb.ble_ctr_cb.rl_hit_count++;
+    return;
+  }
+
+  btm_cb.ble_ctr_cb.rl_miss_count++;
+  if (p_dev_rec->ble.in_controller_list & BTM_RESOLVING_LIST_BIT) return;
+
+  rl_swap_in_bda = p_dev_rec->bd_addr;
+  if (rl_swap_in_scheduled) return;
+  if (do_in_main_thread(FROM_HERE,
+                        base::Bind(&btm_ble_resolving_list_swap_in)) ==
+      BT_STATUS_SUCCESS) {
+    rl_swap_in_scheduled = true;
+  }
+}
+
 /*******************************************************************************
  *
  * Function         btm_ble_enable_resolving_list
@@ -930,4 +1056,27 @@ void btm_ble_resolving_list_cleanup(void) {
 
   osi_free_and_reset((void**)&btm_cb.ble_ctr_cb.irk_list_mask);
 }
+
+/*******************************************************************************
+ *
+ * Function         BTM_BleResolvingListDump
+ *
+ * Description      Dump the resolving list usage statistics
+ *
+ * Parameters       fd: file descriptor to write to
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTM_BleResolvingListDump(int fd) {
+  const tBTM_BLE_CB* p_cb = &btm_cb.ble_ctr_cb;
+
+  dprintf(fd, "\nLE Resolving List:\n");
+  dprintf(fd, "  Controller capacity: %d\n",
+          controller_get_interface()->get_ble_resolving_list_max_size());
+  dprintf(fd, "  Available entries: %d\n", p_cb->resolving_list_avail_size);
+  dprintf(fd, "  Resolved by controller: %u\n", p_cb->rl_hit_count);
+  dprintf(fd, "  Resolved by host: %u\n", p_cb->rl_miss_count);
+  dprintf(fd, "  Entries replaced: %u\n", p_cb->rl_swap_count);
+}
 #endif
@@ -154,6 +154,19 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
 void wipe_secrets_and_remove(tBTM_SEC_DEV_REC* p_dev_rec) {
   p_dev_rec->link_key.fill(0);
   memset(&p_dev_rec->ble.keys, 0, sizeof(tBTM_SEC_BLE_KEYS));
+  auto is_dev_rec = [p_dev_rec](const RawAddress&,
+                                tBTM_SEC_DEV_REC* p_indexed_rec) {
+    return p_indexed_rec == p_dev_rec;
+  };
+  btm_cb.sec_dev_index->EraseIf(is_dev_rec);
+  btm_cb.sec_dev_identity_index->EraseIf(is_dev_rec);
+  auto& handle_index = *btm_cb.sec_dev_handle_index;
+  for (auto it = handle_index.begin(); it != handle_index.end();) {
+    if (it->second == p_dev_rec)
+      it = handle_index.erase(it);
+    else
+      ++it;
+  }
   list_remove(btm_cb.sec_dev_rec, p_dev_rec);
 }
 
@@ -256,6 +269,10 @@ tBTM_SEC_DEV_REC* btm_sec_alloc_dev(const RawAddress& bd_addr) {
 
     p_dev_rec->device_type = p_inq_info->results.device_type;
     p_dev_rec->ble.ble_addr_type = p_inq_info->results.ble_addr_type;
+    if (p_inq_info->results.inq_result_type & BTM_INQ_RESULT_BR) {
+      p_dev_rec->page_scan_rep_mode = p_inq_info->results.page_scan_rep_mode;
+      p_dev_rec->clock_offset = p_inq_info->results.clock_offset;
+    }
   } else if (bd_addr == btm_cb.connecting_bda)
     memcpy(p_dev_rec->dev_class, btm_cb.connecting_dc, DEV_CLASS_LEN);
 
@@ -326,21 +343,50 @@ bool is_handle_equal(void* data, void* context) {
   return true;
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_dev_rec_touch
+ *
+ * Description      Marks the record as the most recently used one, so that
+ *                  btm_find_oldest_dev_rec() evicts it last
+ *
+ * Returns          The record
+ *
+ ******************************************************************************/
+tBTM_SEC_DEV_REC* btm_dev_rec_touch(tBTM_SEC_DEV_REC* p_dev_rec) {
+  p_dev_rec->last_used = ++btm_cb.dev_rec_use_count;
+  return p_dev_rec;
+}
+
 /*******************************************************************************
  *
  * Function         btm_find_dev_by_handle
  *
  * Description      Look for the record in the device database for the record
- *                  with specified handle
+ *                  with specified handle. The records found are indexed by
+ *                  handle, the index being checked against the record as the
+ *                  handles are reused after disconnection.
  *
  * Returns          Pointer to the record or NULL
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle) {
+  auto& handle_index = *btm_cb.sec_dev_handle_index;
+  auto it = handle_index.find(handle);
+  if (it != handle_index.end()) {
+    tBTM_SEC_DEV_REC* p_dev_rec = it->second;
+    if (p_dev_rec->hci_handle == handle || p_dev_rec->ble_hci_handle == handle)
+      return btm_dev_rec_touch(p_dev_rec);
+    handle_index.erase(it);
+  }
+
   list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (n == NULL) return NULL;
 
-  return NULL;
+  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  /* all the records without connection share the invalid handle */
+  if (handle != BTM_SEC_INVALID_HANDLE) handle_index[handle] = p_dev_rec;
+  return btm_dev_rec_touch(p_dev_rec);
 }
 
 bool is_address_equal(void* data, void* context) {
@@ -360,17 +406,33 @@ bool is_address_equal(void* data, void* context) {
  * Function         btm_find_dev
  *
  * Description      Look for the record in the device database for the record
- *                  with specified BD address
+ *                  with specified BD address. The records found by their
+ *                  address or pseudo address are indexed, sparing the scan of
+ *                  the database and its address resolutions the next time.
+ *                  The index is checked against the record, as their
+ *                  addresses change after they are found.
  *
  * Returns          Pointer to the record or NULL
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) {
+  tBTM_SEC_DEV_REC** pp_indexed_rec = btm_cb.sec_dev_index->Find(bd_addr);
+  if (pp_indexed_rec != NULL) {
+    tBTM_SEC_DEV_REC* p_dev_rec = *pp_indexed_rec;
+    if (p_dev_rec->bd_addr == bd_addr || p_dev_rec->ble.pseudo_addr == bd_addr)
+      return btm_dev_rec_touch(p_dev_rec);
+    btm_cb.sec_dev_index->Erase(bd_addr);
+  }
+
   list_node_t* n =
       list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (n == NULL) return NULL;
 
-  return NULL;
+  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  /* resolvable private addresses change, they are not worth indexing */
+  if (p_dev_rec->bd_addr == bd_addr || p_dev_rec->ble.pseudo_addr == bd_addr)
+    btm_cb.sec_dev_index->Put(bd_addr, p_dev_rec);
+  return btm_dev_rec_touch(p_dev_rec);
 }
 
 /*******************************************************************************
@@ -456,18 +518,19 @@ tBTM_SEC_DEV_REC* btm_find_or_alloc_dev(const RawAddress& bd_addr) {
  *
  * Function         btm_find_oldest_dev_rec
  *
- * Description      Locates the oldest device in use. It first looks for
- *                  the oldest non-paired device.  If all devices are paired it
- *                  returns the oldest paired device.
+ * Description      Locates the least recently used device. It first looks for
+ *                  the least recently used non-paired device without
+ *                  connection, then for the least recently used non-paired
+ *                  device. If all devices are paired it returns the least
+ *                  recently used paired device.
  *
  * Returns          Pointer to the record or NULL
  *
  ******************************************************************************/
 static tBTM_SEC_DEV_REC* btm_find_oldest_dev_rec(void) {
+  tBTM_SEC_DEV_REC* p_oldest_idle = NULL;
   tBTM_SEC_DEV_REC* p_oldest = NULL;
-  uint32_t ts_oldest = 0xFFFFFFFF;
   tBTM_SEC_DEV_REC* p_oldest_paired = NULL;
-  uint32_t ts_oldest_paired = 0xFFFFFFFF;
 
   list_node_t* end = list_end(btm_cb.sec_dev_rec);
   for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
@@ -478,21 +541,24 @@ static tBTM_SEC_DEV_REC* btm_find_oldest_dev_rec(void) {
     if ((p_dev_rec->sec_flags &
          (BTM_SEC_LINK_KEY_KNOWN | BTM_SEC_LE_LINK_KEY_KNOWN)) == 0) {
       // Device is not paired
-      if (p_dev_rec->timestamp < ts_oldest) {
+      if (p_oldest == NULL || p_dev_rec->last_used < p_oldest->last_used)
         p_oldest = p_dev_rec;
-        ts_oldest = p_dev_rec->timestamp;
-      }
+      if (p_dev_rec->hci_handle == BTM_SEC_INVALID_HANDLE &&
+          p_dev_rec->ble_hci_handle == BTM_SEC_INVALID_HANDLE &&
+          (p_oldest_idle == NULL ||
+           p_dev_rec->last_used < p_oldest_idle->last_used))
+        p_oldest_idle = p_dev_rec;
     } else {
       // Paired device
-      if (p_dev_rec->timestamp < ts_oldest_paired) {
+      if (p_oldest_paired == NULL ||
+          p_dev_rec->last_used < p_oldest_paired->last_used)
         p_oldest_paired = p_dev_rec;
-        ts_oldest_paired = p_dev_rec->timestamp;
-      }
     }
   }
 
+  if (p_oldest_idle != NULL) return p_oldest_idle;
   // If we did not find any non-paired devices, use the oldest paired one...
-  if (ts_oldest == 0xFFFFFFFF) p_oldest = p_oldest_paired;
+  if (p_oldest == NULL) p_oldest = p_oldest_paired;
 
   return p_oldest;
 }
@@ -525,7 +591,9 @@ tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void) {
   p_dev_rec->sec_flags = BTM_SEC_IN_USE;
   p_dev_rec->bond_type = BOND_TYPE_UNKNOWN;
   p_dev_rec->timestamp = btm_cb.dev_rec_count++;
+  btm_dev_rec_touch(p_dev_rec);
   p_dev_rec->rmt_io_caps = BTM_IO_CAP_UNKNOWN;
+  p_dev_rec->page_scan_rep_mode = HCI_PAGE_SCAN_REP_MODE_R1;
 
   return p_dev_rec;
 }
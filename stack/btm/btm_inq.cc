@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 
 #include "common/time_util.h"
 #include "device/include/controller.h"
@@ -1110,6 +1111,49 @@ void btm_inq_clear_ssp(void) {
   btm_cb.btm_inq_vars.inq_active &= ~BTM_SSP_INQUIRY_ACTIVE;
 }
 
+static_assert(BTM_INQ_DB_SIZE < 256, "inq_db_index holds 8 bit indexes");
+
+/* Returns the slot of |bda| in a hash table of |size| slots, probing starts
+ * there */
+static size_t btm_inq_bdaddr_hash(const RawAddress& bda, size_t size) {
+  uint32_t hash = 0;
+  for (uint8_t b : bda.address) hash = hash * 31 + b;
+  return hash % size;
+}
+
+/* Adds the inquiry database entry at |inx| to the hash index */
+static void btm_inq_db_index_add(uint16_t inx) {
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+  size_t slot = btm_inq_bdaddr_hash(
+      p_inq->inq_db[inx].inq_info.results.remote_bd_addr,
+      BTM_INQ_DB_INDEX_SIZE);
+
+  /* There are more slots than entries, a free one is always found */
+  while (p_inq->inq_db_index[slot] != 0)
+    slot = (slot + 1) % BTM_INQ_DB_INDEX_SIZE;
+  p_inq->inq_db_index[slot] = (uint8_t)(inx + 1);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_rebuild_index
+ *
+ * Description      This function rebuilds the hash index of the inquiry
+ *                  database. It has to be called whenever entries are released
+ *                  or moved.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_inq_db_rebuild_index(void) {
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+
+  memset(p_inq->inq_db_index, 0, sizeof(p_inq->inq_db_index));
+  for (uint16_t xx = 0; xx < BTM_INQ_DB_SIZE; xx++) {
+    if (p_inq->inq_db[xx].in_use) btm_inq_db_index_add(xx);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         btm_clr_inq_db
@@ -1140,6 +1184,7 @@ void btm_clr_inq_db(const RawAddress* p_bda) {
       }
     }
   }
+  btm_inq_db_rebuild_index();
 #if (BTM_INQ_DEBUG == TRUE)
   BTM_TRACE_DEBUG("inq_active:0x%x state:%d", btm_cb.btm_inq_vars.inq_active,
                   btm_cb.btm_inq_vars.state);
@@ -1176,21 +1221,27 @@ void btm_clr_inq_result_flt(void) {
  ******************************************************************************/
 bool btm_inq_find_bdaddr(const RawAddress& p_bda) {
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
-  tINQ_BDADDR* p_db = &p_inq->p_bd_db[0];
-  uint16_t xx;
+  tINQ_BDADDR* p_db = p_inq->p_bd_db;
 
   /* Don't bother searching, database doesn't exist or periodic mode */
   if ((p_inq->inq_active & BTM_PERIODIC_INQUIRY_ACTIVE) || !p_db)
     return (false);
 
-  for (xx = 0; xx < p_inq->num_bd_entries; xx++, p_db++) {
-    if (p_db->bd_addr == p_bda && p_db->inq_count == p_inq->inq_counter)
-      return (true);
+  /* The table is never full, probing ends on an empty slot */
+  size_t slot = btm_inq_bdaddr_hash(p_bda, BTM_INQ_BDADDR_DB_SIZE);
+  while (!p_db[slot].bd_addr.IsEmpty()) {
+    if (p_db[slot].bd_addr == p_bda) {
+      if (p_db[slot].inq_count == p_inq->inq_counter) return (true);
+
+      p_db[slot].inq_count = p_inq->inq_counter;
+      return (false);
+    }
+    slot = (slot + 1) % BTM_INQ_BDADDR_DB_SIZE;
   }
 
-  if (xx < p_inq->max_bd_entries) {
-    p_db->inq_count = p_inq->inq_counter;
-    p_db->bd_addr = p_bda;
+  if (p_inq->num_bd_entries < p_inq->max_bd_entries) {
+    p_db[slot].inq_count = p_inq->inq_counter;
+    p_db[slot].bd_addr = p_bda;
     p_inq->num_bd_entries++;
   }
 
@@ -1209,12 +1260,17 @@ bool btm_inq_find_bdaddr(const RawAddress& p_bda) {
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+  size_t slot = btm_inq_bdaddr_hash(p_bda, BTM_INQ_DB_INDEX_SIZE);
 
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
+  for (uint16_t xx = 0; xx < BTM_INQ_DB_INDEX_SIZE; xx++) {
+    uint8_t inx = p_inq->inq_db_index[slot];
+    if (inx == 0) break;
+
+    tINQ_DB_ENT* p_ent = &p_inq->inq_db[inx - 1];
     if (p_ent->in_use && p_ent->inq_info.results.remote_bd_addr == p_bda)
       return (p_ent);
+    slot = (slot + 1) % BTM_INQ_DB_INDEX_SIZE;
   }
 
   /* If here, not found */
@@ -1226,8 +1282,8 @@ tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda) {
  * Function         btm_inq_db_new
  *
  * Description      This function looks through the inquiry database for an
- *                  unused entry. If no entry is free, it allocates the oldest
- *                  entry.
+ *                  unused entry. If no entry is free, it allocates the least
+ *                  recently responding entry.
  *
  * Returns          pointer to entry
  *
@@ -1243,6 +1299,7 @@ tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda) {
       memset(p_ent, 0, sizeof(tINQ_DB_ENT));
       p_ent->inq_info.results.remote_bd_addr = p_bda;
       p_ent->in_use = true;
+      btm_inq_db_index_add(xx);
 
       return (p_ent);
     }
@@ -1258,6 +1315,7 @@ tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda) {
   memset(p_old, 0, sizeof(tINQ_DB_ENT));
   p_old->inq_info.results.remote_bd_addr = p_bda;
   p_old->in_use = true;
+  btm_inq_db_rebuild_index();
 
   return (p_old);
 }
@@ -1491,9 +1549,9 @@ static void btm_initiate_inquiry(tBTM_INQUIRY_VAR_ST* p_inq) {
     btm_clr_inq_result_flt();
 
     /* Allocate memory to hold bd_addrs responding */
-    p_inq->p_bd_db = (tINQ_BDADDR*)osi_calloc(BT_DEFAULT_BUFFER_SIZE);
-    p_inq->max_bd_entries =
-        (uint16_t)(BT_DEFAULT_BUFFER_SIZE / sizeof(tINQ_BDADDR));
+    p_inq->p_bd_db = (tINQ_BDADDR*)osi_calloc(BTM_INQ_BDADDR_DB_SIZE *
+                                              sizeof(tINQ_BDADDR));
+    p_inq->max_bd_entries = BTM_INQ_BDADDR_DB_MAX_ENTRIES;
 
     btsnd_hcic_inquiry(*lap, p_inqparms->duration, 0);
   }
@@ -1669,6 +1727,14 @@ void btm_process_inq_results(uint8_t* p, uint8_t hci_evt_len,
       p_cur->dev_class[2] = dc[2];
       p_cur->clock_offset = clock_offset | BTM_CLOCK_OFFSET_VALID;
 
+      /* keep the paging parameters of a known device for its next connection,
+       * after this inquiry result is gone */
+      tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(bda);
+      if (p_dev_rec != NULL) {
+        p_dev_rec->page_scan_rep_mode = page_scan_rep_mode;
+        p_dev_rec->clock_offset = p_cur->clock_offset;
+      }
+
       p_i->time_of_resp = bluetooth::common::time_get_os_boottime_ms();
 
       if (p_i->inq_count != p_inq->inq_counter)
@@ -1729,34 +1795,23 @@ void btm_process_inq_results(uint8_t* p, uint8_t hci_evt_len,
  * Function         btm_sort_inq_result
  *
  * Description      This function is called when inquiry complete is received
- *                  from the device to sort inquiry results based on rssi.
+ *                  from the device to sort inquiry results based on rssi, so
+ *                  that BTM_InqDbFirst and BTM_InqDbNext walk the used entries
+ *                  from the strongest to the weakest.
  *
  * Returns          void
  *
  ******************************************************************************/
 void btm_sort_inq_result(void) {
-  uint8_t xx, yy, num_resp;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-  tINQ_DB_ENT* p_next = btm_cb.btm_inq_vars.inq_db + 1;
-  int size;
-  tINQ_DB_ENT* p_tmp = (tINQ_DB_ENT*)osi_malloc(sizeof(tINQ_DB_ENT));
-
-  num_resp = (btm_cb.btm_inq_vars.inq_cmpl_info.num_resp < BTM_INQ_DB_SIZE)
-                 ? btm_cb.btm_inq_vars.inq_cmpl_info.num_resp
-                 : BTM_INQ_DB_SIZE;
-
-  size = sizeof(tINQ_DB_ENT);
-  for (xx = 0; xx < num_resp - 1; xx++, p_ent++) {
-    for (yy = xx + 1, p_next = p_ent + 1; yy < num_resp; yy++, p_next++) {
-      if (p_ent->inq_info.results.rssi < p_next->inq_info.results.rssi) {
-        memcpy(p_tmp, p_next, size);
-        memcpy(p_next, p_ent, size);
-        memcpy(p_ent, p_tmp, size);
-      }
-    }
-  }
+  tINQ_DB_ENT* p_db = btm_cb.btm_inq_vars.inq_db;
 
-  osi_free(p_tmp);
+  std::sort(p_db, p_db + BTM_INQ_DB_SIZE,
+            [](const tINQ_DB_ENT& a, const tINQ_DB_ENT& b) {
+              if (a.in_use != b.in_use) return a.in_use;
+              return a.inq_info.results.rssi > b.inq_info.results.rssi;
+            });
+
+  btm_inq_db_rebuild_index();
 }
 
 /*******************************************************************************
@@ -1898,9 +1953,17 @@ tBTM_STATUS btm_initiate_rem_name(const RawAddress& remote_bda, uint8_t origin,
             p_cur->results.page_scan_mode,
             (uint16_t)(p_cur->results.clock_offset | BTM_CLOCK_OFFSET_VALID));
       } else {
-        /* Otherwise use defaults and mark the clock offset as invalid */
-        btsnd_hcic_rmt_name_req(remote_bda, HCI_PAGE_SCAN_REP_MODE_R1,
-                                HCI_MANDATARY_PAGE_SCAN_MODE, 0);
+        /* Otherwise use what is known of the device, or defaults and mark the
+         * clock offset as invalid */
+        tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(remote_bda);
+        if (p_dev_rec != NULL) {
+          btsnd_hcic_rmt_name_req(remote_bda, p_dev_rec->page_scan_rep_mode,
+                                  HCI_MANDATARY_PAGE_SCAN_MODE,
+                                  p_dev_rec->clock_offset);
+        } else {
+          btsnd_hcic_rmt_name_req(remote_bda, HCI_PAGE_SCAN_REP_MODE_R1,
+                                  HCI_MANDATARY_PAGE_SCAN_MODE, 0);
+        }
       }
 
       p_inq->remname_active = true;
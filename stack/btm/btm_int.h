@@ -73,6 +73,7 @@ extern void btm_event_filter_complete(uint8_t* p);
 extern void btm_inq_stop_on_ssp(void);
 extern void btm_inq_clear_ssp(void);
 extern tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda);
+extern void btm_inq_db_rebuild_index(void);
 extern bool btm_inq_find_bdaddr(const RawAddress& p_bda);
 
 /* Internal functions provided by btm_acl.cc
@@ -142,6 +143,7 @@ extern void btm_pm_proc_cmd_status(uint8_t status);
 extern void btm_pm_proc_mode_change(uint8_t hci_status, uint16_t hci_handle,
                                     uint8_t mode, uint16_t interval);
 extern void btm_pm_proc_ssr_evt(uint8_t* p, uint16_t evt_len);
+extern void btm_pm_proc_traffic(uint16_t hci_handle);
 extern tBTM_STATUS btm_read_power_mode_state(const RawAddress& remote_bda,
                                              tBTM_PM_STATE* pmState);
 extern void btm_sco_chk_pend_unpark(uint8_t hci_status, uint16_t hci_handle);
@@ -149,6 +151,15 @@ extern void btm_qos_setup_timeout(void* data);
 extern void btm_qos_setup_complete(uint8_t status, uint16_t handle,
                                    FLOW_SPEC* p_flow);
 
+/* Internal functions provided by btm_link_quality.cc
+ *****************************************************
+*/
+extern void btm_lq_init(void);
+extern void btm_lq_free(void);
+extern void btm_lq_schedule(void);
+extern void btm_lq_energy_sample(uint32_t tx_time_ms, uint32_t rx_time_ms,
+                                 uint32_t idle_time_ms, uint32_t energy_used);
+
 /* Internal functions provided by btm_sco.cc
  *******************************************
 */
@@ -207,6 +218,7 @@ extern void wipe_secrets_and_remove(tBTM_SEC_DEV_REC* p_dev_rec);
 extern tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr);
 extern tBTM_SEC_DEV_REC* btm_find_or_alloc_dev(const RawAddress& bd_addr);
 extern tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle);
+extern tBTM_SEC_DEV_REC* btm_dev_rec_touch(tBTM_SEC_DEV_REC* p_dev_rec);
 extern tBTM_BOND_TYPE btm_get_bond_type_dev(const RawAddress& bd_addr);
 extern bool btm_set_bond_type_dev(const RawAddress& bd_addr,
                                   tBTM_BOND_TYPE bond_type);
@@ -256,6 +268,8 @@ extern void btm_sec_link_key_notification(const RawAddress& p_bda,
 extern void btm_sec_link_key_request(const RawAddress& p_bda);
 extern void btm_sec_pin_code_request(const RawAddress& p_bda);
 extern void btm_sec_update_clock_offset(uint16_t handle, uint16_t clock_offset);
+extern void btm_sec_update_page_scan_rep_mode(const RawAddress& bd_addr,
+                                              uint8_t page_scan_rep_mode);
 extern void btm_sec_dev_rec_cback_event(tBTM_SEC_DEV_REC* p_dev_rec,
                                         uint8_t res, bool is_le_trasnport);
 extern void btm_sec_set_peer_sec_caps(tACL_CONN* p_acl_cb,
@@ -18,10 +18,13 @@
 #ifndef BTM_INT_TYPES_H
 #define BTM_INT_TYPES_H
 
+#include <unordered_map>
+
 #include "btif/include/btif_bqr.h"
 #include "btm_api_types.h"
 #include "btm_ble_api_types.h"
 #include "btm_ble_int_types.h"
+#include "common/raw_address_flat_map.h"
 #include "hcidefs.h"
 #include "osi/include/alarm.h"
 #include "osi/include/list.h"
@@ -106,9 +109,43 @@ typedef struct {
   uint8_t active_remote_addr_type; /* local device address type for this
                                       connection */
   BD_FEATURES peer_le_features; /* Peer LE Used features mask for the device */
+  uint8_t le_tx_phy; /* LE PHYs in use, as in the PHY Update Complete event */
+  uint8_t le_rx_phy;
+  bool le_link_policy; /* LE link policy asked for the maximum data length */
+
+  /* link quality aggregates, see btm_link_quality.cc */
+  uint32_t lq_rssi_time_ms; /* time of the last RSSI sample, 0 if none */
+  int16_t lq_rssi_avg_x16;  /* moving average of the RSSI, in 1/16 dBm */
+  int8_t lq_rssi;
+  uint32_t lq_retransmissions;
+  uint32_t lq_naks;
+  uint32_t lq_lsto_time_ms; /* time of the last approaching LSTO report */
 
 } tACL_CONN;
 
+/* number of samples kept by the link quality sampling */
+#define BTM_LQ_NUM_SAMPLES 64
+
+/* Define the link quality sampling control structure, see
+ * btm_link_quality.cc */
+typedef struct {
+  bool enabled;
+  alarm_t* timer;
+  uint8_t next_link; /* acl_db index of the next link to read the RSSI of */
+
+  tBTM_LQ_SAMPLE samples[BTM_LQ_NUM_SAMPLES];
+  uint32_t num_samples; /* total, the ring keeps the last BTM_LQ_NUM_SAMPLES */
+
+  /* controller energy info, totals as last reported and since the sampling
+   * started */
+  bool energy_valid;
+  uint32_t last_tx_time_ms;
+  uint32_t last_rx_time_ms;
+  uint32_t last_idle_time_ms;
+  uint32_t last_energy_used;
+  tBTM_CONTROLLER_ACTIVITY activity;
+} tBTM_LQ_CB;
+
 /* Define the Device Management control structure
 */
 typedef struct {
@@ -222,6 +259,15 @@ typedef struct {
   bool scan_rsp;
 } tINQ_DB_ENT;
 
+/* Number of slots of the hash index of |inq_db|, each slot holds the index of
+ * an entry plus one, 0 when the slot is empty */
+#define BTM_INQ_DB_INDEX_SIZE (4 * BTM_INQ_DB_SIZE)
+
+/* Number of slots of the hash table of bdaddrs responding to an inquiry, it is
+ * filled up to BTM_INQ_BDADDR_DB_MAX_ENTRIES to keep probe sequences short */
+#define BTM_INQ_BDADDR_DB_SIZE 512
+#define BTM_INQ_BDADDR_DB_MAX_ENTRIES (BTM_INQ_BDADDR_DB_SIZE * 3 / 4)
+
 enum { INQ_NONE, INQ_GENERAL };
 typedef uint8_t tBTM_INQ_TYPE;
 
@@ -256,10 +302,12 @@ typedef struct {
   uint32_t inq_counter; /* Counter incremented each time an inquiry completes */
   /* Used for determining whether or not duplicate devices */
   /* have responded to the same inquiry */
-  tINQ_BDADDR* p_bd_db;    /* Pointer to memory that holds bdaddrs */
+  tINQ_BDADDR* p_bd_db;    /* Hash table of bdaddrs responding, indexed by
+                              btm_inq_bdaddr_hash() */
   uint16_t num_bd_entries; /* Number of entries in database */
   uint16_t max_bd_entries; /* Maximum number of entries that can be stored */
   tINQ_DB_ENT inq_db[BTM_INQ_DB_SIZE];
+  uint8_t inq_db_index[BTM_INQ_DB_INDEX_SIZE]; /* Hash index of |inq_db| */
   tBTM_INQ_PARMS inqparms; /* Contains the parameters for the current inquiry */
   tBTM_INQUIRY_CMPL
       inq_cmpl_info; /* Status and number of responses from the last inquiry */
@@ -442,6 +490,8 @@ typedef struct {
 #define BTM_BLE_ADDR_RRA 1    /* cur_rand_addr */
 #define BTM_BLE_ADDR_STATIC 2 /* static_addr  */
   uint8_t active_addr_type;
+  /* last time the device was seen, for resolving list replacement */
+  uint64_t rl_active_ms;
 #endif
 
   tBTM_LE_KEY_TYPE key_type; /* bit mask of valid key types in record */
@@ -461,10 +511,12 @@ typedef struct {
   tBTM_SEC_CALLBACK* p_callback;
   void* p_ref_data;
   uint32_t timestamp; /* Timestamp of the last connection   */
+  uint64_t last_used; /* btm_cb.dev_rec_use_count when last found */
   uint32_t trusted_mask[BTM_SEC_SERVICE_ARRAY_SIZE]; /* Bitwise OR of trusted
                                                         services     */
   uint16_t hci_handle;     /* Handle to connection when exists   */
   uint16_t clock_offset;   /* Latest known clock offset          */
+  uint8_t page_scan_rep_mode; /* Latest known page scan repetition mode */
   RawAddress bd_addr;      /* BD_ADDR of the device              */
   DEV_CLASS dev_class;     /* DEV_CLASS of the device            */
   LinkKey link_key;        /* Device link key                    */
@@ -603,6 +655,9 @@ enum {
 };
 typedef uint8_t tBTM_PM_STATE;
 
+/* number of modes tracked by the time in mode statistics */
+#define BTM_PM_NUM_MODES (BTM_PM_ST_PARK + 1)
+
 enum {
   BTM_PM_SET_MODE_EVT, /* Set power mode API is called. */
   BTM_PM_UPDATE_EVT,
@@ -646,6 +701,19 @@ typedef struct {
 #endif
   tBTM_PM_STATE state; /* contains the current mode of the connection */
   bool chg_ind;        /* a request change indication */
+
+  /* ACL traffic of the link, see btm_pm_proc_traffic() */
+  uint64_t last_pkt_us; /* time of the last ACL packet sent or received */
+  uint32_t avg_gap_us;  /* moving average of the ACL packet interval */
+
+  /* power mode statistics, see BTM_PmDebugDump() */
+  tBTM_PM_MODE stats_mode; /* last mode reported by the controller */
+  uint64_t mode_since_us;  /* time the link entered stats_mode */
+  uint64_t time_in_mode_us[BTM_PM_NUM_MODES];
+  uint64_t req_sent_us; /* time the pending mode command was sent, or 0 */
+  uint32_t num_transitions;   /* mode changes requested by the host */
+  uint64_t transition_us;     /* sum of the mode change latencies */
+  uint64_t max_transition_us; /* longest mode change latency */
 } tBTM_PM_MCB;
 
 #define BTM_PM_REC_NOT_USED 0
@@ -750,6 +818,11 @@ typedef struct {
   uint8_t pm_pend_link; /* the index of acl_db, which has a pending PM cmd */
   uint8_t pm_pend_id;   /* the id pf the module, which has a pending PM cmd */
 
+  /*****************************************************
+  **      Link quality sampling
+  *****************************************************/
+  tBTM_LQ_CB lq_cb;
+
   /*****************************************************
   **      Device control
   *****************************************************/
@@ -792,6 +865,7 @@ typedef struct {
   alarm_t* sec_collision_timer;
   uint64_t collision_start_time;
   uint32_t dev_rec_count; /* Counter used for device record timestamp */
+  uint64_t dev_rec_use_count; /* Counter of the device record lookups */
   uint8_t security_mode;
   bool pairing_disabled;
   bool connect_only_paired;
@@ -809,6 +883,16 @@ typedef struct {
   uint8_t disc_reason;              /* for legacy devices */
   tBTM_SEC_SERV_REC sec_serv_rec[BTM_SEC_MAX_SERVICE_RECORDS];
   list_t* sec_dev_rec; /* list of tBTM_SEC_DEV_REC */
+  /* Records of |sec_dev_rec| by the addresses they were found by, see
+   * btm_find_dev() */
+  bluetooth::common::RawAddressFlatMap<tBTM_SEC_DEV_REC*>* sec_dev_index;
+  /* Records of |sec_dev_rec| by their LE identity address, see
+   * btm_find_dev_by_identity_addr() */
+  bluetooth::common::RawAddressFlatMap<tBTM_SEC_DEV_REC*>*
+      sec_dev_identity_index;
+  /* Records of |sec_dev_rec| by their BR/EDR or LE connection handle, see
+   * btm_find_dev_by_handle() */
+  std::unordered_map<uint16_t, tBTM_SEC_DEV_REC*>* sec_dev_handle_index;
   tBTM_SEC_SERV_REC* p_out_serv;
   tBTM_MKEY_CALLBACK* mkey_cback;
 
@@ -0,0 +1,904 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the ISO channel manager: CIG and BIG setup, and the
+ *  ISO data path of their CIS and BIS.
+ *
+ *  SDUs are queued per stream in buffers taken from a pool, and fragmented
+ *  into HCI ISO data packets as the controller returns ISO buffers. Each SDU
+ *  gets the sequence number of the SDU interval it is sent in, and once the
+ *  controller clock was read with LE Read ISO TX Sync, the matching time
+ *  stamp, so that the controller schedules it on that interval.
+ *
+ ******************************************************************************/
+
+#include <base/bind.h>
+#include <base/logging.h>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+
+#include "bt_target.h"
+#include "bt_types.h"
+#include "btm_iso_api.h"
+#include "btu.h"
+#include "common/time_util.h"
+#include "hcidefs.h"
+#include "hcimsgs.h"
+#include "osi/include/allocator.h"
+
+using bluetooth::hci::iso_manager::big_create_params;
+using bluetooth::hci::iso_manager::cig_create_params;
+using bluetooth::hci::iso_manager::cis_cfg;
+using bluetooth::hci::iso_manager::IsoCallbacks;
+using bluetooth::hci::iso_manager::iso_data_path_params;
+
+namespace bluetooth {
+namespace hci {
+
+namespace {
+
+constexpr uint16_t kIsoPreambleSize = 4;
+constexpr uint16_t kIsoSduHeaderSize = 4;
+constexpr uint16_t kIsoTimestampSize = 4;
+constexpr uint16_t kIsoMaxSduSize = 0x0FFF;
+
+/* Packet_Boundary_Flag of HCI ISO data packets */
+constexpr uint8_t kIsoPbFirst = 0x00;
+constexpr uint8_t kIsoPbContinuation = 0x01;
+constexpr uint8_t kIsoPbComplete = 0x02;
+constexpr uint8_t kIsoPbLast = 0x03;
+
+/* SDUs queued on a stream: older ones are dropped, late audio is useless */
+constexpr size_t kMaxQueuedSdus = 8;
+/* SDU buffers kept for reuse */
+constexpr size_t kMaxPooledSdus = 32;
+
+/* Fixed part of the LE Set CIG Parameters command, and per CIS */
+constexpr uint8_t kCigParamsLen = 15;
+constexpr uint8_t kCisCfgLen = 9;
+constexpr uint8_t kCreateBigLen = 31;
+
+}  // namespace
+
+struct IsoManager::impl {
+  struct Sdu {
+    std::vector<uint8_t> data;
+    size_t offset;
+    uint16_t seq_nb;
+    bool has_timestamp;
+    uint32_t timestamp;
+  };
+
+  struct Stream {
+    uint8_t group_id;
+    bool is_cis;
+    bool established;
+    uint8_t data_paths; /* bit per iso_data_path direction */
+    uint32_t sdu_itv_us;
+
+    /* TX: the SDU interval of |next_seq| is found from the host clock, and
+     * its time stamp from the controller clock once |ctrl_synced| */
+    bool tx_started;
+    uint64_t host_anchor_us;
+    uint16_t host_anchor_seq;
+    uint16_t next_seq;
+    bool sync_requested;
+    bool ctrl_synced;
+    uint32_t ctrl_anchor_ts;
+    uint16_t ctrl_anchor_seq;
+    std::deque<std::unique_ptr<Sdu>> tx_queue;
+    uint16_t sent_not_acked;
+
+    /* RX: fragments of the SDU being received, the capacity is kept */
+    bool rx_in_progress;
+    uint16_t rx_seq;
+    uint32_t rx_ts;
+    uint8_t rx_status;
+    std::vector<uint8_t> rx_sdu;
+  };
+
+  IsoCallbacks* callbacks = nullptr;
+  bool running = false;
+
+  uint16_t iso_buf_len = 0;
+  uint16_t iso_credits = 0;
+
+  /* Streams by CIS or BIS handle, and SDU interval of the groups being
+   * created */
+  std::map<uint16_t, Stream> streams;
+  std::map<uint8_t, uint32_t> pending_cig_itv;
+  std::map<uint8_t, uint32_t> pending_big_itv;
+  uint16_t last_served_handle = 0;
+
+  std::vector<std::unique_ptr<Sdu>> sdu_pool;
+
+  static uint8_t ReadStatus(uint8_t* p, uint16_t len) {
+    if (len < 1) return HCI_ERR_UNSPECIFIED;
+    return *p;
+  }
+
+  void Start(IsoCallbacks* cbs) {
+    callbacks = cbs;
+    running = true;
+
+    btu_hcif_send_cmd_with_cb(
+        FROM_HERE, HCI_LE_READ_BUFFER_SIZE_V2, nullptr, 0,
+        base::Bind(&impl::OnReadBufferSize, base::Unretained(this)));
+  }
+
+  void OnReadBufferSize(uint8_t* p, uint16_t len) {
+    uint8_t status, acl_count, iso_count;
+    uint16_t acl_len;
+
+    if (len < 7 || ReadStatus(p, len) != HCI_SUCCESS) {
+      LOG(ERROR) << __func__ << ": ISO not supported by the controller";
+      return;
+    }
+
+    STREAM_TO_UINT8(status, p);
+    STREAM_TO_UINT16(acl_len, p);
+    STREAM_TO_UINT8(acl_count, p);
+    STREAM_TO_UINT16(iso_buf_len, p);
+    STREAM_TO_UINT8(iso_count, p);
+    iso_credits = iso_count;
+
+    LOG(INFO) << __func__ << " iso_buf_len: " << +iso_buf_len
+              << ", iso_buf_count: " << +iso_count;
+  }
+
+  void Stop() {
+    running = false;
+    callbacks = nullptr;
+    for (auto& entry : streams) ReleaseStream(entry.second);
+    streams.clear();
+    pending_cig_itv.clear();
+    pending_big_itv.clear();
+  }
+
+  std::unique_ptr<Sdu> AcquireSdu() {
+    if (sdu_pool.empty()) return std::make_unique<Sdu>();
+
+    std::unique_ptr<Sdu> sdu = std::move(sdu_pool.back());
+    sdu_pool.pop_back();
+    return sdu;
+  }
+
+  void ReleaseSdu(std::unique_ptr<Sdu> sdu) {
+    if (sdu_pool.size() >= kMaxPooledSdus) return;
+    sdu->data.clear();
+    sdu_pool.push_back(std::move(sdu));
+  }
+
+  /* Returns the buffers of |stream| to the pool and the controller buffers
+   * it held to the credits: they are flushed along with the stream */
+  void ReleaseStream(Stream& stream) {
+    while (!stream.tx_queue.empty()) {
+      ReleaseSdu(std::move(stream.tx_queue.front()));
+      stream.tx_queue.pop_front();
+    }
+    iso_credits += stream.sent_not_acked;
+    stream.sent_not_acked = 0;
+    stream.rx_in_progress = false;
+    stream.rx_sdu.clear();
+  }
+
+  void AddStream(uint16_t handle, uint8_t group_id, bool is_cis,
+                 uint32_t sdu_itv_us) {
+    Stream& stream = streams[handle];
+    stream = Stream{};
+    stream.group_id = group_id;
+    stream.is_cis = is_cis;
+    stream.established = !is_cis;
+    stream.sdu_itv_us = sdu_itv_us;
+  }
+
+  void RemoveGroupStreams(uint8_t group_id, bool is_cis) {
+    for (auto it = streams.begin(); it != streams.end();) {
+      if (it->second.group_id != group_id || it->second.is_cis != is_cis) {
+        it++;
+        continue;
+      }
+      ReleaseStream(it->second);
+      it = streams.erase(it);
+    }
+  }
+
+  void CreateCig(uint8_t cig_id, cig_create_params params) {
+    size_t cis_count = params.cis_cfgs.size();
+    if (cis_count == 0 || kCigParamsLen + cis_count * kCisCfgLen > 255) {
+      LOG(ERROR) << __func__ << ": bad CIS count " << cis_count;
+      if (callbacks) callbacks->OnCigCreated(HCI_ERR_ILLEGAL_PARAMETER_FMT,
+                                             cig_id, {});
+      return;
+    }
+
+    uint8_t param_len = kCigParamsLen + cis_count * kCisCfgLen;
+    std::vector<uint8_t> param(param_len);
+    uint8_t* pp = param.data();
+    UINT8_TO_STREAM(pp, cig_id);
+    UINT24_TO_STREAM(pp, params.sdu_itv_mtos);
+    UINT24_TO_STREAM(pp, params.sdu_itv_stom);
+    UINT8_TO_STREAM(pp, params.sca);
+    UINT8_TO_STREAM(pp, params.packing);
+    UINT8_TO_STREAM(pp, params.framing);
+    UINT16_TO_STREAM(pp, params.max_trans_lat_mtos);
+    UINT16_TO_STREAM(pp, params.max_trans_lat_stom);
+    UINT8_TO_STREAM(pp, cis_count);
+    for (const cis_cfg& cis : params.cis_cfgs) {
+      UINT8_TO_STREAM(pp, cis.cis_id);
+      UINT16_TO_STREAM(pp, cis.max_sdu_size_mtos);
+      UINT16_TO_STREAM(pp, cis.max_sdu_size_stom);
+      UINT8_TO_STREAM(pp, cis.phy_mtos);
+      UINT8_TO_STREAM(pp, cis.phy_stom);
+      UINT8_TO_STREAM(pp, cis.rtn_mtos);
+      UINT8_TO_STREAM(pp, cis.rtn_stom);
+    }
+
+    pending_cig_itv[cig_id] = params.sdu_itv_mtos;
+    btu_hcif_send_cmd_with_cb(
+        FROM_HERE, HCI_LE_SET_CIG_PARAMS, param.data(), param_len,
+        base::Bind(&impl::OnCigCreated, base::Unretained(this), cig_id));
+  }
+
+  void OnCigCreated(uint8_t cig_id, uint8_t* p, uint16_t len) {
+    uint8_t status = ReadStatus(p, len);
+    uint8_t evt_cig_id, cis_count;
+    std::vector<uint16_t> cis_handles;
+
+    uint32_t sdu_itv = pending_cig_itv[cig_id];
+    pending_cig_itv.erase(cig_id);
+
+    if (status == HCI_SUCCESS && len >= 3) {
+      STREAM_SKIP_UINT8(p);
+      STREAM_TO_UINT8(evt_cig_id, p);
+      STREAM_TO_UINT8(cis_count, p);
+      if (cis_count > (len - 3) / 2) cis_count = (len - 3) / 2;
+
+      for (uint8_t i = 0; i < cis_count; i++) {
+        uint16_t handle;
+        STREAM_TO_UINT16(handle, p);
+        cis_handles.push_back(handle);
+        AddStream(handle, evt_cig_id, true, sdu_itv);
+      }
+    }
+
+    if (callbacks) callbacks->OnCigCreated(status, cig_id, cis_handles);
+  }
+
+  void RemoveCig(uint8_t cig_id) {
+    btu_hcif_send_cmd_with_cb(
+        FROM_HERE, HCI_LE_REMOVE_CIG, &cig_id, 1,
+        base::Bind(&impl::OnCigRemoved, base::Unretained(this), cig_id));
+  }
+
+  void OnCigRemoved(uint8_t cig_id, uint8_t* p, uint16_t len) {
+    uint8_t status = ReadStatus(p, len);
+    if (status == HCI_SUCCESS) RemoveGroupStreams(cig_id, true);
+    if (callbacks) callbacks->OnCigRemoved(status, cig_id);
+  }
+
+  void EstablishCis(std::vector<std::pair<uint16_t, uint16_t>> conn_pairs) {
+    if (conn_pairs.empty() || 1 + conn_pairs.size() * 4 > 255) {
+      LOG(ERROR) << __func__ << ": bad CIS count " << conn_pairs.size();
+      return;
+    }
+
+    uint8_t param_len = 1 + conn_pairs.size() * 4;
+    std::vector<uint8_t> param(param_len);
+    uint8_t* pp = param.data();
+    UINT8_TO_STREAM(pp, conn_pairs.size());
+    for (const auto& conn_pair : conn_pairs) {
+      UINT16_TO_STREAM(pp, conn_pair.first);
+      UINT16_TO_STREAM(pp, conn_pair.second);
+    }
+
+    /* Only a failure is reported here, the CISes report to OnCisEstablished */
+    btu_hcif_send_cmd_with_cb(
+        FROM_HERE, HCI_LE_CREATE_CIS, param.data(), param_len,
+        base::Bind(&impl::OnCreateCisFailed, base::Unretained(this),
+                   std::move(conn_pairs)));
+  }
+
+  void OnCreateCisFailed(std::vector<std::pair<uint16_t, uint16_t>> conn_pairs,
+                         uint8_t* p, uint16_t len) {
+    uint8_t status = ReadStatus(p, len);
+    LOG(ERROR) << __func__ << ": create CIS failed, status: " << loghex(status);
+    if (!callbacks) return;
+
+    for (const auto& conn_pair : conn_pairs) {
+      callbacks->OnCisEstablished(status, conn_pair.first, 0, 0);
+    }
+  }
+
+  void DisconnectCis(uint16_t cis_handle, uint8_t reason) {
+    auto it = streams.find(cis_handle);
+    if (it == streams.end() || !it->second.is_cis) {
+      LOG(ERROR) << __func__ << ": unknown CIS " << loghex(cis_handle);
+      return;
+    }
+
+    btsnd_hcic_disconnect(cis_handle, reason);
+  }
+
+  void CreateBig(uint8_t big_id, big_create_params params) {
+    uint8_t param[kCreateBigLen];
+    uint8_t* pp = param;
+    UINT8_TO_STREAM(pp, big_id);
+    UINT8_TO_STREAM(pp, params.adv_handle);
+    UINT8_TO_STREAM(pp, params.num_bis);
+    UINT24_TO_STREAM(pp, params.sdu_itv);
+    UINT16_TO_STREAM(pp, params.max_sdu_size);
+    UINT16_TO_STREAM(pp, params.max_transport_latency);
+    UINT8_TO_STREAM(pp, params.rtn);
+    UINT8_TO_STREAM(pp, params.phy);
+    UINT8_TO_STREAM(pp, params.packing);
+    UINT8_TO_STREAM(pp, params.framing);
+    UINT8_TO_STREAM(pp, params.enc);
+    memcpy(pp, params.enc_code.data(), params.enc_code.size());
+
+    pending_big_itv[big_id] = params.sdu_itv;
+    btu_hcif_send_cmd_with_cb(
+        FROM_HERE, HCI_LE_CREATE_BIG, param, kCreateBigLen,
+        base::Bind(&impl::OnCreateBigFailed, base::Unretained(this), big_id));
+  }
+
+  void OnCreateBigFailed(uint8_t big_id, uint8_t* p, uint16_t len) {
+    uint8_t status = ReadStatus(p, len);
+    LOG(ERROR) << __func__ << ": create BIG failed, status: " << loghex(status);
+    pending_big_itv.erase(big_id);
+    if (callbacks) callbacks->OnBigCreated(status, big_id, {});
+  }
+
+  void TerminateBig(uint8_t big_id, uint8_t reason) {
+    uint8_t param[2] = {big_id, reason};
+    btu_hcif_send_cmd_with_cb(
+        FROM_HERE, HCI_LE_TERM_BIG, param, sizeof(param),
+        base::Bind(
+            [](uint8_t big_id, uint8_t* p, uint16_t len) {
+              LOG(ERROR) << "terminate BIG " << +big_id << " failed, status: "
+                         << loghex(ReadStatus(p, len));
+            },
+            big_id));
+  }
+
+  void SetupIsoDataPath(uint16_t iso_handle, iso_data_path_params params) {
+    if (params.codec_conf.size() > 255 - 13) {
+      LOG(ERROR) << __func__ << ": codec configuration too long";
+      if (callbacks) {
+        callbacks->OnIsoDataPathSetup(HCI_ERR_ILLEGAL_PARAMETER_FMT,
+                                      iso_handle);
+      }
+      return;
+    }
+
+    uint8_t param_len = 13 + params.codec_conf.size();
+    std::vector<uint8_t> param(param_len);
+    uint8_t* pp = param.data();
+    UINT16_TO_STREAM(pp, iso_handle);
+    UINT8_TO_STREAM(pp, params.data_path_dir);
+    UINT8_TO_STREAM(pp, params.data_path_id);
+    UINT8_TO_STREAM(pp, params.codec_id_format);
+    UINT16_TO_STREAM(pp, params.codec_id_company);
+    UINT16_TO_STREAM(pp, params.codec_id_vendor);
+    UINT24_TO_STREAM(pp, params.controller_delay);
+    UINT8_TO_STREAM(pp, params.codec_conf.size());
+    if (!params.codec_conf.empty()) {
+      memcpy(pp, params.codec_conf.data(), params.codec_conf.size());
+    }
+
+    btu_hcif_send_cmd_with_cb(
+        FROM_HERE, HCI_LE_SETUP_ISO_DATA_PATH, param.data(), param_len,
+        base::Bind(&impl::OnIsoDataPathSetup, base::Unretained(this),
+                   iso_handle, params.data_path_dir));
+  }
+
+  void OnIsoDataPathSetup(uint16_t iso_handle, uint8_t data_path_dir,
+                          uint8_t* p, uint16_t len) {
+    uint8_t status = ReadStatus(p, len);
+    auto it = streams.find(iso_handle);
+    if (status == HCI_SUCCESS && it != streams.end()) {
+      it->second.data_paths |= 1 << data_path_dir;
+    }
+    if (callbacks) callbacks->OnIsoDataPathSetup(status, iso_handle);
+  }
+
+  void RemoveIsoDataPath(uint16_t iso_handle, uint8_t data_path_dir) {
+    uint8_t param[3];
+    uint8_t* pp = param;
+    UINT16_TO_STREAM(pp, iso_handle);
+    /* The command takes a bit per direction */
+    UINT8_TO_STREAM(pp, 1 << data_path_dir);
+
+    auto it = streams.find(iso_handle);
+    if (it != streams.end()) it->second.data_paths &= ~(1 << data_path_dir);
+
+    btu_hcif_send_cmd_with_cb(
+        FROM_HERE, HCI_LE_REMOVE_ISO_DATA_PATH, param, sizeof(param),
+        base::Bind([](uint8_t* p, uint16_t len) {
+          uint8_t status = ReadStatus(p, len);
+          if (status != HCI_SUCCESS) {
+            LOG(ERROR) << "remove ISO data path failed, status: "
+                       << loghex(status);
+          }
+        }));
+  }
+
+  /* Gives |sdu| the sequence number of the SDU interval it is sent in, never
+   * going back, and the matching controller time stamp when known */
+  void StampSdu(Stream& stream, Sdu& sdu) {
+    uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+    if (!stream.tx_started) {
+      stream.tx_started = true;
+      stream.host_anchor_us = now_us;
+      stream.host_anchor_seq = stream.next_seq;
+    }
+
+    uint16_t seq = stream.next_seq;
+    if (stream.sdu_itv_us) {
+      uint64_t itv_idx = (now_us - stream.host_anchor_us +
+                          stream.sdu_itv_us / 2) / stream.sdu_itv_us;
+      uint16_t due_seq = stream.host_anchor_seq + (uint16_t)itv_idx;
+      /* The intervals the application missed are skipped */
+      if ((int16_t)(due_seq - seq) > 0) seq = due_seq;
+    }
+
+    sdu.seq_nb = seq;
+    stream.next_seq = seq + 1;
+
+    sdu.has_timestamp = stream.ctrl_synced;
+    if (stream.ctrl_synced) {
+      uint16_t delta = seq - stream.ctrl_anchor_seq;
+      sdu.timestamp = stream.ctrl_anchor_ts + delta * stream.sdu_itv_us;
+    }
+  }
+
+  void SendIsoData(uint16_t iso_handle, const uint8_t* data, uint16_t len) {
+    auto it = streams.find(iso_handle);
+    if (it == streams.end() || !it->second.established) {
+      LOG(WARNING) << __func__ << ": no ISO stream " << loghex(iso_handle);
+      return;
+    }
+
+    if (iso_buf_len <= kIsoSduHeaderSize + kIsoTimestampSize ||
+        len > kIsoMaxSduSize) {
+      LOG(ERROR) << __func__ << ": can't send SDU of " << +len << " bytes";
+      return;
+    }
+
+    Stream& stream = it->second;
+    std::unique_ptr<Sdu> sdu = AcquireSdu();
+    sdu->data.assign(data, data + len);
+    sdu->offset = 0;
+    StampSdu(stream, *sdu);
+
+    if (stream.tx_queue.size() >= kMaxQueuedSdus) {
+      VLOG(1) << __func__ << ": dropping late SDU on " << loghex(iso_handle);
+      ReleaseSdu(std::move(stream.tx_queue.front()));
+      stream.tx_queue.pop_front();
+    }
+    stream.tx_queue.push_back(std::move(sdu));
+
+    SendPending();
+  }
+
+  /* Serves the streams in turn, a fragment at a time, while the controller
+   * has ISO buffers */
+  void SendPending() {
+    while (iso_credits > 0) {
+      auto it = streams.upper_bound(last_served_handle);
+      auto start = it;
+      bool found = false;
+      do {
+        if (it == streams.end()) it = streams.begin();
+        if (it == streams.end()) break;
+        if (!it->second.tx_queue.empty()) {
+          found = true;
+          break;
+        }
+        it++;
+      } while (it != start && !(start == streams.end() &&
+                                it == streams.end()));
+      if (!found) return;
+
+      last_served_handle = it->first;
+      SendFragment(it->first, it->second);
+    }
+  }
+
+  void SendFragment(uint16_t handle, Stream& stream) {
+    Sdu& sdu = *stream.tx_queue.front();
+    bool first = sdu.offset == 0;
+    uint16_t header_len = 0;
+    if (first) {
+      header_len = kIsoSduHeaderSize;
+      if (sdu.has_timestamp) header_len += kIsoTimestampSize;
+    }
+
+    uint16_t remaining = sdu.data.size() - sdu.offset;
+    uint16_t frag_len = std::min<uint16_t>(remaining, iso_buf_len - header_len);
+    bool last = frag_len == remaining;
+
+    uint8_t pb;
+    if (first)
+      pb = last ? kIsoPbComplete : kIsoPbFirst;
+    else
+      pb = last ? kIsoPbLast : kIsoPbContinuation;
+
+    uint16_t data_len = header_len + frag_len;
+    BT_HDR* p_buf =
+        (BT_HDR*)osi_malloc(sizeof(BT_HDR) + kIsoPreambleSize + data_len);
+    p_buf->offset = 0;
+    p_buf->len = kIsoPreambleSize + data_len;
+    p_buf->layer_specific = 0;
+
+    uint8_t* pp = p_buf->data;
+    uint16_t handle_flags = handle | (pb << 12);
+    if (first && sdu.has_timestamp) handle_flags |= 1 << 14;
+    UINT16_TO_STREAM(pp, handle_flags);
+    UINT16_TO_STREAM(pp, data_len);
+    if (first) {
+      if (sdu.has_timestamp) UINT32_TO_STREAM(pp, sdu.timestamp);
+      UINT16_TO_STREAM(pp, sdu.seq_nb);
+      UINT16_TO_STREAM(pp, (uint16_t)sdu.data.size());
+    }
+    memcpy(pp, sdu.data.data() + sdu.offset, frag_len);
+    sdu.offset += frag_len;
+
+    iso_credits--;
+    stream.sent_not_acked++;
+    bte_main_hci_send(p_buf, BT_EVT_TO_LM_HCI_ISO);
+
+    if (last) {
+      ReleaseSdu(std::move(stream.tx_queue.front()));
+      stream.tx_queue.pop_front();
+    }
+  }
+
+  void ReadIsoTxSync(uint16_t handle, Stream& stream) {
+    uint8_t param[2];
+    uint8_t* pp = param;
+    UINT16_TO_STREAM(pp, handle);
+
+    stream.sync_requested = true;
+    btu_hcif_send_cmd_with_cb(
+        FROM_HERE, HCI_LE_READ_ISO_TX_SYNC, param, sizeof(param),
+        base::Bind(&impl::OnIsoTxSync, base::Unretained(this), handle));
+  }
+
+  void OnIsoTxSync(uint16_t handle, uint8_t* p, uint16_t len) {
+    uint8_t status = ReadStatus(p, len);
+    auto it = streams.find(handle);
+    if (it == streams.end()) return;
+
+    Stream& stream = it->second;
+    if (status != HCI_SUCCESS || len < 12) {
+      /* Ask again with the next completed packets */
+      stream.sync_requested = false;
+      return;
+    }
+
+    uint32_t time_offset;
+    STREAM_SKIP_UINT8(p);
+    STREAM_SKIP_UINT16(p);
+    STREAM_TO_UINT16(stream.ctrl_anchor_seq, p);
+    STREAM_TO_UINT32(stream.ctrl_anchor_ts, p);
+    STREAM_TO_UINT24(time_offset, p);
+    stream.ctrl_synced = true;
+
+    VLOG(1) << __func__ << " handle: " << loghex(handle)
+            << ", seq: " << stream.ctrl_anchor_seq
+            << ", time stamp: " << stream.ctrl_anchor_ts
+            << ", time offset: " << time_offset;
+  }
+
+  void HandleNumComplDataPkts(uint8_t* p, uint8_t evt_len) {
+    if (streams.empty() || evt_len < 1) return;
+
+    uint8_t num_handles;
+    STREAM_TO_UINT8(num_handles, p);
+    if (num_handles > (evt_len - 1) / 4) num_handles = (evt_len - 1) / 4;
+
+    bool credited = false;
+    for (uint8_t i = 0; i < num_handles; i++) {
+      uint16_t handle, num_sent;
+      STREAM_TO_UINT16(handle, p);
+      STREAM_TO_UINT16(num_sent, p);
+      handle = HCID_GET_HANDLE(handle);
+
+      auto it = streams.find(handle);
+      if (it == streams.end()) continue;
+
+      Stream& stream = it->second;
+      num_sent = std::min(num_sent, stream.sent_not_acked);
+      stream.sent_not_acked -= num_sent;
+      iso_credits += num_sent;
+      credited = true;
+
+      if (!stream.ctrl_synced && !stream.sync_requested) {
+        ReadIsoTxSync(handle, stream);
+      }
+    }
+
+    if (credited) SendPending();
+  }
+
+  /* HCI ISO data packet. An SDU that fits in one packet is passed straight
+   * from it, fragmented ones are gathered in the buffer of the stream. */
+  void HandleIsoData(BT_HDR* p_msg) {
+    uint8_t* p = p_msg->data + p_msg->offset;
+    uint16_t len = p_msg->len;
+    uint16_t handle_flags, data_len;
+
+    if (len < kIsoPreambleSize) return;
+    STREAM_TO_UINT16(handle_flags, p);
+    STREAM_TO_UINT16(data_len, p);
+    data_len &= 0x3FFF;
+    if (data_len > len - kIsoPreambleSize) {
+      LOG(ERROR) << __func__ << ": bogus ISO packet, data_len: " << data_len;
+      return;
+    }
+
+    uint16_t handle = handle_flags & 0x0FFF;
+    uint8_t pb = (handle_flags >> 12) & 0x03;
+    bool has_timestamp = (handle_flags >> 14) & 0x01;
+
+    auto it = streams.find(handle);
+    if (it == streams.end() || !callbacks) return;
+    Stream& stream = it->second;
+
+    if (pb == kIsoPbFirst || pb == kIsoPbComplete) {
+      uint16_t header_len =
+          kIsoSduHeaderSize + (has_timestamp ? kIsoTimestampSize : 0);
+      if (data_len < header_len) return;
+
+      uint32_t timestamp = 0;
+      uint16_t seq_nb, sdu_len_status;
+      if (has_timestamp) STREAM_TO_UINT32(timestamp, p);
+      STREAM_TO_UINT16(seq_nb, p);
+      STREAM_TO_UINT16(sdu_len_status, p);
+      uint8_t status = sdu_len_status >> 14;
+      uint16_t frag_len = data_len - header_len;
+
+      if (stream.rx_in_progress) {
+        VLOG(1) << __func__ << ": incomplete SDU on " << loghex(handle);
+        stream.rx_in_progress = false;
+      }
+
+      if (pb == kIsoPbComplete) {
+        callbacks->OnIsoData(handle, seq_nb, timestamp, status, p, frag_len);
+        return;
+      }
+
+      stream.rx_in_progress = true;
+      stream.rx_seq = seq_nb;
+      stream.rx_ts = timestamp;
+      stream.rx_status = status;
+      stream.rx_sdu.assign(p, p + frag_len);
+      return;
+    }
+
+    if (!stream.rx_in_progress) return;
+
+    if (stream.rx_sdu.size() + data_len > kIsoMaxSduSize) {
+      LOG(ERROR) << __func__ << ": SDU too long on " << loghex(handle);
+      stream.rx_in_progress = false;
+      return;
+    }
+    stream.rx_sdu.insert(stream.rx_sdu.end(), p, p + data_len);
+
+    if (pb == kIsoPbLast) {
+      stream.rx_in_progress = false;
+      callbacks->OnIsoData(handle, stream.rx_seq, stream.rx_ts,
+                           stream.rx_status, stream.rx_sdu.data(),
+                           stream.rx_sdu.size());
+    }
+  }
+
+  void OnCisEstablished(uint8_t* p, uint16_t len) {
+    uint8_t status;
+    uint16_t handle;
+    uint32_t cig_sync_delay, cis_sync_delay, latency_mtos, latency_stom;
+
+    if (len < 15) return;
+    STREAM_TO_UINT8(status, p);
+    STREAM_TO_UINT16(handle, p);
+    STREAM_TO_UINT24(cig_sync_delay, p);
+    STREAM_TO_UINT24(cis_sync_delay, p);
+    STREAM_TO_UINT24(latency_mtos, p);
+    STREAM_TO_UINT24(latency_stom, p);
+
+    auto it = streams.find(handle);
+    if (it == streams.end()) return;
+
+    if (status == HCI_SUCCESS) it->second.established = true;
+    if (callbacks) {
+      callbacks->OnCisEstablished(status, handle, latency_mtos, latency_stom);
+    }
+  }
+
+  /* Only the central role is supported */
+  void OnCisRequest(uint8_t* p, uint16_t len) {
+    uint16_t acl_handle, cis_handle;
+
+    if (len < 4) return;
+    STREAM_TO_UINT16(acl_handle, p);
+    STREAM_TO_UINT16(cis_handle, p);
+    VLOG(1) << __func__ << " rejecting CIS " << loghex(cis_handle)
+            << " of ACL " << loghex(acl_handle);
+
+    uint8_t param[3];
+    uint8_t* pp = param;
+    UINT16_TO_STREAM(pp, cis_handle);
+    UINT8_TO_STREAM(pp, HCI_ERR_HOST_REJECT_RESOURCES);
+    btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_LE_REJ_CIS_REQ, param,
+                              sizeof(param),
+                              base::Bind([](uint8_t* p, uint16_t len) {}));
+  }
+
+  void OnBigCreated(uint8_t* p, uint16_t len) {
+    uint8_t status, big_id, num_bis = 0;
+    std::vector<uint16_t> bis_handles;
+
+    if (len < 2) return;
+    STREAM_TO_UINT8(status, p);
+    STREAM_TO_UINT8(big_id, p);
+
+    uint32_t sdu_itv = pending_big_itv[big_id];
+    pending_big_itv.erase(big_id);
+
+    if (status == HCI_SUCCESS && len >= 18) {
+      /* BIG_Sync_Delay to ISO_Interval */
+      p += 16;
+      STREAM_TO_UINT8(num_bis, p);
+      if (num_bis > (len - 19) / 2) num_bis = (len - 19) / 2;
+
+      for (uint8_t i = 0; i < num_bis; i++) {
+        uint16_t handle;
+        STREAM_TO_UINT16(handle, p);
+        bis_handles.push_back(handle);
+        AddStream(handle, big_id, false, sdu_itv);
+      }
+    }
+
+    if (callbacks) callbacks->OnBigCreated(status, big_id, bis_handles);
+  }
+
+  void OnBigTerminated(uint8_t* p, uint16_t len) {
+    uint8_t big_id, reason;
+
+    if (len < 2) return;
+    STREAM_TO_UINT8(big_id, p);
+    STREAM_TO_UINT8(reason, p);
+
+    RemoveGroupStreams(big_id, false);
+    if (callbacks) callbacks->OnBigTerminated(big_id, reason);
+  }
+
+  void HandleHciEvent(uint8_t sub_code, uint8_t* p, uint16_t len) {
+    if (!running) return;
+
+    switch (sub_code) {
+      case HCI_BLE_CIS_EST_EVT:
+        OnCisEstablished(p, len);
+        break;
+      case HCI_BLE_CIS_REQ_EVT:
+        OnCisRequest(p, len);
+        break;
+      case HCI_BLE_CREATE_BIG_CPL_EVT:
+        OnBigCreated(p, len);
+        break;
+      case HCI_BLE_TERM_BIG_CPL_EVT:
+        OnBigTerminated(p, len);
+        break;
+      default:
+        LOG(ERROR) << __func__ << ": unexpected event " << loghex(sub_code);
+        break;
+    }
+  }
+
+  bool HandleDisconnect(uint16_t handle, uint8_t reason) {
+    auto it = streams.find(handle);
+    if (it == streams.end() || !it->second.is_cis) return false;
+
+    /* The CIS handle stays allocated to the CIG */
+    Stream& stream = it->second;
+    ReleaseStream(stream);
+    stream.established = false;
+    stream.data_paths = 0;
+    stream.tx_started = false;
+    stream.sync_requested = false;
+    stream.ctrl_synced = false;
+
+    if (callbacks) callbacks->OnCisDisconnected(handle, reason);
+    SendPending();
+    return true;
+  }
+};
+
+IsoManager::IsoManager() : pimpl_(new impl()) {}
+
+IsoManager::~IsoManager() = default;
+
+IsoManager* IsoManager::GetInstance() {
+  static IsoManager* instance = new IsoManager();
+  return instance;
+}
+
+void IsoManager::Start(IsoCallbacks* callbacks) { pimpl_->Start(callbacks); }
+
+void IsoManager::Stop() { pimpl_->Stop(); }
+
+bool IsoManager::IsRunning() const { return pimpl_->running; }
+
+void IsoManager::CreateCig(uint8_t cig_id, cig_create_params params) {
+  pimpl_->CreateCig(cig_id, std::move(params));
+}
+
+void IsoManager::RemoveCig(uint8_t cig_id) { pimpl_->RemoveCig(cig_id); }
+
+void IsoManager::EstablishCis(
+    std::vector<std::pair<uint16_t, uint16_t>> conn_pairs) {
+  pimpl_->EstablishCis(std::move(conn_pairs));
+}
+
+void IsoManager::DisconnectCis(uint16_t cis_handle, uint8_t reason) {
+  pimpl_->DisconnectCis(cis_handle, reason);
+}
+
+void IsoManager::CreateBig(uint8_t big_id, big_create_params params) {
+  pimpl_->CreateBig(big_id, std::move(params));
+}
+
+void IsoManager::TerminateBig(uint8_t big_id, uint8_t reason) {
+  pimpl_->TerminateBig(big_id, reason);
+}
+
+void IsoManager::SetupIsoDataPath(uint16_t iso_handle,
+                                  iso_data_path_params params) {
+  pimpl_->SetupIsoDataPath(iso_handle, std::move(params));
+}
+
+void IsoManager::RemoveIsoDataPath(uint16_t iso_handle, uint8_t data_path_dir) {
+  pimpl_->RemoveIsoDataPath(iso_handle, data_path_dir);
+}
+
+void IsoManager::SendIsoData(uint16_t iso_handle, const uint8_t* data,
+                             uint16_t len) {
+  pimpl_->SendIsoData(iso_handle, data, len);
+}
+
+void IsoManager::HandleIsoData(BT_HDR* p_msg) { pimpl_->HandleIsoData(p_msg); }
+
+void IsoManager::HandleNumComplDataPkts(uint8_t* p, uint8_t evt_len) {
+  pimpl_->HandleNumComplDataPkts(p, evt_len);
+}
+
+void IsoManager::HandleHciEvent(uint8_t sub_code, uint8_t* p, uint16_t len) {
+  pimpl_->HandleHciEvent(sub_code, p, len);
+}
+
+bool IsoManager::HandleDisconnect(uint16_t handle, uint8_t reason) {
+  return pimpl_->HandleDisconnect(handle, reason);
+}
+
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,384 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the link quality sampling: the RSSI, retransmissions
+ *  and controller activity reported for the ACL links are kept as fixed size
+ *  samples in a ring, and aggregated per link as they come in, so that the
+ *  power mode and link policies read them without HCI commands of their own.
+ *
+ *  Samples come from the Bluetooth Quality Report events, from the energy
+ *  info read for the framework, and from a timer that reads once per period
+ *  the RSSI of one LE link, and the controller energy info. The RSSI of
+ *  BR/EDR links only comes from BQR: HCI Read RSSI is relative to the golden
+ *  receive power range on those.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btm_lq"
+
+#include <base/bind.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bt_target.h"
+#include "bt_types.h"
+#include "btm_api.h"
+#include "btm_ble_int.h"
+#include "btm_int.h"
+#include "btu.h"
+#include "common/time_util.h"
+#include "hcidefs.h"
+#include "hcimsgs.h"
+#include "osi/include/properties.h"
+
+/* sample the link quality of the ACL links */
+#define BTM_LQ_PROPERTY "persist.bluetooth.link_quality.sampling"
+
+/* period of the sampling timer, and age of an RSSI sample past which the
+ * RSSI of the link is read again */
+#define BTM_LQ_INTERVAL_MS 5000
+
+/* weight of a new RSSI sample in the moving average, as a right shift */
+#define BTM_LQ_RSSI_AVG_SHIFT 2
+
+static void btm_lq_timeout(void* data);
+
+static uint32_t btm_lq_now_ms(void) {
+  return (uint32_t)bluetooth::common::time_get_os_boottime_ms();
+}
+
+/* The energy info totals grow from the controller reset, a total lower than
+ * the previous one means the controller restarted counting */
+static uint32_t btm_lq_delta(uint32_t total, uint32_t last) {
+  return total >= last ? total - last : total;
+}
+
+static tBTM_LQ_SAMPLE* btm_lq_add_sample(const tBTM_LQ_SAMPLE* p_sample) {
+  tBTM_LQ_CB* p_cb = &btm_cb.lq_cb;
+  tBTM_LQ_SAMPLE* p =
+      &p_cb->samples[p_cb->num_samples++ % BTM_LQ_NUM_SAMPLES];
+
+  *p = *p_sample;
+  p->time_ms = btm_lq_now_ms();
+  return p;
+}
+
+static void btm_lq_read_rssi_cb(uint8_t* data, uint16_t len) {
+  uint8_t status;
+  uint16_t handle;
+  int8_t rssi;
+
+  if (len < 4) return;
+  uint8_t* pp = data;
+  STREAM_TO_UINT8(status, pp);
+  STREAM_TO_UINT16(handle, pp);
+  STREAM_TO_INT8(rssi, pp);
+  if (status != HCI_SUCCESS) return;
+
+  tBTM_LQ_SAMPLE sample = {};
+  sample.handle = handle & 0x0FFF;
+  sample.source = BTM_LQ_SRC_RSSI;
+  sample.rssi = rssi;
+  BTM_LinkQualityAddSample(&sample);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_lq_timeout
+ *
+ * Description      Reads the RSSI of the next LE link without a recent one,
+ *                  and the controller energy info. The timer is set again
+ *                  only while there is something to sample.
+ *
+ ******************************************************************************/
+static void btm_lq_timeout(UNUSED_ATTR void* data) {
+  tBTM_LQ_CB* p_cb = &btm_cb.lq_cb;
+  uint32_t now_ms = btm_lq_now_ms();
+  bool le_links = false;
+
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++) {
+    uint8_t idx = (p_cb->next_link + xx) % MAX_L2CAP_LINKS;
+    tACL_CONN* p_acl = &btm_cb.acl_db[idx];
+
+    if (!p_acl->in_use || p_acl->transport != BT_TRANSPORT_LE) continue;
+    le_links = true;
+    if (p_acl->lq_rssi_time_ms != 0 &&
+        now_ms - p_acl->lq_rssi_time_ms < BTM_LQ_INTERVAL_MS)
+      continue;
+
+    /* Next time, start from the link after this one */
+    p_cb->next_link = (idx + 1) % MAX_L2CAP_LINKS;
+
+    /* With its own callback, so that BTM_ReadRSSI users never find it busy */
+    uint8_t param[HCIC_PARAM_SIZE_CMD_HANDLE];
+    uint8_t* pp = param;
+    UINT16_TO_STREAM(pp, p_acl->hci_handle);
+    btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_READ_RSSI, param, sizeof(param),
+                              base::Bind(btm_lq_read_rssi_cb));
+    break;
+  }
+
+  /* The controller is only sampled while it has links */
+  bool energy = false;
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++) {
+    if (btm_cb.acl_db[xx].in_use) {
+      energy = btm_ble_sample_energy_info();
+      break;
+    }
+  }
+
+  /* Nothing left to sample, the timer is set again by the next link */
+  if (!le_links && !energy) return;
+  alarm_set_on_mloop(p_cb->timer, BTM_LQ_INTERVAL_MS, btm_lq_timeout, NULL);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_lq_init
+ *
+ * Description      This function initializes the link quality sampling.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_lq_init(void) {
+  tBTM_LQ_CB* p_cb = &btm_cb.lq_cb;
+
+  memset(p_cb, 0, sizeof(tBTM_LQ_CB));
+  p_cb->enabled = osi_property_get_bool(BTM_LQ_PROPERTY, true);
+  p_cb->timer = alarm_new("btm.lq_timer");
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_lq_free
+ *
+ * Description      This function frees the link quality sampling timer.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_lq_free(void) {
+  alarm_free(btm_cb.lq_cb.timer);
+  btm_cb.lq_cb.timer = NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_lq_schedule
+ *
+ * Description      This function is called when an ACL link comes up, to
+ *                  start the sampling timer if it is not running.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_lq_schedule(void) {
+  tBTM_LQ_CB* p_cb = &btm_cb.lq_cb;
+
+  if (!p_cb->enabled || alarm_is_scheduled(p_cb->timer)) return;
+  alarm_set_on_mloop(p_cb->timer, BTM_LQ_INTERVAL_MS, btm_lq_timeout, NULL);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_lq_energy_sample
+ *
+ * Description      This function is called with the totals of a controller
+ *                  energy info, and samples the activity since the previous
+ *                  one.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_lq_energy_sample(uint32_t tx_time_ms, uint32_t rx_time_ms,
+                          uint32_t idle_time_ms, uint32_t energy_used) {
+  tBTM_LQ_CB* p_cb = &btm_cb.lq_cb;
+
+  if (!p_cb->enabled) return;
+
+  if (p_cb->energy_valid) {
+    tBTM_LQ_SAMPLE sample = {};
+    sample.handle = HCI_INVALID_HANDLE;
+    sample.source = BTM_LQ_SRC_ENERGY;
+    sample.tx_time_ms = btm_lq_delta(tx_time_ms, p_cb->last_tx_time_ms);
+    sample.rx_time_ms = btm_lq_delta(rx_time_ms, p_cb->last_rx_time_ms);
+    sample.idle_time_ms = btm_lq_delta(idle_time_ms, p_cb->last_idle_time_ms);
+    sample.energy_used = btm_lq_delta(energy_used, p_cb->last_energy_used);
+    btm_lq_add_sample(&sample);
+
+    tBTM_CONTROLLER_ACTIVITY* p_activity = &p_cb->activity;
+    p_activity->tx_time_ms += sample.tx_time_ms;
+    p_activity->rx_time_ms += sample.rx_time_ms;
+    p_activity->idle_time_ms += sample.idle_time_ms;
+    p_activity->energy_used += sample.energy_used;
+    uint64_t busy_ms = (uint64_t)sample.tx_time_ms + sample.rx_time_ms;
+    uint64_t total_ms = busy_ms + sample.idle_time_ms;
+    if (total_ms != 0)
+      p_activity->busy_permille = (uint16_t)(busy_ms * 1000 / total_ms);
+  }
+
+  p_cb->energy_valid = true;
+  p_cb->last_tx_time_ms = tx_time_ms;
+  p_cb->last_rx_time_ms = rx_time_ms;
+  p_cb->last_idle_time_ms = idle_time_ms;
+  p_cb->last_energy_used = energy_used;
+}
+
+/*******************************************************************************
+ *
+ * Function         BTM_LinkQualityAddSample
+ *
+ * Description      This function adds a link quality sample to the ring, and
+ *                  updates the aggregates of its link.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTM_LinkQualityAddSample(const tBTM_LQ_SAMPLE* p_sample) {
+  if (!btm_cb.lq_cb.enabled) return;
+
+  const tBTM_LQ_SAMPLE* p = btm_lq_add_sample(p_sample);
+  if (p->source != BTM_LQ_SRC_RSSI && p->source != BTM_LQ_SRC_BQR) return;
+
+  uint8_t idx = btm_handle_to_acl_index(p->handle);
+  if (idx >= MAX_L2CAP_LINKS) return;
+  tACL_CONN* p_acl = &btm_cb.acl_db[idx];
+
+  int16_t rssi_x16 = p->rssi * 16;
+  if (p_acl->lq_rssi_time_ms == 0) {
+    p_acl->lq_rssi_avg_x16 = rssi_x16;
+  } else {
+    p_acl->lq_rssi_avg_x16 +=
+        (rssi_x16 - p_acl->lq_rssi_avg_x16) / (1 << BTM_LQ_RSSI_AVG_SHIFT);
+  }
+  p_acl->lq_rssi = p->rssi;
+  p_acl->lq_rssi_time_ms = p->time_ms;
+
+  if (p->source == BTM_LQ_SRC_BQR) {
+    p_acl->lq_retransmissions += p->retransmissions;
+    p_acl->lq_naks += p->naks;
+    if (p->flags & BTM_LQ_FLAG_APPROACH_LSTO)
+      p_acl->lq_lsto_time_ms = p->time_ms;
+  }
+
+  if (p_acl->transport == BT_TRANSPORT_LE)
+    btm_ble_link_policy_rssi(p_acl, p->rssi);
+}
+
+/*******************************************************************************
+ *
+ * Function         BTM_ReadLinkQuality
+ *
+ * Description      This returns the quality of an ACL link, aggregated from
+ *                  its samples.
+ *
+ * Returns          BTM_SUCCESS if successful,
+ *                  BTM_UNKNOWN_ADDR if bd addr is not active or bad
+ *
+ ******************************************************************************/
+tBTM_STATUS BTM_ReadLinkQuality(const RawAddress& remote_bda,
+                                tBT_TRANSPORT transport,
+                                tBTM_LINK_QUALITY* p_quality) {
+  const tACL_CONN* p_acl = btm_bda_to_acl(remote_bda, transport);
+  if (p_acl == NULL) return BTM_UNKNOWN_ADDR;
+
+  uint32_t now_ms = btm_lq_now_ms();
+  p_quality->rssi = p_acl->lq_rssi;
+  p_quality->rssi_avg = (int8_t)(p_acl->lq_rssi_avg_x16 / 16);
+  p_quality->rssi_age_ms = p_acl->lq_rssi_time_ms != 0
+                               ? now_ms - p_acl->lq_rssi_time_ms
+                               : UINT32_MAX;
+  p_quality->retransmissions = p_acl->lq_retransmissions;
+  p_quality->naks = p_acl->lq_naks;
+  p_quality->lsto_age_ms = p_acl->lq_lsto_time_ms != 0
+                               ? now_ms - p_acl->lq_lsto_time_ms
+                               : UINT32_MAX;
+  return BTM_SUCCESS;
+}
+
+/*******************************************************************************
+ *
+ * Function         BTM_ReadControllerActivity
+ *
+ * Description      This returns the activity of the controller radio, from
+ *                  the energy info sampled.
+ *
+ * Returns          BTM_SUCCESS if successful,
+ *                  BTM_ERR_PROCESSING if no energy info was sampled
+ *
+ ******************************************************************************/
+tBTM_STATUS BTM_ReadControllerActivity(tBTM_CONTROLLER_ACTIVITY* p_activity) {
+  const tBTM_LQ_CB* p_cb = &btm_cb.lq_cb;
+
+  if (!p_cb->enabled || !p_cb->energy_valid) return BTM_ERR_PROCESSING;
+  *p_activity = p_cb->activity;
+  return BTM_SUCCESS;
+}
+
+/*******************************************************************************
+ *
+ * Function         BTM_LinkQualityDebugDump
+ *
+ * Description      This function dumps the link quality aggregates of the ACL
+ *                  links and the controller activity.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTM_LinkQualityDebugDump(int fd) {
+  const tBTM_LQ_CB* p_cb = &btm_cb.lq_cb;
+
+  dprintf(fd, "\nBTM Link Quality:\n");
+  if (!p_cb->enabled) {
+    dprintf(fd, "  Disabled\n");
+    return;
+  }
+  dprintf(fd, "  Samples: %u\n", p_cb->num_samples);
+  if (p_cb->energy_valid) {
+    const tBTM_CONTROLLER_ACTIVITY& activity = p_cb->activity;
+    dprintf(fd,
+            "  Controller tx: %llu ms, rx: %llu ms, idle: %llu ms, "
+            "energy: %llu, busy: %u/1000\n",
+            (unsigned long long)activity.tx_time_ms,
+            (unsigned long long)activity.rx_time_ms,
+            (unsigned long long)activity.idle_time_ms,
+            (unsigned long long)activity.energy_used, activity.busy_permille);
+  }
+
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++) {
+    const tACL_CONN& acl = btm_cb.acl_db[xx];
+    if (!acl.in_use) continue;
+
+    tBTM_LINK_QUALITY quality;
+    BTM_ReadLinkQuality(acl.remote_addr, acl.transport, &quality);
+    dprintf(fd, "  Link: %s, handle: 0x%04x\n",
+            acl.remote_addr.ToString().c_str(), acl.hci_handle);
+    if (quality.rssi_age_ms != UINT32_MAX) {
+      dprintf(fd, "    RSSI: %d dBm, average: %d dBm, %u ms ago\n",
+              quality.rssi, quality.rssi_avg, quality.rssi_age_ms);
+    }
+    dprintf(fd, "    Retransmissions: %u, NAKs: %u\n", quality.retransmissions,
+            quality.naks);
+    if (quality.lsto_age_ms != UINT32_MAX) {
+      dprintf(fd, "    Approaching LSTO: %u ms ago\n", quality.lsto_age_ms);
+    }
+  }
+}
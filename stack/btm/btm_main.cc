@@ -61,6 +61,7 @@ void btm_init(void) {
   /* Initialize BTM component structures */
   btm_inq_db_init(); /* Inquiry Database and Structures */
   btm_acl_init();    /* ACL Database and Structures */
+  btm_lq_init();     /* Link quality sampling */
   /* Security Manager Database and Structures */
   if (stack_config_get_interface()->get_pts_secure_only_mode())
     btm_sec_init(BTM_SEC_MODE_SC);
@@ -69,6 +70,14 @@ void btm_init(void) {
   btm_sco_init(); /* SCO Database and Structures (If included) */
 
   btm_cb.sec_dev_rec = list_new(osi_free);
+  btm_cb.sec_dev_index =
+      new bluetooth::common::RawAddressFlatMap<tBTM_SEC_DEV_REC*>(
+          BTM_SEC_MAX_DEVICE_RECORDS);
+  btm_cb.sec_dev_identity_index =
+      new bluetooth::common::RawAddressFlatMap<tBTM_SEC_DEV_REC*>(
+          BTM_SEC_MAX_DEVICE_RECORDS);
+  btm_cb.sec_dev_handle_index =
+      new std::unordered_map<uint16_t, tBTM_SEC_DEV_REC*>();
 
   btm_dev_init(); /* Device Manager Structures & HCI_Reset */
 }
@@ -93,10 +102,18 @@ void btm_free(void) {
 
   list_free(btm_cb.sec_dev_rec);
   btm_cb.sec_dev_rec = NULL;
+  delete btm_cb.sec_dev_index;
+  btm_cb.sec_dev_index = NULL;
+  delete btm_cb.sec_dev_identity_index;
+  btm_cb.sec_dev_identity_index = NULL;
+  delete btm_cb.sec_dev_handle_index;
+  btm_cb.sec_dev_handle_index = NULL;
 
   alarm_free(btm_cb.sec_collision_timer);
   btm_cb.sec_collision_timer = NULL;
 
   alarm_free(btm_cb.pairing_timer);
   btm_cb.pairing_timer = NULL;
+
+  btm_lq_free();
 }
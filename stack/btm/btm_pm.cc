@@ -35,6 +35,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+
 #include "bt_common.h"
 #include "bt_types.h"
 #include "bt_utils.h"
@@ -42,6 +44,7 @@
 #include "btm_int.h"
 #include "btm_int_types.h"
 #include "btu.h"
+#include "common/time_util.h"
 #include "device/include/controller.h"
 #include "hcidefs.h"
 #include "hcimsgs.h"
@@ -59,6 +62,12 @@
 #define BTM_PM_GET_MD2 2
 #define BTM_PM_GET_COMP 3
 
+/* weight of the last ACL packet interval in their average, as a shift */
+#define BTM_PM_TRAFFIC_AVG_SHIFT 3
+/* longer ACL packet intervals are counted as this one, so that a link coming
+ * back from a long idle period is seen as busy after a few packets */
+#define BTM_PM_TRAFFIC_MAX_INTERVAL_US (10 * 1000 * 1000)
+
 const uint8_t
     btm_pm_md_comp_matrix[BTM_PM_NUM_SET_MODES * BTM_PM_NUM_SET_MODES] = {
         BTM_PM_GET_COMP, BTM_PM_GET_MD2,  BTM_PM_GET_MD2,
@@ -72,6 +81,8 @@ static int btm_pm_find_acl_ind(const RawAddress& remote_bda);
 static tBTM_STATUS btm_pm_snd_md_req(uint8_t pm_id, int link_ind,
                                      const tBTM_PM_PWR_MD* p_mode);
 static const char* mode_to_string(const tBTM_PM_MODE mode);
+static void btm_pm_update_mode_stats(tBTM_PM_MCB* p_cb, tBTM_PM_MODE mode,
+                                     uint8_t hci_status);
 
 #if (BTM_PM_DEBUG == TRUE)
 const char* btm_pm_state_str[] = {"pm_active_state", "pm_hold_state",
@@ -383,6 +394,8 @@ void btm_pm_sm_alloc(uint8_t ind) {
   tBTM_PM_MCB* p_db = &btm_cb.pm_mode_db[ind]; /* per ACL link */
   memset(p_db, 0, sizeof(tBTM_PM_MCB));
   p_db->state = BTM_PM_ST_ACTIVE;
+  p_db->stats_mode = BTM_PM_MD_ACTIVE;
+  p_db->mode_since_us = bluetooth::common::time_get_os_boottime_us();
 #if (BTM_PM_DEBUG == TRUE)
   BTM_TRACE_DEBUG("btm_pm_sm_alloc ind:%d st:%d", ind, p_db->state);
 #endif  // BTM_PM_DEBUG
@@ -649,6 +662,7 @@ static tBTM_STATUS btm_pm_snd_md_req(uint8_t pm_id, int link_ind,
     return (BTM_NO_RESOURCES);
   }
 
+  p_cb->req_sent_us = bluetooth::common::time_get_os_boottime_us();
   return BTM_CMD_STARTED;
 }
 
@@ -704,6 +718,7 @@ void btm_pm_proc_cmd_status(uint8_t status) {
   } else /* the command was not successfull. Stay in the same state */
   {
     pm_status = BTM_PM_STS_ERROR;
+    p_cb->req_sent_us = 0;
   }
 
   /* notify the caller is appropriate */
@@ -760,6 +775,7 @@ void btm_pm_proc_mode_change(uint8_t hci_status, uint16_t hci_handle,
   old_state = p_cb->state;
   p_cb->state = mode;
   p_cb->interval = interval;
+  btm_pm_update_mode_stats(p_cb, mode, hci_status);
 
   BTM_TRACE_DEBUG("%s switched from %s to %s.", __func__,
                   mode_to_string(old_state), mode_to_string(p_cb->state));
@@ -814,6 +830,138 @@ void btm_pm_proc_mode_change(uint8_t hci_status, uint16_t hci_handle,
   btm_cont_rswitch(p, btm_find_dev(p->remote_addr), hci_status);
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_pm_update_mode_stats
+ *
+ * Description      This function updates the time in mode and the mode change
+ *                  latency statistics of a link, when its mode changes.
+ *
+ * Returns          none.
+ *
+ ******************************************************************************/
+static void btm_pm_update_mode_stats(tBTM_PM_MCB* p_cb, tBTM_PM_MODE mode,
+                                     uint8_t hci_status) {
+  uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+
+  if (p_cb->stats_mode < BTM_PM_NUM_MODES)
+    p_cb->time_in_mode_us[p_cb->stats_mode] += now_us - p_cb->mode_since_us;
+  p_cb->stats_mode = mode;
+  p_cb->mode_since_us = now_us;
+
+  /* only count the mode changes requested by this host */
+  if (p_cb->req_sent_us != 0 && hci_status == HCI_SUCCESS) {
+    uint64_t latency_us = now_us - p_cb->req_sent_us;
+    p_cb->num_transitions++;
+    p_cb->transition_us += latency_us;
+    p_cb->max_transition_us = std::max(p_cb->max_transition_us, latency_us);
+  }
+  p_cb->req_sent_us = 0;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_pm_proc_traffic
+ *
+ * Description      This function is called when an ACL packet is sent or
+ *                  received on a BR/EDR link, to keep track of the interval
+ *                  between its packets.
+ *
+ * Returns          none.
+ *
+ ******************************************************************************/
+void btm_pm_proc_traffic(uint16_t hci_handle) {
+  uint8_t xx = btm_handle_to_acl_index(hci_handle);
+  if (xx >= MAX_L2CAP_LINKS) return;
+
+  tBTM_PM_MCB* p_cb = &btm_cb.pm_mode_db[xx];
+  uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+
+  if (p_cb->last_pkt_us != 0) {
+    uint32_t interval_us = (uint32_t)std::min<uint64_t>(
+        now_us - p_cb->last_pkt_us, BTM_PM_TRAFFIC_MAX_INTERVAL_US);
+    if (p_cb->avg_gap_us == 0) {
+      p_cb->avg_gap_us = std::max<uint32_t>(interval_us, 1);
+    } else {
+      p_cb->avg_gap_us = std::max<uint32_t>(
+          p_cb->avg_gap_us - (p_cb->avg_gap_us >> BTM_PM_TRAFFIC_AVG_SHIFT) +
+              (interval_us >> BTM_PM_TRAFFIC_AVG_SHIFT),
+          1);
+    }
+  }
+  p_cb->last_pkt_us = now_us;
+}
+
+/*******************************************************************************
+ *
+ * Function         BTM_ReadTrafficInterval
+ *
+ * Description      This returns the interval between the ACL packets of a
+ *                  specific ACL connection, averaged over its last packets.
+ *                  The time since the last packet counts in, so that the
+ *                  interval of an idle link grows.
+ *
+ * Returns          BTM_SUCCESS if successful,
+ *                  BTM_UNKNOWN_ADDR if bd addr is not active or bad
+ *
+ ******************************************************************************/
+tBTM_STATUS BTM_ReadTrafficInterval(const RawAddress& remote_bda,
+                                    uint32_t* p_interval_us) {
+  int acl_ind = btm_pm_find_acl_ind(remote_bda);
+  if (acl_ind == MAX_L2CAP_LINKS) return (BTM_UNKNOWN_ADDR);
+
+  const tBTM_PM_MCB* p_cb = &btm_cb.pm_mode_db[acl_ind];
+  *p_interval_us = p_cb->avg_gap_us;
+  if (p_cb->avg_gap_us != 0) {
+    uint64_t idle_us = std::min<uint64_t>(
+        bluetooth::common::time_get_os_boottime_us() - p_cb->last_pkt_us,
+        BTM_PM_TRAFFIC_MAX_INTERVAL_US);
+    *p_interval_us = std::max(*p_interval_us, (uint32_t)idle_us);
+  }
+  return BTM_SUCCESS;
+}
+
+/*******************************************************************************
+ *
+ * Function         BTM_PmDebugDump
+ *
+ * Description      This function dumps the traffic and power mode statistics
+ *                  of the BR/EDR links.
+ *
+ * Returns          none.
+ *
+ ******************************************************************************/
+void BTM_PmDebugDump(int fd) {
+  uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+
+  dprintf(fd, "\nBTM Power Mode:\n");
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++) {
+    const tACL_CONN& acl = btm_cb.acl_db[xx];
+    if (!acl.in_use || acl.transport != BT_TRANSPORT_BR_EDR) continue;
+
+    const tBTM_PM_MCB& cb = btm_cb.pm_mode_db[xx];
+    dprintf(fd, "  Link: %s\n", acl.remote_addr.ToString().c_str());
+    dprintf(fd, "    Mode: %s, interval: %d slots\n",
+            mode_to_string(cb.stats_mode), cb.interval);
+    dprintf(fd, "    ACL packet interval: %u us\n", cb.avg_gap_us);
+    dprintf(fd, "    Time in mode (ms):");
+    for (uint8_t mode = 0; mode < BTM_PM_NUM_MODES; mode++) {
+      uint64_t time_us = cb.time_in_mode_us[mode];
+      if (mode == cb.stats_mode) time_us += now_us - cb.mode_since_us;
+      dprintf(fd, " %s: %llu", mode_to_string(mode),
+              (unsigned long long)(time_us / 1000));
+    }
+    dprintf(fd, "\n");
+    dprintf(fd, "    Mode changes: %u", cb.num_transitions);
+    if (cb.num_transitions != 0) {
+      dprintf(fd, ", latency average: %llu us, max: %llu us",
+              (unsigned long long)(cb.transition_us / cb.num_transitions),
+              (unsigned long long)cb.max_transition_us);
+    }
+    dprintf(fd, "\n");
+  }
+}
+
 /*******************************************************************************
  *
  * Function         btm_pm_proc_ssr_evt
@@ -26,6 +26,7 @@
 #include <device/include/esco_parameters.h>
 #include <stack/include/btm_api_types.h>
 #include <string.h>
+#include <algorithm>
 #include "bt_common.h"
 #include "bt_target.h"
 #include "bt_types.h"
@@ -39,6 +40,8 @@
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
+#include "sco_hci_link_interface.h"
 
 /******************************************************************************/
 /*               L O C A L    D A T A    D E F I N I T I O N S                */
@@ -54,11 +57,21 @@
 #define SCO_ST_PEND_ROLECHANGE 7
 #define SCO_ST_PEND_MODECHANGE 8
 
+/* Routes the audio of the SCO links over HCI instead of the PCM interface */
+#define PROPERTY_SCO_HCI_DATAPATH "persist.bluetooth.sco.hci_datapath"
+
+/* Packet status flags of the SCO data packets, see HCI 5.4.3 */
+#define SCO_PKT_STATUS_FLAG_MASK 0x3000
+#define SCO_PKT_STATUS_FLAG_OFFSET 12
+#define SCO_PKT_STATUS_NO_DATA 2
+#define SCO_PKT_STATUS_PARTIALLY_LOST 3
+
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /******************************************************************************/
 
 static uint16_t btm_sco_voice_settings_to_legacy(enh_esco_params_t* p_parms);
+static void btm_sco_set_data_path(enh_esco_params_t* p_setup);
 
 /*******************************************************************************
  *
@@ -86,7 +99,41 @@ void btm_sco_init(void) {
   btm_cb.sco_cb.sco_disc_reason = BTM_INVALID_SCO_DISC_REASON;
   btm_cb.sco_cb.def_esco_parms = esco_parameters_for_codec(ESCO_CODEC_CVSD);
   btm_cb.sco_cb.def_esco_parms.max_latency_ms = 12;
-  btm_cb.sco_cb.sco_route = ESCO_DATA_PATH_PCM;
+  btm_cb.sco_cb.sco_route =
+      osi_property_get_bool(PROPERTY_SCO_HCI_DATAPATH, false)
+          ? ESCO_DATA_PATH_HCI
+          : ESCO_DATA_PATH_PCM;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sco_set_data_path
+ *
+ * Description      This function applies the saved SCO routing to the enhanced
+ *                  parameters of a connection. Over HCI, mSBC frames are coded
+ *                  by the host and carried transparently through the
+ *                  controller.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btm_sco_set_data_path(enh_esco_params_t* p_setup) {
+  p_setup->input_data_path = p_setup->output_data_path =
+      btm_cb.sco_cb.sco_route;
+  if (btm_cb.sco_cb.sco_route != ESCO_DATA_PATH_HCI ||
+      p_setup->transmit_coding_format.coding_format !=
+          ESCO_CODING_FORMAT_MSBC) {
+    return;
+  }
+
+  p_setup->transmit_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->receive_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->input_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->output_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->input_bandwidth = p_setup->output_bandwidth = TXRX_64KBITS_RATE;
+  p_setup->input_coded_data_size = p_setup->output_coded_data_size = 8;
+  p_setup->input_pcm_data_format = p_setup->output_pcm_data_format =
+      ESCO_PCM_DATA_FORMAT_NA;
 }
 
 /*******************************************************************************
@@ -165,8 +212,7 @@ static void btm_esco_conn_rsp(uint16_t sco_inx, uint8_t hci_status,
     if (controller_get_interface()
             ->supports_enhanced_setup_synchronous_connection()) {
       /* Use the saved SCO routing */
-      p_setup->input_data_path = p_setup->output_data_path =
-          btm_cb.sco_cb.sco_route;
+      btm_sco_set_data_path(p_setup);
 
       BTM_TRACE_DEBUG(
           "%s: txbw 0x%x, rxbw 0x%x, lat 0x%x, retrans 0x%02x, "
@@ -199,6 +245,46 @@ static void btm_esco_conn_rsp(uint16_t sco_inx, uint8_t hci_status,
  *
  ******************************************************************************/
 void btm_route_sco_data(BT_HDR* p_msg) {
+#if (BTM_MAX_SCO_LINKS > 0)
+  if (p_msg->len < HCI_SCO_PREAMBLE_SIZE) {
+    osi_free(p_msg);
+    return;
+  }
+
+  uint8_t* p = (uint8_t*)(p_msg + 1) + p_msg->offset;
+  uint16_t handle_with_flags;
+  uint8_t data_len;
+  STREAM_TO_UINT16(handle_with_flags, p);
+  STREAM_TO_UINT8(data_len, p);
+  uint16_t handle = handle_with_flags & HCI_DATA_HANDLE_MASK;
+  uint8_t status = (handle_with_flags & SCO_PKT_STATUS_FLAG_MASK) >>
+                   SCO_PKT_STATUS_FLAG_OFFSET;
+  data_len = std::min<uint16_t>(data_len, p_msg->len - HCI_SCO_PREAMBLE_SIZE);
+
+  uint16_t sco_inx = btm_find_scb_by_handle(handle);
+  if (sco_inx == BTM_MAX_SCO_LINKS ||
+      btm_cb.sco_cb.sco_route != ESCO_DATA_PATH_HCI) {
+    osi_free(p_msg);
+    return;
+  }
+
+  bool lost = status == SCO_PKT_STATUS_NO_DATA ||
+              status == SCO_PKT_STATUS_PARTIALLY_LOST;
+  bluetooth::audio::sco::ReceivePacket(handle, lost, p, data_len);
+
+  /* Answer every received packet with one of the same size, which keeps the
+   * transmission at the pace of the link */
+  BT_HDR* p_buf =
+      (BT_HDR*)osi_malloc(sizeof(BT_HDR) + HCI_SCO_PREAMBLE_SIZE + data_len);
+  p_buf->offset = HCI_SCO_PREAMBLE_SIZE;
+  p_buf->len = data_len;
+  if (bluetooth::audio::sco::FillPacket(
+          handle, (uint8_t*)(p_buf + 1) + p_buf->offset, data_len)) {
+    BTM_WriteScoData(sco_inx, p_buf);
+  } else {
+    osi_free(p_buf);
+  }
+#endif
   osi_free(p_msg);
 }
 
@@ -223,9 +309,41 @@ void btm_route_sco_data(BT_HDR* p_msg) {
  *
  *
  ******************************************************************************/
-tBTM_STATUS BTM_WriteScoData(UNUSED_ATTR uint16_t sco_inx,
-                             UNUSED_ATTR BT_HDR* p_buf) {
+tBTM_STATUS BTM_WriteScoData(uint16_t sco_inx, BT_HDR* p_buf) {
+#if (BTM_MAX_SCO_LINKS > 0)
+  tSCO_CONN* p_ccb = &btm_cb.sco_cb.sco_db[sco_inx];
+  tBTM_STATUS status = BTM_SUCCESS;
+
+  if (sco_inx >= BTM_MAX_SCO_LINKS ||
+      btm_cb.sco_cb.sco_route != ESCO_DATA_PATH_HCI ||
+      p_ccb->state != SCO_ST_CONNECTED) {
+    osi_free(p_buf);
+    return (BTM_UNKNOWN_ADDR);
+  }
+
+  if (p_buf->offset < HCI_SCO_PREAMBLE_SIZE) {
+    osi_free(p_buf);
+    return (BTM_ILLEGAL_VALUE);
+  }
+
+  if (p_buf->len > BTM_SCO_DATA_SIZE_MAX) {
+    p_buf->len = BTM_SCO_DATA_SIZE_MAX;
+    status = BTM_SCO_BAD_LENGTH;
+  }
+
+  p_buf->offset -= HCI_SCO_PREAMBLE_SIZE;
+  uint8_t* p = (uint8_t*)(p_buf + 1) + p_buf->offset;
+  UINT16_TO_STREAM(p, p_ccb->hci_handle);
+  UINT8_TO_STREAM(p, p_buf->len);
+  p_buf->len += HCI_SCO_PREAMBLE_SIZE;
+  p_buf->event = BT_EVT_TO_LM_HCI_SCO;
+
+  bte_main_hci_send(p_buf, BT_EVT_TO_LM_HCI_SCO);
+  return (status);
+#else
+  osi_free(p_buf);
   return (BTM_NO_RESOURCES);
+#endif
 }
 
 #if (BTM_MAX_SCO_LINKS > 0)
@@ -311,8 +429,7 @@ static tBTM_STATUS btm_send_connect_request(uint16_t acl_handle,
     if (controller_get_interface()
             ->supports_enhanced_setup_synchronous_connection()) {
       /* Use the saved SCO routing */
-      p_setup->input_data_path = p_setup->output_data_path =
-          btm_cb.sco_cb.sco_route;
+      btm_sco_set_data_path(p_setup);
       LOG(INFO) << __func__ << std::hex << ": enhanced parameter list"
                 << " txbw=0x" << unsigned(p_setup->transmit_bandwidth)
                 << ", rxbw=0x" << unsigned(p_setup->receive_bandwidth)
@@ -839,6 +956,17 @@ void btm_sco_connected(uint8_t hci_status, const RawAddress* bda,
         if (p_esco_data) p->esco.data = *p_esco_data;
       }
 
+      if (btm_cb.sco_cb.sco_route == ESCO_DATA_PATH_HCI) {
+        /* Over HCI mSBC is set up as transparent data */
+        esco_coding_format_t coding_format =
+            p->esco.setup.transmit_coding_format.coding_format;
+        bluetooth::audio::sco::Open(
+            hci_handle, (coding_format == ESCO_CODING_FORMAT_MSBC ||
+                         coding_format == ESCO_CODING_FORMAT_TRANSPNT)
+                            ? ESCO_CODING_FORMAT_MSBC
+                            : ESCO_CODING_FORMAT_CVSD);
+      }
+
       (*p->p_conn_cb)(xx);
 
       return;
@@ -969,6 +1097,9 @@ void btm_sco_removed(uint16_t hci_handle, uint8_t reason) {
     if ((p->state != SCO_ST_UNUSED) && (p->state != SCO_ST_LISTENING) &&
         (p->hci_handle == hci_handle)) {
       btm_sco_flush_sco_data(xx);
+      if (btm_cb.sco_cb.sco_route == ESCO_DATA_PATH_HCI) {
+        bluetooth::audio::sco::Close(hci_handle);
+      }
 
       p->state = SCO_ST_UNUSED;
       p->hci_handle = BTM_INVALID_HCI_HANDLE;
@@ -1186,8 +1317,7 @@ tBTM_STATUS BTM_ChangeEScoLinkParms(uint16_t sco_inx,
     if (controller_get_interface()
             ->supports_enhanced_setup_synchronous_connection()) {
       /* Use the saved SCO routing */
-      p_setup->input_data_path = p_setup->output_data_path =
-          btm_cb.sco_cb.sco_route;
+      btm_sco_set_data_path(p_setup);
 
       btsnd_hcic_enhanced_set_up_synchronous_connection(p_sco->hci_handle,
                                                         p_setup);
@@ -1466,6 +1596,7 @@ static uint16_t btm_sco_voice_settings_to_legacy(enh_esco_params_t* p_params) {
       break;
 
     case ESCO_CODING_FORMAT_MSBC:
+    case ESCO_CODING_FORMAT_TRANSPNT:
       voice_settings |= HCI_AIR_CODING_FORMAT_TRANSPNT;
       break;
 
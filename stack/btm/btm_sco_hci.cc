@@ -0,0 +1,242 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/******************************************************************************
+ *
+ *  This file carries the audio of an SCO link routed over HCI between the
+ *  controller and the audio HAL: received packets are decoded into a jitter
+ *  buffer the HAL is served from, and the frames the HAL provides are queued
+ *  in another one, encoded into the packets sent back.
+ *
+ ******************************************************************************/
+
+#include "sco_hci_link_interface.h"
+
+#include <base/logging.h>
+#include <stdio.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "sco_hci_codec.h"
+#include "uipc.h"
+
+namespace bluetooth {
+namespace audio {
+namespace sco {
+
+namespace {
+
+struct ScoLink {
+  ScoLink(uint16_t handle, std::unique_ptr<ScoCodec> codec)
+      : handle(handle),
+        codec(std::move(codec)),
+        rx_frames(this->codec->FrameSamples(), SCO_HCI_JITTER_MIN_FRAMES,
+                  SCO_HCI_JITTER_MAX_FRAMES),
+        tx_frames(this->codec->FrameSamples(), SCO_HCI_JITTER_MIN_FRAMES,
+                  SCO_HCI_JITTER_MAX_FRAMES),
+        hal_frame(this->codec->FrameSamples()),
+        hal_bytes(0),
+        rx_packets(0),
+        lost_packets(0),
+        tx_packets(0) {}
+
+  uint16_t handle;
+  std::unique_ptr<ScoCodec> codec;
+  /* Decoded frames waiting for the HAL, and HAL frames waiting to be sent */
+  ScoJitterBuffer rx_frames;
+  ScoJitterBuffer tx_frames;
+  /* Frame being read from the HAL, and how many of its bytes were read */
+  std::vector<int16_t> hal_frame;
+  size_t hal_bytes;
+  uint64_t rx_packets;
+  uint64_t lost_packets;
+  uint64_t tx_packets;
+};
+
+/* Guards |active_link|, which the UIPC thread serves the HAL from while the
+ * BTU thread exchanges packets with the controller */
+std::mutex link_mutex;
+std::unique_ptr<ScoLink> active_link;
+std::unique_ptr<tUIPC_STATE> uipc_sco;
+
+void DumpJitterBuffer(int fd, const char* name, const ScoJitterBuffer& buffer) {
+  const ScoJitterBuffer::Stats& stats = buffer.GetStats();
+  uint64_t average_us =
+      stats.frames_read
+          ? stats.depth_sum * SCO_HCI_FRAME_DURATION_US / stats.frames_read
+          : 0;
+  dprintf(fd,
+          "  %s: latency %llu us avg, %llu us max, target %zu frames, "
+          "%llu underruns, %llu dropped frames\n",
+          name, (unsigned long long)average_us,
+          (unsigned long long)stats.max_depth * SCO_HCI_FRAME_DURATION_US,
+          buffer.Target(), (unsigned long long)stats.underruns,
+          (unsigned long long)stats.dropped_frames);
+}
+
+/* Exchanges one frame of speaker PCM for every frame of microphone PCM the
+ * HAL writes, so that the HAL clock paces the frames it is served */
+void ServeHal(ScoLink* link) {
+  size_t frame_bytes = link->hal_frame.size() * sizeof(int16_t);
+  uint8_t* frame = reinterpret_cast<uint8_t*>(link->hal_frame.data());
+  /* The socket is watched level triggered, data left behind raises the next
+   * data ready event */
+  link->hal_bytes +=
+      UIPC_Read(*uipc_sco, UIPC_CH_ID_AV_AUDIO, nullptr,
+                frame + link->hal_bytes, frame_bytes - link->hal_bytes);
+  if (link->hal_bytes < frame_bytes) return;
+  link->hal_bytes = 0;
+
+  link->tx_frames.Write(link->hal_frame.data());
+  if (!link->rx_frames.Read(link->hal_frame.data())) {
+    std::fill(link->hal_frame.begin(), link->hal_frame.end(), 0);
+  }
+  UIPC_Send(*uipc_sco, UIPC_CH_ID_AV_AUDIO, 0, frame, frame_bytes);
+}
+
+void sco_data_cb(tUIPC_CH_ID, tUIPC_EVENT event) {
+  std::lock_guard<std::mutex> lock(link_mutex);
+  switch (event) {
+    case UIPC_OPEN_EVT:
+      LOG(INFO) << __func__ << ": UIPC_OPEN_EVT";
+      /* A read must never wait for the HAL, partial frames are completed on
+       * the next data ready events */
+      UIPC_Ioctl(*uipc_sco, UIPC_CH_ID_AV_AUDIO, UIPC_SET_READ_POLL_TMO,
+                 reinterpret_cast<void*>(0));
+      if (active_link) {
+        active_link->rx_frames.Reset();
+        active_link->tx_frames.Reset();
+        active_link->hal_bytes = 0;
+      }
+      break;
+
+    case UIPC_RX_DATA_READY_EVT:
+      if (active_link) {
+        ServeHal(active_link.get());
+      } else {
+        /* Drain the HAL while no link is routed */
+        uint8_t buffer[64];
+        UIPC_Read(*uipc_sco, UIPC_CH_ID_AV_AUDIO, nullptr, buffer,
+                  sizeof(buffer));
+      }
+      break;
+
+    case UIPC_CLOSE_EVT:
+      LOG(INFO) << __func__ << ": UIPC_CLOSE_EVT";
+      break;
+
+    default:
+      break;
+  }
+}
+
+}  // namespace
+
+void Open(uint16_t handle, esco_coding_format_t coding_format) {
+  std::unique_ptr<ScoCodec> codec = ScoCodec::Create(coding_format);
+  if (!codec) {
+    LOG(ERROR) << __func__ << ": unsupported coding format "
+               << unsigned(coding_format) << " for handle " << handle;
+    return;
+  }
+  LOG(INFO) << __func__ << ": handle " << handle << ", coding format "
+            << unsigned(coding_format) << ", " << codec->SampleRate() << " Hz";
+
+  {
+    std::lock_guard<std::mutex> lock(link_mutex);
+    if (active_link) {
+      LOG(WARNING) << __func__ << ": replacing the audio of handle "
+                   << active_link->handle;
+    }
+    active_link = std::make_unique<ScoLink>(handle, std::move(codec));
+  }
+
+  if (!uipc_sco) {
+    uipc_sco = UIPC_Init();
+    UIPC_Open(*uipc_sco, UIPC_CH_ID_AV_AUDIO, sco_data_cb, SCO_HCI_DATA_PATH);
+  }
+}
+
+void Close(uint16_t handle) {
+  {
+    std::lock_guard<std::mutex> lock(link_mutex);
+    if (!active_link || active_link->handle != handle) return;
+    LOG(INFO) << __func__ << ": handle " << handle;
+    active_link = nullptr;
+  }
+
+  /* Joins the UIPC thread, which takes |link_mutex| in its callback */
+  if (uipc_sco) {
+    UIPC_Close(*uipc_sco, UIPC_CH_ID_ALL);
+    uipc_sco = nullptr;
+  }
+}
+
+void ReceivePacket(uint16_t handle, bool lost, const uint8_t* data,
+                   size_t len) {
+  std::lock_guard<std::mutex> lock(link_mutex);
+  if (!active_link || active_link->handle != handle) return;
+
+  ScoLink* link = active_link.get();
+  link->rx_packets++;
+  if (lost) link->lost_packets++;
+  link->codec->Decode(data, len, lost, [link](const int16_t* frame) {
+    link->rx_frames.Write(frame);
+  });
+}
+
+bool FillPacket(uint16_t handle, uint8_t* data, size_t len) {
+  std::lock_guard<std::mutex> lock(link_mutex);
+  if (!active_link || active_link->handle != handle) return false;
+
+  ScoLink* link = active_link.get();
+  link->tx_packets++;
+  link->codec->Encode(data, len, [link](int16_t* frame) {
+    return link->tx_frames.Read(frame);
+  });
+  return true;
+}
+
+void DebugDump(int fd) {
+  std::lock_guard<std::mutex> lock(link_mutex);
+  dprintf(fd, "\nSCO HCI datapath:\n");
+  if (!active_link) {
+    dprintf(fd, "  No link routed over HCI\n");
+    return;
+  }
+
+  const ScoLink& link = *active_link;
+  dprintf(fd, "  Handle: 0x%04x, %u Hz\n", link.handle,
+          link.codec->SampleRate());
+  dprintf(fd,
+          "  Packets: %llu received, %llu reported lost, %llu sent\n",
+          (unsigned long long)link.rx_packets,
+          (unsigned long long)link.lost_packets,
+          (unsigned long long)link.tx_packets);
+  dprintf(fd,
+          "  Frames: %llu decoded, %llu concealed, %llu decode errors\n",
+          (unsigned long long)link.codec->DecodedFrames(),
+          (unsigned long long)link.codec->ConcealedFrames(),
+          (unsigned long long)link.codec->DecodeErrors());
+  DumpJitterBuffer(fd, "Speaker", link.rx_frames);
+  DumpJitterBuffer(fd, "Microphone", link.tx_frames);
+}
+
+}  // namespace sco
+}  // namespace audio
+}  // namespace bluetooth
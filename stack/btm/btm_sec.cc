@@ -4760,6 +4760,29 @@ void btm_sec_update_clock_offset(uint16_t handle, uint16_t clock_offset) {
   p_inq_info->results.clock_offset = clock_offset | BTM_CLOCK_OFFSET_VALID;
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_sec_update_page_scan_rep_mode
+ *
+ * Description      This function is called to update the page scan repetition
+ *                  mode of a device, used when paging it
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_sec_update_page_scan_rep_mode(const RawAddress& bd_addr,
+                                       uint8_t page_scan_rep_mode) {
+  if (page_scan_rep_mode > HCI_PAGE_SCAN_REP_MODE_R2) return;
+
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(bd_addr);
+  if (p_dev_rec != NULL) p_dev_rec->page_scan_rep_mode = page_scan_rep_mode;
+
+  tBTM_INQ_INFO* p_inq_info = BTM_InqDbRead(bd_addr);
+  if (p_inq_info == NULL) return;
+
+  p_inq_info->results.page_scan_rep_mode = page_scan_rep_mode;
+}
+
 /******************************************************************
  * S T A T I C     F U N C T I O N S
  ******************************************************************/
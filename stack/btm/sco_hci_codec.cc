@@ -0,0 +1,303 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sco_hci_codec.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "device/include/esco_parameters.h"
+#include "embdrv/sbc/decoder/include/oi_status.h"
+
+ScoJitterBuffer::ScoJitterBuffer(size_t frame_samples, size_t min_frames,
+                                 size_t max_frames)
+    : frame_samples_(frame_samples),
+      min_frames_(std::max<size_t>(min_frames, 1)),
+      max_frames_(std::max(max_frames, min_frames_)),
+      capacity_(2 * max_frames_),
+      frames_(capacity_ * frame_samples) {
+  Reset();
+}
+
+void ScoJitterBuffer::Reset() {
+  head_ = 0;
+  count_ = 0;
+  target_ = min_frames_;
+  buffering_ = true;
+  stable_reads_ = 0;
+  stats_ = {};
+}
+
+void ScoJitterBuffer::DropOldest() {
+  head_ = (head_ + 1) % capacity_;
+  count_--;
+  stats_.dropped_frames++;
+}
+
+void ScoJitterBuffer::Write(const int16_t* frame) {
+  if (count_ == capacity_) DropOldest();
+  size_t tail = (head_ + count_) % capacity_;
+  memcpy(&frames_[tail * frame_samples_], frame,
+         frame_samples_ * sizeof(*frame));
+  count_++;
+  stats_.frames_written++;
+}
+
+bool ScoJitterBuffer::Read(int16_t* frame) {
+  if (count_ == 0) {
+    if (!buffering_) {
+      /* Buffer more from now on, to make the next underrun less likely */
+      stats_.underruns++;
+      target_ = std::min(target_ + 1, max_frames_);
+      buffering_ = true;
+    }
+    stable_reads_ = 0;
+    return false;
+  }
+  if (buffering_) {
+    if (count_ < target_) return false;
+    buffering_ = false;
+  }
+
+  while (count_ > 2 * target_) DropOldest();
+
+  stats_.depth_sum += count_;
+  stats_.max_depth = std::max(stats_.max_depth, count_);
+  memcpy(frame, &frames_[head_ * frame_samples_],
+         frame_samples_ * sizeof(*frame));
+  head_ = (head_ + 1) % capacity_;
+  count_--;
+  stats_.frames_read++;
+
+  if (++stable_reads_ >= kStableReads) {
+    stable_reads_ = 0;
+    if (target_ > min_frames_) target_--;
+  }
+  return true;
+}
+
+ScoPlc::ScoPlc(size_t frame_samples)
+    : last_good_(frame_samples), lost_frames_(0), concealed_frames_(0) {}
+
+void ScoPlc::Conceal(size_t lost, int16_t* frame) const {
+  if (lost > kMaxAttenuatedFrames) {
+    std::fill(frame, frame + last_good_.size(), 0);
+    return;
+  }
+  int32_t divisor = 1 << lost;
+  for (size_t i = 0; i < last_good_.size(); i++) {
+    frame[i] = last_good_[i] / divisor;
+  }
+}
+
+void ScoPlc::GoodFrame(int16_t* frame) {
+  if (lost_frames_ > 0) {
+    /* Fade from where the concealment would have continued */
+    int32_t divisor =
+        lost_frames_ < kMaxAttenuatedFrames ? 1 << (lost_frames_ + 1) : 0;
+    size_t fade = std::min(kCrossFadeSamples, last_good_.size());
+    for (size_t i = 0; i < fade; i++) {
+      int32_t concealed = divisor ? last_good_[i] / divisor : 0;
+      frame[i] = (concealed * (int32_t)(fade - i) + frame[i] * (int32_t)i) /
+                 (int32_t)fade;
+    }
+    lost_frames_ = 0;
+  }
+  std::copy(frame, frame + last_good_.size(), last_good_.begin());
+}
+
+void ScoPlc::BadFrame(int16_t* frame) {
+  lost_frames_++;
+  concealed_frames_++;
+  Conceal(lost_frames_, frame);
+}
+
+ScoCodec::ScoCodec(size_t frame_samples, size_t frame_bytes)
+    : frame_bytes_(frame_bytes),
+      plc_(frame_samples),
+      rx_pcm_(frame_samples),
+      tx_pcm_(frame_samples),
+      rx_synced_(false),
+      rx_skipped_(0),
+      tx_frame_(frame_bytes),
+      tx_offset_(frame_bytes),
+      decoded_frames_(0),
+      decode_errors_(0) {}
+
+std::unique_ptr<ScoCodec> ScoCodec::Create(uint8_t coding_format) {
+  switch (coding_format) {
+    case ESCO_CODING_FORMAT_CVSD:
+      return std::make_unique<ScoCvsdCodec>();
+    case ESCO_CODING_FORMAT_MSBC:
+      return std::make_unique<ScoMsbcCodec>();
+    default:
+      return nullptr;
+  }
+}
+
+void ScoCodec::EmitFrame(bool good, const FrameSink& sink) {
+  if (good) {
+    decoded_frames_++;
+    plc_.GoodFrame(rx_pcm_.data());
+  } else {
+    plc_.BadFrame(rx_pcm_.data());
+  }
+  sink(rx_pcm_.data());
+}
+
+void ScoCodec::Decode(const uint8_t* data, size_t len, bool lost,
+                      const FrameSink& sink) {
+  rx_bytes_.insert(rx_bytes_.end(), data, data + len);
+  rx_lost_.insert(rx_lost_.end(), len, lost);
+
+  while (true) {
+    if (!rx_synced_) {
+      size_t offset;
+      rx_synced_ = FindFrame(rx_bytes_.data(), rx_bytes_.size(), &offset);
+      rx_bytes_.erase(rx_bytes_.begin(), rx_bytes_.begin() + offset);
+      rx_lost_.erase(rx_lost_.begin(), rx_lost_.begin() + offset);
+      /* Keep the pace of the frames while out of sync */
+      rx_skipped_ += offset;
+      for (; rx_skipped_ >= frame_bytes_; rx_skipped_ -= frame_bytes_) {
+        EmitFrame(false, sink);
+      }
+      if (!rx_synced_) return;
+    }
+    if (rx_bytes_.size() < frame_bytes_) return;
+
+    bool frame_lost = std::find(rx_lost_.begin(),
+                                rx_lost_.begin() + frame_bytes_,
+                                true) != rx_lost_.begin() + frame_bytes_;
+    bool good = !frame_lost && DecodeFrame(rx_bytes_.data(), rx_pcm_.data());
+    size_t consumed = frame_bytes_;
+    if (!good && !frame_lost) {
+      /* Data the controller did not report lost that cannot be decoded means
+       * the frame boundaries may have been lost, look for the next one right
+       * after the start of this frame */
+      decode_errors_++;
+      rx_synced_ = false;
+      rx_skipped_ = 0;
+      consumed = 1;
+    }
+    rx_bytes_.erase(rx_bytes_.begin(), rx_bytes_.begin() + consumed);
+    rx_lost_.erase(rx_lost_.begin(), rx_lost_.begin() + consumed);
+    EmitFrame(good, sink);
+  }
+}
+
+void ScoCodec::Encode(uint8_t* data, size_t len, const FrameSource& source) {
+  while (len > 0) {
+    if (tx_offset_ == frame_bytes_) {
+      if (!source(tx_pcm_.data())) {
+        std::fill(tx_pcm_.begin(), tx_pcm_.end(), 0);
+      }
+      EncodeFrame(tx_pcm_.data(), tx_frame_.data());
+      tx_offset_ = 0;
+    }
+    size_t count = std::min(len, frame_bytes_ - tx_offset_);
+    memcpy(data, &tx_frame_[tx_offset_], count);
+    tx_offset_ += count;
+    data += count;
+    len -= count;
+  }
+}
+
+ScoCvsdCodec::ScoCvsdCodec()
+    : ScoCodec(kFrameSamples, kFrameSamples * sizeof(int16_t)) {}
+
+bool ScoCvsdCodec::DecodeFrame(const uint8_t* data, int16_t* frame) {
+  for (size_t i = 0; i < kFrameSamples; i++) {
+    frame[i] = (int16_t)(data[2 * i] | (data[2 * i + 1] << 8));
+  }
+  return true;
+}
+
+bool ScoCvsdCodec::FindFrame(const uint8_t* /* data */, size_t /* len */,
+                             size_t* offset) const {
+  /* Linear PCM has no frame boundaries, any even position will do */
+  *offset = 0;
+  return true;
+}
+
+void ScoCvsdCodec::EncodeFrame(const int16_t* frame, uint8_t* data) {
+  for (size_t i = 0; i < kFrameSamples; i++) {
+    data[2 * i] = (uint8_t)(frame[i] & 0xff);
+    data[2 * i + 1] = (uint8_t)((frame[i] >> 8) & 0xff);
+  }
+}
+
+namespace {
+
+/* The H2 header is a synchronization word followed by the 2 bit sequence
+ * number of the frame, each bit repeated twice */
+constexpr uint8_t kH2SyncWord = 0x01;
+constexpr uint8_t kH2Sequence[] = {0x08, 0x38, 0xc8, 0xf8};
+
+bool IsH2Header(const uint8_t* data) {
+  return data[0] == kH2SyncWord &&
+         std::find(std::begin(kH2Sequence), std::end(kH2Sequence), data[1]) !=
+             std::end(kH2Sequence) &&
+         data[ScoMsbcCodec::kH2HeaderLength] == SBC_MSBC_SYNCWORD;
+}
+
+}  // namespace
+
+ScoMsbcCodec::ScoMsbcCodec()
+    : ScoCodec(kFrameSamples, kPacketFrameLength), tx_sequence_(0) {
+  OI_CODEC_mSBC_DecoderReset(&decoder_context_, decoder_data_,
+                             sizeof(decoder_data_));
+
+  /* The encoder keeps its analysis state in globals shared with A2DP, whose
+   * streaming is suspended while a call is up */
+  memset(&encoder_params_, 0, sizeof(encoder_params_));
+  encoder_params_.Format = SBC_FORMAT_MSBC;
+  SBC_Encoder_Init(&encoder_params_);
+}
+
+bool ScoMsbcCodec::FindFrame(const uint8_t* data, size_t len,
+                             size_t* offset) const {
+  const size_t header_len = kH2HeaderLength + 1;
+  size_t i = 0;
+  for (; i + header_len <= len; i++) {
+    if (IsH2Header(data + i)) {
+      *offset = i;
+      return true;
+    }
+  }
+  /* The last bytes may still be the beginning of a header */
+  *offset = len < header_len ? 0 : len - header_len + 1;
+  return false;
+}
+
+bool ScoMsbcCodec::DecodeFrame(const uint8_t* data, int16_t* frame) {
+  if (!IsH2Header(data)) return false;
+
+  const OI_BYTE* frame_data = data + kH2HeaderLength;
+  uint32_t frame_bytes = SBC_MSBC_FRAME_LEN;
+  uint32_t pcm_bytes = kFrameSamples * sizeof(*frame);
+  OI_STATUS status = OI_CODEC_SBC_DecodeFrame(
+      &decoder_context_, &frame_data, &frame_bytes, frame, &pcm_bytes);
+  return OI_SUCCESS(status) && pcm_bytes == kFrameSamples * sizeof(*frame);
+}
+
+void ScoMsbcCodec::EncodeFrame(const int16_t* frame, uint8_t* data) {
+  data[0] = kH2SyncWord;
+  data[1] = kH2Sequence[tx_sequence_];
+  tx_sequence_ = (tx_sequence_ + 1) % sizeof(kH2Sequence);
+  SBC_Encode(&encoder_params_, const_cast<int16_t*>(frame),
+             data + kH2HeaderLength);
+  data[kPacketFrameLength - 1] = 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "embdrv/sbc/decoder/include/oi_codec_sbc.h"
+#include "embdrv/sbc/encoder/include/sbc_encoder.h"
+
+/* All the codecs of the SCO datapath work on frames of 7.5 ms, the duration of
+ * an mSBC frame */
+#define SCO_HCI_FRAME_DURATION_US 7500
+
+/* Default bounds of the target depth of the jitter buffers, in frames */
+#ifndef SCO_HCI_JITTER_MIN_FRAMES
+#define SCO_HCI_JITTER_MIN_FRAMES 2
+#endif
+#ifndef SCO_HCI_JITTER_MAX_FRAMES
+#define SCO_HCI_JITTER_MAX_FRAMES 16
+#endif
+
+/* ScoJitterBuffer carries PCM frames between the clock of an SCO link and the
+ * clock of the audio HAL, which drift and jitter against each other.
+ *
+ * Reads start once the buffer holds its target depth, and the target adapts:
+ * an underrun raises it by a frame, and every |kStableReads| reads without
+ * underrun lower it by a frame again. When the depth grows beyond twice the
+ * target, because the writer runs faster than the reader, the oldest frame is
+ * dropped so that the latency does not keep growing. After an underrun reads
+ * fail until the target depth is buffered again.
+ */
+class ScoJitterBuffer {
+ public:
+  /* Reads without underrun after which the target depth is lowered */
+  static constexpr size_t kStableReads = 800;
+
+  struct Stats {
+    uint64_t frames_written;
+    uint64_t frames_read;
+    uint64_t underruns;
+    uint64_t dropped_frames;
+    /* Sum and maximum of the depth in frames seen by the reads, that is the
+     * latency added by the buffer */
+    uint64_t depth_sum;
+    size_t max_depth;
+  };
+
+  ScoJitterBuffer(size_t frame_samples, size_t min_frames, size_t max_frames);
+
+  /* Queues a frame of |frame_samples| samples, dropping the oldest frame when
+   * the buffer is full */
+  void Write(const int16_t* frame);
+
+  /* Dequeues a frame into |frame|. Returns false and leaves |frame| untouched
+   * if no frame is available yet. */
+  bool Read(int16_t* frame);
+
+  /* Drops all the frames and restarts from the minimal target depth */
+  void Reset();
+
+  size_t FrameSamples() const { return frame_samples_; }
+  size_t Depth() const { return count_; }
+  size_t Target() const { return target_; }
+  const Stats& GetStats() const { return stats_; }
+
+ private:
+  void DropOldest();
+
+  size_t frame_samples_;
+  size_t min_frames_;
+  size_t max_frames_;
+  /* Twice the maximal target, so that a target deep buffer can still absorb a
+   * burst of writes */
+  size_t capacity_;
+  std::vector<int16_t> frames_;
+  size_t head_;
+  size_t count_;
+  size_t target_;
+  bool buffering_;
+  size_t stable_reads_;
+  Stats stats_;
+};
+
+/* ScoPlc conceals lost frames of decoded speech. A lost frame is replaced by
+ * the last good one, attenuated by half for every consecutive loss so that a
+ * burst of losses fades out to silence, and the first good frame after a loss
+ * is cross faded from the concealment over |kCrossFadeSamples| samples.
+ */
+class ScoPlc {
+ public:
+  static constexpr size_t kCrossFadeSamples = 16;
+  /* Consecutive lost frames after which the concealment is silent */
+  static constexpr size_t kMaxAttenuatedFrames = 8;
+
+  explicit ScoPlc(size_t frame_samples);
+
+  /* Takes note of the good frame |frame|, and cross fades it after a loss */
+  void GoodFrame(int16_t* frame);
+
+  /* Fills |frame| with the concealment of a lost frame */
+  void BadFrame(int16_t* frame);
+
+  uint64_t ConcealedFrames() const { return concealed_frames_; }
+
+ private:
+  /* Writes the concealment of the |lost|-th consecutive lost frame */
+  void Conceal(size_t lost, int16_t* frame) const;
+
+  std::vector<int16_t> last_good_;
+  size_t lost_frames_;
+  uint64_t concealed_frames_;
+};
+
+/* ScoCodec converts between the PCM frames of the audio HAL and the payload of
+ * the SCO packets exchanged with the controller, for the coding format the
+ * link was set up with.
+ */
+class ScoCodec {
+ public:
+  /* Receives a decoded or concealed frame */
+  using FrameSink = std::function<void(const int16_t* frame)>;
+  /* Provides the next frame to encode, returns false if none is available */
+  using FrameSource = std::function<bool(int16_t* frame)>;
+
+  virtual ~ScoCodec() = default;
+
+  /* PCM samples per frame of SCO_HCI_FRAME_DURATION_US */
+  virtual size_t FrameSamples() const = 0;
+  virtual uint32_t SampleRate() const = 0;
+
+  /* Decodes the |len| bytes of a received SCO packet. |lost| is set when the
+   * controller reported the data as not received or partially lost. Every
+   * frame completed by this data is given to |sink|, concealed if it was
+   * lost or could not be decoded. */
+  void Decode(const uint8_t* data, size_t len, bool lost,
+              const FrameSink& sink);
+
+  /* Fills |len| bytes of an SCO packet to send, encoding frames taken from
+   * |source| as needed. Silence is encoded when |source| has no frame. */
+  void Encode(uint8_t* data, size_t len, const FrameSource& source);
+
+  uint64_t DecodedFrames() const { return decoded_frames_; }
+  uint64_t ConcealedFrames() const { return plc_.ConcealedFrames(); }
+  uint64_t DecodeErrors() const { return decode_errors_; }
+
+  /* Returns the codec of |coding_format|, ESCO_CODING_FORMAT_MSBC or
+   * ESCO_CODING_FORMAT_CVSD, or nullptr if it is not supported */
+  static std::unique_ptr<ScoCodec> Create(uint8_t coding_format);
+
+ protected:
+  ScoCodec(size_t frame_samples, size_t frame_bytes);
+
+  /* Decodes the |frame_bytes| bytes of the packet frame at |data| into
+   * |frame|, returns false if they cannot be decoded */
+  virtual bool DecodeFrame(const uint8_t* data, int16_t* frame) = 0;
+
+  /* Looks for the start of a packet frame in the |len| bytes at |data|.
+   * Returns true and sets |offset| to its position if one is found, otherwise
+   * sets |offset| to the number of bytes that cannot be part of one. */
+  virtual bool FindFrame(const uint8_t* data, size_t len,
+                         size_t* offset) const = 0;
+
+  /* Encodes |frame| into |frame_bytes| bytes of a packet frame at |data| */
+  virtual void EncodeFrame(const int16_t* frame, uint8_t* data) = 0;
+
+ private:
+  void EmitFrame(bool good, const FrameSink& sink);
+
+  size_t frame_bytes_;
+  ScoPlc plc_;
+  std::vector<int16_t> rx_pcm_;
+  std::vector<int16_t> tx_pcm_;
+
+  /* Received bytes not decoded yet, and whether they were reported lost */
+  std::vector<uint8_t> rx_bytes_;
+  std::vector<bool> rx_lost_;
+  /* True once a frame boundary was found in the received bytes */
+  bool rx_synced_;
+  /* Bytes skipped while looking for a frame boundary */
+  size_t rx_skipped_;
+
+  /* Encoded frame being sent, and how many of its bytes were sent already */
+  std::vector<uint8_t> tx_frame_;
+  size_t tx_offset_;
+
+  uint64_t decoded_frames_;
+  uint64_t decode_errors_;
+};
+
+/* With CVSD the controller does the air coding over HCI, so packets carry the
+ * linear 16 bit little endian PCM at 8 kHz */
+class ScoCvsdCodec : public ScoCodec {
+ public:
+  static constexpr uint32_t kSampleRate = 8000;
+  static constexpr size_t kFrameSamples =
+      kSampleRate * SCO_HCI_FRAME_DURATION_US / 1000000;
+
+  ScoCvsdCodec();
+
+  size_t FrameSamples() const override { return kFrameSamples; }
+  uint32_t SampleRate() const override { return kSampleRate; }
+
+ protected:
+  bool DecodeFrame(const uint8_t* data, int16_t* frame) override;
+  bool FindFrame(const uint8_t* data, size_t len,
+                 size_t* offset) const override;
+  void EncodeFrame(const int16_t* frame, uint8_t* data) override;
+};
+
+/* mSBC packets carry the frames transparently, each one behind the two byte
+ * H2 synchronization header of HFP and followed by one byte of padding */
+class ScoMsbcCodec : public ScoCodec {
+ public:
+  static constexpr uint32_t kSampleRate = 16000;
+  static constexpr size_t kFrameSamples = SBC_MSBC_SAMPLES_PER_FRAME;
+  static constexpr size_t kH2HeaderLength = 2;
+  static constexpr size_t kPacketFrameLength =
+      kH2HeaderLength + SBC_MSBC_FRAME_LEN + 1;
+
+  ScoMsbcCodec();
+
+  size_t FrameSamples() const override { return kFrameSamples; }
+  uint32_t SampleRate() const override { return kSampleRate; }
+
+ protected:
+  bool DecodeFrame(const uint8_t* data, int16_t* frame) override;
+  bool FindFrame(const uint8_t* data, size_t len,
+                 size_t* offset) const override;
+  void EncodeFrame(const int16_t* frame, uint8_t* data) override;
+
+ private:
+  OI_CODEC_SBC_DECODER_CONTEXT decoder_context_;
+  uint32_t decoder_data_[CODEC_DATA_WORDS(1, SBC_CODEC_FAST_FILTER_BUFFERS)];
+  SBC_ENC_PARAMS encoder_params_;
+  uint8_t tx_sequence_;
+};
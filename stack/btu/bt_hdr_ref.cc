@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "bt_hdr_ref.h"
+
+#include <string.h>
+#include <mutex>
+#include <unordered_map>
+
+#include <base/logging.h>
+
+#include "osi/include/allocator.h"
+
+namespace {
+
+// The extra references of the shared buffers. A buffer that is not in the
+// map has a single reference.
+std::mutex ref_mutex;
+std::unordered_map<const BT_HDR*, size_t> extra_refs;
+
+// Drops the reference of the caller to |p_buf|. Returns true if it was the
+// last one.
+bool release_ref(const BT_HDR* p_buf) {
+  std::lock_guard<std::mutex> lock(ref_mutex);
+  auto it = extra_refs.find(p_buf);
+  if (it == extra_refs.end()) return true;
+  if (--it->second == 0) extra_refs.erase(it);
+  return false;
+}
+
+}  // namespace
+
+BT_HDR* bt_hdr_ref(BT_HDR* p_buf) {
+  CHECK(p_buf != nullptr);
+  std::lock_guard<std::mutex> lock(ref_mutex);
+  extra_refs[p_buf]++;
+  return p_buf;
+}
+
+void bt_hdr_unref(BT_HDR* p_buf) {
+  if (p_buf == nullptr) return;
+  if (release_ref(p_buf)) osi_free(p_buf);
+}
+
+bool bt_hdr_is_shared(const BT_HDR* p_buf) {
+  return bt_hdr_ref_count(p_buf) > 1;
+}
+
+size_t bt_hdr_ref_count(const BT_HDR* p_buf) {
+  std::lock_guard<std::mutex> lock(ref_mutex);
+  auto it = extra_refs.find(p_buf);
+  return it == extra_refs.end() ? 1 : it->second + 1;
+}
+
+BT_HDR* bt_hdr_make_writable(BT_HDR* p_buf) {
+  CHECK(p_buf != nullptr);
+  if (!bt_hdr_is_shared(p_buf)) return p_buf;
+
+  // The other references do not modify the buffer, it can be read unlocked
+  size_t size = sizeof(BT_HDR) + p_buf->offset + p_buf->len;
+  BT_HDR* p_copy = static_cast<BT_HDR*>(osi_malloc(size));
+  memcpy(p_copy, p_buf, size);
+
+  // Another reference may have been released meanwhile
+  if (release_ref(p_buf)) osi_free(p_buf);
+  return p_copy;
+}
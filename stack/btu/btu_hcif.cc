@@ -46,6 +46,7 @@
 #include "btif_config.h"
 #include "btm_api.h"
 #include "btm_int.h"
+#include "btm_iso_api.h"
 #include "btu.h"
 #include "common/metrics.h"
 #include "device/include/controller.h"
@@ -101,7 +102,7 @@ static void btu_hcif_read_clock_off_comp_evt(uint8_t* p);
 static void btu_hcif_conn_pkt_type_change_evt(void);
 static void btu_hcif_qos_violation_evt(uint8_t* p);
 static void btu_hcif_page_scan_mode_change_evt(void);
-static void btu_hcif_page_scan_rep_mode_chng_evt(void);
+static void btu_hcif_page_scan_rep_mode_chng_evt(uint8_t* p);
 static void btu_hcif_esco_connection_comp_evt(uint8_t* p);
 static void btu_hcif_esco_connection_chg_evt(uint8_t* p);
 
@@ -411,7 +412,7 @@ void btu_hcif_process_event(UNUSED_ATTR uint8_t controller_id, BT_HDR* p_msg) {
       btu_hcif_page_scan_mode_change_evt();
       break;
     case HCI_PAGE_SCAN_REP_MODE_CHNG_EVT:
-      btu_hcif_page_scan_rep_mode_chng_evt();
+      btu_hcif_page_scan_rep_mode_chng_evt(p);
       break;
     case HCI_ESCO_CONNECTION_COMP_EVT:
       btu_hcif_esco_connection_comp_evt(p);
@@ -506,6 +507,30 @@ void btu_hcif_process_event(UNUSED_ATTR uint8_t controller_id, BT_HDR* p_msg) {
         case HCI_LE_ADVERTISING_SET_TERMINATED_EVT:
           btm_le_on_advertising_set_terminated(p, hci_evt_len);
           break;
+
+        case HCI_BLE_PERIODIC_ADV_SYNC_EST_EVT:
+          btm_ble_process_periodic_sync_established(ble_evt_len, p);
+          break;
+
+        case HCI_BLE_PERIODIC_ADV_REPORT_EVT:
+          btm_ble_process_periodic_adv_pkt(ble_evt_len, p);
+          break;
+
+        case HCI_BLE_PERIODIC_ADV_SYNC_LOST_EVT:
+          btm_ble_process_periodic_sync_lost(ble_evt_len, p);
+          break;
+
+        case HCI_BLE_PERIODIC_ADV_SYNC_TRANSFER_RECEIVED_EVT:
+          btm_ble_process_periodic_sync_transfer(ble_evt_len, p);
+          break;
+
+        case HCI_BLE_CIS_EST_EVT:
+        case HCI_BLE_CIS_REQ_EVT:
+        case HCI_BLE_CREATE_BIG_CPL_EVT:
+        case HCI_BLE_TERM_BIG_CPL_EVT:
+          bluetooth::hci::IsoManager::GetInstance()->HandleHciEvent(
+              ble_sub_code, p, ble_evt_len);
+          break;
       }
       break;
     }
@@ -1128,6 +1153,11 @@ static void btu_hcif_disconnection_comp_evt(uint8_t* p) {
 
   handle = HCID_GET_HANDLE(handle);
 
+  /* A CIS is not known to L2CAP nor to the security manager */
+  if (bluetooth::hci::IsoManager::GetInstance()->HandleDisconnect(handle,
+                                                                  reason))
+    return;
+
   if ((reason != HCI_ERR_CONN_CAUSE_LOCAL_HOST) &&
       (reason != HCI_ERR_PEER_USER)) {
     /* Uncommon disconnection reasons */
@@ -1765,6 +1795,9 @@ static void btu_hcif_num_compl_data_pkts_evt(uint8_t* p, uint8_t evt_len) {
   /* Process for L2CAP and SCO */
   l2c_link_process_num_completed_pkts(p, evt_len);
 
+  /* and for the ISO channels */
+  bluetooth::hci::IsoManager::GetInstance()->HandleNumComplDataPkts(p, evt_len);
+
   /* Send on to SCO */
   /*?? No SCO for now */
 }
@@ -1981,7 +2014,15 @@ static void btu_hcif_page_scan_mode_change_evt(void) {}
  * Returns          void
  *
  ******************************************************************************/
-static void btu_hcif_page_scan_rep_mode_chng_evt(void) {}
+static void btu_hcif_page_scan_rep_mode_chng_evt(uint8_t* p) {
+  RawAddress bd_addr;
+  uint8_t page_scan_rep_mode;
+
+  STREAM_TO_BDADDR(bd_addr, p);
+  STREAM_TO_UINT8(page_scan_rep_mode, p);
+
+  btm_sec_update_page_scan_rep_mode(bd_addr, page_scan_rep_mode);
+}
 
 /**********************************************
  * Simple Pairing Events
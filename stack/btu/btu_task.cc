@@ -28,10 +28,13 @@
 #include "bte.h"
 #include "btif/include/btif_common.h"
 #include "common/message_loop_thread.h"
+#include "gd/os/trace.h"
 #include "osi/include/osi.h"
 #include "stack/btm/btm_int.h"
+#include "stack/include/btm_iso_api.h"
 #include "stack/include/btu.h"
 #include "stack/l2cap/l2c_int.h"
+#include "stack_config.h"
 
 #include <base/bind.h>
 #include <base/logging.h>
@@ -45,7 +48,16 @@ uint8_t btu_trace_level = HCI_INITIAL_TRACE_LEVEL;
 
 static MessageLoopThread main_thread("bt_main_thread");
 
+/* Threads of the tBTU_WORK_DOMAIN work */
+static MessageLoopThread smp_crypto_thread("bt_smp_crypto_thread");
+
 void btu_hci_msg_process(BT_HDR* p_msg) {
+  if (bluetooth::os::trace::IsEnabled()) {
+    bluetooth::os::trace::EndFlow(BTU_HCI_PACKET_TRACE_FLOW,
+                                  bluetooth::os::trace::FlowIdOf(p_msg));
+  }
+  bluetooth::os::trace::ScopedSlice slice("btu_hci_msg_process");
+
   /* Determine the input message type. */
   switch (p_msg->event & BT_EVT_MASK) {
     case BT_EVT_TO_BTU_HCI_ACL:
@@ -72,7 +84,7 @@ void btu_hci_msg_process(BT_HDR* p_msg) {
       break;
 
     case BT_EVT_TO_BTU_HCI_ISO:
-      // TODO: implement handler
+      bluetooth::hci::IsoManager::GetInstance()->HandleIsoData(p_msg);
       osi_free(p_msg);
       break;
 
@@ -108,6 +120,41 @@ bt_status_t do_in_main_thread_delayed(const base::Location& from_here,
   return BT_STATUS_SUCCESS;
 }
 
+static MessageLoopThread* btu_work_thread(tBTU_WORK_DOMAIN domain) {
+  switch (domain) {
+    case BTU_WORK_SMP_CRYPTO:
+      return &smp_crypto_thread;
+  }
+  return nullptr;
+}
+
+static void btu_run_work_and_reply(const base::Location& from_here,
+                                   base::OnceClosure task,
+                                   base::OnceClosure reply) {
+  std::move(task).Run();
+  do_in_main_thread(from_here, std::move(reply));
+}
+
+bt_status_t do_in_work_thread_and_reply(tBTU_WORK_DOMAIN domain,
+                                        const base::Location& from_here,
+                                        base::OnceClosure task,
+                                        base::OnceClosure reply) {
+  MessageLoopThread* thread = btu_work_thread(domain);
+  if (thread == nullptr || !thread->IsRunning() ||
+      !thread->DoInThread(from_here, base::BindOnce(&btu_run_work_and_reply,
+                                                    from_here, std::move(task),
+                                                    std::move(reply)))) {
+    LOG(ERROR) << __func__ << ": failed from " << from_here.ToString();
+    return BT_STATUS_FAIL;
+  }
+  return BT_STATUS_SUCCESS;
+}
+
+void btu_debug_dump(int fd) {
+  dprintf(fd, "\nMain thread tasks:\n");
+  main_thread.DumpTaskStatistics(fd);
+}
+
 void btu_task_start_up(UNUSED_ATTR void* context) {
   LOG(INFO) << "Bluetooth chip preload is complete";
 
@@ -128,12 +175,24 @@ void btu_task_start_up(UNUSED_ATTR void* context) {
    */
   module_init(get_module(BTE_LOGMSG_MODULE));
 
+  smp_crypto_thread.StartUp();
+  if (!smp_crypto_thread.IsRunning()) {
+    LOG(ERROR) << __func__ << ": unable to start the SMP crypto thread";
+  }
+
+  const stack_config_t* stack_config = stack_config_get_interface();
+  if (stack_config->get_task_statistics_enabled()) {
+    main_thread.EnableTaskStatistics(
+        std::chrono::milliseconds(stack_config->get_task_watchdog_ms()),
+        stack_config->get_task_watchdog_queue_depth());
+  }
+
   main_thread.StartUp();
   if (!main_thread.IsRunning()) {
     LOG(FATAL) << __func__ << ": unable to start btu message loop thread.";
   }
-  if (!main_thread.EnableRealTimeScheduling()) {
-    LOG(FATAL) << __func__ << ": unable to enable real time scheduling";
+  if (!main_thread.ApplyThreadRole(bluetooth::common::ThreadRole::STACK)) {
+    LOG(FATAL) << __func__ << ": unable to apply the stack thread profile";
   }
   if (do_in_jni_thread(FROM_HERE, base::Bind(btif_init_ok, 0, nullptr)) !=
       BT_STATUS_SUCCESS) {
@@ -142,6 +201,9 @@ void btu_task_start_up(UNUSED_ATTR void* context) {
 }
 
 void btu_task_shut_down(UNUSED_ATTR void* context) {
+  // The replies of the work in flight still find the main thread running
+  smp_crypto_thread.ShutDown();
+
   // Shutdown message loop on task completed
   main_thread.ShutDown();
 
@@ -315,6 +315,31 @@ BT_HDR* attp_build_value_cmd(uint16_t payload_size, uint8_t op_code,
   return p_buf;
 }
 
+/*******************************************************************************
+ *
+ * Function         attp_build_pdu_copy
+ *
+ * Description      Copy an ATT PDU built once for several links into a buffer
+ *                  of one link, truncated to the link |payload_size|.
+ *
+ * Returns          The new buffer.
+ *
+ ******************************************************************************/
+BT_HDR* attp_build_pdu_copy(uint16_t payload_size, const uint8_t* p_pdu,
+                            uint16_t len) {
+  if (len > payload_size) {
+    LOG(WARNING) << StringPrintf(
+        "attribute value too long, to be truncated to %d", payload_size - 3);
+    len = payload_size;
+  }
+
+  BT_HDR* p_buf = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + len + L2CAP_MIN_OFFSET);
+  p_buf->offset = L2CAP_MIN_OFFSET;
+  p_buf->len = len;
+  memcpy((uint8_t*)(p_buf + 1) + L2CAP_MIN_OFFSET, p_pdu, len);
+  return p_buf;
+}
+
 /*******************************************************************************
  *
  * Function         attp_send_msg_to_l2cap
@@ -325,6 +350,8 @@ BT_HDR* attp_build_value_cmd(uint16_t payload_size, uint8_t op_code,
 tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB& tcb, BT_HDR* p_toL2CAP) {
   uint16_t l2cap_ret;
 
+  gatt_tput_account(tcb, p_toL2CAP->len, true);
+
   if (tcb.att_lcid == L2CAP_ATT_CID)
     l2cap_ret = L2CA_SendFixedChnlData(L2CAP_ATT_CID, tcb.peer_bda, p_toL2CAP);
   else
@@ -129,9 +129,8 @@ static bool is_gatt_attr_type(const Uuid& uuid) {
 static void gatt_update_last_srv_info() {
   gatt_cb.last_service_handle = 0;
 
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    gatt_cb.last_service_handle = el.s_hdl;
-  }
+  if (!gatt_cb.srv_list_info->empty())
+    gatt_cb.last_service_handle = gatt_cb.srv_list_info->back().s_hdl;
 }
 
 /*******************************************************************************
@@ -265,18 +264,9 @@ uint16_t GATTS_AddService(tGATT_IF gatt_if, btgatt_db_element_t* service,
 
   /*this is a new application service start */
 
-  // find a place for this service in the list
-  auto lst_ptr = gatt_cb.srv_list_info;
-  auto it = lst_ptr->begin();
-  for (; it != lst_ptr->end(); it++) {
-    if (list.asgn_range.s_handle < it->s_hdl) break;
-  }
-  auto rit = lst_ptr->emplace(it);
-
-  tGATT_SRV_LIST_ELEM& elem = *rit;
+  tGATT_SRV_LIST_ELEM& elem =
+      gatt_sr_add_srv(list.asgn_range.s_handle, list.asgn_range.e_handle);
   elem.gatt_if = gatt_if;
-  elem.s_hdl = list.asgn_range.s_handle;
-  elem.e_hdl = list.asgn_range.e_handle;
   elem.p_db = &list.svc_db;
   elem.is_primary = list.asgn_range.is_primary;
 
@@ -389,67 +379,137 @@ void GATTS_StopService(uint16_t service_handle) {
     SDP_DeleteRecord(it->sdp_handle);
   }
 
-  gatt_cb.srv_list_info->erase(it);
+  gatt_sr_remove_srv(it);
   gatt_update_last_srv_info();
 }
 /*******************************************************************************
  *
- * Function         GATTs_HandleValueIndication
+ * Function         gatts_send_value_pdu
  *
- * Description      This function sends a handle value indication to a client.
- *
- * Parameter        conn_id: connection identifier.
- *                  attr_handle: Attribute handle of this handle value
- *                               indication.
- *                  val_len: Length of the indicated attribute value.
- *                  p_val: Pointer to the indicated attribute value data.
+ * Description      Sends a handle value notification or indication PDU, built
+ *                  once by GATTS_HandleValueFanOut, to the client of |conn_id|.
+ *                  An indication is queued while the client has not confirmed
+ *                  the previous one.
  *
  * Returns          GATT_SUCCESS if sucessfully sent or queued; otherwise error
  *                  code.
  *
  ******************************************************************************/
-tGATT_STATUS GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_handle,
-                                         uint16_t val_len, uint8_t* p_val) {
+static tGATT_STATUS gatts_send_value_pdu(uint16_t conn_id, uint8_t* p_pdu,
+                                         uint16_t pdu_len) {
   tGATT_IF gatt_if = GATT_GET_GATT_IF(conn_id);
   uint8_t tcb_idx = GATT_GET_TCB_IDX(conn_id);
   tGATT_REG* p_reg = gatt_get_regcb(gatt_if);
   tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(tcb_idx);
 
-  VLOG(1) << __func__;
   if ((p_reg == NULL) || (p_tcb == NULL)) {
     LOG(ERROR) << __func__ << ": Unknown  conn_id=" << loghex(conn_id);
     return (tGATT_STATUS)GATT_INVALID_CONN_ID;
   }
 
-  if (!GATT_HANDLE_IS_VALID(attr_handle)) return GATT_ILLEGAL_PARAMETER;
-
-  tGATT_VALUE indication;
-  indication.conn_id = conn_id;
-  indication.handle = attr_handle;
-  indication.len = val_len;
-  memcpy(indication.value, p_val, val_len);
-  indication.auth_req = GATT_AUTH_REQ_NONE;
-
-  if (GATT_HANDLE_IS_VALID(p_tcb->indicate_handle)) {
+  bool is_ind = p_pdu[0] == GATT_HANDLE_VALUE_IND;
+  if (is_ind && GATT_HANDLE_IS_VALID(p_tcb->indicate_handle)) {
     VLOG(1) << "Add a pending indication";
+    tGATT_VALUE indication;
+    indication.conn_id = conn_id;
+    uint8_t* p = p_pdu + 1;
+    STREAM_TO_UINT16(indication.handle, p);
+    indication.len = pdu_len - 3;
+    memcpy(indication.value, p, indication.len);
+    indication.auth_req = GATT_AUTH_REQ_NONE;
     gatt_add_pending_ind(p_tcb, &indication);
     return GATT_SUCCESS;
   }
 
-  tGATT_SR_MSG gatt_sr_msg;
-  gatt_sr_msg.attr_value = indication;
-  BT_HDR* p_msg =
-      attp_build_sr_msg(*p_tcb, GATT_HANDLE_VALUE_IND, &gatt_sr_msg);
-  if (!p_msg) return GATT_NO_RESOURCES;
-
+  BT_HDR* p_msg = attp_build_pdu_copy(p_tcb->payload_size, p_pdu, pdu_len);
   tGATT_STATUS cmd_status = attp_send_sr_msg(*p_tcb, p_msg);
-  if (cmd_status == GATT_SUCCESS || cmd_status == GATT_CONGESTED) {
-    p_tcb->indicate_handle = indication.handle;
+  if (is_ind && (cmd_status == GATT_SUCCESS || cmd_status == GATT_CONGESTED)) {
+    uint8_t* p = p_pdu + 1;
+    STREAM_TO_UINT16(p_tcb->indicate_handle, p);
     gatt_start_conf_timer(p_tcb);
   }
   return cmd_status;
 }
 
+/*******************************************************************************
+ *
+ * Function         GATTS_HandleValueFanOut
+ *
+ * Description      This function sends the same handle value notification or
+ *                  indication to several clients. The PDU is built once and
+ *                  copied to each link, truncated to the link MTU.
+ *
+ * Parameter        conn_ids: connection identifiers of the clients.
+ *                  num_conn_ids: number of entries in conn_ids.
+ *                  attr_handle: Attribute handle of this handle value
+ *                               notification or indication.
+ *                  val_len: Length of the attribute value.
+ *                  p_val: Pointer to the attribute value data.
+ *                  need_confirm: true to send an indication, false to send a
+ *                                notification.
+ *                  p_status: if not NULL, receives the status of each client,
+ *                            as returned by GATTS_HandleValueIndication or
+ *                            GATTS_HandleValueNotification.
+ *
+ * Returns          Number of clients the value was sent or queued to.
+ *
+ ******************************************************************************/
+uint8_t GATTS_HandleValueFanOut(const uint16_t* conn_ids, uint8_t num_conn_ids,
+                                uint16_t attr_handle, uint16_t val_len,
+                                uint8_t* p_val, bool need_confirm,
+                                tGATT_STATUS* p_status) {
+  VLOG(1) << __func__ << ": attr_handle=" << loghex(attr_handle)
+          << " num_conn_ids=" << +num_conn_ids;
+
+  uint8_t num_sent = 0;
+  if (!GATT_HANDLE_IS_VALID(attr_handle) || val_len > GATT_MAX_ATTR_LEN) {
+    if (p_status != NULL) {
+      for (uint8_t i = 0; i < num_conn_ids; i++)
+        p_status[i] = GATT_ILLEGAL_PARAMETER;
+    }
+    return num_sent;
+  }
+
+  /* opcode + handle + value */
+  uint8_t pdu[GATT_MAX_ATTR_LEN + 3];
+  uint8_t* p = pdu;
+  UINT8_TO_STREAM(p, need_confirm ? GATT_HANDLE_VALUE_IND
+                                  : GATT_HANDLE_VALUE_NOTIF);
+  UINT16_TO_STREAM(p, attr_handle);
+  ARRAY_TO_STREAM(p, p_val, val_len);
+
+  for (uint8_t i = 0; i < num_conn_ids; i++) {
+    tGATT_STATUS status = gatts_send_value_pdu(conn_ids[i], pdu, val_len + 3);
+    if (status == GATT_SUCCESS || status == GATT_CONGESTED) num_sent++;
+    if (p_status != NULL) p_status[i] = status;
+  }
+  return num_sent;
+}
+
+/*******************************************************************************
+ *
+ * Function         GATTs_HandleValueIndication
+ *
+ * Description      This function sends a handle value indication to a client.
+ *
+ * Parameter        conn_id: connection identifier.
+ *                  attr_handle: Attribute handle of this handle value
+ *                               indication.
+ *                  val_len: Length of the indicated attribute value.
+ *                  p_val: Pointer to the indicated attribute value data.
+ *
+ * Returns          GATT_SUCCESS if sucessfully sent or queued; otherwise error
+ *                  code.
+ *
+ ******************************************************************************/
+tGATT_STATUS GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_handle,
+                                         uint16_t val_len, uint8_t* p_val) {
+  tGATT_STATUS status;
+  GATTS_HandleValueFanOut(&conn_id, 1, attr_handle, val_len, p_val, true,
+                          &status);
+  return status;
+}
+
 /*******************************************************************************
  *
  * Function         GATTS_HandleValueNotification
@@ -468,38 +528,10 @@ tGATT_STATUS GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_handle,
 tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
                                            uint16_t attr_handle,
                                            uint16_t val_len, uint8_t* p_val) {
-  tGATT_VALUE notif;
-  tGATT_IF gatt_if = GATT_GET_GATT_IF(conn_id);
-  uint8_t tcb_idx = GATT_GET_TCB_IDX(conn_id);
-  tGATT_REG* p_reg = gatt_get_regcb(gatt_if);
-  tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(tcb_idx);
-
-  VLOG(1) << __func__;
-
-  if ((p_reg == NULL) || (p_tcb == NULL)) {
-    LOG(ERROR) << __func__ << "Unknown  conn_id: " << conn_id;
-    return (tGATT_STATUS)GATT_INVALID_CONN_ID;
-  }
-
-  if (!GATT_HANDLE_IS_VALID(attr_handle)) {
-    return GATT_ILLEGAL_PARAMETER;
-  }
-
-  notif.handle = attr_handle;
-  notif.len = val_len;
-  memcpy(notif.value, p_val, val_len);
-  notif.auth_req = GATT_AUTH_REQ_NONE;
-
-  tGATT_STATUS cmd_sent;
-  tGATT_SR_MSG gatt_sr_msg;
-  gatt_sr_msg.attr_value = notif;
-  BT_HDR* p_buf =
-      attp_build_sr_msg(*p_tcb, GATT_HANDLE_VALUE_NOTIF, &gatt_sr_msg);
-  if (p_buf != NULL) {
-    cmd_sent = attp_send_sr_msg(*p_tcb, p_buf);
-  } else
-    cmd_sent = GATT_NO_RESOURCES;
-  return cmd_sent;
+  tGATT_STATUS status;
+  GATTS_HandleValueFanOut(&conn_id, 1, attr_handle, val_len, p_val, false,
+                          &status);
+  return status;
 }
 
 /*******************************************************************************
@@ -592,8 +624,17 @@ tGATT_STATUS GATTC_ConfigureMTU(uint16_t conn_id, uint16_t mtu) {
   tGATT_CLCB* p_clcb = gatt_clcb_alloc(conn_id);
   if (!p_clcb) return GATT_NO_RESOURCES;
 
-  p_clcb->p_tcb->payload_size = mtu;
   p_clcb->operation = GATTC_OPTYPE_CONFIG;
+
+  /* The MTU is exchanged once per connection: when the stack did it as the
+   * link came up, the request completes with the result of that exchange */
+  if (p_tcb->mtu_exchange == GATT_MTU_EXCHANGE_DONE) {
+    gatt_end_operation(p_clcb, GATT_SUCCESS, NULL);
+    return GATT_SUCCESS;
+  }
+  if (p_tcb->mtu_exchange == GATT_MTU_EXCHANGE_EARLY) return GATT_SUCCESS;
+
+  p_clcb->p_tcb->payload_size = mtu;
   tGATT_CL_MSG gatt_cl_msg;
   gatt_cl_msg.mtu = mtu;
   return attp_send_cl_msg(*p_clcb->p_tcb, p_clcb, GATT_REQ_MTU, &gatt_cl_msg);
@@ -799,6 +840,59 @@ tGATT_STATUS GATTC_Write(uint16_t conn_id, tGATT_WRITE_TYPE type,
   return GATT_SUCCESS;
 }
 
+/*******************************************************************************
+ *
+ * Function         GATTC_WriteNoRsp
+ *
+ * Description      This function is called to send a write without response to
+ *                  the server. Unlike GATTC_Write, it does not hold a client
+ *                  control block until the command is sent, so an application
+ *                  can have any number of them in flight on a link, bounded by
+ *                  the L2CAP buffers, and can send them while a request is
+ *                  outstanding. No completion callback is called. The write
+ *                  is neither signed nor authenticated, GATTC_Write should be
+ *                  used for those.
+ *
+ * Parameters       conn_id: connection identifier.
+ *                  handle - attribute handle to write.
+ *                  len - length of the value, at most MTU - 3.
+ *                  p_value - value to write.
+ *
+ * Returns          GATT_SUCCESS if the command was sent.
+ *                  GATT_CONGESTED if the command was sent but the link is now
+ *                  congested: no further command should be sent until the
+ *                  application congestion callback reports it is not.
+ *                  GATT_CMD_STARTED if the command was queued behind requests
+ *                  waiting to be sent.
+ *
+ ******************************************************************************/
+tGATT_STATUS GATTC_WriteNoRsp(uint16_t conn_id, uint16_t handle, uint16_t len,
+                              uint8_t* p_value) {
+  tGATT_IF gatt_if = GATT_GET_GATT_IF(conn_id);
+  uint8_t tcb_idx = GATT_GET_TCB_IDX(conn_id);
+  tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(tcb_idx);
+  tGATT_REG* p_reg = gatt_get_regcb(gatt_if);
+
+  if ((p_tcb == NULL) || (p_reg == NULL) || !GATT_HANDLE_IS_VALID(handle) ||
+      (len > p_tcb->payload_size - GATT_HDR_SIZE)) {
+    LOG(ERROR) << __func__ << " Illegal param: conn_id=" << loghex(conn_id)
+               << ", handle=" << loghex(handle) << ", len=" << +len;
+    return GATT_ILLEGAL_PARAMETER;
+  }
+
+  BT_HDR* p_cmd = attp_build_value_cmd(p_tcb->payload_size, GATT_CMD_WRITE,
+                                       handle, 0, len, p_value);
+
+  /* Keep the order of the commands that wait behind an outstanding request,
+   * the outstanding request itself does not hold a command back. */
+  if (!p_tcb->cl_cmd_q.empty() && p_tcb->cl_cmd_q.back().to_send) {
+    gatt_cmd_enq(*p_tcb, NULL, true, GATT_CMD_WRITE, p_cmd);
+    return GATT_CMD_STARTED;
+  }
+
+  return attp_send_msg_to_l2cap(*p_tcb, p_cmd);
+}
+
 /*******************************************************************************
  *
  * Function         GATTC_ExecuteWrite
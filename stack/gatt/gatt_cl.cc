@@ -27,6 +27,8 @@
 #include <string.h>
 #include "bt_common.h"
 #include "bt_utils.h"
+#include "common/metrics.h"
+#include "common/time_util.h"
 #include "gatt_int.h"
 #include "l2c_api.h"
 #include "log/log.h"
@@ -1005,6 +1007,38 @@ void gatt_process_mtu_rsp(tGATT_TCB& tcb, tGATT_CLCB* p_clcb, uint16_t len,
                                      tcb.payload_size);
   gatt_end_operation(p_clcb, status, NULL);
 }
+
+/*******************************************************************************
+ *
+ * Function         gatt_mtu_exchange_cmpl
+ *
+ * Description      Complete the MTU exchange the stack started when the link
+ *                  came up, and the MTU requests of the applications that
+ *                  waited for it.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_mtu_exchange_cmpl(tGATT_TCB& tcb, tGATT_STATUS status) {
+  /* on failure, the applications may still try on their own */
+  tcb.mtu_exchange =
+      status == GATT_SUCCESS ? GATT_MTU_EXCHANGE_DONE : GATT_MTU_EXCHANGE_NONE;
+
+  if (status == GATT_SUCCESS) {
+    int64_t duration_ms =
+        bluetooth::common::time_get_os_boottime_ms() - tcb.conn_start_ms;
+    VLOG(1) << __func__ << ": mtu=" << tcb.payload_size << " " << duration_ms
+            << " ms after the connection";
+    bluetooth::common::BluetoothMetricsLogger::GetInstance()
+        ->LogGattMtuExchange(duration_ms);
+  }
+
+  for (tGATT_CLCB& clcb : gatt_cb.clcb) {
+    if (clcb.in_use && clcb.p_tcb == &tcb &&
+        clcb.operation == GATTC_OPTYPE_CONFIG)
+      gatt_end_operation(&clcb, status, NULL);
+  }
+}
 /*******************************************************************************
  *
  * Function         gatt_cmd_to_rsp_code
@@ -1045,8 +1079,8 @@ bool gatt_cl_send_next_cmd_inq(tGATT_TCB& tcb) {
       uint8_t rsp_code;
       tGATT_CLCB* p_clcb = gatt_cmd_dequeue(tcb, &rsp_code);
 
-      /* send command complete callback here */
-      gatt_end_operation(p_clcb, att_ret, NULL);
+      /* send command complete callback here, GATTC_WriteNoRsp has none */
+      if (p_clcb != NULL) gatt_end_operation(p_clcb, att_ret, NULL);
 
       /* if no ack needed, keep sending */
       if (att_ret == GATT_SUCCESS) continue;
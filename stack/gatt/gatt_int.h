@@ -30,7 +30,10 @@
 #include <base/strings/stringprintf.h>
 #include <string.h>
 #include <list>
+#include <map>
+#include <set>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #define GATT_CREATE_CONN_ID(tcb_idx, gatt_if) \
@@ -179,6 +182,8 @@ typedef struct {
 */
 typedef struct {
   std::vector<tGATT_ATTR> attr_list; /* pointer to the attributes */
+  /* (type, handle) of all the attributes, to look them up by type */
+  std::set<std::pair<bluetooth::Uuid, uint16_t>> uuid_index;
   uint16_t end_handle;       /* Last handle number           */
   uint16_t next_handle;      /* Next usable handle value     */
 } tGATT_SVC_DB;
@@ -234,6 +239,13 @@ typedef struct {
 
 typedef uint8_t tGATT_CH_STATE;
 
+/* ATT MTU exchange of a LE connection */
+#define GATT_MTU_EXCHANGE_NONE 0  /* left to the applications */
+#define GATT_MTU_EXCHANGE_EARLY 1 /* started by the stack on connection */
+#define GATT_MTU_EXCHANGE_DONE 2  /* done by the stack */
+
+typedef uint8_t tGATT_MTU_EXCHANGE;
+
 #define GATT_GATT_START_HANDLE 1
 #define GATT_GAP_START_HANDLE 20
 #define GATT_APP_START_HANDLE 40
@@ -273,6 +285,8 @@ typedef struct {
 
   uint16_t att_lcid; /* L2CAP channel ID for ATT */
   uint16_t payload_size;
+  tGATT_MTU_EXCHANGE mtu_exchange;
+  uint64_t conn_start_ms; /* time the ATT channel came up */
 
   tGATT_CH_STATE ch_state;
   uint8_t ch_flags;
@@ -293,6 +307,21 @@ typedef struct {
   std::queue<tGATT_CMD_Q> cl_cmd_q;
   alarm_t* ind_ack_timer; /* local app confirm to indication timer */
 
+  /* LE connection parameters before the throughput mode, 0 if unknown */
+  uint16_t conn_interval;
+  uint16_t conn_latency;
+  uint16_t conn_timeout;
+
+  /* throughput mode, see gatt_tput_account */
+  bool tput_mode;
+  alarm_t* tput_timer;           /* idle check of the throughput mode */
+  uint64_t tput_window_start_us; /* start of the current measure window */
+  uint32_t tput_window_bytes;    /* ATT bytes sent and received in it */
+  uint32_t tput_kbps;            /* rate of the last measure window */
+  uint32_t tput_max_kbps;
+  uint64_t tx_bytes;
+  uint64_t rx_bytes;
+
   bool in_use;
   uint8_t tcb_idx;
 } tGATT_TCB;
@@ -364,6 +393,8 @@ typedef struct {
   tGATT_IF gatt_if;
   std::list<tGATT_HDL_LIST_ELEM>* hdl_list_info;
   std::list<tGATT_SRV_LIST_ELEM>* srv_list_info;
+  /* srv_list_info elements by service ending handle */
+  std::map<uint16_t, std::list<tGATT_SRV_LIST_ELEM>::iterator>* srv_list_index;
 
   fixed_queue_t* srv_chg_clt_q; /* service change clients queue */
   tGATT_REG cl_rcb[GATT_MAX_APPS];
@@ -414,6 +445,7 @@ extern bool gatt_connect(const RawAddress& rem_bda, tGATT_TCB* p_tcb,
                          tBT_TRANSPORT transport, uint8_t initiating_phys,
                          tGATT_IF gatt_if);
 extern void gatt_data_process(tGATT_TCB& p_tcb, BT_HDR* p_buf);
+extern void gatt_tput_account(tGATT_TCB& tcb, uint16_t len, bool is_tx);
 extern void gatt_update_app_use_link_flag(tGATT_IF gatt_if, tGATT_TCB* p_tcb,
                                           bool is_add, bool check_acl_link);
 
@@ -439,6 +471,11 @@ extern tGATT_STATUS attp_send_cl_msg(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
 extern BT_HDR* attp_build_sr_msg(tGATT_TCB& tcb, uint8_t op_code,
                                  tGATT_SR_MSG* p_msg);
 extern tGATT_STATUS attp_send_sr_msg(tGATT_TCB& tcb, BT_HDR* p_msg);
+extern BT_HDR* attp_build_value_cmd(uint16_t payload_size, uint8_t op_code,
+                                    uint16_t handle, uint16_t offset,
+                                    uint16_t len, uint8_t* p_data);
+extern BT_HDR* attp_build_pdu_copy(uint16_t payload_size, const uint8_t* p_pdu,
+                                   uint16_t len);
 extern tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB& tcb, BT_HDR* p_toL2CAP);
 
 /* utility functions */
@@ -490,6 +527,10 @@ extern bool gatt_auto_connect_dev_remove(tGATT_IF gatt_if,
 /* server function */
 extern std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle);
+extern std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_first_srv(
+    uint16_t handle);
+extern tGATT_SRV_LIST_ELEM& gatt_sr_add_srv(uint16_t s_hdl, uint16_t e_hdl);
+extern void gatt_sr_remove_srv(std::list<tGATT_SRV_LIST_ELEM>::iterator it);
 extern tGATT_STATUS gatt_sr_process_app_rsp(tGATT_TCB& tcb, tGATT_IF gatt_if,
                                             uint32_t trans_id, uint8_t op_code,
                                             tGATT_STATUS status,
@@ -540,6 +581,7 @@ extern void gatt_cleanup_upon_disc(const RawAddress& bda, uint16_t reason,
                                    tBT_TRANSPORT transport);
 extern void gatt_end_operation(tGATT_CLCB* p_clcb, tGATT_STATUS status,
                                void* p_data);
+extern void gatt_mtu_exchange_cmpl(tGATT_TCB& tcb, tGATT_STATUS status);
 
 extern void gatt_act_discovery(tGATT_CLCB* p_clcb);
 extern void gatt_act_read(tGATT_CLCB* p_clcb, uint16_t offset);
@@ -588,5 +630,6 @@ extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB* p_db, bool is_long,
                                                tGATT_SEC_FLAG sec_flag,
                                                uint8_t key_size);
 extern bluetooth::Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db);
+extern tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle);
 
 #endif
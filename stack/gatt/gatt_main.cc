@@ -24,11 +24,14 @@
 
 #include "bt_target.h"
 
+#include <stdio.h>
+
 #include "bt_common.h"
 #include "bt_utils.h"
 #include "btif_storage.h"
 #include "btm_ble_int.h"
 #include "btm_int.h"
+#include "common/time_util.h"
 #include "connection_manager.h"
 #include "device/include/interop.h"
 #include "gatt_int.h"
@@ -45,6 +48,16 @@ using base::StringPrintf;
  */
 #define GATT_MIN_BR_MTU_SIZE 48
 
+/* Throughput mode: an LE connection with more than GATT_TPUT_ENTER_KBPS of
+ * ATT traffic over a measure window gets a short connection interval and a
+ * high link priority, until its traffic falls below GATT_TPUT_EXIT_KBPS */
+#define GATT_TPUT_WINDOW_US (1000 * 1000)
+#define GATT_TPUT_IDLE_MS 2000
+#define GATT_TPUT_ENTER_KBPS 32
+#define GATT_TPUT_EXIT_KBPS 8
+#define GATT_TPUT_CONN_INT_MIN BTM_BLE_CONN_INT_MIN /* 7.5 ms */
+#define GATT_TPUT_CONN_INT_MAX 0x000C               /* 15 ms */
+
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /******************************************************************************/
@@ -69,7 +82,9 @@ static void gatt_l2cif_disconnect_cfm_cback(uint16_t l2cap_cid,
                                             uint16_t result);
 static void gatt_l2cif_data_ind_cback(uint16_t l2cap_cid, BT_HDR* p_msg);
 static void gatt_send_conn_cback(tGATT_TCB* p_tcb);
+static void gatt_exchange_mtu_on_connect(tGATT_TCB* p_tcb);
 static void gatt_l2cif_congest_cback(uint16_t cid, bool congested);
+static void gatt_tput_timeout(void* data);
 
 static const tL2CAP_APPL_INFO dyn_info = {gatt_l2cif_connect_ind_cback,
                                           gatt_l2cif_connect_cfm_cback,
@@ -133,6 +148,8 @@ void gatt_init(void) {
 
   gatt_cb.hdl_list_info = new std::list<tGATT_HDL_LIST_ELEM>();
   gatt_cb.srv_list_info = new std::list<tGATT_SRV_LIST_ELEM>();
+  gatt_cb.srv_list_index =
+      new std::map<uint16_t, std::list<tGATT_SRV_LIST_ELEM>::iterator>();
   gatt_profile_db_init();
 }
 
@@ -165,12 +182,17 @@ void gatt_free(void) {
     alarm_free(gatt_cb.tcb[i].ind_ack_timer);
     gatt_cb.tcb[i].ind_ack_timer = NULL;
 
+    alarm_free(gatt_cb.tcb[i].tput_timer);
+    gatt_cb.tcb[i].tput_timer = NULL;
+
     fixed_queue_free(gatt_cb.tcb[i].sr_cmd.multi_rsp_q, NULL);
     gatt_cb.tcb[i].sr_cmd.multi_rsp_q = NULL;
   }
 
   gatt_cb.hdl_list_info->clear();
   gatt_cb.hdl_list_info = nullptr;
+  delete gatt_cb.srv_list_index;
+  gatt_cb.srv_list_index = nullptr;
   gatt_cb.srv_list_info->clear();
   gatt_cb.srv_list_info = nullptr;
 }
@@ -424,6 +446,7 @@ static void gatt_le_connect_cback(uint16_t chan, const RawAddress& bd_addr,
       p_tcb->payload_size = GATT_DEF_BLE_MTU_SIZE;
 
       gatt_send_conn_cback(p_tcb);
+      gatt_exchange_mtu_on_connect(p_tcb);
     }
     if (check_srv_chg) gatt_chk_srv_chg(p_srv_chg_clt);
   }
@@ -443,12 +466,27 @@ static void gatt_le_connect_cback(uint16_t chan, const RawAddress& bd_addr,
     p_tcb->payload_size = GATT_DEF_BLE_MTU_SIZE;
 
     gatt_send_conn_cback(p_tcb);
+    gatt_exchange_mtu_on_connect(p_tcb);
     if (check_srv_chg) {
       gatt_chk_srv_chg(p_srv_chg_clt);
     }
   }
 }
 
+/** As central, exchange the ATT MTU as soon as the ATT channel is up instead
+ * of on the first request of an application, so that the exchange runs while
+ * the controller updates the data length and the PHY of the link, and the
+ * service discovery or the first reads don't wait for it */
+static void gatt_exchange_mtu_on_connect(tGATT_TCB* p_tcb) {
+  p_tcb->conn_start_ms = bluetooth::common::time_get_os_boottime_ms();
+  if (L2CA_GetBleConnRole(p_tcb->peer_bda) != HCI_ROLE_MASTER) return;
+
+  uint16_t conn_id = GATT_CREATE_CONN_ID(p_tcb->tcb_idx, gatt_cb.gatt_if);
+  tGATT_STATUS status = GATTC_ConfigureMTU(conn_id, GATT_MAX_MTU_SIZE);
+  if (status == GATT_SUCCESS || status == GATT_CMD_STARTED)
+    p_tcb->mtu_exchange = GATT_MTU_EXCHANGE_EARLY;
+}
+
 /** This function is called to process the congestion callback from lcb */
 static void gatt_channel_congestion(tGATT_TCB* p_tcb, bool congested) {
   uint8_t i = 0;
@@ -502,6 +540,13 @@ void gatt_notify_conn_update(uint16_t handle, uint16_t interval,
       gatt_find_tcb_by_addr(p_dev_rec->ble.pseudo_addr, BT_TRANSPORT_LE);
   if (!p_tcb) return;
 
+  /* Keep the parameters to go back to after the throughput mode */
+  if (status == HCI_SUCCESS && !p_tcb->tput_mode) {
+    p_tcb->conn_interval = interval;
+    p_tcb->conn_latency = latency;
+    p_tcb->conn_timeout = timeout;
+  }
+
   for (int i = 0; i < GATT_MAX_APPS; i++) {
     tGATT_REG* p_reg = &gatt_cb.cl_rcb[i];
     if (p_reg->in_use && p_reg->app_cb.p_conn_update_cb) {
@@ -852,6 +897,8 @@ void gatt_data_process(tGATT_TCB& tcb, BT_HDR* p_buf) {
     return;
   }
 
+  gatt_tput_account(tcb, p_buf->len, false);
+
   uint16_t msg_len = p_buf->len - 1;
   STREAM_TO_UINT8(op_code, p);
 
@@ -878,6 +925,123 @@ void gatt_data_process(tGATT_TCB& tcb, BT_HDR* p_buf) {
   }
 }
 
+static void gatt_tput_start(tGATT_TCB& tcb) {
+  uint16_t min_interval = GATT_TPUT_CONN_INT_MIN;
+  uint16_t max_interval = GATT_TPUT_CONN_INT_MAX;
+
+  VLOG(1) << __func__ << ": " << tcb.peer_bda << " " << tcb.tput_kbps
+          << " kbps";
+
+  tcb.tput_mode = true;
+  L2CA_AdjustConnectionIntervals(&min_interval, &max_interval,
+                                 BTM_BLE_CONN_INT_MIN);
+  L2CA_UpdateBleConnParams(tcb.peer_bda, min_interval, max_interval, 0,
+                           BTM_BLE_CONN_TIMEOUT_DEF);
+
+  /* A high priority link gets a larger share of the controller buffers, and
+   * its queue is served first when buffers are freed */
+  L2CA_SetLeFixedChannelAclPriority(tcb.peer_bda, L2CAP_ATT_CID,
+                                    L2CAP_PRIORITY_HIGH);
+
+  alarm_set_on_mloop(tcb.tput_timer, GATT_TPUT_IDLE_MS, gatt_tput_timeout,
+                     &tcb);
+}
+
+static void gatt_tput_stop(tGATT_TCB& tcb) {
+  VLOG(1) << __func__ << ": " << tcb.peer_bda << " " << tcb.tput_kbps
+          << " kbps";
+
+  tcb.tput_mode = false;
+  L2CA_SetLeFixedChannelAclPriority(tcb.peer_bda, L2CAP_ATT_CID,
+                                    L2CAP_PRIORITY_NORMAL);
+
+  if (tcb.conn_interval != 0) {
+    L2CA_UpdateBleConnParams(tcb.peer_bda, tcb.conn_interval,
+                             tcb.conn_interval, tcb.conn_latency,
+                             tcb.conn_timeout);
+  } else {
+    L2CA_UpdateBleConnParams(tcb.peer_bda, BTM_BLE_CONN_INT_MIN_DEF,
+                             BTM_BLE_CONN_INT_MAX_DEF,
+                             BTM_BLE_CONN_SLAVE_LATENCY_DEF,
+                             BTM_BLE_CONN_TIMEOUT_DEF);
+  }
+}
+
+static void gatt_tput_timeout(void* data) {
+  tGATT_TCB* p_tcb = (tGATT_TCB*)data;
+
+  if (!p_tcb->in_use || !p_tcb->tput_mode) return;
+
+  /* Close the current window if it is over */
+  gatt_tput_account(*p_tcb, 0, true);
+
+  if (p_tcb->tput_kbps < GATT_TPUT_EXIT_KBPS) {
+    gatt_tput_stop(*p_tcb);
+    return;
+  }
+
+  alarm_set_on_mloop(p_tcb->tput_timer, GATT_TPUT_IDLE_MS, gatt_tput_timeout,
+                     p_tcb);
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_tput_account
+ *
+ * Description      This function accounts |len| bytes of ATT PDU sent or
+ *                  received on an LE connection. Once a measure window is
+ *                  over, its rate decides whether the connection enters the
+ *                  throughput mode, left when idle by gatt_tput_timeout.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_tput_account(tGATT_TCB& tcb, uint16_t len, bool is_tx) {
+  if (tcb.transport != BT_TRANSPORT_LE) return;
+
+  if (is_tx)
+    tcb.tx_bytes += len;
+  else
+    tcb.rx_bytes += len;
+
+  uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+  uint64_t elapsed_us = now_us - tcb.tput_window_start_us;
+
+  if (elapsed_us >= GATT_TPUT_WINDOW_US) {
+    /* bits per ms are kbps */
+    tcb.tput_kbps = (uint32_t)(tcb.tput_window_bytes * 8000ULL / elapsed_us);
+    if (tcb.tput_kbps > tcb.tput_max_kbps) tcb.tput_max_kbps = tcb.tput_kbps;
+
+    tcb.tput_window_start_us = now_us;
+    tcb.tput_window_bytes = 0;
+
+    if (!tcb.tput_mode && tcb.tput_kbps >= GATT_TPUT_ENTER_KBPS &&
+        gatt_get_ch_state(&tcb) == GATT_CH_OPEN)
+      gatt_tput_start(tcb);
+  }
+
+  tcb.tput_window_bytes += len;
+}
+
+/* Dumps the throughput of the GATT connections */
+void gatt_debug_dump(int fd) {
+  dprintf(fd, "\nGATT connections:\n");
+
+  for (int i = 0; i < GATT_MAX_PHY_CHANNEL; i++) {
+    const tGATT_TCB& tcb = gatt_cb.tcb[i];
+    if (!tcb.in_use) continue;
+
+    dprintf(fd,
+            "  %s %s mtu: %d throughput mode: %s kbps: %u (max %u) tx: %llu "
+            "rx: %llu bytes\n",
+            tcb.peer_bda.ToString().c_str(),
+            tcb.transport == BT_TRANSPORT_LE ? "LE" : "BR/EDR",
+            tcb.payload_size, tcb.tput_mode ? "on" : "off", tcb.tput_kbps,
+            tcb.tput_max_kbps, (unsigned long long)tcb.tx_bytes,
+            (unsigned long long)tcb.rx_bytes);
+  }
+}
+
 /** Add a bonded dev to the service changed client list */
 void gatt_add_a_bonded_dev_for_srv_chg(const RawAddress& bda) {
   tGATTS_SRV_CHG_REQ req;
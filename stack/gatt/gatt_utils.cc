@@ -433,6 +433,7 @@ tGATT_TCB* gatt_allocate_tcb_by_bdaddr(const RawAddress& bda,
     p_tcb->pending_ind_q = fixed_queue_new(SIZE_MAX);
     p_tcb->conf_timer = alarm_new("gatt.conf_timer");
     p_tcb->ind_ack_timer = alarm_new("gatt.ind_ack_timer");
+    p_tcb->tput_timer = alarm_new("gatt.tput_timer");
     p_tcb->in_use = true;
     p_tcb->tcb_idx = i;
     p_tcb->transport = transport;
@@ -662,15 +663,57 @@ void gatt_ind_ack_timeout(void* data) {
  ******************************************************************************/
 std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle) {
-  auto it = gatt_cb.srv_list_info->begin();
+  auto it = gatt_sr_find_first_srv(handle);
+  if (it != gatt_cb.srv_list_info->end() && it->s_hdl <= handle) return it;
 
-  for (; it != gatt_cb.srv_list_info->end(); it++) {
-    if (it->s_hdl <= handle && it->e_hdl >= handle) {
-      return it;
-    }
-  }
+  return gatt_cb.srv_list_info->end();
+}
 
-  return it;
+/*******************************************************************************
+ *
+ * Description      Search for the first service that ends at or after a
+ *                  specific handle. Services do not overlap, so the services
+ *                  of a handle range are this one and the following ones, as
+ *                  long as they start in the range.
+ *
+ * Returns          srv_list_info->end() if not found. Otherwise the service.
+ *
+ ******************************************************************************/
+std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_first_srv(
+    uint16_t handle) {
+  auto it = gatt_cb.srv_list_index->lower_bound(handle);
+  if (it == gatt_cb.srv_list_index->end()) return gatt_cb.srv_list_info->end();
+
+  return it->second;
+}
+
+/*******************************************************************************
+ *
+ * Description      Insert a started service in the handle ordered service
+ *                  list, and index it.
+ *
+ * Returns          The new service list element.
+ *
+ ******************************************************************************/
+tGATT_SRV_LIST_ELEM& gatt_sr_add_srv(uint16_t s_hdl, uint16_t e_hdl) {
+  auto it = gatt_cb.srv_list_info->emplace(gatt_sr_find_first_srv(s_hdl));
+  (*gatt_cb.srv_list_index)[e_hdl] = it;
+
+  it->s_hdl = s_hdl;
+  it->e_hdl = e_hdl;
+  return *it;
+}
+
+/*******************************************************************************
+ *
+ * Description      Remove a stopped service from the service list and index.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_sr_remove_srv(std::list<tGATT_SRV_LIST_ELEM>::iterator it) {
+  gatt_cb.srv_list_index->erase(it->e_hdl);
+  gatt_cb.srv_list_info->erase(it);
 }
 
 /*******************************************************************************
@@ -1226,10 +1269,16 @@ void gatt_end_operation(tGATT_CLCB* p_clcb, tGATT_STATUS status, void* p_data) {
 
   operation = p_clcb->operation;
   conn_id = p_clcb->conn_id;
+  tGATT_TCB* p_tcb = p_clcb->p_tcb;
   alarm_cancel(p_clcb->gatt_rsp_timer_ent);
 
   gatt_clcb_dealloc(p_clcb);
 
+  if (op == GATTC_OPTYPE_CONFIG && p_tcb != NULL &&
+      p_tcb->mtu_exchange == GATT_MTU_EXCHANGE_EARLY &&
+      GATT_GET_GATT_IF(conn_id) == gatt_cb.gatt_if)
+    gatt_mtu_exchange_cmpl(*p_tcb, status);
+
   if (p_disc_cmpl_cb && (op == GATTC_OPTYPE_DISCOVERY))
     (*p_disc_cmpl_cb)(conn_id, disc_type, status);
   else if (p_cmpl_cb && op)
@@ -1268,6 +1317,8 @@ void gatt_cleanup_upon_disc(const RawAddress& bda, uint16_t reason,
   p_tcb->ind_ack_timer = NULL;
   alarm_free(p_tcb->conf_timer);
   p_tcb->conf_timer = NULL;
+  alarm_free(p_tcb->tput_timer);
+  p_tcb->tput_timer = NULL;
   gatt_free_pending_ind(p_tcb);
   fixed_queue_free(p_tcb->sr_cmd.multi_rsp_q, NULL);
   p_tcb->sr_cmd.multi_rsp_q = NULL;
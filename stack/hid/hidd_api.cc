@@ -100,6 +100,7 @@ tHID_STATUS HID_DevRegister(tHID_DEV_HOST_CALLBACK* host_cback) {
     osi_free(hd_cb.pending_data);
     hd_cb.pending_data = NULL;
   }
+  hidd_conn_free_held_reports();
 
   return (HID_SUCCESS);
 }
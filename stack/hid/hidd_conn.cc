@@ -27,6 +27,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+
 #include "bt_types.h"
 
 #include "l2c_api.h"
@@ -39,11 +41,14 @@
 #include "hiddefs.h"
 
 #include "bt_utils.h"
+#include "common/time_util.h"
 #include "hidd_api.h"
 #include "hidd_int.h"
 
 #include "osi/include/osi.h"
 
+using bluetooth::common::time_get_os_boottime_us;
+
 static void hidd_l2cif_connect_ind(const RawAddress& bd_addr, uint16_t cid,
                                    uint16_t psm, uint8_t id);
 static void hidd_l2cif_connect_cfm(uint16_t cid, uint16_t result);
@@ -89,6 +94,8 @@ static void hidd_check_config_done() {
 
     hd_cb.device.state = HIDD_DEV_CONNECTED;
 
+    memset(&hd_cb.report_stats, 0, sizeof(hd_cb.report_stats));
+
     hd_cb.callback(hd_cb.device.addr, HID_DHOST_EVT_OPEN, 0, NULL);
 
     // send outstanding data on intr
@@ -511,6 +518,17 @@ static void hidd_l2cif_disconnect_ind(uint16_t cid, bool ack_needed) {
       osi_free(hd_cb.pending_data);
       hd_cb.pending_data = NULL;
     }
+    hidd_conn_free_held_reports();
+
+    const tHID_DEV_REPORT_STATS* p_stats = &hd_cb.report_stats;
+    if (p_stats->sent) {
+      HIDD_TRACE_EVENT(
+          "%s: input reports sent=%u held=%u dropped=%u latency "
+          "ave=%llu max=%llu us",
+          __func__, p_stats->sent, p_stats->held, p_stats->dropped,
+          (unsigned long long)(p_stats->total_latency_us / p_stats->sent),
+          (unsigned long long)p_stats->max_latency_us);
+    }
 
     hd_cb.device.state = HIDD_DEV_NO_CONN;
     p_hcon->conn_state = HID_CONN_STATE_UNUSED;
@@ -568,6 +586,74 @@ static void hidd_l2cif_disconnect_cfm(uint16_t cid, uint16_t result) {
   }
 }
 
+/* Records the latency of an input report written to L2CAP */
+static void hidd_report_sent(uint64_t submit_time_us) {
+  tHID_DEV_REPORT_STATS* p_stats = &hd_cb.report_stats;
+  uint64_t latency_us = time_get_os_boottime_us() - submit_time_us;
+
+  p_stats->sent++;
+  p_stats->total_latency_us += latency_us;
+  p_stats->max_latency_us = std::max(p_stats->max_latency_us, latency_us);
+}
+
+/* Holds an input report until the interrupt channel is no longer congested.
+ * Reports are held in the order they were submitted and none is replaced:
+ * relative and key reports carry changes, not states, so the host needs every
+ * one of them. */
+static void hidd_hold_report(uint8_t report_id, BT_HDR* p_buf,
+                             uint64_t submit_time_us) {
+  if (hd_cb.num_held_reports == HIDD_MAX_HELD_REPORTS) {
+    HIDD_TRACE_WARNING("%s: too many reports held, dropping report %d",
+                       __func__, report_id);
+    osi_free(p_buf);
+    hd_cb.report_stats.dropped++;
+    return;
+  }
+
+  hd_cb.report_stats.held++;
+  tHID_DEV_HELD_REPORT* p_report =
+      &hd_cb.held_reports[hd_cb.num_held_reports++];
+  p_report->submit_time_us = submit_time_us;
+  p_report->p_buf = p_buf;
+}
+
+/* Sends the held input reports until the interrupt channel is congested */
+static void hidd_send_held_reports() {
+  tHID_CONN* p_hcon = &hd_cb.device.conn;
+  uint8_t sent = 0;
+
+  while (sent < hd_cb.num_held_reports &&
+         !(p_hcon->conn_flags & HID_CONN_FLAGS_CONGESTED)) {
+    tHID_DEV_HELD_REPORT* p_report = &hd_cb.held_reports[sent++];
+    hidd_report_sent(p_report->submit_time_us);
+    if (L2CA_DataWrite(p_hcon->intr_cid, p_report->p_buf) ==
+        L2CAP_DW_CONGESTED) {
+      p_hcon->conn_flags |= HID_CONN_FLAGS_CONGESTED;
+    }
+  }
+
+  hd_cb.num_held_reports -= sent;
+  memmove(&hd_cb.held_reports[0], &hd_cb.held_reports[sent],
+          hd_cb.num_held_reports * sizeof(tHID_DEV_HELD_REPORT));
+}
+
+/*******************************************************************************
+ *
+ * Function         hidd_conn_free_held_reports
+ *
+ * Description      Drops the input reports held while the interrupt channel
+ *                  was congested
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void hidd_conn_free_held_reports(void) {
+  for (uint8_t i = 0; i < hd_cb.num_held_reports; i++) {
+    osi_free(hd_cb.held_reports[i].p_buf);
+  }
+  hd_cb.num_held_reports = 0;
+}
+
 /*******************************************************************************
  *
  * Function         hidd_l2cif_cong_ind
@@ -594,6 +680,7 @@ static void hidd_l2cif_cong_ind(uint16_t cid, bool congested) {
     p_hcon->conn_flags |= HID_CONN_FLAGS_CONGESTED;
   } else {
     p_hcon->conn_flags &= ~HID_CONN_FLAGS_CONGESTED;
+    hidd_send_held_reports();
   }
 }
 
@@ -859,6 +946,7 @@ tHID_STATUS hidd_conn_disconnect(void) {
     osi_free(hd_cb.pending_data);
     hd_cb.pending_data = NULL;
   }
+  hidd_conn_free_held_reports();
 
   p_hcon = &hd_cb.device.conn;
 
@@ -899,13 +987,18 @@ tHID_STATUS hidd_conn_send_data(uint8_t channel, uint8_t msg_type,
   uint8_t* p_out;
   uint16_t cid;
   uint16_t buf_size;
+  uint64_t submit_time_us = time_get_os_boottime_us();
+  // input reports are held while congested, instead of being dropped
+  bool is_intr_data =
+      msg_type == HID_TRANS_DATA && channel != HID_CHANNEL_CTRL;
 
   HIDD_TRACE_VERBOSE("%s: channel(%d), msg_type(%d), len(%d)", __func__,
                      channel, msg_type, len);
 
   p_hcon = &hd_cb.device.conn;
 
-  if (p_hcon->conn_flags & HID_CONN_FLAGS_CONGESTED) {
+  if ((p_hcon->conn_flags & HID_CONN_FLAGS_CONGESTED) &&
+      !(is_intr_data && hd_cb.device.state == HIDD_DEV_CONNECTED)) {
     return HID_ERR_CONGESTED;
   }
 
@@ -978,9 +1071,24 @@ tHID_STATUS hidd_conn_send_data(uint8_t channel, uint8_t msg_type,
     HIDD_TRACE_ERROR("%s: report sent", __func__);
   }
 #endif
+  if (is_intr_data && ((p_hcon->conn_flags & HID_CONN_FLAGS_CONGESTED) ||
+                       hd_cb.num_held_reports != 0)) {
+    HIDD_TRACE_VERBOSE("%s: report held", __func__);
+    hidd_hold_report(data, p_buf, submit_time_us);
+    hidd_send_held_reports();
+    return (HID_SUCCESS);
+  }
+
   HIDD_TRACE_VERBOSE("%s: report sent", __func__);
 
-  if (!L2CA_DataWrite(cid, p_buf)) return (HID_ERR_CONGESTED);
+  if (is_intr_data) hidd_report_sent(submit_time_us);
+
+  uint8_t status = L2CA_DataWrite(cid, p_buf);
+  if (status == L2CAP_DW_FAILED) return (HID_ERR_CONGESTED);
+
+  if (status == L2CAP_DW_CONGESTED && is_intr_data) {
+    p_hcon->conn_flags |= HID_CONN_FLAGS_CONGESTED;
+  }
 
   return (HID_SUCCESS);
 }
@@ -32,6 +32,27 @@
 
 enum { HIDD_DEV_NO_CONN, HIDD_DEV_CONNECTED };
 
+/* Input reports held in order while the interrupt channel is congested,
+ * further reports are dropped */
+#ifndef HIDD_MAX_HELD_REPORTS
+#define HIDD_MAX_HELD_REPORTS 32
+#endif
+
+typedef struct {
+  uint64_t submit_time_us; /* when the held report was submitted */
+  BT_HDR* p_buf;
+} tHID_DEV_HELD_REPORT;
+
+/* Input reports sent on the interrupt channel since the connection opened */
+typedef struct {
+  uint32_t sent;
+  uint32_t held;    /* sent late, once the congestion cleared */
+  uint32_t dropped; /* no room left to hold them */
+  /* from the submission of the report to its write to L2CAP */
+  uint64_t total_latency_us;
+  uint64_t max_latency_us;
+} tHID_DEV_REPORT_STATS;
+
 typedef struct device_ctb {
   bool in_use;
   RawAddress addr;
@@ -62,6 +83,10 @@ typedef struct dev_ctb {
 
   BT_HDR* pending_data;
 
+  tHID_DEV_HELD_REPORT held_reports[HIDD_MAX_HELD_REPORTS];
+  uint8_t num_held_reports;
+  tHID_DEV_REPORT_STATS report_stats;
+
   bool pending_vc_unplug;
 } tHID_DEV_CTB;
 
@@ -69,6 +94,7 @@ extern tHID_STATUS hidd_conn_reg(void);
 extern void hidd_conn_dereg(void);
 extern tHID_STATUS hidd_conn_initiate(void);
 extern tHID_STATUS hidd_conn_disconnect(void);
+extern void hidd_conn_free_held_reports(void);
 extern tHID_STATUS hidd_conn_send_data(uint8_t channel, uint8_t msg_type,
                                        uint8_t param, uint8_t data,
                                        uint16_t len, uint8_t* p_data);
@@ -56,10 +56,12 @@ void A2DP_UnloadEncoderAac(void);
 // The current A2DP codec config is in |a2dp_codec_config|.
 // |read_callback| is the callback for reading the input audio data.
 // |enqueue_callback| is the callback for enqueueing the encoded audio data.
+// |alloc_callback| is the callback for allocating the encoded audio packets.
 void a2dp_aac_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
                            A2dpCodecConfig* a2dp_codec_config,
                            a2dp_source_read_callback_t read_callback,
-                           a2dp_source_enqueue_callback_t enqueue_callback);
+                           a2dp_source_enqueue_callback_t enqueue_callback,
+                           a2dp_source_alloc_callback_t alloc_callback);
 
 // Cleanup the A2DP AAC encoder.
 void a2dp_aac_encoder_cleanup(void);
@@ -77,4 +79,10 @@ uint64_t a2dp_aac_get_encoder_interval_ms(void);
 // |timestamp_us| is the current timestamp (in microseconds).
 void a2dp_aac_send_frames(uint64_t timestamp_us);
 
+// Set transmit queue length for the A2DP AAC ABR (Adaptive Bit Rate).
+void a2dp_aac_set_transmit_queue_length(size_t transmit_queue_length);
+
+// Report that AAC encoded audio was dropped, so the ABR lowers the bit rate.
+void a2dp_aac_report_congestion(void);
+
 #endif  // A2DP_AAC_ENCODER_H
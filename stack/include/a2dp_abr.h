@@ -0,0 +1,62 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Interface to the A2DP ABR (Adaptive Bit Rate) of the codecs without a
+// vendor ABR library.
+//
+
+#ifndef A2DP_ABR_H
+#define A2DP_ABR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of bit rate levels. Level 0 is the bit rate the encoder was set up
+// with, the last level is the lowest bit rate.
+#define A2DP_ABR_NUM_LEVELS 5
+
+typedef struct {
+  uint64_t interval_ms;      // Encoder interval (in milliseconds)
+  uint32_t level;            // Current bit rate level
+  size_t last_txq_length;    // Transmit queue length at the previous tick
+  bool congestion_reported;  // Audio was dropped since the previous tick
+  uint32_t stable_ticks;     // Ticks the transmit queue stayed short
+  uint32_t raise_ticks;      // Stable ticks needed to raise the bit rate
+  size_t adjustments;        // Number of bit rate level changes
+} tA2DP_ABR;
+
+// Initializes the ABR state |p_abr| of an encoder sending audio every
+// |interval_ms| milliseconds. The bit rate level starts at 0.
+void a2dp_abr_init(tA2DP_ABR* p_abr, uint64_t interval_ms);
+
+// Reports that encoded audio was dropped before reaching the peer. The bit
+// rate is lowered on the next call to a2dp_abr_proc().
+void a2dp_abr_report_congestion(tA2DP_ABR* p_abr);
+
+// ABR main process, called once per encoder interval.
+// It picks the bit rate level from the A2DP transmit queue length
+// |transmit_queue_length| and the congestion reported since the previous call.
+// Returns true if the bit rate level changed.
+bool a2dp_abr_proc(tA2DP_ABR* p_abr, size_t transmit_queue_length);
+
+// Scales a codec bit rate parameter to the current bit rate level: |value| at
+// level 0, down to |min_value| at the last level.
+// Returns the parameter to use.
+uint32_t a2dp_abr_scale(const tA2DP_ABR* p_abr, uint32_t value,
+                        uint32_t min_value);
+
+#endif  // A2DP_ABR_H
@@ -506,6 +506,12 @@ typedef uint32_t (*a2dp_source_read_callback_t)(uint8_t* p_buf, uint32_t len);
 typedef bool (*a2dp_source_enqueue_callback_t)(BT_HDR* p_buf, size_t frames_n,
                                                uint32_t num_bytes);
 
+// Prototype for a callback to allocate an A2DP Source packet.
+// |size| is the size of the buffer in octets, including the BT_HDR.
+// The buffer is released with |osi_free| like any other packet.
+// Returns the allocated buffer.
+typedef BT_HDR* (*a2dp_source_alloc_callback_t)(size_t size);
+
 //
 // A2DP encoder callbacks interface.
 //
@@ -515,10 +521,12 @@ typedef struct {
   // The current A2DP codec config is in |a2dp_codec_config|.
   // |read_callback| is the callback for reading the input audio data.
   // |enqueue_callback| is the callback for enqueueing the encoded audio data.
+  // |alloc_callback| is the callback for allocating the encoded audio packets.
   void (*encoder_init)(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
                        A2dpCodecConfig* a2dp_codec_config,
                        a2dp_source_read_callback_t read_callback,
-                       a2dp_source_enqueue_callback_t enqueue_callback);
+                       a2dp_source_enqueue_callback_t enqueue_callback,
+                       a2dp_source_alloc_callback_t alloc_callback);
 
   // Cleanup the A2DP encoder.
   void (*encoder_cleanup)(void);
@@ -538,6 +546,10 @@ typedef struct {
 
   // Set transmit queue length for the A2DP encoder.
   void (*set_transmit_queue_length)(size_t transmit_queue_length);
+
+  // Report to the A2DP encoder that encoded audio was dropped before reaching
+  // the peer.
+  void (*report_congestion)(void);
 } tA2DP_ENCODER_INTERFACE;
 
 // Prototype for a callback to receive decoded audio data from a
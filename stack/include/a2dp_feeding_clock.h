@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Interface to the A2DP feeding clock: the PCM bytes an encoder has to read
+// at each media tick, from the timestamps of the ticks.
+//
+
+#ifndef A2DP_FEEDING_CLOCK_H
+#define A2DP_FEEDING_CLOCK_H
+
+#include <stdint.h>
+
+#include "a2dp_codec_api.h"
+
+typedef struct {
+  uint32_t counter;           // PCM bytes due and not read yet
+  uint32_t residue;           // Fraction of a byte due (in 1/10^7 bytes)
+  uint32_t bytes_per_tick;    // PCM bytes read each media tick
+  uint32_t bytes_per_second;  // PCM bytes played each second
+  uint64_t interval_100ns;    // Encoder interval (in 1/10 microseconds)
+  uint64_t last_tick_100ns;   // Timestamp of the previous tick
+} tA2DP_FEEDING_CLOCK;
+
+// Resets the feeding clock |p_clock| of an encoder fed with
+// |p_feeding_params| every |interval_ms| milliseconds. No PCM is due.
+void a2dp_feeding_clock_reset(tA2DP_FEEDING_CLOCK* p_clock,
+                              const tA2DP_FEEDING_PARAMS* p_feeding_params,
+                              uint64_t interval_ms);
+
+// Adds the PCM played since the previous tick to the bytes due, for a media
+// tick at |timestamp_us|. The first tick adds one interval. The fraction of
+// a byte left over is carried to the next tick, so the feeding does not
+// drift.
+// Returns the number of bytes added.
+uint32_t a2dp_feeding_clock_tick(tA2DP_FEEDING_CLOCK* p_clock,
+                                 uint64_t timestamp_us);
+
+// Returns the number of whole frames of |pcm_bytes_per_frame| bytes due.
+uint32_t a2dp_feeding_clock_frames(const tA2DP_FEEDING_CLOCK* p_clock,
+                                   uint32_t pcm_bytes_per_frame);
+
+// Removes |num_frames| frames of |pcm_bytes_per_frame| bytes from the bytes
+// due, once the encoder has read them.
+void a2dp_feeding_clock_consume(tA2DP_FEEDING_CLOCK* p_clock,
+                                uint32_t num_frames,
+                                uint32_t pcm_bytes_per_frame);
+
+// Puts back |num_frames| frames of |pcm_bytes_per_frame| bytes that could
+// not be read, to be read at the next tick.
+void a2dp_feeding_clock_underflow(tA2DP_FEEDING_CLOCK* p_clock,
+                                  uint32_t num_frames,
+                                  uint32_t pcm_bytes_per_frame);
+
+// Drops the bytes due, keeping the time of the previous tick.
+void a2dp_feeding_clock_flush(tA2DP_FEEDING_CLOCK* p_clock);
+
+#endif  // A2DP_FEEDING_CLOCK_H
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// PCM format conversions shared by the A2DP codecs: deinterleaving of the
+// stereo PCM read from the audio HAL into one buffer per channel.
+//
+
+#ifndef A2DP_PCM_H
+#define A2DP_PCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Splits |num_frames| frames of interleaved 16-bit stereo PCM |p_pcm| into
+// |p_left| and |p_right|, one 32-bit word per sample. The samples are zero
+// extended, as expected by the aptX encoder.
+void a2dp_pcm_deinterleave_16(const uint16_t* p_pcm, size_t num_frames,
+                              uint32_t* p_left, uint32_t* p_right);
+
+// Splits |num_frames| frames of interleaved AUDIO_FORMAT_PCM_24_BIT_PACKED
+// stereo PCM |p_pcm| (3 bytes per sample) into |p_left| and |p_right|, one
+// sign extended 32-bit word per sample (AUDIO_FORMAT_PCM_8_24_BIT).
+void a2dp_pcm_deinterleave_24_packed(const uint8_t* p_pcm, size_t num_frames,
+                                     uint32_t* p_left, uint32_t* p_right);
+
+#endif  // A2DP_PCM_H
@@ -38,10 +38,12 @@ void A2DP_UnloadEncoderSbc(void);
 // The current A2DP codec config is in |a2dp_codec_config|.
 // |read_callback| is the callback for reading the input audio data.
 // |enqueue_callback| is the callback for enqueueing the encoded audio data.
+// |alloc_callback| is the callback for allocating the encoded audio packets.
 void a2dp_sbc_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
                            A2dpCodecConfig* a2dp_codec_config,
                            a2dp_source_read_callback_t read_callback,
-                           a2dp_source_enqueue_callback_t enqueue_callback);
+                           a2dp_source_enqueue_callback_t enqueue_callback,
+                           a2dp_source_alloc_callback_t alloc_callback);
 
 // Cleanup the A2DP SBC encoder.
 void a2dp_sbc_encoder_cleanup(void);
@@ -59,6 +61,12 @@ uint64_t a2dp_sbc_get_encoder_interval_ms(void);
 // |timestamp_us| is the current timestamp (in microseconds).
 void a2dp_sbc_send_frames(uint64_t timestamp_us);
 
+// Set transmit queue length for the A2DP SBC ABR (Adaptive Bit Rate).
+void a2dp_sbc_set_transmit_queue_length(size_t transmit_queue_length);
+
+// Report that SBC encoded audio was dropped, so the ABR lowers the bitpool.
+void a2dp_sbc_report_congestion(void);
+
 // Get SBC bitrate
 // Returns |uint32_t| bitrate in bits per second
 uint32_t a2dp_sbc_get_bitrate();
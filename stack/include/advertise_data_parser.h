@@ -45,9 +45,10 @@ class AdvertiseDataParser {
   }
 
  public:
-  static void RemoveTrailingZeros(std::vector<uint8_t>& ad) {
-    size_t position = 0;
-
+  /* Remove the zero padding of |ad|, checked from |position| which must be the
+   * start of an AD structure */
+  static void RemoveTrailingZeros(std::vector<uint8_t>& ad,
+                                  size_t position = 0) {
     size_t ad_len = ad.size();
     while (position != ad_len) {
       uint8_t len = ad[position];
@@ -131,6 +131,26 @@ class BleAdvertisingManager {
   virtual void SetData(uint8_t inst_id, bool is_scan_rsp,
                        std::vector<uint8_t> data, MultiAdvCb cb) = 0;
 
+  /* Data of one advertising instance, for |SetDataForSets| */
+  struct AdvertisingSetData {
+    uint8_t inst_id;
+    bool is_scan_rsp;
+    std::vector<uint8_t> data;
+  };
+
+  /* This function configures several Multi-ADV instances at once. The HCI
+   * commands of all the instances are issued without waiting for each other,
+   * and |cb| is called once they all completed, with the first failure status
+   * if any. */
+  virtual void SetDataForSets(std::vector<AdvertisingSetData> sets,
+                              MultiAdvCb cb) = 0;
+
+  /* This function enables/disables several advertising instances, with a
+   * single HCI command when the controller supports it. Operation status is
+   * returned in |cb| */
+  virtual void EnableSets(std::vector<uint8_t> inst_ids, bool enable,
+                          MultiAdvCb cb) = 0;
+
   /* This function configure instance with the specified periodic parameters */
   virtual void SetPeriodicAdvertisingParameters(
       uint8_t inst_id, tBLE_PERIODIC_ADV_PARAMS* params, MultiAdvCb cb) = 0;
@@ -301,7 +301,9 @@ extern tBNEP_RESULT BNEP_Disconnect(uint16_t handle);
  *                  BNEP_MTU_EXCEDED        - If the data length is greater
  *                                            than MTU
  *                  BNEP_IGNORE_CMD         - If the packet is filtered out
- *                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full
+ *                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full. The buffer
+ *                                            is not freed, so the caller can
+ *                                            send it again later.
  *                  BNEP_SUCCESS            - If written successfully
  *
  ******************************************************************************/
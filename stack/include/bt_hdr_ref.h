@@ -0,0 +1,67 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Reference counting of BT_HDR buffers, to hand the same packet to several
+ *  destinations without copying it for each of them.
+ *
+ *  Like |buffer_new_ref| in osi/include/buffer.h, a reference is an alias of
+ *  the buffer: it is the same pointer, and the buffer is only freed when its
+ *  last reference is released. The buffer itself is a regular osi_malloc'ed
+ *  BT_HDR, the counts are kept aside: a buffer that was never shared can
+ *  still be freed with osi_free, and a buffer that is no longer shared can be
+ *  handed to code that does not know about references.
+ *
+ *  A shared buffer must not be modified, including its offset and len.
+ *  A destination that prepends headers or trims the payload in place first
+ *  calls |bt_hdr_make_writable|, which only copies the buffer if it is still
+ *  shared: the last destination gets it without a copy, and the destinations
+ *  that drop the packet never copy it.
+ *
+ ******************************************************************************/
+
+#ifndef BT_HDR_REF_H
+#define BT_HDR_REF_H
+
+#include <stddef.h>
+
+#include "bt_types.h"
+
+/* Adds a reference to |p_buf|, an osi_malloc'ed BT_HDR, and returns it.
+ * Each reference is released with |bt_hdr_unref|. Thread safe. */
+BT_HDR* bt_hdr_ref(BT_HDR* p_buf);
+
+/* Releases a reference to |p_buf|, freeing it if it was the last one.
+ * Same as osi_free for a buffer that is not shared. |p_buf| may be null.
+ * Thread safe. */
+void bt_hdr_unref(BT_HDR* p_buf);
+
+/* Returns true if |p_buf| has more than one reference. */
+bool bt_hdr_is_shared(const BT_HDR* p_buf);
+
+/* Returns the number of references to |p_buf|, 1 if it is not shared. */
+size_t bt_hdr_ref_count(const BT_HDR* p_buf);
+
+/* Returns a buffer with the content of |p_buf| that the caller owns alone:
+ * |p_buf| itself if it is not shared, otherwise a copy of its header,
+ * offset area and payload, in which case the caller's reference to |p_buf|
+ * is released. The result is a plain osi_malloc'ed buffer. Thread safe. */
+BT_HDR* bt_hdr_make_writable(BT_HDR* p_buf);
+
+#endif /* BT_HDR_REF_H */
@@ -685,8 +685,11 @@ typedef uint8_t ACCESS_CODE[ACCESS_CODE_BYTE_LEN];
 #define BT_EIR_OOB_COD_TYPE 0x0D
 #define BT_EIR_OOB_SSP_HASH_C_TYPE 0x0E
 #define BT_EIR_OOB_SSP_RAND_R_TYPE 0x0F
+#define BT_EIR_SOLICITED_16BITS_UUID_TYPE 0x14
+#define BT_EIR_SOLICITED_128BITS_UUID_TYPE 0x15
 #define BT_EIR_SERVICE_DATA_TYPE 0x16
 #define BT_EIR_SERVICE_DATA_16BITS_UUID_TYPE 0x16
+#define BT_EIR_SOLICITED_32BITS_UUID_TYPE 0x1F
 #define BT_EIR_SERVICE_DATA_32BITS_UUID_TYPE 0x20
 #define BT_EIR_SERVICE_DATA_128BITS_UUID_TYPE 0x21
 #define BT_EIR_MANUFACTURER_SPECIFIC_TYPE 0xFF
@@ -850,6 +850,21 @@ extern tBTM_STATUS BTM_RemoveSco(uint16_t sco_inx);
  ******************************************************************************/
 extern const RawAddress* BTM_ReadScoBdAddr(uint16_t sco_inx);
 
+/*******************************************************************************
+ *
+ * Function         BTM_WriteScoData
+ *
+ * Description      This function writes SCO data to a specified instance whose
+ *                  audio is routed over HCI. p_buf needs to carry an offset of
+ *                  HCI_SCO_PREAMBLE_SIZE bytes, and is always consumed.
+ *
+ * Returns          BTM_SUCCESS, BTM_ILLEGAL_VALUE for an illegal offset,
+ *                  BTM_SCO_BAD_LENGTH if truncated to BTM_SCO_DATA_SIZE_MAX,
+ *                  BTM_UNKNOWN_ADDR if the SCO is not connected over HCI.
+ *
+ ******************************************************************************/
+extern tBTM_STATUS BTM_WriteScoData(uint16_t sco_inx, BT_HDR* p_buf);
+
 /*******************************************************************************
  *
  * Function         BTM_SetEScoMode
@@ -1416,6 +1431,104 @@ extern tBTM_STATUS BTM_SetPowerMode(uint8_t pm_id, const RawAddress& remote_bda,
 extern tBTM_STATUS BTM_ReadPowerMode(const RawAddress& remote_bda,
                                      tBTM_PM_MODE* p_mode);
 
+/*******************************************************************************
+ *
+ * Function         BTM_ReadTrafficInterval
+ *
+ * Description      This returns the interval between the ACL packets of a
+ *                  specific ACL connection, averaged over its last packets.
+ *                  The time since the last packet counts in, so that the
+ *                  interval of an idle link grows.
+ *
+ * Input Param      remote_bda - device address of desired ACL connection
+ *
+ * Output Param     p_interval_us - address where the interval is copied into,
+ *                                  in microseconds, 0 if not known yet.
+ *                                  (valid only if return code is BTM_SUCCESS)
+ *
+ * Returns          BTM_SUCCESS if successful,
+ *                  BTM_UNKNOWN_ADDR if bd addr is not active or bad
+ *
+ ******************************************************************************/
+extern tBTM_STATUS BTM_ReadTrafficInterval(const RawAddress& remote_bda,
+                                           uint32_t* p_interval_us);
+
+/*******************************************************************************
+ *
+ * Function         BTM_PmDebugDump
+ *
+ * Description      This function dumps the traffic, time in mode and mode
+ *                  change latency statistics of the BR/EDR links.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void BTM_PmDebugDump(int fd);
+
+/*******************************************************************************
+ *
+ * Function         BTM_LinkQualityAddSample
+ *
+ * Description      This function adds a link quality sample, and updates the
+ *                  aggregates of its link. The time of the sample is set by
+ *                  BTM.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void BTM_LinkQualityAddSample(const tBTM_LQ_SAMPLE* p_sample);
+
+/*******************************************************************************
+ *
+ * Function         BTM_ReadLinkQuality
+ *
+ * Description      This returns the quality of an ACL link, aggregated from
+ *                  the samples of the Bluetooth Quality Report events and of
+ *                  the RSSI reads of BTM. It sends no HCI command.
+ *
+ * Input Param      remote_bda - device address of desired ACL connection
+ *                  transport - transport of desired ACL connection
+ *
+ * Output Param     p_quality - address where the quality is copied into.
+ *                              (valid only if return code is BTM_SUCCESS)
+ *
+ * Returns          BTM_SUCCESS if successful,
+ *                  BTM_UNKNOWN_ADDR if bd addr is not active or bad
+ *
+ ******************************************************************************/
+extern tBTM_STATUS BTM_ReadLinkQuality(const RawAddress& remote_bda,
+                                       tBT_TRANSPORT transport,
+                                       tBTM_LINK_QUALITY* p_quality);
+
+/*******************************************************************************
+ *
+ * Function         BTM_ReadControllerActivity
+ *
+ * Description      This returns the activity of the controller radio, from
+ *                  the energy info sampled by BTM. It sends no HCI command.
+ *
+ * Output Param     p_activity - address where the activity is copied into.
+ *                               (valid only if return code is BTM_SUCCESS)
+ *
+ * Returns          BTM_SUCCESS if successful,
+ *                  BTM_ERR_PROCESSING if no energy info was sampled
+ *
+ ******************************************************************************/
+extern tBTM_STATUS BTM_ReadControllerActivity(
+    tBTM_CONTROLLER_ACTIVITY* p_activity);
+
+/*******************************************************************************
+ *
+ * Function         BTM_LinkQualityDebugDump
+ *
+ * Description      This function dumps the link quality aggregates of the ACL
+ *                  links and the controller activity.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void BTM_LinkQualityDebugDump(int fd);
+
 /*******************************************************************************
  *
  * Function         BTM_SetSsrParams
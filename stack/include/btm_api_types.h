@@ -655,11 +655,16 @@ typedef struct {
                                duplicate store of inquiry results */
   uint16_t remote_name_len;
   tBTM_BD_NAME remote_name;
-  uint8_t remote_name_state;
+  uint8_t remote_name_state; /* BTM_INQ_RMT_NAME_... */
   uint8_t remote_name_type;
 
 } tBTM_INQ_INFO;
 
+/* Values of remote_name_state in tBTM_INQ_INFO */
+#define BTM_INQ_RMT_NAME_EMPTY 0  /* name not requested yet */
+#define BTM_INQ_RMT_NAME_DONE 1   /* remote_name holds the name read */
+#define BTM_INQ_RMT_NAME_FAILED 2 /* the name request failed */
+
 /* Structure returned with inquiry complete callback */
 typedef struct {
   tBTM_STATUS status;
@@ -1752,4 +1757,52 @@ typedef struct {
 
 typedef uint8_t tBTM_CONTRL_STATE;
 
+/************************
+ *  Link Quality Types
+ ************************/
+/* Sources of the link quality samples */
+#define BTM_LQ_SRC_RSSI 0   /* HCI Read RSSI */
+#define BTM_LQ_SRC_BQR 1    /* Bluetooth Quality Report link quality event */
+#define BTM_LQ_SRC_ENERGY 2 /* controller activity and energy info */
+
+/* The BQR event was sent as the link was approaching its supervision timeout */
+#define BTM_LQ_FLAG_APPROACH_LSTO 0x01
+
+/* A link quality sample, as kept in the sample ring of BTM */
+typedef struct {
+  uint32_t time_ms; /* boot time of the sample, set by BTM */
+  uint16_t handle;  /* ACL handle, HCI_INVALID_HANDLE for the controller */
+  uint8_t source;   /* BTM_LQ_SRC_* */
+  uint8_t flags;    /* BTM_LQ_FLAG_* */
+  int8_t rssi;      /* dBm, RSSI and BQR samples */
+  /* BQR samples, over the report period */
+  uint32_t retransmissions;
+  uint32_t naks;
+  /* energy samples, since the previous one */
+  uint32_t tx_time_ms;
+  uint32_t rx_time_ms;
+  uint32_t idle_time_ms;
+  uint32_t energy_used;
+} tBTM_LQ_SAMPLE;
+
+/* The quality of an ACL link, aggregated from its samples */
+typedef struct {
+  int8_t rssi;              /* last RSSI, dBm */
+  int8_t rssi_avg;          /* moving average of the RSSI, dBm */
+  uint32_t rssi_age_ms;     /* time since the last RSSI, UINT32_MAX if none */
+  uint32_t retransmissions; /* reported by BQR since the link is up */
+  uint32_t naks;
+  uint32_t lsto_age_ms; /* time since BQR reported the link approaching its
+                           supervision timeout, UINT32_MAX if never */
+} tBTM_LINK_QUALITY;
+
+/* The activity of the controller radio, from its energy info */
+typedef struct {
+  uint64_t tx_time_ms; /* totals since the sampling started */
+  uint64_t rx_time_ms;
+  uint64_t idle_time_ms;
+  uint64_t energy_used;
+  uint16_t busy_permille; /* share of the last sample the radio was busy */
+} tBTM_CONTROLLER_ACTIVITY;
+
 #endif  // BTM_API_TYPES_H
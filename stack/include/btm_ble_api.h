@@ -129,7 +129,9 @@ extern void BTM_BleEnableBatchScan(
 extern void BTM_BleDisableBatchScan(
     base::Callback<void(uint8_t /* status */)> cb);
 
-/* This function is called to read batch scan reports */
+/* This function is called to read batch scan reports. |cb| is run once per
+ * chunk of records read from the controller with |more| true, then once
+ * without records with |more| false */
 extern void BTM_BleReadScanReports(tBLE_SCAN_MODE scan_mode,
                                    tBTM_BLE_SCAN_REP_CBACK cb);
 
@@ -446,6 +448,19 @@ extern bool BTM_ReadConnectedTransportAddress(RawAddress* remote_bda,
  ******************************************************************************/
 extern bool BTM_BleConfigPrivacy(bool enable);
 
+/*******************************************************************************
+ *
+ * Function         BTM_BleResolvingListDump
+ *
+ * Description      This function dumps the controller resolving list usage:
+ *                  how many private addresses were resolved by the controller
+ *                  and by the host, and how many entries were replaced.
+ *
+ * Parameters       fd: file descriptor to write to
+ *
+ ******************************************************************************/
+extern void BTM_BleResolvingListDump(int fd);
+
 /*******************************************************************************
  *
  * Function         BTM_BleLocalPrivacyEnabled
@@ -554,6 +569,19 @@ extern void BTM_LE_PF_clear(tBTM_BLE_PF_FILT_INDEX filt_index,
 extern void BTM_BleEnableDisableFilterFeature(
     uint8_t enable, tBTM_BLE_PF_STATUS_CBACK p_stat_cback);
 
+/*******************************************************************************
+ *
+ * Function         BTM_BleMaxAdvFilters
+ *
+ * Description      Get the number of adv data payload filters that can be
+ *                  set up, by the controller or, when the controller does not
+ *                  support APCF, by the host
+ *
+ * Returns          number of filter indexes, 0 if filtering is not supported
+ *
+ ******************************************************************************/
+extern uint8_t BTM_BleMaxAdvFilters(void);
+
 /*******************************************************************************
  *
  * Function         BTM_BleGetEnergyInfo
@@ -607,6 +635,85 @@ extern void BTM_BleReadPhy(
 extern void BTM_BleSetPhy(const RawAddress& bd_addr, uint8_t tx_phys,
                           uint8_t rx_phys, uint16_t phy_options);
 
+using PeriodicSyncStartedCb =
+    base::Callback<void(uint8_t status, uint16_t sync_handle,
+                        uint8_t advertising_sid, uint8_t address_type,
+                        RawAddress address, uint8_t phy, uint16_t interval)>;
+/* |data| is only valid for the duration of the call */
+using PeriodicSyncReportCb =
+    base::Callback<void(uint16_t sync_handle, int8_t tx_power, int8_t rssi,
+                        uint8_t status, const uint8_t* data, uint16_t len)>;
+using PeriodicSyncLostCb = base::Callback<void(uint16_t sync_handle)>;
+
+/*******************************************************************************
+ *
+ * Function         BTM_BleStartPeriodicSync
+ *
+ * Description      Synchronize to the periodic advertising train |adv_sid| of
+ *                  |address|. Only one sync is created by the controller at a
+ *                  time, the others are queued. The controller finds the train
+ *                  while scanning, so the caller is expected to scan.
+ *                  |started_cb| is called when the sync is established or
+ *                  failed. The complete periodic advertising data is then
+ *                  passed to |report_cb|, and |lost_cb| is called when the
+ *                  sync is lost.
+ *
+ ******************************************************************************/
+extern void BTM_BleStartPeriodicSync(uint8_t adv_sid, const RawAddress& address,
+                                     uint16_t skip, uint16_t timeout,
+                                     PeriodicSyncStartedCb started_cb,
+                                     PeriodicSyncReportCb report_cb,
+                                     PeriodicSyncLostCb lost_cb);
+
+/*******************************************************************************
+ *
+ * Function         BTM_BleCancelPeriodicSync
+ *
+ * Description      Cancel a sync to |adv_sid| of |address| that is not
+ *                  established yet. Its |started_cb| is called with
+ *                  HCI_ERR_OPERATION_CANCELLED_BY_HOST.
+ *
+ ******************************************************************************/
+extern void BTM_BleCancelPeriodicSync(uint8_t adv_sid,
+                                      const RawAddress& address);
+
+/*******************************************************************************
+ *
+ * Function         BTM_BleStopPeriodicSync
+ *
+ * Description      Terminate the established sync |sync_handle|.
+ *
+ ******************************************************************************/
+extern void BTM_BleStopPeriodicSync(uint16_t sync_handle);
+
+/*******************************************************************************
+ *
+ * Function         BTM_BlePeriodicSyncTransfer
+ *
+ * Description      Send the established sync |sync_handle| to the LE connected
+ *                  peer |bd_addr| (Periodic Advertising Sync Transfer), so
+ *                  that it can synchronize without scanning.
+ *
+ ******************************************************************************/
+extern void BTM_BlePeriodicSyncTransfer(
+    const RawAddress& bd_addr, uint16_t service_data, uint16_t sync_handle,
+    base::Callback<void(uint8_t status, RawAddress address)> cb);
+
+/*******************************************************************************
+ *
+ * Function         BTM_BleReceivePeriodicSyncTransfer
+ *
+ * Description      Accept the syncs the LE connected peer |bd_addr| transfers.
+ *                  Each transferred sync is reported to |started_cb|, and then
+ *                  behaves like one started by BTM_BleStartPeriodicSync.
+ *
+ ******************************************************************************/
+extern void BTM_BleReceivePeriodicSyncTransfer(
+    const RawAddress& bd_addr, uint16_t skip, uint16_t timeout,
+    PeriodicSyncStartedCb started_cb, PeriodicSyncReportCb report_cb,
+    PeriodicSyncLostCb lost_cb);
+
 extern void btm_ble_multi_adv_cleanup(void);
+extern void btm_ble_periodic_sync_cleanup(void);
 
 #endif
@@ -0,0 +1,161 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef BTM_ISO_API_H
+#define BTM_ISO_API_H
+
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "bt_types.h"
+
+namespace bluetooth {
+namespace hci {
+namespace iso_manager {
+
+/* Parameters of one CIS of a CIG */
+struct cis_cfg {
+  uint8_t cis_id;
+  uint16_t max_sdu_size_mtos;
+  uint16_t max_sdu_size_stom;
+  uint8_t phy_mtos;
+  uint8_t phy_stom;
+  uint8_t rtn_mtos;
+  uint8_t rtn_stom;
+};
+
+/* Parameters of LE Set CIG Parameters. SDU intervals are in microseconds,
+ * transport latencies in milliseconds. */
+struct cig_create_params {
+  uint32_t sdu_itv_mtos;
+  uint32_t sdu_itv_stom;
+  uint8_t sca;
+  uint8_t packing;
+  uint8_t framing;
+  uint16_t max_trans_lat_mtos;
+  uint16_t max_trans_lat_stom;
+  std::vector<cis_cfg> cis_cfgs;
+};
+
+/* Parameters of LE Create BIG */
+struct big_create_params {
+  uint8_t adv_handle;
+  uint8_t num_bis;
+  uint32_t sdu_itv;
+  uint16_t max_sdu_size;
+  uint16_t max_transport_latency;
+  uint8_t rtn;
+  uint8_t phy;
+  uint8_t packing;
+  uint8_t framing;
+  uint8_t enc;
+  std::array<uint8_t, 16> enc_code;
+};
+
+/* Parameters of LE Setup ISO Data Path */
+struct iso_data_path_params {
+  uint8_t data_path_dir;
+  uint8_t data_path_id;
+  uint8_t codec_id_format;
+  uint16_t codec_id_company;
+  uint16_t codec_id_vendor;
+  uint32_t controller_delay;
+  std::vector<uint8_t> codec_conf;
+};
+
+constexpr uint8_t kIsoDataPathDirectionIn = 0x00;
+constexpr uint8_t kIsoDataPathDirectionOut = 0x01;
+constexpr uint8_t kIsoDataPathHci = 0x00;
+
+/* Events of the ISO manager, all called on the main thread */
+class IsoCallbacks {
+ public:
+  virtual ~IsoCallbacks() = default;
+
+  virtual void OnCigCreated(uint8_t status, uint8_t cig_id,
+                            std::vector<uint16_t> cis_handles) = 0;
+  virtual void OnCigRemoved(uint8_t status, uint8_t cig_id) = 0;
+  virtual void OnCisEstablished(uint8_t status, uint16_t cis_handle,
+                                uint32_t transport_latency_mtos,
+                                uint32_t transport_latency_stom) = 0;
+  virtual void OnCisDisconnected(uint16_t cis_handle, uint8_t reason) = 0;
+  virtual void OnBigCreated(uint8_t status, uint8_t big_id,
+                            std::vector<uint16_t> bis_handles) = 0;
+  virtual void OnBigTerminated(uint8_t big_id, uint8_t reason) = 0;
+  virtual void OnIsoDataPathSetup(uint8_t status, uint16_t iso_handle) = 0;
+
+  /* A complete SDU received on |iso_handle|. |data| is only valid for the
+   * duration of the call. */
+  virtual void OnIsoData(uint16_t iso_handle, uint16_t seq_nb,
+                         uint32_t timestamp, uint8_t status,
+                         const uint8_t* data, uint16_t len) = 0;
+};
+
+}  // namespace iso_manager
+
+class IsoManager {
+ public:
+  static IsoManager* GetInstance();
+
+  /* Reads the ISO buffers of the controller and starts dispatching the ISO
+   * events to |callbacks| */
+  void Start(iso_manager::IsoCallbacks* callbacks);
+  void Stop();
+  bool IsRunning() const;
+
+  void CreateCig(uint8_t cig_id, iso_manager::cig_create_params params);
+  void RemoveCig(uint8_t cig_id);
+
+  /* Connects each CIS handle of |conn_pairs| over the ACL handle paired with
+   * it */
+  void EstablishCis(std::vector<std::pair<uint16_t, uint16_t>> conn_pairs);
+  void DisconnectCis(uint16_t cis_handle, uint8_t reason);
+
+  void CreateBig(uint8_t big_id, iso_manager::big_create_params params);
+  void TerminateBig(uint8_t big_id, uint8_t reason);
+
+  void SetupIsoDataPath(uint16_t iso_handle,
+                        iso_manager::iso_data_path_params params);
+  void RemoveIsoDataPath(uint16_t iso_handle, uint8_t data_path_dir);
+
+  /* Queues the SDU |data| on |iso_handle|. It is stamped with the SDU
+   * interval it falls into, and sent as soon as the controller has room. */
+  void SendIsoData(uint16_t iso_handle, const uint8_t* data, uint16_t len);
+
+  /* Stack internals */
+  void HandleIsoData(BT_HDR* p_msg);
+  void HandleNumComplDataPkts(uint8_t* p, uint8_t evt_len);
+  void HandleHciEvent(uint8_t sub_code, uint8_t* p, uint16_t len);
+  /* Returns false if |handle| is not a CIS */
+  bool HandleDisconnect(uint16_t handle, uint8_t reason);
+
+  struct impl;
+
+ private:
+  IsoManager();
+  ~IsoManager();
+
+  std::unique_ptr<impl> pimpl_;
+};
+
+}  // namespace hci
+}  // namespace bluetooth
+
+#endif  // BTM_ISO_API_H
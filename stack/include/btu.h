@@ -39,6 +39,10 @@
 /* Global BTU data */
 extern uint8_t btu_trace_level;
 
+/* Name of the trace flow of an HCI packet from the HCI thread to the main
+ * thread, whose id is the flow id of the packet */
+constexpr char BTU_HCI_PACKET_TRACE_FLOW[] = "HCI packet to btu";
+
 /* Functions provided by btu_hcif.cc
  ***********************************
 */
@@ -66,6 +70,26 @@ bt_status_t do_in_main_thread_delayed(const base::Location& from_here,
                                       base::OnceClosure task,
                                       const base::TimeDelta& delay);
 
+/* Domains of CPU heavy work, each run on its own thread so that it does not
+ * delay the protocol and profile state machines of the main thread */
+typedef enum : uint8_t {
+  BTU_WORK_SMP_CRYPTO, /* P-256 point multiplications */
+} tBTU_WORK_DOMAIN;
+
+/* Runs |task| on the thread of |domain|, then |reply| on the main thread.
+ * |task| only uses what is bound to it, never the state of the stack; the
+ * reply checks that the result is still wanted before applying it.
+ * Returns BT_STATUS_FAIL, and runs neither of them, if the thread of |domain|
+ * is not running */
+bt_status_t do_in_work_thread_and_reply(tBTU_WORK_DOMAIN domain,
+                                        const base::Location& from_here,
+                                        base::OnceClosure task,
+                                        base::OnceClosure reply);
+
+/* Dumps the task statistics of the main thread, if enabled in the stack
+ * config */
+void btu_debug_dump(int fd);
+
 void BTU_StartUp(void);
 void BTU_ShutDown(void);
 
@@ -731,6 +731,35 @@ extern bool GATTS_DeleteService(tGATT_IF gatt_if, bluetooth::Uuid* p_svc_uuid,
  ******************************************************************************/
 extern void GATTS_StopService(uint16_t service_handle);
 
+/*******************************************************************************
+ *
+ * Function         GATTS_HandleValueFanOut
+ *
+ * Description      This function sends the same handle value notification or
+ *                  indication to several clients. The PDU is built once and
+ *                  copied to each link, truncated to the link MTU.
+ *
+ * Parameter        conn_ids: connection identifiers of the clients.
+ *                  num_conn_ids: number of entries in conn_ids.
+ *                  attr_handle: Attribute handle of this handle value
+ *                               notification or indication.
+ *                  val_len: Length of the attribute value.
+ *                  p_val: Pointer to the attribute value data.
+ *                  need_confirm: true to send an indication, false to send a
+ *                                notification.
+ *                  p_status: if not NULL, receives the status of each client,
+ *                            as returned by GATTS_HandleValueIndication or
+ *                            GATTS_HandleValueNotification.
+ *
+ * Returns          Number of clients the value was sent or queued to.
+ *
+ ******************************************************************************/
+extern uint8_t GATTS_HandleValueFanOut(const uint16_t* conn_ids,
+                                       uint8_t num_conn_ids,
+                                       uint16_t attr_handle, uint16_t val_len,
+                                       uint8_t* p_val, bool need_confirm,
+                                       tGATT_STATUS* p_status);
+
 /*******************************************************************************
  *
  * Function         GATTs_HandleValueIndication
@@ -864,6 +893,35 @@ extern tGATT_STATUS GATTC_Read(uint16_t conn_id, tGATT_READ_TYPE type,
 extern tGATT_STATUS GATTC_Write(uint16_t conn_id, tGATT_WRITE_TYPE type,
                                 tGATT_VALUE* p_write);
 
+/*******************************************************************************
+ *
+ * Function         GATTC_WriteNoRsp
+ *
+ * Description      This function is called to send a write without response to
+ *                  the server. Unlike GATTC_Write, it does not hold a client
+ *                  control block until the command is sent, so an application
+ *                  can have any number of them in flight on a link, bounded by
+ *                  the L2CAP buffers, and can send them while a request is
+ *                  outstanding. No completion callback is called. The write
+ *                  is neither signed nor authenticated, GATTC_Write should be
+ *                  used for those.
+ *
+ * Parameters       conn_id: connection identifier.
+ *                  handle - attribute handle to write.
+ *                  len - length of the value, at most MTU - 3.
+ *                  p_value - value to write.
+ *
+ * Returns          GATT_SUCCESS if the command was sent.
+ *                  GATT_CONGESTED if the command was sent but the link is now
+ *                  congested: no further command should be sent until the
+ *                  application congestion callback reports it is not.
+ *                  GATT_CMD_STARTED if the command was queued behind requests
+ *                  waiting to be sent.
+ *
+ ******************************************************************************/
+extern tGATT_STATUS GATTC_WriteNoRsp(uint16_t conn_id, uint16_t handle,
+                                     uint16_t len, uint8_t* p_value);
+
 /*******************************************************************************
  *
  * Function         GATTC_ExecuteWrite
@@ -1078,6 +1136,9 @@ extern void gatt_init(void);
 // Frees resources used by the GATT profile.
 extern void gatt_free(void);
 
+// Dumps the throughput of the GATT connections to |fd|.
+extern void gatt_debug_dump(int fd);
+
 // Link encryption complete notification for all encryption process
 // initiated outside GATT.
 extern void gatt_notify_enc_cmpl(const RawAddress& bd_addr);
@@ -65,6 +65,7 @@
 
 /* Attribute Profile Attribute UUID */
 #define GATT_UUID_GATT_SRV_CHGD 0x2A05
+#define GATT_UUID_DATABASE_HASH 0x2B2A
 /* Attribute Protocol Test */
 
 /* Link Loss Service */
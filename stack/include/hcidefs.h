@@ -395,6 +395,20 @@
 #define HCI_BLE_READ_RF_COMPENS_POWER (0x004C | HCI_GRP_BLE_CMDS)
 #define HCI_BLE_WRITE_RF_COMPENS_POWER (0x004D | HCI_GRP_BLE_CMDS)
 #define HCI_BLE_SET_PRIVACY_MODE (0x004E | HCI_GRP_BLE_CMDS)
+#define HCI_BLE_PERIODIC_ADVERTISING_SYNC_TRANSFER (0x005A | HCI_GRP_BLE_CMDS)
+#define HCI_BLE_SET_PERIODIC_ADVERTISING_SYNC_TRANSFER_PARAM \
+  (0x005C | HCI_GRP_BLE_CMDS)
+#define HCI_LE_READ_BUFFER_SIZE_V2 (0x0060 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_READ_ISO_TX_SYNC (0x0061 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_SET_CIG_PARAMS (0x0062 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_CREATE_CIS (0x0064 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_REMOVE_CIG (0x0065 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_ACCEPT_CIS_REQ (0x0066 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_REJ_CIS_REQ (0x0067 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_CREATE_BIG (0x0068 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_TERM_BIG (0x006A | HCI_GRP_BLE_CMDS)
+#define HCI_LE_SETUP_ISO_DATA_PATH (0x006E | HCI_GRP_BLE_CMDS)
+#define HCI_LE_REMOVE_ISO_DATA_PATH (0x006F | HCI_GRP_BLE_CMDS)
 
 /* LE Get Vendor Capabilities Command opcode */
 #define HCI_BLE_VENDOR_CAP (0x0153 | HCI_GRP_VENDOR_SPECIFIC)
@@ -602,6 +616,11 @@ constexpr uint8_t HCI_LE_STATES_INIT_MASTER_SLAVE_BIT = 41;
 #define HCI_BLE_SCAN_TIMEOUT_EVT               0x11
 #define HCI_LE_ADVERTISING_SET_TERMINATED_EVT 0x12
 #define HCI_BLE_SCAN_REQ_RX_EVT                0x13
+#define HCI_BLE_PERIODIC_ADV_SYNC_TRANSFER_RECEIVED_EVT 0x18
+#define HCI_BLE_CIS_EST_EVT 0x19
+#define HCI_BLE_CIS_REQ_EVT 0x1A
+#define HCI_BLE_CREATE_BIG_CPL_EVT 0x1B
+#define HCI_BLE_TERM_BIG_CPL_EVT 0x1C
 
 /* Definitions for LE Channel Map */
 #define HCI_BLE_CHNL_MAP_SIZE 5
@@ -680,6 +699,7 @@ constexpr uint8_t HCI_LE_STATES_INIT_MASTER_SLAVE_BIT = 41;
 #define HCI_ERR_CONN_TOUT_DUE_TO_MIC_FAILURE 0x3D
 #define HCI_ERR_CONN_FAILED_ESTABLISHMENT 0x3E
 #define HCI_ERR_LIMIT_REACHED 0x43
+#define HCI_ERR_OPERATION_CANCELLED_BY_HOST 0x44
 #define HCI_ERR_MAC_CONNECTION_FAILED 0x3F
 
 /* ConnectionLess Broadcast errors */
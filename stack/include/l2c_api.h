@@ -670,6 +670,21 @@ extern uint16_t L2CA_FlushChannel(uint16_t lcid, uint16_t num_to_flush);
  ******************************************************************************/
 extern bool L2CA_SetAclPriority(const RawAddress& bd_addr, uint8_t priority);
 
+/*******************************************************************************
+ *
+ * Function         L2CA_SetChnlAclPriority
+ *
+ * Description      Sets the priority of the ACL link a channel needs, on a
+ *                  BR/EDR or LE link. (L2CAP_PRIORITY_NORMAL or
+ *                  L2CAP_PRIORITY_HIGH). The link has the highest priority of
+ *                  the one set by L2CA_SetAclPriority and the ones its open
+ *                  channels need.
+ *
+ * Returns          true if a valid channel, else false
+ *
+ ******************************************************************************/
+extern bool L2CA_SetChnlAclPriority(uint16_t cid, uint8_t priority);
+
 /*******************************************************************************
  *
  * Function         L2CA_SetTxPriority
@@ -950,6 +965,14 @@ extern void L2CA_SetLeFixedChannelTxDataLength(const RawAddress& remote_bda,
                                                uint16_t fix_cid,
                                                uint16_t tx_mtu);
 
+/**
+ * Set the priority of the LE link a fixed channel needs, see
+ * L2CA_SetChnlAclPriority
+ */
+extern void L2CA_SetLeFixedChannelAclPriority(const RawAddress& remote_bda,
+                                              uint16_t fix_cid,
+                                              uint8_t priority);
+
 /**
  * Check whether an ACL or LE link to the remote device is established
  */
@@ -346,6 +346,8 @@ extern tPAN_RESULT PAN_Write(uint16_t handle, const RawAddress& dst,
  *                  ext      - to indicate that extension headers present
  *
  * Returns          PAN_SUCCESS       - if the data is sent successfully
+ *                  PAN_Q_SIZE_EXCEEDED - if the BNEP Tx Q is full. The
+ *                                      buffer is not freed.
  *                  PAN_FAILURE       - if the connection is not found or
  *                                           there is an error in sending data
  *
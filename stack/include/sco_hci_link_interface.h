@@ -0,0 +1,55 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "device/include/esco_parameters.h"
+
+/* Socket the audio HAL connects to in order to exchange the PCM of an SCO link
+ * routed over HCI. For every frame of 7.5 ms of microphone PCM the HAL writes,
+ * one frame of speaker PCM is written back, at the sample rate of the codec of
+ * the link: 16 kHz for mSBC and 8 kHz for CVSD. */
+#define SCO_HCI_DATA_PATH "/data/misc/bluedroid/.sco_data"
+
+namespace bluetooth {
+namespace audio {
+namespace sco {
+
+/* Starts exchanging the audio of the SCO link |handle| with the audio HAL,
+ * coded with |coding_format|: ESCO_CODING_FORMAT_MSBC or
+ * ESCO_CODING_FORMAT_CVSD. Only one link is routed to the HAL at a time. */
+void Open(uint16_t handle, esco_coding_format_t coding_format);
+
+/* Stops exchanging the audio of the SCO link |handle| */
+void Close(uint16_t handle);
+
+/* Decodes the |len| bytes of an SCO packet received on |handle|. |lost| is
+ * set when the controller reported the data as erroneous or missing. */
+void ReceivePacket(uint16_t handle, bool lost, const uint8_t* data,
+                   size_t len);
+
+/* Fills |len| bytes of the next SCO packet to send on |handle|. Returns false
+ * if the audio of |handle| is not routed over HCI. */
+bool FillPacket(uint16_t handle, uint8_t* data, size_t len);
+
+void DebugDump(int fd);
+
+}  // namespace sco
+}  // namespace audio
+}  // namespace bluetooth
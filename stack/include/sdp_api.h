@@ -104,15 +104,18 @@ typedef struct t_sdp_disc_attr {
 
 typedef struct t_sdp_disc_rec {
   tSDP_DISC_ATTR* p_first_attr;      /* First attribute of record    */
+  tSDP_DISC_ATTR* p_last_attr;       /* Last attribute of record     */
   struct t_sdp_disc_rec* p_next_rec; /* Addr of next linked record   */
   uint32_t time_read;                /* The time the record was read */
   RawAddress remote_bd_addr;         /* Remote BD address            */
+  bool attrs_in_order;               /* Attribute IDs are ascending  */
 } tSDP_DISC_REC;
 
 typedef struct {
   uint32_t mem_size;          /* Memory size of the DB        */
   uint32_t mem_free;          /* Memory still available       */
   tSDP_DISC_REC* p_first_rec; /* Addr of first record in DB   */
+  tSDP_DISC_REC* p_last_rec;  /* Addr of last record in DB    */
   uint16_t num_uuid_filters;  /* Number of UUIds to filter    */
   bluetooth::Uuid uuid_filters[SDP_MAX_UUID_FILTERS]; /* UUIDs to filter */
   uint16_t num_attr_filters; /* Number of attribute filters  */
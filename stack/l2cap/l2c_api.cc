@@ -1185,6 +1185,43 @@ bool L2CA_SetAclPriority(const RawAddress& bd_addr, uint8_t priority) {
   return (l2cu_set_acl_priority(bd_addr, priority, false));
 }
 
+/*******************************************************************************
+ *
+ * Function         L2CA_SetChnlAclPriority
+ *
+ * Description      Sets the priority of the ACL link a channel needs, on a
+ *                  BR/EDR or LE link. The link has the highest priority of
+ *                  the one set by L2CA_SetAclPriority and the ones its open
+ *                  channels need, so it goes back to normal when the high
+ *                  priority channels close.
+ *
+ * Returns          true if a valid channel, else false
+ *
+ ******************************************************************************/
+bool L2CA_SetChnlAclPriority(uint16_t cid, uint8_t priority) {
+  if (bluetooth::shim::is_gd_shim_enabled()) {
+    return bluetooth::shim::L2CA_SetChnlAclPriority(cid, priority);
+  }
+
+  tL2C_CCB* p_ccb;
+
+  L2CAP_TRACE_API("L2CA_SetChnlAclPriority()  CID: 0x%04x, priority:%d", cid,
+                  priority);
+
+  /* Find the channel control block. We don't know the link it is on. */
+  p_ccb = l2cu_find_ccb_by_cid(NULL, cid);
+  if ((p_ccb == NULL) || (p_ccb->p_lcb == NULL)) {
+    L2CAP_TRACE_WARNING("L2CAP - no CCB for L2CA_SetChnlAclPriority, CID: %d",
+                        cid);
+    return (false);
+  }
+
+  p_ccb->acl_priority = priority;
+  l2cu_update_acl_priority(p_ccb->p_lcb);
+
+  return (true);
+}
+
 /*******************************************************************************
  *
  * Function         L2CA_SetTxPriority
@@ -300,7 +300,7 @@ void l2cble_conn_comp(uint16_t handle, uint8_t role, const RawAddress& bda,
   if (role == HCI_ROLE_MASTER) alarm_cancel(p_lcb->l2c_lcb_timer);
 
   /* Save the handle */
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   /* Connected OK. Change state to connected, we were scanning so we are master
    */
@@ -982,6 +982,13 @@ void l2cble_update_data_length(tL2C_LCB* p_lcb) {
 
   if (tx_mtu > BTM_BLE_DATA_SIZE_MAX) tx_mtu = BTM_BLE_DATA_SIZE_MAX;
 
+  /* Keep the maximum data length the LE link policy asked for, so that the
+   * full MTU ATT and LE CoC PDUs go in as few LL PDUs as possible */
+  tACL_CONN* p_acl = btm_bda_to_acl(p_lcb->remote_bd_addr, BT_TRANSPORT_LE);
+  if (p_acl != NULL && p_acl->le_link_policy &&
+      HCI_LE_DATA_LEN_EXT_SUPPORTED(p_acl->peer_le_features))
+    tx_mtu = BTM_BLE_DATA_SIZE_MAX;
+
   /* update TX data length if changed */
   if (p_lcb->tx_data_len != tx_mtu)
     BTM_SetBleDataLength(p_lcb->remote_bd_addr, tx_mtu);
@@ -1297,3 +1304,17 @@ void L2CA_SetLeFixedChannelTxDataLength(const RawAddress& remote_bda,
                                         uint16_t fix_cid, uint16_t tx_mtu) {
   l2cble_set_fixed_channel_tx_data_length(remote_bda, fix_cid, tx_mtu);
 }
+
+void L2CA_SetLeFixedChannelAclPriority(const RawAddress& remote_bda,
+                                       uint16_t fix_cid, uint8_t priority) {
+  tL2C_LCB* p_lcb = l2cu_find_lcb_by_bd_addr(remote_bda, BT_TRANSPORT_LE);
+  if (p_lcb == NULL || fix_cid < L2CAP_FIRST_FIXED_CHNL ||
+      fix_cid > L2CAP_LAST_FIXED_CHNL)
+    return;
+
+  tL2C_CCB* p_ccb = p_lcb->p_fixed_ccbs[fix_cid - L2CAP_FIRST_FIXED_CHNL];
+  if (p_ccb == NULL) return;
+
+  p_ccb->acl_priority = priority;
+  l2cu_update_acl_priority(p_lcb);
+}
@@ -1137,6 +1137,9 @@ static void l2c_csm_open(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
           (*cr_cb)(p_ccb->local_cid, *credit, p_ccb->peer_conn_cfg.credits);
         }
         l2c_link_check_send_pkts(p_ccb->p_lcb, NULL, NULL);
+        /* Nothing may have been sent for lack of link buffers, so release a
+         * channel held back for credits here */
+        l2cu_check_channel_congestion(p_ccb);
       }
       break;
   }
@@ -56,6 +56,15 @@ static_assert(L2CAP_LE_CREDIT_THRESHOLD < L2CAP_LE_CREDIT_DEFAULT,
 
 #define L2CAP_NO_IDLE_TIMEOUT 0xFFFF
 
+/* Number of buckets of the LCB indexes by handle and by address. Keep it a
+ * power of 2, and above MAX_L2CAP_LINKS so that most buckets hold one LCB. */
+#ifndef L2C_LCB_INDEX_BUCKETS
+#define L2C_LCB_INDEX_BUCKETS 32
+#endif
+
+static_assert((L2C_LCB_INDEX_BUCKETS & (L2C_LCB_INDEX_BUCKETS - 1)) == 0,
+              "The number of LCB index buckets must be a power of 2");
+
 /*
  * Timeout values (in milliseconds).
  */
@@ -204,6 +213,7 @@ typedef struct {
   BT_HDR* p_rx_sdu;    /* Buffer holding the SDU being received */
   fixed_queue_t*
       waiting_for_ack_q;          /* Buffers sent and waiting for peer to ack */
+  BT_HDR* waiting_for_ack_seq[L2CAP_FCR_SEQ_MODULO + 1]; /* Same, by TxSeq */
   fixed_queue_t* srej_rcv_hold_q; /* Buffers rcvd but held pending SREJ rsp */
   fixed_queue_t* retrans_q;       /* Buffers being retransmitted */
 
@@ -313,6 +323,7 @@ typedef struct t_l2c_ccb {
   uint16_t buff_quota;        /* Buffer quota before sending congestion */
 
   tL2CAP_CHNL_PRIORITY ccb_priority;  /* Channel priority */
+  uint8_t acl_priority;               /* Link priority the channel needs */
   tL2CAP_CHNL_DATA_RATE tx_data_rate; /* Channel Tx data rate */
   tL2CAP_CHNL_DATA_RATE rx_data_rate; /* Channel Rx data rate */
 
@@ -386,7 +397,11 @@ typedef struct t_l2c_linkcb {
   tL2C_LINK_STATE link_state;
 
   alarm_t* l2c_lcb_timer; /* Timer entry for timeout evt */
-  uint16_t handle;        /* The handle used with LM */
+  uint16_t handle;        /* The handle used with LM, see l2cu_set_lcb_handle */
+
+  /* Next LCB in the same bucket of the LCB indexes */
+  struct t_l2c_linkcb* p_next_by_handle;
+  struct t_l2c_linkcb* p_next_by_addr;
 
   tL2C_CCB_Q ccb_queue; /* Queue of CCBs on this LCB */
 
@@ -406,8 +421,12 @@ typedef struct t_l2c_linkcb {
   uint16_t link_xmit_quota; /* Num outstanding pkts allowed */
   uint16_t sent_not_acked;  /* Num packets sent but not acked */
 
+  bool link_degraded; /* Per link quality reports, gets a smaller quota */
+  uint32_t lq_retransmissions; /* Retransmissions of the last quality report */
+
   bool partial_segment_being_sent; /* Set true when a partial segment */
                                    /* is being sent. */
+  bool tx_pending; /* may have data to send, see l2c_link_set_tx_pending */
   bool w4_info_rsp;                /* true when info request is active */
   uint8_t info_rx_bits;            /* set 1 if received info type */
   uint32_t peer_ext_fea;           /* Peer's extended features mask */
@@ -418,6 +437,7 @@ typedef struct t_l2c_linkcb {
   BT_HDR* p_hcit_rcv_acl;   /* Current HCIT ACL buf being rcvd */
   uint16_t idle_timeout_sv; /* Save current Idle timeout */
   uint8_t acl_priority;     /* L2C_PRIORITY_NORMAL or L2C_PRIORITY_HIGH */
+  uint8_t api_acl_priority; /* Priority set by L2CA_SetAclPriority */
   tL2CA_NOCP_CB* p_nocp_cb; /* Num Cmpl pkts callback */
 
 #if (L2CAP_NUM_FIXED_CHNLS > 0)
@@ -471,6 +491,9 @@ typedef struct {
   bool is_cong_cback_context;
 
   tL2C_LCB lcb_pool[MAX_L2CAP_LINKS];    /* Link Control Block pool */
+  tL2C_LCB* p_lcb_by_handle[L2C_LCB_INDEX_BUCKETS]; /* LCBs by handle */
+  tL2C_LCB* p_lcb_by_addr[L2C_LCB_INDEX_BUCKETS];   /* LCBs by BD address */
+  uint8_t num_tx_pending_links; /* Links with tx_pending set */
   tL2C_CCB ccb_pool[MAX_L2CAP_CHANNELS]; /* Channel Control Block pool */
   tL2C_RCB rcb_pool[MAX_L2CAP_CLIENTS];  /* Registration info pool */
 
@@ -526,6 +549,8 @@ typedef struct {
   uint16_t le_dyn_psm; /* Next LE dynamic PSM value to try to assign */
   bool le_dyn_psm_assigned[LE_DYNAMIC_PSM_RANGE]; /* Table of assigned LE PSM */
 
+  int link_quality_observer_id; /* Id of the BQR link quality observer */
+
 } tL2C_CB;
 
 /* Define a structure that contains the information about a connection.
@@ -593,12 +618,14 @@ extern void l2cu_release_lcb(tL2C_LCB* p_lcb);
 extern tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
                                           tBT_TRANSPORT transport);
 extern tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle);
+extern void l2cu_set_lcb_handle(tL2C_LCB* p_lcb, uint16_t handle);
 extern void l2cu_update_lcb_4_bonding(const RawAddress& p_bd_addr,
                                       bool is_bonding);
 
 extern uint8_t l2cu_get_conn_role(tL2C_LCB* p_this_lcb);
 extern bool l2cu_set_acl_priority(const RawAddress& bd_addr, uint8_t priority,
                                   bool reset_after_rs);
+extern void l2cu_update_acl_priority(tL2C_LCB* p_lcb);
 
 extern void l2cu_enqueue_ccb(tL2C_CCB* p_ccb);
 extern void l2cu_dequeue_ccb(tL2C_CCB* p_ccb);
@@ -710,7 +737,11 @@ extern void l2c_link_timeout(tL2C_LCB* p_lcb);
 extern void l2c_info_resp_timer_timeout(void* data);
 extern void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb,
                                      BT_HDR* p_buf);
+extern void l2c_link_set_tx_pending(tL2C_LCB* p_lcb, bool tx_pending);
 extern void l2c_link_adjust_allocation(void);
+extern void l2c_link_process_link_quality(uint16_t handle,
+                                          uint32_t retransmissions,
+                                          uint32_t buffer_overflow_bytes);
 extern void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len);
 extern void l2c_link_process_num_completed_blocks(uint8_t controller_id,
                                                   uint8_t* p, uint16_t evt_len);
@@ -45,6 +45,7 @@
 
 static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
                                    tL2C_TX_COMPLETE_CB_INFO* p_cbi);
+static void l2c_link_check_send_high_pri_pkts(void);
 
 /*******************************************************************************
  *
@@ -186,7 +187,7 @@ bool l2c_link_hci_conn_comp(uint8_t status, uint16_t handle,
   }
 
   /* Save the handle */
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   if (ci.status == HCI_SUCCESS) {
     /* Connected OK. Change state to connected */
@@ -238,7 +239,7 @@ bool l2c_link_hci_conn_comp(uint8_t status, uint16_t handle,
   else if ((ci.status == HCI_ERR_MAX_NUM_OF_CONNECTIONS) &&
            l2cu_lcb_disconnecting()) {
     p_lcb->link_state = LST_CONNECT_HOLDING;
-    p_lcb->handle = HCI_INVALID_HANDLE;
+    l2cu_set_lcb_handle(p_lcb, HCI_INVALID_HANDLE);
   } else {
     /* Just in case app decides to try again in the callback context */
     p_lcb->link_state = LST_DISCONNECTING;
@@ -675,9 +676,11 @@ void l2c_info_resp_timer_timeout(void* data) {
  ******************************************************************************/
 void l2c_link_adjust_allocation(void) {
   uint16_t qq, yy, qq_remainder;
+  uint16_t degraded_qq = 0;
   tL2C_LCB* p_lcb;
   uint16_t hi_quota, low_quota;
   uint16_t num_lowpri_links = 0;
+  uint16_t num_degraded_links = 0;
   uint16_t num_hipri_links = 0;
   uint16_t controller_xmit_quota = l2cb.num_lm_acl_bufs;
   uint16_t high_pri_link_quota = L2CAP_HIGH_PRI_MIN_XMIT_QUOTA_A;
@@ -697,8 +700,10 @@ void l2c_link_adjust_allocation(void) {
         (is_share_buffer || p_lcb->transport != BT_TRANSPORT_LE)) {
       if (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)
         num_hipri_links++;
-      else
+      else {
         num_lowpri_links++;
+        if (p_lcb->link_degraded) num_degraded_links++;
+      }
     }
   }
 
@@ -726,6 +731,17 @@ void l2c_link_adjust_allocation(void) {
     l2cb.round_robin_unacked = 0;
     qq = low_quota / num_lowpri_links;
     qq_remainder = low_quota % num_lowpri_links;
+
+    /* Degraded links get half a share, spread over the healthy links: they
+     * would hold their buffers in retransmissions meanwhile */
+    if (num_degraded_links > 0 && num_degraded_links < num_lowpri_links &&
+        qq >= 2) {
+      uint16_t num_healthy_links = num_lowpri_links - num_degraded_links;
+      uint16_t healthy_quota = low_quota - num_degraded_links * (qq / 2);
+      degraded_qq = qq / 2;
+      qq = healthy_quota / num_healthy_links;
+      qq_remainder = healthy_quota % num_healthy_links;
+    }
   }
   /* If no low priority link */
   else {
@@ -736,8 +752,9 @@ void l2c_link_adjust_allocation(void) {
 
   L2CAP_TRACE_EVENT(
       "l2c_link_adjust_allocation  num_hipri: %u  num_lowpri: %u  low_quota: "
-      "%u  round_robin_quota: %u  qq: %u",
-      num_hipri_links, num_lowpri_links, low_quota, l2cb.round_robin_quota, qq);
+      "%u  round_robin_quota: %u  qq: %u  degraded: %u  degraded_qq: %u",
+      num_hipri_links, num_lowpri_links, low_quota, l2cb.round_robin_quota, qq,
+      num_degraded_links, degraded_qq);
 
   /* Now, assign the quotas to each link */
   for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < MAX_L2CAP_LINKS; yy++, p_lcb++) {
@@ -754,10 +771,14 @@ void l2c_link_adjust_allocation(void) {
         if ((p_lcb->link_xmit_quota > 0) && (qq == 0))
           l2cb.round_robin_unacked += p_lcb->sent_not_acked;
 
-        p_lcb->link_xmit_quota = qq;
-        if (qq_remainder > 0) {
-          p_lcb->link_xmit_quota++;
-          qq_remainder--;
+        if (degraded_qq > 0 && p_lcb->link_degraded) {
+          p_lcb->link_xmit_quota = degraded_qq;
+        } else {
+          p_lcb->link_xmit_quota = qq;
+          if (qq_remainder > 0) {
+            p_lcb->link_xmit_quota++;
+            qq_remainder--;
+          }
         }
       }
 
@@ -782,6 +803,34 @@ void l2c_link_adjust_allocation(void) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         l2c_link_process_link_quality
+ *
+ * Description      This function is called with each link quality report of
+ *                  the controller. A link gets degraded while its
+ *                  retransmissions rise or the controller overflows its
+ *                  buffer, and the link quotas are readjusted when it changes.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_link_process_link_quality(uint16_t handle, uint32_t retransmissions,
+                                   uint32_t buffer_overflow_bytes) {
+  tL2C_LCB* p_lcb = l2cu_find_lcb_by_handle(handle);
+  if (p_lcb == NULL) return;
+
+  bool degraded = retransmissions > p_lcb->lq_retransmissions ||
+                  buffer_overflow_bytes > 0;
+  p_lcb->lq_retransmissions = retransmissions;
+  if (degraded == p_lcb->link_degraded) return;
+
+  L2CAP_TRACE_EVENT("%s handle: 0x%04x degraded: %d", __func__, handle,
+                    degraded);
+  p_lcb->link_degraded = degraded;
+  l2c_link_adjust_allocation();
+}
+
 /*******************************************************************************
  *
  * Function         l2c_link_adjust_chnl_allocation
@@ -974,6 +1023,10 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
   int xx;
   bool single_write = false;
 
+  /* Every path queueing data on a link, or unblocking it, comes here with
+   * the link, so that the round-robin only visits the links marked here */
+  if (p_lcb != NULL) l2c_link_set_tx_pending(p_lcb, true);
+
   /* Save the channel ID for faster counting */
   if (p_buf) {
     if (p_ccb != NULL) {
@@ -1022,7 +1075,8 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
             l2cb.controller_le_xmit_window == 0)))
         continue;
 
-      if ((!p_lcb->in_use) || (p_lcb->partial_segment_being_sent) ||
+      if ((!p_lcb->in_use) || (!p_lcb->tx_pending) ||
+          (p_lcb->partial_segment_being_sent) ||
           (p_lcb->link_state != LST_CONNECTED) ||
           (p_lcb->link_xmit_quota != 0) || (L2C_LINK_CHECK_POWER_MODE(p_lcb)))
         continue;
@@ -1042,6 +1096,8 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
         p_buf = l2cu_get_next_buffer_to_send(p_lcb, &cbi);
         if (p_buf != NULL) {
           l2c_link_send_to_lower(p_lcb, p_buf, &cbi);
+        } else {
+          l2c_link_set_tx_pending(p_lcb, false);
         }
       }
     }
@@ -1086,7 +1142,12 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
              (p_lcb->sent_not_acked < p_lcb->link_xmit_quota)) {
         tL2C_TX_COMPLETE_CB_INFO cbi;
         p_buf = l2cu_get_next_buffer_to_send(p_lcb, &cbi);
-        if (p_buf == NULL) break;
+        if (p_buf == NULL) {
+          /* Nothing left to send on this link */
+          if (list_is_empty(p_lcb->link_xmit_data_q))
+            l2c_link_set_tx_pending(p_lcb, false);
+          break;
+        }
 
         if (!l2c_link_send_to_lower(p_lcb, p_buf, &cbi)) break;
       }
@@ -1104,6 +1165,56 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         l2c_link_check_send_high_pri_pkts
+ *
+ * Description      This function is called when the controller acknowledges
+ *                  packets of a normal priority link, to send the packets of
+ *                  the high priority links first. They would otherwise wait
+ *                  for their own acknowledgements when the normal priority
+ *                  links keep the controller window full.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void l2c_link_check_send_high_pri_pkts(void) {
+  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+
+  if (l2cb.num_tx_pending_links == 0) return;
+
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    if ((p_lcb->in_use) && (p_lcb->tx_pending) &&
+        (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH) &&
+        (p_lcb->sent_not_acked < p_lcb->link_xmit_quota))
+      l2c_link_check_send_pkts(p_lcb, NULL, NULL);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_link_set_tx_pending
+ *
+ * Description      This function marks a link as having, or not having, data
+ *                  to send from its link queue or its channels. The mark is
+ *                  set whenever the link goes through l2c_link_check_send_pkts,
+ *                  and cleared when the link has been found with nothing to
+ *                  send, so links without traffic are skipped when serving
+ *                  the links after a Number Of Completed Packets event.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_link_set_tx_pending(tL2C_LCB* p_lcb, bool tx_pending) {
+  if (p_lcb->tx_pending == tx_pending) return;
+
+  p_lcb->tx_pending = tx_pending;
+  if (tx_pending)
+    l2cb.num_tx_pending_links++;
+  else
+    l2cb.num_tx_pending_links--;
+}
+
 /*******************************************************************************
  *
  * Function         l2c_link_send_to_lower
@@ -1119,6 +1230,10 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
   uint16_t xmit_window, acl_data_size;
   const controller_t* controller = controller_get_interface();
 
+  /* keep track of the traffic for the power mode policy */
+  if (p_lcb->transport == BT_TRANSPORT_BR_EDR)
+    btm_pm_proc_traffic(p_lcb->handle);
+
   if ((p_buf->len <= controller->get_acl_packet_size_classic() &&
        (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
       ((p_lcb->transport == BT_TRANSPORT_LE) &&
@@ -1282,6 +1397,11 @@ void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
       else
         p_lcb->sent_not_acked = 0;
 
+      /* Let the high priority links waiting for the controller window go
+       * before this one fills it again */
+      if (p_lcb->acl_priority != L2CAP_PRIORITY_HIGH)
+        l2c_link_check_send_high_pri_pkts();
+
       l2c_link_check_send_pkts(p_lcb, NULL, NULL);
 
       /* If we were doing round-robin for low priority links, check 'em */
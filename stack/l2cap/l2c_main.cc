@@ -30,6 +30,8 @@
 
 #include "bt_common.h"
 #include "bt_target.h"
+#include "btif/include/btif_bqr.h"
+#include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
 #include "hci/include/btsnoop.h"
@@ -139,6 +141,9 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
   /* Update the buffer header */
   p_msg->offset += 4;
 
+  /* keep track of the traffic for the power mode policy */
+  if (p_lcb->transport == BT_TRANSPORT_BR_EDR) btm_pm_proc_traffic(handle);
+
   /* for BLE channel, always notify connection when ACL data received on the
    * link */
   if (p_lcb && p_lcb->transport == BT_TRANSPORT_LE &&
@@ -405,6 +410,9 @@ static void process_l2cap_cmd(tL2C_LCB* p_lcb, uint8_t* p, uint16_t pkt_len) {
           btsnoop_get_interface()->whitelist_l2c_channel(
               p_lcb->handle, p_ccb->local_cid, p_ccb->remote_cid);
         }
+        btsnoop_get_interface()->add_l2c_channel_psm(
+            p_lcb->handle, p_ccb->local_cid, p_ccb->remote_cid,
+            p_rcb->real_psm);
 
         l2c_csm_execute(p_ccb, L2CEVT_L2CAP_CONNECT_REQ, &con_info);
         break;
@@ -445,6 +453,11 @@ static void process_l2cap_cmd(tL2C_LCB* p_lcb, uint8_t* p, uint16_t pkt_len) {
           btsnoop_get_interface()->whitelist_l2c_channel(
               p_lcb->handle, p_ccb->local_cid, p_ccb->remote_cid);
         }
+        if (con_info.l2cap_result == L2CAP_CONN_OK) {
+          btsnoop_get_interface()->add_l2c_channel_psm(
+              p_lcb->handle, p_ccb->local_cid, p_ccb->remote_cid,
+              p_rcb->real_psm);
+        }
 
         break;
       }
@@ -916,9 +929,18 @@ void l2c_init(void) {
   CHECK(l2cb.rcv_pending_q != NULL);
 
   l2cb.receive_hold_timer = alarm_new("l2c.receive_hold_timer");
+
+  l2cb.link_quality_observer_id = bluetooth::bqr::RegisterLinkQualityObserver(
+      [](const bluetooth::bqr::BqrLinkQualityEventView& event) {
+        l2c_link_process_link_quality(event.ConnectionHandle(),
+                                      event.RetransmissionCount(),
+                                      event.BufferOverflowBytes());
+      });
 }
 
 void l2c_free(void) {
+  bluetooth::bqr::UnregisterLinkQualityObserver(l2cb.link_quality_observer_id);
+  l2cb.link_quality_observer_id = 0;
   list_free(l2cb.rcv_pending_q);
   l2cb.rcv_pending_q = NULL;
 }
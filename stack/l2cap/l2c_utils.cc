@@ -56,6 +56,39 @@ bool l2cu_can_allocate_lcb(void) {
   return false;
 }
 
+/* The links are indexed by handle and by BD address in hash tables chaining
+ * the LCBs of each bucket, since the lookups are done for every packet. */
+static size_t l2cu_handle_bucket(uint16_t handle) {
+  return handle & (L2C_LCB_INDEX_BUCKETS - 1);
+}
+
+static size_t l2cu_addr_bucket(const RawAddress& bd_addr) {
+  return (bd_addr.address[3] ^ bd_addr.address[4] ^ bd_addr.address[5]) &
+         (L2C_LCB_INDEX_BUCKETS - 1);
+}
+
+static void l2cu_unindex_lcb_handle(tL2C_LCB* p_lcb) {
+  tL2C_LCB** pp = &l2cb.p_lcb_by_handle[l2cu_handle_bucket(p_lcb->handle)];
+  for (; *pp; pp = &(*pp)->p_next_by_handle) {
+    if (*pp == p_lcb) {
+      *pp = p_lcb->p_next_by_handle;
+      break;
+    }
+  }
+  p_lcb->p_next_by_handle = NULL;
+}
+
+static void l2cu_unindex_lcb_addr(tL2C_LCB* p_lcb) {
+  tL2C_LCB** pp = &l2cb.p_lcb_by_addr[l2cu_addr_bucket(p_lcb->remote_bd_addr)];
+  for (; *pp; pp = &(*pp)->p_next_by_addr) {
+    if (*pp == p_lcb) {
+      *pp = p_lcb->p_next_by_addr;
+      break;
+    }
+  }
+  p_lcb->p_next_by_addr = NULL;
+}
+
 /*******************************************************************************
  *
  * Function         l2cu_allocate_lcb
@@ -77,6 +110,9 @@ tL2C_LCB* l2cu_allocate_lcb(const RawAddress& p_bd_addr, bool is_bonding,
       memset(p_lcb, 0, sizeof(tL2C_LCB));
 
       p_lcb->remote_bd_addr = p_bd_addr;
+      tL2C_LCB** pp_head = &l2cb.p_lcb_by_addr[l2cu_addr_bucket(p_bd_addr)];
+      p_lcb->p_next_by_addr = *pp_head;
+      *pp_head = p_lcb;
 
       p_lcb->in_use = true;
       p_lcb->link_state = LST_DISCONNECTED;
@@ -141,6 +177,12 @@ void l2cu_update_lcb_4_bonding(const RawAddress& p_bd_addr, bool is_bonding) {
 void l2cu_release_lcb(tL2C_LCB* p_lcb) {
   tL2C_CCB* p_ccb;
 
+  if (p_lcb->in_use) {
+    l2cu_unindex_lcb_addr(p_lcb);
+    if (p_lcb->handle != HCI_INVALID_HANDLE) l2cu_unindex_lcb_handle(p_lcb);
+    l2c_link_set_tx_pending(p_lcb, false);
+  }
+
   p_lcb->in_use = false;
   p_lcb->is_bonding = false;
 
@@ -244,10 +286,9 @@ void l2cu_release_lcb(tL2C_LCB* p_lcb) {
  ******************************************************************************/
 tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
                                    tBT_TRANSPORT transport) {
-  int xx;
-  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+  tL2C_LCB* p_lcb = l2cb.p_lcb_by_addr[l2cu_addr_bucket(p_bd_addr)];
 
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  for (; p_lcb; p_lcb = p_lcb->p_next_by_addr) {
     if ((p_lcb->in_use) && p_lcb->transport == transport &&
         (p_lcb->remote_bd_addr == p_bd_addr)) {
       return (p_lcb);
@@ -1424,6 +1465,7 @@ tL2C_CCB* l2cu_allocate_ccb(tL2C_LCB* p_lcb, uint16_t cid) {
 
   /* Set priority then insert ccb into LCB queue (if we have an LCB) */
   p_ccb->ccb_priority = L2CAP_CHNL_PRIORITY_LOW;
+  p_ccb->acl_priority = L2CAP_PRIORITY_NORMAL;
 
   if (p_lcb) l2cu_enqueue_ccb(p_ccb);
 
@@ -1600,6 +1642,12 @@ void l2cu_release_ccb(tL2C_CCB* p_ccb) {
   if ((p_lcb) && ((p_ccb->local_cid >= L2CAP_BASE_APPL_CID))) {
     l2cu_dequeue_ccb(p_ccb);
 
+    /* The link may not need a high priority anymore */
+    if (p_ccb->acl_priority == L2CAP_PRIORITY_HIGH) {
+      p_ccb->acl_priority = L2CAP_PRIORITY_NORMAL;
+      l2cu_update_acl_priority(p_lcb);
+    }
+
     /* Delink the CCB from the LCB */
     p_ccb->p_lcb = NULL;
   }
@@ -2248,8 +2296,10 @@ bool l2cu_create_conn_after_switch(tL2C_LCB* p_lcb) {
     page_scan_mode = p_inq_info->results.page_scan_mode;
     clock_offset = (uint16_t)(p_inq_info->results.clock_offset);
   } else {
-    /* No info known. Use default settings */
-    page_scan_rep_mode = HCI_PAGE_SCAN_REP_MODE_R1;
+    /* No inquiry info known. Use what was learned of the device before, or
+     * default settings */
+    page_scan_rep_mode = (p_dev_rec) ? p_dev_rec->page_scan_rep_mode
+                                     : HCI_PAGE_SCAN_REP_MODE_R1;
     page_scan_mode = HCI_MANDATARY_PAGE_SCAN_MODE;
 
     clock_offset = (p_dev_rec) ? p_dev_rec->clock_offset : 0;
@@ -2337,6 +2387,34 @@ bool l2cu_lcb_disconnecting(void) {
   return status;
 }
 
+/*******************************************************************************
+ *
+ * Function         l2cu_send_acl_priority_vsc
+ *
+ * Description      Sends the priority of an ACL link to a Broadcom controller.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void l2cu_send_acl_priority_vsc(tL2C_LCB* p_lcb, uint8_t priority) {
+  uint8_t* pp;
+  uint8_t command[HCI_BRCM_ACL_PRIORITY_PARAM_SIZE];
+  uint8_t vs_param;
+
+  if (!BTM_IS_BRCM_CONTROLLER()) return;
+
+  pp = command;
+
+  vs_param = (priority == L2CAP_PRIORITY_HIGH) ? HCI_BRCM_ACL_PRIORITY_HIGH
+                                               : HCI_BRCM_ACL_PRIORITY_LOW;
+
+  UINT16_TO_STREAM(pp, p_lcb->handle);
+  UINT8_TO_STREAM(pp, vs_param);
+
+  BTM_VendorSpecificCommand(HCI_BRCM_SET_ACL_PRIORITY,
+                            HCI_BRCM_ACL_PRIORITY_PARAM_SIZE, command, NULL);
+}
+
 /*******************************************************************************
  *
  * Function         l2cu_set_acl_priority
@@ -2352,9 +2430,6 @@ bool l2cu_lcb_disconnecting(void) {
 bool l2cu_set_acl_priority(const RawAddress& bd_addr, uint8_t priority,
                            bool reset_after_rs) {
   tL2C_LCB* p_lcb;
-  uint8_t* pp;
-  uint8_t command[HCI_BRCM_ACL_PRIORITY_PARAM_SIZE];
-  uint8_t vs_param;
 
   APPL_TRACE_EVENT("SET ACL PRIORITY %d", priority);
 
@@ -2365,31 +2440,62 @@ bool l2cu_set_acl_priority(const RawAddress& bd_addr, uint8_t priority,
     return (false);
   }
 
-  if (BTM_IS_BRCM_CONTROLLER()) {
-    /* Called from above L2CAP through API; send VSC if changed */
-    if ((!reset_after_rs && (priority != p_lcb->acl_priority)) ||
-        /* Called because of a master/slave role switch; if high resend VSC */
-        (reset_after_rs && p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)) {
-      pp = command;
+  /* Called because of a master/slave role switch; if high resend VSC */
+  if (reset_after_rs) {
+    if (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)
+      l2cu_send_acl_priority_vsc(p_lcb, L2CAP_PRIORITY_HIGH);
+    return (true);
+  }
 
-      vs_param = (priority == L2CAP_PRIORITY_HIGH) ? HCI_BRCM_ACL_PRIORITY_HIGH
-                                                   : HCI_BRCM_ACL_PRIORITY_LOW;
+  /* Called from above L2CAP through API */
+  p_lcb->api_acl_priority = priority;
+  l2cu_update_acl_priority(p_lcb);
+  return (true);
+}
 
-      UINT16_TO_STREAM(pp, p_lcb->handle);
-      UINT8_TO_STREAM(pp, vs_param);
+/*******************************************************************************
+ *
+ * Function         l2cu_update_acl_priority
+ *
+ * Description      Sets the priority of an ACL link to the highest one of
+ *                  the priority set through L2CA_SetAclPriority and the ones
+ *                  its channels need.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cu_update_acl_priority(tL2C_LCB* p_lcb) {
+  uint8_t priority = p_lcb->api_acl_priority;
 
-      BTM_VendorSpecificCommand(HCI_BRCM_SET_ACL_PRIORITY,
-                                HCI_BRCM_ACL_PRIORITY_PARAM_SIZE, command,
-                                NULL);
+  for (tL2C_CCB* p_ccb = p_lcb->ccb_queue.p_first_ccb; p_ccb;
+       p_ccb = p_ccb->p_next_ccb) {
+    if (p_ccb->acl_priority == L2CAP_PRIORITY_HIGH) {
+      priority = L2CAP_PRIORITY_HIGH;
+      break;
     }
   }
 
+  for (int xx = 0; xx < L2CAP_NUM_FIXED_CHNLS; xx++) {
+    if (p_lcb->p_fixed_ccbs[xx] != NULL &&
+        p_lcb->p_fixed_ccbs[xx]->acl_priority == L2CAP_PRIORITY_HIGH)
+      priority = L2CAP_PRIORITY_HIGH;
+  }
+
+  if (priority == p_lcb->acl_priority) return;
+
+  L2CAP_TRACE_EVENT("%s: handle 0x%04x priority %d", __func__, p_lcb->handle,
+                    priority);
+
+  /* send VSC if changed */
+  if (p_lcb->transport == BT_TRANSPORT_BR_EDR)
+    l2cu_send_acl_priority_vsc(p_lcb, priority);
+
   /* Adjust lmp buffer allocation for this channel if priority changed */
-  if (p_lcb->acl_priority != priority) {
-    p_lcb->acl_priority = priority;
+  p_lcb->acl_priority = priority;
+  if (p_lcb->transport == BT_TRANSPORT_LE)
+    l2c_ble_link_adjust_allocation();
+  else
     l2c_link_adjust_allocation();
-  }
-  return (true);
 }
 
 #if (L2CAP_NON_FLUSHABLE_PB_INCLUDED == TRUE)
@@ -3027,10 +3133,9 @@ void l2cu_send_peer_ble_credit_based_disconn_req(tL2C_CCB* p_ccb) {
  *
  ******************************************************************************/
 tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
-  int xx;
-  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+  tL2C_LCB* p_lcb = l2cb.p_lcb_by_handle[l2cu_handle_bucket(handle)];
 
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  for (; p_lcb; p_lcb = p_lcb->p_next_by_handle) {
     if ((p_lcb->in_use) && (p_lcb->handle == handle)) {
       return (p_lcb);
     }
@@ -3040,6 +3145,27 @@ tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         l2cu_set_lcb_handle
+ *
+ * Description      Sets the handle of a link, and moves the link to its
+ *                  bucket of the handle index.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cu_set_lcb_handle(tL2C_LCB* p_lcb, uint16_t handle) {
+  if (p_lcb->handle != HCI_INVALID_HANDLE) l2cu_unindex_lcb_handle(p_lcb);
+
+  p_lcb->handle = handle;
+  if (handle != HCI_INVALID_HANDLE) {
+    tL2C_LCB** pp_head = &l2cb.p_lcb_by_handle[l2cu_handle_bucket(handle)];
+    p_lcb->p_next_by_handle = *pp_head;
+    *pp_head = p_lcb;
+  }
+}
+
 /*******************************************************************************
  *
  * Function         l2cu_find_ccb_by_cid
@@ -3429,13 +3555,19 @@ void l2cu_check_channel_congestion(tL2C_CCB* p_ccb) {
 
   size_t q_count = fixed_queue_length(p_ccb->xmit_hold_q);
 
+  /* An LE CoC channel out of credits cannot send what is queued, so hold the
+   * app back until the peer returns credits instead of filling the queue */
+  bool out_of_credits = p_ccb->p_lcb->transport == BT_TRANSPORT_LE &&
+                        p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_LE_COC_MODE &&
+                        p_ccb->peer_conn_cfg.credits == 0 && q_count > 0;
+
   if (p_ccb->cong_sent) {
     /* if channel was congested, but is not congested now, tell the app */
-    if (q_count <= (p_ccb->buff_quota / 2))
+    if (q_count <= (p_ccb->buff_quota / 2) && !out_of_credits)
       send_congestion_status_to_all_clients(p_ccb, false);
   } else {
     /* if channel was not congested, but is congested now, tell the app */
-    if (q_count > p_ccb->buff_quota)
+    if (q_count > p_ccb->buff_quota || out_of_credits)
       send_congestion_status_to_all_clients(p_ccb, true);
   }
 }
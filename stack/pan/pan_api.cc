@@ -472,7 +472,9 @@ tPAN_RESULT PAN_Write(uint16_t handle, const RawAddress& dst,
   memcpy((uint8_t*)buffer + sizeof(BT_HDR) + buffer->offset, p_data,
          buffer->len);
 
-  return PAN_WriteBuf(handle, dst, src, protocol, buffer, ext);
+  tPAN_RESULT result = PAN_WriteBuf(handle, dst, src, protocol, buffer, ext);
+  if (result == PAN_Q_SIZE_EXCEEDED) osi_free(buffer);
+  return result;
 }
 
 /*******************************************************************************
@@ -494,6 +496,8 @@ tPAN_RESULT PAN_Write(uint16_t handle, const RawAddress& dst,
  *                  ext      - to indicate that extension headers present
  *
  * Returns          PAN_SUCCESS       - if the data is sent successfully
+ *                  PAN_Q_SIZE_EXCEEDED - if the BNEP Tx Q is full. The
+ *                                      buffer is not freed.
  *                  PAN_FAILURE       - if the connection is not found or
  *                                           there is an error in sending data
  *
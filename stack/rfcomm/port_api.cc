@@ -815,6 +815,35 @@ static int port_write(tPORT* p_port, BT_HDR* p_buf) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         port_get_tx_tail
+ *
+ * Description      This function returns the last buffer waiting in the tx
+ *                  queue if it has room for more data, so that data written
+ *                  while the peer is flow controlling the port is sent in
+ *                  full size frames.  Must be called with the global lock.
+ *
+ * Parameters:      p_port     - pointer to address of port control block
+ *                  p_room     - free room at the end of the buffer
+ *
+ * Returns          pointer to the buffer, or NULL if there is none with room
+ *
+ ******************************************************************************/
+static BT_HDR* port_get_tx_tail(tPORT* p_port, uint16_t* p_room) {
+  /* Length for each buffer is the smaller of GKI buffer or peer MTU */
+  uint16_t length =
+      RFCOMM_DATA_BUF_SIZE -
+      (uint16_t)(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + RFCOMM_DATA_OVERHEAD);
+  if (p_port->peer_mtu < length) length = p_port->peer_mtu;
+
+  BT_HDR* p_buf = (BT_HDR*)fixed_queue_try_peek_last(p_port->tx.queue);
+  if ((p_buf == NULL) || (p_buf->len >= length)) return NULL;
+
+  *p_room = length - p_buf->len;
+  return p_buf;
+}
+
 /*******************************************************************************
  *
  * Function         PORT_WriteDataCO
@@ -870,42 +899,35 @@ int PORT_WriteDataCO(uint16_t handle, int* p_len) {
   length = RFCOMM_DATA_BUF_SIZE -
            (uint16_t)(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + RFCOMM_DATA_OVERHEAD);
 
-  /* If there are buffers scheduled for transmission check if requested */
-  /* data fits into the end of the queue */
+  /* If there are buffers scheduled for transmission fill the end of the */
+  /* queue first */
   mutex_global_lock();
 
-  p_buf = (BT_HDR*)fixed_queue_try_peek_last(p_port->tx.queue);
-  if ((p_buf != NULL) &&
-      (((int)p_buf->len + available) <= (int)p_port->peer_mtu) &&
-      (((int)p_buf->len + available) <= (int)length)) {
-    // if(recv(fd, (uint8_t *)(p_buf + 1) + p_buf->offset + p_buf->len,
-    // available, 0) != available)
+  uint16_t room = 0;
+  p_buf = port_get_tx_tail(p_port, &room);
+  if (p_buf != NULL) {
+    if (available < (int)room) room = (uint16_t)available;
     if (!p_port->p_data_co_callback(
-            handle, (uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len,
-            available, DATA_CO_CALLBACK_TYPE_OUTGOING))
-
-    {
+            handle, (uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len, room,
+            DATA_CO_CALLBACK_TYPE_OUTGOING)) {
       error(
           "p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING failed, "
-          "available:%d",
-          available);
+          "room:%d",
+          room);
       mutex_global_unlock();
       return (PORT_UNKNOWN_ERROR);
     }
-    // memcpy ((uint8_t *)(p_buf + 1) + p_buf->offset + p_buf->len, p_data,
-    // max_len);
-    p_port->tx.queue_size += (uint16_t)available;
-
-    *p_len = available;
-    p_buf->len += (uint16_t)available;
-
-    mutex_global_unlock();
+    p_port->tx.queue_size += room;
 
-    return (PORT_SUCCESS);
+    *p_len = room;
+    p_buf->len += room;
+    available -= (int)room;
   }
 
   mutex_global_unlock();
 
+  if (available == 0) return (PORT_SUCCESS);
+
   // int max_read = length < p_port->peer_mtu ? length : p_port->peer_mtu;
 
   // max_read = available < max_read ? available : max_read;
@@ -1017,26 +1039,27 @@ int PORT_WriteData(uint16_t handle, const char* p_data, uint16_t max_len,
   length = RFCOMM_DATA_BUF_SIZE -
            (uint16_t)(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + RFCOMM_DATA_OVERHEAD);
 
-  /* If there are buffers scheduled for transmission check if requested */
-  /* data fits into the end of the queue */
+  /* If there are buffers scheduled for transmission fill the end of the */
+  /* queue first */
   mutex_global_lock();
 
-  p_buf = (BT_HDR*)fixed_queue_try_peek_last(p_port->tx.queue);
-  if ((p_buf != NULL) && ((p_buf->len + max_len) <= p_port->peer_mtu) &&
-      ((p_buf->len + max_len) <= length)) {
-    memcpy((uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len, p_data, max_len);
-    p_port->tx.queue_size += max_len;
-
-    *p_len = max_len;
-    p_buf->len += max_len;
-
-    mutex_global_unlock();
-
-    return (PORT_SUCCESS);
+  uint16_t room = 0;
+  p_buf = port_get_tx_tail(p_port, &room);
+  if (p_buf != NULL) {
+    if (max_len < room) room = max_len;
+    memcpy((uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len, p_data, room);
+    p_port->tx.queue_size += room;
+
+    *p_len = room;
+    p_buf->len += room;
+    max_len -= room;
+    p_data += room;
   }
 
   mutex_global_unlock();
 
+  if (max_len == 0) return (PORT_SUCCESS);
+
   while (max_len) {
     /* if we're over buffer high water mark, we're done */
     if ((p_port->tx.queue_size > PORT_TX_HIGH_WM) ||
@@ -182,6 +182,7 @@ typedef struct {
   uint16_t
       credit_rx_max; /* Max number of credits we will allow this guy to sent */
   uint16_t credit_rx_low;   /* Number of credits when we send credit update */
+  uint16_t credit_rx_base;  /* credit_rx_max selected for the MTU */
   uint16_t rx_buf_critical; /* port receive queue critical watermark level */
   bool keep_port_handle;    /* true if port is not deallocated when closing */
   /* it is set to true for server when allocating port */
@@ -36,6 +36,10 @@
 #include "rfc_int.h"
 #include "rfcdefs.h"
 
+/* Credits granted to a peer whose data is consumed as soon as it arrives grow
+ * up to this multiple of the credits selected for the MTU */
+#define PORT_CREDIT_RX_MAX_SCALE 4
+
 static const tPORT_STATE default_port_pars = {
     PORT_BAUD_RATE_9600,
     PORT_8_BITS,
@@ -180,6 +184,7 @@ void port_select_mtu(tPORT* p_port) {
   p_port->credit_rx_max = (PORT_RX_HIGH_WM / p_port->mtu);
   if (p_port->credit_rx_max > PORT_RX_BUF_HIGH_WM)
     p_port->credit_rx_max = PORT_RX_BUF_HIGH_WM;
+  p_port->credit_rx_base = p_port->credit_rx_max;
   p_port->credit_rx_low = (PORT_RX_LOW_WM / p_port->mtu);
   if (p_port->credit_rx_low > PORT_RX_BUF_LOW_WM)
     p_port->credit_rx_low = PORT_RX_BUF_LOW_WM;
@@ -439,6 +444,36 @@ uint32_t port_get_signal_changes(tPORT* p_port, uint8_t old_signals,
   return (p_port->ev_mask & events);
 }
 
+/*******************************************************************************
+ *
+ * Function         port_adapt_credit_rx_max
+ *
+ * Description      Adapt the number of credits granted to the peer to how fast
+ *                  received data is drained.  Credits grow while a data
+ *                  callback consumes everything the peer sends, and fall back
+ *                  to the credits selected for the MTU once it could not.
+ *                  Data queued in the port keeps the credits selected for the
+ *                  MTU, so that it stays below the receive watermarks.
+ *
+ * Returns          nothing
+ *
+ ******************************************************************************/
+static void port_adapt_credit_rx_max(tPORT* p_port) {
+  if (!p_port->p_data_callback && !p_port->p_data_co_callback) return;
+
+  uint16_t credit_rx_ceiling =
+      PORT_CREDIT_RX_MAX_SCALE * p_port->credit_rx_base;
+  if (credit_rx_ceiling > UINT8_MAX) credit_rx_ceiling = UINT8_MAX;
+
+  if (p_port->rx.peer_fc) {
+    p_port->credit_rx_max = p_port->credit_rx_base;
+  } else if (p_port->credit_rx_max < credit_rx_ceiling) {
+    p_port->credit_rx_max += p_port->credit_rx_base;
+    if (p_port->credit_rx_max > credit_rx_ceiling)
+      p_port->credit_rx_max = credit_rx_ceiling;
+  }
+}
+
 /*******************************************************************************
  *
  * Function         port_flow_control_peer
@@ -467,14 +502,17 @@ void port_flow_control_peer(tPORT* p_port, bool enable, uint16_t count) {
       /* If credit count is less than low credit watermark, and user */
       /* did not force flow control, send a credit update */
       /* There might be a special case when we just adjusted rx_max */
-      if ((p_port->credit_rx <= p_port->credit_rx_low) && !p_port->rx.user_fc &&
-          (p_port->credit_rx_max > p_port->credit_rx)) {
-        rfc_send_credit(p_port->rfc.p_mcb, p_port->dlci,
-                        (uint8_t)(p_port->credit_rx_max - p_port->credit_rx));
+      if ((p_port->credit_rx <= p_port->credit_rx_low) && !p_port->rx.user_fc) {
+        port_adapt_credit_rx_max(p_port);
 
-        p_port->credit_rx = p_port->credit_rx_max;
+        if (p_port->credit_rx_max > p_port->credit_rx) {
+          rfc_send_credit(p_port->rfc.p_mcb, p_port->dlci,
+                          (uint8_t)(p_port->credit_rx_max - p_port->credit_rx));
 
-        p_port->rx.peer_fc = false;
+          p_port->credit_rx = p_port->credit_rx_max;
+
+          p_port->rx.peer_fc = false;
+        }
       }
     }
     /* else want to disable flow from peer */
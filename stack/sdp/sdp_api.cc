@@ -106,6 +106,8 @@ bool SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB* p_db, uint32_t len,
  *
  ******************************************************************************/
 bool SDP_CancelServiceSearch(tSDP_DISCOVERY_DB* p_db) {
+  if (sdp_cache_cancel(p_db)) return (true);
+
   tCONN_CB* p_ccb = sdpu_find_ccb_by_db(p_db);
   if (!p_ccb) return (false);
 
@@ -159,6 +161,9 @@ bool SDP_ServiceSearchAttributeRequest(const RawAddress& p_bd_addr,
                                        tSDP_DISC_CMPL_CB* p_cb) {
   tCONN_CB* p_ccb;
 
+  /* Bonded peers whose services did not change are answered from the cache */
+  if (sdp_cache_load(p_bd_addr, p_db, p_cb, NULL, NULL)) return (true);
+
   /* Specific BD address */
   p_ccb = sdp_conn_originate(p_bd_addr);
 
@@ -192,6 +197,9 @@ bool SDP_ServiceSearchAttributeRequest2(const RawAddress& p_bd_addr,
                                         void* user_data) {
   tCONN_CB* p_ccb;
 
+  /* Bonded peers whose services did not change are answered from the cache */
+  if (sdp_cache_load(p_bd_addr, p_db, NULL, p_cb2, user_data)) return (true);
+
   /* Specific BD address */
   p_ccb = sdp_conn_originate(p_bd_addr);
 
@@ -224,6 +232,9 @@ tSDP_DISC_ATTR* SDP_FindAttributeInRec(tSDP_DISC_REC* p_rec, uint16_t attr_id) {
   while (p_attr) {
     if (p_attr->attr_id == attr_id) return (p_attr);
 
+    /* Servers send the attributes of a record by ascending ID */
+    if (p_rec->attrs_in_order && p_attr->attr_id > attr_id) break;
+
     p_attr = p_attr->p_next_attr;
   }
 
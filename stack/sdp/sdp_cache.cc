@@ -0,0 +1,371 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the cache of service search attribute responses of
+ *  bonded peers. A profile connecting again to a peer whose services did not
+ *  change gets its discovery database filled from the cache, without a
+ *  connection to the SDP server of the peer.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <base/bind.h>
+
+#include "bt_common.h"
+#include "bt_target.h"
+#include "btif_config.h"
+#include "btm_api.h"
+#include "btm_int.h"
+#include "btu.h"
+#include "common/init_flags.h"
+#include "osi/include/log.h"
+#include "sdp_api.h"
+#include "sdpint.h"
+
+/* Version of the format below, a cache in any other format is dropped.
+ *
+ * version            1 byte
+ * EIR services       BTM_EIR_SERVICE_ARRAY_SIZE * 4 bytes, little endian
+ * entries, most recently used first, each:
+ *   key length       2 bytes, then the UUID and attribute filters
+ *   list length      2 bytes, then the service search attribute response
+ */
+#define SDP_CACHE_VERSION 1
+
+/* Limits of the cache of one peer, the least recently used entry is dropped
+ * first */
+#define SDP_CACHE_MAX_ENTRIES 8
+#define SDP_CACHE_MAX_BYTES (2 * SDP_MAX_LIST_BYTE_COUNT)
+
+typedef struct {
+  std::vector<uint8_t> key;
+  std::vector<uint8_t> list;
+} tSDP_CACHE_ENTRY;
+
+typedef struct {
+  uint32_t eir_uuid[BTM_EIR_SERVICE_ARRAY_SIZE];
+  std::list<tSDP_CACHE_ENTRY> entries;
+} tSDP_CACHE;
+
+/* A search answered from the cache, completed from the main loop as if the
+ * response came from the peer */
+typedef struct {
+  tSDP_DISCOVERY_DB* p_db;
+  tSDP_DISC_CMPL_CB* p_cb;
+  tSDP_DISC_CMPL_CB2* p_cb2;
+  void* user_data;
+  uint16_t result;
+} tSDP_CACHE_PENDING;
+
+static std::list<tSDP_CACHE_PENDING> sdp_cache_pending;
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_build_key
+ *
+ * Description      This function builds the key of the search of a discovery
+ *                  database, its UUID and attribute filters.
+ *
+ * Returns          the key
+ *
+ ******************************************************************************/
+static std::vector<uint8_t> sdp_cache_build_key(tSDP_DISCOVERY_DB* p_db) {
+  std::vector<uint8_t> key;
+
+  key.push_back(p_db->num_uuid_filters);
+  for (uint16_t xx = 0; xx < p_db->num_uuid_filters; xx++) {
+    const auto uuid = p_db->uuid_filters[xx].To128BitBE();
+    key.insert(key.end(), uuid.begin(), uuid.end());
+  }
+  key.push_back(p_db->num_attr_filters);
+  for (uint16_t xx = 0; xx < p_db->num_attr_filters; xx++) {
+    key.push_back(p_db->attr_filters[xx] >> 8);
+    key.push_back(p_db->attr_filters[xx] & 0xff);
+  }
+  return key;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_read_eir
+ *
+ * Description      This function reads the services of the last EIR received
+ *                  from a peer.
+ *
+ * Returns          true if an EIR with services was received
+ *
+ ******************************************************************************/
+static bool sdp_cache_read_eir(const RawAddress& bd_addr, uint32_t* p_eir) {
+  tBTM_INQ_INFO* p_inq_info = BTM_InqDbRead(bd_addr);
+  bool found = false;
+
+  memset(p_eir, 0, BTM_EIR_SERVICE_ARRAY_SIZE * sizeof(uint32_t));
+  if (!p_inq_info) return false;
+
+  for (uint8_t xx = 0; xx < BTM_EIR_SERVICE_ARRAY_SIZE; xx++) {
+    p_eir[xx] = p_inq_info->results.eir_uuid[xx];
+    if (p_eir[xx] != 0) found = true;
+  }
+  return found;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_read
+ *
+ * Description      This function reads the cache of a peer from the config.
+ *
+ * Returns          true if a valid cache was read
+ *
+ ******************************************************************************/
+static bool sdp_cache_read(const std::string& section, tSDP_CACHE* p_cache) {
+  size_t length = btif_config_get_bin_length(section, BT_CONFIG_KEY_SDP_CACHE);
+  if (length == 0) return false;
+
+  std::vector<uint8_t> blob(length);
+  if (!btif_config_get_bin(section, BT_CONFIG_KEY_SDP_CACHE, blob.data(),
+                           &length)) {
+    return false;
+  }
+
+  uint8_t* p = blob.data();
+  uint8_t* p_end = p + length;
+  uint8_t version;
+  uint16_t len;
+
+  if (length < 1 + sizeof(p_cache->eir_uuid)) return false;
+  STREAM_TO_UINT8(version, p);
+  if (version != SDP_CACHE_VERSION) return false;
+  for (uint8_t xx = 0; xx < BTM_EIR_SERVICE_ARRAY_SIZE; xx++) {
+    STREAM_TO_UINT32(p_cache->eir_uuid[xx], p);
+  }
+
+  while (p < p_end) {
+    tSDP_CACHE_ENTRY entry;
+
+    if (p_end - p < 2) return false;
+    STREAM_TO_UINT16(len, p);
+    if (p_end - p < len) return false;
+    entry.key.assign(p, p + len);
+    p += len;
+
+    if (p_end - p < 2) return false;
+    STREAM_TO_UINT16(len, p);
+    if (p_end - p < len || len == 0) return false;
+    entry.list.assign(p, p + len);
+    p += len;
+
+    p_cache->entries.push_back(std::move(entry));
+  }
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_write
+ *
+ * Description      This function writes the cache of a peer to the config.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_cache_write(const std::string& section,
+                            const tSDP_CACHE& cache) {
+  std::vector<uint8_t> blob;
+
+  blob.push_back(SDP_CACHE_VERSION);
+  for (uint8_t xx = 0; xx < BTM_EIR_SERVICE_ARRAY_SIZE; xx++) {
+    for (uint8_t yy = 0; yy < 4; yy++) {
+      blob.push_back((cache.eir_uuid[xx] >> (8 * yy)) & 0xff);
+    }
+  }
+  for (const tSDP_CACHE_ENTRY& entry : cache.entries) {
+    blob.push_back(entry.key.size() & 0xff);
+    blob.push_back(entry.key.size() >> 8);
+    blob.insert(blob.end(), entry.key.begin(), entry.key.end());
+    blob.push_back(entry.list.size() & 0xff);
+    blob.push_back(entry.list.size() >> 8);
+    blob.insert(blob.end(), entry.list.begin(), entry.list.end());
+  }
+  btif_config_set_bin(section, BT_CONFIG_KEY_SDP_CACHE, blob.data(),
+                      blob.size());
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_complete
+ *
+ * Description      This function completes the oldest search of a discovery
+ *                  database answered from the cache.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_cache_complete(tSDP_DISCOVERY_DB* p_db) {
+  for (auto it = sdp_cache_pending.begin(); it != sdp_cache_pending.end();
+       it++) {
+    if (it->p_db != p_db) continue;
+
+    tSDP_CACHE_PENDING pending = *it;
+    sdp_cache_pending.erase(it);
+    if (pending.p_cb)
+      (*pending.p_cb)(pending.result);
+    else if (pending.p_cb2)
+      (*pending.p_cb2)(pending.result, pending.user_data);
+    return;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_load
+ *
+ * Description      This function fills a discovery database from the cache of
+ *                  a peer, if a previous search with the same filters was
+ *                  saved and the services of the peer did not change since.
+ *                  The callback is then called from the main loop.
+ *
+ * Returns          true if the search was answered from the cache
+ *
+ ******************************************************************************/
+bool sdp_cache_load(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                    tSDP_DISC_CMPL_CB* p_cb, tSDP_DISC_CMPL_CB2* p_cb2,
+                    void* user_data) {
+  if (!bluetooth::common::InitFlags::SdpDiscoveryCacheEnabled()) return false;
+  if (!btm_sec_is_a_bonded_dev(bd_addr)) return false;
+
+  std::string section = bd_addr.ToString();
+  tSDP_CACHE cache;
+  if (!sdp_cache_read(section, &cache)) return false;
+
+  /* A peer changing its services usually changes the services in its EIR */
+  uint32_t eir_uuid[BTM_EIR_SERVICE_ARRAY_SIZE];
+  if (sdp_cache_read_eir(bd_addr, eir_uuid) &&
+      memcmp(eir_uuid, cache.eir_uuid, sizeof(eir_uuid)) != 0) {
+    SDP_TRACE_EVENT("%s: EIR services changed, dropping the cache",
+                    __func__);
+    btif_config_remove(section, BT_CONFIG_KEY_SDP_CACHE);
+    return false;
+  }
+
+  std::vector<uint8_t> key = sdp_cache_build_key(p_db);
+  for (tSDP_CACHE_ENTRY& entry : cache.entries) {
+    if (entry.key != key) continue;
+
+    uint16_t result = sdp_disc_save_search_attr_list(
+        p_db, bd_addr, entry.list.data(), entry.list.size());
+    if (result != SDP_SUCCESS) {
+      /* Start over from an empty database and search on air */
+      SDP_TRACE_WARNING("%s: cannot use the cache, error 0x%x", __func__,
+                        result);
+      p_db->p_first_rec = NULL;
+      p_db->p_last_rec = NULL;
+      p_db->p_free_mem = (uint8_t*)(p_db + 1);
+      p_db->mem_free = p_db->mem_size;
+#if (SDP_RAW_DATA_INCLUDED == TRUE)
+      p_db->raw_used = 0;
+#endif
+      return false;
+    }
+
+    SDP_TRACE_EVENT("%s: search answered from the cache", __func__);
+    sdp_cache_pending.push_back({p_db, p_cb, p_cb2, user_data, SDP_SUCCESS});
+    do_in_main_thread(FROM_HERE, base::Bind(&sdp_cache_complete, p_db));
+    return true;
+  }
+  return false;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_save
+ *
+ * Description      This function saves a complete service search attribute
+ *                  response of a bonded peer in its cache.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_cache_save(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                    uint8_t* p_list, uint16_t list_len) {
+  if (!bluetooth::common::InitFlags::SdpDiscoveryCacheEnabled()) return;
+  if (!btm_sec_is_a_bonded_dev(bd_addr)) return;
+  if (list_len == 0) return;
+
+  std::string section = bd_addr.ToString();
+  tSDP_CACHE cache;
+  uint32_t eir_uuid[BTM_EIR_SERVICE_ARRAY_SIZE];
+  bool has_eir = sdp_cache_read_eir(bd_addr, eir_uuid);
+
+  if (!sdp_cache_read(section, &cache)) {
+    cache.entries.clear();
+    memcpy(cache.eir_uuid, eir_uuid, sizeof(eir_uuid));
+  } else if (has_eir &&
+             memcmp(eir_uuid, cache.eir_uuid, sizeof(eir_uuid)) != 0) {
+    /* The other entries were read before the services changed */
+    cache.entries.clear();
+    memcpy(cache.eir_uuid, eir_uuid, sizeof(eir_uuid));
+  }
+
+  std::vector<uint8_t> key = sdp_cache_build_key(p_db);
+  cache.entries.remove_if(
+      [&key](const tSDP_CACHE_ENTRY& entry) { return entry.key == key; });
+  cache.entries.push_front({key, std::vector<uint8_t>(p_list,
+                                                      p_list + list_len)});
+
+  size_t total = 0;
+  size_t count = 0;
+  for (auto it = cache.entries.begin(); it != cache.entries.end(); it++) {
+    total += it->key.size() + it->list.size();
+    if (++count > SDP_CACHE_MAX_ENTRIES ||
+        (count > 1 && total > SDP_CACHE_MAX_BYTES)) {
+      cache.entries.erase(it, cache.entries.end());
+      break;
+    }
+  }
+
+  sdp_cache_write(section, cache);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_cancel
+ *
+ * Description      This function cancels a search answered from the cache
+ *                  that did not complete yet. The callback is still called,
+ *                  with SDP_CANCEL.
+ *
+ * Returns          true if such a search was found
+ *
+ ******************************************************************************/
+bool sdp_cache_cancel(tSDP_DISCOVERY_DB* p_db) {
+  for (tSDP_CACHE_PENDING& pending : sdp_cache_pending) {
+    if (pending.p_db == p_db && pending.result != SDP_CANCEL) {
+      pending.result = SDP_CANCEL;
+      return true;
+    }
+  }
+  return false;
+}
@@ -25,6 +25,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <bitset>
+#include <unordered_map>
+#include <vector>
+
 #include "bt_target.h"
 
 #include "bt_common.h"
@@ -32,83 +36,88 @@
 #include "sdp_api.h"
 #include "sdpint.h"
 
+using bluetooth::Uuid;
+
 #if (SDP_SERVER_ENABLED == TRUE)
+/* Attributes of a record serialized as they are sent in responses. Attribute
+ * xx spans from entry_offset[xx] to entry_offset[xx + 1] in entries. */
+typedef struct {
+  std::vector<uint8_t> entries;
+  uint16_t entry_offset[SDP_MAX_REC_ATTR + 1];
+} tSDP_RECORD_CACHE;
+
+/* Both indexed by the position of the record in the database, and rebuilt on
+ * the first request after the database changed */
+static tSDP_RECORD_CACHE sdp_record_cache[SDP_MAX_RECORDS];
+static std::unordered_map<Uuid, std::bitset<SDP_MAX_RECORDS>> sdp_uuid_index;
+
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /******************************************************************************/
-static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
-                             uint16_t his_len, int nest_level);
+static void index_uuids_in_seq(uint8_t* p, uint32_t seq_len,
+                               uint16_t rec_index, int nest_level);
 
 /*******************************************************************************
  *
- * Function         sdp_db_service_search
+ * Function         uuid_from_array
  *
- * Description      This function searches for a record that contains the
- *                  specified UIDs. It is passed either NULL to start at the
- *                  beginning, or the previous record found.
+ * Description      This function converts a 2, 4 or 16 byte UUID to its 128
+ *                  bit form, so that UUIDs of different sizes compare equal.
  *
- * Returns          Pointer to the record, or NULL if not found.
+ * Returns          true if the length is valid, else false
  *
  ******************************************************************************/
-tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
-  uint16_t xx, yy;
-  tSDP_ATTRIBUTE* p_attr;
-  tSDP_RECORD* p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
-
-  /* If NULL, start at the beginning, else start at the first specified record
-   */
-  if (!p_rec)
-    p_rec = &sdp_cb.server_db.record[0];
-  else
-    p_rec++;
-
-  /* Look through the records. The spec says that a match occurs if */
-  /* the record contains all the passed UUIDs in it.                */
-  for (; p_rec < p_end; p_rec++) {
-    for (yy = 0; yy < p_seq->num_uids; yy++) {
-      p_attr = &p_rec->attribute[0];
-      for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
-        if (p_attr->type == UUID_DESC_TYPE) {
-          if (sdpu_compare_uuid_arrays(p_attr->value_ptr, p_attr->len,
-                                       &p_seq->uuid_entry[yy].value[0],
-                                       p_seq->uuid_entry[yy].len))
-            break;
-        } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
-          if (find_uuid_in_seq(p_attr->value_ptr, p_attr->len,
-                               &p_seq->uuid_entry[yy].value[0],
-                               p_seq->uuid_entry[yy].len, 0))
-            break;
-        }
-      }
-      /* If any UUID was not found,  on to the next record */
-      if (xx == p_rec->num_attributes) break;
-    }
-
-    /* If every UUID was found in the record, return the record */
-    if (yy == p_seq->num_uids) return (p_rec);
+static bool uuid_from_array(uint8_t* p_uuid, uint32_t len, Uuid* p_out) {
+  switch (len) {
+    case Uuid::kNumBytes16:
+      *p_out = Uuid::From16Bit((p_uuid[0] << 8) | p_uuid[1]);
+      return true;
+    case Uuid::kNumBytes32:
+      *p_out = Uuid::From32Bit((p_uuid[0] << 24) | (p_uuid[1] << 16) |
+                               (p_uuid[2] << 8) | p_uuid[3]);
+      return true;
+    case Uuid::kNumBytes128:
+      *p_out = Uuid::From128BitBE(p_uuid);
+      return true;
   }
+  return false;
+}
 
-  /* If here, no more records found */
-  return (NULL);
+/*******************************************************************************
+ *
+ * Function         index_uuid
+ *
+ * Description      This function adds the record at rec_index to the records
+ *                  containing a UUID.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void index_uuid(uint8_t* p_uuid, uint32_t len, uint16_t rec_index) {
+  Uuid uuid;
+
+  if (uuid_from_array(p_uuid, len, &uuid))
+    sdp_uuid_index[uuid].set(rec_index);
 }
 
 /*******************************************************************************
  *
- * Function         find_uuid_in_seq
+ * Function         index_uuids_in_seq
  *
- * Description      This function searches a data element sequenct for a UUID.
+ * Description      This function indexes the UUIDs of a data element sequence,
+ *                  and of the sequences nested in it.
  *
- * Returns          true if found, else false
+ * Returns          void
  *
  ******************************************************************************/
-static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_uuid,
-                             uint16_t uuid_len, int nest_level) {
+static void index_uuids_in_seq(uint8_t* p, uint32_t seq_len,
+                               uint16_t rec_index, int nest_level) {
   uint8_t* p_end = p + seq_len;
   uint8_t type;
   uint32_t len;
 
   /* A little safety check to avoid excessive recursion */
-  if (nest_level > 3) return (false);
+  if (nest_level > 3) return;
 
   while (p < p_end) {
     type = *p++;
@@ -119,16 +128,133 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_uuid,
     }
     type = type >> 3;
     if (type == UUID_DESC_TYPE) {
-      if (sdpu_compare_uuid_arrays(p, len, p_uuid, uuid_len)) return (true);
+      index_uuid(p, len, rec_index);
     } else if (type == DATA_ELE_SEQ_DESC_TYPE) {
-      if (find_uuid_in_seq(p, len, p_uuid, uuid_len, nest_level + 1))
-        return (true);
+      index_uuids_in_seq(p, len, rec_index, nest_level + 1);
     }
     p = p + len;
   }
+}
 
-  /* If here, failed to match */
-  return (false);
+/*******************************************************************************
+ *
+ * Function         build_cache
+ *
+ * Description      This function indexes the records by the UUIDs they
+ *                  contain, and serializes their attributes, for the requests
+ *                  to be answered without walking and serializing the records
+ *                  each time.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void build_cache(void) {
+  tSDP_DB* p_db = &sdp_cb.server_db;
+
+  sdp_uuid_index.clear();
+  for (uint16_t xx = 0; xx < p_db->num_records; xx++) {
+    tSDP_RECORD* p_rec = &p_db->record[xx];
+    tSDP_RECORD_CACHE* p_cache = &sdp_record_cache[xx];
+
+    p_cache->entries.clear();
+    for (uint16_t yy = 0; yy < p_rec->num_attributes; yy++) {
+      tSDP_ATTRIBUTE* p_attr = &p_rec->attribute[yy];
+      size_t offset = p_cache->entries.size();
+
+      p_cache->entry_offset[yy] = offset;
+      p_cache->entries.resize(offset + sdpu_get_attrib_entry_len(p_attr));
+      uint8_t* p_end =
+          sdpu_build_attrib_entry(&p_cache->entries[offset], p_attr);
+      p_cache->entries.resize(p_end - &p_cache->entries[0]);
+
+      if (p_attr->type == UUID_DESC_TYPE) {
+        index_uuid(p_attr->value_ptr, p_attr->len, xx);
+      } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
+        index_uuids_in_seq(p_attr->value_ptr, p_attr->len, xx, 0);
+      }
+    }
+    p_cache->entry_offset[p_rec->num_attributes] = p_cache->entries.size();
+  }
+  p_db->cache_valid = true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_service_search
+ *
+ * Description      This function searches for a record that contains the
+ *                  specified UIDs. It is passed either NULL to start at the
+ *                  beginning, or the previous record found.
+ *
+ * Returns          Pointer to the record, or NULL if not found.
+ *
+ ******************************************************************************/
+tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
+  tSDP_DB* p_db = &sdp_cb.server_db;
+  std::bitset<SDP_MAX_RECORDS> matches;
+  uint16_t xx;
+  Uuid uuid;
+
+  if (!p_db->cache_valid) build_cache();
+
+  /* The spec says that a match occurs if the record contains all the passed
+   * UUIDs in it. */
+  matches.set();
+  for (xx = 0; xx < p_seq->num_uids; xx++) {
+    if (!uuid_from_array(&p_seq->uuid_entry[xx].value[0],
+                         p_seq->uuid_entry[xx].len, &uuid))
+      return (NULL);
+    auto it = sdp_uuid_index.find(uuid);
+    if (it == sdp_uuid_index.end()) return (NULL);
+    matches &= it->second;
+  }
+
+  /* If NULL, start at the beginning, else start after the specified record */
+  if (!p_rec)
+    xx = 0;
+  else
+    xx = p_rec - &p_db->record[0] + 1;
+
+  for (; xx < p_db->num_records; xx++) {
+    if (matches.test(xx)) return (&p_db->record[xx]);
+  }
+
+  /* If here, no more records found */
+  return (NULL);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_get_attr_list
+ *
+ * Description      This function appends to a list the attributes of a record
+ *                  that match an attribute sequence, serialized as they are
+ *                  sent in responses.
+ *
+ * Returns          Number of bytes appended.
+ *
+ ******************************************************************************/
+size_t sdp_db_get_attr_list(tSDP_RECORD* p_rec, tSDP_ATTR_SEQ* p_seq,
+                            std::vector<uint8_t>* p_list) {
+  tSDP_DB* p_db = &sdp_cb.server_db;
+  size_t start_len = p_list->size();
+
+  if (!p_db->cache_valid) build_cache();
+
+  tSDP_RECORD_CACHE* p_cache = &sdp_record_cache[p_rec - &p_db->record[0]];
+  for (uint16_t xx = 0; xx < p_seq->num_attr; xx++) {
+    /* Note that the attributes in a record are assumed to be in sorted order
+     */
+    for (uint16_t yy = 0; yy < p_rec->num_attributes; yy++) {
+      uint16_t id = p_rec->attribute[yy].id;
+      if (id < p_seq->attr_entry[xx].start) continue;
+      if (id > p_seq->attr_entry[xx].end) break;
+      p_list->insert(p_list->end(),
+                     p_cache->entries.data() + p_cache->entry_offset[yy],
+                     p_cache->entries.data() + p_cache->entry_offset[yy + 1]);
+    }
+  }
+  return p_list->size() - start_len;
 }
 
 /*******************************************************************************
@@ -298,6 +424,8 @@ bool SDP_DeleteRecord(uint32_t handle) {
   uint16_t xx, yy, zz;
   tSDP_RECORD* p_rec = &sdp_cb.server_db.record[0];
 
+  sdp_cb.server_db.cache_valid = false;
+
   if (handle == 0 || sdp_cb.server_db.num_records == 0) {
     /* Delete all records in the database */
     sdp_cb.server_db.num_records = 0;
@@ -388,6 +516,8 @@ bool SDP_AddAttribute(uint32_t handle, uint16_t attr_id, uint8_t attr_type,
     }
   }
 
+  sdp_cb.server_db.cache_valid = false;
+
   /* Find the record in the database */
   for (zz = 0; zz < sdp_cb.server_db.num_records; zz++, p_rec++) {
     if (p_rec->record_handle == handle) {
@@ -795,6 +925,8 @@ bool SDP_DeleteAttribute(uint32_t handle, uint16_t attr_id) {
   uint8_t* pad_ptr;
   uint32_t len; /* Number of bytes in the entry */
 
+  sdp_cb.server_db.cache_valid = false;
+
   /* Find the record in the database */
   for (uint16_t xx = 0; xx < sdp_cb.server_db.num_records; xx++, p_rec++) {
     if (p_rec->record_handle == handle) {
@@ -817,7 +949,7 @@ bool SDP_DeleteAttribute(uint32_t handle, uint16_t attr_id) {
           /* Found it. Shift everything up one */
           p_rec->num_attributes--;
 
-          for (uint16_t zz = xx; zz < p_rec->num_attributes; zz++, p_attr++) {
+          for (uint16_t zz = yy; zz < p_rec->num_attributes; zz++, p_attr++) {
             *p_attr = *(p_attr + 1);
           }
 
@@ -22,6 +22,7 @@
  *
  ******************************************************************************/
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -48,7 +49,9 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                      uint8_t* p_reply_end);
 static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                             uint8_t* p_reply_end);
-static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end);
+static uint8_t* save_attr_seq(tSDP_DISCOVERY_DB* p_db,
+                              const RawAddress& bd_addr, uint8_t* p,
+                              uint8_t* p_msg_end);
 static tSDP_DISC_REC* add_record(tSDP_DISCOVERY_DB* p_db,
                                  const RawAddress& p_bda);
 static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
@@ -340,18 +343,18 @@ static void process_service_search_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
  *
  ******************************************************************************/
 #if (SDP_RAW_DATA_INCLUDED == TRUE)
-static bool sdp_copy_raw_data(tCONN_CB* p_ccb, bool offset) {
+static bool sdp_copy_raw_data(tSDP_DISCOVERY_DB* p_db, uint8_t* p_list,
+                              uint32_t list_len, bool offset) {
   unsigned int cpy_len, rem_len;
-  uint32_t list_len;
+  uint32_t buf_len = list_len;
   uint8_t* p;
   uint8_t* p_end;
   uint8_t type;
 
-  if (p_ccb->p_db->raw_data) {
-    cpy_len = p_ccb->p_db->raw_size - p_ccb->p_db->raw_used;
-    list_len = p_ccb->list_len;
-    p = &p_ccb->rsp_list[0];
-    p_end = &p_ccb->rsp_list[0] + list_len;
+  if (p_db->raw_data) {
+    cpy_len = p_db->raw_size - p_db->raw_used;
+    p = p_list;
+    p_end = p_list + list_len;
 
     if (offset) {
       cpy_len -= 1;
@@ -371,13 +374,13 @@ static bool sdp_copy_raw_data(tCONN_CB* p_ccb, bool offset) {
     if (list_len < cpy_len) {
       cpy_len = list_len;
     }
-    rem_len = SDP_MAX_LIST_BYTE_COUNT - (unsigned int)(p - &p_ccb->rsp_list[0]);
+    rem_len = buf_len - (unsigned int)(p - p_list);
     if (cpy_len > rem_len) {
       SDP_TRACE_WARNING("rem_len :%d less than cpy_len:%d", rem_len, cpy_len);
       cpy_len = rem_len;
     }
-    memcpy(&p_ccb->p_db->raw_data[p_ccb->p_db->raw_used], p, cpy_len);
-    p_ccb->p_db->raw_used += cpy_len;
+    memcpy(&p_db->raw_data[p_db->raw_used], p, cpy_len);
+    p_db->raw_used += cpy_len;
   }
   return true;
 }
@@ -433,7 +436,8 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
     } else {
 #if (SDP_RAW_DATA_INCLUDED == TRUE)
       SDP_TRACE_WARNING("process_service_attr_rsp");
-      if (!sdp_copy_raw_data(p_ccb, false)) {
+      if (!sdp_copy_raw_data(p_ccb->p_db, p_ccb->rsp_list, p_ccb->list_len,
+                             false)) {
         SDP_TRACE_ERROR("sdp_copy_raw_data failed");
         sdp_disconnect(p_ccb, SDP_ILLEGAL_PARAMETER);
         return;
@@ -442,7 +446,8 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
 #endif
 
       /* Save the response in the database. Stop on any error */
-      if (!save_attr_seq(p_ccb, &p_ccb->rsp_list[0],
+      if (!save_attr_seq(p_ccb->p_db, p_ccb->device_address,
+                         &p_ccb->rsp_list[0],
                          &p_ccb->rsp_list[p_ccb->list_len])) {
         sdp_disconnect(p_ccb, SDP_DB_FULL);
         return;
@@ -523,10 +528,9 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
  ******************************************************************************/
 static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                             uint8_t* p_reply_end) {
-  uint8_t *p, *p_start, *p_end, *p_param_len;
-  uint8_t type;
-  uint32_t seq_len;
+  uint8_t *p, *p_start, *p_param_len;
   uint16_t param_len, lists_byte_count = 0;
+  uint16_t status;
   bool cont_request_needed = false;
 
   /* If p_reply is NULL, we were called for the initial read */
@@ -638,48 +642,70 @@ static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
 /* We now have the full response, which is a sequence of sequences */
 /*******************************************************************/
 
+  status = sdp_disc_save_search_attr_list(p_ccb->p_db, p_ccb->device_address,
+                                          p_ccb->rsp_list, p_ccb->list_len);
+  if (status != SDP_SUCCESS) {
+    sdp_disconnect(p_ccb, status);
+    return;
+  }
+  sdp_cache_save(p_ccb->device_address, p_ccb->p_db, p_ccb->rsp_list,
+                 p_ccb->list_len);
+
+  /* Since we got everything we need, disconnect the call */
+  sdpu_log_attribute_metrics(p_ccb->device_address, p_ccb->p_db);
+  sdp_disconnect(p_ccb, SDP_SUCCESS);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_save_search_attr_list
+ *
+ * Description      This function saves a complete service search attribute
+ *                  response, a sequence of attribute sequences, in the
+ *                  discovery database. It is used both for responses from the
+ *                  server and for responses from the discovery cache.
+ *
+ * Returns          SDP_SUCCESS, or the error to report to the client
+ *
+ ******************************************************************************/
+uint16_t sdp_disc_save_search_attr_list(tSDP_DISCOVERY_DB* p_db,
+                                        const RawAddress& bd_addr,
+                                        uint8_t* p_list, uint16_t list_len) {
+  uint32_t seq_len;
+  uint8_t *p, *p_end, type;
+
 #if (SDP_RAW_DATA_INCLUDED == TRUE)
   SDP_TRACE_WARNING("process_service_search_attr_rsp");
-  if (!sdp_copy_raw_data(p_ccb, true)) {
+  if (!sdp_copy_raw_data(p_db, p_list, list_len, true)) {
     SDP_TRACE_ERROR("sdp_copy_raw_data failed");
-    sdp_disconnect(p_ccb, SDP_ILLEGAL_PARAMETER);
-    return;
+    return SDP_ILLEGAL_PARAMETER;
   }
 #endif
 
-  p = &p_ccb->rsp_list[0];
+  p = &p_list[0];
 
   /* The contents is a sequence of attribute sequences */
   type = *p++;
 
   if ((type >> 3) != DATA_ELE_SEQ_DESC_TYPE) {
     SDP_TRACE_WARNING("SDP - Wrong type: 0x%02x in attr_rsp", type);
-    return;
+    return SDP_ILLEGAL_PARAMETER;
   }
-  p = sdpu_get_len_from_type(p, p + p_ccb->list_len, type, &seq_len);
-  if (p == NULL || (p + seq_len) > (p + p_ccb->list_len)) {
+  p = sdpu_get_len_from_type(p, p + list_len, type, &seq_len);
+  if (p == NULL || (p + seq_len) > (p + list_len)) {
     SDP_TRACE_WARNING("%s: bad length", __func__);
-    sdp_disconnect(p_ccb, SDP_ILLEGAL_PARAMETER);
-    return;
+    return SDP_ILLEGAL_PARAMETER;
   }
-  p_end = &p_ccb->rsp_list[p_ccb->list_len];
+  p_end = &p_list[list_len];
 
-  if ((p + seq_len) != p_end) {
-    sdp_disconnect(p_ccb, SDP_INVALID_CONT_STATE);
-    return;
-  }
+  if ((p + seq_len) != p_end) return SDP_INVALID_CONT_STATE;
 
   while (p < p_end) {
-    p = save_attr_seq(p_ccb, p, &p_ccb->rsp_list[p_ccb->list_len]);
-    if (!p) {
-      sdp_disconnect(p_ccb, SDP_DB_FULL);
-      return;
-    }
+    p = save_attr_seq(p_db, bd_addr, p, p_end);
+    if (!p) return SDP_DB_FULL;
   }
 
-  /* Since we got everything we need, disconnect the call */
-  sdpu_log_attribute_metrics(p_ccb->device_address, p_ccb->p_db);
-  sdp_disconnect(p_ccb, SDP_SUCCESS);
+  return SDP_SUCCESS;
 }
 
 /*******************************************************************************
@@ -692,7 +718,9 @@ static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
  * Returns          pointer to next byte or NULL if error
  *
  ******************************************************************************/
-static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
+static uint8_t* save_attr_seq(tSDP_DISCOVERY_DB* p_db,
+                              const RawAddress& bd_addr, uint8_t* p,
+                              uint8_t* p_msg_end) {
   uint32_t seq_len, attr_len;
   uint16_t attr_id;
   uint8_t type, *p_seq_end;
@@ -711,7 +739,7 @@ static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
   }
 
   /* Create a record */
-  p_rec = add_record(p_ccb->p_db, p_ccb->device_address);
+  p_rec = add_record(p_db, bd_addr);
   if (!p_rec) {
     SDP_TRACE_WARNING("SDP - DB full add_record");
     return (NULL);
@@ -735,7 +763,7 @@ static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
     BE_STREAM_TO_UINT16(attr_id, p);
 
     /* Now, add the attribute value */
-    p = add_attr(p, p_seq_end, p_ccb->p_db, p_rec, attr_id, NULL, 0);
+    p = add_attr(p, p_seq_end, p_db, p_rec, attr_id, NULL, 0);
 
     if (!p) {
       SDP_TRACE_WARNING("SDP - DB full add_attr");
@@ -766,22 +794,39 @@ tSDP_DISC_REC* add_record(tSDP_DISCOVERY_DB* p_db, const RawAddress& p_bda) {
   p_db->mem_free -= sizeof(tSDP_DISC_REC);
 
   p_rec->p_first_attr = NULL;
+  p_rec->p_last_attr = NULL;
   p_rec->p_next_rec = NULL;
+  p_rec->attrs_in_order = true;
 
   p_rec->remote_bd_addr = p_bda;
 
   /* Add the record to the end of chain */
   if (!p_db->p_first_rec)
     p_db->p_first_rec = p_rec;
-  else {
-    tSDP_DISC_REC* p_rec1 = p_db->p_first_rec;
+  else
+    p_db->p_last_rec->p_next_rec = p_rec;
+  p_db->p_last_rec = p_rec;
 
-    while (p_rec1->p_next_rec) p_rec1 = p_rec1->p_next_rec;
+  return (p_rec);
+}
 
-    p_rec1->p_next_rec = p_rec;
-  }
+/*******************************************************************************
+ *
+ * Function         sdp_disc_attr_size
+ *
+ * Description      This function returns the space taken in the database by
+ *                  an attribute with a value of attr_len bytes. Values that
+ *                  do not fit in the attribute are stored right after it, and
+ *                  the size is rounded up so the next entry is aligned.
+ *
+ * Returns          the size in bytes
+ *
+ ******************************************************************************/
+static uint32_t sdp_disc_attr_size(uint32_t attr_len) {
+  uint32_t size = offsetof(tSDP_DISC_ATTR, attr_value.v.array) + attr_len;
 
-  return (p_rec);
+  if (size < sizeof(tSDP_DISC_ATTR)) size = sizeof(tSDP_DISC_ATTR);
+  return (size + alignof(tSDP_DISC_ATTR) - 1) & ~(alignof(tSDP_DISC_ATTR) - 1);
 }
 
 #define SDP_ADDITIONAL_LIST_MASK 0x80
@@ -818,11 +863,7 @@ static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
   attr_len &= SDP_DISC_ATTR_LEN_MASK;
   attr_type = (type >> 3) & 0x0f;
 
-  /* See if there is enough space in the database */
-  if (attr_len > 4)
-    total_len = attr_len - 4 + (uint16_t)sizeof(tSDP_DISC_ATTR);
-  else
-    total_len = sizeof(tSDP_DISC_ATTR);
+  total_len = sdp_disc_attr_size(attr_len);
 
   p_attr_end = p + attr_len;
   if (p_attr_end > p_end) {
@@ -831,9 +872,6 @@ static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
     return NULL;
   }
 
-  /* Ensure it is a multiple of 4 */
-  total_len = (total_len + 3) & ~3;
-
   /* See if there is enough space in the database */
   if (p_db->mem_free < total_len) return (NULL);
 
@@ -979,15 +1017,14 @@ static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
 
   /* Add the attribute to the end of the chain */
   if (!p_parent_attr) {
-    if (!p_rec->p_first_attr)
+    if (!p_rec->p_first_attr) {
       p_rec->p_first_attr = p_attr;
-    else {
-      tSDP_DISC_ATTR* p_attr1 = p_rec->p_first_attr;
-
-      while (p_attr1->p_next_attr) p_attr1 = p_attr1->p_next_attr;
-
-      p_attr1->p_next_attr = p_attr;
+    } else {
+      if (attr_id <= p_rec->p_last_attr->attr_id)
+        p_rec->attrs_in_order = false;
+      p_rec->p_last_attr->p_next_attr = p_attr;
     }
+    p_rec->p_last_attr = p_attr;
   } else {
     if (!p_parent_attr->attr_value.v.p_sub_attr) {
       p_parent_attr->attr_value.v.p_sub_attr = p_attr;
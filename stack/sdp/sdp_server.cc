@@ -26,6 +26,8 @@
 #include <log/log.h>
 #include <string.h>
 
+#include <vector>
+
 #include "bt_common.h"
 #include "bt_types.h"
 
@@ -55,6 +57,12 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
                                             uint16_t param_len, uint8_t* p_req,
                                             uint8_t* p_req_end);
 
+static bool save_rsp_list(tCONN_CB* p_ccb, uint8_t rsp_pdu,
+                          const std::vector<uint8_t>& list);
+
+static void send_attr_list_rsp(tCONN_CB* p_ccb, uint16_t trans_num,
+                               uint16_t max_list_len);
+
 /******************************************************************************/
 /*                E R R O R   T E X T   S T R I N G S                         */
 /*                                                                            */
@@ -305,16 +313,10 @@ static void process_service_search(tCONN_CB* p_ccb, uint16_t trans_num,
 static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
                                      uint16_t param_len, uint8_t* p_req,
                                      uint8_t* p_req_end) {
-  uint16_t max_list_len, len_to_send, cont_offset;
-  int16_t rem_len;
-  tSDP_ATTR_SEQ attr_seq, attr_seq_sav;
-  uint8_t *p_rsp, *p_rsp_start, *p_rsp_param_len;
-  uint16_t rsp_param_len, xx;
+  uint16_t max_list_len, cont_offset;
+  tSDP_ATTR_SEQ attr_seq;
   uint32_t rec_handle;
   tSDP_RECORD* p_rec;
-  tSDP_ATTRIBUTE* p_attr;
-  bool is_cont = false;
-  uint16_t attr_len;
 
   if (p_req + sizeof(rec_handle) + sizeof(max_list_len) > p_req_end) {
     android_errorWriteLog(0x534e4554, "69384124");
@@ -343,8 +345,6 @@ static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     return;
   }
 
-  memcpy(&attr_seq_sav, &attr_seq, sizeof(tSDP_ATTR_SEQ));
-
   /* Find a record with the record handle */
   p_rec = sdp_db_find_record(rec_handle);
   if (!p_rec) {
@@ -359,10 +359,6 @@ static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     return;
   }
 
-  /* Free and reallocate buffer */
-  osi_free(p_ccb->rsp_list);
-  p_ccb->rsp_list = (uint8_t*)osi_malloc(max_list_len);
-
   /* Check if this is a continuation request */
   if (*p_req) {
     if (*p_req++ != SDP_CONTINUATION_LEN ||
@@ -373,155 +369,23 @@ static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     }
     BE_STREAM_TO_UINT16(cont_offset, p_req);
 
-    if (cont_offset != p_ccb->cont_offset) {
+    if (cont_offset != p_ccb->cont_offset || !p_ccb->rsp_list ||
+        p_ccb->rsp_pdu != SDP_PDU_SERVICE_ATTR_RSP) {
       sdpu_build_n_send_error(p_ccb, trans_num, SDP_INVALID_CONT_STATE,
                               SDP_TEXT_BAD_CONT_INX);
       return;
     }
-    is_cont = true;
-
-    /* Initialise for continuation response */
-    p_rsp = &p_ccb->rsp_list[0];
-    attr_seq.attr_entry[p_ccb->cont_info.next_attr_index].start =
-        p_ccb->cont_info.next_attr_start_id;
   } else {
-    p_ccb->cont_offset = 0;
-    p_rsp = &p_ccb->rsp_list[3]; /* Leave space for data elem descr */
-
-    /* Reset continuation parameters in p_ccb */
-    p_ccb->cont_info.prev_sdp_rec = NULL;
-    p_ccb->cont_info.next_attr_index = 0;
-    p_ccb->cont_info.attr_offset = 0;
-  }
-
-  /* Search for attributes that match the list given to us */
-  for (xx = p_ccb->cont_info.next_attr_index; xx < attr_seq.num_attr; xx++) {
-    p_attr = sdp_db_find_attr_in_rec(p_rec, attr_seq.attr_entry[xx].start,
-                                     attr_seq.attr_entry[xx].end);
-
-    if (p_attr) {
-      /* Check if attribute fits. Assume 3-byte value type/length */
-      rem_len = max_list_len - (int16_t)(p_rsp - &p_ccb->rsp_list[0]);
-
-      /* just in case */
-      if (rem_len <= 0) {
-        p_ccb->cont_info.next_attr_index = xx;
-        p_ccb->cont_info.next_attr_start_id = p_attr->id;
-        break;
-      }
-
-      attr_len = sdpu_get_attrib_entry_len(p_attr);
-      /* if there is a partial attribute pending to be sent */
-      if (p_ccb->cont_info.attr_offset) {
-        if (attr_len < p_ccb->cont_info.attr_offset) {
-          android_errorWriteLog(0x534e4554, "79217770");
-          LOG(ERROR) << "offset is bigger than attribute length";
-          sdpu_build_n_send_error(p_ccb, trans_num, SDP_INVALID_CONT_STATE,
-                                  SDP_TEXT_BAD_CONT_LEN);
-          return;
-        }
-        p_rsp = sdpu_build_partial_attrib_entry(p_rsp, p_attr, rem_len,
-                                                &p_ccb->cont_info.attr_offset);
-
-        /* If the partial attrib could not been fully added yet */
-        if (p_ccb->cont_info.attr_offset != attr_len)
-          break;
-        else /* If the partial attrib has been added in full by now */
-          p_ccb->cont_info.attr_offset = 0; /* reset attr_offset */
-      } else if (rem_len <
-                 attr_len) /* Not enough space for attr... so add partially */
-      {
-        if (attr_len >= SDP_MAX_ATTR_LEN) {
-          SDP_TRACE_ERROR("SDP attr too big: max_list_len=%d,attr_len=%d",
-                          max_list_len, attr_len);
-          sdpu_build_n_send_error(p_ccb, trans_num, SDP_NO_RESOURCES, NULL);
-          return;
-        }
-
-        /* add the partial attribute if possible */
-        p_rsp = sdpu_build_partial_attrib_entry(
-            p_rsp, p_attr, (uint16_t)rem_len, &p_ccb->cont_info.attr_offset);
-
-        p_ccb->cont_info.next_attr_index = xx;
-        p_ccb->cont_info.next_attr_start_id = p_attr->id;
-        break;
-      } else /* build the whole attribute */
-        p_rsp = sdpu_build_attrib_entry(p_rsp, p_attr);
-
-      /* If doing a range, stick with this one till no more attributes found */
-      if (attr_seq.attr_entry[xx].start != attr_seq.attr_entry[xx].end) {
-        /* Update for next time through */
-        attr_seq.attr_entry[xx].start = p_attr->id + 1;
-
-        xx--;
-      }
-    }
-  }
-  /* If all the attributes have been accomodated in p_rsp,
-     reset next_attr_index */
-  if (xx == attr_seq.num_attr) p_ccb->cont_info.next_attr_index = 0;
-
-  len_to_send = (uint16_t)(p_rsp - &p_ccb->rsp_list[0]);
-  cont_offset = 0;
-
-  if (!is_cont) {
-    p_ccb->list_len = sdpu_get_attrib_seq_len(p_rec, &attr_seq_sav) + 3;
-    /* Put in the sequence header (2 or 3 bytes) */
-    if (p_ccb->list_len > 255) {
-      p_ccb->rsp_list[0] =
-          (uint8_t)((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
-      p_ccb->rsp_list[1] = (uint8_t)((p_ccb->list_len - 3) >> 8);
-      p_ccb->rsp_list[2] = (uint8_t)(p_ccb->list_len - 3);
-    } else {
-      cont_offset = 1;
-
-      p_ccb->rsp_list[1] =
-          (uint8_t)((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE);
-      p_ccb->rsp_list[2] = (uint8_t)(p_ccb->list_len - 3);
-
-      p_ccb->list_len--;
-      len_to_send--;
+    /* Build the whole attribute list, the continuations send the rest of it */
+    std::vector<uint8_t> list;
+    sdp_db_get_attr_list(p_rec, &attr_seq, &list);
+    if (!save_rsp_list(p_ccb, SDP_PDU_SERVICE_ATTR_RSP, list)) {
+      sdpu_build_n_send_error(p_ccb, trans_num, SDP_NO_RESOURCES, NULL);
+      return;
     }
   }
 
-  /* Get a buffer to use to build the response */
-  BT_HDR* p_buf = (BT_HDR*)osi_malloc(SDP_DATA_BUF_SIZE);
-  p_buf->offset = L2CAP_MIN_OFFSET;
-  p_rsp = p_rsp_start = (uint8_t*)(p_buf + 1) + L2CAP_MIN_OFFSET;
-
-  /* Start building a rsponse */
-  UINT8_TO_BE_STREAM(p_rsp, SDP_PDU_SERVICE_ATTR_RSP);
-  UINT16_TO_BE_STREAM(p_rsp, trans_num);
-
-  /* Skip the parameter length, add it when we know the length */
-  p_rsp_param_len = p_rsp;
-  p_rsp += 2;
-
-  UINT16_TO_BE_STREAM(p_rsp, len_to_send);
-
-  memcpy(p_rsp, &p_ccb->rsp_list[cont_offset], len_to_send);
-  p_rsp += len_to_send;
-
-  p_ccb->cont_offset += len_to_send;
-
-  /* If anything left to send, continuation needed */
-  if (p_ccb->cont_offset < p_ccb->list_len) {
-    is_cont = true;
-
-    UINT8_TO_BE_STREAM(p_rsp, SDP_CONTINUATION_LEN);
-    UINT16_TO_BE_STREAM(p_rsp, p_ccb->cont_offset);
-  } else
-    UINT8_TO_BE_STREAM(p_rsp, 0);
-
-  /* Go back and put the parameter length into the buffer */
-  rsp_param_len = p_rsp - p_rsp_param_len - 2;
-  UINT16_TO_BE_STREAM(p_rsp_param_len, rsp_param_len);
-
-  /* Set the length of the SDP data in the buffer */
-  p_buf->len = p_rsp - p_rsp_start;
-
-  /* Send the buffer through L2CAP */
-  L2CA_DataWrite(p_ccb->connection_id, p_buf);
+  send_attr_list_rsp(p_ccb, trans_num, max_list_len);
 }
 
 /*******************************************************************************
@@ -539,18 +403,10 @@ static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
 static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
                                             uint16_t param_len, uint8_t* p_req,
                                             uint8_t* p_req_end) {
-  uint16_t max_list_len;
-  int16_t rem_len;
-  uint16_t len_to_send, cont_offset;
+  uint16_t max_list_len, cont_offset;
   tSDP_UUID_SEQ uid_seq;
-  uint8_t *p_rsp, *p_rsp_start, *p_rsp_param_len;
-  uint16_t rsp_param_len, xx;
   tSDP_RECORD* p_rec;
-  tSDP_ATTR_SEQ attr_seq, attr_seq_sav;
-  tSDP_ATTRIBUTE* p_attr;
-  bool maxxed_out = false, is_cont = false;
-  uint8_t* p_seq_start;
-  uint16_t seq_len, attr_len;
+  tSDP_ATTR_SEQ attr_seq;
 
   /* Extract the UUID sequence to search for */
   p_req = sdpu_extract_uid_seq(p_req, param_len, &uid_seq);
@@ -578,18 +434,12 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     return;
   }
 
-  memcpy(&attr_seq_sav, &attr_seq, sizeof(tSDP_ATTR_SEQ));
-
   if (max_list_len < 4) {
     sdpu_build_n_send_error(p_ccb, trans_num, SDP_ILLEGAL_PARAMETER, NULL);
     android_errorWriteLog(0x534e4554, "68817966");
     return;
   }
 
-  /* Free and reallocate buffer */
-  osi_free(p_ccb->rsp_list);
-  p_ccb->rsp_list = (uint8_t*)osi_malloc(max_list_len);
-
   /* Check if this is a continuation request */
   if (*p_req) {
     if (*p_req++ != SDP_CONTINUATION_LEN ||
@@ -600,189 +450,111 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     }
     BE_STREAM_TO_UINT16(cont_offset, p_req);
 
-    if (cont_offset != p_ccb->cont_offset) {
+    if (cont_offset != p_ccb->cont_offset || !p_ccb->rsp_list ||
+        p_ccb->rsp_pdu != SDP_PDU_SERVICE_SEARCH_ATTR_RSP) {
       sdpu_build_n_send_error(p_ccb, trans_num, SDP_INVALID_CONT_STATE,
                               SDP_TEXT_BAD_CONT_INX);
       return;
     }
-    is_cont = true;
-
-    /* Initialise for continuation response */
-    p_rsp = &p_ccb->rsp_list[0];
-    attr_seq.attr_entry[p_ccb->cont_info.next_attr_index].start =
-        p_ccb->cont_info.next_attr_start_id;
   } else {
-    p_ccb->cont_offset = 0;
-    p_rsp = &p_ccb->rsp_list[3]; /* Leave space for data elem descr */
-
-    /* Reset continuation parameters in p_ccb */
-    p_ccb->cont_info.prev_sdp_rec = NULL;
-    p_ccb->cont_info.next_attr_index = 0;
-    p_ccb->cont_info.last_attr_seq_desc_sent = false;
-    p_ccb->cont_info.attr_offset = 0;
-  }
-
-  /* Get a list of handles that match the UUIDs given to us */
-  for (p_rec = sdp_db_service_search(p_ccb->cont_info.prev_sdp_rec, &uid_seq);
-       p_rec; p_rec = sdp_db_service_search(p_rec, &uid_seq)) {
-    /* Allow space for attribute sequence type and length */
-    p_seq_start = p_rsp;
-    if (!p_ccb->cont_info.last_attr_seq_desc_sent) {
-      /* See if there is enough room to include a new service in the current
-       * response */
-      rem_len = max_list_len - (int16_t)(p_rsp - &p_ccb->rsp_list[0]);
-      if (rem_len < 3) {
-        /* Not enough room. Update continuation info for next response */
-        p_ccb->cont_info.next_attr_index = 0;
-        p_ccb->cont_info.next_attr_start_id = attr_seq.attr_entry[0].start;
-        break;
+    /* Build the attribute lists of all the matching records, each in its own
+     * sequence. The continuations send the rest of it, so that they stay
+     * consistent even if the database changes in between. */
+    std::vector<uint8_t> list;
+    for (p_rec = sdp_db_service_search(NULL, &uid_seq); p_rec;
+         p_rec = sdp_db_service_search(p_rec, &uid_seq)) {
+      size_t seq_start = list.size();
+      list.resize(seq_start + 3);
+      size_t seq_len = sdp_db_get_attr_list(p_rec, &attr_seq, &list);
+      if (seq_len == 0) {
+        /* Records without any of the attributes are left out */
+        list.resize(seq_start);
+        continue;
       }
-      p_rsp += 3;
-    }
-
-    /* Get a list of handles that match the UUIDs given to us */
-    for (xx = p_ccb->cont_info.next_attr_index; xx < attr_seq.num_attr; xx++) {
-      p_attr = sdp_db_find_attr_in_rec(p_rec, attr_seq.attr_entry[xx].start,
-                                       attr_seq.attr_entry[xx].end);
-
-      if (p_attr) {
-        /* Check if attribute fits. Assume 3-byte value type/length */
-        rem_len = max_list_len - (int16_t)(p_rsp - &p_ccb->rsp_list[0]);
-
-        /* just in case */
-        if (rem_len <= 0) {
-          p_ccb->cont_info.next_attr_index = xx;
-          p_ccb->cont_info.next_attr_start_id = p_attr->id;
-          maxxed_out = true;
-          break;
-        }
-
-        attr_len = sdpu_get_attrib_entry_len(p_attr);
-        /* if there is a partial attribute pending to be sent */
-        if (p_ccb->cont_info.attr_offset) {
-          if (attr_len < p_ccb->cont_info.attr_offset) {
-            android_errorWriteLog(0x534e4554, "79217770");
-            LOG(ERROR) << "offset is bigger than attribute length";
-            sdpu_build_n_send_error(p_ccb, trans_num, SDP_INVALID_CONT_STATE,
-                                    SDP_TEXT_BAD_CONT_LEN);
-            return;
-          }
-          p_rsp = sdpu_build_partial_attrib_entry(
-              p_rsp, p_attr, rem_len, &p_ccb->cont_info.attr_offset);
-
-          /* If the partial attrib could not been fully added yet */
-          if (p_ccb->cont_info.attr_offset != attr_len) {
-            maxxed_out = true;
-            break;
-          } else /* If the partial attrib has been added in full by now */
-            p_ccb->cont_info.attr_offset = 0; /* reset attr_offset */
-        } else if (rem_len <
-                   attr_len) /* Not enough space for attr... so add partially */
-        {
-          if (attr_len >= SDP_MAX_ATTR_LEN) {
-            SDP_TRACE_ERROR("SDP attr too big: max_list_len=%d,attr_len=%d",
-                            max_list_len, attr_len);
-            sdpu_build_n_send_error(p_ccb, trans_num, SDP_NO_RESOURCES, NULL);
-            return;
-          }
-
-          /* add the partial attribute if possible */
-          p_rsp = sdpu_build_partial_attrib_entry(
-              p_rsp, p_attr, (uint16_t)rem_len, &p_ccb->cont_info.attr_offset);
-
-          p_ccb->cont_info.next_attr_index = xx;
-          p_ccb->cont_info.next_attr_start_id = p_attr->id;
-          maxxed_out = true;
-          break;
-        } else /* build the whole attribute */
-          p_rsp = sdpu_build_attrib_entry(p_rsp, p_attr);
-
-        /* If doing a range, stick with this one till no more attributes found
-         */
-        if (attr_seq.attr_entry[xx].start != attr_seq.attr_entry[xx].end) {
-          /* Update for next time through */
-          attr_seq.attr_entry[xx].start = p_attr->id + 1;
-
-          xx--;
-        }
+      if (seq_len > 0xFFFF) {
+        sdpu_build_n_send_error(p_ccb, trans_num, SDP_NO_RESOURCES, NULL);
+        return;
       }
+      uint8_t* p_seq = &list[seq_start];
+      UINT8_TO_BE_STREAM(p_seq,
+                         (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
+      UINT16_TO_BE_STREAM(p_seq, seq_len);
     }
-
-    /* Go back and put the type and length into the buffer */
-    if (!p_ccb->cont_info.last_attr_seq_desc_sent) {
-      seq_len = sdpu_get_attrib_seq_len(p_rec, &attr_seq_sav);
-      if (seq_len != 0) {
-        UINT8_TO_BE_STREAM(p_seq_start,
-                           (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
-        UINT16_TO_BE_STREAM(p_seq_start, seq_len);
-
-        if (maxxed_out) p_ccb->cont_info.last_attr_seq_desc_sent = true;
-      } else
-        p_rsp = p_seq_start;
+    if (!save_rsp_list(p_ccb, SDP_PDU_SERVICE_SEARCH_ATTR_RSP, list)) {
+      sdpu_build_n_send_error(p_ccb, trans_num, SDP_NO_RESOURCES, NULL);
+      return;
     }
+  }
+
+  send_attr_list_rsp(p_ccb, trans_num, max_list_len);
+}
 
-    if (maxxed_out) break;
+/*******************************************************************************
+ *
+ * Function         save_rsp_list
+ *
+ * Description      This function keeps an attribute list, wrapped in a data
+ *                  element sequence, in the CCB for the response to a new
+ *                  request and its continuations to send parts of.
+ *
+ * Returns          true if OK, false if the list is too long to be sent
+ *
+ ******************************************************************************/
+static bool save_rsp_list(tCONN_CB* p_ccb, uint8_t rsp_pdu,
+                          const std::vector<uint8_t>& list) {
+  uint8_t* p;
+
+  /* The list length, with the 3 byte header, must fit in 16 bits */
+  if (list.size() + 3 > 0xFFFF) {
+    SDP_TRACE_ERROR("%s: attribute list too long: %zu", __func__, list.size());
+    return false;
+  }
 
-    /* Restore the attr_seq to look for in the next sdp record */
-    memcpy(&attr_seq, &attr_seq_sav, sizeof(tSDP_ATTR_SEQ));
+  osi_free(p_ccb->rsp_list);
+  p_ccb->rsp_list = (uint8_t*)osi_malloc(list.size() + 3);
+  p = p_ccb->rsp_list;
 
-    /* Reset the next attr index */
-    p_ccb->cont_info.next_attr_index = 0;
-    p_ccb->cont_info.prev_sdp_rec = p_rec;
-    p_ccb->cont_info.last_attr_seq_desc_sent = false;
+  /* Put in the sequence header (2 or 3 bytes) */
+  if (list.size() + 3 > 255) {
+    UINT8_TO_BE_STREAM(p, (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
+    UINT16_TO_BE_STREAM(p, list.size());
+  } else {
+    UINT8_TO_BE_STREAM(p, (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE);
+    UINT8_TO_BE_STREAM(p, list.size());
   }
+  if (!list.empty()) memcpy(p, list.data(), list.size());
 
-  /* response length */
-  len_to_send = (uint16_t)(p_rsp - &p_ccb->rsp_list[0]);
-  cont_offset = 0;
-
-  // The current SDP server design has a critical flaw where it can run into
-  // an infinite request/response loop with the client. Here's the scenario:
-  // - client makes SDP request
-  // - server returns the first fragment of the response with a continuation
-  //   token
-  // - an SDP record is deleted from the server
-  // - client issues another request with previous continuation token
-  // - server has nothing to send back because the record is unavailable but
-  //   in the first fragment, it had specified more response bytes than are
-  //   now available
-  // - server sends back no additional response bytes and returns the same
-  //   continuation token
-  // - client issues another request with the continuation token, and the
-  //   process repeats
-  //
-  // We work around this design flaw here by checking if we will make forward
-  // progress (i.e. we will send > 0 response bytes) on a continued request.
-  // If not, we must have run into the above situation and we tell the peer an
-  // error occurred.
-  //
-  // TODO(sharvil): rewrite SDP server.
-  if (is_cont && len_to_send == 0) {
+  p_ccb->list_len = (uint16_t)(p - p_ccb->rsp_list + list.size());
+  p_ccb->cont_offset = 0;
+  p_ccb->rsp_pdu = rsp_pdu;
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         send_attr_list_rsp
+ *
+ * Description      This function sends the part of the attribute list kept in
+ *                  the CCB from the continuation offset, at most max_list_len
+ *                  bytes of it, and a continuation state if more is left.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void send_attr_list_rsp(tCONN_CB* p_ccb, uint16_t trans_num,
+                               uint16_t max_list_len) {
+  uint8_t *p_rsp, *p_rsp_start, *p_rsp_param_len;
+  uint16_t rsp_param_len, len_to_send;
+
+  // A client repeating the continuation state of the last response would get
+  // nothing, and ask again forever.
+  if (p_ccb->cont_offset >= p_ccb->list_len) {
     sdpu_build_n_send_error(p_ccb, trans_num, SDP_INVALID_CONT_STATE, NULL);
     return;
   }
 
-  /* If first response, insert sequence header */
-  if (!is_cont) {
-    /* Get the total list length for requested uid and attribute sequence */
-    p_ccb->list_len = sdpu_get_list_len(&uid_seq, &attr_seq_sav) + 3;
-    /* Put in the sequence header (2 or 3 bytes) */
-    if (p_ccb->list_len > 255) {
-      p_ccb->rsp_list[0] =
-          (uint8_t)((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
-      p_ccb->rsp_list[1] = (uint8_t)((p_ccb->list_len - 3) >> 8);
-      p_ccb->rsp_list[2] = (uint8_t)(p_ccb->list_len - 3);
-    } else {
-      cont_offset = 1;
-
-      p_ccb->rsp_list[1] =
-          (uint8_t)((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE);
-      p_ccb->rsp_list[2] = (uint8_t)(p_ccb->list_len - 3);
-
-      p_ccb->list_len--;
-      len_to_send--;
-    }
-  }
+  len_to_send = p_ccb->list_len - p_ccb->cont_offset;
+  if (len_to_send > max_list_len) len_to_send = max_list_len;
 
   /* Get a buffer to use to build the response */
   BT_HDR* p_buf = (BT_HDR*)osi_malloc(SDP_DATA_BUF_SIZE);
@@ -790,7 +562,7 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
   p_rsp = p_rsp_start = (uint8_t*)(p_buf + 1) + L2CAP_MIN_OFFSET;
 
   /* Start building a rsponse */
-  UINT8_TO_BE_STREAM(p_rsp, SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  UINT8_TO_BE_STREAM(p_rsp, p_ccb->rsp_pdu);
   UINT16_TO_BE_STREAM(p_rsp, trans_num);
 
   /* Skip the parameter length, add it when we know the length */
@@ -801,15 +573,13 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
   UINT16_TO_BE_STREAM(p_rsp, len_to_send);
 
   /* copy from rsp_list to the actual buffer to be sent */
-  memcpy(p_rsp, &p_ccb->rsp_list[cont_offset], len_to_send);
+  memcpy(p_rsp, &p_ccb->rsp_list[p_ccb->cont_offset], len_to_send);
   p_rsp += len_to_send;
 
   p_ccb->cont_offset += len_to_send;
 
   /* If anything left to send, continuation needed */
   if (p_ccb->cont_offset < p_ccb->list_len) {
-    is_cont = true;
-
     UINT8_TO_BE_STREAM(p_rsp, SDP_CONTINUATION_LEN);
     UINT16_TO_BE_STREAM(p_rsp, p_ccb->cont_offset);
   } else
@@ -25,6 +25,8 @@
 #ifndef SDP_INT_H
 #define SDP_INT_H
 
+#include <vector>
+
 #include "bluetooth/uuid.h"
 #include "bt_target.h"
 #include "l2c_api.h"
@@ -103,24 +105,10 @@ typedef struct {
   uint32_t
       di_primary_handle; /* Device ID Primary record or NULL if nonexistent */
   uint16_t num_records;
+  bool cache_valid; /* UUID index and serialized records are up to date */
   tSDP_RECORD record[SDP_MAX_RECORDS];
 } tSDP_DB;
 
-#if (SDP_SERVER_ENABLED == TRUE)
-/* Continuation information for the SDP server response */
-typedef struct {
-  uint16_t next_attr_index;    /* attr index for next continuation response */
-  uint16_t next_attr_start_id; /* attr id to start with for the attr index in
-                                  next cont. response */
-  tSDP_RECORD* prev_sdp_rec; /* last sdp record that was completely sent in the
-                                response */
-  bool last_attr_seq_desc_sent; /* whether attr seq length has been sent
-                                   previously */
-  uint16_t attr_offset; /* offset within the attr to keep trak of partial
-                           attributes in the responses */
-} tSDP_CONT_INFO;
-#endif /* SDP_SERVER_ENABLED == TRUE */
-
 /* Define the SDP Connection Control Block */
 typedef struct {
 #define SDP_STATE_IDLE 0
@@ -166,10 +154,9 @@ typedef struct {
   uint8_t is_attr_search;
 
 #if (SDP_SERVER_ENABLED == TRUE)
-  uint16_t cont_offset;     /* Continuation state data in the server response */
-  tSDP_CONT_INFO cont_info; /* structure to hold continuation information for
-                               the server response */
-#endif                      /* SDP_SERVER_ENABLED == TRUE */
+  uint16_t cont_offset; /* Continuation state data in the server response */
+  uint8_t rsp_pdu;      /* Response PDU the server built rsp_list for */
+#endif                  /* SDP_SERVER_ENABLED == TRUE */
 
 } tCONN_CB;
 
@@ -227,14 +214,7 @@ extern bool sdpu_compare_uuid_with_attr(const bluetooth::Uuid& uuid,
                                         tSDP_DISC_ATTR* p_attr);
 
 extern void sdpu_sort_attr_list(uint16_t num_attr, tSDP_DISCOVERY_DB* p_db);
-extern uint16_t sdpu_get_list_len(tSDP_UUID_SEQ* uid_seq,
-                                  tSDP_ATTR_SEQ* attr_seq);
-extern uint16_t sdpu_get_attrib_seq_len(tSDP_RECORD* p_rec,
-                                        tSDP_ATTR_SEQ* attr_seq);
 extern uint16_t sdpu_get_attrib_entry_len(tSDP_ATTRIBUTE* p_attr);
-extern uint8_t* sdpu_build_partial_attrib_entry(uint8_t* p_out,
-                                                tSDP_ATTRIBUTE* p_attr,
-                                                uint16_t len, uint16_t* offset);
 
 /* Functions provided by sdp_db.cc
  */
@@ -244,6 +224,8 @@ extern tSDP_RECORD* sdp_db_find_record(uint32_t handle);
 extern tSDP_ATTRIBUTE* sdp_db_find_attr_in_rec(tSDP_RECORD* p_rec,
                                                uint16_t start_attr,
                                                uint16_t end_attr);
+extern size_t sdp_db_get_attr_list(tSDP_RECORD* p_rec, tSDP_ATTR_SEQ* p_seq,
+                                   std::vector<uint8_t>* p_list);
 
 /* Functions provided by sdp_server.cc
  */
@@ -257,5 +239,18 @@ extern void sdp_server_handle_client_req(tCONN_CB* p_ccb, BT_HDR* p_msg);
  */
 extern void sdp_disc_connected(tCONN_CB* p_ccb);
 extern void sdp_disc_server_rsp(tCONN_CB* p_ccb, BT_HDR* p_msg);
+extern uint16_t sdp_disc_save_search_attr_list(tSDP_DISCOVERY_DB* p_db,
+                                               const RawAddress& bd_addr,
+                                               uint8_t* p_list,
+                                               uint16_t list_len);
+
+/* Functions provided by sdp_cache.cc
+ */
+extern bool sdp_cache_load(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                           tSDP_DISC_CMPL_CB* p_cb, tSDP_DISC_CMPL_CB2* p_cb2,
+                           void* user_data);
+extern void sdp_cache_save(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                           uint8_t* p_list, uint16_t list_len);
+extern bool sdp_cache_cancel(tSDP_DISCOVERY_DB* p_db);
 
 #endif
@@ -58,8 +58,10 @@ extern elliptic_curve_t curve_p256;
 
 bool ECC_ValidatePoint(const Point& p);
 
-void ECC_PointMult_Bin_NAF(Point* q, Point* p, uint32_t* n);
-
-#define ECC_PointMult(q, p, n) ECC_PointMult_Bin_NAF(q, p, n)
+// Computes q = n * p, n is a 256-bit number stored least significant word
+// first
+void ECC_PointMult(Point* q, Point* p, const uint32_t* n);
 
+// Sets up curve_p256, once before any of the above is used. The curve is only
+// read afterwards, so the functions above may run on several threads.
 void p_256_init_curve();
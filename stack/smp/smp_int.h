@@ -475,6 +475,9 @@ extern void smp_generate_ltk(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_generate_passkey(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_generate_rand_cont(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_create_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
+extern void smp_generate_next_key_pair(void);
+extern void smp_clear_next_key_pair(void);
+extern void smp_cancel_next_key_pair_wait(tSMP_CB* p_cb);
 extern void smp_use_oob_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_compute_dhkey(tSMP_CB* p_cb);
 extern void smp_calculate_local_commitment(tSMP_CB* p_cb);
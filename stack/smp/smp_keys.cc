@@ -32,6 +32,7 @@
 #include "btm_ble_api.h"
 #include "btm_ble_int.h"
 #include "btm_int.h"
+#include "btu.h"
 #include "device/include/controller.h"
 #include "hcimsgs.h"
 #include "osi/include/osi.h"
@@ -51,6 +52,29 @@ using crypto_toolbox::aes_128;
 static void smp_process_stk(tSMP_CB* p_cb, Octet16* p);
 static Octet16 smp_calculate_legacy_short_term_key(tSMP_CB* p_cb);
 static void smp_process_private_key(tSMP_CB* p_cb);
+static void smp_process_local_key_pair(tSMP_CB* p_cb);
+
+/* Key pair generated ahead of the next pairing that needs one, so that the
+ * pairing does not wait for the controller to generate the private key. Each
+ * key pair is used by a single pairing. */
+static struct {
+  bool is_ready;
+  bool is_generating;
+  tSMP_CB* p_waiting_cb; /* pairing waiting for the key pair being generated */
+  BT_OCTET32 private_key;
+  BT_OCTET32 publ_key_x;
+  BT_OCTET32 publ_key_y;
+} smp_next_key_pair;
+
+/* Public key computation of the next key pair, handed to the SMP crypto
+ * thread */
+typedef struct {
+  BT_OCTET32 private_key;
+  Point public_key;
+} tSMP_KEY_PAIR_WORK;
+
+static void smp_compute_next_public_key(tSMP_KEY_PAIR_WORK* p_work);
+static void smp_next_key_pair_computed(tSMP_KEY_PAIR_WORK* p_work);
 
 #define SMP_PASSKEY_MASK 0xfff00000
 
@@ -598,43 +622,180 @@ Octet16 smp_calculate_legacy_short_term_key(tSMP_CB* p_cb) {
   return aes_128(p_cb->tk, text);
 }
 
+/*******************************************************************************
+ *
+ * Function         smp_use_next_key_pair
+ *
+ * Description      This function moves the key pair generated ahead into the
+ *                  control block and notifies SM that the local key pair is
+ *                  created.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_use_next_key_pair(tSMP_CB* p_cb) {
+  memcpy(p_cb->private_key, smp_next_key_pair.private_key, BT_OCTET32_LEN);
+  memcpy(p_cb->loc_publ_key.x, smp_next_key_pair.publ_key_x, BT_OCTET32_LEN);
+  memcpy(p_cb->loc_publ_key.y, smp_next_key_pair.publ_key_y, BT_OCTET32_LEN);
+  memset(&smp_next_key_pair, 0, sizeof(smp_next_key_pair));
+  smp_process_local_key_pair(p_cb);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_next_key_pair_rand
+ *
+ * Description      This function collects the controller random numbers of
+ *                  the next private key, 8 octets at a time, and calculates
+ *                  the public key when the private key is complete.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_next_key_pair_rand(uint8_t offset, BT_OCTET8 rand) {
+  memcpy(&smp_next_key_pair.private_key[offset], rand, BT_OCTET8_LEN);
+  offset += BT_OCTET8_LEN;
+  if (offset < BT_OCTET32_LEN) {
+    btsnd_hcic_ble_rand(Bind(&smp_next_key_pair_rand, offset));
+    return;
+  }
+
+  /* The point multiplication is the only work here that is not an HCI round
+   * trip, it runs on the crypto thread so that it never delays the tasks
+   * queued behind it on the main thread */
+  tSMP_KEY_PAIR_WORK* p_work = new tSMP_KEY_PAIR_WORK;
+  memcpy(p_work->private_key, smp_next_key_pair.private_key, BT_OCTET32_LEN);
+  if (do_in_work_thread_and_reply(
+          BTU_WORK_SMP_CRYPTO, FROM_HERE,
+          base::BindOnce(&smp_compute_next_public_key,
+                         base::Unretained(p_work)),
+          base::BindOnce(&smp_next_key_pair_computed,
+                         base::Owned(p_work))) != BT_STATUS_SUCCESS) {
+    SMP_TRACE_WARNING("%s: computing the public key in place", __func__);
+    p_work = new tSMP_KEY_PAIR_WORK;
+    memcpy(p_work->private_key, smp_next_key_pair.private_key,
+           BT_OCTET32_LEN);
+    smp_compute_next_public_key(p_work);
+    smp_next_key_pair_computed(p_work);
+    delete p_work;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_compute_next_public_key
+ *
+ * Description      This function calculates the public key of the next key
+ *                  pair. It runs on the SMP crypto thread and only uses
+ *                  |p_work|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_compute_next_public_key(tSMP_KEY_PAIR_WORK* p_work) {
+  BT_OCTET32 private_key;
+  memcpy(private_key, p_work->private_key, BT_OCTET32_LEN);
+  ECC_PointMult(&p_work->public_key, &(curve_p256.G), (uint32_t*)private_key);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_next_key_pair_computed
+ *
+ * Description      This function stores the public key computed for the next
+ *                  key pair, and hands the key pair to the pairing waiting
+ *                  for it, if any. Back on the main thread.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_next_key_pair_computed(tSMP_KEY_PAIR_WORK* p_work) {
+  /* Dropped by smp_clear_next_key_pair() while being computed */
+  if (!smp_next_key_pair.is_generating ||
+      memcmp(smp_next_key_pair.private_key, p_work->private_key,
+             BT_OCTET32_LEN) != 0) {
+    SMP_TRACE_DEBUG("%s: key pair dropped", __func__);
+    return;
+  }
+
+  memcpy(smp_next_key_pair.publ_key_x, p_work->public_key.x, BT_OCTET32_LEN);
+  memcpy(smp_next_key_pair.publ_key_y, p_work->public_key.y, BT_OCTET32_LEN);
+  smp_next_key_pair.is_generating = false;
+  smp_next_key_pair.is_ready = true;
+
+  tSMP_CB* p_cb = smp_next_key_pair.p_waiting_cb;
+  if (p_cb != NULL) smp_use_next_key_pair(p_cb);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_generate_next_key_pair
+ *
+ * Description      This function starts generating the key pair of the next
+ *                  pairing, unless one is ready or being generated.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_generate_next_key_pair(void) {
+  if (smp_next_key_pair.is_ready || smp_next_key_pair.is_generating) return;
+
+  SMP_TRACE_DEBUG("%s", __func__);
+  smp_next_key_pair.is_generating = true;
+  btsnd_hcic_ble_rand(Bind(&smp_next_key_pair_rand, 0));
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_clear_next_key_pair
+ *
+ * Description      This function drops the key pair generated ahead.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_clear_next_key_pair(void) {
+  memset(&smp_next_key_pair, 0, sizeof(smp_next_key_pair));
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_cancel_next_key_pair_wait
+ *
+ * Description      This function stops |p_cb| from waiting for the key pair
+ *                  being generated, when its pairing ends before the key pair
+ *                  is ready. The key pair is kept for the next pairing.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_cancel_next_key_pair_wait(tSMP_CB* p_cb) {
+  if (smp_next_key_pair.p_waiting_cb == p_cb)
+    smp_next_key_pair.p_waiting_cb = NULL;
+}
+
 /*******************************************************************************
  *
  * Function         smp_create_private_key
  *
  * Description      This function is called to create private key used to
  *                  calculate public key and DHKey.
- *                  The function starts private key creation requesting
- *                  for the controller to generate [0-7] octets of private key.
+ *                  The key pair generated ahead is used if it is ready,
+ *                  otherwise the pairing waits for it to be generated.
  *
  * Returns          void
  *
  ******************************************************************************/
 void smp_create_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
-  SMP_TRACE_DEBUG("%s", __func__);
+  SMP_TRACE_DEBUG("%s ready: %d", __func__, smp_next_key_pair.is_ready);
 
-  btsnd_hcic_ble_rand(Bind(
-      [](tSMP_CB* p_cb, BT_OCTET8 rand) {
-        memcpy((void*)p_cb->private_key, rand, BT_OCTET8_LEN);
-        btsnd_hcic_ble_rand(Bind(
-            [](tSMP_CB* p_cb, BT_OCTET8 rand) {
-              memcpy((void*)&p_cb->private_key[8], rand, BT_OCTET8_LEN);
-              btsnd_hcic_ble_rand(Bind(
-                  [](tSMP_CB* p_cb, BT_OCTET8 rand) {
-                    memcpy((void*)&p_cb->private_key[16], rand, BT_OCTET8_LEN);
-                    btsnd_hcic_ble_rand(Bind(
-                        [](tSMP_CB* p_cb, BT_OCTET8 rand) {
-                          memcpy((void*)&p_cb->private_key[24], rand,
-                                 BT_OCTET8_LEN);
-                          smp_process_private_key(p_cb);
-                        },
-                        p_cb));
-                  },
-                  p_cb));
-            },
-            p_cb));
-      },
-      p_cb));
+  if (smp_next_key_pair.is_ready) {
+    smp_use_next_key_pair(p_cb);
+    return;
+  }
+
+  smp_next_key_pair.p_waiting_cb = p_cb;
+  smp_generate_next_key_pair();
 }
 
 /*******************************************************************************
@@ -695,6 +856,20 @@ void smp_process_private_key(tSMP_CB* p_cb) {
   memcpy(p_cb->loc_publ_key.x, public_key.x, BT_OCTET32_LEN);
   memcpy(p_cb->loc_publ_key.y, public_key.y, BT_OCTET32_LEN);
 
+  smp_process_local_key_pair(p_cb);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_process_local_key_pair
+ *
+ * Description      This function notifies SM that private key / public key
+ *                  pair is created.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_process_local_key_pair(tSMP_CB* p_cb) {
   smp_debug_print_nbyte_little_endian(p_cb->private_key, "private",
                                       BT_OCTET32_LEN);
   smp_debug_print_nbyte_little_endian(p_cb->loc_publ_key.x, "local public(x)",
@@ -862,6 +862,8 @@ void smp_cb_cleanup(tSMP_CB* p_cb) {
 
   SMP_TRACE_EVENT("smp_cb_cleanup");
 
+  /* a key pair completed later must not reach the next pairing's state */
+  smp_cancel_next_key_pair_wait(p_cb);
   alarm_cancel(p_cb->smp_rsp_timer_ent);
   alarm_cancel(p_cb->delayed_auth_timer_ent);
   memset(p_cb, 0, sizeof(tSMP_CB));
@@ -950,6 +952,9 @@ void smp_proc_pairing_cmpl(tSMP_CB* p_cb) {
 
   smp_reset_control_value(p_cb);
 
+  /* get the key pair of the next pairing ready while the link is idle */
+  smp_generate_next_key_pair();
+
   if (p_callback) (*p_callback)(SMP_COMPLT_EVT, pairing_bda, &evt_data);
 }
 
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "stack/include/a2dp_abr.h"
+
+namespace {
+
+constexpr uint64_t kIntervalMs = 20;
+// Ticks needed to raise the bit rate right after init
+constexpr uint32_t kRaiseTicks = 5000 / kIntervalMs;
+constexpr uint32_t kLastLevel = A2DP_ABR_NUM_LEVELS - 1;
+
+class A2dpAbrTest : public ::testing::Test {
+ protected:
+  void SetUp() override { a2dp_abr_init(&abr_, kIntervalMs); }
+
+  // Runs |ticks| ticks with a steady queue length |transmit_queue_length|.
+  // Returns the number of level changes.
+  size_t Run(uint32_t ticks, size_t transmit_queue_length) {
+    size_t changes = 0;
+    for (uint32_t i = 0; i < ticks; i++) {
+      if (a2dp_abr_proc(&abr_, transmit_queue_length)) changes++;
+    }
+    return changes;
+  }
+
+  tA2DP_ABR abr_;
+};
+
+}  // namespace
+
+TEST_F(A2dpAbrTest, starts_at_full_bit_rate) {
+  EXPECT_EQ(abr_.level, 0u);
+  EXPECT_EQ(Run(10 * kRaiseTicks, 0), 0u);
+  EXPECT_EQ(abr_.level, 0u);
+  EXPECT_EQ(a2dp_abr_scale(&abr_, 328, 164), 328u);
+}
+
+TEST_F(A2dpAbrTest, critical_queue_goes_to_last_level) {
+  EXPECT_TRUE(a2dp_abr_proc(&abr_, 6));
+  EXPECT_EQ(abr_.level, kLastLevel);
+  EXPECT_EQ(a2dp_abr_scale(&abr_, 328, 164), 164u);
+  EXPECT_FALSE(a2dp_abr_proc(&abr_, 10));
+  EXPECT_EQ(abr_.adjustments, 1u);
+}
+
+TEST_F(A2dpAbrTest, growing_queue_steps_down) {
+  EXPECT_FALSE(a2dp_abr_proc(&abr_, 3));
+  EXPECT_TRUE(a2dp_abr_proc(&abr_, 4));
+  EXPECT_EQ(abr_.level, 1u);
+  // A long queue that stopped growing keeps the level
+  EXPECT_FALSE(a2dp_abr_proc(&abr_, 4));
+  EXPECT_FALSE(a2dp_abr_proc(&abr_, 3));
+  EXPECT_TRUE(a2dp_abr_proc(&abr_, 5));
+  EXPECT_EQ(abr_.level, 2u);
+}
+
+TEST_F(A2dpAbrTest, reported_congestion_steps_down) {
+  a2dp_abr_report_congestion(&abr_);
+  EXPECT_TRUE(a2dp_abr_proc(&abr_, 0));
+  EXPECT_EQ(abr_.level, 1u);
+  // The report is consumed
+  EXPECT_FALSE(a2dp_abr_proc(&abr_, 0));
+  for (uint32_t i = 0; i < A2DP_ABR_NUM_LEVELS; i++) {
+    a2dp_abr_report_congestion(&abr_);
+    a2dp_abr_proc(&abr_, 0);
+  }
+  EXPECT_EQ(abr_.level, kLastLevel);
+}
+
+TEST_F(A2dpAbrTest, raises_after_stable_link_with_back_off) {
+  a2dp_abr_report_congestion(&abr_);
+  a2dp_abr_proc(&abr_, 0);
+  ASSERT_EQ(abr_.level, 1u);
+
+  // Lowering the bit rate doubled the time to raise it
+  EXPECT_EQ(Run(2 * kRaiseTicks - 1, 2), 0u);
+  EXPECT_TRUE(a2dp_abr_proc(&abr_, 2));
+  EXPECT_EQ(abr_.level, 0u);
+
+  // A queue above the safety threshold restarts the stable period
+  a2dp_abr_report_congestion(&abr_);
+  a2dp_abr_proc(&abr_, 0);
+  ASSERT_EQ(abr_.level, 1u);
+  EXPECT_EQ(Run(kRaiseTicks, 0), 0u);
+  a2dp_abr_proc(&abr_, 3);
+  EXPECT_EQ(Run(2 * kRaiseTicks - 1, 0), 0u);
+  EXPECT_EQ(Run(1, 0), 1u);
+  EXPECT_EQ(abr_.level, 0u);
+}
+
+TEST_F(A2dpAbrTest, scale_to_level) {
+  abr_.level = 2;
+  EXPECT_EQ(a2dp_abr_scale(&abr_, 53, 26), 40u);
+  EXPECT_EQ(a2dp_abr_scale(&abr_, 20, 30), 20u);
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "stack/include/a2dp_feeding_clock.h"
+
+namespace {
+
+constexpr tA2DP_FEEDING_PARAMS k44k16Stereo = {44100, 16, 2};
+constexpr tA2DP_FEEDING_PARAMS k48k24Stereo = {48000, 24, 2};
+
+// Arbitrary start of the media ticks
+constexpr uint64_t kStartUs = 123456789;
+
+// Runs |ticks| ticks of |interval_us| from kStartUs, reading all the frames
+// of |pcm_bytes_per_frame| bytes due. Returns the number of frames read.
+uint64_t RunTicks(tA2DP_FEEDING_CLOCK* clock, uint64_t ticks,
+                  uint64_t interval_us, uint32_t pcm_bytes_per_frame) {
+  uint64_t frames = 0;
+  for (uint64_t tick = 0; tick < ticks; tick++) {
+    a2dp_feeding_clock_tick(clock, kStartUs + tick * interval_us);
+    uint32_t num_frames = a2dp_feeding_clock_frames(clock, pcm_bytes_per_frame);
+    a2dp_feeding_clock_consume(clock, num_frames, pcm_bytes_per_frame);
+    frames += num_frames;
+  }
+  return frames;
+}
+
+}  // namespace
+
+TEST(A2dpFeedingClockTest, first_tick_adds_one_interval) {
+  tA2DP_FEEDING_CLOCK clock;
+  a2dp_feeding_clock_reset(&clock, &k44k16Stereo, 20);
+  EXPECT_EQ(clock.bytes_per_tick, 3528u);
+  EXPECT_EQ(clock.counter, 0u);
+
+  EXPECT_EQ(a2dp_feeding_clock_tick(&clock, kStartUs), 3528u);
+  EXPECT_EQ(a2dp_feeding_clock_tick(&clock, kStartUs + 40000), 7056u);
+  EXPECT_EQ(clock.counter, 3528u + 7056u);
+}
+
+TEST(A2dpFeedingClockTest, not_reset_adds_nothing) {
+  tA2DP_FEEDING_CLOCK clock = {};
+  EXPECT_EQ(a2dp_feeding_clock_tick(&clock, kStartUs), 0u);
+  EXPECT_EQ(a2dp_feeding_clock_frames(&clock, 512), 0u);
+}
+
+// One hour of SBC at 44.1 kHz: 128 samples per frame, 20 ms ticks
+TEST(A2dpFeedingClockTest, sbc_does_not_drift) {
+  tA2DP_FEEDING_CLOCK clock;
+  a2dp_feeding_clock_reset(&clock, &k44k16Stereo, 20);
+  uint64_t frames = RunTicks(&clock, 3600 * 50, 20000, 128 * 4);
+  EXPECT_NEAR(frames, 3600 * 44100 / 128, 1);
+}
+
+// One hour of AAC at 44.1 kHz: 1024 samples per frame, 23 ms ticks, which
+// are not a whole number of bytes
+TEST(A2dpFeedingClockTest, aac_does_not_drift) {
+  tA2DP_FEEDING_CLOCK clock;
+  a2dp_feeding_clock_reset(&clock, &k44k16Stereo, 23);
+  uint64_t frames = RunTicks(&clock, 3600 * 1000 / 23, 23000, 1024 * 4);
+  EXPECT_NEAR(frames, 3600000ull / 23 * 23 * 44100 / 1000 / 1024, 1);
+}
+
+// Ticks late by up to a tick keep the feeding on the average rate
+TEST(A2dpFeedingClockTest, late_ticks_do_not_drift) {
+  tA2DP_FEEDING_CLOCK clock;
+  a2dp_feeding_clock_reset(&clock, &k48k24Stereo, 20);
+  uint32_t pcm_bytes_per_frame = 128 * 6;
+  uint64_t ticks = 3600 * 50;
+  uint64_t frames = 0;
+  uint32_t seed = 1;
+  for (uint64_t tick = 0; tick < ticks; tick++) {
+    seed = seed * 1103515245 + 12345;
+    // The first and last ticks are on time
+    uint64_t lateness_us = (seed >> 16) % 20000;
+    if (tick == 0 || tick == ticks - 1) lateness_us = 0;
+    a2dp_feeding_clock_tick(&clock, kStartUs + tick * 20000 + lateness_us);
+    uint32_t num_frames =
+        a2dp_feeding_clock_frames(&clock, pcm_bytes_per_frame);
+    a2dp_feeding_clock_consume(&clock, num_frames, pcm_bytes_per_frame);
+    frames += num_frames;
+  }
+  EXPECT_NEAR(frames, 3600 * 48000 / 128, 1);
+}
+
+TEST(A2dpFeedingClockTest, underflow_is_read_next_tick) {
+  tA2DP_FEEDING_CLOCK clock;
+  a2dp_feeding_clock_reset(&clock, &k48k24Stereo, 20);
+  a2dp_feeding_clock_tick(&clock, kStartUs);
+  uint32_t pcm_bytes_per_frame = 128 * 6;
+  uint32_t num_frames = a2dp_feeding_clock_frames(&clock, pcm_bytes_per_frame);
+  EXPECT_EQ(num_frames, 7u);
+  a2dp_feeding_clock_consume(&clock, num_frames, pcm_bytes_per_frame);
+
+  // Two of the frames could not be read
+  a2dp_feeding_clock_underflow(&clock, 2, pcm_bytes_per_frame);
+  a2dp_feeding_clock_tick(&clock, kStartUs + 20000);
+  EXPECT_EQ(a2dp_feeding_clock_frames(&clock, pcm_bytes_per_frame), 10u);
+
+  a2dp_feeding_clock_flush(&clock);
+  EXPECT_EQ(a2dp_feeding_clock_frames(&clock, pcm_bytes_per_frame), 0u);
+  EXPECT_EQ(a2dp_feeding_clock_tick(&clock, kStartUs + 40000), 5760u);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "stack/include/a2dp_pcm.h"
+
+namespace {
+
+// Covers the vector loops and the remainders
+constexpr size_t kNumFrames[] = {0, 1, 3, 4, 7, 8, 9, 52, 92, 101};
+
+std::vector<uint8_t> RandomBytes(size_t size) {
+  std::mt19937 generator(size);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<uint8_t> bytes(size);
+  for (uint8_t& byte : bytes) byte = distribution(generator);
+  return bytes;
+}
+
+}  // namespace
+
+TEST(A2dpPcmTest, deinterleave_16) {
+  for (size_t num_frames : kNumFrames) {
+    std::vector<uint8_t> bytes = RandomBytes(num_frames * 4);
+    std::vector<uint16_t> pcm(num_frames * 2);
+    memcpy(pcm.data(), bytes.data(), bytes.size());
+    std::vector<uint32_t> left(num_frames + 1, 0xdeadbeef);
+    std::vector<uint32_t> right(num_frames + 1, 0xdeadbeef);
+
+    a2dp_pcm_deinterleave_16(pcm.data(), num_frames, left.data(),
+                             right.data());
+
+    for (size_t i = 0; i < num_frames; i++) {
+      EXPECT_EQ(left[i], (uint32_t)pcm[2 * i]) << num_frames << " " << i;
+      EXPECT_EQ(right[i], (uint32_t)pcm[2 * i + 1]) << num_frames << " " << i;
+    }
+    EXPECT_EQ(left[num_frames], 0xdeadbeef);
+    EXPECT_EQ(right[num_frames], 0xdeadbeef);
+  }
+}
+
+TEST(A2dpPcmTest, deinterleave_24_packed) {
+  for (size_t num_frames : kNumFrames) {
+    std::vector<uint8_t> pcm = RandomBytes(num_frames * 6);
+    std::vector<uint32_t> left(num_frames + 1, 0xdeadbeef);
+    std::vector<uint32_t> right(num_frames + 1, 0xdeadbeef);
+
+    a2dp_pcm_deinterleave_24_packed(pcm.data(), num_frames, left.data(),
+                                    right.data());
+
+    for (size_t i = 0; i < num_frames; i++) {
+      const uint8_t* p = &pcm[6 * i];
+      int32_t expected_left = p[0] | (p[1] << 8) | ((int8_t)p[2] << 16);
+      p += 3;
+      int32_t expected_right = p[0] | (p[1] << 8) | ((int8_t)p[2] << 16);
+      EXPECT_EQ(left[i], (uint32_t)expected_left) << num_frames << " " << i;
+      EXPECT_EQ(right[i], (uint32_t)expected_right) << num_frames << " " << i;
+    }
+    EXPECT_EQ(left[num_frames], 0xdeadbeef);
+    EXPECT_EQ(right[num_frames], 0xdeadbeef);
+  }
+}
+
+TEST(A2dpPcmTest, deinterleave_24_packed_sign) {
+  // Full scale negative and positive samples, in each of the 4 positions of
+  // the word loads
+  const uint8_t pcm[] = {0x00, 0x00, 0x80, 0xff, 0xff, 0x7f, 0x01, 0x00,
+                         0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x56,
+                         0x34, 0x92, 0x00, 0x00, 0x80, 0xff, 0xff, 0x7f};
+  uint32_t left[4];
+  uint32_t right[4];
+
+  a2dp_pcm_deinterleave_24_packed(pcm, 4, left, right);
+
+  EXPECT_EQ(left[0], 0xff800000u);
+  EXPECT_EQ(right[0], 0x007fffffu);
+  EXPECT_EQ(left[1], 0xffff0001u);
+  EXPECT_EQ(right[1], 0xffffffffu);
+  EXPECT_EQ(left[2], 0x00000000u);
+  EXPECT_EQ(right[2], 0xff923456u);
+  EXPECT_EQ(left[3], 0xff800000u);
+  EXPECT_EQ(right[3], 0x007fffffu);
+}
@@ -174,4 +174,22 @@ TEST(AdvertiseDataParserTest, RemoveTrailingZerosMalformed) {
   glued.insert(glued.end(), scan_resp.begin(), scan_resp.end());
 
   EXPECT_TRUE(AdvertiseDataParser::IsValid(glued));
-}
\ No newline at end of file
+}
+
+// This test makes sure that RemoveTrailingZeros from a position only removes
+// the padding of the data appended at that position, as the scan response
+// glued to the advertising data in place.
+TEST(AdvertiseDataParserTest, RemoveTrailingZerosFromPosition) {
+  std::vector<uint8_t> ad_data{0x02, 0x01, 0x02, 0x00, 0x00};
+  AdvertiseDataParser::RemoveTrailingZeros(ad_data, 0);
+  ASSERT_EQ(3UL, ad_data.size());
+
+  size_t position = ad_data.size();
+  std::vector<uint8_t> scan_resp{0x03, 0x19, 0x00, 0x80, 0x00, 0x00};
+  ad_data.insert(ad_data.end(), scan_resp.begin(), scan_resp.end());
+  AdvertiseDataParser::RemoveTrailingZeros(ad_data, position);
+
+  std::vector<uint8_t> expected{0x02, 0x01, 0x02, 0x03, 0x19, 0x00, 0x80};
+  EXPECT_EQ(expected, ad_data);
+  EXPECT_TRUE(AdvertiseDataParser::IsValid(ad_data));
+}
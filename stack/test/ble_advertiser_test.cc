@@ -29,7 +29,9 @@ using ::testing::Contains;
 using ::testing::ElementsAreArray;
 using ::testing::Exactly;
 using ::testing::Field;
+using ::testing::InSequence;
 using ::testing::IsEmpty;
+using ::testing::Return;
 using ::testing::SaveArg;
 using ::testing::SizeIs;
 using ::testing::_;
@@ -134,6 +136,7 @@ class AdvertiserHciMock : public BleAdvertiserHciInterface {
   };
 
   bool QuirkAdvertiserZeroHandle() override { return false; }
+  MOCK_METHOD0(SupportsMultiSetEnable, bool());
 
  private:
   DISALLOW_COPY_AND_ASSIGN(AdvertiserHciMock);
@@ -948,6 +951,90 @@ TEST_F(BleAdvertisingManagerTest, test_suspend_resume) {
   ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
 }
 
+/* This test makes sure that data of several sets is sent without waiting for
+ * each other, and that the callback is called once, after all of them. */
+TEST_F(BleAdvertisingManagerTest, test_set_data_for_sets) {
+  for (int i = 0; i < 3; i++) {
+    BleAdvertisingManager::Get()->RegisterAdvertiser(Bind(
+        &BleAdvertisingManagerTest::RegistrationCb, base::Unretained(this)));
+    EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, reg_status);
+  }
+
+  std::vector<BleAdvertisingManager::AdvertisingSetData> sets;
+  for (uint8_t inst_id = 0; inst_id < 3; inst_id++) {
+    sets.push_back({.inst_id = inst_id,
+                    .is_scan_rsp = false,
+                    .data = std::vector<uint8_t>{0x02, 0x0A, 0x00}});
+  }
+
+  std::array<status_cb, 3> set_data_cbs;
+  EXPECT_CALL(*hci_mock, SetAdvertisingData(0, COMPLETE, _, _, _, _))
+      .Times(1)
+      .WillOnce(SaveArg<5>(&set_data_cbs[0]));
+  EXPECT_CALL(*hci_mock, SetAdvertisingData(1, COMPLETE, _, _, _, _))
+      .Times(1)
+      .WillOnce(SaveArg<5>(&set_data_cbs[1]));
+  EXPECT_CALL(*hci_mock, SetAdvertisingData(2, COMPLETE, _, _, _, _))
+      .Times(1)
+      .WillOnce(SaveArg<5>(&set_data_cbs[2]));
+
+  BleAdvertisingManager::Get()->SetDataForSets(
+      std::move(sets),
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+
+  set_data_cbs[0].Run(0);
+  set_data_cbs[2].Run(0);
+  EXPECT_EQ(-1, set_data_status);
+  set_data_cbs[1].Run(0);
+  EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, set_data_status);
+}
+
+/* This test makes sure that several sets are enabled with one command, and
+ * that an address update disables and re-enables all of them at once. */
+TEST_F(BleAdvertisingManagerTest, test_batched_address_update) {
+  for (int i = 0; i < 2; i++) {
+    BleAdvertisingManager::Get()->RegisterAdvertiser(Bind(
+        &BleAdvertisingManagerTest::RegistrationCb, base::Unretained(this)));
+    EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, reg_status);
+  }
+
+  tBTM_BLE_ADV_PARAMS params;
+  params.advertising_event_properties = 0x1 /* connectable */;
+  EXPECT_CALL(*hci_mock, SetParameters1(_, _, _, _, _, _, _, _, _)).Times(2);
+  EXPECT_CALL(*hci_mock, SetParameters2(_, _, _, _, _, _, _, _)).Times(2);
+  for (uint8_t inst_id = 0; inst_id < 2; inst_id++) {
+    BleAdvertisingManager::Get()->SetParameters(
+        inst_id, &params,
+        Bind(&BleAdvertisingManagerTest::SetParametersCb,
+             base::Unretained(this)));
+  }
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+
+  ON_CALL(*hci_mock, SupportsMultiSetEnable()).WillByDefault(Return(true));
+
+  status_cb enable_cb;
+  EXPECT_CALL(*hci_mock, Enable(0x01 /* enable */, SizeIs(2), _))
+      .Times(1)
+      .WillOnce(SaveArg<2>(&enable_cb));
+  BleAdvertisingManager::Get()->EnableSets(
+      {0, 1}, true,
+      Bind(&BleAdvertisingManagerTest::EnableCb, base::Unretained(this)));
+  enable_cb.Run(0);
+  EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, enable_status);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+
+  ON_CALL(*hci_mock, SupportsMultiSetEnable()).WillByDefault(Return(true));
+  {
+    InSequence s;
+    EXPECT_CALL(*hci_mock, Enable(0x00 /* disable */, SizeIs(2), _)).Times(1);
+    EXPECT_CALL(*hci_mock, SetRandomAddress(_, _, _)).Times(2);
+    EXPECT_CALL(*hci_mock, Enable(0x01 /* enable */, SizeIs(2), _)).Times(1);
+  }
+  TriggerRandomAddressUpdate();
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+}
+
 /* This test makes sure that conectable advertisment with timeout will get it's
  * duration and maxExtAdvEvents updated, when it's terminated due to incoming
  * connection.*/
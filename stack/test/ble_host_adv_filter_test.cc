@@ -0,0 +1,190 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "stack/btm/ble_host_adv_filter.h"
+
+#include <gtest/gtest.h>
+
+using bluetooth::Uuid;
+
+namespace {
+const RawAddress kAddress1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kAddress2({0x11, 0x22, 0x33, 0x44, 0x55, 0x67});
+
+/* Flags, 16 bit service UUIDs 0x180D and 0xFEAA, local name "Beacon",
+ * manufacturer data of company 0x00E0 and 16 bit service data of 0xFEAA */
+const std::vector<uint8_t> kAdvData{
+    0x02, 0x01, 0x06, 0x05, 0x03, 0x0D, 0x18, 0xAA, 0xFE, 0x07, 0x09,
+    'B',  'e',  'a',  'c',  'o',  'n',  0x05, 0xFF, 0xE0, 0x00, 0x01,
+    0x02, 0x06, 0x16, 0xAA, 0xFE, 0x10, 0x20, 0x30};
+
+btgatt_filt_param_setup_t Params(uint16_t feat_seln, uint8_t filt_logic_type) {
+  btgatt_filt_param_setup_t params;
+  memset(&params, 0, sizeof(params));
+  params.feat_seln = feat_seln;
+  params.list_logic_type = 0;
+  params.filt_logic_type = filt_logic_type;
+  params.rssi_high_thres = (uint8_t)-128;
+  return params;
+}
+
+ApcfCommand Command(uint8_t type) {
+  ApcfCommand cmd = {};
+  cmd.type = type;
+  return cmd;
+}
+
+bool Matches(const BleHostAdvFilter& filter, const RawAddress& bda,
+             int8_t rssi = -50) {
+  return filter.Matches(bda, rssi, kAdvData.data(), kAdvData.size());
+}
+}  // namespace
+
+TEST(BleHostAdvFilterTest, inactive_until_enabled_and_applied) {
+  BleHostAdvFilter filter;
+  EXPECT_FALSE(filter.IsActive());
+
+  ApcfCommand cmd = Command(BTM_BLE_PF_ADDR_FILTER);
+  cmd.address = kAddress2;
+  EXPECT_TRUE(filter.AddCondition(0, cmd));
+  EXPECT_TRUE(filter.SetParams(
+      0, Params(1 << BTM_BLE_PF_ADDR_FILTER, BTM_BLE_PF_LOGIC_AND)));
+  EXPECT_FALSE(filter.IsActive());
+
+  filter.Enable(true);
+  EXPECT_TRUE(filter.IsActive());
+  EXPECT_FALSE(Matches(filter, kAddress1));
+  EXPECT_TRUE(Matches(filter, kAddress2));
+
+  filter.DeleteParams(0);
+  EXPECT_FALSE(filter.IsActive());
+}
+
+TEST(BleHostAdvFilterTest, match_uuid) {
+  BleHostAdvFilter filter;
+  filter.Enable(true);
+
+  ApcfCommand cmd = Command(BTM_BLE_PF_SRVC_UUID);
+  cmd.uuid = Uuid::From16Bit(0x180F);
+  EXPECT_TRUE(filter.AddCondition(0, cmd));
+  EXPECT_TRUE(filter.SetParams(
+      0, Params(1 << BTM_BLE_PF_SRVC_UUID, BTM_BLE_PF_LOGIC_AND)));
+  EXPECT_FALSE(Matches(filter, kAddress1));
+
+  /* Masked UUIDs go through the mask-compare path */
+  cmd.uuid_mask = Uuid::From16Bit(0xFFF0);
+  EXPECT_TRUE(filter.AddCondition(0, cmd));
+  EXPECT_TRUE(Matches(filter, kAddress1));
+
+  filter.ClearConditions(0);
+  cmd.uuid = Uuid::From16Bit(0xFEAA);
+  cmd.uuid_mask = Uuid::kEmpty;
+  EXPECT_TRUE(filter.AddCondition(0, cmd));
+  EXPECT_TRUE(Matches(filter, kAddress1));
+
+  /* Solicitation UUIDs are matched separately */
+  filter.ClearConditions(0);
+  cmd.type = BTM_BLE_PF_SRVC_SOL_UUID;
+  EXPECT_TRUE(filter.AddCondition(0, cmd));
+  EXPECT_TRUE(filter.SetParams(
+      0, Params(1 << BTM_BLE_PF_SRVC_SOL_UUID, BTM_BLE_PF_LOGIC_AND)));
+  EXPECT_FALSE(Matches(filter, kAddress1));
+}
+
+TEST(BleHostAdvFilterTest, match_name_and_data) {
+  BleHostAdvFilter filter;
+  filter.Enable(true);
+  EXPECT_TRUE(filter.SetParams(
+      0, Params(1 << BTM_BLE_PF_LOCAL_NAME, BTM_BLE_PF_LOGIC_AND)));
+  EXPECT_TRUE(filter.SetParams(
+      1, Params(1 << BTM_BLE_PF_MANU_DATA, BTM_BLE_PF_LOGIC_AND)));
+  EXPECT_TRUE(filter.SetParams(
+      2, Params(1 << BTM_BLE_PF_SRVC_DATA_PATTERN, BTM_BLE_PF_LOGIC_AND)));
+
+  ApcfCommand name = Command(BTM_BLE_PF_LOCAL_NAME);
+  name.name = {'B', 'e', 'a'};
+  EXPECT_TRUE(filter.AddCondition(0, name));
+  EXPECT_FALSE(Matches(filter, kAddress1));
+  name.name = {'B', 'e', 'a', 'c', 'o', 'n'};
+  EXPECT_TRUE(filter.AddCondition(0, name));
+  EXPECT_TRUE(Matches(filter, kAddress1));
+  filter.ClearConditions(0);
+
+  ApcfCommand manu = Command(BTM_BLE_PF_MANU_DATA);
+  manu.company = 0x00E0;
+  manu.data = {0x01, 0x03};
+  manu.data_mask = {0xFF, 0xFF};
+  EXPECT_TRUE(filter.AddCondition(1, manu));
+  EXPECT_FALSE(Matches(filter, kAddress1));
+  manu.data_mask = {0xFF, 0xFC};
+  EXPECT_TRUE(filter.AddCondition(1, manu));
+  EXPECT_TRUE(Matches(filter, kAddress1));
+  filter.ClearConditions(1);
+
+  ApcfCommand srvc_data = Command(BTM_BLE_PF_SRVC_DATA_PATTERN);
+  srvc_data.data = {0xAA, 0xFE, 0x10};
+  EXPECT_TRUE(filter.AddCondition(2, srvc_data));
+  EXPECT_TRUE(Matches(filter, kAddress1));
+}
+
+TEST(BleHostAdvFilterTest, feature_logic) {
+  BleHostAdvFilter filter;
+  filter.Enable(true);
+
+  ApcfCommand addr = Command(BTM_BLE_PF_ADDR_FILTER);
+  addr.address = kAddress2;
+  ApcfCommand uuid = Command(BTM_BLE_PF_SRVC_UUID);
+  uuid.uuid = Uuid::From16Bit(0x180D);
+  EXPECT_TRUE(filter.AddCondition(0, addr));
+  EXPECT_TRUE(filter.AddCondition(0, uuid));
+
+  uint16_t features =
+      (1 << BTM_BLE_PF_ADDR_FILTER) | (1 << BTM_BLE_PF_SRVC_UUID);
+  EXPECT_TRUE(filter.SetParams(0, Params(features, BTM_BLE_PF_LOGIC_AND)));
+  EXPECT_FALSE(Matches(filter, kAddress1));
+  EXPECT_TRUE(Matches(filter, kAddress2));
+
+  EXPECT_TRUE(filter.SetParams(0, Params(features, BTM_BLE_PF_LOGIC_OR)));
+  EXPECT_TRUE(Matches(filter, kAddress1));
+
+  /* With list logic AND all the UUIDs of the filter have to be present */
+  uuid.uuid = Uuid::From16Bit(0x1234);
+  EXPECT_TRUE(filter.AddCondition(0, uuid));
+  btgatt_filt_param_setup_t params =
+      Params(1 << BTM_BLE_PF_SRVC_UUID, BTM_BLE_PF_LOGIC_AND);
+  EXPECT_TRUE(filter.SetParams(0, params));
+  EXPECT_TRUE(Matches(filter, kAddress1));
+  params.list_logic_type = 1 << BTM_BLE_PF_SRVC_UUID;
+  EXPECT_TRUE(filter.SetParams(0, params));
+  EXPECT_FALSE(Matches(filter, kAddress1));
+}
+
+TEST(BleHostAdvFilterTest, rssi_threshold_and_all_pass) {
+  BleHostAdvFilter filter;
+  filter.Enable(true);
+
+  btgatt_filt_param_setup_t params = Params(0, BTM_BLE_PF_LOGIC_AND);
+  params.rssi_high_thres = (uint8_t)-60;
+  EXPECT_TRUE(filter.SetParams(0, params));
+  EXPECT_TRUE(Matches(filter, kAddress1, -50));
+  EXPECT_FALSE(Matches(filter, kAddress1, -70));
+
+  EXPECT_FALSE(filter.SetParams(BTM_BLE_HOST_PF_MAX_FILTERS, params));
+  EXPECT_FALSE(filter.AddCondition(BTM_BLE_HOST_PF_MAX_FILTERS,
+                                   Command(BTM_BLE_PF_SRVC_DATA)));
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "stack/btm/ble_scan_report_filter.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+const RawAddress kAddress1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kAddress2({0x11, 0x22, 0x33, 0x44, 0x55, 0x67});
+const std::vector<uint8_t> kData1{0x02, 0x01, 0x06};
+const std::vector<uint8_t> kData2{0x02, 0x01, 0x1a};
+}  // namespace
+
+TEST(BleScanReportFilterTest, drop_repeated_report) {
+  BleScanReportFilter filter(16, 100);
+  EXPECT_TRUE(filter.ShouldReport(kAddress1, 0, kData1, 1000));
+  EXPECT_FALSE(filter.ShouldReport(kAddress1, 0, kData1, 1050));
+  EXPECT_FALSE(filter.ShouldReport(kAddress1, 0, kData1, 1099));
+  EXPECT_TRUE(filter.ShouldReport(kAddress1, 0, kData1, 1100));
+  EXPECT_FALSE(filter.ShouldReport(kAddress1, 0, kData1, 1150));
+}
+
+TEST(BleScanReportFilterTest, report_changes_right_away) {
+  BleScanReportFilter filter(16, 100);
+  EXPECT_TRUE(filter.ShouldReport(kAddress1, 0, kData1, 1000));
+  EXPECT_TRUE(filter.ShouldReport(kAddress1, 0, kData2, 1010));
+  EXPECT_TRUE(filter.ShouldReport(kAddress1, 1, kData1, 1020));
+  EXPECT_TRUE(filter.ShouldReport(kAddress2, 0, kData1, 1030));
+  EXPECT_FALSE(filter.ShouldReport(kAddress1, 0, kData2, 1040));
+  EXPECT_FALSE(filter.ShouldReport(kAddress2, 0, kData1, 1040));
+}
+
+TEST(BleScanReportFilterTest, clear) {
+  BleScanReportFilter filter(16, 100);
+  EXPECT_TRUE(filter.ShouldReport(kAddress1, 0, kData1, 1000));
+  filter.Clear();
+  EXPECT_TRUE(filter.ShouldReport(kAddress1, 0, kData1, 1010));
+}
+
+TEST(BleScanReportFilterTest, no_interval_reports_all) {
+  BleScanReportFilter filter(16, 0);
+  EXPECT_TRUE(filter.ShouldReport(kAddress1, 0, kData1, 1000));
+  EXPECT_TRUE(filter.ShouldReport(kAddress1, 0, kData1, 1000));
+}
+
+TEST(BleScanReportFilterTest, many_advertisers) {
+  BleScanReportFilter filter(16, 100);
+  // more advertisers than slots, the filter forgets some but never drops a
+  // report it has not seen
+  for (int i = 0; i < 256; i++) {
+    RawAddress addr = kAddress1;
+    addr.address[5] = i;
+    EXPECT_TRUE(filter.ShouldReport(addr, 0, kData1, 1000 + i));
+  }
+
+  // the most recent reports are still remembered
+  RawAddress addr = kAddress1;
+  addr.address[5] = 255;
+  EXPECT_FALSE(filter.ShouldReport(addr, 0, kData1, 1256));
+}
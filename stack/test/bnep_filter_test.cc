@@ -0,0 +1,118 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "stack/bnep/bnep_filter.h"
+
+namespace {
+
+const RawAddress kBroadcast({0xff, 0xff, 0xff, 0xff, 0xff, 0xff});
+const RawAddress kMdns({0x01, 0x00, 0x5e, 0x00, 0x00, 0xfb});
+const RawAddress kMdnsV6({0x33, 0x33, 0x00, 0x00, 0x00, 0xfb});
+
+}  // namespace
+
+TEST(BnepFilterTest, no_protocol_filter_allows_all) {
+  tBNEP_PROT_FILTER filter;
+  bnep_prot_filter_set(&filter, 0, nullptr);
+  EXPECT_TRUE(bnep_prot_filter_allows(&filter, 0x0800));
+  EXPECT_TRUE(bnep_prot_filter_allows(&filter, 0x1234));
+}
+
+TEST(BnepFilterTest, protocol_ranges_are_merged) {
+  // Unsorted, overlapping and adjacent ranges
+  const uint8_t filters[] = {0x86, 0xdd, 0x86, 0xdd,   // IPv6
+                             0x08, 0x06, 0x08, 0x10,   // ARP and up
+                             0x08, 0x00, 0x08, 0x05,   // IPv4 to ARP - 1
+                             0x08, 0x08, 0x08, 0x20};  // overlaps ARP range
+  tBNEP_PROT_FILTER filter;
+  bnep_prot_filter_set(&filter, 4, filters);
+  ASSERT_EQ(filter.num_ranges, 2u);
+  EXPECT_EQ(filter.start[0], 0x0800u);
+  EXPECT_EQ(filter.end[0], 0x0820u);
+  EXPECT_EQ(filter.start[1], 0x86ddu);
+  EXPECT_EQ(filter.end[1], 0x86ddu);
+  EXPECT_EQ(filter.common_allowed, BNEP_FILTER_COMMON_IPV4 |
+                                       BNEP_FILTER_COMMON_ARP |
+                                       BNEP_FILTER_COMMON_IPV6);
+
+  EXPECT_TRUE(bnep_prot_filter_allows(&filter, 0x0800));
+  EXPECT_TRUE(bnep_prot_filter_allows(&filter, 0x0815));
+  EXPECT_TRUE(bnep_prot_filter_allows(&filter, 0x86dd));
+  EXPECT_FALSE(bnep_prot_filter_allows(&filter, 0x07ff));
+  EXPECT_FALSE(bnep_prot_filter_allows(&filter, 0x0821));
+  EXPECT_FALSE(bnep_prot_filter_allows(&filter, 0x86de));
+}
+
+TEST(BnepFilterTest, common_protocols_follow_the_ranges) {
+  const uint8_t filters[] = {0x08, 0x00, 0x08, 0x00,   // IPv4 only
+                             0xff, 0xff, 0xff, 0xff};  // top of the range
+  tBNEP_PROT_FILTER filter;
+  bnep_prot_filter_set(&filter, 2, filters);
+  EXPECT_EQ(filter.common_allowed, BNEP_FILTER_COMMON_IPV4);
+  EXPECT_TRUE(bnep_prot_filter_allows(&filter, 0x0800));
+  EXPECT_FALSE(bnep_prot_filter_allows(&filter, 0x0806));
+  EXPECT_FALSE(bnep_prot_filter_allows(&filter, 0x86dd));
+  EXPECT_TRUE(bnep_prot_filter_allows(&filter, 0xffff));
+  EXPECT_FALSE(bnep_prot_filter_allows(&filter, 0xfffe));
+}
+
+TEST(BnepFilterTest, no_multicast_filter_allows_all) {
+  tBNEP_MCAST_FILTER filter;
+  bnep_mcast_filter_set(&filter, 0, nullptr);
+  EXPECT_TRUE(bnep_mcast_filter_allows(&filter, kBroadcast));
+  EXPECT_TRUE(bnep_mcast_filter_allows(&filter, kMdns));
+}
+
+TEST(BnepFilterTest, multicast_ranges) {
+  const uint8_t filters[] = {
+      0x33, 0x33, 0x00, 0x00, 0x00, 0x00, 0x33, 0x33, 0xff, 0xff, 0xff, 0xff,
+      0x01, 0x00, 0x5e, 0x00, 0x00, 0x00, 0x01, 0x00, 0x5e, 0x7f, 0xff, 0xff};
+  tBNEP_MCAST_FILTER filter;
+  bnep_mcast_filter_set(&filter, 2, filters);
+  ASSERT_EQ(filter.num_ranges, 2u);
+  EXPECT_TRUE(bnep_mcast_filter_allows(&filter, kMdns));
+  EXPECT_TRUE(bnep_mcast_filter_allows(&filter, kMdnsV6));
+  EXPECT_FALSE(bnep_mcast_filter_allows(&filter, kBroadcast));
+
+  // The cached result is for the last address checked
+  EXPECT_FALSE(bnep_mcast_filter_allows(&filter, kBroadcast));
+  EXPECT_TRUE(bnep_mcast_filter_allows(&filter, kMdns));
+}
+
+TEST(BnepFilterTest, null_multicast_range_filters_all) {
+  const uint8_t filters[] = {
+      0x01, 0x00, 0x5e, 0x00, 0x00, 0x00, 0x01, 0x00, 0x5e, 0x7f, 0xff, 0xff,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  tBNEP_MCAST_FILTER filter;
+  bnep_mcast_filter_set(&filter, 2, filters);
+  EXPECT_FALSE(bnep_mcast_filter_allows(&filter, kMdns));
+  EXPECT_FALSE(bnep_mcast_filter_allows(&filter, kBroadcast));
+}
+
+TEST(BnepFilterTest, new_filters_reset_the_cache) {
+  const uint8_t filters[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                             0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+  tBNEP_MCAST_FILTER filter;
+  bnep_mcast_filter_set(&filter, 1, filters);
+  EXPECT_TRUE(bnep_mcast_filter_allows(&filter, kBroadcast));
+
+  const uint8_t mdns_filters[] = {0x01, 0x00, 0x5e, 0x00, 0x00, 0xfb,
+                                  0x01, 0x00, 0x5e, 0x00, 0x00, 0xfb};
+  bnep_mcast_filter_set(&filter, 1, mdns_filters);
+  EXPECT_FALSE(bnep_mcast_filter_allows(&filter, kBroadcast));
+}
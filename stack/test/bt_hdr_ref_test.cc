@@ -0,0 +1,104 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include "osi/include/allocator.h"
+#include "stack/include/bt_hdr_ref.h"
+
+namespace {
+
+BT_HDR* NewPacket(uint16_t offset, uint16_t len) {
+  BT_HDR* p_buf =
+      static_cast<BT_HDR*>(osi_malloc(sizeof(BT_HDR) + offset + len));
+  p_buf->event = 1;
+  p_buf->offset = offset;
+  p_buf->len = len;
+  p_buf->layer_specific = 2;
+  memset(p_buf->data + offset, 0xa5, len);
+  return p_buf;
+}
+
+}  // namespace
+
+TEST(BtHdrRefTest, unshared_buffer_is_freed_on_unref) {
+  BT_HDR* p_buf = NewPacket(4, 16);
+  EXPECT_FALSE(bt_hdr_is_shared(p_buf));
+  EXPECT_EQ(bt_hdr_ref_count(p_buf), 1u);
+  EXPECT_EQ(bt_hdr_make_writable(p_buf), p_buf);
+  bt_hdr_unref(p_buf);
+  bt_hdr_unref(nullptr);
+}
+
+TEST(BtHdrRefTest, reference_is_an_alias) {
+  BT_HDR* p_buf = NewPacket(4, 16);
+  BT_HDR* p_ref = bt_hdr_ref(p_buf);
+  EXPECT_EQ(p_ref, p_buf);
+  EXPECT_TRUE(bt_hdr_is_shared(p_buf));
+  EXPECT_EQ(bt_hdr_ref_count(p_buf), 2u);
+
+  bt_hdr_unref(p_ref);
+  EXPECT_FALSE(bt_hdr_is_shared(p_buf));
+  // No longer shared: a plain buffer again
+  osi_free(p_buf);
+}
+
+TEST(BtHdrRefTest, make_writable_copies_shared_buffers) {
+  BT_HDR* p_buf = NewPacket(8, 32);
+  bt_hdr_ref(p_buf);
+  bt_hdr_ref(p_buf);
+  EXPECT_EQ(bt_hdr_ref_count(p_buf), 3u);
+
+  BT_HDR* p_copy = bt_hdr_make_writable(p_buf);
+  ASSERT_NE(p_copy, p_buf);
+  EXPECT_EQ(bt_hdr_ref_count(p_buf), 2u);
+  EXPECT_FALSE(bt_hdr_is_shared(p_copy));
+  EXPECT_EQ(p_copy->event, p_buf->event);
+  EXPECT_EQ(p_copy->offset, p_buf->offset);
+  EXPECT_EQ(p_copy->len, p_buf->len);
+  EXPECT_EQ(p_copy->layer_specific, p_buf->layer_specific);
+  EXPECT_EQ(memcmp(p_copy->data + 8, p_buf->data + 8, 32), 0);
+
+  // Modifying the copy leaves the shared buffer untouched
+  p_copy->offset -= 4;
+  p_copy->len += 4;
+  memset(p_copy->data + p_copy->offset, 0, 4);
+  EXPECT_EQ(p_buf->offset, 8);
+  EXPECT_EQ(p_buf->len, 32);
+  osi_free(p_copy);
+
+  // The second holder may modify it, the last one gets it as is
+  p_copy = bt_hdr_make_writable(p_buf);
+  EXPECT_NE(p_copy, p_buf);
+  osi_free(p_copy);
+  EXPECT_EQ(bt_hdr_make_writable(p_buf), p_buf);
+  osi_free(p_buf);
+}
+
+TEST(BtHdrRefTest, buffers_are_counted_independently) {
+  BT_HDR* p_first = NewPacket(0, 8);
+  BT_HDR* p_second = NewPacket(0, 8);
+  bt_hdr_ref(p_first);
+  EXPECT_TRUE(bt_hdr_is_shared(p_first));
+  EXPECT_FALSE(bt_hdr_is_shared(p_second));
+
+  bt_hdr_unref(p_second);
+  bt_hdr_unref(p_first);
+  EXPECT_FALSE(bt_hdr_is_shared(p_first));
+  bt_hdr_unref(p_first);
+}
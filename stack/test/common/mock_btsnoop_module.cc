@@ -35,8 +35,15 @@ static void clear_l2cap_whitelist(uint16_t, uint16_t,
                                   uint16_t) { /* do nothing */
 }
 
-static const btsnoop_t fake_snoop = {capture, whitelist_l2c_channel,
-                                     whitelist_rfc_dlci, add_rfc_l2c_channel,
-                                     clear_l2cap_whitelist};
+static void add_l2c_channel_psm(uint16_t, uint16_t, uint16_t,
+                                uint16_t) { /* do nothing */
+}
+
+static const btsnoop_t fake_snoop = {capture,
+                                     whitelist_l2c_channel,
+                                     whitelist_rfc_dlci,
+                                     add_rfc_l2c_channel,
+                                     clear_l2cap_whitelist,
+                                     add_l2c_channel_psm};
 
 const btsnoop_t* btsnoop_get_interface() { return &fake_snoop; }
@@ -121,6 +121,15 @@ void port_event_cback_1(uint32_t code, uint16_t port_handle) {
   rfcomm_callback->PortEventCallback(code, port_handle, 1);
 }
 
+bool accept_incoming_data = true;
+
+int port_data_co_cback(uint16_t port_handle, uint8_t* p_buf, uint16_t len,
+                       int type) {
+  if (type != DATA_CO_CALLBACK_TYPE_INCOMING) return false;
+  osi_free(p_buf);
+  return accept_incoming_data;
+}
+
 RawAddress GetTestAddress(int index) {
   CHECK_LT(index, UINT8_MAX);
   RawAddress result = {
@@ -496,6 +505,113 @@ TEST_F(StackRfcommTest, SingleServerConnectionHelloWorld) {
                                         "\r!dlroW olleH", 4, acl_handle, lcid));
 }
 
+TEST_F(StackRfcommTest, WritesQueuedWithoutCreditsAreSentInFullFrames) {
+  static const uint16_t acl_handle = 0x0009;
+  static const uint16_t lcid = 0x0054;
+  static const uint16_t test_uuid = 0x1112;
+  static const uint8_t test_scn = 8;
+  static const uint16_t test_mtu = 60;
+  static const RawAddress test_address = GetTestAddress(0);
+  uint16_t server_handle = 0;
+  ASSERT_NO_FATAL_FAILURE(StartServerPort(test_uuid, test_scn, test_mtu,
+                                          port_mgmt_cback_0, port_event_cback_0,
+                                          &server_handle));
+  ASSERT_NO_FATAL_FAILURE(ConnectServerL2cap(test_address, acl_handle, lcid));
+  ASSERT_NO_FATAL_FAILURE(ConnectServerPort(
+      test_address, server_handle, test_scn, test_mtu, acl_handle, lcid, 0));
+
+  VLOG(1) << "Step 1";
+  // Use up the credits given by the peer in parameter negotiation
+  for (int i = 0; i < RFCOMM_K_MAX; i++) {
+    ASSERT_NO_FATAL_FAILURE(SendAndVerifyOutgoingTransmission(
+        server_handle, false, test_scn, false, "Hello World!\r",
+        i == 0 ? 3 : -1, acl_handle, lcid));
+  }
+
+  VLOG(1) << "Step 2";
+  // Writes without credits are queued, filling each frame up to the peer MTU
+  const std::string first_message(50, 'a');
+  const std::string second_message(30, 'b');
+  uint16_t transmitted_length = 0;
+  ASSERT_EQ(PORT_WriteData(server_handle, first_message.data(),
+                           first_message.size(), &transmitted_length),
+            PORT_SUCCESS);
+  ASSERT_EQ(transmitted_length, first_message.size());
+  ASSERT_EQ(PORT_WriteData(server_handle, second_message.data(),
+                           second_message.size(), &transmitted_length),
+            PORT_SUCCESS);
+  ASSERT_EQ(transmitted_length, second_message.size());
+
+  VLOG(1) << "Step 3";
+  // Once the peer gives credits, the queued data is sent in two frames
+  BT_HDR* full_frame = AllocateWrappedOutgoingL2capAclPacket(
+      CreateQuickDataPacket(GetDlci(false, test_scn), false, lcid, acl_handle,
+                            -1, first_message + second_message.substr(0, 10)));
+  BT_HDR* last_frame = AllocateWrappedOutgoingL2capAclPacket(
+      CreateQuickDataPacket(GetDlci(false, test_scn), false, lcid, acl_handle,
+                            -1, second_message.substr(10)));
+  EXPECT_CALL(l2cap_interface_, DataWrite(lcid, BtHdrEqual(full_frame)))
+      .WillOnce(Return(L2CAP_DW_SUCCESS));
+  EXPECT_CALL(l2cap_interface_, DataWrite(lcid, BtHdrEqual(last_frame)))
+      .WillOnce(Return(L2CAP_DW_SUCCESS));
+  BT_HDR* credits_from_peer = AllocateWrappedIncomingL2capAclPacket(
+      CreateQuickDataPacket(GetDlci(false, test_scn), true, lcid, acl_handle,
+                            2, ""));
+  l2cap_appl_info_.pL2CA_DataInd_Cb(lcid, credits_from_peer);
+  osi_free(full_frame);
+  osi_free(last_frame);
+}
+
+TEST_F(StackRfcommTest, CreditsFollowDataCalloutDrainRate) {
+  static const uint16_t acl_handle = 0x0009;
+  static const uint16_t lcid = 0x0054;
+  static const uint16_t test_uuid = 0x1112;
+  static const uint8_t test_scn = 8;
+  static const uint16_t test_mtu = 60;
+  static const RawAddress test_address = GetTestAddress(0);
+  uint16_t server_handle = 0;
+  ASSERT_NO_FATAL_FAILURE(StartServerPort(test_uuid, test_scn, test_mtu,
+                                          port_mgmt_cback_0, port_event_cback_0,
+                                          &server_handle));
+  ASSERT_NO_FATAL_FAILURE(ConnectServerL2cap(test_address, acl_handle, lcid));
+  ASSERT_NO_FATAL_FAILURE(ConnectServerPort(
+      test_address, server_handle, test_scn, test_mtu, acl_handle, lcid, 0));
+  ASSERT_EQ(PORT_SetDataCOCallback(server_handle, port_data_co_cback),
+            PORT_SUCCESS);
+  accept_incoming_data = true;
+
+  VLOG(1) << "Step 1";
+  // Data is drained as it arrives: the credit update grows past the credits
+  // selected for the MTU, here 10 of which 7 were given in negotiation
+  BT_HDR* credits_to_peer = AllocateWrappedOutgoingL2capAclPacket(
+      CreateQuickDataPacket(GetDlci(false, test_scn), false, lcid, acl_handle,
+                            16, ""));
+  EXPECT_CALL(l2cap_interface_, DataWrite(lcid, BtHdrEqual(credits_to_peer)))
+      .WillOnce(Return(L2CAP_DW_SUCCESS));
+  for (int i = 0; i < 3; i++) {
+    BT_HDR* data_packet = AllocateWrappedIncomingL2capAclPacket(
+        CreateQuickDataPacket(GetDlci(false, test_scn), true, lcid, acl_handle,
+                              -1, "Hello World!\r"));
+    l2cap_appl_info_.pL2CA_DataInd_Cb(lcid, data_packet);
+  }
+  osi_free(credits_to_peer);
+
+  VLOG(1) << "Step 2";
+  // Data could not be drained: credits fall back once flow is enabled again
+  accept_incoming_data = false;
+  BT_HDR* data_packet = AllocateWrappedIncomingL2capAclPacket(
+      CreateQuickDataPacket(GetDlci(false, test_scn), true, lcid, acl_handle,
+                            -1, "Hello World!\r"));
+  l2cap_appl_info_.pL2CA_DataInd_Cb(lcid, data_packet);
+  credits_to_peer = AllocateWrappedOutgoingL2capAclPacket(
+      CreateQuickDataPacket(GetDlci(false, test_scn), false, lcid, acl_handle,
+                            10, ""));
+  EXPECT_CALL(l2cap_interface_, DataWrite(lcid, BtHdrEqual(credits_to_peer)))
+      .WillOnce(Return(L2CAP_DW_SUCCESS));
+  ASSERT_EQ(PORT_FlowControl_MaxCredit(server_handle, true), PORT_SUCCESS);
+  osi_free(credits_to_peer);
+}
+
 TEST_F(StackRfcommTest, MultiServerPortSameDeviceHelloWorld) {
   // Prepare a server channel at kTestChannelNumber0
   static const uint16_t acl_handle = 0x0009;
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stack/btm/sco_hci_codec.h"
+
+#include <gtest/gtest.h>
+#include <math.h>
+
+#include "device/include/esco_parameters.h"
+
+namespace {
+
+constexpr size_t kFrameSamples = 4;
+
+std::vector<int16_t> Frame(int16_t value) {
+  return std::vector<int16_t>(kFrameSamples, value);
+}
+
+/* A 1 kHz tone at half scale */
+std::vector<int16_t> Tone(size_t samples, uint32_t sample_rate) {
+  std::vector<int16_t> pcm(samples);
+  for (size_t i = 0; i < samples; i++) {
+    pcm[i] = (int16_t)(16384 * sin(2 * M_PI * 1000 * i / sample_rate));
+  }
+  return pcm;
+}
+
+/* Encodes |pcm| into packets of |packet_len| bytes, and decodes them again,
+ * dropping the packets for which |lost| returns true */
+std::vector<int16_t> RoundTrip(ScoCodec* codec, const std::vector<int16_t>& pcm,
+                               size_t packet_len,
+                               std::function<bool(size_t)> lost) {
+  size_t frame_samples = codec->FrameSamples();
+  size_t next = 0;
+  ScoCodec::FrameSource source = [&](int16_t* frame) {
+    if (next + frame_samples > pcm.size()) return false;
+    std::copy(&pcm[next], &pcm[next] + frame_samples, frame);
+    next += frame_samples;
+    return true;
+  };
+  std::vector<int16_t> decoded;
+  ScoCodec::FrameSink sink = [&](const int16_t* frame) {
+    decoded.insert(decoded.end(), frame, frame + frame_samples);
+  };
+
+  std::vector<uint8_t> packet(packet_len);
+  for (size_t i = 0; decoded.size() < pcm.size(); i++) {
+    codec->Encode(packet.data(), packet.size(), source);
+    if (lost(i)) {
+      std::fill(packet.begin(), packet.end(), 0);
+      codec->Decode(packet.data(), packet.size(), true, sink);
+    } else {
+      codec->Decode(packet.data(), packet.size(), false, sink);
+    }
+  }
+  return decoded;
+}
+
+double Snr(const std::vector<int16_t>& reference,
+           const std::vector<int16_t>& decoded, size_t begin, size_t end) {
+  double signal = 0;
+  double noise = 0;
+  for (size_t i = begin; i < end; i++) {
+    signal += (double)reference[i] * reference[i];
+    noise += ((double)reference[i] - decoded[i]) *
+             ((double)reference[i] - decoded[i]);
+  }
+  return 10 * log10(signal / noise);
+}
+
+}  // namespace
+
+TEST(ScoJitterBufferTest, buffer_target_depth_before_reading) {
+  ScoJitterBuffer buffer(kFrameSamples, 2, 8);
+  std::vector<int16_t> frame(kFrameSamples);
+  EXPECT_FALSE(buffer.Read(frame.data()));
+  buffer.Write(Frame(1).data());
+  EXPECT_FALSE(buffer.Read(frame.data()));
+  buffer.Write(Frame(2).data());
+  EXPECT_TRUE(buffer.Read(frame.data()));
+  EXPECT_EQ(frame, Frame(1));
+  EXPECT_TRUE(buffer.Read(frame.data()));
+  EXPECT_EQ(frame, Frame(2));
+  EXPECT_EQ(buffer.GetStats().underruns, 0u);
+}
+
+TEST(ScoJitterBufferTest, underrun_raises_target) {
+  ScoJitterBuffer buffer(kFrameSamples, 2, 8);
+  std::vector<int16_t> frame(kFrameSamples);
+  buffer.Write(Frame(1).data());
+  buffer.Write(Frame(2).data());
+  EXPECT_TRUE(buffer.Read(frame.data()));
+  EXPECT_TRUE(buffer.Read(frame.data()));
+  EXPECT_FALSE(buffer.Read(frame.data()));
+  EXPECT_EQ(buffer.GetStats().underruns, 1u);
+  EXPECT_EQ(buffer.Target(), 3u);
+
+  // Reads only resume once the new target is buffered
+  buffer.Write(Frame(3).data());
+  buffer.Write(Frame(4).data());
+  EXPECT_FALSE(buffer.Read(frame.data()));
+  buffer.Write(Frame(5).data());
+  EXPECT_TRUE(buffer.Read(frame.data()));
+  EXPECT_EQ(frame, Frame(3));
+  EXPECT_EQ(buffer.GetStats().underruns, 1u);
+}
+
+TEST(ScoJitterBufferTest, target_is_bounded) {
+  ScoJitterBuffer buffer(kFrameSamples, 1, 3);
+  std::vector<int16_t> frame(kFrameSamples);
+  for (int i = 0; i < 10; i++) {
+    for (size_t j = 0; j < buffer.Target(); j++) buffer.Write(Frame(i).data());
+    while (buffer.Read(frame.data())) {
+    }
+  }
+  EXPECT_EQ(buffer.Target(), 3u);
+  EXPECT_EQ(buffer.GetStats().underruns, 10u);
+}
+
+TEST(ScoJitterBufferTest, stable_reads_lower_target) {
+  ScoJitterBuffer buffer(kFrameSamples, 1, 8);
+  std::vector<int16_t> frame(kFrameSamples);
+  buffer.Write(Frame(0).data());
+  EXPECT_TRUE(buffer.Read(frame.data()));
+  EXPECT_FALSE(buffer.Read(frame.data()));
+  EXPECT_EQ(buffer.Target(), 2u);
+
+  buffer.Write(Frame(0).data());
+  buffer.Write(Frame(0).data());
+  for (size_t i = 0; i < ScoJitterBuffer::kStableReads; i++) {
+    EXPECT_TRUE(buffer.Read(frame.data()));
+    buffer.Write(Frame(0).data());
+  }
+  EXPECT_EQ(buffer.Target(), 1u);
+}
+
+TEST(ScoJitterBufferTest, drop_oldest_frames_when_writer_is_faster) {
+  ScoJitterBuffer buffer(kFrameSamples, 2, 4);
+  std::vector<int16_t> frame(kFrameSamples);
+  for (int i = 0; i < 6; i++) buffer.Write(Frame(i).data());
+  // Twice the target depth is kept
+  EXPECT_TRUE(buffer.Read(frame.data()));
+  EXPECT_EQ(frame, Frame(2));
+  EXPECT_EQ(buffer.GetStats().dropped_frames, 2u);
+  EXPECT_EQ(buffer.GetStats().max_depth, 4u);
+
+  // Beyond the capacity the oldest frames are overwritten
+  for (int i = 0; i < 20; i++) buffer.Write(Frame(i).data());
+  EXPECT_EQ(buffer.Depth(), 8u);
+  EXPECT_TRUE(buffer.Read(frame.data()));
+  EXPECT_EQ(frame, Frame(16));
+}
+
+TEST(ScoPlcTest, conceal_fades_out_last_good_frame) {
+  ScoPlc plc(kFrameSamples);
+  std::vector<int16_t> frame = Frame(1024);
+  plc.GoodFrame(frame.data());
+  plc.BadFrame(frame.data());
+  EXPECT_EQ(frame, Frame(512));
+  plc.BadFrame(frame.data());
+  EXPECT_EQ(frame, Frame(256));
+  for (size_t i = 2; i < ScoPlc::kMaxAttenuatedFrames; i++) {
+    plc.BadFrame(frame.data());
+  }
+  EXPECT_EQ(frame, Frame(4));
+  plc.BadFrame(frame.data());
+  EXPECT_EQ(frame, Frame(0));
+  EXPECT_EQ(plc.ConcealedFrames(), ScoPlc::kMaxAttenuatedFrames + 1);
+}
+
+TEST(ScoPlcTest, cross_fade_after_loss) {
+  ScoPlc plc(ScoPlc::kCrossFadeSamples * 2);
+  std::vector<int16_t> frame(ScoPlc::kCrossFadeSamples * 2, 1024);
+  plc.GoodFrame(frame.data());
+  plc.BadFrame(frame.data());
+
+  std::vector<int16_t> good(frame.size(), 2048);
+  frame = good;
+  plc.GoodFrame(frame.data());
+  // Starts from the next concealed value, and ends with the good frame
+  EXPECT_EQ(frame[0], 256);
+  for (size_t i = 1; i < ScoPlc::kCrossFadeSamples; i++) {
+    EXPECT_GT(frame[i], frame[i - 1]);
+  }
+  for (size_t i = ScoPlc::kCrossFadeSamples; i < frame.size(); i++) {
+    EXPECT_EQ(frame[i], 2048);
+  }
+
+  // Without loss good frames are left untouched
+  frame = good;
+  plc.GoodFrame(frame.data());
+  EXPECT_EQ(frame, good);
+}
+
+TEST(ScoCodecTest, create) {
+  EXPECT_EQ(ScoCodec::Create(ESCO_CODING_FORMAT_CVSD)->SampleRate(), 8000u);
+  EXPECT_EQ(ScoCodec::Create(ESCO_CODING_FORMAT_MSBC)->SampleRate(), 16000u);
+  EXPECT_EQ(ScoCodec::Create(ESCO_CODING_FORMAT_TRANSPNT), nullptr);
+}
+
+TEST(ScoCodecTest, cvsd_passes_pcm_through) {
+  ScoCvsdCodec codec;
+  std::vector<int16_t> pcm = Tone(ScoCvsdCodec::kFrameSamples * 20, 8000);
+  std::vector<int16_t> decoded =
+      RoundTrip(&codec, pcm, 48, [](size_t) { return false; });
+  ASSERT_EQ(decoded.size(), pcm.size());
+  EXPECT_EQ(decoded, pcm);
+  EXPECT_EQ(codec.DecodedFrames(), 20u);
+  EXPECT_EQ(codec.ConcealedFrames(), 0u);
+}
+
+TEST(ScoCodecTest, msbc_round_trip) {
+  ScoMsbcCodec codec;
+  std::vector<int16_t> pcm = Tone(ScoMsbcCodec::kFrameSamples * 40, 16000);
+  std::vector<int16_t> decoded =
+      RoundTrip(&codec, pcm, 60, [](size_t) { return false; });
+  ASSERT_EQ(decoded.size(), pcm.size());
+  EXPECT_EQ(codec.DecodedFrames(), 40u);
+  EXPECT_EQ(codec.ConcealedFrames(), 0u);
+  EXPECT_EQ(codec.DecodeErrors(), 0u);
+
+  // The filterbanks of the encoder and decoder delay the signal by 73 samples
+  constexpr size_t kDelay = 73;
+  std::vector<int16_t> aligned(decoded.begin() + kDelay, decoded.end());
+  EXPECT_GT(Snr(pcm, aligned, 240, aligned.size()), 20);
+}
+
+TEST(ScoCodecTest, msbc_across_packet_sizes) {
+  for (size_t packet_len : {24, 48, 72}) {
+    ScoMsbcCodec codec;
+    std::vector<int16_t> pcm = Tone(ScoMsbcCodec::kFrameSamples * 12, 16000);
+    RoundTrip(&codec, pcm, packet_len, [](size_t) { return false; });
+    EXPECT_EQ(codec.DecodedFrames(), 12u) << packet_len;
+    EXPECT_EQ(codec.ConcealedFrames(), 0u) << packet_len;
+  }
+}
+
+TEST(ScoCodecTest, msbc_conceals_lost_packets) {
+  ScoMsbcCodec codec;
+  std::vector<int16_t> pcm = Tone(ScoMsbcCodec::kFrameSamples * 20, 16000);
+  std::vector<int16_t> decoded =
+      RoundTrip(&codec, pcm, 60, [](size_t i) { return i == 5 || i == 6; });
+  // Lost frames are replaced, so that the stream keeps its pace
+  EXPECT_EQ(decoded.size(), pcm.size());
+  EXPECT_EQ(codec.DecodedFrames(), 18u);
+  EXPECT_EQ(codec.ConcealedFrames(), 2u);
+  EXPECT_EQ(codec.DecodeErrors(), 0u);
+}
+
+TEST(ScoCodecTest, msbc_resynchronizes_after_corruption) {
+  ScoMsbcCodec codec;
+  std::vector<int16_t> pcm = Tone(ScoMsbcCodec::kFrameSamples * 20, 16000);
+  size_t frames = pcm.size() / ScoMsbcCodec::kFrameSamples;
+  size_t next = 0;
+  ScoCodec::FrameSource source = [&](int16_t* frame) {
+    std::copy(&pcm[next], &pcm[next] + ScoMsbcCodec::kFrameSamples, frame);
+    next += ScoMsbcCodec::kFrameSamples;
+    return true;
+  };
+  size_t decoded = 0;
+  ScoCodec::FrameSink sink = [&](const int16_t*) { decoded++; };
+
+  std::vector<uint8_t> packet(ScoMsbcCodec::kPacketFrameLength);
+  for (size_t i = 0; i < frames; i++) {
+    codec.Encode(packet.data(), packet.size(), source);
+    if (i == 4) {
+      // Corrupt a frame without the controller noticing, and slip a byte
+      packet[0] = 0xff;
+      packet[20] ^= 0x5a;
+      codec.Decode(packet.data() + 1, packet.size() - 1, false, sink);
+    } else {
+      codec.Decode(packet.data(), packet.size(), false, sink);
+    }
+  }
+  EXPECT_GT(codec.DecodeErrors(), 0u);
+  EXPECT_EQ(codec.DecodedFrames(), frames - 1);
+  EXPECT_GE(decoded + 1, frames);
+}
@@ -22,6 +22,9 @@ known_tests=(
   net_test_types
   net_test_btu_message_loop
   net_test_osi
+  net_test_sbc_encoder
+  net_test_g722
+  net_test_sbc_decoder
   net_test_performance
   net_test_stack_rfcomm
   net_test_gatt_conn_multiplexing
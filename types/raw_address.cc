@@ -18,11 +18,8 @@
 
 #include "raw_address.h"
 
-#include <base/strings/string_split.h>
-#include <base/strings/stringprintf.h>
 #include <stdint.h>
 #include <algorithm>
-#include <vector>
 
 static_assert(sizeof(RawAddress) == 6, "RawAddress must be 6 bytes long!");
 
@@ -33,29 +30,42 @@ RawAddress::RawAddress(const uint8_t (&addr)[6]) {
   std::copy(addr, addr + kLength, address);
 }
 
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+}  // namespace
+
 std::string RawAddress::ToString() const {
-  return base::StringPrintf("%02x:%02x:%02x:%02x:%02x:%02x", address[0],
-                            address[1], address[2], address[3], address[4],
-                            address[5]);
+  char buf[kStringLength];
+  char* out = buf;
+  for (unsigned int i = 0; i < kLength; i++) {
+    if (i != 0) *out++ = ':';
+    *out++ = kHexDigits[address[i] >> 4];
+    *out++ = kHexDigits[address[i] & 0x0f];
+  }
+  return std::string(buf, kStringLength);
 }
 
 bool RawAddress::FromString(const std::string& from, RawAddress& to) {
   RawAddress new_addr;
-  if (from.length() != 17) return false;
-
-  std::vector<std::string> byte_tokens =
-      base::SplitString(from, ":", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
-
-  if (byte_tokens.size() != 6) return false;
-
-  for (int i = 0; i < 6; i++) {
-    const auto& token = byte_tokens[i];
+  if (from.length() != kStringLength) return false;
 
-    if (token.length() != 2) return false;
+  const char* in = from.data();
+  for (unsigned int i = 0; i < kLength; i++, in += 3) {
+    if (i != 0 && in[-1] != ':') return false;
 
-    char* temp = nullptr;
-    new_addr.address[i] = strtol(token.c_str(), &temp, 16);
-    if (*temp != '\0') return false;
+    int high = HexValue(in[0]);
+    int low = HexValue(in[1]);
+    if (high < 0 || low < 0) return false;
+    new_addr.address[i] = (high << 4) | low;
   }
 
   to = new_addr;
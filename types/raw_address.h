@@ -26,6 +26,8 @@
 class RawAddress final {
  public:
   static constexpr unsigned int kLength = 6;
+  // Length of the "xx:xx:xx:xx:xx:xx" string form
+  static constexpr unsigned int kStringLength = 17;
 
   uint8_t address[kLength];
 
@@ -74,6 +76,13 @@ struct std::hash<RawAddress> {
     uint64_t int_addr = 0;
     memcpy(reinterpret_cast<uint8_t*>(&int_addr), val.address,
            RawAddress::kLength);
-    return std::hash<uint64_t>{}(int_addr);
+    // splitmix64 finalizer, so that addresses of the same vendor spread over
+    // all the buckets
+    int_addr ^= int_addr >> 30;
+    int_addr *= 0xbf58476d1ce4e5b9ULL;
+    int_addr ^= int_addr >> 27;
+    int_addr *= 0x94d049bb133111ebULL;
+    int_addr ^= int_addr >> 31;
+    return int_addr;
   }
 };
@@ -18,8 +18,11 @@
 #ifndef UIPC_H
 #define UIPC_H
 
+#include <atomic>
 #include <mutex>
 
+#include "osi/include/reactor.h"
+
 #define UIPC_CH_ID_AV_CTRL 0
 #define UIPC_CH_ID_AV_AUDIO 1
 #define UIPC_CH_NUM 2
@@ -63,6 +66,17 @@ typedef struct {
   int read_poll_tmo_ms;
   int task_evt_flags; /* event flags pending to be processed in read task */
   tUIPC_RCV_CBACK* cback;
+
+  /* watch fd for incoming data, unless the user reads it directly */
+  bool read_active;
+  /* registrations of srvfd and fd with the read task reactor, only changed
+     by the read task */
+  reactor_object_t* srv_reactor_object;
+  reactor_object_t* reactor_object;
+  /* set by the reactor callbacks, handled once the reactor returns, and
+     cleared by callers on other threads: atomic */
+  std::atomic<bool> srv_ready;
+  std::atomic<bool> ready;
 } tUIPC_CHAN;
 
 struct tUIPC_STATE {
@@ -70,9 +84,9 @@ struct tUIPC_STATE {
   int running;
   std::recursive_mutex mutex;
 
-  fd_set active_set;
-  fd_set read_set;
-  int max_fd;
+  reactor_t* reactor;
+  reactor_object_t* signal_reactor_object;
+  std::atomic<bool> signal_ready;
   int signal_fds[2];
 
   tUIPC_CHAN ch[UIPC_CH_NUM];
@@ -33,7 +33,6 @@
 #include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/prctl.h>
-#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/un.h>
@@ -55,16 +54,12 @@
 
 #define PCM_FILENAME "/data/test.pcm"
 
-#define MAX(a, b) ((a) > (b) ? (a) : (b))
-
 #define CASE_RETURN_STR(const) \
   case const:                  \
     return #const;
 
 #define UIPC_DISCONNECTED (-1)
 
-#define SAFE_FD_ISSET(fd, set) (((fd) == -1) ? false : FD_ISSET((fd), (set)))
-
 #define UIPC_FLUSH_BUFFER_SIZE 1024
 
 /*****************************************************************************
@@ -178,6 +173,27 @@ static int accept_server_socket(int sfd) {
  *
  ****************************************************************************/
 
+/* The reactor callbacks only record which fds are readable, the read task
+   handles them once the reactor returns. Registrations can then be changed
+   from outside the callbacks. */
+static void uipc_signal_ready_cb(void* context) {
+  static_cast<tUIPC_STATE*>(context)->signal_ready = true;
+}
+
+static void uipc_srv_ready_cb(void* context) {
+  static_cast<tUIPC_CHAN*>(context)->srv_ready = true;
+}
+
+static void uipc_ready_cb(void* context) {
+  static_cast<tUIPC_CHAN*>(context)->ready = true;
+}
+
+static void uipc_unregister_locked(reactor_object_t** object) {
+  if (*object == NULL) return;
+  reactor_unregister(*object);
+  *object = NULL;
+}
+
 static int uipc_main_init(tUIPC_STATE& uipc) {
   int i;
 
@@ -185,28 +201,37 @@ static int uipc_main_init(tUIPC_STATE& uipc) {
 
   uipc.tid = 0;
   uipc.running = 0;
-  memset(&uipc.active_set, 0, sizeof(uipc.active_set));
-  memset(&uipc.read_set, 0, sizeof(uipc.read_set));
-  uipc.max_fd = 0;
+  uipc.signal_reactor_object = NULL;
+  uipc.signal_ready = false;
   memset(&uipc.signal_fds, 0, sizeof(uipc.signal_fds));
-  memset(&uipc.ch, 0, sizeof(uipc.ch));
-
-  /* setup interrupt socket pair */
-  if (socketpair(AF_UNIX, SOCK_STREAM, 0, uipc.signal_fds) < 0) {
-    return -1;
-  }
-
-  FD_SET(uipc.signal_fds[0], &uipc.active_set);
-  uipc.max_fd = MAX(uipc.max_fd, uipc.signal_fds[0]);
 
   for (i = 0; i < UIPC_CH_NUM; i++) {
     tUIPC_CHAN* p = &uipc.ch[i];
     p->srvfd = UIPC_DISCONNECTED;
     p->fd = UIPC_DISCONNECTED;
+    p->read_poll_tmo_ms = 0;
     p->task_evt_flags = 0;
     p->cback = NULL;
+    p->read_active = false;
+    p->srv_reactor_object = NULL;
+    p->reactor_object = NULL;
+    p->srv_ready = false;
+    p->ready = false;
   }
 
+  uipc.reactor = reactor_new();
+  if (uipc.reactor == NULL) {
+    return -1;
+  }
+
+  /* setup interrupt socket pair */
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, uipc.signal_fds) < 0) {
+    return -1;
+  }
+
+  uipc.signal_reactor_object = reactor_register(
+      uipc.reactor, uipc.signal_fds[0], &uipc, uipc_signal_ready_cb, NULL);
+
   return 0;
 }
 
@@ -215,11 +240,15 @@ void uipc_main_cleanup(tUIPC_STATE& uipc) {
 
   BTIF_TRACE_EVENT("uipc_main_cleanup");
 
+  /* close any open channels */
+  for (i = 0; i < UIPC_CH_NUM; i++) uipc_close_ch_locked(uipc, i);
+
+  uipc_unregister_locked(&uipc.signal_reactor_object);
   close(uipc.signal_fds[0]);
   close(uipc.signal_fds[1]);
 
-  /* close any open channels */
-  for (i = 0; i < UIPC_CH_NUM; i++) uipc_close_ch_locked(uipc, i);
+  reactor_free(uipc.reactor);
+  uipc.reactor = NULL;
 }
 
 /* check pending events in read task */
@@ -242,28 +271,27 @@ static int uipc_check_fd_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
   // BTIF_TRACE_EVENT("CHECK SRVFD %d (ch %d)", uipc.ch[ch_id].srvfd,
   // ch_id);
 
-  if (SAFE_FD_ISSET(uipc.ch[ch_id].srvfd, &uipc.read_set)) {
+  if (uipc.ch[ch_id].srv_ready) {
     BTIF_TRACE_EVENT("INCOMING CONNECTION ON CH %d", ch_id);
+    uipc.ch[ch_id].srv_ready = false;
 
     // Close the previous connection
     if (uipc.ch[ch_id].fd != UIPC_DISCONNECTED) {
       BTIF_TRACE_EVENT("CLOSE CONNECTION (FD %d)", uipc.ch[ch_id].fd);
+      uipc_unregister_locked(&uipc.ch[ch_id].reactor_object);
       close(uipc.ch[ch_id].fd);
-      FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
       uipc.ch[ch_id].fd = UIPC_DISCONNECTED;
+      uipc.ch[ch_id].ready = false;
     }
 
     uipc.ch[ch_id].fd = accept_server_socket(uipc.ch[ch_id].srvfd);
 
     BTIF_TRACE_EVENT("NEW FD %d", uipc.ch[ch_id].fd);
 
-    if ((uipc.ch[ch_id].fd >= 0) && uipc.ch[ch_id].cback) {
-      /*  if we have a callback we should add this fd to the active set
-          and notify user with callback event */
-      BTIF_TRACE_EVENT("ADD FD %d TO ACTIVE SET", uipc.ch[ch_id].fd);
-      FD_SET(uipc.ch[ch_id].fd, &uipc.active_set);
-      uipc.max_fd = MAX(uipc.max_fd, uipc.ch[ch_id].fd);
-    }
+    /*  if we have a callback we should watch this fd and notify user with
+        callback event */
+    uipc.ch[ch_id].read_active =
+        (uipc.ch[ch_id].fd >= 0) && uipc.ch[ch_id].cback;
 
     if (uipc.ch[ch_id].fd < 0) {
       BTIF_TRACE_ERROR("FAILED TO ACCEPT CH %d", ch_id);
@@ -275,8 +303,9 @@ static int uipc_check_fd_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
 
   // BTIF_TRACE_EVENT("CHECK FD %d (ch %d)", uipc.ch[ch_id].fd, ch_id);
 
-  if (SAFE_FD_ISSET(uipc.ch[ch_id].fd, &uipc.read_set)) {
+  if (uipc.ch[ch_id].ready) {
     // BTIF_TRACE_EVENT("INCOMING DATA ON CH %d", ch_id);
+    uipc.ch[ch_id].ready = false;
 
     if (uipc.ch[ch_id].cback)
       uipc.ch[ch_id].cback(ch_id, UIPC_RX_DATA_READY_EVT);
@@ -284,8 +313,33 @@ static int uipc_check_fd_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
   return 0;
 }
 
+/* register the fds to watch with the reactor, and unregister the others */
+static void uipc_update_reactor_locked(tUIPC_STATE& uipc) {
+  for (int i = 0; i < UIPC_CH_NUM; i++) {
+    tUIPC_CHAN* p = &uipc.ch[i];
+
+    if (p->srvfd != UIPC_DISCONNECTED && p->srv_reactor_object == NULL) {
+      BTIF_TRACE_EVENT("WATCH SERVER FD %d", p->srvfd);
+      p->srv_reactor_object = reactor_register(uipc.reactor, p->srvfd, p,
+                                               uipc_srv_ready_cb, NULL);
+    }
+
+    bool watch = p->fd != UIPC_DISCONNECTED && p->read_active;
+    if (watch && p->reactor_object == NULL) {
+      BTIF_TRACE_EVENT("WATCH FD %d", p->fd);
+      p->reactor_object =
+          reactor_register(uipc.reactor, p->fd, p, uipc_ready_cb, NULL);
+    } else if (!watch && p->reactor_object != NULL) {
+      BTIF_TRACE_EVENT("STOP WATCHING FD %d", p->fd);
+      uipc_unregister_locked(&p->reactor_object);
+      p->ready = false;
+    }
+  }
+}
+
 static void uipc_check_interrupt_locked(tUIPC_STATE& uipc) {
-  if (SAFE_FD_ISSET(uipc.signal_fds[0], &uipc.read_set)) {
+  if (uipc.signal_ready) {
+    uipc.signal_ready = false;
     char sig_recv = 0;
     OSI_NO_INTR(
         recv(uipc.signal_fds[0], &sig_recv, sizeof(sig_recv), MSG_WAITALL));
@@ -316,15 +370,13 @@ static int uipc_setup_server_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
     return -1;
   }
 
-  BTIF_TRACE_EVENT("ADD SERVER FD TO ACTIVE SET %d", fd);
-  FD_SET(fd, &uipc.active_set);
-  uipc.max_fd = MAX(uipc.max_fd, fd);
+  BTIF_TRACE_EVENT("ADD SERVER FD %d", fd);
 
   uipc.ch[ch_id].srvfd = fd;
   uipc.ch[ch_id].cback = cback;
   uipc.ch[ch_id].read_poll_tmo_ms = DEFAULT_READ_POLL_TMO_MS;
 
-  /* trigger main thread to update read set */
+  /* trigger main thread to watch the server fd */
   uipc_wakeup_locked(uipc);
 
   return 0;
@@ -392,17 +444,20 @@ static int uipc_close_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
 
   if (uipc.ch[ch_id].srvfd != UIPC_DISCONNECTED) {
     BTIF_TRACE_EVENT("CLOSE SERVER (FD %d)", uipc.ch[ch_id].srvfd);
+    uipc_unregister_locked(&uipc.ch[ch_id].srv_reactor_object);
     close(uipc.ch[ch_id].srvfd);
-    FD_CLR(uipc.ch[ch_id].srvfd, &uipc.active_set);
     uipc.ch[ch_id].srvfd = UIPC_DISCONNECTED;
+    uipc.ch[ch_id].srv_ready = false;
     wakeup = 1;
   }
 
   if (uipc.ch[ch_id].fd != UIPC_DISCONNECTED) {
     BTIF_TRACE_EVENT("CLOSE CONNECTION (FD %d)", uipc.ch[ch_id].fd);
+    uipc_unregister_locked(&uipc.ch[ch_id].reactor_object);
     close(uipc.ch[ch_id].fd);
-    FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
     uipc.ch[ch_id].fd = UIPC_DISCONNECTED;
+    uipc.ch[ch_id].read_active = false;
+    uipc.ch[ch_id].ready = false;
     wakeup = 1;
   }
 
@@ -429,26 +484,16 @@ void uipc_close_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
 static void* uipc_read_task(void* arg) {
   tUIPC_STATE& uipc = *((tUIPC_STATE*)arg);
   int ch_id;
-  int result;
 
   prctl(PR_SET_NAME, (unsigned long)"uipc-main", 0, 0, 0);
 
   raise_priority_a2dp(TASK_UIPC_READ);
 
   while (uipc.running) {
-    uipc.read_set = uipc.active_set;
-
-    result = select(uipc.max_fd + 1, &uipc.read_set, NULL, NULL, NULL);
-
-    if (result == 0) {
-      BTIF_TRACE_EVENT("select timeout");
-      continue;
-    }
-    if (result < 0) {
-      if (errno != EINTR) {
-        BTIF_TRACE_EVENT("select failed %s", strerror(errno));
-      }
-      continue;
+    /* wait for at least one readable fd */
+    if (reactor_run_once(uipc.reactor) == REACTOR_STATUS_ERROR) {
+      BTIF_TRACE_ERROR("reactor failed %s", strerror(errno));
+      break;
     }
 
     {
@@ -467,6 +512,9 @@ static void* uipc_read_task(void* arg) {
       for (ch_id = 0; ch_id < UIPC_CH_NUM; ch_id++) {
         if (ch_id != UIPC_CH_ID_AV_AUDIO) uipc_check_fd_locked(uipc, ch_id);
       }
+
+      /* apply the changes to the set of fds to watch */
+      uipc_update_reactor_locked(uipc);
     }
   }
 
@@ -715,12 +763,12 @@ extern bool UIPC_Ioctl(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint32_t request,
       break;
 
     case UIPC_REG_REMOVE_ACTIVE_READSET:
-      /* user will read data directly and not use select loop */
+      /* user will read data directly and not use the read task */
       if (uipc.ch[ch_id].fd != UIPC_DISCONNECTED) {
-        /* remove this channel from active set */
-        FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
+        /* stop watching this channel */
+        uipc.ch[ch_id].read_active = false;
 
-        /* refresh active set */
+        /* refresh watched fds */
         uipc_wakeup_locked(uipc);
       }
       break;
@@ -70,9 +70,7 @@ void Beacon::TimerTick() {
     std::shared_ptr<model::packets::LinkLayerPacketBuilder> to_send =
         std::move(ad);
 
-    for (const auto& phy : phy_layers_[Phy::Type::LOW_ENERGY]) {
-      phy->Send(to_send);
-    }
+    SendLinkLayerPacket(to_send, Phy::Type::LOW_ENERGY);
   }
 }
 
@@ -87,9 +85,7 @@ void Beacon::IncomingPacket(model::packets::LinkLayerPacketView packet) {
     std::shared_ptr<model::packets::LinkLayerPacketBuilder> to_send =
         std::move(scan_response);
 
-    for (const auto& phy : phy_layers_[Phy::Type::LOW_ENERGY]) {
-      phy->Send(to_send);
-    }
+    SendLinkLayerPacket(to_send, Phy::Type::LOW_ENERGY);
   }
 }
 
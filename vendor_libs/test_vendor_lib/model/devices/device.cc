@@ -18,6 +18,8 @@
 
 #include "device.h"
 
+#include "model/setup/phy_layer_factory.h"
+
 using std::vector;
 
 namespace test_vendor_lib {
@@ -58,9 +60,12 @@ bool Device::IsAdvertisementAvailable() const {
 void Device::SendLinkLayerPacket(
     std::shared_ptr<model::packets::LinkLayerPacketBuilder> to_send,
     Phy::Type phy_type) {
-  for (const auto& phy : phy_layers_[phy_type]) {
-    phy->Send(to_send);
+  const auto& phys = phy_layers_[phy_type];
+  if (phys.empty()) {
+    return;
   }
+  // Serialized once, however many phys and receivers share it
+  SendLinkLayerPacket(PhyLayerFactory::Serialize(*to_send), phy_type);
 }
 
 void Device::SendLinkLayerPacket(model::packets::LinkLayerPacketView to_send,
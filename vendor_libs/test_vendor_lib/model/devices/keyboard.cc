@@ -81,6 +81,34 @@ void Keyboard::TimerTick() {
 }
 
 void Keyboard::IncomingPacket(model::packets::LinkLayerPacketView packet) {
+  if (packet.GetDestinationAddress() != properties_.GetLeAddress()) {
+    return;
+  }
+  if (!connected_ &&
+      packet.GetType() == model::packets::PacketType::LE_CONNECT) {
+    auto connect = model::packets::LeConnectView::Create(packet);
+    ASSERT(connect.IsValid());
+    // Accept any central, as a peripheral waiting to be paired does
+    uint16_t connection_interval = (connect.GetLeConnectionIntervalMin() +
+                                    connect.GetLeConnectionIntervalMax()) /
+                                   2;
+    std::shared_ptr<model::packets::LinkLayerPacketBuilder> to_send =
+        model::packets::LeConnectCompleteBuilder::Create(
+            properties_.GetLeAddress(), packet.GetSourceAddress(),
+            connection_interval, connect.GetLeConnectionLatency(),
+            connect.GetLeConnectionSupervisionTimeout(),
+            static_cast<uint8_t>(model::packets::AddressType::PUBLIC));
+    SendLinkLayerPacket(to_send, Phy::Type::LOW_ENERGY);
+    connected_ = true;
+    central_ = packet.GetSourceAddress();
+    return;
+  }
+  if (connected_ && packet.GetSourceAddress() == central_ &&
+      packet.GetType() == model::packets::PacketType::DISCONNECT) {
+    // Advertise again, so that the next central can connect
+    connected_ = false;
+    return;
+  }
   if (!connected_) {
     Beacon::IncomingPacket(packet);
   }
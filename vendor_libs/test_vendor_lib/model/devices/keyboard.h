@@ -47,6 +47,7 @@ class Keyboard : public Beacon {
 
  private:
   bool connected_{false};
+  Address central_{};
   static bool registered_;
 };
 }  // namespace test_vendor_lib
@@ -19,7 +19,6 @@
 #include <unistd.h>
 
 #include "packet/packet_view.h"
-#include "packet/raw_builder.h"
 #include "packet/view.h"
 
 using std::vector;
@@ -63,16 +62,18 @@ void LinkLayerSocketDevice::TimerTick() {
 
 void LinkLayerSocketDevice::IncomingPacket(
     model::packets::LinkLayerPacketView packet) {
-  auto size_packet = bluetooth::packet::RawBuilder();
-  size_packet.AddOctets4(packet.size());
-  std::vector<uint8_t> size_bytes;
-  bluetooth::packet::BitInserter bit_inserter(size_bytes);
-  size_packet.Serialize(bit_inserter);
-
-  if (socket_.TrySend(size_bytes) == kSizeBytes) {
-    std::vector<uint8_t> payload_bytes{packet.begin(), packet.end()};
-    socket_.TrySend(payload_bytes);
+  // The size prefix and the packet go out in one write, straight from the
+  // bytes all the receivers of the packet share
+  uint32_t size = packet.size();
+  uint8_t size_bytes[kSizeBytes];
+  for (size_t i = 0; i < kSizeBytes; i++) {
+    size_bytes[i] = static_cast<uint8_t>(size >> (8 * i));
+  }
+  std::vector<bluetooth::packet::Segment> segments{{size_bytes, kSizeBytes}};
+  for (const auto& segment : packet.GetSegments()) {
+    segments.push_back(segment);
   }
+  socket_.TrySendVector(segments);
 }
 
 }  // namespace test_vendor_lib
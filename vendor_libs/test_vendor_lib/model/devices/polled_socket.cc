@@ -58,30 +58,24 @@ size_t PolledSocket::TrySend(const std::vector<uint8_t>& packet) {
   }
 }
 
-/*
-void PolledSocket::TrySendVector(
-  const std::vector<std::vector<uint8_t>&>& raw_vectors) {
-if (file_descriptor_ < 0) {
-  return;
-}
-for (const std::vector<uint8_t>& v : raw_vectors) {
-  Send(v);
-}
+size_t PolledSocket::TrySendVector(
+    const std::vector<bluetooth::packet::Segment>& segments) {
+  if (file_descriptor_ == -1) {
+    return 0;
+  }
   std::vector<struct iovec> iovecs;
-  for (auto v : raw_vectors) {
-    struct iovec one_iovec;
-    one_iovec.iov_base = v.data();
-    one_iovec.iov_base = v.size();
-    iovecs.push_back(one_iovec);
+  iovecs.reserve(segments.size());
+  for (const auto& segment : segments) {
+    iovecs.push_back({const_cast<uint8_t*>(segment.data), segment.size});
   }
   int ret = writev(file_descriptor_, iovecs.data(), iovecs.size());
   if (ret == -1) {
+    LOG_WARN("%s error %s", __func__, strerror(errno));
     return 0;
   } else {
     return static_cast<size_t>(ret);
   }
 }
-*/
 
 size_t PolledSocket::TryReceive(size_t num_bytes, uint8_t* data) {
   if (file_descriptor_ == -1) return 0;
@@ -26,6 +26,8 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include "packet/segmenting_inserter.h"
+
 namespace test_vendor_lib {
 namespace net {
 
@@ -40,7 +42,9 @@ class PolledSocket {
   virtual ~PolledSocket();
 
   size_t TrySend(const std::vector<uint8_t>& packet);
-  // size_t TrySendVector(const std::vector<const std::vector<uint8_t>&>& data);
+  // Send the concatenation of |segments| with a single write, without copying
+  // them. Returns how many bytes were written.
+  size_t TrySendVector(const std::vector<bluetooth::packet::Segment>& segments);
   size_t TryReceive(size_t num_bytes, uint8_t* data);
 
  private:
@@ -19,6 +19,8 @@
 
 namespace test_vendor_lib {
 
+thread_local size_t PhyLayerFactory::current_shard_ = PhyLayerFactory::kNoShard;
+
 PhyLayerFactory::PhyLayerFactory(Phy::Type phy_type, uint32_t factory_id)
     : phy_type_(phy_type), factory_id_(factory_id) {}
 
@@ -56,25 +58,32 @@ void PhyLayerFactory::UnregisterAllPhyLayers() {
   }
 }
 
-void PhyLayerFactory::Send(
-    const std::shared_ptr<model::packets::LinkLayerPacketBuilder> packet,
-    uint32_t id) {
-  // Convert from a Builder to a View
+model::packets::LinkLayerPacketView PhyLayerFactory::Serialize(
+    const model::packets::LinkLayerPacketBuilder& packet) {
   auto bytes = std::make_shared<std::vector<uint8_t>>();
+  bytes->reserve(packet.size());
   bluetooth::packet::BitInserter i(*bytes);
-  bytes->reserve(packet->size());
-  packet->Serialize(i);
+  packet.Serialize(i);
   auto packet_view =
       bluetooth::packet::PacketView<bluetooth::packet::kLittleEndian>(bytes);
   auto link_layer_packet_view =
       model::packets::LinkLayerPacketView::Create(packet_view);
   ASSERT(link_layer_packet_view.IsValid());
+  return link_layer_packet_view;
+}
 
-  Send(link_layer_packet_view, id);
+void PhyLayerFactory::Send(
+    const std::shared_ptr<model::packets::LinkLayerPacketBuilder> packet,
+    uint32_t id) {
+  Send(Serialize(*packet), id);
 }
 
 void PhyLayerFactory::Send(model::packets::LinkLayerPacketView packet,
                            uint32_t id) {
+  if (current_shard_ < outboxes_.size()) {
+    outboxes_[current_shard_].push_back({packet, id});
+    return;
+  }
   for (const auto& phy : phy_layers_) {
     if (id != phy->GetId()) {
       phy->Receive(packet);
@@ -82,6 +91,40 @@ void PhyLayerFactory::Send(model::packets::LinkLayerPacketView packet,
   }
 }
 
+void PhyLayerFactory::SetCurrentShard(size_t shard) {
+  current_shard_ = shard;
+}
+
+void PhyLayerFactory::SetShardCount(size_t shard_count) {
+  // Nothing needs to be queued when a single thread ticks every device
+  outboxes_.resize(shard_count > 1 ? shard_count : 0);
+}
+
+bool PhyLayerFactory::CollectOutboxes() {
+  collected_.clear();
+  for (auto& outbox : outboxes_) {
+    collected_.insert(collected_.end(), outbox.begin(), outbox.end());
+    outbox.clear();
+  }
+  return !collected_.empty();
+}
+
+void PhyLayerFactory::DeliverCollected(size_t shard, size_t shard_count) {
+  std::vector<std::shared_ptr<PhyLayer>> shard_phys;
+  for (const auto& phy : phy_layers_) {
+    if (phy->GetDeviceId() % shard_count == shard) {
+      shard_phys.push_back(phy);
+    }
+  }
+  for (const auto& queued : collected_) {
+    for (const auto& phy : shard_phys) {
+      if (queued.sender_id != phy->GetId()) {
+        phy->Receive(queued.packet);
+      }
+    }
+  }
+}
+
 void PhyLayerFactory::TimerTick() {
   for (auto& phy : phy_layers_) {
     phy->TimerTick();
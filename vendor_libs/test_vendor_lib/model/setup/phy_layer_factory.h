@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -50,6 +51,27 @@ class PhyLayerFactory {
 
   virtual std::string ToString() const;
 
+  // Serialize a packet once, to share the result with every receiver
+  static model::packets::LinkLayerPacketView Serialize(
+      const model::packets::LinkLayerPacketBuilder& packet);
+
+  // While a shard is set on a thread, the packets it sends are queued in that
+  // shard's outbox instead of being delivered right away, so that devices in
+  // different shards can run concurrently without ever calling into each other
+  static constexpr size_t kNoShard = static_cast<size_t>(-1);
+  static void SetCurrentShard(size_t shard);
+
+  // Keep one outbox per shard
+  void SetShardCount(size_t shard_count);
+
+  // Take the packets queued by every shard since the last call for delivery.
+  // Returns true if there is anything to deliver.
+  bool CollectOutboxes();
+
+  // Deliver the collected packets to the phy layers of the devices in shard.
+  // Safe to call concurrently for different shards.
+  void DeliverCollected(size_t shard, size_t shard_count);
+
  protected:
   virtual void Send(
       std::shared_ptr<model::packets::LinkLayerPacketBuilder> packet,
@@ -61,6 +83,16 @@ class PhyLayerFactory {
   std::vector<std::shared_ptr<PhyLayer>> phy_layers_;
   uint32_t next_id_{1};
   const uint32_t factory_id_;
+
+  struct QueuedPacket {
+    model::packets::LinkLayerPacketView packet;
+    uint32_t sender_id;
+  };
+  // Only ever appended to by the thread running the matching shard
+  std::vector<std::vector<QueuedPacket>> outboxes_;
+  std::vector<QueuedPacket> collected_;
+
+  static thread_local size_t current_shard_;
 };
 
 class PhyLayerImpl : public PhyLayer {
@@ -48,6 +48,7 @@ TestCommandHandler::TestCommandHandler(TestModel& test_model) : model_(test_mode
   SET_HANDLER("set_timer_period", SetTimerPeriod);
   SET_HANDLER("start_timer", StartTimer);
   SET_HANDLER("stop_timer", StopTimer);
+  SET_HANDLER("set_tick_workers", SetTickWorkers);
 #undef SET_HANDLER
 }
 
@@ -263,4 +264,22 @@ void TestCommandHandler::StopTimer(const vector<std::string>& args) {
   send_response_(response_string_);
 }
 
+void TestCommandHandler::SetTickWorkers(const vector<std::string>& args) {
+  if (args.size() != 1) {
+    response_string_ = "TestCommandHandler 'set_tick_workers' takes 1 argument";
+    send_response_(response_string_);
+    return;
+  }
+  size_t worker_count = std::stoi(args[0]);
+  if (worker_count != 0) {
+    response_string_ = "set tick workers to ";
+    response_string_ += args[0];
+    model_.SetTickWorkers(worker_count);
+  } else {
+    response_string_ = "invalid tick worker count ";
+    response_string_ += args[0];
+  }
+  send_response_(response_string_);
+}
+
 }  // namespace test_vendor_lib
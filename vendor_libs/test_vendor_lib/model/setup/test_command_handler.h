@@ -79,6 +79,9 @@ class TestCommandHandler {
 
   void StopTimer(const std::vector<std::string>& args);
 
+  // Change how many threads tick the devices
+  void SetTickWorkers(const std::vector<std::string>& args);
+
   // For manual testing
   void AddDefaults();
 
@@ -48,6 +48,10 @@ using std::vector;
 
 namespace test_vendor_lib {
 
+// How many times in a tick packets sent in reply to other packets are handed
+// out, before the rest waits for the next tick
+static constexpr size_t kMaxDeliveryRounds = 4;
+
 TestModel::TestModel(
     std::function<AsyncUserId()> get_user_id,
     std::function<AsyncTaskId(AsyncUserId, std::chrono::milliseconds,
@@ -89,6 +93,13 @@ void TestModel::SetTimerPeriod(std::chrono::milliseconds new_period) {
   StartTimer();
 }
 
+void TestModel::SetTickWorkers(size_t worker_count) {
+  tick_workers_.SetShardCount(worker_count);
+  for (auto& phy : phys_) {
+    phy.SetShardCount(tick_workers_.GetShardCount());
+  }
+}
+
 void TestModel::StartTimer() {
   LOG_INFO("StartTimer()");
   timer_tick_task_ = schedule_periodic_task_(
@@ -119,6 +130,7 @@ void TestModel::Del(size_t dev_index) {
 size_t TestModel::AddPhy(Phy::Type phy_type) {
   size_t factory_id = phys_.size();
   phys_.emplace_back(phy_type, factory_id);
+  phys_.back().SetShardCount(tick_workers_.GetShardCount());
   return factory_id;
 }
 
@@ -250,10 +262,43 @@ const std::string& TestModel::List() {
 }
 
 void TestModel::TimerTick() {
-  for (const auto& dev : devices_) {
-    if (dev != nullptr) {
-      dev->TimerTick();
+  size_t shard_count = tick_workers_.GetShardCount();
+  if (shard_count == 1) {
+    for (const auto& dev : devices_) {
+      if (dev != nullptr) {
+        dev->TimerTick();
+      }
+    }
+    return;
+  }
+
+  // Devices are sharded by index, and so are the phy layers they receive
+  // from, so each device is only ever called from the thread of its shard
+  tick_workers_.Run([this, shard_count](size_t shard) {
+    PhyLayerFactory::SetCurrentShard(shard);
+    for (size_t i = shard; i < devices_.size(); i += shard_count) {
+      if (devices_[i] != nullptr) {
+        devices_[i]->TimerTick();
+      }
+    }
+    PhyLayerFactory::SetCurrentShard(PhyLayerFactory::kNoShard);
+  });
+
+  for (size_t round = 0; round < kMaxDeliveryRounds; round++) {
+    bool pending = false;
+    for (auto& phy : phys_) {
+      pending = phy.CollectOutboxes() || pending;
+    }
+    if (!pending) {
+      return;
     }
+    tick_workers_.Run([this, shard_count](size_t shard) {
+      PhyLayerFactory::SetCurrentShard(shard);
+      for (auto& phy : phys_) {
+        phy.DeliverCollected(shard, shard_count);
+      }
+      PhyLayerFactory::SetCurrentShard(PhyLayerFactory::kNoShard);
+    });
   }
 }
 
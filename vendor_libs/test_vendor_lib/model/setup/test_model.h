@@ -27,6 +27,7 @@
 #include "model/devices/device.h"
 #include "phy_layer_factory.h"
 #include "test_channel_transport.h"
+#include "tick_worker_pool.h"
 
 namespace test_vendor_lib {
 
@@ -88,6 +89,9 @@ class TestModel {
   void StopTimer();
   void SetTimerPeriod(std::chrono::milliseconds new_period);
 
+  // Split the devices into shards ticked by as many threads
+  void SetTickWorkers(size_t worker_count);
+
   // List the devices that the test knows about
   const std::string& List();
 
@@ -114,6 +118,7 @@ class TestModel {
   AsyncUserId model_user_id_;
   AsyncTaskId timer_tick_task_{kInvalidTaskId};
   std::chrono::milliseconds timer_period_{};
+  TickWorkerPool tick_workers_;
 
   std::vector<std::shared_ptr<Device>> example_devices_;
 };
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tick_worker_pool.h"
+
+#include "os/log.h"
+
+namespace test_vendor_lib {
+
+TickWorkerPool::TickWorkerPool(size_t shard_count)
+    : shard_count_(shard_count == 0 ? 1 : shard_count) {
+  StartWorkers();
+}
+
+TickWorkerPool::~TickWorkerPool() { StopWorkers(); }
+
+void TickWorkerPool::SetShardCount(size_t shard_count) {
+  if (shard_count == 0) {
+    shard_count = 1;
+  }
+  if (shard_count == shard_count_) {
+    return;
+  }
+  LOG_INFO("Ticking with %zu shards", shard_count);
+  StopWorkers();
+  shard_count_ = shard_count;
+  StartWorkers();
+}
+
+void TickWorkerPool::Run(const ShardCallback& work) {
+  if (workers_.empty()) {
+    work(0);
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> guard(mutex_);
+    work_ = &work;
+    pending_workers_ = workers_.size();
+    generation_++;
+  }
+  work_ready_.notify_all();
+
+  work(0);
+
+  std::unique_lock<std::mutex> guard(mutex_);
+  work_done_.wait(guard, [this]() { return pending_workers_ == 0; });
+  work_ = nullptr;
+}
+
+void TickWorkerPool::StartWorkers() {
+  stopping_ = false;
+  for (size_t shard = 1; shard < shard_count_; shard++) {
+    workers_.emplace_back([this, shard, generation = generation_]() {
+      WorkerRoutine(shard, generation);
+    });
+  }
+}
+
+void TickWorkerPool::StopWorkers() {
+  {
+    std::unique_lock<std::mutex> guard(mutex_);
+    stopping_ = true;
+  }
+  work_ready_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void TickWorkerPool::WorkerRoutine(size_t shard, size_t seen_generation) {
+  while (true) {
+    const ShardCallback* work;
+    {
+      std::unique_lock<std::mutex> guard(mutex_);
+      work_ready_.wait(guard, [this, seen_generation]() {
+        return stopping_ || generation_ != seen_generation;
+      });
+      if (stopping_) {
+        return;
+      }
+      seen_generation = generation_;
+      work = work_;
+    }
+
+    (*work)(shard);
+
+    bool last_worker;
+    {
+      std::unique_lock<std::mutex> guard(mutex_);
+      last_worker = --pending_workers_ == 0;
+    }
+    if (last_worker) {
+      work_done_.notify_one();
+    }
+  }
+}
+
+}  // namespace test_vendor_lib
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace test_vendor_lib {
+
+// A fixed set of threads that run one piece of work per shard. Run() hands
+// every worker the same callback with its own shard index, and returns once
+// all of them are done, so the caller can treat a sharded step as a single
+// blocking call. With one shard the work runs on the calling thread and no
+// thread is ever started. Run() must not be called concurrently, nor from
+// inside the work it runs.
+class TickWorkerPool {
+ public:
+  using ShardCallback = std::function<void(size_t shard)>;
+
+  explicit TickWorkerPool(size_t shard_count = 1);
+  TickWorkerPool(const TickWorkerPool&) = delete;
+  TickWorkerPool& operator=(const TickWorkerPool&) = delete;
+  ~TickWorkerPool();
+
+  size_t GetShardCount() const { return shard_count_; }
+
+  // Stop the current workers and start shard_count of them instead
+  void SetShardCount(size_t shard_count);
+
+  // Run work(shard) for every shard, and wait for all of them to return
+  void Run(const ShardCallback& work);
+
+ private:
+  void StartWorkers();
+  void StopWorkers();
+  void WorkerRoutine(size_t shard, size_t seen_generation);
+
+  size_t shard_count_;
+  // Shard 0 always runs on the thread calling Run()
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable work_ready_;
+  std::condition_variable work_done_;
+  const ShardCallback* work_{nullptr};
+  // Bumped for every Run(), so that each worker picks up each piece of work
+  // exactly once
+  size_t generation_{0};
+  size_t pending_workers_{0};
+  bool stopping_{false};
+};
+
+}  // namespace test_vendor_lib
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/setup/tick_worker_pool.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace test_vendor_lib {
+
+TEST(TickWorkerPoolTest, SingleShardRunsOnCallingThread) {
+  TickWorkerPool pool;
+  EXPECT_EQ(pool.GetShardCount(), 1u);
+  std::thread::id runner;
+  pool.Run([&runner](size_t shard) {
+    EXPECT_EQ(shard, 0u);
+    runner = std::this_thread::get_id();
+  });
+  EXPECT_EQ(runner, std::this_thread::get_id());
+}
+
+TEST(TickWorkerPoolTest, EveryShardRunsOncePerRun) {
+  constexpr size_t kShards = 4;
+  constexpr size_t kRuns = 1000;
+  TickWorkerPool pool(kShards);
+  std::vector<std::atomic<size_t>> runs(kShards);
+  for (size_t run = 0; run < kRuns; run++) {
+    pool.Run([&runs](size_t shard) { runs[shard]++; });
+    // Run() only returns once every shard is done
+    for (size_t shard = 0; shard < kShards; shard++) {
+      ASSERT_EQ(runs[shard], run + 1);
+    }
+  }
+}
+
+TEST(TickWorkerPoolTest, ShardsRunOnTheirOwnThreads) {
+  constexpr size_t kShards = 3;
+  TickWorkerPool pool(kShards);
+  std::vector<std::thread::id> runners(kShards);
+  pool.Run([&runners](size_t shard) { runners[shard] = std::this_thread::get_id(); });
+  EXPECT_EQ(runners[0], std::this_thread::get_id());
+  EXPECT_NE(runners[1], runners[0]);
+  EXPECT_NE(runners[2], runners[0]);
+  EXPECT_NE(runners[2], runners[1]);
+}
+
+TEST(TickWorkerPoolTest, ChangeShardCount) {
+  TickWorkerPool pool(2);
+  pool.SetShardCount(5);
+  EXPECT_EQ(pool.GetShardCount(), 5u);
+  std::atomic<size_t> runs{0};
+  pool.Run([&runs](size_t) { runs++; });
+  EXPECT_EQ(runs, 5u);
+
+  pool.SetShardCount(0);
+  EXPECT_EQ(pool.GetShardCount(), 1u);
+  pool.Run([&runs](size_t) { runs++; });
+  EXPECT_EQ(runs, 6u);
+}
+
+}  // namespace test_vendor_lib